@@ -1,3 +1,6 @@
+include(${CMAKE_CURRENT_LIST_DIR}/OptimizeSpirv.cmake)
+
+
 function(CompileHLSL_GetShaderTypeExtension inShaderFileName outShaderType_extension)
     get_filename_component(fileExtension "${inShaderFileName}" EXT)
     string(REGEX REPLACE "^\\." "" fileExtension "${fileExtension}")
@@ -16,7 +19,7 @@ function(CompileHLSL_GetShaderStage inShaderFile outShaderStage)
     list(LENGTH shaderType_extension partCount)
     if(NOT partCount EQUAL 2)
         message(FATAL_ERROR
-            "Expected shader file name of the form `<shaderName>.<vert|frag|comp>.hlsl`."
+            "Expected shader file name of the form `<shaderName>.<vert|frag|comp|task|mesh>.hlsl`."
             "Got `${inShaderFileName}` from input `${inShaderFile}`."
         )
     endif()
@@ -29,13 +32,27 @@ function(CompileHLSL_GetShaderStage inShaderFile outShaderStage)
         set(shaderStage "ps_6_1")
     elseif(shaderType STREQUAL "comp")
         set(shaderStage "cs_6_1")
+    elseif(shaderType STREQUAL "task")
+        set(shaderStage "as_6_5")
+    elseif(shaderType STREQUAL "mesh")
+        set(shaderStage "ms_6_5")
     else()
-        message(FATAL_ERROR "Expected `inShaderType` to be one of `vert`, `frag`, or `comp`. Got `${shaderType}`.")
+        message(FATAL_ERROR "Expected `inShaderType` to be one of `vert`, `frag`, `comp`, `task`, or `mesh`. Got `${shaderType}`.")
     endif()
 
     set(${outShaderStage} "${shaderStage}" PARENT_SCOPE)
 endfunction()
 
+function(CompileHLSL_GetTargetEnvironment inShaderStage outTargetEnvironment)
+    # Task and mesh shaders need SPIR-V 1.4, and `dxc` targets Vulkan 1.0 otherwise.
+    set(targetEnvironment "vulkan1.0")
+    if(inShaderStage MATCHES "^(as|ms)_")
+        set(targetEnvironment "vulkan1.3")
+    endif()
+
+    set(${outTargetEnvironment} "${targetEnvironment}" PARENT_SCOPE)
+endfunction()
+
 function(CompileHLSL_GetCompileOptions HLSL_COMPILER_COMMAND inShaderSourceFile inSpirvBinaryFile inShaderStage outCompileOptions)
     set(hlslCompilerName)
     get_filename_component(hlslCompilerName "${HLSL_COMPILER_COMMAND}" NAME)
@@ -43,6 +60,11 @@ function(CompileHLSL_GetCompileOptions HLSL_COMPILER_COMMAND inShaderSourceFile
     set(compileOptions)
     if (${hlslCompilerName} STREQUAL "dxc")
         list(APPEND compileOptions -spirv -T ${shaderStage} -E main -Fo ${inSpirvBinaryFile} ${inShaderSourceFile})
+        # Task and mesh shaders need SPIR-V 1.4, and `dxc` only emits the `VK_EXT_mesh_shader`
+        # flavor of them when asked for the extension.
+        if(shaderStage MATCHES "^(as|ms)_")
+            list(APPEND compileOptions -fspv-target-env=vulkan1.3 -fspv-extension=SPV_EXT_mesh_shader)
+        endif()
     else()
         message(FATAL_ERROR
             "Unsupported compiler. The supported compilers are `dxc`. "
@@ -53,9 +75,44 @@ function(CompileHLSL_GetCompileOptions HLSL_COMPILER_COMMAND inShaderSourceFile
     set(${outCompileOptions} "${compileOptions}" PARENT_SCOPE)
 endfunction()
 
-function(CompileHLSL_CompileShader HLSL_COMPILER_COMMAND inShaderSourceFile inSpirvBinaryOutputPath outSpirvBinaryOutputFile)
+function(CompileHLSL_GetSpirvBinaryFile inShaderSourceFile inSpirvBinaryOutputPath outSpirvBinaryFile)
+    get_filename_component(fileName "${inShaderSourceFile}" NAME)
+
+    set(${outSpirvBinaryFile} "${inSpirvBinaryOutputPath}/${fileName}.spv" PARENT_SCOPE)
+endfunction()
+
+#[[
+`dxc` only lists the dependencies of a shader when it is asked for them, without compiling
+it, so the depfile is written by an invocation of its own.
+]]
+function(CompileHLSL_GetDepfileOptions HLSL_COMPILER_COMMAND inShaderSourceFile inShaderStage inDepfile outDepfileOptions)
+    set(hlslCompilerName)
+    get_filename_component(hlslCompilerName "${HLSL_COMPILER_COMMAND}" NAME)
+
+    set(depfileOptions)
+    if (${hlslCompilerName} STREQUAL "dxc")
+        list(APPEND depfileOptions -spirv -T ${inShaderStage} -E main -M -MF "${inDepfile}" "${inShaderSourceFile}")
+    else()
+        message(FATAL_ERROR
+            "Unsupported compiler. The supported compilers are `dxc`. "
+            "Got `${HLSL_COMPILER_COMMAND}`."
+        )
+    endif()
+
+    set(${outDepfileOptions} "${depfileOptions}" PARENT_SCOPE)
+endfunction()
+
+#[[
+Add a build rule that compiles one shader to SPIR-V. The rule depends on the shader source,
+and on every file it includes through the depfile the compiler writes, so the shader only
+recompiles when one of them changes. With a `spirv-opt` command, a second rule optimizes
+the binary, and the optimized binary is the one to embed.
+]]
+function(CompileHLSL_AddCompileCommand HLSL_COMPILER_COMMAND SPIRV_OPT_COMMAND inOptimizerOptions inShaderSourceFile inSpirvBinaryOutputPath outSpirvBinaryOutputFile)
     get_filename_component(fileName "${inShaderSourceFile}" NAME)
-    set(spirvOutputFile "${inSpirvBinaryOutputPath}/${fileName}.spv")
+    set(spirvOutputFile)
+    CompileHLSL_GetSpirvBinaryFile("${inShaderSourceFile}" "${inSpirvBinaryOutputPath}" spirvOutputFile)
+    set(depfile "${spirvOutputFile}.d")
 
     set(shaderStage)
     CompileHLSL_GetShaderStage("${inShaderSourceFile}" shaderStage)
@@ -63,30 +120,50 @@ function(CompileHLSL_CompileShader HLSL_COMPILER_COMMAND inShaderSourceFile inSp
     set(compileOptions)
     CompileHLSL_GetCompileOptions("${HLSL_COMPILER_COMMAND}" "${inShaderSourceFile}" "${spirvOutputFile}" "${shaderStage}" compileOptions)
 
-    list(APPEND fullCommand "${HLSL_COMPILER_COMMAND}" "${compileOptions}")
+    set(depfileOptions)
+    CompileHLSL_GetDepfileOptions("${HLSL_COMPILER_COMMAND}" "${inShaderSourceFile}" "${shaderStage}" "${depfile}" depfileOptions)
+
+    add_custom_command(
+        OUTPUT "${spirvOutputFile}"
+        COMMAND "${HLSL_COMPILER_COMMAND}" ${depfileOptions}
+        COMMAND "${HLSL_COMPILER_COMMAND}" ${compileOptions}
+        DEPENDS "${inShaderSourceFile}"
+        DEPFILE "${depfile}"
+        COMMENT "Compiling HLSL shader `${fileName}`"
+        VERBATIM
+    )
 
-    message(STATUS "Compiling shader")
-    message(STATUS "Input: `${fileName}`")
-    message(STATUS "Output: `${spirvOutputFile}`")
-    message(STATUS "Full compiler command: `${fullCommand}`")
-    execute_process(COMMAND ${fullCommand} RESULT_VARIABLE result)
-    if(result EQUAL 0)
-        message(STATUS "Compiling shader complete")
-    else()
-        message(FATAL_ERROR "Shader compilation failed with result `${result}`")
+    if(SPIRV_OPT_COMMAND)
+        set(targetEnvironment)
+        CompileHLSL_GetTargetEnvironment("${shaderStage}" targetEnvironment)
+
+        set(optimizedSpirvOutputFile)
+        OptimizeSpirv_AddOptimizeCommand(
+            "${SPIRV_OPT_COMMAND}"
+            "${inOptimizerOptions}"
+            "${spirvOutputFile}"
+            "${targetEnvironment}"
+            "${inSpirvBinaryOutputPath}/optimized"
+            optimizedSpirvOutputFile
+        )
+        set(spirvOutputFile "${optimizedSpirvOutputFile}")
     endif()
 
     set(${outSpirvBinaryOutputFile} "${spirvOutputFile}" PARENT_SCOPE)
 endfunction()
 
-function(CompileHLSL_CompileShaders HLSL_COMPILER_COMMAND inShaderSourceFiles inSpirvBinaryOutputPath outSpirvBinaryFiles)
+function(CompileHLSL_AddCompileCommands HLSL_COMPILER_COMMAND SPIRV_OPT_COMMAND inOptimizerOptions inShaderSourceFiles inSpirvBinaryOutputPath outSpirvBinaryFiles)
     list(APPEND spirvBinaryFiles)
     foreach(shaderSourceFile IN LISTS inShaderSourceFiles)
-        get_filename_component(fileName "${shaderSourceFile}" NAME)
-        set(spirvOutputFile "${inSpirvBinaryOutputPath}/${fileName}.spv")
-
         set(spirvOutputFile)
-        CompileHLSL_CompileShader("${HLSL_COMPILER_COMMAND}" "${shaderSourceFile}" "${inSpirvBinaryOutputPath}" spirvOutputFile)
+        CompileHLSL_AddCompileCommand(
+            "${HLSL_COMPILER_COMMAND}"
+            "${SPIRV_OPT_COMMAND}"
+            "${inOptimizerOptions}"
+            "${shaderSourceFile}"
+            "${inSpirvBinaryOutputPath}"
+            spirvOutputFile
+        )
 
         list(APPEND spirvBinaryFiles "${spirvOutputFile}")
     endforeach()
@@ -94,173 +171,18 @@ function(CompileHLSL_CompileShaders HLSL_COMPILER_COMMAND inShaderSourceFiles in
     set(${outSpirvBinaryFiles} "${spirvBinaryFiles}" PARENT_SCOPE)
 endfunction()
 
-function(CompileHLSL_ReadSpirvBinaries inSpirvBinaryFiles outSpirvBinaries)
-    list(APPEND spirvBinaries)
-    foreach(spirvBinaryFile IN LISTS inSpirvBinaryFiles)
-        get_filename_component(fileName "${spirvBinaryFile}" NAME)
-        
-        file(READ "${spirvBinaryFile}" spirvBinary HEX)
-        
-        list(APPEND spirvBinaries "${spirvBinary}")
-    endforeach()
-
-    set(${outSpirvBinaries} "${spirvBinaries}" PARENT_SCOPE)
-endfunction()
-
-function(CompileHLSL_EmbedShader_GenerateEmbeddingName inSpirvBinaryFileName outSpirvBinaryEmbeddingName)
-    string(APPEND spirvBinaryEmbeddingName "")
-    string(REPLACE "." "_" spirvBinaryEmbeddingName "${inSpirvBinaryFileName}")
-
-    set(${outSpirvBinaryEmbeddingName} "${spirvBinaryEmbeddingName}" PARENT_SCOPE)
-endfunction()
-
-function(CompileHLSL_FormatSpirvBinaryToOctets inInputFile inOctetsPerLine outFormattedOctets outOctetsWritten)
-    set(formattedData "")
-    set(currentLine "")
-    set(count 0)
-    set(octetsWritten 0)
-
-    # Process each byte
-    string(LENGTH "${inInputFile}" binaryLength)
-    math(EXPR lastIndex "${binaryLength} - 1")
-    foreach(index RANGE 0 ${lastIndex} 2)
-        string(SUBSTRING "${inInputFile}" ${index} 2 byte)
-        string(APPEND currentLine "0x${byte}")
-        math(EXPR count "${count} + 1")
-        math(EXPR octetsWritten "${octetsWritten} + 1")
-
-        # Add a comma if this is not the last line of the file.
-        if(NOT index EQUAL ${lastIndex})
-            string(APPEND currentLine ",")
-        endif()
-
-        # Start a new line if we've reached inOctetsPerLine.
-        if(count EQUAL inOctetsPerLine)
-            string(APPEND formattedData "${currentLine}\n")
-            set(currentLine "")
-            set(count 0)
-        else()
-            string(APPEND currentLine " ")
-        endif()
-    endforeach()
-
-    if(NOT currentLine STREQUAL "")
-        string(APPEND formattedData "${currentLine}\n")
-    endif()
-    
-    set(${outFormattedOctets} "${formattedData}" PARENT_SCOPE)
-    set(${outOctetsWritten} "${octetsWritten}" PARENT_SCOPE)
-endfunction()
-
-function(CompileHLSL_EmbedShader inShaderFileName inSpirvBinaryFileName inSpirvBinaryFileData outSpirvBinaryEmbeddingData)
-    string(APPEND shaderName "")
-    CompileHLSL_EmbedShader_GenerateEmbeddingName("${inShaderFileName}" shaderName)
-
-    string(APPEND arrayName "")
-    CompileHLSL_EmbedShader_GenerateEmbeddingName("${inSpirvBinaryFileName}" arrayName)
-
-    set(formattedOctets "")
-    set(octetsWritten 0)
-    CompileHLSL_FormatSpirvBinaryToOctets("${inSpirvBinaryFileData}" 12 formattedOctets octetsWritten)
-    
-    string(REGEX REPLACE "^0x" "    0x" formattedOctets "${formattedOctets}")
-    string(REGEX REPLACE ",\n0x" ",\n    0x" formattedOctets "${formattedOctets}")
-    
-    math(EXPR arraySize "${octetsWritten}")
-
-    string(APPEND combinedContent "// Shader: `${inShaderFileName}`\n")
-    string(APPEND combinedContent "// SPIR-V Binary: `${inSpirvBinaryFileName}`\n")
-    string(APPEND combinedContent "const std::string ${shaderName} = std::string { \"${inShaderFileName}\" };\n")
-    string(APPEND combinedContent "const std::array<uint8_t, ${arraySize}> ${arrayName} = std::array<uint8_t, ${arraySize}> {")
-    string(APPEND combinedContent "\n")
-    string(APPEND combinedContent "${formattedOctets}")
-    string(APPEND combinedContent "};")
-
-    set(${outSpirvBinaryEmbeddingData} "${combinedContent}" PARENT_SCOPE)
-endfunction()
-
-function(CompileHLSL_EmbedShaders inShaderSourceFiles inSpirvBinaryFiles inSpirvBinaries outSpirvBinaryEmbedding)
-    set(spirvBinaryEmbedding)
-    set(listLength 0)
-    list(LENGTH inSpirvBinaries listLength)
-    math(EXPR lastIndex "${listLength} - 1")
-    foreach(index RANGE 0 ${lastIndex})
-        set(shaderSourceFile)
-        list(GET inShaderSourceFiles "${index}" shaderSourceFile)
+#[[
+The arguments `embed_spirv` takes to embed each shader: its file name, and the SPIR-V binary
+it was compiled to.
+]]
+function(CompileHLSL_GetEmbeddingArguments inShaderSourceFiles inSpirvBinaryFiles outEmbeddingArguments)
+    set(embeddingArguments)
+    foreach(shaderSourceFile spirvBinaryFile IN ZIP_LISTS inShaderSourceFiles inSpirvBinaryFiles)
         get_filename_component(shaderSourceFileName "${shaderSourceFile}" NAME)
-
-        set(spirvBinaryFile)
-        list(GET inSpirvBinaryFiles "${index}" spirvBinaryFile)
-        get_filename_component(spirvBinaryFileName "${spirvBinaryFile}" NAME)
-
-        string(APPEND spirvBinary "")
-        list(GET inSpirvBinaries "${index}" spirvBinary)
-
-        set(spirvBinaryEmbeddingFragment)
-        CompileHLSL_EmbedShader("${shaderSourceFileName}" "${spirvBinaryFileName}" "${spirvBinary}" spirvBinaryEmbeddingFragment)
-
-        string(APPEND spirvBinaryEmbedding "\n")
-        string(APPEND spirvBinaryEmbedding "${spirvBinaryEmbeddingFragment}")
-        string(APPEND spirvBinaryEmbedding "\n")
+        list(APPEND embeddingArguments "${shaderSourceFileName}" "${spirvBinaryFile}")
     endforeach()
 
-    set(${outSpirvBinaryEmbedding} "${spirvBinaryEmbedding}" PARENT_SCOPE)
-endfunction()
-
-function(CompileHLSL_GetIncludeGuard inFileName outIncludeGuardName)
-    string(TOUPPER "${inFileName}" includeGuardName)
-    string(REGEX REPLACE "[.-]" "_" includeGuardName "${includeGuardName}")
-    string(PREPEND includeGuardName "_")
-
-    set(${outIncludeGuardName} "${includeGuardName}" PARENT_SCOPE)
-endfunction()
-
-function(CompileHLSL_CreateEmbeddingFile inSpirvEmbedding inFinalShaderEmbeddingOutputPath inFinalShaderEmbeddingFileName outFinalShaderEmbeddingFile)
-    set(finalOutputFileName "${inFinalShaderEmbeddingFileName}.in")
-    set(finalOutputFile "${inFinalShaderEmbeddingOutputPath}/${finalOutputFileName}")
-    
-    set(finalOutputIncludeGuardName)
-    CompileHLSL_GetIncludeGuard("${finalOutputFileName}" finalOutputIncludeGuardName)
-
-    string(APPEND combinedContent "")
-    string(APPEND combinedContent "#ifndef ${finalOutputIncludeGuardName}\n")
-    string(APPEND combinedContent "#define ${finalOutputIncludeGuardName}\n")
-    string(APPEND combinedContent "\n")
-    string(APPEND combinedContent "#include <array>\n")
-    string(APPEND combinedContent "#include <string>\n")
-    string(APPEND combinedContent "\n")
-    string(APPEND combinedContent "${inSpirvEmbedding}")
-    string(APPEND combinedContent "\n")
-    string(APPEND combinedContent "#endif // ${finalOutputIncludeGuardName}")
-    string(APPEND combinedContent "\n")
-
-    file(WRITE "${finalOutputFile}" "${combinedContent}")
-
-    set(${outFinalShaderEmbeddingFile} "${finalOutputFile}" PARENT_SCOPE)
-endfunction()
-
-function(CompileHLSL_BuildShaders HLSL_COMPILER_COMMAND inShaderSourceFiles inFinalShaderEmbeddingOutputPath inFinalShaderEmbeddingFileName outFinalShaderEmbeddingFile)
-    CompileHLSL_CompileShaders(
-        "${HLSL_COMPILER_COMMAND}"
-        "${inShaderSourceFiles}"
-        "${inFinalShaderEmbeddingOutputPath}"
-        spirvBinaryFiles
-    )
-
-    list(APPEND spirvBinaries)
-    CompileHLSL_ReadSpirvBinaries("${spirvBinaryFiles}" spirvBinaries)
-
-    string(APPEND spirvBinaryEmbedding "")
-    CompileHLSL_EmbedShaders("${inShaderSourceFiles}" "${spirvBinaryFiles}" "${spirvBinaries}" spirvBinaryEmbedding)
-
-    CompileHLSL_CreateEmbeddingFile(
-        "${spirvBinaryEmbedding}"
-        "${inFinalShaderEmbeddingOutputPath}"
-        "${inFinalShaderEmbeddingFileName}"
-        spirvBinaryEmbeddingFile
-    )
-
-    set(${outFinalShaderEmbeddingFile} "${spirvBinaryEmbeddingFile}" PARENT_SCOPE)
+    set(${outEmbeddingArguments} "${embeddingArguments}" PARENT_SCOPE)
 endfunction()
 
 function(CompileHLSL_SetupBuildProcess inShaderOutputDir)
@@ -299,6 +221,8 @@ function(CompileHLSL_FindSourceFiles inShaderPath outFoundShaderFiles)
         "${inShaderPath}/*.frag.hlsl"
         "${inShaderPath}/*.vert.hlsl"
         "${inShaderPath}/*.comp.hlsl"
+        "${inShaderPath}/*.task.hlsl"
+        "${inShaderPath}/*.mesh.hlsl"
     )
 
     set(${outFoundShaderFiles} ${HLSL_SOURCE_FILES} PARENT_SCOPE)
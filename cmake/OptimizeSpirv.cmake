@@ -0,0 +1,92 @@
+#[[
+An optional build stage between compiling a shader and embedding it. It runs `spirv-opt` over
+each SPIR-V binary on its own, and reports how many instructions the optimization saved.
+The unoptimized binary is kept next to the optimized one, so debug builds and tools like
+RenderDoc can still use it.
+
+`SPIRV_OPTIMIZATION` picks `None`, `Performance` (`-O`) or `Size` (`-Os`), and
+`SPIRV_STRIP_DEBUG_INFO` strips debug names and source from the embedded binaries. Both
+default to off in Debug builds and on in any other build.
+]]
+function(OptimizeSpirv_DeclareOptions)
+    set(defaultOptimization "Performance")
+    set(defaultStripDebugInfo ON)
+    if(CMAKE_BUILD_TYPE STREQUAL "Debug")
+        set(defaultOptimization "None")
+        set(defaultStripDebugInfo OFF)
+    endif()
+
+    set(SPIRV_OPTIMIZATION "${defaultOptimization}" CACHE STRING "How spirv-opt optimizes the embedded shaders: None, Performance or Size")
+    set_property(CACHE SPIRV_OPTIMIZATION PROPERTY STRINGS "None" "Performance" "Size")
+    option(SPIRV_STRIP_DEBUG_INFO "Strip debug info from the embedded shaders" ${defaultStripDebugInfo})
+endfunction()
+
+function(OptimizeSpirv_GetOptimizerOptions inOptimization inStripDebugInfo outOptimizerOptions)
+    set(optimizerOptions)
+    if(inOptimization STREQUAL "Performance")
+        list(APPEND optimizerOptions -O)
+    elseif(inOptimization STREQUAL "Size")
+        list(APPEND optimizerOptions -Os)
+    elseif(NOT inOptimization STREQUAL "None")
+        message(FATAL_ERROR "Expected `SPIRV_OPTIMIZATION` to be one of `None`, `Performance`, or `Size`. Got `${inOptimization}`.")
+    endif()
+
+    if(inStripDebugInfo)
+        list(APPEND optimizerOptions --strip-debug)
+    endif()
+
+    set(${outOptimizerOptions} "${optimizerOptions}" PARENT_SCOPE)
+endfunction()
+
+#[[
+Find `spirv-opt` when the options ask for any optimization. The stage is skipped, with a
+warning, when it is not installed, and the shaders are embedded as they were compiled.
+]]
+function(OptimizeSpirv_FindOptimizerCommand inOptimizerOptions outSpirvOptCommand)
+    if(NOT inOptimizerOptions)
+        set(${outSpirvOptCommand} "" PARENT_SCOPE)
+        return()
+    endif()
+
+    find_program(_possibleSpirvOptCommand
+        NAMES spirv-opt
+        PATHS /usr/bin
+              /usr/local/bin
+              $ENV{VULKAN_SDK}/Bin/
+              $ENV{VULKAN_SDK}/Bin32/
+    )
+
+    if(${_possibleSpirvOptCommand} STREQUAL "_possibleSpirvOptCommand-NOTFOUND")
+        message(WARNING
+            "`spirv-opt` could not be found, so the shaders are embedded without optimization. "
+            "It comes with the Vulkan SDK, or with the SPIRV-Tools package of your system."
+        )
+        set(${outSpirvOptCommand} "" PARENT_SCOPE)
+        return()
+    endif()
+
+    set(${outSpirvOptCommand} "${_possibleSpirvOptCommand}" PARENT_SCOPE)
+endfunction()
+
+#[[
+Add a build rule that optimizes one SPIR-V binary into `inOptimizedSpirvBinaryPath`, under the
+same file name, so that it embeds under the same name too.
+]]
+function(OptimizeSpirv_AddOptimizeCommand SPIRV_OPT_COMMAND inOptimizerOptions inSpirvBinaryFile inTargetEnvironment inOptimizedSpirvBinaryPath outOptimizedSpirvBinaryFile)
+    get_filename_component(fileName "${inSpirvBinaryFile}" NAME)
+    set(optimizedSpirvBinaryFile "${inOptimizedSpirvBinaryPath}/${fileName}")
+
+    add_custom_command(
+        OUTPUT "${optimizedSpirvBinaryFile}"
+        COMMAND "${CMAKE_COMMAND}" -E make_directory "${inOptimizedSpirvBinaryPath}"
+        COMMAND "${SPIRV_OPT_COMMAND}" ${inOptimizerOptions} --target-env=${inTargetEnvironment} "${inSpirvBinaryFile}" -o "${optimizedSpirvBinaryFile}"
+        COMMAND embed_spirv --compare "${inSpirvBinaryFile}" "${optimizedSpirvBinaryFile}"
+        DEPENDS
+            "${inSpirvBinaryFile}"
+            embed_spirv
+        COMMENT "Optimizing SPIR-V binary `${fileName}`"
+        VERBATIM
+    )
+
+    set(${outOptimizedSpirvBinaryFile} "${optimizedSpirvBinaryFile}" PARENT_SCOPE)
+endfunction()
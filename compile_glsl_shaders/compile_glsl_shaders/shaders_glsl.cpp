@@ -1,14 +1,55 @@
 #include "shaders_glsl.h"
 
+#include <array>
+
 #include "shaders_glsl.h.in"
 
 
-std::unordered_map<std::string, std::vector<uint8_t>> shaders_glsl::createGlslShaders() {
-    const auto shaders = std::unordered_map<std::string, std::vector<uint8_t>> {
-        { shader_frag_glsl, std::vector<uint8_t> { shader_frag_glsl_spv.begin(), shader_frag_glsl_spv.end() } },
-        { shader_vert_glsl, std::vector<uint8_t> { shader_vert_glsl_spv.begin(), shader_vert_glsl_spv.end() } },
-    };
+namespace {
+
+struct EmbeddedShader final {
+    std::string_view name;
+    std::span<const uint32_t> code;
+    embed_spirv::EmbeddedReflection reflection;
+};
+
+}
+
+// In the order of `GlslShader`.
+static constexpr auto EMBEDDED_SHADERS = std::array<EmbeddedShader, 22> {
+    EmbeddedShader { bloom_upsample_comp_glsl, bloom_upsample_comp_glsl_spv, bloom_upsample_comp_glsl_spv_reflection },
+    EmbeddedShader { cull_comp_glsl, cull_comp_glsl_spv, cull_comp_glsl_spv_reflection },
+    EmbeddedShader { depth_vert_glsl, depth_vert_glsl_spv, depth_vert_glsl_spv_reflection },
+    EmbeddedShader { depth_pyramid_comp_glsl, depth_pyramid_comp_glsl_spv, depth_pyramid_comp_glsl_spv_reflection },
+    EmbeddedShader { downsample_comp_glsl, downsample_comp_glsl_spv, downsample_comp_glsl_spv_reflection },
+    EmbeddedShader { fullscreen_vert_glsl, fullscreen_vert_glsl_spv, fullscreen_vert_glsl_spv_reflection },
+    EmbeddedShader { hud_frag_glsl, hud_frag_glsl_spv, hud_frag_glsl_spv_reflection },
+    EmbeddedShader { hud_vert_glsl, hud_vert_glsl_spv, hud_vert_glsl_spv_reflection },
+    EmbeddedShader { lz4_decompress_comp_glsl, lz4_decompress_comp_glsl_spv, lz4_decompress_comp_glsl_spv_reflection },
+    EmbeddedShader { meshlet_mesh_glsl, meshlet_mesh_glsl_spv, meshlet_mesh_glsl_spv_reflection },
+    EmbeddedShader { meshlet_task_glsl, meshlet_task_glsl_spv, meshlet_task_glsl_spv_reflection },
+    EmbeddedShader { mipmap_comp_glsl, mipmap_comp_glsl_spv, mipmap_comp_glsl_spv_reflection },
+    EmbeddedShader { mipmap_filter_comp_glsl, mipmap_filter_comp_glsl_spv, mipmap_filter_comp_glsl_spv_reflection },
+    EmbeddedShader { mipmap_volume_comp_glsl, mipmap_volume_comp_glsl_spv, mipmap_volume_comp_glsl_spv_reflection },
+    EmbeddedShader { occlusion_proxy_vert_glsl, occlusion_proxy_vert_glsl_spv, occlusion_proxy_vert_glsl_spv_reflection },
+    EmbeddedShader { post_process_frag_glsl, post_process_frag_glsl_spv, post_process_frag_glsl_spv_reflection },
+    EmbeddedShader { shader_frag_glsl, shader_frag_glsl_spv, shader_frag_glsl_spv_reflection },
+    EmbeddedShader { shader_vert_glsl, shader_vert_glsl_spv, shader_vert_glsl_spv_reflection },
+    EmbeddedShader { shading_rate_comp_glsl, shading_rate_comp_glsl_spv, shading_rate_comp_glsl_spv_reflection },
+    EmbeddedShader { temporal_upscale_comp_glsl, temporal_upscale_comp_glsl_spv, temporal_upscale_comp_glsl_spv_reflection },
+    EmbeddedShader { texture_compress_comp_glsl, texture_compress_comp_glsl_spv, texture_compress_comp_glsl_spv_reflection },
+    EmbeddedShader { vertex_pull_vert_glsl, vertex_pull_vert_glsl_spv, vertex_pull_vert_glsl_spv_reflection },
+};
+static_assert(EMBEDDED_SHADERS.size() == static_cast<size_t>(shaders_glsl::GlslShader::VertexPullVert) + 1);
+
+std::span<const uint32_t> shaders_glsl::getGlslShader(GlslShader shader) {
+    return EMBEDDED_SHADERS[static_cast<size_t>(shader)].code;
+}
 
-    return shaders;
+std::string_view shaders_glsl::getGlslShaderName(GlslShader shader) {
+    return EMBEDDED_SHADERS[static_cast<size_t>(shader)].name;
 }
 
+const embed_spirv::EmbeddedReflection& shaders_glsl::getGlslShaderReflection(GlslShader shader) {
+    return EMBEDDED_SHADERS[static_cast<size_t>(shader)].reflection;
+}
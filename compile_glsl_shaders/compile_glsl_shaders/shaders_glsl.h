@@ -1,13 +1,51 @@
 #ifndef _SHADERS_GLSL_H
 #define _SHADERS_GLSL_H
 
-#include <unordered_map>
-#include <string>
-#include <vector>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include <embed_spirv/embedded_reflection.h>
 
 namespace shaders_glsl {
 
-std::unordered_map<std::string, std::vector<uint8_t>> createGlslShaders();
+/// @brief The embedded GLSL shaders, one for each source file in `shaders/`.
+enum class GlslShader {
+    BloomUpsampleComp,
+    CullComp,
+    DepthVert,
+    DepthPyramidComp,
+    DownsampleComp,
+    FullscreenVert,
+    HudFrag,
+    HudVert,
+    Lz4DecompressComp,
+    MeshletMesh,
+    MeshletTask,
+    MipmapComp,
+    MipmapFilterComp,
+    MipmapVolumeComp,
+    OcclusionProxyVert,
+    PostProcessFrag,
+    ShaderFrag,
+    ShaderVert,
+    ShadingRateComp,
+    TemporalUpscaleComp,
+    TextureCompressComp,
+    VertexPullVert
+};
+
+/// @brief The SPIR-V `shader` compiled to, as the words `vkCreateShaderModule` takes.
+///
+/// @note The code is embedded in static storage, so the span stays valid for the whole run
+/// and getting it neither allocates nor looks anything up by name.
+std::span<const uint32_t> getGlslShader(GlslShader shader);
+
+/// @brief The file name of the source `shader` was compiled from.
+std::string_view getGlslShaderName(GlslShader shader);
+
+/// @brief The interface of `shader`, reflected from its SPIR-V when the shader was built.
+const embed_spirv::EmbeddedReflection& getGlslShaderReflection(GlslShader shader);
 
 }
 
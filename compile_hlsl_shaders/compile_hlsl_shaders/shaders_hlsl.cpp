@@ -1,14 +1,55 @@
 #include "shaders_hlsl.h"
 
+#include <array>
+
 #include "shaders_hlsl.h.in"
 
 
-std::unordered_map<std::string, std::vector<uint8_t>> shaders_hlsl::createHlslShaders() {
-    const auto shaders = std::unordered_map<std::string, std::vector<uint8_t>> {
-        { shader_frag_hlsl, std::vector<uint8_t> { shader_frag_hlsl_spv.begin(), shader_frag_hlsl_spv.end() } },
-        { shader_vert_hlsl, std::vector<uint8_t> { shader_vert_hlsl_spv.begin(), shader_vert_hlsl_spv.end() } },
-    };
+namespace {
+
+struct EmbeddedShader final {
+    std::string_view name;
+    std::span<const uint32_t> code;
+    embed_spirv::EmbeddedReflection reflection;
+};
+
+}
+
+// In the order of `HlslShader`.
+static constexpr auto EMBEDDED_SHADERS = std::array<EmbeddedShader, 22> {
+    EmbeddedShader { bloom_upsample_comp_hlsl, bloom_upsample_comp_hlsl_spv, bloom_upsample_comp_hlsl_spv_reflection },
+    EmbeddedShader { cull_comp_hlsl, cull_comp_hlsl_spv, cull_comp_hlsl_spv_reflection },
+    EmbeddedShader { depth_vert_hlsl, depth_vert_hlsl_spv, depth_vert_hlsl_spv_reflection },
+    EmbeddedShader { depth_pyramid_comp_hlsl, depth_pyramid_comp_hlsl_spv, depth_pyramid_comp_hlsl_spv_reflection },
+    EmbeddedShader { downsample_comp_hlsl, downsample_comp_hlsl_spv, downsample_comp_hlsl_spv_reflection },
+    EmbeddedShader { fullscreen_vert_hlsl, fullscreen_vert_hlsl_spv, fullscreen_vert_hlsl_spv_reflection },
+    EmbeddedShader { hud_frag_hlsl, hud_frag_hlsl_spv, hud_frag_hlsl_spv_reflection },
+    EmbeddedShader { hud_vert_hlsl, hud_vert_hlsl_spv, hud_vert_hlsl_spv_reflection },
+    EmbeddedShader { lz4_decompress_comp_hlsl, lz4_decompress_comp_hlsl_spv, lz4_decompress_comp_hlsl_spv_reflection },
+    EmbeddedShader { meshlet_mesh_hlsl, meshlet_mesh_hlsl_spv, meshlet_mesh_hlsl_spv_reflection },
+    EmbeddedShader { meshlet_task_hlsl, meshlet_task_hlsl_spv, meshlet_task_hlsl_spv_reflection },
+    EmbeddedShader { mipmap_comp_hlsl, mipmap_comp_hlsl_spv, mipmap_comp_hlsl_spv_reflection },
+    EmbeddedShader { mipmap_filter_comp_hlsl, mipmap_filter_comp_hlsl_spv, mipmap_filter_comp_hlsl_spv_reflection },
+    EmbeddedShader { mipmap_volume_comp_hlsl, mipmap_volume_comp_hlsl_spv, mipmap_volume_comp_hlsl_spv_reflection },
+    EmbeddedShader { occlusion_proxy_vert_hlsl, occlusion_proxy_vert_hlsl_spv, occlusion_proxy_vert_hlsl_spv_reflection },
+    EmbeddedShader { post_process_frag_hlsl, post_process_frag_hlsl_spv, post_process_frag_hlsl_spv_reflection },
+    EmbeddedShader { shader_frag_hlsl, shader_frag_hlsl_spv, shader_frag_hlsl_spv_reflection },
+    EmbeddedShader { shader_vert_hlsl, shader_vert_hlsl_spv, shader_vert_hlsl_spv_reflection },
+    EmbeddedShader { shading_rate_comp_hlsl, shading_rate_comp_hlsl_spv, shading_rate_comp_hlsl_spv_reflection },
+    EmbeddedShader { temporal_upscale_comp_hlsl, temporal_upscale_comp_hlsl_spv, temporal_upscale_comp_hlsl_spv_reflection },
+    EmbeddedShader { texture_compress_comp_hlsl, texture_compress_comp_hlsl_spv, texture_compress_comp_hlsl_spv_reflection },
+    EmbeddedShader { vertex_pull_vert_hlsl, vertex_pull_vert_hlsl_spv, vertex_pull_vert_hlsl_spv_reflection },
+};
+static_assert(EMBEDDED_SHADERS.size() == static_cast<size_t>(shaders_hlsl::HlslShader::VertexPullVert) + 1);
+
+std::span<const uint32_t> shaders_hlsl::getHlslShader(HlslShader shader) {
+    return EMBEDDED_SHADERS[static_cast<size_t>(shader)].code;
+}
 
-    return shaders;
+std::string_view shaders_hlsl::getHlslShaderName(HlslShader shader) {
+    return EMBEDDED_SHADERS[static_cast<size_t>(shader)].name;
 }
 
+const embed_spirv::EmbeddedReflection& shaders_hlsl::getHlslShaderReflection(HlslShader shader) {
+    return EMBEDDED_SHADERS[static_cast<size_t>(shader)].reflection;
+}
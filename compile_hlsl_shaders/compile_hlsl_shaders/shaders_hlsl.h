@@ -1,13 +1,51 @@
 #ifndef _SHADERS_HLSL_H
 #define _SHADERS_HLSL_H
 
-#include <unordered_map>
-#include <string>
-#include <vector>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include <embed_spirv/embedded_reflection.h>
 
 namespace shaders_hlsl {
 
-std::unordered_map<std::string, std::vector<uint8_t>> createHlslShaders();
+/// @brief The embedded HLSL shaders, one for each source file in `shaders/`.
+enum class HlslShader {
+    BloomUpsampleComp,
+    CullComp,
+    DepthVert,
+    DepthPyramidComp,
+    DownsampleComp,
+    FullscreenVert,
+    HudFrag,
+    HudVert,
+    Lz4DecompressComp,
+    MeshletMesh,
+    MeshletTask,
+    MipmapComp,
+    MipmapFilterComp,
+    MipmapVolumeComp,
+    OcclusionProxyVert,
+    PostProcessFrag,
+    ShaderFrag,
+    ShaderVert,
+    ShadingRateComp,
+    TemporalUpscaleComp,
+    TextureCompressComp,
+    VertexPullVert
+};
+
+/// @brief The SPIR-V `shader` compiled to, as the words `vkCreateShaderModule` takes.
+///
+/// @note The code is embedded in static storage, so the span stays valid for the whole run
+/// and getting it neither allocates nor looks anything up by name.
+std::span<const uint32_t> getHlslShader(HlslShader shader);
+
+/// @brief The file name of the source `shader` was compiled from.
+std::string_view getHlslShaderName(HlslShader shader);
+
+/// @brief The interface of `shader`, reflected from its SPIR-V when the shader was built.
+const embed_spirv::EmbeddedReflection& getHlslShaderReflection(HlslShader shader);
 
 }
 
@@ -0,0 +1,747 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+constexpr size_t WORDS_PER_LINE = 6;
+
+/// @brief A shader to embed, and the SPIR-V binary it was compiled to.
+struct ShaderBinary final {
+    std::string shaderFileName;
+    std::filesystem::path spirvBinaryFile;
+};
+
+/// @brief The name of the constant a file is embedded as, which is its name with every
+/// `.` replaced by `_`.
+static std::string getEmbeddingName(const std::string& fileName) {
+    auto embeddingName = fileName;
+    std::replace(embeddingName.begin(), embeddingName.end(), '.', '_');
+
+    return embeddingName;
+}
+
+static std::string getIncludeGuard(const std::string& fileName) {
+    auto includeGuard = std::string { "_" };
+    for (const auto character : fileName) {
+        if (character == '.' || character == '-') {
+            includeGuard.push_back('_');
+        } else {
+            includeGuard.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(character))));
+        }
+    }
+
+    return includeGuard;
+}
+
+/// @brief Read a SPIR-V binary as the words it is made of, in the byte order of the file,
+/// so that the embedded array has the same bytes in memory as the file.
+static std::vector<uint32_t> readSpirvWords(const std::filesystem::path& spirvBinaryFile) {
+    auto file = std::ifstream { spirvBinaryFile, std::ios::in | std::ios::binary };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open SPIR-V binary " + spirvBinaryFile.string() + "!");
+    }
+
+    const auto bytes = std::vector<char> { std::istreambuf_iterator<char> { file }, std::istreambuf_iterator<char> {} };
+    if (bytes.empty() || bytes.size() % sizeof(uint32_t) != 0) {
+        throw std::runtime_error("SPIR-V binary " + spirvBinaryFile.string() + " is not a whole number of words!");
+    }
+
+    auto words = std::vector<uint32_t>(bytes.size() / sizeof(uint32_t));
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+
+    return words;
+}
+
+/// @brief The number of instructions in a SPIR-V module, counted from the word count every
+/// instruction starts with, after the five words of the module header.
+static size_t countSpirvInstructions(const std::vector<uint32_t>& words) {
+    constexpr size_t HEADER_WORD_COUNT = 5;
+
+    auto instructionCount = size_t { 0 };
+    auto offset = HEADER_WORD_COUNT;
+    while (offset < words.size()) {
+        const auto instructionWordCount = words[offset] >> 16;
+        if (instructionWordCount == 0) {
+            throw std::runtime_error("SPIR-V binary has an instruction of no words!");
+        }
+
+        offset += instructionWordCount;
+        instructionCount++;
+    }
+
+    return instructionCount;
+}
+
+/// @brief Print how many instructions and bytes the optimized binary saves over the
+/// original one.
+static void printSpirvComparison(const std::filesystem::path& originalFile, const std::filesystem::path& optimizedFile) {
+    const auto originalWords = readSpirvWords(originalFile);
+    const auto optimizedWords = readSpirvWords(optimizedFile);
+    const auto originalCount = static_cast<double>(countSpirvInstructions(originalWords));
+    const auto optimizedCount = static_cast<double>(countSpirvInstructions(optimizedWords));
+    const auto instructionChange = originalCount > 0.0 ? 100.0 * (optimizedCount - originalCount) / originalCount : 0.0;
+
+    std::cout << optimizedFile.filename().string() << ": "
+        << static_cast<size_t>(originalCount) << " -> " << static_cast<size_t>(optimizedCount) << " instructions ("
+        << std::showpos << std::fixed << std::setprecision(1) << instructionChange << std::noshowpos << "%), "
+        << originalWords.size() * sizeof(uint32_t) << " -> " << optimizedWords.size() * sizeof(uint32_t) << " bytes"
+        << std::endl;
+}
+
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+constexpr size_t SPIRV_HEADER_SIZE = 5;
+
+constexpr uint32_t OP_ENTRY_POINT = 15;
+constexpr uint32_t OP_TYPE_BOOL = 20;
+constexpr uint32_t OP_TYPE_INT = 21;
+constexpr uint32_t OP_TYPE_FLOAT = 22;
+constexpr uint32_t OP_TYPE_VECTOR = 23;
+constexpr uint32_t OP_TYPE_MATRIX = 24;
+constexpr uint32_t OP_TYPE_IMAGE = 25;
+constexpr uint32_t OP_TYPE_SAMPLER = 26;
+constexpr uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+constexpr uint32_t OP_TYPE_ARRAY = 28;
+constexpr uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+constexpr uint32_t OP_TYPE_STRUCT = 30;
+constexpr uint32_t OP_TYPE_POINTER = 32;
+constexpr uint32_t OP_CONSTANT = 43;
+constexpr uint32_t OP_SPEC_CONSTANT = 50;
+constexpr uint32_t OP_VARIABLE = 59;
+constexpr uint32_t OP_DECORATE = 71;
+constexpr uint32_t OP_MEMBER_DECORATE = 72;
+constexpr uint32_t OP_TYPE_ACCELERATION_STRUCTURE = 5341;
+
+constexpr uint32_t DECORATION_BLOCK = 2;
+constexpr uint32_t DECORATION_BUFFER_BLOCK = 3;
+constexpr uint32_t DECORATION_ARRAY_STRIDE = 6;
+constexpr uint32_t DECORATION_MATRIX_STRIDE = 7;
+constexpr uint32_t DECORATION_BUILT_IN = 11;
+constexpr uint32_t DECORATION_LOCATION = 30;
+constexpr uint32_t DECORATION_BINDING = 33;
+constexpr uint32_t DECORATION_DESCRIPTOR_SET = 34;
+constexpr uint32_t DECORATION_OFFSET = 35;
+
+constexpr uint32_t STORAGE_CLASS_UNIFORM_CONSTANT = 0;
+constexpr uint32_t STORAGE_CLASS_INPUT = 1;
+constexpr uint32_t STORAGE_CLASS_UNIFORM = 2;
+constexpr uint32_t STORAGE_CLASS_PUSH_CONSTANT = 9;
+constexpr uint32_t STORAGE_CLASS_STORAGE_BUFFER = 12;
+
+constexpr uint32_t DIM_BUFFER = 5;
+constexpr uint32_t DIM_SUBPASS_DATA = 6;
+
+// The values of the Vulkan enums the reflection is written in, since the tool builds
+// without the Vulkan headers.
+constexpr uint32_t SHADER_STAGE_VERTEX = 0x00000001;
+constexpr uint32_t SHADER_STAGE_TESSELLATION_CONTROL = 0x00000002;
+constexpr uint32_t SHADER_STAGE_TESSELLATION_EVALUATION = 0x00000004;
+constexpr uint32_t SHADER_STAGE_GEOMETRY = 0x00000008;
+constexpr uint32_t SHADER_STAGE_FRAGMENT = 0x00000010;
+constexpr uint32_t SHADER_STAGE_COMPUTE = 0x00000020;
+constexpr uint32_t SHADER_STAGE_TASK = 0x00000040;
+constexpr uint32_t SHADER_STAGE_MESH = 0x00000080;
+
+constexpr uint32_t DESCRIPTOR_TYPE_SAMPLER = 0;
+constexpr uint32_t DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER = 1;
+constexpr uint32_t DESCRIPTOR_TYPE_SAMPLED_IMAGE = 2;
+constexpr uint32_t DESCRIPTOR_TYPE_STORAGE_IMAGE = 3;
+constexpr uint32_t DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER = 4;
+constexpr uint32_t DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER = 5;
+constexpr uint32_t DESCRIPTOR_TYPE_UNIFORM_BUFFER = 6;
+constexpr uint32_t DESCRIPTOR_TYPE_STORAGE_BUFFER = 7;
+constexpr uint32_t DESCRIPTOR_TYPE_INPUT_ATTACHMENT = 10;
+constexpr uint32_t DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE = 1000150000;
+
+// `VK_FORMAT_R32_UINT` and the formats after it, for one to four components.
+constexpr std::array<uint32_t, 4> UNSIGNED_FORMATS = { 98, 101, 104, 107 };
+constexpr std::array<uint32_t, 4> SIGNED_FORMATS = { 99, 102, 105, 108 };
+constexpr std::array<uint32_t, 4> FLOAT_FORMATS = { 100, 103, 106, 109 };
+
+struct SpirvDecorations final {
+    std::optional<uint32_t> set;
+    std::optional<uint32_t> binding;
+    std::optional<uint32_t> location;
+    std::optional<uint32_t> arrayStride;
+    bool isBuiltIn = false;
+    bool isBlock = false;
+    bool isBufferBlock = false;
+};
+
+struct SpirvMemberDecorations final {
+    std::optional<uint32_t> offset;
+    std::optional<uint32_t> matrixStride;
+};
+
+/// @brief A type, with the operands that follow its result id.
+struct SpirvType final {
+    uint32_t opcode;
+    std::vector<uint32_t> operands;
+};
+
+struct SpirvVariable final {
+    uint32_t id;
+    uint32_t pointerType;
+    uint32_t storageClass;
+};
+
+struct SpirvModule final {
+    std::optional<uint32_t> executionModel;
+    std::unordered_map<uint32_t, SpirvDecorations> decorations;
+    std::unordered_map<uint32_t, std::vector<SpirvMemberDecorations>> memberDecorations;
+    std::unordered_map<uint32_t, SpirvType> types;
+    std::unordered_map<uint32_t, uint32_t> constants;
+    std::vector<SpirvVariable> variables;
+
+    const SpirvType& getType(uint32_t id) const {
+        const auto found = this->types.find(id);
+        if (found == this->types.end()) {
+            throw std::runtime_error("failed to reflect shader, a variable has an undeclared type!");
+        }
+
+        return found->second;
+    }
+
+    const SpirvDecorations& getDecorations(uint32_t id) const {
+        static const auto none = SpirvDecorations {};
+        const auto found = this->decorations.find(id);
+
+        return found != this->decorations.end() ? found->second : none;
+    }
+
+    SpirvMemberDecorations getMemberDecorations(uint32_t structId, uint32_t member) const {
+        const auto found = this->memberDecorations.find(structId);
+        if (found == this->memberDecorations.end() || member >= found->second.size()) {
+            return SpirvMemberDecorations {};
+        }
+
+        return found->second[member];
+    }
+
+    uint32_t getArrayLength(const SpirvType& arrayType) const {
+        const auto found = this->constants.find(arrayType.operands.at(1));
+        if (found == this->constants.end()) {
+            throw std::runtime_error("failed to reflect shader, an array has a length that is not a constant!");
+        }
+
+        return found->second;
+    }
+};
+
+/// @brief A descriptor a shader declares, as `embed_spirv::EmbeddedBinding` embeds it.
+struct ReflectedBinding final {
+    uint32_t set;
+    uint32_t binding;
+    uint32_t descriptorType;
+    uint32_t descriptorCount;
+};
+
+struct ReflectedVertexInput final {
+    uint32_t location;
+    uint32_t format;
+};
+
+/// @brief The interface of a shader, as `embed_spirv::EmbeddedReflection` embeds it.
+struct ShaderReflection final {
+    uint32_t stage = 0;
+    std::vector<ReflectedBinding> bindings;
+    uint32_t pushConstantOffset = 0;
+    uint32_t pushConstantSize = 0;
+    std::vector<ReflectedVertexInput> vertexInputs;
+};
+
+static SpirvModule parseSpirvModule(const std::vector<uint32_t>& words) {
+    if (words.size() < SPIRV_HEADER_SIZE || words[0] != SPIRV_MAGIC) {
+        throw std::runtime_error("failed to reflect shader, the binary is not SPIR-V!");
+    }
+
+    const auto code = std::span<const uint32_t> { words };
+    auto module = SpirvModule {};
+    auto offset = SPIRV_HEADER_SIZE;
+    while (offset < code.size()) {
+        const auto wordCount = code[offset] >> 16;
+        const auto opcode = code[offset] & 0xffff;
+        if (wordCount == 0 || offset + wordCount > code.size()) {
+            throw std::runtime_error("failed to reflect shader, an instruction runs past the end of the code!");
+        }
+
+        const auto operands = code.subspan(offset + 1, wordCount - 1);
+        offset += wordCount;
+        switch (opcode) {
+            case OP_ENTRY_POINT: {
+                if (!module.executionModel.has_value()) {
+                    module.executionModel = operands[0];
+                }
+                break;
+            }
+            case OP_DECORATE: {
+                auto& decorations = module.decorations[operands[0]];
+                const auto value = operands.size() > 2 ? std::optional<uint32_t> { operands[2] } : std::nullopt;
+                switch (operands[1]) {
+                    case DECORATION_BLOCK: decorations.isBlock = true; break;
+                    case DECORATION_BUFFER_BLOCK: decorations.isBufferBlock = true; break;
+                    case DECORATION_ARRAY_STRIDE: decorations.arrayStride = value; break;
+                    case DECORATION_BUILT_IN: decorations.isBuiltIn = true; break;
+                    case DECORATION_LOCATION: decorations.location = value; break;
+                    case DECORATION_BINDING: decorations.binding = value; break;
+                    case DECORATION_DESCRIPTOR_SET: decorations.set = value; break;
+                    default: break;
+                }
+                break;
+            }
+            case OP_MEMBER_DECORATE: {
+                if (operands.size() < 4) {
+                    break;
+                }
+
+                auto& members = module.memberDecorations[operands[0]];
+                if (members.size() <= operands[1]) {
+                    members.resize(operands[1] + 1);
+                }
+                if (operands[2] == DECORATION_OFFSET) {
+                    members[operands[1]].offset = operands[3];
+                } else if (operands[2] == DECORATION_MATRIX_STRIDE) {
+                    members[operands[1]].matrixStride = operands[3];
+                }
+                break;
+            }
+            case OP_TYPE_BOOL:
+            case OP_TYPE_INT:
+            case OP_TYPE_FLOAT:
+            case OP_TYPE_VECTOR:
+            case OP_TYPE_MATRIX:
+            case OP_TYPE_IMAGE:
+            case OP_TYPE_SAMPLER:
+            case OP_TYPE_SAMPLED_IMAGE:
+            case OP_TYPE_ARRAY:
+            case OP_TYPE_RUNTIME_ARRAY:
+            case OP_TYPE_STRUCT:
+            case OP_TYPE_POINTER:
+            case OP_TYPE_ACCELERATION_STRUCTURE: {
+                module.types.insert_or_assign(operands[0], SpirvType {
+                    .opcode = opcode,
+                    .operands = std::vector<uint32_t>(operands.begin() + 1, operands.end()),
+                });
+                break;
+            }
+            case OP_CONSTANT:
+            case OP_SPEC_CONSTANT: {
+                // Only the low word matters for array lengths.
+                if (operands.size() > 2) {
+                    module.constants.insert_or_assign(operands[1], operands[2]);
+                }
+                break;
+            }
+            case OP_VARIABLE: {
+                module.variables.push_back(SpirvVariable {
+                    .id = operands[1],
+                    .pointerType = operands[0],
+                    .storageClass = operands[2],
+                });
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if (!module.executionModel.has_value()) {
+        throw std::runtime_error("failed to reflect shader, it has no entry point!");
+    }
+
+    return module;
+}
+
+static uint32_t getStageOfExecutionModel(uint32_t executionModel) {
+    switch (executionModel) {
+        case 0: return SHADER_STAGE_VERTEX;
+        case 1: return SHADER_STAGE_TESSELLATION_CONTROL;
+        case 2: return SHADER_STAGE_TESSELLATION_EVALUATION;
+        case 3: return SHADER_STAGE_GEOMETRY;
+        case 4: return SHADER_STAGE_FRAGMENT;
+        case 5: return SHADER_STAGE_COMPUTE;
+        case 5364: return SHADER_STAGE_TASK;
+        case 5365: return SHADER_STAGE_MESH;
+        default: throw std::runtime_error("failed to reflect shader, its stage is not supported!");
+    }
+}
+
+/// @brief The bytes `typeId` takes in a block, where a matrix member is laid out with
+/// `matrixStride`.
+static uint32_t getTypeSize(const SpirvModule& module, uint32_t typeId, std::optional<uint32_t> matrixStride) {
+    const auto& type = module.getType(typeId);
+    switch (type.opcode) {
+        case OP_TYPE_INT:
+        case OP_TYPE_FLOAT:
+            return type.operands[0] / 8;
+        case OP_TYPE_VECTOR:
+            return type.operands[1] * getTypeSize(module, type.operands[0], std::nullopt);
+        case OP_TYPE_MATRIX:
+            return type.operands[1] * matrixStride.value_or(getTypeSize(module, type.operands[0], std::nullopt));
+        case OP_TYPE_ARRAY: {
+            const auto stride = module.getDecorations(typeId).arrayStride;
+            const auto elementSize = stride.value_or(getTypeSize(module, type.operands[0], matrixStride));
+
+            return module.getArrayLength(type) * elementSize;
+        }
+        case OP_TYPE_STRUCT: {
+            auto size = uint32_t { 0 };
+            for (uint32_t member = 0; member < type.operands.size(); member++) {
+                const auto memberDecorations = module.getMemberDecorations(typeId, member);
+                const auto memberSize = getTypeSize(module, type.operands[member], memberDecorations.matrixStride);
+                size = std::max(size, memberDecorations.offset.value_or(size) + memberSize);
+            }
+
+            return size;
+        }
+        case OP_TYPE_POINTER:
+            return sizeof(uint64_t);
+        default:
+            throw std::runtime_error("failed to reflect shader, a block holds a type without a size!");
+    }
+}
+
+static uint32_t getDescriptorType(const SpirvModule& module, const SpirvType& type, uint32_t typeId, uint32_t storageClass) {
+    switch (type.opcode) {
+        case OP_TYPE_SAMPLED_IMAGE:
+            return DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        case OP_TYPE_SAMPLER:
+            return DESCRIPTOR_TYPE_SAMPLER;
+        case OP_TYPE_ACCELERATION_STRUCTURE:
+            return DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE;
+        case OP_TYPE_IMAGE: {
+            const auto dim = type.operands[1];
+            const auto isStorage = type.operands[5] == 2;
+            if (dim == DIM_SUBPASS_DATA) {
+                return DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            } else if (dim == DIM_BUFFER) {
+                return isStorage ? DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            } else {
+                return isStorage ? DESCRIPTOR_TYPE_STORAGE_IMAGE : DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            }
+        }
+        case OP_TYPE_STRUCT: {
+            // Before SPIR-V 1.3, storage buffers are uniform blocks with a buffer block
+            // decoration.
+            const auto& decorations = module.getDecorations(typeId);
+            if (storageClass == STORAGE_CLASS_STORAGE_BUFFER || decorations.isBufferBlock) {
+                return DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            }
+
+            return DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        }
+        default:
+            throw std::runtime_error("failed to reflect shader, a descriptor has a type that is not supported!");
+    }
+}
+
+/// @brief Add `binding` to `bindings`, or combine it with the binding already there, where
+/// an image and a sampler at the same binding, as HLSL declares them, make a combined
+/// image sampler.
+static void addBinding(std::vector<ReflectedBinding>& bindings, const ReflectedBinding& binding) {
+    const auto found = std::find_if(bindings.begin(), bindings.end(), [&binding](const auto& other) {
+        return other.set == binding.set && other.binding == binding.binding;
+    });
+    if (found == bindings.end()) {
+        bindings.push_back(binding);
+        return;
+    }
+
+    const auto isImageOrSampler = [](uint32_t type) {
+        return type == DESCRIPTOR_TYPE_SAMPLED_IMAGE
+            || type == DESCRIPTOR_TYPE_SAMPLER
+            || type == DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    };
+    if (found->descriptorCount != binding.descriptorCount) {
+        throw std::runtime_error("failed to reflect shader, two descriptors share a binding!");
+    }
+    if (found->descriptorType != binding.descriptorType) {
+        if (!isImageOrSampler(found->descriptorType) || !isImageOrSampler(binding.descriptorType)) {
+            throw std::runtime_error("failed to reflect shader, two descriptors share a binding!");
+        }
+
+        found->descriptorType = DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    }
+}
+
+static std::optional<uint32_t> getVertexInputFormat(const SpirvModule& module, uint32_t typeId) {
+    const auto& type = module.getType(typeId);
+    const auto componentCount = type.opcode == OP_TYPE_VECTOR ? type.operands[1] : 1;
+    const auto& componentType = type.opcode == OP_TYPE_VECTOR ? module.getType(type.operands[0]) : type;
+    if (componentCount < 1 || componentCount > 4 || componentType.operands[0] != 32) {
+        return std::nullopt;
+    }
+
+    if (componentType.opcode == OP_TYPE_FLOAT) {
+        return FLOAT_FORMATS[componentCount - 1];
+    } else if (componentType.opcode == OP_TYPE_INT) {
+        return componentType.operands[1] != 0 ? SIGNED_FORMATS[componentCount - 1] : UNSIGNED_FORMATS[componentCount - 1];
+    }
+
+    return std::nullopt;
+}
+
+/// @brief Add the inputs of a variable of `typeId` at `location` to `vertexInputs`, a
+/// location for every column of a matrix and every element of an array.
+static void addVertexInputs(std::vector<ReflectedVertexInput>& vertexInputs, const SpirvModule& module, uint32_t typeId, uint32_t location) {
+    const auto& type = module.getType(typeId);
+    if (type.opcode == OP_TYPE_ARRAY || type.opcode == OP_TYPE_MATRIX) {
+        const auto& elementType = module.getType(type.operands[0]);
+        const auto count = type.opcode == OP_TYPE_ARRAY ? module.getArrayLength(type) : type.operands[1];
+        const auto elementLocations = elementType.opcode == OP_TYPE_MATRIX ? elementType.operands[1] : 1;
+        for (uint32_t element = 0; element < count; element++) {
+            addVertexInputs(vertexInputs, module, type.operands[0], location + element * elementLocations);
+        }
+        return;
+    }
+
+    const auto format = getVertexInputFormat(module, typeId);
+    if (!format.has_value()) {
+        throw std::runtime_error("failed to reflect shader, a vertex input has a type that is not supported!");
+    }
+
+    vertexInputs.push_back(ReflectedVertexInput {
+        .location = location,
+        .format = format.value(),
+    });
+}
+
+/// @brief Reflect the interface of a SPIR-V module.
+///
+/// @note Only the first entry point is looked at. A push constant block spans from the
+/// offset of its first member to the end of its last, and inputs with a built-in
+/// decoration are not vertex inputs.
+static ShaderReflection reflectSpirv(const std::vector<uint32_t>& words) {
+    const auto module = parseSpirvModule(words);
+
+    auto reflection = ShaderReflection {};
+    reflection.stage = getStageOfExecutionModel(module.executionModel.value());
+    for (const auto& variable : module.variables) {
+        const auto& pointerType = module.getType(variable.pointerType);
+        if (pointerType.opcode != OP_TYPE_POINTER) {
+            throw std::runtime_error("failed to reflect shader, a variable is not a pointer!");
+        }
+
+        const auto typeId = pointerType.operands[1];
+        const auto& decorations = module.getDecorations(variable.id);
+        switch (variable.storageClass) {
+            case STORAGE_CLASS_PUSH_CONSTANT: {
+                const auto& blockType = module.getType(typeId);
+                auto begin = UINT32_MAX;
+                for (uint32_t member = 0; member < blockType.operands.size(); member++) {
+                    begin = std::min(begin, module.getMemberDecorations(typeId, member).offset.value_or(0));
+                }
+                const auto end = getTypeSize(module, typeId, std::nullopt);
+                if (end > begin) {
+                    reflection.pushConstantOffset = begin;
+                    reflection.pushConstantSize = end - begin;
+                }
+                break;
+            }
+            case STORAGE_CLASS_INPUT: {
+                if (reflection.stage == SHADER_STAGE_VERTEX && !decorations.isBuiltIn && decorations.location.has_value()) {
+                    addVertexInputs(reflection.vertexInputs, module, typeId, decorations.location.value());
+                }
+                break;
+            }
+            case STORAGE_CLASS_UNIFORM_CONSTANT:
+            case STORAGE_CLASS_UNIFORM:
+            case STORAGE_CLASS_STORAGE_BUFFER: {
+                if (!decorations.binding.has_value()) {
+                    break;
+                }
+
+                // An array of descriptors is as many descriptors as it has elements, and an
+                // array without a size leaves the count to the layout.
+                auto descriptorCount = uint32_t { 1 };
+                auto elementTypeId = typeId;
+                while (true) {
+                    const auto& elementType = module.getType(elementTypeId);
+                    if (elementType.opcode == OP_TYPE_ARRAY) {
+                        descriptorCount *= module.getArrayLength(elementType);
+                    } else if (elementType.opcode == OP_TYPE_RUNTIME_ARRAY) {
+                        descriptorCount = 0;
+                    } else {
+                        break;
+                    }
+                    elementTypeId = elementType.operands[0];
+                }
+
+                addBinding(reflection.bindings, ReflectedBinding {
+                    .set = decorations.set.value_or(0),
+                    .binding = decorations.binding.value(),
+                    .descriptorType = getDescriptorType(module, module.getType(elementTypeId), elementTypeId, variable.storageClass),
+                    .descriptorCount = descriptorCount,
+                });
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const auto& first, const auto& second) {
+        return first.set != second.set ? first.set < second.set : first.binding < second.binding;
+    });
+    std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const auto& first, const auto& second) {
+        return first.location < second.location;
+    });
+
+    return reflection;
+}
+
+/// @brief Write the reflection of a shader as `<arrayName>_bindings`,
+/// `<arrayName>_vertex_inputs` and `<arrayName>_reflection`, the last of which points into
+/// the other two.
+static void writeShaderReflection(std::ostream& output, const std::string& arrayName, const ShaderReflection& reflection) {
+    output << "constexpr std::array<embed_spirv::EmbeddedBinding, " << reflection.bindings.size() << "> " << arrayName << "_bindings = {\n";
+    for (const auto& binding : reflection.bindings) {
+        output << "    embed_spirv::EmbeddedBinding { "
+            << ".set = " << binding.set << ", "
+            << ".binding = " << binding.binding << ", "
+            << ".descriptorType = " << binding.descriptorType << ", "
+            << ".descriptorCount = " << binding.descriptorCount << " },\n";
+    }
+    output << "};\n";
+    output << "constexpr std::array<embed_spirv::EmbeddedVertexInput, " << reflection.vertexInputs.size() << "> " << arrayName << "_vertex_inputs = {\n";
+    for (const auto& vertexInput : reflection.vertexInputs) {
+        output << "    embed_spirv::EmbeddedVertexInput { "
+            << ".location = " << vertexInput.location << ", "
+            << ".format = " << vertexInput.format << " },\n";
+    }
+    output << "};\n";
+    output << "constexpr embed_spirv::EmbeddedReflection " << arrayName << "_reflection = embed_spirv::EmbeddedReflection {\n";
+    output << "    .stage = 0x" << std::hex << std::setw(8) << std::setfill('0') << reflection.stage << std::dec << ",\n";
+    output << "    .bindings = " << arrayName << "_bindings,\n";
+    output << "    .pushConstantOffset = " << reflection.pushConstantOffset << ",\n";
+    output << "    .pushConstantSize = " << reflection.pushConstantSize << ",\n";
+    output << "    .vertexInputs = " << arrayName << "_vertex_inputs,\n";
+    output << "};\n";
+}
+
+static void writeShaderEmbedding(std::ostream& output, const ShaderBinary& shaderBinary) {
+    const auto spirvBinaryFileName = shaderBinary.spirvBinaryFile.filename().string();
+    const auto shaderName = getEmbeddingName(shaderBinary.shaderFileName);
+    const auto arrayName = getEmbeddingName(spirvBinaryFileName);
+    const auto words = readSpirvWords(shaderBinary.spirvBinaryFile);
+    const auto reflection = [&]() {
+        try {
+            return reflectSpirv(words);
+        } catch (const std::runtime_error& error) {
+            throw std::runtime_error(spirvBinaryFileName + ": " + error.what());
+        }
+    }();
+
+    output << "\n";
+    output << "// Shader: `" << shaderBinary.shaderFileName << "`\n";
+    output << "// SPIR-V Binary: `" << spirvBinaryFileName << "`\n";
+    output << "constexpr std::string_view " << shaderName << " = std::string_view { \"" << shaderBinary.shaderFileName << "\" };\n";
+    output << "constexpr std::array<uint32_t, " << words.size() << "> " << arrayName << " = std::array<uint32_t, " << words.size() << "> {\n";
+    for (size_t i = 0; i < words.size(); i++) {
+        output << (i % WORDS_PER_LINE == 0 ? "    " : " ");
+        output << "0x" << std::hex << std::setw(8) << std::setfill('0') << words[i] << std::dec << ",";
+        if (i % WORDS_PER_LINE == WORDS_PER_LINE - 1 || i == words.size() - 1) {
+            output << "\n";
+        }
+    }
+    output << "};\n";
+    writeShaderReflection(output, arrayName, reflection);
+}
+
+static std::string createEmbeddingFile(const std::string& embeddingFileName, const std::vector<ShaderBinary>& shaderBinaries) {
+    const auto includeGuard = getIncludeGuard(embeddingFileName);
+
+    auto output = std::ostringstream {};
+    output << "#ifndef " << includeGuard << "\n";
+    output << "#define " << includeGuard << "\n";
+    output << "\n";
+    output << "#include <array>\n";
+    output << "#include <cstdint>\n";
+    output << "#include <string_view>\n";
+    output << "\n";
+    output << "#include <embed_spirv/embedded_reflection.h>\n";
+    output << "\n";
+    for (const auto& shaderBinary : shaderBinaries) {
+        writeShaderEmbedding(output, shaderBinary);
+    }
+    output << "\n";
+    output << "#endif // " << includeGuard << "\n";
+
+    return output.str();
+}
+
+/// @brief Write `contents` to `filePath` unless the file already holds them, so that
+/// sources including it are not rebuilt when the shaders compiled to the same binaries.
+static void writeFileIfChanged(const std::filesystem::path& filePath, const std::string& contents) {
+    auto existingFile = std::ifstream { filePath, std::ios::in | std::ios::binary };
+    if (existingFile.is_open()) {
+        const auto existingContents = std::string { std::istreambuf_iterator<char> { existingFile }, std::istreambuf_iterator<char> {} };
+        if (existingContents == contents) {
+            return;
+        }
+    }
+    existingFile.close();
+
+    auto file = std::ofstream { filePath, std::ios::out | std::ios::binary | std::ios::trunc };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open embedding file " + filePath.string() + "!");
+    }
+
+    file << contents;
+}
+
+/// @brief Usage: `embed_spirv <embedding file> [<shader file name> <SPIR-V binary>]...`, or
+/// `embed_spirv --compare <original binary> <optimized binary>` to report what an
+/// optimization saved.
+int main(int argc, char* argv[]) {
+    if (argc == 4 && std::string { argv[1] } == "--compare") {
+        try {
+            printSpirvComparison(std::filesystem::path { argv[2] }, std::filesystem::path { argv[3] });
+        } catch (const std::exception& exception) {
+            std::cerr << "embed_spirv: " << exception.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    if (argc < 2 || argc % 2 != 0) {
+        std::cerr << "Usage: embed_spirv <embedding file> [<shader file name> <SPIR-V binary>]..." << std::endl;
+        std::cerr << "       embed_spirv --compare <original binary> <optimized binary>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const auto embeddingFile = std::filesystem::path { argv[1] };
+        auto shaderBinaries = std::vector<ShaderBinary> {};
+        for (int i = 2; i < argc; i += 2) {
+            shaderBinaries.push_back(ShaderBinary {
+                .shaderFileName = std::string { argv[i] },
+                .spirvBinaryFile = std::filesystem::path { argv[i + 1] },
+            });
+        }
+
+        const auto contents = createEmbeddingFile(embeddingFile.filename().string(), shaderBinaries);
+        writeFileIfChanged(embeddingFile, contents);
+    } catch (const std::exception& exception) {
+        std::cerr << "embed_spirv: " << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
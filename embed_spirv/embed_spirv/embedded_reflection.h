@@ -0,0 +1,44 @@
+#ifndef _EMBEDDED_REFLECTION_H
+#define _EMBEDDED_REFLECTION_H
+
+#include <cstdint>
+#include <span>
+
+namespace embed_spirv {
+
+/// @brief A descriptor a shader declares.
+///
+/// @note The descriptor type is the value of its `VkDescriptorType`, so that neither the
+/// embedding tool nor the embedded shaders need the Vulkan headers.
+struct EmbeddedBinding final {
+    uint32_t set;
+    uint32_t binding;
+    uint32_t descriptorType;
+    /// @brief The descriptors of the binding, or zero for an array without a size, which
+    /// the layout has to give one.
+    uint32_t descriptorCount;
+};
+
+/// @brief An input of a vertex shader, with the value of the `VkFormat` it is read as.
+struct EmbeddedVertexInput final {
+    uint32_t location;
+    uint32_t format;
+};
+
+/// @brief The interface of a shader, reflected from its SPIR-V by `embed_spirv` when the
+/// shader is built: the value of its `VkShaderStageFlagBits`, the descriptors it declares,
+/// the range of push constants it reads, and the inputs of a vertex shader.
+///
+/// @note A push constant size of zero means the shader reads no push constants. The
+/// bindings are ordered by set and binding, and the vertex inputs by location.
+struct EmbeddedReflection final {
+    uint32_t stage;
+    std::span<const EmbeddedBinding> bindings;
+    uint32_t pushConstantOffset;
+    uint32_t pushConstantSize;
+    std::span<const EmbeddedVertexInput> vertexInputs;
+};
+
+}
+
+#endif // _EMBEDDED_REFLECTION_H
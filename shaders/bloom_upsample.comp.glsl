@@ -0,0 +1,50 @@
+#version 450
+
+// Adds one level of the bloom chain into the level above it. Every thread reads its
+// destination texel, which the downsampler left holding the scene color at that level,
+// and adds the level below sampled with a 3x3 tent filter, so that the chain is blurred
+// wider with every level it is upsampled through. Run from the smallest level up, the
+// first level ends up holding the sum of every level.
+#define THREAD_COUNT_X 8
+#define THREAD_COUNT_Y 8
+
+layout(local_size_x = THREAD_COUNT_X, local_size_y = THREAD_COUNT_Y, local_size_z = 1) in;
+
+layout(push_constant) uniform PushConstants {
+    uvec2 sourceExtent;
+    uvec2 destinationExtent;
+    // The distance between the taps of the tent filter, in texels of the source.
+    float radius;
+} pushConstants;
+
+layout(set = 0, binding = 0) uniform texture2D source;
+layout(set = 0, binding = 1) uniform sampler linearSampler;
+layout(set = 0, binding = 2, rgba16f) uniform image2D destination;
+
+
+vec4 sampleSource(vec2 uv) {
+    return textureLod(sampler2D(source, linearSampler), uv, 0.0);
+}
+
+void main() {
+    uvec2 texel = gl_GlobalInvocationID.xy;
+    if (any(greaterThanEqual(texel, pushConstants.destinationExtent))) {
+        return;
+    }
+
+    vec2 uv = (vec2(texel) + 0.5) / vec2(pushConstants.destinationExtent);
+    vec2 offset = pushConstants.radius / vec2(pushConstants.sourceExtent);
+
+    vec4 upsampled = 4.0 * sampleSource(uv);
+    upsampled += 2.0 * sampleSource(uv + vec2(-offset.x, 0.0));
+    upsampled += 2.0 * sampleSource(uv + vec2(offset.x, 0.0));
+    upsampled += 2.0 * sampleSource(uv + vec2(0.0, -offset.y));
+    upsampled += 2.0 * sampleSource(uv + vec2(0.0, offset.y));
+    upsampled += sampleSource(uv + vec2(-offset.x, -offset.y));
+    upsampled += sampleSource(uv + vec2(offset.x, -offset.y));
+    upsampled += sampleSource(uv + vec2(-offset.x, offset.y));
+    upsampled += sampleSource(uv + vec2(offset.x, offset.y));
+
+    ivec2 coord = ivec2(texel);
+    imageStore(destination, coord, imageLoad(destination, coord) + upsampled / 16.0);
+}
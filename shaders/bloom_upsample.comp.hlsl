@@ -0,0 +1,44 @@
+// Adds one level of the bloom chain into the level above it. Every thread reads its
+// destination texel, which the downsampler left holding the scene color at that level,
+// and adds the level below sampled with a 3x3 tent filter, so that the chain is blurred
+// wider with every level it is upsampled through. Run from the smallest level up, the
+// first level ends up holding the sum of every level.
+#define THREAD_COUNT_X 8
+#define THREAD_COUNT_Y 8
+
+struct CS_PushConstants {
+    uint2 sourceExtent;
+    uint2 destinationExtent;
+    // The distance between the taps of the tent filter, in texels of the source.
+    float radius;
+};
+
+[[vk::push_constant]] CS_PushConstants pushConstants;
+
+[[vk::binding(0, 0)]] Texture2D<float4> source;
+[[vk::binding(1, 0)]] SamplerState linearSampler;
+[[vk::binding(2, 0)]] [[vk::image_format("rgba16f")]] RWTexture2D<float4> destination;
+
+
+[numthreads(THREAD_COUNT_X, THREAD_COUNT_Y, 1)]
+void main(uint3 dispatchThreadId : SV_DispatchThreadID) {
+    uint2 texel = dispatchThreadId.xy;
+    if (any(texel >= pushConstants.destinationExtent)) {
+        return;
+    }
+
+    float2 uv = (float2(texel) + 0.5f) / float2(pushConstants.destinationExtent);
+    float2 offset = pushConstants.radius / float2(pushConstants.sourceExtent);
+
+    float4 upsampled = 4.0f * source.SampleLevel(linearSampler, uv, 0.0f);
+    upsampled += 2.0f * source.SampleLevel(linearSampler, uv + float2(-offset.x, 0.0f), 0.0f);
+    upsampled += 2.0f * source.SampleLevel(linearSampler, uv + float2(offset.x, 0.0f), 0.0f);
+    upsampled += 2.0f * source.SampleLevel(linearSampler, uv + float2(0.0f, -offset.y), 0.0f);
+    upsampled += 2.0f * source.SampleLevel(linearSampler, uv + float2(0.0f, offset.y), 0.0f);
+    upsampled += source.SampleLevel(linearSampler, uv + float2(-offset.x, -offset.y), 0.0f);
+    upsampled += source.SampleLevel(linearSampler, uv + float2(offset.x, -offset.y), 0.0f);
+    upsampled += source.SampleLevel(linearSampler, uv + float2(-offset.x, offset.y), 0.0f);
+    upsampled += source.SampleLevel(linearSampler, uv + float2(offset.x, offset.y), 0.0f);
+
+    destination[texel] = destination[texel] + upsampled / 16.0f;
+}
@@ -0,0 +1,139 @@
+#version 450
+#extension GL_EXT_samplerless_texture_functions : require
+
+// Culls the indirect draws of a frame against the view frustum before the scene is drawn.
+// Every invocation tests the bounding sphere of the instance of one candidate draw, and
+// the draws that survive are compacted into the culled draws, whose count the draw reads.
+// With occlusion culling, the draws behind the depth pyramid of the frame before are
+// culled too.
+#define THREAD_COUNT 64
+// A `VkDrawIndexedIndirectCommand` is five words, with the first instance last.
+#define DRAW_COMMAND_SIZE 5
+#define FIRST_INSTANCE 4
+
+layout(local_size_x = THREAD_COUNT, local_size_y = 1, local_size_z = 1) in;
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 viewProj;
+    vec4 cameraPosition;
+    // The view projection the depth pyramid was built with.
+    mat4 depthPyramidViewProj;
+} ubo;
+
+// The offsets of the frame's regions in both draw buffers, in words.
+layout(push_constant) uniform PushConstants {
+    uint countOffset;
+    uint drawOffset;
+    uint cullOcclusion;
+    // Whether depth runs from one at the near plane to zero at the far plane.
+    uint isReverseDepth;
+} pushConstants;
+
+layout(set = 0, binding = 1) readonly buffer CandidateDraws {
+    uint candidateDraws[];
+};
+
+// The bounding sphere of every instance in world space, with the radius in `w`.
+layout(set = 0, binding = 2) readonly buffer BoundingSpheres {
+    vec4 boundingSpheres[];
+};
+
+layout(set = 0, binding = 3) buffer CulledDraws {
+    uint culledDraws[];
+};
+
+// The farthest depth under every texel of every level.
+layout(set = 0, binding = 4) uniform texture2D depthPyramid;
+
+
+bool isInsideFrustum(vec3 center, float radius) {
+    // The planes of the clip volume in world space, with depth from zero to one. Reverse-Z
+    // swaps the near and far planes, and a far plane at infinity culls nothing.
+    const mat4 viewProj = transpose(ubo.viewProj);
+    const vec4 planes[6] = vec4[6](
+        viewProj[3] + viewProj[0],
+        viewProj[3] - viewProj[0],
+        viewProj[3] + viewProj[1],
+        viewProj[3] - viewProj[1],
+        viewProj[2],
+        viewProj[3] - viewProj[2]
+    );
+
+    for (int i = 0; i < 6; i++) {
+        if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isOccluded(vec3 center, float radius) {
+    // The bounds of the sphere on the screen, and its nearest depth, from the corners of
+    // the box around it.
+    vec2 minUv = vec2(1.0);
+    vec2 maxUv = vec2(0.0);
+    const bool isReverseDepth = pushConstants.isReverseDepth != 0;
+    float nearestDepth = isReverseDepth ? 0.0 : 1.0;
+    for (uint i = 0; i < 8; i++) {
+        const vec3 corner = center + radius * vec3(
+            (i & 1u) != 0u ? 1.0 : -1.0,
+            (i & 2u) != 0u ? 1.0 : -1.0,
+            (i & 4u) != 0u ? 1.0 : -1.0
+        );
+        const vec4 clipPosition = ubo.depthPyramidViewProj * vec4(corner, 1.0);
+        if (clipPosition.w <= 0.0) {
+            // The box reaches behind the camera.
+            return false;
+        }
+
+        const vec3 ndcPosition = clipPosition.xyz / clipPosition.w;
+        const vec2 uv = ndcPosition.xy * 0.5 + 0.5;
+        minUv = min(minUv, uv);
+        maxUv = max(maxUv, uv);
+        nearestDepth = isReverseDepth ? max(nearestDepth, ndcPosition.z) : min(nearestDepth, ndcPosition.z);
+    }
+    minUv = clamp(minUv, 0.0, 1.0);
+    maxUv = clamp(maxUv, 0.0, 1.0);
+
+    // The level at which the bounds cover at most two by two texels.
+    const vec2 size = (maxUv - minUv) * vec2(textureSize(depthPyramid, 0));
+    const int level = min(int(ceil(log2(max(max(size.x, size.y), 1.0)))), textureQueryLevels(depthPyramid) - 1);
+
+    const ivec2 levelSize = textureSize(depthPyramid, level);
+    const ivec2 first = min(ivec2(minUv * vec2(levelSize)), levelSize - 1);
+    const ivec2 last = min(ivec2(maxUv * vec2(levelSize)), levelSize - 1);
+
+    float farthestDepth = isReverseDepth ? 1.0 : 0.0;
+    for (int y = first.y; y <= last.y; y++) {
+        for (int x = first.x; x <= last.x; x++) {
+            const float depth = texelFetch(depthPyramid, ivec2(x, y), level).r;
+            farthestDepth = isReverseDepth ? min(farthestDepth, depth) : max(farthestDepth, depth);
+        }
+    }
+
+    return isReverseDepth ? nearestDepth < farthestDepth : nearestDepth > farthestDepth;
+}
+
+void main() {
+    const uint drawIndex = gl_GlobalInvocationID.x;
+    if (drawIndex >= candidateDraws[pushConstants.countOffset]) {
+        return;
+    }
+
+    const uint candidateDraw = pushConstants.drawOffset + drawIndex * DRAW_COMMAND_SIZE;
+    const vec4 boundingSphere = boundingSpheres[candidateDraws[candidateDraw + FIRST_INSTANCE]];
+    if (!isInsideFrustum(boundingSphere.xyz, boundingSphere.w)) {
+        return;
+    }
+
+    if (pushConstants.cullOcclusion != 0 && isOccluded(boundingSphere.xyz, boundingSphere.w)) {
+        return;
+    }
+
+    const uint culledIndex = atomicAdd(culledDraws[pushConstants.countOffset], 1);
+    const uint culledDraw = pushConstants.drawOffset + culledIndex * DRAW_COMMAND_SIZE;
+    for (uint i = 0; i < DRAW_COMMAND_SIZE; i++) {
+        culledDraws[culledDraw + i] = candidateDraws[candidateDraw + i];
+    }
+}
@@ -0,0 +1,137 @@
+// Culls the indirect draws of a frame against the view frustum before the scene is drawn.
+// Every thread tests the bounding sphere of the instance of one candidate draw, and the
+// draws that survive are compacted into the culled draws, whose count the draw reads.
+// With occlusion culling, the draws behind the depth pyramid of the frame before are
+// culled too.
+#define THREAD_COUNT 64
+// A `VkDrawIndexedIndirectCommand` is five words, with the first instance last.
+#define DRAW_COMMAND_SIZE 5
+#define FIRST_INSTANCE 4
+
+struct CS_InputConstants {
+    float4x4 viewProj;
+    float4 cameraPosition;
+    // The view projection the depth pyramid was built with.
+    float4x4 depthPyramidViewProj;
+};
+
+// The offsets of the frame's regions in both draw buffers, in words.
+struct CS_PushConstants {
+    uint countOffset;
+    uint drawOffset;
+    uint cullOcclusion;
+    // Whether depth runs from one at the near plane to zero at the far plane.
+    uint isReverseDepth;
+};
+
+[[vk::binding(0, 0)]] cbuffer ubo {
+    CS_InputConstants ubo;
+}
+
+[[vk::push_constant]] CS_PushConstants pushConstants;
+
+[[vk::binding(1, 0)]] StructuredBuffer<uint> candidateDraws;
+// The bounding sphere of every instance in world space, with the radius in `w`.
+[[vk::binding(2, 0)]] StructuredBuffer<float4> boundingSpheres;
+[[vk::binding(3, 0)]] RWStructuredBuffer<uint> culledDraws;
+// The farthest depth under every texel of every level.
+[[vk::binding(4, 0)]] Texture2D<float> depthPyramid;
+
+
+bool isInsideFrustum(float3 center, float radius) {
+    // The planes of the clip volume in world space, with depth from zero to one. Reverse-Z
+    // swaps the near and far planes, and a far plane at infinity culls nothing.
+    float4x4 viewProj = ubo.viewProj;
+    float4 planes[6] = {
+        viewProj[3] + viewProj[0],
+        viewProj[3] - viewProj[0],
+        viewProj[3] + viewProj[1],
+        viewProj[3] - viewProj[1],
+        viewProj[2],
+        viewProj[3] - viewProj[2],
+    };
+
+    for (int i = 0; i < 6; i++) {
+        if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isOccluded(float3 center, float radius) {
+    // The bounds of the sphere on the screen, and its nearest depth, from the corners of
+    // the box around it.
+    float2 minUv = float2(1.0f, 1.0f);
+    float2 maxUv = float2(0.0f, 0.0f);
+    bool isReverseDepth = pushConstants.isReverseDepth != 0;
+    float nearestDepth = isReverseDepth ? 0.0f : 1.0f;
+    for (uint i = 0; i < 8; i++) {
+        float3 corner = center + radius * float3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+        float4 clipPosition = mul(ubo.depthPyramidViewProj, float4(corner, 1.0f));
+        if (clipPosition.w <= 0.0f) {
+            // The box reaches behind the camera.
+            return false;
+        }
+
+        float3 ndcPosition = clipPosition.xyz / clipPosition.w;
+        float2 uv = ndcPosition.xy * 0.5f + 0.5f;
+        minUv = min(minUv, uv);
+        maxUv = max(maxUv, uv);
+        nearestDepth = isReverseDepth ? max(nearestDepth, ndcPosition.z) : min(nearestDepth, ndcPosition.z);
+    }
+    minUv = saturate(minUv);
+    maxUv = saturate(maxUv);
+
+    // The level at which the bounds cover at most two by two texels.
+    uint width;
+    uint height;
+    uint levelCount;
+    depthPyramid.GetDimensions(0, width, height, levelCount);
+    float2 size = (maxUv - minUv) * float2(width, height);
+    uint level = min((uint) ceil(log2(max(max(size.x, size.y), 1.0f))), levelCount - 1);
+
+    uint levelWidth;
+    uint levelHeight;
+    depthPyramid.GetDimensions(level, levelWidth, levelHeight, levelCount);
+    int2 levelSize = int2(levelWidth, levelHeight);
+    int2 first = min(int2(minUv * float2(levelSize)), levelSize - 1);
+    int2 last = min(int2(maxUv * float2(levelSize)), levelSize - 1);
+
+    float farthestDepth = isReverseDepth ? 1.0f : 0.0f;
+    for (int y = first.y; y <= last.y; y++) {
+        for (int x = first.x; x <= last.x; x++) {
+            float depth = depthPyramid.Load(int3(x, y, level));
+            farthestDepth = isReverseDepth ? min(farthestDepth, depth) : max(farthestDepth, depth);
+        }
+    }
+
+    return isReverseDepth ? nearestDepth < farthestDepth : nearestDepth > farthestDepth;
+}
+
+[numthreads(THREAD_COUNT, 1, 1)]
+void main(uint3 dispatchThreadId : SV_DispatchThreadID) {
+    uint drawIndex = dispatchThreadId.x;
+    if (drawIndex >= candidateDraws[pushConstants.countOffset]) {
+        return;
+    }
+
+    uint candidateDraw = pushConstants.drawOffset + drawIndex * DRAW_COMMAND_SIZE;
+    float4 boundingSphere = boundingSpheres[candidateDraws[candidateDraw + FIRST_INSTANCE]];
+    if (!isInsideFrustum(boundingSphere.xyz, boundingSphere.w)) {
+        return;
+    }
+
+    if (pushConstants.cullOcclusion != 0 && isOccluded(boundingSphere.xyz, boundingSphere.w)) {
+        return;
+    }
+
+    uint culledIndex;
+    InterlockedAdd(culledDraws[pushConstants.countOffset], 1, culledIndex);
+
+    uint culledDraw = pushConstants.drawOffset + culledIndex * DRAW_COMMAND_SIZE;
+    for (uint i = 0; i < DRAW_COMMAND_SIZE; i++) {
+        culledDraws[culledDraw + i] = candidateDraws[candidateDraw + i];
+    }
+}
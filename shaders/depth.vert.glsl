@@ -0,0 +1,32 @@
+#version 450
+#extension GL_EXT_multiview : require
+
+// The views a multiview frame renders at most, as `MAX_VIEW_COUNT` in `main.cpp`.
+#define MAX_VIEW_COUNT 4
+
+layout(binding = 0) uniform UniformBufferObject {
+    // Past the matrices and camera position the other stages read, the matrix of every
+    // view the frame renders, one per layer of its attachments. A frame of a single view
+    // only fills the first.
+    layout(offset = 160) mat4 viewProjs[MAX_VIEW_COUNT];
+} ubo;
+
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+} pushConstants;
+
+layout(location = 0) in vec3 inPosition;
+// The columns of the transform of the instance, at the locations of `shader.vert`.
+layout(location = 2) in vec4 inInstanceModel0;
+layout(location = 3) in vec4 inInstanceModel1;
+layout(location = 4) in vec4 inInstanceModel2;
+layout(location = 5) in vec4 inInstanceModel3;
+
+// The depth prepass only passes where this matches `shader.vert` exactly.
+invariant gl_Position;
+
+
+void main() {
+    mat4 instanceModel = mat4(inInstanceModel0, inInstanceModel1, inInstanceModel2, inInstanceModel3);
+    gl_Position = ubo.viewProjs[gl_ViewIndex] * (instanceModel * (pushConstants.model * vec4(inPosition, 1.0)));
+}
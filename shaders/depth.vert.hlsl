@@ -0,0 +1,49 @@
+// The views a multiview frame renders at most, as `MAX_VIEW_COUNT` in `main.cpp`.
+#define MAX_VIEW_COUNT 4
+
+struct VS_Input {
+    [[vk::location(0)]] float3 position : TEXCOORD0;
+    // The columns of the transform of the instance, at the locations of `shader.vert`.
+    [[vk::location(2)]] float4 instanceModel0 : TEXCOORD2;
+    [[vk::location(3)]] float4 instanceModel1 : TEXCOORD3;
+    [[vk::location(4)]] float4 instanceModel2 : TEXCOORD4;
+    [[vk::location(5)]] float4 instanceModel3 : TEXCOORD5;
+    uint viewIndex : SV_ViewID;
+};
+
+struct VS_Output {
+    // The depth prepass only passes where this matches `shader.vert` exactly.
+    precise float4 position : SV_POSITION;
+};
+
+struct VS_InputConstants {
+    // Past the matrices and camera position the other stages read, the matrix of every
+    // view the frame renders, one per layer of its attachments. A frame of a single view
+    // only fills the first.
+    [[vk::offset(160)]] float4x4 viewProjs[MAX_VIEW_COUNT];
+};
+
+struct VS_PushConstants {
+    float4x4 model;
+};
+
+cbuffer ubo : register(b0) {
+    VS_InputConstants ubo;
+}
+
+[[vk::push_constant]] VS_PushConstants pushConstants;
+
+
+VS_Output main(VS_Input input) {
+    float4 meshPosition = mul(pushConstants.model, float4(input.position, 1.0f));
+    float4 worldPosition = input.instanceModel0 * meshPosition.x
+        + input.instanceModel1 * meshPosition.y
+        + input.instanceModel2 * meshPosition.z
+        + input.instanceModel3 * meshPosition.w;
+    float4 outPosition = mul(ubo.viewProjs[input.viewIndex], worldPosition);
+    
+    VS_Output output;
+    output.position = outPosition;
+    
+    return output;
+}
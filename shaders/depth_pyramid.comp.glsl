@@ -0,0 +1,67 @@
+#version 450
+#extension GL_EXT_samplerless_texture_functions : require
+
+// Reduces one level of a hierarchical depth pyramid from the level before it, or the first
+// level from the depth buffer. Every invocation writes one texel, reduced over every source
+// texel its footprint touches, so a level is conservative even when the source is not
+// twice its size. A multisampled depth buffer is reduced over all of its samples.
+#define THREAD_COUNT_X 8
+#define THREAD_COUNT_Y 8
+
+#define REDUCTION_MIN 0
+#define REDUCTION_MAX 1
+
+layout(local_size_x = THREAD_COUNT_X, local_size_y = THREAD_COUNT_Y, local_size_z = 1) in;
+
+layout(push_constant) uniform PushConstants {
+    uvec2 sourceExtent;
+    uvec2 destinationExtent;
+    uint reduction;
+    // The samples of a multisampled source, or zero for a single sampled one.
+    uint sourceSampleCount;
+} pushConstants;
+
+layout(set = 0, binding = 0) uniform texture2D source;
+layout(set = 0, binding = 1, r32f) uniform writeonly image2D destination;
+layout(set = 0, binding = 2) uniform texture2DMS multisampledSource;
+
+float reduce(float depth, float otherDepth) {
+    return pushConstants.reduction == REDUCTION_MAX ? max(depth, otherDepth) : min(depth, otherDepth);
+}
+
+float loadSource(ivec2 texel) {
+    if (pushConstants.sourceSampleCount == 0) {
+        return texelFetch(source, texel, 0).r;
+    }
+
+    float depth = texelFetch(multisampledSource, texel, 0).r;
+    for (int i = 1; i < int(pushConstants.sourceSampleCount); i++) {
+        depth = reduce(depth, texelFetch(multisampledSource, texel, i).r);
+    }
+
+    return depth;
+}
+
+
+void main() {
+    const uvec2 texel = gl_GlobalInvocationID.xy;
+    if (any(greaterThanEqual(texel, pushConstants.destinationExtent))) {
+        return;
+    }
+
+    // The source texels from the one the footprint starts in to the one it ends in.
+    const uvec2 first = (texel * pushConstants.sourceExtent) / pushConstants.destinationExtent;
+    const uvec2 last = min(
+        ((texel + 1) * pushConstants.sourceExtent + pushConstants.destinationExtent - 1) / pushConstants.destinationExtent,
+        pushConstants.sourceExtent
+    );
+
+    float depth = pushConstants.reduction == REDUCTION_MAX ? 0.0 : 1.0;
+    for (uint y = first.y; y < last.y; y++) {
+        for (uint x = first.x; x < last.x; x++) {
+            depth = reduce(depth, loadSource(ivec2(x, y)));
+        }
+    }
+
+    imageStore(destination, ivec2(texel), vec4(depth));
+}
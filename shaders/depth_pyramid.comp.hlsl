@@ -0,0 +1,63 @@
+// Reduces one level of a hierarchical depth pyramid from the level before it, or the first
+// level from the depth buffer. Every thread writes one texel, reduced over every source
+// texel its footprint touches, so a level is conservative even when the source is not
+// twice its size. A multisampled depth buffer is reduced over all of its samples.
+#define THREAD_COUNT_X 8
+#define THREAD_COUNT_Y 8
+
+#define REDUCTION_MIN 0
+#define REDUCTION_MAX 1
+
+struct CS_PushConstants {
+    uint2 sourceExtent;
+    uint2 destinationExtent;
+    uint reduction;
+    // The samples of a multisampled source, or zero for a single sampled one.
+    uint sourceSampleCount;
+};
+
+[[vk::push_constant]] CS_PushConstants pushConstants;
+
+[[vk::binding(0, 0)]] Texture2D<float> source;
+[[vk::binding(1, 0)]] [[vk::image_format("r32f")]] RWTexture2D<float> destination;
+[[vk::binding(2, 0)]] Texture2DMS<float> multisampledSource;
+
+float reduce(float depth, float otherDepth) {
+    return pushConstants.reduction == REDUCTION_MAX ? max(depth, otherDepth) : min(depth, otherDepth);
+}
+
+float loadSource(uint2 texel) {
+    if (pushConstants.sourceSampleCount == 0) {
+        return source.Load(int3(texel, 0));
+    }
+
+    float depth = multisampledSource.Load(int2(texel), 0);
+    for (uint i = 1; i < pushConstants.sourceSampleCount; i++) {
+        depth = reduce(depth, multisampledSource.Load(int2(texel), i));
+    }
+
+    return depth;
+}
+
+
+[numthreads(THREAD_COUNT_X, THREAD_COUNT_Y, 1)]
+void main(uint3 dispatchThreadId : SV_DispatchThreadID) {
+    uint2 texel = dispatchThreadId.xy;
+    if (any(texel >= pushConstants.destinationExtent)) {
+        return;
+    }
+
+    // The source texels from the one the footprint starts in to the one it ends in.
+    uint2 first = (texel * pushConstants.sourceExtent) / pushConstants.destinationExtent;
+    uint2 last = ((texel + 1) * pushConstants.sourceExtent + pushConstants.destinationExtent - 1) / pushConstants.destinationExtent;
+    last = min(last, pushConstants.sourceExtent);
+
+    float depth = pushConstants.reduction == REDUCTION_MAX ? 0.0f : 1.0f;
+    for (uint y = first.y; y < last.y; y++) {
+        for (uint x = first.x; x < last.x; x++) {
+            depth = reduce(depth, loadSource(uint2(x, y)));
+        }
+    }
+
+    destination[texel] = depth;
+}
@@ -0,0 +1,203 @@
+#version 450
+
+// The single-pass downsampler the depth pyramid, the luminance reduction and the bloom
+// chain share, in the spirit of AMD's FidelityFX SPD like `mipmap.comp`. Every workgroup
+// reduces one 64x64 tile of level 0 into levels 1 through 6 using shared memory, and the
+// last workgroup to finish, found with a global atomic counter, reduces level 6 into the
+// remaining levels. Every texel reduces the four under it, and texels past the edge of a
+// level read the edge instead, which the minimum and maximum both ignore. Chains whose
+// level 0 is up to 4096x4096 fit into a single dispatch.
+//
+// Level 0 is either in the chain already, or filtered from a source texture by the same
+// dispatch, which samples it between four of its texels wherever the chain is half its
+// size. Single channel chains are `r32f`, and color chains `rgba16f`, each with a binding
+// of its own that the other never touches.
+#define MAX_MIP_LEVELS 13
+#define TILE_SIZE 32
+#define THREAD_COUNT 256
+
+#define REDUCTION_MIN 0
+#define REDUCTION_MAX 1
+#define REDUCTION_AVERAGE 2
+
+#define SOURCE_FILTER_NONE 0
+#define SOURCE_FILTER_COLOR 1
+#define SOURCE_FILTER_LOG_LUMINANCE 2
+
+// The smallest luminance the log is taken of, so that black texels do not pull the
+// average down without bound.
+#define MIN_LUMINANCE 0.0001
+
+// As `DownsampleReduction`, whether the chain is `rgba16f`, and as `DownsampleSourceFilter`.
+layout(constant_id = 0) const uint REDUCTION = REDUCTION_MIN;
+layout(constant_id = 1) const uint IS_COLOR = 0;
+layout(constant_id = 2) const uint SOURCE_FILTER = SOURCE_FILTER_NONE;
+
+layout(local_size_x = THREAD_COUNT, local_size_y = 1, local_size_z = 1) in;
+
+layout(push_constant) uniform PushConstants {
+    uvec2 extent;
+    uint mipCount;
+    uint workGroupCount;
+    // The weight of the new value of every texel of the last level against the one it
+    // held, which keeps a running average of it below one.
+    float lastLevelFeedback;
+} pushConstants;
+
+layout(set = 0, binding = 0, r32f) uniform coherent image2D scalarMips[MAX_MIP_LEVELS];
+layout(set = 0, binding = 1) coherent buffer WorkGroupCounter {
+    uint count;
+} workGroupCounter;
+layout(set = 0, binding = 2, rgba16f) uniform coherent image2D colorMips[MAX_MIP_LEVELS];
+layout(set = 0, binding = 3) uniform texture2D source;
+layout(set = 0, binding = 4) uniform sampler sourceSampler;
+
+shared vec4 sharedTexels[TILE_SIZE][TILE_SIZE];
+shared uint sharedIsLastWorkGroup;
+
+
+vec4 reduceQuad(vec4 texel0, vec4 texel1, vec4 texel2, vec4 texel3) {
+    if (REDUCTION == REDUCTION_AVERAGE) {
+        return 0.25 * (texel0 + texel1 + texel2 + texel3);
+    } else if (REDUCTION == REDUCTION_MAX) {
+        return max(max(texel0, texel1), max(texel2, texel3));
+    }
+
+    return min(min(texel0, texel1), min(texel2, texel3));
+}
+
+uvec2 mipExtent(uint level) {
+    return max(uvec2(1, 1), pushConstants.extent >> level);
+}
+
+vec4 loadTexel(uint level, uvec2 coord) {
+    ivec2 clampedCoord = ivec2(min(coord, mipExtent(level) - 1));
+    if (IS_COLOR != 0) {
+        return imageLoad(colorMips[level], clampedCoord);
+    }
+
+    return vec4(imageLoad(scalarMips[level], clampedCoord).r, 0.0, 0.0, 0.0);
+}
+
+void storeTexel(uint level, uvec2 coord, vec4 texel) {
+    if (any(greaterThanEqual(coord, mipExtent(level)))) {
+        return;
+    }
+
+    if (level == pushConstants.mipCount - 1 && pushConstants.lastLevelFeedback < 1.0) {
+        texel = mix(loadTexel(level, coord), texel, pushConstants.lastLevelFeedback);
+    }
+
+    if (IS_COLOR != 0) {
+        imageStore(colorMips[level], ivec2(coord), texel);
+    } else {
+        imageStore(scalarMips[level], ivec2(coord), vec4(texel.x));
+    }
+}
+
+// Texel `coord` of level 0 filtered from the source, which is written into the chain too.
+vec4 filterSource(uvec2 coord) {
+    uvec2 clampedCoord = min(coord, mipExtent(0) - 1);
+    vec2 uv = (vec2(clampedCoord) + 0.5) / vec2(pushConstants.extent);
+    vec4 texel = textureLod(sampler2D(source, sourceSampler), uv, 0.0);
+    if (SOURCE_FILTER == SOURCE_FILTER_LOG_LUMINANCE) {
+        float luminance = dot(texel.rgb, vec3(0.2126, 0.7152, 0.0722));
+        texel = vec4(log(max(luminance, MIN_LUMINANCE)), 0.0, 0.0, 0.0);
+    }
+
+    storeTexel(0, coord, texel);
+
+    return texel;
+}
+
+vec4 loadBaseTexel(uint baseLevel, uvec2 coord) {
+    if (baseLevel == 0 && SOURCE_FILTER != SOURCE_FILTER_NONE) {
+        return filterSource(coord);
+    }
+
+    return loadTexel(baseLevel, coord);
+}
+
+// Reduce a 64x64 tile of `baseLevel` starting at `tile * 64` into the next six levels.
+// The first level reads from the image, or the source, every following level reads from
+// shared memory.
+void reduceTile(uint baseLevel, uvec2 tile, uint localIndex) {
+    if (baseLevel + 1 >= pushConstants.mipCount) {
+        return;
+    }
+
+    for (uint i = 0; i < (TILE_SIZE * TILE_SIZE) / THREAD_COUNT; i++) {
+        uint index = localIndex + i * THREAD_COUNT;
+        uvec2 local = uvec2(index % TILE_SIZE, index / TILE_SIZE);
+        uvec2 coord = tile * TILE_SIZE + local;
+
+        vec4 texel = reduceQuad(
+            loadBaseTexel(baseLevel, 2 * coord + uvec2(0, 0)),
+            loadBaseTexel(baseLevel, 2 * coord + uvec2(1, 0)),
+            loadBaseTexel(baseLevel, 2 * coord + uvec2(0, 1)),
+            loadBaseTexel(baseLevel, 2 * coord + uvec2(1, 1))
+        );
+
+        storeTexel(baseLevel + 1, coord, texel);
+        sharedTexels[local.y][local.x] = texel;
+    }
+
+    barrier();
+
+    for (uint level = baseLevel + 2; level < min(baseLevel + 7, pushConstants.mipCount); level++) {
+        uint tileSize = TILE_SIZE >> (level - baseLevel - 1);
+        uvec2 local = uvec2(localIndex % tileSize, localIndex / tileSize);
+        bool isActive = localIndex < tileSize * tileSize;
+
+        vec4 texel = vec4(0.0);
+        if (isActive) {
+            texel = reduceQuad(
+                sharedTexels[2 * local.y + 0][2 * local.x + 0],
+                sharedTexels[2 * local.y + 0][2 * local.x + 1],
+                sharedTexels[2 * local.y + 1][2 * local.x + 0],
+                sharedTexels[2 * local.y + 1][2 * local.x + 1]
+            );
+        }
+
+        barrier();
+
+        if (isActive) {
+            storeTexel(level, tile * tileSize + local, texel);
+            sharedTexels[local.y][local.x] = texel;
+        }
+
+        barrier();
+    }
+}
+
+
+void main() {
+    uint localIndex = gl_LocalInvocationIndex;
+    reduceTile(0, gl_WorkGroupID.xy, localIndex);
+
+    if (pushConstants.mipCount <= 7) {
+        return;
+    }
+
+    // Make this workgroup's writes to level 6 visible before announcing that it is done.
+    memoryBarrierImage();
+    barrier();
+
+    if (localIndex == 0) {
+        uint previousCount = atomicAdd(workGroupCounter.count, 1);
+        sharedIsLastWorkGroup = (previousCount == pushConstants.workGroupCount - 1) ? 1 : 0;
+        // Every other workgroup has counted itself already, so the counter starts over for
+        // the next frame without a fill.
+        if (sharedIsLastWorkGroup != 0) {
+            workGroupCounter.count = 0;
+        }
+    }
+
+    barrier();
+
+    if (sharedIsLastWorkGroup == 0) {
+        return;
+    }
+
+    reduceTile(6, uvec2(0, 0), localIndex);
+}
@@ -0,0 +1,200 @@
+// The single-pass downsampler the depth pyramid, the luminance reduction and the bloom
+// chain share, in the spirit of AMD's FidelityFX SPD like `mipmap.comp`. Every workgroup
+// reduces one 64x64 tile of level 0 into levels 1 through 6 using group shared memory, and
+// the last workgroup to finish, found with a global atomic counter, reduces level 6 into
+// the remaining levels. Every texel reduces the four under it, and texels past the edge of
+// a level read the edge instead, which the minimum and maximum both ignore. Chains whose
+// level 0 is up to 4096x4096 fit into a single dispatch.
+//
+// Level 0 is either in the chain already, or filtered from a source texture by the same
+// dispatch, which samples it between four of its texels wherever the chain is half its
+// size. Single channel chains are `r32f`, and color chains `rgba16f`, each with a binding
+// of its own that the other never touches.
+#define MAX_MIP_LEVELS 13
+#define TILE_SIZE 32
+#define THREAD_COUNT 256
+
+#define REDUCTION_MIN 0
+#define REDUCTION_MAX 1
+#define REDUCTION_AVERAGE 2
+
+#define SOURCE_FILTER_NONE 0
+#define SOURCE_FILTER_COLOR 1
+#define SOURCE_FILTER_LOG_LUMINANCE 2
+
+// The smallest luminance the log is taken of, so that black texels do not pull the
+// average down without bound.
+#define MIN_LUMINANCE 0.0001f
+
+// As `DownsampleReduction`, whether the chain is `rgba16f`, and as `DownsampleSourceFilter`.
+[[vk::constant_id(0)]] const uint REDUCTION = REDUCTION_MIN;
+[[vk::constant_id(1)]] const uint IS_COLOR = 0;
+[[vk::constant_id(2)]] const uint SOURCE_FILTER = SOURCE_FILTER_NONE;
+
+struct CS_PushConstants {
+    uint2 extent;
+    uint mipCount;
+    uint workGroupCount;
+    // The weight of the new value of every texel of the last level against the one it
+    // held, which keeps a running average of it below one.
+    float lastLevelFeedback;
+};
+
+[[vk::push_constant]] CS_PushConstants pushConstants;
+
+[[vk::binding(0, 0)]] [[vk::image_format("r32f")]] globallycoherent RWTexture2D<float> scalarMips[MAX_MIP_LEVELS];
+[[vk::binding(1, 0)]] globallycoherent RWStructuredBuffer<uint> workGroupCounter;
+[[vk::binding(2, 0)]] [[vk::image_format("rgba16f")]] globallycoherent RWTexture2D<float4> colorMips[MAX_MIP_LEVELS];
+[[vk::binding(3, 0)]] Texture2D<float4> source;
+[[vk::binding(4, 0)]] SamplerState sourceSampler;
+
+groupshared float4 sharedTexels[TILE_SIZE][TILE_SIZE];
+groupshared uint sharedIsLastWorkGroup;
+
+
+float4 reduceQuad(float4 texel0, float4 texel1, float4 texel2, float4 texel3) {
+    if (REDUCTION == REDUCTION_AVERAGE) {
+        return 0.25f * (texel0 + texel1 + texel2 + texel3);
+    } else if (REDUCTION == REDUCTION_MAX) {
+        return max(max(texel0, texel1), max(texel2, texel3));
+    }
+
+    return min(min(texel0, texel1), min(texel2, texel3));
+}
+
+uint2 mipExtent(uint level) {
+    return max(uint2(1, 1), pushConstants.extent >> level);
+}
+
+float4 loadTexel(uint level, uint2 coord) {
+    uint2 clampedCoord = min(coord, mipExtent(level) - 1);
+    if (IS_COLOR != 0) {
+        return colorMips[level][clampedCoord];
+    }
+
+    return float4(scalarMips[level][clampedCoord], 0.0f, 0.0f, 0.0f);
+}
+
+void storeTexel(uint level, uint2 coord, float4 texel) {
+    if (any(coord >= mipExtent(level))) {
+        return;
+    }
+
+    if (level == pushConstants.mipCount - 1 && pushConstants.lastLevelFeedback < 1.0f) {
+        texel = lerp(loadTexel(level, coord), texel, pushConstants.lastLevelFeedback);
+    }
+
+    if (IS_COLOR != 0) {
+        colorMips[level][coord] = texel;
+    } else {
+        scalarMips[level][coord] = texel.x;
+    }
+}
+
+// Texel `coord` of level 0 filtered from the source, which is written into the chain too.
+float4 filterSource(uint2 coord) {
+    uint2 clampedCoord = min(coord, mipExtent(0) - 1);
+    float2 uv = (float2(clampedCoord) + 0.5f) / float2(pushConstants.extent);
+    float4 texel = source.SampleLevel(sourceSampler, uv, 0.0f);
+    if (SOURCE_FILTER == SOURCE_FILTER_LOG_LUMINANCE) {
+        float luminance = dot(texel.rgb, float3(0.2126f, 0.7152f, 0.0722f));
+        texel = float4(log(max(luminance, MIN_LUMINANCE)), 0.0f, 0.0f, 0.0f);
+    }
+
+    storeTexel(0, coord, texel);
+
+    return texel;
+}
+
+float4 loadBaseTexel(uint baseLevel, uint2 coord) {
+    if (baseLevel == 0 && SOURCE_FILTER != SOURCE_FILTER_NONE) {
+        return filterSource(coord);
+    }
+
+    return loadTexel(baseLevel, coord);
+}
+
+// Reduce a 64x64 tile of `baseLevel` starting at `tile * 64` into the next six levels.
+// The first level reads from the image, or the source, every following level reads from
+// shared memory.
+void reduceTile(uint baseLevel, uint2 tile, uint localIndex) {
+    if (baseLevel + 1 >= pushConstants.mipCount) {
+        return;
+    }
+
+    [unroll]
+    for (uint i = 0; i < (TILE_SIZE * TILE_SIZE) / THREAD_COUNT; i++) {
+        uint index = localIndex + i * THREAD_COUNT;
+        uint2 local = uint2(index % TILE_SIZE, index / TILE_SIZE);
+        uint2 coord = tile * TILE_SIZE + local;
+
+        float4 texel = reduceQuad(
+            loadBaseTexel(baseLevel, 2 * coord + uint2(0, 0)),
+            loadBaseTexel(baseLevel, 2 * coord + uint2(1, 0)),
+            loadBaseTexel(baseLevel, 2 * coord + uint2(0, 1)),
+            loadBaseTexel(baseLevel, 2 * coord + uint2(1, 1))
+        );
+
+        storeTexel(baseLevel + 1, coord, texel);
+        sharedTexels[local.y][local.x] = texel;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint level = baseLevel + 2; level < min(baseLevel + 7, pushConstants.mipCount); level++) {
+        uint tileSize = TILE_SIZE >> (level - baseLevel - 1);
+        uint2 local = uint2(localIndex % tileSize, localIndex / tileSize);
+        bool isActive = localIndex < tileSize * tileSize;
+
+        float4 texel = float4(0.0f, 0.0f, 0.0f, 0.0f);
+        if (isActive) {
+            texel = reduceQuad(
+                sharedTexels[2 * local.y + 0][2 * local.x + 0],
+                sharedTexels[2 * local.y + 0][2 * local.x + 1],
+                sharedTexels[2 * local.y + 1][2 * local.x + 0],
+                sharedTexels[2 * local.y + 1][2 * local.x + 1]
+            );
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+
+        if (isActive) {
+            storeTexel(level, tile * tileSize + local, texel);
+            sharedTexels[local.y][local.x] = texel;
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+    }
+}
+
+
+[numthreads(THREAD_COUNT, 1, 1)]
+void main(uint3 groupId : SV_GroupID, uint localIndex : SV_GroupIndex) {
+    reduceTile(0, groupId.xy, localIndex);
+
+    if (pushConstants.mipCount <= 7) {
+        return;
+    }
+
+    // Make this workgroup's writes to level 6 visible before announcing that it is done.
+    DeviceMemoryBarrierWithGroupSync();
+
+    if (localIndex == 0) {
+        uint previousCount;
+        InterlockedAdd(workGroupCounter[0], 1, previousCount);
+        sharedIsLastWorkGroup = (previousCount == pushConstants.workGroupCount - 1) ? 1 : 0;
+        // Every other workgroup has counted itself already, so the counter starts over for
+        // the next frame without a fill.
+        if (sharedIsLastWorkGroup != 0) {
+            workGroupCounter[0] = 0;
+        }
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (sharedIsLastWorkGroup == 0) {
+        return;
+    }
+
+    reduceTile(6, uint2(0, 0), localIndex);
+}
@@ -0,0 +1,9 @@
+#version 450
+
+
+// One triangle that covers the whole attachment, with its corners at (-1, -1), (3, -1) and
+// (-1, 3), so it needs no vertex input.
+void main() {
+    vec2 corner = vec2(float((gl_VertexIndex << 1) & 2), float(gl_VertexIndex & 2));
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
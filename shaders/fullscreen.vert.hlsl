@@ -0,0 +1,15 @@
+struct VS_Output {
+    float4 position : SV_POSITION;
+};
+
+
+// One triangle that covers the whole attachment, with its corners at (-1, -1), (3, -1) and
+// (-1, 3), so it needs no vertex input.
+VS_Output main(uint vertexIndex : SV_VertexID) {
+    float2 corner = float2(float((vertexIndex << 1) & 2), float(vertexIndex & 2));
+
+    VS_Output output;
+    output.position = float4(corner * 2.0f - 1.0f, 0.0f, 1.0f);
+
+    return output;
+}
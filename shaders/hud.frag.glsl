@@ -0,0 +1,18 @@
+#version 450
+
+layout(location = 0) in vec2 fragGlyphCoordinate;
+layout(location = 1) in vec4 fragColor;
+layout(location = 2) flat in uint fragGlyphMask;
+
+layout(location = 0) out vec4 outColor;
+
+
+void main() {
+    // Rects have every pixel of their glyph lit.
+    uvec2 pixel = min(uvec2(fragGlyphCoordinate), uvec2(2u, 4u));
+    if (((fragGlyphMask >> (3u * pixel.y + pixel.x)) & 1u) == 0u) {
+        discard;
+    }
+
+    outColor = fragColor;
+}
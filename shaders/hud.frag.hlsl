@@ -0,0 +1,24 @@
+struct PS_Input {
+    float4 position : SV_POSITION;
+    float2 glyphCoordinate : TEXCOORD0;
+    float4 color : COLOR0;
+    nointerpolation uint glyphMask : TEXCOORD1;
+};
+
+struct PS_Output {
+    float4 outColor : SV_TARGET0;
+};
+
+
+PS_Output main(PS_Input input) {
+    // Rects have every pixel of their glyph lit.
+    uint2 pixel = min(uint2(input.glyphCoordinate), uint2(2, 4));
+    if (((input.glyphMask >> (3 * pixel.y + pixel.x)) & 1) == 0) {
+        discard;
+    }
+
+    PS_Output output;
+    output.outColor = input.color;
+
+    return output;
+}
@@ -0,0 +1,26 @@
+#version 450
+
+layout(push_constant) uniform PushConstants {
+    // One over the width and height of the color attachment, in pixels.
+    vec2 inverseExtent;
+} pushConstants;
+
+// The corner of the quad in pixels from the top left of the attachment.
+layout(location = 0) in vec2 inPosition;
+// Where the corner is in the glyph of the quad, in glyph pixels.
+layout(location = 1) in vec2 inGlyphCoordinate;
+layout(location = 2) in vec4 inColor;
+// The lit pixels of the glyph, with row `r` and column `c` at bit `3 * r + c`.
+layout(location = 3) in uint inGlyphMask;
+
+layout(location = 0) out vec2 fragGlyphCoordinate;
+layout(location = 1) out vec4 fragColor;
+layout(location = 2) flat out uint fragGlyphMask;
+
+
+void main() {
+    gl_Position = vec4(inPosition * pushConstants.inverseExtent * 2.0 - 1.0, 0.0, 1.0);
+    fragGlyphCoordinate = inGlyphCoordinate;
+    fragColor = inColor;
+    fragGlyphMask = inGlyphMask;
+}
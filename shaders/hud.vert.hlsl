@@ -0,0 +1,34 @@
+struct VS_Input {
+    // The corner of the quad in pixels from the top left of the attachment.
+    [[vk::location(0)]] float2 position : POSITION;
+    // Where the corner is in the glyph of the quad, in glyph pixels.
+    [[vk::location(1)]] float2 glyphCoordinate : TEXCOORD0;
+    [[vk::location(2)]] float4 color : COLOR0;
+    // The lit pixels of the glyph, with row `r` and column `c` at bit `3 * r + c`.
+    [[vk::location(3)]] uint glyphMask : TEXCOORD1;
+};
+
+struct VS_Output {
+    float4 position : SV_POSITION;
+    float2 glyphCoordinate : TEXCOORD0;
+    float4 color : COLOR0;
+    nointerpolation uint glyphMask : TEXCOORD1;
+};
+
+struct VS_PushConstants {
+    // One over the width and height of the color attachment, in pixels.
+    float2 inverseExtent;
+};
+
+[[vk::push_constant]] VS_PushConstants pushConstants;
+
+
+VS_Output main(VS_Input input) {
+    VS_Output output;
+    output.position = float4(input.position * pushConstants.inverseExtent * 2.0f - 1.0f, 0.0f, 1.0f);
+    output.glyphCoordinate = input.glyphCoordinate;
+    output.color = input.color;
+    output.glyphMask = input.glyphMask;
+
+    return output;
+}
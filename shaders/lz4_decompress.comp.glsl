@@ -0,0 +1,119 @@
+#version 450
+
+// Expands asset archive entries that were compressed into independent LZ4 blocks. Every
+// invocation decodes one block, from the table of block offsets at the start of the source
+// into its own range of the destination, so blocks never read or write each other's bytes.
+//
+// The destination is written a word at a time. Bytes collect in a register until a word
+// is complete, and the matches that reach back into that word read it from there. A corrupt
+// block stops at the end of its input or output range rather than run past it.
+#define THREAD_COUNT 64
+
+#define MIN_MATCH 4
+
+layout(local_size_x = THREAD_COUNT, local_size_y = 1, local_size_z = 1) in;
+
+layout(push_constant) uniform PushConstants {
+    uint blockCount;
+    uint blockSize;
+    // The sizes of the compressed source and of the uncompressed contents, in bytes.
+    uint sourceSize;
+    uint size;
+} pushConstants;
+
+layout(set = 0, binding = 0) readonly buffer Source {
+    uint words[];
+} source;
+layout(set = 0, binding = 1) buffer Destination {
+    uint words[];
+} destination;
+
+
+uint outputPosition;
+uint pendingWord;
+
+
+uint readSourceByte(uint position) {
+    return (source.words[position >> 2] >> ((position & 3) * 8)) & 0xff;
+}
+
+uint readLength(inout uint position, uint inputEnd, uint length) {
+    if (length != 15) {
+        return length;
+    }
+
+    uint lengthByte = 255;
+    while (lengthByte == 255 && position < inputEnd) {
+        lengthByte = readSourceByte(position);
+        position++;
+        length += lengthByte;
+    }
+
+    return length;
+}
+
+uint readDestinationByte(uint position) {
+    uint word = (position >> 2) == (outputPosition >> 2) ? pendingWord : destination.words[position >> 2];
+
+    return (word >> ((position & 3) * 8)) & 0xff;
+}
+
+void writeByte(uint value) {
+    pendingWord |= value << ((outputPosition & 3) * 8);
+    outputPosition++;
+    if ((outputPosition & 3) == 0) {
+        destination.words[(outputPosition >> 2) - 1] = pendingWord;
+        pendingWord = 0;
+    }
+}
+
+
+void main() {
+    uint block = gl_GlobalInvocationID.x;
+    if (block >= pushConstants.blockCount) {
+        return;
+    }
+
+    uint inputPosition = source.words[block];
+    uint inputEnd = min(source.words[block + 1], pushConstants.sourceSize);
+    uint blockStart = block * pushConstants.blockSize;
+    uint blockEnd = min(blockStart + pushConstants.blockSize, pushConstants.size);
+
+    outputPosition = blockStart;
+    pendingWord = 0;
+    while (inputPosition < inputEnd && outputPosition < blockEnd) {
+        uint token = readSourceByte(inputPosition);
+        inputPosition++;
+
+        uint literalLength = readLength(inputPosition, inputEnd, token >> 4);
+        literalLength = min(literalLength, min(inputEnd - inputPosition, blockEnd - outputPosition));
+        for (uint i = 0; i < literalLength; i++) {
+            writeByte(readSourceByte(inputPosition));
+            inputPosition++;
+        }
+
+        // The last sequence of a block has no match.
+        if (inputEnd - inputPosition < 2) {
+            break;
+        }
+
+        uint offset = readSourceByte(inputPosition) | (readSourceByte(inputPosition + 1) << 8);
+        inputPosition += 2;
+        if (offset == 0 || offset > outputPosition - blockStart) {
+            break;
+        }
+
+        uint matchLength = readLength(inputPosition, inputEnd, token & 0x0f) + MIN_MATCH;
+        matchLength = min(matchLength, blockEnd - outputPosition);
+
+        // Matches may overlap the bytes they produce, so they are copied a byte at a time.
+        for (uint i = 0; i < matchLength; i++) {
+            writeByte(readDestinationByte(outputPosition - offset));
+        }
+    }
+
+    // Only the last block of an entry can end partway through a word.
+    if ((outputPosition & 3) != 0) {
+        destination.words[outputPosition >> 2] = pendingWord;
+    }
+}
@@ -0,0 +1,92 @@
+#version 460
+#extension GL_EXT_mesh_shader : require
+
+// Emits the triangles of one meshlet. Vertices are fetched from the split streams of the
+// vertex buffer, read as storage buffer words: positions are four 16-bit unsigned
+// normalized components, the last one padding, and texture coordinates are two.
+#define MESHLETS_PER_TASK 32
+#define THREAD_COUNT 32
+#define MAX_VERTICES 64
+#define MAX_TRIANGLES 124
+
+layout(local_size_x = THREAD_COUNT) in;
+layout(triangles, max_vertices = MAX_VERTICES, max_primitives = MAX_TRIANGLES) out;
+
+struct Meshlet {
+    vec4 boundingSphere;
+    vec4 coneApex;
+    vec4 coneAxis;
+    uint vertexOffset;
+    uint triangleOffset;
+    uint vertexCount;
+    uint triangleCount;
+};
+
+struct TaskPayload {
+    uint meshletIndices[MESHLETS_PER_TASK];
+};
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 viewProj;
+} ubo;
+
+layout(set = 2, binding = 0) readonly buffer Meshlets {
+    Meshlet meshlets[];
+};
+
+layout(set = 2, binding = 1) readonly buffer MeshletVertices {
+    uint meshletVertices[];
+};
+
+// The local vertex indices of the triangles, packed four bytes to a word.
+layout(set = 2, binding = 2) readonly buffer MeshletTriangles {
+    uint meshletTriangles[];
+};
+
+layout(set = 2, binding = 3) readonly buffer Vertices {
+    uint vertices[];
+};
+
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+    uint textureIndex;
+    uint firstMeshlet;
+    uint meshletCount;
+    uint texCoordOffset;
+} pushConstants;
+
+taskPayloadSharedEXT TaskPayload payload;
+
+layout(location = 0) out vec2 fragTexCoord[];
+// The mesh shader pipeline draws a single copy, with the one material it pushes.
+layout(location = 1) flat out uint fragTextureIndex[];
+
+
+uint readTriangleIndex(uint byteOffset) {
+    return (meshletTriangles[byteOffset / 4] >> (8 * (byteOffset % 4))) & 0xff;
+}
+
+void main() {
+    const Meshlet meshlet = meshlets[payload.meshletIndices[gl_WorkGroupID.x]];
+    SetMeshOutputsEXT(meshlet.vertexCount, meshlet.triangleCount);
+
+    const mat4 modelViewProj = ubo.viewProj * pushConstants.model;
+    for (uint i = gl_LocalInvocationIndex; i < meshlet.vertexCount; i += THREAD_COUNT) {
+        const uint vertex = meshletVertices[meshlet.vertexOffset + i];
+        const vec2 positionXY = unpackUnorm2x16(vertices[2 * vertex]);
+        const vec2 positionZW = unpackUnorm2x16(vertices[2 * vertex + 1]);
+
+        gl_MeshVerticesEXT[i].gl_Position = modelViewProj * vec4(positionXY, positionZW.x, 1.0);
+        fragTexCoord[i] = unpackUnorm2x16(vertices[pushConstants.texCoordOffset + vertex]);
+        fragTextureIndex[i] = pushConstants.textureIndex;
+    }
+
+    for (uint i = gl_LocalInvocationIndex; i < meshlet.triangleCount; i += THREAD_COUNT) {
+        const uint byteOffset = meshlet.triangleOffset + 3 * i;
+        gl_PrimitiveTriangleIndicesEXT[i] = uvec3(
+            readTriangleIndex(byteOffset),
+            readTriangleIndex(byteOffset + 1),
+            readTriangleIndex(byteOffset + 2)
+        );
+    }
+}
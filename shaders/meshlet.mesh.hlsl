@@ -0,0 +1,96 @@
+// Emits the triangles of one meshlet. Vertices are fetched from the split streams of the
+// vertex buffer, read as storage buffer words: positions are four 16-bit unsigned
+// normalized components, the last one padding, and texture coordinates are two.
+#define MESHLETS_PER_TASK 32
+#define THREAD_COUNT 32
+#define MAX_VERTICES 64
+#define MAX_TRIANGLES 124
+
+struct Meshlet {
+    float4 boundingSphere;
+    float4 coneApex;
+    float4 coneAxis;
+    uint vertexOffset;
+    uint triangleOffset;
+    uint vertexCount;
+    uint triangleCount;
+};
+
+struct MS_Payload {
+    uint meshletIndices[MESHLETS_PER_TASK];
+};
+
+struct MS_InputConstants {
+    float4x4 viewProj;
+};
+
+struct MS_PushConstants {
+    float4x4 model;
+    uint textureIndex;
+    uint firstMeshlet;
+    uint meshletCount;
+    uint texCoordOffset;
+};
+
+struct MS_Output {
+    float4 position : SV_POSITION;
+    float2 fragTexCoord: TEXCOORD0;
+    // The mesh shader pipeline draws a single copy, with the one material it pushes.
+    nointerpolation uint fragTextureIndex : TEXCOORD1;
+};
+
+cbuffer ubo : register(b0) {
+    MS_InputConstants ubo;
+}
+
+[[vk::push_constant]] MS_PushConstants pushConstants;
+
+[[vk::binding(0, 2)]] StructuredBuffer<Meshlet> meshlets;
+[[vk::binding(1, 2)]] StructuredBuffer<uint> meshletVertices;
+// The local vertex indices of the triangles, packed four bytes to a word.
+[[vk::binding(2, 2)]] StructuredBuffer<uint> meshletTriangles;
+[[vk::binding(3, 2)]] StructuredBuffer<uint> vertexData;
+
+
+float2 unpackUnorm2x16(uint value) {
+    return float2(value & 0xffff, value >> 16) / 65535.0f;
+}
+
+uint readTriangleIndex(uint byteOffset) {
+    return (meshletTriangles[byteOffset / 4] >> (8 * (byteOffset % 4))) & 0xff;
+}
+
+[outputtopology("triangle")]
+[numthreads(THREAD_COUNT, 1, 1)]
+void main(
+    uint groupThreadId : SV_GroupIndex,
+    uint3 groupId : SV_GroupID,
+    in payload MS_Payload payload,
+    out indices uint3 triangles[MAX_TRIANGLES],
+    out vertices MS_Output vertices[MAX_VERTICES]
+) {
+    Meshlet meshlet = meshlets[payload.meshletIndices[groupId.x]];
+    SetMeshOutputCounts(meshlet.vertexCount, meshlet.triangleCount);
+
+    float4x4 modelViewProj = mul(ubo.viewProj, pushConstants.model);
+    for (uint i = groupThreadId; i < meshlet.vertexCount; i += THREAD_COUNT) {
+        uint vertex = meshletVertices[meshlet.vertexOffset + i];
+        float2 positionXY = unpackUnorm2x16(vertexData[2 * vertex]);
+        float2 positionZW = unpackUnorm2x16(vertexData[2 * vertex + 1]);
+
+        MS_Output output;
+        output.position = mul(modelViewProj, float4(positionXY, positionZW.x, 1.0f));
+        output.fragTexCoord = unpackUnorm2x16(vertexData[pushConstants.texCoordOffset + vertex]);
+        output.fragTextureIndex = pushConstants.textureIndex;
+        vertices[i] = output;
+    }
+
+    for (uint j = groupThreadId; j < meshlet.triangleCount; j += THREAD_COUNT) {
+        uint byteOffset = meshlet.triangleOffset + 3 * j;
+        triangles[j] = uint3(
+            readTriangleIndex(byteOffset),
+            readTriangleIndex(byteOffset + 1),
+            readTriangleIndex(byteOffset + 2)
+        );
+    }
+}
@@ -0,0 +1,103 @@
+#version 460
+#extension GL_EXT_mesh_shader : require
+
+// Culls the meshlets of a mesh before the mesh shader runs. Every invocation tests one
+// meshlet against the view frustum and its normal cone, and the visible meshlets of the
+// workgroup are compacted into the payload, one mesh shader workgroup each.
+#define MESHLETS_PER_TASK 32
+
+layout(local_size_x = MESHLETS_PER_TASK) in;
+
+struct Meshlet {
+    vec4 boundingSphere;
+    // The cone cutoff is stored in `w`.
+    vec4 coneApex;
+    vec4 coneAxis;
+    uint vertexOffset;
+    uint triangleOffset;
+    uint vertexCount;
+    uint triangleCount;
+};
+
+struct TaskPayload {
+    uint meshletIndices[MESHLETS_PER_TASK];
+};
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 viewProj;
+    vec4 cameraPosition;
+} ubo;
+
+layout(set = 2, binding = 0) readonly buffer Meshlets {
+    Meshlet meshlets[];
+};
+
+// The model matrix is only read by the mesh shader. The bounds of the meshlets are in the
+// space of the unquantized positions, which is world space.
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+    uint textureIndex;
+    uint firstMeshlet;
+    uint meshletCount;
+    uint texCoordOffset;
+} pushConstants;
+
+taskPayloadSharedEXT TaskPayload payload;
+
+shared uint visibleMeshletCount;
+
+
+bool isInsideFrustum(vec3 center, float radius) {
+    // The planes of the clip volume in world space, with depth from zero to one. Reverse-Z
+    // swaps the near and far planes, and a far plane at infinity culls nothing.
+    const mat4 viewProj = transpose(ubo.viewProj);
+    const vec4 planes[6] = vec4[6](
+        viewProj[3] + viewProj[0],
+        viewProj[3] - viewProj[0],
+        viewProj[3] + viewProj[1],
+        viewProj[3] - viewProj[1],
+        viewProj[2],
+        viewProj[3] - viewProj[2]
+    );
+
+    for (int i = 0; i < 6; i++) {
+        if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isVisible(Meshlet meshlet) {
+    if (!isInsideFrustum(meshlet.boundingSphere.xyz, meshlet.boundingSphere.w)) {
+        return false;
+    }
+
+    const vec3 coneApex = meshlet.coneApex.xyz;
+    const vec3 coneAxis = meshlet.coneAxis.xyz;
+    const float coneCutoff = meshlet.coneApex.w;
+
+    return dot(normalize(coneApex - ubo.cameraPosition.xyz), coneAxis) < coneCutoff;
+}
+
+void main() {
+    const uint meshletIndex = gl_GlobalInvocationID.x;
+    if (gl_LocalInvocationIndex == 0) {
+        visibleMeshletCount = 0;
+    }
+
+    barrier();
+
+    if (meshletIndex < pushConstants.meshletCount) {
+        const uint globalMeshletIndex = pushConstants.firstMeshlet + meshletIndex;
+        if (isVisible(meshlets[globalMeshletIndex])) {
+            const uint slot = atomicAdd(visibleMeshletCount, 1);
+            payload.meshletIndices[slot] = globalMeshletIndex;
+        }
+    }
+
+    barrier();
+
+    EmitMeshTasksEXT(visibleMeshletCount, 1, 1);
+}
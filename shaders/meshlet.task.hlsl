@@ -0,0 +1,103 @@
+// Culls the meshlets of a mesh before the mesh shader runs. Every thread tests one meshlet
+// against the view frustum and its normal cone, and the visible meshlets of the group are
+// compacted into the payload, one mesh shader group each.
+#define MESHLETS_PER_TASK 32
+
+struct Meshlet {
+    float4 boundingSphere;
+    // The cone cutoff is stored in `w`.
+    float4 coneApex;
+    float4 coneAxis;
+    uint vertexOffset;
+    uint triangleOffset;
+    uint vertexCount;
+    uint triangleCount;
+};
+
+struct AS_Payload {
+    uint meshletIndices[MESHLETS_PER_TASK];
+};
+
+struct AS_InputConstants {
+    float4x4 viewProj;
+    float4 cameraPosition;
+};
+
+// The model matrix is only read by the mesh shader. The bounds of the meshlets are in the
+// space of the unquantized positions, which is world space.
+struct AS_PushConstants {
+    float4x4 model;
+    uint textureIndex;
+    uint firstMeshlet;
+    uint meshletCount;
+    uint texCoordOffset;
+};
+
+cbuffer ubo : register(b0) {
+    AS_InputConstants ubo;
+}
+
+[[vk::push_constant]] AS_PushConstants pushConstants;
+
+[[vk::binding(0, 2)]] StructuredBuffer<Meshlet> meshlets;
+
+groupshared AS_Payload payload;
+groupshared uint visibleMeshletCount;
+
+
+bool isInsideFrustum(float3 center, float radius) {
+    // The planes of the clip volume in world space, with depth from zero to one. Reverse-Z
+    // swaps the near and far planes, and a far plane at infinity culls nothing.
+    float4x4 viewProj = ubo.viewProj;
+    float4 planes[6] = {
+        viewProj[3] + viewProj[0],
+        viewProj[3] - viewProj[0],
+        viewProj[3] + viewProj[1],
+        viewProj[3] - viewProj[1],
+        viewProj[2],
+        viewProj[3] - viewProj[2],
+    };
+
+    for (int i = 0; i < 6; i++) {
+        if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isVisible(Meshlet meshlet) {
+    if (!isInsideFrustum(meshlet.boundingSphere.xyz, meshlet.boundingSphere.w)) {
+        return false;
+    }
+
+    float3 coneApex = meshlet.coneApex.xyz;
+    float3 coneAxis = meshlet.coneAxis.xyz;
+    float coneCutoff = meshlet.coneApex.w;
+
+    return dot(normalize(coneApex - ubo.cameraPosition.xyz), coneAxis) < coneCutoff;
+}
+
+[numthreads(MESHLETS_PER_TASK, 1, 1)]
+void main(uint groupThreadId : SV_GroupIndex, uint3 dispatchThreadId : SV_DispatchThreadID) {
+    uint meshletIndex = dispatchThreadId.x;
+    if (groupThreadId == 0) {
+        visibleMeshletCount = 0;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (meshletIndex < pushConstants.meshletCount) {
+        uint globalMeshletIndex = pushConstants.firstMeshlet + meshletIndex;
+        if (isVisible(meshlets[globalMeshletIndex])) {
+            uint slot;
+            InterlockedAdd(visibleMeshletCount, 1, slot);
+            payload.meshletIndices[slot] = globalMeshletIndex;
+        }
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    DispatchMesh(visibleMeshletCount, 1, 1, payload);
+}
@@ -0,0 +1,144 @@
+#version 450
+
+// A single-pass mip chain generator in the spirit of AMD's FidelityFX SPD. Every workgroup
+// downsamples one 64x64 tile of mip 0 into mips 1 through 6 using shared memory. The last
+// workgroup to finish, found with a global atomic counter, then downsamples mip 6 into the
+// remaining levels. Sources up to 4096x4096 fit into a single dispatch.
+#define MAX_MIP_LEVELS 13
+#define TILE_SIZE 32
+#define THREAD_COUNT 256
+
+layout(local_size_x = THREAD_COUNT, local_size_y = 1, local_size_z = 1) in;
+
+layout(push_constant) uniform PushConstants {
+    uvec2 sourceExtent;
+    uint mipCount;
+    uint workGroupCount;
+    uint isSrgb;
+} pushConstants;
+
+layout(set = 0, binding = 0, rgba8) uniform coherent image2D mips[MAX_MIP_LEVELS];
+layout(set = 0, binding = 1) coherent buffer WorkGroupCounter {
+    uint count;
+} workGroupCounter;
+
+shared vec4 sharedTexels[TILE_SIZE][TILE_SIZE];
+shared uint sharedIsLastWorkGroup;
+
+
+vec3 srgbToLinear(vec3 color) {
+    vec3 low = color / 12.92;
+    vec3 high = pow((color + 0.055) / 1.055, vec3(2.4));
+
+    return mix(low, high, step(vec3(0.04045), color));
+}
+
+vec3 linearToSrgb(vec3 color) {
+    vec3 low = color * 12.92;
+    vec3 high = 1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055;
+
+    return mix(low, high, step(vec3(0.0031308), color));
+}
+
+uvec2 mipExtent(uint level) {
+    return max(uvec2(1, 1), pushConstants.sourceExtent >> level);
+}
+
+vec4 loadTexel(uint level, uvec2 coord) {
+    vec4 texel = imageLoad(mips[level], ivec2(min(coord, mipExtent(level) - 1)));
+    if (pushConstants.isSrgb != 0) {
+        texel.rgb = srgbToLinear(texel.rgb);
+    }
+
+    return texel;
+}
+
+void storeTexel(uint level, uvec2 coord, vec4 texel) {
+    if (any(greaterThanEqual(coord, mipExtent(level)))) {
+        return;
+    }
+
+    if (pushConstants.isSrgb != 0) {
+        texel.rgb = linearToSrgb(texel.rgb);
+    }
+
+    imageStore(mips[level], ivec2(coord), texel);
+}
+
+// Downsample a 64x64 tile of `baseLevel` starting at `tile * 64` into the next six levels.
+// The first level reads from the image, every following level reads from shared memory.
+void downsampleTile(uint baseLevel, uvec2 tile, uint localIndex) {
+    if (baseLevel + 1 >= pushConstants.mipCount) {
+        return;
+    }
+
+    for (uint i = 0; i < (TILE_SIZE * TILE_SIZE) / THREAD_COUNT; i++) {
+        uint index = localIndex + i * THREAD_COUNT;
+        uvec2 local = uvec2(index % TILE_SIZE, index / TILE_SIZE);
+        uvec2 coord = tile * TILE_SIZE + local;
+
+        vec4 texel = 0.25 * (
+            loadTexel(baseLevel, 2 * coord + uvec2(0, 0)) +
+            loadTexel(baseLevel, 2 * coord + uvec2(1, 0)) +
+            loadTexel(baseLevel, 2 * coord + uvec2(0, 1)) +
+            loadTexel(baseLevel, 2 * coord + uvec2(1, 1))
+        );
+
+        storeTexel(baseLevel + 1, coord, texel);
+        sharedTexels[local.y][local.x] = texel;
+    }
+
+    barrier();
+
+    for (uint level = baseLevel + 2; level < min(baseLevel + 7, pushConstants.mipCount); level++) {
+        uint tileSize = TILE_SIZE >> (level - baseLevel - 1);
+        uvec2 local = uvec2(localIndex % tileSize, localIndex / tileSize);
+        bool isActive = localIndex < tileSize * tileSize;
+
+        vec4 texel = vec4(0.0);
+        if (isActive) {
+            texel = 0.25 * (
+                sharedTexels[2 * local.y + 0][2 * local.x + 0] +
+                sharedTexels[2 * local.y + 0][2 * local.x + 1] +
+                sharedTexels[2 * local.y + 1][2 * local.x + 0] +
+                sharedTexels[2 * local.y + 1][2 * local.x + 1]
+            );
+        }
+
+        barrier();
+
+        if (isActive) {
+            storeTexel(level, tile * tileSize + local, texel);
+            sharedTexels[local.y][local.x] = texel;
+        }
+
+        barrier();
+    }
+}
+
+
+void main() {
+    uint localIndex = gl_LocalInvocationIndex;
+    downsampleTile(0, gl_WorkGroupID.xy, localIndex);
+
+    if (pushConstants.mipCount <= 7) {
+        return;
+    }
+
+    // Make this workgroup's writes to mip 6 visible before announcing that it is done.
+    memoryBarrierImage();
+    barrier();
+
+    if (localIndex == 0) {
+        uint previousCount = atomicAdd(workGroupCounter.count, 1);
+        sharedIsLastWorkGroup = (previousCount == pushConstants.workGroupCount - 1) ? 1 : 0;
+    }
+
+    barrier();
+
+    if (sharedIsLastWorkGroup == 0) {
+        return;
+    }
+
+    downsampleTile(6, uvec2(0, 0), localIndex);
+}
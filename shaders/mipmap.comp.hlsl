@@ -0,0 +1,141 @@
+// A single-pass mip chain generator in the spirit of AMD's FidelityFX SPD. Every workgroup
+// downsamples one 64x64 tile of mip 0 into mips 1 through 6 using group shared memory. The
+// last workgroup to finish, found with a global atomic counter, then downsamples mip 6
+// into the remaining levels. Sources up to 4096x4096 fit into a single dispatch.
+#define MAX_MIP_LEVELS 13
+#define TILE_SIZE 32
+#define THREAD_COUNT 256
+
+struct CS_PushConstants {
+    uint2 sourceExtent;
+    uint mipCount;
+    uint workGroupCount;
+    uint isSrgb;
+};
+
+[[vk::push_constant]] CS_PushConstants pushConstants;
+
+[[vk::binding(0, 0)]] [[vk::image_format("rgba8")]] globallycoherent RWTexture2D<float4> mips[MAX_MIP_LEVELS];
+[[vk::binding(1, 0)]] globallycoherent RWStructuredBuffer<uint> workGroupCounter;
+
+groupshared float4 sharedTexels[TILE_SIZE][TILE_SIZE];
+groupshared uint sharedIsLastWorkGroup;
+
+
+float3 srgbToLinear(float3 color) {
+    float3 low = color / 12.92f;
+    float3 high = pow((color + 0.055f) / 1.055f, 2.4f);
+
+    return lerp(low, high, step(0.04045f, color));
+}
+
+float3 linearToSrgb(float3 color) {
+    float3 low = color * 12.92f;
+    float3 high = 1.055f * pow(color, 1.0f / 2.4f) - 0.055f;
+
+    return lerp(low, high, step(0.0031308f, color));
+}
+
+uint2 mipExtent(uint level) {
+    return max(uint2(1, 1), pushConstants.sourceExtent >> level);
+}
+
+float4 loadTexel(uint level, uint2 coord) {
+    float4 texel = mips[level][min(coord, mipExtent(level) - 1)];
+    if (pushConstants.isSrgb != 0) {
+        texel.rgb = srgbToLinear(texel.rgb);
+    }
+
+    return texel;
+}
+
+void storeTexel(uint level, uint2 coord, float4 texel) {
+    if (any(coord >= mipExtent(level))) {
+        return;
+    }
+
+    if (pushConstants.isSrgb != 0) {
+        texel.rgb = linearToSrgb(texel.rgb);
+    }
+
+    mips[level][coord] = texel;
+}
+
+// Downsample a 64x64 tile of `baseLevel` starting at `tile * 64` into the next six levels.
+// The first level reads from the image, every following level reads from shared memory.
+void downsampleTile(uint baseLevel, uint2 tile, uint localIndex) {
+    if (baseLevel + 1 >= pushConstants.mipCount) {
+        return;
+    }
+
+    [unroll]
+    for (uint i = 0; i < (TILE_SIZE * TILE_SIZE) / THREAD_COUNT; i++) {
+        uint index = localIndex + i * THREAD_COUNT;
+        uint2 local = uint2(index % TILE_SIZE, index / TILE_SIZE);
+        uint2 coord = tile * TILE_SIZE + local;
+
+        float4 texel = 0.25f * (
+            loadTexel(baseLevel, 2 * coord + uint2(0, 0)) +
+            loadTexel(baseLevel, 2 * coord + uint2(1, 0)) +
+            loadTexel(baseLevel, 2 * coord + uint2(0, 1)) +
+            loadTexel(baseLevel, 2 * coord + uint2(1, 1))
+        );
+
+        storeTexel(baseLevel + 1, coord, texel);
+        sharedTexels[local.y][local.x] = texel;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint level = baseLevel + 2; level < min(baseLevel + 7, pushConstants.mipCount); level++) {
+        uint tileSize = TILE_SIZE >> (level - baseLevel - 1);
+        uint2 local = uint2(localIndex % tileSize, localIndex / tileSize);
+        bool isActive = localIndex < tileSize * tileSize;
+
+        float4 texel = 0.0f;
+        if (isActive) {
+            texel = 0.25f * (
+                sharedTexels[2 * local.y + 0][2 * local.x + 0] +
+                sharedTexels[2 * local.y + 0][2 * local.x + 1] +
+                sharedTexels[2 * local.y + 1][2 * local.x + 0] +
+                sharedTexels[2 * local.y + 1][2 * local.x + 1]
+            );
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+
+        if (isActive) {
+            storeTexel(level, tile * tileSize + local, texel);
+            sharedTexels[local.y][local.x] = texel;
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+    }
+}
+
+
+[numthreads(THREAD_COUNT, 1, 1)]
+void main(uint3 groupId : SV_GroupID, uint localIndex : SV_GroupIndex) {
+    downsampleTile(0, groupId.xy, localIndex);
+
+    if (pushConstants.mipCount <= 7) {
+        return;
+    }
+
+    // Make this workgroup's writes to mip 6 visible before announcing that it is done.
+    DeviceMemoryBarrierWithGroupSync();
+
+    if (localIndex == 0) {
+        uint previousCount;
+        InterlockedAdd(workGroupCounter[0], 1, previousCount);
+        sharedIsLastWorkGroup = (previousCount == pushConstants.workGroupCount - 1) ? 1 : 0;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (sharedIsLastWorkGroup == 0) {
+        return;
+    }
+
+    downsampleTile(6, uint2(0, 0), localIndex);
+}
@@ -0,0 +1,320 @@
+#version 450
+
+// A per-level mip chain generator with configurable downsampling filters. Every dispatch
+// runs one pass over one level:
+//
+// * The downsample pass filters `sourceLevel` into the next level. The footprint of every
+//   destination texel is derived from the exact ratio of the two extents, so odd-sized
+//   levels are filtered over all of their texels instead of being truncated.
+// * The histogram pass counts the alpha values of `sourceLevel`.
+// * The alpha scale pass rescales the alpha of `sourceLevel` so that the fraction of texels
+//   above the alpha cutoff matches level 0. This keeps cutout textures from thinning out
+//   or vanishing in the distance.
+//
+// Every level is an array of layers, and each layer runs in its own slice of the dispatch,
+// so all faces of a cube map or all layers of an array share a dispatch. The alpha
+// histograms count every layer together. The taps of a cube face that fall past its edges
+// are read from the neighbouring faces, so the faces of every level meet without seams.
+#define MAX_MIP_LEVELS 13
+#define HISTOGRAM_BIN_COUNT 256
+#define THREAD_COUNT_X 8
+#define THREAD_COUNT_Y 8
+#define THREAD_COUNT (THREAD_COUNT_X * THREAD_COUNT_Y)
+
+#define FILTER_BOX 0
+#define FILTER_TENT 1
+#define FILTER_KAISER 2
+#define FILTER_LANCZOS 3
+
+#define PASS_DOWNSAMPLE 0
+#define PASS_HISTOGRAM 1
+#define PASS_SCALE_ALPHA 2
+
+#define PI 3.14159265358979
+
+layout(local_size_x = THREAD_COUNT_X, local_size_y = THREAD_COUNT_Y, local_size_z = 1) in;
+
+layout(push_constant) uniform PushConstants {
+    uint sourceWidth;
+    uint sourceHeight;
+    uint destinationWidth;
+    uint destinationHeight;
+    uint sourceLevel;
+    uint filterType;
+    uint pass;
+    uint isSrgb;
+    float alphaCutoff;
+    uint isCubeMap;
+} pushConstants;
+
+layout(set = 0, binding = 0, rgba8) uniform image2DArray mips[MAX_MIP_LEVELS];
+// The first element is the workgroup counter of the single-pass generator. It is followed
+// by one alpha histogram per mip level.
+layout(set = 0, binding = 1) buffer Scratch {
+    uint values[];
+} scratch;
+
+shared uint sharedHistogram[HISTOGRAM_BIN_COUNT];
+shared float sharedAlphaScale;
+
+
+vec3 srgbToLinear(vec3 color) {
+    vec3 low = color / 12.92;
+    vec3 high = pow((color + 0.055) / 1.055, vec3(2.4));
+
+    return mix(low, high, step(vec3(0.04045), color));
+}
+
+vec3 linearToSrgb(vec3 color) {
+    vec3 low = color * 12.92;
+    vec3 high = 1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055;
+
+    return mix(low, high, step(vec3(0.0031308), color));
+}
+
+float sinc(float x) {
+    if (abs(x) < 1e-5) {
+        return 1.0;
+    }
+
+    return sin(PI * x) / (PI * x);
+}
+
+float besselI0(float x) {
+    float sum = 1.0;
+    float term = 1.0;
+    for (int k = 1; k < 10; k++) {
+        float ratio = x / (2.0 * float(k));
+        term *= ratio * ratio;
+        sum += term;
+    }
+
+    return sum;
+}
+
+// The support of each filter, in destination texels.
+float filterRadius(uint filterType) {
+    switch (filterType) {
+        case FILTER_TENT: return 1.0;
+        case FILTER_KAISER: return 1.5;
+        case FILTER_LANCZOS: return 2.0;
+        default: return 0.5;
+    }
+}
+
+// The weight of a source texel along one axis. `texel` is the source texel index, `center`
+// the destination texel center and `scale` the ratio of source to destination extent, all
+// in source texels.
+float axisWeight(uint filterType, int texel, float center, float scale) {
+    if (filterType == FILTER_BOX) {
+        // The box filter weights each texel by how much of it the footprint covers.
+        float low = center - 0.5 * scale;
+        float high = center + 0.5 * scale;
+
+        return max(0.0, min(float(texel) + 1.0, high) - max(float(texel), low));
+    }
+
+    float t = abs((float(texel) + 0.5 - center) / scale);
+    switch (filterType) {
+        case FILTER_TENT: {
+            return max(0.0, 1.0 - t);
+        }
+        case FILTER_KAISER: {
+            if (t >= 1.5) {
+                return 0.0;
+            }
+
+            float ratio = t / 1.5;
+            return sinc(t) * besselI0(4.0 * sqrt(1.0 - ratio * ratio)) / besselI0(4.0);
+        }
+        default: {
+            if (t >= 2.0) {
+                return 0.0;
+            }
+
+            return sinc(t) * sinc(t / 2.0);
+        }
+    }
+}
+
+// The face and texel that a texel past the edges of a cube face falls on. The faces follow
+// the Vulkan cube map layout: +X, -X, +Y, -Y, +Z, -Z.
+ivec3 wrapCubeTexel(ivec2 coord, int layer, int faceSize) {
+    int face = layer % 6;
+    vec2 st = (vec2(coord) + 0.5) / float(faceSize) * 2.0 - 1.0;
+    vec3 direction;
+    switch (face) {
+        case 0: direction = vec3(1.0, -st.y, -st.x); break;
+        case 1: direction = vec3(-1.0, -st.y, st.x); break;
+        case 2: direction = vec3(st.x, 1.0, st.y); break;
+        case 3: direction = vec3(st.x, -1.0, -st.y); break;
+        case 4: direction = vec3(st.x, -st.y, 1.0); break;
+        default: direction = vec3(-st.x, -st.y, -1.0); break;
+    }
+
+    vec3 magnitude = abs(direction);
+    int wrappedFace;
+    vec2 wrapped;
+    if (magnitude.x >= magnitude.y && magnitude.x >= magnitude.z) {
+        wrappedFace = direction.x > 0.0 ? 0 : 1;
+        wrapped = vec2(direction.x > 0.0 ? -direction.z : direction.z, -direction.y) / magnitude.x;
+    } else if (magnitude.y >= magnitude.z) {
+        wrappedFace = direction.y > 0.0 ? 2 : 3;
+        wrapped = vec2(direction.x, direction.y > 0.0 ? direction.z : -direction.z) / magnitude.y;
+    } else {
+        wrappedFace = direction.z > 0.0 ? 4 : 5;
+        wrapped = vec2(direction.z > 0.0 ? direction.x : -direction.x, -direction.y) / magnitude.z;
+    }
+
+    ivec2 texel = ivec2(floor((wrapped * 0.5 + 0.5) * float(faceSize)));
+
+    return ivec3(clamp(texel, ivec2(0, 0), ivec2(faceSize - 1)), layer - face + wrappedFace);
+}
+
+vec4 loadLinear(uint level, ivec2 coord, int layer) {
+    ivec2 extent = ivec2(pushConstants.sourceWidth, pushConstants.sourceHeight);
+    ivec3 texelCoord = ivec3(clamp(coord, ivec2(0, 0), extent - 1), layer);
+    if (pushConstants.isCubeMap != 0 && any(notEqual(coord, texelCoord.xy))) {
+        texelCoord = wrapCubeTexel(coord, layer, extent.x);
+    }
+
+    vec4 texel = imageLoad(mips[level], texelCoord);
+    if (pushConstants.isSrgb != 0) {
+        texel.rgb = srgbToLinear(texel.rgb);
+    }
+
+    return texel;
+}
+
+void downsample(uvec3 coord) {
+    if (any(greaterThanEqual(coord.xy, uvec2(pushConstants.destinationWidth, pushConstants.destinationHeight)))) {
+        return;
+    }
+
+    vec2 scale = vec2(
+        float(pushConstants.sourceWidth) / float(pushConstants.destinationWidth),
+        float(pushConstants.sourceHeight) / float(pushConstants.destinationHeight)
+    );
+    vec2 center = (vec2(coord.xy) + 0.5) * scale;
+    vec2 reach = filterRadius(pushConstants.filterType) * scale;
+    ivec2 first = ivec2(floor(center - reach));
+    ivec2 last = ivec2(ceil(center + reach)) - 1;
+
+    vec4 sum = vec4(0.0);
+    float weightSum = 0.0;
+    for (int y = first.y; y <= last.y; y++) {
+        float weightY = axisWeight(pushConstants.filterType, y, center.y, scale.y);
+        if (weightY == 0.0) {
+            continue;
+        }
+
+        for (int x = first.x; x <= last.x; x++) {
+            float weight = weightY * axisWeight(pushConstants.filterType, x, center.x, scale.x);
+            sum += weight * loadLinear(pushConstants.sourceLevel, ivec2(x, y), int(coord.z));
+            weightSum += weight;
+        }
+    }
+
+    // Negative lobes of the windowed sinc filters can overshoot, so clamp the result.
+    vec4 texel = clamp(sum / weightSum, 0.0, 1.0);
+    if (pushConstants.isSrgb != 0) {
+        texel.rgb = linearToSrgb(texel.rgb);
+    }
+
+    imageStore(mips[pushConstants.sourceLevel + 1], ivec3(coord), texel);
+}
+
+void countAlpha(uvec3 coord, uint localIndex) {
+    for (uint bin = localIndex; bin < HISTOGRAM_BIN_COUNT; bin += THREAD_COUNT) {
+        sharedHistogram[bin] = 0;
+    }
+
+    barrier();
+
+    if (all(lessThan(coord.xy, uvec2(pushConstants.sourceWidth, pushConstants.sourceHeight)))) {
+        float alpha = imageLoad(mips[pushConstants.sourceLevel], ivec3(coord)).a;
+        uint bin = min(uint(alpha * 255.0 + 0.5), HISTOGRAM_BIN_COUNT - 1);
+        atomicAdd(sharedHistogram[bin], 1);
+    }
+
+    barrier();
+
+    uint histogramOffset = 1 + pushConstants.sourceLevel * HISTOGRAM_BIN_COUNT;
+    for (uint bin = localIndex; bin < HISTOGRAM_BIN_COUNT; bin += THREAD_COUNT) {
+        if (sharedHistogram[bin] != 0) {
+            atomicAdd(scratch.values[histogramOffset + bin], sharedHistogram[bin]);
+        }
+    }
+}
+
+// Find the alpha scale that gives `level` the same coverage above the cutoff as level 0.
+float computeAlphaScale(uint level) {
+    uint cutoffBin = uint(pushConstants.alphaCutoff * 255.0 + 0.5);
+    uint baseTotal = 0;
+    uint baseCovered = 0;
+    for (uint bin = 0; bin < HISTOGRAM_BIN_COUNT; bin++) {
+        uint count = scratch.values[1 + bin];
+        baseTotal += count;
+        baseCovered += (bin > cutoffBin) ? count : 0;
+    }
+
+    // Nothing is left to preserve when no texel of level 0 passes the cutoff, and scaling
+    // toward an empty target would lower the alpha of every level.
+    if (baseCovered == 0) {
+        return 1.0;
+    }
+
+    uint histogramOffset = 1 + level * HISTOGRAM_BIN_COUNT;
+    uint levelTotal = 0;
+    for (uint bin = 0; bin < HISTOGRAM_BIN_COUNT; bin++) {
+        levelTotal += scratch.values[histogramOffset + bin];
+    }
+
+    float targetCoverage = float(baseCovered) / float(max(baseTotal, 1u));
+    uint covered = 0;
+    for (uint bin = HISTOGRAM_BIN_COUNT - 1; bin > 0; bin--) {
+        covered += scratch.values[histogramOffset + bin];
+        if (float(covered) >= targetCoverage * float(levelTotal)) {
+            return pushConstants.alphaCutoff / (float(bin) / 255.0);
+        }
+    }
+
+    return 1.0;
+}
+
+void scaleAlpha(uvec3 coord, uint localIndex) {
+    if (localIndex == 0) {
+        sharedAlphaScale = computeAlphaScale(pushConstants.sourceLevel);
+    }
+
+    barrier();
+
+    if (any(greaterThanEqual(coord.xy, uvec2(pushConstants.sourceWidth, pushConstants.sourceHeight)))) {
+        return;
+    }
+
+    // Only alpha changes, so the color channels are written back exactly as they were read.
+    vec4 texel = imageLoad(mips[pushConstants.sourceLevel], ivec3(coord));
+    texel.a = clamp(texel.a * sharedAlphaScale, 0.0, 1.0);
+    imageStore(mips[pushConstants.sourceLevel], ivec3(coord), texel);
+}
+
+
+void main() {
+    uvec3 coord = gl_GlobalInvocationID;
+    uint localIndex = gl_LocalInvocationIndex;
+    switch (pushConstants.pass) {
+        case PASS_HISTOGRAM: {
+            countAlpha(coord, localIndex);
+            break;
+        }
+        case PASS_SCALE_ALPHA: {
+            scaleAlpha(coord, localIndex);
+            break;
+        }
+        default: {
+            downsample(coord);
+            break;
+        }
+    }
+}
@@ -0,0 +1,318 @@
+// A per-level mip chain generator with configurable downsampling filters. Every dispatch
+// runs one pass over one level:
+//
+// * The downsample pass filters `sourceLevel` into the next level. The footprint of every
+//   destination texel is derived from the exact ratio of the two extents, so odd-sized
+//   levels are filtered over all of their texels instead of being truncated.
+// * The histogram pass counts the alpha values of `sourceLevel`.
+// * The alpha scale pass rescales the alpha of `sourceLevel` so that the fraction of texels
+//   above the alpha cutoff matches level 0. This keeps cutout textures from thinning out
+//   or vanishing in the distance.
+//
+// Every level is an array of layers, and each layer runs in its own slice of the dispatch,
+// so all faces of a cube map or all layers of an array share a dispatch. The alpha
+// histograms count every layer together. The taps of a cube face that fall past its edges
+// are read from the neighbouring faces, so the faces of every level meet without seams.
+#define MAX_MIP_LEVELS 13
+#define HISTOGRAM_BIN_COUNT 256
+#define THREAD_COUNT_X 8
+#define THREAD_COUNT_Y 8
+#define THREAD_COUNT (THREAD_COUNT_X * THREAD_COUNT_Y)
+
+#define FILTER_BOX 0
+#define FILTER_TENT 1
+#define FILTER_KAISER 2
+#define FILTER_LANCZOS 3
+
+#define PASS_DOWNSAMPLE 0
+#define PASS_HISTOGRAM 1
+#define PASS_SCALE_ALPHA 2
+
+#define PI 3.14159265358979f
+
+struct CS_PushConstants {
+    uint sourceWidth;
+    uint sourceHeight;
+    uint destinationWidth;
+    uint destinationHeight;
+    uint sourceLevel;
+    uint filterType;
+    uint pass;
+    uint isSrgb;
+    float alphaCutoff;
+    uint isCubeMap;
+};
+
+[[vk::push_constant]] CS_PushConstants pushConstants;
+
+[[vk::binding(0, 0)]] [[vk::image_format("rgba8")]] RWTexture2DArray<float4> mips[MAX_MIP_LEVELS];
+// The first element is the workgroup counter of the single-pass generator. It is followed
+// by one alpha histogram per mip level.
+[[vk::binding(1, 0)]] RWStructuredBuffer<uint> scratch;
+
+groupshared uint sharedHistogram[HISTOGRAM_BIN_COUNT];
+groupshared float sharedAlphaScale;
+
+
+float3 srgbToLinear(float3 color) {
+    float3 low = color / 12.92f;
+    float3 high = pow((color + 0.055f) / 1.055f, 2.4f);
+
+    return lerp(low, high, step(0.04045f, color));
+}
+
+float3 linearToSrgb(float3 color) {
+    float3 low = color * 12.92f;
+    float3 high = 1.055f * pow(color, 1.0f / 2.4f) - 0.055f;
+
+    return lerp(low, high, step(0.0031308f, color));
+}
+
+float sinc(float x) {
+    if (abs(x) < 1e-5f) {
+        return 1.0f;
+    }
+
+    return sin(PI * x) / (PI * x);
+}
+
+float besselI0(float x) {
+    float sum = 1.0f;
+    float term = 1.0f;
+    [unroll]
+    for (int k = 1; k < 10; k++) {
+        float ratio = x / (2.0f * k);
+        term *= ratio * ratio;
+        sum += term;
+    }
+
+    return sum;
+}
+
+// The support of each filter, in destination texels.
+float filterRadius(uint filterType) {
+    switch (filterType) {
+        case FILTER_TENT: return 1.0f;
+        case FILTER_KAISER: return 1.5f;
+        case FILTER_LANCZOS: return 2.0f;
+        default: return 0.5f;
+    }
+}
+
+// The weight of a source texel along one axis. `texel` is the source texel index, `center`
+// the destination texel center and `scale` the ratio of source to destination extent, all
+// in source texels.
+float axisWeight(uint filterType, int texel, float center, float scale) {
+    if (filterType == FILTER_BOX) {
+        // The box filter weights each texel by how much of it the footprint covers.
+        float low = center - 0.5f * scale;
+        float high = center + 0.5f * scale;
+
+        return max(0.0f, min(texel + 1.0f, high) - max(float(texel), low));
+    }
+
+    float t = abs((texel + 0.5f - center) / scale);
+    switch (filterType) {
+        case FILTER_TENT: {
+            return max(0.0f, 1.0f - t);
+        }
+        case FILTER_KAISER: {
+            if (t >= 1.5f) {
+                return 0.0f;
+            }
+
+            float ratio = t / 1.5f;
+            return sinc(t) * besselI0(4.0f * sqrt(1.0f - ratio * ratio)) / besselI0(4.0f);
+        }
+        default: {
+            if (t >= 2.0f) {
+                return 0.0f;
+            }
+
+            return sinc(t) * sinc(t / 2.0f);
+        }
+    }
+}
+
+// The face and texel that a texel past the edges of a cube face falls on. The faces follow
+// the Vulkan cube map layout: +X, -X, +Y, -Y, +Z, -Z.
+int3 wrapCubeTexel(int2 coord, int layer, int faceSize) {
+    int face = layer % 6;
+    float2 st = (float2(coord) + 0.5f) / float(faceSize) * 2.0f - 1.0f;
+    float3 direction;
+    switch (face) {
+        case 0: direction = float3(1.0f, -st.y, -st.x); break;
+        case 1: direction = float3(-1.0f, -st.y, st.x); break;
+        case 2: direction = float3(st.x, 1.0f, st.y); break;
+        case 3: direction = float3(st.x, -1.0f, -st.y); break;
+        case 4: direction = float3(st.x, -st.y, 1.0f); break;
+        default: direction = float3(-st.x, -st.y, -1.0f); break;
+    }
+
+    float3 magnitude = abs(direction);
+    int wrappedFace;
+    float2 wrapped;
+    if (magnitude.x >= magnitude.y && magnitude.x >= magnitude.z) {
+        wrappedFace = direction.x > 0.0f ? 0 : 1;
+        wrapped = float2(direction.x > 0.0f ? -direction.z : direction.z, -direction.y) / magnitude.x;
+    } else if (magnitude.y >= magnitude.z) {
+        wrappedFace = direction.y > 0.0f ? 2 : 3;
+        wrapped = float2(direction.x, direction.y > 0.0f ? direction.z : -direction.z) / magnitude.y;
+    } else {
+        wrappedFace = direction.z > 0.0f ? 4 : 5;
+        wrapped = float2(direction.z > 0.0f ? direction.x : -direction.x, -direction.y) / magnitude.z;
+    }
+
+    int2 texel = int2(floor((wrapped * 0.5f + 0.5f) * float(faceSize)));
+
+    return int3(clamp(texel, int2(0, 0), int2(faceSize - 1, faceSize - 1)), layer - face + wrappedFace);
+}
+
+float4 loadLinear(uint level, int2 coord, int layer) {
+    int2 extent = int2(pushConstants.sourceWidth, pushConstants.sourceHeight);
+    int3 texelCoord = int3(clamp(coord, int2(0, 0), extent - 1), layer);
+    if (pushConstants.isCubeMap != 0 && any(coord != texelCoord.xy)) {
+        texelCoord = wrapCubeTexel(coord, layer, extent.x);
+    }
+
+    float4 texel = mips[level][uint3(texelCoord)];
+    if (pushConstants.isSrgb != 0) {
+        texel.rgb = srgbToLinear(texel.rgb);
+    }
+
+    return texel;
+}
+
+void downsample(uint3 coord) {
+    if (any(coord.xy >= uint2(pushConstants.destinationWidth, pushConstants.destinationHeight))) {
+        return;
+    }
+
+    float2 scale = float2(
+        float(pushConstants.sourceWidth) / float(pushConstants.destinationWidth),
+        float(pushConstants.sourceHeight) / float(pushConstants.destinationHeight)
+    );
+    float2 center = (float2(coord.xy) + 0.5f) * scale;
+    float2 reach = filterRadius(pushConstants.filterType) * scale;
+    int2 first = int2(floor(center - reach));
+    int2 last = int2(ceil(center + reach)) - 1;
+
+    float4 sum = 0.0f;
+    float weightSum = 0.0f;
+    [loop]
+    for (int y = first.y; y <= last.y; y++) {
+        float weightY = axisWeight(pushConstants.filterType, y, center.y, scale.y);
+        if (weightY == 0.0f) {
+            continue;
+        }
+
+        [loop]
+        for (int x = first.x; x <= last.x; x++) {
+            float weight = weightY * axisWeight(pushConstants.filterType, x, center.x, scale.x);
+            sum += weight * loadLinear(pushConstants.sourceLevel, int2(x, y), int(coord.z));
+            weightSum += weight;
+        }
+    }
+
+    // Negative lobes of the windowed sinc filters can overshoot, so clamp the result.
+    float4 texel = saturate(sum / weightSum);
+    if (pushConstants.isSrgb != 0) {
+        texel.rgb = linearToSrgb(texel.rgb);
+    }
+
+    mips[pushConstants.sourceLevel + 1][coord] = texel;
+}
+
+void countAlpha(uint3 coord, uint localIndex) {
+    for (uint bin = localIndex; bin < HISTOGRAM_BIN_COUNT; bin += THREAD_COUNT) {
+        sharedHistogram[bin] = 0;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (all(coord.xy < uint2(pushConstants.sourceWidth, pushConstants.sourceHeight))) {
+        float alpha = mips[pushConstants.sourceLevel][coord].a;
+        uint bin = min(uint(alpha * 255.0f + 0.5f), HISTOGRAM_BIN_COUNT - 1);
+        InterlockedAdd(sharedHistogram[bin], 1);
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    uint histogramOffset = 1 + pushConstants.sourceLevel * HISTOGRAM_BIN_COUNT;
+    for (uint bin = localIndex; bin < HISTOGRAM_BIN_COUNT; bin += THREAD_COUNT) {
+        if (sharedHistogram[bin] != 0) {
+            InterlockedAdd(scratch[histogramOffset + bin], sharedHistogram[bin]);
+        }
+    }
+}
+
+// Find the alpha scale that gives `level` the same coverage above the cutoff as level 0.
+float computeAlphaScale(uint level) {
+    uint cutoffBin = uint(pushConstants.alphaCutoff * 255.0f + 0.5f);
+    uint baseTotal = 0;
+    uint baseCovered = 0;
+    for (uint bin = 0; bin < HISTOGRAM_BIN_COUNT; bin++) {
+        uint count = scratch[1 + bin];
+        baseTotal += count;
+        baseCovered += (bin > cutoffBin) ? count : 0;
+    }
+
+    // Nothing is left to preserve when no texel of level 0 passes the cutoff, and scaling
+    // toward an empty target would lower the alpha of every level.
+    if (baseCovered == 0) {
+        return 1.0f;
+    }
+
+    uint histogramOffset = 1 + level * HISTOGRAM_BIN_COUNT;
+    uint levelTotal = 0;
+    for (uint bin = 0; bin < HISTOGRAM_BIN_COUNT; bin++) {
+        levelTotal += scratch[histogramOffset + bin];
+    }
+
+    float targetCoverage = float(baseCovered) / float(max(baseTotal, 1u));
+    uint covered = 0;
+    for (uint bin = HISTOGRAM_BIN_COUNT - 1; bin > 0; bin--) {
+        covered += scratch[histogramOffset + bin];
+        if (float(covered) >= targetCoverage * float(levelTotal)) {
+            return pushConstants.alphaCutoff / (float(bin) / 255.0f);
+        }
+    }
+
+    return 1.0f;
+}
+
+void scaleAlpha(uint3 coord, uint localIndex) {
+    if (localIndex == 0) {
+        sharedAlphaScale = computeAlphaScale(pushConstants.sourceLevel);
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (any(coord.xy >= uint2(pushConstants.sourceWidth, pushConstants.sourceHeight))) {
+        return;
+    }
+
+    // Only alpha changes, so the color channels are written back exactly as they were read.
+    float4 texel = mips[pushConstants.sourceLevel][coord];
+    texel.a = saturate(texel.a * sharedAlphaScale);
+    mips[pushConstants.sourceLevel][coord] = texel;
+}
+
+
+[numthreads(THREAD_COUNT_X, THREAD_COUNT_Y, 1)]
+void main(uint3 dispatchId : SV_DispatchThreadID, uint localIndex : SV_GroupIndex) {
+    switch (pushConstants.pass) {
+        case PASS_HISTOGRAM: {
+            countAlpha(dispatchId, localIndex);
+            break;
+        }
+        case PASS_SCALE_ALPHA: {
+            scaleAlpha(dispatchId, localIndex);
+            break;
+        }
+        default: {
+            downsample(dispatchId);
+            break;
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#version 450
+
+// The downsample pass of the filter mip generator for volume textures. Every dispatch
+// filters `sourceLevel` into the next level along all three axes, with the same filters
+// and exact footprints as the 2D filter pipeline. Volumes have no alpha coverage passes.
+#define MAX_MIP_LEVELS 13
+#define THREAD_COUNT_X 4
+#define THREAD_COUNT_Y 4
+#define THREAD_COUNT_Z 4
+
+#define FILTER_BOX 0
+#define FILTER_TENT 1
+#define FILTER_KAISER 2
+#define FILTER_LANCZOS 3
+
+#define PI 3.14159265358979
+
+layout(local_size_x = THREAD_COUNT_X, local_size_y = THREAD_COUNT_Y, local_size_z = THREAD_COUNT_Z) in;
+
+layout(push_constant) uniform PushConstants {
+    uint sourceWidth;
+    uint sourceHeight;
+    uint sourceDepth;
+    uint destinationWidth;
+    uint destinationHeight;
+    uint destinationDepth;
+    uint sourceLevel;
+    uint filterType;
+    uint isSrgb;
+} pushConstants;
+
+layout(set = 0, binding = 0, rgba8) uniform image3D mips[MAX_MIP_LEVELS];
+
+
+vec3 srgbToLinear(vec3 color) {
+    vec3 low = color / 12.92;
+    vec3 high = pow((color + 0.055) / 1.055, vec3(2.4));
+
+    return mix(low, high, step(vec3(0.04045), color));
+}
+
+vec3 linearToSrgb(vec3 color) {
+    vec3 low = color * 12.92;
+    vec3 high = 1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055;
+
+    return mix(low, high, step(vec3(0.0031308), color));
+}
+
+float sinc(float x) {
+    if (abs(x) < 1e-5) {
+        return 1.0;
+    }
+
+    return sin(PI * x) / (PI * x);
+}
+
+float besselI0(float x) {
+    float sum = 1.0;
+    float term = 1.0;
+    for (int k = 1; k < 10; k++) {
+        float ratio = x / (2.0 * float(k));
+        term *= ratio * ratio;
+        sum += term;
+    }
+
+    return sum;
+}
+
+// The support of each filter, in destination texels.
+float filterRadius(uint filterType) {
+    switch (filterType) {
+        case FILTER_TENT: return 1.0;
+        case FILTER_KAISER: return 1.5;
+        case FILTER_LANCZOS: return 2.0;
+        default: return 0.5;
+    }
+}
+
+// The weight of a source texel along one axis. `texel` is the source texel index, `center`
+// the destination texel center and `scale` the ratio of source to destination extent, all
+// in source texels.
+float axisWeight(uint filterType, int texel, float center, float scale) {
+    if (filterType == FILTER_BOX) {
+        // The box filter weights each texel by how much of it the footprint covers.
+        float low = center - 0.5 * scale;
+        float high = center + 0.5 * scale;
+
+        return max(0.0, min(float(texel) + 1.0, high) - max(float(texel), low));
+    }
+
+    float t = abs((float(texel) + 0.5 - center) / scale);
+    switch (filterType) {
+        case FILTER_TENT: {
+            return max(0.0, 1.0 - t);
+        }
+        case FILTER_KAISER: {
+            if (t >= 1.5) {
+                return 0.0;
+            }
+
+            float ratio = t / 1.5;
+            return sinc(t) * besselI0(4.0 * sqrt(1.0 - ratio * ratio)) / besselI0(4.0);
+        }
+        default: {
+            if (t >= 2.0) {
+                return 0.0;
+            }
+
+            return sinc(t) * sinc(t / 2.0);
+        }
+    }
+}
+
+vec4 loadLinear(uint level, ivec3 coord) {
+    ivec3 extent = ivec3(pushConstants.sourceWidth, pushConstants.sourceHeight, pushConstants.sourceDepth);
+    vec4 texel = imageLoad(mips[level], clamp(coord, ivec3(0, 0, 0), extent - 1));
+    if (pushConstants.isSrgb != 0) {
+        texel.rgb = srgbToLinear(texel.rgb);
+    }
+
+    return texel;
+}
+
+
+void main() {
+    uvec3 coord = gl_GlobalInvocationID;
+    uvec3 destinationExtent = uvec3(pushConstants.destinationWidth, pushConstants.destinationHeight, pushConstants.destinationDepth);
+    if (any(greaterThanEqual(coord, destinationExtent))) {
+        return;
+    }
+
+    vec3 scale = vec3(pushConstants.sourceWidth, pushConstants.sourceHeight, pushConstants.sourceDepth) / vec3(destinationExtent);
+    vec3 center = (vec3(coord) + 0.5) * scale;
+    vec3 reach = filterRadius(pushConstants.filterType) * scale;
+    ivec3 first = ivec3(floor(center - reach));
+    ivec3 last = ivec3(ceil(center + reach)) - 1;
+
+    vec4 sum = vec4(0.0);
+    float weightSum = 0.0;
+    for (int z = first.z; z <= last.z; z++) {
+        float weightZ = axisWeight(pushConstants.filterType, z, center.z, scale.z);
+        if (weightZ == 0.0) {
+            continue;
+        }
+
+        for (int y = first.y; y <= last.y; y++) {
+            float weightYZ = weightZ * axisWeight(pushConstants.filterType, y, center.y, scale.y);
+            if (weightYZ == 0.0) {
+                continue;
+            }
+
+            for (int x = first.x; x <= last.x; x++) {
+                float weight = weightYZ * axisWeight(pushConstants.filterType, x, center.x, scale.x);
+                sum += weight * loadLinear(pushConstants.sourceLevel, ivec3(x, y, z));
+                weightSum += weight;
+            }
+        }
+    }
+
+    // Negative lobes of the windowed sinc filters can overshoot, so clamp the result.
+    vec4 texel = clamp(sum / weightSum, 0.0, 1.0);
+    if (pushConstants.isSrgb != 0) {
+        texel.rgb = linearToSrgb(texel.rgb);
+    }
+
+    imageStore(mips[pushConstants.sourceLevel + 1], ivec3(coord), texel);
+}
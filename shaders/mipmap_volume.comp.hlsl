@@ -0,0 +1,169 @@
+// The downsample pass of the filter mip generator for volume textures. Every dispatch
+// filters `sourceLevel` into the next level along all three axes, with the same filters
+// and exact footprints as the 2D filter pipeline. Volumes have no alpha coverage passes.
+#define MAX_MIP_LEVELS 13
+#define THREAD_COUNT_X 4
+#define THREAD_COUNT_Y 4
+#define THREAD_COUNT_Z 4
+
+#define FILTER_BOX 0
+#define FILTER_TENT 1
+#define FILTER_KAISER 2
+#define FILTER_LANCZOS 3
+
+#define PI 3.14159265358979f
+
+struct CS_PushConstants {
+    uint sourceWidth;
+    uint sourceHeight;
+    uint sourceDepth;
+    uint destinationWidth;
+    uint destinationHeight;
+    uint destinationDepth;
+    uint sourceLevel;
+    uint filterType;
+    uint isSrgb;
+};
+
+[[vk::push_constant]] CS_PushConstants pushConstants;
+
+[[vk::binding(0, 0)]] [[vk::image_format("rgba8")]] RWTexture3D<float4> mips[MAX_MIP_LEVELS];
+
+
+float3 srgbToLinear(float3 color) {
+    float3 low = color / 12.92f;
+    float3 high = pow((color + 0.055f) / 1.055f, 2.4f);
+
+    return lerp(low, high, step(0.04045f, color));
+}
+
+float3 linearToSrgb(float3 color) {
+    float3 low = color * 12.92f;
+    float3 high = 1.055f * pow(color, 1.0f / 2.4f) - 0.055f;
+
+    return lerp(low, high, step(0.0031308f, color));
+}
+
+float sinc(float x) {
+    if (abs(x) < 1e-5f) {
+        return 1.0f;
+    }
+
+    return sin(PI * x) / (PI * x);
+}
+
+float besselI0(float x) {
+    float sum = 1.0f;
+    float term = 1.0f;
+    [unroll]
+    for (int k = 1; k < 10; k++) {
+        float ratio = x / (2.0f * k);
+        term *= ratio * ratio;
+        sum += term;
+    }
+
+    return sum;
+}
+
+// The support of each filter, in destination texels.
+float filterRadius(uint filterType) {
+    switch (filterType) {
+        case FILTER_TENT: return 1.0f;
+        case FILTER_KAISER: return 1.5f;
+        case FILTER_LANCZOS: return 2.0f;
+        default: return 0.5f;
+    }
+}
+
+// The weight of a source texel along one axis. `texel` is the source texel index, `center`
+// the destination texel center and `scale` the ratio of source to destination extent, all
+// in source texels.
+float axisWeight(uint filterType, int texel, float center, float scale) {
+    if (filterType == FILTER_BOX) {
+        // The box filter weights each texel by how much of it the footprint covers.
+        float low = center - 0.5f * scale;
+        float high = center + 0.5f * scale;
+
+        return max(0.0f, min(texel + 1.0f, high) - max(float(texel), low));
+    }
+
+    float t = abs((texel + 0.5f - center) / scale);
+    switch (filterType) {
+        case FILTER_TENT: {
+            return max(0.0f, 1.0f - t);
+        }
+        case FILTER_KAISER: {
+            if (t >= 1.5f) {
+                return 0.0f;
+            }
+
+            float ratio = t / 1.5f;
+            return sinc(t) * besselI0(4.0f * sqrt(1.0f - ratio * ratio)) / besselI0(4.0f);
+        }
+        default: {
+            if (t >= 2.0f) {
+                return 0.0f;
+            }
+
+            return sinc(t) * sinc(t / 2.0f);
+        }
+    }
+}
+
+float4 loadLinear(uint level, int3 coord) {
+    int3 extent = int3(pushConstants.sourceWidth, pushConstants.sourceHeight, pushConstants.sourceDepth);
+    float4 texel = mips[level][uint3(clamp(coord, int3(0, 0, 0), extent - 1))];
+    if (pushConstants.isSrgb != 0) {
+        texel.rgb = srgbToLinear(texel.rgb);
+    }
+
+    return texel;
+}
+
+
+[numthreads(THREAD_COUNT_X, THREAD_COUNT_Y, THREAD_COUNT_Z)]
+void main(uint3 coord : SV_DispatchThreadID) {
+    uint3 destinationExtent = uint3(pushConstants.destinationWidth, pushConstants.destinationHeight, pushConstants.destinationDepth);
+    if (any(coord >= destinationExtent)) {
+        return;
+    }
+
+    float3 scale = float3(pushConstants.sourceWidth, pushConstants.sourceHeight, pushConstants.sourceDepth) / float3(destinationExtent);
+    float3 center = (float3(coord) + 0.5f) * scale;
+    float3 reach = filterRadius(pushConstants.filterType) * scale;
+    int3 first = int3(floor(center - reach));
+    int3 last = int3(ceil(center + reach)) - 1;
+
+    float4 sum = 0.0f;
+    float weightSum = 0.0f;
+    [loop]
+    for (int z = first.z; z <= last.z; z++) {
+        float weightZ = axisWeight(pushConstants.filterType, z, center.z, scale.z);
+        if (weightZ == 0.0f) {
+            continue;
+        }
+
+        [loop]
+        for (int y = first.y; y <= last.y; y++) {
+            float weightYZ = weightZ * axisWeight(pushConstants.filterType, y, center.y, scale.y);
+            if (weightYZ == 0.0f) {
+                continue;
+            }
+
+            [loop]
+            for (int x = first.x; x <= last.x; x++) {
+                float weight = weightYZ * axisWeight(pushConstants.filterType, x, center.x, scale.x);
+                sum += weight * loadLinear(pushConstants.sourceLevel, int3(x, y, z));
+                weightSum += weight;
+            }
+        }
+    }
+
+    // Negative lobes of the windowed sinc filters can overshoot, so clamp the result.
+    float4 texel = saturate(sum / weightSum);
+    if (pushConstants.isSrgb != 0) {
+        texel.rgb = linearToSrgb(texel.rgb);
+    }
+
+    mips[pushConstants.sourceLevel + 1][coord] = texel;
+}
@@ -0,0 +1,30 @@
+#version 450
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 viewProj;
+} ubo;
+
+layout(push_constant) uniform PushConstants {
+    // Takes the corners of the cube from -1 to 1 to the bounds of the mesh.
+    mat4 model;
+} pushConstants;
+
+// The columns of the transform of the copy the proxy stands in for.
+layout(location = 0) in vec4 inInstanceModel0;
+layout(location = 1) in vec4 inInstanceModel1;
+layout(location = 2) in vec4 inInstanceModel2;
+layout(location = 3) in vec4 inInstanceModel3;
+
+
+void main() {
+    // The fourteen vertices of a strip around a cube, with the coordinates of each one as
+    // its bit in a mask per axis.
+    uint vertexBit = 1u << uint(gl_VertexIndex);
+    vec3 corner = vec3(
+        (0x287au & vertexBit) != 0u ? 1.0 : -1.0,
+        (0x02afu & vertexBit) != 0u ? 1.0 : -1.0,
+        (0x31e3u & vertexBit) != 0u ? 1.0 : -1.0
+    );
+    mat4 instanceModel = mat4(inInstanceModel0, inInstanceModel1, inInstanceModel2, inInstanceModel3);
+    gl_Position = ubo.viewProj * (instanceModel * (pushConstants.model * vec4(corner, 1.0)));
+}
@@ -0,0 +1,49 @@
+struct VS_Input {
+    // The columns of the transform of the copy the proxy stands in for.
+    [[vk::location(0)]] float4 instanceModel0 : TEXCOORD0;
+    [[vk::location(1)]] float4 instanceModel1 : TEXCOORD1;
+    [[vk::location(2)]] float4 instanceModel2 : TEXCOORD2;
+    [[vk::location(3)]] float4 instanceModel3 : TEXCOORD3;
+    uint vertexIndex : SV_VertexID;
+};
+
+struct VS_Output {
+    float4 position : SV_POSITION;
+};
+
+struct VS_InputConstants {
+    float4x4 viewProj;
+};
+
+struct VS_PushConstants {
+    // Takes the corners of the cube from -1 to 1 to the bounds of the mesh.
+    float4x4 model;
+};
+
+cbuffer ubo : register(b0) {
+    VS_InputConstants ubo;
+}
+
+[[vk::push_constant]] VS_PushConstants pushConstants;
+
+
+VS_Output main(VS_Input input) {
+    // The fourteen vertices of a strip around a cube, with the coordinates of each one as
+    // its bit in a mask per axis.
+    uint vertexBit = 1u << input.vertexIndex;
+    float3 corner = float3(
+        (0x287a & vertexBit) != 0 ? 1.0f : -1.0f,
+        (0x02af & vertexBit) != 0 ? 1.0f : -1.0f,
+        (0x31e3 & vertexBit) != 0 ? 1.0f : -1.0f
+    );
+    float4 meshPosition = mul(pushConstants.model, float4(corner, 1.0f));
+    float4 worldPosition = input.instanceModel0 * meshPosition.x
+        + input.instanceModel1 * meshPosition.y
+        + input.instanceModel2 * meshPosition.z
+        + input.instanceModel3 * meshPosition.w;
+
+    VS_Output output;
+    output.position = mul(ubo.viewProj, worldPosition);
+
+    return output;
+}
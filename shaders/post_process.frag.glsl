@@ -0,0 +1,134 @@
+#version 450
+
+// How the color is encoded for the swap chain, as `OutputEncoding`, and the nits the
+// scene's white is shown at on HDR formats, like the constants of `shader.frag.glsl`.
+layout(constant_id = 0) const uint OUTPUT_ENCODING = 0;
+layout(constant_id = 1) const float PAPER_WHITE_NITS = 200.0;
+// Whether the bloom is added, and whether the exposure follows the average luminance of
+// the scene.
+layout(constant_id = 2) const bool BLOOM = false;
+layout(constant_id = 3) const bool AUTO_EXPOSURE = false;
+
+const uint OUTPUT_ENCODING_NONE = 0;
+const uint OUTPUT_ENCODING_SRGB = 1;
+const uint OUTPUT_ENCODING_PQ = 2;
+const uint OUTPUT_ENCODING_SCRGB = 3;
+
+// The linear scene color the first subpass wrote, read at the fragment's own pixel so it
+// never leaves the tile.
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput sceneColor;
+// The bloom and the log average luminance a compute pass built from the scene color of
+// the frame before, each only bound when it is used.
+layout(set = 0, binding = 1) uniform texture2D bloom;
+layout(set = 0, binding = 2) uniform texture2D averageLogLuminance;
+layout(set = 0, binding = 3) uniform sampler bloomSampler;
+
+layout(push_constant) uniform PushConstants {
+    // The scale of the scene color before it is tone mapped. With auto exposure, it
+    // scales the one that brings the average luminance to middle grey instead.
+    float exposure;
+    // The power the color is raised to around middle grey.
+    float contrast;
+    // How far the color is from its luminance, with zero for greyscale.
+    float saturation;
+    // How far the color moves toward the bloom.
+    float bloomIntensity;
+    // One over the size of the scene color, to sample the bloom at the fragment with.
+    vec2 inverseExtent;
+    // The levels of the chain the bloom sums.
+    uint bloomLevelCount;
+} pushConstants;
+
+layout(location = 0) out vec4 outColor;
+
+const float MIDDLE_GREY = 0.18;
+
+// The exposure pushed, scaled to bring the average luminance to middle grey with auto
+// exposure, within five stops either way so a black or blown out frame stays usable.
+float getExposure() {
+    if (!AUTO_EXPOSURE) {
+        return pushConstants.exposure;
+    }
+
+    float averageLuminance = exp(texelFetch(averageLogLuminance, ivec2(0, 0), 0).r);
+
+    return pushConstants.exposure * clamp(MIDDLE_GREY / averageLuminance, 1.0 / 32.0, 32.0);
+}
+
+// The color moved toward the bloom at the fragment, which sums every level of the chain.
+vec3 addBloom(vec3 color, vec2 position) {
+    if (!BLOOM) {
+        return color;
+    }
+
+    vec2 uv = position * pushConstants.inverseExtent;
+    vec3 bloomColor = textureLod(sampler2D(bloom, bloomSampler), uv, 0.0).rgb / float(pushConstants.bloomLevelCount);
+
+    return mix(color, bloomColor, pushConstants.bloomIntensity);
+}
+
+// The extended Reinhard curve with its white point at the exposure, so the scene's white
+// stays white and an exposure of one leaves the color as it is.
+vec3 toneMap(vec3 color) {
+    float exposure = getExposure();
+    float whitePoint = exposure;
+    vec3 exposed = color * exposure;
+
+    return exposed * (1.0 + exposed / (whitePoint * whitePoint)) / (1.0 + exposed);
+}
+
+vec3 grade(vec3 color) {
+    vec3 contrasted = MIDDLE_GREY * pow(max(color, 0.0) / MIDDLE_GREY, vec3(pushConstants.contrast));
+    float luminance = dot(contrasted, vec3(0.2126, 0.7152, 0.0722));
+
+    return max(mix(vec3(luminance), contrasted, pushConstants.saturation), 0.0);
+}
+
+// The sRGB transfer function, for UNORM formats the hardware does not encode.
+vec3 encodeSrgb(vec3 color) {
+    vec3 clampedColor = clamp(color, 0.0, 1.0);
+    vec3 lower = clampedColor * 12.92;
+    vec3 upper = 1.055 * pow(clampedColor, vec3(1.0 / 2.4)) - 0.055;
+
+    return mix(upper, lower, lessThanEqual(clampedColor, vec3(0.0031308)));
+}
+
+// The ST 2084 perceptual quantizer of HDR10, of the color moved into BT.2020 primaries,
+// with 1.0 at the paper white.
+vec3 encodePq(vec3 color) {
+    // Column major, so every row here is a column of the matrix.
+    const mat3 BT709_TO_BT2020 = mat3(
+        0.6274, 0.0691, 0.0164,
+        0.3293, 0.9195, 0.0880,
+        0.0433, 0.0114, 0.8956
+    );
+    const float M1 = 0.1593017578125;
+    const float M2 = 78.84375;
+    const float C1 = 0.8359375;
+    const float C2 = 18.8515625;
+    const float C3 = 18.6875;
+
+    vec3 luminance = clamp(BT709_TO_BT2020 * max(color, 0.0) * (PAPER_WHITE_NITS / 10000.0), 0.0, 1.0);
+    vec3 power = pow(luminance, vec3(M1));
+
+    return pow((C1 + C2 * power) / (1.0 + C3 * power), vec3(M2));
+}
+
+vec3 encodeOutput(vec3 color) {
+    if (OUTPUT_ENCODING == OUTPUT_ENCODING_SRGB) {
+        return encodeSrgb(color);
+    } else if (OUTPUT_ENCODING == OUTPUT_ENCODING_PQ) {
+        return encodePq(color);
+    } else if (OUTPUT_ENCODING == OUTPUT_ENCODING_SCRGB) {
+        // scRGB is linear, with 1.0 at 80 nits.
+        return color * (PAPER_WHITE_NITS / 80.0);
+    }
+
+    return color;
+}
+
+void main() {
+    vec4 color = subpassLoad(sceneColor);
+    vec3 bloomed = addBloom(color.rgb, gl_FragCoord.xy);
+    outColor = vec4(encodeOutput(grade(toneMap(bloomed))), color.a);
+}
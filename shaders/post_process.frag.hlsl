@@ -0,0 +1,144 @@
+// How the color is encoded for the swap chain, as `OutputEncoding`, and the nits the
+// scene's white is shown at on HDR formats, like the constants of `shader.frag.hlsl`.
+[[vk::constant_id(0)]] const uint OUTPUT_ENCODING = 0;
+[[vk::constant_id(1)]] const float PAPER_WHITE_NITS = 200.0f;
+// Whether the bloom is added, and whether the exposure follows the average luminance of
+// the scene.
+[[vk::constant_id(2)]] const bool BLOOM = false;
+[[vk::constant_id(3)]] const bool AUTO_EXPOSURE = false;
+
+#define OUTPUT_ENCODING_NONE 0
+#define OUTPUT_ENCODING_SRGB 1
+#define OUTPUT_ENCODING_PQ 2
+#define OUTPUT_ENCODING_SCRGB 3
+
+// The linear scene color the first subpass wrote, read at the fragment's own pixel so it
+// never leaves the tile.
+[[vk::input_attachment_index(0)]] [[vk::binding(0, 0)]] SubpassInput<float4> sceneColor;
+// The bloom and the log average luminance a compute pass built from the scene color of
+// the frame before, each only bound when it is used.
+[[vk::binding(1, 0)]] Texture2D<float4> bloom;
+[[vk::binding(2, 0)]] Texture2D<float> averageLogLuminance;
+[[vk::binding(3, 0)]] SamplerState bloomSampler;
+
+struct PS_PushConstants {
+    // The scale of the scene color before it is tone mapped. With auto exposure, it
+    // scales the one that brings the average luminance to middle grey instead.
+    float exposure;
+    // The power the color is raised to around middle grey.
+    float contrast;
+    // How far the color is from its luminance, with zero for greyscale.
+    float saturation;
+    // How far the color moves toward the bloom.
+    float bloomIntensity;
+    // One over the size of the scene color, to sample the bloom at the fragment with.
+    float2 inverseExtent;
+    // The levels of the chain the bloom sums.
+    uint bloomLevelCount;
+};
+
+[[vk::push_constant]] PS_PushConstants pushConstants;
+
+struct PS_Input {
+    float4 position : SV_POSITION;
+};
+
+struct PS_Output {
+    float4 outColor : SV_TARGET0;
+};
+
+
+static const float MIDDLE_GREY = 0.18f;
+
+// The exposure pushed, scaled to bring the average luminance to middle grey with auto
+// exposure, within five stops either way so a black or blown out frame stays usable.
+float getExposure() {
+    if (!AUTO_EXPOSURE) {
+        return pushConstants.exposure;
+    }
+
+    float averageLuminance = exp(averageLogLuminance.Load(int3(0, 0, 0)));
+
+    return pushConstants.exposure * clamp(MIDDLE_GREY / averageLuminance, 1.0f / 32.0f, 32.0f);
+}
+
+// The color moved toward the bloom at the fragment, which sums every level of the chain.
+float3 addBloom(float3 color, float2 position) {
+    if (!BLOOM) {
+        return color;
+    }
+
+    float2 uv = position * pushConstants.inverseExtent;
+    float3 bloomColor = bloom.SampleLevel(bloomSampler, uv, 0.0f).rgb / float(pushConstants.bloomLevelCount);
+
+    return lerp(color, bloomColor, pushConstants.bloomIntensity);
+}
+
+// The extended Reinhard curve with its white point at the exposure, so the scene's white
+// stays white and an exposure of one leaves the color as it is.
+float3 toneMap(float3 color) {
+    float exposure = getExposure();
+    float whitePoint = exposure;
+    float3 exposed = color * exposure;
+
+    return exposed * (1.0f + exposed / (whitePoint * whitePoint)) / (1.0f + exposed);
+}
+
+float3 grade(float3 color) {
+    float3 contrasted = MIDDLE_GREY * pow(max(color, 0.0f) / MIDDLE_GREY, pushConstants.contrast);
+    float luminance = dot(contrasted, float3(0.2126f, 0.7152f, 0.0722f));
+
+    return max(lerp(luminance.xxx, contrasted, pushConstants.saturation), 0.0f);
+}
+
+// The sRGB transfer function, for UNORM formats the hardware does not encode.
+float3 encodeSrgb(float3 color) {
+    float3 clampedColor = saturate(color);
+    float3 lower = clampedColor * 12.92f;
+    float3 upper = 1.055f * pow(clampedColor, 1.0f / 2.4f) - 0.055f;
+
+    return select(clampedColor <= 0.0031308f, lower, upper);
+}
+
+// The ST 2084 perceptual quantizer of HDR10, of the color moved into BT.2020 primaries,
+// with 1.0 at the paper white.
+float3 encodePq(float3 color) {
+    static const float3x3 BT709_TO_BT2020 = float3x3(
+        0.6274f, 0.3293f, 0.0433f,
+        0.0691f, 0.9195f, 0.0114f,
+        0.0164f, 0.0880f, 0.8956f
+    );
+    static const float M1 = 0.1593017578125f;
+    static const float M2 = 78.84375f;
+    static const float C1 = 0.8359375f;
+    static const float C2 = 18.8515625f;
+    static const float C3 = 18.6875f;
+
+    float3 luminance = saturate(mul(BT709_TO_BT2020, max(color, 0.0f)) * (PAPER_WHITE_NITS / 10000.0f));
+    float3 power = pow(luminance, M1);
+
+    return pow((C1 + C2 * power) / (1.0f + C3 * power), M2);
+}
+
+float3 encodeOutput(float3 color) {
+    if (OUTPUT_ENCODING == OUTPUT_ENCODING_SRGB) {
+        return encodeSrgb(color);
+    } else if (OUTPUT_ENCODING == OUTPUT_ENCODING_PQ) {
+        return encodePq(color);
+    } else if (OUTPUT_ENCODING == OUTPUT_ENCODING_SCRGB) {
+        // scRGB is linear, with 1.0 at 80 nits.
+        return color * (PAPER_WHITE_NITS / 80.0f);
+    }
+
+    return color;
+}
+
+PS_Output main(PS_Input input) {
+    float4 color = sceneColor.SubpassLoad();
+
+    PS_Output output;
+    float3 bloomed = addBloom(color.rgb, input.position.xy);
+    output.outColor = float4(encodeOutput(grade(toneMap(bloomed))), color.a);
+
+    return output;
+}
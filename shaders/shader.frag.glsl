@@ -1,12 +1,252 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout(binding = 1) uniform sampler2D texSampler;
+// The global texture table, which holds only as many textures as the scene has, in a set
+// of its own.
+layout(set = 1, binding = 0) uniform sampler2D textures[];
 
-layout(location = 0) in vec3 fragColor;
-layout(location = 1) in vec2 fragTexCoord;
+layout(binding = 0) uniform UniformBufferObject {
+    // Past the matrices and camera position the vertex, task, and mesh shaders and the draw
+    // culler read. It follows the scale of dynamic resolution.
+    layout(offset = 144) float lodBias;
+    // The pixel of every LOD feedback tile that writes its level this frame.
+    uint lodFeedbackPhase;
+} ubo;
+
+// The most detailed level the frame sampled every texture of the table at, which the
+// texture streamer reads back.
+layout(binding = 1) buffer LodFeedback {
+    uint requestedLevels[];
+} lodFeedback;
+
+// The page table of the virtual texture, which `VirtualTexture` lays out, and the most
+// detailed level the frame sampled every page of it at, an entry to a page at the same
+// index as the page table.
+layout(binding = 2) readonly buffer VirtualPageTable {
+    uint entries[];
+} virtualPageTable;
+
+layout(binding = 3) buffer VirtualPageFeedback {
+    uint requestedLevels[];
+} virtualPageFeedback;
+
+// The permutation of the shader, which the pipeline fixes with specialization constants
+// laid out like `FragmentSpecialization`, so the branches on them fold away.
+layout(constant_id = 0) const bool SHOW_MIP_LEVELS = false;
+layout(constant_id = 1) const bool ALPHA_TEST = false;
+layout(constant_id = 2) const float ALPHA_CUTOFF = 0.5;
+layout(constant_id = 3) const float LOD_BIAS = 0.0;
+// How the color is encoded for the swap chain, as `OutputEncoding`, and the nits the
+// scene's white is shown at on HDR formats.
+layout(constant_id = 4) const uint OUTPUT_ENCODING = 0;
+layout(constant_id = 5) const float PAPER_WHITE_NITS = 200.0;
+// Whether one fragment of every tile of `LOD_FEEDBACK_TILE_SIZE` pixels a side writes the
+// level it samples.
+layout(constant_id = 6) const bool LOD_FEEDBACK = false;
+layout(constant_id = 7) const uint LOD_FEEDBACK_TILE_SIZE = 4;
+// Whether the entry of the model's texture in the table is the atlas of a virtual texture.
+layout(constant_id = 8) const bool VIRTUAL_TEXTURE = false;
+
+const uint OUTPUT_ENCODING_NONE = 0;
+const uint OUTPUT_ENCODING_SRGB = 1;
+const uint OUTPUT_ENCODING_PQ = 2;
+const uint OUTPUT_ENCODING_SCRGB = 3;
+
+const int MIP_LEVEL_COLOR_COUNT = 6;
+
+// The pages of the virtual texture, as `VirtualTexture` cuts them, and the entries of its
+// page table before the two of every level.
+const uint VIRTUAL_TILE_SIZE = 128;
+const uint VIRTUAL_TILE_BORDER = 4;
+const uint VIRTUAL_ATLAS_TILE_SIZE = VIRTUAL_TILE_SIZE + 2 * VIRTUAL_TILE_BORDER;
+const uint VIRTUAL_HEADER_SIZE = 4;
+const uint VIRTUAL_TEXTURE_INDEX = 0;
+
+// The colors levels 0 to 5 are shown in, with the levels between them blended, and every
+// level past the last one shown like it.
+const vec3 MIP_LEVEL_COLORS[MIP_LEVEL_COLOR_COUNT] = vec3[](
+    vec3(1.0, 0.0, 0.0),
+    vec3(1.0, 0.5, 0.0),
+    vec3(1.0, 1.0, 0.0),
+    vec3(0.0, 1.0, 0.0),
+    vec3(0.0, 1.0, 1.0),
+    vec3(0.0, 0.0, 1.0)
+);
+
+layout(location = 0) in vec2 fragTexCoord;
+// The entry of the material of the copy in the texture table, which the vertex or mesh
+// shader picks.
+layout(location = 1) flat in uint fragTextureIndex;
 
 layout(location = 0) out vec4 outColor;
 
+vec3 getMipLevelColor(float level) {
+    float clampedLevel = clamp(level, 0.0, float(MIP_LEVEL_COLOR_COUNT - 1));
+    int lowerLevel = int(floor(clampedLevel));
+    int upperLevel = min(lowerLevel + 1, MIP_LEVEL_COLOR_COUNT - 1);
+
+    return mix(MIP_LEVEL_COLORS[lowerLevel], MIP_LEVEL_COLORS[upperLevel], clampedLevel - float(lowerLevel));
+}
+
+// The sRGB transfer function, for UNORM formats the hardware does not encode.
+vec3 encodeSrgb(vec3 color) {
+    vec3 clampedColor = clamp(color, 0.0, 1.0);
+    vec3 lower = clampedColor * 12.92;
+    vec3 upper = 1.055 * pow(clampedColor, vec3(1.0 / 2.4)) - 0.055;
+
+    return mix(upper, lower, lessThanEqual(clampedColor, vec3(0.0031308)));
+}
+
+// The ST 2084 perceptual quantizer of HDR10, of the color moved into BT.2020 primaries,
+// with 1.0 at the paper white.
+vec3 encodePq(vec3 color) {
+    // Column major, so every row here is a column of the matrix.
+    const mat3 BT709_TO_BT2020 = mat3(
+        0.6274, 0.0691, 0.0164,
+        0.3293, 0.9195, 0.0880,
+        0.0433, 0.0114, 0.8956
+    );
+    const float M1 = 0.1593017578125;
+    const float M2 = 78.84375;
+    const float C1 = 0.8359375;
+    const float C2 = 18.8515625;
+    const float C3 = 18.6875;
+
+    vec3 luminance = clamp(BT709_TO_BT2020 * max(color, 0.0) * (PAPER_WHITE_NITS / 10000.0), 0.0, 1.0);
+    vec3 power = pow(luminance, vec3(M1));
+
+    return pow((C1 + C2 * power) / (1.0 + C3 * power), vec3(M2));
+}
+
+// Take the level with the bias the texture is sampled with, before the sampler clamps it to
+// the levels that are resident, into the minimum of the texture. Fragments hidden behind
+// others may write as well, which only asks for more detail than is seen.
+void writeLodFeedback(uint textureIndex, float lodBias) {
+    uvec2 tilePixel = uvec2(gl_FragCoord.xy) % LOD_FEEDBACK_TILE_SIZE;
+    if (tilePixel.y * LOD_FEEDBACK_TILE_SIZE + tilePixel.x != ubo.lodFeedbackPhase) {
+        return;
+    }
+
+    float level = textureQueryLod(textures[textureIndex], fragTexCoord).y + lodBias;
+    atomicMin(lodFeedback.requestedLevels[textureIndex], uint(max(floor(level), 0.0)));
+}
+
+uvec2 getVirtualLevelSize(uint level) {
+    uvec2 size = uvec2(virtualPageTable.entries[0], virtualPageTable.entries[1]);
+
+    return max(size >> level, uvec2(1));
+}
+
+// The page of `level` that covers `uv`, among the pages of the level.
+uvec2 getVirtualPageCoord(uint level, vec2 uv) {
+    uvec2 levelSize = getVirtualLevelSize(level);
+    uint pagesPerRow = virtualPageTable.entries[VIRTUAL_HEADER_SIZE + 2 * level + 1];
+    uint pageRowCount = (levelSize.y + VIRTUAL_TILE_SIZE - 1) / VIRTUAL_TILE_SIZE;
+
+    return min(uvec2(uv * vec2(levelSize)) / VIRTUAL_TILE_SIZE, uvec2(pagesPerRow, pageRowCount) - 1);
+}
+
+// The index of the entry of the page of `level` that covers `uv`, in the page table and
+// the feedback alike.
+uint getVirtualPage(uint level, vec2 uv) {
+    uint firstEntry = virtualPageTable.entries[VIRTUAL_HEADER_SIZE + 2 * level];
+    uint pagesPerRow = virtualPageTable.entries[VIRTUAL_HEADER_SIZE + 2 * level + 1];
+    uvec2 page = getVirtualPageCoord(level, uv);
+
+    return firstEntry + page.y * pagesPerRow + page.x;
+}
+
+// Sample `level` of the virtual texture bilinearly, from the tile its page table entry
+// points at, which holds the page itself or the nearest less detailed one that covers it.
+vec4 sampleVirtualLevel(uint level, vec2 uv, out uint residentLevel) {
+    uint entry = virtualPageTable.entries[getVirtualPage(level, uv)];
+    uint tile = entry & 0xFFFF;
+    residentLevel = entry >> 16;
+
+    vec2 texel = uv * vec2(getVirtualLevelSize(residentLevel));
+    vec2 pageOrigin = vec2(getVirtualPageCoord(residentLevel, uv) * VIRTUAL_TILE_SIZE);
+    uint atlasTilesPerRow = virtualPageTable.entries[3];
+    vec2 tileOrigin = vec2(uvec2(tile % atlasTilesPerRow, tile / atlasTilesPerRow) * VIRTUAL_ATLAS_TILE_SIZE);
+    vec2 atlasTexel = tileOrigin + float(VIRTUAL_TILE_BORDER) + texel - pageOrigin;
+
+    return textureLod(textures[VIRTUAL_TEXTURE_INDEX], atlasTexel / float(atlasTilesPerRow * VIRTUAL_ATLAS_TILE_SIZE), 0.0);
+}
+
+// Sample the virtual texture trilinearly, with the level worked out from the derivatives
+// of the texels of its first level, since the atlas has a single level the sampler could
+// pick from. The level that was asked for and the most detailed one that was sampled
+// return in `level` and `residentLevel`.
+vec4 sampleVirtualTexture(vec2 texCoord, float lodBias, out float level, out float residentLevel) {
+    uint levelCount = virtualPageTable.entries[2];
+    vec2 texel = texCoord * vec2(getVirtualLevelSize(0));
+    float lod = log2(max(length(dFdx(texel)), length(dFdy(texel)))) + lodBias;
+    level = clamp(lod, 0.0, float(levelCount - 1));
+
+    // The tiles repeat the texels past the edges of their level, like the sampler of any
+    // other texture of the table.
+    vec2 uv = fract(texCoord);
+    uint lowerLevel = uint(level);
+    uint upperLevel = min(lowerLevel + 1, levelCount - 1);
+    uint lowerResidentLevel;
+    uint upperResidentLevel;
+    vec4 lower = sampleVirtualLevel(lowerLevel, uv, lowerResidentLevel);
+    vec4 upper = sampleVirtualLevel(upperLevel, uv, upperResidentLevel);
+    residentLevel = max(level, float(lowerResidentLevel));
+
+    return mix(lower, upper, level - float(lowerLevel));
+}
+
+// Take the level the virtual texture is sampled at into the minimum of the page that
+// covers the fragment, so `VirtualTexture` uploads it if it is missing.
+void writeVirtualPageFeedback(float level) {
+    uvec2 tilePixel = uvec2(gl_FragCoord.xy) % LOD_FEEDBACK_TILE_SIZE;
+    if (tilePixel.y * LOD_FEEDBACK_TILE_SIZE + tilePixel.x != ubo.lodFeedbackPhase) {
+        return;
+    }
+
+    uint requestedLevel = uint(level);
+    atomicMin(virtualPageFeedback.requestedLevels[getVirtualPage(requestedLevel, fract(fragTexCoord))], requestedLevel);
+}
+
+vec3 encodeOutput(vec3 color) {
+    if (OUTPUT_ENCODING == OUTPUT_ENCODING_SRGB) {
+        return encodeSrgb(color);
+    } else if (OUTPUT_ENCODING == OUTPUT_ENCODING_PQ) {
+        return encodePq(color);
+    } else if (OUTPUT_ENCODING == OUTPUT_ENCODING_SCRGB) {
+        // scRGB is linear, with 1.0 at 80 nits.
+        return color * (PAPER_WHITE_NITS / 80.0);
+    }
+
+    return color;
+}
+
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
+    // Every fragment of a draw samples the same texture, since a draw of more copies than
+    // one only ever has one material, so the index is uniform.
+    float lodBias = LOD_BIAS + ubo.lodBias;
+    bool isVirtual = VIRTUAL_TEXTURE && fragTextureIndex == VIRTUAL_TEXTURE_INDEX;
+    float virtualLevel = 0.0;
+    float virtualResidentLevel = 0.0;
+    if (isVirtual) {
+        outColor = sampleVirtualTexture(fragTexCoord, lodBias, virtualLevel, virtualResidentLevel);
+    } else {
+        outColor = texture(textures[fragTextureIndex], fragTexCoord, lodBias);
+    }
+    if (ALPHA_TEST && outColor.a < ALPHA_CUTOFF) {
+        discard;
+    }
+
+    if (isVirtual) {
+        writeVirtualPageFeedback(virtualLevel);
+    } else if (LOD_FEEDBACK) {
+        writeLodFeedback(fragTextureIndex, lodBias);
+    }
+
+    if (SHOW_MIP_LEVELS) {
+        float level = isVirtual ? virtualResidentLevel : textureQueryLod(textures[fragTextureIndex], fragTexCoord).x + lodBias;
+        outColor = vec4(getMipLevelColor(level), 1.0);
+    }
+
+    outColor = vec4(encodeOutput(outColor.rgb), outColor.a);
 }
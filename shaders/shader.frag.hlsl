@@ -1,10 +1,79 @@
-Texture2D<float4> texSampler : register(t1, space0);
-SamplerState texSamplerState : register(s1, space0);
+// The global texture table, which holds only as many textures as the scene has, in a set
+// of its own.
+Texture2D<float4> textures[] : register(t0, space1);
+SamplerState textureSamplers[] : register(s0, space1);
+
+// The permutation of the shader, which the pipeline fixes with specialization constants
+// laid out like `FragmentSpecialization`, so the branches on them fold away.
+[[vk::constant_id(0)]] const bool SHOW_MIP_LEVELS = false;
+[[vk::constant_id(1)]] const bool ALPHA_TEST = false;
+[[vk::constant_id(2)]] const float ALPHA_CUTOFF = 0.5f;
+[[vk::constant_id(3)]] const float LOD_BIAS = 0.0f;
+// How the color is encoded for the swap chain, as `OutputEncoding`, and the nits the
+// scene's white is shown at on HDR formats.
+[[vk::constant_id(4)]] const uint OUTPUT_ENCODING = 0;
+[[vk::constant_id(5)]] const float PAPER_WHITE_NITS = 200.0f;
+// Whether one fragment of every tile of `LOD_FEEDBACK_TILE_SIZE` pixels a side writes the
+// level it samples.
+[[vk::constant_id(6)]] const bool LOD_FEEDBACK = false;
+[[vk::constant_id(7)]] const uint LOD_FEEDBACK_TILE_SIZE = 4;
+// Whether the entry of the model's texture in the table is the atlas of a virtual texture.
+[[vk::constant_id(8)]] const bool VIRTUAL_TEXTURE = false;
+
+#define OUTPUT_ENCODING_NONE 0
+#define OUTPUT_ENCODING_SRGB 1
+#define OUTPUT_ENCODING_PQ 2
+#define OUTPUT_ENCODING_SCRGB 3
+
+#define MIP_LEVEL_COLOR_COUNT 6
+
+// The pages of the virtual texture, as `VirtualTexture` cuts them, and the entries of its
+// page table before the two of every level.
+#define VIRTUAL_TILE_SIZE 128u
+#define VIRTUAL_TILE_BORDER 4u
+#define VIRTUAL_ATLAS_TILE_SIZE (VIRTUAL_TILE_SIZE + 2u * VIRTUAL_TILE_BORDER)
+#define VIRTUAL_HEADER_SIZE 4u
+#define VIRTUAL_TEXTURE_INDEX 0u
+
+// The colors levels 0 to 5 are shown in, with the levels between them blended, and every
+// level past the last one shown like it.
+static const float3 MIP_LEVEL_COLORS[MIP_LEVEL_COLOR_COUNT] = {
+    float3(1.0f, 0.0f, 0.0f),
+    float3(1.0f, 0.5f, 0.0f),
+    float3(1.0f, 1.0f, 0.0f),
+    float3(0.0f, 1.0f, 0.0f),
+    float3(0.0f, 1.0f, 1.0f),
+    float3(0.0f, 0.0f, 1.0f),
+};
+
+struct PS_InputConstants {
+    // Past the matrices and camera position the vertex, task, and mesh shaders and the draw
+    // culler read. It follows the scale of dynamic resolution.
+    [[vk::offset(144)]] float lodBias;
+    // The pixel of every LOD feedback tile that writes its level this frame.
+    uint lodFeedbackPhase;
+};
+
+cbuffer ubo : register(b0) {
+    PS_InputConstants ubo;
+}
+
+// The most detailed level the frame sampled every texture of the table at, which the
+// texture streamer reads back.
+[[vk::binding(1, 0)]] RWStructuredBuffer<uint> lodFeedback;
+
+// The page table of the virtual texture, which `VirtualTexture` lays out, and the most
+// detailed level the frame sampled every page of it at, an entry to a page at the same
+// index as the page table.
+[[vk::binding(2, 0)]] StructuredBuffer<uint> virtualPageTable;
+[[vk::binding(3, 0)]] RWStructuredBuffer<uint> virtualPageFeedback;
 
 struct PS_Input {
     float4 position : SV_POSITION;
-    float3 fragColor : TEXCOORD0;
-    float2 fragTexCoord: TEXCOORD1;
+    float2 fragTexCoord: TEXCOORD0;
+    // The entry of the material of the copy in the texture table, which the vertex or mesh
+    // shader picks.
+    nointerpolation uint fragTextureIndex : TEXCOORD1;
 };
 
 struct PS_Output {
@@ -12,11 +81,183 @@ struct PS_Output {
 };
 
 
+float3 getMipLevelColor(float level) {
+    float clampedLevel = clamp(level, 0.0f, float(MIP_LEVEL_COLOR_COUNT - 1));
+    uint lowerLevel = uint(floor(clampedLevel));
+    uint upperLevel = min(lowerLevel + 1u, uint(MIP_LEVEL_COLOR_COUNT - 1));
+
+    return lerp(MIP_LEVEL_COLORS[lowerLevel], MIP_LEVEL_COLORS[upperLevel], clampedLevel - float(lowerLevel));
+}
+
+// The sRGB transfer function, for UNORM formats the hardware does not encode.
+float3 encodeSrgb(float3 color) {
+    float3 clampedColor = saturate(color);
+    float3 lower = clampedColor * 12.92f;
+    float3 upper = 1.055f * pow(clampedColor, 1.0f / 2.4f) - 0.055f;
+
+    return select(clampedColor <= 0.0031308f, lower, upper);
+}
+
+// The ST 2084 perceptual quantizer of HDR10, of the color moved into BT.2020 primaries,
+// with 1.0 at the paper white.
+float3 encodePq(float3 color) {
+    static const float3x3 BT709_TO_BT2020 = float3x3(
+        0.6274f, 0.3293f, 0.0433f,
+        0.0691f, 0.9195f, 0.0114f,
+        0.0164f, 0.0880f, 0.8956f
+    );
+    static const float M1 = 0.1593017578125f;
+    static const float M2 = 78.84375f;
+    static const float C1 = 0.8359375f;
+    static const float C2 = 18.8515625f;
+    static const float C3 = 18.6875f;
+
+    float3 luminance = saturate(mul(BT709_TO_BT2020, max(color, 0.0f)) * (PAPER_WHITE_NITS / 10000.0f));
+    float3 power = pow(luminance, M1);
+
+    return pow((C1 + C2 * power) / (1.0f + C3 * power), M2);
+}
+
+// Take the level with the bias the texture is sampled with, before the sampler clamps it to
+// the levels that are resident, into the minimum of the texture. Fragments hidden behind
+// others may write as well, which only asks for more detail than is seen.
+void writeLodFeedback(uint textureIndex, float2 fragCoord, float2 texCoord, float lodBias) {
+    uint2 tilePixel = uint2(fragCoord) % LOD_FEEDBACK_TILE_SIZE;
+    if (tilePixel.y * LOD_FEEDBACK_TILE_SIZE + tilePixel.x != ubo.lodFeedbackPhase) {
+        return;
+    }
+
+    float level = textures[textureIndex].CalculateLevelOfDetailUnclamped(textureSamplers[textureIndex], texCoord) + lodBias;
+    InterlockedMin(lodFeedback[textureIndex], uint(max(floor(level), 0.0f)));
+}
+
+uint2 getVirtualLevelSize(uint level) {
+    uint2 size = uint2(virtualPageTable[0], virtualPageTable[1]);
+
+    return max(size >> level, uint2(1, 1));
+}
+
+// The page of `level` that covers `uv`, among the pages of the level.
+uint2 getVirtualPageCoord(uint level, float2 uv) {
+    uint2 levelSize = getVirtualLevelSize(level);
+    uint pagesPerRow = virtualPageTable[VIRTUAL_HEADER_SIZE + 2u * level + 1u];
+    uint pageRowCount = (levelSize.y + VIRTUAL_TILE_SIZE - 1u) / VIRTUAL_TILE_SIZE;
+
+    return min(uint2(uv * float2(levelSize)) / VIRTUAL_TILE_SIZE, uint2(pagesPerRow, pageRowCount) - 1u);
+}
+
+// The index of the entry of the page of `level` that covers `uv`, in the page table and
+// the feedback alike.
+uint getVirtualPage(uint level, float2 uv) {
+    uint firstEntry = virtualPageTable[VIRTUAL_HEADER_SIZE + 2u * level];
+    uint pagesPerRow = virtualPageTable[VIRTUAL_HEADER_SIZE + 2u * level + 1u];
+    uint2 page = getVirtualPageCoord(level, uv);
+
+    return firstEntry + page.y * pagesPerRow + page.x;
+}
+
+// Sample `level` of the virtual texture bilinearly, from the tile its page table entry
+// points at, which holds the page itself or the nearest less detailed one that covers it.
+float4 sampleVirtualLevel(uint level, float2 uv, out uint residentLevel) {
+    uint entry = virtualPageTable[getVirtualPage(level, uv)];
+    uint tile = entry & 0xFFFFu;
+    residentLevel = entry >> 16;
+
+    float2 texel = uv * float2(getVirtualLevelSize(residentLevel));
+    float2 pageOrigin = float2(getVirtualPageCoord(residentLevel, uv) * VIRTUAL_TILE_SIZE);
+    uint atlasTilesPerRow = virtualPageTable[3];
+    float2 tileOrigin = float2(uint2(tile % atlasTilesPerRow, tile / atlasTilesPerRow) * VIRTUAL_ATLAS_TILE_SIZE);
+    float2 atlasTexel = tileOrigin + float(VIRTUAL_TILE_BORDER) + texel - pageOrigin;
+
+    return textures[VIRTUAL_TEXTURE_INDEX].SampleLevel(
+        textureSamplers[VIRTUAL_TEXTURE_INDEX],
+        atlasTexel / float(atlasTilesPerRow * VIRTUAL_ATLAS_TILE_SIZE),
+        0.0f
+    );
+}
+
+// Sample the virtual texture trilinearly, with the level worked out from the derivatives
+// of the texels of its first level, since the atlas has a single level the sampler could
+// pick from. The level that was asked for and the most detailed one that was sampled
+// return in `level` and `residentLevel`.
+float4 sampleVirtualTexture(float2 texCoord, float lodBias, out float level, out float residentLevel) {
+    uint levelCount = virtualPageTable[2];
+    float2 texel = texCoord * float2(getVirtualLevelSize(0));
+    float lod = log2(max(length(ddx(texel)), length(ddy(texel)))) + lodBias;
+    level = clamp(lod, 0.0f, float(levelCount - 1u));
+
+    // The tiles repeat the texels past the edges of their level, like the sampler of any
+    // other texture of the table.
+    float2 uv = frac(texCoord);
+    uint lowerLevel = uint(level);
+    uint upperLevel = min(lowerLevel + 1u, levelCount - 1u);
+    uint lowerResidentLevel;
+    uint upperResidentLevel;
+    float4 lower = sampleVirtualLevel(lowerLevel, uv, lowerResidentLevel);
+    float4 upper = sampleVirtualLevel(upperLevel, uv, upperResidentLevel);
+    residentLevel = max(level, float(lowerResidentLevel));
+
+    return lerp(lower, upper, level - float(lowerLevel));
+}
+
+// Take the level the virtual texture is sampled at into the minimum of the page that
+// covers the fragment, so `VirtualTexture` uploads it if it is missing.
+void writeVirtualPageFeedback(float2 fragCoord, float2 texCoord, float level) {
+    uint2 tilePixel = uint2(fragCoord) % LOD_FEEDBACK_TILE_SIZE;
+    if (tilePixel.y * LOD_FEEDBACK_TILE_SIZE + tilePixel.x != ubo.lodFeedbackPhase) {
+        return;
+    }
+
+    uint requestedLevel = uint(level);
+    InterlockedMin(virtualPageFeedback[getVirtualPage(requestedLevel, frac(texCoord))], requestedLevel);
+}
+
+float3 encodeOutput(float3 color) {
+    if (OUTPUT_ENCODING == OUTPUT_ENCODING_SRGB) {
+        return encodeSrgb(color);
+    } else if (OUTPUT_ENCODING == OUTPUT_ENCODING_PQ) {
+        return encodePq(color);
+    } else if (OUTPUT_ENCODING == OUTPUT_ENCODING_SCRGB) {
+        // scRGB is linear, with 1.0 at 80 nits.
+        return color * (PAPER_WHITE_NITS / 80.0f);
+    }
+
+    return color;
+}
+
 PS_Output main(PS_Input input) {    
-    float4 outFragColor = texSampler.Sample(texSamplerState, input.fragTexCoord);
+    // Every fragment of a draw samples the same texture, since a draw of more copies than
+    // one only ever has one material, so the index is uniform.
+    uint textureIndex = input.fragTextureIndex;
+    float lodBias = LOD_BIAS + ubo.lodBias;
+    bool isVirtual = VIRTUAL_TEXTURE && textureIndex == VIRTUAL_TEXTURE_INDEX;
+    float virtualLevel = 0.0f;
+    float virtualResidentLevel = 0.0f;
+    float4 outFragColor;
+    if (isVirtual) {
+        outFragColor = sampleVirtualTexture(input.fragTexCoord, lodBias, virtualLevel, virtualResidentLevel);
+    } else {
+        outFragColor = textures[textureIndex].SampleBias(textureSamplers[textureIndex], input.fragTexCoord, lodBias);
+    }
+    if (ALPHA_TEST && outFragColor.a < ALPHA_CUTOFF) {
+        discard;
+    }
+
+    if (isVirtual) {
+        writeVirtualPageFeedback(input.position.xy, input.fragTexCoord, virtualLevel);
+    } else if (LOD_FEEDBACK) {
+        writeLodFeedback(textureIndex, input.position.xy, input.fragTexCoord, lodBias);
+    }
+
+    if (SHOW_MIP_LEVELS) {
+        float level = isVirtual
+            ? virtualResidentLevel
+            : textures[textureIndex].CalculateLevelOfDetail(textureSamplers[textureIndex], input.fragTexCoord) + lodBias;
+        outFragColor = float4(getMipLevelColor(level), 1.0f);
+    }
     
     PS_Output output;
-    output.outColor = outFragColor;
+    output.outColor = float4(encodeOutput(outFragColor.rgb), outFragColor.a);
     
     return output;
 }
@@ -1,22 +1,44 @@
 #version 450
+#extension GL_EXT_multiview : require
+
+// The views a multiview frame renders at most, as `MAX_VIEW_COUNT` in `main.cpp`.
+#define MAX_VIEW_COUNT 4
 
 layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
-    mat4 view;
-    mat4 proj;
+    // Past the matrices and camera position the other stages read, the matrix of every
+    // view the frame renders, one per layer of its attachments. A frame of a single view
+    // only fills the first.
+    layout(offset = 160) mat4 viewProjs[MAX_VIEW_COUNT];
 } ubo;
 
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+    uint textureIndex;
+    // Past the texture coordinate offset only the vertex pulling shader reads.
+    layout(offset = 72) uint materialCount;
+} pushConstants;
+
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
+layout(location = 1) in vec2 inTexCoord;
+// The columns of the transform of the instance.
+layout(location = 2) in vec4 inInstanceModel0;
+layout(location = 3) in vec4 inInstanceModel1;
+layout(location = 4) in vec4 inInstanceModel2;
+layout(location = 5) in vec4 inInstanceModel3;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) flat out uint fragTextureIndex;
 
-layout(location = 0) out vec3 fragColor;
-layout(location = 1) out vec2 fragTexCoord;
+// The depth prepass only passes where this matches `depth.vert` exactly.
+invariant gl_Position;
 
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
-    fragColor = inColor;
+    mat4 instanceModel = mat4(inInstanceModel0, inInstanceModel1, inInstanceModel2, inInstanceModel3);
+    gl_Position = ubo.viewProjs[gl_ViewIndex] * (instanceModel * (pushConstants.model * vec4(inPosition, 1.0)));
     fragTexCoord = inTexCoord;
+    // The instance index counts from the first instance of the draw, so a draw of a single
+    // copy still takes the material of its copy.
+    fragTextureIndex = pushConstants.textureIndex + uint(gl_InstanceIndex) % pushConstants.materialCount;
 }
 
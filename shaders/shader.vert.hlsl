@@ -1,35 +1,61 @@
+// The views a multiview frame renders at most, as `MAX_VIEW_COUNT` in `main.cpp`.
+#define MAX_VIEW_COUNT 4
+
 struct VS_Input {
     float3 position : TEXCOORD0;
-    float3 color : TEXCOORD1;
-    float2 texCoord: TEXCOORD2;
+    float2 texCoord: TEXCOORD1;
+    // The columns of the transform of the instance.
+    float4 instanceModel0 : TEXCOORD2;
+    float4 instanceModel1 : TEXCOORD3;
+    float4 instanceModel2 : TEXCOORD4;
+    float4 instanceModel3 : TEXCOORD5;
+    // Like `gl_InstanceIndex`, this counts from the first instance of the draw, so a draw of
+    // a single copy still takes the material of its copy.
+    uint instanceIndex : SV_InstanceID;
+    uint viewIndex : SV_ViewID;
 };
 
 struct VS_Output {
-    float4 position : SV_POSITION;
-    float3 fragColor : TEXCOORD0;
-    float2 fragTexCoord: TEXCOORD1;
+    // The depth prepass only passes where this matches `depth.vert` exactly.
+    precise float4 position : SV_POSITION;
+    float2 fragTexCoord: TEXCOORD0;
+    nointerpolation uint fragTextureIndex : TEXCOORD1;
 };
 
 struct VS_InputConstants {
+    // Past the matrices and camera position the other stages read, the matrix of every
+    // view the frame renders, one per layer of its attachments. A frame of a single view
+    // only fills the first.
+    [[vk::offset(160)]] float4x4 viewProjs[MAX_VIEW_COUNT];
+};
+
+struct VS_PushConstants {
     float4x4 model;
-    float4x4 view;
-    float4x4 proj;
+    uint textureIndex;
+    // Past the texture coordinate offset only the vertex pulling shader reads.
+    [[vk::offset(72)]] uint materialCount;
 };
 
 cbuffer ubo : register(b0) {
     VS_InputConstants ubo;
 }
 
+[[vk::push_constant]] VS_PushConstants pushConstants;
+
 
 VS_Output main(VS_Input input) {
-    float4 outPosition = mul(ubo.proj, mul(ubo.view, mul(ubo.model, float4(input.position, 1.0f))));
-    float3 outFragColor = input.color;
+    float4 meshPosition = mul(pushConstants.model, float4(input.position, 1.0f));
+    float4 worldPosition = input.instanceModel0 * meshPosition.x
+        + input.instanceModel1 * meshPosition.y
+        + input.instanceModel2 * meshPosition.z
+        + input.instanceModel3 * meshPosition.w;
+    float4 outPosition = mul(ubo.viewProjs[input.viewIndex], worldPosition);
     float2 outFragTexCoord = input.texCoord;
     
     VS_Output output;
     output.position = outPosition;
-    output.fragColor = outFragColor;
     output.fragTexCoord = outFragTexCoord;
+    output.fragTextureIndex = pushConstants.textureIndex + input.instanceIndex % pushConstants.materialCount;
     
     return output;
 }
@@ -0,0 +1,85 @@
+#version 450
+
+// Builds the fragment shading rate attachment from the luminance of the frame before.
+// Every invocation writes one texel: it samples a grid of points over the pixels the texel
+// covers, and halves the shading rate along each axis the luminance barely changes along.
+#define THREAD_COUNT_X 8
+#define THREAD_COUNT_Y 8
+
+// The points sampled along each axis of a texel, as `ShadingRateImage::SAMPLE_COUNT`.
+#define SAMPLE_COUNT 4
+
+// The change in luminance between neighboring points below which the rate is halved, as
+// `ShadingRateImage::CONTRAST_THRESHOLD`.
+#define CONTRAST_THRESHOLD (1.0 / 32.0)
+
+// The rates are packed as the base 2 logarithm of the width, shifted up by 2, over the base
+// 2 logarithm of the height.
+#define RATE_1X1 0u
+#define RATE_1X2 1u
+#define RATE_2X1 4u
+#define RATE_2X2 5u
+
+layout(local_size_x = THREAD_COUNT_X, local_size_y = THREAD_COUNT_Y, local_size_z = 1) in;
+
+layout(push_constant) uniform PushConstants {
+    uvec2 renderExtent;
+    uvec2 texelSize;
+    uvec2 imageExtent;
+} pushConstants;
+
+// The frame before is output sized, and its render extent maps onto the whole of it.
+layout(set = 0, binding = 0) uniform texture2D source;
+layout(set = 0, binding = 1, r8ui) uniform writeonly uimage2D shadingRate;
+layout(set = 0, binding = 2) uniform sampler linearSampler;
+
+
+float luminance(vec3 color) {
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+void main() {
+    const uvec2 texel = gl_GlobalInvocationID.xy;
+    if (any(greaterThanEqual(texel, pushConstants.imageExtent))) {
+        return;
+    }
+
+    // The texels past the render extent are never read.
+    const vec2 texelOrigin = vec2(texel * pushConstants.texelSize);
+    const vec2 renderExtent = vec2(pushConstants.renderExtent);
+    if (any(greaterThanEqual(texelOrigin, renderExtent))) {
+        imageStore(shadingRate, ivec2(texel), uvec4(RATE_1X1));
+        return;
+    }
+
+    float samples[SAMPLE_COUNT][SAMPLE_COUNT];
+    const vec2 sampleSpacing = vec2(pushConstants.texelSize) / SAMPLE_COUNT;
+    for (int y = 0; y < SAMPLE_COUNT; y++) {
+        for (int x = 0; x < SAMPLE_COUNT; x++) {
+            const vec2 position = texelOrigin + (vec2(x, y) + 0.5) * sampleSpacing;
+            const vec2 uv = min(position / renderExtent, vec2(1.0));
+            samples[y][x] = luminance(textureLod(sampler2D(source, linearSampler), uv, 0.0).rgb);
+        }
+    }
+
+    float contrastX = 0.0;
+    float contrastY = 0.0;
+    for (int y = 0; y < SAMPLE_COUNT; y++) {
+        for (int x = 0; x < SAMPLE_COUNT - 1; x++) {
+            contrastX = max(contrastX, abs(samples[y][x + 1] - samples[y][x]));
+            contrastY = max(contrastY, abs(samples[x + 1][y] - samples[x][y]));
+        }
+    }
+
+    const bool isCoarseX = contrastX < CONTRAST_THRESHOLD;
+    const bool isCoarseY = contrastY < CONTRAST_THRESHOLD;
+    uint rate = RATE_1X1;
+    if (isCoarseX && isCoarseY) {
+        rate = RATE_2X2;
+    } else if (isCoarseX) {
+        rate = RATE_2X1;
+    } else if (isCoarseY) {
+        rate = RATE_1X2;
+    }
+    imageStore(shadingRate, ivec2(texel), uvec4(rate));
+}
@@ -0,0 +1,84 @@
+// Builds the fragment shading rate attachment from the luminance of the frame before.
+// Every thread writes one texel: it samples a grid of points over the pixels the texel
+// covers, and halves the shading rate along each axis the luminance barely changes along.
+#define THREAD_COUNT_X 8
+#define THREAD_COUNT_Y 8
+
+// The points sampled along each axis of a texel, as `ShadingRateImage::SAMPLE_COUNT`.
+#define SAMPLE_COUNT 4
+
+// The change in luminance between neighboring points below which the rate is halved, as
+// `ShadingRateImage::CONTRAST_THRESHOLD`.
+#define CONTRAST_THRESHOLD (1.0f / 32.0f)
+
+// The rates are packed as the base 2 logarithm of the width, shifted up by 2, over the base
+// 2 logarithm of the height.
+#define RATE_1X1 0u
+#define RATE_1X2 1u
+#define RATE_2X1 4u
+#define RATE_2X2 5u
+
+struct CS_PushConstants {
+    uint2 renderExtent;
+    uint2 texelSize;
+    uint2 imageExtent;
+};
+
+[[vk::push_constant]] CS_PushConstants pushConstants;
+
+// The frame before is output sized, and its render extent maps onto the whole of it.
+[[vk::binding(0, 0)]] Texture2D<float4> source;
+[[vk::binding(1, 0)]] [[vk::image_format("r8ui")]] RWTexture2D<uint> shadingRate;
+[[vk::binding(2, 0)]] SamplerState linearSampler;
+
+
+float luminance(float3 color) {
+    return dot(color, float3(0.2126f, 0.7152f, 0.0722f));
+}
+
+[numthreads(THREAD_COUNT_X, THREAD_COUNT_Y, 1)]
+void main(uint3 dispatchThreadId : SV_DispatchThreadID) {
+    uint2 texel = dispatchThreadId.xy;
+    if (any(texel >= pushConstants.imageExtent)) {
+        return;
+    }
+
+    // The texels past the render extent are never read.
+    float2 texelOrigin = float2(texel * pushConstants.texelSize);
+    float2 renderExtent = float2(pushConstants.renderExtent);
+    if (any(texelOrigin >= renderExtent)) {
+        shadingRate[texel] = RATE_1X1;
+        return;
+    }
+
+    float samples[SAMPLE_COUNT][SAMPLE_COUNT];
+    float2 sampleSpacing = float2(pushConstants.texelSize) / SAMPLE_COUNT;
+    for (int y = 0; y < SAMPLE_COUNT; y++) {
+        for (int x = 0; x < SAMPLE_COUNT; x++) {
+            float2 position = texelOrigin + (float2(x, y) + 0.5f) * sampleSpacing;
+            float2 uv = min(position / renderExtent, 1.0f);
+            samples[y][x] = luminance(source.SampleLevel(linearSampler, uv, 0.0f).rgb);
+        }
+    }
+
+    float contrastX = 0.0f;
+    float contrastY = 0.0f;
+    for (int y = 0; y < SAMPLE_COUNT; y++) {
+        for (int x = 0; x < SAMPLE_COUNT - 1; x++) {
+            contrastX = max(contrastX, abs(samples[y][x + 1] - samples[y][x]));
+            contrastY = max(contrastY, abs(samples[x + 1][y] - samples[x][y]));
+        }
+    }
+
+    bool isCoarseX = contrastX < CONTRAST_THRESHOLD;
+    bool isCoarseY = contrastY < CONTRAST_THRESHOLD;
+    if (isCoarseX && isCoarseY) {
+        shadingRate[texel] = RATE_2X2;
+    } else if (isCoarseX) {
+        shadingRate[texel] = RATE_2X1;
+    } else if (isCoarseY) {
+        shadingRate[texel] = RATE_1X2;
+    } else {
+        shadingRate[texel] = RATE_1X1;
+    }
+}
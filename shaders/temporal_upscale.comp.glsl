@@ -0,0 +1,78 @@
+#version 450
+#extension GL_EXT_samplerless_texture_functions : require
+
+// Upscales a jittered frame rendered below the output resolution into the history. Every
+// invocation writes one output texel: the color of the frame at the texel's unjittered
+// position, blended with the history where the texel was in the frame before, clamped to
+// the colors around it in the frame.
+#define THREAD_COUNT_X 8
+#define THREAD_COUNT_Y 8
+
+// The weight of the new color against the history, as `TemporalUpscaler::FEEDBACK`.
+#define FEEDBACK 0.1
+
+layout(local_size_x = THREAD_COUNT_X, local_size_y = THREAD_COUNT_Y, local_size_z = 1) in;
+
+layout(push_constant) uniform PushConstants {
+    // From the unjittered clip space of the frame to the clip space of the frame before.
+    mat4 reprojection;
+    // The offset of the frame's projection in rendered pixels.
+    vec2 jitter;
+    uvec2 renderExtent;
+    uvec2 outputExtent;
+    uint hasHistory;
+} pushConstants;
+
+// The frame is rendered into the top left corner of images as big as the output.
+layout(set = 0, binding = 0) uniform texture2D color;
+layout(set = 0, binding = 1) uniform texture2D depth;
+layout(set = 0, binding = 2) uniform texture2D history;
+layout(set = 0, binding = 3, rgba16f) uniform writeonly image2D outputImage;
+layout(set = 0, binding = 4) uniform sampler linearSampler;
+
+
+void main() {
+    const uvec2 texel = gl_GlobalInvocationID.xy;
+    if (any(greaterThanEqual(texel, pushConstants.outputExtent))) {
+        return;
+    }
+
+    const vec2 outputExtent = vec2(pushConstants.outputExtent);
+    const vec2 renderExtent = vec2(pushConstants.renderExtent);
+    const vec2 uv = (vec2(texel) + 0.5) / outputExtent;
+
+    // The jitter moved everything the frame shows by its offset, so the unjittered color
+    // sits that far along.
+    const vec2 renderPosition = clamp(uv * renderExtent + pushConstants.jitter, vec2(0.5), renderExtent - 0.5);
+    const ivec2 renderTexel = ivec2(renderPosition);
+    const vec4 current = textureLod(sampler2D(color, linearSampler), renderPosition / outputExtent, 0.0);
+    if (pushConstants.hasHistory == 0) {
+        imageStore(outputImage, ivec2(texel), current);
+        return;
+    }
+
+    vec4 minColor = current;
+    vec4 maxColor = current;
+    const ivec2 lastRenderTexel = ivec2(pushConstants.renderExtent) - 1;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            const vec4 neighbor = texelFetch(color, clamp(renderTexel + ivec2(x, y), ivec2(0), lastRenderTexel), 0);
+            minColor = min(minColor, neighbor);
+            maxColor = max(maxColor, neighbor);
+        }
+    }
+
+    // Points at infinity reproject too, since the clip space position is only divided
+    // after it is moved into the frame before.
+    const float texelDepth = texelFetch(depth, renderTexel, 0).r;
+    const vec4 previousClip = pushConstants.reprojection * vec4(uv * 2.0 - 1.0, texelDepth, 1.0);
+    const vec2 previousUv = (previousClip.xy / previousClip.w) * 0.5 + 0.5;
+    const bool isOnScreen = previousClip.w > 0.0 && all(greaterThanEqual(previousUv, vec2(0.0))) && all(lessThanEqual(previousUv, vec2(1.0)));
+    if (!isOnScreen) {
+        imageStore(outputImage, ivec2(texel), current);
+        return;
+    }
+
+    const vec4 previous = clamp(textureLod(sampler2D(history, linearSampler), previousUv, 0.0), minColor, maxColor);
+    imageStore(outputImage, ivec2(texel), mix(previous, current, FEEDBACK));
+}
@@ -0,0 +1,76 @@
+// Upscales a jittered frame rendered below the output resolution into the history. Every
+// thread writes one output texel: the color of the frame at the texel's unjittered
+// position, blended with the history where the texel was in the frame before, clamped to
+// the colors around it in the frame.
+#define THREAD_COUNT_X 8
+#define THREAD_COUNT_Y 8
+
+// The weight of the new color against the history, as `TemporalUpscaler::FEEDBACK`.
+#define FEEDBACK 0.1f
+
+struct CS_PushConstants {
+    // From the unjittered clip space of the frame to the clip space of the frame before.
+    float4x4 reprojection;
+    // The offset of the frame's projection in rendered pixels.
+    float2 jitter;
+    uint2 renderExtent;
+    uint2 outputExtent;
+    uint hasHistory;
+};
+
+[[vk::push_constant]] CS_PushConstants pushConstants;
+
+// The frame is rendered into the top left corner of images as big as the output.
+[[vk::binding(0, 0)]] Texture2D<float4> color;
+[[vk::binding(1, 0)]] Texture2D<float> depth;
+[[vk::binding(2, 0)]] Texture2D<float4> history;
+[[vk::binding(3, 0)]] [[vk::image_format("rgba16f")]] RWTexture2D<float4> output;
+[[vk::binding(4, 0)]] SamplerState linearSampler;
+
+
+[numthreads(THREAD_COUNT_X, THREAD_COUNT_Y, 1)]
+void main(uint3 dispatchThreadId : SV_DispatchThreadID) {
+    uint2 texel = dispatchThreadId.xy;
+    if (any(texel >= pushConstants.outputExtent)) {
+        return;
+    }
+
+    float2 outputExtent = float2(pushConstants.outputExtent);
+    float2 renderExtent = float2(pushConstants.renderExtent);
+    float2 uv = (float2(texel) + 0.5f) / outputExtent;
+
+    // The jitter moved everything the frame shows by its offset, so the unjittered color
+    // sits that far along.
+    float2 renderPosition = clamp(uv * renderExtent + pushConstants.jitter, 0.5f, renderExtent - 0.5f);
+    int2 renderTexel = int2(renderPosition);
+    float4 current = color.SampleLevel(linearSampler, renderPosition / outputExtent, 0.0f);
+    if (pushConstants.hasHistory == 0) {
+        output[texel] = current;
+        return;
+    }
+
+    float4 minColor = current;
+    float4 maxColor = current;
+    int2 lastRenderTexel = int2(pushConstants.renderExtent) - 1;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            float4 neighbor = color.Load(int3(clamp(renderTexel + int2(x, y), int2(0, 0), lastRenderTexel), 0));
+            minColor = min(minColor, neighbor);
+            maxColor = max(maxColor, neighbor);
+        }
+    }
+
+    // Points at infinity reproject too, since the clip space position is only divided
+    // after it is moved into the frame before.
+    float texelDepth = depth.Load(int3(renderTexel, 0));
+    float4 previousClip = mul(pushConstants.reprojection, float4(uv * 2.0f - 1.0f, texelDepth, 1.0f));
+    float2 previousUv = (previousClip.xy / previousClip.w) * 0.5f + 0.5f;
+    bool isOnScreen = previousClip.w > 0.0f && all(previousUv >= 0.0f) && all(previousUv <= 1.0f);
+    if (!isOnScreen) {
+        output[texel] = current;
+        return;
+    }
+
+    float4 previous = clamp(history.SampleLevel(linearSampler, previousUv, 0.0f), minColor, maxColor);
+    output[texel] = lerp(previous, current, FEEDBACK);
+}
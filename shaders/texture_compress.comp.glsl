@@ -0,0 +1,163 @@
+#version 450
+#extension GL_EXT_samplerless_texture_functions : require
+
+// A real-time BC1 and BC3 encoder. Every invocation encodes one 4x4 block of one mip level.
+//
+// The endpoints are the corners of the bounding box of the block's colors, inset by a
+// sixteenth of its extent so that outliers do not stretch the palette, and every texel
+// takes the palette entry nearest to its projection onto the line between them. This is
+// the fast encoder of van Waveren's real-time DXT compression: a single pass with no
+// search, which trades some quality for running at load time.
+//
+// BC3 adds an alpha block that is encoded the same way along the alpha axis. Blocks that
+// hang over the edge of a level repeat its last texels.
+#define THREAD_COUNT_X 8
+#define THREAD_COUNT_Y 8
+
+#define FORMAT_BC1 0
+#define FORMAT_BC3 1
+
+layout(local_size_x = THREAD_COUNT_X, local_size_y = THREAD_COUNT_Y, local_size_z = 1) in;
+
+layout(push_constant) uniform PushConstants {
+    uint width;
+    uint height;
+    uint level;
+    // The offset of the level's first block in the output, in 32-bit words.
+    uint blockOffset;
+    uint blockFormat;
+    uint isSrgb;
+} pushConstants;
+
+layout(set = 0, binding = 0) uniform texture2D source;
+layout(set = 0, binding = 1) buffer Blocks {
+    uint words[];
+} blocks;
+
+
+vec3 linearToSrgb(vec3 color) {
+    vec3 low = color * 12.92;
+    vec3 high = 1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055;
+
+    return mix(low, high, step(vec3(0.0031308), color));
+}
+
+uint packColor565(vec3 color) {
+    uvec3 quantized = uvec3(round(clamp(color, 0.0, 1.0) * vec3(31.0, 63.0, 31.0)));
+
+    return (quantized.r << 11) | (quantized.g << 5) | quantized.b;
+}
+
+vec3 unpackColor565(uint color) {
+    return vec3((color >> 11) & 0x1f, (color >> 5) & 0x3f, color & 0x1f) / vec3(31.0, 63.0, 31.0);
+}
+
+uvec2 encodeColorBlock(vec4 texels[16]) {
+    vec3 minColor = texels[0].rgb;
+    vec3 maxColor = texels[0].rgb;
+    for (int i = 1; i < 16; i++) {
+        minColor = min(minColor, texels[i].rgb);
+        maxColor = max(maxColor, texels[i].rgb);
+    }
+
+    vec3 inset = (maxColor - minColor) / 16.0;
+    uint color0 = packColor565(maxColor - inset);
+    uint color1 = packColor565(minColor + inset);
+    if (color0 == color1) {
+        return uvec2(color0 | (color1 << 16), 0);
+    }
+
+    // The four color mode needs the larger endpoint first.
+    if (color0 < color1) {
+        uint swapped = color0;
+        color0 = color1;
+        color1 = swapped;
+    }
+
+    vec3 endpoint0 = unpackColor565(color0);
+    vec3 endpoint1 = unpackColor565(color1);
+    vec3 direction = endpoint0 - endpoint1;
+    float lengthSquared = max(dot(direction, direction), 1e-8);
+
+    // The palette runs color0, color1, 2/3 color0 + 1/3 color1, 1/3 color0 + 2/3 color1.
+    const uint paletteIndices[4] = uint[4](1, 3, 2, 0);
+    uint indices = 0;
+    for (int i = 0; i < 16; i++) {
+        float t = clamp(dot(texels[i].rgb - endpoint1, direction) / lengthSquared, 0.0, 1.0);
+        indices |= paletteIndices[uint(round(t * 3.0))] << (2 * i);
+    }
+
+    return uvec2(color0 | (color1 << 16), indices);
+}
+
+uvec2 encodeAlphaBlock(vec4 texels[16]) {
+    float minAlpha = texels[0].a;
+    float maxAlpha = texels[0].a;
+    for (int i = 1; i < 16; i++) {
+        minAlpha = min(minAlpha, texels[i].a);
+        maxAlpha = max(maxAlpha, texels[i].a);
+    }
+
+    uint alpha0 = uint(round(maxAlpha * 255.0));
+    uint alpha1 = uint(round(minAlpha * 255.0));
+    uvec2 block = uvec2(alpha0 | (alpha1 << 8), 0);
+    if (alpha0 == alpha1) {
+        return block;
+    }
+
+    // The eight alpha mode runs alpha0, alpha1, then six steps from alpha0 to alpha1.
+    float range = float(alpha0 - alpha1);
+    for (int i = 0; i < 16; i++) {
+        uint step = uint(round(clamp((texels[i].a * 255.0 - float(alpha1)) / range, 0.0, 1.0) * 7.0));
+        uint index = (step == 7) ? 0 : (step == 0) ? 1 : 8 - step;
+
+        // The 3-bit indices start at bit 16 of the block, and one of them straddles the
+        // two words.
+        uint bit = 16 + 3 * uint(i);
+        if (bit < 32) {
+            block.x |= index << bit;
+        }
+
+        if (bit + 3 > 32) {
+            block.y |= (bit >= 32) ? (index << (bit - 32)) : (index >> (32 - bit));
+        }
+    }
+
+    return block;
+}
+
+
+void main() {
+    uvec2 blockCoord = gl_GlobalInvocationID.xy;
+    uvec2 blockCount = (uvec2(pushConstants.width, pushConstants.height) + 3) / 4;
+    if (any(greaterThanEqual(blockCoord, blockCount))) {
+        return;
+    }
+
+    ivec2 lastTexel = ivec2(pushConstants.width, pushConstants.height) - 1;
+    vec4 texels[16];
+    for (int i = 0; i < 16; i++) {
+        ivec2 coord = min(ivec2(blockCoord * 4) + ivec2(i % 4, i / 4), lastTexel);
+        texels[i] = texelFetch(source, coord, int(pushConstants.level));
+
+        // An sRGB view decodes to linear, and sRGB blocks hold the encoded values.
+        if (pushConstants.isSrgb != 0) {
+            texels[i].rgb = linearToSrgb(texels[i].rgb);
+        }
+    }
+
+    uvec2 colorBlock = encodeColorBlock(texels);
+    uint blockIndex = blockCoord.y * blockCount.x + blockCoord.x;
+    if (pushConstants.blockFormat == FORMAT_BC3) {
+        uvec2 alphaBlock = encodeAlphaBlock(texels);
+        uint word = pushConstants.blockOffset + 4 * blockIndex;
+        blocks.words[word + 0] = alphaBlock.x;
+        blocks.words[word + 1] = alphaBlock.y;
+        blocks.words[word + 2] = colorBlock.x;
+        blocks.words[word + 3] = colorBlock.y;
+    } else {
+        uint word = pushConstants.blockOffset + 2 * blockIndex;
+        blocks.words[word + 0] = colorBlock.x;
+        blocks.words[word + 1] = colorBlock.y;
+    }
+}
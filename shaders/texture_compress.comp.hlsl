@@ -0,0 +1,159 @@
+// A real-time BC1 and BC3 encoder. Every invocation encodes one 4x4 block of one mip level.
+//
+// The endpoints are the corners of the bounding box of the block's colors, inset by a
+// sixteenth of its extent so that outliers do not stretch the palette, and every texel
+// takes the palette entry nearest to its projection onto the line between them. This is
+// the fast encoder of van Waveren's real-time DXT compression: a single pass with no
+// search, which trades some quality for running at load time.
+//
+// BC3 adds an alpha block that is encoded the same way along the alpha axis. Blocks that
+// hang over the edge of a level repeat its last texels.
+#define THREAD_COUNT_X 8
+#define THREAD_COUNT_Y 8
+
+#define FORMAT_BC1 0
+#define FORMAT_BC3 1
+
+struct CS_PushConstants {
+    uint width;
+    uint height;
+    uint level;
+    // The offset of the level's first block in the output, in 32-bit words.
+    uint blockOffset;
+    uint blockFormat;
+    uint isSrgb;
+};
+
+[[vk::push_constant]] CS_PushConstants pushConstants;
+
+[[vk::binding(0, 0)]] Texture2D<float4> source;
+[[vk::binding(1, 0)]] RWStructuredBuffer<uint> blocks;
+
+
+float3 linearToSrgb(float3 color) {
+    float3 low = color * 12.92f;
+    float3 high = 1.055f * pow(color, 1.0f / 2.4f) - 0.055f;
+
+    return lerp(low, high, step(0.0031308f, color));
+}
+
+uint packColor565(float3 color) {
+    uint3 quantized = uint3(round(saturate(color) * float3(31.0f, 63.0f, 31.0f)));
+
+    return (quantized.r << 11) | (quantized.g << 5) | quantized.b;
+}
+
+float3 unpackColor565(uint color) {
+    return float3((color >> 11) & 0x1f, (color >> 5) & 0x3f, color & 0x1f) / float3(31.0f, 63.0f, 31.0f);
+}
+
+uint2 encodeColorBlock(float4 texels[16]) {
+    float3 minColor = texels[0].rgb;
+    float3 maxColor = texels[0].rgb;
+    for (int i = 1; i < 16; i++) {
+        minColor = min(minColor, texels[i].rgb);
+        maxColor = max(maxColor, texels[i].rgb);
+    }
+
+    float3 inset = (maxColor - minColor) / 16.0f;
+    uint color0 = packColor565(maxColor - inset);
+    uint color1 = packColor565(minColor + inset);
+    if (color0 == color1) {
+        return uint2(color0 | (color1 << 16), 0);
+    }
+
+    // The four color mode needs the larger endpoint first.
+    if (color0 < color1) {
+        uint swapped = color0;
+        color0 = color1;
+        color1 = swapped;
+    }
+
+    float3 endpoint0 = unpackColor565(color0);
+    float3 endpoint1 = unpackColor565(color1);
+    float3 direction = endpoint0 - endpoint1;
+    float lengthSquared = max(dot(direction, direction), 1e-8f);
+
+    // The palette runs color0, color1, 2/3 color0 + 1/3 color1, 1/3 color0 + 2/3 color1.
+    const uint paletteIndices[4] = { 1, 3, 2, 0 };
+    uint indices = 0;
+    for (int j = 0; j < 16; j++) {
+        float t = saturate(dot(texels[j].rgb - endpoint1, direction) / lengthSquared);
+        indices |= paletteIndices[uint(round(t * 3.0f))] << (2 * j);
+    }
+
+    return uint2(color0 | (color1 << 16), indices);
+}
+
+uint2 encodeAlphaBlock(float4 texels[16]) {
+    float minAlpha = texels[0].a;
+    float maxAlpha = texels[0].a;
+    for (int i = 1; i < 16; i++) {
+        minAlpha = min(minAlpha, texels[i].a);
+        maxAlpha = max(maxAlpha, texels[i].a);
+    }
+
+    uint alpha0 = uint(round(maxAlpha * 255.0f));
+    uint alpha1 = uint(round(minAlpha * 255.0f));
+    uint2 block = uint2(alpha0 | (alpha1 << 8), 0);
+    if (alpha0 == alpha1) {
+        return block;
+    }
+
+    // The eight alpha mode runs alpha0, alpha1, then six steps from alpha0 to alpha1.
+    float range = float(alpha0 - alpha1);
+    for (int j = 0; j < 16; j++) {
+        uint step = uint(round(saturate((texels[j].a * 255.0f - float(alpha1)) / range) * 7.0f));
+        uint index = (step == 7) ? 0 : (step == 0) ? 1 : 8 - step;
+
+        // The 3-bit indices start at bit 16 of the block, and one of them straddles the
+        // two words.
+        uint bit = 16 + 3 * uint(j);
+        if (bit < 32) {
+            block.x |= index << bit;
+        }
+
+        if (bit + 3 > 32) {
+            block.y |= (bit >= 32) ? (index << (bit - 32)) : (index >> (32 - bit));
+        }
+    }
+
+    return block;
+}
+
+
+[numthreads(THREAD_COUNT_X, THREAD_COUNT_Y, 1)]
+void main(uint3 dispatchId : SV_DispatchThreadID) {
+    uint2 blockCoord = dispatchId.xy;
+    uint2 blockCount = (uint2(pushConstants.width, pushConstants.height) + 3) / 4;
+    if (any(blockCoord >= blockCount)) {
+        return;
+    }
+
+    int2 lastTexel = int2(pushConstants.width, pushConstants.height) - 1;
+    float4 texels[16];
+    for (int i = 0; i < 16; i++) {
+        int2 coord = min(int2(blockCoord * 4) + int2(i % 4, i / 4), lastTexel);
+        texels[i] = source.Load(int3(coord, pushConstants.level));
+
+        // An sRGB view decodes to linear, and sRGB blocks hold the encoded values.
+        if (pushConstants.isSrgb != 0) {
+            texels[i].rgb = linearToSrgb(texels[i].rgb);
+        }
+    }
+
+    uint2 colorBlock = encodeColorBlock(texels);
+    uint blockIndex = blockCoord.y * blockCount.x + blockCoord.x;
+    if (pushConstants.blockFormat == FORMAT_BC3) {
+        uint2 alphaBlock = encodeAlphaBlock(texels);
+        uint word = pushConstants.blockOffset + 4 * blockIndex;
+        blocks[word + 0] = alphaBlock.x;
+        blocks[word + 1] = alphaBlock.y;
+        blocks[word + 2] = colorBlock.x;
+        blocks[word + 3] = colorBlock.y;
+    } else {
+        uint word = pushConstants.blockOffset + 2 * blockIndex;
+        blocks[word + 0] = colorBlock.x;
+        blocks[word + 1] = colorBlock.y;
+    }
+}
@@ -0,0 +1,52 @@
+#version 450
+#extension GL_EXT_multiview : require
+
+// The views a multiview frame renders at most, as `MAX_VIEW_COUNT` in `main.cpp`.
+#define MAX_VIEW_COUNT 4
+
+// Fetches the vertex from the split streams of the vertex buffer, read as storage buffer
+// words by vertex index: positions are four 16-bit unsigned normalized components, the last
+// one padding, and texture coordinates are two. The vertex index counts from the base
+// vertex of the draw, so meshes anywhere in the geometry pool are fetched alike.
+layout(binding = 0) uniform UniformBufferObject {
+    // Past the matrices and camera position the other stages read, the matrix of every
+    // view the frame renders, one per layer of its attachments. A frame of a single view
+    // only fills the first.
+    layout(offset = 160) mat4 viewProjs[MAX_VIEW_COUNT];
+} ubo;
+
+layout(set = 2, binding = 0) readonly buffer Vertices {
+    uint vertices[];
+};
+
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+    uint textureIndex;
+    uint texCoordOffset;
+    uint materialCount;
+} pushConstants;
+
+// The columns of the transform of the instance, at the locations of `shader.vert`.
+layout(location = 2) in vec4 inInstanceModel0;
+layout(location = 3) in vec4 inInstanceModel1;
+layout(location = 4) in vec4 inInstanceModel2;
+layout(location = 5) in vec4 inInstanceModel3;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) flat out uint fragTextureIndex;
+
+// The depth prepass draws with this shader too, and only passes where it matches exactly.
+invariant gl_Position;
+
+
+void main() {
+    const uint vertex = uint(gl_VertexIndex);
+    const vec2 positionXY = unpackUnorm2x16(vertices[2 * vertex]);
+    const vec2 positionZW = unpackUnorm2x16(vertices[2 * vertex + 1]);
+
+    mat4 instanceModel = mat4(inInstanceModel0, inInstanceModel1, inInstanceModel2, inInstanceModel3);
+    gl_Position = ubo.viewProjs[gl_ViewIndex] * (instanceModel * (pushConstants.model * vec4(positionXY, positionZW.x, 1.0)));
+    fragTexCoord = unpackUnorm2x16(vertices[pushConstants.texCoordOffset + vertex]);
+    // The instance index counts from the first instance of the draw, as in `shader.vert`.
+    fragTextureIndex = pushConstants.textureIndex + uint(gl_InstanceIndex) % pushConstants.materialCount;
+}
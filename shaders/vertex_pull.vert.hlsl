@@ -0,0 +1,71 @@
+// The views a multiview frame renders at most, as `MAX_VIEW_COUNT` in `main.cpp`.
+#define MAX_VIEW_COUNT 4
+
+// Fetches the vertex from the split streams of the vertex buffer, read as storage buffer
+// words by vertex index: positions are four 16-bit unsigned normalized components, the last
+// one padding, and texture coordinates are two. The vertex index counts from the base
+// vertex of the draw, so meshes anywhere in the geometry pool are fetched alike.
+struct VS_Input {
+    uint vertexIndex : SV_VertexID;
+    // Counts from the first instance of the draw, as in `shader.vert`.
+    uint instanceIndex : SV_InstanceID;
+    // The columns of the transform of the instance, at the locations of `shader.vert`.
+    [[vk::location(2)]] float4 instanceModel0 : TEXCOORD2;
+    [[vk::location(3)]] float4 instanceModel1 : TEXCOORD3;
+    [[vk::location(4)]] float4 instanceModel2 : TEXCOORD4;
+    [[vk::location(5)]] float4 instanceModel3 : TEXCOORD5;
+    uint viewIndex : SV_ViewID;
+};
+
+struct VS_Output {
+    // The depth prepass draws with this shader too, and only passes where it matches exactly.
+    precise float4 position : SV_POSITION;
+    float2 fragTexCoord: TEXCOORD0;
+    nointerpolation uint fragTextureIndex : TEXCOORD1;
+};
+
+struct VS_InputConstants {
+    // Past the matrices and camera position the other stages read, the matrix of every
+    // view the frame renders, one per layer of its attachments. A frame of a single view
+    // only fills the first.
+    [[vk::offset(160)]] float4x4 viewProjs[MAX_VIEW_COUNT];
+};
+
+struct VS_PushConstants {
+    float4x4 model;
+    uint textureIndex;
+    uint texCoordOffset;
+    uint materialCount;
+};
+
+cbuffer ubo : register(b0) {
+    VS_InputConstants ubo;
+}
+
+[[vk::push_constant]] VS_PushConstants pushConstants;
+
+[[vk::binding(0, 2)]] StructuredBuffer<uint> vertexData;
+
+
+float2 unpackUnorm2x16(uint value) {
+    return float2(value & 0xffff, value >> 16) / 65535.0f;
+}
+
+VS_Output main(VS_Input input) {
+    uint vertex = input.vertexIndex;
+    float2 positionXY = unpackUnorm2x16(vertexData[2 * vertex]);
+    float2 positionZW = unpackUnorm2x16(vertexData[2 * vertex + 1]);
+
+    float4 meshPosition = mul(pushConstants.model, float4(positionXY, positionZW.x, 1.0f));
+    float4 worldPosition = input.instanceModel0 * meshPosition.x
+        + input.instanceModel1 * meshPosition.y
+        + input.instanceModel2 * meshPosition.z
+        + input.instanceModel3 * meshPosition.w;
+
+    VS_Output output;
+    output.position = mul(ubo.viewProjs[input.viewIndex], worldPosition);
+    output.fragTexCoord = unpackUnorm2x16(vertexData[pushConstants.texCoordOffset + vertex]);
+    output.fragTextureIndex = pushConstants.textureIndex + input.instanceIndex % pushConstants.materialCount;
+
+    return output;
+}
@@ -0,0 +1,555 @@
+#include "asset_archive.h"
+
+#include "cache_source_key.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+
+using AssetArchive = VulkanEngine::AssetArchive;
+using AssetArchiveEntry = VulkanEngine::AssetArchiveEntry;
+using AssetCompression = VulkanEngine::AssetCompression;
+using AssetFile = VulkanEngine::AssetFile;
+using CacheSourceKey = VulkanEngine::CacheSourceKey;
+using MappedFile = VulkanEngine::MappedFile;
+
+// The archive is a header, the entries and the table of contents, in that order. Any
+// change to that layout must bump the version.
+static constexpr uint32_t ARCHIVE_MAGIC = 0x4b415041; // "APAK"
+static constexpr uint32_t ARCHIVE_VERSION = 1;
+
+struct ArchiveHeader final {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t entryCount;
+    uint64_t tableOffset;
+    uint64_t tableSize;
+};
+
+// Every entry of the table of contents is followed by its path.
+struct ArchiveTableEntry final {
+    uint32_t compression;
+    uint32_t pathSize;
+    uint64_t offset;
+    uint64_t storedSize;
+    uint64_t size;
+    uint64_t hash;
+};
+
+// LZ4 matches are at least four bytes long. The last five bytes of a block are always
+// literals, and the last match starts at least twelve bytes before the end of the block.
+static constexpr size_t LZ4_MIN_MATCH = 4;
+static constexpr size_t LZ4_LAST_LITERALS = 5;
+static constexpr size_t LZ4_MATCH_FIND_LIMIT = 12;
+static constexpr size_t LZ4_MAX_OFFSET = 65535;
+static constexpr uint32_t LZ4_HASH_BITS = 16;
+// Every length byte after a token adds at most 255 bytes of output, so no LZ4 block expands
+// to more than 255 times its size.
+static constexpr uint64_t LZ4_MAX_EXPANSION = 255;
+
+// An entry is only stored compressed when that saves at least an eighth of its size, so
+// files that are already compressed are never decompressed for nothing.
+static constexpr uint64_t MIN_COMPRESSION_SAVING_DIVISOR = 8;
+
+// Files with these extensions are uploaded to the GPU as they are, so they are compressed
+// in blocks the GPU can expand.
+static constexpr auto GPU_UPLOADED_EXTENSIONS = std::array<std::string_view, 1> { ".ktx2" };
+
+static std::unique_ptr<AssetArchive> s_mountedArchive = nullptr;
+
+static uint32_t readLz4Word(const uint8_t* data) {
+    auto word = uint32_t { 0 };
+    std::memcpy(&word, data, sizeof(word));
+
+    return word;
+}
+
+static void writeLz4Length(std::vector<uint8_t>& output, size_t length) {
+    while (length >= 255) {
+        output.push_back(255);
+        length -= 255;
+    }
+    output.push_back(static_cast<uint8_t>(length));
+}
+
+/// @brief Compress `input` into a single LZ4 block, with a greedy parse over a hash table
+/// of the last position of every four-byte sequence.
+static std::vector<uint8_t> compressLz4(std::span<const uint8_t> input) {
+    auto output = std::vector<uint8_t> {};
+    output.reserve(input.size() + input.size() / 255 + 16);
+
+    auto writeSequence = [&output, &input](size_t literalStart, size_t literalEnd, size_t offset, size_t matchLength) {
+        const auto literalLength = literalEnd - literalStart;
+        const auto hasMatch = matchLength > 0;
+        const auto matchCode = hasMatch ? matchLength - LZ4_MIN_MATCH : 0;
+        const auto token = (std::min<size_t>(literalLength, 15) << 4) | (hasMatch ? std::min<size_t>(matchCode, 15) : 0);
+        output.push_back(static_cast<uint8_t>(token));
+        if (literalLength >= 15) {
+            writeLz4Length(output, literalLength - 15);
+        }
+        output.insert(output.end(), input.begin() + literalStart, input.begin() + literalEnd);
+
+        if (!hasMatch) {
+            return;
+        }
+
+        output.push_back(static_cast<uint8_t>(offset & 0xff));
+        output.push_back(static_cast<uint8_t>(offset >> 8));
+        if (matchCode >= 15) {
+            writeLz4Length(output, matchCode - 15);
+        }
+    };
+
+    auto anchor = size_t { 0 };
+    if (input.size() > LZ4_MATCH_FIND_LIMIT) {
+        auto hashTable = std::vector<int64_t>(size_t { 1 } << LZ4_HASH_BITS, -1);
+        const auto matchEndLimit = input.size() - LZ4_LAST_LITERALS;
+        auto position = size_t { 0 };
+        while (position < input.size() - LZ4_MATCH_FIND_LIMIT) {
+            const auto sequence = readLz4Word(input.data() + position);
+            const auto hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+            const auto candidate = hashTable[hash];
+            hashTable[hash] = static_cast<int64_t>(position);
+
+            const auto isMatch = candidate >= 0 &&
+                position - static_cast<size_t>(candidate) <= LZ4_MAX_OFFSET &&
+                readLz4Word(input.data() + candidate) == sequence;
+            if (!isMatch) {
+                position++;
+
+                continue;
+            }
+
+            auto matchLength = LZ4_MIN_MATCH;
+            while (position + matchLength < matchEndLimit && input[candidate + matchLength] == input[position + matchLength]) {
+                matchLength++;
+            }
+
+            writeSequence(anchor, position, position - static_cast<size_t>(candidate), matchLength);
+            position += matchLength;
+            anchor = position;
+        }
+    }
+
+    writeSequence(anchor, input.size(), 0, 0);
+
+    return output;
+}
+
+/// @brief Decompress a single LZ4 block into `output`, which it has to fill exactly.
+static void decompressLz4(std::span<const uint8_t> input, std::span<uint8_t> output) {
+    auto readLength = [&input](size_t& position, size_t length) -> size_t {
+        if (length != 15) {
+            return length;
+        }
+
+        auto byte = uint8_t { 255 };
+        while (byte == 255) {
+            if (position >= input.size()) {
+                throw std::runtime_error("failed to decompress asset archive entry: truncated block!");
+            }
+
+            byte = input[position++];
+            length += byte;
+        }
+
+        return length;
+    };
+
+    auto inputPosition = size_t { 0 };
+    auto outputPosition = size_t { 0 };
+    while (inputPosition < input.size()) {
+        const auto token = input[inputPosition++];
+        const auto literalLength = readLength(inputPosition, token >> 4);
+        if (literalLength > input.size() - inputPosition || literalLength > output.size() - outputPosition) {
+            throw std::runtime_error("failed to decompress asset archive entry: literals out of bounds!");
+        }
+
+        std::memcpy(output.data() + outputPosition, input.data() + inputPosition, literalLength);
+        inputPosition += literalLength;
+        outputPosition += literalLength;
+
+        // The last sequence of a block has no match.
+        if (inputPosition == input.size()) {
+            break;
+        }
+
+        if (input.size() - inputPosition < 2) {
+            throw std::runtime_error("failed to decompress asset archive entry: truncated block!");
+        }
+
+        const auto offset = static_cast<size_t>(input[inputPosition]) | (static_cast<size_t>(input[inputPosition + 1]) << 8);
+        inputPosition += 2;
+        if (offset == 0 || offset > outputPosition) {
+            throw std::runtime_error("failed to decompress asset archive entry: match out of bounds!");
+        }
+
+        const auto matchLength = readLength(inputPosition, token & 0x0f) + LZ4_MIN_MATCH;
+        if (matchLength > output.size() - outputPosition) {
+            throw std::runtime_error("failed to decompress asset archive entry: match out of bounds!");
+        }
+
+        // Matches may overlap the bytes they produce, so they are copied a byte at a time.
+        for (size_t i = 0; i < matchLength; i++) {
+            output[outputPosition + i] = output[outputPosition + i - offset];
+        }
+        outputPosition += matchLength;
+    }
+
+    if (outputPosition != output.size()) {
+        throw std::runtime_error("failed to decompress asset archive entry: size mismatch!");
+    }
+}
+
+/// @brief Compress `input` into independent LZ4 blocks of `AssetArchive::COMPRESSED_BLOCK_SIZE`
+/// bytes, after the table of their offsets.
+///
+/// @note Returns nothing when the stored entry would not fit 32-bit offsets.
+static std::optional<std::vector<uint8_t>> compressLz4Blocks(std::span<const uint8_t> input) {
+    const auto blockCount = (input.size() + AssetArchive::COMPRESSED_BLOCK_SIZE - 1) / AssetArchive::COMPRESSED_BLOCK_SIZE;
+    auto blockOffsets = std::vector<uint32_t>(blockCount + 1);
+    auto blocks = std::vector<uint8_t> {};
+    const auto tableSize = blockOffsets.size() * sizeof(uint32_t);
+    for (size_t i = 0; i < blockCount; i++) {
+        if (tableSize + blocks.size() > UINT32_MAX) {
+            return std::nullopt;
+        }
+
+        blockOffsets[i] = static_cast<uint32_t>(tableSize + blocks.size());
+        const auto blockStart = i * AssetArchive::COMPRESSED_BLOCK_SIZE;
+        const auto blockSize = std::min<size_t>(AssetArchive::COMPRESSED_BLOCK_SIZE, input.size() - blockStart);
+        const auto compressedBlock = compressLz4(input.subspan(blockStart, blockSize));
+        blocks.insert(blocks.end(), compressedBlock.begin(), compressedBlock.end());
+    }
+
+    if (tableSize + blocks.size() > UINT32_MAX) {
+        return std::nullopt;
+    }
+
+    blockOffsets[blockCount] = static_cast<uint32_t>(tableSize + blocks.size());
+
+    auto output = std::vector<uint8_t>(tableSize);
+    std::memcpy(output.data(), blockOffsets.data(), tableSize);
+    output.insert(output.end(), blocks.begin(), blocks.end());
+
+    return output;
+}
+
+/// @brief The stored bytes of block `blockIndex` of a block-compressed entry.
+static std::span<const uint8_t> getLz4Block(std::span<const uint8_t> input, uint64_t blockCount, uint64_t blockIndex) {
+    const auto tableSize = (blockCount + 1) * sizeof(uint32_t);
+    if (input.size() < tableSize) {
+        throw std::runtime_error("failed to decompress asset archive entry: truncated block table!");
+    }
+
+    const auto blockStart = readLz4Word(input.data() + blockIndex * sizeof(uint32_t));
+    const auto blockEnd = readLz4Word(input.data() + (blockIndex + 1) * sizeof(uint32_t));
+    if (blockStart < tableSize || blockStart > blockEnd || blockEnd > input.size()) {
+        throw std::runtime_error("failed to decompress asset archive entry: block out of bounds!");
+    }
+
+    return input.subspan(blockStart, blockEnd - blockStart);
+}
+
+AssetArchive::AssetArchive(const std::filesystem::path& archivePath)
+    : m_filePath { archivePath.string() }
+    , m_file { m_filePath }
+    , m_entries {}
+{
+    const auto* data = m_file.getData();
+    const auto size = m_file.getSize();
+    if (size < sizeof(ArchiveHeader)) {
+        throw std::runtime_error("failed to open asset archive: not an asset archive!");
+    }
+
+    auto header = ArchiveHeader {};
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != ARCHIVE_MAGIC || header.version != ARCHIVE_VERSION) {
+        throw std::runtime_error("failed to open asset archive: not an asset archive!");
+    }
+
+    if (header.tableOffset > size || header.tableSize > size - header.tableOffset) {
+        throw std::runtime_error("failed to open asset archive: truncated table of contents!");
+    }
+
+    // Every entry takes at least its fixed-size record, so a count the table cannot hold is
+    // rejected before it sizes the reservation.
+    if (header.entryCount > header.tableSize / sizeof(ArchiveTableEntry)) {
+        throw std::runtime_error("failed to open asset archive: truncated table of contents!");
+    }
+
+    auto position = header.tableOffset;
+    const auto tableEnd = header.tableOffset + header.tableSize;
+    m_entries.reserve(header.entryCount);
+    for (uint64_t i = 0; i < header.entryCount; i++) {
+        if (tableEnd - position < sizeof(ArchiveTableEntry)) {
+            throw std::runtime_error("failed to open asset archive: truncated table of contents!");
+        }
+
+        auto tableEntry = ArchiveTableEntry {};
+        std::memcpy(&tableEntry, data + position, sizeof(tableEntry));
+        position += sizeof(tableEntry);
+        if (tableEnd - position < tableEntry.pathSize) {
+            throw std::runtime_error("failed to open asset archive: truncated table of contents!");
+        }
+
+        auto path = std::string { reinterpret_cast<const char*>(data + position), tableEntry.pathSize };
+        position += tableEntry.pathSize;
+
+        if (tableEntry.offset > size || tableEntry.storedSize > size - tableEntry.offset) {
+            throw std::runtime_error("failed to open asset archive: truncated entry!");
+        }
+
+        const auto compression = static_cast<AssetCompression>(tableEntry.compression);
+        const auto isKnownCompression = compression == AssetCompression::None ||
+            compression == AssetCompression::Lz4 ||
+            compression == AssetCompression::Lz4Blocks;
+        if (!isKnownCompression) {
+            throw std::runtime_error("failed to open asset archive: unknown entry compression!");
+        }
+
+        if (compression == AssetCompression::None && tableEntry.storedSize != tableEntry.size) {
+            throw std::runtime_error("failed to open asset archive: corrupt entry!");
+        }
+
+        // The stored size lies within the file, so bounding the expanded size by it keeps a
+        // corrupt size from sizing the buffer an entry is read into.
+        if (compression != AssetCompression::None && tableEntry.size > tableEntry.storedSize * LZ4_MAX_EXPANSION) {
+            throw std::runtime_error("failed to open asset archive: corrupt entry!");
+        }
+
+        if (compression == AssetCompression::Lz4Blocks) {
+            const auto blockCount = (tableEntry.size + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE;
+            if ((blockCount + 1) * sizeof(uint32_t) > tableEntry.storedSize) {
+                throw std::runtime_error("failed to open asset archive: truncated block table!");
+            }
+        }
+
+        m_entries.emplace(std::move(path), AssetArchiveEntry {
+            .compression = compression,
+            .offset = tableEntry.offset,
+            .storedSize = tableEntry.storedSize,
+            .size = tableEntry.size,
+            .hash = tableEntry.hash,
+        });
+    }
+}
+
+std::optional<AssetArchiveEntry> AssetArchive::find(const std::string& filePath) const {
+    const auto entry = m_entries.find(AssetArchive::normalizePath(filePath));
+    if (entry == m_entries.end()) {
+        return std::nullopt;
+    }
+
+    return entry->second;
+}
+
+std::span<const uint8_t> AssetArchive::getStoredBytes(const AssetArchiveEntry& entry) const {
+    const auto bytes = m_file.getBytes();
+    if (entry.offset > bytes.size() || entry.storedSize > bytes.size() - entry.offset) {
+        throw std::runtime_error("failed to read asset archive entry: entry out of bounds!");
+    }
+
+    return bytes.subspan(entry.offset, entry.storedSize);
+}
+
+std::vector<uint8_t> AssetArchive::read(const AssetArchiveEntry& entry) const {
+    const auto storedBytes = this->getStoredBytes(entry);
+    auto data = std::vector<uint8_t>(entry.size);
+    if (entry.compression == AssetCompression::Lz4) {
+        decompressLz4(storedBytes, data);
+    } else if (entry.compression == AssetCompression::Lz4Blocks) {
+        const auto blockCount = AssetArchive::getBlockCount(entry);
+        for (uint64_t i = 0; i < blockCount; i++) {
+            const auto blockStart = i * COMPRESSED_BLOCK_SIZE;
+            const auto blockSize = std::min(COMPRESSED_BLOCK_SIZE, entry.size - blockStart);
+            decompressLz4(getLz4Block(storedBytes, blockCount, i), std::span { data }.subspan(blockStart, blockSize));
+        }
+    } else {
+        std::copy(storedBytes.begin(), storedBytes.end(), data.begin());
+    }
+
+    if (CacheSourceKey::hashBytes(data.data(), data.size(), CacheSourceKey::FNV_OFFSET_BASIS) != entry.hash) {
+        throw std::runtime_error("failed to read asset archive entry: corrupt entry!");
+    }
+
+    return data;
+}
+
+std::vector<uint8_t> AssetArchive::readBlock(const AssetArchiveEntry& entry, uint64_t blockIndex) const {
+    const auto blockCount = AssetArchive::getBlockCount(entry);
+    if (entry.compression != AssetCompression::Lz4Blocks || blockIndex >= blockCount) {
+        throw std::logic_error("the asset archive entry has no such block!");
+    }
+
+    const auto blockStart = blockIndex * COMPRESSED_BLOCK_SIZE;
+    auto data = std::vector<uint8_t>(std::min(COMPRESSED_BLOCK_SIZE, entry.size - blockStart));
+    decompressLz4(getLz4Block(this->getStoredBytes(entry), blockCount, blockIndex), data);
+
+    return data;
+}
+
+uint64_t AssetArchive::getBlockCount(const AssetArchiveEntry& entry) {
+    return (entry.size + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE;
+}
+
+const std::string& AssetArchive::getFilePath() const {
+    return m_filePath;
+}
+
+void AssetArchive::write(const std::filesystem::path& archivePath, const std::vector<std::string>& filePaths) {
+    // Write to a temporary file first so a crash mid-write never leaves a truncated archive
+    // behind under the real name.
+    auto temporaryPath = archivePath;
+    temporaryPath += ".tmp";
+    {
+        auto file = std::ofstream { temporaryPath, std::ios::binary | std::ios::trunc };
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open asset archive for writing!");
+        }
+
+        // The header is written again once the table of contents has a place.
+        auto header = ArchiveHeader {
+            .magic = ARCHIVE_MAGIC,
+            .version = ARCHIVE_VERSION,
+            .entryCount = filePaths.size(),
+            .tableOffset = 0,
+            .tableSize = 0,
+        };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        static constexpr auto PADDING = std::array<char, ENTRY_ALIGNMENT> {};
+        auto offset = uint64_t { sizeof(header) };
+        auto pad = [&file, &offset]() {
+            const auto alignedOffset = (offset + ENTRY_ALIGNMENT - 1) & ~(ENTRY_ALIGNMENT - 1);
+            file.write(PADDING.data(), static_cast<std::streamsize>(alignedOffset - offset));
+            offset = alignedOffset;
+        };
+
+        auto table = std::vector<uint8_t> {};
+        for (const auto& filePath : filePaths) {
+            const auto sourceFile = MappedFile { filePath };
+            const auto sourceBytes = sourceFile.getBytes();
+            const auto extension = std::filesystem::path { filePath }.extension().string();
+            const auto isGpuUploaded = std::ranges::find(GPU_UPLOADED_EXTENSIONS, extension) != GPU_UPLOADED_EXTENSIONS.end();
+            const auto compressedBytes = [isGpuUploaded, sourceBytes]() -> std::optional<std::vector<uint8_t>> {
+                if (isGpuUploaded) {
+                    return compressLz4Blocks(sourceBytes);
+                } else {
+                    return compressLz4(sourceBytes);
+                }
+            }();
+            const auto isCompressed = compressedBytes.has_value() &&
+                compressedBytes->size() <= sourceBytes.size() - sourceBytes.size() / MIN_COMPRESSION_SAVING_DIVISOR;
+            const auto compression = [isCompressed, isGpuUploaded]() -> AssetCompression {
+                if (!isCompressed) {
+                    return AssetCompression::None;
+                } else if (isGpuUploaded) {
+                    return AssetCompression::Lz4Blocks;
+                } else {
+                    return AssetCompression::Lz4;
+                }
+            }();
+            const auto storedBytes = isCompressed ? std::span<const uint8_t> { *compressedBytes } : sourceBytes;
+
+            pad();
+            const auto path = AssetArchive::normalizePath(filePath);
+            const auto tableEntry = ArchiveTableEntry {
+                .compression = static_cast<uint32_t>(compression),
+                .pathSize = static_cast<uint32_t>(path.size()),
+                .offset = offset,
+                .storedSize = storedBytes.size(),
+                .size = sourceBytes.size(),
+                .hash = CacheSourceKey::hashBytes(sourceBytes.data(), sourceBytes.size(), CacheSourceKey::FNV_OFFSET_BASIS),
+            };
+            const auto* tableEntryBytes = reinterpret_cast<const uint8_t*>(&tableEntry);
+            table.insert(table.end(), tableEntryBytes, tableEntryBytes + sizeof(tableEntry));
+            table.insert(table.end(), path.begin(), path.end());
+
+            file.write(reinterpret_cast<const char*>(storedBytes.data()), static_cast<std::streamsize>(storedBytes.size()));
+            offset += storedBytes.size();
+        }
+
+        pad();
+        header.tableOffset = offset;
+        header.tableSize = table.size();
+        file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size()));
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!file) {
+            throw std::runtime_error("failed to write asset archive!");
+        }
+    }
+
+    auto errorCode = std::error_code {};
+    std::filesystem::rename(temporaryPath, archivePath, errorCode);
+    if (errorCode) {
+        std::filesystem::remove(temporaryPath, errorCode);
+
+        throw std::runtime_error("failed to rename asset archive into place!");
+    }
+}
+
+void AssetArchive::mount(const std::filesystem::path& archivePath) {
+    s_mountedArchive = std::make_unique<AssetArchive>(archivePath);
+}
+
+const AssetArchive* AssetArchive::getMounted() {
+    return s_mountedArchive.get();
+}
+
+std::string AssetArchive::normalizePath(const std::string& filePath) {
+    return std::filesystem::path { filePath }.lexically_normal().generic_string();
+}
+
+AssetFile::AssetFile(const std::string& filePath)
+    : m_file { std::nullopt }
+    , m_decompressedData {}
+    , m_bytes {}
+    , m_fileRegion { std::nullopt }
+{
+    const auto* archive = AssetArchive::getMounted();
+    const auto entry = archive != nullptr ? archive->find(filePath) : std::nullopt;
+    if (!entry.has_value()) {
+        m_file.emplace(filePath);
+        m_bytes = m_file->getBytes();
+        m_fileRegion = AssetFileRegion { .filePath = filePath, .offset = 0 };
+    } else if (entry->compression == AssetCompression::None) {
+        m_bytes = archive->getStoredBytes(*entry);
+        m_fileRegion = AssetFileRegion { .filePath = archive->getFilePath(), .offset = entry->offset };
+    } else {
+        m_decompressedData = archive->read(*entry);
+        m_bytes = m_decompressedData;
+    }
+}
+
+bool AssetFile::exists(const std::string& filePath) {
+    const auto* archive = AssetArchive::getMounted();
+    if (archive != nullptr && archive->find(filePath).has_value()) {
+        return true;
+    }
+
+    return std::filesystem::exists(filePath);
+}
+
+const uint8_t* AssetFile::getData() const {
+    return m_bytes.data();
+}
+
+size_t AssetFile::getSize() const {
+    return m_bytes.size();
+}
+
+std::span<const uint8_t> AssetFile::getBytes() const {
+    return m_bytes;
+}
+
+const std::optional<VulkanEngine::AssetFileRegion>& AssetFile::getFileRegion() const {
+    return m_fileRegion;
+}
@@ -0,0 +1,169 @@
+#ifndef _ASSET_ARCHIVE_H
+#define _ASSET_ARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+
+
+namespace VulkanEngine {
+
+enum class AssetCompression : uint32_t {
+    None = 0,
+    Lz4 = 1,
+    /// @brief Independent LZ4 blocks of `AssetArchive::COMPRESSED_BLOCK_SIZE` bytes each,
+    /// after a table of their offsets, so that every block can be expanded on its own.
+    Lz4Blocks = 2
+};
+
+/// @brief One file packed into an `AssetArchive`.
+///
+/// @note `offset` is relative to the start of the archive. `hash` is the FNV-1a hash of the
+/// uncompressed contents.
+struct AssetArchiveEntry final {
+    AssetCompression compression = AssetCompression::None;
+    uint64_t offset = 0;
+    uint64_t storedSize = 0;
+    uint64_t size = 0;
+    uint64_t hash = 0;
+};
+
+/// @brief Where the contents of an asset sit unchanged in a file, a loose file or an
+/// uncompressed archive entry.
+struct AssetFileRegion final {
+    std::string filePath;
+    uint64_t offset = 0;
+};
+
+/// @brief A read-only archive of asset files, with a table of contents keyed by path.
+///
+/// @note The archive is a header, the entries, and the table of contents, in that order.
+/// It is mapped whole, so it opens once however many assets are read from it, and the
+/// stored contents of an uncompressed entry are read straight out of the mapping. Every
+/// entry starts on an `ENTRY_ALIGNMENT` boundary, so texel data copied out of it into a
+/// staging slice keeps the alignment of its blocks.
+///
+/// Entries are compressed with LZ4 when it saves space, which suits meshes and other text
+/// assets, while PNG and JPEG images are already compressed and stay as they are. KTX2
+/// textures, whose contents go to the GPU as they are, are compressed in independent blocks
+/// instead, so that they can be uploaded compressed and expanded by a compute shader, one
+/// block per invocation.
+///
+/// A block-compressed entry is stored as `blockCount + 1` 32-bit offsets, relative to the
+/// start of the entry, followed by the blocks. Block `i` spans the stored bytes from offset
+/// `i` up to offset `i + 1`, and expands to the `COMPRESSED_BLOCK_SIZE` bytes of the
+/// contents that start at `i * COMPRESSED_BLOCK_SIZE`, or fewer for the last block.
+class AssetArchive final {
+    public:
+        static constexpr uint64_t ENTRY_ALIGNMENT = 16;
+
+        static constexpr uint64_t COMPRESSED_BLOCK_SIZE = 64 * 1024;
+
+        explicit AssetArchive() = delete;
+        explicit AssetArchive(const std::filesystem::path& archivePath);
+
+        ~AssetArchive() = default;
+
+        AssetArchive(const AssetArchive& other) = delete;
+        AssetArchive& operator=(const AssetArchive& other) = delete;
+
+        /// @brief The entry packed under `filePath`, or nothing when the archive does not
+        /// hold the file.
+        ///
+        /// @note Paths are compared in their lexically normal generic form, so the path a
+        /// loader opens a loose file by finds the same file in the archive.
+        std::optional<AssetArchiveEntry> find(const std::string& filePath) const;
+
+        /// @brief The stored contents of an uncompressed entry, without a copy.
+        std::span<const uint8_t> getStoredBytes(const AssetArchiveEntry& entry) const;
+
+        /// @brief The uncompressed contents of an entry.
+        ///
+        /// @note The contents are checked against the hash of the entry, so a corrupt
+        /// archive is reported rather than handed to a parser.
+        std::vector<uint8_t> read(const AssetArchiveEntry& entry) const;
+
+        /// @brief The uncompressed contents of one block of a block-compressed entry.
+        ///
+        /// @note Loaders read the first block of an entry the GPU expands to parse its header
+        /// without decompressing the rest. A single block is not checked against the hash,
+        /// which covers the whole entry.
+        std::vector<uint8_t> readBlock(const AssetArchiveEntry& entry, uint64_t blockIndex) const;
+
+        /// @brief The number of blocks a block-compressed entry is stored in.
+        static uint64_t getBlockCount(const AssetArchiveEntry& entry);
+
+        const std::string& getFilePath() const;
+
+        /// @brief Pack the files at `filePaths` into a new archive at `archivePath`.
+        ///
+        /// @note The files are packed under the paths they are given by, so they should be
+        /// the paths the loaders open them with.
+        static void write(const std::filesystem::path& archivePath, const std::vector<std::string>& filePaths);
+
+        /// @brief Read assets from the archive at `archivePath` from now on, ahead of the
+        /// loose files.
+        ///
+        /// @note Must be called before any asset is loaded, once, like at startup. The
+        /// archive is never changed afterwards, so every thread can read from it.
+        static void mount(const std::filesystem::path& archivePath);
+
+        /// @brief The mounted archive, or `nullptr` when none is mounted.
+        static const AssetArchive* getMounted();
+    private:
+        std::string m_filePath;
+        MappedFile m_file;
+        std::unordered_map<std::string, AssetArchiveEntry> m_entries;
+
+        static std::string normalizePath(const std::string& filePath);
+};
+
+/// @brief The contents of an asset file, read from the mounted archive when it holds the
+/// file and mapped from disk otherwise.
+///
+/// @note Loaders read assets through it in place of a `MappedFile`. Only compressed
+/// entries are copied, since they have to be decompressed somewhere, and only they are
+/// checked against their hashes on the way. Uncompressed entries are handed out straight
+/// from the mapping, like a loose file.
+class AssetFile final {
+    public:
+        explicit AssetFile() = delete;
+        explicit AssetFile(const std::string& filePath);
+
+        ~AssetFile() = default;
+
+        AssetFile(const AssetFile& other) = delete;
+        AssetFile& operator=(const AssetFile& other) = delete;
+
+        /// @brief Whether the asset can be opened, from the mounted archive or from disk.
+        static bool exists(const std::string& filePath);
+
+        const uint8_t* getData() const;
+
+        size_t getSize() const;
+
+        std::span<const uint8_t> getBytes() const;
+
+        /// @brief Where the contents sit unchanged on disk, or nothing for a compressed
+        /// entry.
+        ///
+        /// @note Readers that read ranges of the asset straight into memory of their own,
+        /// like staging slices, read them from there rather than through the mapping.
+        const std::optional<AssetFileRegion>& getFileRegion() const;
+    private:
+        std::optional<MappedFile> m_file;
+        std::vector<uint8_t> m_decompressedData;
+        std::span<const uint8_t> m_bytes;
+        std::optional<AssetFileRegion> m_fileRegion;
+};
+
+}
+
+#endif // _ASSET_ARCHIVE_H
@@ -0,0 +1,38 @@
+#include "asset_registry.h"
+
+#include <system_error>
+
+#include "cache_source_key.h"
+
+
+using AssetKey = VulkanEngine::AssetKey;
+using AssetKeyHash = VulkanEngine::AssetKeyHash;
+using CacheSourceKey = VulkanEngine::CacheSourceKey;
+
+AssetKey AssetKey::create(const std::filesystem::path& sourcePath, uint64_t settingsHash) {
+    // A file that does not exist yet still gets a key, from the part of its path that does.
+    auto errorCode = std::error_code {};
+    auto canonicalPath = std::filesystem::weakly_canonical(sourcePath, errorCode);
+    if (errorCode) {
+        canonicalPath = std::filesystem::absolute(sourcePath).lexically_normal();
+    }
+
+    return AssetKey {
+        .path = canonicalPath.generic_string(),
+        .settingsHash = settingsHash,
+    };
+}
+
+size_t AssetKeyHash::operator()(const AssetKey& key) const {
+    const auto pathHash = CacheSourceKey::hashBytes(
+        reinterpret_cast<const uint8_t*>(key.path.data()),
+        key.path.size(),
+        CacheSourceKey::FNV_OFFSET_BASIS
+    );
+
+    return static_cast<size_t>(CacheSourceKey::hashBytes(
+        reinterpret_cast<const uint8_t*>(&key.settingsHash),
+        sizeof(key.settingsHash),
+        pathHash
+    ));
+}
@@ -0,0 +1,263 @@
+#ifndef _ASSET_REGISTRY_H
+#define _ASSET_REGISTRY_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief Identifies an asset by the canonical path of its source file and a hash of the
+/// settings it is imported with, so the same file imported two ways is two assets.
+struct AssetKey final {
+    std::string path;
+    uint64_t settingsHash = 0;
+
+    /// @brief The key of `sourcePath`, with `.` and `..` and symbolic links resolved, so
+    /// every spelling of the same file gives the same key.
+    static AssetKey create(const std::filesystem::path& sourcePath, uint64_t settingsHash);
+
+    bool operator==(const AssetKey& other) const = default;
+};
+
+struct AssetKeyHash final {
+    size_t operator()(const AssetKey& key) const;
+};
+
+/// @brief An asset a loader has produced, and the memory it holds.
+template <typename Asset>
+struct LoadedAsset final {
+    Asset asset;
+    size_t byteSize;
+};
+
+struct AssetRegistryStatistics final {
+    uint32_t liveCount = 0;
+    uint32_t cachedCount = 0;
+    size_t cachedBytes = 0;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+};
+
+/// @brief Loads every asset once, however many times it is asked for, and hands out
+/// reference-counted handles to it.
+///
+/// @note An asset is live while any handle to it is held. Once the last one is dropped,
+/// `collect` moves the asset into a cache of released assets, from which asking for it
+/// again brings it back without loading it. The cache holds the assets released most
+/// recently, up to its budget, and evicts the least recently released ones beyond it.
+///
+/// The registry serves both levels of an asset: with decoded meshes and pixels it is the
+/// CPU-side cache between the loaders and the upload, and with the buffers and images they
+/// were uploaded into it is the GPU-resident set, where evicting an asset frees its memory
+/// through the eviction function, like queueing its resources on a `GpuResourceTable`.
+///
+/// Any thread may ask for assets. A thread that asks for an asset another thread is still
+/// loading waits for that load rather than starting its own, and an asset whose loader
+/// threw is forgotten, so asking for it again loads it again. Handles have to be dropped,
+/// and `collect` called, for the registry to evict anything, which it does on the thread
+/// that calls `collect`. Destroying the registry evicts every asset, whether or not it is
+/// still live.
+template <typename Asset>
+class AssetRegistry final {
+    public:
+        using Handle = std::shared_ptr<const Asset>;
+        using Load = std::function<LoadedAsset<Asset>()>;
+        using Evict = std::function<void(const Asset& asset)>;
+
+        explicit AssetRegistry() = delete;
+        explicit AssetRegistry(size_t cacheBudget, Evict evict = nullptr);
+
+        ~AssetRegistry();
+
+        AssetRegistry(const AssetRegistry& other) = delete;
+        AssetRegistry& operator=(const AssetRegistry& other) = delete;
+
+        /// @brief The asset of `key`, which `load` is only called for when the asset is
+        /// neither live nor cached.
+        ///
+        /// @note Rethrows the error of the load, also to the threads that waited on it.
+        Handle acquire(const AssetKey& key, const Load& load);
+
+        /// @brief Move the assets nothing holds a handle to any more into the cache, and
+        /// evict the least recently released ones beyond the budget.
+        void collect();
+
+        AssetRegistryStatistics getStatistics() const;
+    private:
+        struct Loaded final {
+            Handle asset;
+            size_t byteSize;
+        };
+
+        struct Entry final {
+            std::shared_future<Loaded> loaded;
+            bool isCached;
+            /// @brief The place of the entry in `m_cachedKeys`, while it is cached.
+            typename std::list<AssetKey>::iterator cachePosition;
+        };
+
+        size_t m_cacheBudget;
+        Evict m_evict;
+        mutable std::mutex m_mutex;
+        std::unordered_map<AssetKey, Entry, AssetKeyHash> m_entries;
+        /// @brief The keys of the cached assets, the most recently released first.
+        std::list<AssetKey> m_cachedKeys;
+        size_t m_cachedBytes;
+        uint64_t m_hitCount;
+        uint64_t m_missCount;
+
+        static bool isReady(const std::shared_future<Loaded>& loaded);
+};
+
+template <typename Asset>
+AssetRegistry<Asset>::AssetRegistry(size_t cacheBudget, Evict evict)
+    : m_cacheBudget { cacheBudget }
+    , m_evict { std::move(evict) }
+    , m_entries {}
+    , m_cachedKeys {}
+    , m_cachedBytes { 0 }
+    , m_hitCount { 0 }
+    , m_missCount { 0 }
+{
+}
+
+template <typename Asset>
+AssetRegistry<Asset>::~AssetRegistry() {
+    for (auto& [key, entry] : m_entries) {
+        if (m_evict && AssetRegistry::isReady(entry.loaded)) {
+            m_evict(*entry.loaded.get().asset);
+        }
+    }
+
+    m_entries.clear();
+    m_cachedKeys.clear();
+    m_cachedBytes = 0;
+}
+
+template <typename Asset>
+typename AssetRegistry<Asset>::Handle AssetRegistry<Asset>::acquire(const AssetKey& key, const Load& load) {
+    auto promise = std::promise<Loaded> {};
+    auto existing = std::shared_future<Loaded> {};
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        auto found = m_entries.find(key);
+        if (found != m_entries.end()) {
+            auto& entry = found->second;
+            if (entry.isCached) {
+                m_cachedBytes -= entry.loaded.get().byteSize;
+                m_cachedKeys.erase(entry.cachePosition);
+                entry.isCached = false;
+            }
+            existing = entry.loaded;
+            m_hitCount++;
+        } else {
+            m_entries.emplace(key, Entry {
+                .loaded = promise.get_future().share(),
+                .isCached = false,
+                .cachePosition = {},
+            });
+            m_missCount++;
+        }
+    }
+
+    // The load may still be running on another thread, so it is waited for outside the
+    // lock.
+    if (existing.valid()) {
+        return existing.get().asset;
+    }
+
+    try {
+        auto loadedAsset = load();
+        const auto loaded = Loaded {
+            .asset = std::make_shared<const Asset>(std::move(loadedAsset.asset)),
+            .byteSize = loadedAsset.byteSize,
+        };
+        promise.set_value(loaded);
+
+        return loaded.asset;
+    } catch (...) {
+        // The entry goes before the error is set, so that only the threads already waiting
+        // on the load ever see it fail.
+        {
+            const auto lock = std::lock_guard<std::mutex> { m_mutex };
+            m_entries.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+
+        throw;
+    }
+}
+
+template <typename Asset>
+void AssetRegistry<Asset>::collect() {
+    auto evicted = std::vector<Handle> {};
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        for (auto& [key, entry] : m_entries) {
+            // The shared state of the load holds the only handle left once every caller has
+            // dropped theirs.
+            if (entry.isCached || !AssetRegistry::isReady(entry.loaded)) {
+                continue;
+            }
+
+            const auto& loaded = entry.loaded.get();
+            if (loaded.asset.use_count() == 1) {
+                m_cachedKeys.push_front(key);
+                entry.cachePosition = m_cachedKeys.begin();
+                entry.isCached = true;
+                m_cachedBytes += loaded.byteSize;
+            }
+        }
+
+        while (m_cachedBytes > m_cacheBudget && !m_cachedKeys.empty()) {
+            const auto found = m_entries.find(m_cachedKeys.back());
+            const auto& loaded = found->second.loaded.get();
+            m_cachedBytes -= loaded.byteSize;
+            evicted.push_back(loaded.asset);
+            m_cachedKeys.pop_back();
+            m_entries.erase(found);
+        }
+    }
+
+    // The registry no longer knows the evicted assets, so evicting them needs no lock.
+    for (const auto& asset : evicted) {
+        if (m_evict) {
+            m_evict(*asset);
+        }
+    }
+}
+
+template <typename Asset>
+AssetRegistryStatistics AssetRegistry<Asset>::getStatistics() const {
+    const auto lock = std::lock_guard<std::mutex> { m_mutex };
+
+    return AssetRegistryStatistics {
+        .liveCount = static_cast<uint32_t>(m_entries.size() - m_cachedKeys.size()),
+        .cachedCount = static_cast<uint32_t>(m_cachedKeys.size()),
+        .cachedBytes = m_cachedBytes,
+        .hitCount = m_hitCount,
+        .missCount = m_missCount,
+    };
+}
+
+template <typename Asset>
+bool AssetRegistry<Asset>::isReady(const std::shared_future<Loaded>& loaded) {
+    return loaded.wait_for(std::chrono::seconds { 0 }) == std::future_status::ready;
+}
+
+}
+
+#endif // _ASSET_REGISTRY_H
@@ -0,0 +1,227 @@
+#include "asset_streamer.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+
+using AssetStreamer = VulkanEngine::AssetStreamer;
+using AssetHandle = VulkanEngine::AssetHandle;
+using PreparedAsset = VulkanEngine::PreparedAsset;
+
+AssetStreamer::AssetStreamer(uint32_t threadCount, size_t memoryBudget, CpuSet cpus)
+    : m_memoryBudget { memoryBudget }
+    , m_preparedSize { 0 }
+    , m_pendingCount { 0 }
+    , m_isStopping { false }
+{
+    for (uint32_t i = 0; i < std::max(threadCount, 1u); i++) {
+        m_workers.emplace_back([this, cpus]() {
+            CpuTopology::pinCurrentThread(cpus);
+            this->run();
+        });
+    }
+}
+
+AssetStreamer::~AssetStreamer() {
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        m_isStopping = true;
+        m_queue = std::priority_queue<QueueEntry> {};
+    }
+
+    m_workAvailable.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+
+    m_requests.clear();
+    m_preparedHandles.clear();
+}
+
+AssetHandle AssetStreamer::request(int32_t priority, PrepareAsset prepare) {
+    auto handle = INVALID_HANDLE;
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        handle = static_cast<AssetHandle>(m_requests.size());
+        m_requests.push_back(Request {
+            .priority = priority,
+            .status = RequestStatus::Queued,
+            .prepare = std::move(prepare),
+            .asset = PreparedAsset {},
+            .error = nullptr,
+        });
+        m_queue.push(QueueEntry { .priority = priority, .handle = handle });
+        m_pendingCount++;
+    }
+
+    m_workAvailable.notify_one();
+
+    return handle;
+}
+
+void AssetStreamer::setPriority(AssetHandle handle, int32_t priority) {
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        auto& request = this->getRequest(handle);
+        if (request.priority == priority) {
+            return;
+        }
+
+        request.priority = priority;
+        if (request.status == RequestStatus::Queued) {
+            m_queue.push(QueueEntry { .priority = priority, .handle = handle });
+        }
+    }
+
+    m_workAvailable.notify_one();
+}
+
+void AssetStreamer::cancel(AssetHandle handle) {
+    // The asset is destroyed outside of the lock, since it can own a lot of memory.
+    auto asset = PreparedAsset {};
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        auto& request = this->getRequest(handle);
+        if (request.status == RequestStatus::Published || request.status == RequestStatus::Cancelled) {
+            return;
+        }
+
+        if (request.status == RequestStatus::Prepared) {
+            m_preparedHandles.erase(std::find(m_preparedHandles.begin(), m_preparedHandles.end(), handle));
+            m_preparedSize -= request.asset.byteSize;
+            asset = std::exchange(request.asset, PreparedAsset {});
+        }
+
+        // A request that is still being prepared drops its asset once it is done.
+        request.status = RequestStatus::Cancelled;
+        request.prepare = nullptr;
+        request.error = nullptr;
+        m_pendingCount--;
+    }
+
+    m_workAvailable.notify_all();
+}
+
+bool AssetStreamer::hasPending() const {
+    const auto lock = std::lock_guard<std::mutex> { m_mutex };
+
+    return m_pendingCount > 0;
+}
+
+size_t AssetStreamer::getPendingCount() const {
+    const auto lock = std::lock_guard<std::mutex> { m_mutex };
+
+    return m_pendingCount;
+}
+
+void AssetStreamer::publishReady() {
+    this->publishReady([](size_t) { return true; });
+}
+
+void AssetStreamer::publishReady(const CanPublish& canPublish) {
+    while (true) {
+        auto asset = PreparedAsset {};
+        auto error = std::exception_ptr { nullptr };
+        {
+            const auto lock = std::lock_guard<std::mutex> { m_mutex };
+            if (m_preparedHandles.empty()) {
+                return;
+            }
+
+            const auto next = std::max_element(m_preparedHandles.begin(), m_preparedHandles.end(), [this](AssetHandle lhs, AssetHandle rhs) {
+                return QueueEntry { m_requests[lhs].priority, lhs } < QueueEntry { m_requests[rhs].priority, rhs };
+            });
+            auto& request = m_requests[*next];
+            if (!canPublish(request.asset.byteSize)) {
+                return;
+            }
+
+            m_preparedHandles.erase(next);
+            m_preparedSize -= request.asset.byteSize;
+            m_pendingCount--;
+            request.status = RequestStatus::Published;
+            asset = std::exchange(request.asset, PreparedAsset {});
+            error = std::exchange(request.error, nullptr);
+        }
+
+        // The memory the asset held may let a worker start the next request.
+        m_workAvailable.notify_all();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
+        // Publishing runs unlocked, so that it can make requests of its own.
+        asset.publish();
+    }
+}
+
+AssetStreamer::Request& AssetStreamer::getRequest(AssetHandle handle) {
+    if (handle >= m_requests.size()) {
+        throw std::invalid_argument("unknown asset handle!");
+    }
+
+    return m_requests[handle];
+}
+
+void AssetStreamer::discardStaleEntries() {
+    while (!m_queue.empty()) {
+        const auto& entry = m_queue.top();
+        const auto& request = m_requests[entry.handle];
+        if (request.status == RequestStatus::Queued && request.priority == entry.priority) {
+            return;
+        }
+
+        m_queue.pop();
+    }
+}
+
+void AssetStreamer::run() {
+    while (true) {
+        auto lock = std::unique_lock<std::mutex> { m_mutex };
+        m_workAvailable.wait(lock, [this]() {
+            if (m_isStopping) {
+                return true;
+            }
+
+            this->discardStaleEntries();
+
+            return !m_queue.empty() && m_preparedSize < m_memoryBudget;
+        });
+        if (m_isStopping) {
+            return;
+        }
+
+        const auto handle = m_queue.top().handle;
+        m_queue.pop();
+        auto& request = m_requests[handle];
+        request.status = RequestStatus::Preparing;
+        auto prepare = std::exchange(request.prepare, nullptr);
+        lock.unlock();
+
+        auto asset = PreparedAsset {};
+        auto error = std::exception_ptr { nullptr };
+        try {
+            asset = prepare();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        // The vector of requests may have grown while the lock was released.
+        auto& preparedRequest = m_requests[handle];
+        if (preparedRequest.status == RequestStatus::Cancelled) {
+            lock.unlock();
+
+            continue;
+        }
+
+        preparedRequest.status = RequestStatus::Prepared;
+        preparedRequest.error = error;
+        if (!error) {
+            m_preparedSize += asset.byteSize;
+            preparedRequest.asset = std::move(asset);
+        }
+        m_preparedHandles.push_back(handle);
+    }
+}
@@ -0,0 +1,151 @@
+#ifndef _ASSET_STREAMER_H
+#define _ASSET_STREAMER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "cpu_topology.h"
+
+
+namespace VulkanEngine {
+
+/// @brief Identifies a request made of an `AssetStreamer`.
+using AssetHandle = uint32_t;
+
+/// @brief An asset a worker has prepared, and how to publish it.
+///
+/// @note The size counts the memory the asset holds until it is published, like decoded
+/// pixels waiting for their upload.
+struct PreparedAsset final {
+    size_t byteSize;
+    std::function<void()> publish;
+};
+
+/// @brief Prepares assets on a pool of worker threads, most urgent first, and hands them
+/// to the frame loop to publish between frames.
+///
+/// @note Preparing an asset is the part of loading it that needs no device, like reading
+/// and decoding files, so it runs on a worker. Publishing it is the part that does, like
+/// recording its upload, so it runs on the thread that calls `publishReady` at a frame
+/// boundary, and never races the commands of a frame. A request with a higher priority
+/// starts first, and requests with the same priority start in the order they were made.
+///
+/// The assets that were prepared but not published yet hold their memory until they are.
+/// Workers only start a request while those assets fit inside the memory budget, so the
+/// memory goes over the budget by at most the assets that are still being prepared.
+///
+/// The workers are pinned to the CPUs given, if any.
+class AssetStreamer final {
+    public:
+        using PrepareAsset = std::function<PreparedAsset()>;
+        /// @brief Whether an asset of `byteSize` bytes may be published now.
+        using CanPublish = std::function<bool(size_t byteSize)>;
+
+        static constexpr AssetHandle INVALID_HANDLE = std::numeric_limits<AssetHandle>::max();
+
+        explicit AssetStreamer() = delete;
+        explicit AssetStreamer(uint32_t threadCount, size_t memoryBudget, CpuSet cpus = {});
+
+        /// @brief Drop the requests that have not started and the assets that were not
+        /// published, and wait for the running ones.
+        ~AssetStreamer();
+
+        AssetStreamer(const AssetStreamer& other) = delete;
+        AssetStreamer& operator=(const AssetStreamer& other) = delete;
+
+        AssetHandle request(int32_t priority, PrepareAsset prepare);
+
+        /// @brief Change the priority of a request, which decides when it starts, if it has
+        /// not started yet, and when it is published otherwise.
+        void setPriority(AssetHandle handle, int32_t priority);
+
+        /// @brief Drop a request that has not started, or the asset of one that has, so
+        /// that it is never published.
+        ///
+        /// @note A request that was already published is left as it is.
+        void cancel(AssetHandle handle);
+
+        /// @brief Whether any request was neither published nor cancelled yet.
+        bool hasPending() const;
+
+        /// @brief The requests that were neither published nor cancelled yet.
+        size_t getPendingCount() const;
+
+        /// @brief Publish every asset that is prepared, the most urgent first.
+        ///
+        /// @note A request whose preparation failed rethrows its error here.
+        void publishReady();
+
+        /// @brief Publish the prepared assets, the most urgent first, for as long as
+        /// `canPublish` lets the next one through.
+        ///
+        /// @note The first asset turned away stops publishing, so a less urgent asset never
+        /// goes ahead of a more urgent one. It stays prepared for the next call. `canPublish`
+        /// is called while the streamer is locked, so it must not call back into it.
+        void publishReady(const CanPublish& canPublish);
+    private:
+        enum class RequestStatus {
+            Queued,
+            Preparing,
+            Prepared,
+            Published,
+            Cancelled
+        };
+
+        struct Request final {
+            int32_t priority;
+            RequestStatus status;
+            PrepareAsset prepare;
+            PreparedAsset asset;
+            std::exception_ptr error;
+        };
+
+        /// @brief An entry of the queue of requests waiting to start.
+        ///
+        /// @note Changing a priority queues the request again rather than moving its entry,
+        /// so an entry whose priority no longer matches its request is skipped when it comes
+        /// up.
+        struct QueueEntry final {
+            int32_t priority;
+            AssetHandle handle;
+
+            bool operator<(const QueueEntry& other) const {
+                if (priority != other.priority) {
+                    return priority < other.priority;
+                }
+
+                return handle > other.handle;
+            }
+        };
+
+        size_t m_memoryBudget;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_workAvailable;
+        std::priority_queue<QueueEntry> m_queue;
+        std::vector<Request> m_requests;
+        std::vector<AssetHandle> m_preparedHandles;
+        size_t m_preparedSize;
+        size_t m_pendingCount;
+        bool m_isStopping;
+        std::vector<std::thread> m_workers;
+
+        Request& getRequest(AssetHandle handle);
+
+        /// @brief Drop the entries at the front of the queue that no longer stand for a
+        /// request waiting to start.
+        void discardStaleEntries();
+
+        void run();
+};
+
+}
+
+#endif // _ASSET_STREAMER_H
@@ -0,0 +1,561 @@
+#include "async_file_reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+
+using AsyncFileReader = VulkanEngine::AsyncFileReader;
+using AsyncReadHandle = VulkanEngine::AsyncReadHandle;
+using AsyncReadRequest = VulkanEngine::AsyncReadRequest;
+
+namespace VulkanEngine {
+
+struct AsyncReadBatch final {
+    /// @brief The file descriptor, or the `HANDLE` on Windows.
+    intptr_t file;
+    /// @brief The chunks that have not landed, and one more while the batch is being
+    /// submitted.
+    std::atomic<size_t> pendingChunkCount;
+    AsyncFileReader::Completion completion;
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool isDone;
+    std::exception_ptr error;
+};
+
+}
+
+#if defined(_WIN32)
+
+static intptr_t openFile(const std::string& filePath) {
+    const auto file = CreateFileA(
+        filePath.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open file for reading!");
+    }
+
+    return reinterpret_cast<intptr_t>(file);
+}
+
+static void closeFile(intptr_t file) {
+    CloseHandle(reinterpret_cast<HANDLE>(file));
+}
+
+/// @brief Read `size` bytes at `fileOffset`, or fewer only at the end of the file.
+static uint64_t readFileAt(intptr_t file, uint64_t fileOffset, uint64_t size, uint8_t* destination) {
+    auto totalRead = uint64_t { 0 };
+    while (totalRead < size) {
+        const auto offset = fileOffset + totalRead;
+        auto overlapped = OVERLAPPED {};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xffffffff);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        const auto readSize = static_cast<DWORD>(std::min<uint64_t>(size - totalRead, AsyncFileReader::CHUNK_SIZE));
+        auto bytesRead = DWORD { 0 };
+        if (!ReadFile(reinterpret_cast<HANDLE>(file), destination + totalRead, readSize, &bytesRead, &overlapped)) {
+            if (GetLastError() == ERROR_HANDLE_EOF) {
+                break;
+            }
+
+            throw std::runtime_error("failed to read file!");
+        }
+
+        if (bytesRead == 0) {
+            break;
+        }
+
+        totalRead += bytesRead;
+    }
+
+    return totalRead;
+}
+
+#else
+
+static intptr_t openFile(const std::string& filePath) {
+    const auto file = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        throw std::runtime_error("failed to open file for reading!");
+    }
+
+    return static_cast<intptr_t>(file);
+}
+
+static void closeFile(intptr_t file) {
+    close(static_cast<int>(file));
+}
+
+/// @brief Read `size` bytes at `fileOffset`, or fewer only at the end of the file.
+static uint64_t readFileAt(intptr_t file, uint64_t fileOffset, uint64_t size, uint8_t* destination) {
+    auto totalRead = uint64_t { 0 };
+    while (totalRead < size) {
+        const auto bytesRead = pread(
+            static_cast<int>(file),
+            destination + totalRead,
+            static_cast<size_t>(size - totalRead),
+            static_cast<off_t>(fileOffset + totalRead)
+        );
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            throw std::runtime_error("failed to read file!");
+        }
+
+        if (bytesRead == 0) {
+            break;
+        }
+
+        totalRead += static_cast<uint64_t>(bytesRead);
+    }
+
+    return totalRead;
+}
+
+#endif
+
+#if defined(__linux__)
+
+/// @brief An io_uring set up through its system calls, with the submission and completion
+/// rings mapped.
+///
+/// @note The reader is the only producer of submissions and the completion thread the only
+/// consumer of completions, so the rings need no locks of their own beyond the one that
+/// serializes submitting threads.
+struct AsyncFileReader::IoRing final {
+    int fd;
+    void* submissionRing;
+    size_t submissionRingSize;
+    void* completionRing;
+    size_t completionRingSize;
+    io_uring_sqe* submissionEntries;
+    size_t submissionEntriesSize;
+    uint32_t* submissionTail;
+    uint32_t submissionMask;
+    uint32_t* submissionArray;
+    uint32_t* completionHead;
+    uint32_t* completionTail;
+    uint32_t completionMask;
+    io_uring_cqe* completionEntries;
+    std::mutex submitMutex;
+
+    explicit IoRing(uint32_t entryCount)
+        : fd { -1 }
+        , submissionRing { MAP_FAILED }
+        , submissionRingSize { 0 }
+        , completionRing { MAP_FAILED }
+        , completionRingSize { 0 }
+        , submissionEntries { static_cast<io_uring_sqe*>(MAP_FAILED) }
+        , submissionEntriesSize { 0 }
+    {
+        auto params = io_uring_params {};
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entryCount, &params));
+        if (fd < 0) {
+            throw std::runtime_error("failed to set up io_uring!");
+        }
+
+        // Kernels before 5.6 have io_uring, but neither the read operation nor the probe.
+        auto probeStorage = std::vector<uint8_t>(sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op));
+        auto* probe = reinterpret_cast<io_uring_probe*>(probeStorage.data());
+        const auto probeResult = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST);
+        if (probeResult < 0 || probe->last_op < IORING_OP_READ || (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) == 0) {
+            this->destroy();
+
+            throw std::runtime_error("failed to set up io_uring: reads are not supported!");
+        }
+
+        submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const auto isSingleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (isSingleMapping) {
+            submissionRingSize = std::max(submissionRingSize, completionRingSize);
+        }
+
+        submissionRing = mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (submissionRing == MAP_FAILED) {
+            this->destroy();
+
+            throw std::runtime_error("failed to map io_uring submission ring!");
+        }
+
+        if (isSingleMapping) {
+            completionRing = submissionRing;
+            completionRingSize = 0;
+        } else {
+            completionRing = mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (completionRing == MAP_FAILED) {
+                this->destroy();
+
+                throw std::runtime_error("failed to map io_uring completion ring!");
+            }
+        }
+
+        submissionEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+        submissionEntries = static_cast<io_uring_sqe*>(
+            mmap(nullptr, submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES)
+        );
+        if (submissionEntries == MAP_FAILED) {
+            this->destroy();
+
+            throw std::runtime_error("failed to map io_uring submission entries!");
+        }
+
+        auto* submissionBase = static_cast<uint8_t*>(submissionRing);
+        submissionTail = reinterpret_cast<uint32_t*>(submissionBase + params.sq_off.tail);
+        submissionMask = *reinterpret_cast<uint32_t*>(submissionBase + params.sq_off.ring_mask);
+        submissionArray = reinterpret_cast<uint32_t*>(submissionBase + params.sq_off.array);
+
+        auto* completionBase = static_cast<uint8_t*>(completionRing);
+        completionHead = reinterpret_cast<uint32_t*>(completionBase + params.cq_off.head);
+        completionTail = reinterpret_cast<uint32_t*>(completionBase + params.cq_off.tail);
+        completionMask = *reinterpret_cast<uint32_t*>(completionBase + params.cq_off.ring_mask);
+        completionEntries = reinterpret_cast<io_uring_cqe*>(completionBase + params.cq_off.cqes);
+    }
+
+    ~IoRing() {
+        this->destroy();
+    }
+
+    /// @brief Queue a submission entry and hand it to the kernel.
+    void submit(const io_uring_sqe& entry) {
+        const auto lock = std::lock_guard<std::mutex> { submitMutex };
+        // Every entry is consumed by the `io_uring_enter` that follows it, so the ring is
+        // empty whenever the lock is free.
+        const auto tail = *submissionTail;
+        const auto index = tail & submissionMask;
+        submissionEntries[index] = entry;
+        submissionArray[index] = index;
+        __atomic_store_n(submissionTail, tail + 1, __ATOMIC_RELEASE);
+
+        while (syscall(__NR_io_uring_enter, fd, 1, 0, 0, nullptr, 0) < 0) {
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                throw std::runtime_error("failed to submit io_uring read!");
+            }
+        }
+    }
+
+    void destroy() {
+        if (submissionEntries != MAP_FAILED) {
+            munmap(submissionEntries, submissionEntriesSize);
+            submissionEntries = static_cast<io_uring_sqe*>(MAP_FAILED);
+        }
+
+        if (completionRing != MAP_FAILED && completionRing != submissionRing) {
+            munmap(completionRing, completionRingSize);
+        }
+        completionRing = MAP_FAILED;
+
+        if (submissionRing != MAP_FAILED) {
+            munmap(submissionRing, submissionRingSize);
+            submissionRing = MAP_FAILED;
+        }
+
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+};
+
+#else
+
+struct AsyncFileReader::IoRing final {
+};
+
+#endif
+
+AsyncFileReader::AsyncFileReader(uint32_t queueDepth, CpuSet cpus)
+    : m_queueDepth { std::max(queueDepth, 1u) }
+    , m_ioRing { nullptr }
+    , m_inFlightCount { 0 }
+    , m_isStopping { false }
+{
+#if defined(__linux__)
+    // Sandboxes and hardened kernels may refuse io_uring, which the thread pool stands in for.
+    try {
+        m_ioRing = std::make_unique<IoRing>(m_queueDepth);
+    } catch (const std::runtime_error&) {
+        m_ioRing = nullptr;
+    }
+#endif
+
+    if (m_ioRing != nullptr) {
+        m_threads.emplace_back([this, cpus]() {
+            CpuTopology::pinCurrentThread(cpus);
+            this->reapIoRing();
+        });
+    } else {
+        for (uint32_t i = 0; i < m_queueDepth; i++) {
+            m_threads.emplace_back([this, cpus]() {
+                CpuTopology::pinCurrentThread(cpus);
+                this->runReadWorker();
+            });
+        }
+    }
+}
+
+AsyncFileReader::~AsyncFileReader() {
+#if defined(__linux__)
+    if (m_ioRing != nullptr) {
+        {
+            auto lock = std::unique_lock<std::mutex> { m_mutex };
+            m_slotAvailable.wait(lock, [this]() { return m_inFlightCount == 0; });
+        }
+
+        // A no-op without user data tells the completion thread to stop. Every read has
+        // landed, so nothing completes after it.
+        auto entry = io_uring_sqe {};
+        entry.opcode = IORING_OP_NOP;
+        entry.user_data = 0;
+        m_ioRing->submit(entry);
+    }
+#endif
+
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        m_isStopping = true;
+    }
+
+    m_chunkAvailable.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+
+    m_threads.clear();
+    m_ioRing.reset();
+}
+
+bool AsyncFileReader::usesIoRing() const {
+    return m_ioRing != nullptr;
+}
+
+AsyncReadHandle AsyncFileReader::submit(const std::string& filePath, std::span<const AsyncReadRequest> requests, Completion completion) {
+    const auto isReaderThread = std::ranges::any_of(m_threads, [](const std::thread& thread) {
+        return thread.get_id() == std::this_thread::get_id();
+    });
+    if (isReaderThread) {
+        throw std::logic_error("cannot submit reads from a thread of the file reader!");
+    }
+
+    auto batch = std::make_shared<AsyncReadBatch>();
+    batch->file = openFile(filePath);
+    batch->completion = std::move(completion);
+    batch->isDone = false;
+
+    auto chunks = std::vector<Chunk> {};
+    for (const auto& request : requests) {
+        auto* destination = static_cast<uint8_t*>(request.destination);
+        for (uint64_t offset = 0; offset < request.size; offset += CHUNK_SIZE) {
+            chunks.push_back(Chunk {
+                .batch = batch,
+                .fileOffset = request.fileOffset + offset,
+                .size = std::min(request.size - offset, CHUNK_SIZE),
+                .destination = destination + offset,
+            });
+        }
+    }
+
+    // The extra count keeps the batch from finishing before its last chunk is submitted.
+    batch->pendingChunkCount.store(chunks.size() + 1);
+    for (auto& chunk : chunks) {
+        if (m_ioRing != nullptr) {
+            this->submitToIoRing(std::move(chunk));
+        } else {
+            {
+                const auto lock = std::lock_guard<std::mutex> { m_mutex };
+                m_pendingChunks.push_back(std::move(chunk));
+            }
+            m_chunkAvailable.notify_one();
+        }
+    }
+
+    AsyncFileReader::finishChunk(Chunk { .batch = batch, .fileOffset = 0, .size = 0, .destination = nullptr }, nullptr);
+
+    return batch;
+}
+
+void AsyncFileReader::wait(const AsyncReadHandle& handle) {
+    auto lock = std::unique_lock<std::mutex> { handle->mutex };
+    handle->finished.wait(lock, [&handle]() { return handle->isDone; });
+    if (handle->error) {
+        std::rethrow_exception(handle->error);
+    }
+}
+
+void AsyncFileReader::submitToIoRing(Chunk chunk) {
+#if defined(__linux__)
+    {
+        auto lock = std::unique_lock<std::mutex> { m_mutex };
+        m_slotAvailable.wait(lock, [this]() { return m_inFlightCount < m_queueDepth; });
+        m_inFlightCount++;
+    }
+
+    // The completion thread takes the chunk back from the user data.
+    auto* inFlightChunk = new Chunk { std::move(chunk) };
+    auto entry = io_uring_sqe {};
+    entry.opcode = IORING_OP_READ;
+    entry.fd = static_cast<int>(inFlightChunk->batch->file);
+    entry.off = inFlightChunk->fileOffset;
+    entry.addr = reinterpret_cast<uint64_t>(inFlightChunk->destination);
+    entry.len = static_cast<uint32_t>(inFlightChunk->size);
+    entry.user_data = reinterpret_cast<uint64_t>(inFlightChunk);
+    m_ioRing->submit(entry);
+#else
+    static_cast<void>(chunk);
+#endif
+}
+
+void AsyncFileReader::reapIoRing() {
+#if defined(__linux__)
+    auto& ring = *m_ioRing;
+    auto isStopping = false;
+    while (!isStopping) {
+        const auto result = syscall(__NR_io_uring_enter, ring.fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (result < 0 && errno != EINTR) {
+            return;
+        }
+
+        auto head = *ring.completionHead;
+        const auto tail = __atomic_load_n(ring.completionTail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            const auto completion = ring.completionEntries[head & ring.completionMask];
+            head++;
+            if (completion.user_data == 0) {
+                isStopping = true;
+
+                continue;
+            }
+
+            auto chunk = std::unique_ptr<Chunk> { reinterpret_cast<Chunk*>(completion.user_data) };
+            {
+                const auto lock = std::lock_guard<std::mutex> { m_mutex };
+                m_inFlightCount--;
+            }
+            m_slotAvailable.notify_all();
+
+            // Short reads and failed reads finish with a blocking read, which either
+            // completes the chunk or reports the error.
+            auto error = std::exception_ptr { nullptr };
+            if (completion.res < 0 || static_cast<uint64_t>(completion.res) < chunk->size) {
+                const auto bytesRead = static_cast<uint64_t>(std::max(completion.res, 0));
+                const auto remainder = Chunk {
+                    .batch = chunk->batch,
+                    .fileOffset = chunk->fileOffset + bytesRead,
+                    .size = chunk->size - bytesRead,
+                    .destination = chunk->destination + bytesRead,
+                };
+                try {
+                    AsyncFileReader::readChunk(remainder);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+
+            AsyncFileReader::finishChunk(*chunk, error);
+        }
+
+        __atomic_store_n(ring.completionHead, head, __ATOMIC_RELEASE);
+    }
+#endif
+}
+
+void AsyncFileReader::runReadWorker() {
+    while (true) {
+        auto chunk = Chunk {};
+        {
+            auto lock = std::unique_lock<std::mutex> { m_mutex };
+            m_chunkAvailable.wait(lock, [this]() { return m_isStopping || !m_pendingChunks.empty(); });
+            if (m_pendingChunks.empty()) {
+                return;
+            }
+
+            chunk = std::move(m_pendingChunks.front());
+            m_pendingChunks.pop_front();
+        }
+
+        auto error = std::exception_ptr { nullptr };
+        try {
+            AsyncFileReader::readChunk(chunk);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        AsyncFileReader::finishChunk(chunk, error);
+    }
+}
+
+void AsyncFileReader::readChunk(const Chunk& chunk) {
+    const auto bytesRead = readFileAt(chunk.batch->file, chunk.fileOffset, chunk.size, chunk.destination);
+    if (bytesRead != chunk.size) {
+        throw std::runtime_error("failed to read file: unexpected end of file!");
+    }
+}
+
+void AsyncFileReader::finishChunk(const Chunk& chunk, std::exception_ptr error) {
+    auto& batch = *chunk.batch;
+    if (error) {
+        const auto lock = std::lock_guard<std::mutex> { batch.mutex };
+        if (!batch.error) {
+            batch.error = error;
+        }
+    }
+
+    if (batch.pendingChunkCount.fetch_sub(1) != 1) {
+        return;
+    }
+
+    closeFile(batch.file);
+
+    // The completion runs before the batch counts as done, so a waiter sees its effects.
+    auto batchError = std::exception_ptr { nullptr };
+    {
+        const auto lock = std::lock_guard<std::mutex> { batch.mutex };
+        batchError = batch.error;
+    }
+
+    if (batch.completion) {
+        try {
+            batch.completion(batchError);
+        } catch (...) {
+            batchError = std::current_exception();
+        }
+        batch.completion = nullptr;
+    }
+
+    {
+        const auto lock = std::lock_guard<std::mutex> { batch.mutex };
+        batch.error = batchError;
+        batch.isDone = true;
+    }
+    batch.finished.notify_all();
+}
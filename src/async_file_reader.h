@@ -0,0 +1,113 @@
+#ifndef _ASYNC_FILE_READER_H
+#define _ASYNC_FILE_READER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpu_topology.h"
+
+
+namespace VulkanEngine {
+
+/// @brief A range of a file to read, and the memory to read it into.
+struct AsyncReadRequest final {
+    uint64_t fileOffset = 0;
+    uint64_t size = 0;
+    void* destination = nullptr;
+};
+
+struct AsyncReadBatch;
+
+/// @brief Refers to the reads submitted to an `AsyncFileReader` together, for waiting on
+/// them.
+using AsyncReadHandle = std::shared_ptr<AsyncReadBatch>;
+
+/// @brief Reads ranges of files straight into caller memory, many reads at a time.
+///
+/// @note A submission is split into chunks of at most `CHUNK_SIZE` bytes, and every chunk
+/// is in flight at once, up to the queue depth, so a large texture keeps the device queue
+/// full instead of waiting on one read after another. On Linux the chunks go through an
+/// io_uring, and a completion thread reaps them. Where io_uring is missing or refused, and
+/// on other platforms, a pool of as many threads as the queue depth issues positional reads
+/// instead.
+///
+/// A submission can name a function to run once all of its reads have landed, like
+/// scheduling the job that decodes them. It runs on the thread that reaped the last read,
+/// so it should only hand the work on. It must not submit reads of its own, since a
+/// submission can wait for a queue slot that only that thread frees.
+///
+/// The threads of the reader, the completion thread or the read workers, are pinned to the
+/// CPUs given, if any.
+class AsyncFileReader final {
+    public:
+        using Completion = std::function<void(std::exception_ptr error)>;
+
+        static constexpr uint64_t CHUNK_SIZE = 1 << 20;
+
+        explicit AsyncFileReader() = delete;
+        explicit AsyncFileReader(uint32_t queueDepth, CpuSet cpus = {});
+
+        /// @brief Wait for every read in flight, then stop.
+        ~AsyncFileReader();
+
+        AsyncFileReader(const AsyncFileReader& other) = delete;
+        AsyncFileReader& operator=(const AsyncFileReader& other) = delete;
+
+        /// @brief Whether the reads go through an io_uring.
+        bool usesIoRing() const;
+
+        /// @brief Start reading every range of `requests` from `filePath`.
+        ///
+        /// @note Throws when called from a thread of the reader, such as from a completion.
+        AsyncReadHandle submit(const std::string& filePath, std::span<const AsyncReadRequest> requests, Completion completion = nullptr);
+
+        /// @brief Block until every read of the submission has landed.
+        ///
+        /// @note A read that failed, or came up short, rethrows its error here.
+        void wait(const AsyncReadHandle& handle);
+    private:
+        struct Chunk final {
+            AsyncReadHandle batch;
+            uint64_t fileOffset;
+            uint64_t size;
+            uint8_t* destination;
+        };
+
+        struct IoRing;
+
+        uint32_t m_queueDepth;
+        std::unique_ptr<IoRing> m_ioRing;
+        std::mutex m_mutex;
+        std::condition_variable m_chunkAvailable;
+        std::condition_variable m_slotAvailable;
+        std::deque<Chunk> m_pendingChunks;
+        uint32_t m_inFlightCount;
+        bool m_isStopping;
+        std::vector<std::thread> m_threads;
+
+        void submitToIoRing(Chunk chunk);
+
+        void reapIoRing();
+
+        void runReadWorker();
+
+        /// @brief Read a chunk with a blocking positional read.
+        static void readChunk(const Chunk& chunk);
+
+        static void finishChunk(const Chunk& chunk, std::exception_ptr error);
+};
+
+}
+
+#endif // _ASYNC_FILE_READER_H
@@ -0,0 +1,279 @@
+#include "barrier_batch.h"
+
+#include <stdexcept>
+
+#include "command_counters.h"
+
+
+using BarrierBatch = VulkanEngine::BarrierBatch;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+/// @brief The stages that use an image in a layout, what they read, and what they write.
+struct LayoutScope final {
+    VkPipelineStageFlags2 stages;
+    VkAccessFlags2 readAccess;
+    VkAccessFlags2 writeAccess;
+};
+
+static LayoutScope getLayoutScope(VkImageLayout layout) {
+    switch (layout) {
+        case VK_IMAGE_LAYOUT_UNDEFINED: return LayoutScope { VK_PIPELINE_STAGE_2_NONE, 0, 0 };
+        case VK_IMAGE_LAYOUT_PREINITIALIZED: return LayoutScope { VK_PIPELINE_STAGE_2_HOST_BIT, 0, VK_ACCESS_2_HOST_WRITE_BIT };
+        case VK_IMAGE_LAYOUT_GENERAL: return LayoutScope {
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            VK_ACCESS_2_MEMORY_READ_BIT,
+            VK_ACCESS_2_MEMORY_WRITE_BIT
+        };
+        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL: return LayoutScope {
+            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT,
+            VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT
+        };
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+        case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL: return LayoutScope {
+            VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+        };
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+        case VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL: return LayoutScope {
+            VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT |
+                VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+            0
+        };
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL: return LayoutScope {
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+            0
+        };
+        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: return LayoutScope {
+            VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_RESOLVE_BIT,
+            VK_ACCESS_2_TRANSFER_READ_BIT,
+            0
+        };
+        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: return LayoutScope {
+            VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_RESOLVE_BIT |
+                VK_PIPELINE_STAGE_2_CLEAR_BIT,
+            0,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT
+        };
+        case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR: return LayoutScope { VK_PIPELINE_STAGE_2_NONE, 0, 0 };
+        default: throw std::invalid_argument("unsupported image layout for a transition!");
+    }
+}
+
+/// @brief Whether two ranges of mip levels or array layers share any element, where a count
+/// of `remaining` runs to the end of the image.
+static bool rangesOverlap(uint32_t firstBase, uint32_t firstCount, uint32_t secondBase, uint32_t secondCount, uint32_t remaining) {
+    const auto firstEnd = firstCount == remaining ? UINT32_MAX : firstBase + firstCount;
+    const auto secondEnd = secondCount == remaining ? UINT32_MAX : secondBase + secondCount;
+
+    return firstBase < secondEnd && secondBase < firstEnd;
+}
+
+// The legacy stage and access bits have the same values in the synchronization2 masks, so
+// only the bits that split a legacy bit up need folding back into it.
+static VkPipelineStageFlags toLegacyStages(VkPipelineStageFlags2 stages, VkPipelineStageFlags emptyStages) {
+    auto legacyStages = static_cast<VkPipelineStageFlags>(stages & 0xffffffffull);
+    const auto transferStages = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_RESOLVE_BIT |
+        VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT;
+    if (stages & transferStages) {
+        legacyStages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+
+    if (stages & (VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT)) {
+        legacyStages |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    }
+
+    if (stages & VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT) {
+        legacyStages |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
+            VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT;
+    }
+
+    // An empty stage mask is only valid with synchronization2.
+    if (legacyStages == 0) {
+        return emptyStages;
+    }
+
+    return legacyStages;
+}
+
+static VkAccessFlags toLegacyAccess(VkAccessFlags2 access) {
+    auto legacyAccess = static_cast<VkAccessFlags>(access & 0xffffffffull);
+    if (access & (VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT)) {
+        legacyAccess |= VK_ACCESS_SHADER_READ_BIT;
+    }
+
+    if (access & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT) {
+        legacyAccess |= VK_ACCESS_SHADER_WRITE_BIT;
+    }
+
+    return legacyAccess;
+}
+
+BarrierBatch::BarrierBatch(bool useSynchronization2, std::pmr::memory_resource* memoryResource)
+    : m_useSynchronization2 { useSynchronization2 }
+    , m_memoryBarriers { std::pmr::vector<VkMemoryBarrier2> { memoryResource } }
+    , m_bufferBarriers { std::pmr::vector<VkBufferMemoryBarrier2> { memoryResource } }
+    , m_imageBarriers { std::pmr::vector<VkImageMemoryBarrier2> { memoryResource } }
+{
+}
+
+void BarrierBatch::transitionImage(
+    VkImage image,
+    const VkImageSubresourceRange& subresourceRange,
+    VkImageLayout oldLayout,
+    VkImageLayout newLayout
+) {
+    if (newLayout == VK_IMAGE_LAYOUT_UNDEFINED || newLayout == VK_IMAGE_LAYOUT_PREINITIALIZED) {
+        throw std::invalid_argument("images cannot be transitioned into an undefined or preinitialized layout!");
+    }
+
+    // Only writes need to be made available. Reads in the old layout just have to finish
+    // before the new layout is written, which the stages already see to.
+    const auto source = getLayoutScope(oldLayout);
+    const auto destination = getLayoutScope(newLayout);
+    this->addImageBarrier(VkImageMemoryBarrier2 {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+        .srcStageMask = source.stages,
+        .srcAccessMask = source.writeAccess,
+        .dstStageMask = destination.stages,
+        .dstAccessMask = destination.readAccess | destination.writeAccess,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = subresourceRange,
+    });
+}
+
+void BarrierBatch::addMemoryBarrier(const VkMemoryBarrier2& barrier) {
+    m_memoryBarriers.push_back(barrier);
+}
+
+void BarrierBatch::addBufferBarrier(const VkBufferMemoryBarrier2& barrier) {
+    m_bufferBarriers.push_back(barrier);
+}
+
+void BarrierBatch::addImageBarrier(const VkImageMemoryBarrier2& barrier) {
+    m_imageBarriers.push_back(barrier);
+}
+
+void BarrierBatch::flush(VkCommandBuffer commandBuffer) {
+    if (this->isEmpty()) {
+        return;
+    }
+
+    if (m_useSynchronization2) {
+        const auto dependencyInfo = VkDependencyInfo {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext = nullptr,
+            .dependencyFlags = 0,
+            .memoryBarrierCount = static_cast<uint32_t>(m_memoryBarriers.size()),
+            .pMemoryBarriers = m_memoryBarriers.data(),
+            .bufferMemoryBarrierCount = static_cast<uint32_t>(m_bufferBarriers.size()),
+            .pBufferMemoryBarriers = m_bufferBarriers.data(),
+            .imageMemoryBarrierCount = static_cast<uint32_t>(m_imageBarriers.size()),
+            .pImageMemoryBarriers = m_imageBarriers.data(),
+        };
+        vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+        CommandCounters::add(CommandCounter::Barriers);
+    } else {
+        this->flushLegacy(commandBuffer);
+    }
+
+    m_memoryBarriers.clear();
+    m_bufferBarriers.clear();
+    m_imageBarriers.clear();
+}
+
+bool BarrierBatch::hasImageBarrier(VkImage image, const VkImageSubresourceRange& subresourceRange) const {
+    for (const auto& barrier : m_imageBarriers) {
+        const auto& range = barrier.subresourceRange;
+        const auto overlaps = barrier.image == image &&
+            (range.aspectMask & subresourceRange.aspectMask) != 0 &&
+            rangesOverlap(range.baseMipLevel, range.levelCount, subresourceRange.baseMipLevel, subresourceRange.levelCount, VK_REMAINING_MIP_LEVELS) &&
+            rangesOverlap(range.baseArrayLayer, range.layerCount, subresourceRange.baseArrayLayer, subresourceRange.layerCount, VK_REMAINING_ARRAY_LAYERS);
+        if (overlaps) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool BarrierBatch::isEmpty() const {
+    return m_memoryBarriers.empty() && m_bufferBarriers.empty() && m_imageBarriers.empty();
+}
+
+void BarrierBatch::flushLegacy(VkCommandBuffer commandBuffer) {
+    auto srcStageMask = VkPipelineStageFlags2 { VK_PIPELINE_STAGE_2_NONE };
+    auto dstStageMask = VkPipelineStageFlags2 { VK_PIPELINE_STAGE_2_NONE };
+
+    // The legacy barriers come from the same memory as the batch's own.
+    auto* memoryResource = m_memoryBarriers.get_allocator().resource();
+    auto memoryBarriers = std::pmr::vector<VkMemoryBarrier> { memoryResource };
+    memoryBarriers.reserve(m_memoryBarriers.size());
+    for (const auto& barrier : m_memoryBarriers) {
+        srcStageMask |= barrier.srcStageMask;
+        dstStageMask |= barrier.dstStageMask;
+        memoryBarriers.push_back(VkMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = toLegacyAccess(barrier.srcAccessMask),
+            .dstAccessMask = toLegacyAccess(barrier.dstAccessMask),
+        });
+    }
+
+    auto bufferBarriers = std::pmr::vector<VkBufferMemoryBarrier> { memoryResource };
+    bufferBarriers.reserve(m_bufferBarriers.size());
+    for (const auto& barrier : m_bufferBarriers) {
+        srcStageMask |= barrier.srcStageMask;
+        dstStageMask |= barrier.dstStageMask;
+        bufferBarriers.push_back(VkBufferMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = toLegacyAccess(barrier.srcAccessMask),
+            .dstAccessMask = toLegacyAccess(barrier.dstAccessMask),
+            .srcQueueFamilyIndex = barrier.srcQueueFamilyIndex,
+            .dstQueueFamilyIndex = barrier.dstQueueFamilyIndex,
+            .buffer = barrier.buffer,
+            .offset = barrier.offset,
+            .size = barrier.size,
+        });
+    }
+
+    auto imageBarriers = std::pmr::vector<VkImageMemoryBarrier> { memoryResource };
+    imageBarriers.reserve(m_imageBarriers.size());
+    for (const auto& barrier : m_imageBarriers) {
+        srcStageMask |= barrier.srcStageMask;
+        dstStageMask |= barrier.dstStageMask;
+        imageBarriers.push_back(VkImageMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = toLegacyAccess(barrier.srcAccessMask),
+            .dstAccessMask = toLegacyAccess(barrier.dstAccessMask),
+            .oldLayout = barrier.oldLayout,
+            .newLayout = barrier.newLayout,
+            .srcQueueFamilyIndex = barrier.srcQueueFamilyIndex,
+            .dstQueueFamilyIndex = barrier.dstQueueFamilyIndex,
+            .image = barrier.image,
+            .subresourceRange = barrier.subresourceRange,
+        });
+    }
+
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        toLegacyStages(srcStageMask, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT),
+        toLegacyStages(dstStageMask, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT),
+        0,
+        static_cast<uint32_t>(memoryBarriers.size()), memoryBarriers.data(),
+        static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+}
@@ -0,0 +1,73 @@
+#ifndef _BARRIER_BATCH_H
+#define _BARRIER_BATCH_H
+
+#include <vulkan/vulkan.h>
+
+#include <memory_resource>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief Collects memory, buffer and image barriers and records all of them with one
+/// pipeline barrier.
+///
+/// @note Barriers are described with synchronization2 stage and access masks, which name
+/// copies, blits and sampled reads on their own instead of the whole transfer stage or
+/// every shader read. Devices with synchronization2 record them with
+/// `vkCmdPipelineBarrier2`. Everywhere else the masks are folded into their legacy
+/// equivalents for `vkCmdPipelineBarrier`, which takes one pair of stage masks for the
+/// whole flush, so the stages of every barrier in it are merged. The barriers are kept in
+/// `memoryResource`, which a batch recorded every frame takes from the frame's arena.
+class BarrierBatch final {
+    public:
+        explicit BarrierBatch() = delete;
+        explicit BarrierBatch(
+            bool useSynchronization2,
+            std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource()
+        );
+
+        ~BarrierBatch() = default;
+
+        /// @brief Transition an image between any two layouts, with the stages and accesses
+        /// that use an image in each of them.
+        ///
+        /// @note Images in the shader read-only layout are taken to be sampled by fragment
+        /// shaders. Barriers that need other stages are added with `addImageBarrier`.
+        void transitionImage(
+            VkImage image,
+            const VkImageSubresourceRange& subresourceRange,
+            VkImageLayout oldLayout,
+            VkImageLayout newLayout
+        );
+
+        void addMemoryBarrier(const VkMemoryBarrier2& barrier);
+
+        void addBufferBarrier(const VkBufferMemoryBarrier2& barrier);
+
+        void addImageBarrier(const VkImageMemoryBarrier2& barrier);
+
+        /// @brief Whether a barrier in the batch covers any subresource in `subresourceRange`
+        /// of `image`.
+        ///
+        /// @note Barriers recorded by one flush are not ordered among themselves, so a second
+        /// barrier on the same subresource has to wait for the next flush.
+        bool hasImageBarrier(VkImage image, const VkImageSubresourceRange& subresourceRange) const;
+
+        /// @brief Record every barrier collected so far into `commandBuffer`, and empty the
+        /// batch.
+        void flush(VkCommandBuffer commandBuffer);
+
+        bool isEmpty() const;
+    private:
+        bool m_useSynchronization2;
+        std::pmr::vector<VkMemoryBarrier2> m_memoryBarriers;
+        std::pmr::vector<VkBufferMemoryBarrier2> m_bufferBarriers;
+        std::pmr::vector<VkImageMemoryBarrier2> m_imageBarriers;
+
+        void flushLegacy(VkCommandBuffer commandBuffer);
+};
+
+}
+
+#endif // _BARRIER_BATCH_H
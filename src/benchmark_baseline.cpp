@@ -0,0 +1,265 @@
+#include "benchmark_baseline.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "json_reader.h"
+
+
+using BenchmarkBaseline = VulkanEngine::BenchmarkBaseline;
+using BenchmarkMetric = VulkanEngine::BenchmarkMetric;
+using BenchmarkComparisonOptions = VulkanEngine::BenchmarkComparisonOptions;
+using BenchmarkMetricComparison = VulkanEngine::BenchmarkMetricComparison;
+using JsonValue = VulkanEngine::JsonValue;
+using JsonReader = VulkanEngine::JsonReader;
+
+// Any change to the layout of the file must bump the version, so that old baselines fail
+// to load instead of being compared the wrong way.
+static constexpr uint32_t BASELINE_FILE_VERSION = 1;
+
+// The MAD of normal samples times this is their standard deviation.
+static constexpr double MAD_NORMAL_SCALE = 1.4826;
+
+static double getMedian(std::vector<double> samples) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const auto middle = samples.size() / 2;
+    if (samples.size() % 2 == 1) {
+        return samples[middle];
+    } else {
+        return 0.5 * (samples[middle - 1] + samples[middle]);
+    }
+}
+
+static double getMad(const std::vector<double>& samples, double median) {
+    auto deviations = std::vector<double> {};
+    deviations.reserve(samples.size());
+    for (const auto sample : samples) {
+        deviations.push_back(std::abs(sample - median));
+    }
+
+    return MAD_NORMAL_SCALE * getMedian(std::move(deviations));
+}
+
+/// @brief The two-sided p-value of the Mann-Whitney U test of `first` against `second`,
+/// from the normal approximation of U with a continuity and a tie correction.
+static double getMannWhitneyPValue(const std::vector<double>& first, const std::vector<double>& second) {
+    struct RankedSample final {
+        double value;
+        bool isFirst;
+    };
+
+    auto ranked = std::vector<RankedSample> {};
+    ranked.reserve(first.size() + second.size());
+    for (const auto value : first) {
+        ranked.push_back(RankedSample { .value = value, .isFirst = true });
+    }
+    for (const auto value : second) {
+        ranked.push_back(RankedSample { .value = value, .isFirst = false });
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const RankedSample& a, const RankedSample& b) {
+        return a.value < b.value;
+    });
+
+    // Tied samples share the mean of the ranks they span.
+    auto firstRankSum = 0.0;
+    auto tieSum = 0.0;
+    for (size_t begin = 0; begin < ranked.size();) {
+        auto end = begin + 1;
+        while (end < ranked.size() && ranked[end].value == ranked[begin].value) {
+            end++;
+        }
+
+        const auto rank = 0.5 * static_cast<double>(begin + 1 + end);
+        for (size_t i = begin; i < end; i++) {
+            if (ranked[i].isFirst) {
+                firstRankSum += rank;
+            }
+        }
+
+        const auto tieCount = static_cast<double>(end - begin);
+        tieSum += tieCount * tieCount * tieCount - tieCount;
+        begin = end;
+    }
+
+    const auto n1 = static_cast<double>(first.size());
+    const auto n2 = static_cast<double>(second.size());
+    const auto n = n1 + n2;
+    const auto u = firstRankSum - n1 * (n1 + 1.0) / 2.0;
+    const auto mean = n1 * n2 / 2.0;
+    const auto variance = n1 * n2 / 12.0 * ((n + 1.0) - tieSum / (n * (n - 1.0)));
+    if (variance <= 0.0) {
+        return 1.0;
+    }
+
+    const auto z = std::max(std::abs(u - mean) - 0.5, 0.0) / std::sqrt(variance);
+
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+static std::string escapeJsonString(const std::string& string) {
+    auto escaped = std::string {};
+    for (const auto character : string) {
+        if (character == '"' || character == '\\') {
+            escaped.push_back('\\');
+        }
+        escaped.push_back(character);
+    }
+
+    return escaped;
+}
+
+static const JsonValue& getMember(const JsonValue& object, std::string_view key, JsonValue::Type type) {
+    const auto* value = object.find(key);
+    if (value == nullptr || value->type != type) {
+        throw std::runtime_error(fmt::format("failed to load benchmark baseline: missing or malformed \"{}\"!", key));
+    }
+
+    return *value;
+}
+
+BenchmarkBaseline::BenchmarkBaseline(const std::string& deviceUuid, uint32_t driverVersion)
+    : m_deviceUuid { deviceUuid }
+    , m_driverVersion { driverVersion }
+{
+}
+
+std::filesystem::path BenchmarkBaseline::getPath(const std::filesystem::path& directory, const std::string& deviceUuid, uint32_t driverVersion) {
+    return directory / fmt::format("{}_{}.json", deviceUuid, driverVersion);
+}
+
+BenchmarkBaseline BenchmarkBaseline::load(const std::filesystem::path& path) {
+    auto file = std::ifstream { path, std::ios::in };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open benchmark baseline!");
+    }
+
+    const auto text = std::string { std::istreambuf_iterator<char> { file }, std::istreambuf_iterator<char> {} };
+    auto reader = JsonReader { text };
+    const auto document = reader.parseDocument();
+    if (getMember(document, "version", JsonValue::Type::Number).number != BASELINE_FILE_VERSION) {
+        throw std::runtime_error("failed to load benchmark baseline: not a baseline of this version!");
+    }
+
+    auto baseline = BenchmarkBaseline {
+        getMember(document, "deviceUuid", JsonValue::Type::String).string,
+        static_cast<uint32_t>(getMember(document, "driverVersion", JsonValue::Type::Number).number),
+    };
+    for (const auto& storedMetric : getMember(document, "metrics", JsonValue::Type::Array).elements) {
+        auto metric = BenchmarkMetric {
+            .name = getMember(storedMetric, "name", JsonValue::Type::String).string,
+            .unit = getMember(storedMetric, "unit", JsonValue::Type::String).string,
+            .isHigherBetter = getMember(storedMetric, "higherIsBetter", JsonValue::Type::Bool).boolean,
+            .samples = {},
+        };
+        for (const auto& sample : getMember(storedMetric, "samples", JsonValue::Type::Array).elements) {
+            if (sample.type != JsonValue::Type::Number) {
+                throw std::runtime_error("failed to load benchmark baseline: malformed sample!");
+            }
+
+            metric.samples.push_back(sample.number);
+        }
+        baseline.m_metrics.push_back(std::move(metric));
+    }
+
+    return baseline;
+}
+
+void BenchmarkBaseline::save(const std::filesystem::path& path) const {
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+
+    auto file = std::ofstream { path, std::ios::out | std::ios::trunc };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open benchmark baseline for writing!");
+    }
+
+    // The samples are written in the shortest form that reads back to the same double.
+    file << "{\n";
+    file << fmt::format("  \"version\": {},\n", BASELINE_FILE_VERSION);
+    file << fmt::format("  \"deviceUuid\": \"{}\",\n", escapeJsonString(m_deviceUuid));
+    file << fmt::format("  \"driverVersion\": {},\n", m_driverVersion);
+    file << "  \"metrics\": [";
+    for (size_t i = 0; i < m_metrics.size(); i++) {
+        const auto& metric = m_metrics[i];
+        file << fmt::format(
+            "{}\n    {{ \"name\": \"{}\", \"unit\": \"{}\", \"higherIsBetter\": {}, \"samples\": [",
+            i == 0 ? "" : ",",
+            escapeJsonString(metric.name),
+            escapeJsonString(metric.unit),
+            metric.isHigherBetter
+        );
+        for (size_t j = 0; j < metric.samples.size(); j++) {
+            file << fmt::format("{}{}", j == 0 ? "" : ", ", metric.samples[j]);
+        }
+        file << "] }";
+    }
+    file << "\n  ]\n}\n";
+
+    if (!file) {
+        throw std::runtime_error("failed to write benchmark baseline!");
+    }
+}
+
+void BenchmarkBaseline::addMetric(BenchmarkMetric metric) {
+    m_metrics.push_back(std::move(metric));
+}
+
+const std::vector<BenchmarkMetric>& BenchmarkBaseline::getMetrics() const {
+    return m_metrics;
+}
+
+std::vector<BenchmarkMetricComparison> BenchmarkBaseline::compare(const BenchmarkBaseline& run, const BenchmarkComparisonOptions& options) const {
+    auto comparisons = std::vector<BenchmarkMetricComparison> {};
+    for (const auto& runMetric : run.m_metrics) {
+        const auto baselineMetric = std::find_if(m_metrics.begin(), m_metrics.end(), [&runMetric](const BenchmarkMetric& metric) {
+            return metric.name == runMetric.name;
+        });
+        if (baselineMetric == m_metrics.end() || baselineMetric->samples.empty() || runMetric.samples.empty()) {
+            continue;
+        }
+
+        auto comparison = BenchmarkMetricComparison {
+            .name = runMetric.name,
+            .unit = runMetric.unit,
+            .baselineMedian = getMedian(baselineMetric->samples),
+            .baselineMad = 0.0,
+            .runMedian = getMedian(runMetric.samples),
+            .runMad = 0.0,
+            .relativeChange = 0.0,
+            .pValue = std::nullopt,
+            .isRegression = false,
+        };
+        comparison.baselineMad = getMad(baselineMetric->samples, comparison.baselineMedian);
+        comparison.runMad = getMad(runMetric.samples, comparison.runMedian);
+
+        const auto worsening = runMetric.isHigherBetter
+            ? comparison.baselineMedian - comparison.runMedian
+            : comparison.runMedian - comparison.baselineMedian;
+        if (comparison.baselineMedian != 0.0) {
+            comparison.relativeChange = worsening / std::abs(comparison.baselineMedian);
+        }
+
+        const auto isTestable = baselineMetric->samples.size() >= MIN_TEST_SAMPLE_COUNT && runMetric.samples.size() >= MIN_TEST_SAMPLE_COUNT;
+        if (isTestable) {
+            comparison.pValue = getMannWhitneyPValue(baselineMetric->samples, runMetric.samples);
+            comparison.isRegression = *comparison.pValue < options.significanceLevel
+                && comparison.relativeChange > options.minRelativeChange
+                && worsening > options.minMadChange * comparison.baselineMad;
+        } else {
+            comparison.isRegression = comparison.relativeChange > options.minSingleSampleRelativeChange;
+        }
+        comparisons.push_back(std::move(comparison));
+    }
+
+    return comparisons;
+}
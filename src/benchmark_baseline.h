@@ -0,0 +1,105 @@
+#ifndef _BENCHMARK_BASELINE_H
+#define _BENCHMARK_BASELINE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief One measure of a benchmark run and every sample of it the run took.
+struct BenchmarkMetric final {
+    std::string name;
+    std::string unit;
+    /// @brief Whether larger samples are better, as with throughputs, rather than worse, as
+    /// with times.
+    bool isHigherBetter = false;
+    std::vector<double> samples;
+};
+
+/// @brief When a metric of a run counts as a regression from its baseline.
+struct BenchmarkComparisonOptions final {
+    /// @brief The largest p-value of the Mann-Whitney U test that counts as significant.
+    double significanceLevel = 0.01;
+    /// @brief The smallest change of the median, as a share of the baseline median, that
+    /// counts, for metrics with enough samples to test.
+    double minRelativeChange = 0.05;
+    /// @brief The smallest change of the median, in baseline MADs, that counts, for metrics
+    /// with enough samples to test.
+    double minMadChange = 1.0;
+    /// @brief The smallest change, as a share of the baseline, that counts for metrics with
+    /// too few samples to test, which have nothing but the threshold to tell noise apart.
+    double minSingleSampleRelativeChange = 0.2;
+};
+
+/// @brief How a metric of a run compares with the same metric of its baseline.
+struct BenchmarkMetricComparison final {
+    std::string name;
+    std::string unit;
+    double baselineMedian = 0.0;
+    double baselineMad = 0.0;
+    double runMedian = 0.0;
+    double runMad = 0.0;
+    /// @brief The change of the median as a share of the baseline median, positive when the
+    /// run is worse.
+    double relativeChange = 0.0;
+    /// @brief The two-sided p-value of the Mann-Whitney U test, when both sides have enough
+    /// samples to run it.
+    std::optional<double> pValue;
+    bool isRegression = false;
+};
+
+/// @brief The metrics of a benchmark run on one device and driver, which later runs on the
+/// same device and driver are compared against.
+///
+/// @note The file is JSON, with every sample, so a later run can test its samples against
+/// the baseline's. Metrics with at least `MIN_TEST_SAMPLE_COUNT` samples on both sides
+/// regress when the Mann-Whitney U test finds the run's samples significantly worse and the
+/// median moved by more than both the relative and the MAD threshold. The MAD is scaled to
+/// match the standard deviation of normal samples. Other metrics regress on the relative
+/// threshold for single samples alone. Frame times are not quite independent of each other,
+/// so the thresholds on the median guard against the test finding shifts too small to
+/// matter.
+class BenchmarkBaseline final {
+    public:
+        /// @brief The fewest samples a side of the Mann-Whitney U test takes, below which the
+        /// normal approximation of its statistic is too coarse.
+        static constexpr size_t MIN_TEST_SAMPLE_COUNT = 8;
+
+        explicit BenchmarkBaseline() = default;
+        explicit BenchmarkBaseline(const std::string& deviceUuid, uint32_t driverVersion);
+
+        ~BenchmarkBaseline() = default;
+
+        BenchmarkBaseline(BenchmarkBaseline&& other) noexcept = default;
+        BenchmarkBaseline& operator=(BenchmarkBaseline&& other) noexcept = default;
+
+        BenchmarkBaseline(const BenchmarkBaseline& other) = delete;
+        BenchmarkBaseline& operator=(const BenchmarkBaseline& other) = delete;
+
+        /// @brief The file in `directory` the baseline of a device and driver lives in.
+        static std::filesystem::path getPath(const std::filesystem::path& directory, const std::string& deviceUuid, uint32_t driverVersion);
+
+        static BenchmarkBaseline load(const std::filesystem::path& path);
+
+        void save(const std::filesystem::path& path) const;
+
+        void addMetric(BenchmarkMetric metric);
+
+        const std::vector<BenchmarkMetric>& getMetrics() const;
+
+        /// @brief Compare every metric of `run` with the metric of the same name here.
+        /// Metrics either side lacks are left out.
+        std::vector<BenchmarkMetricComparison> compare(const BenchmarkBaseline& run, const BenchmarkComparisonOptions& options) const;
+    private:
+        std::string m_deviceUuid;
+        uint32_t m_driverVersion = 0;
+        std::vector<BenchmarkMetric> m_metrics;
+};
+
+}
+
+#endif // _BENCHMARK_BASELINE_H
@@ -0,0 +1,508 @@
+#include "bloom_chain.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <stdexcept>
+#include <utility>
+
+#include "command_counters.h"
+
+
+using BloomChain = VulkanEngine::BloomChain;
+using Downsampler = VulkanEngine::Downsampler;
+using DownsampleReduction = VulkanEngine::DownsampleReduction;
+using DownsampleSourceFilter = VulkanEngine::DownsampleSourceFilter;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+BloomChain::BloomChain(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    VkPipelineCache pipelineCache,
+    std::span<const uint32_t> downsampleShaderCode,
+    std::span<const uint32_t> upsampleShaderCode,
+    VkImageView sceneColorImageView,
+    VkExtent2D sceneColorExtent,
+    uint32_t mipLevels
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_extent { VkExtent2D { std::max(sceneColorExtent.width / 2, 1u), std::max(sceneColorExtent.height / 2, 1u) } }
+    , m_mipLevels { std::min(mipLevels, static_cast<uint32_t>(std::bit_width(std::min(m_extent.width, m_extent.height)))) }
+    , m_image { VK_NULL_HANDLE }
+    , m_allocation {}
+    , m_mipViews {}
+    , m_sampler { VK_NULL_HANDLE }
+    , m_upsampleDescriptorSetLayout { VK_NULL_HANDLE }
+    , m_upsamplePipelineLayout { VK_NULL_HANDLE }
+    , m_upsamplePipeline { VK_NULL_HANDLE }
+    , m_descriptorPool { VK_NULL_HANDLE }
+    , m_upsampleDescriptorSets {}
+    , m_downsampler {}
+{
+    if (mipLevels < 2 || mipLevels > MAX_MIP_LEVELS) {
+        throw std::invalid_argument("bloom chain needs between 2 and MAX_MIP_LEVELS levels");
+    }
+    if (m_mipLevels < 2) {
+        throw std::invalid_argument("bloom chain needs a scene color at least 4 pixels a side");
+    }
+
+    this->createImage();
+    this->createImageViews();
+    this->createSampler();
+    this->createUpsampleDescriptorSetLayout();
+    this->createUpsamplePipeline(pipelineCache, upsampleShaderCode);
+    this->createUpsampleDescriptorSets();
+    m_downsampler = std::make_unique<Downsampler>(
+        m_device,
+        m_allocator,
+        pipelineCache,
+        downsampleShaderCode,
+        FORMAT,
+        m_extent,
+        m_mipViews,
+        DownsampleReduction::Average,
+        sceneColorImageView,
+        DownsampleSourceFilter::Color
+    );
+}
+
+BloomChain::~BloomChain() {
+    m_downsampler.reset();
+    vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+    vkDestroyPipeline(m_device, m_upsamplePipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_upsamplePipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_upsampleDescriptorSetLayout, nullptr);
+    vkDestroySampler(m_device, m_sampler, nullptr);
+
+    for (const auto mipView : m_mipViews) {
+        vkDestroyImageView(m_device, mipView, nullptr);
+    }
+    vkDestroyImage(m_device, m_image, nullptr);
+    m_allocator.free(m_allocation);
+
+    m_upsampleDescriptorSets.clear();
+    m_descriptorPool = VK_NULL_HANDLE;
+    m_upsamplePipeline = VK_NULL_HANDLE;
+    m_upsamplePipelineLayout = VK_NULL_HANDLE;
+    m_upsampleDescriptorSetLayout = VK_NULL_HANDLE;
+    m_sampler = VK_NULL_HANDLE;
+    m_mipViews.clear();
+    m_image = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void BloomChain::recordInitialization(VkCommandBuffer commandBuffer) const {
+    const auto subresourceRange = VkImageSubresourceRange {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = 0,
+        .levelCount = m_mipLevels,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+
+    const auto clearBarrier = VkImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_image,
+        .subresourceRange = subresourceRange,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &clearBarrier
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    const auto clearColor = VkClearColorValue { .float32 = { 0.0f, 0.0f, 0.0f, 0.0f } };
+    vkCmdClearColorImage(commandBuffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &subresourceRange);
+
+    // The tone mapper adds the bloom before the first frame blurs it.
+    const auto readBarrier = VkImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_image,
+        .subresourceRange = subresourceRange,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &readBarrier
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    m_downsampler->recordInitialization(commandBuffer);
+}
+
+void BloomChain::record(VkCommandBuffer commandBuffer) const {
+    m_downsampler->record(commandBuffer);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_upsamplePipeline);
+    CommandCounters::add(CommandCounter::PipelineBinds);
+
+    for (uint32_t level = m_mipLevels - 1; level > 0; level--) {
+        // Every upsample reads the level the one before it, or the downsampler, wrote, and
+        // adds into the level above it, which the downsampler wrote too.
+        const auto levelBarrier = VkMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        };
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &levelBarrier,
+            0, nullptr,
+            0, nullptr
+        );
+        CommandCounters::add(CommandCounter::Barriers);
+
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            m_upsamplePipelineLayout,
+            0,
+            1,
+            &m_upsampleDescriptorSets[level - 1],
+            0,
+            nullptr
+        );
+        CommandCounters::add(CommandCounter::DescriptorBinds);
+
+        const auto sourceExtent = this->getMipExtent(level);
+        const auto destinationExtent = this->getMipExtent(level - 1);
+        const auto pushConstants = UpsamplePushConstants {
+            .sourceWidth = sourceExtent.width,
+            .sourceHeight = sourceExtent.height,
+            .destinationWidth = destinationExtent.width,
+            .destinationHeight = destinationExtent.height,
+            .radius = UPSAMPLE_RADIUS,
+        };
+        vkCmdPushConstants(
+            commandBuffer,
+            m_upsamplePipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(UpsamplePushConstants),
+            &pushConstants
+        );
+
+        vkCmdDispatch(
+            commandBuffer,
+            (destinationExtent.width + UPSAMPLE_THREAD_COUNT - 1) / UPSAMPLE_THREAD_COUNT,
+            (destinationExtent.height + UPSAMPLE_THREAD_COUNT - 1) / UPSAMPLE_THREAD_COUNT,
+            1
+        );
+        CommandCounters::add(CommandCounter::Dispatches);
+    }
+}
+
+VkImage BloomChain::getImage() const {
+    return m_image;
+}
+
+uint32_t BloomChain::getMipLevels() const {
+    return m_mipLevels;
+}
+
+VkImageView BloomChain::getImageView() const {
+    return m_mipViews.front();
+}
+
+VkSampler BloomChain::getSampler() const {
+    return m_sampler;
+}
+
+VkExtent2D BloomChain::getMipExtent(uint32_t level) const {
+    return VkExtent2D {
+        std::max(m_extent.width >> level, 1u),
+        std::max(m_extent.height >> level, 1u),
+    };
+}
+
+void BloomChain::createImage() {
+    const auto imageInfo = VkImageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = FORMAT,
+        .extent = VkExtent3D { m_extent.width, m_extent.height, 1 },
+        .mipLevels = m_mipLevels,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    auto image = VkImage {};
+    const auto resultCreateImage = vkCreateImage(m_device, &imageInfo, nullptr, &image);
+    if (resultCreateImage != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bloom chain image!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetImageMemoryRequirements(m_device, image, &memRequirements);
+
+    const auto allocation = m_allocator.allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Optimal, GpuMemoryCategory::Attachment);
+
+    vkBindImageMemory(m_device, image, allocation.memory, allocation.offset);
+
+    m_image = image;
+    m_allocation = allocation;
+}
+
+void BloomChain::createImageViews() {
+    m_mipViews.reserve(m_mipLevels);
+    for (uint32_t level = 0; level < m_mipLevels; level++) {
+        const auto viewInfo = VkImageViewCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = m_image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = FORMAT,
+            .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .subresourceRange.baseMipLevel = level,
+            .subresourceRange.levelCount = 1,
+            .subresourceRange.baseArrayLayer = 0,
+            .subresourceRange.layerCount = 1,
+        };
+
+        auto imageView = VkImageView {};
+        const auto result = vkCreateImageView(m_device, &viewInfo, nullptr, &imageView);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create bloom chain image view!");
+        }
+
+        m_mipViews.push_back(imageView);
+    }
+}
+
+void BloomChain::createSampler() {
+    const auto samplerInfo = VkSamplerCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .mipLodBias = 0.0f,
+        .anisotropyEnable = VK_FALSE,
+        .maxAnisotropy = 1.0f,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .minLod = 0.0f,
+        .maxLod = 0.0f,
+        .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+
+    auto sampler = VkSampler {};
+    const auto result = vkCreateSampler(m_device, &samplerInfo, nullptr, &sampler);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bloom chain sampler!");
+    }
+
+    m_sampler = sampler;
+}
+
+void BloomChain::createUpsampleDescriptorSetLayout() {
+    const auto bindings = std::array<VkDescriptorSetLayoutBinding, 3> {
+        VkDescriptorSetLayoutBinding {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = &m_sampler,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 2,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+    };
+    const auto layoutInfo = VkDescriptorSetLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+
+    auto descriptorSetLayout = VkDescriptorSetLayout {};
+    const auto result = vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &descriptorSetLayout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bloom upsample descriptor set layout!");
+    }
+
+    m_upsampleDescriptorSetLayout = descriptorSetLayout;
+}
+
+void BloomChain::createUpsamplePipeline(VkPipelineCache pipelineCache, std::span<const uint32_t> shaderCode) {
+    const auto pushConstantRange = VkPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(UpsamplePushConstants),
+    };
+    const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_upsampleDescriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+
+    auto pipelineLayout = VkPipelineLayout {};
+    const auto resultCreatePipelineLayout = vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    if (resultCreatePipelineLayout != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bloom upsample pipeline layout!");
+    }
+
+    // The destructor takes care of the layout if the pipeline fails.
+    m_upsamplePipelineLayout = pipelineLayout;
+
+    const auto shaderModuleInfo = VkShaderModuleCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = shaderCode.size_bytes(),
+        .pCode = shaderCode.data(),
+    };
+
+    auto shaderModule = VkShaderModule {};
+    const auto resultCreateShaderModule = vkCreateShaderModule(m_device, &shaderModuleInfo, nullptr, &shaderModule);
+    if (resultCreateShaderModule != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bloom upsample shader module!");
+    }
+
+    const auto pipelineInfo = VkComputePipelineCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shaderModule,
+            .pName = "main",
+        },
+        .layout = m_upsamplePipelineLayout,
+    };
+
+    auto pipeline = VkPipeline {};
+    const auto resultCreatePipeline = vkCreateComputePipelines(m_device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    // The pipeline keeps everything it needs from the shader module.
+    vkDestroyShaderModule(m_device, shaderModule, nullptr);
+
+    if (resultCreatePipeline != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bloom upsample pipeline!");
+    }
+
+    m_upsamplePipeline = pipeline;
+}
+
+void BloomChain::createUpsampleDescriptorSets() {
+    // One set per upsample, reading a level and adding into the one above it.
+    const auto setCount = m_mipLevels - 1;
+    const auto poolSizes = std::array<VkDescriptorPoolSize, 3> {
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = setCount,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLER,
+            .descriptorCount = setCount,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = setCount,
+        },
+    };
+    const auto poolInfo = VkDescriptorPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = 0,
+        .maxSets = setCount,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+    };
+
+    auto descriptorPool = VkDescriptorPool {};
+    const auto resultCreateDescriptorPool = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &descriptorPool);
+    if (resultCreateDescriptorPool != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bloom chain descriptor pool!");
+    }
+
+    m_descriptorPool = descriptorPool;
+
+    const auto layouts = std::vector<VkDescriptorSetLayout>(setCount, m_upsampleDescriptorSetLayout);
+    const auto allocInfo = VkDescriptorSetAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_descriptorPool,
+        .descriptorSetCount = setCount,
+        .pSetLayouts = layouts.data(),
+    };
+
+    auto descriptorSets = std::vector<VkDescriptorSet>(setCount, VK_NULL_HANDLE);
+    const auto resultAllocateDescriptorSets = vkAllocateDescriptorSets(m_device, &allocInfo, descriptorSets.data());
+    if (resultAllocateDescriptorSets != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate bloom chain descriptor sets!");
+    }
+
+    for (uint32_t level = 0; level < setCount; level++) {
+        const auto sourceInfo = VkDescriptorImageInfo {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = m_mipViews[level + 1],
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        };
+        const auto destinationInfo = VkDescriptorImageInfo {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = m_mipViews[level],
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        };
+        const auto descriptorWrites = std::array<VkWriteDescriptorSet, 2> {
+            VkWriteDescriptorSet {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptorSets[level],
+                .dstBinding = 0,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                .pImageInfo = &sourceInfo,
+            },
+            VkWriteDescriptorSet {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptorSets[level],
+                .dstBinding = 2,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .pImageInfo = &destinationInfo,
+            },
+        };
+
+        vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+
+    m_upsampleDescriptorSets = std::move(descriptorSets);
+}
@@ -0,0 +1,120 @@
+#ifndef _BLOOM_CHAIN_H
+#define _BLOOM_CHAIN_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "downsampler.h"
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief Blurs the scene color into a bloom, downsampling it with the shared
+/// `Downsampler` and adding every level back into the one above it.
+///
+/// @note The chain is an `R16G16B16A16_SFLOAT` image at half the scene color, whose levels
+/// the downsampler fills with the scene color averaged down in one dispatch. Every level
+/// is then upsampled with a tent filter and added into the level above it, from the
+/// smallest up, so that the first level ends up holding the sum of every level, each
+/// blurred as wide as its size. The tone mapper divides it by the levels it sums.
+///
+/// The chain lives in `VK_IMAGE_LAYOUT_GENERAL`, and keeps at most `MAX_MIP_LEVELS`, so
+/// that one dispatch always downsamples it whole. The scene color has to be sampled in
+/// `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL`.
+class BloomChain final {
+    public:
+        static constexpr VkFormat FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+        static constexpr uint32_t MAX_MIP_LEVELS = Downsampler::TILE_LEVELS + 1;
+
+        explicit BloomChain() = delete;
+        /// @note The chain keeps `mipLevels`, or as many down to a single texel as the
+        /// scene color has, whichever is fewer.
+        explicit BloomChain(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            VkPipelineCache pipelineCache,
+            std::span<const uint32_t> downsampleShaderCode,
+            std::span<const uint32_t> upsampleShaderCode,
+            VkImageView sceneColorImageView,
+            VkExtent2D sceneColorExtent,
+            uint32_t mipLevels
+        );
+
+        ~BloomChain();
+
+        BloomChain(const BloomChain& other) = delete;
+        BloomChain& operator=(const BloomChain& other) = delete;
+
+        /// @brief Record clearing every level to black, and moving the chain into its
+        /// layout, for the frames that add it before it is first blurred.
+        void recordInitialization(VkCommandBuffer commandBuffer) const;
+
+        /// @brief Record downsampling the scene color into the chain and upsampling it back
+        /// into the first level.
+        ///
+        /// @note Must be recorded outside of a render pass. The barriers that order the
+        /// scene color writes before it and the reads of the first level after it are left
+        /// to the caller.
+        void record(VkCommandBuffer commandBuffer) const;
+
+        VkImage getImage() const;
+
+        uint32_t getMipLevels() const;
+
+        /// @brief The view of the first level, which holds the bloom.
+        VkImageView getImageView() const;
+
+        /// @brief A linear sampler that clamps to the edge, to sample the bloom with.
+        VkSampler getSampler() const;
+    private:
+        static constexpr uint32_t UPSAMPLE_THREAD_COUNT = 8;
+        /// @brief The distance between the taps of the upsample tent filter, in texels of
+        /// the level it reads.
+        static constexpr float UPSAMPLE_RADIUS = 1.0f;
+
+        struct UpsamplePushConstants final {
+            uint32_t sourceWidth;
+            uint32_t sourceHeight;
+            uint32_t destinationWidth;
+            uint32_t destinationHeight;
+            float radius;
+        };
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkExtent2D m_extent;
+        uint32_t m_mipLevels;
+        VkImage m_image;
+        GpuAllocation m_allocation;
+        std::vector<VkImageView> m_mipViews;
+        VkSampler m_sampler;
+        VkDescriptorSetLayout m_upsampleDescriptorSetLayout;
+        VkPipelineLayout m_upsamplePipelineLayout;
+        VkPipeline m_upsamplePipeline;
+        VkDescriptorPool m_descriptorPool;
+        std::vector<VkDescriptorSet> m_upsampleDescriptorSets;
+        std::unique_ptr<Downsampler> m_downsampler;
+
+        VkExtent2D getMipExtent(uint32_t level) const;
+
+        void createImage();
+
+        void createImageViews();
+
+        void createSampler();
+
+        void createUpsampleDescriptorSetLayout();
+
+        void createUpsamplePipeline(VkPipelineCache pipelineCache, std::span<const uint32_t> shaderCode);
+
+        void createUpsampleDescriptorSets();
+};
+
+}
+
+#endif // _BLOOM_CHAIN_H
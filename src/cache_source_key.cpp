@@ -0,0 +1,63 @@
+#include "cache_source_key.h"
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+
+using CacheSourceKey = VulkanEngine::CacheSourceKey;
+
+std::optional<CacheSourceKey> CacheSourceKey::create(const std::filesystem::path& sourcePath) {
+    auto errorCode = std::error_code {};
+    const auto modifiedTime = std::filesystem::last_write_time(sourcePath, errorCode);
+    if (errorCode) {
+        return std::nullopt;
+    }
+
+    auto file = std::ifstream { sourcePath, std::ios::binary };
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+
+    auto contentHash = FNV_OFFSET_BASIS;
+    auto buffer = std::vector<uint8_t>(64 * 1024);
+    while (file) {
+        file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        contentHash = CacheSourceKey::hashBytes(buffer.data(), static_cast<size_t>(file.gcount()), contentHash);
+    }
+
+    if (!file.eof()) {
+        return std::nullopt;
+    }
+
+    return CacheSourceKey {
+        .modifiedTime = static_cast<int64_t>(modifiedTime.time_since_epoch().count()),
+        .contentHash = contentHash,
+    };
+}
+
+std::string CacheSourceKey::createEntryName(const std::filesystem::path& sourcePath, const std::string& extension) {
+    const auto sourcePathString = sourcePath.generic_string();
+    const auto pathHash = CacheSourceKey::hashBytes(
+        reinterpret_cast<const uint8_t*>(sourcePathString.data()),
+        sourcePathString.size(),
+        FNV_OFFSET_BASIS
+    );
+
+    auto entryName = std::array<char, 17> {};
+    std::snprintf(entryName.data(), entryName.size(), "%016llx", static_cast<unsigned long long>(pathHash));
+
+    return std::string { entryName.data() } + extension;
+}
+
+uint64_t CacheSourceKey::hashBytes(const uint8_t* data, size_t size, uint64_t hash) {
+    // 64-bit FNV-1a.
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
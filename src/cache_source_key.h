@@ -0,0 +1,38 @@
+#ifndef _CACHE_SOURCE_KEY_H
+#define _CACHE_SOURCE_KEY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+
+namespace VulkanEngine {
+
+/// @brief Identifies the version of a source file that an on-disk cache entry was built from.
+///
+/// @note A cache entry is only valid while both the modification time and the content hash
+/// of its source match the ones stored with it.
+struct CacheSourceKey final {
+    static constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325;
+    static constexpr uint64_t FNV_PRIME = 0x100000001b3;
+
+    int64_t modifiedTime = 0;
+    uint64_t contentHash = 0;
+
+    /// @brief Hash the source file, or return nothing when it cannot be read.
+    static std::optional<CacheSourceKey> create(const std::filesystem::path& sourcePath);
+
+    /// @brief The file name of the cache entry of `sourcePath`, a hash of the path followed
+    /// by `extension`.
+    ///
+    /// @note Different paths can collide, so entries also store the full source path.
+    static std::string createEntryName(const std::filesystem::path& sourcePath, const std::string& extension);
+
+    static uint64_t hashBytes(const uint8_t* data, size_t size, uint64_t hash);
+};
+
+}
+
+#endif // _CACHE_SOURCE_KEY_H
@@ -0,0 +1,135 @@
+#include "command_counters.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+
+
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounts = VulkanEngine::CommandCounts;
+using CommandCounterBlock = VulkanEngine::CommandCounterBlock;
+using CommandFrameCounts = VulkanEngine::CommandFrameCounts;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+static constexpr size_t COUNTER_COUNT = static_cast<size_t>(CommandCounter::Count);
+
+// Blocks and pass names are published with release ordering once they are written, so a
+// thread that reads a count with acquire ordering sees every one before it. Neither is
+// ever removed, so the blocks of threads that have finished are still collected.
+static std::mutex g_threadBlocksMutex;
+static std::array<std::unique_ptr<CommandCounterBlock>, CommandCounters::MAX_THREADS> g_threadBlocks;
+static std::atomic<uint32_t> g_threadBlockCount = 0;
+static std::mutex g_passNamesMutex;
+static std::array<std::string, CommandCounters::MAX_PASSES> g_passNames = { std::string { "frame" } };
+static std::atomic<uint32_t> g_passCount = 1;
+
+static void addCounts(CommandCounts& sum, const CommandCounts& counts) {
+    for (size_t i = 0; i < COUNTER_COUNT; i++) {
+        sum[i] += counts[i];
+    }
+}
+
+CommandCounterBlock::CommandCounterBlock(uint32_t threadIndex)
+    : m_threadIndex { threadIndex }
+    , m_counts {}
+{
+}
+
+uint32_t CommandCounterBlock::getThreadIndex() const {
+    return m_threadIndex;
+}
+
+CommandCounts CommandCounterBlock::take(uint32_t pass) {
+    auto counts = CommandCounts {};
+    for (size_t i = 0; i < COUNTER_COUNT; i++) {
+        counts[i] = m_counts[pass][i].exchange(0, std::memory_order_relaxed);
+    }
+
+    return counts;
+}
+
+void CommandFrameCounts::add(const CommandFrameCounts& other) {
+    addCounts(total, other.total);
+    for (uint32_t i = 0; i < other.passCount; i++) {
+        addCounts(passes[i], other.passes[i]);
+    }
+    for (uint32_t i = 0; i < other.threadCount; i++) {
+        addCounts(threads[i], other.threads[i]);
+    }
+    passCount = std::max(passCount, other.passCount);
+    threadCount = std::max(threadCount, other.threadCount);
+}
+
+uint32_t CommandCounters::findPass(std::string_view name) {
+    const auto passCount = g_passCount.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < passCount; i++) {
+        if (g_passNames[i] == name) {
+            return i;
+        }
+    }
+
+    const auto lock = std::lock_guard<std::mutex> { g_passNamesMutex };
+    // Another thread may have added the pass since the count was loaded.
+    const auto lockedPassCount = g_passCount.load(std::memory_order_relaxed);
+    for (uint32_t i = passCount; i < lockedPassCount; i++) {
+        if (g_passNames[i] == name) {
+            return i;
+        }
+    }
+    if (lockedPassCount == MAX_PASSES) {
+        return NO_PASS;
+    }
+
+    g_passNames[lockedPassCount] = std::string { name };
+    g_passCount.store(lockedPassCount + 1, std::memory_order_release);
+
+    return lockedPassCount;
+}
+
+std::string_view CommandCounters::getPassName(uint32_t pass) {
+    return g_passNames[pass];
+}
+
+void CommandCounters::collectFrame(CommandFrameCounts& frame) {
+    frame = CommandFrameCounts {};
+    frame.passCount = g_passCount.load(std::memory_order_acquire);
+    frame.threadCount = g_threadBlockCount.load(std::memory_order_acquire);
+    for (uint32_t thread = 0; thread < frame.threadCount; thread++) {
+        auto& block = *g_threadBlocks[thread];
+        for (uint32_t pass = 0; pass < frame.passCount; pass++) {
+            const auto counts = block.take(pass);
+            addCounts(frame.total, counts);
+            addCounts(frame.passes[pass], counts);
+            addCounts(frame.threads[thread], counts);
+        }
+    }
+}
+
+const char* CommandCounters::getCounterName(CommandCounter counter) {
+    switch (counter) {
+        case CommandCounter::Draws: return "draws";
+        case CommandCounter::Dispatches: return "dispatches";
+        case CommandCounter::PipelineBinds: return "pipelineBinds";
+        case CommandCounter::DescriptorBinds: return "descriptorBinds";
+        case CommandCounter::Barriers: return "barriers";
+        case CommandCounter::Submits: return "submits";
+        case CommandCounter::UploadedBytes: return "uploadedBytes";
+        case CommandCounter::Count: break;
+    }
+
+    return "unknown";
+}
+
+CommandCounterBlock* CommandCounters::createThreadBlock() {
+    const auto lock = std::lock_guard<std::mutex> { g_threadBlocksMutex };
+    const auto threadIndex = g_threadBlockCount.load(std::memory_order_relaxed);
+    if (threadIndex == MAX_THREADS) {
+        return g_threadBlocks[MAX_THREADS - 1].get();
+    }
+
+    g_threadBlocks[threadIndex] = std::make_unique<CommandCounterBlock>(threadIndex);
+    g_threadBlockCount.store(threadIndex + 1, std::memory_order_release);
+
+    return g_threadBlocks[threadIndex].get();
+}
@@ -0,0 +1,161 @@
+#ifndef _COMMAND_COUNTERS_H
+#define _COMMAND_COUNTERS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+
+namespace VulkanEngine {
+
+/// @brief A kind of command the frame records, counted by `CommandCounters`.
+enum class CommandCounter {
+    Draws,
+    Dispatches,
+    PipelineBinds,
+    /// @brief Binds of descriptor sets or descriptor buffers, and pushes of descriptors.
+    DescriptorBinds,
+    /// @brief Pipeline barrier commands, however many barriers each of them holds.
+    Barriers,
+    /// @brief Calls that submit to a queue.
+    Submits,
+    /// @brief Bytes staged for upload.
+    UploadedBytes,
+    Count
+};
+
+using CommandCounts = std::array<uint64_t, static_cast<size_t>(CommandCounter::Count)>;
+
+/// @brief The counts of one thread, split by the pass they were recorded in.
+///
+/// @note Only the owning thread adds to a block, but every add is atomic, so that the
+/// thread collecting a frame takes the counts without a lock while they are added, and
+/// threads past `CommandCounters::MAX_THREADS` can share the last block.
+class CommandCounterBlock final {
+    public:
+        static constexpr uint32_t MAX_PASSES = 32;
+
+        explicit CommandCounterBlock() = delete;
+        explicit CommandCounterBlock(uint32_t threadIndex);
+
+        ~CommandCounterBlock() = default;
+
+        CommandCounterBlock(const CommandCounterBlock& other) = delete;
+        CommandCounterBlock& operator=(const CommandCounterBlock& other) = delete;
+
+        uint32_t getThreadIndex() const;
+
+        void add(uint32_t pass, CommandCounter counter, uint64_t amount) {
+            m_counts[pass][static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        /// @brief The counts of `pass` since they were last taken, leaving them at zero.
+        CommandCounts take(uint32_t pass);
+    private:
+        uint32_t m_threadIndex;
+        std::array<std::array<std::atomic<uint64_t>, static_cast<size_t>(CommandCounter::Count)>, MAX_PASSES> m_counts;
+};
+
+struct CommandFrameCounts;
+
+/// @brief Counts the draws, dispatches, binds, barriers, submits and uploads recorded by
+/// every thread, split by the pass recording them, a frame at a time.
+///
+/// @note Counting goes to a block of the calling thread, created the first time it counts,
+/// which is the only time the counters take a lock on the hot path. A thread counts into
+/// the pass it last entered with a `CommandPassScope`, or into pass zero, the work outside
+/// of every pass. Passes are found by name without a lock, and only a name seen for the
+/// first time takes one, so that a graph built every frame finds its passes again. Passes
+/// past `MAX_PASSES` are counted in pass zero.
+///
+/// The thread that runs the frame loop collects the counts once a frame, which takes every
+/// count added since the last collection.
+class CommandCounters final {
+    public:
+        static constexpr uint32_t MAX_THREADS = 64;
+        static constexpr uint32_t MAX_PASSES = CommandCounterBlock::MAX_PASSES;
+        static constexpr uint32_t NO_PASS = 0;
+
+        explicit CommandCounters() = delete;
+
+        static void add(CommandCounter counter, uint64_t amount = 1) {
+            CommandCounters::getThreadBlock().add(CommandCounters::getCurrentPassRef(), counter, amount);
+        }
+
+        /// @brief The index of the pass `name`, given one the first time it is asked for.
+        static uint32_t findPass(std::string_view name);
+
+        static std::string_view getPassName(uint32_t pass);
+
+        /// @brief The pass the calling thread counts into.
+        static uint32_t getCurrentPass() {
+            return CommandCounters::getCurrentPassRef();
+        }
+
+        /// @brief Take every count added since the last collection into `frame`.
+        static void collectFrame(CommandFrameCounts& frame);
+
+        static uint64_t get(const CommandCounts& counts, CommandCounter counter) {
+            return counts[static_cast<size_t>(counter)];
+        }
+
+        /// @brief The name of `counter` in benchmark results.
+        static const char* getCounterName(CommandCounter counter);
+    private:
+        friend class CommandPassScope;
+
+        static uint32_t& getCurrentPassRef() {
+            thread_local uint32_t currentPass = NO_PASS;
+
+            return currentPass;
+        }
+
+        static CommandCounterBlock& getThreadBlock() {
+            thread_local CommandCounterBlock* threadBlock = CommandCounters::createThreadBlock();
+
+            return *threadBlock;
+        }
+
+        static CommandCounterBlock* createThreadBlock();
+};
+
+/// @brief The counts of a frame, in total, by pass and by thread.
+///
+/// @note Passes and threads are indexed like in `CommandCounters`, and the counts of the
+/// ones that have not been seen yet are zero.
+struct CommandFrameCounts final {
+    CommandCounts total {};
+    std::array<CommandCounts, CommandCounters::MAX_PASSES> passes {};
+    uint32_t passCount = 0;
+    std::array<CommandCounts, CommandCounters::MAX_THREADS> threads {};
+    uint32_t threadCount = 0;
+
+    /// @brief Add every count of `other`, to sum up frames.
+    void add(const CommandFrameCounts& other);
+};
+
+/// @brief Counts what the calling thread records into `pass` while it lives, then goes
+/// back to the pass before it.
+class CommandPassScope final {
+    public:
+        explicit CommandPassScope() = delete;
+        explicit CommandPassScope(uint32_t pass)
+            : m_previousPass { CommandCounters::getCurrentPassRef() }
+        {
+            CommandCounters::getCurrentPassRef() = pass;
+        }
+
+        ~CommandPassScope() {
+            CommandCounters::getCurrentPassRef() = m_previousPass;
+        }
+
+        CommandPassScope(const CommandPassScope& other) = delete;
+        CommandPassScope& operator=(const CommandPassScope& other) = delete;
+    private:
+        uint32_t m_previousPass;
+};
+
+}
+
+#endif // _COMMAND_COUNTERS_H
@@ -0,0 +1,320 @@
+#include "cpu_mipmap_generator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CPU_MIPMAP_GENERATOR_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CPU_MIPMAP_GENERATOR_NEON
+#endif
+
+
+using CpuMipmapGenerator = VulkanEngine::CpuMipmapGenerator;
+using CpuMipFilter = VulkanEngine::CpuMipFilter;
+using TextureCacheEntry = VulkanEngine::TextureCacheEntry;
+using TextureCache = VulkanEngine::TextureCache;
+using TextureFormats = VulkanEngine::TextureFormats;
+
+// Levels are filtered as one linear RGBA float4 per texel, so every texel operation maps
+// onto a single 128-bit SIMD register.
+#if defined(CPU_MIPMAP_GENERATOR_SSE2)
+using Texel = __m128;
+
+static inline Texel loadTexel(const float* texel) { return _mm_loadu_ps(texel); }
+static inline void storeTexel(float* texel, Texel value) { _mm_storeu_ps(texel, value); }
+static inline Texel zeroTexel() { return _mm_setzero_ps(); }
+static inline Texel addTexels(Texel a, Texel b) { return _mm_add_ps(a, b); }
+static inline Texel scaleTexel(Texel a, float weight) { return _mm_mul_ps(a, _mm_set1_ps(weight)); }
+static inline Texel multiplyAddTexel(Texel accumulator, Texel a, float weight) {
+    return _mm_add_ps(accumulator, _mm_mul_ps(a, _mm_set1_ps(weight)));
+}
+#elif defined(CPU_MIPMAP_GENERATOR_NEON)
+using Texel = float32x4_t;
+
+static inline Texel loadTexel(const float* texel) { return vld1q_f32(texel); }
+static inline void storeTexel(float* texel, Texel value) { vst1q_f32(texel, value); }
+static inline Texel zeroTexel() { return vdupq_n_f32(0.0f); }
+static inline Texel addTexels(Texel a, Texel b) { return vaddq_f32(a, b); }
+static inline Texel scaleTexel(Texel a, float weight) { return vmulq_n_f32(a, weight); }
+static inline Texel multiplyAddTexel(Texel accumulator, Texel a, float weight) {
+    return vmlaq_n_f32(accumulator, a, weight);
+}
+#else
+struct Texel {
+    std::array<float, 4> channels;
+};
+
+static inline Texel loadTexel(const float* texel) { return Texel { { texel[0], texel[1], texel[2], texel[3] } }; }
+static inline void storeTexel(float* texel, Texel value) { std::memcpy(texel, value.channels.data(), sizeof(value.channels)); }
+static inline Texel zeroTexel() { return Texel { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+static inline Texel addTexels(Texel a, Texel b) {
+    return Texel { { a.channels[0] + b.channels[0], a.channels[1] + b.channels[1], a.channels[2] + b.channels[2], a.channels[3] + b.channels[3] } };
+}
+static inline Texel scaleTexel(Texel a, float weight) {
+    return Texel { { a.channels[0] * weight, a.channels[1] * weight, a.channels[2] * weight, a.channels[3] * weight } };
+}
+static inline Texel multiplyAddTexel(Texel accumulator, Texel a, float weight) {
+    return addTexels(accumulator, scaleTexel(a, weight));
+}
+#endif
+
+// The number of source texels a Kaiser filter tap covers along each axis for a 2x reduction.
+static constexpr size_t KAISER_TAP_COUNT = 6;
+static constexpr size_t LINEAR_TO_SRGB_TABLE_SIZE = 4096;
+
+static bool isSrgbFormat(VkFormat format) {
+    return format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_B8G8R8A8_SRGB;
+}
+
+static const std::array<float, 256>& getSrgbToLinearTable() {
+    static const auto table = []() {
+        auto values = std::array<float, 256> {};
+        for (size_t i = 0; i < values.size(); i++) {
+            const auto color = static_cast<float>(i) / 255.0f;
+            values[i] = (color <= 0.04045f) ? color / 12.92f : std::pow((color + 0.055f) / 1.055f, 2.4f);
+        }
+
+        return values;
+    }();
+
+    return table;
+}
+
+static const std::array<uint8_t, LINEAR_TO_SRGB_TABLE_SIZE>& getLinearToSrgbTable() {
+    static const auto table = []() {
+        auto values = std::array<uint8_t, LINEAR_TO_SRGB_TABLE_SIZE> {};
+        for (size_t i = 0; i < values.size(); i++) {
+            const auto color = static_cast<float>(i) / static_cast<float>(values.size() - 1);
+            const auto srgb = (color <= 0.0031308f) ? color * 12.92f : 1.055f * std::pow(color, 1.0f / 2.4f) - 0.055f;
+            values[i] = static_cast<uint8_t>(std::clamp(srgb * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+
+        return values;
+    }();
+
+    return table;
+}
+
+// The weights of a Kaiser-windowed sinc for halving an extent. Destination texel `x` sits
+// between source texels `2x` and `2x + 1`, so the taps lie at half-texel offsets from it.
+static const std::array<float, KAISER_TAP_COUNT>& getKaiserWeights() {
+    static const auto weights = []() {
+        const auto besselI0 = [](double x) -> double {
+            auto sum = 1.0;
+            auto term = 1.0;
+            for (int k = 1; k < 32; k++) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+
+            return sum;
+        };
+
+        constexpr auto pi = 3.14159265358979323846;
+        constexpr auto beta = 4.0;
+        constexpr auto halfWidth = 1.5;
+        auto values = std::array<float, KAISER_TAP_COUNT> {};
+        auto total = 0.0;
+        for (size_t i = 0; i < KAISER_TAP_COUNT; i++) {
+            // Distance in destination texels between the tap and the destination center.
+            const auto t = (static_cast<double>(i) - 2.5) / 2.0;
+            const auto sinc = std::sin(pi * t) / (pi * t);
+            const auto ratio = t / halfWidth;
+            const auto window = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - ratio * ratio))) / besselI0(beta);
+            values[i] = static_cast<float>(sinc * window);
+            total += values[i];
+        }
+
+        for (auto& value : values) {
+            value = static_cast<float>(value / total);
+        }
+
+        return values;
+    }();
+
+    return weights;
+}
+
+static std::vector<float> decodeLevel(const uint8_t* pixels, uint32_t width, uint32_t height, bool isSrgb) {
+    const auto& srgbToLinear = getSrgbToLinearTable();
+    const auto texelCount = size_t { width } * height;
+    auto texels = std::vector<float>(4 * texelCount);
+    for (size_t i = 0; i < texelCount; i++) {
+        for (size_t channel = 0; channel < 3; channel++) {
+            const auto value = pixels[4 * i + channel];
+            texels[4 * i + channel] = isSrgb ? srgbToLinear[value] : static_cast<float>(value) / 255.0f;
+        }
+
+        texels[4 * i + 3] = static_cast<float>(pixels[4 * i + 3]) / 255.0f;
+    }
+
+    return texels;
+}
+
+// Half float levels already are linear, and only need widening to single precision.
+static std::vector<float> decodeHalfLevel(const uint8_t* pixels, uint32_t width, uint32_t height) {
+    const auto valueCount = size_t { 4 } * width * height;
+    auto texels = std::vector<float>(valueCount);
+    for (size_t i = 0; i < valueCount; i++) {
+        auto value = uint16_t { 0 };
+        std::memcpy(&value, pixels + sizeof(uint16_t) * i, sizeof(uint16_t));
+        texels[i] = TextureFormats::fromHalf(value);
+    }
+
+    return texels;
+}
+
+static void encodeHalfLevel(const std::vector<float>& texels, uint8_t* pixels) {
+    for (size_t i = 0; i < texels.size(); i++) {
+        // Negative lobes of the Kaiser filter can undershoot, and alpha cannot exceed one.
+        const auto value = (i % 4 == 3) ? std::clamp(texels[i], 0.0f, 1.0f) : std::max(texels[i], 0.0f);
+        const auto half = TextureFormats::toHalf(value);
+        std::memcpy(pixels + sizeof(uint16_t) * i, &half, sizeof(uint16_t));
+    }
+}
+
+static void encodeLevel(const std::vector<float>& texels, uint8_t* pixels, bool isSrgb) {
+    const auto& linearToSrgb = getLinearToSrgbTable();
+    const auto toUnorm = [](float value) -> uint8_t {
+        return static_cast<uint8_t>(std::clamp(value * 255.0f + 0.5f, 0.0f, 255.0f));
+    };
+
+    const auto texelCount = texels.size() / 4;
+    for (size_t i = 0; i < texelCount; i++) {
+        for (size_t channel = 0; channel < 3; channel++) {
+            const auto value = texels[4 * i + channel];
+            if (isSrgb) {
+                const auto index = static_cast<size_t>(std::clamp(value, 0.0f, 1.0f) * (LINEAR_TO_SRGB_TABLE_SIZE - 1) + 0.5f);
+                pixels[4 * i + channel] = linearToSrgb[index];
+            } else {
+                pixels[4 * i + channel] = toUnorm(value);
+            }
+        }
+
+        pixels[4 * i + 3] = toUnorm(texels[4 * i + 3]);
+    }
+}
+
+static std::vector<float> downsampleBox(const std::vector<float>& source, uint32_t width, uint32_t height, uint32_t nextWidth, uint32_t nextHeight) {
+    auto destination = std::vector<float>(size_t { 4 } * nextWidth * nextHeight);
+    for (uint32_t y = 0; y < nextHeight; y++) {
+        const auto* row0 = source.data() + size_t { 4 } * width * std::min(2 * y, height - 1);
+        const auto* row1 = source.data() + size_t { 4 } * width * std::min(2 * y + 1, height - 1);
+        auto* destinationRow = destination.data() + size_t { 4 } * nextWidth * y;
+        for (uint32_t x = 0; x < nextWidth; x++) {
+            const auto x0 = size_t { 4 } * std::min(2 * x, width - 1);
+            const auto x1 = size_t { 4 } * std::min(2 * x + 1, width - 1);
+            const auto sum = addTexels(
+                addTexels(loadTexel(row0 + x0), loadTexel(row0 + x1)),
+                addTexels(loadTexel(row1 + x0), loadTexel(row1 + x1))
+            );
+
+            storeTexel(destinationRow + 4 * x, scaleTexel(sum, 0.25f));
+        }
+    }
+
+    return destination;
+}
+
+static std::vector<float> downsampleKaiser(const std::vector<float>& source, uint32_t width, uint32_t height, uint32_t nextWidth, uint32_t nextHeight) {
+    const auto& weights = getKaiserWeights();
+    const auto clampCoordinate = [](int64_t coordinate, uint32_t extent) -> size_t {
+        return static_cast<size_t>(std::clamp<int64_t>(coordinate, 0, static_cast<int64_t>(extent) - 1));
+    };
+
+    // The filter is separable: halve the width first, then the height.
+    auto horizontal = std::vector<float>(size_t { 4 } * nextWidth * height);
+    for (uint32_t y = 0; y < height; y++) {
+        const auto* sourceRow = source.data() + size_t { 4 } * width * y;
+        auto* horizontalRow = horizontal.data() + size_t { 4 } * nextWidth * y;
+        for (uint32_t x = 0; x < nextWidth; x++) {
+            auto sum = zeroTexel();
+            for (size_t tap = 0; tap < KAISER_TAP_COUNT; tap++) {
+                const auto sourceX = clampCoordinate(int64_t { 2 } * x - 2 + static_cast<int64_t>(tap), width);
+                sum = multiplyAddTexel(sum, loadTexel(sourceRow + 4 * sourceX), weights[tap]);
+            }
+
+            storeTexel(horizontalRow + 4 * x, sum);
+        }
+    }
+
+    auto destination = std::vector<float>(size_t { 4 } * nextWidth * nextHeight);
+    for (uint32_t y = 0; y < nextHeight; y++) {
+        auto* destinationRow = destination.data() + size_t { 4 } * nextWidth * y;
+        for (uint32_t x = 0; x < nextWidth; x++) {
+            auto sum = zeroTexel();
+            for (size_t tap = 0; tap < KAISER_TAP_COUNT; tap++) {
+                const auto sourceY = clampCoordinate(int64_t { 2 } * y - 2 + static_cast<int64_t>(tap), height);
+                sum = multiplyAddTexel(sum, loadTexel(horizontal.data() + size_t { 4 } * (nextWidth * sourceY + x)), weights[tap]);
+            }
+
+            storeTexel(destinationRow + 4 * x, sum);
+        }
+    }
+
+    return destination;
+}
+
+bool CpuMipmapGenerator::supportsFormat(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM: return true;
+        case VK_FORMAT_R8G8B8A8_SRGB: return true;
+        case VK_FORMAT_B8G8R8A8_UNORM: return true;
+        case VK_FORMAT_B8G8R8A8_SRGB: return true;
+        case VK_FORMAT_R16G16B16A16_SFLOAT: return true;
+        default: return false;
+    }
+}
+
+TextureCacheEntry CpuMipmapGenerator::generate(
+    VkFormat format,
+    const uint8_t* pixels,
+    uint32_t width,
+    uint32_t height,
+    uint32_t mipLevels,
+    CpuMipFilter filter
+) {
+    if (!CpuMipmapGenerator::supportsFormat(format)) {
+        throw std::invalid_argument("unsupported format for CPU mipmap generation!");
+    }
+
+    const auto isSrgb = isSrgbFormat(format);
+    const auto isHalfFloat = format == VK_FORMAT_R16G16B16A16_SFLOAT;
+    auto entry = TextureCacheEntry {
+        .format = format,
+        .width = width,
+        .height = height,
+        .levels = TextureCache::createLevels(*TextureFormats::getInfo(format), width, height, mipLevels),
+    };
+    entry.data.resize(entry.levels.back().offset + entry.levels.back().size);
+    std::memcpy(entry.data.data(), pixels, static_cast<size_t>(entry.levels[0].size));
+
+    auto currentLevel = isHalfFloat ? decodeHalfLevel(pixels, width, height) : decodeLevel(pixels, width, height, isSrgb);
+    for (uint32_t i = 1; i < mipLevels; i++) {
+        const auto& previous = entry.levels[i - 1];
+        const auto& next = entry.levels[i];
+        auto nextLevel = [&]() -> std::vector<float> {
+            if (filter == CpuMipFilter::Kaiser) {
+                return downsampleKaiser(currentLevel, previous.width, previous.height, next.width, next.height);
+            } else {
+                return downsampleBox(currentLevel, previous.width, previous.height, next.width, next.height);
+            }
+        }();
+
+        if (isHalfFloat) {
+            encodeHalfLevel(nextLevel, entry.data.data() + next.offset);
+        } else {
+            encodeLevel(nextLevel, entry.data.data() + next.offset, isSrgb);
+        }
+        currentLevel = std::move(nextLevel);
+    }
+
+    return entry;
+}
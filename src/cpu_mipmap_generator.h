@@ -0,0 +1,50 @@
+#ifndef _CPU_MIPMAP_GENERATOR_H
+#define _CPU_MIPMAP_GENERATOR_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+#include "texture_cache.h"
+
+
+namespace VulkanEngine {
+
+/// @brief The downsampling filter used by the `CpuMipmapGenerator`.
+enum class CpuMipFilter {
+    /// @brief Average each 2x2 footprint. Fast, but soft and prone to aliasing.
+    Box,
+    /// @brief A Kaiser-windowed sinc over a 6x6 footprint. Sharper, with less aliasing.
+    Kaiser
+};
+
+/// @brief Builds mip chains for 8-bit and half float RGBA textures on the CPU.
+///
+/// @note This is the fallback for formats the device cannot blit with linear filtering,
+/// and it can also be used on purpose to keep mip generation off the GPU. Every level is
+/// filtered from the previous level in linear floating point, so sRGB textures are
+/// converted to linear first and back to sRGB only when a level is written out. The inner
+/// loops operate on whole texels with SSE2 or NEON when the target supports them.
+///
+/// The chain is returned laid out exactly like a texture cache entry, so it can be uploaded
+/// with a single copy and stored in the cache as-is.
+class CpuMipmapGenerator final {
+    public:
+        explicit CpuMipmapGenerator() = delete;
+
+        static bool supportsFormat(VkFormat format);
+
+        /// @brief Generate `mipLevels` levels from the tightly packed level 0 in `pixels`.
+        static TextureCacheEntry generate(
+            VkFormat format,
+            const uint8_t* pixels,
+            uint32_t width,
+            uint32_t height,
+            uint32_t mipLevels,
+            CpuMipFilter filter
+        );
+};
+
+}
+
+#endif // _CPU_MIPMAP_GENERATOR_H
@@ -0,0 +1,132 @@
+#include "cpu_profiler.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+
+using CpuZoneRing = VulkanEngine::CpuZoneRing;
+using CpuZoneEvent = VulkanEngine::CpuZoneEvent;
+using CpuCounterEvent = VulkanEngine::CpuCounterEvent;
+using CpuProfiler = VulkanEngine::CpuProfiler;
+
+static std::mutex g_threadRingsMutex;
+static std::vector<std::unique_ptr<CpuZoneRing>> g_threadRings;
+static std::mutex g_countersMutex;
+static std::vector<CpuCounterEvent> g_counters;
+static uint64_t g_counterWriteCount = 0;
+
+static std::string escapeJsonString(const char* string) {
+    auto escaped = std::string {};
+    for (const char* c = string; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            escaped.push_back('\\');
+        }
+
+        escaped.push_back(*c);
+    }
+
+    return escaped;
+}
+
+CpuZoneRing::CpuZoneRing(uint32_t threadIndex)
+    : m_threadIndex { threadIndex }
+    , m_writeCount { 0 }
+    , m_events {}
+{
+}
+
+uint32_t CpuZoneRing::getThreadIndex() const {
+    return m_threadIndex;
+}
+
+std::vector<CpuZoneEvent> CpuZoneRing::getEvents() const {
+    const auto writeCount = m_writeCount.load(std::memory_order_acquire);
+    const auto eventCount = std::min<uint64_t>(writeCount, CAPACITY);
+
+    auto events = std::vector<CpuZoneEvent> {};
+    events.reserve(eventCount);
+    for (uint64_t i = writeCount - eventCount; i < writeCount; i++) {
+        events.push_back(m_events[i % CAPACITY]);
+    }
+
+    return events;
+}
+
+std::chrono::steady_clock::time_point CpuProfiler::getEpoch() {
+    static const auto epoch = std::chrono::steady_clock::now();
+
+    return epoch;
+}
+
+CpuZoneRing* CpuProfiler::createThreadRing() {
+    const auto lock = std::lock_guard<std::mutex> { g_threadRingsMutex };
+    const auto threadIndex = static_cast<uint32_t>(g_threadRings.size());
+    g_threadRings.push_back(std::make_unique<CpuZoneRing>(threadIndex));
+
+    return g_threadRings.back().get();
+}
+
+void CpuProfiler::recordCounter(const char* name, double value) {
+    const auto event = CpuCounterEvent {
+        .name = name,
+        .nanoseconds = CpuProfiler::now(),
+        .value = value,
+    };
+    const auto lock = std::lock_guard<std::mutex> { g_countersMutex };
+    if (g_counters.size() < COUNTER_CAPACITY) {
+        g_counters.push_back(event);
+    } else {
+        g_counters[g_counterWriteCount % COUNTER_CAPACITY] = event;
+    }
+    g_counterWriteCount++;
+}
+
+void CpuProfiler::writeChromeTrace(const std::filesystem::path& filePath) {
+    if (filePath.has_parent_path()) {
+        std::filesystem::create_directories(filePath.parent_path());
+    }
+
+    auto file = std::ofstream { filePath, std::ios::out | std::ios::trunc };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open CPU trace file!");
+    }
+
+    // Chrome traces count time in microseconds.
+    const auto lock = std::lock_guard<std::mutex> { g_threadRingsMutex };
+    file << "{\"traceEvents\":[";
+    auto isFirstEvent = true;
+    for (const auto& threadRing : g_threadRings) {
+        for (const auto& event : threadRing->getEvents()) {
+            file << fmt::format(
+                "{}\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                isFirstEvent ? "" : ",",
+                escapeJsonString(event.name),
+                threadRing->getThreadIndex(),
+                static_cast<double>(event.startNanoseconds) / 1000.0,
+                static_cast<double>(event.endNanoseconds - event.startNanoseconds) / 1000.0
+            );
+            isFirstEvent = false;
+        }
+    }
+
+    // Counters are written oldest first, continuing from where the ring wraps around.
+    const auto countersLock = std::lock_guard<std::mutex> { g_countersMutex };
+    const auto counterStart = g_counterWriteCount - g_counters.size();
+    for (auto i = counterStart; i < g_counterWriteCount; i++) {
+        const auto& event = g_counters[i % COUNTER_CAPACITY];
+        file << fmt::format(
+            "{}\n{{\"name\":\"{}\",\"ph\":\"C\",\"pid\":0,\"ts\":{:.3f},\"args\":{{\"value\":{}}}}}",
+            isFirstEvent ? "" : ",",
+            escapeJsonString(event.name),
+            static_cast<double>(event.nanoseconds) / 1000.0,
+            event.value
+        );
+        isFirstEvent = false;
+    }
+    file << "\n]}\n";
+}
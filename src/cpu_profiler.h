@@ -0,0 +1,159 @@
+#ifndef _CPU_PROFILER_H
+#define _CPU_PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+#if defined(ENABLE_CPU_PROFILING) && defined(TRACY_ENABLE)
+#include <tracy/Tracy.hpp>
+#endif
+
+
+namespace VulkanEngine {
+
+/// @brief A zone of CPU time, in nanoseconds since the profiler started.
+struct CpuZoneEvent final {
+    const char* name;
+    uint64_t startNanoseconds;
+    uint64_t endNanoseconds;
+};
+
+/// @brief A value of a counter, at a time in nanoseconds since the profiler started.
+struct CpuCounterEvent final {
+    const char* name;
+    uint64_t nanoseconds;
+    double value;
+};
+
+/// @brief The zones one thread has closed, in a ring that keeps the newest `CAPACITY`.
+///
+/// @note Only the owning thread writes a ring, so writing a zone takes no lock. The write
+/// count is published with release ordering, so another thread that reads the ring while
+/// its owner has stopped writing sees every zone written before it.
+class CpuZoneRing final {
+    public:
+        static constexpr size_t CAPACITY = 1 << 16;
+
+        explicit CpuZoneRing() = delete;
+        explicit CpuZoneRing(uint32_t threadIndex);
+
+        ~CpuZoneRing() = default;
+
+        CpuZoneRing(const CpuZoneRing& other) = delete;
+        CpuZoneRing& operator=(const CpuZoneRing& other) = delete;
+
+        uint32_t getThreadIndex() const;
+
+        void push(const CpuZoneEvent& event) {
+            const auto writeCount = m_writeCount.load(std::memory_order_relaxed);
+            m_events[writeCount % CAPACITY] = event;
+            m_writeCount.store(writeCount + 1, std::memory_order_release);
+        }
+
+        /// @brief Copy out the zones in the ring, oldest first.
+        std::vector<CpuZoneEvent> getEvents() const;
+    private:
+        uint32_t m_threadIndex;
+        std::atomic<uint64_t> m_writeCount;
+        std::array<CpuZoneEvent, CAPACITY> m_events;
+};
+
+/// @brief Collects the CPU zones of every thread.
+///
+/// @note Every thread gets a ring of its own the first time it closes a zone. That is the
+/// only time the profiler takes a lock on the hot path, and rings live until the program
+/// exits, so the zones of threads that have finished can still be exported.
+///
+/// Counters are written with `CPU_PROFILE_COUNTER`, which takes a lock and keeps the newest
+/// `COUNTER_CAPACITY` values of all counters between them, so it is meant for a few values a
+/// frame rather than for the hot path.
+///
+/// Zones are opened with `CPU_PROFILE_ZONE`, which compiles to nothing unless
+/// `ENABLE_CPU_PROFILING` is defined, and counters likewise. With `TRACY_ENABLE` defined as
+/// well, zones and counters go to Tracy instead.
+class CpuProfiler final {
+    public:
+#if defined(ENABLE_CPU_PROFILING)
+        static constexpr bool IS_ENABLED = true;
+#else
+        static constexpr bool IS_ENABLED = false;
+#endif
+        static constexpr size_t COUNTER_CAPACITY = 1 << 16;
+
+        explicit CpuProfiler() = delete;
+
+        static uint64_t now() {
+            const auto elapsed = std::chrono::steady_clock::now() - CpuProfiler::getEpoch();
+
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+
+        static CpuZoneRing& getThreadRing() {
+            thread_local CpuZoneRing* threadRing = CpuProfiler::createThreadRing();
+
+            return *threadRing;
+        }
+
+        /// @brief Record the value of the counter `name`, which has to outlive the profiler.
+        static void recordCounter(const char* name, double value);
+
+        /// @brief Write the zones of every thread as a Chrome trace, which `chrome://tracing`
+        /// and Perfetto open.
+        ///
+        /// @note The traced threads must not be writing zones at the same time.
+        static void writeChromeTrace(const std::filesystem::path& filePath);
+    private:
+        static std::chrono::steady_clock::time_point getEpoch();
+
+        static CpuZoneRing* createThreadRing();
+};
+
+/// @brief Times the scope it lives in as one CPU zone.
+///
+/// @note `name` has to outlive the profiler, which string literals do.
+class CpuScopedZone final {
+    public:
+        explicit CpuScopedZone() = delete;
+        explicit CpuScopedZone(const char* name)
+            : m_name { name }
+            , m_startNanoseconds { CpuProfiler::now() }
+        {
+        }
+
+        ~CpuScopedZone() {
+            CpuProfiler::getThreadRing().push(CpuZoneEvent {
+                .name = m_name,
+                .startNanoseconds = m_startNanoseconds,
+                .endNanoseconds = CpuProfiler::now(),
+            });
+        }
+
+        CpuScopedZone(const CpuScopedZone& other) = delete;
+        CpuScopedZone& operator=(const CpuScopedZone& other) = delete;
+    private:
+        const char* m_name;
+        uint64_t m_startNanoseconds;
+};
+
+}
+
+#define CPU_PROFILE_CONCAT_IMPL(a, b) a##b
+#define CPU_PROFILE_CONCAT(a, b) CPU_PROFILE_CONCAT_IMPL(a, b)
+
+#if defined(ENABLE_CPU_PROFILING) && defined(TRACY_ENABLE)
+#define CPU_PROFILE_ZONE(name) ZoneScopedN(name)
+#define CPU_PROFILE_COUNTER(name, value) TracyPlot(name, static_cast<double>(value))
+#elif defined(ENABLE_CPU_PROFILING)
+#define CPU_PROFILE_ZONE(name) const auto CPU_PROFILE_CONCAT(cpuProfileZone, __LINE__) = VulkanEngine::CpuScopedZone { name }
+#define CPU_PROFILE_COUNTER(name, value) VulkanEngine::CpuProfiler::recordCounter(name, static_cast<double>(value))
+#else
+#define CPU_PROFILE_ZONE(name) ((void)0)
+#define CPU_PROFILE_COUNTER(name, value) ((void)(value))
+#endif
+
+#endif // _CPU_PROFILER_H
@@ -0,0 +1,364 @@
+#include "cpu_topology.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include <fmt/core.h>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+using CpuTopology = VulkanEngine::CpuTopology;
+using CpuSet = VulkanEngine::CpuSet;
+using LogicalCpu = VulkanEngine::LogicalCpu;
+using CoreClass = VulkanEngine::CoreClass;
+
+/// @brief Every CPU the standard library knows of, as performance cores on one node.
+static std::vector<LogicalCpu> getUniformCpus() {
+    auto cpus = std::vector<LogicalCpu> {};
+    const auto cpuCount = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t i = 0; i < cpuCount; i++) {
+        cpus.push_back(LogicalCpu { .index = i, .numaNode = 0, .coreClass = CoreClass::Performance });
+    }
+
+    return cpus;
+}
+
+#if defined(__linux__)
+
+static std::optional<std::string> readSysfsFile(const std::filesystem::path& path) {
+    auto file = std::ifstream { path };
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+
+    auto contents = std::string {};
+    std::getline(file, contents);
+
+    return contents;
+}
+
+/// @brief Parse a sysfs CPU list, like `0-3,8,10-11`.
+static CpuSet parseCpuList(const std::string& cpuList) {
+    auto cpus = CpuSet {};
+    size_t position = 0;
+    while (position < cpuList.size()) {
+        const auto end = std::min(cpuList.find(',', position), cpuList.size());
+        const auto range = cpuList.substr(position, end - position);
+        position = end + 1;
+        if (range.empty() || range.find_first_of("0123456789") == std::string::npos) {
+            continue;
+        }
+
+        const auto dash = range.find('-');
+        const auto first = static_cast<uint32_t>(std::stoul(range.substr(0, dash)));
+        const auto last = dash == std::string::npos ? first : static_cast<uint32_t>(std::stoul(range.substr(dash + 1)));
+        for (auto cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+static std::vector<LogicalCpu> detectCpus() {
+    const auto onlineCpus = readSysfsFile("/sys/devices/system/cpu/online");
+    if (!onlineCpus.has_value()) {
+        return getUniformCpus();
+    }
+
+    auto numaNodes = std::unordered_map<uint32_t, uint32_t> {};
+    auto errorCode = std::error_code {};
+    for (const auto& entry : std::filesystem::directory_iterator { "/sys/devices/system/node", errorCode }) {
+        const auto name = entry.path().filename().string();
+        if (!name.starts_with("node") || name.size() == 4 || name.find_first_not_of("0123456789", 4) != std::string::npos) {
+            continue;
+        }
+
+        const auto numaNode = static_cast<uint32_t>(std::stoul(name.substr(4)));
+        const auto nodeCpus = readSysfsFile(entry.path() / "cpulist");
+        if (nodeCpus.has_value()) {
+            for (const auto cpu : parseCpuList(*nodeCpus)) {
+                numaNodes[cpu] = numaNode;
+            }
+        }
+    }
+
+    // Hybrid Intel parts list their efficiency cores as a PMU of their own. Elsewhere the
+    // smaller cores of a hybrid part have a lower capacity than the biggest ones.
+    auto efficiencyCpus = std::unordered_map<uint32_t, bool> {};
+    const auto atomCpus = readSysfsFile("/sys/devices/cpu_atom/cpus");
+    const auto cpuIndices = parseCpuList(*onlineCpus);
+    if (atomCpus.has_value()) {
+        for (const auto cpu : parseCpuList(*atomCpus)) {
+            efficiencyCpus[cpu] = true;
+        }
+    } else {
+        auto capacities = std::unordered_map<uint32_t, uint32_t> {};
+        auto maxCapacity = uint32_t { 0 };
+        for (const auto cpu : cpuIndices) {
+            const auto capacity = readSysfsFile(fmt::format("/sys/devices/system/cpu/cpu{}/cpu_capacity", cpu));
+            if (capacity.has_value() && !capacity->empty()) {
+                capacities[cpu] = static_cast<uint32_t>(std::stoul(*capacity));
+                maxCapacity = std::max(maxCapacity, capacities[cpu]);
+            }
+        }
+
+        for (const auto& [cpu, capacity] : capacities) {
+            efficiencyCpus[cpu] = capacity < maxCapacity;
+        }
+    }
+
+    auto cpus = std::vector<LogicalCpu> {};
+    for (const auto cpu : cpuIndices) {
+        const auto numaNode = numaNodes.find(cpu);
+        const auto isEfficiency = efficiencyCpus.find(cpu);
+        cpus.push_back(LogicalCpu {
+            .index = cpu,
+            .numaNode = numaNode != numaNodes.end() ? numaNode->second : 0,
+            .coreClass = isEfficiency != efficiencyCpus.end() && isEfficiency->second ? CoreClass::Efficiency : CoreClass::Performance,
+        });
+    }
+
+    if (cpus.empty()) {
+        return getUniformCpus();
+    }
+
+    return cpus;
+}
+
+#elif defined(_WIN32)
+
+static std::vector<LogicalCpu> detectCpus() {
+    auto size = DWORD { 0 };
+    GetLogicalProcessorInformationEx(RelationAll, nullptr, &size);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+        return getUniformCpus();
+    }
+
+    auto buffer = std::vector<uint8_t>(size);
+    if (!GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &size)) {
+        return getUniformCpus();
+    }
+
+    // Only the first processor group is used, which holds every CPU of a machine with up
+    // to 64 of them. A higher efficiency class is a faster core.
+    auto coreClasses = std::vector<BYTE>(64, 0);
+    auto numaNodes = std::vector<uint32_t>(64, 0);
+    auto activeMask = KAFFINITY { 0 };
+    auto maxEfficiencyClass = BYTE { 0 };
+    for (size_t offset = 0; offset < size;) {
+        const auto* info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+        if (info->Relationship == RelationProcessorCore && info->Processor.GroupMask[0].Group == 0) {
+            const auto mask = info->Processor.GroupMask[0].Mask;
+            activeMask |= mask;
+            maxEfficiencyClass = std::max(maxEfficiencyClass, info->Processor.EfficiencyClass);
+            for (uint32_t i = 0; i < 64; i++) {
+                if (mask & (KAFFINITY { 1 } << i)) {
+                    coreClasses[i] = info->Processor.EfficiencyClass;
+                }
+            }
+        } else if (info->Relationship == RelationNumaNode && info->NumaNode.GroupMask.Group == 0) {
+            const auto mask = info->NumaNode.GroupMask.Mask;
+            for (uint32_t i = 0; i < 64; i++) {
+                if (mask & (KAFFINITY { 1 } << i)) {
+                    numaNodes[i] = info->NumaNode.NodeNumber;
+                }
+            }
+        }
+
+        offset += info->Size;
+    }
+
+    auto cpus = std::vector<LogicalCpu> {};
+    for (uint32_t i = 0; i < 64; i++) {
+        if (activeMask & (KAFFINITY { 1 } << i)) {
+            cpus.push_back(LogicalCpu {
+                .index = i,
+                .numaNode = numaNodes[i],
+                .coreClass = coreClasses[i] < maxEfficiencyClass ? CoreClass::Efficiency : CoreClass::Performance,
+            });
+        }
+    }
+
+    if (cpus.empty()) {
+        return getUniformCpus();
+    }
+
+    return cpus;
+}
+
+#else
+
+static std::vector<LogicalCpu> detectCpus() {
+    return getUniformCpus();
+}
+
+#endif
+
+CpuTopology::CpuTopology(std::vector<LogicalCpu> cpus)
+    : m_cpus { std::move(cpus) }
+    , m_numaNodeCount { 0 }
+    , m_renderNode { 0 }
+{
+    if (m_cpus.empty()) {
+        throw std::invalid_argument("a CPU topology needs at least one CPU!");
+    }
+
+    for (const auto& cpu : m_cpus) {
+        m_numaNodeCount = std::max(m_numaNodeCount, cpu.numaNode + 1);
+    }
+
+    // A node without performance cores, like a memory-only node, is never the render node.
+    const auto renderCpu = std::find_if(m_cpus.begin(), m_cpus.end(), [](const LogicalCpu& cpu) {
+        return cpu.coreClass == CoreClass::Performance;
+    });
+    m_renderNode = renderCpu != m_cpus.end() ? renderCpu->numaNode : m_cpus.front().numaNode;
+    for (const auto& cpu : m_cpus) {
+        if (cpu.coreClass == CoreClass::Performance) {
+            m_renderNode = std::min(m_renderNode, cpu.numaNode);
+        }
+    }
+}
+
+CpuTopology CpuTopology::detect() {
+    return CpuTopology { detectCpus() };
+}
+
+bool CpuTopology::pinCurrentThread(std::span<const uint32_t> cpus) {
+    if (cpus.empty()) {
+        return true;
+    }
+
+#if defined(__linux__)
+    auto cpuSet = cpu_set_t {};
+    CPU_ZERO(&cpuSet);
+    for (const auto cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#elif defined(_WIN32)
+    auto mask = DWORD_PTR { 0 };
+    for (const auto cpu : cpus) {
+        if (cpu < 64) {
+            mask |= DWORD_PTR { 1 } << cpu;
+        }
+    }
+
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    return false;
+#endif
+}
+
+const std::vector<LogicalCpu>& CpuTopology::getCpus() const {
+    return m_cpus;
+}
+
+uint32_t CpuTopology::getNumaNodeCount() const {
+    return m_numaNodeCount;
+}
+
+bool CpuTopology::isHybrid() const {
+    return std::any_of(m_cpus.begin(), m_cpus.end(), [](const LogicalCpu& cpu) {
+        return cpu.coreClass == CoreClass::Efficiency;
+    });
+}
+
+uint32_t CpuTopology::getRenderNode() const {
+    return m_renderNode;
+}
+
+CpuSet CpuTopology::getCpus(uint32_t numaNode, CoreClass coreClass) const {
+    auto cpus = CpuSet {};
+    for (const auto& cpu : m_cpus) {
+        if (cpu.numaNode == numaNode && cpu.coreClass == coreClass) {
+            cpus.push_back(cpu.index);
+        }
+    }
+
+    return cpus;
+}
+
+CpuSet CpuTopology::getRenderCpus() const {
+    auto cpus = this->getCpus(m_renderNode, CoreClass::Performance);
+    if (cpus.empty()) {
+        cpus = this->getCpus(m_renderNode, CoreClass::Efficiency);
+    }
+
+    return cpus;
+}
+
+CpuSet CpuTopology::getBackgroundCpus() const {
+    auto cpus = this->getCpus(m_renderNode, CoreClass::Efficiency);
+    if (cpus.empty()) {
+        cpus = this->getCpus(m_renderNode, CoreClass::Performance);
+    }
+
+    return cpus;
+}
+
+std::vector<CpuSet> CpuTopology::getWorkerCpuSets(uint32_t workerCount) const {
+    // Worker `i` goes to the node of the performance core `i` of `workerCount` evenly spaced
+    // ones, so the nodes with more of them get more workers.
+    auto performanceCpus = std::vector<LogicalCpu> {};
+    for (const auto& cpu : m_cpus) {
+        if (cpu.coreClass == CoreClass::Performance) {
+            performanceCpus.push_back(cpu);
+        }
+    }
+    if (performanceCpus.empty()) {
+        performanceCpus = m_cpus;
+    }
+    std::stable_sort(performanceCpus.begin(), performanceCpus.end(), [](const LogicalCpu& lhs, const LogicalCpu& rhs) {
+        return lhs.numaNode < rhs.numaNode;
+    });
+
+    auto nodeCpuSets = std::vector<CpuSet>(m_numaNodeCount);
+    for (const auto& cpu : performanceCpus) {
+        nodeCpuSets[cpu.numaNode].push_back(cpu.index);
+    }
+
+    auto workerCpuSets = std::vector<CpuSet> {};
+    for (uint32_t i = 0; i < workerCount; i++) {
+        const auto& cpu = performanceCpus[static_cast<size_t>(i) * performanceCpus.size() / workerCount];
+        workerCpuSets.push_back(nodeCpuSets[cpu.numaNode]);
+    }
+
+    return workerCpuSets;
+}
+
+void CpuTopology::printReport() const {
+    const auto efficiencyCount = std::count_if(m_cpus.begin(), m_cpus.end(), [](const LogicalCpu& cpu) {
+        return cpu.coreClass == CoreClass::Efficiency;
+    });
+    fmt::println(
+        "CPU topology: {} logical CPUs, {} performance and {} efficiency, on {} NUMA nodes. Render node: {}",
+        m_cpus.size(),
+        m_cpus.size() - efficiencyCount,
+        efficiencyCount,
+        m_numaNodeCount,
+        m_renderNode
+    );
+}
@@ -0,0 +1,93 @@
+#ifndef _CPU_TOPOLOGY_H
+#define _CPU_TOPOLOGY_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief The logical CPUs a thread may run on. An empty set leaves the thread wherever
+/// the scheduler puts it.
+using CpuSet = std::vector<uint32_t>;
+
+enum class CoreClass {
+    Performance,
+    Efficiency
+};
+
+struct LogicalCpu final {
+    uint32_t index;
+    uint32_t numaNode;
+    CoreClass coreClass;
+};
+
+/// @brief The logical CPUs of the machine, which NUMA node each of them is on, and whether
+/// it is a performance or an efficiency core, with the CPUs each kind of thread is placed
+/// on.
+///
+/// @note The render node is the first node with performance cores. The render thread
+/// records and submits every frame and creates the device, so the host memory the driver
+/// allocates for it, like the staging ring, is local to that node. Decode and I/O threads
+/// write into memory the render thread then stages, so they stay on the render node too,
+/// on its efficiency cores where it has any, and off to the side of the render thread.
+/// Job workers are spread over the performance cores of every node, and each one is kept
+/// to the cores of one node so that the memory its jobs touch stays local to it.
+///
+/// On Linux the topology is read from sysfs, where hybrid Intel parts list their
+/// efficiency cores under `cpu_atom`, and where other hybrid parts give their smaller
+/// cores a lower capacity. On Windows it comes from the processor information of the first
+/// processor group. Everywhere else every CPU is a performance core on one node, and
+/// threads cannot be pinned.
+class CpuTopology final {
+    public:
+        explicit CpuTopology() = delete;
+        explicit CpuTopology(std::vector<LogicalCpu> cpus);
+
+        ~CpuTopology() = default;
+
+        /// @brief Read the topology of the machine the process runs on.
+        static CpuTopology detect();
+
+        /// @brief Pin the calling thread to `cpus`.
+        ///
+        /// @note Returns false where threads cannot be pinned, or the OS refused. An empty
+        /// set leaves the thread as it is.
+        static bool pinCurrentThread(std::span<const uint32_t> cpus);
+
+        const std::vector<LogicalCpu>& getCpus() const;
+
+        uint32_t getNumaNodeCount() const;
+
+        /// @brief Whether the machine has both performance and efficiency cores.
+        bool isHybrid() const;
+
+        uint32_t getRenderNode() const;
+
+        /// @brief The CPUs of `numaNode` of the class `coreClass`.
+        CpuSet getCpus(uint32_t numaNode, CoreClass coreClass) const;
+
+        /// @brief The CPUs the render thread, which also submits, runs on: the performance
+        /// cores of the render node.
+        CpuSet getRenderCpus() const;
+
+        /// @brief The CPUs decode and I/O threads run on: the efficiency cores of the render
+        /// node, or all of its CPUs when it has none.
+        CpuSet getBackgroundCpus() const;
+
+        /// @brief The CPUs of each of `workerCount` job workers, which are the performance
+        /// cores of one node each, with the workers spread over the nodes by their number of
+        /// performance cores.
+        std::vector<CpuSet> getWorkerCpuSets(uint32_t workerCount) const;
+
+        void printReport() const;
+    private:
+        std::vector<LogicalCpu> m_cpus;
+        uint32_t m_numaNodeCount;
+        uint32_t m_renderNode;
+};
+
+}
+
+#endif // _CPU_TOPOLOGY_H
@@ -0,0 +1,100 @@
+#include "debug_log_queue.h"
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+
+
+using DebugLogQueue = VulkanEngine::DebugLogQueue;
+
+DebugLogQueue::DebugLogQueue(std::ostream& stream)
+    : m_stream { stream }
+    , m_slots {}
+    , m_pushPosition { 0 }
+    , m_drainPosition { 0 }
+    , m_signal { 0 }
+    , m_isStopping { false }
+    , m_droppedCount { 0 }
+    , m_thread {}
+{
+    for (size_t i = 0; i < CAPACITY; i++) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    m_thread = std::thread { [this]() { this->run(); } };
+}
+
+DebugLogQueue::~DebugLogQueue() {
+    m_isStopping.store(true);
+    m_signal.fetch_add(1, std::memory_order_release);
+    m_signal.notify_one();
+    m_thread.join();
+
+    const auto droppedCount = this->getDroppedCount();
+    if (droppedCount > 0) {
+        fmt::println(m_stream, "dropped {} debug messages, because the log queue was full", droppedCount);
+    }
+}
+
+bool DebugLogQueue::push(std::string_view label, std::string_view message) {
+    // Claim the slot at the push position. A slot whose sequence is behind the position is
+    // still waiting to be drained, so the queue is full.
+    auto position = m_pushPosition.load(std::memory_order_relaxed);
+    auto* slot = static_cast<Slot*>(nullptr);
+    while (true) {
+        slot = &m_slots[position & (CAPACITY - 1)];
+        const auto sequence = slot->sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0) {
+            if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+
+            return false;
+        } else {
+            position = m_pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->label = label;
+    slot->message.assign(message);
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    m_signal.fetch_add(1, std::memory_order_release);
+    m_signal.notify_one();
+
+    return true;
+}
+
+uint64_t DebugLogQueue::getDroppedCount() const {
+    return m_droppedCount.load(std::memory_order_relaxed);
+}
+
+void DebugLogQueue::drain() {
+    while (true) {
+        auto& slot = m_slots[m_drainPosition & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != m_drainPosition + 1) {
+            return;
+        }
+
+        fmt::println(m_stream, "[{}] {}", slot.label, slot.message);
+        slot.sequence.store(m_drainPosition + CAPACITY, std::memory_order_release);
+        m_drainPosition++;
+    }
+}
+
+void DebugLogQueue::run() {
+    while (true) {
+        // The signal is read before draining, so a push that lands after the drain changes
+        // it, and the wait returns at once.
+        const auto signal = m_signal.load(std::memory_order_acquire);
+        this->drain();
+        if (m_isStopping.load()) {
+            this->drain();
+            return;
+        }
+
+        m_signal.wait(signal, std::memory_order_acquire);
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef _DEBUG_LOG_QUEUE_H
+#define _DEBUG_LOG_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+
+namespace VulkanEngine {
+
+/// @brief A bounded, lock-free queue of log messages that any thread may push onto, which
+/// a background thread drains into a stream.
+///
+/// @note Pushing a message copies it into a slot of the ring and returns, so the thread
+/// that logs it never formats it, never takes a lock, and never waits on the stream. Every
+/// slot keeps the string it held last, so once the slots have held messages as long as the
+/// ones that come after, pushing allocates nothing. When every slot is taken the message is
+/// dropped and counted, rather than blocking the thread that logs it, which is usually a
+/// driver thread in the middle of a Vulkan call.
+///
+/// The label of a message, like its severity, is not copied, and has to outlive the queue.
+/// The queue drains every message pushed before it is destroyed, and reports how many it
+/// dropped. A message still in the queue when the process crashes is lost.
+class DebugLogQueue final {
+    public:
+        static constexpr size_t CAPACITY = 1024;
+
+        explicit DebugLogQueue() = delete;
+        explicit DebugLogQueue(std::ostream& stream);
+
+        /// @brief Write out every message pushed so far, then stop the thread.
+        ~DebugLogQueue();
+
+        DebugLogQueue(const DebugLogQueue& other) = delete;
+        DebugLogQueue& operator=(const DebugLogQueue& other) = delete;
+
+        /// @brief Queue a message, written out as `[label] message`.
+        ///
+        /// @note Returns false, and drops the message, when the queue is full.
+        bool push(std::string_view label, std::string_view message);
+
+        /// @brief The messages dropped so far because the queue was full.
+        uint64_t getDroppedCount() const;
+    private:
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "the capacity has to be a power of two");
+
+        /// @brief A slot of the ring. A slot at position `p` is free to push into when its
+        /// sequence is `p`, and holds a message to drain when its sequence is `p + 1`.
+        struct Slot final {
+            std::atomic<size_t> sequence;
+            std::string_view label;
+            std::string message;
+        };
+
+        std::ostream& m_stream;
+        std::array<Slot, CAPACITY> m_slots;
+        std::atomic<size_t> m_pushPosition;
+        size_t m_drainPosition;
+        /// @brief Bumped after every push, and on stopping, for the thread to wait on.
+        std::atomic<uint32_t> m_signal;
+        std::atomic<bool> m_isStopping;
+        std::atomic<uint64_t> m_droppedCount;
+        std::thread m_thread;
+
+        /// @brief Write out every message pushed so far.
+        void drain();
+
+        void run();
+};
+
+}
+
+#endif // _DEBUG_LOG_QUEUE_H
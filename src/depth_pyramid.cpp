@@ -0,0 +1,517 @@
+#include "depth_pyramid.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <stdexcept>
+#include <utility>
+
+#include "command_counters.h"
+
+
+using DepthPyramid = VulkanEngine::DepthPyramid;
+using DepthReduction = VulkanEngine::DepthReduction;
+using Downsampler = VulkanEngine::Downsampler;
+using DownsampleReduction = VulkanEngine::DownsampleReduction;
+using DownsampleSourceFilter = VulkanEngine::DownsampleSourceFilter;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+DepthPyramid::DepthPyramid(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    VkPipelineCache pipelineCache,
+    std::span<const uint32_t> shaderCode,
+    std::span<const uint32_t> downsampleShaderCode,
+    VkImageView depthImageView,
+    VkExtent2D depthExtent,
+    VkSampleCountFlagBits depthSamples,
+    DepthReduction reduction
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_depthExtent { depthExtent }
+    , m_depthSamples { depthSamples }
+    , m_reduction { reduction }
+    , m_extent { VkExtent2D { std::bit_floor(depthExtent.width), std::bit_floor(depthExtent.height) } }
+    , m_mipLevels { static_cast<uint32_t>(std::bit_width(std::max(m_extent.width, m_extent.height))) }
+    , m_descriptorSetLayout { VK_NULL_HANDLE }
+    , m_pipelineLayout { VK_NULL_HANDLE }
+    , m_pipeline { VK_NULL_HANDLE }
+    , m_image { VK_NULL_HANDLE }
+    , m_allocation {}
+    , m_imageView { VK_NULL_HANDLE }
+    , m_mipViews {}
+    , m_descriptorPool { VK_NULL_HANDLE }
+    , m_descriptorSets {}
+    , m_downsampler {}
+{
+    if (depthExtent.width == 0 || depthExtent.height == 0) {
+        throw std::invalid_argument("depth pyramid needs a depth buffer that is not empty");
+    }
+
+    this->createDescriptorSetLayout();
+    this->createPipeline(pipelineCache, shaderCode);
+    this->createImage();
+    this->createImageViews();
+    this->createDescriptorSets(depthImageView);
+    if (m_mipLevels > 1) {
+        // Past the levels the downsampler binds, the levels are reduced one at a time anyway.
+        const auto downsampleMipLevels = std::min(m_mipLevels, Downsampler::MAX_MIP_LEVELS);
+        m_downsampler = std::make_unique<Downsampler>(
+            m_device,
+            m_allocator,
+            pipelineCache,
+            downsampleShaderCode,
+            VK_FORMAT_R32_SFLOAT,
+            m_extent,
+            std::span<const VkImageView> { m_mipViews }.first(downsampleMipLevels),
+            reduction == DepthReduction::Max ? DownsampleReduction::Max : DownsampleReduction::Min,
+            VK_NULL_HANDLE,
+            DownsampleSourceFilter::None
+        );
+    }
+}
+
+DepthPyramid::~DepthPyramid() {
+    m_downsampler.reset();
+    vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+
+    for (const auto mipView : m_mipViews) {
+        vkDestroyImageView(m_device, mipView, nullptr);
+    }
+    vkDestroyImageView(m_device, m_imageView, nullptr);
+    vkDestroyImage(m_device, m_image, nullptr);
+    m_allocator.free(m_allocation);
+
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+
+    m_descriptorPool = VK_NULL_HANDLE;
+    m_descriptorSets.clear();
+    m_mipViews.clear();
+    m_imageView = VK_NULL_HANDLE;
+    m_image = VK_NULL_HANDLE;
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipelineLayout = VK_NULL_HANDLE;
+    m_descriptorSetLayout = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void DepthPyramid::recordInitialization(VkCommandBuffer commandBuffer, float depth) const {
+    const auto subresourceRange = VkImageSubresourceRange {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = 0,
+        .levelCount = m_mipLevels,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+
+    const auto clearBarrier = VkImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_image,
+        .subresourceRange = subresourceRange,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &clearBarrier
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    const auto clearColor = VkClearColorValue { .float32 = { depth, depth, depth, depth } };
+    vkCmdClearColorImage(commandBuffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &subresourceRange);
+
+    const auto readBarrier = VkImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_image,
+        .subresourceRange = subresourceRange,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &readBarrier
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    if (m_downsampler != nullptr) {
+        m_downsampler->recordInitialization(commandBuffer);
+    }
+}
+
+void DepthPyramid::record(VkCommandBuffer commandBuffer) const {
+    const auto recordLevelBarrier = [commandBuffer]() {
+        const auto levelBarrier = VkMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        };
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &levelBarrier,
+            0, nullptr,
+            0, nullptr
+        );
+        CommandCounters::add(CommandCounter::Barriers);
+    };
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    CommandCounters::add(CommandCounter::PipelineBinds);
+    this->recordLevel(commandBuffer, 0);
+    if (m_mipLevels == 1) {
+        return;
+    }
+
+    // The barrier orders the counter reset of the build before this one too, since it
+    // covers every compute write recorded before it.
+    recordLevelBarrier();
+    m_downsampler->record(commandBuffer);
+
+    const auto singlePassMipLevels = m_downsampler->getSinglePassMipLevels();
+    if (singlePassMipLevels == m_mipLevels) {
+        return;
+    }
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    CommandCounters::add(CommandCounter::PipelineBinds);
+    for (uint32_t level = singlePassMipLevels; level < m_mipLevels; level++) {
+        recordLevelBarrier();
+        this->recordLevel(commandBuffer, level);
+    }
+}
+
+VkImage DepthPyramid::getImage() const {
+    return m_image;
+}
+
+VkImageView DepthPyramid::getImageView() const {
+    return m_imageView;
+}
+
+VkExtent2D DepthPyramid::getExtent() const {
+    return m_extent;
+}
+
+uint32_t DepthPyramid::getMipLevels() const {
+    return m_mipLevels;
+}
+
+VkExtent2D DepthPyramid::getMipExtent(uint32_t level) const {
+    return VkExtent2D {
+        std::max(m_extent.width >> level, 1u),
+        std::max(m_extent.height >> level, 1u),
+    };
+}
+
+void DepthPyramid::createDescriptorSetLayout() {
+    const auto bindings = std::array<VkDescriptorSetLayoutBinding, 3> {
+        VkDescriptorSetLayoutBinding {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 2,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+    };
+    // Every level reads either a single sampled or a multisampled source, and the shader
+    // never touches the binding of the other.
+    const auto bindingFlags = std::array<VkDescriptorBindingFlags, 3> {
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+        0,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+    };
+    const auto bindingFlagsInfo = VkDescriptorSetLayoutBindingFlagsCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+        .pBindingFlags = bindingFlags.data(),
+    };
+    const auto layoutInfo = VkDescriptorSetLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &bindingFlagsInfo,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+
+    auto descriptorSetLayout = VkDescriptorSetLayout {};
+    const auto result = vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &descriptorSetLayout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid descriptor set layout!");
+    }
+
+    m_descriptorSetLayout = descriptorSetLayout;
+}
+
+void DepthPyramid::createPipeline(VkPipelineCache pipelineCache, std::span<const uint32_t> shaderCode) {
+    const auto pushConstantRange = VkPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_descriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+
+    auto pipelineLayout = VkPipelineLayout {};
+    const auto resultCreatePipelineLayout = vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    if (resultCreatePipelineLayout != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid pipeline layout!");
+    }
+
+    // The destructor takes care of the layout if the pipeline fails.
+    m_pipelineLayout = pipelineLayout;
+
+    const auto shaderModuleInfo = VkShaderModuleCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = shaderCode.size_bytes(),
+        .pCode = shaderCode.data(),
+    };
+
+    auto shaderModule = VkShaderModule {};
+    const auto resultCreateShaderModule = vkCreateShaderModule(m_device, &shaderModuleInfo, nullptr, &shaderModule);
+    if (resultCreateShaderModule != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid shader module!");
+    }
+
+    const auto pipelineInfo = VkComputePipelineCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shaderModule,
+            .pName = "main",
+        },
+        .layout = m_pipelineLayout,
+    };
+
+    auto pipeline = VkPipeline {};
+    const auto resultCreatePipeline = vkCreateComputePipelines(m_device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    // The pipeline keeps everything it needs from the shader module.
+    vkDestroyShaderModule(m_device, shaderModule, nullptr);
+
+    if (resultCreatePipeline != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid pipeline!");
+    }
+
+    m_pipeline = pipeline;
+}
+
+void DepthPyramid::createImage() {
+    const auto imageInfo = VkImageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .extent = VkExtent3D { m_extent.width, m_extent.height, 1 },
+        .mipLevels = m_mipLevels,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    auto image = VkImage {};
+    const auto resultCreateImage = vkCreateImage(m_device, &imageInfo, nullptr, &image);
+    if (resultCreateImage != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid image!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetImageMemoryRequirements(m_device, image, &memRequirements);
+
+    const auto allocation = m_allocator.allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Optimal, GpuMemoryCategory::Attachment);
+
+    vkBindImageMemory(m_device, image, allocation.memory, allocation.offset);
+
+    m_image = image;
+    m_allocation = allocation;
+}
+
+void DepthPyramid::createImageViews() {
+    const auto createView = [this](uint32_t baseMipLevel, uint32_t levelCount) -> VkImageView {
+        const auto viewInfo = VkImageViewCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = m_image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = VK_FORMAT_R32_SFLOAT,
+            .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .subresourceRange.baseMipLevel = baseMipLevel,
+            .subresourceRange.levelCount = levelCount,
+            .subresourceRange.baseArrayLayer = 0,
+            .subresourceRange.layerCount = 1,
+        };
+
+        auto imageView = VkImageView {};
+        const auto result = vkCreateImageView(m_device, &viewInfo, nullptr, &imageView);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create depth pyramid image view!");
+        }
+
+        return imageView;
+    };
+
+    m_imageView = createView(0, m_mipLevels);
+    m_mipViews.reserve(m_mipLevels);
+    for (uint32_t level = 0; level < m_mipLevels; level++) {
+        m_mipViews.push_back(createView(level, 1));
+    }
+}
+
+void DepthPyramid::createDescriptorSets(VkImageView depthImageView) {
+    const auto poolSizes = std::array<VkDescriptorPoolSize, 2> {
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 2 * m_mipLevels,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = m_mipLevels,
+        },
+    };
+    const auto poolInfo = VkDescriptorPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = 0,
+        .maxSets = m_mipLevels,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+    };
+
+    auto descriptorPool = VkDescriptorPool {};
+    const auto resultCreateDescriptorPool = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &descriptorPool);
+    if (resultCreateDescriptorPool != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid descriptor pool!");
+    }
+
+    m_descriptorPool = descriptorPool;
+
+    const auto setLayouts = std::vector<VkDescriptorSetLayout>(m_mipLevels, m_descriptorSetLayout);
+    const auto allocInfo = VkDescriptorSetAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_descriptorPool,
+        .descriptorSetCount = m_mipLevels,
+        .pSetLayouts = setLayouts.data(),
+    };
+
+    auto descriptorSets = std::vector<VkDescriptorSet>(m_mipLevels);
+    const auto resultAllocateDescriptorSets = vkAllocateDescriptorSets(m_device, &allocInfo, descriptorSets.data());
+    if (resultAllocateDescriptorSets != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate depth pyramid descriptor sets!");
+    }
+
+    // The first level reads the depth buffer, and every level after it the level before.
+    auto sourceInfos = std::vector<VkDescriptorImageInfo> {};
+    auto destinationInfos = std::vector<VkDescriptorImageInfo> {};
+    sourceInfos.reserve(m_mipLevels);
+    destinationInfos.reserve(m_mipLevels);
+    for (uint32_t level = 0; level < m_mipLevels; level++) {
+        sourceInfos.push_back(VkDescriptorImageInfo {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = level == 0 ? depthImageView : m_mipViews[level - 1],
+            .imageLayout = level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL,
+        });
+        destinationInfos.push_back(VkDescriptorImageInfo {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = m_mipViews[level],
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        });
+    }
+
+    auto descriptorWrites = std::vector<VkWriteDescriptorSet> {};
+    descriptorWrites.reserve(2 * m_mipLevels);
+    for (uint32_t level = 0; level < m_mipLevels; level++) {
+        const auto isMultisampledSource = level == 0 && m_depthSamples != VK_SAMPLE_COUNT_1_BIT;
+        descriptorWrites.push_back(VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSets[level],
+            .dstBinding = isMultisampledSource ? 2u : 0u,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .pImageInfo = &sourceInfos[level],
+        });
+        descriptorWrites.push_back(VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSets[level],
+            .dstBinding = 1,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .pImageInfo = &destinationInfos[level],
+        });
+    }
+    vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+    m_descriptorSets = std::move(descriptorSets);
+}
+
+void DepthPyramid::recordLevel(VkCommandBuffer commandBuffer, uint32_t level) const {
+    vkCmdBindDescriptorSets(
+        commandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        m_pipelineLayout,
+        0,
+        1,
+        &m_descriptorSets[level],
+        0,
+        nullptr
+    );
+    CommandCounters::add(CommandCounter::DescriptorBinds);
+
+    const auto isDepthSource = level == 0;
+    const auto sourceExtent = isDepthSource ? m_depthExtent : this->getMipExtent(level - 1);
+    const auto destinationExtent = this->getMipExtent(level);
+    const auto pushConstants = PushConstants {
+        .sourceWidth = sourceExtent.width,
+        .sourceHeight = sourceExtent.height,
+        .destinationWidth = destinationExtent.width,
+        .destinationHeight = destinationExtent.height,
+        .reduction = static_cast<uint32_t>(m_reduction),
+        .sourceSampleCount = isDepthSource && m_depthSamples != VK_SAMPLE_COUNT_1_BIT ? static_cast<uint32_t>(m_depthSamples) : 0,
+    };
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+
+    const auto workGroupCountX = (destinationExtent.width + THREAD_COUNT - 1) / THREAD_COUNT;
+    const auto workGroupCountY = (destinationExtent.height + THREAD_COUNT - 1) / THREAD_COUNT;
+    vkCmdDispatch(commandBuffer, workGroupCountX, workGroupCountY, 1);
+    CommandCounters::add(CommandCounter::Dispatches);
+}
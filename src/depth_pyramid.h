@@ -0,0 +1,133 @@
+#ifndef _DEPTH_PYRAMID_H
+#define _DEPTH_PYRAMID_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "downsampler.h"
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief How a texel of a `DepthPyramid` combines the depths under it.
+enum class DepthReduction : uint32_t {
+    /// @brief Keep the nearest depth, for tests that need everything in front of a region.
+    Min = 0,
+    /// @brief Keep the farthest depth, for occlusion tests against a region.
+    Max = 1
+};
+
+/// @brief Reduces a depth buffer into a hierarchical depth pyramid with a compute shader,
+/// with every level holding the minimum or maximum of the depths under each of its texels.
+///
+/// @note The pyramid is an `R32_SFLOAT` image whose first level is the largest power of two
+/// that fits inside the depth buffer, so that every level after it halves the one before.
+/// Each texel of the first level reduces over every depth texel its footprint touches,
+/// which keeps the reduction conservative for depth buffers of any size, and over every
+/// sample of a multisampled depth buffer. The pyramid lives in `VK_IMAGE_LAYOUT_GENERAL`.
+///
+/// Every level after the first is reduced from it in one dispatch of the shared
+/// `Downsampler`, instead of a dispatch and a barrier per level. With a first level past
+/// `Downsampler::MAX_SINGLE_PASS_EXTENT` a side, only the levels the workgroups reduce out
+/// of shared memory come from that dispatch, and the rest are reduced a level at a time as
+/// before.
+class DepthPyramid final {
+    public:
+        /// @brief The width and height of the workgroups of the reduction shader.
+        static constexpr uint32_t THREAD_COUNT = 8;
+
+        explicit DepthPyramid() = delete;
+        explicit DepthPyramid(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            VkPipelineCache pipelineCache,
+            std::span<const uint32_t> shaderCode,
+            std::span<const uint32_t> downsampleShaderCode,
+            VkImageView depthImageView,
+            VkExtent2D depthExtent,
+            VkSampleCountFlagBits depthSamples,
+            DepthReduction reduction
+        );
+
+        ~DepthPyramid();
+
+        DepthPyramid(const DepthPyramid& other) = delete;
+        DepthPyramid& operator=(const DepthPyramid& other) = delete;
+
+        /// @brief Record filling every level with `depth`, and moving the pyramid into its
+        /// layout, for the frames that read it before it is first built.
+        void recordInitialization(VkCommandBuffer commandBuffer, float depth) const;
+
+        /// @brief Record building the pyramid from the depth buffer.
+        ///
+        /// @note Must be recorded outside of a render pass, with the depth buffer in
+        /// `VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL`. The barriers between the levels
+        /// are recorded here, and the ones that order the depth writes before it and the
+        /// pyramid reads around it are left to the caller. Compute shaders sample the depth
+        /// buffer, read the pyramid, and write it.
+        void record(VkCommandBuffer commandBuffer) const;
+
+        VkImage getImage() const;
+
+        /// @brief The view of every level of the pyramid, for sampling it.
+        VkImageView getImageView() const;
+
+        VkExtent2D getExtent() const;
+
+        uint32_t getMipLevels() const;
+    private:
+        struct PushConstants final {
+            uint32_t sourceWidth;
+            uint32_t sourceHeight;
+            uint32_t destinationWidth;
+            uint32_t destinationHeight;
+            uint32_t reduction;
+            /// @brief The samples of a multisampled source, or zero for a single sampled one.
+            uint32_t sourceSampleCount;
+        };
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkExtent2D m_depthExtent;
+        VkSampleCountFlagBits m_depthSamples;
+        DepthReduction m_reduction;
+        VkExtent2D m_extent;
+        uint32_t m_mipLevels;
+        VkDescriptorSetLayout m_descriptorSetLayout;
+        VkPipelineLayout m_pipelineLayout;
+        VkPipeline m_pipeline;
+        VkImage m_image;
+        GpuAllocation m_allocation;
+        VkImageView m_imageView;
+        std::vector<VkImageView> m_mipViews;
+        VkDescriptorPool m_descriptorPool;
+        /// @brief One set for each level, reading the level before it, or the depth buffer
+        /// through the binding for its sample count.
+        std::vector<VkDescriptorSet> m_descriptorSets;
+        /// @brief Reduces the first level into the levels after it, for pyramids with more
+        /// than one level.
+        std::unique_ptr<Downsampler> m_downsampler;
+
+        void createDescriptorSetLayout();
+
+        void createPipeline(VkPipelineCache pipelineCache, std::span<const uint32_t> shaderCode);
+
+        void createImage();
+
+        void createImageViews();
+
+        void createDescriptorSets(VkImageView depthImageView);
+
+        void recordLevel(VkCommandBuffer commandBuffer, uint32_t level) const;
+
+        VkExtent2D getMipExtent(uint32_t level) const;
+};
+
+}
+
+#endif // _DEPTH_PYRAMID_H
@@ -0,0 +1,224 @@
+#include "descriptor_allocator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "cache_source_key.h"
+
+
+using DescriptorAllocator = VulkanEngine::DescriptorAllocator;
+using DescriptorWrite = VulkanEngine::DescriptorWrite;
+using CacheSourceKey = VulkanEngine::CacheSourceKey;
+
+template <typename T>
+static uint64_t hashValue(const T& value, uint64_t hash) {
+    return CacheSourceKey::hashBytes(reinterpret_cast<const uint8_t*>(&value), sizeof(value), hash);
+}
+
+DescriptorAllocator::DescriptorAllocator(
+    VkDevice device,
+    const std::vector<DescriptorPoolRatio>& ratios,
+    uint32_t initialSetsPerPool,
+    VkDescriptorPoolCreateFlags poolFlags
+)
+    : m_device { device }
+    , m_ratios { ratios }
+    , m_poolFlags { poolFlags }
+    , m_setsPerPool { std::clamp<uint32_t>(initialSetsPerPool, 1, MAX_SETS_PER_POOL) }
+    , m_readyPools { std::vector<VkDescriptorPool> {} }
+    , m_fullPools { std::vector<VkDescriptorPool> {} }
+    , m_cachedSets { std::unordered_map<uint64_t, std::vector<CachedSet>> {} }
+{
+    m_readyPools.push_back(this->createPool());
+}
+
+DescriptorAllocator::~DescriptorAllocator() {
+    for (const auto pool : m_readyPools) {
+        vkDestroyDescriptorPool(m_device, pool, nullptr);
+    }
+
+    for (const auto pool : m_fullPools) {
+        vkDestroyDescriptorPool(m_device, pool, nullptr);
+    }
+
+    m_readyPools.clear();
+    m_fullPools.clear();
+    m_device = VK_NULL_HANDLE;
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout, uint32_t variableDescriptorCount) {
+    const auto variableCountInfo = VkDescriptorSetVariableDescriptorCountAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO,
+        .descriptorSetCount = 1,
+        .pDescriptorCounts = &variableDescriptorCount,
+    };
+
+    // A pool that runs out is never tried again until the allocator is reset, and a set
+    // that does not fit even in a fresh pool never will.
+    auto isFreshPool = false;
+    while (true) {
+        const auto pool = this->getReadyPool();
+        const auto allocInfo = VkDescriptorSetAllocateInfo {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .pNext = variableDescriptorCount > 0 ? &variableCountInfo : nullptr,
+            .descriptorPool = pool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &layout,
+        };
+
+        auto descriptorSet = VkDescriptorSet {};
+        const auto result = vkAllocateDescriptorSets(m_device, &allocInfo, &descriptorSet);
+        if (result == VK_SUCCESS) {
+            return descriptorSet;
+        } else if ((result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) || isFreshPool) {
+            throw std::runtime_error("failed to allocate descriptor set!");
+        }
+
+        m_readyPools.pop_back();
+        m_fullPools.push_back(pool);
+        isFreshPool = m_readyPools.empty();
+    }
+}
+
+VkDescriptorSet DescriptorAllocator::getDescriptorSet(
+    VkDescriptorSetLayout layout,
+    const std::vector<DescriptorWrite>& writes,
+    uint32_t variableDescriptorCount
+) {
+    const auto hash = DescriptorAllocator::hashDescriptorSet(layout, writes, variableDescriptorCount);
+    auto& cachedSets = m_cachedSets[hash];
+    for (const auto& cachedSet : cachedSets) {
+        if (DescriptorAllocator::isSameDescriptorSet(cachedSet, layout, writes, variableDescriptorCount)) {
+            return cachedSet.descriptorSet;
+        }
+    }
+
+    const auto descriptorSet = this->allocate(layout, variableDescriptorCount);
+    auto descriptorWrites = std::vector<VkWriteDescriptorSet> {};
+    descriptorWrites.reserve(writes.size());
+    for (const auto& write : writes) {
+        const auto isImageWrite = !write.imageInfos.empty();
+        descriptorWrites.push_back(VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = write.binding,
+            .dstArrayElement = 0,
+            .descriptorCount = static_cast<uint32_t>(isImageWrite ? write.imageInfos.size() : write.bufferInfos.size()),
+            .descriptorType = write.type,
+            .pImageInfo = isImageWrite ? write.imageInfos.data() : nullptr,
+            .pBufferInfo = isImageWrite ? nullptr : write.bufferInfos.data(),
+        });
+    }
+    vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+    cachedSets.push_back(CachedSet {
+        .layout = layout,
+        .writes = writes,
+        .variableDescriptorCount = variableDescriptorCount,
+        .descriptorSet = descriptorSet,
+    });
+
+    return descriptorSet;
+}
+
+void DescriptorAllocator::reset() {
+    for (const auto pool : m_fullPools) {
+        m_readyPools.push_back(pool);
+    }
+    m_fullPools.clear();
+
+    for (const auto pool : m_readyPools) {
+        vkResetDescriptorPool(m_device, pool, /* VkDescriptorPoolResetFlags */ 0);
+    }
+
+    m_cachedSets.clear();
+}
+
+VkDescriptorPool DescriptorAllocator::createPool() {
+    auto poolSizes = std::vector<VkDescriptorPoolSize> {};
+    poolSizes.reserve(m_ratios.size());
+    for (const auto& ratio : m_ratios) {
+        poolSizes.push_back(VkDescriptorPoolSize {
+            .type = ratio.type,
+            .descriptorCount = std::max(static_cast<uint32_t>(std::ceil(ratio.descriptorsPerSet * m_setsPerPool)), 1u),
+        });
+    }
+
+    const auto poolInfo = VkDescriptorPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = m_poolFlags,
+        .maxSets = m_setsPerPool,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+    };
+
+    auto pool = VkDescriptorPool {};
+    const auto result = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &pool);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    m_setsPerPool = std::min(m_setsPerPool * 2, MAX_SETS_PER_POOL);
+
+    return pool;
+}
+
+VkDescriptorPool DescriptorAllocator::getReadyPool() {
+    if (m_readyPools.empty()) {
+        m_readyPools.push_back(this->createPool());
+    }
+
+    return m_readyPools.back();
+}
+
+uint64_t DescriptorAllocator::hashDescriptorSet(
+    VkDescriptorSetLayout layout,
+    const std::vector<DescriptorWrite>& writes,
+    uint32_t variableDescriptorCount
+) {
+    // The infos are hashed field by field, since some of them have padding.
+    auto hash = hashValue(layout, CacheSourceKey::FNV_OFFSET_BASIS);
+    hash = hashValue(variableDescriptorCount, hash);
+    for (const auto& write : writes) {
+        hash = hashValue(write.binding, hash);
+        hash = hashValue(write.type, hash);
+        for (const auto& bufferInfo : write.bufferInfos) {
+            hash = hashValue(bufferInfo.buffer, hash);
+            hash = hashValue(bufferInfo.offset, hash);
+            hash = hashValue(bufferInfo.range, hash);
+        }
+
+        for (const auto& imageInfo : write.imageInfos) {
+            hash = hashValue(imageInfo.sampler, hash);
+            hash = hashValue(imageInfo.imageView, hash);
+            hash = hashValue(imageInfo.imageLayout, hash);
+        }
+    }
+
+    return hash;
+}
+
+bool DescriptorAllocator::isSameDescriptorSet(
+    const CachedSet& cachedSet,
+    VkDescriptorSetLayout layout,
+    const std::vector<DescriptorWrite>& writes,
+    uint32_t variableDescriptorCount
+) {
+    const auto isSameBufferInfo = [](const VkDescriptorBufferInfo& lhs, const VkDescriptorBufferInfo& rhs) {
+        return lhs.buffer == rhs.buffer && lhs.offset == rhs.offset && lhs.range == rhs.range;
+    };
+    const auto isSameImageInfo = [](const VkDescriptorImageInfo& lhs, const VkDescriptorImageInfo& rhs) {
+        return lhs.sampler == rhs.sampler && lhs.imageView == rhs.imageView && lhs.imageLayout == rhs.imageLayout;
+    };
+    const auto isSameWrite = [&isSameBufferInfo, &isSameImageInfo](const DescriptorWrite& lhs, const DescriptorWrite& rhs) {
+        return lhs.binding == rhs.binding
+            && lhs.type == rhs.type
+            && std::ranges::equal(lhs.bufferInfos, rhs.bufferInfos, isSameBufferInfo)
+            && std::ranges::equal(lhs.imageInfos, rhs.imageInfos, isSameImageInfo);
+    };
+
+    return cachedSet.layout == layout
+        && cachedSet.variableDescriptorCount == variableDescriptorCount
+        && std::ranges::equal(cachedSet.writes, writes, isSameWrite);
+}
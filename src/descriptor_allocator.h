@@ -0,0 +1,116 @@
+#ifndef _DESCRIPTOR_ALLOCATOR_H
+#define _DESCRIPTOR_ALLOCATOR_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief How many descriptors of a type a pool of a `DescriptorAllocator` holds for every
+/// set it holds.
+struct DescriptorPoolRatio final {
+    VkDescriptorType type;
+    float descriptorsPerSet;
+};
+
+/// @brief The descriptors written to one binding of a set, starting at its first array
+/// element. Only the infos that match the descriptor type are used.
+struct DescriptorWrite final {
+    uint32_t binding;
+    VkDescriptorType type;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    std::vector<VkDescriptorImageInfo> imageInfos;
+};
+
+/// @brief Allocates descriptor sets out of a chain of descriptor pools that grows whenever
+/// the pools run out, and caches the sets whose descriptors never change.
+///
+/// @note Every new pool holds twice the sets of the last one, up to `MAX_SETS_PER_POOL`,
+/// sized by the ratios the allocator was made with. Sets are never freed one by one.
+/// `reset` returns every set of every pool at once with `vkResetDescriptorPool`, and keeps
+/// the pools for the sets allocated after it. A cached set is looked up by its layout and
+/// a hash of its writes, so it must not be written again once it is handed out.
+///
+/// @note There are no pools of its own for each frame in flight, reset at the start of
+/// the frame. No set is allocated per frame: every frame in flight keeps one uniform buffer
+/// set and one texture table for the whole run, and the descriptors that change, the
+/// streamed texture and the stress materials, are written into the frame's table in place
+/// once its slot has been waited on (`UPDATE_AFTER_BIND` allows it even while bound).
+/// Allocating and writing the sets again every frame would only add work, so the pools are
+/// reset only when the frame resources are recreated.
+class DescriptorAllocator final {
+    public:
+        static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+        explicit DescriptorAllocator() = delete;
+        explicit DescriptorAllocator(
+            VkDevice device,
+            const std::vector<DescriptorPoolRatio>& ratios,
+            uint32_t initialSetsPerPool,
+            VkDescriptorPoolCreateFlags poolFlags
+        );
+
+        ~DescriptorAllocator();
+
+        DescriptorAllocator(const DescriptorAllocator& other) = delete;
+        DescriptorAllocator& operator=(const DescriptorAllocator& other) = delete;
+
+        /// @brief Allocate a set of `layout`, with `variableDescriptorCount` descriptors in
+        /// its variable-sized binding, if it has one.
+        VkDescriptorSet allocate(VkDescriptorSetLayout layout, uint32_t variableDescriptorCount = 0);
+
+        /// @brief The set of `layout` with `writes` written to it, allocated and written the
+        /// first time it is asked for.
+        VkDescriptorSet getDescriptorSet(
+            VkDescriptorSetLayout layout,
+            const std::vector<DescriptorWrite>& writes,
+            uint32_t variableDescriptorCount = 0
+        );
+
+        /// @brief Return every set allocated so far to the pools, and forget the cached
+        /// sets.
+        ///
+        /// @note None of the sets may still be in use by the GPU.
+        void reset();
+    private:
+        struct CachedSet final {
+            VkDescriptorSetLayout layout;
+            std::vector<DescriptorWrite> writes;
+            uint32_t variableDescriptorCount;
+            VkDescriptorSet descriptorSet;
+        };
+
+        VkDevice m_device;
+        std::vector<DescriptorPoolRatio> m_ratios;
+        VkDescriptorPoolCreateFlags m_poolFlags;
+        uint32_t m_setsPerPool;
+        /// @brief The pools that may have room left, the one allocated from last at the back.
+        std::vector<VkDescriptorPool> m_readyPools;
+        std::vector<VkDescriptorPool> m_fullPools;
+        std::unordered_map<uint64_t, std::vector<CachedSet>> m_cachedSets;
+
+        VkDescriptorPool createPool();
+
+        VkDescriptorPool getReadyPool();
+
+        static uint64_t hashDescriptorSet(
+            VkDescriptorSetLayout layout,
+            const std::vector<DescriptorWrite>& writes,
+            uint32_t variableDescriptorCount
+        );
+
+        static bool isSameDescriptorSet(
+            const CachedSet& cachedSet,
+            VkDescriptorSetLayout layout,
+            const std::vector<DescriptorWrite>& writes,
+            uint32_t variableDescriptorCount
+        );
+};
+
+}
+
+#endif // _DESCRIPTOR_ALLOCATOR_H
@@ -0,0 +1,255 @@
+#include "descriptor_buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <memory_resource>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "command_counters.h"
+
+
+using DescriptorBuffer = VulkanEngine::DescriptorBuffer;
+using DescriptorBufferSet = VulkanEngine::DescriptorBufferSet;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+DescriptorBuffer::DescriptorBuffer(
+    VkPhysicalDevice physicalDevice,
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    VkDeviceSize capacity
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_buffer { VK_NULL_HANDLE }
+    , m_allocation {}
+    , m_deviceAddress { 0 }
+    , m_capacity { capacity }
+    , m_head { 0 }
+    , m_properties {}
+    , m_vkGetDescriptorSetLayoutSizeEXT { nullptr }
+    , m_vkGetDescriptorSetLayoutBindingOffsetEXT { nullptr }
+    , m_vkGetDescriptorEXT { nullptr }
+    , m_vkCmdBindDescriptorBuffersEXT { nullptr }
+    , m_vkCmdSetDescriptorBufferOffsetsEXT { nullptr }
+{
+    // The loader does not export extension commands, so they come from the device.
+    m_vkGetDescriptorSetLayoutSizeEXT = reinterpret_cast<PFN_vkGetDescriptorSetLayoutSizeEXT>(
+        vkGetDeviceProcAddr(m_device, "vkGetDescriptorSetLayoutSizeEXT")
+    );
+    m_vkGetDescriptorSetLayoutBindingOffsetEXT = reinterpret_cast<PFN_vkGetDescriptorSetLayoutBindingOffsetEXT>(
+        vkGetDeviceProcAddr(m_device, "vkGetDescriptorSetLayoutBindingOffsetEXT")
+    );
+    m_vkGetDescriptorEXT = reinterpret_cast<PFN_vkGetDescriptorEXT>(
+        vkGetDeviceProcAddr(m_device, "vkGetDescriptorEXT")
+    );
+    m_vkCmdBindDescriptorBuffersEXT = reinterpret_cast<PFN_vkCmdBindDescriptorBuffersEXT>(
+        vkGetDeviceProcAddr(m_device, "vkCmdBindDescriptorBuffersEXT")
+    );
+    m_vkCmdSetDescriptorBufferOffsetsEXT = reinterpret_cast<PFN_vkCmdSetDescriptorBufferOffsetsEXT>(
+        vkGetDeviceProcAddr(m_device, "vkCmdSetDescriptorBufferOffsetsEXT")
+    );
+    const auto hasCommands = m_vkGetDescriptorSetLayoutSizeEXT != nullptr
+        && m_vkGetDescriptorSetLayoutBindingOffsetEXT != nullptr
+        && m_vkGetDescriptorEXT != nullptr
+        && m_vkCmdBindDescriptorBuffersEXT != nullptr
+        && m_vkCmdSetDescriptorBufferOffsetsEXT != nullptr;
+    if (!hasCommands) {
+        throw std::runtime_error("failed to load descriptor buffer commands!");
+    }
+
+    m_properties = VkPhysicalDeviceDescriptorBufferPropertiesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT,
+        .pNext = nullptr,
+    };
+    auto properties = VkPhysicalDeviceProperties2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &m_properties,
+    };
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = m_capacity,
+        .usage = BUFFER_USAGE,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto resultCreateBuffer = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+    if (resultCreateBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor buffer!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    // The host writes descriptors whenever a set changes, and the device reads them for
+    // every draw, so they live where the uniform data does.
+    const auto allocation = m_allocator.allocate(
+        memRequirements,
+        m_allocator.selectDynamicMemoryProperties(memRequirements.memoryTypeBits),
+        GpuResourceKind::Linear,
+        GpuMemoryCategory::Other
+    );
+
+    vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+    m_buffer = buffer;
+    m_allocation = allocation;
+    m_deviceAddress = m_allocator.getBufferDeviceAddress(buffer);
+}
+
+DescriptorBuffer::~DescriptorBuffer() {
+    vkDestroyBuffer(m_device, m_buffer, nullptr);
+    m_allocator.free(m_allocation);
+
+    m_buffer = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+DescriptorBufferSet DescriptorBuffer::allocate(VkDescriptorSetLayout layout) {
+    auto layoutSize = VkDeviceSize { 0 };
+    m_vkGetDescriptorSetLayoutSizeEXT(m_device, layout, &layoutSize);
+
+    const auto alignment = std::max<VkDeviceSize>(m_properties.descriptorBufferOffsetAlignment, 1);
+    const auto alignedHead = (m_head + alignment - 1) / alignment * alignment;
+    if (alignedHead + layoutSize > m_capacity) {
+        throw std::runtime_error {
+            fmt::format("Descriptor set of {} bytes exceeds the {} bytes left in the descriptor buffer", layoutSize, m_capacity - alignedHead)
+        };
+    }
+
+    m_head = alignedHead + layoutSize;
+
+    return DescriptorBufferSet {
+        .layout = layout,
+        .offset = alignedHead,
+    };
+}
+
+void* DescriptorBuffer::getDescriptorData(const DescriptorBufferSet& set, uint32_t binding, uint32_t arrayElement, size_t descriptorSize) const {
+    auto bindingOffset = VkDeviceSize { 0 };
+    m_vkGetDescriptorSetLayoutBindingOffsetEXT(m_device, set.layout, binding, &bindingOffset);
+
+    const auto offset = set.offset + bindingOffset + static_cast<VkDeviceSize>(arrayElement) * descriptorSize;
+
+    return static_cast<char*>(m_allocation.mappedData) + offset;
+}
+
+void DescriptorBuffer::write(const DescriptorBufferSet& set, const std::vector<DescriptorWrite>& writes) {
+    for (const auto& write : writes) {
+        if (write.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) {
+            for (uint32_t i = 0; i < write.imageInfos.size(); i++) {
+                this->writeCombinedImageSampler(set, write.binding, i, write.imageInfos[i]);
+            }
+        } else if (write.bufferInfos.size() == 1) {
+            this->writeBuffer(set, write.binding, write.type, write.bufferInfos[0]);
+        } else {
+            throw std::invalid_argument("only single buffers are written to descriptor buffers!");
+        }
+    }
+}
+
+void DescriptorBuffer::writeBuffer(
+    const DescriptorBufferSet& set,
+    uint32_t binding,
+    VkDescriptorType type,
+    const VkDescriptorBufferInfo& bufferInfo
+) {
+    if (bufferInfo.range == VK_WHOLE_SIZE) {
+        throw std::invalid_argument("buffer descriptors are written by address and need a range!");
+    }
+
+    const auto addressInfo = VkDescriptorAddressInfoEXT {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT,
+        .pNext = nullptr,
+        .address = m_allocator.getBufferDeviceAddress(bufferInfo.buffer) + bufferInfo.offset,
+        .range = bufferInfo.range,
+        .format = VK_FORMAT_UNDEFINED,
+    };
+    const auto [data, descriptorSize] = [this, type, &addressInfo]() -> std::tuple<VkDescriptorDataEXT, size_t> {
+        if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+            return { VkDescriptorDataEXT { .pUniformBuffer = &addressInfo }, m_properties.uniformBufferDescriptorSize };
+        } else if (type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+            return { VkDescriptorDataEXT { .pStorageBuffer = &addressInfo }, m_properties.storageBufferDescriptorSize };
+        } else {
+            throw std::invalid_argument("only uniform and storage buffers are written as buffers!");
+        }
+    }();
+    const auto getInfo = VkDescriptorGetInfoEXT {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+        .pNext = nullptr,
+        .type = type,
+        .data = data,
+    };
+
+    m_vkGetDescriptorEXT(m_device, &getInfo, descriptorSize, this->getDescriptorData(set, binding, 0, descriptorSize));
+}
+
+void DescriptorBuffer::writeCombinedImageSampler(
+    const DescriptorBufferSet& set,
+    uint32_t binding,
+    uint32_t arrayElement,
+    const VkDescriptorImageInfo& imageInfo
+) {
+    const auto getInfo = VkDescriptorGetInfoEXT {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+        .pNext = nullptr,
+        .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .data = VkDescriptorDataEXT { .pCombinedImageSampler = &imageInfo },
+    };
+    const auto descriptorSize = m_properties.combinedImageSamplerDescriptorSize;
+
+    m_vkGetDescriptorEXT(m_device, &getInfo, descriptorSize, this->getDescriptorData(set, binding, arrayElement, descriptorSize));
+}
+
+void DescriptorBuffer::bind(
+    VkCommandBuffer commandBuffer,
+    VkPipelineBindPoint pipelineBindPoint,
+    VkPipelineLayout pipelineLayout,
+    uint32_t firstSet,
+    std::span<const DescriptorBufferSet> sets
+) const {
+    const auto bindingInfo = VkDescriptorBufferBindingInfoEXT {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT,
+        .pNext = nullptr,
+        .address = m_deviceAddress,
+        .usage = BUFFER_USAGE,
+    };
+    m_vkCmdBindDescriptorBuffersEXT(commandBuffer, 1, &bindingInfo);
+    CommandCounters::add(CommandCounter::DescriptorBinds);
+
+    // Every set is in the one buffer that was bound. Draws bind a handful of sets from any
+    // recording thread, so the scratch lives on the stack unless there are more of them.
+    auto storage = std::array<std::byte, 256> {};
+    auto scratch = std::pmr::monotonic_buffer_resource { storage.data(), storage.size() };
+    auto bufferIndices = std::pmr::vector<uint32_t>(sets.size(), 0, &scratch);
+    auto offsets = std::pmr::vector<VkDeviceSize> { &scratch };
+    offsets.reserve(sets.size());
+    for (const auto& set : sets) {
+        offsets.push_back(set.offset);
+    }
+
+    m_vkCmdSetDescriptorBufferOffsetsEXT(
+        commandBuffer,
+        pipelineBindPoint,
+        pipelineLayout,
+        firstSet,
+        static_cast<uint32_t>(sets.size()),
+        bufferIndices.data(),
+        offsets.data()
+    );
+}
+
+void DescriptorBuffer::reset() {
+    m_head = 0;
+}
+
+VkDeviceSize DescriptorBuffer::getCapacity() const {
+    return m_capacity;
+}
@@ -0,0 +1,130 @@
+#ifndef _DESCRIPTOR_BUFFER_H
+#define _DESCRIPTOR_BUFFER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "descriptor_allocator.h"
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief Where the descriptors of one set live in a `DescriptorBuffer`, and the layout
+/// they follow.
+struct DescriptorBufferSet final {
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+};
+
+/// @brief A persistently mapped buffer of descriptors, written with `vkGetDescriptorEXT`
+/// and bound by offset with `VK_EXT_descriptor_buffer`, in place of descriptor pools and
+/// `vkUpdateDescriptorSets`.
+///
+/// @note Sets are handed out linearly, each as big as its layout and aligned to
+/// `descriptorBufferOffsetAlignment`, and are only returned all at once by `reset`.
+/// Writing a descriptor copies it straight into the mapped buffer, so a set must not be
+/// written while a submit that reads it is in flight. A set the GPU reads every frame is
+/// therefore allocated once per frame in flight, like a descriptor set that gets updated.
+///
+/// Every set layout has to be created with `VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT`,
+/// and every pipeline that uses one with `VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT`.
+/// The buffer holds resource and sampler descriptors alike, so it is bound in a single
+/// binding and the sets of any layout can be bound together. The device needs buffer
+/// device addresses.
+class DescriptorBuffer final {
+    public:
+        explicit DescriptorBuffer() = delete;
+        explicit DescriptorBuffer(
+            VkPhysicalDevice physicalDevice,
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            VkDeviceSize capacity
+        );
+
+        ~DescriptorBuffer();
+
+        DescriptorBuffer(const DescriptorBuffer& other) = delete;
+        DescriptorBuffer& operator=(const DescriptorBuffer& other) = delete;
+
+        /// @brief Hand out room for a set of `layout`.
+        ///
+        /// @note Throws when the buffer is full.
+        DescriptorBufferSet allocate(VkDescriptorSetLayout layout);
+
+        /// @brief Write `writes` to `set`, as `vkUpdateDescriptorSets` would write them to a
+        /// descriptor set.
+        ///
+        /// @note Only uniform buffers, storage buffers and combined image samplers can be
+        /// written, and every buffer has to have a device address.
+        void write(const DescriptorBufferSet& set, const std::vector<DescriptorWrite>& writes);
+
+        /// @brief Write a uniform or storage buffer descriptor to `binding` of `set`.
+        ///
+        /// @note Descriptors are written by address, so `bufferInfo` must name its range
+        /// rather than `VK_WHOLE_SIZE`.
+        void writeBuffer(
+            const DescriptorBufferSet& set,
+            uint32_t binding,
+            VkDescriptorType type,
+            const VkDescriptorBufferInfo& bufferInfo
+        );
+
+        /// @brief Write a combined image sampler to element `arrayElement` of `binding` of
+        /// `set`.
+        void writeCombinedImageSampler(
+            const DescriptorBufferSet& set,
+            uint32_t binding,
+            uint32_t arrayElement,
+            const VkDescriptorImageInfo& imageInfo
+        );
+
+        /// @brief Bind the buffer, and `sets` to the sets of `pipelineLayout` from `firstSet`
+        /// on.
+        ///
+        /// @note Binding descriptor sets afterwards unbinds the descriptor buffer, and the
+        /// other way around.
+        void bind(
+            VkCommandBuffer commandBuffer,
+            VkPipelineBindPoint pipelineBindPoint,
+            VkPipelineLayout pipelineLayout,
+            uint32_t firstSet,
+            std::span<const DescriptorBufferSet> sets
+        ) const;
+
+        /// @brief Return every set handed out so far.
+        ///
+        /// @note None of the sets may still be in use by the GPU.
+        void reset();
+
+        VkDeviceSize getCapacity() const;
+    private:
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkBuffer m_buffer;
+        GpuAllocation m_allocation;
+        VkDeviceAddress m_deviceAddress;
+        VkDeviceSize m_capacity;
+        VkDeviceSize m_head;
+        VkPhysicalDeviceDescriptorBufferPropertiesEXT m_properties;
+        PFN_vkGetDescriptorSetLayoutSizeEXT m_vkGetDescriptorSetLayoutSizeEXT;
+        PFN_vkGetDescriptorSetLayoutBindingOffsetEXT m_vkGetDescriptorSetLayoutBindingOffsetEXT;
+        PFN_vkGetDescriptorEXT m_vkGetDescriptorEXT;
+        PFN_vkCmdBindDescriptorBuffersEXT m_vkCmdBindDescriptorBuffersEXT;
+        PFN_vkCmdSetDescriptorBufferOffsetsEXT m_vkCmdSetDescriptorBufferOffsetsEXT;
+
+        static constexpr VkBufferUsageFlags BUFFER_USAGE = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT
+            | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT
+            | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
+        /// @brief The mapped bytes of the descriptor at element `arrayElement` of `binding`
+        /// of `set`, for descriptors of `descriptorSize` bytes.
+        void* getDescriptorData(const DescriptorBufferSet& set, uint32_t binding, uint32_t arrayElement, size_t descriptorSize) const;
+};
+
+}
+
+#endif // _DESCRIPTOR_BUFFER_H
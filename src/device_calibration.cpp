@@ -0,0 +1,185 @@
+#include "device_calibration.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#include "json_reader.h"
+
+
+using DeviceCalibration = VulkanEngine::DeviceCalibration;
+using CalibrationMeasurements = VulkanEngine::CalibrationMeasurements;
+using CalibrationTarget = VulkanEngine::CalibrationTarget;
+using PerformancePreset = VulkanEngine::PerformancePreset;
+using JsonValue = VulkanEngine::JsonValue;
+using JsonReader = VulkanEngine::JsonReader;
+
+// Any change to the layout of the file, or to what the micro-benchmarks measure, must bump
+// the version, so that old profiles fail to load and the device is measured again.
+static constexpr uint32_t PROFILE_FILE_VERSION = 1;
+
+// The textures the model stands for are 8-bit RGBA.
+static constexpr double TEXTURE_BYTES_PER_TEXEL = 4.0;
+
+/// @brief The milliseconds `work` takes at `rate` units of work a millisecond, which is
+/// never fast enough when nothing was measured.
+static double getMilliseconds(double work, double rate) {
+    if (rate <= 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    return work / rate;
+}
+
+static const JsonValue& getMember(const JsonValue& object, std::string_view key, JsonValue::Type type) {
+    const auto* value = object.find(key);
+    if (value == nullptr || value->type != type) {
+        throw std::runtime_error(fmt::format("failed to load calibration profile: missing or malformed \"{}\"!", key));
+    }
+
+    return *value;
+}
+
+static double getPositiveNumber(const JsonValue& object, std::string_view key) {
+    const auto number = getMember(object, key, JsonValue::Type::Number).number;
+    if (!(number > 0.0)) {
+        throw std::runtime_error(fmt::format("failed to load calibration profile: \"{}\" is not positive!", key));
+    }
+
+    return number;
+}
+
+DeviceCalibration::DeviceCalibration(const std::string& deviceUuid, uint32_t driverVersion, const CalibrationMeasurements& measurements)
+    : m_deviceUuid { deviceUuid }
+    , m_driverVersion { driverVersion }
+    , m_measurements { measurements }
+{
+}
+
+std::filesystem::path DeviceCalibration::getPath(const std::filesystem::path& directory, const std::string& deviceUuid, uint32_t driverVersion) {
+    return directory / fmt::format("{}_{}.json", deviceUuid, driverVersion);
+}
+
+DeviceCalibration DeviceCalibration::load(const std::filesystem::path& path) {
+    auto file = std::ifstream { path, std::ios::in };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open calibration profile!");
+    }
+
+    const auto text = std::string { std::istreambuf_iterator<char> { file }, std::istreambuf_iterator<char> {} };
+    auto reader = JsonReader { text };
+    const auto document = reader.parseDocument();
+    if (getMember(document, "version", JsonValue::Type::Number).number != PROFILE_FILE_VERSION) {
+        throw std::runtime_error("failed to load calibration profile: not a profile of this version!");
+    }
+
+    const auto& measurements = getMember(document, "measurements", JsonValue::Type::Object);
+
+    return DeviceCalibration {
+        getMember(document, "deviceUuid", JsonValue::Type::String).string,
+        static_cast<uint32_t>(getMember(document, "driverVersion", JsonValue::Type::Number).number),
+        CalibrationMeasurements {
+            .mipGenerationMegatexelsPerSecond = getPositiveNumber(measurements, "mipGenerationMegatexelsPerSecond"),
+            .fillGigapixelsPerSecond = getPositiveNumber(measurements, "fillGigapixelsPerSecond"),
+            .uploadMegabytesPerSecond = getPositiveNumber(measurements, "uploadMegabytesPerSecond"),
+            .pipelineCompileMilliseconds = getPositiveNumber(measurements, "pipelineCompileMilliseconds"),
+        },
+    };
+}
+
+void DeviceCalibration::save(const std::filesystem::path& path) const {
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+
+    auto file = std::ofstream { path, std::ios::out | std::ios::trunc };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open calibration profile for writing!");
+    }
+
+    // The device UUID is written in hex digits, which need no escaping.
+    file << "{\n";
+    file << fmt::format("  \"version\": {},\n", PROFILE_FILE_VERSION);
+    file << fmt::format("  \"deviceUuid\": \"{}\",\n", m_deviceUuid);
+    file << fmt::format("  \"driverVersion\": {},\n", m_driverVersion);
+    file << "  \"measurements\": {\n";
+    file << fmt::format("    \"mipGenerationMegatexelsPerSecond\": {},\n", m_measurements.mipGenerationMegatexelsPerSecond);
+    file << fmt::format("    \"fillGigapixelsPerSecond\": {},\n", m_measurements.fillGigapixelsPerSecond);
+    file << fmt::format("    \"uploadMegabytesPerSecond\": {},\n", m_measurements.uploadMegabytesPerSecond);
+    file << fmt::format("    \"pipelineCompileMilliseconds\": {}\n", m_measurements.pipelineCompileMilliseconds);
+    file << "  }\n}\n";
+
+    if (!file) {
+        throw std::runtime_error("failed to write calibration profile!");
+    }
+}
+
+const CalibrationMeasurements& DeviceCalibration::getMeasurements() const {
+    return m_measurements;
+}
+
+PerformancePreset DeviceCalibration::selectPreset(const CalibrationTarget& target) const {
+    const auto pixelCount = static_cast<double>(target.extent.width) * static_cast<double>(target.extent.height);
+    const auto fillPixelsPerMillisecond = m_measurements.fillGigapixelsPerSecond * 1.0e6;
+    const auto filteringTexelsPerMillisecond = m_measurements.mipGenerationMegatexelsPerSecond * 1.0e3;
+    const auto getFillMilliseconds = [pixelCount, fillPixelsPerMillisecond](VkSampleCountFlagBits sampleCount) {
+        return getMilliseconds(pixelCount * FILL_PASSES_PER_FRAME * static_cast<double>(sampleCount), fillPixelsPerMillisecond);
+    };
+    const auto getFilteringMilliseconds = [pixelCount, filteringTexelsPerMillisecond](float anisotropy) {
+        return getMilliseconds(pixelCount * static_cast<double>(anisotropy), filteringTexelsPerMillisecond);
+    };
+
+    auto preset = PerformancePreset {
+        .msaaSamples = VK_SAMPLE_COUNT_1_BIT,
+        .maxAnisotropy = 1.0f,
+        .maxTextureSize = std::min(MIN_TEXTURE_SIZE, target.maxTextureSize),
+        .framesInFlight = 1,
+        .optimizePipelineLibraryLinks = m_measurements.pipelineCompileMilliseconds <= target.optimizedLinkMilliseconds,
+    };
+
+    const auto fillBudget = FILL_FRAME_SHARE * target.frameMilliseconds;
+    for (auto sampleCount = VK_SAMPLE_COUNT_2_BIT; sampleCount <= target.maxSampleCount; sampleCount = static_cast<VkSampleCountFlagBits>(sampleCount << 1)) {
+        if (getFillMilliseconds(sampleCount) > fillBudget) {
+            break;
+        }
+
+        preset.msaaSamples = sampleCount;
+    }
+
+    const auto fillMilliseconds = getFillMilliseconds(preset.msaaSamples);
+    const auto filteringBudget = FILTERING_FRAME_SHARE * target.frameMilliseconds + std::max(fillBudget - fillMilliseconds, 0.0);
+    for (auto anisotropy = 2.0f; anisotropy <= target.maxAnisotropy; anisotropy *= 2.0f) {
+        if (getFilteringMilliseconds(anisotropy) > filteringBudget) {
+            break;
+        }
+
+        preset.maxAnisotropy = anisotropy;
+    }
+
+    const auto uploadBytesPerMillisecond = m_measurements.uploadMegabytesPerSecond * 1024.0 * 1024.0 / 1000.0;
+    const auto getTextureLoadMilliseconds = [uploadBytesPerMillisecond, filteringTexelsPerMillisecond](uint32_t size) {
+        const auto texelCount = static_cast<double>(size) * static_cast<double>(size);
+
+        return getMilliseconds(texelCount * TEXTURE_BYTES_PER_TEXEL, uploadBytesPerMillisecond)
+            + getMilliseconds(texelCount, filteringTexelsPerMillisecond);
+    };
+    for (auto size = uint64_t { preset.maxTextureSize } * 2; size <= target.maxTextureSize; size *= 2) {
+        if (getTextureLoadMilliseconds(static_cast<uint32_t>(size)) > target.textureLoadMilliseconds) {
+            break;
+        }
+
+        preset.maxTextureSize = static_cast<uint32_t>(size);
+    }
+
+    const auto gpuMilliseconds = fillMilliseconds + getFilteringMilliseconds(preset.maxAnisotropy);
+    const auto framesInFlight = gpuMilliseconds > GPU_BOUND_FRAME_SHARE * target.frameMilliseconds
+        ? LATENCY_FRAMES_IN_FLIGHT + 1
+        : LATENCY_FRAMES_IN_FLIGHT;
+    preset.framesInFlight = std::clamp(framesInFlight, 1u, std::max(target.maxFramesInFlight, 1u));
+
+    return preset;
+}
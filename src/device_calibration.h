@@ -0,0 +1,110 @@
+#ifndef _DEVICE_CALIBRATION_H
+#define _DEVICE_CALIBRATION_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+
+namespace VulkanEngine {
+
+/// @brief What the micro-benchmarks of a calibration measured on a device, each averaged
+/// over its repetitions.
+struct CalibrationMeasurements final {
+    /// @brief The texels of level 0 whose mip chain is generated a second, in millions.
+    double mipGenerationMegatexelsPerSecond = 0.0;
+    /// @brief The pixels a blit writes a second, in billions.
+    double fillGigapixelsPerSecond = 0.0;
+    /// @brief The texture bytes the staging ring uploads a second, in MB.
+    double uploadMegabytesPerSecond = 0.0;
+    /// @brief The time it takes to build the graphics pipeline of the demo.
+    double pipelineCompileMilliseconds = 0.0;
+};
+
+/// @brief What a preset has to meet, and the most every setting can go up to.
+struct CalibrationTarget final {
+    /// @brief The time the GPU work of a frame has to fit in.
+    double frameMilliseconds = 1000.0 / 60.0;
+    /// @brief The time the upload and the mip generation of the largest texture have to fit
+    /// in.
+    double textureLoadMilliseconds = 250.0;
+    /// @brief The slowest pipeline build that still lets graphics pipeline library links
+    /// run the optimizer, which makes every link a full build.
+    double optimizedLinkMilliseconds = 50.0;
+    /// @brief The pixels of a frame.
+    VkExtent2D extent = VkExtent2D { 0, 0 };
+    VkSampleCountFlagBits maxSampleCount = VK_SAMPLE_COUNT_1_BIT;
+    float maxAnisotropy = 1.0f;
+    uint32_t maxTextureSize = 0;
+    uint32_t maxFramesInFlight = 1;
+};
+
+/// @brief The quality and performance settings a calibration picks for a device.
+struct PerformancePreset final {
+    VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+    float maxAnisotropy = 1.0f;
+    /// @brief The largest width or height of a texture level that is sampled.
+    uint32_t maxTextureSize = 0;
+    uint32_t framesInFlight = 1;
+    bool optimizePipelineLibraryLinks = false;
+};
+
+/// @brief The measurements of a device and driver, which every launch on the same device
+/// and driver picks its preset from.
+///
+/// @note The file is JSON. Only the measurements are stored, so the preset follows the
+/// target it is picked for without the device being measured again. A new driver has no
+/// profile, and is measured again.
+///
+/// The preset comes from a coarse model of a frame. Every pixel is written
+/// `FILL_PASSES_PER_FRAME` times per sample, which has to fit in `FILL_FRAME_SHARE` of the
+/// frame, and is sampled once per anisotropic tap, at the rate the mip chain is generated
+/// at, which has to fit in `FILTERING_FRAME_SHARE`. The sample count goes as high as fits,
+/// and the anisotropy takes what the samples leave. The largest texture is the largest power
+/// of two that uploads and generates its mip chain within the texture load time. A frame
+/// whose estimated GPU time takes more than `GPU_BOUND_FRAME_SHARE` of the target keeps one
+/// more frame in flight, so that the GPU never waits on the CPU, and the others keep two,
+/// for lower latency.
+class DeviceCalibration final {
+    public:
+        static constexpr double FILL_PASSES_PER_FRAME = 4.0;
+        static constexpr double FILL_FRAME_SHARE = 0.5;
+        static constexpr double FILTERING_FRAME_SHARE = 0.25;
+        static constexpr double GPU_BOUND_FRAME_SHARE = 0.75;
+        /// @brief The smallest texture size a preset caps at, which every device keeps.
+        static constexpr uint32_t MIN_TEXTURE_SIZE = 256;
+        static constexpr uint32_t LATENCY_FRAMES_IN_FLIGHT = 2;
+
+        explicit DeviceCalibration() = default;
+        explicit DeviceCalibration(const std::string& deviceUuid, uint32_t driverVersion, const CalibrationMeasurements& measurements);
+
+        ~DeviceCalibration() = default;
+
+        DeviceCalibration(DeviceCalibration&& other) noexcept = default;
+        DeviceCalibration& operator=(DeviceCalibration&& other) noexcept = default;
+
+        DeviceCalibration(const DeviceCalibration& other) = delete;
+        DeviceCalibration& operator=(const DeviceCalibration& other) = delete;
+
+        /// @brief The file in `directory` the profile of a device and driver lives in.
+        static std::filesystem::path getPath(const std::filesystem::path& directory, const std::string& deviceUuid, uint32_t driverVersion);
+
+        static DeviceCalibration load(const std::filesystem::path& path);
+
+        void save(const std::filesystem::path& path) const;
+
+        const CalibrationMeasurements& getMeasurements() const;
+
+        /// @brief The best settings whose estimated cost meets `target`.
+        PerformancePreset selectPreset(const CalibrationTarget& target) const;
+    private:
+        std::string m_deviceUuid;
+        uint32_t m_driverVersion = 0;
+        CalibrationMeasurements m_measurements;
+};
+
+}
+
+#endif // _DEVICE_CALIBRATION_H
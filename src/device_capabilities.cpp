@@ -0,0 +1,125 @@
+#include "device_capabilities.h"
+
+#include <mutex>
+
+
+using DeviceCapabilities = VulkanEngine::DeviceCapabilities;
+
+DeviceCapabilities::DeviceCapabilities(VkPhysicalDevice physicalDevice)
+    : m_physicalDevice { physicalDevice }
+    , m_properties {}
+    , m_memoryProperties {}
+    , m_queueFamilies {}
+    , m_features {}
+    , m_vulkan11Features { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES }
+    , m_vulkan12Features { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES }
+    , m_vulkan13Features { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES }
+    , m_formatMutex {}
+    , m_formatProperties {}
+{
+    vkGetPhysicalDeviceProperties(physicalDevice, &m_properties);
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+    m_queueFamilies.resize(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, m_queueFamilies.data());
+
+    this->queryFeatures();
+}
+
+DeviceCapabilities::~DeviceCapabilities() {
+    m_formatProperties.clear();
+    m_queueFamilies.clear();
+    m_physicalDevice = VK_NULL_HANDLE;
+}
+
+VkPhysicalDevice DeviceCapabilities::getPhysicalDevice() const {
+    return m_physicalDevice;
+}
+
+const VkPhysicalDeviceProperties& DeviceCapabilities::getProperties() const {
+    return m_properties;
+}
+
+const VkPhysicalDeviceLimits& DeviceCapabilities::getLimits() const {
+    return m_properties.limits;
+}
+
+const VkPhysicalDeviceMemoryProperties& DeviceCapabilities::getMemoryProperties() const {
+    return m_memoryProperties;
+}
+
+const std::vector<VkQueueFamilyProperties>& DeviceCapabilities::getQueueFamilies() const {
+    return m_queueFamilies;
+}
+
+const VkPhysicalDeviceFeatures& DeviceCapabilities::getFeatures() const {
+    return m_features;
+}
+
+const VkPhysicalDeviceVulkan11Features& DeviceCapabilities::getVulkan11Features() const {
+    return m_vulkan11Features;
+}
+
+const VkPhysicalDeviceVulkan12Features& DeviceCapabilities::getVulkan12Features() const {
+    return m_vulkan12Features;
+}
+
+const VkPhysicalDeviceVulkan13Features& DeviceCapabilities::getVulkan13Features() const {
+    return m_vulkan13Features;
+}
+
+VkFormatProperties DeviceCapabilities::getFormatProperties(VkFormat format) const {
+    {
+        const auto lock = std::shared_lock { m_formatMutex };
+        const auto found = m_formatProperties.find(format);
+        if (found != m_formatProperties.end()) {
+            return found->second;
+        }
+    }
+
+    auto formatProperties = VkFormatProperties {};
+    vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &formatProperties);
+
+    // Two threads that miss on the same format query the same answer, so whichever
+    // inserts first wins and the other is dropped.
+    const auto lock = std::unique_lock { m_formatMutex };
+    m_formatProperties.emplace(format, formatProperties);
+
+    return formatProperties;
+}
+
+bool DeviceCapabilities::hasOptimalTilingFeatures(VkFormat format, VkFormatFeatureFlags features) const {
+    const auto formatProperties = this->getFormatProperties(format);
+
+    return (formatProperties.optimalTilingFeatures & features) == features;
+}
+
+void DeviceCapabilities::queryFeatures() {
+    // The feature structures of a core version are only valid to chain on a device that
+    // supports it, so older devices keep them zeroed.
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = nullptr,
+    };
+    auto** next = &features.pNext;
+    if (m_properties.apiVersion >= VK_API_VERSION_1_2) {
+        *next = &m_vulkan11Features;
+        next = &m_vulkan11Features.pNext;
+        *next = &m_vulkan12Features;
+        next = &m_vulkan12Features.pNext;
+    }
+    if (m_properties.apiVersion >= VK_API_VERSION_1_3) {
+        *next = &m_vulkan13Features;
+        next = &m_vulkan13Features.pNext;
+    }
+
+    vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features);
+
+    m_features = features.features;
+    m_vulkan11Features.pNext = nullptr;
+    m_vulkan12Features.pNext = nullptr;
+    m_vulkan13Features.pNext = nullptr;
+}
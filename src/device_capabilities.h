@@ -0,0 +1,76 @@
+#ifndef _DEVICE_CAPABILITIES_H
+#define _DEVICE_CAPABILITIES_H
+
+#include <vulkan/vulkan.h>
+
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief An immutable snapshot of what a physical device supports, queried once when the
+/// device is opened, so that the renderer and its subsystems answer capability questions
+/// from memory instead of calling back into the driver while they record.
+///
+/// @note The properties, the limits, the memory types, the queue families, and the core
+/// feature chains up to Vulkan 1.3 are all queried by the constructor. Format support is
+/// filled in lazily, the first time each format is asked about, since a device knows about
+/// far more formats than a renderer ever uses. Lookups are safe from any thread.
+class DeviceCapabilities final {
+    public:
+        explicit DeviceCapabilities() = delete;
+        explicit DeviceCapabilities(VkPhysicalDevice physicalDevice);
+
+        ~DeviceCapabilities();
+
+        DeviceCapabilities(const DeviceCapabilities& other) = delete;
+        DeviceCapabilities& operator=(const DeviceCapabilities& other) = delete;
+
+        VkPhysicalDevice getPhysicalDevice() const;
+
+        const VkPhysicalDeviceProperties& getProperties() const;
+
+        const VkPhysicalDeviceLimits& getLimits() const;
+
+        const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const;
+
+        const std::vector<VkQueueFamilyProperties>& getQueueFamilies() const;
+
+        const VkPhysicalDeviceFeatures& getFeatures() const;
+
+        /// @brief The Vulkan 1.1 features, which are all false on a device older than 1.1.
+        const VkPhysicalDeviceVulkan11Features& getVulkan11Features() const;
+
+        /// @brief The Vulkan 1.2 features, which are all false on a device older than 1.2.
+        const VkPhysicalDeviceVulkan12Features& getVulkan12Features() const;
+
+        /// @brief The Vulkan 1.3 features, which are all false on a device older than 1.3.
+        const VkPhysicalDeviceVulkan13Features& getVulkan13Features() const;
+
+        /// @brief The features of `format`, queried from the device the first time it is
+        /// asked for.
+        VkFormatProperties getFormatProperties(VkFormat format) const;
+
+        /// @brief Whether optimally tiled images of `format` support every feature in
+        /// `features`.
+        bool hasOptimalTilingFeatures(VkFormat format, VkFormatFeatureFlags features) const;
+    private:
+        VkPhysicalDevice m_physicalDevice;
+        VkPhysicalDeviceProperties m_properties;
+        VkPhysicalDeviceMemoryProperties m_memoryProperties;
+        std::vector<VkQueueFamilyProperties> m_queueFamilies;
+        VkPhysicalDeviceFeatures m_features;
+        VkPhysicalDeviceVulkan11Features m_vulkan11Features;
+        VkPhysicalDeviceVulkan12Features m_vulkan12Features;
+        VkPhysicalDeviceVulkan13Features m_vulkan13Features;
+        mutable std::shared_mutex m_formatMutex;
+        mutable std::unordered_map<VkFormat, VkFormatProperties> m_formatProperties;
+
+        void queryFeatures();
+};
+
+}
+
+#endif // _DEVICE_CAPABILITIES_H
@@ -0,0 +1,53 @@
+#include "device_dispatch.h"
+
+
+using DeviceDispatch = VulkanEngine::DeviceDispatch;
+
+DeviceDispatch DeviceDispatch::load(VkDevice device) {
+    return DeviceDispatch {
+        .vkBeginCommandBuffer = DeviceDispatch::loadFunction<PFN_vkBeginCommandBuffer>(device, "vkBeginCommandBuffer"),
+        .vkEndCommandBuffer = DeviceDispatch::loadFunction<PFN_vkEndCommandBuffer>(device, "vkEndCommandBuffer"),
+        .vkResetCommandBuffer = DeviceDispatch::loadFunction<PFN_vkResetCommandBuffer>(device, "vkResetCommandBuffer"),
+        .vkResetCommandPool = DeviceDispatch::loadFunction<PFN_vkResetCommandPool>(device, "vkResetCommandPool"),
+        .vkCmdBeginRenderPass = DeviceDispatch::loadFunction<PFN_vkCmdBeginRenderPass>(device, "vkCmdBeginRenderPass"),
+        .vkCmdNextSubpass = DeviceDispatch::loadFunction<PFN_vkCmdNextSubpass>(device, "vkCmdNextSubpass"),
+        .vkCmdEndRenderPass = DeviceDispatch::loadFunction<PFN_vkCmdEndRenderPass>(device, "vkCmdEndRenderPass"),
+        .vkCmdBeginRendering = DeviceDispatch::loadFunction<PFN_vkCmdBeginRendering>(device, "vkCmdBeginRendering"),
+        .vkCmdEndRendering = DeviceDispatch::loadFunction<PFN_vkCmdEndRendering>(device, "vkCmdEndRendering"),
+        .vkCmdExecuteCommands = DeviceDispatch::loadFunction<PFN_vkCmdExecuteCommands>(device, "vkCmdExecuteCommands"),
+        .vkCmdBindPipeline = DeviceDispatch::loadFunction<PFN_vkCmdBindPipeline>(device, "vkCmdBindPipeline"),
+        .vkCmdBindDescriptorSets = DeviceDispatch::loadFunction<PFN_vkCmdBindDescriptorSets>(device, "vkCmdBindDescriptorSets"),
+        .vkCmdBindVertexBuffers = DeviceDispatch::loadFunction<PFN_vkCmdBindVertexBuffers>(device, "vkCmdBindVertexBuffers"),
+        .vkCmdBindIndexBuffer = DeviceDispatch::loadFunction<PFN_vkCmdBindIndexBuffer>(device, "vkCmdBindIndexBuffer"),
+        .vkCmdPushConstants = DeviceDispatch::loadFunction<PFN_vkCmdPushConstants>(device, "vkCmdPushConstants"),
+        .vkCmdSetViewport = DeviceDispatch::loadFunction<PFN_vkCmdSetViewport>(device, "vkCmdSetViewport"),
+        .vkCmdSetScissor = DeviceDispatch::loadFunction<PFN_vkCmdSetScissor>(device, "vkCmdSetScissor"),
+        .vkCmdSetCullMode = DeviceDispatch::loadFunction<PFN_vkCmdSetCullMode>(device, "vkCmdSetCullMode"),
+        .vkCmdSetFrontFace = DeviceDispatch::loadFunction<PFN_vkCmdSetFrontFace>(device, "vkCmdSetFrontFace"),
+        .vkCmdSetPrimitiveTopology = DeviceDispatch::loadFunction<PFN_vkCmdSetPrimitiveTopology>(device, "vkCmdSetPrimitiveTopology"),
+        .vkCmdSetDepthTestEnable = DeviceDispatch::loadFunction<PFN_vkCmdSetDepthTestEnable>(device, "vkCmdSetDepthTestEnable"),
+        .vkCmdSetDepthWriteEnable = DeviceDispatch::loadFunction<PFN_vkCmdSetDepthWriteEnable>(device, "vkCmdSetDepthWriteEnable"),
+        .vkCmdSetDepthCompareOp = DeviceDispatch::loadFunction<PFN_vkCmdSetDepthCompareOp>(device, "vkCmdSetDepthCompareOp"),
+        .vkCmdSetDeviceMask = DeviceDispatch::loadFunction<PFN_vkCmdSetDeviceMask>(device, "vkCmdSetDeviceMask"),
+        .vkCmdDraw = DeviceDispatch::loadFunction<PFN_vkCmdDraw>(device, "vkCmdDraw"),
+        .vkCmdDrawIndexed = DeviceDispatch::loadFunction<PFN_vkCmdDrawIndexed>(device, "vkCmdDrawIndexed"),
+        .vkCmdDrawIndexedIndirect = DeviceDispatch::loadFunction<PFN_vkCmdDrawIndexedIndirect>(device, "vkCmdDrawIndexedIndirect"),
+        .vkCmdDrawIndexedIndirectCount = DeviceDispatch::loadFunction<PFN_vkCmdDrawIndexedIndirectCount>(device, "vkCmdDrawIndexedIndirectCount"),
+        .vkCmdDispatch = DeviceDispatch::loadFunction<PFN_vkCmdDispatch>(device, "vkCmdDispatch"),
+        .vkCmdPipelineBarrier = DeviceDispatch::loadFunction<PFN_vkCmdPipelineBarrier>(device, "vkCmdPipelineBarrier"),
+        .vkCmdPipelineBarrier2 = DeviceDispatch::loadFunction<PFN_vkCmdPipelineBarrier2>(device, "vkCmdPipelineBarrier2"),
+        .vkCmdCopyBuffer = DeviceDispatch::loadFunction<PFN_vkCmdCopyBuffer>(device, "vkCmdCopyBuffer"),
+        .vkCmdCopyImageToBuffer = DeviceDispatch::loadFunction<PFN_vkCmdCopyImageToBuffer>(device, "vkCmdCopyImageToBuffer"),
+        .vkCmdBlitImage = DeviceDispatch::loadFunction<PFN_vkCmdBlitImage>(device, "vkCmdBlitImage"),
+        .vkCmdClearColorImage = DeviceDispatch::loadFunction<PFN_vkCmdClearColorImage>(device, "vkCmdClearColorImage"),
+        .vkUpdateDescriptorSets = DeviceDispatch::loadFunction<PFN_vkUpdateDescriptorSets>(device, "vkUpdateDescriptorSets"),
+        .vkQueueSubmit = DeviceDispatch::loadFunction<PFN_vkQueueSubmit>(device, "vkQueueSubmit"),
+        .vkQueueSubmit2 = DeviceDispatch::loadFunction<PFN_vkQueueSubmit2>(device, "vkQueueSubmit2"),
+        .vkWaitForFences = DeviceDispatch::loadFunction<PFN_vkWaitForFences>(device, "vkWaitForFences"),
+        .vkResetFences = DeviceDispatch::loadFunction<PFN_vkResetFences>(device, "vkResetFences"),
+        .vkWaitSemaphores = DeviceDispatch::loadFunction<PFN_vkWaitSemaphores>(device, "vkWaitSemaphores"),
+        .vkGetSemaphoreCounterValue = DeviceDispatch::loadFunction<PFN_vkGetSemaphoreCounterValue>(device, "vkGetSemaphoreCounterValue"),
+        .vkAcquireNextImageKHR = DeviceDispatch::loadFunction<PFN_vkAcquireNextImageKHR>(device, "vkAcquireNextImageKHR"),
+        .vkQueuePresentKHR = DeviceDispatch::loadFunction<PFN_vkQueuePresentKHR>(device, "vkQueuePresentKHR"),
+    };
+}
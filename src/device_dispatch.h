@@ -0,0 +1,93 @@
+#ifndef _DEVICE_DISPATCH_H
+#define _DEVICE_DISPATCH_H
+
+#include <vulkan/vulkan.h>
+
+
+namespace VulkanEngine {
+
+/// @brief The entry points of the commands recorded and submitted every frame, loaded from
+/// one device with `vkGetDeviceProcAddr`.
+///
+/// @note Calling these goes straight to the driver, where the functions the loader exports
+/// first look up the dispatch table of the handle they are given. Only the commands on the
+/// path of a frame are here, and creating and destroying objects goes through the loader as
+/// before. An entry point the device does not expose stays null, and the extension ones are
+/// only loaded by the device that enables their extension, so each is called behind the
+/// same support checks as before.
+struct DeviceDispatch final {
+    PFN_vkBeginCommandBuffer vkBeginCommandBuffer = nullptr;
+    PFN_vkEndCommandBuffer vkEndCommandBuffer = nullptr;
+    PFN_vkResetCommandBuffer vkResetCommandBuffer = nullptr;
+    PFN_vkResetCommandPool vkResetCommandPool = nullptr;
+
+    PFN_vkCmdBeginRenderPass vkCmdBeginRenderPass = nullptr;
+    PFN_vkCmdNextSubpass vkCmdNextSubpass = nullptr;
+    PFN_vkCmdEndRenderPass vkCmdEndRenderPass = nullptr;
+    PFN_vkCmdBeginRendering vkCmdBeginRendering = nullptr;
+    PFN_vkCmdEndRendering vkCmdEndRendering = nullptr;
+    PFN_vkCmdExecuteCommands vkCmdExecuteCommands = nullptr;
+
+    PFN_vkCmdBindPipeline vkCmdBindPipeline = nullptr;
+    PFN_vkCmdBindDescriptorSets vkCmdBindDescriptorSets = nullptr;
+    PFN_vkCmdBindVertexBuffers vkCmdBindVertexBuffers = nullptr;
+    PFN_vkCmdBindIndexBuffer vkCmdBindIndexBuffer = nullptr;
+    PFN_vkCmdPushConstants vkCmdPushConstants = nullptr;
+
+    PFN_vkCmdSetViewport vkCmdSetViewport = nullptr;
+    PFN_vkCmdSetScissor vkCmdSetScissor = nullptr;
+    PFN_vkCmdSetCullMode vkCmdSetCullMode = nullptr;
+    PFN_vkCmdSetFrontFace vkCmdSetFrontFace = nullptr;
+    PFN_vkCmdSetPrimitiveTopology vkCmdSetPrimitiveTopology = nullptr;
+    PFN_vkCmdSetDepthTestEnable vkCmdSetDepthTestEnable = nullptr;
+    PFN_vkCmdSetDepthWriteEnable vkCmdSetDepthWriteEnable = nullptr;
+    PFN_vkCmdSetDepthCompareOp vkCmdSetDepthCompareOp = nullptr;
+    PFN_vkCmdSetDeviceMask vkCmdSetDeviceMask = nullptr;
+
+    PFN_vkCmdDraw vkCmdDraw = nullptr;
+    PFN_vkCmdDrawIndexed vkCmdDrawIndexed = nullptr;
+    PFN_vkCmdDrawIndexedIndirect vkCmdDrawIndexedIndirect = nullptr;
+    PFN_vkCmdDrawIndexedIndirectCount vkCmdDrawIndexedIndirectCount = nullptr;
+    PFN_vkCmdDispatch vkCmdDispatch = nullptr;
+
+    PFN_vkCmdPipelineBarrier vkCmdPipelineBarrier = nullptr;
+    PFN_vkCmdPipelineBarrier2 vkCmdPipelineBarrier2 = nullptr;
+    PFN_vkCmdCopyBuffer vkCmdCopyBuffer = nullptr;
+    PFN_vkCmdCopyImageToBuffer vkCmdCopyImageToBuffer = nullptr;
+    PFN_vkCmdBlitImage vkCmdBlitImage = nullptr;
+    PFN_vkCmdClearColorImage vkCmdClearColorImage = nullptr;
+
+    PFN_vkUpdateDescriptorSets vkUpdateDescriptorSets = nullptr;
+
+    PFN_vkQueueSubmit vkQueueSubmit = nullptr;
+    PFN_vkQueueSubmit2 vkQueueSubmit2 = nullptr;
+    PFN_vkWaitForFences vkWaitForFences = nullptr;
+    PFN_vkResetFences vkResetFences = nullptr;
+    PFN_vkWaitSemaphores vkWaitSemaphores = nullptr;
+    PFN_vkGetSemaphoreCounterValue vkGetSemaphoreCounterValue = nullptr;
+
+    PFN_vkAcquireNextImageKHR vkAcquireNextImageKHR = nullptr;
+    PFN_vkQueuePresentKHR vkQueuePresentKHR = nullptr;
+
+    PFN_vkCmdDrawMeshTasksEXT vkCmdDrawMeshTasksEXT = nullptr;
+    PFN_vkWaitForPresentKHR vkWaitForPresentKHR = nullptr;
+    PFN_vkCmdSetFragmentShadingRateKHR vkCmdSetFragmentShadingRateKHR = nullptr;
+    PFN_vkCmdBeginConditionalRenderingEXT vkCmdBeginConditionalRenderingEXT = nullptr;
+    PFN_vkCmdEndConditionalRenderingEXT vkCmdEndConditionalRenderingEXT = nullptr;
+
+    /// @brief Load the core entry points, and those of the swap chain, from `device`.
+    ///
+    /// @note The entry points of the other extensions are left to the device, which knows
+    /// which of them it has enabled.
+    static DeviceDispatch load(VkDevice device);
+
+    /// @brief The entry point `name` of `device`, cast to `Function`.
+    template <typename Function>
+    static Function loadFunction(VkDevice device, const char* name) {
+        return reinterpret_cast<Function>(vkGetDeviceProcAddr(device, name));
+    }
+};
+
+}
+
+#endif // _DEVICE_DISPATCH_H
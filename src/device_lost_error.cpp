@@ -0,0 +1,9 @@
+#include "device_lost_error.h"
+
+
+using DeviceLostError = VulkanEngine::DeviceLostError;
+
+DeviceLostError::DeviceLostError(const std::string& message)
+    : std::runtime_error { message }
+{
+}
@@ -0,0 +1,22 @@
+#ifndef _DEVICE_LOST_ERROR_H
+#define _DEVICE_LOST_ERROR_H
+
+#include <stdexcept>
+#include <string>
+
+
+namespace VulkanEngine {
+
+/// @brief What a submit, a present or a wait throws when the device reports
+/// `VK_ERROR_DEVICE_LOST`, so that the app can open the device again instead of exiting.
+///
+/// @note Nothing created from a lost device can be used again, but it can all still be
+/// destroyed, and every wait on it returns at once.
+class DeviceLostError final : public std::runtime_error {
+    public:
+        explicit DeviceLostError(const std::string& message);
+};
+
+}
+
+#endif // _DEVICE_LOST_ERROR_H
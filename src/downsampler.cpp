@@ -0,0 +1,489 @@
+#include "downsampler.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+
+#include "command_counters.h"
+
+
+using Downsampler = VulkanEngine::Downsampler;
+using DownsampleReduction = VulkanEngine::DownsampleReduction;
+using DownsampleSourceFilter = VulkanEngine::DownsampleSourceFilter;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+Downsampler::Downsampler(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    VkPipelineCache pipelineCache,
+    std::span<const uint32_t> shaderCode,
+    VkFormat format,
+    VkExtent2D extent,
+    std::span<const VkImageView> mipViews,
+    DownsampleReduction reduction,
+    VkImageView sourceImageView,
+    DownsampleSourceFilter sourceFilter
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_format { format }
+    , m_extent { extent }
+    , m_reduction { reduction }
+    , m_sourceFilter { sourceFilter }
+    , m_singlePassMipLevels {
+        std::max(extent.width, extent.height) <= MAX_SINGLE_PASS_EXTENT
+            ? static_cast<uint32_t>(mipViews.size())
+            : std::min(static_cast<uint32_t>(mipViews.size()), TILE_LEVELS + 1)
+    }
+    , m_descriptorSetLayout { VK_NULL_HANDLE }
+    , m_pipelineLayout { VK_NULL_HANDLE }
+    , m_pipeline { VK_NULL_HANDLE }
+    , m_sourceSampler { VK_NULL_HANDLE }
+    , m_counterBuffer { VK_NULL_HANDLE }
+    , m_counterAllocation {}
+    , m_descriptorPool { VK_NULL_HANDLE }
+    , m_descriptorSet { VK_NULL_HANDLE }
+{
+    if (format != VK_FORMAT_R32_SFLOAT && format != VK_FORMAT_R16G16B16A16_SFLOAT) {
+        throw std::invalid_argument("downsampler only reduces R32_SFLOAT and R16G16B16A16_SFLOAT chains");
+    }
+    if (extent.width == 0 || extent.height == 0) {
+        throw std::invalid_argument("downsampler needs a first level that is not empty");
+    }
+    if (mipViews.size() < 2 || mipViews.size() > MAX_MIP_LEVELS) {
+        throw std::invalid_argument("downsampler needs between 2 and MAX_MIP_LEVELS levels");
+    }
+    if ((sourceImageView != VK_NULL_HANDLE) != (sourceFilter != DownsampleSourceFilter::None)) {
+        throw std::invalid_argument("downsampler needs a source filter exactly for a chain with a source");
+    }
+    if (sourceImageView != VK_NULL_HANDLE && m_singlePassMipLevels != mipViews.size()) {
+        throw std::invalid_argument("downsampler only filters a source into a chain one dispatch reduces whole");
+    }
+
+    this->createDescriptorSetLayout();
+    this->createPipeline(pipelineCache, shaderCode);
+    if (sourceImageView != VK_NULL_HANDLE) {
+        this->createSourceSampler();
+    }
+    this->createCounterBuffer();
+    this->createDescriptorSet(mipViews, sourceImageView);
+}
+
+Downsampler::~Downsampler() {
+    vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+    vkDestroyBuffer(m_device, m_counterBuffer, nullptr);
+    m_allocator.free(m_counterAllocation);
+    vkDestroySampler(m_device, m_sourceSampler, nullptr);
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+
+    m_descriptorSet = VK_NULL_HANDLE;
+    m_descriptorPool = VK_NULL_HANDLE;
+    m_counterBuffer = VK_NULL_HANDLE;
+    m_sourceSampler = VK_NULL_HANDLE;
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipelineLayout = VK_NULL_HANDLE;
+    m_descriptorSetLayout = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void Downsampler::recordInitialization(VkCommandBuffer commandBuffer) const {
+    // The shader resets the counter itself, after the first reduction.
+    vkCmdFillBuffer(commandBuffer, m_counterBuffer, 0, VK_WHOLE_SIZE, 0);
+
+    const auto counterBarrier = VkBufferMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = m_counterBuffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, nullptr,
+        1, &counterBarrier,
+        0, nullptr
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+}
+
+void Downsampler::record(VkCommandBuffer commandBuffer, float lastLevelFeedback) const {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    CommandCounters::add(CommandCounter::PipelineBinds);
+    vkCmdBindDescriptorSets(
+        commandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        m_pipelineLayout,
+        0,
+        1,
+        &m_descriptorSet,
+        0,
+        nullptr
+    );
+    CommandCounters::add(CommandCounter::DescriptorBinds);
+
+    const auto workGroupCountX = (m_extent.width + TILE_SIZE - 1) / TILE_SIZE;
+    const auto workGroupCountY = (m_extent.height + TILE_SIZE - 1) / TILE_SIZE;
+    const auto pushConstants = PushConstants {
+        .width = m_extent.width,
+        .height = m_extent.height,
+        .mipCount = m_singlePassMipLevels,
+        .workGroupCount = workGroupCountX * workGroupCountY,
+        .lastLevelFeedback = lastLevelFeedback,
+    };
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+    vkCmdDispatch(commandBuffer, workGroupCountX, workGroupCountY, 1);
+    CommandCounters::add(CommandCounter::Dispatches);
+}
+
+uint32_t Downsampler::getSinglePassMipLevels() const {
+    return m_singlePassMipLevels;
+}
+
+bool Downsampler::isColor() const {
+    return m_format == VK_FORMAT_R16G16B16A16_SFLOAT;
+}
+
+void Downsampler::createDescriptorSetLayout() {
+    const auto bindings = std::array<VkDescriptorSetLayoutBinding, 5> {
+        VkDescriptorSetLayoutBinding {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = MAX_MIP_LEVELS,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 2,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = MAX_MIP_LEVELS,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 3,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 4,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+    };
+    // A chain is bound through the levels of its own format, and the other ones, and the
+    // source of a chain without one, are never touched.
+    const auto bindingFlags = std::array<VkDescriptorBindingFlags, 5> {
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+        0,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+    };
+    const auto bindingFlagsInfo = VkDescriptorSetLayoutBindingFlagsCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+        .pBindingFlags = bindingFlags.data(),
+    };
+    const auto layoutInfo = VkDescriptorSetLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &bindingFlagsInfo,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+
+    auto descriptorSetLayout = VkDescriptorSetLayout {};
+    const auto result = vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &descriptorSetLayout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create downsampler descriptor set layout!");
+    }
+
+    m_descriptorSetLayout = descriptorSetLayout;
+}
+
+void Downsampler::createPipeline(VkPipelineCache pipelineCache, std::span<const uint32_t> shaderCode) {
+    const auto pushConstantRange = VkPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_descriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+
+    auto pipelineLayout = VkPipelineLayout {};
+    const auto resultCreatePipelineLayout = vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    if (resultCreatePipelineLayout != VK_SUCCESS) {
+        throw std::runtime_error("failed to create downsampler pipeline layout!");
+    }
+
+    // The destructor takes care of the layout if the pipeline fails.
+    m_pipelineLayout = pipelineLayout;
+
+    const auto shaderModuleInfo = VkShaderModuleCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = shaderCode.size_bytes(),
+        .pCode = shaderCode.data(),
+    };
+
+    auto shaderModule = VkShaderModule {};
+    const auto resultCreateShaderModule = vkCreateShaderModule(m_device, &shaderModuleInfo, nullptr, &shaderModule);
+    if (resultCreateShaderModule != VK_SUCCESS) {
+        throw std::runtime_error("failed to create downsampler shader module!");
+    }
+
+    const auto specialization = Specialization {
+        .reduction = static_cast<uint32_t>(m_reduction),
+        .isColor = this->isColor() ? 1u : 0u,
+        .sourceFilter = static_cast<uint32_t>(m_sourceFilter),
+    };
+    const auto specializationEntries = std::array<VkSpecializationMapEntry, 3> {
+        VkSpecializationMapEntry {
+            .constantID = 0,
+            .offset = offsetof(Specialization, reduction),
+            .size = sizeof(uint32_t),
+        },
+        VkSpecializationMapEntry {
+            .constantID = 1,
+            .offset = offsetof(Specialization, isColor),
+            .size = sizeof(uint32_t),
+        },
+        VkSpecializationMapEntry {
+            .constantID = 2,
+            .offset = offsetof(Specialization, sourceFilter),
+            .size = sizeof(uint32_t),
+        },
+    };
+    const auto specializationInfo = VkSpecializationInfo {
+        .mapEntryCount = static_cast<uint32_t>(specializationEntries.size()),
+        .pMapEntries = specializationEntries.data(),
+        .dataSize = sizeof(Specialization),
+        .pData = &specialization,
+    };
+    const auto pipelineInfo = VkComputePipelineCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shaderModule,
+            .pName = "main",
+            .pSpecializationInfo = &specializationInfo,
+        },
+        .layout = m_pipelineLayout,
+    };
+
+    auto pipeline = VkPipeline {};
+    const auto resultCreatePipeline = vkCreateComputePipelines(m_device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    // The pipeline keeps everything it needs from the shader module.
+    vkDestroyShaderModule(m_device, shaderModule, nullptr);
+
+    if (resultCreatePipeline != VK_SUCCESS) {
+        throw std::runtime_error("failed to create downsampler pipeline!");
+    }
+
+    m_pipeline = pipeline;
+}
+
+void Downsampler::createSourceSampler() {
+    // The source is sampled in the middle of every texel of the first level, between the
+    // texels of a source twice its size, and never past its edges.
+    const auto samplerInfo = VkSamplerCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .mipLodBias = 0.0f,
+        .anisotropyEnable = VK_FALSE,
+        .maxAnisotropy = 1.0f,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .minLod = 0.0f,
+        .maxLod = 0.0f,
+        .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+
+    auto sampler = VkSampler {};
+    const auto result = vkCreateSampler(m_device, &samplerInfo, nullptr, &sampler);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create downsampler source sampler!");
+    }
+
+    m_sourceSampler = sampler;
+}
+
+void Downsampler::createCounterBuffer() {
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = sizeof(uint32_t),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto result = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create downsampler counter buffer!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    const auto allocation = m_allocator.allocate(
+        memRequirements,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        GpuResourceKind::Linear,
+        GpuMemoryCategory::Other
+    );
+
+    vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+    m_counterBuffer = buffer;
+    m_counterAllocation = allocation;
+}
+
+void Downsampler::createDescriptorSet(std::span<const VkImageView> mipViews, VkImageView sourceImageView) {
+    const auto poolSizes = std::array<VkDescriptorPoolSize, 4> {
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = MAX_MIP_LEVELS,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 1,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLER,
+            .descriptorCount = 1,
+        },
+    };
+    const auto poolInfo = VkDescriptorPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = 0,
+        .maxSets = 1,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+    };
+
+    auto descriptorPool = VkDescriptorPool {};
+    const auto resultCreateDescriptorPool = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &descriptorPool);
+    if (resultCreateDescriptorPool != VK_SUCCESS) {
+        throw std::runtime_error("failed to create downsampler descriptor pool!");
+    }
+
+    m_descriptorPool = descriptorPool;
+
+    const auto allocInfo = VkDescriptorSetAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_descriptorPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &m_descriptorSetLayout,
+    };
+
+    auto descriptorSet = VkDescriptorSet {};
+    const auto resultAllocateDescriptorSets = vkAllocateDescriptorSets(m_device, &allocInfo, &descriptorSet);
+    if (resultAllocateDescriptorSets != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate downsampler descriptor set!");
+    }
+
+    // Every element of the array must be valid, so the ones past the last level repeat it;
+    // the shader never stores to them.
+    auto mipInfos = std::array<VkDescriptorImageInfo, MAX_MIP_LEVELS> {};
+    for (uint32_t level = 0; level < MAX_MIP_LEVELS; level++) {
+        mipInfos[level] = VkDescriptorImageInfo {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = mipViews[std::min<size_t>(level, mipViews.size() - 1)],
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        };
+    }
+    const auto counterInfo = VkDescriptorBufferInfo {
+        .buffer = m_counterBuffer,
+        .offset = 0,
+        .range = VK_WHOLE_SIZE,
+    };
+    const auto sourceInfo = VkDescriptorImageInfo {
+        .sampler = VK_NULL_HANDLE,
+        .imageView = sourceImageView,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+    const auto samplerInfo = VkDescriptorImageInfo {
+        .sampler = m_sourceSampler,
+        .imageView = VK_NULL_HANDLE,
+        .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    const auto descriptorWrites = std::array<VkWriteDescriptorSet, 4> {
+        VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = this->isColor() ? 2u : 0u,
+            .dstArrayElement = 0,
+            .descriptorCount = MAX_MIP_LEVELS,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .pImageInfo = mipInfos.data(),
+        },
+        VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = 1,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &counterInfo,
+        },
+        VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = 3,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .pImageInfo = &sourceInfo,
+        },
+        VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = 4,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+            .pImageInfo = &samplerInfo,
+        },
+    };
+    // The source and its sampler are only written for a chain that has one.
+    const auto descriptorWriteCount = sourceImageView != VK_NULL_HANDLE ? 4u : 2u;
+    vkUpdateDescriptorSets(m_device, descriptorWriteCount, descriptorWrites.data(), 0, nullptr);
+
+    m_descriptorSet = descriptorSet;
+}
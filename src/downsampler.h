@@ -0,0 +1,145 @@
+#ifndef _DOWNSAMPLER_H
+#define _DOWNSAMPLER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief How a texel of a level of a `Downsampler` chain combines the four under it.
+enum class DownsampleReduction : uint32_t {
+    Min = 0,
+    Max = 1,
+    Average = 2
+};
+
+/// @brief What the first level of a `Downsampler` chain is filtered into from its source.
+enum class DownsampleSourceFilter : uint32_t {
+    /// @brief The chain has no source, and its first level is written before it is reduced.
+    None = 0,
+    /// @brief The color of the source.
+    Color = 1,
+    /// @brief The natural log of the luminance of the source, so that the average over the
+    /// chain is the log average luminance.
+    LogLuminance = 2
+};
+
+/// @brief Reduces the first level of a chain of levels into every level after it in one
+/// dispatch of the downsample shader, a single-pass downsampler in the manner of the one
+/// of the mip generator, for the chains that are not textures.
+///
+/// @note Every workgroup reduces one `TILE_SIZE` tile of the first level into the
+/// `TILE_LEVELS` levels after it, and the last workgroup to finish, found through an atomic
+/// counter, reduces the tail of the chain. The counter resets itself, so it only needs
+/// clearing when the chain is initialized. Past `MAX_SINGLE_PASS_EXTENT` a side only the
+/// levels the workgroups reduce out of shared memory are written, and the rest are left to
+/// the caller.
+///
+/// A chain with a source has its first level filtered from it by the same dispatch, which
+/// samples the source with a linear filter in the middle of every texel of the first level.
+/// A source is sampled in `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL`, and only fits a
+/// chain that one dispatch reduces whole.
+///
+/// Chains are `VK_FORMAT_R32_SFLOAT` or `VK_FORMAT_R16G16B16A16_SFLOAT` images in
+/// `VK_IMAGE_LAYOUT_GENERAL`, with a view of each level and the storage usage, and halve
+/// from one level to the next.
+class Downsampler final {
+    public:
+        /// @brief The texels a side of the tile of the first level every workgroup
+        /// reduces, and the levels its shared memory reduces the tile into.
+        static constexpr uint32_t TILE_SIZE = 64;
+        static constexpr uint32_t TILE_LEVELS = 6;
+        /// @brief The levels the downsample shader binds, as `MAX_MIP_LEVELS` in it.
+        static constexpr uint32_t MAX_MIP_LEVELS = 13;
+        /// @brief The largest side of a first level whose whole chain one dispatch reduces,
+        /// since the last workgroup reduces a single tile.
+        static constexpr uint32_t MAX_SINGLE_PASS_EXTENT = TILE_SIZE << TILE_LEVELS;
+
+        explicit Downsampler() = delete;
+        /// @note `mipViews` holds a view of each level, from the first, and `sourceImageView`
+        /// is `VK_NULL_HANDLE` for a chain without a source.
+        explicit Downsampler(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            VkPipelineCache pipelineCache,
+            std::span<const uint32_t> shaderCode,
+            VkFormat format,
+            VkExtent2D extent,
+            std::span<const VkImageView> mipViews,
+            DownsampleReduction reduction,
+            VkImageView sourceImageView,
+            DownsampleSourceFilter sourceFilter
+        );
+
+        ~Downsampler();
+
+        Downsampler(const Downsampler& other) = delete;
+        Downsampler& operator=(const Downsampler& other) = delete;
+
+        /// @brief Record clearing the workgroup counter, and the barrier that makes it
+        /// ready for the first reduction.
+        void recordInitialization(VkCommandBuffer commandBuffer) const;
+
+        /// @brief Record reducing the chain.
+        ///
+        /// @note Must be recorded outside of a render pass. The barriers that order the
+        /// writes of the first level, or of the source, before it, and the reads of the
+        /// chain after it, are left to the caller. Every texel of the last level written
+        /// moves toward its new value by `lastLevelFeedback`, which keeps a running average
+        /// of it below one.
+        void record(VkCommandBuffer commandBuffer, float lastLevelFeedback = 1.0f) const;
+
+        /// @brief The levels one reduction writes, from the first one.
+        uint32_t getSinglePassMipLevels() const;
+    private:
+        struct PushConstants final {
+            uint32_t width;
+            uint32_t height;
+            uint32_t mipCount;
+            uint32_t workGroupCount;
+            float lastLevelFeedback;
+        };
+
+        struct Specialization final {
+            uint32_t reduction;
+            uint32_t isColor;
+            uint32_t sourceFilter;
+        };
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkFormat m_format;
+        VkExtent2D m_extent;
+        DownsampleReduction m_reduction;
+        DownsampleSourceFilter m_sourceFilter;
+        uint32_t m_singlePassMipLevels;
+        VkDescriptorSetLayout m_descriptorSetLayout;
+        VkPipelineLayout m_pipelineLayout;
+        VkPipeline m_pipeline;
+        VkSampler m_sourceSampler;
+        VkBuffer m_counterBuffer;
+        GpuAllocation m_counterAllocation;
+        VkDescriptorPool m_descriptorPool;
+        VkDescriptorSet m_descriptorSet;
+
+        bool isColor() const;
+
+        void createDescriptorSetLayout();
+
+        void createPipeline(VkPipelineCache pipelineCache, std::span<const uint32_t> shaderCode);
+
+        void createSourceSampler();
+
+        void createCounterBuffer();
+
+        void createDescriptorSet(std::span<const VkImageView> mipViews, VkImageView sourceImageView);
+};
+
+}
+
+#endif // _DOWNSAMPLER_H
@@ -0,0 +1,394 @@
+#include "draw_culler.h"
+
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+#include "command_counters.h"
+
+
+using DrawCuller = VulkanEngine::DrawCuller;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+DrawCuller::DrawCuller(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    VkPipelineCache pipelineCache,
+    std::span<const uint32_t> shaderCode,
+    const IndirectDrawBuffer& candidateDraws,
+    const VkDescriptorBufferInfo& uniformBufferInfo,
+    VkBuffer boundingSphereBuffer,
+    bool isReverseDepth
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_candidateDraws { candidateDraws }
+    , m_isReverseDepth { isReverseDepth }
+    , m_descriptorSetLayout { VK_NULL_HANDLE }
+    , m_pipelineLayout { VK_NULL_HANDLE }
+    , m_pipeline { VK_NULL_HANDLE }
+    , m_descriptorPool { VK_NULL_HANDLE }
+    , m_descriptorSets {}
+    , m_depthPyramidViews(candidateDraws.getFrameCount(), VK_NULL_HANDLE)
+    , m_buffer { VK_NULL_HANDLE }
+    , m_allocation {}
+{
+    this->createDescriptorSetLayout();
+    this->createPipeline(pipelineCache, shaderCode);
+    this->createBuffer();
+    this->createDescriptorSets(uniformBufferInfo, boundingSphereBuffer);
+}
+
+DrawCuller::~DrawCuller() {
+    vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+
+    vkDestroyBuffer(m_device, m_buffer, nullptr);
+    m_allocator.free(m_allocation);
+
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+
+    m_descriptorPool = VK_NULL_HANDLE;
+    m_descriptorSets.clear();
+    m_buffer = VK_NULL_HANDLE;
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipelineLayout = VK_NULL_HANDLE;
+    m_descriptorSetLayout = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void DrawCuller::record(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t uniformBufferOffset) const {
+    const auto countOffset = this->getCountOffset(frameIndex);
+
+    // The frame's previous submit has finished before the frame is recorded again, so
+    // nothing still reads the count.
+    vkCmdFillBuffer(commandBuffer, m_buffer, countOffset, sizeof(uint32_t), 0);
+
+    const auto countBarrier = VkBufferMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = m_buffer,
+        .offset = countOffset,
+        .size = sizeof(uint32_t),
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, nullptr,
+        1, &countBarrier,
+        0, nullptr
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    CommandCounters::add(CommandCounter::PipelineBinds);
+    vkCmdBindDescriptorSets(
+        commandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        m_pipelineLayout,
+        0,
+        1,
+        &m_descriptorSets[frameIndex],
+        1,
+        &uniformBufferOffset
+    );
+    CommandCounters::add(CommandCounter::DescriptorBinds);
+
+    const auto pushConstants = PushConstants {
+        .countOffset = static_cast<uint32_t>(countOffset / sizeof(uint32_t)),
+        .drawOffset = static_cast<uint32_t>(this->getDrawOffset(frameIndex) / sizeof(uint32_t)),
+        .cullOcclusion = m_depthPyramidViews[frameIndex] != VK_NULL_HANDLE,
+        .isReverseDepth = m_isReverseDepth,
+    };
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+
+    // Threads past the frame's draw count return right away, so the dispatch covers the
+    // most draws there can be without reading the count back.
+    const auto workGroupCount = (this->getMaxDrawCount() + THREAD_COUNT - 1) / THREAD_COUNT;
+    vkCmdDispatch(commandBuffer, workGroupCount, 1, 1);
+    CommandCounters::add(CommandCounter::Dispatches);
+}
+
+void DrawCuller::setDepthPyramid(uint32_t frameIndex, VkImageView depthPyramidView) {
+    // Rewriting the set invalidates the command buffers that bind it, so it is only written
+    // when the pyramid changes.
+    if (m_depthPyramidViews[frameIndex] == depthPyramidView) {
+        return;
+    }
+
+    m_depthPyramidViews[frameIndex] = depthPyramidView;
+    if (depthPyramidView == VK_NULL_HANDLE) {
+        return;
+    }
+
+    const auto depthPyramidInfo = VkDescriptorImageInfo {
+        .sampler = VK_NULL_HANDLE,
+        .imageView = depthPyramidView,
+        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+    };
+    const auto descriptorWrite = VkWriteDescriptorSet {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = m_descriptorSets[frameIndex],
+        .dstBinding = 4,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        .pImageInfo = &depthPyramidInfo,
+    };
+    vkUpdateDescriptorSets(m_device, 1, &descriptorWrite, 0, nullptr);
+}
+
+VkBuffer DrawCuller::getBuffer() const {
+    return m_buffer;
+}
+
+VkDeviceSize DrawCuller::getCountOffset(uint32_t frameIndex) const {
+    return m_candidateDraws.getCountOffset(frameIndex);
+}
+
+VkDeviceSize DrawCuller::getDrawOffset(uint32_t frameIndex) const {
+    return m_candidateDraws.getDrawOffset(frameIndex);
+}
+
+uint32_t DrawCuller::getMaxDrawCount() const {
+    return m_candidateDraws.getMaxDrawCount();
+}
+
+void DrawCuller::createDescriptorSetLayout() {
+    const auto bindings = std::array<VkDescriptorSetLayoutBinding, 5> {
+        VkDescriptorSetLayoutBinding {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 2,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 3,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 4,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+    };
+    // The depth pyramid stays unwritten in the frames that only cull against the frustum,
+    // which never read it.
+    const auto bindingFlags = std::array<VkDescriptorBindingFlags, 5> {
+        0,
+        0,
+        0,
+        0,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+    };
+    const auto bindingFlagsInfo = VkDescriptorSetLayoutBindingFlagsCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+        .pBindingFlags = bindingFlags.data(),
+    };
+    const auto layoutInfo = VkDescriptorSetLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &bindingFlagsInfo,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+
+    auto descriptorSetLayout = VkDescriptorSetLayout {};
+    const auto result = vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &descriptorSetLayout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create draw culler descriptor set layout!");
+    }
+
+    m_descriptorSetLayout = descriptorSetLayout;
+}
+
+void DrawCuller::createPipeline(VkPipelineCache pipelineCache, std::span<const uint32_t> shaderCode) {
+    const auto pushConstantRange = VkPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_descriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+
+    auto pipelineLayout = VkPipelineLayout {};
+    const auto resultCreatePipelineLayout = vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    if (resultCreatePipelineLayout != VK_SUCCESS) {
+        throw std::runtime_error("failed to create draw culler pipeline layout!");
+    }
+
+    const auto shaderModuleInfo = VkShaderModuleCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = shaderCode.size_bytes(),
+        .pCode = shaderCode.data(),
+    };
+
+    auto shaderModule = VkShaderModule {};
+    const auto resultCreateShaderModule = vkCreateShaderModule(m_device, &shaderModuleInfo, nullptr, &shaderModule);
+    if (resultCreateShaderModule != VK_SUCCESS) {
+        vkDestroyPipelineLayout(m_device, pipelineLayout, nullptr);
+
+        throw std::runtime_error("failed to create draw culler shader module!");
+    }
+
+    const auto pipelineInfo = VkComputePipelineCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shaderModule,
+            .pName = "main",
+        },
+        .layout = pipelineLayout,
+    };
+
+    auto pipeline = VkPipeline {};
+    const auto resultCreatePipeline = vkCreateComputePipelines(m_device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    // The pipeline keeps everything it needs from the shader module.
+    vkDestroyShaderModule(m_device, shaderModule, nullptr);
+
+    if (resultCreatePipeline != VK_SUCCESS) {
+        vkDestroyPipelineLayout(m_device, pipelineLayout, nullptr);
+
+        throw std::runtime_error("failed to create draw culler pipeline!");
+    }
+
+    m_pipelineLayout = pipelineLayout;
+    m_pipeline = pipeline;
+}
+
+void DrawCuller::createBuffer() {
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = m_candidateDraws.getSize(),
+        .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto resultCreateBuffer = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+    if (resultCreateBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to create culled draw buffer!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    const auto allocation = m_allocator.allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Linear, GpuMemoryCategory::Other);
+
+    vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+    m_buffer = buffer;
+    m_allocation = allocation;
+}
+
+void DrawCuller::createDescriptorSets(const VkDescriptorBufferInfo& uniformBufferInfo, VkBuffer boundingSphereBuffer) {
+    const auto frameCount = m_candidateDraws.getFrameCount();
+    const auto poolSizes = std::array<VkDescriptorPoolSize, 3> {
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+            .descriptorCount = frameCount,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 3 * frameCount,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = frameCount,
+        },
+    };
+    const auto poolInfo = VkDescriptorPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = 0,
+        .maxSets = frameCount,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+    };
+
+    auto descriptorPool = VkDescriptorPool {};
+    const auto resultCreateDescriptorPool = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &descriptorPool);
+    if (resultCreateDescriptorPool != VK_SUCCESS) {
+        throw std::runtime_error("failed to create draw culler descriptor pool!");
+    }
+
+    m_descriptorPool = descriptorPool;
+
+    const auto setLayouts = std::vector<VkDescriptorSetLayout>(frameCount, m_descriptorSetLayout);
+    const auto allocInfo = VkDescriptorSetAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_descriptorPool,
+        .descriptorSetCount = frameCount,
+        .pSetLayouts = setLayouts.data(),
+    };
+
+    auto descriptorSets = std::vector<VkDescriptorSet>(frameCount);
+    const auto resultAllocateDescriptorSets = vkAllocateDescriptorSets(m_device, &allocInfo, descriptorSets.data());
+    if (resultAllocateDescriptorSets != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate draw culler descriptor sets!");
+    }
+
+    // Every frame binds the buffers whole, and finds its regions by the push constants.
+    const auto storageBufferInfos = std::array<VkDescriptorBufferInfo, 3> {
+        VkDescriptorBufferInfo { .buffer = m_candidateDraws.getBuffer(), .offset = 0, .range = VK_WHOLE_SIZE },
+        VkDescriptorBufferInfo { .buffer = boundingSphereBuffer, .offset = 0, .range = VK_WHOLE_SIZE },
+        VkDescriptorBufferInfo { .buffer = m_buffer, .offset = 0, .range = VK_WHOLE_SIZE },
+    };
+    auto descriptorWrites = std::vector<VkWriteDescriptorSet> {};
+    descriptorWrites.reserve(2 * frameCount);
+    for (const auto descriptorSet : descriptorSets) {
+        descriptorWrites.push_back(VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+            .pBufferInfo = &uniformBufferInfo,
+        });
+        descriptorWrites.push_back(VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = 1,
+            .dstArrayElement = 0,
+            .descriptorCount = static_cast<uint32_t>(storageBufferInfos.size()),
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = storageBufferInfos.data(),
+        });
+    }
+    vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+    m_descriptorSets = std::move(descriptorSets);
+}
@@ -0,0 +1,112 @@
+#ifndef _DRAW_CULLER_H
+#define _DRAW_CULLER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "gpu_memory_allocator.h"
+#include "indirect_draw_buffer.h"
+
+
+namespace VulkanEngine {
+
+/// @brief Culls the indexed indirect draws of an `IndirectDrawBuffer` against the view
+/// frustum with a compute shader, and compacts the draws that survive into a device-local
+/// buffer of its own, for `vkCmdDrawIndexedIndirectCount`.
+///
+/// @note The culled buffer has the same layout as the buffer of candidate draws, with a
+/// region for every frame in flight that holds the count of the surviving draws, then the
+/// draws. Every draw draws one instance, and its first instance indexes a buffer of world
+/// space bounding spheres, one `vec4` each with the radius in `w`. The frustum comes from
+/// the view projection matrix at the start of the frame's uniform buffer, so a command
+/// buffer recorded once culls against the camera of whichever frame it is submitted in.
+/// The order of the surviving draws is not kept.
+///
+/// A frame given a depth pyramid also culls the draws hidden behind the depth of the frame
+/// before it. The pyramid holds the farthest depth of each of its texels, which is the
+/// smallest one with reverse depth, and the view projection matrix it was built with
+/// follows the camera position in the uniform buffer.
+class DrawCuller final {
+    public:
+        /// @brief The number of draws every workgroup of the cull shader tests.
+        static constexpr uint32_t THREAD_COUNT = 64;
+
+        explicit DrawCuller() = delete;
+        explicit DrawCuller(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            VkPipelineCache pipelineCache,
+            std::span<const uint32_t> shaderCode,
+            const IndirectDrawBuffer& candidateDraws,
+            const VkDescriptorBufferInfo& uniformBufferInfo,
+            VkBuffer boundingSphereBuffer,
+            bool isReverseDepth
+        );
+
+        ~DrawCuller();
+
+        DrawCuller(const DrawCuller& other) = delete;
+        DrawCuller& operator=(const DrawCuller& other) = delete;
+
+        /// @brief Record culling the candidate draws of `frameIndex` into its culled region,
+        /// with the frame's uniform buffer at `uniformBufferOffset`.
+        ///
+        /// @note Must be recorded outside of a render pass. Compute shaders write the culled
+        /// draws and their count, and the barrier that hands them to the indirect draws
+        /// recorded after it is left to the caller, like the one that orders the writes of
+        /// the depth pyramid before it.
+        void record(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t uniformBufferOffset) const;
+
+        /// @brief Cull the draws of `frameIndex` against the depth pyramid `depthPyramidView`
+        /// too, or against the frustum alone when it is `VK_NULL_HANDLE`.
+        ///
+        /// @note Must only be called once the frame's previous submit has finished, and
+        /// before the commands that cull the frame are recorded.
+        void setDepthPyramid(uint32_t frameIndex, VkImageView depthPyramidView);
+
+        VkBuffer getBuffer() const;
+
+        VkDeviceSize getCountOffset(uint32_t frameIndex) const;
+
+        VkDeviceSize getDrawOffset(uint32_t frameIndex) const;
+
+        uint32_t getMaxDrawCount() const;
+    private:
+        /// @brief The offsets of a frame's regions, in 32-bit words, since the buffers are
+        /// bound whole and read as words.
+        struct PushConstants final {
+            uint32_t countOffset;
+            uint32_t drawOffset;
+            VkBool32 cullOcclusion;
+            VkBool32 isReverseDepth;
+        };
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        const IndirectDrawBuffer& m_candidateDraws;
+        bool m_isReverseDepth;
+        VkDescriptorSetLayout m_descriptorSetLayout;
+        VkPipelineLayout m_pipelineLayout;
+        VkPipeline m_pipeline;
+        VkDescriptorPool m_descriptorPool;
+        /// @brief One set for each frame in flight, since each can read a different pyramid.
+        std::vector<VkDescriptorSet> m_descriptorSets;
+        std::vector<VkImageView> m_depthPyramidViews;
+        VkBuffer m_buffer;
+        GpuAllocation m_allocation;
+
+        void createDescriptorSetLayout();
+
+        void createPipeline(VkPipelineCache pipelineCache, std::span<const uint32_t> shaderCode);
+
+        void createBuffer();
+
+        void createDescriptorSets(const VkDescriptorBufferInfo& uniformBufferInfo, VkBuffer boundingSphereBuffer);
+};
+
+}
+
+#endif // _DRAW_CULLER_H
@@ -0,0 +1,76 @@
+#include "dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+using DynamicResolution = VulkanEngine::DynamicResolution;
+
+DynamicResolution::DynamicResolution(double budgetMilliseconds, float minScale, float maxScale)
+    : m_budgetMilliseconds { budgetMilliseconds }
+    , m_minScale { minScale }
+    , m_maxScale { maxScale }
+    , m_scale { maxScale }
+    , m_averageMilliseconds {}
+    , m_heldSamples { 0 }
+{
+    if (!(budgetMilliseconds > 0.0) || !(minScale > 0.0f) || minScale > maxScale || maxScale > 1.0f) {
+        throw std::invalid_argument("dynamic resolution needs a positive budget and scales in (0, 1]!");
+    }
+}
+
+bool DynamicResolution::update(double gpuMilliseconds) {
+    if (m_averageMilliseconds.has_value()) {
+        m_averageMilliseconds = *m_averageMilliseconds + SMOOTHING * (gpuMilliseconds - *m_averageMilliseconds);
+    } else {
+        m_averageMilliseconds = gpuMilliseconds;
+    }
+
+    if (m_heldSamples > 0) {
+        m_heldSamples--;
+
+        return false;
+    }
+
+    const auto averageMilliseconds = *m_averageMilliseconds;
+    const auto isOverBudget = averageMilliseconds > m_budgetMilliseconds;
+    const auto hasHeadroom = averageMilliseconds < UPSCALE_FRACTION * m_budgetMilliseconds;
+    if (!(isOverBudget || hasHeadroom) || !(averageMilliseconds > 0.0)) {
+        return false;
+    }
+
+    const auto idealScale = m_scale * static_cast<float>(std::sqrt(TARGET_FRACTION * m_budgetMilliseconds / averageMilliseconds));
+    const auto steppedScale = std::clamp(idealScale, m_scale - MAX_STEP, m_scale + MAX_STEP);
+    const auto roundedScale = std::round(steppedScale / GRANULARITY) * GRANULARITY;
+    const auto scale = std::clamp(roundedScale, m_minScale, m_maxScale);
+    if (scale == m_scale) {
+        return false;
+    }
+
+    m_scale = scale;
+    m_heldSamples = HOLD_SAMPLES;
+
+    return true;
+}
+
+float DynamicResolution::getScale() const {
+    return m_scale;
+}
+
+VkExtent2D DynamicResolution::getRenderExtent(VkExtent2D extent) const {
+    const auto scaleDimension = [this](uint32_t dimension) -> uint32_t {
+        const auto scaledDimension = static_cast<uint32_t>(std::lround(static_cast<float>(dimension) * m_scale));
+
+        return std::clamp(scaledDimension, 1u, dimension);
+    };
+
+    return VkExtent2D {
+        .width = scaleDimension(extent.width),
+        .height = scaleDimension(extent.height),
+    };
+}
+
+float DynamicResolution::getLodBias() const {
+    return std::log2(m_scale);
+}
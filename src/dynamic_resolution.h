@@ -0,0 +1,59 @@
+#ifndef _DYNAMIC_RESOLUTION_H
+#define _DYNAMIC_RESOLUTION_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <optional>
+
+
+namespace VulkanEngine {
+
+/// @brief Picks the scale a frame is rendered at, so that its GPU time stays within a
+/// budget.
+///
+/// @note The GPU time of a frame is taken to grow with its pixel count, so with the square
+/// of the scale, and every update moves the scale toward the one that would land on
+/// `TARGET_FRACTION` of the budget. Frame times are smoothed first, and the scale only
+/// moves once the smoothed time leaves the band between `UPSCALE_FRACTION` of the budget
+/// and the whole budget, so it does not chase noise. Every change is at most `MAX_STEP`,
+/// is rounded to `GRANULARITY`, and holds for `HOLD_SAMPLES` samples, which covers the
+/// frames in flight that were rendered at the old scale by the time their times come in.
+class DynamicResolution final {
+    public:
+        static constexpr double TARGET_FRACTION = 0.9;
+        static constexpr double UPSCALE_FRACTION = 0.75;
+        static constexpr double SMOOTHING = 0.2;
+        static constexpr float MAX_STEP = 0.1f;
+        static constexpr float GRANULARITY = 1.0f / 32.0f;
+        static constexpr uint32_t HOLD_SAMPLES = 8;
+
+        explicit DynamicResolution() = delete;
+        explicit DynamicResolution(double budgetMilliseconds, float minScale, float maxScale);
+
+        DynamicResolution(const DynamicResolution& other) = delete;
+        DynamicResolution& operator=(const DynamicResolution& other) = delete;
+
+        /// @brief Take the GPU time of a frame, and return whether the scale changed.
+        bool update(double gpuMilliseconds);
+
+        float getScale() const;
+
+        /// @brief The extent a frame that is shown at `extent` is rendered at.
+        VkExtent2D getRenderExtent(VkExtent2D extent) const;
+
+        /// @brief The bias that samples textures at the mip levels the shown extent would
+        /// pick, rather than the ones of the smaller rendered extent.
+        float getLodBias() const;
+    private:
+        double m_budgetMilliseconds;
+        float m_minScale;
+        float m_maxScale;
+        float m_scale;
+        std::optional<double> m_averageMilliseconds;
+        uint32_t m_heldSamples;
+};
+
+}
+
+#endif // _DYNAMIC_RESOLUTION_H
@@ -3,45 +3,90 @@
 
 using QueueFamilyIndices = VulkanEngine::QueueFamilyIndices;
 using SwapChainSupportDetails = VulkanEngine::SwapChainSupportDetails;
+using PresentModePolicy = VulkanEngine::PresentModePolicy;
+using SwapChainImageCountPolicy = VulkanEngine::SwapChainImageCountPolicy;
+using StartupTimeline = VulkanEngine::StartupTimeline;
 
-
-using VulkanInstanceProperties = VulkanEngine::VulkanInstanceProperties;
-
-VulkanInstanceProperties::VulkanInstanceProperties(std::vector<VkLayerProperties> availableLayers, std::vector<VkExtensionProperties> availableExtensions) 
-    : m_availableLayers { availableLayers }
-    , m_availableExtensions { availableExtensions }
-{
-    for (const auto& layerProperties : availableLayers) {
-        if (strcmp(layerProperties.layerName, Constants::VK_LAYER_KHRONOS_validation.data()) == 0) {
-            m_validationLayersAvailable = true;
+void QueueFamilyIndices::selectGraphicsAndPresentFamilies(
+    std::span<const VkQueueFamilyProperties> queueFamilies,
+    const std::function<bool(uint32_t)>& supportsPresent
+) {
+    for (uint32_t i = 0; i < queueFamilies.size(); i++) {
+        const auto isGraphicsAndCompute = (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamilies[i].queueFlags & VK_QUEUE_COMPUTE_BIT);
+        const auto isPresent = supportsPresent(i);
+        if (isGraphicsAndCompute && isPresent) {
+            graphicsAndComputeFamily = i;
+            presentFamily = i;
+            return;
         }
-    }
 
-    for (const auto& extensionProperties : availableExtensions) {
-        if (strcmp(extensionProperties.extensionName, VK_EXT_DEBUG_UTILS_EXTENSION_NAME) == 0) {
-            m_debugUtilsAvailable = true;
+        if (isGraphicsAndCompute && !graphicsAndComputeFamily.has_value()) {
+            graphicsAndComputeFamily = i;
+        }
+        if (isPresent && !presentFamily.has_value()) {
+            presentFamily = i;
         }
     }
 }
 
-bool VulkanInstanceProperties::isExtensionAvailable(const char* layerName) const {
-    for (const auto& layerProperties : m_availableLayers) {
-        if (strcmp(layerProperties.layerName, layerName) == 0) {
-            return true;
+void QueueFamilyIndices::selectDedicatedFamilies(std::span<const VkQueueFamilyProperties> queueFamilies) {
+    for (uint32_t i = 0; i < queueFamilies.size(); i++) {
+        const auto& queueFamily = queueFamilies[i];
+        const auto isTransferOnly = (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && 
+            !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && 
+            !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT);
+        const auto isComputeOnly = (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && 
+            !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT);
+        if (isTransferOnly && !transferFamily.has_value()) {
+            transferFamily = i;
+        }
+        if (isComputeOnly && !computeFamily.has_value()) {
+            computeFamily = i;
         }
     }
+}
+
+QueueFamilyIndices QueueFamilyIndices::find(VkPhysicalDevice physicalDevice, const std::function<bool(uint32_t)>& supportsPresent) {
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+    auto queueFamilies = std::vector<VkQueueFamilyProperties> { queueFamilyCount };
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    auto indices = QueueFamilyIndices {};
+    indices.selectGraphicsAndPresentFamilies(queueFamilies, supportsPresent);
+    indices.selectDedicatedFamilies(queueFamilies);
 
-    return false;
+    return indices;
 }
 
-bool VulkanInstanceProperties::isLayerAvailable(const char* extensionName) const {
+
+using VulkanInstanceProperties = VulkanEngine::VulkanInstanceProperties;
+
+VulkanInstanceProperties::VulkanInstanceProperties(std::vector<VkLayerProperties> availableLayers, std::vector<VkExtensionProperties> availableExtensions)
+    : m_availableLayers { availableLayers }
+    , m_availableExtensions { availableExtensions }
+    , m_layerNames {}
+    , m_extensionNames {}
+{
+    for (const auto& layerProperties : m_availableLayers) {
+        m_layerNames.emplace(layerProperties.layerName);
+    }
+
     for (const auto& extensionProperties : m_availableExtensions) {
-        if (strcmp(extensionProperties.extensionName, extensionName) == 0) {
-            return true;
-        }
+        m_extensionNames.emplace(extensionProperties.extensionName);
     }
 
-    return false;
+    m_validationLayersAvailable = m_layerNames.contains(Constants::VK_LAYER_KHRONOS_validation);
+    m_debugUtilsAvailable = m_extensionNames.contains(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+}
+
+bool VulkanInstanceProperties::isExtensionAvailable(const std::string& extensionName) const {
+    return m_extensionNames.contains(extensionName);
+}
+
+bool VulkanInstanceProperties::isLayerAvailable(const std::string& layerName) const {
+    return m_layerNames.contains(layerName);
 }
 
 const std::vector<VkLayerProperties>& VulkanInstanceProperties::getAvailableLayers() const {
@@ -55,7 +100,7 @@ const std::vector<VkExtensionProperties>& VulkanInstanceProperties::getAvailable
 bool VulkanInstanceProperties::areValidationLayersAvailable() const {
     return m_validationLayersAvailable;
 }
-    
+
 bool VulkanInstanceProperties::areDebugUtilsAvailable() const {
     return m_debugUtilsAvailable;
 }
@@ -64,14 +109,22 @@ bool VulkanInstanceProperties::areDebugUtilsAvailable() const {
 using PhysicalDeviceProperties = VulkanEngine::PhysicalDeviceProperties;
 
 PhysicalDeviceProperties::PhysicalDeviceProperties(std::vector<VkExtensionProperties> deviceExtensions)
-    : m_deviceExtensions { deviceExtensions } 
+    : m_deviceExtensions { deviceExtensions }
+    , m_extensionNames {}
 {
+    for (const auto& extensionProperties : m_deviceExtensions) {
+        m_extensionNames.emplace(extensionProperties.extensionName);
+    }
 }
 
 const std::vector<VkExtensionProperties>& PhysicalDeviceProperties::getExtensions() const {
     return m_deviceExtensions;
 }
 
+bool PhysicalDeviceProperties::isExtensionAvailable(const std::string& extensionName) const {
+    return m_extensionNames.contains(extensionName);
+}
+
 
 #ifndef GLFW_INCLUDE_VULKAN
 #define GLFW_INCLUDE_VULKAN
@@ -82,12 +135,12 @@ using VulkanInstanceProperties = VulkanEngine::VulkanInstanceProperties;
 using PhysicalDeviceProperties = VulkanEngine::PhysicalDeviceProperties;
 
 
-VulkanInstanceProperties VulkanEngine::PlatformInfoProvider::getVulkanInstanceInfo() const {
-    auto availableLayers = this->getAvailableVulkanInstanceLayers();
-    auto availableExtensions = this->getAvailableVulkanInstanceExtensions();    
-    auto instanceInfo = VulkanInstanceProperties { availableLayers, availableExtensions };
+const VulkanInstanceProperties& VulkanEngine::PlatformInfoProvider::getVulkanInstanceInfo() const {
+    if (!m_instanceInfo.has_value()) {
+        m_instanceInfo.emplace(this->getAvailableVulkanInstanceLayers(), this->getAvailableVulkanInstanceExtensions());
+    }
 
-    return instanceInfo;
+    return *m_instanceInfo;
 }
 
 std::vector<std::string> VulkanEngine::PlatformInfoProvider::getWindowSystemInstanceExtensions() const {
@@ -101,9 +154,14 @@ std::vector<std::string> VulkanEngine::PlatformInfoProvider::getWindowSystemInst
     return requiredExtensions;
 }
 
-PhysicalDeviceProperties VulkanEngine::PlatformInfoProvider::getAvailableVulkanDeviceExtensions(
+const PhysicalDeviceProperties& VulkanEngine::PlatformInfoProvider::getAvailableVulkanDeviceExtensions(
     VkPhysicalDevice physicalDevice
 ) const {
+    const auto found = m_deviceExtensions.find(physicalDevice);
+    if (found != m_deviceExtensions.end()) {
+        return found->second;
+    }
+
     auto deviceExtensionProperties =  std::vector<VkExtensionProperties> {};
     uint32_t numInstanceExtensions = 0;
     vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &numInstanceExtensions, nullptr);
@@ -111,44 +169,94 @@ PhysicalDeviceProperties VulkanEngine::PlatformInfoProvider::getAvailableVulkanD
         deviceExtensionProperties.resize(numInstanceExtensions);
         vkEnumerateDeviceExtensionProperties(
             physicalDevice,
-            nullptr, 
-            &numInstanceExtensions, 
+            nullptr,
+            &numInstanceExtensions,
             deviceExtensionProperties.data()
         );
     }
 
-    return PhysicalDeviceProperties(deviceExtensionProperties);
+    const auto [inserted, _] = m_deviceExtensions.try_emplace(physicalDevice, deviceExtensionProperties);
+
+    return inserted->second;
 }
 
-std::vector<VkLayerProperties> VulkanEngine::PlatformInfoProvider::getAvailableVulkanInstanceLayers() const {
+const std::vector<VkLayerProperties>& VulkanEngine::PlatformInfoProvider::getAvailableVulkanInstanceLayers() const {
+    if (m_instanceLayers.has_value()) {
+        return *m_instanceLayers;
+    }
+
     auto instanceLayerProperties = std::vector<VkLayerProperties> {};
     uint32_t numInstanceExtensions = 0;
     vkEnumerateInstanceLayerProperties(&numInstanceExtensions, nullptr);
     if (numInstanceExtensions > 0) {
         instanceLayerProperties.resize(numInstanceExtensions);
         vkEnumerateInstanceLayerProperties(
-            &numInstanceExtensions, 
+            &numInstanceExtensions,
             instanceLayerProperties.data()
         );
     }
 
-    return instanceLayerProperties;
+    m_instanceLayers = std::move(instanceLayerProperties);
+
+    return *m_instanceLayers;
+}
+
+const std::vector<VkExtensionProperties>& VulkanEngine::PlatformInfoProvider::getAvailableVulkanLayerExtensions(const std::string& layerName) const {
+    const auto found = m_layerExtensions.find(layerName);
+    if (found != m_layerExtensions.end()) {
+        return found->second;
+    }
+
+    auto layerExtensionProperties = std::vector<VkExtensionProperties> {};
+    uint32_t numLayerExtensions = 0;
+    vkEnumerateInstanceExtensionProperties(layerName.data(), &numLayerExtensions, nullptr);
+    if (numLayerExtensions > 0) {
+        layerExtensionProperties.resize(numLayerExtensions);
+        vkEnumerateInstanceExtensionProperties(
+            layerName.data(),
+            &numLayerExtensions,
+            layerExtensionProperties.data()
+        );
+    }
+
+    const auto [inserted, _] = m_layerExtensions.try_emplace(layerName, std::move(layerExtensionProperties));
+
+    return inserted->second;
 }
 
-std::vector<VkExtensionProperties> VulkanEngine::PlatformInfoProvider::getAvailableVulkanInstanceExtensions() const {
+const std::vector<VkExtensionProperties>& VulkanEngine::PlatformInfoProvider::getAvailableVulkanInstanceExtensions() const {
+    if (m_instanceExtensions.has_value()) {
+        return *m_instanceExtensions;
+    }
+
     auto instanceExtensionProperties = std::vector<VkExtensionProperties> {};
     uint32_t numInstanceExtensions = 0;
     vkEnumerateInstanceExtensionProperties(nullptr, &numInstanceExtensions, nullptr);
     if (numInstanceExtensions > 0) {
         instanceExtensionProperties.resize(numInstanceExtensions);
         vkEnumerateInstanceExtensionProperties(
-            nullptr, 
-            &numInstanceExtensions, 
+            nullptr,
+            &numInstanceExtensions,
             instanceExtensionProperties.data()
         );
     }
 
-    return instanceExtensionProperties;
+    m_instanceExtensions = std::move(instanceExtensionProperties);
+
+    return *m_instanceExtensions;
+}
+
+bool VulkanEngine::PlatformInfoProvider::isInstanceExtensionAvailable(const std::string& extensionName) const {
+    if (!m_instanceExtensionNames.has_value()) {
+        auto instanceExtensionNames = std::unordered_set<std::string> {};
+        for (const auto& extensionProperties : this->getAvailableVulkanInstanceExtensions()) {
+            instanceExtensionNames.emplace(extensionProperties.extensionName);
+        }
+
+        m_instanceExtensionNames = std::move(instanceExtensionNames);
+    }
+
+    return m_instanceExtensionNames->contains(extensionName);
 }
 
 std::vector<std::string> VulkanEngine::PlatformInfoProvider::detectMissingInstanceExtensions(
@@ -156,17 +264,8 @@ std::vector<std::string> VulkanEngine::PlatformInfoProvider::detectMissingInstan
     const std::vector<std::string>& instanceExtensions
 ) const {
     auto missingInstanceExtensions = std::vector<std::string> {};
-    auto availableInstanceExtensions = instanceInfo.getAvailableExtensions();
     for (const auto& extensionName : instanceExtensions) {
-        auto found = std::find_if(
-            std::begin(availableInstanceExtensions),
-            std::end(availableInstanceExtensions),
-            [extensionName](const auto& extension) {
-                return strcmp(extensionName.data(), extension.extensionName) == 0;
-            }
-        );
-        auto extensionNotFound = (found == std::end(availableInstanceExtensions));
-        if (extensionNotFound) {
+        if (!instanceInfo.isExtensionAvailable(extensionName)) {
             missingInstanceExtensions.emplace_back(extensionName);
         }
     }
@@ -179,17 +278,8 @@ std::vector<std::string> VulkanEngine::PlatformInfoProvider::detectMissingInstan
     const std::vector<std::string>& instanceLayers
 ) const {
     auto missingInstanceLayers = std::vector<std::string> {};
-    auto availableInstanceLayers = instanceInfo.getAvailableLayers();
     for (const auto& layerName : instanceLayers) {
-        auto found = std::find_if(
-            std::begin(availableInstanceLayers),
-            std::end(availableInstanceLayers),
-            [layerName](const auto& layer) {
-                return strcmp(layerName.data(), layer.layerName) == 0;
-            }
-        );
-        auto layerNotFound = (found == std::end(availableInstanceLayers));
-        if (layerNotFound) {
+        if (!instanceInfo.isLayerAvailable(layerName)) {
             missingInstanceLayers.emplace_back(layerName);
         }
     }
@@ -203,15 +293,7 @@ std::vector<std::string> VulkanEngine::PlatformInfoProvider::detectMissingRequir
 ) const {
     auto missingExtensions = std::vector<std::string> {};
     for (const auto& requiredExtension : requiredExtensions) {
-        auto found = std::find_if(
-            std::begin(requiredExtensions),
-            std::end(requiredExtensions),
-            [requiredExtension](const auto& extension) {
-            return strcmp(requiredExtension.data(), extension.data()) == 0;
-            }
-        );
-        auto extensionNotFound = (found == std::end(requiredExtensions));
-        if (extensionNotFound) {
+        if (!physicalDeviceProperties.isExtensionAvailable(requiredExtension)) {
             missingExtensions.emplace_back(requiredExtension);
         }
     }
@@ -220,7 +302,7 @@ std::vector<std::string> VulkanEngine::PlatformInfoProvider::detectMissingRequir
 }
 
 bool VulkanEngine::PlatformInfoProvider::areValidationLayersSupported() const {
-    auto instanceInfo = this->getVulkanInstanceInfo();
+    const auto& instanceInfo = this->getVulkanInstanceInfo();
 
     return instanceInfo.areValidationLayersAvailable();
 }
@@ -231,12 +313,14 @@ using VulkanInstanceSpec = VulkanEngine::VulkanInstanceSpec;
 VulkanEngine::VulkanInstanceSpec::VulkanInstanceSpec(
     std::vector<std::string> instanceExtensions,
     std::vector<std::string> instanceLayers,
+    std::vector<VkValidationFeatureEnableEXT> validationFeatures,
     VkInstanceCreateFlags instanceCreateFlags,
     std::string applicationName,
     std::string engineName
 ) 
     : m_instanceExtensions { instanceExtensions }
     , m_instanceLayers { instanceLayers }
+    , m_validationFeatures { validationFeatures }
     , m_instanceCreateFlags { instanceCreateFlags }
     , m_applicationName { applicationName }
     , m_engineName { engineName }
@@ -251,6 +335,10 @@ const std::vector<std::string>& VulkanInstanceSpec::instanceLayers() const {
     return m_instanceLayers;
 }
 
+const std::vector<VkValidationFeatureEnableEXT>& VulkanInstanceSpec::validationFeatures() const {
+    return m_validationFeatures;
+}
+
 VkInstanceCreateFlags VulkanInstanceSpec::instanceCreateFlags() const {
     return m_instanceCreateFlags;
 }
@@ -276,20 +364,33 @@ bool VulkanInstanceSpec::areValidationLayersEnabled() const {
 
 using InstanceSpecProvider = VulkanEngine::InstanceSpecProvider;
 
-InstanceSpecProvider::InstanceSpecProvider(bool enableValidationLayers, bool enableDebuggingExtensions)
+InstanceSpecProvider::InstanceSpecProvider(
+    bool enableValidationLayers,
+    bool enableGpuAssistedValidation,
+    bool enableDebuggingExtensions,
+    bool isHeadless,
+    bool isSwapChainColorSpaceAvailable
+)
     : m_enableValidationLayers { enableValidationLayers }
+    , m_enableGpuAssistedValidation { enableGpuAssistedValidation }
     , m_enableDebuggingExtensions { enableDebuggingExtensions }
+    , m_isHeadless { isHeadless }
+    , m_isSwapChainColorSpaceAvailable { isSwapChainColorSpaceAvailable }
 {
 }
 
 InstanceSpecProvider::~InstanceSpecProvider() {
     m_enableValidationLayers = false;
+    m_enableGpuAssistedValidation = false;
     m_enableDebuggingExtensions = false;
+    m_isHeadless = false;
+    m_isSwapChainColorSpaceAvailable = false;
 }
 
 VulkanInstanceSpec InstanceSpecProvider::createInstanceSpec() const {
     const auto instanceExtensions = this->getInstanceExtensions();
     const auto instanceLayers = this->getInstanceLayers();
+    const auto validationFeatures = this->getValidationFeatures();
     const auto instanceCreateFlags = this->minInstanceCreateFlags();
     const auto applicationName = std::string { "" };
     const auto engineName = std::string { "" };
@@ -297,6 +398,7 @@ VulkanInstanceSpec InstanceSpecProvider::createInstanceSpec() const {
     return VulkanInstanceSpec {
         instanceExtensions,
         instanceLayers,
+        validationFeatures,
         instanceCreateFlags,
         applicationName,
         engineName
@@ -313,6 +415,11 @@ VkInstanceCreateFlags InstanceSpecProvider::minInstanceCreateFlags() const {
 }
 
 std::vector<std::string> InstanceSpecProvider::getWindowSystemInstanceRequirements() const {        
+    // GLFW is never initialized without a window system.
+    if (m_isHeadless) {
+        return std::vector<std::string> {};
+    }
+
     uint32_t requiredExtensionCount = 0;
     const char** requiredExtensionNames = glfwGetRequiredInstanceExtensions(&requiredExtensionCount);
     auto requiredExtensions = std::vector<std::string> {};
@@ -331,6 +438,17 @@ std::vector<std::string> InstanceSpecProvider::getInstanceExtensions() const {
         instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
 
+    // The validation layer provides this extension itself.
+    if (m_enableValidationLayers && m_enableGpuAssistedValidation) {
+        instanceExtensions.push_back(VK_EXT_VALIDATION_FEATURES_EXTENSION_NAME);
+    }
+
+    // Surfaces only report the HDR color spaces with this extension, which is optional, so
+    // it is only required where the loader has it.
+    if (!m_isHeadless && m_isSwapChainColorSpaceAvailable) {
+        instanceExtensions.push_back(VK_EXT_SWAPCHAIN_COLOR_SPACE_EXTENSION_NAME);
+    }
+
    return instanceExtensions;
 }
 
@@ -343,18 +461,50 @@ std::vector<std::string> InstanceSpecProvider::getInstanceLayers() const {
     return instanceLayers;
 }
 
+std::vector<VkValidationFeatureEnableEXT> InstanceSpecProvider::getValidationFeatures() const {
+    auto validationFeatures = std::vector<VkValidationFeatureEnableEXT> {};
+    if (m_enableValidationLayers && m_enableGpuAssistedValidation) {
+        validationFeatures.push_back(VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_EXT);
+        validationFeatures.push_back(VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_RESERVE_BINDING_SLOT_EXT);
+    }
+
+    return validationFeatures;
+}
+
 
 using SystemFactory = VulkanEngine::SystemFactory;
 
+SystemFactory::SystemFactory(
+    std::shared_ptr<PlatformInfoProvider> infoProvider,
+    const VkAllocationCallbacks* allocationCallbacks
+)
+    : m_infoProvider { std::move(infoProvider) }
+    , m_allocationCallbacks { allocationCallbacks }
+{
+}
 
 VkInstance SystemFactory::create(const VulkanInstanceSpec& instanceSpec) {
-    if (instanceSpec.areValidationLayersEnabled() && !m_infoProvider->areValidationLayersSupported()) {
+    const auto instanceExtensions = instanceSpec.instanceExtensions();
+    const auto instanceLayers = instanceSpec.instanceLayers();
+
+    // Without layers, as in release mode, the loader is never asked about layers at all.
+    // The extensions of the enabled layers count as available, since the layers provide
+    // them once they are loaded.
+    auto availableLayers = std::vector<VkLayerProperties> {};
+    auto availableExtensions = m_infoProvider->getAvailableVulkanInstanceExtensions();
+    if (!instanceLayers.empty()) {
+        availableLayers = m_infoProvider->getAvailableVulkanInstanceLayers();
+        for (const auto& layerName : instanceLayers) {
+            const auto& layerExtensions = m_infoProvider->getAvailableVulkanLayerExtensions(layerName);
+            availableExtensions.insert(availableExtensions.end(), layerExtensions.begin(), layerExtensions.end());
+        }
+    }
+
+    const auto instanceInfo = VulkanInstanceProperties { availableLayers, availableExtensions };
+    if (instanceSpec.areValidationLayersEnabled() && !instanceInfo.areValidationLayersAvailable()) {
         throw std::runtime_error("validation layers requested, but not available!");
     }
 
-    const auto instanceInfo = m_infoProvider->getVulkanInstanceInfo();
-    const auto instanceExtensions = instanceSpec.instanceExtensions();
-    const auto instanceLayers = instanceSpec.instanceLayers();
     const auto missingExtensions = m_infoProvider->detectMissingInstanceExtensions(
         instanceInfo,
         instanceExtensions
@@ -412,8 +562,18 @@ VkInstance SystemFactory::create(const VulkanInstanceSpec& instanceSpec) {
         .apiVersion = VK_API_VERSION_1_3
     };
     const auto flags = (VkInstanceCreateFlags {}) | instanceCreateFlags;
+    const auto& validationFeatures = instanceSpec.validationFeatures();
+    const auto validationFeaturesInfo = VkValidationFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_VALIDATION_FEATURES_EXT,
+        .pNext = nullptr,
+        .enabledValidationFeatureCount = static_cast<uint32_t>(validationFeatures.size()),
+        .pEnabledValidationFeatures = validationFeatures.data(),
+        .disabledValidationFeatureCount = 0,
+        .pDisabledValidationFeatures = nullptr,
+    };
     const auto createInfo = VkInstanceCreateInfo {
         .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+        .pNext = validationFeatures.empty() ? nullptr : &validationFeaturesInfo,
         .pApplicationInfo = &appInfo,
         .flags = flags,
         .enabledLayerCount = static_cast<uint32_t>(enabledLayerNames.size()),
@@ -423,7 +583,7 @@ VkInstance SystemFactory::create(const VulkanInstanceSpec& instanceSpec) {
     };
 
     auto instance = VkInstance {};
-    const auto result = vkCreateInstance(&createInfo, nullptr, &instance);
+    const auto result = vkCreateInstance(&createInfo, m_allocationCallbacks, &instance);
     if (result != VK_SUCCESS) {
         throw std::runtime_error(fmt::format("Failed to create Vulkan instance."));
     }
@@ -446,11 +606,22 @@ std::vector<const char*>  SystemFactory::convertToCStrings(const std::vector<std
 
 
 using PhysicalDeviceSpec = VulkanEngine::PhysicalDeviceSpec;
-
-PhysicalDeviceSpec::PhysicalDeviceSpec(const std::vector<std::string>& requiredExtensions, bool hasGraphicsFamily, bool hasPresentFamily)
+using FormatRequirement = VulkanEngine::FormatRequirement;
+
+PhysicalDeviceSpec::PhysicalDeviceSpec(
+    const std::vector<std::string>& requiredExtensions,
+    bool hasGraphicsFamily,
+    bool hasPresentFamily,
+    const std::vector<FormatRequirement>& preferredFormats,
+    const std::string& preferredDevice,
+    uint32_t deviceRank
+)
     : m_requiredExtensions { requiredExtensions }
     , m_hasGraphicsFamily { hasGraphicsFamily }
     , m_hasPresentFamily { hasPresentFamily }
+    , m_preferredFormats { preferredFormats }
+    , m_preferredDevice { preferredDevice }
+    , m_deviceRank { deviceRank }
 {
 }
 
@@ -466,13 +637,33 @@ bool PhysicalDeviceSpec::hasPresentFamily() const {
     return m_hasPresentFamily;
 }
 
+const std::vector<FormatRequirement>& PhysicalDeviceSpec::preferredFormats() const {
+    return m_preferredFormats;
+}
+
+const std::string& PhysicalDeviceSpec::preferredDevice() const {
+    return m_preferredDevice;
+}
+
+uint32_t PhysicalDeviceSpec::deviceRank() const {
+    return m_deviceRank;
+}
+
 
 using PhysicalDeviceSpecProvider = VulkanEngine::PhysicalDeviceSpecProvider;
 
+PhysicalDeviceSpecProvider::PhysicalDeviceSpecProvider(bool hasPresentFamily, const std::string& preferredDevice, uint32_t deviceRank)
+    : m_hasPresentFamily { hasPresentFamily }
+    , m_preferredDevice { preferredDevice }
+    , m_deviceRank { deviceRank }
+{
+}
+
 PhysicalDeviceSpec PhysicalDeviceSpecProvider::createPhysicalDeviceSpec() const {
     const auto requiredExtensions = this->getPhysicalDeviceRequirements();
+    const auto preferredFormats = this->getPreferredFormats();
 
-    return PhysicalDeviceSpec { requiredExtensions, true, true };
+    return PhysicalDeviceSpec { requiredExtensions, true, m_hasPresentFamily, preferredFormats, m_preferredDevice, m_deviceRank };
 }
 
 std::vector<std::string> PhysicalDeviceSpecProvider::getPhysicalDeviceRequirements() const {
@@ -481,15 +672,35 @@ std::vector<std::string> PhysicalDeviceSpecProvider::getPhysicalDeviceRequiremen
         physicalDeviceExtensions.push_back(VulkanEngine::Constants::VK_KHR_portability_subset);
     }
 
-    physicalDeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    if (m_hasPresentFamily) {
+        physicalDeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
 
     return physicalDeviceExtensions;
 }
 
+std::vector<FormatRequirement> PhysicalDeviceSpecProvider::getPreferredFormats() const {
+    // Textures are sampled with linear filtering and have their mip chains blitted, and the
+    // depth buffer prefers a 32-bit float format.
+    const auto textureFeatures = VkFormatFeatureFlags {
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT |
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+        VK_FORMAT_FEATURE_BLIT_DST_BIT
+    };
+
+    return std::vector<FormatRequirement> {
+        FormatRequirement { VK_FORMAT_R8G8B8A8_SRGB, textureFeatures },
+        FormatRequirement { VK_FORMAT_R8G8B8A8_UNORM, textureFeatures },
+        FormatRequirement { VK_FORMAT_D32_SFLOAT, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT },
+    };
+}
+
 
 using PhysicalDeviceSelector = VulkanEngine::PhysicalDeviceSelector;
+using PhysicalDeviceScore = VulkanEngine::PhysicalDeviceScore;
 
-PhysicalDeviceSelector::PhysicalDeviceSelector(VkInstance instance, std::unique_ptr<PlatformInfoProvider> infoProvider)
+PhysicalDeviceSelector::PhysicalDeviceSelector(VkInstance instance, std::shared_ptr<PlatformInfoProvider> infoProvider)
     : m_instance { instance }
     , m_infoProvider { std::move(infoProvider) }
 {
@@ -500,94 +711,43 @@ PhysicalDeviceSelector::~PhysicalDeviceSelector() {
     m_infoProvider = nullptr;
 }
 
-QueueFamilyIndices PhysicalDeviceSelector::findQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const {
-    uint32_t queueFamilyCount = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
-
-    auto queueFamilies = std::vector<VkQueueFamilyProperties> { queueFamilyCount };
-     vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
-
-    int i = 0;
-    auto indices = QueueFamilyIndices {};
-    for (const auto& queueFamily : queueFamilies) {
-        if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
-            indices.graphicsAndComputeFamily = i;
-        }
-
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
-
-        if (presentSupport) {
-            indices.presentFamily = i;
-        }
-
-        if (indices.isComplete()) {
-            break;
-        }
-
-        i++;
-    }
-
-    return indices;
+QueueFamilyIndices PhysicalDeviceSelector::findQueueFamilies(VkPhysicalDevice physicalDevice, bool hasPresentFamily) const {
+    return QueueFamilyIndices::find(physicalDevice, [this, physicalDevice, hasPresentFamily](uint32_t queueFamily) -> bool {
+        return hasPresentFamily && glfwGetPhysicalDevicePresentationSupport(m_instance, physicalDevice, queueFamily) == GLFW_TRUE;
+    });
 }
 
 bool PhysicalDeviceSelector::checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice, const std::vector<std::string>& requiredExtensions) const {
-    uint32_t extensionCount = 0;
-    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    const auto& deviceExtensionProperties = m_infoProvider->getAvailableVulkanDeviceExtensions(physicalDevice);
 
-    auto availableExtensions = std::vector<VkExtensionProperties> { extensionCount };
-    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
-
-    auto remainingExtensions = std::set<std::string> { requiredExtensions.begin(), requiredExtensions.end() };
-    for (const auto& extension : availableExtensions) {
-        for (const auto& requiredExtension : requiredExtensions) {
-            remainingExtensions.erase(extension.extensionName);
+    return std::all_of(
+        requiredExtensions.begin(),
+        requiredExtensions.end(),
+        [&deviceExtensionProperties](const std::string& requiredExtension) {
+            return deviceExtensionProperties.isExtensionAvailable(requiredExtension);
         }
-    }
-
-    return remainingExtensions.empty();
-}
-
-SwapChainSupportDetails PhysicalDeviceSelector::querySwapChainSupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const {
-    auto details = SwapChainSupportDetails {};
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &details.capabilities);
-
-    uint32_t formatCount = 0;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, nullptr);
-
-    if (formatCount != 0) {
-        details.formats.resize(formatCount);
-        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, details.formats.data());
-    }
-
-    uint32_t presentModeCount = 0;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, nullptr);
-
-    if (presentModeCount != 0) {
-        details.presentModes.resize(presentModeCount);
-        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, details.presentModes.data());
-    }
-
-    return details;
+    );
 }
 
-bool PhysicalDeviceSelector::isPhysicalDeviceCompatible(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const PhysicalDeviceSpec& physicalDeviceSpec) const {
-    const auto indices = this->findQueueFamilies(physicalDevice, surface);
+bool PhysicalDeviceSelector::isPhysicalDeviceCompatible(VkPhysicalDevice physicalDevice, const PhysicalDeviceSpec& physicalDeviceSpec) const {
+    // There is no surface yet, so the surface formats and present modes are only checked
+    // when the swap chain is created.
+    const auto indices = this->findQueueFamilies(physicalDevice, physicalDeviceSpec.hasPresentFamily());
     const bool areRequiredExtensionsSupported = this->checkDeviceExtensionSupport(
         physicalDevice,
         physicalDeviceSpec.requiredExtensions()
     );
 
-    bool swapChainCompatible = false;
-    if (areRequiredExtensionsSupported) {
-        SwapChainSupportDetails swapChainSupport = this->querySwapChainSupport(physicalDevice, surface);
-        swapChainCompatible = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
-    }
-
     auto supportedFeatures = VkPhysicalDeviceFeatures {};
     vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
 
-    return indices.isComplete() && areRequiredExtensionsSupported && swapChainCompatible && supportedFeatures.samplerAnisotropy;
+    // The renderer samples every texture through the global texture table.
+    const auto isDescriptorIndexingSupported = VulkanEngine::GpuDevice::isDescriptorIndexingSupported(physicalDevice);
+
+    return indices.isComplete(physicalDeviceSpec.hasPresentFamily())
+        && areRequiredExtensionsSupported
+        && supportedFeatures.samplerAnisotropy
+        && isDescriptorIndexingSupported;
 }
 
 std::vector<VkPhysicalDevice> PhysicalDeviceSelector::findAllPhysicalDevices() const {
@@ -600,7 +760,7 @@ std::vector<VkPhysicalDevice> PhysicalDeviceSelector::findAllPhysicalDevices() c
     return physicalDevices;
 }
 
-std::vector<VkPhysicalDevice> PhysicalDeviceSelector::findCompatiblePhysicalDevices(VkSurfaceKHR surface, const PhysicalDeviceSpec& physicalDeviceSpec) const {
+std::vector<VkPhysicalDevice> PhysicalDeviceSelector::findCompatiblePhysicalDevices(const PhysicalDeviceSpec& physicalDeviceSpec) const {
     const auto physicalDevices = this->findAllPhysicalDevices();
     if (physicalDevices.empty()) {
         throw std::runtime_error("failed to find GPUs with Vulkan support!");
@@ -608,7 +768,7 @@ std::vector<VkPhysicalDevice> PhysicalDeviceSelector::findCompatiblePhysicalDevi
 
     auto compatiblePhysicalDevices = std::vector<VkPhysicalDevice> {};
     for (const auto& physicalDevice : physicalDevices) {
-        if (this->isPhysicalDeviceCompatible(physicalDevice, surface, physicalDeviceSpec)) {
+        if (this->isPhysicalDeviceCompatible(physicalDevice, physicalDeviceSpec)) {
             compatiblePhysicalDevices.emplace_back(physicalDevice);
         }
     }
@@ -616,15 +776,159 @@ std::vector<VkPhysicalDevice> PhysicalDeviceSelector::findCompatiblePhysicalDevi
     return compatiblePhysicalDevices;
 }
 
-VkPhysicalDevice PhysicalDeviceSelector::selectPhysicalDeviceForSurface(VkSurfaceKHR surface, const PhysicalDeviceSpec& physicalDeviceSpec) const {
-    const auto physicalDevices = this->findCompatiblePhysicalDevices(surface, physicalDeviceSpec);
+PhysicalDeviceScore PhysicalDeviceSelector::scorePhysicalDevice(VkPhysicalDevice physicalDevice, const PhysicalDeviceSpec& physicalDeviceSpec) const {
+    auto properties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    const auto deviceTypeRank = [&properties]() -> uint32_t {
+        if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
+            return 4;
+        } else if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU) {
+            return 3;
+        } else if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU) {
+            return 2;
+        } else if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) {
+            return 1;
+        } else {
+            return 0;
+        }
+    }();
+
+    // Only the largest device-local heap counts, since that is where the images and
+    // buffers go.
+    auto memoryProperties = VkPhysicalDeviceMemoryProperties {};
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    auto deviceLocalHeapSize = VkDeviceSize { 0 };
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+        const auto& heap = memoryProperties.memoryHeaps[i];
+        if (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            deviceLocalHeapSize = std::max(deviceLocalHeapSize, heap.size);
+        }
+    }
+
+    const auto indices = this->findQueueFamilies(physicalDevice, physicalDeviceSpec.hasPresentFamily());
+
+    uint32_t supportedFormatCount = 0;
+    for (const auto& formatRequirement : physicalDeviceSpec.preferredFormats()) {
+        auto formatProperties = VkFormatProperties {};
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, formatRequirement.format, &formatProperties);
+
+        const auto features = formatProperties.optimalTilingFeatures & formatRequirement.optimalTilingFeatures;
+        if (features == formatRequirement.optimalTilingFeatures) {
+            supportedFormatCount++;
+        }
+    }
+
+    return PhysicalDeviceScore {
+        .deviceTypeRank = deviceTypeRank,
+        .deviceLocalHeapSize = deviceLocalHeapSize,
+        .dedicatedQueueFamilyCount = static_cast<uint32_t>(indices.transferFamily.has_value()) + static_cast<uint32_t>(indices.computeFamily.has_value()),
+        .supportedFormatCount = supportedFormatCount,
+    };
+}
+
+bool PhysicalDeviceSelector::matchesPreferredDevice(VkPhysicalDevice physicalDevice, const std::string& preferredDevice) const {
+    auto properties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    if (preferredDevice == properties.deviceName) {
+        return true;
+    }
+
+    auto lowerCasePreferredDevice = preferredDevice;
+    std::transform(
+        lowerCasePreferredDevice.begin(),
+        lowerCasePreferredDevice.end(),
+        lowerCasePreferredDevice.begin(),
+        [](unsigned char character) { return static_cast<char>(std::tolower(character)); }
+    );
+
+    return lowerCasePreferredDevice == PhysicalDeviceSelector::getDeviceUuid(physicalDevice);
+}
+
+VkPhysicalDevice PhysicalDeviceSelector::selectPhysicalDevice(const PhysicalDeviceSpec& physicalDeviceSpec) const {
+    const auto physicalDevices = this->findCompatiblePhysicalDevices(physicalDeviceSpec);
     if (physicalDevices.empty()) {
         throw std::runtime_error("failed to find a suitable GPU!");
     }
 
-    VkPhysicalDevice selectedPhysicalDevice = physicalDevices[0];
+    if (!physicalDeviceSpec.preferredDevice().empty()) {
+        for (const auto& physicalDevice : physicalDevices) {
+            if (this->matchesPreferredDevice(physicalDevice, physicalDeviceSpec.preferredDevice())) {
+                return physicalDevice;
+            }
+        }
+
+        throw std::runtime_error(fmt::format("failed to find a suitable GPU named {}!", physicalDeviceSpec.preferredDevice()));
+    }
+
+    if (physicalDeviceSpec.deviceRank() >= physicalDevices.size()) {
+        throw std::runtime_error(fmt::format("failed to find {} suitable GPUs!", physicalDeviceSpec.deviceRank() + 1));
+    }
+
+    // Enumeration order puts the integrated GPU first on many dual-GPU machines, so it only
+    // decides between devices that score the same.
+    auto scoredPhysicalDevices = std::vector<std::tuple<PhysicalDeviceScore, VkPhysicalDevice>> {};
+    scoredPhysicalDevices.reserve(physicalDevices.size());
+    for (const auto& physicalDevice : physicalDevices) {
+        scoredPhysicalDevices.emplace_back(this->scorePhysicalDevice(physicalDevice, physicalDeviceSpec), physicalDevice);
+    }
+
+    std::stable_sort(
+        scoredPhysicalDevices.begin(),
+        scoredPhysicalDevices.end(),
+        [](const auto& left, const auto& right) { return std::get<0>(left) > std::get<0>(right); }
+    );
+
+    return std::get<1>(scoredPhysicalDevices[physicalDeviceSpec.deviceRank()]);
+}
+
+std::vector<VkPhysicalDevice> PhysicalDeviceSelector::findDeviceGroup(VkPhysicalDevice physicalDevice) const {
+    uint32_t deviceGroupCount = 0;
+    vkEnumeratePhysicalDeviceGroups(m_instance, &deviceGroupCount, nullptr);
+
+    auto deviceGroups = std::vector<VkPhysicalDeviceGroupProperties>(
+        deviceGroupCount,
+        VkPhysicalDeviceGroupProperties { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GROUP_PROPERTIES, .pNext = nullptr }
+    );
+    vkEnumeratePhysicalDeviceGroups(m_instance, &deviceGroupCount, deviceGroups.data());
+
+    for (const auto& deviceGroup : deviceGroups) {
+        const auto groupBegin = deviceGroup.physicalDevices;
+        const auto groupEnd = deviceGroup.physicalDevices + deviceGroup.physicalDeviceCount;
+        if (std::find(groupBegin, groupEnd, physicalDevice) == groupEnd) {
+            continue;
+        }
+
+        if (deviceGroup.physicalDeviceCount > 1) {
+            return std::vector<VkPhysicalDevice> { groupBegin, groupEnd };
+        }
+    }
+
+    return std::vector<VkPhysicalDevice> {};
+}
+
+std::string PhysicalDeviceSelector::getDeviceUuid(VkPhysicalDevice physicalDevice) {
+    auto idProperties = VkPhysicalDeviceIDProperties {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+        .pNext = nullptr,
+    };
+    auto properties = VkPhysicalDeviceProperties2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &idProperties,
+    };
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    // The usual 8-4-4-4-12 grouping of the 16 bytes.
+    auto uuid = std::string {};
+    for (uint32_t i = 0; i < VK_UUID_SIZE; i++) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            uuid += '-';
+        }
+        uuid += fmt::format("{:02x}", idProperties.deviceUUID[i]);
+    }
 
-    return selectedPhysicalDevice;
+    return uuid;
 }
 
 
@@ -647,15 +951,14 @@ bool LogicalDeviceSpec::requireSamplerAnisotropy() const {
 
 using LogicalDeviceSpecProvider = VulkanEngine::LogicalDeviceSpecProvider;
 
-LogicalDeviceSpecProvider::LogicalDeviceSpecProvider(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) 
+LogicalDeviceSpecProvider::LogicalDeviceSpecProvider(VkPhysicalDevice physicalDevice, bool isHeadless) 
     : m_physicalDevice { physicalDevice }
-    , m_surface { surface }
+    , m_isHeadless { isHeadless }
 {
 }
 
 LogicalDeviceSpecProvider::~LogicalDeviceSpecProvider() {
     m_physicalDevice = VK_NULL_HANDLE;
-    m_surface = VK_NULL_HANDLE;
 }
 
 LogicalDeviceSpec LogicalDeviceSpecProvider::createLogicalDeviceSpec() const {
@@ -671,96 +974,176 @@ std::vector<std::string> LogicalDeviceSpecProvider::getLogicalDeviceRequirements
         logicalDeviceExtensions.push_back(VulkanEngine::Constants::VK_KHR_portability_subset);
     }
 
-    logicalDeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    // A headless device presents nothing.
+    if (!m_isHeadless) {
+        logicalDeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
 
-    return logicalDeviceExtensions;
-}
+    // Mesh shading is optional, so it is only required of devices that have it, and the
+    // renderer falls back to the vertex pipeline everywhere else.
+    if (VulkanEngine::GpuDevice::isMeshShadingSupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+    }
 
+    // Present waits are optional in the same way, and only measure and bound latency.
+    if (!m_isHeadless && VulkanEngine::GpuDevice::isPresentWaitSupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        logicalDeviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    }
 
-using LogicalDeviceFactory = VulkanEngine::LogicalDeviceFactory;
+    // Descriptor buffers are optional as well, and the renderer falls back to descriptor
+    // sets without them.
+    if (VulkanEngine::GpuDevice::isDescriptorBufferSupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+    }
 
-LogicalDeviceFactory::LogicalDeviceFactory(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, std::unique_ptr<PlatformInfoProvider> infoProvider)
-    : m_physicalDevice { physicalDevice }
-    , m_surface { surface }
-    , m_infoProvider { std::move(infoProvider) }
-{
-}
+    // So are graphics pipeline libraries. Without them pipelines are built in one piece.
+    if (VulkanEngine::GpuDevice::isGraphicsPipelineLibrarySupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+        logicalDeviceExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+    }
 
-LogicalDeviceFactory::~LogicalDeviceFactory() {
-    m_physicalDevice = VK_NULL_HANDLE;
-    m_surface = VK_NULL_HANDLE;
-    m_infoProvider = nullptr;
-}
+    // Variable rate shading is optional as well. Without it every fragment is shaded.
+    if (VulkanEngine::GpuDevice::isFragmentShadingRateSupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME);
+    }
 
-QueueFamilyIndices LogicalDeviceFactory::findQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const {
-    auto indices = QueueFamilyIndices {};
+    // So is conditional rendering. Without it every draw is recorded unconditionally.
+    if (VulkanEngine::GpuDevice::isConditionalRenderingSupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME);
+    }
 
-    uint32_t queueFamilyCount = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    // And so are the vendor's performance counters. Without them the GPU profiler only
+    // collects timestamps and pipeline statistics.
+    if (VulkanEngine::GpuDevice::isPerformanceQuerySupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_KHR_PERFORMANCE_QUERY_EXTENSION_NAME);
+    }
 
-    auto queueFamilies = std::vector<VkQueueFamilyProperties> { queueFamilyCount };
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+    // Memory budgets are optional too. Without them the allocator estimates its own.
+    if (VulkanEngine::GpuDevice::isMemoryBudgetSupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
 
-    int i = 0;
-    for (const auto& queueFamily : queueFamilies) {
-        if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
-            indices.graphicsAndComputeFamily = i;
-        }
+    // So are memory priorities, and device local memory the driver may page out. Without
+    // them the driver picks what to evict when the device runs out of memory.
+    if (VulkanEngine::GpuDevice::isMemoryPrioritySupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME);
+    }
 
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
+    if (VulkanEngine::GpuDevice::isPageableDeviceLocalMemorySupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_EXTENSION_NAME);
+    }
 
-        if (presentSupport) {
-            indices.presentFamily = i;
-        }
+    // So is exporting memory and semaphores. Without it frames cannot be handed to an
+    // external encoder.
+    if (VulkanEngine::GpuDevice::isExternalMemoryFdSupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME);
+        logicalDeviceExtensions.push_back(VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME);
+    }
 
-        if (indices.isComplete()) {
-            break;
-        }
+    // Host image copies are optional as well. Without them textures go through the
+    // staging ring.
+    if (VulkanEngine::GpuDevice::isHostImageCopySupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME);
+    }
 
-        i++;
+    // So are push descriptors. Without them the compute passes allocate a set for every
+    // dispatch.
+    if (VulkanEngine::GpuDevice::isPushDescriptorSupported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
     }
 
-    return indices;
+    // And so is the fifth maintenance extension. Without it every pipeline stage takes a
+    // shader module.
+    if (VulkanEngine::GpuDevice::isMaintenance5Supported(m_physicalDevice)) {
+        logicalDeviceExtensions.push_back(VK_KHR_MAINTENANCE_5_EXTENSION_NAME);
+    }
+
+    return logicalDeviceExtensions;
 }
 
-SwapChainSupportDetails LogicalDeviceFactory::querySwapChainSupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const {
-    auto details = SwapChainSupportDetails {};
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &details.capabilities);
 
-    uint32_t formatCount = 0;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, nullptr);
+using LogicalDeviceFactory = VulkanEngine::LogicalDeviceFactory;
 
-    if (formatCount != 0) {
-        details.formats.resize(formatCount);
-        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, details.formats.data());
-    }
+LogicalDeviceFactory::LogicalDeviceFactory(
+    VkInstance instance,
+    VkPhysicalDevice physicalDevice,
+    bool isHeadless,
+    const std::vector<VkPhysicalDevice>& deviceGroup,
+    std::shared_ptr<PlatformInfoProvider> infoProvider,
+    const VkAllocationCallbacks* allocationCallbacks
+)
+    : m_instance { instance }
+    , m_physicalDevice { physicalDevice }
+    , m_isHeadless { isHeadless }
+    , m_deviceGroup { deviceGroup }
+    , m_infoProvider { std::move(infoProvider) }
+    , m_allocationCallbacks { allocationCallbacks }
+{
+}
 
-    uint32_t presentModeCount = 0;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, nullptr);
+LogicalDeviceFactory::~LogicalDeviceFactory() {
+    m_instance = VK_NULL_HANDLE;
+    m_physicalDevice = VK_NULL_HANDLE;
+    m_infoProvider = nullptr;
+    m_allocationCallbacks = nullptr;
+}
 
-    if (presentModeCount != 0) {
-        details.presentModes.resize(presentModeCount);
-        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, details.presentModes.data());
+QueueFamilyIndices LogicalDeviceFactory::findQueueFamilies(VkPhysicalDevice physicalDevice) const {
+    return QueueFamilyIndices::find(physicalDevice, [this, physicalDevice](uint32_t queueFamily) -> bool {
+        return !m_isHeadless && glfwGetPhysicalDevicePresentationSupport(m_instance, physicalDevice, queueFamily) == GLFW_TRUE;
+    });
+}
+
+std::tuple<VkDevice, VkQueue, VkQueue, VkQueue, VkQueue> LogicalDeviceFactory::createLogicalDevice(const LogicalDeviceSpec& logicalDeviceSpec) {
+    const auto indices = this->findQueueFamilies(m_physicalDevice);
+    auto uniqueQueueFamilies = std::set<uint32_t> { indices.graphicsAndComputeFamily.value() };
+    if (indices.presentFamily.has_value()) {
+        uniqueQueueFamilies.insert(indices.presentFamily.value());
+    }
+    if (indices.transferFamily.has_value()) {
+        uniqueQueueFamilies.insert(indices.transferFamily.value());
+    }
+    if (indices.computeFamily.has_value()) {
+        uniqueQueueFamilies.insert(indices.computeFamily.value());
     }
 
-    return details;
-}
+    // Without a compute-only family, async compute gets a second queue of the graphics
+    // family when the device exposes one. Only if neither exists does it alias the graphics
+    // queue.
+    const auto computeQueueIndex = [this, &indices]() -> uint32_t {
+        if (indices.computeFamily.has_value()) {
+            return 0;
+        }
 
-std::tuple<VkDevice, VkQueue, VkQueue, VkQueue> LogicalDeviceFactory::createLogicalDevice(const LogicalDeviceSpec& logicalDeviceSpec) {
-    const auto indices = this->findQueueFamilies(m_physicalDevice, m_surface);
-    const auto uniqueQueueFamilies = std::set<uint32_t> {
-        indices.graphicsAndComputeFamily.value(), 
-        indices.presentFamily.value()
-    };
-    const float queuePriority = 1.0f;
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, nullptr);
+
+        auto queueFamilies = std::vector<VkQueueFamilyProperties> { queueFamilyCount };
+        vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+        if (queueFamilies[indices.graphicsAndComputeFamily.value()].queueCount > 1) {
+            return 1;
+        } else {
+            return 0;
+        }
+    }();
+
+    const float queuePriorities[] = { 1.0f, 1.0f };
     auto queueCreateInfos = std::vector<VkDeviceQueueCreateInfo> {};
     for (uint32_t queueFamily : uniqueQueueFamilies) {
+        const auto queueCount = [&indices, queueFamily, computeQueueIndex]() -> uint32_t {
+            if (queueFamily == indices.graphicsAndComputeFamily.value()) {
+                return computeQueueIndex + 1;
+            } else {
+                return 1;
+            }
+        }();
         const auto queueCreateInfo = VkDeviceQueueCreateInfo {
             .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
             .queueFamilyIndex = queueFamily,
-            .queueCount = 1,
-            .pQueuePriorities = &queuePriority,
+            .queueCount = queueCount,
+            .pQueuePriorities = queuePriorities,
         };
 
         queueCreateInfos.push_back(queueCreateInfo);
@@ -773,7 +1156,7 @@ std::tuple<VkDevice, VkQueue, VkQueue, VkQueue> LogicalDeviceFactory::createLogi
             return VK_FALSE;
         }
     }();
-    const auto deviceExtensionProperties = m_infoProvider->getAvailableVulkanDeviceExtensions(m_physicalDevice);
+    const auto& deviceExtensionProperties = m_infoProvider->getAvailableVulkanDeviceExtensions(m_physicalDevice);
     const auto missingExtensions = m_infoProvider->detectMissingRequiredDeviceExtensions(
         deviceExtensionProperties, 
         logicalDeviceSpec.requiredExtensions()
@@ -790,31 +1173,302 @@ std::tuple<VkDevice, VkQueue, VkQueue, VkQueue> LogicalDeviceFactory::createLogi
     }
 
     const auto enabledExtensions = LogicalDeviceFactory::convertToCStrings(logicalDeviceSpec.requiredExtensions());
-    const auto validationLayersCStrings = []() {
-                if (ENABLE_VALIDATION_LAYERS) {
-                    return LogicalDeviceFactory::convertToCStrings(Constants::VALIDATION_LAYERS);
-                } else {
-                    return std::vector<const char*> {};
-                }
-    }();
 
+    auto supportedFeatures = VkPhysicalDeviceFeatures {};
+    vkGetPhysicalDeviceFeatures(m_physicalDevice, &supportedFeatures);
+
+    // The compute mipmap generator indexes an array of storage images. It is optional, so
+    // enable the feature only where the device has it.
+    // Sparse residency backs huge textures with partially resident memory, and is optional
+    // in the same way.
+    // The global texture table is indexed by the material of each draw.
+    // Indirect draws of the whole scene take many draws and a draw count from buffers.
+    const auto isDrawIndirectCountEnabled = VulkanEngine::GpuDevice::isDrawIndirectCountSupported(m_physicalDevice);
+    // Buffer device addresses let shaders reach buffers through pointers, without a
+    // descriptor.
+    const auto deviceCount = std::max(static_cast<uint32_t>(m_deviceGroup.size()), uint32_t { 1 });
+    const auto isBufferDeviceAddressEnabled = VulkanEngine::GpuDevice::isBufferDeviceAddressSupported(m_physicalDevice, deviceCount);
+    // The GPU profiler counts what its scopes did with pipeline statistics, which the
+    // secondary command buffers that run inside them inherit.
+    // The fragment shader writes the mip levels it samples to a feedback buffer for
+    // texture streaming, where the device can store from fragment shaders.
     const auto deviceFeatures = VkPhysicalDeviceFeatures {
+        .multiDrawIndirect = isDrawIndirectCountEnabled ? VK_TRUE : VK_FALSE,
+        .drawIndirectFirstInstance = isDrawIndirectCountEnabled ? VK_TRUE : VK_FALSE,
         .samplerAnisotropy = requireSamplerAnisotropy,
+        .pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery,
+        .fragmentStoresAndAtomics = supportedFeatures.fragmentStoresAndAtomics,
+        .shaderSampledImageArrayDynamicIndexing = VK_TRUE,
+        .shaderStorageImageArrayDynamicIndexing = supportedFeatures.shaderStorageImageArrayDynamicIndexing,
+        .sparseBinding = supportedFeatures.sparseBinding,
+        .sparseResidencyImage2D = supportedFeatures.sparseResidencyImage2D,
+        .inheritedQueries = supportedFeatures.inheritedQueries,
+    };
+    // Task and mesh shaders come with the mesh shader extension, wherever it is enabled.
+    const auto enabledExtensionNames = logicalDeviceSpec.requiredExtensions();
+    const auto isMeshShadingEnabled = std::find(
+        enabledExtensionNames.begin(),
+        enabledExtensionNames.end(),
+        std::string { VK_EXT_MESH_SHADER_EXTENSION_NAME }
+    ) != enabledExtensionNames.end();
+    auto meshShaderFeatures = VkPhysicalDeviceMeshShaderFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT,
+        .pNext = nullptr,
+        .taskShader = VK_TRUE,
+        .meshShader = VK_TRUE,
+    };
+    // Dynamic rendering lets the renderer draw without render passes or framebuffers, and
+    // synchronization2 lets upload barriers name the exact stages and accesses they wait on.
+    const auto isDynamicRenderingEnabled = VulkanEngine::GpuDevice::isDynamicRenderingSupported(m_physicalDevice);
+    const auto isSynchronization2Enabled = VulkanEngine::GpuDevice::isSynchronization2Supported(m_physicalDevice);
+    auto vulkan13Features = VkPhysicalDeviceVulkan13Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+        .pNext = nullptr,
+        .synchronization2 = isSynchronization2Enabled ? VK_TRUE : VK_FALSE,
+        .dynamicRendering = isDynamicRenderingEnabled ? VK_TRUE : VK_FALSE,
+    };
+    // Present IDs tag presents so that present waits can wait for them.
+    const auto isPresentWaitEnabled = std::find(
+        enabledExtensionNames.begin(),
+        enabledExtensionNames.end(),
+        std::string { VK_KHR_PRESENT_WAIT_EXTENSION_NAME }
+    ) != enabledExtensionNames.end();
+    auto presentIdFeatures = VkPhysicalDevicePresentIdFeaturesKHR {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+        .pNext = nullptr,
+        .presentId = VK_TRUE,
+    };
+    auto presentWaitFeatures = VkPhysicalDevicePresentWaitFeaturesKHR {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+        .pNext = nullptr,
+        .presentWait = VK_TRUE,
+    };
+    // Descriptors are written straight into descriptor buffers wherever the extension is
+    // enabled.
+    const auto isDescriptorBufferEnabled = std::find(
+        enabledExtensionNames.begin(),
+        enabledExtensionNames.end(),
+        std::string { VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME }
+    ) != enabledExtensionNames.end();
+    auto descriptorBufferFeatures = VkPhysicalDeviceDescriptorBufferFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT,
+        .pNext = nullptr,
+        .descriptorBuffer = VK_TRUE,
+    };
+    const auto isGraphicsPipelineLibraryEnabled = std::find(
+        enabledExtensionNames.begin(),
+        enabledExtensionNames.end(),
+        std::string { VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME }
+    ) != enabledExtensionNames.end();
+    auto graphicsPipelineLibraryFeatures = VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+        .pNext = nullptr,
+        .graphicsPipelineLibrary = VK_TRUE,
+    };
+    // Pipeline shading rates come with the extension, and attachment shading rates with it
+    // wherever the device has them. Rates per primitive are never used.
+    const auto isFragmentShadingRateEnabled = std::find(
+        enabledExtensionNames.begin(),
+        enabledExtensionNames.end(),
+        std::string { VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME }
+    ) != enabledExtensionNames.end();
+    const auto isFragmentShadingRateAttachmentEnabled = VulkanEngine::GpuDevice::isFragmentShadingRateAttachmentSupported(m_physicalDevice);
+    auto fragmentShadingRateFeatures = VkPhysicalDeviceFragmentShadingRateFeaturesKHR {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR,
+        .pNext = nullptr,
+        .pipelineFragmentShadingRate = VK_TRUE,
+        .primitiveFragmentShadingRate = VK_FALSE,
+        .attachmentFragmentShadingRate = isFragmentShadingRateAttachmentEnabled ? VK_TRUE : VK_FALSE,
+    };
+    // Draws are only ever made conditional inside the command buffer that records them,
+    // so secondaries never inherit a condition.
+    const auto isConditionalRenderingEnabled = std::find(
+        enabledExtensionNames.begin(),
+        enabledExtensionNames.end(),
+        std::string { VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME }
+    ) != enabledExtensionNames.end();
+    auto conditionalRenderingFeatures = VkPhysicalDeviceConditionalRenderingFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_CONDITIONAL_RENDERING_FEATURES_EXT,
+        .pNext = nullptr,
+        .conditionalRendering = VK_TRUE,
+        .inheritedConditionalRendering = VK_FALSE,
+    };
+    // Performance queries are reset on the host, since they cannot be reset in the command
+    // buffers that run them.
+    const auto isPerformanceQueryEnabled = std::find(
+        enabledExtensionNames.begin(),
+        enabledExtensionNames.end(),
+        std::string { VK_KHR_PERFORMANCE_QUERY_EXTENSION_NAME }
+    ) != enabledExtensionNames.end();
+    auto performanceQueryFeatures = VkPhysicalDevicePerformanceQueryFeaturesKHR {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PERFORMANCE_QUERY_FEATURES_KHR,
+        .pNext = nullptr,
+        .performanceCounterQueryPools = VK_TRUE,
+        .performanceCounterMultipleQueryPools = VK_FALSE,
+    };
+    const auto isHostImageCopyEnabled = std::find(
+        enabledExtensionNames.begin(),
+        enabledExtensionNames.end(),
+        std::string { VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME }
+    ) != enabledExtensionNames.end();
+    auto hostImageCopyFeatures = VkPhysicalDeviceHostImageCopyFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT,
+        .pNext = nullptr,
+        .hostImageCopy = VK_TRUE,
+    };
+    const auto isMemoryPriorityEnabled = std::find(
+        enabledExtensionNames.begin(),
+        enabledExtensionNames.end(),
+        std::string { VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME }
+    ) != enabledExtensionNames.end();
+    auto memoryPriorityFeatures = VkPhysicalDeviceMemoryPriorityFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PRIORITY_FEATURES_EXT,
+        .pNext = nullptr,
+        .memoryPriority = VK_TRUE,
+    };
+    const auto isPageableDeviceLocalMemoryEnabled = std::find(
+        enabledExtensionNames.begin(),
+        enabledExtensionNames.end(),
+        std::string { VK_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_EXTENSION_NAME }
+    ) != enabledExtensionNames.end();
+    auto pageableDeviceLocalMemoryFeatures = VkPhysicalDevicePageableDeviceLocalMemoryFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PAGEABLE_DEVICE_LOCAL_MEMORY_FEATURES_EXT,
+        .pNext = nullptr,
+        .pageableDeviceLocalMemory = VK_TRUE,
+    };
+    const auto isMaintenance5Enabled = std::find(
+        enabledExtensionNames.begin(),
+        enabledExtensionNames.end(),
+        std::string { VK_KHR_MAINTENANCE_5_EXTENSION_NAME }
+    ) != enabledExtensionNames.end();
+    auto maintenance5Features = VkPhysicalDeviceMaintenance5FeaturesKHR {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_5_FEATURES_KHR,
+        .pNext = nullptr,
+        .maintenance5 = VK_TRUE,
+    };
+    // The optional features are chained behind the Vulkan 1.2 features, which every
+    // device has.
+    void* optionalFeatures = nullptr;
+    if (isMeshShadingEnabled) {
+        meshShaderFeatures.pNext = optionalFeatures;
+        optionalFeatures = &meshShaderFeatures;
+    }
+
+    if (isDynamicRenderingEnabled || isSynchronization2Enabled) {
+        vulkan13Features.pNext = optionalFeatures;
+        optionalFeatures = &vulkan13Features;
+    }
+
+    if (isDescriptorBufferEnabled) {
+        descriptorBufferFeatures.pNext = optionalFeatures;
+        optionalFeatures = &descriptorBufferFeatures;
+    }
+
+    if (isGraphicsPipelineLibraryEnabled) {
+        graphicsPipelineLibraryFeatures.pNext = optionalFeatures;
+        optionalFeatures = &graphicsPipelineLibraryFeatures;
+    }
+
+    if (isFragmentShadingRateEnabled) {
+        fragmentShadingRateFeatures.pNext = optionalFeatures;
+        optionalFeatures = &fragmentShadingRateFeatures;
+    }
+
+    if (isConditionalRenderingEnabled) {
+        conditionalRenderingFeatures.pNext = optionalFeatures;
+        optionalFeatures = &conditionalRenderingFeatures;
+    }
+
+    if (isPerformanceQueryEnabled) {
+        performanceQueryFeatures.pNext = optionalFeatures;
+        optionalFeatures = &performanceQueryFeatures;
+    }
+
+    if (isHostImageCopyEnabled) {
+        hostImageCopyFeatures.pNext = optionalFeatures;
+        optionalFeatures = &hostImageCopyFeatures;
+    }
+
+    if (isMemoryPriorityEnabled) {
+        memoryPriorityFeatures.pNext = optionalFeatures;
+        optionalFeatures = &memoryPriorityFeatures;
+    }
+
+    if (isPageableDeviceLocalMemoryEnabled) {
+        pageableDeviceLocalMemoryFeatures.pNext = optionalFeatures;
+        optionalFeatures = &pageableDeviceLocalMemoryFeatures;
+    }
+
+    if (isMaintenance5Enabled) {
+        maintenance5Features.pNext = optionalFeatures;
+        optionalFeatures = &maintenance5Features;
+    }
+
+    if (isPresentWaitEnabled) {
+        presentIdFeatures.pNext = optionalFeatures;
+        presentWaitFeatures.pNext = &presentIdFeatures;
+        optionalFeatures = &presentWaitFeatures;
+    }
+
+    // The scene's vertex shaders pick the matrix of their view by the view index, which
+    // takes the multiview feature every Vulkan 1.1 device has, even when a frame renders a
+    // single view.
+    const auto vulkan11Features = VkPhysicalDeviceVulkan11Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES,
+        .pNext = optionalFeatures,
+        .multiview = VK_TRUE,
+    };
+
+    // Upload batches and the staging ring track GPU progress with timeline semaphores, and
+    // the global texture table takes the descriptor indexing features, which every
+    // compatible device has.
+    const auto vulkan12Features = VkPhysicalDeviceVulkan12Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = &vulkan11Features,
+        .drawIndirectCount = isDrawIndirectCountEnabled ? VK_TRUE : VK_FALSE,
+        .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+        .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
+        .descriptorBindingPartiallyBound = VK_TRUE,
+        .descriptorBindingVariableDescriptorCount = VK_TRUE,
+        .runtimeDescriptorArray = VK_TRUE,
+        .hostQueryReset = isPerformanceQueryEnabled ? VK_TRUE : VK_FALSE,
+        .timelineSemaphore = VK_TRUE,
+        .bufferDeviceAddress = isBufferDeviceAddressEnabled ? VK_TRUE : VK_FALSE,
+        .bufferDeviceAddressMultiDevice = isBufferDeviceAddressEnabled && deviceCount > 1 ? VK_TRUE : VK_FALSE,
     };
 
+    // A logical device made from a device group spans every device in it. Each resource
+    // gets an instance on every device, and device masks pick the devices commands run on.
+    const auto deviceGroupCreateInfo = VkDeviceGroupDeviceCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_GROUP_DEVICE_CREATE_INFO,
+        .pNext = &vulkan12Features,
+        .physicalDeviceCount = static_cast<uint32_t>(m_deviceGroup.size()),
+        .pPhysicalDevices = m_deviceGroup.data(),
+    };
+    const auto deviceCreateInfoNext = [this, &vulkan12Features, &deviceGroupCreateInfo]() -> const void* {
+        if (m_deviceGroup.empty()) {
+            return &vulkan12Features;
+        } else {
+            return &deviceGroupCreateInfo;
+        }
+    }();
+
     const auto createInfo = VkDeviceCreateInfo {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = deviceCreateInfoNext,
         .queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
         .pQueueCreateInfos = queueCreateInfos.data(),
         .pEnabledFeatures = &deviceFeatures,
         .enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size()),
         .ppEnabledExtensionNames = enabledExtensions.data(),
-        .enabledLayerCount = static_cast<uint32_t>(validationLayersCStrings.size()),
-        .ppEnabledLayerNames = validationLayersCStrings.data(),
+        // Device layers are deprecated and ignored, so the layers enabled on the instance,
+        // which the engine mode picks, are the ones that validate the device.
+        .enabledLayerCount = 0,
+        .ppEnabledLayerNames = nullptr,
     };
 
     auto device = VkDevice {};
-    const auto result = vkCreateDevice(m_physicalDevice, &createInfo, nullptr, &device);
+    const auto result = vkCreateDevice(m_physicalDevice, &createInfo, m_allocationCallbacks, &device);
     if (result != VK_SUCCESS) {
         throw std::runtime_error("failed to create logical device!");
     }
@@ -823,12 +1477,26 @@ std::tuple<VkDevice, VkQueue, VkQueue, VkQueue> LogicalDeviceFactory::createLogi
     vkGetDeviceQueue(device, indices.graphicsAndComputeFamily.value(), 0, &graphicsQueue);
 
     auto computeQueue = VkQueue {};
-    vkGetDeviceQueue(device, indices.graphicsAndComputeFamily.value(), 0, &computeQueue);
+    vkGetDeviceQueue(
+        device,
+        indices.computeFamily.value_or(indices.graphicsAndComputeFamily.value()),
+        computeQueueIndex,
+        &computeQueue
+    );
         
-    auto presentQueue = VkQueue {};
-    vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+    // Headless devices have no present queue.
+    auto presentQueue = VkQueue { VK_NULL_HANDLE };
+    if (indices.presentFamily.has_value()) {
+        vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+    }
+
+    // Without a dedicated transfer family, uploads share the graphics queue.
+    auto transferQueue = graphicsQueue;
+    if (indices.transferFamily.has_value()) {
+        vkGetDeviceQueue(device, indices.transferFamily.value(), 0, &transferQueue);
+    }
 
-    return std::make_tuple(device, graphicsQueue, computeQueue, presentQueue);
+    return std::make_tuple(device, graphicsQueue, computeQueue, presentQueue, transferQueue);
 }
 
 std::vector<const char*> LogicalDeviceFactory::convertToCStrings(const std::vector<std::string>& strings) {
@@ -850,6 +1518,9 @@ using VulkanDebugMessenger = VulkanEngine::VulkanDebugMessenger;
 VulkanDebugMessenger::VulkanDebugMessenger()
     : m_instance { VK_NULL_HANDLE }
     , m_debugMessenger { VK_NULL_HANDLE }
+    , m_allocationCallbacks { nullptr }
+    , m_minSeverity { DEFAULT_MIN_SEVERITY }
+    , m_logQueue { nullptr }
 {
 }
 
@@ -857,7 +1528,11 @@ VulkanDebugMessenger::~VulkanDebugMessenger() {
     this->cleanup();
 }
 
-std::unique_ptr<VulkanDebugMessenger> VulkanDebugMessenger::create(VkInstance instance) {
+std::unique_ptr<VulkanDebugMessenger> VulkanDebugMessenger::create(
+    VkInstance instance,
+    const VkAllocationCallbacks* allocationCallbacks,
+    VkDebugUtilsMessageSeverityFlagBitsEXT minSeverity
+) {
     if (instance == VK_NULL_HANDLE) {
         throw std::invalid_argument { "Got an empty `VkInstance` handle" };
     }
@@ -868,29 +1543,38 @@ std::unique_ptr<VulkanDebugMessenger> VulkanDebugMessenger::create(VkInstance in
         throw std::invalid_argument { "Got an invalid `VkInstance` handle" };
     }
 
+    // The callback finds the queue through its user data, so the messenger exists before
+    // the layers can call it. The severity bits grow with the severity, so the ones that
+    // pass are the minimum and every bit above it.
+    auto vulkanDebugMessenger = std::make_unique<VulkanDebugMessenger>();
+    vulkanDebugMessenger->m_minSeverity = minSeverity;
+    vulkanDebugMessenger->m_logQueue = std::make_unique<DebugLogQueue>(std::cerr);
+
+    const auto allSeverities =
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT |
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | 
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | 
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
     const auto createInfo = VkDebugUtilsMessengerCreateInfoEXT {
         .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
-        .messageSeverity = 
-            VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT |
-            VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | 
-            VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | 
-            VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT,
+        .messageSeverity = allSeverities & ~(static_cast<VkDebugUtilsMessageSeverityFlagsEXT>(minSeverity) - 1),
         .messageType = 
             VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | 
             VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | 
             VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
         .pfnUserCallback = debugCallback,
+        .pUserData = vulkanDebugMessenger.get(),
     };
 
     auto debugMessenger = static_cast<VkDebugUtilsMessengerEXT>(nullptr);
-    const auto result = VulkanDebugMessenger::CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger);
+    const auto result = VulkanDebugMessenger::CreateDebugUtilsMessengerEXT(instance, &createInfo, allocationCallbacks, &debugMessenger);
     if (result != VK_SUCCESS) {
         throw std::runtime_error { "failed to set up debug messenger!" };
     }
 
-    auto vulkanDebugMessenger = std::make_unique<VulkanDebugMessenger>();
     vulkanDebugMessenger->m_instance = instance;
     vulkanDebugMessenger->m_debugMessenger = debugMessenger;
+    vulkanDebugMessenger->m_allocationCallbacks = allocationCallbacks;
 
     return vulkanDebugMessenger;
 }
@@ -946,8 +1630,13 @@ VKAPI_ATTR VkBool32 VKAPI_CALL VulkanDebugMessenger::debugCallback(
     const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
     void* pUserData
 ) {
-    const auto messageSeverityString = VulkanDebugMessenger::messageSeverityToString(messageSeverity);
-    fmt::println(std::cerr, "[{}] {}", messageSeverityString, pCallbackData->pMessage);
+    const auto* debugMessenger = static_cast<const VulkanDebugMessenger*>(pUserData);
+    if (messageSeverity < debugMessenger->m_minSeverity) {
+        return VK_FALSE;
+    }
+
+    const auto& messageSeverityString = VulkanDebugMessenger::messageSeverityToString(messageSeverity);
+    debugMessenger->m_logQueue->push(messageSeverityString, pCallbackData->pMessage);
 
     return VK_FALSE;
 }
@@ -958,11 +1647,16 @@ void VulkanDebugMessenger::cleanup() {
     }
 
     if (m_debugMessenger != VK_NULL_HANDLE) {
-        VulkanDebugMessenger::DestroyDebugUtilsMessengerEXT(m_instance, m_debugMessenger, nullptr);
+        VulkanDebugMessenger::DestroyDebugUtilsMessengerEXT(m_instance, m_debugMessenger, m_allocationCallbacks);
     }
 
+    // The queue goes after the messenger, so the layers cannot push onto it any more, and
+    // writes out the messages still in it.
+    m_logQueue.reset();
+
     m_debugMessenger = VK_NULL_HANDLE;
     m_instance = VK_NULL_HANDLE;
+    m_allocationCallbacks = nullptr;
 }
 
 
@@ -991,14 +1685,31 @@ VkSurfaceKHR SurfaceProvider::createSurface() {
 
 
 using WindowSystem = VulkanEngine::WindowSystem;
+using WindowEvent = VulkanEngine::WindowEvent;
+using WindowEventType = VulkanEngine::WindowEventType;
 
-WindowSystem::WindowSystem(VkInstance instance) : m_instance { instance } {}
+WindowSystem::WindowSystem(VkInstance instance)
+    : m_instance { instance }
+    , m_isEventPumpRunning { false }
+    , m_windowExtent { 0, 0 }
+    , m_framebufferResized { false }
+    , m_windowEventCount { 0 }
+    , m_isFocused { true }
+    , m_isIconified { false }
+    , m_isCloseRequested { false }
+    , m_keysDown {}
+{
+}
 
 WindowSystem::~WindowSystem() {
     m_framebufferResized = false;
     m_windowExtent = VkExtent2D { 0, 0 };
     m_surface = VK_NULL_HANDLE;
 
+    for (const auto& viewportWindow : m_viewportWindows) {
+        glfwDestroyWindow(viewportWindow.window);
+    }
+    m_viewportWindows.clear();
     glfwDestroyWindow(m_window);
 
     m_instance = VK_NULL_HANDLE;
@@ -1013,11 +1724,42 @@ void WindowSystem::createWindow(uint32_t width, uint32_t height, const std::stri
     glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
 
     auto window = glfwCreateWindow(width, height, title.data(), nullptr, nullptr);
-    glfwSetWindowUserPointer(window, this);
-    glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+    this->setWindowCallbacks(window);
+
+    // The framebuffer of a scaled display is larger than the window it was asked for.
+    auto framebufferWidth = 0;
+    auto framebufferHeight = 0;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
 
     m_window = window;
-    m_windowExtent = VkExtent2D { width, height };
+    m_windowExtent = VkExtent2D { static_cast<uint32_t>(framebufferWidth), static_cast<uint32_t>(framebufferHeight) };
+    // A window that opens behind another one never hears that it lost the focus.
+    m_isFocused = glfwGetWindowAttrib(window, GLFW_FOCUSED) == GLFW_TRUE;
+}
+
+uint32_t WindowSystem::createViewportWindow(uint32_t width, uint32_t height, const std::string& title) {
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+    auto window = glfwCreateWindow(width, height, title.data(), nullptr, nullptr);
+    if (window == nullptr) {
+        throw std::runtime_error("failed to create viewport window!");
+    }
+    this->setWindowCallbacks(window);
+
+    auto framebufferWidth = 0;
+    auto framebufferHeight = 0;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+    m_viewportWindows.push_back(ViewportWindow {
+        .window = window,
+        .extent = VkExtent2D { static_cast<uint32_t>(framebufferWidth), static_cast<uint32_t>(framebufferHeight) },
+        .isResized = false,
+        .isFocused = glfwGetWindowAttrib(window, GLFW_FOCUSED) == GLFW_TRUE,
+        .isIconified = false,
+    });
+
+    return static_cast<uint32_t>(m_viewportWindows.size() - 1);
 }
 
 GLFWwindow* WindowSystem::getWindow() const {
@@ -1028,6 +1770,26 @@ SurfaceProvider WindowSystem::createSurfaceProvider() {
     return SurfaceProvider { m_instance, m_window};
 }
 
+SurfaceProvider WindowSystem::createViewportSurfaceProvider(uint32_t viewport) {
+    return SurfaceProvider { m_instance, m_viewportWindows.at(viewport).window };
+}
+
+uint32_t WindowSystem::getViewportCount() const {
+    return static_cast<uint32_t>(m_viewportWindows.size());
+}
+
+VkExtent2D WindowSystem::getViewportExtent(uint32_t viewport) const {
+    return m_viewportWindows.at(viewport).extent;
+}
+
+bool WindowSystem::hasViewportResized(uint32_t viewport) const {
+    return m_viewportWindows.at(viewport).isResized;
+}
+
+void WindowSystem::setViewportResized(uint32_t viewport, bool viewportResized) {
+    m_viewportWindows.at(viewport).isResized = viewportResized;
+}
+
 bool WindowSystem::hasFramebufferResized() const {
     return m_framebufferResized;
 }
@@ -1036,21 +1798,230 @@ void WindowSystem::setFramebufferResized(bool framebufferResized) {
     m_framebufferResized = framebufferResized;
 }
 
+VkExtent2D WindowSystem::getFramebufferExtent() const {
+    return m_windowExtent;
+}
+
+uint64_t WindowSystem::getWindowEventCount() const {
+    return m_windowEventCount;
+}
+
+// Focusing a viewport window takes the focus from the main window, but the app is still
+// what the user looks at.
+bool WindowSystem::isFocused() const {
+    return m_isFocused || std::ranges::any_of(m_viewportWindows, &ViewportWindow::isFocused);
+}
+
+bool WindowSystem::isIconified() const {
+    return m_isIconified && std::ranges::all_of(m_viewportWindows, &ViewportWindow::isIconified);
+}
+
+bool WindowSystem::isKeyDown(int key) const {
+    return key >= 0 && key <= GLFW_KEY_LAST && m_keysDown.test(static_cast<size_t>(key));
+}
+
+bool WindowSystem::isCloseRequested() const {
+    return m_isCloseRequested;
+}
+
+void WindowSystem::pollEvents() {
+    if (!m_isEventPumpRunning) {
+        glfwPollEvents();
+    }
+
+    this->handleQueuedEvents();
+}
+
+void WindowSystem::waitEvents(std::optional<double> timeoutSeconds) {
+    if (m_isEventPumpRunning) {
+        m_eventQueue.waitForEvent(timeoutSeconds);
+    } else if (timeoutSeconds) {
+        glfwWaitEventsTimeout(*timeoutSeconds);
+    } else {
+        glfwWaitEvents();
+    }
+
+    this->handleQueuedEvents();
+}
+
+void WindowSystem::runEventPump(const std::function<void()>& render) {
+    auto renderError = std::exception_ptr {};
+    auto isRendering = std::atomic<bool> { true };
+    m_isEventPumpRunning = true;
+    auto renderThread = std::thread { [&render, &renderError, &isRendering]() {
+        try {
+            render();
+        } catch (...) {
+            renderError = std::current_exception();
+        }
+
+        isRendering.store(false);
+        // The pump may be asleep until the next event, which might never come otherwise.
+        glfwPostEmptyEvent();
+    } };
+
+    while (isRendering.load()) {
+        glfwWaitEvents();
+        this->applyPendingTitle();
+    }
+
+    renderThread.join();
+    m_isEventPumpRunning = false;
+    if (renderError) {
+        std::rethrow_exception(renderError);
+    }
+}
+
 void WindowSystem::setWindowTitle(const std::string& title) {
-    glfwSetWindowTitle(m_window, title.data());
+    if (!m_isEventPumpRunning) {
+        glfwSetWindowTitle(m_window, title.data());
+        return;
+    }
+
+    {
+        auto lock = std::lock_guard<std::mutex> { m_titleMutex };
+        m_pendingTitle = title;
+    }
+    glfwPostEmptyEvent();
 }
 
-void WindowSystem::framebufferResizeCallback(GLFWwindow* window, int width, int height) {
+void WindowSystem::handleQueuedEvents() {
+    while (const auto event = m_eventQueue.pop()) {
+        m_windowEventCount++;
+        if (event->window > 0) {
+            this->handleViewportEvent(m_viewportWindows[event->window - 1], *event);
+            continue;
+        }
+
+        switch (event->type) {
+            case WindowEventType::FramebufferResize: {
+                m_framebufferResized = true;
+                m_windowExtent = VkExtent2D { event->width, event->height };
+                break;
+            }
+            case WindowEventType::Refresh: {
+                break;
+            }
+            case WindowEventType::Focus: {
+                m_isFocused = event->isSet;
+                break;
+            }
+            case WindowEventType::Iconify: {
+                m_isIconified = event->isSet;
+                break;
+            }
+            case WindowEventType::Key: {
+                if (event->key >= 0 && event->key <= GLFW_KEY_LAST) {
+                    m_keysDown.set(static_cast<size_t>(event->key), event->action != GLFW_RELEASE);
+                }
+                break;
+            }
+            case WindowEventType::Close: {
+                m_isCloseRequested = true;
+                break;
+            }
+        }
+    }
+}
+
+// The keys and close requests of a viewport window go to the app as a whole.
+void WindowSystem::handleViewportEvent(ViewportWindow& viewportWindow, const WindowEvent& event) {
+    switch (event.type) {
+        case WindowEventType::FramebufferResize: {
+            viewportWindow.isResized = true;
+            viewportWindow.extent = VkExtent2D { event.width, event.height };
+            break;
+        }
+        case WindowEventType::Refresh: {
+            break;
+        }
+        case WindowEventType::Focus: {
+            viewportWindow.isFocused = event.isSet;
+            break;
+        }
+        case WindowEventType::Iconify: {
+            viewportWindow.isIconified = event.isSet;
+            break;
+        }
+        case WindowEventType::Key: {
+            if (event.key >= 0 && event.key <= GLFW_KEY_LAST) {
+                m_keysDown.set(static_cast<size_t>(event.key), event.action != GLFW_RELEASE);
+            }
+            break;
+        }
+        case WindowEventType::Close: {
+            m_isCloseRequested = true;
+            break;
+        }
+    }
+}
+
+void WindowSystem::applyPendingTitle() {
+    auto lock = std::lock_guard<std::mutex> { m_titleMutex };
+    if (m_pendingTitle) {
+        glfwSetWindowTitle(m_window, m_pendingTitle->data());
+        m_pendingTitle.reset();
+    }
+}
+
+uint32_t WindowSystem::getWindowIndex(GLFWwindow* window) const {
+    for (size_t i = 0; i < m_viewportWindows.size(); i++) {
+        if (m_viewportWindows[i].window == window) {
+            return static_cast<uint32_t>(i + 1);
+        }
+    }
+
+    return 0;
+}
+
+void WindowSystem::setWindowCallbacks(GLFWwindow* window) {
+    glfwSetWindowUserPointer(window, this);
+    glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+    glfwSetWindowRefreshCallback(window, windowRefreshCallback);
+    glfwSetWindowFocusCallback(window, windowFocusCallback);
+    glfwSetWindowIconifyCallback(window, windowIconifyCallback);
+    glfwSetKeyCallback(window, keyCallback);
+    glfwSetWindowCloseCallback(window, windowCloseCallback);
+}
+
+void WindowSystem::pushEvent(GLFWwindow* window, const WindowEvent& event) {
     auto windowSystem = reinterpret_cast<WindowSystem*>(glfwGetWindowUserPointer(window));
-    windowSystem->m_framebufferResized = true;
-    windowSystem->m_windowExtent = VkExtent2D { 
-        static_cast<uint32_t>(width),
-        static_cast<uint32_t>(height)
-    };
+    auto windowEvent = event;
+    windowEvent.window = windowSystem->getWindowIndex(window);
+    windowSystem->m_eventQueue.push(windowEvent);
+}
+
+void WindowSystem::framebufferResizeCallback(GLFWwindow* window, int width, int height) {
+    WindowSystem::pushEvent(window, WindowEvent {
+        .type = WindowEventType::FramebufferResize,
+        .width = static_cast<uint32_t>(width),
+        .height = static_cast<uint32_t>(height),
+    });
+}
+
+void WindowSystem::windowRefreshCallback(GLFWwindow* window) {
+    WindowSystem::pushEvent(window, WindowEvent { .type = WindowEventType::Refresh });
 }
 
+void WindowSystem::windowFocusCallback(GLFWwindow* window, int focused) {
+    WindowSystem::pushEvent(window, WindowEvent { .type = WindowEventType::Focus, .isSet = focused == GLFW_TRUE });
+}
+
+void WindowSystem::windowIconifyCallback(GLFWwindow* window, int iconified) {
+    WindowSystem::pushEvent(window, WindowEvent { .type = WindowEventType::Iconify, .isSet = iconified == GLFW_TRUE });
+}
+
+void WindowSystem::keyCallback(GLFWwindow* window, int key, int, int action, int) {
+    WindowSystem::pushEvent(window, WindowEvent { .type = WindowEventType::Key, .key = key, .action = action });
+}
+
+void WindowSystem::windowCloseCallback(GLFWwindow* window) {
+    WindowSystem::pushEvent(window, WindowEvent { .type = WindowEventType::Close });
+}
 
 using GpuDevice = VulkanEngine::GpuDevice;
+using DeviceDispatch = VulkanEngine::DeviceDispatch;
+using TextureFormats = VulkanEngine::TextureFormats;
 
 GpuDevice::GpuDevice(
     VkInstance instance,
@@ -1059,33 +2030,184 @@ GpuDevice::GpuDevice(
     VkQueue graphicsQueue,
     VkQueue computeQueue,
     VkQueue presentQueue,
-    VkCommandPool commandPool
+    VkQueue transferQueue,
+    VkCommandPool commandPool,
+    VkCommandPool uploadCommandPool,
+    VkCommandPool transferCommandPool,
+    VkCommandPool computeCommandPool,
+    const QueueFamilyIndices& queueFamilyIndices,
+    uint32_t deviceCount,
+    const VkAllocationCallbacks* allocationCallbacks
 )   : m_instance { instance }
     , m_physicalDevice { physicalDevice }
     , m_device { device }
     , m_graphicsQueue { graphicsQueue }
     , m_computeQueue { computeQueue }
     , m_presentQueue { presentQueue }
+    , m_transferQueue { transferQueue }
     , m_commandPool { commandPool }
-    , m_shaderModules { std::unordered_set<VkShaderModule> {} }
+    , m_uploadCommandPool { uploadCommandPool }
+    , m_transferCommandPool { transferCommandPool }
+    , m_computeCommandPool { computeCommandPool }
+    , m_queueFamilyIndices { queueFamilyIndices }
+    , m_deviceCount { deviceCount }
+    , m_allocationCallbacks { allocationCallbacks }
+    , m_sparseBindingQueue { VK_NULL_HANDLE }
+    , m_dispatch { DeviceDispatch::load(device) }
+    , m_isDynamicRenderingSupported { GpuDevice::isDynamicRenderingSupported(physicalDevice) }
+    , m_isSynchronization2Supported { GpuDevice::isSynchronization2Supported(physicalDevice) }
+    , m_isExtendedDynamicStateSupported { GpuDevice::isExtendedDynamicStateSupported(physicalDevice) }
+    , m_isDrawIndirectCountSupported { GpuDevice::isDrawIndirectCountSupported(physicalDevice) }
+    , m_isBufferDeviceAddressSupported { GpuDevice::isBufferDeviceAddressSupported(physicalDevice, deviceCount) }
+    , m_isDescriptorBufferSupported {
+        GpuDevice::isDescriptorBufferSupported(physicalDevice)
+            && GpuDevice::isBufferDeviceAddressSupported(physicalDevice, deviceCount)
+    }
+    , m_isGraphicsPipelineLibrarySupported { GpuDevice::isGraphicsPipelineLibrarySupported(physicalDevice) }
+    , m_isFragmentShadingRateAttachmentSupported { GpuDevice::isFragmentShadingRateAttachmentSupported(physicalDevice) }
+    , m_isExternalMemoryFdSupported { GpuDevice::isExternalMemoryFdSupported(physicalDevice) }
+    , m_isMaintenance5Supported { GpuDevice::isMaintenance5Supported(physicalDevice) }
+    , m_isLost { false }
+    , m_surface { VK_NULL_HANDLE }
+    , m_shaderModules {}
+    , m_shaderModuleHashes {}
+    , m_capabilities { std::make_unique<DeviceCapabilities>(physicalDevice) }
+    , m_memoryAllocator {
+        std::make_unique<GpuMemoryAllocator>(
+            physicalDevice,
+            device,
+            GpuDevice::isMemoryBudgetSupported(physicalDevice),
+            GpuDevice::isMemoryPrioritySupported(physicalDevice),
+            GpuDevice::isBufferDeviceAddressSupported(physicalDevice, deviceCount)
+        )
+    }
 {
     m_msaaSamples = GpuDevice::getMaxUsableSampleCount(physicalDevice);
+
+    // Sparse binds go through the graphics queue, so sparse residency is only used when
+    // the graphics family supports them. The features are enabled wherever they exist.
+    // Plain sparse binds only bind memory on the first device of a device group, so device
+    // groups go without.
+    const auto& supportedFeatures = m_capabilities->getFeatures();
+    const auto& queueFamilies = m_capabilities->getQueueFamilies();
+    const auto& graphicsFamily = queueFamilies[queueFamilyIndices.graphicsAndComputeFamily.value()];
+    const auto hasSparseResidency = supportedFeatures.sparseBinding && supportedFeatures.sparseResidencyImage2D;
+    if (deviceCount == 1 && hasSparseResidency && (graphicsFamily.queueFlags & VK_QUEUE_SPARSE_BINDING_BIT)) {
+        m_sparseBindingQueue = graphicsQueue;
+    }
+
+    if (GpuDevice::isMeshShadingSupported(physicalDevice)) {
+        m_dispatch.vkCmdDrawMeshTasksEXT = DeviceDispatch::loadFunction<PFN_vkCmdDrawMeshTasksEXT>(device, "vkCmdDrawMeshTasksEXT");
+    }
+
+    if (queueFamilyIndices.presentFamily.has_value() && GpuDevice::isPresentWaitSupported(physicalDevice)) {
+        m_dispatch.vkWaitForPresentKHR = DeviceDispatch::loadFunction<PFN_vkWaitForPresentKHR>(device, "vkWaitForPresentKHR");
+    }
+
+    if (GpuDevice::isFragmentShadingRateSupported(physicalDevice)) {
+        m_dispatch.vkCmdSetFragmentShadingRateKHR = DeviceDispatch::loadFunction<PFN_vkCmdSetFragmentShadingRateKHR>(device, "vkCmdSetFragmentShadingRateKHR");
+    }
+
+    if (GpuDevice::isConditionalRenderingSupported(physicalDevice)) {
+        m_dispatch.vkCmdBeginConditionalRenderingEXT = DeviceDispatch::loadFunction<PFN_vkCmdBeginConditionalRenderingEXT>(device, "vkCmdBeginConditionalRenderingEXT");
+        m_dispatch.vkCmdEndConditionalRenderingEXT = DeviceDispatch::loadFunction<PFN_vkCmdEndConditionalRenderingEXT>(device, "vkCmdEndConditionalRenderingEXT");
+    }
+
+    m_queueSubmitter = std::make_unique<QueueSubmitter>(m_dispatch, GpuDevice::isSynchronization2Supported(physicalDevice), deviceCount);
+    m_stagingRing = std::make_unique<StagingRing>(device, *m_memoryAllocator, *m_queueSubmitter, StagingRing::DEFAULT_CAPACITY);
+    // Host copies write a single instance of an image, so device groups go without.
+    if (deviceCount == 1 && GpuDevice::isHostImageCopySupported(physicalDevice)) {
+        m_hostImageCopier = std::make_unique<HostImageCopier>(physicalDevice, device);
+    }
+    m_samplerCache = std::make_unique<SamplerCache>(physicalDevice, device);
+    m_pipelineLayoutCache = std::make_unique<PipelineLayoutCache>(device);
+
+    const auto graphicsUploadQueue = UploadQueue {
+        .queue = graphicsQueue,
+        .commandPool = uploadCommandPool,
+        .queueFamilyIndex = queueFamilyIndices.graphicsAndComputeFamily.value(),
+    };
+    const auto transferUploadQueue = UploadQueue {
+        .queue = transferQueue,
+        .commandPool = transferCommandPool,
+        .queueFamilyIndex = queueFamilyIndices.transferFamily.value_or(queueFamilyIndices.graphicsAndComputeFamily.value()),
+    };
+    m_uploadContext = std::make_unique<UploadContext>(
+        *m_capabilities,
+        device,
+        graphicsUploadQueue,
+        transferUploadQueue,
+        *m_stagingRing,
+        *m_queueSubmitter,
+        GpuDevice::isSynchronization2Supported(physicalDevice)
+    );
 }
 
 GpuDevice::~GpuDevice() {
-    for (const auto& shaderModule : m_shaderModules) {
-        vkDestroyShaderModule(m_device, shaderModule, nullptr);
+    for (const auto& [hash, cachedShaderModule] : m_shaderModules) {
+        vkDestroyShaderModule(m_device, cachedShaderModule.shaderModule, m_allocationCallbacks);
+    }
+    m_shaderModules.clear();
+    m_shaderModuleHashes.clear();
+
+    m_uploadContext.reset();
+    m_hostImageCopier.reset();
+    m_gpuDecompressor.reset();
+    m_textureCompressor.reset();
+    m_mipmapGenerator.reset();
+    m_pipelineCompiler.reset();
+
+    // Every pipeline has been created by now, so this is the last chance to keep what the
+    // driver compiled for the next run. A lost device has nothing left to read it from.
+    if (m_pipelineCache != nullptr && !m_isLost) {
+        try {
+            m_pipelineCache->store();
+        } catch (const std::runtime_error& exception) {
+            fmt::println(std::cerr, "Failed to store pipeline cache: {}", exception.what());
+        }
     }
+    m_pipelineCache.reset();
+    m_pipelineLayoutCache.reset();
+    m_samplerCache.reset();
+    m_stagingRing.reset();
+    m_queueSubmitter.reset();
+
+    // Every owner of device memory is gone, so the report is final. Destroying the
+    // allocator lists whatever is still allocated as leaked.
+    m_memoryAllocator->printReport();
+    m_memoryAllocator.reset();
+    m_capabilities.reset();
 
     vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
-    vkDestroyCommandPool(m_device, m_commandPool, nullptr);
-    vkDestroyDevice(m_device, nullptr);
+    vkDestroyCommandPool(m_device, m_computeCommandPool, m_allocationCallbacks);
+    vkDestroyCommandPool(m_device, m_transferCommandPool, m_allocationCallbacks);
+    vkDestroyCommandPool(m_device, m_uploadCommandPool, m_allocationCallbacks);
+    vkDestroyCommandPool(m_device, m_commandPool, m_allocationCallbacks);
+    vkDestroyDevice(m_device, m_allocationCallbacks);
 
     m_surface = VK_NULL_HANDLE;
+    m_computeCommandPool = VK_NULL_HANDLE;
+    m_transferCommandPool = VK_NULL_HANDLE;
+    m_uploadCommandPool = VK_NULL_HANDLE;
     m_commandPool = VK_NULL_HANDLE;
+    m_sparseBindingQueue = VK_NULL_HANDLE;
+    m_dispatch = DeviceDispatch {};
+    m_isDynamicRenderingSupported = false;
+    m_isSynchronization2Supported = false;
+    m_isExtendedDynamicStateSupported = false;
+    m_isDrawIndirectCountSupported = false;
+    m_isBufferDeviceAddressSupported = false;
+    m_isDescriptorBufferSupported = false;
+    m_isGraphicsPipelineLibrarySupported = false;
+    m_isFragmentShadingRateAttachmentSupported = false;
+    m_isExternalMemoryFdSupported = false;
+    m_isMaintenance5Supported = false;
+    m_isLost = false;
+    m_transferQueue = VK_NULL_HANDLE;
     m_presentQueue = VK_NULL_HANDLE;
     m_graphicsQueue = VK_NULL_HANDLE;
     m_device = VK_NULL_HANDLE;
+    m_allocationCallbacks = nullptr;
     m_physicalDevice = VK_NULL_HANDLE;
     m_instance = VK_NULL_HANDLE;
 }
@@ -1094,6 +2216,14 @@ VkPhysicalDevice GpuDevice::getPhysicalDevice() const {
     return m_physicalDevice;
 }
 
+const VkAllocationCallbacks* GpuDevice::getAllocationCallbacks() const {
+    return m_allocationCallbacks;
+}
+
+const VulkanEngine::DeviceCapabilities& GpuDevice::getDeviceCapabilities() const {
+    return *m_capabilities;
+}
+
 VkDevice GpuDevice::getLogicalDevice() const {
     return m_device;
 }
@@ -1110,17 +2240,37 @@ VkQueue GpuDevice::getPresentQueue() const {
     return m_presentQueue;
 }
 
+VkQueue GpuDevice::getTransferQueue() const {
+    return m_transferQueue;
+}
+
 VkCommandPool GpuDevice::getCommandPool() const {
     return m_commandPool;
 }
 
-VkSampleCountFlagBits GpuDevice::getMsaaSamples() const {
-    return m_msaaSamples;
+VkCommandPool GpuDevice::getTransferCommandPool() const {
+    return m_transferCommandPool;
 }
 
-VkSampleCountFlagBits GpuDevice::getMaxUsableSampleCount(VkPhysicalDevice physicalDevice) {
-    auto physicalDeviceProperties = VkPhysicalDeviceProperties {};
-    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+VkCommandPool GpuDevice::getComputeCommandPool() const {
+    return m_computeCommandPool;
+}
+
+const VulkanEngine::QueueFamilyIndices& GpuDevice::getQueueFamilyIndices() const {
+    return m_queueFamilyIndices;
+}
+
+uint32_t GpuDevice::getDeviceCount() const {
+    return m_deviceCount;
+}
+
+VkSampleCountFlagBits GpuDevice::getMsaaSamples() const {
+    return m_msaaSamples;
+}
+
+VkSampleCountFlagBits GpuDevice::getMaxUsableSampleCount(VkPhysicalDevice physicalDevice) {
+    auto physicalDeviceProperties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
 
     const auto sampleCounts = VkSampleCountFlags { 
         physicalDeviceProperties.limits.framebufferColorSampleCounts & 
@@ -1145,9 +2295,11 @@ VkSurfaceKHR GpuDevice::createRenderSurface(SurfaceProvider& surfaceProvider) {
 }
 
 VkShaderModule GpuDevice::createShaderModuleFromFile(const std::string& fileName) {
-    const auto shaderCode = this->loadShaderFromFile(fileName);
+    // Mappings and archive entries are aligned, so the code can be handed to Vulkan without
+    // a copy.
+    const auto shaderFile = AssetFile { fileName };
 
-    return this->createShaderModule(shaderCode);
+    return this->createShaderModule(shaderFile.getData(), shaderFile.getSize());
 }
 
 VkShaderModule GpuDevice::createShaderModule(std::istream& stream) {
@@ -1157,43 +2309,78 @@ VkShaderModule GpuDevice::createShaderModule(std::istream& stream) {
 }
 
 VkShaderModule GpuDevice::createShaderModule(const std::vector<char>& code) {
+    return this->createShaderModule(code.data(), code.size());
+}
+
+VkShaderModule GpuDevice::createShaderModule(const std::vector<unsigned char>& code) {
+    return this->createShaderModule(code.data(), code.size());
+}
+
+VkShaderModule GpuDevice::createShaderModule(std::span<const uint32_t> code) {
+    return this->createShaderModule(code.data(), code.size_bytes());
+}
+
+VkShaderModule GpuDevice::createShaderModule(const void* code, size_t codeSize) {
+    // Permutations and pipelines that share a stage ask for the same code over and over,
+    // so a module is only created for code that has no module yet.
+    const auto* codeBytes = static_cast<const uint8_t*>(code);
+    const auto hash = CacheSourceKey::hashBytes(codeBytes, codeSize, CacheSourceKey::FNV_OFFSET_BASIS);
+    const auto [first, last] = m_shaderModules.equal_range(hash);
+    for (auto cached = first; cached != last; cached++) {
+        auto& cachedShaderModule = cached->second;
+        if (std::equal(cachedShaderModule.code.begin(), cachedShaderModule.code.end(), codeBytes, codeBytes + codeSize)) {
+            cachedShaderModule.referenceCount++;
+
+            return cachedShaderModule.shaderModule;
+        }
+    }
+
     const auto createInfo = VkShaderModuleCreateInfo {
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .codeSize = code.size(),
-        .pCode = reinterpret_cast<const uint32_t*>(code.data()),
+        .codeSize = codeSize,
+        .pCode = reinterpret_cast<const uint32_t*>(code),
         .pNext = nullptr,
         .flags = 0,
     };
 
     auto shaderModule = VkShaderModule {};
-    const auto result = vkCreateShaderModule(m_device, &createInfo, nullptr, &shaderModule);
+    const auto result = vkCreateShaderModule(m_device, &createInfo, m_allocationCallbacks, &shaderModule);
     if (result != VK_SUCCESS) {
         throw std::runtime_error("failed to create shader module!");
     }
 
-    m_shaderModules.insert(shaderModule);
+    m_shaderModules.emplace(hash, CachedShaderModule {
+        .code = std::vector<uint8_t>(codeBytes, codeBytes + codeSize),
+        .shaderModule = shaderModule,
+        .referenceCount = 1,
+    });
+    m_shaderModuleHashes.emplace(shaderModule, hash);
 
     return shaderModule;
 }
 
-VkShaderModule GpuDevice::createShaderModule(const std::vector<unsigned char>& code) {
-    const auto createInfo = VkShaderModuleCreateInfo {
-        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .codeSize = code.size(),
-        .pCode = reinterpret_cast<const uint32_t*>(code.data()),
-        .pNext = nullptr,
-        .flags = 0,
-    };
+void GpuDevice::releaseShaderModule(VkShaderModule shaderModule) {
+    const auto foundHash = m_shaderModuleHashes.find(shaderModule);
+    if (foundHash == m_shaderModuleHashes.end()) {
+        throw std::invalid_argument("shader module released that the device did not create!");
+    }
 
-    auto shaderModule = VkShaderModule {};
-    const auto result = vkCreateShaderModule(m_device, &createInfo, nullptr, &shaderModule);
-    if (result != VK_SUCCESS) {
-        throw std::runtime_error("failed to create shader module!");
+    const auto [first, last] = m_shaderModules.equal_range(foundHash->second);
+    const auto cached = std::find_if(first, last, [shaderModule](const auto& entry) {
+        return entry.second.shaderModule == shaderModule;
+    });
+    cached->second.referenceCount--;
+    if (cached->second.referenceCount > 0) {
+        return;
     }
 
-    m_shaderModules.insert(shaderModule);
+    vkDestroyShaderModule(m_device, shaderModule, m_allocationCallbacks);
+    m_shaderModules.erase(cached);
+    m_shaderModuleHashes.erase(foundHash);
+}
 
-    return shaderModule;
+uint32_t GpuDevice::getShaderModuleCount() const {
+    return static_cast<uint32_t>(m_shaderModules.size());
 }
 
 std::vector<char> GpuDevice::loadShader(std::istream& stream) {
@@ -1206,201 +2393,1328 @@ std::vector<char> GpuDevice::loadShader(std::istream& stream) {
     return buffer;
 }
 
-std::ifstream GpuDevice::openShaderFile(const std::string& fileName) {
-    auto file = std::ifstream { fileName, std::ios::ate | std::ios::binary };
+std::vector<char> GpuDevice::loadShaderFromFile(const std::string& fileName) {
+    const auto shaderFile = AssetFile { fileName };
+    const auto* shaderData = reinterpret_cast<const char*>(shaderFile.getData());
 
-    if (!file.is_open()) {
-        throw std::runtime_error("failed to open file!");
-    }
+    return std::vector<char>(shaderData, shaderData + shaderFile.getSize());
+}
 
-    return file;
+uint32_t GpuDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+    return m_memoryAllocator->findMemoryType(typeFilter, properties);
 }
 
-std::vector<char> GpuDevice::loadShaderFromFile(const std::string& fileName) {
-    auto stream = this->openShaderFile(fileName);
-    auto shader = this->loadShader(stream);
-    stream.close();
+VulkanEngine::GpuMemoryAllocator& GpuDevice::getMemoryAllocator() {
+    return *m_memoryAllocator;
+}
+
+VulkanEngine::QueueSubmitter& GpuDevice::getQueueSubmitter() {
+    return *m_queueSubmitter;
+}
 
-    return shader;
+VulkanEngine::StagingRing& GpuDevice::getStagingRing() {
+    return *m_stagingRing;
 }
 
-uint32_t GpuDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-    auto memProperties = VkPhysicalDeviceMemoryProperties {};
-    vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memProperties);
+VulkanEngine::SamplerCache& GpuDevice::getSamplerCache() {
+    return *m_samplerCache;
+}
 
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
+VulkanEngine::PipelineLayoutCache& GpuDevice::getPipelineLayoutCache() {
+    return *m_pipelineLayoutCache;
+}
+
+const DeviceDispatch& GpuDevice::getDeviceDispatch() const {
+    return m_dispatch;
+}
+
+VulkanEngine::UploadContext& GpuDevice::getUploadContext() {
+    return *m_uploadContext;
+}
+
+void GpuDevice::createPipelineCache(const std::filesystem::path& filePath) {
+    m_pipelineCache = std::make_unique<PipelineCache>(m_physicalDevice, m_device, filePath);
+}
+
+VkPipelineCache GpuDevice::getPipelineCache() const {
+    if (m_pipelineCache == nullptr) {
+        return VK_NULL_HANDLE;
     }
 
-    throw std::runtime_error("failed to find suitable memory type!");
+    return m_pipelineCache->getHandle();
 }
 
+void GpuDevice::createPipelineCompiler(uint32_t threadCount) {
+    m_pipelineCompiler = std::make_unique<PipelineCompiler>(m_device, this->getPipelineCache(), threadCount);
+}
 
-using GpuDeviceInitializer = VulkanEngine::GpuDeviceInitializer;
+VulkanEngine::PipelineCompiler& GpuDevice::getPipelineCompiler() {
+    if (m_pipelineCompiler == nullptr) {
+        throw std::logic_error("the pipeline compiler has not been created!");
+    }
 
-GpuDeviceInitializer::GpuDeviceInitializer(VkInstance instance)
-    : m_instance { instance }
-{
+    return *m_pipelineCompiler;
 }
 
-GpuDeviceInitializer::~GpuDeviceInitializer() {
-    vkDestroySurfaceKHR(m_instance, m_dummySurface, nullptr);
+void GpuDevice::createMipmapGenerator(
+    std::span<const uint32_t> shaderCode,
+    std::span<const uint32_t> filterShaderCode,
+    std::span<const uint32_t> volumeShaderCode
+) {
+    auto mipmapGenerator = std::make_unique<MipmapGenerator>(
+        *m_capabilities,
+        m_device,
+        *m_memoryAllocator,
+        this->getPipelineCache(),
+        GpuDevice::isPushDescriptorSupported(m_capabilities->getPhysicalDevice()),
+        shaderCode,
+        filterShaderCode,
+        volumeShaderCode
+    );
+    m_uploadContext->setMipmapGenerator(mipmapGenerator.get());
 
-    m_instance = VK_NULL_HANDLE;
+    m_mipmapGenerator = std::move(mipmapGenerator);
 }
 
-std::unique_ptr<GpuDevice> GpuDeviceInitializer::createGpuDevice() {
-    this->createDummySurface();
-    this->selectPhysicalDevice();
-    this->createLogicalDevice();
-    this->createCommandPool();
+VulkanEngine::MipmapGenerator* GpuDevice::getMipmapGenerator() const {
+    return m_mipmapGenerator.get();
+}
 
-    auto gpuDevice = std::make_unique<GpuDevice>(
-        m_instance,
+void GpuDevice::createTextureCompressor(std::span<const uint32_t> shaderCode) {
+    m_textureCompressor = std::make_unique<TextureCompressor>(
+        *m_capabilities,
+        m_device,
+        this->getPipelineCache(),
+        shaderCode
+    );
+}
+
+VulkanEngine::TextureCompressor* GpuDevice::getTextureCompressor() const {
+    return m_textureCompressor.get();
+}
+
+void GpuDevice::createGpuDecompressor(std::span<const uint32_t> shaderCode) {
+    m_gpuDecompressor = std::make_unique<GpuDecompressor>(
         m_physicalDevice,
         m_device,
-        m_graphicsQueue,
-        m_computeQueue,
-        m_presentQueue,
-        m_commandPool
+        this->getPipelineCache(),
+        shaderCode
     );
+}
 
-    return gpuDevice;
+VulkanEngine::GpuDecompressor* GpuDevice::getGpuDecompressor() const {
+    return m_gpuDecompressor.get();
 }
 
-QueueFamilyIndices GpuDeviceInitializer::findQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const {
-    auto indices = QueueFamilyIndices {};
+VulkanEngine::HostImageCopier* GpuDevice::getHostImageCopier() const {
+    return m_hostImageCopier.get();
+}
 
-    uint32_t queueFamilyCount = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+VkQueue GpuDevice::getSparseBindingQueue() const {
+    return m_sparseBindingQueue;
+}
 
-    auto queueFamilies = std::vector<VkQueueFamilyProperties> { queueFamilyCount };
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+bool GpuDevice::supportsSparseTextures(VkFormat format, VkImageUsageFlags usage) const {
+    if (m_sparseBindingQueue == VK_NULL_HANDLE) {
+        return false;
+    }
 
-    int i = 0;
-    for (const auto& queueFamily : queueFamilies) {
-        if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
-            indices.graphicsAndComputeFamily = i;
-        }
+    return SparseTexture::isSupported(m_physicalDevice, format, usage);
+}
 
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
+std::unique_ptr<VulkanEngine::SparseTexture> GpuDevice::createSparseTexture(
+    uint32_t width,
+    uint32_t height,
+    uint32_t mipLevels,
+    VkFormat format,
+    VkImageUsageFlags usage,
+    VkDeviceSize memoryBudget
+) {
+    if (!this->supportsSparseTextures(format, usage)) {
+        throw std::runtime_error("failed to create sparse texture: sparse residency is not supported for this format!");
+    }
 
-        if (presentSupport) {
-            indices.presentFamily = i;
-        }
+    return std::make_unique<SparseTexture>(
+        m_device,
+        *m_memoryAllocator,
+        m_sparseBindingQueue,
+        width,
+        height,
+        mipLevels,
+        format,
+        usage,
+        memoryBudget
+    );
+}
 
-        if (indices.isComplete()) {
-            break;
+bool GpuDevice::isMeshShadingSupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    const auto hasMeshShaderExtension = std::any_of(
+        extensions.begin(),
+        extensions.end(),
+        [](const VkExtensionProperties& extension) {
+            return strcmp(extension.extensionName, VK_EXT_MESH_SHADER_EXTENSION_NAME) == 0;
         }
+    );
+    if (!hasMeshShaderExtension) {
+        return false;
+    }
+
+    auto meshShaderFeatures = VkPhysicalDeviceMeshShaderFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &meshShaderFeatures,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return meshShaderFeatures.taskShader && meshShaderFeatures.meshShader;
+}
 
-        i++;
+bool GpuDevice::isDynamicRenderingSupported(VkPhysicalDevice physicalDevice) {
+    auto physicalDeviceProperties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+    if (physicalDeviceProperties.apiVersion < VK_API_VERSION_1_3) {
+        return false;
     }
 
-    return indices;
+    auto vulkan13Features = VkPhysicalDeviceVulkan13Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &vulkan13Features,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return vulkan13Features.dynamicRendering == VK_TRUE;
 }
 
-void GpuDeviceInitializer::createDummySurface() {
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+bool GpuDevice::supportsDynamicRendering() const {
+    return m_isDynamicRenderingSupported;
+}
 
-    auto dummyWindow = glfwCreateWindow(1, 1, "DUMMY WINDOW", nullptr, nullptr);
-    auto dummySurface = VkSurfaceKHR {};
-    const auto result = glfwCreateWindowSurface(m_instance, dummyWindow, nullptr, &dummySurface);
-    if (result != VK_SUCCESS) {
-        glfwDestroyWindow(dummyWindow);
-        dummyWindow = nullptr;
+bool GpuDevice::isSynchronization2Supported(VkPhysicalDevice physicalDevice) {
+    auto physicalDeviceProperties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+    if (physicalDeviceProperties.apiVersion < VK_API_VERSION_1_3) {
+        return false;
+    }
 
-        throw std::runtime_error("failed to create window surface!");
+    auto vulkan13Features = VkPhysicalDeviceVulkan13Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &vulkan13Features,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return vulkan13Features.synchronization2 == VK_TRUE;
+}
+
+bool GpuDevice::supportsSynchronization2() const {
+    return m_isSynchronization2Supported;
+}
+
+bool GpuDevice::isExtendedDynamicStateSupported(VkPhysicalDevice physicalDevice) {
+    auto physicalDeviceProperties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+
+    return physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_3;
+}
+
+bool GpuDevice::supportsExtendedDynamicState() const {
+    return m_isExtendedDynamicStateSupported;
+}
+
+bool GpuDevice::isDrawIndirectCountSupported(VkPhysicalDevice physicalDevice) {
+    auto vulkan12Features = VkPhysicalDeviceVulkan12Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &vulkan12Features,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return features.features.multiDrawIndirect == VK_TRUE
+        && features.features.drawIndirectFirstInstance == VK_TRUE
+        && vulkan12Features.drawIndirectCount == VK_TRUE;
+}
+
+bool GpuDevice::supportsDrawIndirectCount() const {
+    return m_isDrawIndirectCountSupported;
+}
+
+bool GpuDevice::isBufferDeviceAddressSupported(VkPhysicalDevice physicalDevice, uint32_t deviceCount) {
+    auto vulkan12Features = VkPhysicalDeviceVulkan12Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &vulkan12Features,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return vulkan12Features.bufferDeviceAddress == VK_TRUE
+        && (deviceCount <= 1 || vulkan12Features.bufferDeviceAddressMultiDevice == VK_TRUE);
+}
+
+bool GpuDevice::supportsBufferDeviceAddress() const {
+    return m_isBufferDeviceAddressSupported;
+}
+
+VkDeviceAddress GpuDevice::getBufferDeviceAddress(VkBuffer buffer) const {
+    return m_memoryAllocator->getBufferDeviceAddress(buffer);
+}
+
+bool GpuDevice::isDescriptorBufferSupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    const auto hasDescriptorBufferExtension = std::any_of(
+        extensions.begin(),
+        extensions.end(),
+        [](const VkExtensionProperties& extension) {
+            return strcmp(extension.extensionName, VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME) == 0;
+        }
+    );
+    if (!hasDescriptorBufferExtension || !GpuDevice::isBufferDeviceAddressSupported(physicalDevice, 1)) {
+        return false;
     }
 
-    glfwDestroyWindow(dummyWindow);
-    dummyWindow = nullptr;
+    auto descriptorBufferFeatures = VkPhysicalDeviceDescriptorBufferFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &descriptorBufferFeatures,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return descriptorBufferFeatures.descriptorBuffer == VK_TRUE;
+}
 
-    m_dummySurface = dummySurface;
+bool GpuDevice::supportsDescriptorBuffer() const {
+    return m_isDescriptorBufferSupported;
 }
 
-void GpuDeviceInitializer::selectPhysicalDevice() {
-    const auto physicalDeviceSpecProvider = PhysicalDeviceSpecProvider {};
-    const auto physicalDeviceSpec = physicalDeviceSpecProvider.createPhysicalDeviceSpec();
-    
-    auto infoProvider = std::make_unique<PlatformInfoProvider>();
-    const auto physicalDeviceSelector = PhysicalDeviceSelector { m_instance, std::move(infoProvider) };
-    
-    const auto selectedPhysicalDevice = physicalDeviceSelector.selectPhysicalDeviceForSurface(
-        m_dummySurface,
-        physicalDeviceSpec
+bool GpuDevice::isGraphicsPipelineLibrarySupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    const auto hasExtension = [&extensions](const char* extensionName) {
+        return std::any_of(
+            extensions.begin(),
+            extensions.end(),
+            [extensionName](const VkExtensionProperties& extension) {
+                return strcmp(extension.extensionName, extensionName) == 0;
+            }
+        );
+    };
+    if (!hasExtension(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) || !hasExtension(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+        return false;
+    }
+
+    auto graphicsPipelineLibraryFeatures = VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &graphicsPipelineLibraryFeatures,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return graphicsPipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE;
+}
+
+bool GpuDevice::supportsGraphicsPipelineLibrary() const {
+    return m_isGraphicsPipelineLibrarySupported;
+}
+
+bool GpuDevice::isFragmentShadingRateSupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    const auto hasFragmentShadingRateExtension = std::any_of(
+        extensions.begin(),
+        extensions.end(),
+        [](const VkExtensionProperties& extension) {
+            return strcmp(extension.extensionName, VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME) == 0;
+        }
     );
+    if (!hasFragmentShadingRateExtension) {
+        return false;
+    }
 
-    m_physicalDevice = selectedPhysicalDevice;
+    auto fragmentShadingRateFeatures = VkPhysicalDeviceFragmentShadingRateFeaturesKHR {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &fragmentShadingRateFeatures,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return fragmentShadingRateFeatures.pipelineFragmentShadingRate == VK_TRUE;
 }
 
-void GpuDeviceInitializer::createLogicalDevice() {
-    const auto logicalDeviceSpecProvider = LogicalDeviceSpecProvider { m_physicalDevice, m_dummySurface };
-    const auto logicalDeviceSpec = logicalDeviceSpecProvider.createLogicalDeviceSpec();
+bool GpuDevice::isFragmentShadingRateAttachmentSupported(VkPhysicalDevice physicalDevice) {
+    if (!GpuDevice::isFragmentShadingRateSupported(physicalDevice)) {
+        return false;
+    }
 
-    auto infoProvider = std::make_unique<PlatformInfoProvider>();
-    auto factory = LogicalDeviceFactory { m_physicalDevice, m_dummySurface, std::move(infoProvider) };
-    
-    const auto [device, graphicsQueue, computeQueue, presentQueue] = factory.createLogicalDevice(logicalDeviceSpec);
+    auto fragmentShadingRateFeatures = VkPhysicalDeviceFragmentShadingRateFeaturesKHR {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &fragmentShadingRateFeatures,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
 
-    m_device = device;
-    m_graphicsQueue = graphicsQueue;
-    m_computeQueue = computeQueue;
-    m_presentQueue = presentQueue;
+    return fragmentShadingRateFeatures.attachmentFragmentShadingRate == VK_TRUE;
 }
 
-void GpuDeviceInitializer::createCommandPool() {
-    const auto queueFamilyIndices = this->findQueueFamilies(m_physicalDevice, m_dummySurface);
-    const auto poolInfo = VkCommandPoolCreateInfo {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-        .queueFamilyIndex = queueFamilyIndices.graphicsAndComputeFamily.value(),
+bool GpuDevice::supportsFragmentShadingRate() const {
+    return m_dispatch.vkCmdSetFragmentShadingRateKHR != nullptr;
+}
+
+bool GpuDevice::supportsFragmentShadingRateAttachment() const {
+    return m_dispatch.vkCmdSetFragmentShadingRateKHR != nullptr && m_isFragmentShadingRateAttachmentSupported;
+}
+
+VkPhysicalDeviceFragmentShadingRatePropertiesKHR GpuDevice::getFragmentShadingRateProperties() const {
+    auto fragmentShadingRateProperties = VkPhysicalDeviceFragmentShadingRatePropertiesKHR {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_PROPERTIES_KHR,
+        .pNext = nullptr,
+    };
+    auto properties = VkPhysicalDeviceProperties2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &fragmentShadingRateProperties,
     };
+    vkGetPhysicalDeviceProperties2(m_physicalDevice, &properties);
+
+    // The chain only lived as long as the query.
+    fragmentShadingRateProperties.pNext = nullptr;
+
+    return fragmentShadingRateProperties;
+}
+
+void GpuDevice::setFragmentShadingRate(
+    VkCommandBuffer commandBuffer,
+    VkExtent2D fragmentSize,
+    std::span<const VkFragmentShadingRateCombinerOpKHR, 2> combinerOps
+) const {
+    if (m_dispatch.vkCmdSetFragmentShadingRateKHR == nullptr) {
+        throw std::logic_error("fragment shading rate set on a device without fragment shading rates!");
+    }
+
+    m_dispatch.vkCmdSetFragmentShadingRateKHR(commandBuffer, &fragmentSize, combinerOps.data());
+}
+
+bool GpuDevice::isConditionalRenderingSupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    const auto hasExtension = std::any_of(
+        extensions.begin(),
+        extensions.end(),
+        [](const VkExtensionProperties& extension) {
+            return strcmp(extension.extensionName, VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME) == 0;
+        }
+    );
+    if (!hasExtension) {
+        return false;
+    }
+
+    auto conditionalRenderingFeatures = VkPhysicalDeviceConditionalRenderingFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_CONDITIONAL_RENDERING_FEATURES_EXT,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &conditionalRenderingFeatures,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return conditionalRenderingFeatures.conditionalRendering == VK_TRUE;
+}
+
+bool GpuDevice::isPerformanceQuerySupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    const auto hasExtension = std::any_of(
+        extensions.begin(),
+        extensions.end(),
+        [](const VkExtensionProperties& extension) {
+            return strcmp(extension.extensionName, VK_KHR_PERFORMANCE_QUERY_EXTENSION_NAME) == 0;
+        }
+    );
+    if (!hasExtension) {
+        return false;
+    }
+
+    auto performanceQueryFeatures = VkPhysicalDevicePerformanceQueryFeaturesKHR {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PERFORMANCE_QUERY_FEATURES_KHR,
+        .pNext = nullptr,
+    };
+    auto vulkan12Features = VkPhysicalDeviceVulkan12Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = &performanceQueryFeatures,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &vulkan12Features,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return performanceQueryFeatures.performanceCounterQueryPools == VK_TRUE && vulkan12Features.hostQueryReset == VK_TRUE;
+}
+
+bool GpuDevice::supportsConditionalRendering() const {
+    return m_dispatch.vkCmdBeginConditionalRenderingEXT != nullptr && m_dispatch.vkCmdEndConditionalRenderingEXT != nullptr;
+}
+
+void GpuDevice::beginConditionalRendering(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset) const {
+    if (!this->supportsConditionalRendering()) {
+        throw std::logic_error("conditional rendering begun on a device without conditional rendering!");
+    }
+
+    const auto conditionalRenderingInfo = VkConditionalRenderingBeginInfoEXT {
+        .sType = VK_STRUCTURE_TYPE_CONDITIONAL_RENDERING_BEGIN_INFO_EXT,
+        .pNext = nullptr,
+        .buffer = buffer,
+        .offset = offset,
+        .flags = 0,
+    };
+    m_dispatch.vkCmdBeginConditionalRenderingEXT(commandBuffer, &conditionalRenderingInfo);
+}
+
+void GpuDevice::endConditionalRendering(VkCommandBuffer commandBuffer) const {
+    if (!this->supportsConditionalRendering()) {
+        throw std::logic_error("conditional rendering ended on a device without conditional rendering!");
+    }
+
+    m_dispatch.vkCmdEndConditionalRenderingEXT(commandBuffer);
+}
+
+bool GpuDevice::isDescriptorIndexingSupported(VkPhysicalDevice physicalDevice) {
+    auto vulkan12Features = VkPhysicalDeviceVulkan12Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &vulkan12Features,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return features.features.shaderSampledImageArrayDynamicIndexing == VK_TRUE
+        && vulkan12Features.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE
+        && vulkan12Features.descriptorBindingUpdateUnusedWhilePending == VK_TRUE
+        && vulkan12Features.descriptorBindingPartiallyBound == VK_TRUE
+        && vulkan12Features.descriptorBindingVariableDescriptorCount == VK_TRUE
+        && vulkan12Features.runtimeDescriptorArray == VK_TRUE;
+}
+
+bool GpuDevice::isPresentWaitSupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    const auto hasExtension = [&extensions](const char* extensionName) {
+        return std::any_of(
+            extensions.begin(),
+            extensions.end(),
+            [extensionName](const VkExtensionProperties& extension) {
+                return strcmp(extension.extensionName, extensionName) == 0;
+            }
+        );
+    };
+    if (!hasExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME) || !hasExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+        return false;
+    }
+
+    auto presentIdFeatures = VkPhysicalDevicePresentIdFeaturesKHR {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+        .pNext = nullptr,
+    };
+    auto presentWaitFeatures = VkPhysicalDevicePresentWaitFeaturesKHR {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+        .pNext = &presentIdFeatures,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &presentWaitFeatures,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+}
+
+bool GpuDevice::supportsPresentWait() const {
+    return m_dispatch.vkWaitForPresentKHR != nullptr;
+}
+
+bool GpuDevice::isMemoryBudgetSupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    return std::any_of(
+        extensions.begin(),
+        extensions.end(),
+        [](const VkExtensionProperties& extension) {
+            return strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+        }
+    );
+}
+
+bool GpuDevice::isExternalMemoryFdSupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    const auto hasExtension = [&extensions](const char* extensionName) {
+        return std::any_of(
+            extensions.begin(),
+            extensions.end(),
+            [extensionName](const VkExtensionProperties& extension) {
+                return strcmp(extension.extensionName, extensionName) == 0;
+            }
+        );
+    };
+
+    return hasExtension(VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME) && hasExtension(VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME);
+}
+
+bool GpuDevice::supportsExternalMemoryFd() const {
+    return m_isExternalMemoryFdSupported;
+}
+
+bool GpuDevice::isMemoryPrioritySupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    const auto hasExtension = std::any_of(
+        extensions.begin(),
+        extensions.end(),
+        [](const VkExtensionProperties& extension) {
+            return strcmp(extension.extensionName, VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME) == 0;
+        }
+    );
+    if (!hasExtension) {
+        return false;
+    }
+
+    auto memoryPriorityFeatures = VkPhysicalDeviceMemoryPriorityFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PRIORITY_FEATURES_EXT,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &memoryPriorityFeatures,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return memoryPriorityFeatures.memoryPriority == VK_TRUE;
+}
+
+bool GpuDevice::isPageableDeviceLocalMemorySupported(VkPhysicalDevice physicalDevice) {
+    if (!GpuDevice::isMemoryPrioritySupported(physicalDevice)) {
+        return false;
+    }
+
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    const auto hasExtension = std::any_of(
+        extensions.begin(),
+        extensions.end(),
+        [](const VkExtensionProperties& extension) {
+            return strcmp(extension.extensionName, VK_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_EXTENSION_NAME) == 0;
+        }
+    );
+    if (!hasExtension) {
+        return false;
+    }
+
+    auto pageableDeviceLocalMemoryFeatures = VkPhysicalDevicePageableDeviceLocalMemoryFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PAGEABLE_DEVICE_LOCAL_MEMORY_FEATURES_EXT,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &pageableDeviceLocalMemoryFeatures,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return pageableDeviceLocalMemoryFeatures.pageableDeviceLocalMemory == VK_TRUE;
+}
+
+bool GpuDevice::isHostImageCopySupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    const auto hasExtension = std::any_of(
+        extensions.begin(),
+        extensions.end(),
+        [](const VkExtensionProperties& extension) {
+            return strcmp(extension.extensionName, VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME) == 0;
+        }
+    );
+    if (!hasExtension) {
+        return false;
+    }
+
+    auto hostImageCopyFeatures = VkPhysicalDeviceHostImageCopyFeaturesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &hostImageCopyFeatures,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return hostImageCopyFeatures.hostImageCopy == VK_TRUE;
+}
+
+bool GpuDevice::isPushDescriptorSupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    return std::any_of(
+        extensions.begin(),
+        extensions.end(),
+        [](const VkExtensionProperties& extension) {
+            return strcmp(extension.extensionName, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) == 0;
+        }
+    );
+}
+
+bool GpuDevice::isMaintenance5Supported(VkPhysicalDevice physicalDevice) {
+    // The extension depends on dynamic rendering, which is only core in Vulkan 1.3.
+    auto physicalDeviceProperties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+    if (physicalDeviceProperties.apiVersion < VK_API_VERSION_1_3) {
+        return false;
+    }
+
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties> { extensionCount };
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    const auto hasExtension = std::any_of(
+        extensions.begin(),
+        extensions.end(),
+        [](const VkExtensionProperties& extension) {
+            return strcmp(extension.extensionName, VK_KHR_MAINTENANCE_5_EXTENSION_NAME) == 0;
+        }
+    );
+    if (!hasExtension) {
+        return false;
+    }
+
+    auto maintenance5Features = VkPhysicalDeviceMaintenance5FeaturesKHR {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_5_FEATURES_KHR,
+        .pNext = nullptr,
+    };
+    auto features = VkPhysicalDeviceFeatures2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &maintenance5Features,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return maintenance5Features.maintenance5 == VK_TRUE;
+}
+
+bool GpuDevice::supportsMaintenance5() const {
+    return m_isMaintenance5Supported;
+}
+
+void GpuDevice::markLost() {
+    m_isLost = true;
+}
+
+bool GpuDevice::isLost() const {
+    return m_isLost;
+}
+
+VkResult GpuDevice::waitForPresent(VkSwapchainKHR swapChain, uint64_t presentId, uint64_t timeout) const {
+    if (m_dispatch.vkWaitForPresentKHR == nullptr) {
+        throw std::logic_error("present waited on a device without present waits!");
+    }
+
+    return m_dispatch.vkWaitForPresentKHR(m_device, swapChain, presentId, timeout);
+}
+
+bool GpuDevice::supportsMeshShading() const {
+    return m_dispatch.vkCmdDrawMeshTasksEXT != nullptr;
+}
+
+void GpuDevice::drawMeshTasks(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) const {
+    if (m_dispatch.vkCmdDrawMeshTasksEXT == nullptr) {
+        throw std::logic_error("mesh tasks drawn on a device without mesh shading!");
+    }
+
+    m_dispatch.vkCmdDrawMeshTasksEXT(commandBuffer, groupCountX, groupCountY, groupCountZ);
+    VulkanEngine::CommandCounters::add(VulkanEngine::CommandCounter::Draws);
+}
+
+std::tuple<VkBuffer, VulkanEngine::GpuAllocation> GpuDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) {
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto resultCreateBuffer = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+    if (resultCreateBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to create buffer!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    // A buffer that is only ever copied from host memory is staging, and a buffer with
+    // several uses is counted under the first of them.
+    const auto category = [usage]() {
+        if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) {
+            return GpuMemoryCategory::Vertex;
+        } else if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) {
+            return GpuMemoryCategory::Index;
+        } else if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+            return GpuMemoryCategory::Uniform;
+        } else if (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT || usage == VK_BUFFER_USAGE_TRANSFER_DST_BIT) {
+            return GpuMemoryCategory::Staging;
+        } else {
+            return GpuMemoryCategory::Other;
+        }
+    }();
+    const auto allocation = m_memoryAllocator->allocate(memRequirements, properties, GpuResourceKind::Linear, category);
+
+    vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+    return std::make_tuple(buffer, allocation);
+}
+
+std::optional<std::tuple<VkBuffer, VulkanEngine::GpuAllocation>> GpuDevice::createMovedBuffer(
+    const GpuAllocation& allocation,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage
+) {
+    if (!m_memoryAllocator->shouldMove(allocation)) {
+        return std::nullopt;
+    }
+
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto resultCreateBuffer = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+    if (resultCreateBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to create moved buffer!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    const auto movedAllocation = m_memoryAllocator->allocateForMove(allocation, memRequirements);
+    if (!movedAllocation.isValid()) {
+        vkDestroyBuffer(m_device, buffer, nullptr);
+
+        return std::nullopt;
+    }
+
+    vkBindBufferMemory(m_device, buffer, movedAllocation.memory, movedAllocation.offset);
+
+    return std::make_tuple(buffer, movedAllocation);
+}
+
+std::tuple<VkImage, VulkanEngine::GpuAllocation> GpuDevice::createImage(
+    uint32_t width,
+    uint32_t height,
+    uint32_t mipLevels,
+    VkSampleCountFlagBits numSamples,
+    VkFormat format,
+    VkImageTiling tiling,
+    VkImageUsageFlags usage,
+    VkMemoryPropertyFlags properties,
+    VkImageCreateFlags flags,
+    uint32_t arrayLayers,
+    uint32_t depth,
+    VkImageType imageType
+) {
+    // A mutable sRGB image is only ever viewed as itself and as its UNORM alias. Listing
+    // the two lets the driver keep the compression it would drop for any format at all.
+    const auto linearFormat = TextureFormats::getLinearFormat(format);
+    const auto viewFormats = std::array<VkFormat, 2> { format, linearFormat };
+    const auto formatListInfo = VkImageFormatListCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_LIST_CREATE_INFO,
+        .viewFormatCount = static_cast<uint32_t>(viewFormats.size()),
+        .pViewFormats = viewFormats.data(),
+    };
+    const auto hasFormatList = (flags & VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT) != 0 && linearFormat != VK_FORMAT_UNDEFINED;
+    const auto imageInfo = VkImageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = hasFormatList ? &formatListInfo : nullptr,
+        .flags = flags,
+        .imageType = imageType,
+        .extent.width = width,
+        .extent.height = height,
+        .extent.depth = depth,
+        .mipLevels = mipLevels,
+        .arrayLayers = arrayLayers,
+        .format = format,
+        .tiling = tiling,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .usage = usage,
+        .samples = numSamples,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto image = VkImage {};
+    const auto resultCreateImage = vkCreateImage(m_device, &imageInfo, nullptr, &image);
+    if (resultCreateImage != VK_SUCCESS) {
+        throw std::runtime_error("failed to create image!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetImageMemoryRequirements(m_device, image, &memRequirements);
+
+    const auto resourceKind = [tiling]() {
+        if (tiling == VK_IMAGE_TILING_OPTIMAL) {
+            return GpuResourceKind::Optimal;
+        } else {
+            return GpuResourceKind::Linear;
+        }
+    }();
+    const auto category = [usage]() {
+        const auto attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        if (usage & attachmentUsage) {
+            return GpuMemoryCategory::Attachment;
+        } else if (usage & VK_IMAGE_USAGE_SAMPLED_BIT) {
+            return GpuMemoryCategory::Texture;
+        } else {
+            return GpuMemoryCategory::Other;
+        }
+    }();
+    const auto allocation = m_memoryAllocator->allocate(memRequirements, properties, resourceKind, category);
+
+    vkBindImageMemory(m_device, image, allocation.memory, allocation.offset);
+
+    return std::make_tuple(image, allocation);
+}
+
+void GpuDevice::destroyBuffer(VkBuffer buffer, const GpuAllocation& allocation) {
+    vkDestroyBuffer(m_device, buffer, nullptr);
+    m_memoryAllocator->free(allocation);
+}
+
+void GpuDevice::destroyImage(VkImage image, const GpuAllocation& allocation) {
+    vkDestroyImage(m_device, image, nullptr);
+    m_memoryAllocator->free(allocation);
+}
+
+std::tuple<VkImage, VulkanEngine::GpuAllocation> GpuDevice::createTransientAttachment(
+    uint32_t width,
+    uint32_t height,
+    VkSampleCountFlagBits numSamples,
+    VkFormat format,
+    VkImageUsageFlags usage,
+    uint32_t arrayLayers
+) {
+    const auto imageInfo = VkImageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .extent.width = width,
+        .extent.height = height,
+        .extent.depth = 1,
+        .mipLevels = 1,
+        .arrayLayers = arrayLayers,
+        .format = format,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .usage = usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+        .samples = numSamples,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto image = VkImage {};
+    const auto resultCreateImage = vkCreateImage(m_device, &imageInfo, nullptr, &image);
+    if (resultCreateImage != VK_SUCCESS) {
+        throw std::runtime_error("failed to create transient attachment image!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetImageMemoryRequirements(m_device, image, &memRequirements);
+
+    // Lazily allocated memory is only committed when the attachment has to leave tile
+    // memory, so on tilers it usually never is.
+    const auto& memoryProperties = m_memoryAllocator->getMemoryProperties();
+    auto hasLazilyAllocatedMemory = false;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        const auto isLazilyAllocated = (memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+        if ((memRequirements.memoryTypeBits & (1 << i)) && isLazilyAllocated) {
+            hasLazilyAllocatedMemory = true;
+            break;
+        }
+    }
+
+    const auto properties = [hasLazilyAllocatedMemory]() -> VkMemoryPropertyFlags {
+        if (hasLazilyAllocatedMemory) {
+            return VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+        } else {
+            return VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        }
+    }();
+    const auto allocation = m_memoryAllocator->allocate(memRequirements, properties, GpuResourceKind::Optimal, GpuMemoryCategory::Attachment);
+
+    vkBindImageMemory(m_device, image, allocation.memory, allocation.offset);
+
+    return std::make_tuple(image, allocation);
+}
+
+
+using GpuDeviceInitializer = VulkanEngine::GpuDeviceInitializer;
+using DeviceSelection = VulkanEngine::DeviceSelection;
+using DeviceGroupMode = VulkanEngine::DeviceGroupMode;
+
+GpuDeviceInitializer::GpuDeviceInitializer(
+    VkInstance instance,
+    std::shared_ptr<PlatformInfoProvider> infoProvider,
+    const VkAllocationCallbacks* allocationCallbacks,
+    bool isHeadless,
+    const DeviceSelection& deviceSelection
+)
+    : m_instance { instance }
+    , m_infoProvider { std::move(infoProvider) }
+    , m_allocationCallbacks { allocationCallbacks }
+    , m_isHeadless { isHeadless }
+    , m_deviceSelection { deviceSelection }
+{
+}
+
+GpuDeviceInitializer::~GpuDeviceInitializer() {
+    m_allocationCallbacks = nullptr;
+    m_infoProvider = nullptr;
+    m_instance = VK_NULL_HANDLE;
+}
+
+std::unique_ptr<GpuDevice> GpuDeviceInitializer::createGpuDevice() {
+    auto startupTimeline = StartupTimeline {};
+    this->selectPhysicalDevice();
+    startupTimeline.mark("select physical device");
+    this->createLogicalDevice();
+    startupTimeline.mark("create logical device");
+    this->createCommandPool();
+    startupTimeline.mark("create command pools");
+
+    const auto queueFamilyIndices = this->findQueueFamilies(m_physicalDevice);
+    auto gpuDevice = std::make_unique<GpuDevice>(
+        m_instance,
+        m_physicalDevice,
+        m_device,
+        m_graphicsQueue,
+        m_computeQueue,
+        m_presentQueue,
+        m_transferQueue,
+        m_commandPool,
+        m_uploadCommandPool,
+        m_transferCommandPool,
+        m_computeCommandPool,
+        queueFamilyIndices,
+        std::max(static_cast<uint32_t>(m_deviceGroup.size()), uint32_t { 1 }),
+        m_allocationCallbacks
+    );
+    startupTimeline.mark("create device allocator and upload context");
+
+    return gpuDevice;
+}
+
+QueueFamilyIndices GpuDeviceInitializer::findQueueFamilies(VkPhysicalDevice physicalDevice) const {
+    return QueueFamilyIndices::find(physicalDevice, [this, physicalDevice](uint32_t queueFamily) -> bool {
+        return !m_isHeadless && glfwGetPhysicalDevicePresentationSupport(m_instance, physicalDevice, queueFamily) == GLFW_TRUE;
+    });
+}
+
+void GpuDeviceInitializer::selectPhysicalDevice() {
+    const auto physicalDeviceSpecProvider = PhysicalDeviceSpecProvider {
+        !m_isHeadless,
+        m_deviceSelection.preferredDevice,
+        m_deviceSelection.deviceRank
+    };
+    const auto physicalDeviceSpec = physicalDeviceSpecProvider.createPhysicalDeviceSpec();
+    
+    const auto physicalDeviceSelector = PhysicalDeviceSelector { m_instance, m_infoProvider };
+    
+    const auto selectedPhysicalDevice = physicalDeviceSelector.selectPhysicalDevice(physicalDeviceSpec);
+    const auto deviceGroup = [&physicalDeviceSelector, selectedPhysicalDevice, this]() -> std::vector<VkPhysicalDevice> {
+        if (m_deviceSelection.deviceGroupMode != DeviceGroupMode::None) {
+            return physicalDeviceSelector.findDeviceGroup(selectedPhysicalDevice);
+        } else {
+            return std::vector<VkPhysicalDevice> {};
+        }
+    }();
+
+    m_physicalDevice = selectedPhysicalDevice;
+    m_deviceGroup = deviceGroup;
+}
+
+void GpuDeviceInitializer::createLogicalDevice() {
+    const auto logicalDeviceSpecProvider = LogicalDeviceSpecProvider { m_physicalDevice, m_isHeadless };
+    const auto logicalDeviceSpec = logicalDeviceSpecProvider.createLogicalDeviceSpec();
+
+    auto factory = LogicalDeviceFactory {
+        m_instance,
+        m_physicalDevice,
+        m_isHeadless,
+        m_deviceGroup,
+        m_infoProvider,
+        m_allocationCallbacks
+    };
+    
+    const auto [device, graphicsQueue, computeQueue, presentQueue, transferQueue] = factory.createLogicalDevice(logicalDeviceSpec);
+
+    m_device = device;
+    m_graphicsQueue = graphicsQueue;
+    m_computeQueue = computeQueue;
+    m_presentQueue = presentQueue;
+    m_transferQueue = transferQueue;
+}
+
+void GpuDeviceInitializer::createCommandPool() {
+    // The general pool holds long-lived command buffers that are recorded again one at a
+    // time. Per-frame command buffers live in pools of their own that are reset wholesale.
+    const auto queueFamilyIndices = this->findQueueFamilies(m_physicalDevice);
+    const auto poolInfo = VkCommandPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = queueFamilyIndices.graphicsAndComputeFamily.value(),
+    };
+
+    auto commandPool = VkCommandPool {};
+    const auto result = vkCreateCommandPool(m_device, &poolInfo, m_allocationCallbacks, &commandPool);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create command pool!");
+    }
+
+    // Upload command buffers are recorded once and freed, so the upload pools are transient,
+    // and the graphics half of upload batches stays out of the general pool.
+    const auto uploadPoolInfo = VkCommandPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = queueFamilyIndices.graphicsAndComputeFamily.value(),
+    };
+
+    auto uploadCommandPool = VkCommandPool {};
+    const auto resultUpload = vkCreateCommandPool(m_device, &uploadPoolInfo, m_allocationCallbacks, &uploadCommandPool);
+    if (resultUpload != VK_SUCCESS) {
+        vkDestroyCommandPool(m_device, commandPool, m_allocationCallbacks);
+
+        throw std::runtime_error("failed to create upload command pool!");
+    }
+
+    const auto transferPoolInfo = VkCommandPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = queueFamilyIndices.transferFamily.value_or(queueFamilyIndices.graphicsAndComputeFamily.value()),
+    };
+
+    auto transferCommandPool = VkCommandPool {};
+    const auto resultTransfer = vkCreateCommandPool(m_device, &transferPoolInfo, m_allocationCallbacks, &transferCommandPool);
+    if (resultTransfer != VK_SUCCESS) {
+        vkDestroyCommandPool(m_device, uploadCommandPool, m_allocationCallbacks);
+        vkDestroyCommandPool(m_device, commandPool, m_allocationCallbacks);
+
+        throw std::runtime_error("failed to create transfer command pool!");
+    }
+
+    const auto computePoolInfo = VkCommandPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = queueFamilyIndices.computeFamily.value_or(queueFamilyIndices.graphicsAndComputeFamily.value()),
+    };
+
+    auto computeCommandPool = VkCommandPool {};
+    const auto resultCompute = vkCreateCommandPool(m_device, &computePoolInfo, m_allocationCallbacks, &computeCommandPool);
+    if (resultCompute != VK_SUCCESS) {
+        vkDestroyCommandPool(m_device, transferCommandPool, m_allocationCallbacks);
+        vkDestroyCommandPool(m_device, uploadCommandPool, m_allocationCallbacks);
+        vkDestroyCommandPool(m_device, commandPool, m_allocationCallbacks);
+
+        throw std::runtime_error("failed to create compute command pool!");
+    }
+
+    m_commandPool = commandPool;
+    m_uploadCommandPool = uploadCommandPool;
+    m_transferCommandPool = transferCommandPool;
+    m_computeCommandPool = computeCommandPool;
+}
+
+
+using Engine = VulkanEngine::Engine;
+using EngineMode = VulkanEngine::EngineMode;
+
+Engine::~Engine() {
+    for (const auto surface : m_viewportSurfaces) {
+        vkDestroySurfaceKHR(m_instance, surface, nullptr);
+    }
+    m_viewportSurfaces.clear();
+    m_windowSystem.reset();
+    m_gpuDevice.reset();
+    m_debugMessenger.reset();
+
+    vkDestroyInstance(m_instance, m_hostAllocator->getCallbacks());
+
+    m_systemFactory.reset();
+    m_infoProvider.reset();
+
+    // The instance was the last object backed by the host allocator, so the high-water
+    // marks are final, and whatever is still live was leaked.
+    if (m_enableValidationLayers) {
+        m_hostAllocator->printReport();
+    }
+    m_hostAllocator.reset();
 
-    auto commandPool = VkCommandPool {};
-    const auto result = vkCreateCommandPool(m_device, &poolInfo, nullptr, &commandPool);
-    if (result != VK_SUCCESS) {
-        throw std::runtime_error("failed to create command pool!");
+    if (!m_isHeadless) {
+        glfwTerminate();
     }
+}
 
-    m_commandPool = commandPool;
+std::unique_ptr<Engine> Engine::createDebugMode(const DeviceSelection& deviceSelection) {
+    return Engine::create(EngineMode::Debug, false, deviceSelection);
+}
+
+std::unique_ptr<Engine> Engine::createReleaseMode(const DeviceSelection& deviceSelection) {
+    return Engine::create(EngineMode::Release, false, deviceSelection);
 }
 
+std::unique_ptr<Engine> Engine::createHeadlessDebugMode(const DeviceSelection& deviceSelection) {
+    return Engine::create(EngineMode::Debug, true, deviceSelection);
+}
 
-using Engine = VulkanEngine::Engine;
+std::unique_ptr<Engine> Engine::createHeadlessReleaseMode(const DeviceSelection& deviceSelection) {
+    return Engine::create(EngineMode::Release, true, deviceSelection);
+}
 
-Engine::~Engine() {
-    m_windowSystem.reset();
-    m_gpuDevice.reset();
-    m_debugMessenger.reset();
+EngineMode Engine::parseEngineMode(const std::string& name) {
+    if (name == "release") {
+        return EngineMode::Release;
+    } else if (name == "debug") {
+        return EngineMode::Debug;
+    } else if (name == "gpu-assisted") {
+        return EngineMode::GpuAssistedValidation;
+    } else {
+        throw std::invalid_argument(fmt::format("unknown engine mode: {}", name));
+    }
+}
+
+EngineMode Engine::getEngineModeFromEnvironment(EngineMode defaultMode) {
+    const char* name = std::getenv("VULKAN_ENGINE_MODE");
+    if (name == nullptr || *name == '\0') {
+        return defaultMode;
+    }
 
-    vkDestroyInstance(m_instance, nullptr);
+    return Engine::parseEngineMode(std::string { name });
+}
 
-    m_systemFactory.reset();
-    m_infoProvider.reset();
+bool Engine::isHeadless() const {
+    return m_isHeadless;
+}
 
-    glfwTerminate();
+EngineMode Engine::getEngineMode() const {
+    return m_engineMode;
 }
 
-std::unique_ptr<Engine> Engine::createDebugMode() {
-    return Engine::create(true);
+uint32_t Engine::getDeviceCount() const {
+    return m_gpuDevice->getDeviceCount();
 }
 
-std::unique_ptr<Engine> Engine::createReleaseMode() {
-    return Engine::create(false);
+VulkanEngine::DeviceGroupMode Engine::getDeviceGroupMode() const {
+    if (m_gpuDevice->getDeviceCount() > 1) {
+        return m_deviceSelection.deviceGroupMode;
+    } else {
+        return DeviceGroupMode::None;
+    }
 }
 
 VkInstance Engine::getInstance() const {
     return m_instance;
 }
 
+const VkAllocationCallbacks* Engine::getAllocationCallbacks() const {
+    return m_hostAllocator->getCallbacks();
+}
+
 VkPhysicalDevice Engine::getPhysicalDevice() const {
     return m_gpuDevice->getPhysicalDevice();
 }
 
+const VulkanEngine::DeviceCapabilities& Engine::getDeviceCapabilities() const {
+    return m_gpuDevice->getDeviceCapabilities();
+}
+
 VkDevice Engine::getLogicalDevice() const {
     return m_gpuDevice->getLogicalDevice();
 }
@@ -1417,10 +3731,28 @@ VkQueue Engine::getPresentQueue() const {
     return m_gpuDevice->getPresentQueue();
 }
 
+VkQueue Engine::getTransferQueue() const {
+    return m_gpuDevice->getTransferQueue();
+}
+
 VkCommandPool Engine::getCommandPool() const {
     return m_gpuDevice->getCommandPool();
 }
 
+uint32_t Engine::getGraphicsQueueFamilyIndex() const {
+    return m_gpuDevice->getQueueFamilyIndices().graphicsAndComputeFamily.value();
+}
+
+uint32_t Engine::getPresentQueueFamilyIndex() const {
+    return m_gpuDevice->getQueueFamilyIndices().presentFamily.value();
+}
+
+uint32_t Engine::getComputeQueueFamilyIndex() const {
+    const auto& queueFamilyIndices = m_gpuDevice->getQueueFamilyIndices();
+
+    return queueFamilyIndices.computeFamily.value_or(queueFamilyIndices.graphicsAndComputeFamily.value());
+}
+
 VkSurfaceKHR Engine::getSurface() const {
     return m_surface;
 }
@@ -1441,6 +3773,46 @@ void Engine::setFramebufferResized(bool framebufferResized) {
     m_windowSystem->setFramebufferResized(framebufferResized);
 }
 
+uint64_t Engine::getWindowEventCount() const {
+    return m_windowSystem->getWindowEventCount();
+}
+
+bool Engine::isWindowFocused() const {
+    return m_windowSystem->isFocused();
+}
+
+bool Engine::isWindowIconified() const {
+    return m_windowSystem->isIconified();
+}
+
+VkExtent2D Engine::getFramebufferExtent() const {
+    return m_windowSystem->getFramebufferExtent();
+}
+
+bool Engine::isKeyDown(int key) const {
+    return m_windowSystem->isKeyDown(key);
+}
+
+bool Engine::isWindowCloseRequested() const {
+    return m_windowSystem->isCloseRequested();
+}
+
+void Engine::pollWindowEvents() {
+    m_windowSystem->pollEvents();
+}
+
+void Engine::waitWindowEvents(std::optional<double> timeoutSeconds) {
+    m_windowSystem->waitEvents(timeoutSeconds);
+}
+
+void Engine::runWindowEventPump(const std::function<void()>& render) {
+    m_windowSystem->runEventPump(render);
+}
+
+void Engine::setWindowTitle(const std::string& title) {
+    m_windowSystem->setWindowTitle(title);
+}
+
 bool Engine::isInitialized() const {
     return m_instance != VK_NULL_HANDLE;
 }
@@ -1456,20 +3828,32 @@ void Engine::createGLFWLibrary() {
     }
 }
 
+void Engine::createHostAllocator() {
+    auto hostAllocator = std::make_unique<HostAllocator>();
+
+    m_hostAllocator = std::move(hostAllocator);
+}
+
 void Engine::createInfoProvider() {
-    auto infoProvider = std::make_unique<PlatformInfoProvider>();
+    auto infoProvider = std::make_shared<PlatformInfoProvider>();
 
     m_infoProvider = std::move(infoProvider);
 }
 
 void Engine::createSystemFactory() {
-    auto systemFactory = std::make_unique<SystemFactory>();
+    auto systemFactory = std::make_unique<SystemFactory>(m_infoProvider, m_hostAllocator->getCallbacks());
 
     m_systemFactory = std::move(systemFactory);
 }
 
 void Engine::createInstance() {
-    const auto instanceSpecProvider = InstanceSpecProvider { m_enableValidationLayers, m_enableDebuggingExtensions };
+    const auto instanceSpecProvider = InstanceSpecProvider {
+        m_enableValidationLayers,
+        m_enableGpuAssistedValidation,
+        m_enableDebuggingExtensions,
+        m_isHeadless,
+        !m_isHeadless && m_infoProvider->isInstanceExtensionAvailable(VK_EXT_SWAPCHAIN_COLOR_SPACE_EXTENSION_NAME)
+    };
     const auto instanceSpec = instanceSpecProvider.createInstanceSpec();
     const auto instance = m_systemFactory->create(instanceSpec);
         
@@ -1487,61 +3871,107 @@ void Engine::createDebugMessenger() {
         return;
     }
 
-    auto debugMessenger = VulkanDebugMessenger::create(m_instance);
+    auto debugMessenger = VulkanDebugMessenger::create(m_instance, m_hostAllocator->getCallbacks());
 
     m_debugMessenger = std::move(debugMessenger);
 }
 
 void Engine::createWindow(uint32_t width, uint32_t height, const std::string& title) {
+    if (m_isHeadless) {
+        throw std::logic_error("created a window on a headless engine!");
+    }
+
+    auto startupTimeline = StartupTimeline {};
     m_windowSystem->createWindow(width, height, title);
+    startupTimeline.mark("create window");
        
     this->createRenderSurface();
+    startupTimeline.mark("create render surface");
 }
 
-void Engine::createGpuDevice() {
-    auto gpuDeviceInitializer = GpuDeviceInitializer { m_instance };
-    auto gpuDevice = gpuDeviceInitializer.createGpuDevice();
+uint32_t Engine::createViewportWindow(uint32_t width, uint32_t height, const std::string& title) {
+    if (m_isHeadless) {
+        throw std::logic_error("created a viewport window on a headless engine!");
+    }
 
-    m_gpuDevice = std::move(gpuDevice);
+    const auto viewport = m_windowSystem->createViewportWindow(width, height, title);
+    auto surfaceProvider = m_windowSystem->createViewportSurfaceProvider(viewport);
+    const auto surface = surfaceProvider.createSurface();
+
+    // Every window presents from the one present queue, together with the main window.
+    const auto presentFamily = m_gpuDevice->getQueueFamilyIndices().presentFamily.value();
+    VkBool32 presentSupport = false;
+    vkGetPhysicalDeviceSurfaceSupportKHR(m_gpuDevice->getPhysicalDevice(), presentFamily, surface, &presentSupport);
+    if (!presentSupport) {
+        vkDestroySurfaceKHR(m_instance, surface, nullptr);
+
+        throw std::runtime_error("failed to find a present queue that supports the viewport window surface!");
+    }
+
+    m_viewportSurfaces.push_back(surface);
+
+    return viewport;
 }
 
-void Engine::createRenderSurface() {
-    auto surfaceProvider = m_windowSystem->createSurfaceProvider();
-    const auto surface = m_gpuDevice->createRenderSurface(surfaceProvider);
+uint32_t Engine::getViewportCount() const {
+    return static_cast<uint32_t>(m_viewportSurfaces.size());
+}
 
-    m_surface = surface;
+VkSurfaceKHR Engine::getViewportSurface(uint32_t viewport) const {
+    return m_viewportSurfaces.at(viewport);
 }
 
-QueueFamilyIndices Engine::findQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const {
-    auto indices = QueueFamilyIndices {};
+VkExtent2D Engine::getViewportExtent(uint32_t viewport) const {
+    return m_windowSystem->getViewportExtent(viewport);
+}
 
-    uint32_t queueFamilyCount = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+bool Engine::hasViewportResized(uint32_t viewport) const {
+    return m_windowSystem->hasViewportResized(viewport);
+}
 
-    auto queueFamilies = std::vector<VkQueueFamilyProperties> { queueFamilyCount };
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+void Engine::setViewportResized(uint32_t viewport, bool viewportResized) {
+    m_windowSystem->setViewportResized(viewport, viewportResized);
+}
 
-    int i = 0;
-    for (const auto& queueFamily : queueFamilies) {
-        if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
-            indices.graphicsAndComputeFamily = i;
-        }
+void Engine::createGpuDevice() {
+    auto gpuDeviceInitializer = GpuDeviceInitializer {
+        m_instance,
+        m_infoProvider,
+        m_hostAllocator->getCallbacks(),
+        m_isHeadless,
+        m_deviceSelection
+    };
+    auto gpuDevice = gpuDeviceInitializer.createGpuDevice();
 
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
+    m_gpuDevice = std::move(gpuDevice);
+}
 
-        if (presentSupport) {
-            indices.presentFamily = i;
-        }
+void Engine::recreateGpuDevice() {
+    auto startupTimeline = StartupTimeline {};
+    m_gpuDevice.reset();
+    startupTimeline.mark("destroy lost device");
+    this->createGpuDevice();
+    startupTimeline.skip();
+    if (!m_isHeadless && m_windowSystem->getWindow() != nullptr) {
+        this->createRenderSurface();
+        startupTimeline.mark("create render surface");
+    }
+}
 
-        if (indices.isComplete()) {
-            break;
-        }
+void Engine::createRenderSurface() {
+    auto surfaceProvider = m_windowSystem->createSurfaceProvider();
+    const auto surface = m_gpuDevice->createRenderSurface(surfaceProvider);
 
-        i++;
+    // The present family was picked from GLFW's presentation support before the window
+    // existed, so the surface it actually presents to is checked against it here.
+    const auto presentFamily = m_gpuDevice->getQueueFamilyIndices().presentFamily.value();
+    VkBool32 presentSupport = false;
+    vkGetPhysicalDeviceSurfaceSupportKHR(m_gpuDevice->getPhysicalDevice(), presentFamily, surface, &presentSupport);
+    if (!presentSupport) {
+        throw std::runtime_error("failed to find a present queue that supports the window surface!");
     }
 
-    return indices;
+    m_surface = surface;
 }
 
 SwapChainSupportDetails Engine::querySwapChainSupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const {
@@ -1567,6 +3997,106 @@ SwapChainSupportDetails Engine::querySwapChainSupport(VkPhysicalDevice physicalD
     return details;
 }
 
+VkPresentModeKHR Engine::selectPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, PresentModePolicy policy) {
+    const auto preferredPresentModes = [policy]() -> std::vector<VkPresentModeKHR> {
+        switch (policy) {
+            case PresentModePolicy::Immediate: return { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR };
+            case PresentModePolicy::FifoRelaxed: return { VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+            case PresentModePolicy::Mailbox: return { VK_PRESENT_MODE_MAILBOX_KHR };
+            case PresentModePolicy::Fifo: return {};
+        }
+
+        return {};
+    }();
+
+    for (const auto& preferredPresentMode : preferredPresentModes) {
+        const auto found = std::find(availablePresentModes.begin(), availablePresentModes.end(), preferredPresentMode);
+        if (found != availablePresentModes.end()) {
+            return preferredPresentMode;
+        }
+    }
+
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+uint32_t Engine::selectSwapChainImageCount(
+    const VkSurfaceCapabilitiesKHR& capabilities,
+    VkPresentModeKHR presentMode,
+    uint32_t framesInFlight,
+    SwapChainImageCountPolicy policy
+) {
+    const auto imageCount = [&capabilities, presentMode, framesInFlight, policy]() -> uint32_t {
+        switch (policy) {
+            case SwapChainImageCountPolicy::Driver: return capabilities.minImageCount + 1;
+            case SwapChainImageCountPolicy::Double: return 2;
+            case SwapChainImageCountPolicy::Triple: return 3;
+            case SwapChainImageCountPolicy::Matched: {
+                const auto queuedImageCount = presentMode == VK_PRESENT_MODE_MAILBOX_KHR ? 1u : 0u;
+
+                return 1 + framesInFlight + queuedImageCount;
+            }
+        }
+
+        return capabilities.minImageCount + 1;
+    }();
+
+    // A maximum of zero means that the surface takes any count.
+    if (capabilities.maxImageCount > 0) {
+        return std::clamp(imageCount, capabilities.minImageCount, capabilities.maxImageCount);
+    }
+
+    return std::max(imageCount, capabilities.minImageCount);
+}
+
+VkSurfaceFormatKHR Engine::selectSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats, SurfaceFormatPolicy policy) {
+    if (availableFormats.empty()) {
+        throw std::invalid_argument("surface has no formats to select from!");
+    }
+
+    const auto sdrFormats = std::vector<VkSurfaceFormatKHR> {
+        VkSurfaceFormatKHR { VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+        VkSurfaceFormatKHR { VK_FORMAT_R8G8B8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+    };
+    const auto sdr10Formats = std::vector<VkSurfaceFormatKHR> {
+        VkSurfaceFormatKHR { VK_FORMAT_A2B10G10R10_UNORM_PACK32, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+        VkSurfaceFormatKHR { VK_FORMAT_A2R10G10B10_UNORM_PACK32, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+    };
+    const auto hdr10Formats = std::vector<VkSurfaceFormatKHR> {
+        VkSurfaceFormatKHR { VK_FORMAT_A2B10G10R10_UNORM_PACK32, VK_COLOR_SPACE_HDR10_ST2084_EXT },
+        VkSurfaceFormatKHR { VK_FORMAT_A2R10G10B10_UNORM_PACK32, VK_COLOR_SPACE_HDR10_ST2084_EXT },
+    };
+    const auto scRgbFormats = std::vector<VkSurfaceFormatKHR> {
+        VkSurfaceFormatKHR { VK_FORMAT_R16G16B16A16_SFLOAT, VK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT },
+    };
+    const auto preferredFormatGroups = [&, policy]() -> std::vector<std::vector<VkSurfaceFormatKHR>> {
+        switch (policy) {
+            case SurfaceFormatPolicy::Sdr: return { sdrFormats };
+            case SurfaceFormatPolicy::Sdr10: return { sdr10Formats, sdrFormats };
+            case SurfaceFormatPolicy::Hdr10: return { hdr10Formats, scRgbFormats, sdr10Formats, sdrFormats };
+            case SurfaceFormatPolicy::ScRgb: return { scRgbFormats, hdr10Formats, sdr10Formats, sdrFormats };
+        }
+
+        return { sdrFormats };
+    }();
+
+    for (const auto& preferredFormats : preferredFormatGroups) {
+        for (const auto& preferredFormat : preferredFormats) {
+            const auto found = std::find_if(
+                availableFormats.begin(),
+                availableFormats.end(),
+                [&preferredFormat](const VkSurfaceFormatKHR& availableFormat) {
+                    return availableFormat.format == preferredFormat.format && availableFormat.colorSpace == preferredFormat.colorSpace;
+                }
+            );
+            if (found != availableFormats.end()) {
+                return *found;
+            }
+        }
+    }
+
+    return availableFormats[0];
+}
+
 VkShaderModule Engine::createShaderModuleFromFile(const std::string& fileName) {
     return m_gpuDevice->createShaderModuleFromFile(fileName);
 }
@@ -1583,24 +4113,289 @@ VkShaderModule Engine::createShaderModule(const std::vector<unsigned char>& code
     return m_gpuDevice->createShaderModule(code);
 }
 
-std::unique_ptr<Engine> Engine::create(bool enableDebugging) {
-    auto newEngine = std::make_unique<Engine>();
+VkShaderModule Engine::createShaderModule(std::span<const uint32_t> code) {
+    return m_gpuDevice->createShaderModule(code);
+}
 
-    if (enableDebugging) {
-        newEngine->m_enableValidationLayers = true;
-        newEngine->m_enableDebuggingExtensions = true;
-    } else {
-        newEngine->m_enableValidationLayers = false;
-        newEngine->m_enableDebuggingExtensions = false;
+void Engine::releaseShaderModule(VkShaderModule shaderModule) {
+    m_gpuDevice->releaseShaderModule(shaderModule);
+}
+
+std::tuple<VkBuffer, VulkanEngine::GpuAllocation> Engine::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) {
+    return m_gpuDevice->createBuffer(size, usage, properties);
+}
+
+std::optional<std::tuple<VkBuffer, VulkanEngine::GpuAllocation>> Engine::createMovedBuffer(
+    const GpuAllocation& allocation,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage
+) {
+    return m_gpuDevice->createMovedBuffer(allocation, size, usage);
+}
+
+std::tuple<VkImage, VulkanEngine::GpuAllocation> Engine::createImage(
+    uint32_t width,
+    uint32_t height,
+    uint32_t mipLevels,
+    VkSampleCountFlagBits numSamples,
+    VkFormat format,
+    VkImageTiling tiling,
+    VkImageUsageFlags usage,
+    VkMemoryPropertyFlags properties,
+    VkImageCreateFlags flags,
+    uint32_t arrayLayers,
+    uint32_t depth,
+    VkImageType imageType
+) {
+    return m_gpuDevice->createImage(width, height, mipLevels, numSamples, format, tiling, usage, properties, flags, arrayLayers, depth, imageType);
+}
+
+void Engine::destroyBuffer(VkBuffer buffer, const GpuAllocation& allocation) {
+    m_gpuDevice->destroyBuffer(buffer, allocation);
+}
+
+void Engine::destroyImage(VkImage image, const GpuAllocation& allocation) {
+    m_gpuDevice->destroyImage(image, allocation);
+}
+
+std::tuple<VkImage, VulkanEngine::GpuAllocation> Engine::createTransientAttachment(
+    uint32_t width,
+    uint32_t height,
+    VkSampleCountFlagBits numSamples,
+    VkFormat format,
+    VkImageUsageFlags usage,
+    uint32_t arrayLayers
+) {
+    return m_gpuDevice->createTransientAttachment(width, height, numSamples, format, usage, arrayLayers);
+}
+
+VulkanEngine::GpuMemoryAllocator& Engine::getMemoryAllocator() {
+    return m_gpuDevice->getMemoryAllocator();
+}
+
+VulkanEngine::QueueSubmitter& Engine::getQueueSubmitter() {
+    return m_gpuDevice->getQueueSubmitter();
+}
+
+VulkanEngine::StagingRing& Engine::getStagingRing() {
+    return m_gpuDevice->getStagingRing();
+}
+
+VulkanEngine::SamplerCache& Engine::getSamplerCache() {
+    return m_gpuDevice->getSamplerCache();
+}
+
+VulkanEngine::PipelineLayoutCache& Engine::getPipelineLayoutCache() {
+    return m_gpuDevice->getPipelineLayoutCache();
+}
+
+const VulkanEngine::DeviceDispatch& Engine::getDeviceDispatch() const {
+    return m_gpuDevice->getDeviceDispatch();
+}
+
+VulkanEngine::UploadContext& Engine::getUploadContext() {
+    return m_gpuDevice->getUploadContext();
+}
+
+void Engine::createPipelineCache(const std::filesystem::path& filePath) {
+    m_gpuDevice->createPipelineCache(filePath);
+}
+
+VkPipelineCache Engine::getPipelineCache() const {
+    return m_gpuDevice->getPipelineCache();
+}
+
+void Engine::createPipelineCompiler(uint32_t threadCount) {
+    m_gpuDevice->createPipelineCompiler(threadCount);
+}
+
+VulkanEngine::PipelineCompiler& Engine::getPipelineCompiler() {
+    return m_gpuDevice->getPipelineCompiler();
+}
+
+void Engine::createMipmapGenerator(
+    std::span<const uint32_t> shaderCode,
+    std::span<const uint32_t> filterShaderCode,
+    std::span<const uint32_t> volumeShaderCode
+) {
+    m_gpuDevice->createMipmapGenerator(shaderCode, filterShaderCode, volumeShaderCode);
+}
+
+VulkanEngine::MipmapGenerator* Engine::getMipmapGenerator() const {
+    return m_gpuDevice->getMipmapGenerator();
+}
+
+void Engine::createTextureCompressor(std::span<const uint32_t> shaderCode) {
+    m_gpuDevice->createTextureCompressor(shaderCode);
+}
+
+VulkanEngine::TextureCompressor* Engine::getTextureCompressor() const {
+    return m_gpuDevice->getTextureCompressor();
+}
+
+void Engine::createGpuDecompressor(std::span<const uint32_t> shaderCode) {
+    m_gpuDevice->createGpuDecompressor(shaderCode);
+}
+
+VulkanEngine::GpuDecompressor* Engine::getGpuDecompressor() const {
+    return m_gpuDevice->getGpuDecompressor();
+}
+
+VulkanEngine::HostImageCopier* Engine::getHostImageCopier() const {
+    return m_gpuDevice->getHostImageCopier();
+}
+
+bool Engine::supportsSparseTextures(VkFormat format, VkImageUsageFlags usage) const {
+    return m_gpuDevice->supportsSparseTextures(format, usage);
+}
+
+std::unique_ptr<VulkanEngine::SparseTexture> Engine::createSparseTexture(
+    uint32_t width,
+    uint32_t height,
+    uint32_t mipLevels,
+    VkFormat format,
+    VkImageUsageFlags usage,
+    VkDeviceSize memoryBudget
+) {
+    return m_gpuDevice->createSparseTexture(width, height, mipLevels, format, usage, memoryBudget);
+}
+
+bool Engine::supportsDynamicRendering() const {
+    return m_gpuDevice->supportsDynamicRendering();
+}
+
+bool Engine::supportsSynchronization2() const {
+    return m_gpuDevice->supportsSynchronization2();
+}
+
+bool Engine::supportsPushDescriptors() const {
+    return GpuDevice::isPushDescriptorSupported(this->getPhysicalDevice());
+}
+
+bool Engine::supportsExtendedDynamicState() const {
+    return m_gpuDevice->supportsExtendedDynamicState();
+}
+
+bool Engine::supportsDrawIndirectCount() const {
+    return m_gpuDevice->supportsDrawIndirectCount();
+}
+
+bool Engine::supportsBufferDeviceAddress() const {
+    return m_gpuDevice->supportsBufferDeviceAddress();
+}
+
+VkDeviceAddress Engine::getBufferDeviceAddress(VkBuffer buffer) const {
+    return m_gpuDevice->getBufferDeviceAddress(buffer);
+}
+
+bool Engine::supportsDescriptorBuffer() const {
+    return m_gpuDevice->supportsDescriptorBuffer();
+}
+
+bool Engine::supportsGraphicsPipelineLibrary() const {
+    return m_gpuDevice->supportsGraphicsPipelineLibrary();
+}
+
+bool Engine::supportsFragmentShadingRate() const {
+    return m_gpuDevice->supportsFragmentShadingRate();
+}
+
+bool Engine::supportsFragmentShadingRateAttachment() const {
+    return m_gpuDevice->supportsFragmentShadingRateAttachment();
+}
+
+VkPhysicalDeviceFragmentShadingRatePropertiesKHR Engine::getFragmentShadingRateProperties() const {
+    return m_gpuDevice->getFragmentShadingRateProperties();
+}
+
+void Engine::setFragmentShadingRate(
+    VkCommandBuffer commandBuffer,
+    VkExtent2D fragmentSize,
+    std::span<const VkFragmentShadingRateCombinerOpKHR, 2> combinerOps
+) const {
+    m_gpuDevice->setFragmentShadingRate(commandBuffer, fragmentSize, combinerOps);
+}
+
+bool Engine::supportsConditionalRendering() const {
+    return m_gpuDevice->supportsConditionalRendering();
+}
+
+void Engine::beginConditionalRendering(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset) const {
+    m_gpuDevice->beginConditionalRendering(commandBuffer, buffer, offset);
+}
+
+void Engine::endConditionalRendering(VkCommandBuffer commandBuffer) const {
+    m_gpuDevice->endConditionalRendering(commandBuffer);
+}
+
+bool Engine::supportsMeshShading() const {
+    return m_gpuDevice->supportsMeshShading();
+}
+
+bool Engine::supportsPresentWait() const {
+    return m_gpuDevice->supportsPresentWait();
+}
+
+VkResult Engine::waitForPresent(VkSwapchainKHR swapChain, uint64_t presentId, uint64_t timeout) const {
+    return m_gpuDevice->waitForPresent(swapChain, presentId, timeout);
+}
+
+bool Engine::supportsExternalMemoryFd() const {
+    return m_gpuDevice->supportsExternalMemoryFd();
+}
+
+bool Engine::supportsMaintenance5() const {
+    return m_gpuDevice->supportsMaintenance5();
+}
+
+void Engine::markDeviceLost() {
+    m_gpuDevice->markLost();
+}
+
+bool Engine::isDeviceLost() const {
+    return m_gpuDevice->isLost();
+}
+
+void Engine::drawMeshTasks(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) const {
+    m_gpuDevice->drawMeshTasks(commandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+std::unique_ptr<Engine> Engine::create(EngineMode engineMode, bool isHeadless, const DeviceSelection& deviceSelection) {
+    // Presenting from a device group needs device group swap chains, which the renderer
+    // does not create.
+    if (!isHeadless && deviceSelection.deviceGroupMode != DeviceGroupMode::None) {
+        throw std::invalid_argument("device groups need a headless engine!");
     }
 
-    newEngine->createGLFWLibrary();
+    auto newEngine = std::make_unique<Engine>();
+    newEngine->m_isHeadless = isHeadless;
+    newEngine->m_deviceSelection = deviceSelection;
+    newEngine->m_engineMode = engineMode;
+    newEngine->m_enableValidationLayers = engineMode != EngineMode::Release;
+    newEngine->m_enableGpuAssistedValidation = engineMode == EngineMode::GpuAssistedValidation;
+    newEngine->m_enableDebuggingExtensions = engineMode != EngineMode::Release;
+
+    // Validation layers are loaded by the loader while the instance is created, so their
+    // cost shows up in that phase.
+    auto startupTimeline = StartupTimeline {};
+    if (!isHeadless) {
+        newEngine->createGLFWLibrary();
+        startupTimeline.mark("initialize GLFW");
+    }
+    newEngine->createHostAllocator();
     newEngine->createInfoProvider();
     newEngine->createSystemFactory();
+    startupTimeline.mark("query instance properties");
     newEngine->createInstance();
+    startupTimeline.mark("create instance and load layers");
     newEngine->createDebugMessenger();
+    startupTimeline.mark("create debug messenger");
     newEngine->createGpuDevice();
-    newEngine->createWindowSystem();
+    startupTimeline.skip();
+    if (!isHeadless) {
+        newEngine->createWindowSystem();
+        startupTimeline.mark("create window system");
+    }
 
     return newEngine;
 }
@@ -3,12 +3,24 @@
 
 #include <vulkan/vulkan.h>
 
+#include <cctype>
+#include <compare>
+#include <cstdlib>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
 #include <optional>
 #include <set>
+#include <span>
+#include <unordered_map>
 #include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 #include <fmt/core.h>
 #include <fmt/ostream.h>
@@ -26,6 +38,30 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
+#include "device_capabilities.h"
+#include "gpu_memory_allocator.h"
+#include "host_allocator.h"
+#include "debug_log_queue.h"
+#include "window_event_queue.h"
+#include "device_dispatch.h"
+#include "command_counters.h"
+#include "queue_submitter.h"
+#include "staging_ring.h"
+#include "sampler_cache.h"
+#include "texture_format.h"
+#include "pipeline_layout_cache.h"
+#include "upload_batch.h"
+#include "texture_compressor.h"
+#include "gpu_decompressor.h"
+#include "host_image_copier.h"
+#include "sparse_texture.h"
+#include "mapped_file.h"
+#include "asset_archive.h"
+#include "pipeline_cache.h"
+#include "cache_source_key.h"
+#include "pipeline_compiler.h"
+#include "startup_timings.h"
+
 
 #ifdef NDEBUG
 const bool ENABLE_VALIDATION_LAYERS = false;
@@ -52,9 +88,9 @@ class VulkanInstanceProperties final {
     public:
         explicit VulkanInstanceProperties(std::vector<VkLayerProperties> availableLayers, std::vector<VkExtensionProperties> availableExtensions);
     
-        bool isExtensionAvailable(const char* layerName) const;
+        bool isExtensionAvailable(const std::string& extensionName) const;
 
-        bool isLayerAvailable(const char* extensionName) const;
+        bool isLayerAvailable(const std::string& layerName) const;
 
         const std::vector<VkLayerProperties>& getAvailableLayers() const;
 
@@ -66,6 +102,8 @@ class VulkanInstanceProperties final {
     private:
         std::vector<VkLayerProperties> m_availableLayers;
         std::vector<VkExtensionProperties> m_availableExtensions;
+        std::unordered_set<std::string> m_layerNames;
+        std::unordered_set<std::string> m_extensionNames;
         bool m_validationLayersAvailable = false;
 	    bool m_debugUtilsAvailable = false;
 };
@@ -75,10 +113,20 @@ class PhysicalDeviceProperties final {
         explicit PhysicalDeviceProperties(std::vector<VkExtensionProperties> deviceExtensions);
 
         const std::vector<VkExtensionProperties>& getExtensions() const;
+
+        bool isExtensionAvailable(const std::string& extensionName) const;
     private:
         std::vector<VkExtensionProperties> m_deviceExtensions;
+        std::unordered_set<std::string> m_extensionNames;
 };
 
+/// @brief Answers what the loader and the physical devices provide, enumerating each of
+/// them only the first time it is asked.
+///
+/// @note An engine creates one provider and shares it with every factory and selector it
+/// starts up with, so the instance layers and extensions are enumerated once, and the
+/// extensions of a physical device once however many times it is checked. Lookups go
+/// through hashed name sets. The provider is not safe to share between threads.
 class PlatformInfoProvider {
     public:
         enum class Platform {
@@ -91,7 +139,10 @@ class PlatformInfoProvider {
         explicit PlatformInfoProvider() = default;
         ~PlatformInfoProvider() = default;
 
-        VulkanInstanceProperties getVulkanInstanceInfo() const;
+        PlatformInfoProvider(const PlatformInfoProvider& other) = delete;
+        PlatformInfoProvider& operator=(const PlatformInfoProvider& other) = delete;
+
+        const VulkanInstanceProperties& getVulkanInstanceInfo() const;
 
         std::vector<std::string> getWindowSystemInstanceExtensions() const;
 
@@ -112,9 +163,16 @@ class PlatformInfoProvider {
             #endif
         }
 
-        std::vector<VkExtensionProperties> getAvailableVulkanInstanceExtensions() const;
+        const std::vector<VkExtensionProperties>& getAvailableVulkanInstanceExtensions() const;
+
+        const std::vector<VkLayerProperties>& getAvailableVulkanInstanceLayers() const;
 
-        std::vector<VkLayerProperties> getAvailableVulkanInstanceLayers() const;
+        /// @brief Whether the driver provides an instance extension, without asking the
+        /// loader about layers.
+        bool isInstanceExtensionAvailable(const std::string& extensionName) const;
+
+        /// @brief The instance extensions a layer provides on top of those of the driver.
+        const std::vector<VkExtensionProperties>& getAvailableVulkanLayerExtensions(const std::string& layerName) const;
 
         std::vector<std::string> detectMissingInstanceExtensions(
             const VulkanInstanceProperties& instanceInfo,
@@ -126,18 +184,54 @@ class PlatformInfoProvider {
             const std::vector<std::string>& instanceExtensions
         ) const;
 
-        PhysicalDeviceProperties getAvailableVulkanDeviceExtensions(VkPhysicalDevice physicalDevice) const;
+        const PhysicalDeviceProperties& getAvailableVulkanDeviceExtensions(VkPhysicalDevice physicalDevice) const;
 
         bool areValidationLayersSupported() const;
+    private:
+        mutable std::optional<std::vector<VkExtensionProperties>> m_instanceExtensions;
+        mutable std::optional<std::unordered_set<std::string>> m_instanceExtensionNames;
+        mutable std::optional<std::vector<VkLayerProperties>> m_instanceLayers;
+        mutable std::optional<VulkanInstanceProperties> m_instanceInfo;
+        mutable std::unordered_map<std::string, std::vector<VkExtensionProperties>> m_layerExtensions;
+        mutable std::unordered_map<VkPhysicalDevice, PhysicalDeviceProperties> m_deviceExtensions;
 };
 
 struct QueueFamilyIndices final {
     std::optional<uint32_t> graphicsAndComputeFamily;
     std::optional<uint32_t> presentFamily;
-
-    bool isComplete() const {
-        return graphicsAndComputeFamily.has_value() && presentFamily.has_value();
+    /// @brief A queue family that supports transfers but neither graphics nor compute. On
+    /// discrete GPUs this is usually backed by dedicated copy engines, so uploads submitted
+    /// to it overlap with rendering.
+    std::optional<uint32_t> transferFamily;
+    /// @brief A queue family that supports compute but not graphics. Work submitted to it
+    /// runs asynchronously with respect to the graphics queue.
+    std::optional<uint32_t> computeFamily;
+
+    /// @brief Whether the families a device needs have been found. Headless devices
+    /// present nothing, so they need no present family.
+    bool isComplete(bool hasPresentFamily = true) const {
+        return graphicsAndComputeFamily.has_value() && (presentFamily.has_value() || !hasPresentFamily);
     }
+
+    /// @brief Pick the graphics and compute family, and the present family from the
+    /// families `supportsPresent` answers for, out of `queueFamilies`.
+    ///
+    /// @note A family that does both is preferred, so that swap chain images are drawn
+    /// and presented by the same family, and never change hands between queues.
+    /// Otherwise the first family of each kind is picked.
+    void selectGraphicsAndPresentFamilies(
+        std::span<const VkQueueFamilyProperties> queueFamilies,
+        const std::function<bool(uint32_t)>& supportsPresent
+    );
+
+    /// @brief Pick the first transfer-only family and the first compute family without
+    /// graphics out of `queueFamilies`, when the device has them.
+    void selectDedicatedFamilies(std::span<const VkQueueFamilyProperties> queueFamilies);
+
+    /// @brief Query the queue families of `physicalDevice`, and select every family the
+    /// engine uses out of them. Device selection, logical device creation and device
+    /// initialization all go through this, so that they agree on the families.
+    static QueueFamilyIndices find(VkPhysicalDevice physicalDevice, const std::function<bool(uint32_t)>& supportsPresent);
 };
 
 struct SwapChainSupportDetails final {
@@ -146,12 +240,54 @@ struct SwapChainSupportDetails final {
     std::vector<VkPresentModeKHR> presentModes;
 };
 
+/// @brief The present mode a swap chain asks for.
+///
+/// @note `Immediate` tears, but never holds a frame back, which is what throughput
+/// benchmarks want. `FifoRelaxed` waits for vertical blank unless a frame is late.
+/// `Mailbox` replaces the queued frame with a newer one instead of waiting. `Fifo` always
+/// waits for vertical blank.
+enum class PresentModePolicy {
+    Immediate,
+    FifoRelaxed,
+    Mailbox,
+    Fifo,
+};
+
+/// @brief How many images a swap chain asks for.
+///
+/// @note `Driver` asks for one more than the surface needs at the least. `Double` and
+/// `Triple` ask for two and three. `Matched` asks for one image on the display and one for
+/// every frame in flight, and with mailbox one more for the frame it holds queued, so one
+/// frame in flight takes two images with FIFO, the least latency, and three with mailbox.
+/// Every count is clamped to what the surface allows, so more images cost memory only where
+/// they keep the frames from waiting.
+enum class SwapChainImageCountPolicy {
+    Driver,
+    Double,
+    Triple,
+    Matched,
+};
+
+/// @brief The surface format a swap chain asks for.
+///
+/// @note `Sdr` is 8-bit sRGB, which the hardware encodes. `Sdr10` is 10-bit UNORM in the
+/// sRGB color space, which the shaders encode themselves. `Hdr10` is 10-bit UNORM with the
+/// ST 2084 perceptual quantizer in BT.2020 primaries, for HDR10 displays. `ScRgb` is linear
+/// 16-bit float in extended sRGB, where 1.0 is 80 nits and values go past it.
+enum class SurfaceFormatPolicy {
+    Sdr,
+    Sdr10,
+    Hdr10,
+    ScRgb,
+};
+
 class VulkanInstanceSpec final {
     public:
         explicit VulkanInstanceSpec() = default;
         explicit VulkanInstanceSpec(
             std::vector<std::string> instanceExtensions,
             std::vector<std::string> instanceLayers,
+            std::vector<VkValidationFeatureEnableEXT> validationFeatures,
             VkInstanceCreateFlags instanceCreateFlags,
             std::string applicationName,
             std::string engineName
@@ -162,6 +298,10 @@ class VulkanInstanceSpec final {
 
         const std::vector<std::string>& instanceLayers() const;
 
+        /// @brief The validation features to enable on top of the default ones, which is
+        /// empty unless GPU-assisted validation is on.
+        const std::vector<VkValidationFeatureEnableEXT>& validationFeatures() const;
+
         VkInstanceCreateFlags instanceCreateFlags() const;
 
         const std::string& applicationName() const;
@@ -172,6 +312,7 @@ class VulkanInstanceSpec final {
     private:
         std::vector<std::string> m_instanceExtensions;
         std::vector<std::string> m_instanceLayers;
+        std::vector<VkValidationFeatureEnableEXT> m_validationFeatures;
         VkInstanceCreateFlags m_instanceCreateFlags;
         std::string m_applicationName;
         std::string m_engineName;
@@ -180,14 +321,23 @@ class VulkanInstanceSpec final {
 class InstanceSpecProvider final {
     public:
         explicit InstanceSpecProvider() = default;
-        explicit InstanceSpecProvider(bool enableValidationLayers, bool enableDebuggingExtensions);
+        explicit InstanceSpecProvider(
+            bool enableValidationLayers,
+            bool enableGpuAssistedValidation,
+            bool enableDebuggingExtensions,
+            bool isHeadless = false,
+            bool isSwapChainColorSpaceAvailable = false
+        );
 
         ~InstanceSpecProvider();
 
         VulkanInstanceSpec createInstanceSpec() const;
     private:
         bool m_enableValidationLayers;
+        bool m_enableGpuAssistedValidation;
         bool m_enableDebuggingExtensions;
+        bool m_isHeadless;
+        bool m_isSwapChainColorSpaceAvailable;
 
         enum class Platform {
             Apple,
@@ -215,23 +365,42 @@ class InstanceSpecProvider final {
         std::vector<std::string> getInstanceExtensions() const;
 
         std::vector<std::string> getInstanceLayers() const;
+
+        std::vector<VkValidationFeatureEnableEXT> getValidationFeatures() const;
 };
 
 class SystemFactory final {
     public:
-        explicit SystemFactory() = default;
+        explicit SystemFactory(
+            std::shared_ptr<PlatformInfoProvider> infoProvider,
+            const VkAllocationCallbacks* allocationCallbacks
+        );
 
         VkInstance create(const VulkanInstanceSpec& instanceSpec);
     private:
-        std::unique_ptr<PlatformInfoProvider> m_infoProvider;
+        std::shared_ptr<PlatformInfoProvider> m_infoProvider;
+        const VkAllocationCallbacks* m_allocationCallbacks;
 
         static std::vector<const char*> convertToCStrings(const std::vector<std::string>& strings);
 };
 
+/// @brief A format the renderer uses, and the optimal tiling features it uses it with.
+struct FormatRequirement final {
+    VkFormat format;
+    VkFormatFeatureFlags optimalTilingFeatures;
+};
+
 class PhysicalDeviceSpec final {
     public:
         explicit PhysicalDeviceSpec() = default;
-        explicit PhysicalDeviceSpec(const std::vector<std::string>& requiredExtensions, bool hasGraphicsFamily, bool hasPresentFamily);
+        explicit PhysicalDeviceSpec(
+            const std::vector<std::string>& requiredExtensions,
+            bool hasGraphicsFamily,
+            bool hasPresentFamily,
+            const std::vector<FormatRequirement>& preferredFormats,
+            const std::string& preferredDevice,
+            uint32_t deviceRank
+        );
 
         ~PhysicalDeviceSpec() = default;
 
@@ -240,18 +409,46 @@ class PhysicalDeviceSpec final {
         bool hasGraphicsFamily() const;
 
         bool hasPresentFamily() const;
+
+        /// @brief The formats a device scores higher for supporting. Devices without them
+        /// are still compatible, since the renderer has fallbacks.
+        const std::vector<FormatRequirement>& preferredFormats() const;
+
+        /// @brief The name or UUID of the device to use instead of the best scoring one, or
+        /// an empty string to pick by score.
+        const std::string& preferredDevice() const;
+
+        /// @brief Which of the compatible devices to pick when none is preferred, counting
+        /// from the best scoring one.
+        uint32_t deviceRank() const;
     private:
         std::vector<std::string> m_requiredExtensions;
         bool m_hasGraphicsFamily;
         bool m_hasPresentFamily;
+        std::vector<FormatRequirement> m_preferredFormats;
+        std::string m_preferredDevice;
+        uint32_t m_deviceRank;
 };
 
 class PhysicalDeviceSpecProvider final {
     public:
         explicit PhysicalDeviceSpecProvider() = default;
+        /// @brief A provider for devices that present to a surface, or for headless ones
+        /// that need neither a present family nor swap chains. A non-empty `preferredDevice`
+        /// names the device, or gives its UUID, to use whatever the scores say. Otherwise
+        /// `deviceRank` picks the device, counting from the best scoring one.
+        explicit PhysicalDeviceSpecProvider(
+            bool hasPresentFamily,
+            const std::string& preferredDevice = std::string {},
+            uint32_t deviceRank = 0
+        );
 
         PhysicalDeviceSpec createPhysicalDeviceSpec() const;
     private:
+        bool m_hasPresentFamily { true };
+        std::string m_preferredDevice;
+        uint32_t m_deviceRank { 0 };
+
         enum class Platform {
             Apple,
             Linux,
@@ -272,30 +469,64 @@ class PhysicalDeviceSpecProvider final {
         }
 
         std::vector<std::string> getPhysicalDeviceRequirements() const;
+
+        std::vector<FormatRequirement> getPreferredFormats() const;
+};
+
+/// @brief How well a compatible physical device suits the renderer.
+///
+/// @note Scores compare field by field, so a discrete GPU beats an integrated one however
+/// much memory the integrated one shares, and each later field only breaks ties.
+struct PhysicalDeviceScore final {
+    uint32_t deviceTypeRank;
+    VkDeviceSize deviceLocalHeapSize;
+    uint32_t dedicatedQueueFamilyCount;
+    uint32_t supportedFormatCount;
+
+    auto operator<=>(const PhysicalDeviceScore& other) const = default;
 };
 
 class PhysicalDeviceSelector final {
     public:
-        explicit PhysicalDeviceSelector(VkInstance instance, std::unique_ptr<PlatformInfoProvider> infoProvider);
+        explicit PhysicalDeviceSelector(VkInstance instance, std::shared_ptr<PlatformInfoProvider> infoProvider);
 
         ~PhysicalDeviceSelector();
 
-        QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const;
+        /// @brief Find the queue families of a physical device, with a present family only
+        /// when `hasPresentFamily` is set.
+        ///
+        /// @note Presentation support comes from GLFW, which answers for the platform's
+        /// window system without a window, so no surface has to exist before the device does.
+        QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice, bool hasPresentFamily) const;
 
         bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice, const std::vector<std::string>& requiredExtensions) const;
 
-        SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const;
-
-        bool isPhysicalDeviceCompatible(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const PhysicalDeviceSpec& physicalDeviceSpec) const;
+        bool isPhysicalDeviceCompatible(VkPhysicalDevice physicalDevice, const PhysicalDeviceSpec& physicalDeviceSpec) const;
 
         std::vector<VkPhysicalDevice> findAllPhysicalDevices() const;
 
-        std::vector<VkPhysicalDevice> findCompatiblePhysicalDevices(VkSurfaceKHR surface, const PhysicalDeviceSpec& physicalDeviceSpec) const;
+        std::vector<VkPhysicalDevice> findCompatiblePhysicalDevices(const PhysicalDeviceSpec& physicalDeviceSpec) const;
 
-        VkPhysicalDevice selectPhysicalDeviceForSurface(VkSurfaceKHR surface, const PhysicalDeviceSpec& physicalDeviceSpec) const;
+        PhysicalDeviceScore scorePhysicalDevice(VkPhysicalDevice physicalDevice, const PhysicalDeviceSpec& physicalDeviceSpec) const;
+
+        /// @brief Whether `preferredDevice` is the device's name, or its UUID written the
+        /// usual way, in any case.
+        bool matchesPreferredDevice(VkPhysicalDevice physicalDevice, const std::string& preferredDevice) const;
+
+        /// @brief Select the compatible device the spec prefers, or else the one of its rank
+        /// among the compatible devices from best to worst scoring, with ties going to the
+        /// device enumerated first.
+        VkPhysicalDevice selectPhysicalDevice(const PhysicalDeviceSpec& physicalDeviceSpec) const;
+
+        /// @brief The UUID of a physical device, written the usual 8-4-4-4-12 way.
+        static std::string getDeviceUuid(VkPhysicalDevice physicalDevice);
+
+        /// @brief The physical devices of the device group `physicalDevice` belongs to, or
+        /// an empty list when it is the only device in its group.
+        std::vector<VkPhysicalDevice> findDeviceGroup(VkPhysicalDevice physicalDevice) const;
     private:
         VkInstance m_instance;
-        std::unique_ptr<PlatformInfoProvider> m_infoProvider;
+        std::shared_ptr<PlatformInfoProvider> m_infoProvider;
 };
 
 class LogicalDeviceSpec final {
@@ -316,14 +547,14 @@ class LogicalDeviceSpec final {
 class LogicalDeviceSpecProvider final {
     public:
         explicit LogicalDeviceSpecProvider() = default;
-        explicit LogicalDeviceSpecProvider(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
+        explicit LogicalDeviceSpecProvider(VkPhysicalDevice physicalDevice, bool isHeadless);
 
         ~LogicalDeviceSpecProvider();
 
         LogicalDeviceSpec createLogicalDeviceSpec() const;
     private:
         VkPhysicalDevice m_physicalDevice;
-        VkSurfaceKHR m_surface;
+        bool m_isHeadless;
 
         enum class Platform {
             Apple,
@@ -349,30 +580,50 @@ class LogicalDeviceSpecProvider final {
 
 class LogicalDeviceFactory final {
     public:
-        explicit LogicalDeviceFactory(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, std::unique_ptr<PlatformInfoProvider> infoProvider);
+        explicit LogicalDeviceFactory(
+            VkInstance instance,
+            VkPhysicalDevice physicalDevice,
+            bool isHeadless,
+            const std::vector<VkPhysicalDevice>& deviceGroup,
+            std::shared_ptr<PlatformInfoProvider> infoProvider,
+            const VkAllocationCallbacks* allocationCallbacks
+        );
 
         ~LogicalDeviceFactory();
 
-        QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const;
-
-        SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const;
+        QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice) const;
 
-        std::tuple<VkDevice, VkQueue, VkQueue, VkQueue> createLogicalDevice(const LogicalDeviceSpec& logicalDeviceSpec);
+        std::tuple<VkDevice, VkQueue, VkQueue, VkQueue, VkQueue> createLogicalDevice(const LogicalDeviceSpec& logicalDeviceSpec);
     private:
+        VkInstance m_instance;
         VkPhysicalDevice m_physicalDevice;
-        VkSurfaceKHR m_surface;
-        std::unique_ptr<PlatformInfoProvider> m_infoProvider;
+        bool m_isHeadless;
+        std::vector<VkPhysicalDevice> m_deviceGroup;
+        std::shared_ptr<PlatformInfoProvider> m_infoProvider;
+        const VkAllocationCallbacks* m_allocationCallbacks;
 
         static std::vector<const char*> convertToCStrings(const std::vector<std::string>& strings);
 };
 
+/// @brief Forwards the messages of the validation layers to standard error.
+///
+/// @note The callback runs on whichever thread made the Vulkan call, which waits on it, so
+/// it only drops the messages below the minimum severity and hands the rest to a
+/// `DebugLogQueue`, whose thread formats and writes them. The layers are only asked for
+/// the severities that pass, so the ones that fail are never even built.
 class VulkanDebugMessenger final {
     public:
+        static constexpr VkDebugUtilsMessageSeverityFlagBitsEXT DEFAULT_MIN_SEVERITY = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+
         explicit VulkanDebugMessenger();
 
         ~VulkanDebugMessenger();
 
-        static std::unique_ptr<VulkanDebugMessenger> create(VkInstance instance);
+        static std::unique_ptr<VulkanDebugMessenger> create(
+            VkInstance instance,
+            const VkAllocationCallbacks* allocationCallbacks,
+            VkDebugUtilsMessageSeverityFlagBitsEXT minSeverity = DEFAULT_MIN_SEVERITY
+        );
 
         static VkResult CreateDebugUtilsMessengerEXT(
             VkInstance instance, 
@@ -400,6 +651,9 @@ class VulkanDebugMessenger final {
     private:
         VkInstance m_instance;
         VkDebugUtilsMessengerEXT m_debugMessenger;
+        const VkAllocationCallbacks* m_allocationCallbacks;
+        VkDebugUtilsMessageSeverityFlagBitsEXT m_minSeverity;
+        std::unique_ptr<DebugLogQueue> m_logQueue;
 };
 
 class SurfaceProvider final {
@@ -426,23 +680,127 @@ class WindowSystem final {
 
         void createWindow(uint32_t width, uint32_t height, const std::string& title);
 
+        /// @brief Open another window, which shows a viewport of its own next to the main
+        /// window and shares its events, and return its index among the viewport windows.
+        uint32_t createViewportWindow(uint32_t width, uint32_t height, const std::string& title);
+
         GLFWwindow* getWindow() const;
 
         SurfaceProvider createSurfaceProvider();
 
+        SurfaceProvider createViewportSurfaceProvider(uint32_t viewport);
+
+        uint32_t getViewportCount() const;
+
+        /// @brief The extent of the framebuffer of viewport window `viewport`, in pixels.
+        VkExtent2D getViewportExtent(uint32_t viewport) const;
+
+        bool hasViewportResized(uint32_t viewport) const;
+
+        void setViewportResized(uint32_t viewport, bool viewportResized);
+
         bool hasFramebufferResized() const;
 
         void setFramebufferResized(bool framebufferResized);
 
+        /// @brief The extent of the framebuffer, in pixels.
+        VkExtent2D getFramebufferExtent() const;
+
+        /// @brief How many events have reached the windows that can change what they show:
+        /// resizes, requests to redraw its contents, focus changes, minimizing and
+        /// restoring, and keys.
+        uint64_t getWindowEventCount() const;
+
+        /// @brief Whether the main window, or any viewport window, has the input focus.
+        bool isFocused() const;
+
+        /// @brief Whether the main window and every viewport window are minimized, with
+        /// nothing of them on screen.
+        bool isIconified() const;
+
+        /// @brief Whether `key`, a GLFW key, is held down.
+        bool isKeyDown(int key) const;
+
+        /// @brief Whether the user asked for the window to close.
+        bool isCloseRequested() const;
+
+        /// @brief Handle the events that came in since the last call, without waiting.
+        void pollEvents();
+
+        /// @brief Sleep until an event comes in, or until `timeoutSeconds` have passed when
+        /// there is a timeout, and handle the events that came in since the last call.
+        void waitEvents(std::optional<double> timeoutSeconds);
+
+        /// @brief Run `render` on a thread of its own while the calling thread pumps the
+        /// events of the window and forwards them to it, until `render` returns, and throw
+        /// whatever `render` throws.
+        ///
+        /// @note Must be called on the main thread, the only one GLFW handles events and
+        /// sets window titles on. `render` has to leave GLFW alone, and go through
+        /// `pollEvents`, `waitEvents` and `setWindowTitle` instead.
+        void runEventPump(const std::function<void()>& render);
+
+        /// @brief Set the title of the window, or have the event pump set it, when there is
+        /// one running.
         void setWindowTitle(const std::string& title);
     private:
         VkInstance m_instance;
         GLFWwindow* m_window;
         VkSurfaceKHR m_surface;
+        WindowEventQueue m_eventQueue;
+        /// @brief Whether the events are pumped on another thread than the one that
+        /// handles them, which never calls GLFW to pump them then.
+        bool m_isEventPumpRunning;
+        std::mutex m_titleMutex;
+        std::optional<std::string> m_pendingTitle;
+
+        // The state of the window as of the last event handled, on the thread that handles
+        // them.
         VkExtent2D m_windowExtent;
         bool m_framebufferResized;
+        uint64_t m_windowEventCount;
+        bool m_isFocused;
+        bool m_isIconified;
+        bool m_isCloseRequested;
+        std::bitset<GLFW_KEY_LAST + 1> m_keysDown;
+
+        struct ViewportWindow final {
+            GLFWwindow* window;
+            VkExtent2D extent;
+            bool isResized;
+            bool isFocused;
+            bool isIconified;
+        };
+
+        /// @brief The windows are only opened before events are pumped, so the pump reads
+        /// the handles while the state is handled on the other thread.
+        std::vector<ViewportWindow> m_viewportWindows;
+
+        void handleQueuedEvents();
+
+        void handleViewportEvent(ViewportWindow& viewportWindow, const WindowEvent& event);
+
+        /// @brief Set the title `setWindowTitle` left for the event pump, if there is one.
+        void applyPendingTitle();
+
+        /// @brief The index of `window` that events carry.
+        uint32_t getWindowIndex(GLFWwindow* window) const;
+
+        void setWindowCallbacks(GLFWwindow* window);
+
+        static void pushEvent(GLFWwindow* window, const WindowEvent& event);
 
         static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
+
+        static void windowRefreshCallback(GLFWwindow* window);
+
+        static void windowFocusCallback(GLFWwindow* window, int focused);
+
+        static void windowIconifyCallback(GLFWwindow* window, int iconified);
+
+        static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+        static void windowCloseCallback(GLFWwindow* window);
 };
 
 class GpuDevice final {
@@ -455,13 +813,28 @@ class GpuDevice final {
             VkQueue graphicsQueue,
             VkQueue computeQueue,
             VkQueue presentQueue,
-            VkCommandPool commandPool
+            VkQueue transferQueue,
+            VkCommandPool commandPool,
+            VkCommandPool uploadCommandPool,
+            VkCommandPool transferCommandPool,
+            VkCommandPool computeCommandPool,
+            const QueueFamilyIndices& queueFamilyIndices,
+            uint32_t deviceCount,
+            const VkAllocationCallbacks* allocationCallbacks
         );
 
         ~GpuDevice();
 
         VkPhysicalDevice getPhysicalDevice() const;
 
+        /// @brief The host allocation callbacks the device, its command pools and its shader
+        /// modules were created with, which objects destroyed alongside them share.
+        const VkAllocationCallbacks* getAllocationCallbacks() const;
+
+        /// @brief What the physical device supports, queried once when the device was
+        /// opened.
+        const DeviceCapabilities& getDeviceCapabilities() const;
+
         VkDevice getLogicalDevice() const;
 
         VkQueue getGraphicsQueue() const;
@@ -470,8 +843,20 @@ class GpuDevice final {
 
         VkQueue getPresentQueue() const;
 
+        VkQueue getTransferQueue() const;
+
         VkCommandPool getCommandPool() const;
 
+        VkCommandPool getTransferCommandPool() const;
+
+        VkCommandPool getComputeCommandPool() const;
+
+        const QueueFamilyIndices& getQueueFamilyIndices() const;
+
+        /// @brief The number of physical devices the logical device spans, which is more than
+        /// one only for a device created from a device group.
+        uint32_t getDeviceCount() const;
+
         VkSampleCountFlagBits getMsaaSamples() const;
 
         static VkSampleCountFlagBits getMaxUsableSampleCount(VkPhysicalDevice physicalDevice);
@@ -485,6 +870,334 @@ class GpuDevice final {
         VkShaderModule createShaderModule(const std::vector<char>& code);
 
         VkShaderModule createShaderModule(const std::vector<unsigned char>& code);
+
+        /// @brief A shader module straight from SPIR-V words, such as the embedded shaders,
+        /// without copying them.
+        VkShaderModule createShaderModule(std::span<const uint32_t> code);
+
+        /// @brief Drop a reference to a module from `createShaderModule`, which is destroyed
+        /// with the last one.
+        ///
+        /// @note A module can be released as soon as the pipelines built from it are
+        /// created. Modules that are never released are destroyed with the device.
+        void releaseShaderModule(VkShaderModule shaderModule);
+
+        /// @brief The modules alive, one for every distinct code asked for.
+        uint32_t getShaderModuleCount() const;
+
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+        GpuMemoryAllocator& getMemoryAllocator();
+
+        QueueSubmitter& getQueueSubmitter();
+
+        StagingRing& getStagingRing();
+
+        SamplerCache& getSamplerCache();
+
+        PipelineLayoutCache& getPipelineLayoutCache();
+
+        /// @brief The entry points of the commands of a frame, loaded from the device.
+        const DeviceDispatch& getDeviceDispatch() const;
+
+        UploadContext& getUploadContext();
+
+        /// @brief Load the pipeline cache from `filePath`, or start an empty one. The cache
+        /// is written back when the device is destroyed.
+        ///
+        /// @note Must be called before the mipmap generator is created for its pipelines to
+        /// use the cache.
+        void createPipelineCache(const std::filesystem::path& filePath);
+
+        /// @brief The pipeline cache, or `VK_NULL_HANDLE` when none has been created.
+        VkPipelineCache getPipelineCache() const;
+
+        /// @brief Start `threadCount` pipeline compiler workers that share the pipeline cache.
+        ///
+        /// @note Must be called after the pipeline cache is created for its pipelines to use
+        /// the cache.
+        void createPipelineCompiler(uint32_t threadCount);
+
+        PipelineCompiler& getPipelineCompiler();
+
+        void createMipmapGenerator(
+            std::span<const uint32_t> shaderCode,
+            std::span<const uint32_t> filterShaderCode,
+            std::span<const uint32_t> volumeShaderCode
+        );
+
+        /// @brief The mipmap generator, or `nullptr` when none has been created.
+        MipmapGenerator* getMipmapGenerator() const;
+
+        void createTextureCompressor(std::span<const uint32_t> shaderCode);
+
+        /// @brief The texture compressor, or `nullptr` when none has been created.
+        TextureCompressor* getTextureCompressor() const;
+
+        void createGpuDecompressor(std::span<const uint32_t> shaderCode);
+
+        /// @brief The GPU decompressor, or `nullptr` when none has been created.
+        GpuDecompressor* getGpuDecompressor() const;
+
+        /// @brief The host image copier, or `nullptr` when the device cannot copy to images
+        /// from the host.
+        HostImageCopier* getHostImageCopier() const;
+
+        /// @brief The queue that sparse memory binds are submitted to, or `VK_NULL_HANDLE`
+        /// when the device cannot create sparse residency images.
+        VkQueue getSparseBindingQueue() const;
+
+        bool supportsSparseTextures(VkFormat format, VkImageUsageFlags usage) const;
+
+        std::unique_ptr<SparseTexture> createSparseTexture(
+            uint32_t width,
+            uint32_t height,
+            uint32_t mipLevels,
+            VkFormat format,
+            VkImageUsageFlags usage,
+            VkDeviceSize memoryBudget
+        );
+
+        /// @brief Whether `physicalDevice` has `VK_EXT_mesh_shader` with both task and mesh
+        /// shaders. The extension is enabled on every device that has it.
+        static bool isMeshShadingSupported(VkPhysicalDevice physicalDevice);
+
+        bool supportsMeshShading() const;
+
+        /// @brief Whether `physicalDevice` is a Vulkan 1.3 device with dynamic rendering.
+        /// The feature is enabled on every device that has it.
+        static bool isDynamicRenderingSupported(VkPhysicalDevice physicalDevice);
+
+        bool supportsDynamicRendering() const;
+
+        /// @brief Whether `physicalDevice` is a Vulkan 1.3 device with synchronization2.
+        /// The feature is enabled on every device that has it, and upload batches record
+        /// their barriers with it.
+        static bool isSynchronization2Supported(VkPhysicalDevice physicalDevice);
+
+        bool supportsSynchronization2() const;
+
+        /// @brief Whether `physicalDevice` is a Vulkan 1.3 device, which has the dynamic
+        /// cull mode, front face, topology and depth state of extended dynamic state as core
+        /// commands, without a feature to enable.
+        static bool isExtendedDynamicStateSupported(VkPhysicalDevice physicalDevice);
+
+        bool supportsExtendedDynamicState() const;
+
+        /// @brief Whether `physicalDevice` has multi-draw indirect with first instances, and
+        /// takes the draw count of an indirect draw from a buffer. The features are enabled
+        /// on every device that has them.
+        static bool isDrawIndirectCountSupported(VkPhysicalDevice physicalDevice);
+
+        bool supportsDrawIndirectCount() const;
+
+        /// @brief Whether `physicalDevice` has Vulkan 1.2 buffer device addresses, on a logical
+        /// device made from `deviceCount` devices. The feature is enabled on every device that
+        /// has it.
+        ///
+        /// @note A device group needs the multi-device feature too, or no address can be
+        /// queried on it.
+        static bool isBufferDeviceAddressSupported(VkPhysicalDevice physicalDevice, uint32_t deviceCount);
+
+        bool supportsBufferDeviceAddress() const;
+
+        /// @brief The address shaders reach `buffer` at, which has to have been created with
+        /// `VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT`.
+        ///
+        /// @note The address belongs to the buffer, so a buffer moved by `createMovedBuffer`
+        /// has a new one.
+        VkDeviceAddress getBufferDeviceAddress(VkBuffer buffer) const;
+
+        /// @brief Whether `physicalDevice` has `VK_EXT_descriptor_buffer` with its feature, and
+        /// the buffer device addresses descriptor buffers are bound by. The extension is
+        /// enabled on every device that has it.
+        static bool isDescriptorBufferSupported(VkPhysicalDevice physicalDevice);
+
+        /// @brief Whether descriptor buffers can be used on the logical device, which takes
+        /// buffer device addresses on all of its devices.
+        bool supportsDescriptorBuffer() const;
+
+        /// @brief Whether `physicalDevice` has `VK_EXT_graphics_pipeline_library`, and the
+        /// `VK_KHR_pipeline_library` it builds on, with its feature. The extensions are
+        /// enabled on every device that has them.
+        static bool isGraphicsPipelineLibrarySupported(VkPhysicalDevice physicalDevice);
+
+        bool supportsGraphicsPipelineLibrary() const;
+
+        /// @brief Whether `physicalDevice` has `VK_KHR_fragment_shading_rate` with pipeline
+        /// shading rates, which set the shading rate of the draws that follow. The extension
+        /// is enabled on every device that has it.
+        static bool isFragmentShadingRateSupported(VkPhysicalDevice physicalDevice);
+
+        /// @brief Whether `physicalDevice` can also take the shading rate of a render pass
+        /// from an attachment, on top of pipeline shading rates.
+        static bool isFragmentShadingRateAttachmentSupported(VkPhysicalDevice physicalDevice);
+
+        bool supportsFragmentShadingRate() const;
+
+        bool supportsFragmentShadingRateAttachment() const;
+
+        /// @brief The limits of the fragment shading rates of the device, like the texel sizes
+        /// a shading rate attachment can have, and whether rates can be combined by more than
+        /// keeping or replacing one.
+        VkPhysicalDeviceFragmentShadingRatePropertiesKHR getFragmentShadingRateProperties() const;
+
+        /// @brief Record a `vkCmdSetFragmentShadingRateKHR`, which is loaded from the device
+        /// since the Vulkan loader does not export extension commands.
+        ///
+        /// @note The first combiner combines the rate of the pipeline with the rate of each
+        /// primitive, and the second combines the result with the rate of the attachment.
+        void setFragmentShadingRate(
+            VkCommandBuffer commandBuffer,
+            VkExtent2D fragmentSize,
+            std::span<const VkFragmentShadingRateCombinerOpKHR, 2> combinerOps
+        ) const;
+
+        /// @brief Whether `physicalDevice` has `VK_EXT_conditional_rendering` with its
+        /// feature, which skips draws and dispatches by a value in a buffer. The extension
+        /// is enabled on every device that has it.
+        static bool isConditionalRenderingSupported(VkPhysicalDevice physicalDevice);
+
+        /// @brief Whether `physicalDevice` has `VK_KHR_performance_query` with query pools
+        /// of performance counters, and resets queries on the host, which the GPU profiler
+        /// resets performance queries with. The extension is enabled on every device that
+        /// has it.
+        static bool isPerformanceQuerySupported(VkPhysicalDevice physicalDevice);
+
+        bool supportsConditionalRendering() const;
+
+        /// @brief Record a `vkCmdBeginConditionalRenderingEXT`, which is loaded from the
+        /// device since the Vulkan loader does not export extension commands.
+        ///
+        /// @note The draws and dispatches up to the matching `endConditionalRendering` are
+        /// skipped when the 32-bit value at `offset` in `buffer` is zero when they execute.
+        void beginConditionalRendering(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset) const;
+
+        void endConditionalRendering(VkCommandBuffer commandBuffer) const;
+
+        /// @brief Whether `physicalDevice` has the descriptor indexing features the global
+        /// texture table needs: runtime-sized, partially bound arrays of combined image
+        /// samplers with a variable count, indexed dynamically, whose unused descriptors
+        /// can be updated after the set is bound. Every device has to have them.
+        static bool isDescriptorIndexingSupported(VkPhysicalDevice physicalDevice);
+
+        /// @brief Whether `physicalDevice` has `VK_KHR_present_id` and `VK_KHR_present_wait`
+        /// with both of their features. The extensions are enabled on every device that has
+        /// them.
+        static bool isPresentWaitSupported(VkPhysicalDevice physicalDevice);
+
+        bool supportsPresentWait() const;
+
+        /// @brief Whether `physicalDevice` has `VK_EXT_memory_budget`, which reports how much
+        /// of each memory heap the process uses and can use. The extension is enabled on
+        /// every device that has it.
+        static bool isMemoryBudgetSupported(VkPhysicalDevice physicalDevice);
+
+        /// @brief Whether `physicalDevice` has `VK_EXT_memory_priority` with its feature,
+        /// which tells the driver which memory to keep on the device when it runs out. The
+        /// extension is enabled on every device that has it.
+        static bool isMemoryPrioritySupported(VkPhysicalDevice physicalDevice);
+
+        /// @brief Whether `physicalDevice` has `VK_EXT_pageable_device_local_memory` with
+        /// its feature, which lets the driver page device local memory out by priority rather
+        /// than fail allocations. The extension is enabled on every device that has it and
+        /// memory priorities.
+        static bool isPageableDeviceLocalMemorySupported(VkPhysicalDevice physicalDevice);
+
+        /// @brief Whether `physicalDevice` has `VK_KHR_external_memory_fd` and
+        /// `VK_KHR_external_semaphore_fd`, which export memory and semaphores as POSIX file
+        /// descriptors for other APIs and processes to import. The extensions are enabled on
+        /// every device that has them.
+        static bool isExternalMemoryFdSupported(VkPhysicalDevice physicalDevice);
+
+        bool supportsExternalMemoryFd() const;
+
+        /// @brief Whether `physicalDevice` has `VK_EXT_host_image_copy` with its feature,
+        /// which copies texels between host memory and images without a command buffer. The
+        /// extension is enabled on every device that has it.
+        static bool isHostImageCopySupported(VkPhysicalDevice physicalDevice);
+
+        /// @brief Whether `physicalDevice` has `VK_KHR_push_descriptor`, which writes the
+        /// descriptors of a set straight into a command buffer instead of into an allocated
+        /// set. The extension is enabled on every device that has it.
+        static bool isPushDescriptorSupported(VkPhysicalDevice physicalDevice);
+
+        /// @brief Whether `physicalDevice` has `VK_KHR_maintenance5` with its feature on top
+        /// of Vulkan 1.3, which lets a pipeline stage take its SPIR-V in a chained
+        /// `VkShaderModuleCreateInfo` instead of a module. The extension is enabled on every
+        /// device that has it.
+        static bool isMaintenance5Supported(VkPhysicalDevice physicalDevice);
+
+        bool supportsMaintenance5() const;
+
+        /// @brief Record that the device was lost, so that destroying it skips what would
+        /// read from it, like writing the pipeline cache back.
+        void markLost();
+
+        bool isLost() const;
+
+        /// @brief Wait until the present tagged with `presentId` has reached the display,
+        /// with `vkWaitForPresentKHR` loaded from the device.
+        ///
+        /// @note The result is `VK_TIMEOUT` when `timeout` passes first, and can be
+        /// `VK_ERROR_OUT_OF_DATE_KHR` once the swap chain has to be recreated.
+        VkResult waitForPresent(VkSwapchainKHR swapChain, uint64_t presentId, uint64_t timeout) const;
+
+        /// @brief Record a `vkCmdDrawMeshTasksEXT`, which is loaded from the device since the
+        /// Vulkan loader does not export extension commands.
+        void drawMeshTasks(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) const;
+
+        std::tuple<VkBuffer, GpuAllocation> createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+
+        /// @brief Create a buffer to move the buffer bound to `allocation` into, in a fuller
+        /// block of the same heap, when moving it would help compact the heap.
+        ///
+        /// @returns Nothing when the move would not help, or when no fuller block has room.
+        /// The caller copies the contents over and destroys the old buffer.
+        std::optional<std::tuple<VkBuffer, GpuAllocation>> createMovedBuffer(
+            const GpuAllocation& allocation,
+            VkDeviceSize size,
+            VkBufferUsageFlags usage
+        );
+
+        /// @brief Create an image of `imageType` with `arrayLayers` layers, or `depth` slices
+        /// for a 3D image, and bind memory to it.
+        ///
+        /// @note A cube map is a 2D image of six layers for every cube, with
+        /// `VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT` in `flags`. A mutable format sRGB image is created with a format list of itself and its
+        /// UNORM alias, the one format compute writes it through.
+        std::tuple<VkImage, GpuAllocation> createImage(
+            uint32_t width,
+            uint32_t height,
+            uint32_t mipLevels,
+            VkSampleCountFlagBits numSamples,
+            VkFormat format,
+            VkImageTiling tiling,
+            VkImageUsageFlags usage,
+            VkMemoryPropertyFlags properties,
+            VkImageCreateFlags flags = 0,
+            uint32_t arrayLayers = 1,
+            uint32_t depth = 1,
+            VkImageType imageType = VK_IMAGE_TYPE_2D
+        );
+
+        void destroyBuffer(VkBuffer buffer, const GpuAllocation& allocation);
+
+        void destroyImage(VkImage image, const GpuAllocation& allocation);
+
+        /// @brief Create an optimal tiling attachment whose contents never outlive a render
+        /// pass, like a multisampled color target that is resolved at its end.
+        ///
+        /// @note The image is transient, and is bound to lazily allocated memory wherever the
+        /// device has a memory type for it, so tilers can keep it in tile memory.
+        std::tuple<VkImage, GpuAllocation> createTransientAttachment(
+            uint32_t width,
+            uint32_t height,
+            VkSampleCountFlagBits numSamples,
+            VkFormat format,
+            VkImageUsageFlags usage,
+            uint32_t arrayLayers = 1
+        );
     private:
         VkInstance m_instance;
         VkPhysicalDevice m_physicalDevice;
@@ -492,41 +1205,125 @@ class GpuDevice final {
         VkQueue m_graphicsQueue;
         VkQueue m_computeQueue;
         VkQueue m_presentQueue;
+        VkQueue m_transferQueue;
         VkCommandPool m_commandPool;
+        VkCommandPool m_uploadCommandPool;
+        VkCommandPool m_transferCommandPool;
+        VkCommandPool m_computeCommandPool;
+        QueueFamilyIndices m_queueFamilyIndices;
+        uint32_t m_deviceCount;
+        const VkAllocationCallbacks* m_allocationCallbacks;
+        VkQueue m_sparseBindingQueue;
+        DeviceDispatch m_dispatch;
+        bool m_isDynamicRenderingSupported;
+        bool m_isSynchronization2Supported;
+        bool m_isExtendedDynamicStateSupported;
+        bool m_isDrawIndirectCountSupported;
+        bool m_isBufferDeviceAddressSupported;
+        bool m_isDescriptorBufferSupported;
+        bool m_isGraphicsPipelineLibrarySupported;
+        bool m_isFragmentShadingRateAttachmentSupported;
+        bool m_isExternalMemoryFdSupported;
+        bool m_isMaintenance5Supported;
+        bool m_isLost;
         VkSurfaceKHR m_surface;
         VkSampleCountFlagBits m_msaaSamples = VK_SAMPLE_COUNT_1_BIT;
 
-        std::unordered_set<VkShaderModule> m_shaderModules;
+        struct CachedShaderModule final {
+            std::vector<uint8_t> code;
+            VkShaderModule shaderModule;
+            uint32_t referenceCount;
+        };
+
+        /// @brief The modules by the hash of their code, where codes that collide share a
+        /// hash, and the hash of every module.
+        std::unordered_multimap<uint64_t, CachedShaderModule> m_shaderModules;
+        std::unordered_map<VkShaderModule, uint64_t> m_shaderModuleHashes;
+
+        std::unique_ptr<DeviceCapabilities> m_capabilities;
+        std::unique_ptr<GpuMemoryAllocator> m_memoryAllocator;
+        std::unique_ptr<QueueSubmitter> m_queueSubmitter;
+        std::unique_ptr<StagingRing> m_stagingRing;
+        std::unique_ptr<SamplerCache> m_samplerCache;
+        std::unique_ptr<PipelineLayoutCache> m_pipelineLayoutCache;
+        std::unique_ptr<PipelineCache> m_pipelineCache;
+        std::unique_ptr<PipelineCompiler> m_pipelineCompiler;
+        std::unique_ptr<MipmapGenerator> m_mipmapGenerator;
+        std::unique_ptr<TextureCompressor> m_textureCompressor;
+        std::unique_ptr<GpuDecompressor> m_gpuDecompressor;
+        std::unique_ptr<HostImageCopier> m_hostImageCopier;
+        std::unique_ptr<UploadContext> m_uploadContext;
 
         std::vector<char> loadShader(std::istream& stream);
 
-        std::ifstream openShaderFile(const std::string& fileName);
-
         std::vector<char> loadShaderFromFile(const std::string& fileName);
 
-        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+        VkShaderModule createShaderModule(const void* code, size_t codeSize);
 };
 
+/// @brief How an engine spreads its frames over the physical devices of a device group.
+enum class DeviceGroupMode {
+    /// @brief Use a single physical device.
+    None,
+    /// @brief Alternate frame rendering, where each frame slot renders on a device of its
+    /// own.
+    AlternateFrame,
+    /// @brief Split frame rendering, where every device renders a horizontal strip of
+    /// every frame.
+    SplitFrame
+};
+
+/// @brief Which physical device, or device group, an engine runs on.
+struct DeviceSelection final {
+    /// @brief The name or UUID of the device to run on, or empty to pick by score.
+    std::string preferredDevice;
+    /// @brief Which of the compatible devices to run on when none is preferred, counting
+    /// from the best scoring one, so that independent engines can each take a device.
+    uint32_t deviceRank = 0;
+    /// @brief Whether to create the logical device from the device group of the selected
+    /// device, and how to use it. Groups of one device fall back to `None`.
+    DeviceGroupMode deviceGroupMode = DeviceGroupMode::None;
+};
+
+/// @brief Selects a physical device and creates the logical device, its queues and its
+/// command pools.
+///
+/// @note The device is picked before any window exists, so its present family is the one
+/// GLFW reports presentation support for, and the window's surface is checked against it
+/// once it is created. A headless initializer picks a device without a present family or
+/// swap chains.
 class GpuDeviceInitializer final {
     public:
-        explicit GpuDeviceInitializer(VkInstance instance);
+        explicit GpuDeviceInitializer(
+            VkInstance instance,
+            std::shared_ptr<PlatformInfoProvider> infoProvider,
+            const VkAllocationCallbacks* allocationCallbacks,
+            bool isHeadless = false,
+            const DeviceSelection& deviceSelection = DeviceSelection {}
+        );
 
         ~GpuDeviceInitializer();
 
         std::unique_ptr<GpuDevice> createGpuDevice();
     private:
         VkInstance m_instance;
-        VkSurfaceKHR m_dummySurface;
+        std::shared_ptr<PlatformInfoProvider> m_infoProvider;
+        const VkAllocationCallbacks* m_allocationCallbacks;
+        bool m_isHeadless;
+        DeviceSelection m_deviceSelection;
         VkPhysicalDevice m_physicalDevice;
+        std::vector<VkPhysicalDevice> m_deviceGroup;
         VkDevice m_device;
         VkQueue m_graphicsQueue;
         VkQueue m_computeQueue;
         VkQueue m_presentQueue;
+        VkQueue m_transferQueue;
         VkCommandPool m_commandPool;
+        VkCommandPool m_uploadCommandPool;
+        VkCommandPool m_transferCommandPool;
+        VkCommandPool m_computeCommandPool;
 
-        QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const;
-
-        void createDummySurface();
+        QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice) const;
 
         void selectPhysicalDevice();
 
@@ -535,19 +1332,71 @@ class GpuDeviceInitializer final {
         void createCommandPool();
 };
 
+/// @brief How much checking an engine does, chosen when it is created.
+///
+/// @note `Release` enables no layers and creates no debug messenger, so it pays nothing for
+/// validation. `GpuAssistedValidation` also instruments shaders to check descriptor indexing
+/// and buffer accesses on the GPU, which is much slower than `Debug`.
+enum class EngineMode {
+    Release,
+    Debug,
+    GpuAssistedValidation
+};
+
 class Engine final {
     public:
         explicit Engine() = default;
         ~Engine();
 
-        static std::unique_ptr<Engine> createDebugMode();
+        /// @brief An engine in `engineMode`, headless or with a window system, on the best
+        /// scoring device or on the one `deviceSelection` asks for.
+        static std::unique_ptr<Engine> create(EngineMode engineMode, bool isHeadless, const DeviceSelection& deviceSelection = DeviceSelection {});
+
+        /// @brief The mode named `release`, `debug` or `gpu-assisted`.
+        static EngineMode parseEngineMode(const std::string& name);
+
+        /// @brief The mode `VULKAN_ENGINE_MODE` names, or `defaultMode` when it is not set.
+        static EngineMode getEngineModeFromEnvironment(EngineMode defaultMode);
+
+        /// @brief An engine on the best scoring device, or on the one `deviceSelection` asks
+        /// for.
+        ///
+        /// @note Only headless engines run on device groups, since their frames are never
+        /// presented.
+        static std::unique_ptr<Engine> createDebugMode(const DeviceSelection& deviceSelection = DeviceSelection {});
+
+        static std::unique_ptr<Engine> createReleaseMode(const DeviceSelection& deviceSelection = DeviceSelection {});
+
+        /// @brief An engine without GLFW, a window or a surface, on a device that needs no
+        /// present family. It renders into images of its own, which suits display-less
+        /// machines.
+        ///
+        /// @note The window, surface and swap chain functions must not be called on it.
+        static std::unique_ptr<Engine> createHeadlessDebugMode(const DeviceSelection& deviceSelection = DeviceSelection {});
+
+        static std::unique_ptr<Engine> createHeadlessReleaseMode(const DeviceSelection& deviceSelection = DeviceSelection {});
 
-        static std::unique_ptr<Engine> createReleaseMode();
+        bool isHeadless() const;
+
+        EngineMode getEngineMode() const;
+
+        /// @brief The number of physical devices the engine renders with.
+        uint32_t getDeviceCount() const;
+
+        /// @brief How frames are spread over the devices, which is `None` unless the engine
+        /// renders with more than one.
+        DeviceGroupMode getDeviceGroupMode() const;
 
         VkInstance getInstance() const;
 
+        /// @brief The host allocation callbacks every object the engine and the renderer
+        /// create with the driver share.
+        const VkAllocationCallbacks* getAllocationCallbacks() const;
+
         VkPhysicalDevice getPhysicalDevice() const;
 
+        const DeviceCapabilities& getDeviceCapabilities() const;
+
         VkDevice getLogicalDevice() const;
 
         VkQueue getGraphicsQueue() const;
@@ -556,8 +1405,22 @@ class Engine final {
 
         VkQueue getPresentQueue() const;
 
+        VkQueue getTransferQueue() const;
+
         VkCommandPool getCommandPool() const;
 
+        /// @brief The queue family of the graphics queue, which the command pool allocates
+        /// command buffers for.
+        uint32_t getGraphicsQueueFamilyIndex() const;
+
+        /// @brief The queue family of the present queue, which is the one of the graphics
+        /// queue whenever that family can present.
+        uint32_t getPresentQueueFamilyIndex() const;
+
+        /// @brief The queue family of the compute queue, a family of its own where the
+        /// device has one, and the one of the graphics queue otherwise.
+        uint32_t getComputeQueueFamilyIndex() const;
+
         VkSurfaceKHR getSurface() const;
 
         VkSampleCountFlagBits getMsaaSamples() const;
@@ -568,10 +1431,32 @@ class Engine final {
 
         void setFramebufferResized(bool framebufferResized);
 
+        VkExtent2D getFramebufferExtent() const;
+
+        uint64_t getWindowEventCount() const;
+
+        bool isWindowFocused() const;
+
+        bool isWindowIconified() const;
+
+        bool isKeyDown(int key) const;
+
+        bool isWindowCloseRequested() const;
+
+        void pollWindowEvents();
+
+        void waitWindowEvents(std::optional<double> timeoutSeconds);
+
+        void runWindowEventPump(const std::function<void()>& render);
+
+        void setWindowTitle(const std::string& title);
+
         bool isInitialized() const;
 
         void createGLFWLibrary();
 
+        void createHostAllocator();
+
         void createInfoProvider();
 
         void createSystemFactory();
@@ -584,14 +1469,68 @@ class Engine final {
 
         void createWindow(uint32_t width, uint32_t height, const std::string& title);
 
+        /// @brief Open a viewport window and create its surface, which presents from the
+        /// same queue as the one of the main window, and return its index.
+        ///
+        /// @note Must be called on the main thread, after `createWindow`.
+        uint32_t createViewportWindow(uint32_t width, uint32_t height, const std::string& title);
+
+        uint32_t getViewportCount() const;
+
+        VkSurfaceKHR getViewportSurface(uint32_t viewport) const;
+
+        VkExtent2D getViewportExtent(uint32_t viewport) const;
+
+        bool hasViewportResized(uint32_t viewport) const;
+
+        void setViewportResized(uint32_t viewport, bool viewportResized);
+
         void createGpuDevice();
 
-        void createRenderSurface();
+        /// @brief Destroy the device, which was lost, and open it again on the physical
+        /// device the selection picks, with a new surface for the main window.
+        ///
+        /// @note Everything created from the old device has to be destroyed first. The
+        /// instance, the window system, the windows and the surfaces of the viewport windows
+        /// are kept, and the pipeline cache of the old device is written out and read back,
+        /// unless the device was marked lost, so this skips most of what `create` does.
+        void recreateGpuDevice();
 
-        QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const;
+        /// @brief Record that the device was lost, before what was created from it is
+        /// destroyed.
+        void markDeviceLost();
+
+        bool isDeviceLost() const;
+
+        void createRenderSurface();
 
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const;
 
+        /// @brief The present mode `policy` asks for, or the nearest one in
+        /// `availablePresentModes` when the surface does not have it.
+        ///
+        /// @note Immediate falls back on mailbox, which is uncapped too, and every other mode
+        /// falls back on FIFO, which every surface supports.
+        static VkPresentModeKHR selectPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, PresentModePolicy policy);
+
+        /// @brief The image count `policy` asks for, for a swap chain of `presentMode` that
+        /// `framesInFlight` frames render into, within the counts of `capabilities`.
+        static uint32_t selectSwapChainImageCount(
+            const VkSurfaceCapabilitiesKHR& capabilities,
+            VkPresentModeKHR presentMode,
+            uint32_t framesInFlight,
+            SwapChainImageCountPolicy policy
+        );
+
+        /// @brief The surface format `policy` asks for, or the nearest one in
+        /// `availableFormats` when the surface does not have it.
+        ///
+        /// @note `ScRgb` falls back on `Hdr10`, and `Hdr10` on `ScRgb`, so an HDR policy
+        /// stays HDR wherever the surface has either. Both then fall back on `Sdr10`, which
+        /// falls back on `Sdr`. Every policy takes BGR and RGB channel orders alike, and when
+        /// the surface has none of them, its first format is taken.
+        static VkSurfaceFormatKHR selectSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats, SurfaceFormatPolicy policy);
+
         VkShaderModule createShaderModuleFromFile(const std::string& fileName);
 
         VkShaderModule createShaderModule(std::istream& stream);
@@ -599,20 +1538,167 @@ class Engine final {
         VkShaderModule createShaderModule(const std::vector<char>& code);
 
         VkShaderModule createShaderModule(const std::vector<unsigned char>& code);
+
+        VkShaderModule createShaderModule(std::span<const uint32_t> code);
+
+        void releaseShaderModule(VkShaderModule shaderModule);
+
+        std::tuple<VkBuffer, GpuAllocation> createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+
+        std::optional<std::tuple<VkBuffer, GpuAllocation>> createMovedBuffer(
+            const GpuAllocation& allocation,
+            VkDeviceSize size,
+            VkBufferUsageFlags usage
+        );
+
+        std::tuple<VkImage, GpuAllocation> createImage(
+            uint32_t width,
+            uint32_t height,
+            uint32_t mipLevels,
+            VkSampleCountFlagBits numSamples,
+            VkFormat format,
+            VkImageTiling tiling,
+            VkImageUsageFlags usage,
+            VkMemoryPropertyFlags properties,
+            VkImageCreateFlags flags = 0,
+            uint32_t arrayLayers = 1,
+            uint32_t depth = 1,
+            VkImageType imageType = VK_IMAGE_TYPE_2D
+        );
+
+        void destroyBuffer(VkBuffer buffer, const GpuAllocation& allocation);
+
+        void destroyImage(VkImage image, const GpuAllocation& allocation);
+
+        std::tuple<VkImage, GpuAllocation> createTransientAttachment(
+            uint32_t width,
+            uint32_t height,
+            VkSampleCountFlagBits numSamples,
+            VkFormat format,
+            VkImageUsageFlags usage,
+            uint32_t arrayLayers = 1
+        );
+
+        GpuMemoryAllocator& getMemoryAllocator();
+
+        QueueSubmitter& getQueueSubmitter();
+
+        StagingRing& getStagingRing();
+
+        SamplerCache& getSamplerCache();
+
+        PipelineLayoutCache& getPipelineLayoutCache();
+
+        /// @brief The entry points of the commands of a frame, loaded from the device, for
+        /// recording without going through the loader.
+        ///
+        /// @note The table lives as long as the device, until `recreateGpuDevice`.
+        const DeviceDispatch& getDeviceDispatch() const;
+
+        UploadContext& getUploadContext();
+
+        void createPipelineCache(const std::filesystem::path& filePath);
+
+        VkPipelineCache getPipelineCache() const;
+
+        void createPipelineCompiler(uint32_t threadCount);
+
+        PipelineCompiler& getPipelineCompiler();
+
+        void createMipmapGenerator(
+            std::span<const uint32_t> shaderCode,
+            std::span<const uint32_t> filterShaderCode,
+            std::span<const uint32_t> volumeShaderCode
+        );
+
+        MipmapGenerator* getMipmapGenerator() const;
+
+        void createTextureCompressor(std::span<const uint32_t> shaderCode);
+
+        TextureCompressor* getTextureCompressor() const;
+
+        void createGpuDecompressor(std::span<const uint32_t> shaderCode);
+
+        GpuDecompressor* getGpuDecompressor() const;
+
+        HostImageCopier* getHostImageCopier() const;
+
+        bool supportsSparseTextures(VkFormat format, VkImageUsageFlags usage) const;
+
+        std::unique_ptr<SparseTexture> createSparseTexture(
+            uint32_t width,
+            uint32_t height,
+            uint32_t mipLevels,
+            VkFormat format,
+            VkImageUsageFlags usage,
+            VkDeviceSize memoryBudget
+        );
+
+        bool supportsMeshShading() const;
+
+        void drawMeshTasks(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) const;
+
+        bool supportsDynamicRendering() const;
+
+        bool supportsSynchronization2() const;
+
+        bool supportsPushDescriptors() const;
+
+        bool supportsExtendedDynamicState() const;
+
+        bool supportsDrawIndirectCount() const;
+
+        bool supportsBufferDeviceAddress() const;
+
+        VkDeviceAddress getBufferDeviceAddress(VkBuffer buffer) const;
+
+        bool supportsDescriptorBuffer() const;
+
+        bool supportsGraphicsPipelineLibrary() const;
+
+        bool supportsFragmentShadingRate() const;
+
+        bool supportsFragmentShadingRateAttachment() const;
+
+        VkPhysicalDeviceFragmentShadingRatePropertiesKHR getFragmentShadingRateProperties() const;
+
+        void setFragmentShadingRate(
+            VkCommandBuffer commandBuffer,
+            VkExtent2D fragmentSize,
+            std::span<const VkFragmentShadingRateCombinerOpKHR, 2> combinerOps
+        ) const;
+
+        bool supportsConditionalRendering() const;
+
+        void beginConditionalRendering(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset) const;
+
+        void endConditionalRendering(VkCommandBuffer commandBuffer) const;
+
+        bool supportsPresentWait() const;
+
+        VkResult waitForPresent(VkSwapchainKHR swapChain, uint64_t presentId, uint64_t timeout) const;
+
+        bool supportsExternalMemoryFd() const;
+
+        bool supportsMaintenance5() const;
     private:
-        std::unique_ptr<PlatformInfoProvider> m_infoProvider;
+        std::unique_ptr<HostAllocator> m_hostAllocator;
+        std::shared_ptr<PlatformInfoProvider> m_infoProvider;
         std::unique_ptr<SystemFactory> m_systemFactory;
         VkInstance m_instance;
         std::unique_ptr<VulkanDebugMessenger> m_debugMessenger;
         std::unique_ptr<WindowSystem> m_windowSystem;
-        VkSurfaceKHR m_surface;
+        VkSurfaceKHR m_surface { VK_NULL_HANDLE };
+        std::vector<VkSurfaceKHR> m_viewportSurfaces;
 
         std::unique_ptr<GpuDevice> m_gpuDevice;
 
+        EngineMode m_engineMode { EngineMode::Release };
         bool m_enableValidationLayers; 
+        bool m_enableGpuAssistedValidation { false };
         bool m_enableDebuggingExtensions;
-
-        static std::unique_ptr<Engine> create(bool enableDebugging);
+        bool m_isHeadless { false };
+        DeviceSelection m_deviceSelection;
 };
 
 }
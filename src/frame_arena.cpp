@@ -0,0 +1,118 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <bit>
+#include <new>
+#include <stdexcept>
+
+
+using FrameArena = VulkanEngine::FrameArena;
+
+static constexpr size_t BLOCK_ALIGNMENT = alignof(std::max_align_t);
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+FrameArena::FrameArena(size_t capacity)
+    : m_block { nullptr }
+    , m_capacity { capacity }
+    , m_head { 0 }
+    , m_overflowBlocks { nullptr }
+    , m_overflowBytes { 0 }
+    , m_overflowCount { 0 }
+    , m_peakBytes { 0 }
+{
+    if (capacity == 0) {
+        throw std::invalid_argument("a frame arena needs a capacity!");
+    }
+
+    m_block = static_cast<std::byte*>(::operator new(m_capacity, std::align_val_t { BLOCK_ALIGNMENT }));
+}
+
+FrameArena::~FrameArena() {
+    this->freeOverflowBlocks();
+    ::operator delete(m_block, std::align_val_t { BLOCK_ALIGNMENT });
+    m_block = nullptr;
+    m_capacity = 0;
+    m_head = 0;
+}
+
+void FrameArena::reset() {
+    m_peakBytes = std::max(m_peakBytes, this->getUsedBytes());
+
+    // The frame ran over, so the arena grows to the whole of it, and the frames like it
+    // after fit without the heap.
+    if (m_overflowCount > 0) {
+        const auto capacity = std::bit_ceil(m_head + m_overflowBytes);
+        auto* block = static_cast<std::byte*>(::operator new(capacity, std::align_val_t { BLOCK_ALIGNMENT }));
+        ::operator delete(m_block, std::align_val_t { BLOCK_ALIGNMENT });
+        m_block = block;
+        m_capacity = capacity;
+    }
+
+    this->freeOverflowBlocks();
+    m_head = 0;
+}
+
+size_t FrameArena::getCapacity() const {
+    return m_capacity;
+}
+
+size_t FrameArena::getUsedBytes() const {
+    return m_head + m_overflowBytes;
+}
+
+size_t FrameArena::getPeakBytes() const {
+    return std::max(m_peakBytes, this->getUsedBytes());
+}
+
+uint32_t FrameArena::getOverflowCount() const {
+    return m_overflowCount;
+}
+
+void FrameArena::freeOverflowBlocks() {
+    while (m_overflowBlocks != nullptr) {
+        auto* block = m_overflowBlocks;
+        m_overflowBlocks = block->next;
+
+        const auto alignment = block->alignment;
+        ::operator delete(block, std::align_val_t { alignment });
+    }
+
+    m_overflowBytes = 0;
+    m_overflowCount = 0;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    // The block is only aligned to `BLOCK_ALIGNMENT`, so stricter alignments are worked
+    // out from the address.
+    const auto base = reinterpret_cast<uintptr_t>(m_block);
+    const auto offset = alignUp(base + m_head, alignment) - base;
+    if (offset + bytes <= m_capacity) {
+        m_head = offset + bytes;
+
+        return m_block + offset;
+    }
+
+    const auto blockAlignment = std::max(alignment, alignof(OverflowBlock));
+    const auto headerSize = alignUp(sizeof(OverflowBlock), blockAlignment);
+    auto* block = static_cast<OverflowBlock*>(::operator new(headerSize + bytes, std::align_val_t { blockAlignment }));
+    *block = OverflowBlock {
+        .next = m_overflowBlocks,
+        .alignment = blockAlignment,
+    };
+    m_overflowBlocks = block;
+    m_overflowBytes += bytes + alignment;
+    m_overflowCount++;
+
+    return reinterpret_cast<std::byte*>(block) + headerSize;
+}
+
+void FrameArena::do_deallocate(void*, size_t, size_t) {
+    // Everything is handed back at once by `reset`.
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,77 @@
+#ifndef _FRAME_ARENA_H
+#define _FRAME_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+
+namespace VulkanEngine {
+
+/// @brief A bump allocator for the scratch data of one frame slot, like the passes of its
+/// render graph and the barriers between them, which is rewound all at once when the
+/// slot's previous submit is known to have finished.
+///
+/// @note The arena is a `std::pmr::memory_resource`, so containers take it through
+/// `std::pmr::polymorphic_allocator`. Deallocation does nothing, and the memory comes back
+/// with `reset`. A frame that needs more than the arena holds takes the rest from the heap,
+/// and the next `reset` grows the arena to fit it, so a renderer whose frames all look
+/// alike stops going to the heap after its first frames. The arena is not thread-safe, and
+/// only the thread that records the frame may allocate from it.
+class FrameArena final : public std::pmr::memory_resource {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+        explicit FrameArena() = delete;
+        explicit FrameArena(size_t capacity);
+
+        ~FrameArena();
+
+        FrameArena(const FrameArena& other) = delete;
+        FrameArena& operator=(const FrameArena& other) = delete;
+
+        /// @brief Hand every allocation back at once, and grow the arena to fit the frame
+        /// just finished if it ran over.
+        ///
+        /// @note Nothing allocated from the arena since the last reset may still be used.
+        void reset();
+
+        size_t getCapacity() const;
+
+        /// @brief The bytes allocated since the last reset, with the ones taken from the heap.
+        size_t getUsedBytes() const;
+
+        /// @brief The most bytes any frame allocated.
+        size_t getPeakBytes() const;
+
+        /// @brief The allocations since the last reset that did not fit, and went to the heap.
+        ///
+        /// @note In a steady state this stays zero.
+        uint32_t getOverflowCount() const;
+    private:
+        /// @brief The header in front of an allocation that went to the heap.
+        struct OverflowBlock final {
+            OverflowBlock* next;
+            size_t alignment;
+        };
+
+        std::byte* m_block;
+        size_t m_capacity;
+        size_t m_head;
+        OverflowBlock* m_overflowBlocks;
+        size_t m_overflowBytes;
+        uint32_t m_overflowCount;
+        size_t m_peakBytes;
+
+        void freeOverflowBlocks();
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+
+        void do_deallocate(void* memory, size_t bytes, size_t alignment) override;
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+}
+
+#endif // _FRAME_ARENA_H
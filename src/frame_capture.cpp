@@ -0,0 +1,482 @@
+#include "frame_capture.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include <fmt/core.h>
+
+#include "texture_format.h"
+#include "command_counters.h"
+
+
+using FrameCapture = VulkanEngine::FrameCapture;
+using CaptureEncoding = VulkanEngine::CaptureEncoding;
+using TextureFormats = VulkanEngine::TextureFormats;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+static bool isBgraFormat(VkFormat format) {
+    return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+}
+
+FrameCapture::FrameCapture(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    uint32_t queueFamilyIndex,
+    VkExtent2D extent,
+    VkFormat format,
+    uint32_t slotCount
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_extent { extent }
+    , m_format { format }
+    , m_commandPool { VK_NULL_HANDLE }
+    , m_timelineSemaphore { VK_NULL_HANDLE }
+    , m_submitCount { 0 }
+    , m_slots { std::vector<Slot> {} }
+    , m_mutex {}
+    , m_captureAvailable {}
+    , m_captureWritten {}
+    , m_pendingCaptures { std::deque<PendingCapture> {} }
+    , m_writingCount { 0 }
+    , m_writtenCount { 0 }
+    , m_droppedCount { 0 }
+    , m_error { nullptr }
+    , m_isStopping { false }
+    , m_worker {}
+{
+    if (slotCount == 0 || !TextureFormats::getInfo(format).has_value()) {
+        throw std::invalid_argument("frame captures need a slot and an uncompressed format!");
+    }
+
+    // Every slot's command buffer is recorded again whenever the slot is reused.
+    const auto poolInfo = VkCommandPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = queueFamilyIndex,
+    };
+    const auto resultCreateCommandPool = vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool);
+    if (resultCreateCommandPool != VK_SUCCESS) {
+        throw std::runtime_error("failed to create frame capture command pool!");
+    }
+
+    const auto timelineCreateInfo = VkSemaphoreTypeCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = nullptr,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    const auto semaphoreInfo = VkSemaphoreCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timelineCreateInfo,
+        .flags = 0,
+    };
+    const auto resultCreateSemaphore = vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_timelineSemaphore);
+    if (resultCreateSemaphore != VK_SUCCESS) {
+        throw std::runtime_error("failed to create frame capture timeline semaphore!");
+    }
+
+    this->createSlots(slotCount);
+
+    m_worker = std::thread { [this]() { this->run(); } };
+}
+
+FrameCapture::~FrameCapture() {
+    {
+        auto lock = std::unique_lock<std::mutex> { m_mutex };
+        m_isStopping = true;
+    }
+    m_captureAvailable.notify_all();
+    m_worker.join();
+
+    for (auto& slot : m_slots) {
+        vkDestroyBuffer(m_device, slot.buffer, nullptr);
+        m_allocator.free(slot.allocation);
+        slot.buffer = VK_NULL_HANDLE;
+        slot.commandBuffer = VK_NULL_HANDLE;
+    }
+
+    vkDestroySemaphore(m_device, m_timelineSemaphore, nullptr);
+    vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+
+    m_timelineSemaphore = VK_NULL_HANDLE;
+    m_commandPool = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+bool FrameCapture::isEncodable(VkFormat format, CaptureEncoding encoding) {
+    switch (encoding) {
+        case CaptureEncoding::Ppm:
+            return format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB || isBgraFormat(format);
+        case CaptureEncoding::Pfm:
+            return format == VK_FORMAT_R16G16B16A16_SFLOAT;
+        case CaptureEncoding::Raw:
+            return TextureFormats::getInfo(format).has_value();
+    }
+
+    return false;
+}
+
+bool FrameCapture::capture(
+    VkQueue queue,
+    VkImage image,
+    uint32_t arrayLayer,
+    const std::filesystem::path& filePath,
+    CaptureEncoding encoding
+) {
+    if (!FrameCapture::isEncodable(m_format, encoding)) {
+        throw std::invalid_argument("frame captures of this format cannot be written with this encoding!");
+    }
+
+    auto slotIndex = static_cast<uint32_t>(m_slots.size());
+    {
+        auto lock = std::unique_lock<std::mutex> { m_mutex };
+        for (uint32_t i = 0; i < m_slots.size(); i++) {
+            if (m_slots[i].isFree) {
+                slotIndex = i;
+                break;
+            }
+        }
+
+        if (slotIndex == m_slots.size()) {
+            m_droppedCount++;
+
+            return false;
+        }
+
+        m_slots[slotIndex].isFree = false;
+    }
+
+    const auto& slot = m_slots[slotIndex];
+    this->recordCopy(slot, image, arrayLayer);
+
+    // Submission order puts the copy after the frame, and the copy's barrier after the
+    // frame's color writes.
+    const auto timelineValue = m_submitCount + 1;
+    const auto timelineSubmitInfo = VkTimelineSemaphoreSubmitInfo {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreValueCount = 0,
+        .pWaitSemaphoreValues = nullptr,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues = &timelineValue,
+    };
+    const auto submitInfo = VkSubmitInfo {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = &timelineSubmitInfo,
+        .waitSemaphoreCount = 0,
+        .pWaitSemaphores = nullptr,
+        .pWaitDstStageMask = nullptr,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &slot.commandBuffer,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = &m_timelineSemaphore,
+    };
+    const auto resultQueueSubmit = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+    if (resultQueueSubmit != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit frame capture command buffer!");
+    }
+    m_submitCount = timelineValue;
+
+    {
+        auto lock = std::unique_lock<std::mutex> { m_mutex };
+        m_pendingCaptures.push_back(PendingCapture {
+            .slotIndex = slotIndex,
+            .timelineValue = timelineValue,
+            .filePath = filePath,
+            .encoding = encoding,
+        });
+    }
+    m_captureAvailable.notify_one();
+
+    return true;
+}
+
+void FrameCapture::waitIdle() {
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+    m_captureWritten.wait(lock, [this]() { return m_pendingCaptures.empty() && m_writingCount == 0; });
+    if (m_error) {
+        auto error = std::exchange(m_error, nullptr);
+        std::rethrow_exception(error);
+    }
+}
+
+uint32_t FrameCapture::getWrittenCount() const {
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+
+    return m_writtenCount;
+}
+
+uint32_t FrameCapture::getDroppedCount() const {
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+
+    return m_droppedCount;
+}
+
+void FrameCapture::createSlots(uint32_t slotCount) {
+    const auto slotSize = TextureFormats::getInfo(m_format)->getLevelSize(m_extent.width, m_extent.height);
+    const auto allocInfo = VkCommandBufferAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = m_commandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = slotCount,
+    };
+    auto commandBuffers = std::vector<VkCommandBuffer>(slotCount, VK_NULL_HANDLE);
+    const auto resultAllocateCommandBuffers = vkAllocateCommandBuffers(m_device, &allocInfo, commandBuffers.data());
+    if (resultAllocateCommandBuffers != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate frame capture command buffers!");
+    }
+
+    m_slots.reserve(slotCount);
+    for (uint32_t i = 0; i < slotCount; i++) {
+        const auto bufferInfo = VkBufferCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = slotSize,
+            .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        };
+
+        auto buffer = VkBuffer {};
+        const auto resultCreateBuffer = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+        if (resultCreateBuffer != VK_SUCCESS) {
+            throw std::runtime_error("failed to create frame capture buffer!");
+        }
+
+        auto memRequirements = VkMemoryRequirements {};
+        vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+        // The host reads every byte of the slot back, which is far faster from cached memory.
+        const auto allocation = m_allocator.allocate(
+            memRequirements,
+            m_allocator.selectUploadMemoryProperties(memRequirements.memoryTypeBits, true),
+            GpuResourceKind::Linear,
+            GpuMemoryCategory::Staging
+        );
+
+        vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+        m_slots.push_back(Slot {
+            .buffer = buffer,
+            .allocation = allocation,
+            .commandBuffer = commandBuffers[i],
+            .isFree = true,
+        });
+    }
+}
+
+void FrameCapture::recordCopy(const Slot& slot, VkImage image, uint32_t arrayLayer) const {
+    vkResetCommandBuffer(slot.commandBuffer, 0);
+
+    const auto beginInfo = VkCommandBufferBeginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    vkBeginCommandBuffer(slot.commandBuffer, &beginInfo);
+
+    // The frame left the image ready to copy from, but its writes still have to be made
+    // visible to the copy.
+    const auto subresourceRange = VkImageSubresourceRange {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = 0,
+        .levelCount = 1,
+        .baseArrayLayer = arrayLayer,
+        .layerCount = 1,
+    };
+    const auto imageBarrier = VkImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = subresourceRange,
+    };
+    vkCmdPipelineBarrier(
+        slot.commandBuffer,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        1,
+        &imageBarrier
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    const auto region = VkBufferImageCopy {
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .imageSubresource.mipLevel = 0,
+        .imageSubresource.baseArrayLayer = arrayLayer,
+        .imageSubresource.layerCount = 1,
+        .imageOffset = VkOffset3D { 0, 0, 0 },
+        .imageExtent = VkExtent3D { m_extent.width, m_extent.height, 1 },
+    };
+    vkCmdCopyImageToBuffer(slot.commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+    // The copy's writes are made visible to the host, and the next frame's color writes to
+    // the image wait for the copy to have read it.
+    const auto bufferBarrier = VkBufferMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = slot.buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+    vkCmdPipelineBarrier(
+        slot.commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        0,
+        nullptr,
+        1,
+        &bufferBarrier,
+        0,
+        nullptr
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+    vkCmdPipelineBarrier(
+        slot.commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    const auto resultEndCommandBuffer = vkEndCommandBuffer(slot.commandBuffer);
+    if (resultEndCommandBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to record frame capture command buffer!");
+    }
+}
+
+void FrameCapture::run() {
+    while (true) {
+        auto capture = PendingCapture {};
+        {
+            auto lock = std::unique_lock<std::mutex> { m_mutex };
+            m_captureAvailable.wait(lock, [this]() { return m_isStopping || !m_pendingCaptures.empty(); });
+            // Stopping still writes every capture that was taken.
+            if (m_pendingCaptures.empty()) {
+                return;
+            }
+
+            capture = std::move(m_pendingCaptures.front());
+            m_pendingCaptures.pop_front();
+            m_writingCount++;
+        }
+
+        auto error = std::exception_ptr { nullptr };
+        try {
+            const auto waitInfo = VkSemaphoreWaitInfo {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .semaphoreCount = 1,
+                .pSemaphores = &m_timelineSemaphore,
+                .pValues = &capture.timelineValue,
+            };
+            const auto resultWaitSemaphores = vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX);
+            if (resultWaitSemaphores != VK_SUCCESS) {
+                throw std::runtime_error("failed to wait for frame capture copy!");
+            }
+
+            this->write(m_slots[capture.slotIndex], capture);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            auto lock = std::unique_lock<std::mutex> { m_mutex };
+            m_slots[capture.slotIndex].isFree = true;
+            m_writingCount--;
+            if (error) {
+                m_error = m_error ? m_error : error;
+            } else {
+                m_writtenCount++;
+            }
+        }
+        m_captureWritten.notify_all();
+    }
+}
+
+void FrameCapture::write(const Slot& slot, const PendingCapture& capture) const {
+    m_allocator.invalidate(slot.allocation);
+
+    if (capture.filePath.has_parent_path()) {
+        std::filesystem::create_directories(capture.filePath.parent_path());
+    }
+
+    auto file = std::ofstream { capture.filePath, std::ios::out | std::ios::binary | std::ios::trunc };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open frame capture file!");
+    }
+
+    const auto* texels = static_cast<const uint8_t*>(slot.allocation.mappedData);
+    const auto pixelCount = static_cast<size_t>(m_extent.width) * m_extent.height;
+    switch (capture.encoding) {
+        case CaptureEncoding::Ppm: {
+            // PPM stores three channels in RGB order.
+            const auto redIndex = isBgraFormat(m_format) ? 2 : 0;
+            const auto blueIndex = isBgraFormat(m_format) ? 0 : 2;
+            auto rgbPixels = std::vector<uint8_t>(pixelCount * 3);
+            for (size_t i = 0; i < pixelCount; i++) {
+                rgbPixels[3 * i + 0] = texels[4 * i + redIndex];
+                rgbPixels[3 * i + 1] = texels[4 * i + 1];
+                rgbPixels[3 * i + 2] = texels[4 * i + blueIndex];
+            }
+
+            file << fmt::format("P6\n{} {}\n255\n", m_extent.width, m_extent.height);
+            file.write(reinterpret_cast<const char*>(rgbPixels.data()), static_cast<std::streamsize>(rgbPixels.size()));
+            break;
+        }
+        case CaptureEncoding::Pfm: {
+            // A negative scale marks the floats as little endian.
+            auto rgbPixels = std::vector<float>(pixelCount * 3);
+            for (uint32_t y = 0; y < m_extent.height; y++) {
+                const auto sourceRow = static_cast<size_t>(m_extent.height - 1 - y) * m_extent.width;
+                for (uint32_t x = 0; x < m_extent.width; x++) {
+                    auto halves = std::array<uint16_t, 4> {};
+                    std::memcpy(halves.data(), texels + 8 * (sourceRow + x), sizeof(halves));
+                    const auto pixelIndex = static_cast<size_t>(y) * m_extent.width + x;
+                    rgbPixels[3 * pixelIndex + 0] = TextureFormats::fromHalf(halves[0]);
+                    rgbPixels[3 * pixelIndex + 1] = TextureFormats::fromHalf(halves[1]);
+                    rgbPixels[3 * pixelIndex + 2] = TextureFormats::fromHalf(halves[2]);
+                }
+            }
+
+            file << fmt::format("PF\n{} {}\n-1.0\n", m_extent.width, m_extent.height);
+            file.write(reinterpret_cast<const char*>(rgbPixels.data()), static_cast<std::streamsize>(rgbPixels.size() * sizeof(float)));
+            break;
+        }
+        case CaptureEncoding::Raw: {
+            const auto size = TextureFormats::getInfo(m_format)->getLevelSize(m_extent.width, m_extent.height);
+            file.write(reinterpret_cast<const char*>(texels), static_cast<std::streamsize>(size));
+            break;
+        }
+    }
+
+    if (!file) {
+        throw std::runtime_error("failed to write frame capture file!");
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef _FRAME_CAPTURE_H
+#define _FRAME_CAPTURE_H
+
+#include <vulkan/vulkan.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief The file a captured frame is written as.
+enum class CaptureEncoding {
+    /// @brief An 8-bit binary PPM, of an RGBA or BGRA image with 8 bits a channel. Alpha is
+    /// dropped.
+    Ppm,
+    /// @brief A little endian PFM, of an RGBA image with half floats a channel, which keeps
+    /// the range of HDR frames. Alpha is dropped, and the rows go bottom up as PFM has them.
+    Pfm,
+    /// @brief The texels as the device copied them, tightly packed, with nothing around them.
+    Raw,
+};
+
+/// @brief Copies frames into a ring of persistently mapped readback buffers, and writes
+/// them out on a worker thread once the device is done with them, so that capturing a
+/// frame never waits on the device.
+///
+/// @note Every capture takes a slot of the ring, and submits a copy of its own after the
+/// frame that rendered the image, on the same queue, which signals a timeline semaphore of
+/// the capture's own. The worker waits on that value, then encodes the slot into its file
+/// and hands the slot back. When every slot is still being copied or written, the capture
+/// is dropped instead of stalling the frame loop, and counted.
+///
+/// The image has to be `extent` and `format`, and be in
+/// `VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL` after color attachment writes, which it stays in.
+/// The queue is only submitted to from the thread that captures.
+class FrameCapture final {
+    public:
+        explicit FrameCapture() = delete;
+        explicit FrameCapture(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            uint32_t queueFamilyIndex,
+            VkExtent2D extent,
+            VkFormat format,
+            uint32_t slotCount
+        );
+
+        /// @brief Write every capture in flight, then stop.
+        ~FrameCapture();
+
+        FrameCapture(const FrameCapture& other) = delete;
+        FrameCapture& operator=(const FrameCapture& other) = delete;
+
+        /// @brief Whether captures of `format` can be written as `encoding`.
+        static bool isEncodable(VkFormat format, CaptureEncoding encoding);
+
+        /// @brief Copy the layer `arrayLayer` of `image` into a free slot after everything
+        /// submitted to `queue` so far, to be written to `filePath` as `encoding`.
+        ///
+        /// @returns Whether a slot was free, and the capture was taken.
+        bool capture(
+            VkQueue queue,
+            VkImage image,
+            uint32_t arrayLayer,
+            const std::filesystem::path& filePath,
+            CaptureEncoding encoding
+        );
+
+        /// @brief Block until every capture taken so far has been written.
+        ///
+        /// @note A capture that failed to write rethrows its error here.
+        void waitIdle();
+
+        uint32_t getWrittenCount() const;
+
+        uint32_t getDroppedCount() const;
+    private:
+        struct Slot final {
+            VkBuffer buffer;
+            GpuAllocation allocation;
+            VkCommandBuffer commandBuffer;
+            bool isFree;
+        };
+
+        struct PendingCapture final {
+            uint32_t slotIndex;
+            uint64_t timelineValue;
+            std::filesystem::path filePath;
+            CaptureEncoding encoding;
+        };
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkExtent2D m_extent;
+        VkFormat m_format;
+        VkCommandPool m_commandPool;
+        VkSemaphore m_timelineSemaphore;
+        uint64_t m_submitCount;
+        std::vector<Slot> m_slots;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_captureAvailable;
+        std::condition_variable m_captureWritten;
+        std::deque<PendingCapture> m_pendingCaptures;
+        uint32_t m_writingCount;
+        uint32_t m_writtenCount;
+        uint32_t m_droppedCount;
+        std::exception_ptr m_error;
+        bool m_isStopping;
+        std::thread m_worker;
+
+        void createSlots(uint32_t slotCount);
+
+        void recordCopy(const Slot& slot, VkImage image, uint32_t arrayLayer) const;
+
+        void run();
+
+        void write(const Slot& slot, const PendingCapture& capture) const;
+};
+
+}
+
+#endif // _FRAME_CAPTURE_H
@@ -0,0 +1,314 @@
+#include "frame_exporter.h"
+
+#include <stdexcept>
+
+
+using FrameExporter = VulkanEngine::FrameExporter;
+using ExportedFrame = VulkanEngine::ExportedFrame;
+
+static uint32_t findDeviceLocalMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter) {
+    auto memoryProperties = VkPhysicalDeviceMemoryProperties {};
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        const auto isAllowed = (typeFilter & (1u << i)) != 0;
+        const auto isDeviceLocal = (memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0;
+        if (isAllowed && isDeviceLocal) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find a device local memory type for exported frames!");
+}
+
+FrameExporter::FrameExporter(
+    VkPhysicalDevice physicalDevice,
+    VkDevice device,
+    VkExtent2D extent,
+    VkFormat format,
+    VkImageUsageFlags usage,
+    uint32_t imageCount
+)
+    : m_device { device }
+    , m_extent { extent }
+    , m_format { format }
+    , m_images { std::vector<VkImage> {} }
+    , m_imageMemories { std::vector<VkDeviceMemory> {} }
+    , m_imageMemorySizes { std::vector<VkDeviceSize> {} }
+    , m_timelineSemaphore { VK_NULL_HANDLE }
+    , m_vkGetMemoryFdKHR { nullptr }
+    , m_vkGetSemaphoreFdKHR { nullptr }
+    , m_mutex {}
+    , m_imageReleased {}
+    , m_latestFrame { std::nullopt }
+    , m_isTaken { std::vector<bool>(imageCount, false) }
+    , m_droppedCount { 0 }
+{
+    if (!FrameExporter::isSupported(physicalDevice, format, usage)) {
+        throw std::runtime_error("failed to create frame exporter: the device cannot export these images as file descriptors!");
+    }
+
+    // The loader does not export extension commands, so they come from the device.
+    m_vkGetMemoryFdKHR = reinterpret_cast<PFN_vkGetMemoryFdKHR>(
+        vkGetDeviceProcAddr(m_device, "vkGetMemoryFdKHR")
+    );
+    m_vkGetSemaphoreFdKHR = reinterpret_cast<PFN_vkGetSemaphoreFdKHR>(
+        vkGetDeviceProcAddr(m_device, "vkGetSemaphoreFdKHR")
+    );
+    if (m_vkGetMemoryFdKHR == nullptr || m_vkGetSemaphoreFdKHR == nullptr) {
+        throw std::runtime_error("failed to load external memory commands!");
+    }
+
+    this->createImages(physicalDevice, usage, imageCount);
+    this->createTimelineSemaphore();
+}
+
+FrameExporter::~FrameExporter() {
+    vkDestroySemaphore(m_device, m_timelineSemaphore, nullptr);
+    for (size_t i = 0; i < m_images.size(); i++) {
+        vkDestroyImage(m_device, m_images[i], nullptr);
+        vkFreeMemory(m_device, m_imageMemories[i], nullptr);
+    }
+
+    m_images.clear();
+    m_imageMemories.clear();
+    m_timelineSemaphore = VK_NULL_HANDLE;
+    m_vkGetMemoryFdKHR = nullptr;
+    m_vkGetSemaphoreFdKHR = nullptr;
+    m_device = VK_NULL_HANDLE;
+}
+
+bool FrameExporter::isSupported(VkPhysicalDevice physicalDevice, VkFormat format, VkImageUsageFlags usage) {
+    const auto externalImageFormatInfo = VkPhysicalDeviceExternalImageFormatInfo {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_IMAGE_FORMAT_INFO,
+        .pNext = nullptr,
+        .handleType = MEMORY_HANDLE_TYPE,
+    };
+    const auto imageFormatInfo = VkPhysicalDeviceImageFormatInfo2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+        .pNext = &externalImageFormatInfo,
+        .format = format,
+        .type = VK_IMAGE_TYPE_2D,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = usage,
+        .flags = 0,
+    };
+    auto externalImageFormatProperties = VkExternalImageFormatProperties {
+        .sType = VK_STRUCTURE_TYPE_EXTERNAL_IMAGE_FORMAT_PROPERTIES,
+        .pNext = nullptr,
+    };
+    auto imageFormatProperties = VkImageFormatProperties2 {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2,
+        .pNext = &externalImageFormatProperties,
+    };
+    const auto result = vkGetPhysicalDeviceImageFormatProperties2(physicalDevice, &imageFormatInfo, &imageFormatProperties);
+    if (result != VK_SUCCESS) {
+        return false;
+    }
+
+    const auto memoryFeatures = externalImageFormatProperties.externalMemoryProperties.externalMemoryFeatures;
+    if ((memoryFeatures & VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT) == 0) {
+        return false;
+    }
+
+    const auto semaphoreTypeInfo = VkSemaphoreTypeCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = nullptr,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    const auto externalSemaphoreInfo = VkPhysicalDeviceExternalSemaphoreInfo {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_SEMAPHORE_INFO,
+        .pNext = &semaphoreTypeInfo,
+        .handleType = SEMAPHORE_HANDLE_TYPE,
+    };
+    auto externalSemaphoreProperties = VkExternalSemaphoreProperties {
+        .sType = VK_STRUCTURE_TYPE_EXTERNAL_SEMAPHORE_PROPERTIES,
+        .pNext = nullptr,
+    };
+    vkGetPhysicalDeviceExternalSemaphoreProperties(physicalDevice, &externalSemaphoreInfo, &externalSemaphoreProperties);
+
+    return (externalSemaphoreProperties.externalSemaphoreFeatures & VK_EXTERNAL_SEMAPHORE_FEATURE_EXPORTABLE_BIT) != 0;
+}
+
+const std::vector<VkImage>& FrameExporter::getImages() const {
+    return m_images;
+}
+
+VkDeviceSize FrameExporter::getMemorySize(uint32_t imageIndex) const {
+    return m_imageMemorySizes.at(imageIndex);
+}
+
+VkSemaphore FrameExporter::getTimelineSemaphore() const {
+    return m_timelineSemaphore;
+}
+
+int FrameExporter::exportMemoryFd(uint32_t imageIndex) const {
+    const auto getFdInfo = VkMemoryGetFdInfoKHR {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
+        .pNext = nullptr,
+        .memory = m_imageMemories.at(imageIndex),
+        .handleType = MEMORY_HANDLE_TYPE,
+    };
+    auto fd = -1;
+    const auto result = m_vkGetMemoryFdKHR(m_device, &getFdInfo, &fd);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to export exported frame memory as a file descriptor!");
+    }
+
+    return fd;
+}
+
+int FrameExporter::exportSemaphoreFd() const {
+    const auto getFdInfo = VkSemaphoreGetFdInfoKHR {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_GET_FD_INFO_KHR,
+        .pNext = nullptr,
+        .semaphore = m_timelineSemaphore,
+        .handleType = SEMAPHORE_HANDLE_TYPE,
+    };
+    auto fd = -1;
+    const auto result = m_vkGetSemaphoreFdKHR(m_device, &getFdInfo, &fd);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to export exported frame timeline semaphore as a file descriptor!");
+    }
+
+    return fd;
+}
+
+void FrameExporter::waitForRelease(uint32_t imageIndex) {
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+    if (m_latestFrame.has_value() && m_latestFrame->imageIndex == imageIndex) {
+        m_latestFrame = std::nullopt;
+        m_droppedCount++;
+    }
+
+    m_imageReleased.wait(lock, [this, imageIndex]() { return !m_isTaken[imageIndex]; });
+}
+
+void FrameExporter::publish(uint32_t imageIndex, uint64_t timelineValue) {
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+    if (m_latestFrame.has_value()) {
+        m_droppedCount++;
+    }
+
+    m_latestFrame = ExportedFrame {
+        .imageIndex = imageIndex,
+        .timelineValue = timelineValue,
+    };
+}
+
+std::optional<ExportedFrame> FrameExporter::takeLatestFrame() {
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+    if (!m_latestFrame.has_value()) {
+        return std::nullopt;
+    }
+
+    const auto frame = *m_latestFrame;
+    m_latestFrame = std::nullopt;
+    m_isTaken[frame.imageIndex] = true;
+
+    return frame;
+}
+
+void FrameExporter::release(uint32_t imageIndex) {
+    {
+        auto lock = std::unique_lock<std::mutex> { m_mutex };
+        m_isTaken.at(imageIndex) = false;
+    }
+    m_imageReleased.notify_all();
+}
+
+uint64_t FrameExporter::getDroppedCount() const {
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+
+    return m_droppedCount;
+}
+
+void FrameExporter::createImages(VkPhysicalDevice physicalDevice, VkImageUsageFlags usage, uint32_t imageCount) {
+    m_images.reserve(imageCount);
+    m_imageMemories.reserve(imageCount);
+    m_imageMemorySizes.reserve(imageCount);
+    for (uint32_t i = 0; i < imageCount; i++) {
+        const auto externalMemoryImageInfo = VkExternalMemoryImageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .handleTypes = MEMORY_HANDLE_TYPE,
+        };
+        const auto imageInfo = VkImageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .pNext = &externalMemoryImageInfo,
+            .flags = 0,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = m_format,
+            .extent = VkExtent3D { m_extent.width, m_extent.height, 1 },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = usage,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+
+        auto image = VkImage {};
+        const auto resultCreateImage = vkCreateImage(m_device, &imageInfo, nullptr, &image);
+        if (resultCreateImage != VK_SUCCESS) {
+            throw std::runtime_error("failed to create exported frame image!");
+        }
+        m_images.push_back(image);
+
+        auto memRequirements = VkMemoryRequirements {};
+        vkGetImageMemoryRequirements(m_device, image, &memRequirements);
+
+        const auto exportAllocateInfo = VkExportMemoryAllocateInfo {
+            .sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .handleTypes = MEMORY_HANDLE_TYPE,
+        };
+        const auto dedicatedAllocateInfo = VkMemoryDedicatedAllocateInfo {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+            .pNext = &exportAllocateInfo,
+            .image = image,
+            .buffer = VK_NULL_HANDLE,
+        };
+        const auto allocateInfo = VkMemoryAllocateInfo {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = &dedicatedAllocateInfo,
+            .allocationSize = memRequirements.size,
+            .memoryTypeIndex = findDeviceLocalMemoryType(physicalDevice, memRequirements.memoryTypeBits),
+        };
+
+        auto memory = VkDeviceMemory {};
+        const auto resultAllocateMemory = vkAllocateMemory(m_device, &allocateInfo, nullptr, &memory);
+        if (resultAllocateMemory != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate exported frame memory!");
+        }
+        m_imageMemories.push_back(memory);
+        m_imageMemorySizes.push_back(memRequirements.size);
+
+        vkBindImageMemory(m_device, image, memory, 0);
+    }
+}
+
+void FrameExporter::createTimelineSemaphore() {
+    const auto exportSemaphoreInfo = VkExportSemaphoreCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_CREATE_INFO,
+        .pNext = nullptr,
+        .handleTypes = SEMAPHORE_HANDLE_TYPE,
+    };
+    const auto timelineCreateInfo = VkSemaphoreTypeCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = &exportSemaphoreInfo,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    const auto semaphoreInfo = VkSemaphoreCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timelineCreateInfo,
+        .flags = 0,
+    };
+    const auto result = vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_timelineSemaphore);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create exported frame timeline semaphore!");
+    }
+}
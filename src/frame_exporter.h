@@ -0,0 +1,120 @@
+#ifndef _FRAME_EXPORTER_H
+#define _FRAME_EXPORTER_H
+
+#include <vulkan/vulkan.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief A frame an external consumer can read, once the exported timeline reaches
+/// `timelineValue`.
+struct ExportedFrame final {
+    uint32_t imageIndex = 0;
+    uint64_t timelineValue = 0;
+};
+
+/// @brief Device-local images and a timeline semaphore whose memory is exported as POSIX
+/// file descriptors, so that a hardware encoder in another API or process can read
+/// rendered frames in place, without a readback to the host and an upload back.
+///
+/// @note The renderer draws into the images, signals the timeline with every frame it
+/// publishes, and leaves the image in `VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL`. A consumer
+/// imports the memories and the semaphore once, then takes the latest frame, waits for
+/// its timeline value on its own queue, reads the image, and releases it. Frames that are
+/// published before the consumer takes them are dropped in favor of newer ones, so a slow
+/// consumer never holds the renderer back. Only an image the consumer has taken and not
+/// released makes the renderer wait before drawing into it again.
+///
+/// Every image has a dedicated allocation, which is what importers like CUDA and the
+/// encoders built on it expect, and is created with the usage the renderer asks for.
+class FrameExporter final {
+    public:
+        static constexpr VkExternalMemoryHandleTypeFlagBits MEMORY_HANDLE_TYPE = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+        static constexpr VkExternalSemaphoreHandleTypeFlagBits SEMAPHORE_HANDLE_TYPE = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT;
+
+        explicit FrameExporter() = delete;
+        explicit FrameExporter(
+            VkPhysicalDevice physicalDevice,
+            VkDevice device,
+            VkExtent2D extent,
+            VkFormat format,
+            VkImageUsageFlags usage,
+            uint32_t imageCount
+        );
+
+        ~FrameExporter();
+
+        FrameExporter(const FrameExporter& other) = delete;
+        FrameExporter& operator=(const FrameExporter& other) = delete;
+
+        /// @brief Whether `physicalDevice` can export optimally tiled images of `format`
+        /// with `usage`, and timeline semaphores, as file descriptors.
+        static bool isSupported(VkPhysicalDevice physicalDevice, VkFormat format, VkImageUsageFlags usage);
+
+        const std::vector<VkImage>& getImages() const;
+
+        /// @brief The size of the memory of image `imageIndex`, which importers need next
+        /// to its file descriptor.
+        VkDeviceSize getMemorySize(uint32_t imageIndex) const;
+
+        /// @brief The timeline semaphore to signal with every frame that is published.
+        VkSemaphore getTimelineSemaphore() const;
+
+        /// @brief A new file descriptor for the memory of image `imageIndex`, which the
+        /// caller owns until it hands it to an importer.
+        int exportMemoryFd(uint32_t imageIndex) const;
+
+        /// @brief A new file descriptor for the timeline semaphore, which the caller owns
+        /// until it hands it to an importer.
+        int exportSemaphoreFd() const;
+
+        /// @brief Block until image `imageIndex` can be drawn into again: until the consumer
+        /// has released it, if it took it, and otherwise at once, dropping the frame in it
+        /// if the consumer never took it.
+        void waitForRelease(uint32_t imageIndex);
+
+        /// @brief Publish the frame drawn into `imageIndex` by the submit that signals
+        /// `timelineValue`, in place of any frame the consumer has not taken.
+        void publish(uint32_t imageIndex, uint64_t timelineValue);
+
+        /// @brief Take the latest published frame, for the consumer to read, if there is a
+        /// frame it has not taken yet.
+        std::optional<ExportedFrame> takeLatestFrame();
+
+        /// @brief Hand image `imageIndex` back once the consumer is done reading it.
+        void release(uint32_t imageIndex);
+
+        /// @brief The frames that were published and replaced before the consumer took
+        /// them.
+        uint64_t getDroppedCount() const;
+    private:
+        VkDevice m_device;
+        VkExtent2D m_extent;
+        VkFormat m_format;
+        std::vector<VkImage> m_images;
+        std::vector<VkDeviceMemory> m_imageMemories;
+        std::vector<VkDeviceSize> m_imageMemorySizes;
+        VkSemaphore m_timelineSemaphore;
+        PFN_vkGetMemoryFdKHR m_vkGetMemoryFdKHR;
+        PFN_vkGetSemaphoreFdKHR m_vkGetSemaphoreFdKHR;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_imageReleased;
+        std::optional<ExportedFrame> m_latestFrame;
+        /// @brief Whether the consumer holds each image.
+        std::vector<bool> m_isTaken;
+        uint64_t m_droppedCount;
+
+        void createImages(VkPhysicalDevice physicalDevice, VkImageUsageFlags usage, uint32_t imageCount);
+
+        void createTimelineSemaphore();
+};
+
+}
+
+#endif // _FRAME_EXPORTER_H
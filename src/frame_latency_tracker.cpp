@@ -0,0 +1,92 @@
+#include "frame_latency_tracker.h"
+
+#include <algorithm>
+
+#include "cpu_profiler.h"
+
+
+using FrameLatencyTracker = VulkanEngine::FrameLatencyTracker;
+using FrameLatencyStatistics = VulkanEngine::FrameLatencyStatistics;
+
+void FrameLatencyTracker::recordInput(Clock::time_point time) {
+    m_inputTime = time;
+    m_isSubmitted = false;
+}
+
+void FrameLatencyTracker::recordSubmit(Clock::time_point time) {
+    if (!m_inputTime.has_value()) {
+        return;
+    }
+
+    const auto milliseconds = FrameLatencyTracker::addSample(m_inputToSubmit, *m_inputTime, time);
+    CPU_PROFILE_COUNTER("input to submit (ms)", milliseconds);
+    m_isSubmitted = true;
+}
+
+void FrameLatencyTracker::recordPresent(std::optional<uint64_t> presentId, Clock::time_point time) {
+    if (!m_inputTime.has_value() || !m_isSubmitted) {
+        return;
+    }
+
+    const auto milliseconds = FrameLatencyTracker::addSample(m_inputToPresent, *m_inputTime, time);
+    CPU_PROFILE_COUNTER("input to present (ms)", milliseconds);
+    if (presentId.has_value()) {
+        if (m_pendingFrames.size() == MAX_PENDING_FRAMES) {
+            m_pendingFrames.pop_front();
+        }
+
+        m_pendingFrames.push_back(PendingFrame { .presentId = *presentId, .inputTime = *m_inputTime });
+    }
+    m_inputTime = std::nullopt;
+    m_isSubmitted = false;
+}
+
+void FrameLatencyTracker::recordDisplayed(uint64_t presentId, Clock::time_point time) {
+    while (!m_pendingFrames.empty() && m_pendingFrames.front().presentId <= presentId) {
+        const auto milliseconds = FrameLatencyTracker::addSample(m_inputToDisplay, m_pendingFrames.front().inputTime, time);
+        CPU_PROFILE_COUNTER("input to display (ms)", milliseconds);
+        m_pendingFrames.pop_front();
+    }
+}
+
+void FrameLatencyTracker::dropPendingFrames() {
+    m_pendingFrames.clear();
+}
+
+std::optional<uint64_t> FrameLatencyTracker::getOldestPendingPresentId() const {
+    if (m_pendingFrames.empty()) {
+        return std::nullopt;
+    }
+
+    return m_pendingFrames.front().presentId;
+}
+
+const FrameLatencyStatistics& FrameLatencyTracker::getInputToSubmitStatistics() const {
+    return m_inputToSubmit;
+}
+
+const FrameLatencyStatistics& FrameLatencyTracker::getInputToPresentStatistics() const {
+    return m_inputToPresent;
+}
+
+const FrameLatencyStatistics& FrameLatencyTracker::getInputToDisplayStatistics() const {
+    return m_inputToDisplay;
+}
+
+double FrameLatencyTracker::addSample(FrameLatencyStatistics& statistics, Clock::time_point startTime, Clock::time_point endTime) {
+    const auto milliseconds = std::chrono::duration<double, std::milli> { endTime - startTime }.count();
+    if (statistics.sampleCount == 0) {
+        statistics.minMilliseconds = milliseconds;
+        statistics.maxMilliseconds = milliseconds;
+    } else {
+        statistics.minMilliseconds = std::min(statistics.minMilliseconds, milliseconds);
+        statistics.maxMilliseconds = std::max(statistics.maxMilliseconds, milliseconds);
+    }
+
+    // A running average, which does not lose precision over a long run the way a sum would.
+    statistics.sampleCount++;
+    statistics.averageMilliseconds += (milliseconds - statistics.averageMilliseconds) / static_cast<double>(statistics.sampleCount);
+    statistics.latestMilliseconds = milliseconds;
+
+    return milliseconds;
+}
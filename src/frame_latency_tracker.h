@@ -0,0 +1,87 @@
+#ifndef _FRAME_LATENCY_TRACKER_H
+#define _FRAME_LATENCY_TRACKER_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+
+namespace VulkanEngine {
+
+/// @brief The latencies of one step of the frames a `FrameLatencyTracker` has measured.
+struct FrameLatencyStatistics final {
+    uint64_t sampleCount = 0;
+    double minMilliseconds = 0.0;
+    double averageMilliseconds = 0.0;
+    double maxMilliseconds = 0.0;
+    double latestMilliseconds = 0.0;
+};
+
+/// @brief Measures the time from when a frame polled its input to when it was submitted,
+/// presented and shown on the display.
+///
+/// @note A frame starts at `recordInput`, and each step after it is measured from there. A
+/// frame that is presented with a present ID waits until its ID is reported displayed, which
+/// also finishes every frame presented before it, since presents reach the display in order.
+/// A frame that starts over before it is submitted, like when the swap chain was out of
+/// date, keeps the newer input time. At most `MAX_PENDING_FRAMES` frames wait for the
+/// display, and the oldest are dropped past that.
+///
+/// Every sample is also written to the CPU profiler as a counter.
+class FrameLatencyTracker final {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr size_t MAX_PENDING_FRAMES = 16;
+
+        explicit FrameLatencyTracker() = default;
+
+        ~FrameLatencyTracker() = default;
+
+        FrameLatencyTracker(const FrameLatencyTracker& other) = delete;
+        FrameLatencyTracker& operator=(const FrameLatencyTracker& other) = delete;
+
+        /// @brief Start the next frame at the time its input was polled.
+        void recordInput(Clock::time_point time);
+
+        void recordSubmit(Clock::time_point time);
+
+        /// @brief Finish the frame at its present, or leave it waiting for `presentId` to be
+        /// displayed.
+        void recordPresent(std::optional<uint64_t> presentId, Clock::time_point time);
+
+        /// @brief Finish every frame waiting for a present ID up to `presentId`.
+        void recordDisplayed(uint64_t presentId, Clock::time_point time);
+
+        /// @brief Forget the frames waiting for the display, whose present IDs belong to a
+        /// swap chain that was retired.
+        void dropPendingFrames();
+
+        /// @brief The present ID of the oldest frame waiting for the display.
+        std::optional<uint64_t> getOldestPendingPresentId() const;
+
+        const FrameLatencyStatistics& getInputToSubmitStatistics() const;
+
+        const FrameLatencyStatistics& getInputToPresentStatistics() const;
+
+        const FrameLatencyStatistics& getInputToDisplayStatistics() const;
+    private:
+        struct PendingFrame final {
+            uint64_t presentId;
+            Clock::time_point inputTime;
+        };
+
+        std::optional<Clock::time_point> m_inputTime;
+        bool m_isSubmitted { false };
+        std::deque<PendingFrame> m_pendingFrames;
+        FrameLatencyStatistics m_inputToSubmit;
+        FrameLatencyStatistics m_inputToPresent;
+        FrameLatencyStatistics m_inputToDisplay;
+
+        static double addSample(FrameLatencyStatistics& statistics, Clock::time_point startTime, Clock::time_point endTime);
+};
+
+}
+
+#endif // _FRAME_LATENCY_TRACKER_H
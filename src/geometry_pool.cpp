@@ -0,0 +1,150 @@
+#include "geometry_pool.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+
+using GeometryPool = VulkanEngine::GeometryPool;
+using GeometryRange = VulkanEngine::GeometryRange;
+
+GeometryPool::GeometryPool(uint32_t vertexCapacity, uint32_t indexCapacity, VkIndexType indexType)
+    : m_vertexCapacity { vertexCapacity }
+    , m_indexCapacity { indexCapacity }
+    , m_indexType { indexType }
+    , m_freeVertices {}
+    , m_freeIndices {}
+    , m_allocatedVertexCount { 0 }
+    , m_allocatedIndexCount { 0 }
+{
+    if (indexType != VK_INDEX_TYPE_UINT16 && indexType != VK_INDEX_TYPE_UINT32) {
+        throw std::logic_error("geometry pool indices must be 16-bit or 32-bit!");
+    }
+
+    if (vertexCapacity > 0) {
+        m_freeVertices.push_back(FreeRange { 0, vertexCapacity });
+    }
+
+    if (indexCapacity > 0) {
+        m_freeIndices.push_back(FreeRange { 0, indexCapacity });
+    }
+}
+
+std::optional<GeometryRange> GeometryPool::allocate(uint32_t vertexCount, uint32_t indexCount) {
+    const auto maxVertexCount = m_indexType == VK_INDEX_TYPE_UINT16 ? uint32_t { std::numeric_limits<uint16_t>::max() } + 1 : std::numeric_limits<uint32_t>::max();
+    if (vertexCount > maxVertexCount) {
+        throw std::logic_error("mesh has more vertices than the indices of the geometry pool can address!");
+    }
+
+    const auto baseVertex = GeometryPool::allocateRange(m_freeVertices, vertexCount);
+    if (!baseVertex.has_value()) {
+        return std::nullopt;
+    }
+
+    const auto firstIndex = GeometryPool::allocateRange(m_freeIndices, indexCount);
+    if (!firstIndex.has_value()) {
+        GeometryPool::freeRange(m_freeVertices, *baseVertex, vertexCount);
+
+        return std::nullopt;
+    }
+
+    m_allocatedVertexCount += vertexCount;
+    m_allocatedIndexCount += indexCount;
+
+    return GeometryRange {
+        .baseVertex = *baseVertex,
+        .vertexCount = vertexCount,
+        .firstIndex = *firstIndex,
+        .indexCount = indexCount,
+    };
+}
+
+void GeometryPool::free(const GeometryRange& range) {
+    GeometryPool::freeRange(m_freeVertices, range.baseVertex, range.vertexCount);
+    GeometryPool::freeRange(m_freeIndices, range.firstIndex, range.indexCount);
+    m_allocatedVertexCount -= range.vertexCount;
+    m_allocatedIndexCount -= range.indexCount;
+}
+
+uint32_t GeometryPool::getVertexCapacity() const {
+    return m_vertexCapacity;
+}
+
+uint32_t GeometryPool::getIndexCapacity() const {
+    return m_indexCapacity;
+}
+
+VkIndexType GeometryPool::getIndexType() const {
+    return m_indexType;
+}
+
+VkDeviceSize GeometryPool::getIndexSize() const {
+    if (m_indexType == VK_INDEX_TYPE_UINT16) {
+        return sizeof(uint16_t);
+    } else {
+        return sizeof(uint32_t);
+    }
+}
+
+uint32_t GeometryPool::getAllocatedVertexCount() const {
+    return m_allocatedVertexCount;
+}
+
+uint32_t GeometryPool::getAllocatedIndexCount() const {
+    return m_allocatedIndexCount;
+}
+
+std::optional<uint32_t> GeometryPool::allocateRange(std::vector<FreeRange>& freeRanges, uint32_t count) {
+    // Empty ranges take no room, and sit at the start of the pool.
+    if (count == 0) {
+        return 0;
+    }
+
+    for (auto range = freeRanges.begin(); range != freeRanges.end(); range++) {
+        if (range->count < count) {
+            continue;
+        }
+
+        const auto offset = range->offset;
+        if (range->count == count) {
+            freeRanges.erase(range);
+        } else {
+            range->offset += count;
+            range->count -= count;
+        }
+
+        return offset;
+    }
+
+    return std::nullopt;
+}
+
+void GeometryPool::freeRange(std::vector<FreeRange>& freeRanges, uint32_t offset, uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    const auto next = std::lower_bound(
+        freeRanges.begin(),
+        freeRanges.end(),
+        offset,
+        [](const FreeRange& range, uint32_t offset) { return range.offset < offset; }
+    );
+    auto inserted = freeRanges.insert(next, FreeRange { offset, count });
+
+    // Coalesce with the following range.
+    const auto following = inserted + 1;
+    if (following != freeRanges.end() && inserted->offset + inserted->count == following->offset) {
+        inserted->count += following->count;
+        freeRanges.erase(following);
+    }
+
+    // Coalesce with the preceding range.
+    if (inserted != freeRanges.begin()) {
+        const auto preceding = inserted - 1;
+        if (preceding->offset + preceding->count == inserted->offset) {
+            preceding->count += inserted->count;
+            freeRanges.erase(inserted);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef _GEOMETRY_POOL_H
+#define _GEOMETRY_POOL_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief The vertices and indices of one mesh in a `GeometryPool`.
+///
+/// @note Indices are relative to `baseVertex`, which draws pass as their vertex offset.
+struct GeometryRange final {
+    uint32_t baseVertex = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+/// @brief Sub-allocates the vertices and indices of meshes from one shared vertex buffer and
+/// one shared index buffer.
+///
+/// @note Every mesh in the pool is drawn with the same bound buffers and its own base vertex
+/// and first index, so binding them once covers every draw, and indirect draws can refer to
+/// any mesh. The pool only keeps the books, a first-fit free list of vertices and one of
+/// indices as in `GpuMemoryBlock`, and the owner creates the buffers at the capacities of
+/// the pool.
+///
+/// Indices are stored relative to the base vertex of their mesh, so 16-bit indices serve
+/// any mesh of up to 65536 vertices however full the pool is.
+class GeometryPool final {
+    public:
+        explicit GeometryPool() = delete;
+        explicit GeometryPool(uint32_t vertexCapacity, uint32_t indexCapacity, VkIndexType indexType);
+
+        ~GeometryPool() = default;
+
+        GeometryPool(const GeometryPool& other) = delete;
+        GeometryPool& operator=(const GeometryPool& other) = delete;
+
+        /// @brief A range of `vertexCount` vertices and `indexCount` indices, or nothing when
+        /// the pool has no room for the mesh.
+        std::optional<GeometryRange> allocate(uint32_t vertexCount, uint32_t indexCount);
+
+        void free(const GeometryRange& range);
+
+        uint32_t getVertexCapacity() const;
+
+        uint32_t getIndexCapacity() const;
+
+        VkIndexType getIndexType() const;
+
+        VkDeviceSize getIndexSize() const;
+
+        uint32_t getAllocatedVertexCount() const;
+
+        uint32_t getAllocatedIndexCount() const;
+    private:
+        struct FreeRange final {
+            uint32_t offset;
+            uint32_t count;
+        };
+
+        uint32_t m_vertexCapacity;
+        uint32_t m_indexCapacity;
+        VkIndexType m_indexType;
+        std::vector<FreeRange> m_freeVertices;
+        std::vector<FreeRange> m_freeIndices;
+        uint32_t m_allocatedVertexCount;
+        uint32_t m_allocatedIndexCount;
+
+        static std::optional<uint32_t> allocateRange(std::vector<FreeRange>& freeRanges, uint32_t count);
+
+        static void freeRange(std::vector<FreeRange>& freeRanges, uint32_t offset, uint32_t count);
+};
+
+}
+
+#endif // _GEOMETRY_POOL_H
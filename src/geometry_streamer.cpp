@@ -0,0 +1,208 @@
+#include "geometry_streamer.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+
+using GeometryStreamer = VulkanEngine::GeometryStreamer;
+using GeometryUpload = VulkanEngine::GeometryUpload;
+
+GeometryStreamer::GeometryStreamer(
+    UploadContext& uploadContext,
+    GeometryPool& geometryPool,
+    std::span<const MeshLod> lods,
+    uint32_t vertexCount,
+    uint32_t framesInFlight
+)
+    : m_uploadContext { uploadContext }
+    , m_geometryPool { geometryPool }
+    , m_lods { lods.begin(), lods.end() }
+    , m_vertexRange {}
+    , m_indexRanges(lods.size())
+    , m_uploadedVertexCount { 0 }
+    , m_residentLevel { 0 }
+    , m_requestedLevel { 0 }
+    , m_pendingUpload {}
+    , m_framesInFlight { framesInFlight }
+    , m_updateCount { 0 }
+    , m_pendingEvictions { std::vector<std::tuple<uint32_t, uint64_t>> {} }
+{
+    if (m_lods.empty()) {
+        throw std::invalid_argument("a streamed mesh needs at least one level of detail!");
+    }
+
+    const auto vertexRange = m_geometryPool.allocate(vertexCount, 0);
+    if (!vertexRange.has_value()) {
+        throw std::runtime_error("failed to stream mesh: the geometry pool has no room for its vertices!");
+    }
+
+    m_vertexRange = *vertexRange;
+    m_residentLevel = static_cast<uint32_t>(m_lods.size());
+    m_requestedLevel = static_cast<uint32_t>(m_lods.size());
+}
+
+GeometryStreamer::~GeometryStreamer() {
+    for (const auto& indexRange : m_indexRanges) {
+        if (indexRange.has_value()) {
+            m_geometryPool.free(*indexRange);
+        }
+    }
+
+    m_geometryPool.free(m_vertexRange);
+    m_indexRanges.clear();
+    m_pendingEvictions.clear();
+}
+
+GeometryUpload GeometryStreamer::beginStreaming() {
+    const auto level = this->getCoarsestLevel();
+    const auto indexRange = m_geometryPool.allocate(0, m_lods[level].indexCount);
+    if (!indexRange.has_value()) {
+        throw std::runtime_error("failed to stream mesh: the geometry pool has no room for its coarsest level!");
+    }
+
+    m_indexRanges[level] = *indexRange;
+    const auto upload = this->createUpload(level);
+    m_uploadedVertexCount = this->getLevelVertexCount(level);
+    m_residentLevel = level;
+    m_requestedLevel = level;
+
+    return upload;
+}
+
+void GeometryStreamer::requestLevel(uint32_t level) {
+    m_requestedLevel = std::min(level, this->getCoarsestLevel());
+}
+
+void GeometryStreamer::update() {
+    m_updateCount++;
+    this->evictRetiredLevels();
+
+    if (m_pendingUpload.has_value()) {
+        const auto [level, timelineValue] = *m_pendingUpload;
+        if (!m_uploadContext.isComplete(timelineValue)) {
+            return;
+        }
+
+        m_residentLevel = level;
+        m_pendingUpload.reset();
+    }
+
+    // The draws pick up the coarser level with the next frame, and the finer levels keep
+    // their ranges until no frame in flight draws them.
+    if (m_requestedLevel > m_residentLevel) {
+        for (uint32_t level = m_residentLevel; level < m_requestedLevel; level++) {
+            m_pendingEvictions.push_back(std::make_tuple(level, m_updateCount));
+        }
+
+        m_residentLevel = m_requestedLevel;
+
+        return;
+    }
+
+    // A level still waiting for eviction keeps its indices, so it only has to be taken back.
+    while (m_requestedLevel < m_residentLevel && this->cancelEviction(m_residentLevel - 1)) {
+        m_residentLevel--;
+    }
+}
+
+std::optional<GeometryUpload> GeometryStreamer::getNextUpload() {
+    if (m_pendingUpload.has_value() || m_requestedLevel >= m_residentLevel) {
+        return std::nullopt;
+    }
+
+    const auto level = m_residentLevel - 1;
+    if (!m_indexRanges[level].has_value()) {
+        const auto indexRange = m_geometryPool.allocate(0, m_lods[level].indexCount);
+        if (!indexRange.has_value()) {
+            // The pool is full. Try again once evictions have freed indices.
+            return std::nullopt;
+        }
+
+        m_indexRanges[level] = *indexRange;
+    }
+
+    return this->createUpload(level);
+}
+
+void GeometryStreamer::submitUpload(const GeometryUpload& upload, uint64_t timelineValue) {
+    m_uploadedVertexCount = std::max(m_uploadedVertexCount, upload.firstVertex + upload.vertexCount);
+    m_pendingUpload = std::make_tuple(upload.level, timelineValue);
+}
+
+uint32_t GeometryStreamer::getResidentLevel() const {
+    return m_residentLevel;
+}
+
+uint32_t GeometryStreamer::getFirstIndex(uint32_t level) const {
+    return m_indexRanges.at(level).value().firstIndex;
+}
+
+uint32_t GeometryStreamer::getBaseVertex() const {
+    return m_vertexRange.baseVertex;
+}
+
+bool GeometryStreamer::hasPendingUpload() const {
+    return m_pendingUpload.has_value();
+}
+
+bool GeometryStreamer::isStreaming() const {
+    return m_pendingUpload.has_value()
+        || !m_pendingEvictions.empty()
+        || m_requestedLevel != m_residentLevel;
+}
+
+uint32_t GeometryStreamer::getCoarsestLevel() const {
+    return static_cast<uint32_t>(m_lods.size()) - 1;
+}
+
+uint32_t GeometryStreamer::getLevelVertexCount(uint32_t level) const {
+    // Meshes cached before levels knew their vertices index all of them.
+    const auto vertexCount = m_lods[level].vertexCount;
+
+    return vertexCount == 0 ? m_vertexRange.vertexCount : std::min(vertexCount, m_vertexRange.vertexCount);
+}
+
+GeometryUpload GeometryStreamer::createUpload(uint32_t level) const {
+    const auto levelVertexCount = this->getLevelVertexCount(level);
+    const auto firstVertex = std::min(m_uploadedVertexCount, levelVertexCount);
+    const auto& indexRange = *m_indexRanges[level];
+
+    return GeometryUpload {
+        .level = level,
+        .firstVertex = firstVertex,
+        .vertexCount = levelVertexCount - firstVertex,
+        .firstIndex = indexRange.firstIndex,
+        .indexCount = indexRange.indexCount,
+    };
+}
+
+void GeometryStreamer::evictRetiredLevels() {
+    // A level stops being drawn once every frame in flight has picked up the coarser level,
+    // which takes at most `m_framesInFlight` updates.
+    const auto isRetired = [this](const auto& pendingEviction) {
+        const auto& [level, updateCount] = pendingEviction;
+        if (m_updateCount < updateCount + m_framesInFlight) {
+            return false;
+        }
+
+        m_geometryPool.free(*m_indexRanges[level]);
+        m_indexRanges[level].reset();
+
+        return true;
+    };
+    m_pendingEvictions.erase(std::remove_if(m_pendingEvictions.begin(), m_pendingEvictions.end(), isRetired), m_pendingEvictions.end());
+}
+
+bool GeometryStreamer::cancelEviction(uint32_t level) {
+    const auto pendingEviction = std::find_if(m_pendingEvictions.begin(), m_pendingEvictions.end(), [level](const auto& pendingEviction) {
+        return std::get<0>(pendingEviction) == level;
+    });
+    if (pendingEviction == m_pendingEvictions.end()) {
+        return false;
+    }
+
+    m_pendingEvictions.erase(pendingEviction);
+
+    return true;
+}
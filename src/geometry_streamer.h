@@ -0,0 +1,133 @@
+#ifndef _GEOMETRY_STREAMER_H
+#define _GEOMETRY_STREAMER_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include "geometry_pool.h"
+#include "mesh_cache.h"
+#include "upload_batch.h"
+
+
+namespace VulkanEngine {
+
+/// @brief The data a `GeometryStreamer` needs written for a level of detail to become
+/// resident: the vertices the level adds, relative to the base vertex of the mesh, and the
+/// range of the pool that the indices of the level go to.
+struct GeometryUpload final {
+    uint32_t level = 0;
+    uint32_t firstVertex = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+/// @brief Streams the levels of detail of a mesh into a geometry pool on demand, coarsest
+/// level first.
+///
+/// @note The mesh has to store its vertices coarsest level first, so that every level
+/// indexes a prefix of them. The vertex range of the whole mesh is allocated up front, since
+/// every level indexes from the same base vertex, but it only fills up as levels arrive, and
+/// a level adds just the vertices coarser levels do not use. Every level has an index range
+/// of its own, allocated when the level streams in and freed once it is evicted.
+///
+/// Only the coarsest level goes out with the initial batch. The finer levels follow one at
+/// a time, from the coarsest up, whenever the renderer asks for a finer level than the pool
+/// holds. The caller writes and submits each upload, within its upload budget, and hands
+/// back the timeline value of the batch. A level is drawn once its upload has finished.
+///
+/// Levels finer than the renderer asks for are evicted: the draws stop using them at once,
+/// and their index ranges go back to the pool `framesInFlight` updates later, once no frame
+/// in flight can still draw them. A level asked for again before then keeps its range and
+/// its indices. The vertices of an evicted level stay, so streaming it in again only takes
+/// its indices.
+class GeometryStreamer final {
+    public:
+        explicit GeometryStreamer() = delete;
+        explicit GeometryStreamer(
+            UploadContext& uploadContext,
+            GeometryPool& geometryPool,
+            std::span<const MeshLod> lods,
+            uint32_t vertexCount,
+            uint32_t framesInFlight
+        );
+
+        ~GeometryStreamer();
+
+        GeometryStreamer(const GeometryStreamer& other) = delete;
+        GeometryStreamer& operator=(const GeometryStreamer& other) = delete;
+
+        /// @brief The upload of the coarsest level, which the caller records into the initial
+        /// batch, and which is resident from then on.
+        ///
+        /// @note The coarsest level is never evicted.
+        GeometryUpload beginStreaming();
+
+        /// @brief Ask for `level` and every coarser level to become resident.
+        void requestLevel(uint32_t level);
+
+        /// @brief Pick up the upload that finished, and retire the levels that fell out of
+        /// use.
+        ///
+        /// @note Call this once per frame.
+        void update();
+
+        /// @brief The next level to upload, if a finer level is asked for and no upload is in
+        /// flight, or nothing.
+        ///
+        /// @note The index range of the level is allocated the first time it is returned, and
+        /// kept until the upload is submitted. Nothing is returned while the pool has no room
+        /// for it.
+        std::optional<GeometryUpload> getNextUpload();
+
+        /// @brief Take `upload`, from `getNextUpload`, as submitted in a batch that signals
+        /// `timelineValue`.
+        void submitUpload(const GeometryUpload& upload, uint64_t timelineValue);
+
+        /// @brief The most detailed level that can be drawn.
+        uint32_t getResidentLevel() const;
+
+        /// @brief The first index in the pool of the resident `level`.
+        uint32_t getFirstIndex(uint32_t level) const;
+
+        uint32_t getBaseVertex() const;
+
+        /// @brief Whether an upload is in flight.
+        bool hasPendingUpload() const;
+
+        /// @brief Whether later updates still have work to do: levels to upload or to wait
+        /// for, or levels to evict.
+        bool isStreaming() const;
+    private:
+        UploadContext& m_uploadContext;
+        GeometryPool& m_geometryPool;
+        std::vector<MeshLod> m_lods;
+        GeometryRange m_vertexRange;
+        /// @brief The index range of every level, where it has one.
+        std::vector<std::optional<GeometryRange>> m_indexRanges;
+        uint32_t m_uploadedVertexCount;
+        uint32_t m_residentLevel;
+        uint32_t m_requestedLevel;
+        std::optional<std::tuple<uint32_t, uint64_t>> m_pendingUpload;
+        uint32_t m_framesInFlight;
+        uint64_t m_updateCount;
+        std::vector<std::tuple<uint32_t, uint64_t>> m_pendingEvictions;
+
+        uint32_t getCoarsestLevel() const;
+
+        /// @brief The vertices `level` indexes, from the start of the mesh.
+        uint32_t getLevelVertexCount(uint32_t level) const;
+
+        GeometryUpload createUpload(uint32_t level) const;
+
+        void evictRetiredLevels();
+
+        bool cancelEviction(uint32_t level);
+};
+
+}
+
+#endif // _GEOMETRY_STREAMER_H
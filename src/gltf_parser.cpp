@@ -0,0 +1,318 @@
+#include "gltf_parser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "json_reader.h"
+
+
+using GltfParser = VulkanEngine::GltfParser;
+using GltfAccessor = VulkanEngine::GltfAccessor;
+using GltfPrimitive = VulkanEngine::GltfPrimitive;
+using GltfComponentType = VulkanEngine::GltfComponentType;
+using JsonValue = VulkanEngine::JsonValue;
+using JsonReader = VulkanEngine::JsonReader;
+
+// The GLB header is the magic `glTF`, the container version and the file length.
+static constexpr uint32_t GLB_MAGIC = 0x46546c67;
+static constexpr uint32_t GLB_VERSION = 2;
+static constexpr size_t GLB_HEADER_SIZE = 12;
+static constexpr size_t GLB_CHUNK_HEADER_SIZE = 8;
+static constexpr uint32_t GLB_CHUNK_TYPE_JSON = 0x4e4f534a;
+static constexpr uint32_t GLB_CHUNK_TYPE_BIN = 0x004e4942;
+
+// The glTF code of primitives that are triangle lists, which primitives default to.
+static constexpr uint32_t GLTF_MODE_TRIANGLES = 4;
+
+static uint32_t readUint32(const uint8_t* data) {
+    auto value = uint32_t { 0 };
+    std::memcpy(&value, data, sizeof(value));
+
+    return value;
+}
+
+static size_t getComponentSize(GltfComponentType componentType) {
+    switch (componentType) {
+        case GltfComponentType::Int8: return 1;
+        case GltfComponentType::Uint8: return 1;
+        case GltfComponentType::Int16: return 2;
+        case GltfComponentType::Uint16: return 2;
+        case GltfComponentType::Uint32: return 4;
+        case GltfComponentType::Float32: return 4;
+    }
+
+    throw std::runtime_error("failed to parse GLB file: unknown accessor component type!");
+}
+
+static uint32_t getComponentCount(const std::string& type) {
+    if (type == "SCALAR") {
+        return 1;
+    } else if (type == "VEC2") {
+        return 2;
+    } else if (type == "VEC3") {
+        return 3;
+    } else if (type == "VEC4") {
+        return 4;
+    }
+
+    throw std::runtime_error("failed to parse GLB file: unsupported accessor type!");
+}
+
+static const JsonValue& getElement(const JsonValue* array, size_t index) {
+    if (array == nullptr || array->type != JsonValue::Type::Array || index >= array->elements.size()) {
+        throw std::runtime_error("failed to parse GLB file: index out of range!");
+    }
+
+    return array->elements[index];
+}
+
+/// @brief The non-negative integer under `key`, or `defaultValue` when there is none.
+static size_t getSize(const JsonValue& object, std::string_view key, std::optional<size_t> defaultValue = std::nullopt) {
+    const auto* value = object.find(key);
+    if (value == nullptr && defaultValue.has_value()) {
+        return *defaultValue;
+    }
+
+    // Sizes past 2^53 are not exact doubles, and no GLB file is near that large.
+    const auto isSize = value != nullptr
+        && value->type == JsonValue::Type::Number
+        && value->number >= 0.0
+        && value->number < 9007199254740992.0
+        && value->number == std::floor(value->number);
+    if (!isSize) {
+        throw std::runtime_error("failed to parse GLB file: missing or malformed size!");
+    }
+
+    return static_cast<size_t>(value->number);
+}
+
+/// @brief Resolve accessor `index` into a view of the binary chunk.
+static GltfAccessor getAccessor(const JsonValue& document, std::span<const uint8_t> binaryChunk, size_t index) {
+    const auto& accessor = getElement(document.find("accessors"), index);
+    if (accessor.find("sparse") != nullptr) {
+        throw std::runtime_error("failed to parse GLB file: sparse accessors are not supported!");
+    }
+
+    const auto* type = accessor.find("type");
+    if (type == nullptr || type->type != JsonValue::Type::String) {
+        throw std::runtime_error("failed to parse GLB file: accessor has no type!");
+    }
+
+    const auto componentType = static_cast<GltfComponentType>(getSize(accessor, "componentType"));
+    const auto componentCount = getComponentCount(type->string);
+    const auto elementSize = getComponentSize(componentType) * componentCount;
+    const auto* normalized = accessor.find("normalized");
+    const auto count = getSize(accessor, "count");
+
+    // Accessors without a buffer view are all zeros, which is no use for geometry.
+    const auto& bufferView = getElement(document.find("bufferViews"), getSize(accessor, "bufferView"));
+    const auto& buffer = getElement(document.find("buffers"), getSize(bufferView, "buffer"));
+    if (buffer.find("uri") != nullptr) {
+        throw std::runtime_error("failed to parse GLB file: external buffers are not supported!");
+    }
+
+    const auto viewOffset = getSize(bufferView, "byteOffset", 0);
+    const auto viewLength = getSize(bufferView, "byteLength");
+    const auto stride = getSize(bufferView, "byteStride", elementSize);
+    const auto accessorOffset = getSize(accessor, "byteOffset", 0);
+    if (viewOffset > binaryChunk.size() || viewLength > binaryChunk.size() - viewOffset || stride < elementSize) {
+        throw std::runtime_error("failed to parse GLB file: buffer view out of range!");
+    }
+
+    // The last element only needs room for itself, not for a whole stride.
+    if (count > 0) {
+        const auto isInView = accessorOffset <= viewLength
+            && count - 1 <= (viewLength - accessorOffset) / stride
+            && elementSize <= viewLength - accessorOffset - (count - 1) * stride;
+        if (!isInView) {
+            throw std::runtime_error("failed to parse GLB file: accessor out of range!");
+        }
+    }
+
+    return GltfAccessor {
+        .data = binaryChunk.data() + viewOffset + accessorOffset,
+        .count = count,
+        .stride = stride,
+        .componentType = componentType,
+        .componentCount = componentCount,
+        .isNormalized = normalized != nullptr && normalized->type == JsonValue::Type::Bool && normalized->boolean,
+    };
+}
+
+void GltfAccessor::readFloats(size_t index, float* values) const {
+    const auto* element = data + index * stride;
+    for (uint32_t i = 0; i < componentCount; i++) {
+        switch (componentType) {
+            case GltfComponentType::Int8: {
+                const auto value = static_cast<float>(static_cast<int8_t>(element[i]));
+                values[i] = isNormalized ? std::max(value / 127.0f, -1.0f) : value;
+                break;
+            }
+            case GltfComponentType::Uint8: {
+                const auto value = static_cast<float>(element[i]);
+                values[i] = isNormalized ? value / 255.0f : value;
+                break;
+            }
+            case GltfComponentType::Int16: {
+                auto component = int16_t { 0 };
+                std::memcpy(&component, element + 2 * i, sizeof(component));
+                const auto value = static_cast<float>(component);
+                values[i] = isNormalized ? std::max(value / 32767.0f, -1.0f) : value;
+                break;
+            }
+            case GltfComponentType::Uint16: {
+                auto component = uint16_t { 0 };
+                std::memcpy(&component, element + 2 * i, sizeof(component));
+                const auto value = static_cast<float>(component);
+                values[i] = isNormalized ? value / 65535.0f : value;
+                break;
+            }
+            case GltfComponentType::Uint32: {
+                values[i] = static_cast<float>(readUint32(element + 4 * i));
+                break;
+            }
+            case GltfComponentType::Float32: {
+                std::memcpy(&values[i], element + 4 * i, sizeof(float));
+                break;
+            }
+        }
+    }
+}
+
+uint32_t GltfAccessor::readIndex(size_t index) const {
+    const auto* element = data + index * stride;
+    switch (componentType) {
+        case GltfComponentType::Uint8: {
+            return element[0];
+        }
+        case GltfComponentType::Uint16: {
+            auto value = uint16_t { 0 };
+            std::memcpy(&value, element, sizeof(value));
+
+            return value;
+        }
+        case GltfComponentType::Uint32: {
+            return readUint32(element);
+        }
+        default: {
+            throw std::logic_error("indices are unsigned integers!");
+        }
+    }
+}
+
+std::vector<GltfPrimitive> GltfParser::parse(std::span<const uint8_t> bytes) {
+    if (bytes.size() < GLB_HEADER_SIZE || readUint32(bytes.data()) != GLB_MAGIC) {
+        throw std::runtime_error("failed to parse GLB file: not a GLB file!");
+    }
+
+    if (readUint32(bytes.data() + 4) != GLB_VERSION) {
+        throw std::runtime_error("failed to parse GLB file: unsupported container version!");
+    }
+
+    const auto length = size_t { readUint32(bytes.data() + 8) };
+    if (length > bytes.size()) {
+        throw std::runtime_error("failed to parse GLB file: file is truncated!");
+    }
+
+    // The JSON chunk comes first, and the binary chunk, when there is one, second. Chunks of
+    // other types may follow, and are skipped.
+    auto jsonChunk = std::span<const uint8_t> {};
+    auto binaryChunk = std::span<const uint8_t> {};
+    for (auto offset = GLB_HEADER_SIZE, chunkIndex = size_t { 0 }; offset < length; chunkIndex++) {
+        if (length - offset < GLB_CHUNK_HEADER_SIZE) {
+            throw std::runtime_error("failed to parse GLB file: file is truncated!");
+        }
+
+        const auto chunkLength = size_t { readUint32(bytes.data() + offset) };
+        const auto chunkType = readUint32(bytes.data() + offset + 4);
+        offset += GLB_CHUNK_HEADER_SIZE;
+        if (chunkLength > length - offset) {
+            throw std::runtime_error("failed to parse GLB file: file is truncated!");
+        }
+
+        const auto chunk = bytes.subspan(offset, chunkLength);
+        if (chunkIndex == 0 && chunkType == GLB_CHUNK_TYPE_JSON) {
+            jsonChunk = chunk;
+        } else if (chunkIndex == 1 && chunkType == GLB_CHUNK_TYPE_BIN) {
+            binaryChunk = chunk;
+        } else if (chunkIndex == 0) {
+            throw std::runtime_error("failed to parse GLB file: first chunk is not JSON!");
+        }
+
+        offset += chunkLength;
+    }
+
+    const auto document = [&jsonChunk]() -> JsonValue {
+        auto reader = JsonReader { std::string_view { reinterpret_cast<const char*>(jsonChunk.data()), jsonChunk.size() } };
+        try {
+            return reader.parseDocument();
+        } catch (const std::runtime_error&) {
+            throw std::runtime_error("failed to parse GLB file: malformed JSON chunk!");
+        }
+    }();
+    const auto* asset = document.find("asset");
+    const auto* version = asset != nullptr ? asset->find("version") : nullptr;
+    if (version == nullptr || version->type != JsonValue::Type::String || !version->string.starts_with("2.")) {
+        throw std::runtime_error("failed to parse GLB file: not a glTF 2.0 asset!");
+    }
+
+    auto primitives = std::vector<GltfPrimitive> {};
+    const auto* meshes = document.find("meshes");
+    const auto meshCount = meshes != nullptr && meshes->type == JsonValue::Type::Array ? meshes->elements.size() : 0;
+    for (size_t meshIndex = 0; meshIndex < meshCount; meshIndex++) {
+        const auto* meshPrimitives = meshes->elements[meshIndex].find("primitives");
+        const auto primitiveCount = meshPrimitives != nullptr && meshPrimitives->type == JsonValue::Type::Array ? meshPrimitives->elements.size() : 0;
+        for (size_t primitiveIndex = 0; primitiveIndex < primitiveCount; primitiveIndex++) {
+            const auto& primitive = meshPrimitives->elements[primitiveIndex];
+            if (getSize(primitive, "mode", GLTF_MODE_TRIANGLES) != GLTF_MODE_TRIANGLES) {
+                throw std::runtime_error("failed to parse GLB file: only triangle lists are supported!");
+            }
+
+            const auto* attributes = primitive.find("attributes");
+            if (attributes == nullptr || attributes->find("POSITION") == nullptr) {
+                throw std::runtime_error("failed to parse GLB file: primitive has no positions!");
+            }
+
+            auto gltfPrimitive = GltfPrimitive {
+                .positions = getAccessor(document, binaryChunk, getSize(*attributes, "POSITION")),
+                .texCoords = std::nullopt,
+                .indices = std::nullopt,
+            };
+            if (gltfPrimitive.positions.componentCount != 3) {
+                throw std::runtime_error("failed to parse GLB file: positions are not three-component vectors!");
+            }
+
+            if (attributes->find("TEXCOORD_0") != nullptr) {
+                gltfPrimitive.texCoords = getAccessor(document, binaryChunk, getSize(*attributes, "TEXCOORD_0"));
+                if (gltfPrimitive.texCoords->componentCount != 2 || gltfPrimitive.texCoords->count != gltfPrimitive.positions.count) {
+                    throw std::runtime_error("failed to parse GLB file: malformed texture coordinates!");
+                }
+            }
+
+            if (primitive.find("indices") != nullptr) {
+                gltfPrimitive.indices = getAccessor(document, binaryChunk, getSize(primitive, "indices"));
+                const auto componentType = gltfPrimitive.indices->componentType;
+                const auto isIndexType = componentType == GltfComponentType::Uint8
+                    || componentType == GltfComponentType::Uint16
+                    || componentType == GltfComponentType::Uint32;
+                if (gltfPrimitive.indices->componentCount != 1 || !isIndexType) {
+                    throw std::runtime_error("failed to parse GLB file: indices are not unsigned integer scalars!");
+                }
+            }
+
+            // Without indices, the positions are the corners of the triangles in order.
+            const auto cornerCount = gltfPrimitive.indices.has_value() ? gltfPrimitive.indices->count : gltfPrimitive.positions.count;
+            if (cornerCount % 3 != 0) {
+                throw std::runtime_error("failed to parse GLB file: triangle list does not form whole triangles!");
+            }
+
+            primitives.push_back(gltfPrimitive);
+        }
+    }
+
+    return primitives;
+}
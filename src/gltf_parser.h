@@ -0,0 +1,70 @@
+#ifndef _GLTF_PARSER_H
+#define _GLTF_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief The component types of glTF accessors, by their glTF codes.
+enum class GltfComponentType : uint32_t {
+    Int8 = 5120,
+    Uint8 = 5121,
+    Int16 = 5122,
+    Uint16 = 5123,
+    Uint32 = 5125,
+    Float32 = 5126,
+};
+
+/// @brief A typed view of the binary chunk of a GLB file, one element per index.
+///
+/// @note `data` points into the bytes the file was parsed from, so an accessor is only
+/// valid as long as they are. Elements are `stride` bytes apart, and every element lies
+/// within the binary chunk.
+struct GltfAccessor final {
+    const uint8_t* data = nullptr;
+    size_t count = 0;
+    size_t stride = 0;
+    GltfComponentType componentType = GltfComponentType::Float32;
+    uint32_t componentCount = 0;
+    bool isNormalized = false;
+
+    /// @brief Read the first `componentCount` components of element `index` as floats,
+    /// normalizing integer components when the accessor is normalized.
+    void readFloats(size_t index, float* values) const;
+
+    /// @brief Read element `index` of an accessor of unsigned integer scalars.
+    uint32_t readIndex(size_t index) const;
+};
+
+/// @brief The accessors of one triangle list of a glTF mesh.
+///
+/// @note Without `indices`, every consecutive three vertices form a triangle.
+struct GltfPrimitive final {
+    GltfAccessor positions;
+    std::optional<GltfAccessor> texCoords;
+    std::optional<GltfAccessor> indices;
+};
+
+/// @brief Parses the geometry of binary glTF 2.0 files, GLB files, in place.
+///
+/// @note The JSON chunk is parsed for the accessors of the `POSITION` and `TEXCOORD_0`
+/// attributes and the indices of every triangle-list primitive, in mesh order, and the
+/// accessors are handed out as views of the binary chunk, so no vertex data is copied.
+/// Every buffer has to be the binary chunk of the file; external buffers, sparse
+/// accessors and primitives that are not triangle lists are rejected. Node transforms
+/// are not applied, so every mesh comes out in its own space.
+class GltfParser final {
+    public:
+        explicit GltfParser() = delete;
+
+        static std::vector<GltfPrimitive> parse(std::span<const uint8_t> bytes);
+};
+
+}
+
+#endif // _GLTF_PARSER_H
@@ -0,0 +1,324 @@
+#include "gpu_decompressor.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "command_counters.h"
+
+
+using GpuDecompressor = VulkanEngine::GpuDecompressor;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+// The decompression pipeline runs 64 invocations per workgroup, one per block.
+static constexpr uint32_t GROUP_SIZE = 64;
+
+GpuDecompressor::GpuDecompressor(
+    VkPhysicalDevice physicalDevice,
+    VkDevice device,
+    VkPipelineCache pipelineCache,
+    std::span<const uint32_t> shaderCode
+)
+    : m_physicalDevice { physicalDevice }
+    , m_device { device }
+    , m_pipelineCache { pipelineCache }
+    , m_sourceAlignment { 0 }
+    , m_descriptorSetLayout { VK_NULL_HANDLE }
+    , m_pipelineLayout { VK_NULL_HANDLE }
+    , m_pipeline { VK_NULL_HANDLE }
+{
+    // The source is bound at the offset of its staging slice, and storage buffer bindings
+    // have to start at a multiple of the device's offset alignment.
+    auto properties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+    m_sourceAlignment = std::max<VkDeviceSize>(properties.limits.minStorageBufferOffsetAlignment, sizeof(uint32_t));
+
+    this->createDescriptorSetLayout();
+    this->createPipeline(shaderCode);
+}
+
+GpuDecompressor::~GpuDecompressor() {
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipelineLayout = VK_NULL_HANDLE;
+    m_descriptorSetLayout = VK_NULL_HANDLE;
+    m_pipelineCache = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+    m_physicalDevice = VK_NULL_HANDLE;
+}
+
+VkDeviceSize GpuDecompressor::getSourceAlignment() const {
+    return m_sourceAlignment;
+}
+
+VkBufferUsageFlags GpuDecompressor::getRequiredSourceUsage() const {
+    return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+}
+
+VkBufferUsageFlags GpuDecompressor::getRequiredBufferUsage() const {
+    return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+}
+
+VkDeviceSize GpuDecompressor::getRangeSize(VkDeviceSize size) {
+    return std::max<VkDeviceSize>((size + sizeof(uint32_t) - 1) & ~VkDeviceSize { sizeof(uint32_t) - 1 }, sizeof(uint32_t));
+}
+
+GpuDecompressor::DispatchResources GpuDecompressor::record(VkCommandBuffer commandBuffer, const DecompressionTarget& target) {
+    const auto blockCount = (target.size + target.blockSize - 1) / target.blockSize;
+    const auto tableSize = (blockCount + 1) * sizeof(uint32_t);
+    if (target.sourceSize < tableSize || target.sourceSize > UINT32_MAX || target.size > UINT32_MAX) {
+        throw std::runtime_error("failed to record GPU decompression: the source is not a block-compressed asset!");
+    }
+
+    if (target.blockSize % sizeof(uint32_t) != 0) {
+        throw std::logic_error("GPU decompression blocks must be a whole number of words!");
+    }
+
+    auto resources = DispatchResources {};
+
+    // Every asset gets a pool of its own, which is destroyed with the rest of its
+    // resources once the batch completes.
+    const auto poolSize = VkDescriptorPoolSize {
+        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 2,
+    };
+    const auto poolInfo = VkDescriptorPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &poolSize,
+    };
+    const auto resultCreateDescriptorPool = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &resources.descriptorPool);
+    if (resultCreateDescriptorPool != VK_SUCCESS) {
+        throw std::runtime_error("failed to create GPU decompressor descriptor pool!");
+    }
+
+    const auto allocInfo = VkDescriptorSetAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = resources.descriptorPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &m_descriptorSetLayout,
+    };
+
+    auto descriptorSet = VkDescriptorSet {};
+    const auto resultAllocateDescriptorSet = vkAllocateDescriptorSets(m_device, &allocInfo, &descriptorSet);
+    if (resultAllocateDescriptorSet != VK_SUCCESS) {
+        this->release(resources);
+
+        throw std::runtime_error("failed to allocate GPU decompressor descriptor set!");
+    }
+
+    const auto destinationSize = GpuDecompressor::getRangeSize(target.size);
+    const auto bufferInfos = std::array<VkDescriptorBufferInfo, 2> {
+        VkDescriptorBufferInfo {
+            .buffer = target.sourceBuffer,
+            .offset = target.sourceOffset,
+            .range = GpuDecompressor::getRangeSize(target.sourceSize),
+        },
+        VkDescriptorBufferInfo {
+            .buffer = target.destinationBuffer,
+            .offset = 0,
+            .range = destinationSize,
+        },
+    };
+    const auto descriptorWrites = std::array<VkWriteDescriptorSet, 2> {
+        VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &bufferInfos[0],
+        },
+        VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = 1,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &bufferInfos[1],
+        },
+    };
+    vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+    // The source was written by the host before the batch was submitted, which the
+    // submission itself makes visible, so the dispatch needs no barrier in front of it.
+    const auto pushConstants = PushConstants {
+        .blockCount = static_cast<uint32_t>(blockCount),
+        .blockSize = static_cast<uint32_t>(target.blockSize),
+        .sourceSize = static_cast<uint32_t>(target.sourceSize),
+        .size = static_cast<uint32_t>(target.size),
+    };
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    CommandCounters::add(CommandCounter::PipelineBinds);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+    CommandCounters::add(CommandCounter::DescriptorBinds);
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstants);
+    vkCmdDispatch(commandBuffer, static_cast<uint32_t>((blockCount + GROUP_SIZE - 1) / GROUP_SIZE), 1, 1);
+    CommandCounters::add(CommandCounter::Dispatches);
+
+    const auto destinationBarrier = VkBufferMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = target.destinationBuffer,
+        .offset = 0,
+        .size = destinationSize,
+    };
+    if (target.destinationImage == VK_NULL_HANDLE) {
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, nullptr,
+            1, &destinationBarrier,
+            0, nullptr
+        );
+        CommandCounters::add(CommandCounter::Barriers);
+
+        return resources;
+    }
+
+    const auto imageBarrier = VkImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = target.destinationImage,
+        .subresourceRange = VkImageSubresourceRange {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0,
+            .levelCount = target.mipLevels,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        1, &destinationBarrier,
+        1, &imageBarrier
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    vkCmdCopyBufferToImage(
+        commandBuffer,
+        target.destinationBuffer,
+        target.destinationImage,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(target.regions.size()),
+        target.regions.data()
+    );
+
+    return resources;
+}
+
+void GpuDecompressor::release(const DispatchResources& resources) {
+    // Destroying the pool frees its descriptor set.
+    if (resources.descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(m_device, resources.descriptorPool, nullptr);
+    }
+}
+
+void GpuDecompressor::createDescriptorSetLayout() {
+    const auto bindings = std::array<VkDescriptorSetLayoutBinding, 2> {
+        VkDescriptorSetLayoutBinding {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+    };
+    const auto layoutInfo = VkDescriptorSetLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+
+    auto descriptorSetLayout = VkDescriptorSetLayout {};
+    const auto result = vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &descriptorSetLayout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create GPU decompressor descriptor set layout!");
+    }
+
+    m_descriptorSetLayout = descriptorSetLayout;
+}
+
+void GpuDecompressor::createPipeline(std::span<const uint32_t> shaderCode) {
+    const auto pushConstantRange = VkPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_descriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+
+    auto pipelineLayout = VkPipelineLayout {};
+    const auto resultCreatePipelineLayout = vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    if (resultCreatePipelineLayout != VK_SUCCESS) {
+        throw std::runtime_error("failed to create GPU decompressor pipeline layout!");
+    }
+
+    m_pipelineLayout = pipelineLayout;
+
+    const auto shaderModuleInfo = VkShaderModuleCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = shaderCode.size_bytes(),
+        .pCode = shaderCode.data(),
+    };
+
+    auto shaderModule = VkShaderModule {};
+    const auto resultCreateShaderModule = vkCreateShaderModule(m_device, &shaderModuleInfo, nullptr, &shaderModule);
+    if (resultCreateShaderModule != VK_SUCCESS) {
+        throw std::runtime_error("failed to create GPU decompressor shader module!");
+    }
+
+    const auto pipelineInfo = VkComputePipelineCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shaderModule,
+            .pName = "main",
+        },
+        .layout = m_pipelineLayout,
+    };
+
+    auto pipeline = VkPipeline {};
+    const auto resultCreatePipeline = vkCreateComputePipelines(m_device, m_pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    // The pipeline keeps everything it needs from the shader module.
+    vkDestroyShaderModule(m_device, shaderModule, nullptr);
+
+    if (resultCreatePipeline != VK_SUCCESS) {
+        throw std::runtime_error("failed to create GPU decompressor pipeline!");
+    }
+
+    m_pipeline = pipeline;
+}
@@ -0,0 +1,111 @@
+#ifndef _GPU_DECOMPRESSOR_H
+#define _GPU_DECOMPRESSOR_H
+
+#include <vulkan/vulkan.h>
+
+#include <span>
+
+
+namespace VulkanEngine {
+
+/// @brief An asset compressed into independent LZ4 blocks, and where its contents are
+/// expanded to.
+struct DecompressionTarget final {
+    /// @brief The compressed bytes, block offset table first, like a staging slice. The
+    /// buffer must have the usage reported by `getRequiredSourceUsage`, the offset must be a
+    /// multiple of `getSourceAlignment`, and `getRangeSize(sourceSize)` bytes must fit.
+    VkBuffer sourceBuffer = VK_NULL_HANDLE;
+    VkDeviceSize sourceOffset = 0;
+    VkDeviceSize sourceSize = 0;
+    /// @brief A device local buffer, created with the usage reported by
+    /// `getRequiredBufferUsage`, of at least `getRangeSize(size)` bytes.
+    VkBuffer destinationBuffer = VK_NULL_HANDLE;
+    /// @brief The size of the uncompressed contents, and of the blocks they were split into.
+    VkDeviceSize size = 0;
+    VkDeviceSize blockSize = 0;
+    /// @brief An image in the undefined layout to copy regions of the contents into, or
+    /// `VK_NULL_HANDLE` to leave them in the destination buffer.
+    ///
+    /// @note The buffer offsets of the regions are relative to the start of the contents.
+    VkImage destinationImage = VK_NULL_HANDLE;
+    uint32_t mipLevels = 0;
+    std::span<const VkBufferImageCopy> regions;
+};
+
+/// @brief Expands assets compressed into independent LZ4 blocks with a compute shader.
+///
+/// @note Streamed assets are uploaded compressed, so they take that much less of the
+/// staging ring and of the bus, and the CPU never decompresses them. Every invocation
+/// decodes one block, so the work spreads over as many invocations as the asset has blocks,
+/// which keeps a large texture from waiting on a single thread, although it does not fill
+/// the GPU the way a format built for GPU decoding, like GDeflate, with its interleaved
+/// bit streams, would.
+///
+/// Block-compressed texel formats cannot be written by storage writes portably, so textures
+/// are expanded into a buffer first and copied into their image from there.
+class GpuDecompressor final {
+    public:
+        /// @brief The per-asset resources that must outlive the command buffer.
+        struct DispatchResources final {
+            VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        };
+
+        explicit GpuDecompressor() = delete;
+        explicit GpuDecompressor(
+            VkPhysicalDevice physicalDevice,
+            VkDevice device,
+            VkPipelineCache pipelineCache,
+            std::span<const uint32_t> shaderCode
+        );
+
+        ~GpuDecompressor();
+
+        GpuDecompressor(const GpuDecompressor& other) = delete;
+        GpuDecompressor& operator=(const GpuDecompressor& other) = delete;
+
+        VkDeviceSize getSourceAlignment() const;
+
+        VkBufferUsageFlags getRequiredSourceUsage() const;
+
+        VkBufferUsageFlags getRequiredBufferUsage() const;
+
+        /// @brief The size of the buffer range that holds `size` bytes of a source or a
+        /// destination.
+        ///
+        /// @note The shader reads and writes whole words, so the last one may run past the
+        /// bytes themselves.
+        static VkDeviceSize getRangeSize(VkDeviceSize size);
+
+        /// @brief Record the expansion of the source into the destination buffer, and the
+        /// copy into the destination image when there is one.
+        ///
+        /// @note Afterwards the destination buffer is readable by transfers and shaders, and
+        /// every level of the destination image is left in the transfer destination layout,
+        /// since the caller may still have mip levels to generate.
+        DispatchResources record(VkCommandBuffer commandBuffer, const DecompressionTarget& target);
+
+        void release(const DispatchResources& resources);
+    private:
+        struct PushConstants final {
+            uint32_t blockCount;
+            uint32_t blockSize;
+            uint32_t sourceSize;
+            uint32_t size;
+        };
+
+        VkPhysicalDevice m_physicalDevice;
+        VkDevice m_device;
+        VkPipelineCache m_pipelineCache;
+        VkDeviceSize m_sourceAlignment;
+        VkDescriptorSetLayout m_descriptorSetLayout;
+        VkPipelineLayout m_pipelineLayout;
+        VkPipeline m_pipeline;
+
+        void createDescriptorSetLayout();
+
+        void createPipeline(std::span<const uint32_t> shaderCode);
+};
+
+}
+
+#endif // _GPU_DECOMPRESSOR_H
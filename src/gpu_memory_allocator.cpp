@@ -0,0 +1,881 @@
+#include "gpu_memory_allocator.h"
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+
+using GpuMemoryCategory = VulkanEngine::GpuMemoryCategory;
+using GpuMemoryPriority = VulkanEngine::GpuMemoryPriority;
+
+std::string_view VulkanEngine::getMemoryCategoryName(GpuMemoryCategory category) {
+    switch (category) {
+        case GpuMemoryCategory::Texture: return "texture";
+        case GpuMemoryCategory::Vertex: return "vertex";
+        case GpuMemoryCategory::Index: return "index";
+        case GpuMemoryCategory::Uniform: return "uniform";
+        case GpuMemoryCategory::Staging: return "staging";
+        case GpuMemoryCategory::Attachment: return "attachment";
+        case GpuMemoryCategory::Other: return "other";
+    }
+
+    return "unknown";
+}
+
+float VulkanEngine::getMemoryPriorityValue(GpuMemoryPriority priority) {
+    switch (priority) {
+        case GpuMemoryPriority::Low: return 0.25f;
+        case GpuMemoryPriority::Normal: return 0.5f;
+        case GpuMemoryPriority::High: return 1.0f;
+    }
+
+    return 0.5f;
+}
+
+VulkanEngine::GpuMemoryPriority VulkanEngine::getDefaultMemoryPriority(GpuMemoryCategory category) {
+    switch (category) {
+        case GpuMemoryCategory::Attachment: return GpuMemoryPriority::High;
+        case GpuMemoryCategory::Staging: return GpuMemoryPriority::Low;
+        case GpuMemoryCategory::Texture:
+        case GpuMemoryCategory::Vertex:
+        case GpuMemoryCategory::Index:
+        case GpuMemoryCategory::Uniform:
+        case GpuMemoryCategory::Other: return GpuMemoryPriority::Normal;
+    }
+
+    return GpuMemoryPriority::Normal;
+}
+
+static double toMebibytes(VkDeviceSize bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+
+using GpuMemoryBlock = VulkanEngine::GpuMemoryBlock;
+
+GpuMemoryBlock::GpuMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, void* mappedData)
+    : m_memory { memory }
+    , m_size { size }
+    , m_memoryTypeIndex { memoryTypeIndex }
+    , m_mappedData { mappedData }
+    , m_freeRanges { FreeRange { 0, size } }
+    , m_allocatedBytes { 0 }
+{
+}
+
+VkDeviceMemory GpuMemoryBlock::getMemory() const {
+    return m_memory;
+}
+
+VkDeviceSize GpuMemoryBlock::getSize() const {
+    return m_size;
+}
+
+uint32_t GpuMemoryBlock::getMemoryTypeIndex() const {
+    return m_memoryTypeIndex;
+}
+
+void* GpuMemoryBlock::getMappedData() const {
+    return m_mappedData;
+}
+
+bool GpuMemoryBlock::isEmpty() const {
+    return m_allocatedBytes == 0;
+}
+
+VkDeviceSize GpuMemoryBlock::getAllocatedBytes() const {
+    return m_allocatedBytes;
+}
+
+VkDeviceSize GpuMemoryBlock::getLargestFreeRange() const {
+    auto largestFreeRange = VkDeviceSize { 0 };
+    for (const auto& range : m_freeRanges) {
+        largestFreeRange = std::max(largestFreeRange, range.size);
+    }
+
+    return largestFreeRange;
+}
+
+std::optional<VkDeviceSize> GpuMemoryBlock::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    for (auto range = m_freeRanges.begin(); range != m_freeRanges.end(); range++) {
+        const auto alignedOffset = (range->offset + alignment - 1) & ~(alignment - 1);
+        const auto padding = alignedOffset - range->offset;
+        if (padding + size > range->size) {
+            continue;
+        }
+
+        const auto rangeEnd = range->offset + range->size;
+        const auto allocationEnd = alignedOffset + size;
+        const auto oldOffset = range->offset;
+        if (allocationEnd == rangeEnd) {
+            range = m_freeRanges.erase(range);
+        } else {
+            range->offset = allocationEnd;
+            range->size = rangeEnd - allocationEnd;
+        }
+
+        // Keep the alignment padding in the free list so it can be coalesced later.
+        if (padding > 0) {
+            m_freeRanges.insert(range, FreeRange { oldOffset, padding });
+        }
+
+        m_allocatedBytes += size;
+
+        return alignedOffset;
+    }
+
+    return std::nullopt;
+}
+
+void GpuMemoryBlock::free(VkDeviceSize offset, VkDeviceSize size) {
+    const auto next = std::lower_bound(
+        m_freeRanges.begin(),
+        m_freeRanges.end(),
+        offset,
+        [](const FreeRange& range, VkDeviceSize offset) { return range.offset < offset; }
+    );
+    auto inserted = m_freeRanges.insert(next, FreeRange { offset, size });
+
+    // Coalesce with the following range.
+    const auto following = inserted + 1;
+    if (following != m_freeRanges.end() && inserted->offset + inserted->size == following->offset) {
+        inserted->size += following->size;
+        m_freeRanges.erase(following);
+    }
+
+    // Coalesce with the preceding range.
+    if (inserted != m_freeRanges.begin()) {
+        const auto preceding = inserted - 1;
+        if (preceding->offset + preceding->size == inserted->offset) {
+            preceding->size += inserted->size;
+            m_freeRanges.erase(inserted);
+        }
+    }
+
+    m_allocatedBytes -= size;
+}
+
+
+using GpuMemoryAllocator = VulkanEngine::GpuMemoryAllocator;
+
+GpuMemoryAllocator::GpuMemoryAllocator(
+    VkPhysicalDevice physicalDevice,
+    VkDevice device,
+    bool isMemoryBudgetSupported,
+    bool isMemoryPrioritySupported,
+    bool isBufferDeviceAddressSupported
+)
+    : m_physicalDevice { physicalDevice }
+    , m_device { device }
+    , m_memoryProperties {}
+    , m_isUnifiedMemory { false }
+    , m_nonCoherentAtomSize { 1 }
+    , m_deviceMemoryAllocationCount { 0 }
+    , m_isMemoryBudgetSupported { isMemoryBudgetSupported }
+    , m_isMemoryPrioritySupported { isMemoryPrioritySupported }
+    , m_isBufferDeviceAddressSupported { isBufferDeviceAddressSupported }
+    , m_allocatedBytesPerHeap {}
+    , m_heapBudgets {}
+    , m_categoryStatistics {}
+    , m_liveAllocations {}
+    , m_dirtyRanges {}
+{
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+    this->updateBudgets();
+
+    // Some drivers for unified memory report a device type other than integrated, but
+    // still report every heap as device local.
+    auto physicalDeviceProperties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+    const auto isEveryHeapDeviceLocal = std::all_of(
+        m_memoryProperties.memoryHeaps,
+        m_memoryProperties.memoryHeaps + m_memoryProperties.memoryHeapCount,
+        [](const VkMemoryHeap& heap) { return (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0; }
+    );
+    m_isUnifiedMemory = physicalDeviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU || isEveryHeapDeviceLocal;
+    m_nonCoherentAtomSize = std::max<VkDeviceSize>(physicalDeviceProperties.limits.nonCoherentAtomSize, 1);
+}
+
+GpuMemoryAllocator::~GpuMemoryAllocator() {
+    if (!m_liveAllocations.empty()) {
+        fmt::println(std::cerr, "{} device memory allocations were never freed:", m_liveAllocations.size());
+        for (const auto& [key, allocation] : m_liveAllocations) {
+            fmt::println(
+                std::cerr,
+                "    {} bytes of {} memory in memory type {}",
+                allocation.size,
+                VulkanEngine::getMemoryCategoryName(allocation.category),
+                allocation.memoryTypeIndex
+            );
+        }
+    }
+
+    m_liveAllocations.clear();
+    for (auto& heapsPerPriority : m_heaps) {
+        for (auto& heapsPerMemoryType : heapsPerPriority) {
+            for (auto& heapsPerResourceKind : heapsPerMemoryType) {
+                for (auto& heap : heapsPerResourceKind) {
+                    for (auto& block : heap) {
+                        this->freeBlock(block);
+                    }
+
+                    heap.clear();
+                }
+            }
+        }
+    }
+
+    m_device = VK_NULL_HANDLE;
+    m_physicalDevice = VK_NULL_HANDLE;
+}
+
+uint32_t GpuMemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+bool GpuMemoryAllocator::hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool GpuMemoryAllocator::isUnifiedMemory() const {
+    return m_isUnifiedMemory;
+}
+
+bool GpuMemoryAllocator::isDeviceMemoryHostVisible() const {
+    const auto properties = VkMemoryPropertyFlags {
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    };
+    if (m_isUnifiedMemory) {
+        return this->hasMemoryType(~0u, properties);
+    }
+
+    for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++) {
+        const auto& memoryType = m_memoryProperties.memoryTypes[i];
+        if ((memoryType.propertyFlags & properties) != properties) {
+            continue;
+        }
+
+        if (m_memoryProperties.memoryHeaps[memoryType.heapIndex].size > DEVICE_MEMORY_WINDOW_SIZE) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+VkMemoryPropertyFlags GpuMemoryAllocator::selectDynamicMemoryProperties(uint32_t typeFilter) const {
+    const auto hostProperties = VkMemoryPropertyFlags {
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    };
+    const auto deviceProperties = hostProperties | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    if (this->hasMemoryType(typeFilter, deviceProperties)) {
+        return deviceProperties;
+    }
+
+    return hostProperties;
+}
+
+VkMemoryPropertyFlags GpuMemoryAllocator::selectUploadMemoryProperties(uint32_t typeFilter, bool preferCached) const {
+    const auto cachedProperties = VkMemoryPropertyFlags {
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT
+    };
+    if (preferCached && this->hasMemoryType(typeFilter, cachedProperties)) {
+        return cachedProperties;
+    }
+
+    return VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+bool GpuMemoryAllocator::isHostCoherent(const GpuAllocation& allocation) const {
+    const auto propertyFlags = m_memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags;
+
+    return (propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+}
+
+void GpuMemoryAllocator::addDirtyRange(const GpuAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) {
+    if (size == 0 || this->isHostCoherent(allocation)) {
+        return;
+    }
+
+    // The end of the block is a valid end for a range whatever its alignment.
+    const auto begin = (allocation.offset + offset) / m_nonCoherentAtomSize * m_nonCoherentAtomSize;
+    const auto end = std::min(
+        (allocation.offset + offset + size + m_nonCoherentAtomSize - 1) / m_nonCoherentAtomSize * m_nonCoherentAtomSize,
+        allocation.block->getSize()
+    );
+
+    // Slices written one after the other merge into one range.
+    if (!m_dirtyRanges.empty()) {
+        auto& lastRange = m_dirtyRanges.back();
+        const auto lastEnd = lastRange.offset + lastRange.size;
+        if (lastRange.memory == allocation.memory && begin <= lastEnd && lastRange.offset <= end) {
+            const auto mergedBegin = std::min(lastRange.offset, begin);
+            lastRange.size = std::max(lastEnd, end) - mergedBegin;
+            lastRange.offset = mergedBegin;
+
+            return;
+        }
+    }
+
+    m_dirtyRanges.push_back(VkMappedMemoryRange {
+        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+        .memory = allocation.memory,
+        .offset = begin,
+        .size = end - begin,
+    });
+}
+
+void GpuMemoryAllocator::flushDirtyRanges() {
+    if (m_dirtyRanges.empty()) {
+        return;
+    }
+
+    const auto result = vkFlushMappedMemoryRanges(m_device, static_cast<uint32_t>(m_dirtyRanges.size()), m_dirtyRanges.data());
+    m_dirtyRanges.clear();
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to flush mapped memory ranges!");
+    }
+}
+
+void GpuMemoryAllocator::invalidate(const GpuAllocation& allocation) const {
+    if (this->isHostCoherent(allocation)) {
+        return;
+    }
+
+    const auto range = VkMappedMemoryRange {
+        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+        .memory = allocation.memory,
+        .offset = allocation.offset,
+        .size = allocation.size,
+    };
+    const auto result = vkInvalidateMappedMemoryRanges(m_device, 1, &range);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to invalidate mapped memory range!");
+    }
+}
+
+VulkanEngine::GpuAllocation GpuMemoryAllocator::allocate(
+    const VkMemoryRequirements& memoryRequirements,
+    VkMemoryPropertyFlags properties,
+    GpuResourceKind resourceKind,
+    GpuMemoryCategory category
+) {
+    return this->allocate(memoryRequirements, properties, resourceKind, category, getDefaultMemoryPriority(category));
+}
+
+VulkanEngine::GpuAllocation GpuMemoryAllocator::allocate(
+    const VkMemoryRequirements& memoryRequirements,
+    VkMemoryPropertyFlags properties,
+    GpuResourceKind resourceKind,
+    GpuMemoryCategory category,
+    GpuMemoryPriority requestedPriority
+) {
+    // Without memory priorities, splitting the heaps by priority would only waste blocks.
+    const auto priority = m_isMemoryPrioritySupported ? requestedPriority : GpuMemoryPriority::Normal;
+    const auto memoryTypeIndex = this->findMemoryType(memoryRequirements.memoryTypeBits, properties);
+    const auto subAllocationRequirements = this->getSubAllocationRequirements(memoryRequirements, memoryTypeIndex);
+    const auto size = subAllocationRequirements.size;
+    const auto alignment = subAllocationRequirements.alignment;
+    const auto sizeClass = GpuMemoryAllocator::selectSizeClass(size);
+    auto& heap = this->getHeap(priority, memoryTypeIndex, resourceKind, sizeClass);
+
+    for (auto& block : heap) {
+        const auto offset = block->allocate(size, alignment);
+        if (!offset.has_value()) {
+            continue;
+        }
+
+        const auto mappedData = [&block, &offset]() -> void* {
+            if (block->getMappedData() == nullptr) {
+                return nullptr;
+            }
+
+            return static_cast<char*>(block->getMappedData()) + offset.value();
+        }();
+
+        const auto allocation = GpuAllocation {
+            .memory = block->getMemory(),
+            .offset = offset.value(),
+            .size = size,
+            .memoryTypeIndex = memoryTypeIndex,
+            .mappedData = mappedData,
+            .block = block.get(),
+            .category = category,
+            .priority = priority,
+        };
+        this->trackAllocation(allocation);
+
+        return allocation;
+    }
+
+    const auto blockSize = this->blockSizeForSizeClass(sizeClass, memoryTypeIndex, size);
+    auto newBlock = this->allocateBlock(memoryTypeIndex, blockSize, resourceKind, priority);
+    const auto offset = newBlock->allocate(size, alignment);
+    if (!offset.has_value()) {
+        this->freeBlock(newBlock);
+
+        throw std::runtime_error("failed to sub-allocate from a fresh memory block!");
+    }
+
+    const auto mappedData = [&newBlock, &offset]() -> void* {
+        if (newBlock->getMappedData() == nullptr) {
+            return nullptr;
+        }
+
+        return static_cast<char*>(newBlock->getMappedData()) + offset.value();
+    }();
+    const auto allocation = GpuAllocation {
+        .memory = newBlock->getMemory(),
+        .offset = offset.value(),
+        .size = size,
+        .memoryTypeIndex = memoryTypeIndex,
+        .mappedData = mappedData,
+        .block = newBlock.get(),
+        .category = category,
+        .priority = priority,
+    };
+
+    heap.push_back(std::move(newBlock));
+    this->trackAllocation(allocation);
+
+    return allocation;
+}
+
+void GpuMemoryAllocator::free(const GpuAllocation& allocation) {
+    if (!allocation.isValid()) {
+        return;
+    }
+
+    auto& heapsPerMemoryType = m_heaps[static_cast<size_t>(allocation.priority)][allocation.memoryTypeIndex];
+    for (auto& heapsPerResourceKind : heapsPerMemoryType) {
+        for (size_t sizeClassIndex = 0; sizeClassIndex < heapsPerResourceKind.size(); sizeClassIndex++) {
+            auto& heap = heapsPerResourceKind[sizeClassIndex];
+            const auto found = std::find_if(
+                heap.begin(),
+                heap.end(),
+                [&allocation](const auto& block) { return block.get() == allocation.block; }
+            );
+            if (found == heap.end()) {
+                continue;
+            }
+
+            (*found)->free(allocation.offset, allocation.size);
+            this->untrackAllocation(allocation);
+
+            // Keep one empty block around per shared heap so that a free followed by an
+            // allocation of the same size class does not round trip to the driver.
+            const auto sizeClass = static_cast<SizeClass>(sizeClassIndex);
+            const auto isSharedHeap = sizeClass != SizeClass::Dedicated;
+            const auto emptyBlockCount = std::count_if(
+                heap.begin(),
+                heap.end(),
+                [](const auto& block) { return block->isEmpty(); }
+            );
+            if ((*found)->isEmpty() && (!isSharedHeap || emptyBlockCount > 1)) {
+                this->freeBlock(*found);
+                heap.erase(found);
+            }
+
+            return;
+        }
+    }
+
+    throw std::invalid_argument { "Got an allocation that does not belong to this allocator" };
+}
+
+VkDeviceAddress GpuMemoryAllocator::getBufferDeviceAddress(VkBuffer buffer) const {
+    if (!m_isBufferDeviceAddressSupported) {
+        throw std::logic_error("buffer address queried without buffer device addresses!");
+    }
+
+    const auto addressInfo = VkBufferDeviceAddressInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .buffer = buffer,
+    };
+
+    return vkGetBufferDeviceAddress(m_device, &addressInfo);
+}
+
+bool GpuMemoryAllocator::shouldMove(const GpuAllocation& allocation) const {
+    const auto heapIndices = this->findHeapIndices(allocation);
+    if (!heapIndices.has_value()) {
+        return false;
+    }
+
+    const auto [resourceKindIndex, sizeClassIndex] = *heapIndices;
+    if (static_cast<SizeClass>(sizeClassIndex) == SizeClass::Dedicated) {
+        return false;
+    }
+
+    const auto* block = allocation.block;
+    if (block->getAllocatedBytes() * 100 > block->getSize() * DEFRAGMENTATION_MAX_BLOCK_USAGE_PERCENT) {
+        return false;
+    }
+
+    const auto& heap = this->getHeapsPerMemoryType(allocation)[resourceKindIndex][sizeClassIndex];
+
+    return std::any_of(heap.begin(), heap.end(), [block, &allocation](const auto& other) {
+        return other->getAllocatedBytes() > block->getAllocatedBytes() && other->getLargestFreeRange() >= allocation.size;
+    });
+}
+
+VulkanEngine::GpuAllocation GpuMemoryAllocator::allocateForMove(const GpuAllocation& allocation, const VkMemoryRequirements& memoryRequirements) {
+    const auto heapIndices = this->findHeapIndices(allocation);
+    if (!heapIndices.has_value() || !(memoryRequirements.memoryTypeBits & (1 << allocation.memoryTypeIndex))) {
+        return GpuAllocation {};
+    }
+
+    const auto [resourceKindIndex, sizeClassIndex] = *heapIndices;
+    const auto& heap = this->getHeapsPerMemoryType(allocation)[resourceKindIndex][sizeClassIndex];
+
+    // The fullest blocks are tried first, so that moves pack blocks rather than spread
+    // allocations over them, and an allocation never moves into a sparser block than its own.
+    auto destinations = std::vector<GpuMemoryBlock*> {};
+    for (const auto& block : heap) {
+        if (block->getAllocatedBytes() > allocation.block->getAllocatedBytes()) {
+            destinations.push_back(block.get());
+        }
+    }
+
+    std::sort(destinations.begin(), destinations.end(), [](const GpuMemoryBlock* left, const GpuMemoryBlock* right) {
+        return left->getAllocatedBytes() > right->getAllocatedBytes();
+    });
+
+    // A moved allocation covers the same whole atoms as a fresh one, so that its flushes
+    // stay aligned.
+    const auto subAllocationRequirements = this->getSubAllocationRequirements(memoryRequirements, allocation.memoryTypeIndex);
+    const auto size = subAllocationRequirements.size;
+    const auto alignment = subAllocationRequirements.alignment;
+    for (auto* block : destinations) {
+        const auto offset = block->allocate(size, alignment);
+        if (!offset.has_value()) {
+            continue;
+        }
+
+        const auto mappedData = [block, &offset]() -> void* {
+            if (block->getMappedData() == nullptr) {
+                return nullptr;
+            }
+
+            return static_cast<char*>(block->getMappedData()) + offset.value();
+        }();
+        const auto movedAllocation = GpuAllocation {
+            .memory = block->getMemory(),
+            .offset = offset.value(),
+            .size = size,
+            .memoryTypeIndex = allocation.memoryTypeIndex,
+            .mappedData = mappedData,
+            .block = block,
+            .category = allocation.category,
+            .priority = allocation.priority,
+        };
+        this->trackAllocation(movedAllocation);
+
+        return movedAllocation;
+    }
+
+    return GpuAllocation {};
+}
+
+const VkPhysicalDeviceMemoryProperties& GpuMemoryAllocator::getMemoryProperties() const {
+    return m_memoryProperties;
+}
+
+uint32_t GpuMemoryAllocator::getDeviceMemoryAllocationCount() const {
+    return m_deviceMemoryAllocationCount;
+}
+
+void GpuMemoryAllocator::updateBudgets() {
+    if (!m_isMemoryBudgetSupported) {
+        for (uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; i++) {
+            m_heapBudgets[i] = GpuHeapBudget {
+                .usage = m_allocatedBytesPerHeap[i],
+                .budget = m_memoryProperties.memoryHeaps[i].size / 100 * ESTIMATED_BUDGET_PERCENT,
+            };
+        }
+
+        return;
+    }
+
+    auto budgetProperties = VkPhysicalDeviceMemoryBudgetPropertiesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+        .pNext = nullptr,
+    };
+    auto memoryProperties = VkPhysicalDeviceMemoryProperties2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+        .pNext = &budgetProperties,
+    };
+    vkGetPhysicalDeviceMemoryProperties2(m_physicalDevice, &memoryProperties);
+
+    for (uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; i++) {
+        m_heapBudgets[i] = GpuHeapBudget {
+            .usage = budgetProperties.heapUsage[i],
+            .budget = budgetProperties.heapBudget[i],
+        };
+    }
+}
+
+VulkanEngine::GpuHeapBudget GpuMemoryAllocator::getHeapBudget(uint32_t heapIndex) const {
+    if (heapIndex >= m_memoryProperties.memoryHeapCount) {
+        throw std::invalid_argument("unknown memory heap index!");
+    }
+
+    return m_heapBudgets[heapIndex];
+}
+
+bool GpuMemoryAllocator::hasMemoryBudget() const {
+    return m_isMemoryBudgetSupported;
+}
+
+VulkanEngine::GpuMemoryStatistics GpuMemoryAllocator::getStatistics() const {
+    auto statistics = GpuMemoryStatistics {
+        .categories = m_categoryStatistics,
+    };
+
+    auto unusableFreeBytes = VkDeviceSize { 0 };
+    for (const auto& heapsPerPriority : m_heaps) {
+        for (const auto& heapsPerMemoryType : heapsPerPriority) {
+            for (const auto& heapsPerResourceKind : heapsPerMemoryType) {
+                for (const auto& heap : heapsPerResourceKind) {
+                    for (const auto& block : heap) {
+                        const auto freeBytes = block->getSize() - block->getAllocatedBytes();
+                        statistics.blockCount++;
+                        statistics.blockBytes += block->getSize();
+                        statistics.allocatedBytes += block->getAllocatedBytes();
+                        statistics.freeBytes += freeBytes;
+                        unusableFreeBytes += freeBytes - block->getLargestFreeRange();
+                    }
+                }
+            }
+        }
+    }
+
+    if (statistics.freeBytes > 0) {
+        statistics.fragmentation = static_cast<float>(unusableFreeBytes) / static_cast<float>(statistics.freeBytes);
+    }
+
+    return statistics;
+}
+
+void GpuMemoryAllocator::printReport() const {
+    const auto statistics = this->getStatistics();
+    fmt::println("{:<10}  {:>10}  {:>8}  {:>10}", "Category", "MiB", "Count", "Peak MiB");
+    for (size_t i = 0; i < statistics.categories.size(); i++) {
+        const auto& categoryStatistics = statistics.categories[i];
+        fmt::println(
+            "{:<10}  {:>10.3f}  {:>8}  {:>10.3f}",
+            VulkanEngine::getMemoryCategoryName(static_cast<GpuMemoryCategory>(i)),
+            toMebibytes(categoryStatistics.bytes),
+            categoryStatistics.allocationCount,
+            toMebibytes(categoryStatistics.peakBytes)
+        );
+    }
+    fmt::println(
+        "{} blocks, {:.3f} MiB, {:.3f} MiB allocated, {:.3f} MiB free, {:.1f}% fragmented",
+        statistics.blockCount,
+        toMebibytes(statistics.blockBytes),
+        toMebibytes(statistics.allocatedBytes),
+        toMebibytes(statistics.freeBytes),
+        100.0f * statistics.fragmentation
+    );
+}
+
+GpuMemoryAllocator::SizeClass GpuMemoryAllocator::selectSizeClass(VkDeviceSize size) {
+    if (size <= SMALL_ALLOCATION_MAX_SIZE) {
+        return SizeClass::Small;
+    } else if (size <= MEDIUM_ALLOCATION_MAX_SIZE) {
+        return SizeClass::Medium;
+    } else {
+        return SizeClass::Dedicated;
+    }
+}
+
+VkDeviceSize GpuMemoryAllocator::blockSizeForSizeClass(SizeClass sizeClass, uint32_t memoryTypeIndex, VkDeviceSize requestedSize) const {
+    const auto heapIndex = m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    const auto heapSize = m_memoryProperties.memoryHeaps[heapIndex].size;
+
+    // Small heaps (e.g. the 256 MiB host-visible device-local heap on many discrete GPUs)
+    // should not be consumed by a handful of mostly empty blocks.
+    const auto maxSharedBlockSize = std::max(heapSize / 8, requestedSize);
+    switch (sizeClass) {
+        case SizeClass::Small: return std::min(SMALL_BLOCK_SIZE, maxSharedBlockSize);
+        case SizeClass::Medium: return std::min(MEDIUM_BLOCK_SIZE, maxSharedBlockSize);
+        case SizeClass::Dedicated: return requestedSize;
+    }
+
+    return requestedSize;
+}
+
+VkMemoryRequirements GpuMemoryAllocator::getSubAllocationRequirements(const VkMemoryRequirements& memoryRequirements, uint32_t memoryTypeIndex) const {
+    // Allocations in mapped memory that is not host coherent cover whole atoms, so that
+    // flushing one never flushes a neighbour the device may be writing.
+    const auto propertyFlags = m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+    const auto isNonCoherent = (propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+        !(propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (!isNonCoherent) {
+        return memoryRequirements;
+    }
+
+    return VkMemoryRequirements {
+        .size = (memoryRequirements.size + m_nonCoherentAtomSize - 1) / m_nonCoherentAtomSize * m_nonCoherentAtomSize,
+        .alignment = std::max(memoryRequirements.alignment, m_nonCoherentAtomSize),
+        .memoryTypeBits = memoryRequirements.memoryTypeBits,
+    };
+}
+
+GpuMemoryAllocator::Heap& GpuMemoryAllocator::getHeap(
+    GpuMemoryPriority priority,
+    uint32_t memoryTypeIndex,
+    GpuResourceKind resourceKind,
+    SizeClass sizeClass
+) {
+    const auto priorityIndex = static_cast<size_t>(priority);
+    const auto resourceKindIndex = static_cast<size_t>(resourceKind);
+    const auto sizeClassIndex = static_cast<size_t>(sizeClass);
+
+    return m_heaps[priorityIndex][memoryTypeIndex][resourceKindIndex][sizeClassIndex];
+}
+
+const GpuMemoryAllocator::HeapsPerMemoryType& GpuMemoryAllocator::getHeapsPerMemoryType(const GpuAllocation& allocation) const {
+    return m_heaps[static_cast<size_t>(allocation.priority)][allocation.memoryTypeIndex];
+}
+
+std::optional<std::tuple<size_t, size_t>> GpuMemoryAllocator::findHeapIndices(const GpuAllocation& allocation) const {
+    if (!allocation.isValid()) {
+        return std::nullopt;
+    }
+
+    const auto& heapsPerMemoryType = this->getHeapsPerMemoryType(allocation);
+    for (size_t resourceKindIndex = 0; resourceKindIndex < heapsPerMemoryType.size(); resourceKindIndex++) {
+        const auto& heapsPerResourceKind = heapsPerMemoryType[resourceKindIndex];
+        for (size_t sizeClassIndex = 0; sizeClassIndex < heapsPerResourceKind.size(); sizeClassIndex++) {
+            const auto& heap = heapsPerResourceKind[sizeClassIndex];
+            const auto found = std::find_if(
+                heap.begin(),
+                heap.end(),
+                [&allocation](const auto& block) { return block.get() == allocation.block; }
+            );
+            if (found != heap.end()) {
+                return std::make_tuple(resourceKindIndex, sizeClassIndex);
+            }
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::unique_ptr<GpuMemoryBlock> GpuMemoryAllocator::allocateBlock(
+    uint32_t memoryTypeIndex,
+    VkDeviceSize blockSize,
+    GpuResourceKind resourceKind,
+    GpuMemoryPriority priority
+) {
+    const auto priorityAllocateInfo = VkMemoryPriorityAllocateInfoEXT {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_PRIORITY_ALLOCATE_INFO_EXT,
+        .pNext = nullptr,
+        .priority = getMemoryPriorityValue(priority),
+    };
+    // A buffer with a device address has to be bound to memory allocated for addresses.
+    // Images never have one, so their blocks go without.
+    const auto allocateFlagsInfo = VkMemoryAllocateFlagsInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+        .pNext = m_isMemoryPrioritySupported ? &priorityAllocateInfo : nullptr,
+        .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+        .deviceMask = 0,
+    };
+    const auto isDeviceAddressable = m_isBufferDeviceAddressSupported && resourceKind == GpuResourceKind::Linear;
+    const auto allocateInfoNext = [this, isDeviceAddressable, &allocateFlagsInfo, &priorityAllocateInfo]() -> const void* {
+        if (isDeviceAddressable) {
+            return &allocateFlagsInfo;
+        } else if (m_isMemoryPrioritySupported) {
+            return &priorityAllocateInfo;
+        } else {
+            return nullptr;
+        }
+    }();
+    const auto allocInfo = VkMemoryAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = allocateInfoNext,
+        .allocationSize = blockSize,
+        .memoryTypeIndex = memoryTypeIndex,
+    };
+
+    auto memory = VkDeviceMemory {};
+    const auto resultAllocateMemory = vkAllocateMemory(m_device, &allocInfo, nullptr, &memory);
+    if (resultAllocateMemory != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate device memory block!");
+    }
+
+    m_deviceMemoryAllocationCount++;
+    m_allocatedBytesPerHeap[m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex] += blockSize;
+
+    const auto propertyFlags = m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+    void* mappedData = nullptr;
+    if (propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        const auto resultMapMemory = vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, &mappedData);
+        if (resultMapMemory != VK_SUCCESS) {
+            vkFreeMemory(m_device, memory, nullptr);
+            m_deviceMemoryAllocationCount--;
+            m_allocatedBytesPerHeap[m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex] -= blockSize;
+
+            throw std::runtime_error("failed to map device memory block!");
+        }
+    }
+
+    return std::make_unique<GpuMemoryBlock>(memory, blockSize, memoryTypeIndex, mappedData);
+}
+
+void GpuMemoryAllocator::trackAllocation(const GpuAllocation& allocation) {
+    auto& categoryStatistics = m_categoryStatistics[static_cast<size_t>(allocation.category)];
+    categoryStatistics.bytes += allocation.size;
+    categoryStatistics.allocationCount++;
+    categoryStatistics.peakBytes = std::max(categoryStatistics.peakBytes, categoryStatistics.bytes);
+
+    m_liveAllocations.insert_or_assign(std::make_tuple(allocation.memory, allocation.offset), allocation);
+}
+
+void GpuMemoryAllocator::untrackAllocation(const GpuAllocation& allocation) {
+    // The tracked copy is counted, not the caller's, which may have been changed since.
+    const auto found = m_liveAllocations.find(std::make_tuple(allocation.memory, allocation.offset));
+    if (found == m_liveAllocations.end()) {
+        return;
+    }
+
+    const auto& trackedAllocation = found->second;
+    auto& categoryStatistics = m_categoryStatistics[static_cast<size_t>(trackedAllocation.category)];
+    categoryStatistics.bytes -= trackedAllocation.size;
+    categoryStatistics.allocationCount--;
+
+    m_liveAllocations.erase(found);
+}
+
+void GpuMemoryAllocator::freeBlock(std::unique_ptr<GpuMemoryBlock>& block) {
+    if (block == nullptr) {
+        return;
+    }
+
+    if (block->getMappedData() != nullptr) {
+        vkUnmapMemory(m_device, block->getMemory());
+    }
+
+    vkFreeMemory(m_device, block->getMemory(), nullptr);
+    m_deviceMemoryAllocationCount--;
+    m_allocatedBytesPerHeap[m_memoryProperties.memoryTypes[block->getMemoryTypeIndex()].heapIndex] -= block->getSize();
+
+    block.reset();
+}
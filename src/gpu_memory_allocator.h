@@ -0,0 +1,379 @@
+#ifndef _GPU_MEMORY_ALLOCATOR_H
+#define _GPU_MEMORY_ALLOCATOR_H
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief The kind of resource bound to an allocation.
+///
+/// @note Vulkan requires linear resources (buffers, linearly tiled images) and
+/// non-linear resources (optimally tiled images) that share a `VkDeviceMemory` to
+/// be separated by `bufferImageGranularity` bytes whenever they are adjacent. The
+/// allocator never mixes the two kinds inside one memory block, so the granularity
+/// requirement is satisfied without any padding between neighbouring allocations.
+enum class GpuResourceKind {
+    Linear,
+    Optimal
+};
+
+/// @brief What an allocation holds, for the allocator's statistics.
+enum class GpuMemoryCategory : size_t {
+    Texture = 0,
+    Vertex = 1,
+    Index = 2,
+    Uniform = 3,
+    Staging = 4,
+    Attachment = 5,
+    Other = 6
+};
+
+constexpr size_t GPU_MEMORY_CATEGORY_COUNT = 7;
+
+std::string_view getMemoryCategoryName(GpuMemoryCategory category);
+
+/// @brief How much an allocation is worth keeping in device local memory when the device
+/// runs out of it, with `VK_EXT_memory_priority`.
+///
+/// @note Render targets are touched every frame, so paging one out stalls every frame,
+/// while the detail levels of a streamed texture can be paged out and only cost detail.
+enum class GpuMemoryPriority : size_t {
+    Low = 0,
+    Normal = 1,
+    High = 2
+};
+
+constexpr size_t GPU_MEMORY_PRIORITY_COUNT = 3;
+
+/// @brief The priority the memory of `priority` is allocated with, between 0 and 1, with
+/// the 0.5 that Vulkan gives memory without a priority in the middle.
+float getMemoryPriorityValue(GpuMemoryPriority priority);
+
+/// @brief The priority of allocations of `category` that do not ask for another.
+GpuMemoryPriority getDefaultMemoryPriority(GpuMemoryCategory category);
+
+class GpuMemoryBlock;
+
+/// @brief How much of a memory heap is in use, and how much of it the process can use
+/// before the driver starts to page memory out or fail allocations.
+struct GpuHeapBudget final {
+    VkDeviceSize usage = 0;
+    VkDeviceSize budget = 0;
+};
+
+/// @brief The live allocations of one category, and the most bytes they ever held at once.
+struct GpuMemoryCategoryStatistics final {
+    VkDeviceSize bytes = 0;
+    uint32_t allocationCount = 0;
+    VkDeviceSize peakBytes = 0;
+};
+
+/// @brief What the allocator holds, by category and by block.
+///
+/// @note Blocks are shared between categories, so fragmentation is measured over the
+/// blocks: the share of their free bytes that lies outside the largest free range of its
+/// block, which no allocation larger than that range can use.
+struct GpuMemoryStatistics final {
+    std::array<GpuMemoryCategoryStatistics, GPU_MEMORY_CATEGORY_COUNT> categories;
+    uint32_t blockCount = 0;
+    VkDeviceSize blockBytes = 0;
+    VkDeviceSize allocatedBytes = 0;
+    VkDeviceSize freeBytes = 0;
+    float fragmentation = 0.0f;
+};
+
+/// @brief A sub-range of a `VkDeviceMemory` block handed out by the `GpuMemoryAllocator`.
+struct GpuAllocation final {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    uint32_t memoryTypeIndex = 0;
+    void* mappedData = nullptr;
+    GpuMemoryBlock* block = nullptr;
+    GpuMemoryCategory category = GpuMemoryCategory::Other;
+    GpuMemoryPriority priority = GpuMemoryPriority::Normal;
+
+    bool isValid() const {
+        return memory != VK_NULL_HANDLE;
+    }
+};
+
+class GpuMemoryBlock final {
+    public:
+        explicit GpuMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, void* mappedData);
+
+        ~GpuMemoryBlock() = default;
+
+        VkDeviceMemory getMemory() const;
+
+        VkDeviceSize getSize() const;
+
+        uint32_t getMemoryTypeIndex() const;
+
+        void* getMappedData() const;
+
+        bool isEmpty() const;
+
+        VkDeviceSize getAllocatedBytes() const;
+
+        VkDeviceSize getLargestFreeRange() const;
+
+        std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+        void free(VkDeviceSize offset, VkDeviceSize size);
+    private:
+        struct FreeRange final {
+            VkDeviceSize offset;
+            VkDeviceSize size;
+        };
+
+        VkDeviceMemory m_memory;
+        VkDeviceSize m_size;
+        uint32_t m_memoryTypeIndex;
+        void* m_mappedData;
+        std::vector<FreeRange> m_freeRanges;
+        VkDeviceSize m_allocatedBytes;
+};
+
+/// @brief A block-based sub-allocator for device memory.
+///
+/// @note Each memory type owns a set of heaps, one per (resource kind, size class)
+/// pair. Small and medium requests are carved out of large shared blocks with a
+/// first-fit free list, so most allocations never touch `vkAllocateMemory`. Requests
+/// larger than the largest size class get a dedicated block of their own. Blocks
+/// backed by host-visible memory are persistently mapped when they are created, and
+/// callers must use `GpuAllocation::mappedData` instead of calling `vkMapMemory`.
+///
+/// The budget of every memory heap comes from `VK_EXT_memory_budget` where the device has
+/// it, and counts the memory of the whole process, other APIs included. Without it the
+/// usage is the size of the blocks this allocator holds, against a fixed share of the heap.
+///
+/// Every allocation is counted under its category until it is freed. An allocation that
+/// is still live when the allocator is destroyed was leaked, and is reported as such.
+///
+/// Shared blocks fragment as allocations come and go. Their owners compact them a move at
+/// a time: an allocation in a sparsely used block is given room in a fuller block of the
+/// same heap, the owner copies its resource over, and freeing the old allocation lets the
+/// sparse block empty out and go back to the driver.
+///
+/// Where the device has buffer device addresses, every block of memory for buffers is
+/// allocated so that the buffers bound to it can give out their addresses.
+///
+/// Where the device has memory priorities, a priority is given to a whole `VkDeviceMemory`,
+/// so every priority has heaps of its own, and the driver pages out the blocks of low
+/// priority first when the device runs out of memory. Without them every allocation is of
+/// normal priority.
+class GpuMemoryAllocator final {
+    public:
+        explicit GpuMemoryAllocator() = delete;
+        explicit GpuMemoryAllocator(
+            VkPhysicalDevice physicalDevice,
+            VkDevice device,
+            bool isMemoryBudgetSupported,
+            bool isMemoryPrioritySupported,
+            bool isBufferDeviceAddressSupported
+        );
+
+        ~GpuMemoryAllocator();
+
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+        bool hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+        /// @brief Whether the device shares its memory with the host, as an integrated GPU
+        /// does, or a GPU reached through the portability subset on a system with one pool
+        /// of memory.
+        bool isUnifiedMemory() const;
+
+        /// @brief Whether most device local memory is host visible too, as with resizable BAR
+        /// or on an integrated GPU, so that buffers can be written in place rather than copied
+        /// from a staging buffer.
+        ///
+        /// @note Without resizable BAR a discrete GPU only maps a small window of its memory,
+        /// which the driver uses too. That window is left to the memory the host writes every
+        /// frame. With unified memory every heap is the same memory, however small the driver
+        /// reports it.
+        bool isDeviceMemoryHostVisible() const;
+
+        /// @brief The properties of memory the host writes every frame and the device reads:
+        /// device local too where a memory type allows it, so the device reads it at full
+        /// speed, and only host visible otherwise.
+        VkMemoryPropertyFlags selectDynamicMemoryProperties(uint32_t typeFilter) const;
+
+        /// @brief The properties of memory the host fills with upload data for the device to
+        /// copy from: host cached where `preferCached` is set and a memory type allows it, and
+        /// host coherent otherwise.
+        ///
+        /// @note Cached memory is fast to write piecemeal and to read back while decoding into
+        /// it, but it may not be host coherent, in which case every range the host writes has
+        /// to be added with `addDirtyRange` before the device reads it.
+        VkMemoryPropertyFlags selectUploadMemoryProperties(uint32_t typeFilter, bool preferCached) const;
+
+        bool isHostCoherent(const GpuAllocation& allocation) const;
+
+        /// @brief Queue a range of a mapped allocation the host has written, to be flushed by
+        /// the next `flushDirtyRanges`.
+        ///
+        /// @note The range is widened to `nonCoherentAtomSize`, which every allocation in
+        /// memory that is not host coherent is aligned to, so a flush never reaches into the
+        /// allocation next to it. Ranges of host coherent memory are ignored.
+        void addDirtyRange(const GpuAllocation& allocation, VkDeviceSize offset, VkDeviceSize size);
+
+        /// @brief Flush every queued dirty range with one call, before the submit that reads
+        /// them.
+        void flushDirtyRanges();
+
+        /// @brief Make what the device wrote to a mapped allocation visible to the host,
+        /// before the host reads it.
+        ///
+        /// @note Allocations of host coherent memory need nothing. The range is the whole
+        /// allocation, which is aligned to `nonCoherentAtomSize` in memory that is not host
+        /// coherent, so it is safe to call from any thread.
+        void invalidate(const GpuAllocation& allocation) const;
+
+        /// @brief Allocate memory of the default priority of `category`.
+        GpuAllocation allocate(
+            const VkMemoryRequirements& memoryRequirements,
+            VkMemoryPropertyFlags properties,
+            GpuResourceKind resourceKind,
+            GpuMemoryCategory category
+        );
+
+        GpuAllocation allocate(
+            const VkMemoryRequirements& memoryRequirements,
+            VkMemoryPropertyFlags properties,
+            GpuResourceKind resourceKind,
+            GpuMemoryCategory category,
+            GpuMemoryPriority priority
+        );
+
+        void free(const GpuAllocation& allocation);
+
+        /// @brief The address shaders reach `buffer` at, once it is bound to an allocation.
+        ///
+        /// @note The buffer has to have been created with
+        /// `VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT` on a device with buffer device
+        /// addresses.
+        VkDeviceAddress getBufferDeviceAddress(VkBuffer buffer) const;
+
+        /// @brief Whether moving `allocation` would help compact its heap: its block is a
+        /// shared block that is mostly free, and a fuller block of the heap has room for it.
+        bool shouldMove(const GpuAllocation& allocation) const;
+
+        /// @brief Allocate room for a copy of `allocation` in a fuller block of its heap,
+        /// without allocating a new block.
+        ///
+        /// @returns An invalid allocation when no such block has room, or when the memory
+        /// type of `allocation` does not suit `memoryRequirements`.
+        GpuAllocation allocateForMove(const GpuAllocation& allocation, const VkMemoryRequirements& memoryRequirements);
+
+        const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const;
+
+        uint32_t getDeviceMemoryAllocationCount() const;
+
+        /// @brief Query the usage and budget of every memory heap again.
+        ///
+        /// @note The driver only updates its numbers between frames, so call this once per
+        /// frame. The budgets returned in between stay as they were.
+        void updateBudgets();
+
+        GpuHeapBudget getHeapBudget(uint32_t heapIndex) const;
+
+        /// @brief Whether the budgets come from the driver rather than the allocator's own
+        /// estimate.
+        bool hasMemoryBudget() const;
+
+        GpuMemoryStatistics getStatistics() const;
+
+        /// @brief Print the statistics as a table.
+        ///
+        /// @note The allocations that are still live are listed as leaks when the allocator
+        /// is destroyed, not here, so that each of them is reported once.
+        void printReport() const;
+    private:
+        enum class SizeClass : size_t {
+            Small = 0,
+            Medium = 1,
+            Dedicated = 2
+        };
+
+        static constexpr size_t SIZE_CLASS_COUNT = 3;
+        static constexpr size_t RESOURCE_KIND_COUNT = 2;
+
+        static constexpr VkDeviceSize SMALL_ALLOCATION_MAX_SIZE = 256 * 1024;
+        static constexpr VkDeviceSize SMALL_BLOCK_SIZE = 4 * 1024 * 1024;
+        static constexpr VkDeviceSize MEDIUM_ALLOCATION_MAX_SIZE = 32 * 1024 * 1024;
+        static constexpr VkDeviceSize MEDIUM_BLOCK_SIZE = 64 * 1024 * 1024;
+        /// @brief The share of a heap the estimated budget allows, since other processes
+        /// and the driver need some of it too.
+        static constexpr VkDeviceSize ESTIMATED_BUDGET_PERCENT = 80;
+        /// @brief The most a block can be in use for its allocations to be moved out of it.
+        static constexpr VkDeviceSize DEFRAGMENTATION_MAX_BLOCK_USAGE_PERCENT = 50;
+        /// @brief The size of the window into device memory a discrete GPU maps without
+        /// resizable BAR. A host visible device local heap larger than it maps most of the
+        /// device memory.
+        static constexpr VkDeviceSize DEVICE_MEMORY_WINDOW_SIZE = 256 * 1024 * 1024;
+
+        using Heap = std::vector<std::unique_ptr<GpuMemoryBlock>>;
+        using HeapsPerMemoryType = std::array<std::array<Heap, SIZE_CLASS_COUNT>, RESOURCE_KIND_COUNT>;
+
+        VkPhysicalDevice m_physicalDevice;
+        VkDevice m_device;
+        VkPhysicalDeviceMemoryProperties m_memoryProperties;
+        bool m_isUnifiedMemory;
+        VkDeviceSize m_nonCoherentAtomSize;
+        std::array<std::array<HeapsPerMemoryType, VK_MAX_MEMORY_TYPES>, GPU_MEMORY_PRIORITY_COUNT> m_heaps;
+        uint32_t m_deviceMemoryAllocationCount;
+        bool m_isMemoryBudgetSupported;
+        bool m_isMemoryPrioritySupported;
+        bool m_isBufferDeviceAddressSupported;
+        std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_allocatedBytesPerHeap;
+        std::array<GpuHeapBudget, VK_MAX_MEMORY_HEAPS> m_heapBudgets;
+        std::array<GpuMemoryCategoryStatistics, GPU_MEMORY_CATEGORY_COUNT> m_categoryStatistics;
+        /// @brief The live allocations, by their memory and offset.
+        std::map<std::tuple<VkDeviceMemory, VkDeviceSize>, GpuAllocation> m_liveAllocations;
+        std::vector<VkMappedMemoryRange> m_dirtyRanges;
+
+        static SizeClass selectSizeClass(VkDeviceSize size);
+
+        VkDeviceSize blockSizeForSizeClass(SizeClass sizeClass, uint32_t memoryTypeIndex, VkDeviceSize requestedSize) const;
+
+        Heap& getHeap(GpuMemoryPriority priority, uint32_t memoryTypeIndex, GpuResourceKind resourceKind, SizeClass sizeClass);
+
+        /// @brief `memoryRequirements` as a sub-allocation in `memoryTypeIndex` takes them,
+        /// rounded out to whole atoms in mapped memory that is not host coherent.
+        VkMemoryRequirements getSubAllocationRequirements(const VkMemoryRequirements& memoryRequirements, uint32_t memoryTypeIndex) const;
+
+        const HeapsPerMemoryType& getHeapsPerMemoryType(const GpuAllocation& allocation) const;
+
+        /// @brief The resource kind and size class of the heap that holds the block of
+        /// `allocation`, if any does.
+        std::optional<std::tuple<size_t, size_t>> findHeapIndices(const GpuAllocation& allocation) const;
+
+        std::unique_ptr<GpuMemoryBlock> allocateBlock(
+            uint32_t memoryTypeIndex,
+            VkDeviceSize blockSize,
+            GpuResourceKind resourceKind,
+            GpuMemoryPriority priority
+        );
+
+        void freeBlock(std::unique_ptr<GpuMemoryBlock>& block);
+
+        void trackAllocation(const GpuAllocation& allocation);
+
+        void untrackAllocation(const GpuAllocation& allocation);
+};
+
+}
+
+#endif // _GPU_MEMORY_ALLOCATOR_H
@@ -0,0 +1,599 @@
+#include "gpu_profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+
+using GpuProfiler = VulkanEngine::GpuProfiler;
+using GpuScopeStatistics = VulkanEngine::GpuScopeStatistics;
+using GpuCounterStatistics = VulkanEngine::GpuCounterStatistics;
+
+static uint32_t getTimestampValidBits(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex) {
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+    auto queueFamilies = std::vector<VkQueueFamilyProperties> { queueFamilyCount };
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+    if (queueFamilyIndex >= queueFamilies.size()) {
+        return 0;
+    }
+
+    return queueFamilies[queueFamilyIndex].timestampValidBits;
+}
+
+// The name of the unit of a performance counter, as the statistics report it.
+static std::string getCounterUnitName(VkPerformanceCounterUnitKHR unit) {
+    switch (unit) {
+        case VK_PERFORMANCE_COUNTER_UNIT_PERCENTAGE_KHR:
+            return "%";
+        case VK_PERFORMANCE_COUNTER_UNIT_NANOSECONDS_KHR:
+            return "ns";
+        case VK_PERFORMANCE_COUNTER_UNIT_BYTES_KHR:
+            return "bytes";
+        case VK_PERFORMANCE_COUNTER_UNIT_BYTES_PER_SECOND_KHR:
+            return "bytes/s";
+        case VK_PERFORMANCE_COUNTER_UNIT_KELVIN_KHR:
+            return "K";
+        case VK_PERFORMANCE_COUNTER_UNIT_WATTS_KHR:
+            return "W";
+        case VK_PERFORMANCE_COUNTER_UNIT_VOLTS_KHR:
+            return "V";
+        case VK_PERFORMANCE_COUNTER_UNIT_AMPS_KHR:
+            return "A";
+        case VK_PERFORMANCE_COUNTER_UNIT_HERTZ_KHR:
+            return "Hz";
+        case VK_PERFORMANCE_COUNTER_UNIT_CYCLES_KHR:
+            return "cycles";
+        default:
+            return "";
+    }
+}
+
+static double getCounterValue(const VkPerformanceCounterResultKHR& result, VkPerformanceCounterStorageKHR storage) {
+    switch (storage) {
+        case VK_PERFORMANCE_COUNTER_STORAGE_INT32_KHR:
+            return static_cast<double>(result.int32);
+        case VK_PERFORMANCE_COUNTER_STORAGE_INT64_KHR:
+            return static_cast<double>(result.int64);
+        case VK_PERFORMANCE_COUNTER_STORAGE_UINT32_KHR:
+            return static_cast<double>(result.uint32);
+        case VK_PERFORMANCE_COUNTER_STORAGE_UINT64_KHR:
+            return static_cast<double>(result.uint64);
+        case VK_PERFORMANCE_COUNTER_STORAGE_FLOAT32_KHR:
+            return static_cast<double>(result.float32);
+        case VK_PERFORMANCE_COUNTER_STORAGE_FLOAT64_KHR:
+            return result.float64;
+        default:
+            return 0.0;
+    }
+}
+
+GpuProfiler::GpuProfiler(
+    VkInstance instance,
+    VkPhysicalDevice physicalDevice,
+    VkDevice device,
+    uint32_t queueFamilyIndex,
+    uint32_t frameCount,
+    bool collectPipelineStatistics,
+    bool collectPerformanceCounters,
+    uint32_t maxScopesPerFrame
+)
+    : m_device { device }
+    , m_timestampPeriod { 0.0 }
+    , m_timestampMask { 0 }
+    , m_maxScopesPerFrame { maxScopesPerFrame }
+    , m_pipelineStatistics { 0 }
+    , m_counters { std::vector<CounterDescription> {} }
+    , m_performanceCounterIndices { std::vector<uint32_t> {} }
+    , m_frames { std::vector<FrameQueries> {} }
+    , m_recordingFrame { 0 }
+    , m_histories { std::vector<ScopeHistory> {} }
+    , m_latestFrameMilliseconds { std::nullopt }
+    , m_vkReleaseProfilingLockKHR { nullptr }
+{
+    if (!GpuProfiler::isSupported(physicalDevice, queueFamilyIndex)) {
+        throw std::invalid_argument("queue family does not support timestamps!");
+    }
+
+    if (collectPipelineStatistics && !GpuProfiler::isPipelineStatisticsSupported(physicalDevice, queueFamilyIndex)) {
+        throw std::invalid_argument("queue family does not support pipeline statistics!");
+    }
+
+    auto physicalDeviceProperties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+
+    // Timestamps wrap around at their valid bits.
+    const auto timestampValidBits = getTimestampValidBits(physicalDevice, queueFamilyIndex);
+    m_timestampPeriod = static_cast<double>(physicalDeviceProperties.limits.timestampPeriod);
+    m_timestampMask = timestampValidBits >= 64 ? UINT64_MAX : (uint64_t { 1 } << timestampValidBits) - 1;
+
+    // The statistics are written in the order of their bits.
+    if (collectPipelineStatistics) {
+        m_pipelineStatistics = PIPELINE_STATISTICS;
+        for (const auto* name : { "vertex invocations", "clipping invocations", "clipping primitives", "fragment invocations", "compute invocations" }) {
+            const auto unit = std::string { name }.ends_with("primitives") ? "primitives" : "invocations";
+            m_counters.push_back(CounterDescription { .name = name, .unit = unit, .storage = VK_PERFORMANCE_COUNTER_STORAGE_UINT64_KHR });
+        }
+    }
+    if (collectPerformanceCounters) {
+        this->selectPerformanceCounters(instance, physicalDevice, queueFamilyIndex);
+    }
+
+    for (uint32_t i = 0; i < frameCount; i++) {
+        m_frames.push_back(FrameQueries {
+            .queryPool = this->createQueryPool(VK_QUERY_TYPE_TIMESTAMP, queueFamilyIndex),
+            .statisticsQueryPool = m_pipelineStatistics != 0 ? this->createQueryPool(VK_QUERY_TYPE_PIPELINE_STATISTICS, queueFamilyIndex) : VK_NULL_HANDLE,
+            .performanceQueryPool = !m_performanceCounterIndices.empty() ? this->createQueryPool(VK_QUERY_TYPE_PERFORMANCE_QUERY_KHR, queueFamilyIndex) : VK_NULL_HANDLE,
+            .scopeNames = std::vector<std::string> {},
+            .counterScopes = std::vector<uint32_t> {},
+            .countingScope = NO_SCOPE,
+            .isSubmitted = false,
+        });
+    }
+}
+
+GpuProfiler::~GpuProfiler() {
+    for (const auto& frame : m_frames) {
+        vkDestroyQueryPool(m_device, frame.queryPool, nullptr);
+        vkDestroyQueryPool(m_device, frame.statisticsQueryPool, nullptr);
+        vkDestroyQueryPool(m_device, frame.performanceQueryPool, nullptr);
+    }
+
+    if (m_vkReleaseProfilingLockKHR != nullptr) {
+        m_vkReleaseProfilingLockKHR(m_device);
+    }
+
+    m_frames.clear();
+    m_vkReleaseProfilingLockKHR = nullptr;
+    m_device = VK_NULL_HANDLE;
+}
+
+bool GpuProfiler::isSupported(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex) {
+    auto physicalDeviceProperties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+    if (physicalDeviceProperties.limits.timestampPeriod <= 0.0f) {
+        return false;
+    }
+
+    return getTimestampValidBits(physicalDevice, queueFamilyIndex) > 0;
+}
+
+bool GpuProfiler::isPipelineStatisticsSupported(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex) {
+    auto supportedFeatures = VkPhysicalDeviceFeatures {};
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+    if (!supportedFeatures.pipelineStatisticsQuery || !supportedFeatures.inheritedQueries) {
+        return false;
+    }
+
+    // The vertex and fragment statistics are only counted on graphics queues.
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+    auto queueFamilies = std::vector<VkQueueFamilyProperties> { queueFamilyCount };
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    return queueFamilyIndex < queueFamilies.size() && (queueFamilies[queueFamilyIndex].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+}
+
+VkQueryPipelineStatisticFlags GpuProfiler::getPipelineStatistics() const {
+    return m_pipelineStatistics;
+}
+
+void GpuProfiler::resetFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+    if (frameIndex >= m_frames.size()) {
+        throw std::invalid_argument("frame index out of range!");
+    }
+
+    auto& frame = m_frames[frameIndex];
+    vkCmdResetQueryPool(commandBuffer, frame.queryPool, 0, 2 * m_maxScopesPerFrame);
+    if (frame.statisticsQueryPool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(commandBuffer, frame.statisticsQueryPool, 0, m_maxScopesPerFrame);
+    }
+    // Performance queries cannot be reset in the command buffer that runs them, so they are
+    // reset on the host, which the slot's finished submit allows.
+    if (frame.performanceQueryPool != VK_NULL_HANDLE) {
+        vkResetQueryPool(m_device, frame.performanceQueryPool, 0, m_maxScopesPerFrame);
+    }
+    frame.scopeNames.clear();
+    frame.counterScopes.clear();
+    frame.countingScope = NO_SCOPE;
+
+    m_recordingFrame = frameIndex;
+}
+
+uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const std::string& name) {
+    auto& frame = m_frames[m_recordingFrame];
+    if (frame.scopeNames.size() >= m_maxScopesPerFrame) {
+        throw std::logic_error("too many GPU profiler scopes in one frame!");
+    }
+
+    const auto scope = static_cast<uint32_t>(frame.scopeNames.size());
+    frame.scopeNames.push_back(name);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, 2 * scope);
+
+    const auto hasCounters = frame.statisticsQueryPool != VK_NULL_HANDLE || frame.performanceQueryPool != VK_NULL_HANDLE;
+    if (hasCounters && frame.countingScope == NO_SCOPE) {
+        const auto query = static_cast<uint32_t>(frame.counterScopes.size());
+        if (frame.statisticsQueryPool != VK_NULL_HANDLE) {
+            vkCmdBeginQuery(commandBuffer, frame.statisticsQueryPool, query, 0);
+        }
+        if (frame.performanceQueryPool != VK_NULL_HANDLE) {
+            vkCmdBeginQuery(commandBuffer, frame.performanceQueryPool, query, 0);
+        }
+        frame.counterScopes.push_back(scope);
+        frame.countingScope = scope;
+    }
+
+    return scope;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+    auto& frame = m_frames[m_recordingFrame];
+    if (frame.countingScope == scope) {
+        const auto query = static_cast<uint32_t>(frame.counterScopes.size() - 1);
+        if (frame.performanceQueryPool != VK_NULL_HANDLE) {
+            vkCmdEndQuery(commandBuffer, frame.performanceQueryPool, query);
+        }
+        if (frame.statisticsQueryPool != VK_NULL_HANDLE) {
+            vkCmdEndQuery(commandBuffer, frame.statisticsQueryPool, query);
+        }
+        frame.countingScope = NO_SCOPE;
+    }
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.queryPool, 2 * scope + 1);
+}
+
+void GpuProfiler::submitFrame(uint32_t frameIndex) {
+    m_frames[frameIndex].isSubmitted = true;
+}
+
+bool GpuProfiler::resolveFrame(uint32_t frameIndex) {
+    auto& frame = m_frames[frameIndex];
+    if (!frame.isSubmitted || frame.scopeNames.empty()) {
+        return false;
+    }
+
+    const auto queryCount = static_cast<uint32_t>(2 * frame.scopeNames.size());
+    auto timestamps = std::vector<uint64_t>(queryCount, 0);
+    const auto result = vkGetQueryPoolResults(
+        m_device,
+        frame.queryPool,
+        0,
+        queryCount,
+        timestamps.size() * sizeof(uint64_t),
+        timestamps.data(),
+        sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT
+    );
+    if (result == VK_NOT_READY) {
+        return false;
+    } else if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to read timestamp queries!");
+    }
+
+    auto counterValues = std::vector<double> {};
+    if (!this->readCounters(frame, counterValues)) {
+        return false;
+    }
+
+    frame.isSubmitted = false;
+
+    // The first scope of a frame starts it, and every timestamp is taken from there, which
+    // the mask keeps right across a wrap of the counter.
+    auto frameTicks = uint64_t { 0 };
+    for (size_t i = 0; i < frame.scopeNames.size(); i++) {
+        frameTicks = std::max(frameTicks, (timestamps[2 * i + 1] - timestamps[0]) & m_timestampMask);
+    }
+    m_latestFrameMilliseconds = static_cast<double>(frameTicks) * m_timestampPeriod / 1'000'000.0;
+
+    // Scopes that share a name in a frame add up to one sample, and so do their counters.
+    const auto counterCount = m_counters.size();
+    auto frameHistories = std::vector<ScopeHistory*> {};
+    auto frameMilliseconds = std::vector<double> {};
+    auto frameCounterValues = std::vector<std::vector<double>> {};
+    for (size_t i = 0; i < frame.scopeNames.size(); i++) {
+        const auto ticks = (timestamps[2 * i + 1] - timestamps[2 * i]) & m_timestampMask;
+        const auto milliseconds = static_cast<double>(ticks) * m_timestampPeriod / 1'000'000.0;
+
+        auto& history = this->getHistory(frame.scopeNames[i]);
+        auto it = std::find(frameHistories.begin(), frameHistories.end(), &history);
+        if (it != frameHistories.end()) {
+            frameMilliseconds[it - frameHistories.begin()] += milliseconds;
+        } else {
+            frameHistories.push_back(&history);
+            frameMilliseconds.push_back(milliseconds);
+            frameCounterValues.push_back(std::vector<double> {});
+            it = frameHistories.end() - 1;
+        }
+
+        const auto counterScope = std::find(frame.counterScopes.begin(), frame.counterScopes.end(), static_cast<uint32_t>(i));
+        if (counterScope != frame.counterScopes.end()) {
+            auto& values = frameCounterValues[it - frameHistories.begin()];
+            values.resize(counterCount, 0.0);
+            const auto* queryValues = counterValues.data() + (counterScope - frame.counterScopes.begin()) * counterCount;
+            for (size_t counter = 0; counter < counterCount; counter++) {
+                values[counter] += queryValues[counter];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < frameHistories.size(); i++) {
+        auto& milliseconds = frameHistories[i]->milliseconds;
+        if (milliseconds.size() >= HISTORY_LENGTH) {
+            milliseconds.pop_front();
+        }
+
+        milliseconds.push_back(frameMilliseconds[i]);
+
+        if (frameCounterValues[i].empty()) {
+            continue;
+        }
+
+        auto& historyCounterValues = frameHistories[i]->counterValues;
+        historyCounterValues.resize(counterCount);
+        for (size_t counter = 0; counter < counterCount; counter++) {
+            auto& values = historyCounterValues[counter];
+            if (values.size() >= HISTORY_LENGTH) {
+                values.pop_front();
+            }
+
+            values.push_back(frameCounterValues[i][counter]);
+        }
+    }
+
+    return true;
+}
+
+std::vector<GpuScopeStatistics> GpuProfiler::getStatistics() const {
+    auto statistics = std::vector<GpuScopeStatistics> {};
+    statistics.reserve(m_histories.size());
+    for (const auto& history : m_histories) {
+        if (history.milliseconds.empty()) {
+            continue;
+        }
+
+        const auto [minMilliseconds, maxMilliseconds] = std::minmax_element(history.milliseconds.begin(), history.milliseconds.end());
+        auto totalMilliseconds = 0.0;
+        for (const auto& milliseconds : history.milliseconds) {
+            totalMilliseconds += milliseconds;
+        }
+
+        auto counters = std::vector<GpuCounterStatistics> {};
+        for (size_t counter = 0; counter < history.counterValues.size(); counter++) {
+            const auto& values = history.counterValues[counter];
+            if (values.empty()) {
+                continue;
+            }
+
+            auto totalValue = 0.0;
+            for (const auto value : values) {
+                totalValue += value;
+            }
+
+            counters.push_back(GpuCounterStatistics {
+                .name = m_counters[counter].name,
+                .unit = m_counters[counter].unit,
+                .averageValue = totalValue / static_cast<double>(values.size()),
+            });
+        }
+
+        statistics.push_back(GpuScopeStatistics {
+            .name = history.name,
+            .minMilliseconds = *minMilliseconds,
+            .averageMilliseconds = totalMilliseconds / static_cast<double>(history.milliseconds.size()),
+            .maxMilliseconds = *maxMilliseconds,
+            .counters = std::move(counters),
+        });
+    }
+
+    return statistics;
+}
+
+void GpuProfiler::selectPerformanceCounters(VkInstance instance, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex) {
+    // The performance query commands are not exported by the loader.
+    const auto vkEnumerateCounters = reinterpret_cast<PFN_vkEnumeratePhysicalDeviceQueueFamilyPerformanceQueryCountersKHR>(
+        vkGetInstanceProcAddr(instance, "vkEnumeratePhysicalDeviceQueueFamilyPerformanceQueryCountersKHR")
+    );
+    const auto vkGetPassCount = reinterpret_cast<PFN_vkGetPhysicalDeviceQueueFamilyPerformanceQueryPassesKHR>(
+        vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceQueueFamilyPerformanceQueryPassesKHR")
+    );
+    const auto vkAcquireProfilingLock = reinterpret_cast<PFN_vkAcquireProfilingLockKHR>(
+        vkGetDeviceProcAddr(m_device, "vkAcquireProfilingLockKHR")
+    );
+    const auto vkReleaseProfilingLock = reinterpret_cast<PFN_vkReleaseProfilingLockKHR>(
+        vkGetDeviceProcAddr(m_device, "vkReleaseProfilingLockKHR")
+    );
+    if (vkEnumerateCounters == nullptr || vkGetPassCount == nullptr || vkAcquireProfilingLock == nullptr || vkReleaseProfilingLock == nullptr) {
+        return;
+    }
+
+    uint32_t counterCount = 0;
+    vkEnumerateCounters(physicalDevice, queueFamilyIndex, &counterCount, nullptr, nullptr);
+
+    auto counters = std::vector<VkPerformanceCounterKHR>(counterCount, VkPerformanceCounterKHR {
+        .sType = VK_STRUCTURE_TYPE_PERFORMANCE_COUNTER_KHR,
+        .pNext = nullptr,
+    });
+    auto descriptions = std::vector<VkPerformanceCounterDescriptionKHR>(counterCount, VkPerformanceCounterDescriptionKHR {
+        .sType = VK_STRUCTURE_TYPE_PERFORMANCE_COUNTER_DESCRIPTION_KHR,
+        .pNext = nullptr,
+    });
+    const auto resultEnumerate = vkEnumerateCounters(physicalDevice, queueFamilyIndex, &counterCount, counters.data(), descriptions.data());
+    if (resultEnumerate != VK_SUCCESS) {
+        return;
+    }
+
+    // A counter of a whole command buffer or render pass cannot be told apart by scope, and
+    // one that takes more passes would need every frame submitted more than once.
+    auto selectedCounters = std::vector<uint32_t> {};
+    for (uint32_t i = 0; i < counterCount && selectedCounters.size() < MAX_PERFORMANCE_COUNTERS; i++) {
+        if (counters[i].scope != VK_PERFORMANCE_COUNTER_SCOPE_COMMAND_KHR) {
+            continue;
+        }
+
+        selectedCounters.push_back(i);
+        const auto performanceQueryInfo = VkQueryPoolPerformanceCreateInfoKHR {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_PERFORMANCE_CREATE_INFO_KHR,
+            .pNext = nullptr,
+            .queueFamilyIndex = queueFamilyIndex,
+            .counterIndexCount = static_cast<uint32_t>(selectedCounters.size()),
+            .pCounterIndices = selectedCounters.data(),
+        };
+        uint32_t passCount = 0;
+        vkGetPassCount(physicalDevice, &performanceQueryInfo, &passCount);
+        if (passCount != 1) {
+            selectedCounters.pop_back();
+        }
+    }
+    if (selectedCounters.empty()) {
+        return;
+    }
+
+    // Another profiling tool may hold the lock, in which case the counters are left out
+    // rather than waited for.
+    const auto lockInfo = VkAcquireProfilingLockInfoKHR {
+        .sType = VK_STRUCTURE_TYPE_ACQUIRE_PROFILING_LOCK_INFO_KHR,
+        .pNext = nullptr,
+        .flags = 0,
+        .timeout = 0,
+    };
+    if (vkAcquireProfilingLock(m_device, &lockInfo) != VK_SUCCESS) {
+        return;
+    }
+
+    m_vkReleaseProfilingLockKHR = vkReleaseProfilingLock;
+    m_performanceCounterIndices = selectedCounters;
+    for (const auto counter : selectedCounters) {
+        m_counters.push_back(CounterDescription {
+            .name = descriptions[counter].name,
+            .unit = getCounterUnitName(counters[counter].unit),
+            .storage = counters[counter].storage,
+        });
+    }
+}
+
+VkQueryPool GpuProfiler::createQueryPool(VkQueryType queryType, uint32_t queueFamilyIndex) const {
+    const auto performanceQueryInfo = VkQueryPoolPerformanceCreateInfoKHR {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_PERFORMANCE_CREATE_INFO_KHR,
+        .pNext = nullptr,
+        .queueFamilyIndex = queueFamilyIndex,
+        .counterIndexCount = static_cast<uint32_t>(m_performanceCounterIndices.size()),
+        .pCounterIndices = m_performanceCounterIndices.data(),
+    };
+    // Every scope takes two timestamps, and at most one query of each other kind.
+    const auto queryPoolInfo = VkQueryPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = queryType == VK_QUERY_TYPE_PERFORMANCE_QUERY_KHR ? &performanceQueryInfo : nullptr,
+        .queryType = queryType,
+        .queryCount = queryType == VK_QUERY_TYPE_TIMESTAMP ? 2 * m_maxScopesPerFrame : m_maxScopesPerFrame,
+        .pipelineStatistics = queryType == VK_QUERY_TYPE_PIPELINE_STATISTICS ? m_pipelineStatistics : 0,
+    };
+
+    auto queryPool = VkQueryPool {};
+    const auto result = vkCreateQueryPool(m_device, &queryPoolInfo, nullptr, &queryPool);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create GPU profiler query pool!");
+    }
+
+    return queryPool;
+}
+
+bool GpuProfiler::readCounters(const FrameQueries& frame, std::vector<double>& values) const {
+    const auto queryCount = static_cast<uint32_t>(frame.counterScopes.size());
+    const auto counterCount = m_counters.size();
+    values.assign(queryCount * counterCount, 0.0);
+    if (queryCount == 0) {
+        return true;
+    }
+
+    // Every query holds the pipeline statistics first, then the performance counters.
+    const auto statisticCount = static_cast<size_t>(std::popcount(m_pipelineStatistics));
+    if (frame.statisticsQueryPool != VK_NULL_HANDLE) {
+        auto statistics = std::vector<uint64_t>(queryCount * statisticCount, 0);
+        const auto result = vkGetQueryPoolResults(
+            m_device,
+            frame.statisticsQueryPool,
+            0,
+            queryCount,
+            statistics.size() * sizeof(uint64_t),
+            statistics.data(),
+            statisticCount * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT
+        );
+        if (result == VK_NOT_READY) {
+            return false;
+        } else if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to read pipeline statistics queries!");
+        }
+
+        for (uint32_t query = 0; query < queryCount; query++) {
+            for (size_t statistic = 0; statistic < statisticCount; statistic++) {
+                values[query * counterCount + statistic] = static_cast<double>(statistics[query * statisticCount + statistic]);
+            }
+        }
+    }
+
+    if (frame.performanceQueryPool != VK_NULL_HANDLE) {
+        const auto performanceCounterCount = m_performanceCounterIndices.size();
+        auto results = std::vector<VkPerformanceCounterResultKHR>(queryCount * performanceCounterCount);
+        const auto result = vkGetQueryPoolResults(
+            m_device,
+            frame.performanceQueryPool,
+            0,
+            queryCount,
+            results.size() * sizeof(VkPerformanceCounterResultKHR),
+            results.data(),
+            performanceCounterCount * sizeof(VkPerformanceCounterResultKHR),
+            0
+        );
+        if (result == VK_NOT_READY) {
+            return false;
+        } else if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to read performance queries!");
+        }
+
+        for (uint32_t query = 0; query < queryCount; query++) {
+            for (size_t counter = 0; counter < performanceCounterCount; counter++) {
+                const auto& description = m_counters[statisticCount + counter];
+                values[query * counterCount + statisticCount + counter] = getCounterValue(
+                    results[query * performanceCounterCount + counter],
+                    description.storage
+                );
+            }
+        }
+    }
+
+    return true;
+}
+
+GpuProfiler::ScopeHistory& GpuProfiler::getHistory(const std::string& name) {
+    const auto it = std::find_if(m_histories.begin(), m_histories.end(), [&name](const ScopeHistory& history) {
+        return history.name == name;
+    });
+    if (it != m_histories.end()) {
+        return *it;
+    }
+
+    m_histories.push_back(ScopeHistory {
+        .name = name,
+        .milliseconds = std::deque<double> {},
+        .counterValues = std::vector<std::deque<double>> {},
+    });
+
+    return m_histories.back();
+}
+
+std::optional<double> GpuProfiler::getLatestMilliseconds(const std::string& name) const {
+    for (const auto& history : m_histories) {
+        if (history.name == name && !history.milliseconds.empty()) {
+            return history.milliseconds.back();
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::optional<double> GpuProfiler::getLatestFrameMilliseconds() const {
+    return m_latestFrameMilliseconds;
+}
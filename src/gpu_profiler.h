@@ -0,0 +1,188 @@
+#ifndef _GPU_PROFILER_H
+#define _GPU_PROFILER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief The average of a counter of a named scope over the frames the profiler
+/// remembers, in `unit`.
+struct GpuCounterStatistics final {
+    std::string name;
+    std::string unit;
+    double averageValue;
+};
+
+/// @brief The GPU time of a named scope over the frames the profiler remembers, and its
+/// counters, if they were collected for it.
+struct GpuScopeStatistics final {
+    std::string name;
+    double minMilliseconds;
+    double averageMilliseconds;
+    double maxMilliseconds;
+    std::vector<GpuCounterStatistics> counters;
+};
+
+/// @brief Times named scopes of command buffers on the GPU with timestamp queries, and
+/// counts what they did with pipeline statistics and performance queries.
+///
+/// @note Every frame slot has query pools of its own, so a frame writes its queries while
+/// the results of the frames before it are still waiting to be read. Results are read with
+/// `resolveFrame` once the slot's previous submit has finished, and without waiting, so
+/// profiling never stalls the CPU. Scopes of the same name in one frame add up to one
+/// sample, and the statistics cover the last `HISTORY_LENGTH` samples of every name.
+///
+/// The pipeline statistics are the vertex, clipping, fragment and compute counts that tell
+/// whether a pass is bound by its vertices or its fragments. The performance counters are
+/// the vendor's own, from `VK_KHR_performance_query`, like the memory traffic that tells
+/// whether it is bound by bandwidth. Only the counters that are per command and fit in a
+/// single pass are collected, and the device's profiling lock is held for as long as the
+/// profiler lives. Queries of one kind cannot nest, so a scope that begins inside another
+/// has no counters of its own, and its work counts toward the outer scope.
+///
+/// A frame slot is not tied to the frame loop. Any command buffer on the profiled queue
+/// family can take a slot of its own, like an upload batch does.
+class GpuProfiler final {
+    public:
+        static constexpr uint32_t DEFAULT_MAX_SCOPES_PER_FRAME = 16;
+        static constexpr size_t HISTORY_LENGTH = 120;
+        static constexpr uint32_t MAX_PERFORMANCE_COUNTERS = 8;
+        static constexpr VkQueryPipelineStatisticFlags PIPELINE_STATISTICS =
+            VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+            | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT
+            | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+            | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT
+            | VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+        explicit GpuProfiler() = delete;
+        /// @brief Profile the queues of `queueFamilyIndex`, with pipeline statistics when
+        /// `collectPipelineStatistics`, and performance counters when
+        /// `collectPerformanceCounters` and the device has any that can be collected.
+        ///
+        /// @note Secondary command buffers have no way to inherit performance queries, so
+        /// they must not run inside a scope with performance counters.
+        explicit GpuProfiler(
+            VkInstance instance,
+            VkPhysicalDevice physicalDevice,
+            VkDevice device,
+            uint32_t queueFamilyIndex,
+            uint32_t frameCount,
+            bool collectPipelineStatistics = false,
+            bool collectPerformanceCounters = false,
+            uint32_t maxScopesPerFrame = DEFAULT_MAX_SCOPES_PER_FRAME
+        );
+
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler& other) = delete;
+        GpuProfiler& operator=(const GpuProfiler& other) = delete;
+
+        /// @brief Whether the queues of `queueFamilyIndex` write timestamps.
+        static bool isSupported(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex);
+
+        /// @brief Whether the queues of `queueFamilyIndex` run pipeline statistics queries,
+        /// and secondary command buffers can run inside them.
+        ///
+        /// @note The features this takes are enabled wherever the device has them.
+        static bool isPipelineStatisticsSupported(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex);
+
+        /// @brief The pipeline statistics the scopes count, which secondary command buffers
+        /// that run inside a scope inherit, or none without pipeline statistics.
+        VkQueryPipelineStatisticFlags getPipelineStatistics() const;
+
+        /// @brief Start recording the scopes of a frame slot into `commandBuffer`.
+        ///
+        /// @note This resets the slot's queries, so it is recorded outside of any render
+        /// pass, and only once the slot's previous results have been resolved.
+        void resetFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+        /// @brief Write the starting timestamp of a scope of the frame being recorded.
+        uint32_t beginScope(VkCommandBuffer commandBuffer, const std::string& name);
+
+        void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+        /// @brief Note that the commands of a frame slot were submitted, so that its results
+        /// are read once.
+        void submitFrame(uint32_t frameIndex);
+
+        /// @brief Read the results of a frame slot's last submit, if it has one that has not
+        /// been read yet.
+        ///
+        /// @note The submit has to have finished. Results that are not ready are left for
+        /// the next call rather than waited for. Returns whether there were results to read.
+        bool resolveFrame(uint32_t frameIndex);
+
+        std::vector<GpuScopeStatistics> getStatistics() const;
+
+        /// @brief The GPU time of the scope `name` in the last frame resolved with it, if
+        /// any was.
+        std::optional<double> getLatestMilliseconds(const std::string& name) const;
+
+        /// @brief The GPU time from the start of the first scope to the end of the last one
+        /// in the last frame resolved, if any was.
+        std::optional<double> getLatestFrameMilliseconds() const;
+    private:
+        static constexpr uint32_t NO_SCOPE = UINT32_MAX;
+
+        struct FrameQueries final {
+            VkQueryPool queryPool;
+            VkQueryPool statisticsQueryPool;
+            VkQueryPool performanceQueryPool;
+            std::vector<std::string> scopeNames;
+            /// @brief The scope of every counter query, in the order of the queries.
+            std::vector<uint32_t> counterScopes;
+            /// @brief The scope whose counter queries are active, if any.
+            uint32_t countingScope;
+            bool isSubmitted;
+        };
+
+        struct CounterDescription final {
+            std::string name;
+            std::string unit;
+            VkPerformanceCounterStorageKHR storage;
+        };
+
+        struct ScopeHistory final {
+            std::string name;
+            std::deque<double> milliseconds;
+            /// @brief The samples of every counter, for the frames the scope had counters.
+            std::vector<std::deque<double>> counterValues;
+        };
+
+        VkDevice m_device;
+        double m_timestampPeriod;
+        uint64_t m_timestampMask;
+        uint32_t m_maxScopesPerFrame;
+        VkQueryPipelineStatisticFlags m_pipelineStatistics;
+        /// @brief The pipeline statistics first, then the performance counters.
+        std::vector<CounterDescription> m_counters;
+        std::vector<uint32_t> m_performanceCounterIndices;
+        std::vector<FrameQueries> m_frames;
+        uint32_t m_recordingFrame;
+        std::vector<ScopeHistory> m_histories;
+        std::optional<double> m_latestFrameMilliseconds;
+        PFN_vkReleaseProfilingLockKHR m_vkReleaseProfilingLockKHR;
+
+        /// @brief Pick the performance counters to collect, and take the profiling lock,
+        /// leaving the profiler without them if either fails.
+        void selectPerformanceCounters(VkInstance instance, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex);
+
+        VkQueryPool createQueryPool(VkQueryType queryType, uint32_t queueFamilyIndex) const;
+
+        /// @brief Read the counters of the counted scopes of `frame` into `values`, one run
+        /// of counters per counter query, or return false if they are not ready.
+        bool readCounters(const FrameQueries& frame, std::vector<double>& values) const;
+
+        ScopeHistory& getHistory(const std::string& name);
+};
+
+}
+
+#endif // _GPU_PROFILER_H
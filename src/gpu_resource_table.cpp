@@ -0,0 +1,231 @@
+#include "gpu_resource_table.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+
+using GpuResourceTable = VulkanEngine::GpuResourceTable;
+using GpuBufferHandle = VulkanEngine::GpuBufferHandle;
+using GpuImageHandle = VulkanEngine::GpuImageHandle;
+using GpuTimelineValue = VulkanEngine::GpuTimelineValue;
+
+template <typename Resource>
+static uint32_t takeSlot(std::vector<Resource>& slots, std::vector<uint32_t>& freeSlots) {
+    if (!freeSlots.empty()) {
+        const auto index = freeSlots.back();
+        freeSlots.pop_back();
+
+        return index;
+    }
+
+    slots.push_back(Resource {});
+
+    return static_cast<uint32_t>(slots.size() - 1);
+}
+
+GpuResourceTable::GpuResourceTable(VkDevice device, GpuMemoryAllocator& allocator)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_bufferSlots {}
+    , m_freeBufferSlots {}
+    , m_imageSlots {}
+    , m_freeImageSlots {}
+    , m_queuedDestructions {}
+{
+}
+
+GpuResourceTable::~GpuResourceTable() {
+    this->destroyQueued();
+
+    for (const auto& slot : m_bufferSlots) {
+        if (slot.isLive) {
+            vkDestroyBuffer(m_device, slot.resource, nullptr);
+            m_allocator.free(slot.allocation);
+        }
+    }
+
+    for (const auto& slot : m_imageSlots) {
+        if (slot.isLive) {
+            vkDestroyImage(m_device, slot.resource, nullptr);
+            m_allocator.free(slot.allocation);
+        }
+    }
+
+    m_bufferSlots.clear();
+    m_imageSlots.clear();
+    m_device = VK_NULL_HANDLE;
+}
+
+GpuBufferHandle GpuResourceTable::addBuffer(VkBuffer buffer, const GpuAllocation& allocation) {
+    const auto index = takeSlot(m_bufferSlots, m_freeBufferSlots);
+    auto& slot = m_bufferSlots[index];
+    slot.resource = buffer;
+    slot.allocation = allocation;
+    slot.isLive = true;
+
+    return GpuBufferHandle { .index = index, .generation = slot.generation };
+}
+
+GpuImageHandle GpuResourceTable::addImage(VkImage image, const GpuAllocation& allocation) {
+    const auto index = takeSlot(m_imageSlots, m_freeImageSlots);
+    auto& slot = m_imageSlots[index];
+    slot.resource = image;
+    slot.allocation = allocation;
+    slot.isLive = true;
+
+    return GpuImageHandle { .index = index, .generation = slot.generation };
+}
+
+bool GpuResourceTable::isValid(GpuBufferHandle handle) const {
+    if (handle.index >= m_bufferSlots.size()) {
+        return false;
+    }
+
+    const auto& slot = m_bufferSlots[handle.index];
+
+    return slot.isLive && slot.generation == handle.generation;
+}
+
+bool GpuResourceTable::isValid(GpuImageHandle handle) const {
+    if (handle.index >= m_imageSlots.size()) {
+        return false;
+    }
+
+    const auto& slot = m_imageSlots[handle.index];
+
+    return slot.isLive && slot.generation == handle.generation;
+}
+
+VkBuffer GpuResourceTable::getBuffer(GpuBufferHandle handle) const {
+    return this->getSlot(handle).resource;
+}
+
+const VulkanEngine::GpuAllocation& GpuResourceTable::getAllocation(GpuBufferHandle handle) const {
+    return this->getSlot(handle).allocation;
+}
+
+VkImage GpuResourceTable::getImage(GpuImageHandle handle) const {
+    return this->getSlot(handle).resource;
+}
+
+const VulkanEngine::GpuAllocation& GpuResourceTable::getAllocation(GpuImageHandle handle) const {
+    return this->getSlot(handle).allocation;
+}
+
+void GpuResourceTable::replaceBuffer(GpuBufferHandle handle, VkBuffer buffer, const GpuAllocation& allocation, const GpuTimelineValue& retireAfter) {
+    const auto& oldSlot = this->getSlot(handle);
+    m_queuedDestructions.push_back(QueuedDestruction {
+        .buffer = oldSlot.resource,
+        .image = VK_NULL_HANDLE,
+        .allocation = oldSlot.allocation,
+        .retireAfter = retireAfter,
+    });
+
+    auto& slot = m_bufferSlots[handle.index];
+    slot.resource = buffer;
+    slot.allocation = allocation;
+}
+
+void GpuResourceTable::destroyBuffer(GpuBufferHandle handle, const GpuTimelineValue& retireAfter) {
+    const auto& oldSlot = this->getSlot(handle);
+    m_queuedDestructions.push_back(QueuedDestruction {
+        .buffer = oldSlot.resource,
+        .image = VK_NULL_HANDLE,
+        .allocation = oldSlot.allocation,
+        .retireAfter = retireAfter,
+    });
+
+    auto& slot = m_bufferSlots[handle.index];
+    slot.resource = VK_NULL_HANDLE;
+    slot.allocation = GpuAllocation {};
+    slot.generation++;
+    slot.isLive = false;
+    m_freeBufferSlots.push_back(handle.index);
+}
+
+void GpuResourceTable::destroyImage(GpuImageHandle handle, const GpuTimelineValue& retireAfter) {
+    const auto& oldSlot = this->getSlot(handle);
+    m_queuedDestructions.push_back(QueuedDestruction {
+        .buffer = VK_NULL_HANDLE,
+        .image = oldSlot.resource,
+        .allocation = oldSlot.allocation,
+        .retireAfter = retireAfter,
+    });
+
+    auto& slot = m_imageSlots[handle.index];
+    slot.resource = VK_NULL_HANDLE;
+    slot.allocation = GpuAllocation {};
+    slot.generation++;
+    slot.isLive = false;
+    m_freeImageSlots.push_back(handle.index);
+}
+
+void GpuResourceTable::collect() {
+    if (m_queuedDestructions.empty()) {
+        return;
+    }
+
+    // Every semaphore is read once, however many resources wait on it.
+    auto completedValues = std::unordered_map<VkSemaphore, uint64_t> {};
+    for (const auto& destruction : m_queuedDestructions) {
+        const auto timelineSemaphore = destruction.retireAfter.timelineSemaphore;
+        if (!completedValues.contains(timelineSemaphore)) {
+            auto completedValue = uint64_t { 0 };
+            vkGetSemaphoreCounterValue(m_device, timelineSemaphore, &completedValue);
+            completedValues[timelineSemaphore] = completedValue;
+        }
+    }
+
+    const auto isRetired = [this, &completedValues](const QueuedDestruction& destruction) {
+        if (destruction.retireAfter.value > completedValues[destruction.retireAfter.timelineSemaphore]) {
+            return false;
+        }
+
+        this->destroy(destruction);
+
+        return true;
+    };
+
+    std::erase_if(m_queuedDestructions, isRetired);
+}
+
+void GpuResourceTable::destroyQueued() {
+    for (const auto& destruction : m_queuedDestructions) {
+        this->destroy(destruction);
+    }
+
+    m_queuedDestructions.clear();
+}
+
+size_t GpuResourceTable::getQueuedDestructionCount() const {
+    return m_queuedDestructions.size();
+}
+
+const GpuResourceTable::Slot<VkBuffer>& GpuResourceTable::getSlot(GpuBufferHandle handle) const {
+    if (!this->isValid(handle)) {
+        throw std::invalid_argument("unknown buffer handle!");
+    }
+
+    return m_bufferSlots[handle.index];
+}
+
+const GpuResourceTable::Slot<VkImage>& GpuResourceTable::getSlot(GpuImageHandle handle) const {
+    if (!this->isValid(handle)) {
+        throw std::invalid_argument("unknown image handle!");
+    }
+
+    return m_imageSlots[handle.index];
+}
+
+void GpuResourceTable::destroy(const QueuedDestruction& destruction) {
+    if (destruction.buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(m_device, destruction.buffer, nullptr);
+    }
+
+    if (destruction.image != VK_NULL_HANDLE) {
+        vkDestroyImage(m_device, destruction.image, nullptr);
+    }
+
+    m_allocator.free(destruction.allocation);
+}
@@ -0,0 +1,130 @@
+#ifndef _GPU_RESOURCE_TABLE_H
+#define _GPU_RESOURCE_TABLE_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief Refers to a resource of a `GpuResourceTable` by its slot, and the generation of
+/// the resource that holds the slot.
+///
+/// @note Destroying a resource moves its slot to the next generation, so a handle that
+/// outlives its resource is caught rather than reaching whatever takes the slot next.
+template <typename Tag>
+struct GpuResourceHandle final {
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool operator==(const GpuResourceHandle& other) const = default;
+};
+
+using GpuBufferHandle = GpuResourceHandle<struct GpuBufferTag>;
+using GpuImageHandle = GpuResourceHandle<struct GpuImageTag>;
+
+/// @brief A value of a timeline semaphore, like the submit count of a frame on the frame
+/// timeline or the value of an upload batch on the upload timeline.
+struct GpuTimelineValue final {
+    VkSemaphore timelineSemaphore;
+    uint64_t value;
+};
+
+/// @brief Owns buffers and images behind generational handles, and destroys them once the
+/// GPU is done with them.
+///
+/// @note Destroying a resource invalidates its handle at once, but only queues the resource
+/// itself until a timeline semaphore reaches the value the caller names, like the submit
+/// count of the last frame that may use it. `collect` destroys the resources whose values
+/// have been reached, so resources can go mid-session without idling the device. A buffer
+/// can also be replaced behind its handle, which queues the old buffer the same way and
+/// keeps the handle valid.
+class GpuResourceTable final {
+    public:
+        explicit GpuResourceTable() = delete;
+        explicit GpuResourceTable(VkDevice device, GpuMemoryAllocator& allocator);
+
+        /// @brief Destroy every resource, whether it was queued or not.
+        ///
+        /// @note The device has to be idle.
+        ~GpuResourceTable();
+
+        GpuResourceTable(const GpuResourceTable& other) = delete;
+        GpuResourceTable& operator=(const GpuResourceTable& other) = delete;
+
+        GpuBufferHandle addBuffer(VkBuffer buffer, const GpuAllocation& allocation);
+
+        GpuImageHandle addImage(VkImage image, const GpuAllocation& allocation);
+
+        bool isValid(GpuBufferHandle handle) const;
+
+        bool isValid(GpuImageHandle handle) const;
+
+        VkBuffer getBuffer(GpuBufferHandle handle) const;
+
+        const GpuAllocation& getAllocation(GpuBufferHandle handle) const;
+
+        VkImage getImage(GpuImageHandle handle) const;
+
+        const GpuAllocation& getAllocation(GpuImageHandle handle) const;
+
+        /// @brief Put another buffer behind `handle`, and destroy the old one once `retireAfter`
+        /// has been reached.
+        void replaceBuffer(GpuBufferHandle handle, VkBuffer buffer, const GpuAllocation& allocation, const GpuTimelineValue& retireAfter);
+
+        void destroyBuffer(GpuBufferHandle handle, const GpuTimelineValue& retireAfter);
+
+        void destroyImage(GpuImageHandle handle, const GpuTimelineValue& retireAfter);
+
+        /// @brief Destroy the queued resources whose timeline values have been reached.
+        void collect();
+
+        /// @brief Destroy every queued resource, whether its timeline value has been reached
+        /// or not.
+        ///
+        /// @note The device has to be idle, like before a timeline semaphore that resources wait
+        /// on is destroyed.
+        void destroyQueued();
+
+        size_t getQueuedDestructionCount() const;
+    private:
+        template <typename Resource>
+        struct Slot final {
+            Resource resource;
+            GpuAllocation allocation;
+            uint32_t generation;
+            bool isLive;
+        };
+
+        struct QueuedDestruction final {
+            VkBuffer buffer;
+            VkImage image;
+            GpuAllocation allocation;
+            GpuTimelineValue retireAfter;
+        };
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        std::vector<Slot<VkBuffer>> m_bufferSlots;
+        std::vector<uint32_t> m_freeBufferSlots;
+        std::vector<Slot<VkImage>> m_imageSlots;
+        std::vector<uint32_t> m_freeImageSlots;
+        std::vector<QueuedDestruction> m_queuedDestructions;
+
+        const Slot<VkBuffer>& getSlot(GpuBufferHandle handle) const;
+
+        const Slot<VkImage>& getSlot(GpuImageHandle handle) const;
+
+        void destroy(const QueuedDestruction& destruction);
+};
+
+}
+
+#endif // _GPU_RESOURCE_TABLE_H
@@ -0,0 +1,173 @@
+#include "graphics_pipeline_library.h"
+
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+
+using GraphicsPipelineLibrary = VulkanEngine::GraphicsPipelineLibrary;
+using GraphicsPipelinePart = VulkanEngine::GraphicsPipelinePart;
+using GraphicsPipelinePartKeys = VulkanEngine::GraphicsPipelinePartKeys;
+
+static VkGraphicsPipelineLibraryFlagsEXT getLibraryFlags(GraphicsPipelinePart part) {
+    switch (part) {
+        case GraphicsPipelinePart::VertexInput:
+            return VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+        case GraphicsPipelinePart::PreRasterization:
+            return VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+        case GraphicsPipelinePart::FragmentShader:
+            return VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+        case GraphicsPipelinePart::FragmentOutput:
+            return VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+    }
+
+    throw std::invalid_argument("unknown graphics pipeline part!");
+}
+
+/// @brief Whether the shader stage `stage` is compiled into the part `part`.
+static bool isStageInPart(VkShaderStageFlagBits stage, GraphicsPipelinePart part) {
+    if (part == GraphicsPipelinePart::PreRasterization) {
+        return stage != VK_SHADER_STAGE_FRAGMENT_BIT;
+    } else if (part == GraphicsPipelinePart::FragmentShader) {
+        return stage == VK_SHADER_STAGE_FRAGMENT_BIT;
+    } else {
+        return false;
+    }
+}
+
+GraphicsPipelineLibrary::GraphicsPipelineLibrary(VkDevice device, bool isLinkOptimized)
+    : m_device { device }
+    , m_isLinkOptimized { isLinkOptimized }
+    , m_parts {}
+{
+}
+
+GraphicsPipelineLibrary::~GraphicsPipelineLibrary() {
+    for (const auto& [key, part] : m_parts) {
+        vkDestroyPipeline(m_device, part.pipeline, nullptr);
+    }
+
+    m_parts.clear();
+    m_device = VK_NULL_HANDLE;
+}
+
+VkPipeline GraphicsPipelineLibrary::getPart(
+    VkPipelineCache pipelineCache,
+    const VkGraphicsPipelineCreateInfo& pipelineInfo,
+    GraphicsPipelinePart part,
+    uint64_t key
+) {
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        const auto found = m_parts.find(std::make_tuple(part, key));
+        if (found != m_parts.end()) {
+            return found->second.pipeline;
+        }
+    }
+
+    // The state outside the part is ignored, so the part is built from the whole create
+    // info, with only the stages it compiles.
+    auto stages = std::vector<VkPipelineShaderStageCreateInfo> {};
+    for (uint32_t i = 0; i < pipelineInfo.stageCount; i++) {
+        if (isStageInPart(pipelineInfo.pStages[i].stage, part)) {
+            stages.push_back(pipelineInfo.pStages[i]);
+        }
+    }
+
+    const auto libraryInfo = VkGraphicsPipelineLibraryCreateInfoEXT {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+        .pNext = pipelineInfo.pNext,
+        .flags = getLibraryFlags(part),
+    };
+    auto partInfo = pipelineInfo;
+    partInfo.pNext = &libraryInfo;
+    partInfo.flags = pipelineInfo.flags | VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+    partInfo.stageCount = static_cast<uint32_t>(stages.size());
+    partInfo.pStages = stages.data();
+
+    auto pipeline = VkPipeline {};
+    const auto result = vkCreateGraphicsPipelines(m_device, pipelineCache, 1, &partInfo, nullptr, &pipeline);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create graphics pipeline library part!");
+    }
+
+    const auto lock = std::lock_guard<std::mutex> { m_mutex };
+    const auto [found, isInserted] = m_parts.try_emplace(
+        std::make_tuple(part, key),
+        Part { .pipeline = pipeline, .renderPass = pipelineInfo.renderPass }
+    );
+    if (!isInserted) {
+        vkDestroyPipeline(m_device, pipeline, nullptr);
+    }
+
+    return found->second.pipeline;
+}
+
+VkPipeline GraphicsPipelineLibrary::createPipeline(
+    VkPipelineCache pipelineCache,
+    const VkGraphicsPipelineCreateInfo& pipelineInfo,
+    const GraphicsPipelinePartKeys& partKeys,
+    bool isOptimized
+) {
+    if ((pipelineInfo.flags & VK_PIPELINE_CREATE_LIBRARY_BIT_KHR) != 0 || pipelineInfo.basePipelineHandle != VK_NULL_HANDLE) {
+        throw std::invalid_argument("pipeline library can only link whole pipelines that derive from none!");
+    }
+
+    const auto parts = std::array<VkPipeline, 4> {
+        this->getPart(pipelineCache, pipelineInfo, GraphicsPipelinePart::VertexInput, partKeys.vertexInput),
+        this->getPart(pipelineCache, pipelineInfo, GraphicsPipelinePart::PreRasterization, partKeys.preRasterization),
+        this->getPart(pipelineCache, pipelineInfo, GraphicsPipelinePart::FragmentShader, partKeys.fragmentShader),
+        this->getPart(pipelineCache, pipelineInfo, GraphicsPipelinePart::FragmentOutput, partKeys.fragmentOutput),
+    };
+    const auto linkInfo = VkPipelineLibraryCreateInfoKHR {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+        .pNext = nullptr,
+        .libraryCount = static_cast<uint32_t>(parts.size()),
+        .pLibraries = parts.data(),
+    };
+    const auto linkFlags = m_isLinkOptimized || isOptimized ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+    const auto linkedPipelineInfo = VkGraphicsPipelineCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &linkInfo,
+        .flags = pipelineInfo.flags | linkFlags,
+        .layout = pipelineInfo.layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+
+    auto pipeline = VkPipeline {};
+    const auto result = vkCreateGraphicsPipelines(m_device, pipelineCache, 1, &linkedPipelineInfo, nullptr, &pipeline);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to link graphics pipeline!");
+    }
+
+    return pipeline;
+}
+
+void GraphicsPipelineLibrary::evictParts(VkRenderPass renderPass) {
+    if (renderPass == VK_NULL_HANDLE) {
+        return;
+    }
+
+    const auto lock = std::lock_guard<std::mutex> { m_mutex };
+    std::erase_if(m_parts, [this, renderPass](const auto& entry) {
+        const auto& [key, part] = entry;
+        if (part.renderPass != renderPass) {
+            return false;
+        }
+
+        vkDestroyPipeline(m_device, part.pipeline, nullptr);
+
+        return true;
+    });
+}
+
+bool GraphicsPipelineLibrary::isLinkOptimized() const {
+    return m_isLinkOptimized;
+}
+
+size_t GraphicsPipelineLibrary::getPartCount() const {
+    const auto lock = std::lock_guard<std::mutex> { m_mutex };
+
+    return m_parts.size();
+}
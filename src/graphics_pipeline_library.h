@@ -0,0 +1,107 @@
+#ifndef _GRAPHICS_PIPELINE_LIBRARY_H
+#define _GRAPHICS_PIPELINE_LIBRARY_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+
+namespace VulkanEngine {
+
+/// @brief The four parts `VK_EXT_graphics_pipeline_library` splits a graphics pipeline into.
+enum class GraphicsPipelinePart : uint32_t {
+    VertexInput = 0,
+    PreRasterization = 1,
+    FragmentShader = 2,
+    FragmentOutput = 3,
+};
+
+/// @brief The keys of the parts of a graphics pipeline, one for the state of each part.
+///
+/// @note Two pipelines whose parts have the same key share the part, so a key has to cover
+/// everything its part is built from: the shaders, the fixed-function state of the part,
+/// the pipeline layout and the attachments. The layout and the render pass may go into the
+/// key as handles, as long as the layout outlives the library and the parts of a render
+/// pass are evicted when it is destroyed, so that a handle reused for another object never
+/// finds the parts of the old one.
+struct GraphicsPipelinePartKeys final {
+    uint64_t vertexInput = 0;
+    uint64_t preRasterization = 0;
+    uint64_t fragmentShader = 0;
+    uint64_t fragmentOutput = 0;
+};
+
+/// @brief Builds graphics pipelines by linking parts with `VK_EXT_graphics_pipeline_library`,
+/// compiling each part only the first time its key is asked for.
+///
+/// @note A pipeline is described by the create info it would be built from in one piece,
+/// and every part is created from that create info with the shader stages of the part. A
+/// pipeline that only changes some of its parts, like one with a reloaded fragment shader,
+/// compiles those parts and links against the cached rest, which takes a fraction of a
+/// full build. Without optimized links, pipelines link without running the optimizer over
+/// the whole pipeline again, and may run a little slower than pipelines built in one piece.
+/// Parts always keep what the optimizer needs, so a fast link can be followed by an
+/// optimized one of the same pipeline that replaces it once it is ready.
+///
+/// Pipelines are built concurrently on the compiler workers, so parts are cached under a
+/// lock and two builds racing for the same part keep the first one. The cache owns its
+/// parts and destroys them with itself; linked pipelines belong to the caller, and stay
+/// valid without their parts. Parts are only evicted with their render pass.
+class GraphicsPipelineLibrary final {
+    public:
+        explicit GraphicsPipelineLibrary() = delete;
+        explicit GraphicsPipelineLibrary(VkDevice device, bool isLinkOptimized);
+
+        ~GraphicsPipelineLibrary();
+
+        GraphicsPipelineLibrary(const GraphicsPipelineLibrary& other) = delete;
+        GraphicsPipelineLibrary& operator=(const GraphicsPipelineLibrary& other) = delete;
+
+        /// @brief Link the pipeline `pipelineInfo` describes out of the parts of `partKeys`,
+        /// building the parts that are not cached yet.
+        ///
+        /// @note `pipelineInfo` must not already be a library or link libraries, and must
+        /// not derive from another pipeline. The link is optimized when `isOptimized` is
+        /// set, or when every link of the library is.
+        VkPipeline createPipeline(
+            VkPipelineCache pipelineCache,
+            const VkGraphicsPipelineCreateInfo& pipelineInfo,
+            const GraphicsPipelinePartKeys& partKeys,
+            bool isOptimized = false
+        );
+
+        /// @brief Destroy the parts built against `renderPass`, before it is destroyed.
+        ///
+        /// @note No build against the render pass may still be running.
+        void evictParts(VkRenderPass renderPass);
+
+        /// @brief Whether every link runs the optimizer over the whole pipeline.
+        bool isLinkOptimized() const;
+
+        size_t getPartCount() const;
+    private:
+        struct Part final {
+            VkPipeline pipeline;
+            VkRenderPass renderPass;
+        };
+
+        VkDevice m_device;
+        bool m_isLinkOptimized;
+        mutable std::mutex m_mutex;
+        std::map<std::tuple<GraphicsPipelinePart, uint64_t>, Part> m_parts;
+
+        /// @brief The cached part `part` with key `key`, or one built from `pipelineInfo`.
+        VkPipeline getPart(
+            VkPipelineCache pipelineCache,
+            const VkGraphicsPipelineCreateInfo& pipelineInfo,
+            GraphicsPipelinePart part,
+            uint64_t key
+        );
+};
+
+}
+
+#endif // _GRAPHICS_PIPELINE_LIBRARY_H
@@ -0,0 +1,307 @@
+#include "host_allocator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#include <fmt/core.h>
+
+
+using HostAllocator = VulkanEngine::HostAllocator;
+using HostAllocatorStatistics = VulkanEngine::HostAllocatorStatistics;
+
+static double toKibibytes(size_t bytes) {
+    return static_cast<double>(bytes) / 1024.0;
+}
+
+static const char* getAllocationScopeName(size_t scope) {
+    switch (static_cast<VkSystemAllocationScope>(scope)) {
+        case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND: return "Command";
+        case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT: return "Object";
+        case VK_SYSTEM_ALLOCATION_SCOPE_CACHE: return "Cache";
+        case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE: return "Device";
+        case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE: return "Instance";
+        default: return "Unknown";
+    }
+}
+
+HostAllocator::HostAllocator()
+    : m_callbacks {}
+    , m_pools {}
+    , m_statisticsMutex {}
+    , m_scopeStatistics {}
+    , m_chunkCount { 0 }
+    , m_chunkBytes { 0 }
+    , m_pooledAllocationCount { 0 }
+    , m_largeAllocationCount { 0 }
+{
+    m_callbacks = VkAllocationCallbacks {
+        .pUserData = this,
+        .pfnAllocation = HostAllocator::allocationCallback,
+        .pfnReallocation = HostAllocator::reallocationCallback,
+        .pfnFree = HostAllocator::freeCallback,
+        .pfnInternalAllocation = HostAllocator::internalAllocationCallback,
+        .pfnInternalFree = HostAllocator::internalFreeCallback,
+    };
+}
+
+HostAllocator::~HostAllocator() {
+    for (auto& pool : m_pools) {
+        for (auto* chunk : pool.chunks) {
+            ::operator delete(chunk, std::align_val_t { POOL_ALIGNMENT });
+        }
+
+        pool.chunks.clear();
+        pool.freeSlots = nullptr;
+    }
+
+    m_chunkCount = 0;
+    m_chunkBytes = 0;
+}
+
+const VkAllocationCallbacks* HostAllocator::getCallbacks() const {
+    return &m_callbacks;
+}
+
+HostAllocatorStatistics HostAllocator::getStatistics() const {
+    const auto lock = std::lock_guard<std::mutex> { m_statisticsMutex };
+
+    return HostAllocatorStatistics {
+        .scopes = m_scopeStatistics,
+        .chunkCount = m_chunkCount,
+        .chunkBytes = m_chunkBytes,
+        .pooledAllocationCount = m_pooledAllocationCount,
+        .largeAllocationCount = m_largeAllocationCount,
+    };
+}
+
+void HostAllocator::printReport() const {
+    const auto statistics = this->getStatistics();
+    fmt::println("{:<10}  {:>10}  {:>8}  {:>10}  {:>12}", "Scope", "KiB", "Count", "Peak KiB", "Internal KiB");
+    for (size_t i = 0; i < statistics.scopes.size(); i++) {
+        const auto& scopeStatistics = statistics.scopes[i];
+        fmt::println(
+            "{:<10}  {:>10.1f}  {:>8}  {:>10.1f}  {:>12.1f}",
+            getAllocationScopeName(i),
+            toKibibytes(scopeStatistics.bytes),
+            scopeStatistics.allocationCount,
+            toKibibytes(scopeStatistics.peakBytes),
+            toKibibytes(scopeStatistics.internalBytes)
+        );
+    }
+    fmt::println(
+        "{} pool chunks, {:.1f} KiB pooled, {} pooled allocations, {} large allocations",
+        statistics.chunkCount,
+        toKibibytes(statistics.chunkBytes),
+        statistics.pooledAllocationCount,
+        statistics.largeAllocationCount
+    );
+}
+
+size_t HostAllocator::selectPool(size_t size) {
+    auto poolIndex = size_t { 0 };
+    while ((MIN_POOLED_SIZE << poolIndex) < size) {
+        poolIndex++;
+    }
+
+    return poolIndex;
+}
+
+size_t HostAllocator::getSlotSize(size_t poolIndex) {
+    return sizeof(Header) + (MIN_POOLED_SIZE << poolIndex);
+}
+
+void* HostAllocator::allocate(size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    if (size == 0) {
+        return nullptr;
+    }
+
+    auto* header = static_cast<Header*>(nullptr);
+    const auto isPooled = size <= MAX_POOLED_SIZE && alignment <= POOL_ALIGNMENT;
+    if (isPooled) {
+        header = static_cast<Header*>(this->allocateSlot(HostAllocator::selectPool(size)));
+        if (header == nullptr) {
+            return nullptr;
+        }
+
+        *header = Header { .size = size, .scope = static_cast<uint32_t>(scope), .alignment = 0 };
+    } else {
+        // The header takes a whole alignment in front of the allocation, so that the
+        // allocation itself stays aligned.
+        const auto largeAlignment = std::max(alignment, POOL_ALIGNMENT);
+        auto* base = static_cast<std::byte*>(
+            ::operator new(largeAlignment + size, std::align_val_t { largeAlignment }, std::nothrow)
+        );
+        if (base == nullptr) {
+            return nullptr;
+        }
+
+        header = reinterpret_cast<Header*>(base + largeAlignment) - 1;
+        *header = Header {
+            .size = size,
+            .scope = static_cast<uint32_t>(scope),
+            .alignment = static_cast<uint32_t>(largeAlignment),
+        };
+    }
+
+    this->recordAllocation(size, header->scope, isPooled);
+
+    return header + 1;
+}
+
+void* HostAllocator::reallocate(void* original, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    if (original == nullptr) {
+        return this->allocate(size, alignment, scope);
+    }
+
+    if (size == 0) {
+        this->free(original);
+
+        return nullptr;
+    }
+
+    auto* header = static_cast<Header*>(original) - 1;
+
+    // A pooled allocation that still fits in its slot grows or shrinks in place.
+    const auto isPooled = header->alignment == 0;
+    const auto fitsInPlace = size <= MAX_POOLED_SIZE
+        && alignment <= POOL_ALIGNMENT
+        && HostAllocator::selectPool(size) == HostAllocator::selectPool(header->size);
+    if (isPooled && fitsInPlace) {
+        this->recordFree(header->size, header->scope);
+        header->size = size;
+        this->recordAllocation(size, header->scope, true);
+
+        return original;
+    }
+
+    auto* memory = this->allocate(size, alignment, scope);
+    if (memory == nullptr) {
+        return nullptr;
+    }
+
+    std::memcpy(memory, original, std::min(size, header->size));
+    this->free(original);
+
+    return memory;
+}
+
+void HostAllocator::free(void* memory) {
+    if (memory == nullptr) {
+        return;
+    }
+
+    auto* header = static_cast<Header*>(memory) - 1;
+    this->recordFree(header->size, header->scope);
+
+    if (header->alignment == 0) {
+        this->freeSlot(HostAllocator::selectPool(header->size), header);
+    } else {
+        const auto largeAlignment = size_t { header->alignment };
+        auto* base = reinterpret_cast<std::byte*>(memory) - largeAlignment;
+        ::operator delete(base, std::align_val_t { largeAlignment });
+    }
+}
+
+void* HostAllocator::allocateSlot(size_t poolIndex) {
+    auto& pool = m_pools[poolIndex];
+    const auto lock = std::lock_guard<std::mutex> { pool.mutex };
+    if (pool.freeSlots == nullptr) {
+        auto* chunk = static_cast<std::byte*>(::operator new(CHUNK_SIZE, std::align_val_t { POOL_ALIGNMENT }, std::nothrow));
+        if (chunk == nullptr) {
+            return nullptr;
+        }
+
+        // Thread the whole chunk onto the free list, so the first slot is handed out first.
+        const auto slotSize = HostAllocator::getSlotSize(poolIndex);
+        const auto slotCount = CHUNK_SIZE / slotSize;
+        for (size_t i = slotCount; i > 0; i--) {
+            auto* slot = reinterpret_cast<FreeSlot*>(chunk + (i - 1) * slotSize);
+            slot->next = pool.freeSlots;
+            pool.freeSlots = slot;
+        }
+        pool.chunks.push_back(chunk);
+
+        const auto statisticsLock = std::lock_guard<std::mutex> { m_statisticsMutex };
+        m_chunkCount++;
+        m_chunkBytes += CHUNK_SIZE;
+    }
+
+    auto* slot = pool.freeSlots;
+    pool.freeSlots = slot->next;
+
+    return slot;
+}
+
+void HostAllocator::freeSlot(size_t poolIndex, void* slot) {
+    auto& pool = m_pools[poolIndex];
+    const auto lock = std::lock_guard<std::mutex> { pool.mutex };
+    auto* freeSlot = static_cast<FreeSlot*>(slot);
+    freeSlot->next = pool.freeSlots;
+    pool.freeSlots = freeSlot;
+}
+
+void HostAllocator::recordAllocation(size_t size, uint32_t scope, bool isPooled) {
+    const auto lock = std::lock_guard<std::mutex> { m_statisticsMutex };
+    auto& scopeStatistics = m_scopeStatistics[std::min<size_t>(scope, HOST_ALLOCATION_SCOPE_COUNT - 1)];
+    scopeStatistics.bytes += size;
+    scopeStatistics.allocationCount++;
+    scopeStatistics.peakBytes = std::max(scopeStatistics.peakBytes, scopeStatistics.bytes);
+    if (isPooled) {
+        m_pooledAllocationCount++;
+    } else {
+        m_largeAllocationCount++;
+    }
+}
+
+void HostAllocator::recordFree(size_t size, uint32_t scope) {
+    const auto lock = std::lock_guard<std::mutex> { m_statisticsMutex };
+    auto& scopeStatistics = m_scopeStatistics[std::min<size_t>(scope, HOST_ALLOCATION_SCOPE_COUNT - 1)];
+    scopeStatistics.bytes -= size;
+    scopeStatistics.allocationCount--;
+}
+
+VKAPI_ATTR void* VKAPI_CALL HostAllocator::allocationCallback(
+    void* userData,
+    size_t size,
+    size_t alignment,
+    VkSystemAllocationScope scope
+) {
+    return static_cast<HostAllocator*>(userData)->allocate(size, alignment, scope);
+}
+
+VKAPI_ATTR void* VKAPI_CALL HostAllocator::reallocationCallback(
+    void* userData,
+    void* original,
+    size_t size,
+    size_t alignment,
+    VkSystemAllocationScope scope
+) {
+    return static_cast<HostAllocator*>(userData)->reallocate(original, size, alignment, scope);
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::freeCallback(void* userData, void* memory) {
+    static_cast<HostAllocator*>(userData)->free(memory);
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalAllocationCallback(
+    void* userData,
+    size_t size,
+    VkInternalAllocationType allocationType,
+    VkSystemAllocationScope scope
+) {
+    auto* allocator = static_cast<HostAllocator*>(userData);
+    const auto lock = std::lock_guard<std::mutex> { allocator->m_statisticsMutex };
+    allocator->m_scopeStatistics[std::min<size_t>(scope, HOST_ALLOCATION_SCOPE_COUNT - 1)].internalBytes += size;
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalFreeCallback(
+    void* userData,
+    size_t size,
+    VkInternalAllocationType allocationType,
+    VkSystemAllocationScope scope
+) {
+    auto* allocator = static_cast<HostAllocator*>(userData);
+    const auto lock = std::lock_guard<std::mutex> { allocator->m_statisticsMutex };
+    allocator->m_scopeStatistics[std::min<size_t>(scope, HOST_ALLOCATION_SCOPE_COUNT - 1)].internalBytes -= size;
+}
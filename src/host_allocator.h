@@ -0,0 +1,161 @@
+#ifndef _HOST_ALLOCATOR_H
+#define _HOST_ALLOCATOR_H
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief The number of `VkSystemAllocationScope` values, from command to instance.
+constexpr size_t HOST_ALLOCATION_SCOPE_COUNT = 5;
+
+/// @brief The live host allocations the driver made in one scope, and the most bytes they
+/// ever held at once.
+///
+/// @note Internal allocations are the ones the driver makes with its own allocator and only
+/// reports, like executable memory for compiled shaders.
+struct HostAllocationScopeStatistics final {
+    size_t bytes = 0;
+    uint32_t allocationCount = 0;
+    size_t peakBytes = 0;
+    size_t internalBytes = 0;
+};
+
+/// @brief What the host allocator holds, by allocation scope and by pool.
+struct HostAllocatorStatistics final {
+    std::array<HostAllocationScopeStatistics, HOST_ALLOCATION_SCOPE_COUNT> scopes;
+    uint32_t chunkCount = 0;
+    size_t chunkBytes = 0;
+    uint64_t pooledAllocationCount = 0;
+    uint64_t largeAllocationCount = 0;
+};
+
+/// @brief The `VkAllocationCallbacks` the engine hands to the driver, which serve its host
+/// allocations from size-class pools and account for them by allocation scope.
+///
+/// @note Drivers make many small, short-lived host allocations for command buffers,
+/// descriptor set layouts and other small objects. Requests of up to `MAX_POOLED_SIZE`
+/// bytes, with at most the alignment of the pools, are served from free lists of fixed size
+/// slots carved out of `CHUNK_SIZE` chunks, which are only returned when the allocator is
+/// destroyed. Larger or more strictly aligned requests go to the aligned global allocator.
+/// Every allocation is preceded by a small header recording its size and scope, so frees
+/// and reallocations know where an allocation came from.
+///
+/// The callbacks are safe to call from any thread. An object has to be destroyed with the
+/// same callbacks it was created with, so the allocator has to outlive every object created
+/// with them.
+class HostAllocator final {
+    public:
+        static constexpr size_t MIN_POOLED_SIZE = 16;
+        static constexpr size_t MAX_POOLED_SIZE = 1024;
+        static constexpr size_t POOL_COUNT = 7;
+        static constexpr size_t POOL_ALIGNMENT = 16;
+        static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+        explicit HostAllocator();
+
+        ~HostAllocator();
+
+        HostAllocator(const HostAllocator& other) = delete;
+        HostAllocator& operator=(const HostAllocator& other) = delete;
+
+        /// @brief The callbacks to pass to every `vkCreate*` and `vkDestroy*` call of the
+        /// objects this allocator backs.
+        const VkAllocationCallbacks* getCallbacks() const;
+
+        HostAllocatorStatistics getStatistics() const;
+
+        /// @brief Print the statistics as a table, with the high-water mark of every scope.
+        ///
+        /// @note After the instance is destroyed, whatever is still live was leaked by the
+        /// driver or by a missing destroy.
+        void printReport() const;
+    private:
+        /// @brief The header in front of every allocation. Pooled allocations have an
+        /// alignment of zero, and their pool follows from their size.
+        struct alignas(POOL_ALIGNMENT) Header final {
+            size_t size;
+            uint32_t scope;
+            uint32_t alignment;
+        };
+
+        static_assert(sizeof(Header) == POOL_ALIGNMENT);
+
+        struct FreeSlot final {
+            FreeSlot* next;
+        };
+
+        struct Pool final {
+            std::mutex mutex;
+            FreeSlot* freeSlots = nullptr;
+            std::vector<void*> chunks;
+        };
+
+        VkAllocationCallbacks m_callbacks;
+        std::array<Pool, POOL_COUNT> m_pools;
+        mutable std::mutex m_statisticsMutex;
+        std::array<HostAllocationScopeStatistics, HOST_ALLOCATION_SCOPE_COUNT> m_scopeStatistics;
+        uint32_t m_chunkCount;
+        size_t m_chunkBytes;
+        uint64_t m_pooledAllocationCount;
+        uint64_t m_largeAllocationCount;
+
+        static size_t selectPool(size_t size);
+
+        static size_t getSlotSize(size_t poolIndex);
+
+        void* allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+
+        void* reallocate(void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+
+        void free(void* memory);
+
+        void* allocateSlot(size_t poolIndex);
+
+        void freeSlot(size_t poolIndex, void* slot);
+
+        void recordAllocation(size_t size, uint32_t scope, bool isPooled);
+
+        void recordFree(size_t size, uint32_t scope);
+
+        static VKAPI_ATTR void* VKAPI_CALL allocationCallback(
+            void* userData,
+            size_t size,
+            size_t alignment,
+            VkSystemAllocationScope scope
+        );
+
+        static VKAPI_ATTR void* VKAPI_CALL reallocationCallback(
+            void* userData,
+            void* original,
+            size_t size,
+            size_t alignment,
+            VkSystemAllocationScope scope
+        );
+
+        static VKAPI_ATTR void VKAPI_CALL freeCallback(void* userData, void* memory);
+
+        static VKAPI_ATTR void VKAPI_CALL internalAllocationCallback(
+            void* userData,
+            size_t size,
+            VkInternalAllocationType allocationType,
+            VkSystemAllocationScope scope
+        );
+
+        static VKAPI_ATTR void VKAPI_CALL internalFreeCallback(
+            void* userData,
+            size_t size,
+            VkInternalAllocationType allocationType,
+            VkSystemAllocationScope scope
+        );
+};
+
+}
+
+#endif // _HOST_ALLOCATOR_H
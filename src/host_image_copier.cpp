@@ -0,0 +1,142 @@
+#include "host_image_copier.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+
+using HostImageCopier = VulkanEngine::HostImageCopier;
+
+// Host copies and transitions can only reach the layouts the device lists for them.
+static bool canCopyToShaderRead(VkPhysicalDevice physicalDevice) {
+    auto hostImageCopyProperties = VkPhysicalDeviceHostImageCopyPropertiesEXT {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT,
+        .pNext = nullptr,
+    };
+    auto properties = VkPhysicalDeviceProperties2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &hostImageCopyProperties,
+    };
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    auto copyDstLayouts = std::vector<VkImageLayout>(hostImageCopyProperties.copyDstLayoutCount);
+    hostImageCopyProperties.pCopyDstLayouts = copyDstLayouts.data();
+    hostImageCopyProperties.copySrcLayoutCount = 0;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    return std::find(copyDstLayouts.begin(), copyDstLayouts.end(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) != copyDstLayouts.end();
+}
+
+HostImageCopier::HostImageCopier(VkPhysicalDevice physicalDevice, VkDevice device)
+    : m_physicalDevice { physicalDevice }
+    , m_device { device }
+    , m_vkCopyMemoryToImageEXT {
+        reinterpret_cast<PFN_vkCopyMemoryToImageEXT>(vkGetDeviceProcAddr(device, "vkCopyMemoryToImageEXT"))
+    }
+    , m_vkTransitionImageLayoutEXT {
+        reinterpret_cast<PFN_vkTransitionImageLayoutEXT>(vkGetDeviceProcAddr(device, "vkTransitionImageLayoutEXT"))
+    }
+    , m_canCopyToShaderRead { canCopyToShaderRead(physicalDevice) }
+{
+    if (m_vkCopyMemoryToImageEXT == nullptr || m_vkTransitionImageLayoutEXT == nullptr) {
+        throw std::runtime_error("failed to load host image copy functions!");
+    }
+}
+
+bool HostImageCopier::supportsFormat(VkFormat format) const {
+    if (!m_canCopyToShaderRead) {
+        return false;
+    }
+
+    auto formatProperties3 = VkFormatProperties3 {
+        .sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_3,
+        .pNext = nullptr,
+    };
+    auto formatProperties = VkFormatProperties2 {
+        .sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2,
+        .pNext = &formatProperties3,
+    };
+    vkGetPhysicalDeviceFormatProperties2(m_physicalDevice, format, &formatProperties);
+    if ((formatProperties3.optimalTilingFeatures & VK_FORMAT_FEATURE_2_HOST_IMAGE_TRANSFER_BIT_EXT) == 0) {
+        return false;
+    }
+
+    const auto imageFormatInfo = VkPhysicalDeviceImageFormatInfo2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+        .pNext = nullptr,
+        .format = format,
+        .type = VK_IMAGE_TYPE_2D,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = this->getRequiredImageUsage() | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .flags = 0,
+    };
+    auto performanceQuery = VkHostImageCopyDevicePerformanceQueryEXT {
+        .sType = VK_STRUCTURE_TYPE_HOST_IMAGE_COPY_DEVICE_PERFORMANCE_QUERY_EXT,
+        .pNext = nullptr,
+    };
+    auto imageFormatProperties = VkImageFormatProperties2 {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2,
+        .pNext = &performanceQuery,
+    };
+    const auto result = vkGetPhysicalDeviceImageFormatProperties2(m_physicalDevice, &imageFormatInfo, &imageFormatProperties);
+
+    return result == VK_SUCCESS && performanceQuery.optimalDeviceAccess == VK_TRUE;
+}
+
+VkImageUsageFlags HostImageCopier::getRequiredImageUsage() const {
+    return VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT;
+}
+
+void HostImageCopier::transitionToShaderRead(VkImage image, uint32_t mipLevels) const {
+    const auto transitionInfo = VkHostImageLayoutTransitionInfoEXT {
+        .sType = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT,
+        .pNext = nullptr,
+        .image = image,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .subresourceRange = VkImageSubresourceRange {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0,
+            .levelCount = mipLevels,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+
+    const auto result = m_vkTransitionImageLayoutEXT(m_device, 1, &transitionInfo);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to transition image layout on the host!");
+    }
+}
+
+void HostImageCopier::copyToImage(VkImage image, const void* data, std::span<const VkBufferImageCopy> regions) const {
+    auto copyRegions = std::vector<VkMemoryToImageCopyEXT> {};
+    copyRegions.reserve(regions.size());
+    for (const auto& region : regions) {
+        copyRegions.push_back(VkMemoryToImageCopyEXT {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT,
+            .pNext = nullptr,
+            .pHostPointer = static_cast<const char*>(data) + region.bufferOffset,
+            .memoryRowLength = region.bufferRowLength,
+            .memoryImageHeight = region.bufferImageHeight,
+            .imageSubresource = region.imageSubresource,
+            .imageOffset = region.imageOffset,
+            .imageExtent = region.imageExtent,
+        });
+    }
+
+    const auto copyInfo = VkCopyMemoryToImageInfoEXT {
+        .sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT,
+        .pNext = nullptr,
+        .flags = 0,
+        .dstImage = image,
+        .dstImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .regionCount = static_cast<uint32_t>(copyRegions.size()),
+        .pRegions = copyRegions.data(),
+    };
+
+    const auto result = m_vkCopyMemoryToImageEXT(m_device, &copyInfo);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to copy texels to image from the host!");
+    }
+}
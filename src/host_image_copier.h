@@ -0,0 +1,62 @@
+#ifndef _HOST_IMAGE_COPIER_H
+#define _HOST_IMAGE_COPIER_H
+
+#include <vulkan/vulkan.h>
+
+#include <span>
+
+
+namespace VulkanEngine {
+
+/// @brief Writes texels from host memory straight into optimally tiled images with
+/// `VK_EXT_host_image_copy`, without a staging buffer, a command buffer or a submit.
+///
+/// @note An image copied to from the host is created with `getRequiredImageUsage`, and
+/// never passes through a transfer layout. It goes from the undefined layout to the shader
+/// read layout on the host, and its levels are copied in that layout, so it can be sampled
+/// by any submission made after the copies return. Copies to different levels of one
+/// image, or to different images, can run on as many threads at once as there are levels.
+///
+/// A format is only copied to from the host when the device reports that an image with the
+/// host transfer usage keeps the device access it would have without it. Otherwise the
+/// copier reports the format as unsupported, and the texture goes through the staging ring,
+/// since a texture sampled every frame is worth one copy on the GPU.
+class HostImageCopier final {
+    public:
+        explicit HostImageCopier() = delete;
+        explicit HostImageCopier(VkPhysicalDevice physicalDevice, VkDevice device);
+
+        ~HostImageCopier() = default;
+
+        HostImageCopier(const HostImageCopier& other) = delete;
+        HostImageCopier& operator=(const HostImageCopier& other) = delete;
+
+        /// @brief Whether a sampled, optimally tiled 2D image of `format` is copied to from
+        /// the host.
+        bool supportsFormat(VkFormat format) const;
+
+        /// @brief The usage an image needs to be copied to from the host, next to its
+        /// sampled usage.
+        VkImageUsageFlags getRequiredImageUsage() const;
+
+        /// @brief Move every level of `image`, which must be in the undefined layout, to the
+        /// shader read layout on the host.
+        void transitionToShaderRead(VkImage image, uint32_t mipLevels) const;
+
+        /// @brief Copy `regions` of `data` into `image`, which must be in the shader read
+        /// layout.
+        ///
+        /// @note The regions are laid out like buffer copies, with their buffer offsets
+        /// relative to `data`.
+        void copyToImage(VkImage image, const void* data, std::span<const VkBufferImageCopy> regions) const;
+    private:
+        VkPhysicalDevice m_physicalDevice;
+        VkDevice m_device;
+        PFN_vkCopyMemoryToImageEXT m_vkCopyMemoryToImageEXT;
+        PFN_vkTransitionImageLayoutEXT m_vkTransitionImageLayoutEXT;
+        bool m_canCopyToShaderRead;
+};
+
+}
+
+#endif // _HOST_IMAGE_COPIER_H
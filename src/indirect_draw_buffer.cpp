@@ -0,0 +1,137 @@
+#include "indirect_draw_buffer.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+
+using IndirectDrawBuffer = VulkanEngine::IndirectDrawBuffer;
+
+static bool isSameDrawCommand(const VkDrawIndexedIndirectCommand& lhs, const VkDrawIndexedIndirectCommand& rhs) {
+    return lhs.indexCount == rhs.indexCount
+        && lhs.instanceCount == rhs.instanceCount
+        && lhs.firstIndex == rhs.firstIndex
+        && lhs.vertexOffset == rhs.vertexOffset
+        && lhs.firstInstance == rhs.firstInstance;
+}
+
+IndirectDrawBuffer::IndirectDrawBuffer(VkDevice device, GpuMemoryAllocator& allocator, uint32_t frameCount, uint32_t maxDrawCount)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_buffer { VK_NULL_HANDLE }
+    , m_allocation {}
+    , m_frameCount { frameCount }
+    , m_maxDrawCount { maxDrawCount }
+    , m_regionSize { 0 }
+    , m_regionDrawCommands { std::vector<std::vector<VkDrawIndexedIndirectCommand>> { frameCount } }
+{
+    if (frameCount == 0) {
+        throw std::invalid_argument("an indirect draw buffer needs at least one frame!");
+    }
+
+    const auto drawsSize = VkDeviceSize { sizeof(VkDrawIndexedIndirectCommand) * maxDrawCount };
+    m_regionSize = (DRAWS_OFFSET + drawsSize + DRAWS_OFFSET - 1) / DRAWS_OFFSET * DRAWS_OFFSET;
+
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = m_regionSize * m_frameCount,
+        .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto resultCreateBuffer = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+    if (resultCreateBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to create indirect draw buffer!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    const auto allocation = m_allocator.allocate(
+        memRequirements,
+        m_allocator.selectDynamicMemoryProperties(memRequirements.memoryTypeBits),
+        GpuResourceKind::Linear,
+        GpuMemoryCategory::Other
+    );
+
+    vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+    // Every region starts out with no draws.
+    for (uint32_t i = 0; i < m_frameCount; i++) {
+        const auto drawCount = uint32_t { 0 };
+        std::memcpy(static_cast<char*>(allocation.mappedData) + this->getCountOffset(i), &drawCount, sizeof(drawCount));
+    }
+
+    m_buffer = buffer;
+    m_allocation = allocation;
+}
+
+IndirectDrawBuffer::~IndirectDrawBuffer() {
+    vkDestroyBuffer(m_device, m_buffer, nullptr);
+    m_allocator.free(m_allocation);
+
+    m_buffer = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+uint32_t IndirectDrawBuffer::update(uint32_t frameIndex, std::span<const VkDrawIndexedIndirectCommand> drawCommands) {
+    if (frameIndex >= m_frameCount) {
+        throw std::invalid_argument {
+            fmt::format("Frame {} is out of range for an indirect draw buffer of {} frames", frameIndex, m_frameCount)
+        };
+    }
+
+    if (drawCommands.size() > m_maxDrawCount) {
+        throw std::invalid_argument {
+            fmt::format("{} draws exceed the indirect draw buffer capacity of {} draws", drawCommands.size(), m_maxDrawCount)
+        };
+    }
+
+    auto* region = static_cast<char*>(m_allocation.mappedData) + frameIndex * m_regionSize;
+    auto* mappedDrawCommands = reinterpret_cast<VkDrawIndexedIndirectCommand*>(region + DRAWS_OFFSET);
+    auto& regionDrawCommands = m_regionDrawCommands[frameIndex];
+    uint32_t writtenCount = 0;
+    for (size_t i = 0; i < drawCommands.size(); i++) {
+        if (i < regionDrawCommands.size() && isSameDrawCommand(regionDrawCommands[i], drawCommands[i])) {
+            continue;
+        }
+
+        mappedDrawCommands[i] = drawCommands[i];
+        writtenCount++;
+    }
+
+    if (drawCommands.size() != regionDrawCommands.size()) {
+        const auto drawCount = static_cast<uint32_t>(drawCommands.size());
+        std::memcpy(region, &drawCount, sizeof(drawCount));
+    }
+
+    regionDrawCommands.assign(drawCommands.begin(), drawCommands.end());
+
+    return writtenCount;
+}
+
+VkBuffer IndirectDrawBuffer::getBuffer() const {
+    return m_buffer;
+}
+
+VkDeviceSize IndirectDrawBuffer::getSize() const {
+    return m_regionSize * m_frameCount;
+}
+
+VkDeviceSize IndirectDrawBuffer::getCountOffset(uint32_t frameIndex) const {
+    return frameIndex * m_regionSize;
+}
+
+VkDeviceSize IndirectDrawBuffer::getDrawOffset(uint32_t frameIndex) const {
+    return frameIndex * m_regionSize + DRAWS_OFFSET;
+}
+
+uint32_t IndirectDrawBuffer::getMaxDrawCount() const {
+    return m_maxDrawCount;
+}
+
+uint32_t IndirectDrawBuffer::getFrameCount() const {
+    return m_frameCount;
+}
@@ -0,0 +1,69 @@
+#ifndef _INDIRECT_DRAW_BUFFER_H
+#define _INDIRECT_DRAW_BUFFER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief A persistently mapped, host-visible buffer of indexed indirect draws and their
+/// draw count, with one region for every frame in flight, for `vkCmdDrawIndexedIndirectCount`.
+///
+/// @note Every region holds its draw count first, then room for `maxDrawCount` draws. The
+/// buffer keeps a copy of what each region holds, and `update` only writes the draws,
+/// and the count, that changed since the region was last updated. A region must only be
+/// updated once its frame's previous submit has finished. Command buffers that draw from a
+/// region stay valid however its draws change. The buffer can be bound as a storage buffer
+/// too, for compute passes that read the draws.
+class IndirectDrawBuffer final {
+    public:
+        explicit IndirectDrawBuffer() = delete;
+        explicit IndirectDrawBuffer(VkDevice device, GpuMemoryAllocator& allocator, uint32_t frameCount, uint32_t maxDrawCount);
+
+        ~IndirectDrawBuffer();
+
+        IndirectDrawBuffer(const IndirectDrawBuffer& other) = delete;
+        IndirectDrawBuffer& operator=(const IndirectDrawBuffer& other) = delete;
+
+        /// @brief Make the draws of the region of `frameIndex` `drawCommands`, and return how
+        /// many of them had to be written.
+        uint32_t update(uint32_t frameIndex, std::span<const VkDrawIndexedIndirectCommand> drawCommands);
+
+        VkBuffer getBuffer() const;
+
+        /// @brief The size of the buffer, which holds the regions of every frame.
+        VkDeviceSize getSize() const;
+
+        VkDeviceSize getCountOffset(uint32_t frameIndex) const;
+
+        VkDeviceSize getDrawOffset(uint32_t frameIndex) const;
+
+        uint32_t getMaxDrawCount() const;
+
+        uint32_t getFrameCount() const;
+    private:
+        /// @brief The draws must start at a multiple of four bytes, and one scalar is all the
+        /// count needs, but keeping the draws 16 byte aligned costs nothing.
+        static constexpr VkDeviceSize DRAWS_OFFSET = 16;
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkBuffer m_buffer;
+        GpuAllocation m_allocation;
+        uint32_t m_frameCount;
+        uint32_t m_maxDrawCount;
+        VkDeviceSize m_regionSize;
+        /// @brief What the region of every frame holds, so that the mapped memory, which may
+        /// be uncached, is never read back.
+        std::vector<std::vector<VkDrawIndexedIndirectCommand>> m_regionDrawCommands;
+};
+
+}
+
+#endif // _INDIRECT_DRAW_BUFFER_H
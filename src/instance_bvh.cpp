@@ -0,0 +1,383 @@
+#include "instance_bvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#if defined(__SSE__) || defined(_M_X64)
+    #include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+#include <glm/gtc/matrix_access.hpp>
+
+#include "job_system.h"
+
+
+using InstanceBvh = VulkanEngine::InstanceBvh;
+
+// Split the instances of a range at the median of their centers along the axis the centers
+// spread out the most on, and return how many go in the first half.
+static uint32_t splitAtMedian(std::span<const glm::vec4> boundingSpheres, std::span<uint32_t> instances) {
+    auto minCenter = glm::vec3(boundingSpheres[instances.front()]);
+    auto maxCenter = minCenter;
+    for (const auto instance : instances) {
+        minCenter = glm::min(minCenter, glm::vec3(boundingSpheres[instance]));
+        maxCenter = glm::max(maxCenter, glm::vec3(boundingSpheres[instance]));
+    }
+
+    const auto spread = maxCenter - minCenter;
+    const auto axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : (spread.y >= spread.z ? 1 : 2);
+    const auto half = static_cast<uint32_t>(instances.size() / 2);
+    std::nth_element(instances.begin(), instances.begin() + half, instances.end(), [&boundingSpheres, axis](uint32_t a, uint32_t b) {
+        return boundingSpheres[a][axis] < boundingSpheres[b][axis];
+    });
+
+    return half;
+}
+
+void InstanceBvh::build(std::span<const glm::vec4> boundingSpheres) {
+    m_nodes.clear();
+    m_cullTasks.clear();
+    m_instanceOrder.resize(boundingSpheres.size());
+    std::iota(m_instanceOrder.begin(), m_instanceOrder.end(), 0);
+    if (boundingSpheres.empty()) {
+        return;
+    }
+
+    m_nodes.reserve(boundingSpheres.size() / 2 + 1);
+    this->buildNode(boundingSpheres, 0, static_cast<uint32_t>(boundingSpheres.size()));
+    this->buildCullTasks();
+    this->refit(boundingSpheres);
+}
+
+void InstanceBvh::refit(std::span<const glm::vec4> boundingSpheres) {
+    if (boundingSpheres.size() != m_instanceOrder.size()) {
+        throw std::invalid_argument("instance bvh refit with a different instance count!");
+    }
+
+    // Every node comes before its children, so going through them backwards finds the
+    // children of every node refitted already.
+    for (auto nodeIndex = m_nodes.size(); nodeIndex-- > 0;) {
+        auto& node = m_nodes[nodeIndex];
+        for (uint32_t child = 0; child < NODE_WIDTH; child++) {
+            auto center = glm::vec3(0.0f);
+            auto extent = glm::vec3(0.0f);
+            auto radius = 0.0f;
+            if (node.instanceCounts[child] == 0) {
+                // An empty child keeps no bounds, and is never visible.
+            } else if ((node.children[child] & LEAF_BIT) != 0) {
+                const auto& boundingSphere = boundingSpheres[node.children[child] & ~LEAF_BIT];
+                center = glm::vec3(boundingSphere);
+                extent = glm::vec3(boundingSphere.w);
+                radius = boundingSphere.w;
+            } else {
+                const auto& childNode = m_nodes[node.children[child]];
+                auto minCorner = glm::vec3(std::numeric_limits<float>::max());
+                auto maxCorner = glm::vec3(std::numeric_limits<float>::lowest());
+                for (uint32_t grandchild = 0; grandchild < NODE_WIDTH; grandchild++) {
+                    if (childNode.instanceCounts[grandchild] == 0) {
+                        continue;
+                    }
+
+                    const auto grandchildCenter = glm::vec3(childNode.centerX[grandchild], childNode.centerY[grandchild], childNode.centerZ[grandchild]);
+                    const auto grandchildExtent = glm::vec3(childNode.extentX[grandchild], childNode.extentY[grandchild], childNode.extentZ[grandchild]);
+                    minCorner = glm::min(minCorner, grandchildCenter - grandchildExtent);
+                    maxCorner = glm::max(maxCorner, grandchildCenter + grandchildExtent);
+                }
+
+                center = 0.5f * (minCorner + maxCorner);
+                extent = 0.5f * (maxCorner - minCorner);
+                radius = glm::length(extent);
+                auto childrenRadius = 0.0f;
+                for (uint32_t grandchild = 0; grandchild < NODE_WIDTH; grandchild++) {
+                    if (childNode.instanceCounts[grandchild] == 0) {
+                        continue;
+                    }
+
+                    const auto grandchildCenter = glm::vec3(childNode.centerX[grandchild], childNode.centerY[grandchild], childNode.centerZ[grandchild]);
+                    childrenRadius = std::max(childrenRadius, glm::distance(center, grandchildCenter) + childNode.radius[grandchild]);
+                }
+                radius = std::min(radius, childrenRadius);
+            }
+
+            node.centerX[child] = center.x;
+            node.centerY[child] = center.y;
+            node.centerZ[child] = center.z;
+            node.extentX[child] = extent.x;
+            node.extentY[child] = extent.y;
+            node.extentZ[child] = extent.z;
+            node.radius[child] = radius;
+        }
+    }
+}
+
+void InstanceBvh::cull(const glm::mat4& viewProj, JobSystem* jobSystem, std::vector<uint32_t>& visibleInstances) const {
+    visibleInstances.resize(m_instanceOrder.size());
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    const auto frustum = InstanceBvh::extractFrustum(viewProj);
+    auto* output = visibleInstances.data();
+    const auto isParallel = jobSystem != nullptr && m_instanceOrder.size() >= PARALLEL_CULL_MIN_INSTANCES && m_cullTasks.size() > 1;
+    if (!isParallel) {
+        visibleInstances.resize(this->cullNode(frustum, 0, output));
+        return;
+    }
+
+    // Every task writes from where its instances start in the order of the tree, and the
+    // tasks are in that order, so moving their instances down to close the gaps between
+    // them never overwrites instances that have not been moved yet.
+    auto visibleCounts = std::vector<uint32_t>(m_cullTasks.size());
+    jobSystem->parallelFor(m_cullTasks.size(), 1, [this, &frustum, &visibleCounts, output](size_t task) {
+        const auto& cullTask = m_cullTasks[task];
+        const auto& node = m_nodes[cullTask.node];
+        const auto [isOutsideMask, isCrossingMask] = InstanceBvh::classifyChildren(node, frustum);
+        visibleCounts[task] = this->cullChild(
+            frustum,
+            cullTask.node,
+            cullTask.child,
+            isOutsideMask,
+            isCrossingMask,
+            output + node.firstInstances[cullTask.child]
+        );
+    });
+
+    auto visibleCount = size_t { 0 };
+    for (size_t task = 0; task < m_cullTasks.size(); task++) {
+        const auto& cullTask = m_cullTasks[task];
+        const auto* taskOutput = output + m_nodes[cullTask.node].firstInstances[cullTask.child];
+        std::copy(taskOutput, taskOutput + visibleCounts[task], output + visibleCount);
+        visibleCount += visibleCounts[task];
+    }
+    visibleInstances.resize(visibleCount);
+}
+
+uint32_t InstanceBvh::getInstanceCount() const {
+    return static_cast<uint32_t>(m_instanceOrder.size());
+}
+
+uint32_t InstanceBvh::buildNode(std::span<const glm::vec4> boundingSpheres, uint32_t firstInstance, uint32_t instanceCount) {
+    const auto nodeIndex = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back(Node {});
+
+    // A node with more instances than children splits them in half, and both halves in half
+    // again.
+    auto groupFirsts = std::array<uint32_t, NODE_WIDTH> {};
+    auto groupCounts = std::array<uint32_t, NODE_WIDTH> {};
+    if (instanceCount <= NODE_WIDTH) {
+        for (uint32_t group = 0; group < instanceCount; group++) {
+            groupFirsts[group] = firstInstance + group;
+            groupCounts[group] = 1;
+        }
+    } else {
+        auto instances = std::span(m_instanceOrder).subspan(firstInstance, instanceCount);
+        const auto half = splitAtMedian(boundingSpheres, instances);
+        const auto firstQuarter = splitAtMedian(boundingSpheres, instances.first(half));
+        const auto thirdQuarter = splitAtMedian(boundingSpheres, instances.subspan(half));
+        groupFirsts = { firstInstance, firstInstance + firstQuarter, firstInstance + half, firstInstance + half + thirdQuarter };
+        groupCounts = { firstQuarter, half - firstQuarter, thirdQuarter, instanceCount - half - thirdQuarter };
+    }
+
+    for (uint32_t child = 0; child < NODE_WIDTH; child++) {
+        if (groupCounts[child] == 0) {
+            continue;
+        }
+
+        const auto childNode = groupCounts[child] == 1
+            ? LEAF_BIT | m_instanceOrder[groupFirsts[child]]
+            : this->buildNode(boundingSpheres, groupFirsts[child], groupCounts[child]);
+        auto& node = m_nodes[nodeIndex];
+        node.children[child] = childNode;
+        node.firstInstances[child] = groupFirsts[child];
+        node.instanceCounts[child] = groupCounts[child];
+    }
+
+    return nodeIndex;
+}
+
+void InstanceBvh::buildCullTasks() {
+    for (uint32_t child = 0; child < NODE_WIDTH; child++) {
+        if (m_nodes[0].instanceCounts[child] != 0) {
+            m_cullTasks.push_back(CullTask { .node = 0, .child = child });
+        }
+    }
+
+    // The children of a node are in the order of their instances, so putting them in the
+    // place of their node keeps the tasks in that order.
+    while (m_cullTasks.size() < CULL_TASK_COUNT) {
+        auto nextTasks = std::vector<CullTask> {};
+        for (const auto& cullTask : m_cullTasks) {
+            const auto childNode = m_nodes[cullTask.node].children[cullTask.child];
+            if ((childNode & LEAF_BIT) != 0) {
+                nextTasks.push_back(cullTask);
+                continue;
+            }
+
+            for (uint32_t child = 0; child < NODE_WIDTH; child++) {
+                if (m_nodes[childNode].instanceCounts[child] != 0) {
+                    nextTasks.push_back(CullTask { .node = childNode, .child = child });
+                }
+            }
+        }
+
+        if (nextTasks.size() == m_cullTasks.size()) {
+            break;
+        }
+        m_cullTasks = std::move(nextTasks);
+    }
+}
+
+// The planes of the clip volume in world space, with depth from zero to one, as the
+// culling shader takes them. A plane without a normal, like the far plane of a reverse-Z
+// projection at infinity, is left as it is and culls nothing.
+InstanceBvh::Frustum InstanceBvh::extractFrustum(const glm::mat4& viewProj) {
+    const glm::vec4 planes[6] = {
+        glm::row(viewProj, 3) + glm::row(viewProj, 0),
+        glm::row(viewProj, 3) - glm::row(viewProj, 0),
+        glm::row(viewProj, 3) + glm::row(viewProj, 1),
+        glm::row(viewProj, 3) - glm::row(viewProj, 1),
+        glm::row(viewProj, 2),
+        glm::row(viewProj, 3) - glm::row(viewProj, 2),
+    };
+
+    auto frustum = Frustum {};
+    for (size_t i = 0; i < frustum.size(); i++) {
+        const auto normalLength = glm::length(glm::vec3(planes[i]));
+        const auto plane = normalLength > 0.0f ? planes[i] / normalLength : planes[i];
+        frustum[i].normalX.fill(plane.x);
+        frustum[i].normalY.fill(plane.y);
+        frustum[i].normalZ.fill(plane.z);
+        frustum[i].distance.fill(plane.w);
+        frustum[i].absNormalX.fill(std::abs(plane.x));
+        frustum[i].absNormalY.fill(std::abs(plane.y));
+        frustum[i].absNormalZ.fill(std::abs(plane.z));
+    }
+
+    return frustum;
+}
+
+// A child is as far across a plane as its box reaches along the plane's normal, or as its
+// sphere does, whichever is less.
+std::array<uint32_t, 2> InstanceBvh::classifyChildren(const Node& node, const Frustum& frustum) {
+#if defined(__SSE__) || defined(_M_X64)
+    const auto centerX = _mm_load_ps(node.centerX.data());
+    const auto centerY = _mm_load_ps(node.centerY.data());
+    const auto centerZ = _mm_load_ps(node.centerZ.data());
+    const auto extentX = _mm_load_ps(node.extentX.data());
+    const auto extentY = _mm_load_ps(node.extentY.data());
+    const auto extentZ = _mm_load_ps(node.extentZ.data());
+    const auto radius = _mm_load_ps(node.radius.data());
+    auto isOutside = _mm_setzero_ps();
+    auto isCrossing = _mm_setzero_ps();
+    for (const auto& plane : frustum) {
+        auto distance = _mm_add_ps(_mm_load_ps(plane.distance.data()), _mm_mul_ps(_mm_load_ps(plane.normalX.data()), centerX));
+        distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(plane.normalY.data()), centerY));
+        distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(plane.normalZ.data()), centerZ));
+        auto reach = _mm_mul_ps(_mm_load_ps(plane.absNormalX.data()), extentX);
+        reach = _mm_add_ps(reach, _mm_mul_ps(_mm_load_ps(plane.absNormalY.data()), extentY));
+        reach = _mm_add_ps(reach, _mm_mul_ps(_mm_load_ps(plane.absNormalZ.data()), extentZ));
+        reach = _mm_min_ps(reach, radius);
+        isOutside = _mm_or_ps(isOutside, _mm_cmplt_ps(distance, _mm_sub_ps(_mm_setzero_ps(), reach)));
+        isCrossing = _mm_or_ps(isCrossing, _mm_cmplt_ps(distance, reach));
+    }
+
+    return {
+        static_cast<uint32_t>(_mm_movemask_ps(isOutside)),
+        static_cast<uint32_t>(_mm_movemask_ps(_mm_andnot_ps(isOutside, isCrossing))),
+    };
+#elif defined(__ARM_NEON)
+    const auto centerX = vld1q_f32(node.centerX.data());
+    const auto centerY = vld1q_f32(node.centerY.data());
+    const auto centerZ = vld1q_f32(node.centerZ.data());
+    const auto extentX = vld1q_f32(node.extentX.data());
+    const auto extentY = vld1q_f32(node.extentY.data());
+    const auto extentZ = vld1q_f32(node.extentZ.data());
+    const auto radius = vld1q_f32(node.radius.data());
+    auto isOutside = vdupq_n_u32(0);
+    auto isCrossing = vdupq_n_u32(0);
+    for (const auto& plane : frustum) {
+        auto distance = vmlaq_f32(vld1q_f32(plane.distance.data()), vld1q_f32(plane.normalX.data()), centerX);
+        distance = vmlaq_f32(distance, vld1q_f32(plane.normalY.data()), centerY);
+        distance = vmlaq_f32(distance, vld1q_f32(plane.normalZ.data()), centerZ);
+        auto reach = vmulq_f32(vld1q_f32(plane.absNormalX.data()), extentX);
+        reach = vmlaq_f32(reach, vld1q_f32(plane.absNormalY.data()), extentY);
+        reach = vmlaq_f32(reach, vld1q_f32(plane.absNormalZ.data()), extentZ);
+        reach = vminq_f32(reach, radius);
+        isOutside = vorrq_u32(isOutside, vcltq_f32(distance, vnegq_f32(reach)));
+        isCrossing = vorrq_u32(isCrossing, vcltq_f32(distance, reach));
+    }
+    isCrossing = vbicq_u32(isCrossing, isOutside);
+
+    const uint32_t laneBits[NODE_WIDTH] = { 1, 2, 4, 8 };
+    const auto bits = vld1q_u32(laneBits);
+    const auto outsideBits = vandq_u32(isOutside, bits);
+    const auto crossingBits = vandq_u32(isCrossing, bits);
+
+    return {
+        vgetq_lane_u32(outsideBits, 0) | vgetq_lane_u32(outsideBits, 1) | vgetq_lane_u32(outsideBits, 2) | vgetq_lane_u32(outsideBits, 3),
+        vgetq_lane_u32(crossingBits, 0) | vgetq_lane_u32(crossingBits, 1) | vgetq_lane_u32(crossingBits, 2) | vgetq_lane_u32(crossingBits, 3),
+    };
+#else
+    auto isOutsideMask = uint32_t { 0 };
+    auto isCrossingMask = uint32_t { 0 };
+    for (uint32_t child = 0; child < NODE_WIDTH; child++) {
+        for (const auto& plane : frustum) {
+            const auto distance = plane.distance[child]
+                + plane.normalX[child] * node.centerX[child]
+                + plane.normalY[child] * node.centerY[child]
+                + plane.normalZ[child] * node.centerZ[child];
+            const auto reach = std::min(
+                plane.absNormalX[child] * node.extentX[child] + plane.absNormalY[child] * node.extentY[child] + plane.absNormalZ[child] * node.extentZ[child],
+                node.radius[child]
+            );
+            if (distance < -reach) {
+                isOutsideMask |= 1u << child;
+            } else if (distance < reach) {
+                isCrossingMask |= 1u << child;
+            }
+        }
+    }
+
+    return { isOutsideMask, isCrossingMask & ~isOutsideMask };
+#endif
+}
+
+uint32_t InstanceBvh::cullChild(
+    const Frustum& frustum,
+    uint32_t nodeIndex,
+    uint32_t child,
+    uint32_t isOutsideMask,
+    uint32_t isCrossingMask,
+    uint32_t* output
+) const {
+    const auto& node = m_nodes[nodeIndex];
+    const auto childBit = 1u << child;
+    const auto instanceCount = node.instanceCounts[child];
+    if (instanceCount == 0 || (isOutsideMask & childBit) != 0) {
+        return 0;
+    }
+
+    // An instance's sphere is its exact bounds, so one that is not outside is visible.
+    if ((isCrossingMask & childBit) == 0 || (node.children[child] & LEAF_BIT) != 0) {
+        const auto* firstInstance = m_instanceOrder.data() + node.firstInstances[child];
+        std::copy(firstInstance, firstInstance + instanceCount, output);
+        return instanceCount;
+    }
+
+    return this->cullNode(frustum, node.children[child], output);
+}
+
+uint32_t InstanceBvh::cullNode(const Frustum& frustum, uint32_t nodeIndex, uint32_t* output) const {
+    const auto [isOutsideMask, isCrossingMask] = InstanceBvh::classifyChildren(m_nodes[nodeIndex], frustum);
+    auto visibleCount = uint32_t { 0 };
+    for (uint32_t child = 0; child < NODE_WIDTH; child++) {
+        visibleCount += this->cullChild(frustum, nodeIndex, child, isOutsideMask, isCrossingMask, output + visibleCount);
+    }
+
+    return visibleCount;
+}
@@ -0,0 +1,132 @@
+#ifndef _INSTANCE_BVH_H
+#define _INSTANCE_BVH_H
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+
+namespace VulkanEngine {
+
+class JobSystem;
+
+/// @brief A bounding volume hierarchy over the bounding spheres of the instances of a
+/// scene, that culls them against the view frustum on the CPU.
+///
+/// @note Every node has up to four children, each an instance or a node of its own, and
+/// keeps their bounds side by side, one array per coordinate, so that a node's children are
+/// tested against a plane four at a time. A child is bounded by both a box and a sphere, and
+/// is only as large against a plane as the smaller of the two. A child that is inside every
+/// plane has all of its instances visible without testing them, and one outside any plane
+/// has none.
+///
+/// `build` splits the instances at the median of the longest axis of their centers, twice
+/// for every node. Instances that move are handled by `refit`, which keeps the hierarchy and
+/// recomputes its bounds from the leaves up, so the tree only needs to be built again when
+/// the instances are added or removed. Every node's instances are contiguous in the order
+/// of the tree, which lets the subtrees under the top of the tree be culled on the jobs of
+/// a `JobSystem`, each writing into its own part of the visible list.
+class InstanceBvh final {
+    public:
+        static constexpr uint32_t NODE_WIDTH = 4;
+        static constexpr size_t PARALLEL_CULL_MIN_INSTANCES = 4096;
+        static constexpr size_t CULL_TASK_COUNT = 64;
+
+        explicit InstanceBvh() = default;
+
+        ~InstanceBvh() = default;
+
+        InstanceBvh(const InstanceBvh& other) = delete;
+        InstanceBvh& operator=(const InstanceBvh& other) = delete;
+
+        /// @brief Build the hierarchy over `boundingSpheres`, with the radius in `w`,
+        /// indexed by instance.
+        void build(std::span<const glm::vec4> boundingSpheres);
+
+        /// @brief Recompute the bounds of the hierarchy from `boundingSpheres`, which must
+        /// have as many instances as the hierarchy was built with.
+        void refit(std::span<const glm::vec4> boundingSpheres);
+
+        /// @brief Replace `visibleInstances` with the instances whose bounding spheres are
+        /// at least partly inside the frustum of `viewProj`, on the jobs of `jobSystem` if
+        /// there are enough of them, and on the calling thread otherwise or without one.
+        ///
+        /// @note The planes are taken from `viewProj` with depth from zero to one, so a
+        /// reverse-Z projection with its far plane at infinity culls nothing by depth. The
+        /// visible instances are in the order of the tree, not by index.
+        void cull(const glm::mat4& viewProj, JobSystem* jobSystem, std::vector<uint32_t>& visibleInstances) const;
+
+        uint32_t getInstanceCount() const;
+    private:
+        static constexpr uint32_t LEAF_BIT = 0x80000000u;
+
+        /// @brief The bounds and contents of the children of a node, with empty children
+        /// holding no instances.
+        struct alignas(16) Node final {
+            std::array<float, NODE_WIDTH> centerX;
+            std::array<float, NODE_WIDTH> centerY;
+            std::array<float, NODE_WIDTH> centerZ;
+            std::array<float, NODE_WIDTH> extentX;
+            std::array<float, NODE_WIDTH> extentY;
+            std::array<float, NODE_WIDTH> extentZ;
+            std::array<float, NODE_WIDTH> radius;
+            /// @brief The node of every child, or its instance with `LEAF_BIT` set.
+            std::array<uint32_t, NODE_WIDTH> children;
+            /// @brief Where the instances of every child start in the order of the tree.
+            std::array<uint32_t, NODE_WIDTH> firstInstances;
+            std::array<uint32_t, NODE_WIDTH> instanceCounts;
+        };
+
+        /// @brief A plane of the frustum, with every value repeated for every child of a
+        /// node.
+        struct alignas(16) FrustumPlane final {
+            std::array<float, NODE_WIDTH> normalX;
+            std::array<float, NODE_WIDTH> normalY;
+            std::array<float, NODE_WIDTH> normalZ;
+            std::array<float, NODE_WIDTH> distance;
+            std::array<float, NODE_WIDTH> absNormalX;
+            std::array<float, NODE_WIDTH> absNormalY;
+            std::array<float, NODE_WIDTH> absNormalZ;
+        };
+
+        using Frustum = std::array<FrustumPlane, 6>;
+
+        /// @brief A child of a node that is culled on a job of its own.
+        struct CullTask final {
+            uint32_t node;
+            uint32_t child;
+        };
+
+        std::vector<Node> m_nodes;
+        /// @brief The instances in the order of the tree.
+        std::vector<uint32_t> m_instanceOrder;
+        /// @brief The children at the top of the tree whose subtrees hold every instance
+        /// between them, in the order of their instances.
+        std::vector<CullTask> m_cullTasks;
+
+        uint32_t buildNode(std::span<const glm::vec4> boundingSpheres, uint32_t firstInstance, uint32_t instanceCount);
+
+        void buildCullTasks();
+
+        static Frustum extractFrustum(const glm::mat4& viewProj);
+
+        /// @brief The children of `node` outside some plane of `frustum` in the low bits of
+        /// the first mask, and those that cross some plane in the second.
+        static std::array<uint32_t, 2> classifyChildren(const Node& node, const Frustum& frustum);
+
+        /// @brief Write the visible instances of `child` of the node at `nodeIndex` to
+        /// `output` and return how many there are.
+        uint32_t cullChild(const Frustum& frustum, uint32_t nodeIndex, uint32_t child, uint32_t isOutsideMask, uint32_t isCrossingMask, uint32_t* output) const;
+
+        uint32_t cullNode(const Frustum& frustum, uint32_t nodeIndex, uint32_t* output) const;
+};
+
+}
+
+#endif // _INSTANCE_BVH_H
@@ -0,0 +1,280 @@
+#include "job_system.h"
+
+#include "cpu_profiler.h"
+
+#include <utility>
+
+
+using JobSystem = VulkanEngine::JobSystem;
+using JobHandle = VulkanEngine::JobHandle;
+
+namespace VulkanEngine {
+
+struct JobState final {
+    JobSystem::Job job;
+    /// @brief The dependencies that have not finished, and one more while the job is
+    /// being scheduled.
+    std::atomic<uint32_t> pendingDependencyCount;
+    /// @brief Set under `mutex`, so that a job scheduled after it either sees it done or
+    /// is registered as a dependent before it finishes.
+    std::atomic<bool> isDone;
+    std::mutex mutex;
+    std::vector<JobHandle> dependents;
+    std::exception_ptr error;
+};
+
+}
+
+/// @brief The job system the calling thread is a worker of, if any, and its index there.
+static thread_local const JobSystem* s_workerJobSystem = nullptr;
+static thread_local uint32_t s_workerIndex = 0;
+
+JobSystem::JobSystem(uint32_t threadCount, std::vector<CpuSet> workerCpuSets)
+    : m_queuedCount { 0 }
+    , m_waitingCount { 0 }
+    , m_isStopping { false }
+{
+    const auto workerCount = std::max(threadCount, 1u);
+    for (uint32_t i = 0; i < workerCount + 1; i++) {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    for (uint32_t i = 0; i < workerCount; i++) {
+        auto cpus = i < workerCpuSets.size() ? std::move(workerCpuSets[i]) : CpuSet {};
+        m_workers.emplace_back([this, i, cpus = std::move(cpus)]() {
+            CpuTopology::pinCurrentThread(cpus);
+            this->run(i);
+        });
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        m_isStopping = true;
+    }
+
+    m_wake.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+
+    m_queues.clear();
+}
+
+uint32_t JobSystem::getThreadCount() const {
+    return static_cast<uint32_t>(m_workers.size());
+}
+
+JobHandle JobSystem::schedule(Job job, const std::vector<JobHandle>& dependencies) {
+    auto state = std::make_shared<JobState>();
+    state->job = std::move(job);
+    state->pendingDependencyCount.store(1);
+    state->isDone.store(false);
+
+    auto error = std::exception_ptr { nullptr };
+    for (const auto& dependency : dependencies) {
+        const auto lock = std::lock_guard<std::mutex> { dependency->mutex };
+        if (!dependency->isDone.load()) {
+            state->pendingDependencyCount.fetch_add(1);
+            dependency->dependents.push_back(state);
+        } else if (dependency->error && !error) {
+            error = dependency->error;
+        }
+    }
+
+    if (error) {
+        const auto lock = std::lock_guard<std::mutex> { state->mutex };
+        if (!state->error) {
+            state->error = error;
+        }
+    }
+
+    if (state->pendingDependencyCount.fetch_sub(1) == 1) {
+        this->push(state);
+    }
+
+    return state;
+}
+
+bool JobSystem::isDone(const JobHandle& job) const {
+    return job->isDone.load();
+}
+
+void JobSystem::wait(const JobHandle& job) {
+    const auto queueIndex = this->getQueueIndex();
+    while (!this->isDone(job)) {
+        if (this->tryRunJob(queueIndex)) {
+            continue;
+        }
+
+        CPU_PROFILE_ZONE("wait for job");
+        auto lock = std::unique_lock<std::mutex> { m_mutex };
+        m_waitingCount.fetch_add(1);
+        m_wake.wait(lock, [this, &job]() { return this->isDone(job) || m_queuedCount.load() > 0; });
+        m_waitingCount.fetch_sub(1);
+    }
+
+    const auto lock = std::lock_guard<std::mutex> { job->mutex };
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
+
+uint32_t JobSystem::getQueueIndex() const {
+    if (s_workerJobSystem == this) {
+        return s_workerIndex;
+    }
+
+    return static_cast<uint32_t>(m_queues.size() - 1);
+}
+
+void JobSystem::push(JobHandle job) {
+    auto& queue = *m_queues[this->getQueueIndex()];
+    {
+        const auto lock = std::lock_guard<std::mutex> { queue.mutex };
+        queue.jobs.push_back(std::move(job));
+    }
+
+    // The count changes before the lock is taken, so a thread that tests it under the lock
+    // before it sleeps cannot miss the job.
+    m_queuedCount.fetch_add(1);
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+    }
+    m_wake.notify_one();
+}
+
+JobHandle JobSystem::pop(uint32_t queueIndex) {
+    auto& queue = *m_queues[queueIndex];
+    const auto lock = std::lock_guard<std::mutex> { queue.mutex };
+    if (queue.jobs.empty()) {
+        return nullptr;
+    }
+
+    // The shared queue has no owner to keep warm, so its jobs run in the order they came.
+    const auto isSharedQueue = queueIndex == m_queues.size() - 1;
+    auto job = JobHandle {};
+    if (isSharedQueue) {
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+    } else {
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+    }
+    m_queuedCount.fetch_sub(1);
+
+    return job;
+}
+
+JobHandle JobSystem::steal(uint32_t queueIndex) {
+    CPU_PROFILE_ZONE("steal job");
+    // Starting after the thief's own queue spreads thieves over the queues, and reaches the
+    // shared queue first from the last worker.
+    const auto queueCount = static_cast<uint32_t>(m_queues.size());
+    for (uint32_t i = 1; i < queueCount; i++) {
+        auto& queue = *m_queues[(queueIndex + i) % queueCount];
+        const auto lock = std::lock_guard<std::mutex> { queue.mutex };
+        if (queue.jobs.empty()) {
+            continue;
+        }
+
+        auto job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        m_queuedCount.fetch_sub(1);
+
+        return job;
+    }
+
+    return nullptr;
+}
+
+bool JobSystem::tryRunJob(uint32_t queueIndex) {
+    auto job = this->pop(queueIndex);
+    if (job == nullptr && m_queuedCount.load() > 0) {
+        job = this->steal(queueIndex);
+    }
+
+    if (job == nullptr) {
+        return false;
+    }
+
+    this->runJob(job);
+
+    return true;
+}
+
+void JobSystem::runJob(const JobHandle& job) {
+    CPU_PROFILE_ZONE("run job");
+    auto error = std::exception_ptr { nullptr };
+    {
+        const auto lock = std::lock_guard<std::mutex> { job->mutex };
+        error = job->error;
+    }
+
+    // A job whose dependency failed is skipped, and only passes the error on.
+    if (!error) {
+        try {
+            job->job();
+        } catch (...) {
+            const auto lock = std::lock_guard<std::mutex> { job->mutex };
+            job->error = std::current_exception();
+        }
+    }
+
+    job->job = nullptr;
+    this->finishJob(job);
+}
+
+void JobSystem::finishJob(const JobHandle& job) {
+    auto dependents = std::vector<JobHandle> {};
+    auto error = std::exception_ptr { nullptr };
+    {
+        const auto lock = std::lock_guard<std::mutex> { job->mutex };
+        job->isDone.store(true);
+        dependents = std::move(job->dependents);
+        error = job->error;
+    }
+
+    for (const auto& dependent : dependents) {
+        if (error) {
+            const auto lock = std::lock_guard<std::mutex> { dependent->mutex };
+            if (!dependent->error) {
+                dependent->error = error;
+            }
+        }
+
+        if (dependent->pendingDependencyCount.fetch_sub(1) == 1) {
+            this->push(dependent);
+        }
+    }
+
+    // A waiter counts itself before it tests whether the job is done, so either it sees
+    // the job done or the job sees it waiting.
+    if (m_waitingCount.load() > 0) {
+        this->wakeAll();
+    }
+}
+
+void JobSystem::wakeAll() {
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+    }
+    m_wake.notify_all();
+}
+
+void JobSystem::run(uint32_t workerIndex) {
+    s_workerJobSystem = this;
+    s_workerIndex = workerIndex;
+    while (true) {
+        if (this->tryRunJob(workerIndex)) {
+            continue;
+        }
+
+        auto lock = std::unique_lock<std::mutex> { m_mutex };
+        m_wake.wait(lock, [this]() { return m_isStopping || m_queuedCount.load() > 0; });
+        if (m_isStopping) {
+            return;
+        }
+    }
+}
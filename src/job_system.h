@@ -0,0 +1,149 @@
+#ifndef _JOB_SYSTEM_H
+#define _JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cpu_topology.h"
+
+
+namespace VulkanEngine {
+
+struct JobState;
+
+/// @brief Refers to a job scheduled on a `JobSystem`, for waiting on it or scheduling jobs
+/// that run after it.
+using JobHandle = std::shared_ptr<JobState>;
+
+/// @brief Runs short jobs on a pool of worker threads that steal work from each other.
+///
+/// @note Every worker has a deque of its own. A job scheduled from a worker goes on the
+/// back of the worker's deque, and the worker takes its next job from the back too, so the
+/// jobs a job spawns run while their data is still in cache. A worker with nothing left
+/// takes the jobs scheduled from other threads, then steals from the front of the other
+/// deques, which is where their oldest and usually largest jobs are.
+///
+/// A job only starts once every job it depends on has finished. A job that throws hands its
+/// error to the jobs that depend on it, which are then skipped, and `wait` rethrows it. A
+/// thread that waits on a job runs other jobs until it has finished, so waiting from inside
+/// a job never ties up a worker. Every job has to be waited for, directly or through a job
+/// that depends on it, before the system is destroyed.
+///
+/// Running, stealing, and waiting for jobs are profiled as CPU zones of their own, so the
+/// cost of scheduling shows up next to the jobs.
+///
+/// Worker `i` is pinned to the `i`-th of the CPU sets given, if there is one, which is how
+/// workers are kept to the cores of one NUMA node each.
+class JobSystem final {
+    public:
+        using Job = std::function<void()>;
+
+        explicit JobSystem() = delete;
+        explicit JobSystem(uint32_t threadCount, std::vector<CpuSet> workerCpuSets = {});
+
+        /// @brief Stop the workers once their running jobs have finished.
+        ~JobSystem();
+
+        JobSystem(const JobSystem& other) = delete;
+        JobSystem& operator=(const JobSystem& other) = delete;
+
+        uint32_t getThreadCount() const;
+
+        JobHandle schedule(Job job, const std::vector<JobHandle>& dependencies = {});
+
+        /// @brief Whether the job has finished, whether or not it failed.
+        bool isDone(const JobHandle& job) const;
+
+        /// @brief Run jobs on the calling thread until `job` has finished.
+        ///
+        /// @note A job that failed, or that was skipped because a job it depends on failed,
+        /// rethrows the error here.
+        void wait(const JobHandle& job);
+
+        /// @brief Run `function` once for every index below `count`, in jobs of `grainSize`
+        /// indices each, and return once all of them have finished.
+        ///
+        /// @note Every job is waited for before an error is rethrown, since they all refer to
+        /// `function`.
+        template <typename Function>
+        void parallelFor(size_t count, size_t grainSize, const Function& function) {
+            const auto jobSize = std::max<size_t>(grainSize, 1);
+            auto jobs = std::vector<JobHandle> {};
+            jobs.reserve((count + jobSize - 1) / jobSize);
+            for (size_t begin = 0; begin < count; begin += jobSize) {
+                const auto end = std::min(begin + jobSize, count);
+                jobs.push_back(this->schedule([&function, begin, end]() {
+                    for (size_t i = begin; i < end; i++) {
+                        function(i);
+                    }
+                }));
+            }
+
+            auto error = std::exception_ptr { nullptr };
+            for (const auto& job : jobs) {
+                try {
+                    this->wait(job);
+                } catch (...) {
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    private:
+        struct WorkerQueue final {
+            std::mutex mutex;
+            std::deque<JobHandle> jobs;
+        };
+
+        /// @brief The deques of the workers, then the queue of the jobs scheduled from
+        /// threads that are not workers.
+        std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+        std::atomic<size_t> m_queuedCount;
+        /// @brief The threads sleeping in `wait`, which a finished job has to wake.
+        std::atomic<uint32_t> m_waitingCount;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_isStopping;
+        std::vector<std::thread> m_workers;
+
+        /// @brief The index of the calling thread's deque, or the index of the queue shared
+        /// by the other threads.
+        uint32_t getQueueIndex() const;
+
+        void push(JobHandle job);
+
+        JobHandle pop(uint32_t queueIndex);
+
+        JobHandle steal(uint32_t queueIndex);
+
+        /// @brief Run one job, if any is queued.
+        bool tryRunJob(uint32_t queueIndex);
+
+        void runJob(const JobHandle& job);
+
+        void finishJob(const JobHandle& job);
+
+        /// @brief Wake the threads sleeping on `m_wake`, once the state they test has changed.
+        void wakeAll();
+
+        void run(uint32_t workerIndex);
+};
+
+}
+
+#endif // _JOB_SYSTEM_H
@@ -0,0 +1,203 @@
+#include "json_reader.h"
+
+#include <charconv>
+#include <stdexcept>
+#include <system_error>
+
+
+using JsonValue = VulkanEngine::JsonValue;
+using JsonReader = VulkanEngine::JsonReader;
+
+static void throwMalformedJson() {
+    throw std::runtime_error("failed to parse JSON: malformed document!");
+}
+
+const JsonValue* JsonValue::find(std::string_view key) const {
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (keys[i] == key) {
+            return &elements[i];
+        }
+    }
+
+    return nullptr;
+}
+
+JsonReader::JsonReader(std::string_view text)
+    : m_position { text.data() }
+    , m_end { text.data() + text.size() }
+{
+}
+
+JsonValue JsonReader::parseDocument() {
+    auto value = this->parseValue(0);
+    this->skipSpaces();
+    if (m_position != m_end) {
+        throwMalformedJson();
+    }
+
+    return value;
+}
+
+void JsonReader::skipSpaces() {
+    while (m_position < m_end && (*m_position == ' ' || *m_position == '\t' || *m_position == '\n' || *m_position == '\r')) {
+        m_position++;
+    }
+}
+
+void JsonReader::expect(char character) {
+    this->skipSpaces();
+    if (m_position == m_end || *m_position != character) {
+        throwMalformedJson();
+    }
+
+    m_position++;
+}
+
+bool JsonReader::consume(std::string_view literal) {
+    if (static_cast<size_t>(m_end - m_position) < literal.size() || std::string_view { m_position, literal.size() } != literal) {
+        return false;
+    }
+
+    m_position += literal.size();
+
+    return true;
+}
+
+bool JsonReader::consumeComma() {
+    this->skipSpaces();
+
+    return this->consume(",");
+}
+
+JsonValue JsonReader::parseValue(uint32_t depth) {
+    if (depth > MAX_DEPTH) {
+        throwMalformedJson();
+    }
+
+    this->skipSpaces();
+    if (m_position == m_end) {
+        throwMalformedJson();
+    }
+
+    auto value = JsonValue {};
+    if (*m_position == '{') {
+        value.type = JsonValue::Type::Object;
+        m_position++;
+        this->skipSpaces();
+        if (m_position < m_end && *m_position == '}') {
+            m_position++;
+
+            return value;
+        }
+
+        do {
+            this->skipSpaces();
+            value.keys.push_back(this->parseString());
+            this->expect(':');
+            value.elements.push_back(this->parseValue(depth + 1));
+        } while (this->consumeComma());
+        this->expect('}');
+    } else if (*m_position == '[') {
+        value.type = JsonValue::Type::Array;
+        m_position++;
+        this->skipSpaces();
+        if (m_position < m_end && *m_position == ']') {
+            m_position++;
+
+            return value;
+        }
+
+        do {
+            value.elements.push_back(this->parseValue(depth + 1));
+        } while (this->consumeComma());
+        this->expect(']');
+    } else if (*m_position == '"') {
+        value.type = JsonValue::Type::String;
+        value.string = this->parseString();
+    } else if (this->consume("true")) {
+        value.type = JsonValue::Type::Bool;
+        value.boolean = true;
+    } else if (this->consume("false")) {
+        value.type = JsonValue::Type::Bool;
+    } else if (this->consume("null")) {
+        value.type = JsonValue::Type::Null;
+    } else {
+        value.type = JsonValue::Type::Number;
+        const auto [next, error] = std::from_chars(m_position, m_end, value.number);
+        if (error != std::errc {}) {
+            throwMalformedJson();
+        }
+
+        m_position = next;
+    }
+
+    return value;
+}
+
+std::string JsonReader::parseString() {
+    if (m_position == m_end || *m_position != '"') {
+        throwMalformedJson();
+    }
+
+    m_position++;
+    auto string = std::string {};
+    while (m_position < m_end && *m_position != '"') {
+        if (*m_position != '\\') {
+            string.push_back(*m_position++);
+            continue;
+        }
+
+        m_position++;
+        if (m_position == m_end) {
+            throwMalformedJson();
+        }
+
+        const auto escape = *m_position++;
+        switch (escape) {
+            case '"': string.push_back('"'); break;
+            case '\\': string.push_back('\\'); break;
+            case '/': string.push_back('/'); break;
+            case 'b': string.push_back('\b'); break;
+            case 'f': string.push_back('\f'); break;
+            case 'n': string.push_back('\n'); break;
+            case 'r': string.push_back('\r'); break;
+            case 't': string.push_back('\t'); break;
+            case 'u': this->appendCodeUnit(string); break;
+            default: throwMalformedJson();
+        }
+    }
+
+    if (m_position == m_end) {
+        throwMalformedJson();
+    }
+
+    m_position++;
+
+    return string;
+}
+
+// Every UTF-16 code unit is encoded on its own. The keys and values the parser looks
+// at are all ASCII, so names with surrogate pairs only have to survive being skipped.
+void JsonReader::appendCodeUnit(std::string& string) {
+    auto codeUnit = uint32_t { 0 };
+    if (m_end - m_position < 4) {
+        throwMalformedJson();
+    }
+
+    const auto [next, error] = std::from_chars(m_position, m_position + 4, codeUnit, 16);
+    if (error != std::errc {} || next != m_position + 4) {
+        throwMalformedJson();
+    }
+
+    m_position += 4;
+    if (codeUnit < 0x80) {
+        string.push_back(static_cast<char>(codeUnit));
+    } else if (codeUnit < 0x800) {
+        string.push_back(static_cast<char>(0xc0 | (codeUnit >> 6)));
+        string.push_back(static_cast<char>(0x80 | (codeUnit & 0x3f)));
+    } else {
+        string.push_back(static_cast<char>(0xe0 | (codeUnit >> 12)));
+        string.push_back(static_cast<char>(0x80 | ((codeUnit >> 6) & 0x3f)));
+        string.push_back(static_cast<char>(0x80 | (codeUnit & 0x3f)));
+    }
+}
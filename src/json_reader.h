@@ -0,0 +1,72 @@
+#ifndef _JSON_READER_H
+#define _JSON_READER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief A value of a JSON document.
+///
+/// @note Objects keep their keys and values in two lists, in the order they were written.
+/// The documents read here have a handful of keys per object, so a linear lookup is as
+/// fast as a map.
+struct JsonValue final {
+    enum class Type {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> elements;
+    std::vector<std::string> keys;
+
+    /// @brief The value under `key` of an object, or null when it has none.
+    const JsonValue* find(std::string_view key) const;
+};
+
+/// @brief A recursive descent parser of JSON documents.
+///
+/// @note Malformed documents, and documents nested deeper than `MAX_DEPTH`, throw.
+class JsonReader final {
+    public:
+        /// @brief Nesting deeper than this is not a document the engine reads, and would only
+        /// exhaust the stack.
+        static constexpr uint32_t MAX_DEPTH = 64;
+
+        explicit JsonReader() = delete;
+        explicit JsonReader(std::string_view text);
+
+        JsonValue parseDocument();
+    private:
+        const char* m_position;
+        const char* m_end;
+
+        void skipSpaces();
+
+        void expect(char character);
+
+        bool consume(std::string_view literal);
+
+        bool consumeComma();
+
+        JsonValue parseValue(uint32_t depth);
+
+        std::string parseString();
+
+        void appendCodeUnit(std::string& string);
+};
+
+}
+
+#endif // _JSON_READER_H
@@ -0,0 +1,175 @@
+#include "ktx2_writer.h"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include "texture_format.h"
+
+
+using Ktx2Writer = VulkanEngine::Ktx2Writer;
+using TextureCacheEntry = VulkanEngine::TextureCacheEntry;
+using TextureFormats = VulkanEngine::TextureFormats;
+
+struct Ktx2Header final {
+    std::array<uint8_t, 12> identifier;
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+
+struct Ktx2LevelIndexEntry final {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+static constexpr std::array<uint8_t, 12> KTX2_IDENTIFIER = {
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+// The transfer functions and primaries of the Khronos data format specification.
+static constexpr uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+static constexpr uint32_t KHR_DF_TRANSFER_SRGB = 2;
+static constexpr uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+static constexpr uint32_t KHR_DF_VERSION = 2;
+static constexpr uint32_t KHR_DF_BASIC_BLOCK_SIZE = 24;
+
+static bool isSrgbFormat(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// @brief The size of the data type of a format, which is one for block-compressed formats,
+/// and the size of a packed texel for packed formats.
+///
+/// @note Every uncompressed format of the texture path has four channels.
+static uint32_t getTypeSize(VkFormat format, const VulkanEngine::TextureFormatInfo& formatInfo) {
+    if (formatInfo.isCompressed()) {
+        return 1;
+    }
+
+    if (format == VK_FORMAT_B10G11R11_UFLOAT_PACK32) {
+        return 4;
+    }
+
+    return formatInfo.blockSize / 4;
+}
+
+void Ktx2Writer::write(const std::filesystem::path& filePath, const TextureCacheEntry& mipChain) {
+    const auto formatInfo = TextureFormats::getInfo(mipChain.format);
+    if (!formatInfo.has_value() || mipChain.levels.empty() || mipChain.layerCount == 0) {
+        throw std::invalid_argument("a KTX2 texture needs a known format, at least one level and at least one layer!");
+    }
+
+    const auto transferFunction = isSrgbFormat(mipChain.format) ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR;
+    const auto dfd = std::array<uint32_t, 7> {
+        sizeof(uint32_t) * 7,
+        0,
+        KHR_DF_VERSION | (KHR_DF_BASIC_BLOCK_SIZE << 16),
+        (KHR_DF_PRIMARIES_BT709 << 8) | (transferFunction << 16),
+        (formatInfo->blockWidth - 1) | ((formatInfo->blockHeight - 1) << 8),
+        formatInfo->blockSize,
+        0,
+    };
+
+    // The levels follow the descriptor smallest first, each aligned to the texel block and
+    // to four bytes, as the specification asks, while the index lists them largest first.
+    const auto levelCount = static_cast<uint32_t>(mipChain.levels.size());
+    const auto levelIndexEnd = sizeof(Ktx2Header) + levelCount * sizeof(Ktx2LevelIndexEntry);
+    const auto dataStart = levelIndexEnd + sizeof(dfd);
+    const auto levelAlignment = static_cast<uint64_t>(std::lcm(formatInfo->blockSize, 4u));
+    auto levelIndex = std::vector<Ktx2LevelIndexEntry>(levelCount);
+    auto offset = static_cast<uint64_t>(dataStart);
+    for (uint32_t i = levelCount; i-- > 0;) {
+        offset = (offset + levelAlignment - 1) / levelAlignment * levelAlignment;
+        levelIndex[i] = Ktx2LevelIndexEntry {
+            .byteOffset = offset,
+            .byteLength = mipChain.levels[i].size,
+            .uncompressedByteLength = mipChain.levels[i].size,
+        };
+        offset += mipChain.levels[i].size;
+    }
+
+    const auto header = Ktx2Header {
+        .identifier = KTX2_IDENTIFIER,
+        .vkFormat = static_cast<uint32_t>(mipChain.format),
+        .typeSize = getTypeSize(mipChain.format, *formatInfo),
+        .pixelWidth = mipChain.width,
+        .pixelHeight = mipChain.height,
+        .pixelDepth = 0,
+        // A layer count of zero marks a texture that is not an array.
+        .layerCount = mipChain.layerCount > 1 ? mipChain.layerCount : 0,
+        .faceCount = 1,
+        .levelCount = levelCount,
+        .supercompressionScheme = 0,
+        .dfdByteOffset = static_cast<uint32_t>(levelIndexEnd),
+        .dfdByteLength = static_cast<uint32_t>(sizeof(dfd)),
+        .kvdByteOffset = 0,
+        .kvdByteLength = 0,
+        .sgdByteOffset = 0,
+        .sgdByteLength = 0,
+    };
+
+    auto temporaryPath = filePath;
+    temporaryPath += ".tmp";
+    {
+        auto file = std::ofstream { temporaryPath, std::ios::binary | std::ios::trunc };
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open KTX2 texture for writing!");
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(levelIndex.data()), static_cast<std::streamsize>(levelIndex.size() * sizeof(Ktx2LevelIndexEntry)));
+        file.write(reinterpret_cast<const char*>(dfd.data()), sizeof(dfd));
+
+        auto position = static_cast<uint64_t>(dataStart);
+        const auto padding = std::array<char, 16> {};
+        for (uint32_t i = levelCount; i-- > 0;) {
+            const auto& level = mipChain.levels[i];
+            file.write(padding.data(), static_cast<std::streamsize>(levelIndex[i].byteOffset - position));
+            file.write(reinterpret_cast<const char*>(mipChain.data.data() + level.offset), static_cast<std::streamsize>(level.size));
+            position = levelIndex[i].byteOffset + level.size;
+        }
+
+        if (!file) {
+            throw std::runtime_error("failed to write KTX2 texture!");
+        }
+    }
+
+    auto errorCode = std::error_code {};
+    std::filesystem::rename(temporaryPath, filePath, errorCode);
+    if (errorCode) {
+        std::filesystem::remove(temporaryPath, errorCode);
+        throw std::runtime_error("failed to move KTX2 texture into place!");
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef _KTX2_WRITER_H
+#define _KTX2_WRITER_H
+
+#include <vulkan/vulkan.h>
+
+#include <filesystem>
+
+#include "texture_cache.h"
+
+
+namespace VulkanEngine {
+
+/// @brief Writes a complete mip chain out as a KTX2 container, which the texture loader
+/// uploads as it is, without decoding the source image or generating mips.
+///
+/// @note The file holds a plain 2D texture, or a 2D array of every layer of the chain, in a
+/// native Vulkan format, with every level and no supercompression. Its data format descriptor is a basic block that names the
+/// transfer function and the texel block, but no channel samples, which the loader never
+/// reads. The file is written under a temporary name first, so a crash mid-write never
+/// leaves a truncated texture in its place.
+class Ktx2Writer final {
+    public:
+        explicit Ktx2Writer() = delete;
+
+        static void write(const std::filesystem::path& filePath, const TextureCacheEntry& mipChain);
+};
+
+}
+
+#endif // _KTX2_WRITER_H
@@ -0,0 +1,148 @@
+#include "lod_feedback.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "command_counters.h"
+
+
+using LodFeedback = VulkanEngine::LodFeedback;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+LodFeedback::LodFeedback(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    uint32_t textureCount,
+    uint32_t frameCount,
+    VkBufferUsageFlags additionalUsage
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_textureCount { textureCount }
+    , m_frameCount { frameCount }
+    , m_regionSize { 0 }
+    , m_buffer { VK_NULL_HANDLE }
+    , m_allocation {}
+    , m_isPending(frameCount, false)
+    , m_requestedLevels(textureCount, NOT_SAMPLED)
+    , m_hasResults { false }
+{
+    if (textureCount == 0 || frameCount == 0) {
+        throw std::invalid_argument("lod feedback needs at least one texture and one frame!");
+    }
+
+    this->createBuffer(additionalUsage);
+}
+
+LodFeedback::~LodFeedback() {
+    vkDestroyBuffer(m_device, m_buffer, nullptr);
+    m_allocator.free(m_allocation);
+
+    m_buffer = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void LodFeedback::beginFrame(uint32_t frameIndex) {
+    auto* levels = this->getLevels(frameIndex);
+    if (m_isPending[frameIndex]) {
+        m_allocator.invalidate(m_allocation);
+        std::copy_n(levels, m_textureCount, m_requestedLevels.begin());
+        m_hasResults = true;
+    }
+
+    std::fill_n(levels, m_textureCount, NOT_SAMPLED);
+    m_allocator.addDirtyRange(m_allocation, frameIndex * m_regionSize, m_textureCount * sizeof(uint32_t));
+    m_allocator.flushDirtyRanges();
+    m_isPending[frameIndex] = true;
+}
+
+void LodFeedback::recordReadback(VkCommandBuffer commandBuffer) const {
+    const auto memoryBarrier = VkMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        1,
+        &memoryBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+}
+
+VkDescriptorBufferInfo LodFeedback::getBufferInfo(uint32_t frameIndex) const {
+    return VkDescriptorBufferInfo {
+        .buffer = m_buffer,
+        .offset = frameIndex * m_regionSize,
+        .range = m_textureCount * sizeof(uint32_t),
+    };
+}
+
+bool LodFeedback::hasResults() const {
+    return m_hasResults;
+}
+
+std::optional<uint32_t> LodFeedback::getRequestedLevel(uint32_t textureIndex) const {
+    const auto level = m_requestedLevels.at(textureIndex);
+    if (level == NOT_SAMPLED) {
+        return std::nullopt;
+    }
+
+    return level;
+}
+
+void LodFeedback::createBuffer(VkBufferUsageFlags additionalUsage) {
+    // Every region starts at a multiple of the largest `nonCoherentAtomSize` and
+    // `minStorageBufferOffsetAlignment` there is, so it can be bound and flushed on its own.
+    const auto regionAlignment = VkDeviceSize { 256 };
+    const auto regionSize = VkDeviceSize { m_textureCount * sizeof(uint32_t) };
+    m_regionSize = (regionSize + regionAlignment - 1) / regionAlignment * regionAlignment;
+
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = m_regionSize * m_frameCount,
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | additionalUsage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto resultCreateBuffer = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+    if (resultCreateBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to create lod feedback buffer!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    // The host reads every region back, which is far faster from cached memory.
+    const auto allocation = m_allocator.allocate(
+        memRequirements,
+        m_allocator.selectUploadMemoryProperties(memRequirements.memoryTypeBits, true),
+        GpuResourceKind::Linear,
+        GpuMemoryCategory::Other
+    );
+
+    vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+    m_buffer = buffer;
+    m_allocation = allocation;
+
+    // A region no frame has written yet is read as no texture sampled.
+    for (uint32_t frame = 0; frame < m_frameCount; frame++) {
+        std::fill_n(this->getLevels(frame), m_textureCount, NOT_SAMPLED);
+    }
+    m_allocator.addDirtyRange(m_allocation, 0, m_regionSize * m_frameCount);
+    m_allocator.flushDirtyRanges();
+}
+
+uint32_t* LodFeedback::getLevels(uint32_t frameIndex) const {
+    return reinterpret_cast<uint32_t*>(static_cast<char*>(m_allocation.mappedData) + frameIndex * m_regionSize);
+}
@@ -0,0 +1,87 @@
+#ifndef _LOD_FEEDBACK_H
+#define _LOD_FEEDBACK_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief The most detailed mip level the fragment shader asked for of every texture of the
+/// texture table, as the device wrote it while drawing, read back a few frames later to
+/// drive texture streaming.
+///
+/// @note The buffer has a region of `textureCount` levels for each of `frameCount` frame
+/// slots, bound as a storage buffer the fragment shader takes the atomic minimum of its
+/// level into. `beginFrame` reads back the region of the slot, once the slot's last submit
+/// has finished, and then resets it to `NOT_SAMPLED` for the frame. The command buffer of
+/// the frame ends with `recordReadback`, which makes the shader writes visible to the host,
+/// so the levels are never waited for, only a frame slot late.
+///
+/// The buffer takes `additionalUsage` on top of its storage buffer usage, such as a device
+/// address for descriptors written by address.
+class LodFeedback final {
+    public:
+        /// @brief The level of a texture no fragment sampled.
+        static constexpr uint32_t NOT_SAMPLED = UINT32_MAX;
+
+        explicit LodFeedback() = delete;
+        explicit LodFeedback(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            uint32_t textureCount,
+            uint32_t frameCount,
+            VkBufferUsageFlags additionalUsage = 0
+        );
+
+        ~LodFeedback();
+
+        LodFeedback(const LodFeedback& other) = delete;
+        LodFeedback& operator=(const LodFeedback& other) = delete;
+
+        /// @brief Read back the levels the last frame of `frameIndex` wrote, and clear the
+        /// region for the frame that is about to be recorded in the slot.
+        ///
+        /// @note Must be called after the slot's last submit has finished.
+        void beginFrame(uint32_t frameIndex);
+
+        /// @brief Record the barrier that makes the fragment shader's writes to the buffer
+        /// visible to the host, after the last draw of the frame.
+        void recordReadback(VkCommandBuffer commandBuffer) const;
+
+        /// @brief The region of `frameIndex`, for the storage buffer descriptor of the slot.
+        VkDescriptorBufferInfo getBufferInfo(uint32_t frameIndex) const;
+
+        /// @brief Whether a frame has been read back since the feedback was created.
+        bool hasResults() const;
+
+        /// @brief The most detailed level the newest frame read back sampled
+        /// `textureIndex` at, or nothing when no fragment of it sampled the texture.
+        std::optional<uint32_t> getRequestedLevel(uint32_t textureIndex) const;
+    private:
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        uint32_t m_textureCount;
+        uint32_t m_frameCount;
+        VkDeviceSize m_regionSize;
+        VkBuffer m_buffer;
+        GpuAllocation m_allocation;
+        /// @brief Whether the region of every slot was written by a frame since it was
+        /// last read back.
+        std::vector<bool> m_isPending;
+        std::vector<uint32_t> m_requestedLevels;
+        bool m_hasResults;
+
+        void createBuffer(VkBufferUsageFlags additionalUsage);
+
+        uint32_t* getLevels(uint32_t frameIndex) const;
+};
+
+}
+
+#endif // _LOD_FEEDBACK_H
@@ -0,0 +1,202 @@
+#include "luminance_reduction.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+#include "command_counters.h"
+
+
+using LuminanceReduction = VulkanEngine::LuminanceReduction;
+using Downsampler = VulkanEngine::Downsampler;
+using DownsampleReduction = VulkanEngine::DownsampleReduction;
+using DownsampleSourceFilter = VulkanEngine::DownsampleSourceFilter;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+/// @brief The side of the first level of the chain for a side of the scene color.
+static uint32_t getReductionExtent(uint32_t sceneColorExtent) {
+    return std::min(std::bit_floor(std::max(sceneColorExtent / 2, 1u)), LuminanceReduction::MAX_EXTENT);
+}
+
+LuminanceReduction::LuminanceReduction(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    VkPipelineCache pipelineCache,
+    std::span<const uint32_t> downsampleShaderCode,
+    VkImageView sceneColorImageView,
+    VkExtent2D sceneColorExtent
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_extent { VkExtent2D { getReductionExtent(sceneColorExtent.width), getReductionExtent(sceneColorExtent.height) } }
+    , m_mipLevels { static_cast<uint32_t>(std::bit_width(std::max(m_extent.width, m_extent.height))) }
+    , m_image { VK_NULL_HANDLE }
+    , m_allocation {}
+    , m_mipViews {}
+    , m_downsampler {}
+{
+    if (sceneColorExtent.width < 4 || sceneColorExtent.height < 4) {
+        throw std::invalid_argument("luminance reduction needs a scene color at least 4 pixels a side");
+    }
+
+    this->createImage();
+    this->createImageViews();
+    m_downsampler = std::make_unique<Downsampler>(
+        m_device,
+        m_allocator,
+        pipelineCache,
+        downsampleShaderCode,
+        VK_FORMAT_R32_SFLOAT,
+        m_extent,
+        m_mipViews,
+        DownsampleReduction::Average,
+        sceneColorImageView,
+        DownsampleSourceFilter::LogLuminance
+    );
+}
+
+LuminanceReduction::~LuminanceReduction() {
+    m_downsampler.reset();
+
+    for (const auto mipView : m_mipViews) {
+        vkDestroyImageView(m_device, mipView, nullptr);
+    }
+    vkDestroyImage(m_device, m_image, nullptr);
+    m_allocator.free(m_allocation);
+
+    m_mipViews.clear();
+    m_image = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void LuminanceReduction::recordInitialization(VkCommandBuffer commandBuffer, float logLuminance) const {
+    const auto subresourceRange = VkImageSubresourceRange {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = 0,
+        .levelCount = m_mipLevels,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+
+    const auto clearBarrier = VkImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_image,
+        .subresourceRange = subresourceRange,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &clearBarrier
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    const auto clearColor = VkClearColorValue { .float32 = { logLuminance, logLuminance, logLuminance, logLuminance } };
+    vkCmdClearColorImage(commandBuffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &subresourceRange);
+
+    // The tone mapper reads the average before the first reduction writes it.
+    const auto readBarrier = VkImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_image,
+        .subresourceRange = subresourceRange,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &readBarrier
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    m_downsampler->recordInitialization(commandBuffer);
+}
+
+void LuminanceReduction::record(VkCommandBuffer commandBuffer, float adaptation) const {
+    m_downsampler->record(commandBuffer, adaptation);
+}
+
+VkImage LuminanceReduction::getImage() const {
+    return m_image;
+}
+
+uint32_t LuminanceReduction::getMipLevels() const {
+    return m_mipLevels;
+}
+
+VkImageView LuminanceReduction::getAverageImageView() const {
+    return m_mipViews.back();
+}
+
+void LuminanceReduction::createImage() {
+    const auto imageInfo = VkImageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .extent = VkExtent3D { m_extent.width, m_extent.height, 1 },
+        .mipLevels = m_mipLevels,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    auto image = VkImage {};
+    const auto resultCreateImage = vkCreateImage(m_device, &imageInfo, nullptr, &image);
+    if (resultCreateImage != VK_SUCCESS) {
+        throw std::runtime_error("failed to create luminance reduction image!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetImageMemoryRequirements(m_device, image, &memRequirements);
+
+    const auto allocation = m_allocator.allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Optimal, GpuMemoryCategory::Attachment);
+
+    vkBindImageMemory(m_device, image, allocation.memory, allocation.offset);
+
+    m_image = image;
+    m_allocation = allocation;
+}
+
+void LuminanceReduction::createImageViews() {
+    m_mipViews.reserve(m_mipLevels);
+    for (uint32_t level = 0; level < m_mipLevels; level++) {
+        const auto viewInfo = VkImageViewCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = m_image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = VK_FORMAT_R32_SFLOAT,
+            .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .subresourceRange.baseMipLevel = level,
+            .subresourceRange.levelCount = 1,
+            .subresourceRange.baseArrayLayer = 0,
+            .subresourceRange.layerCount = 1,
+        };
+
+        auto imageView = VkImageView {};
+        const auto result = vkCreateImageView(m_device, &viewInfo, nullptr, &imageView);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create luminance reduction image view!");
+        }
+
+        m_mipViews.push_back(imageView);
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef _LUMINANCE_REDUCTION_H
+#define _LUMINANCE_REDUCTION_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "downsampler.h"
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief Reduces the scene color into its log average luminance for auto exposure, in one
+/// dispatch of the shared `Downsampler`.
+///
+/// @note The reduction is an `R32_SFLOAT` chain down to a single texel, whose first level
+/// is the largest power of two on each side within half the scene color, and at most
+/// `MAX_EXTENT`. Its texels hold the log luminance of the scene color sampled between four
+/// of its pixels, so the last level holds the log of the geometric mean luminance, which
+/// a few very bright pixels do not dominate. The last level keeps a running average over
+/// frames, so that the exposure adapts to a change of scene instead of jumping to it.
+///
+/// The chain lives in `VK_IMAGE_LAYOUT_GENERAL`. The scene color has to be sampled in
+/// `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL`.
+class LuminanceReduction final {
+    public:
+        static constexpr uint32_t MAX_EXTENT = 1024;
+
+        explicit LuminanceReduction() = delete;
+        explicit LuminanceReduction(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            VkPipelineCache pipelineCache,
+            std::span<const uint32_t> downsampleShaderCode,
+            VkImageView sceneColorImageView,
+            VkExtent2D sceneColorExtent
+        );
+
+        ~LuminanceReduction();
+
+        LuminanceReduction(const LuminanceReduction& other) = delete;
+        LuminanceReduction& operator=(const LuminanceReduction& other) = delete;
+
+        /// @brief Record filling every level with `logLuminance`, and moving the chain into
+        /// its layout, for the frames that expose with it before it is first reduced.
+        void recordInitialization(VkCommandBuffer commandBuffer, float logLuminance) const;
+
+        /// @brief Record reducing the scene color, and moving the average `adaptation` of
+        /// the way toward it.
+        ///
+        /// @note Must be recorded outside of a render pass. The barriers that order the
+        /// scene color writes before it and the reads of the average after it are left to
+        /// the caller.
+        void record(VkCommandBuffer commandBuffer, float adaptation) const;
+
+        VkImage getImage() const;
+
+        uint32_t getMipLevels() const;
+
+        /// @brief The view of the last level, whose single texel is the average.
+        VkImageView getAverageImageView() const;
+    private:
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkExtent2D m_extent;
+        uint32_t m_mipLevels;
+        VkImage m_image;
+        GpuAllocation m_allocation;
+        std::vector<VkImageView> m_mipViews;
+        std::unique_ptr<Downsampler> m_downsampler;
+
+        void createImage();
+
+        void createImageViews();
+};
+
+}
+
+#endif // _LUMINANCE_REDUCTION_H
@@ -1,6 +1,68 @@
 #include <vulkan/vulkan.h>
 
 #include "engine.h"
+#include "texture_cache.h"
+#include "texture_format.h"
+#include "texture_packer.h"
+#include "cpu_mipmap_generator.h"
+#include "texture_streamer.h"
+#include "mipmap_slicer.h"
+#include "mapped_file.h"
+#include "asset_archive.h"
+#include "async_file_reader.h"
+#include "mesh_cache.h"
+#include "mesh_importer.h"
+#include "geometry_pool.h"
+#include "geometry_streamer.h"
+#include "vertex_layout.h"
+#include "secondary_command_recorder.h"
+#include "gpu_profiler.h"
+#include "dynamic_resolution.h"
+#include "temporal_upscaler.h"
+#include "shading_rate_image.h"
+#include "frame_capture.h"
+#include "frame_exporter.h"
+#include "cpu_profiler.h"
+#include "startup_timings.h"
+#include "task_graph.h"
+#include "shader_reloader.h"
+#include "graphics_pipeline_library.h"
+#include "cache_source_key.h"
+#include "uniform_ring.h"
+#include "descriptor_allocator.h"
+#include "descriptor_buffer.h"
+#include "indirect_draw_buffer.h"
+#include "draw_culler.h"
+#include "occlusion_queries.h"
+#include "performance_hud.h"
+#include "frame_latency_tracker.h"
+#include "metrics_exporter.h"
+#include "depth_pyramid.h"
+#include "luminance_reduction.h"
+#include "bloom_chain.h"
+#include "render_graph.h"
+#include "frame_arena.h"
+#include "asset_streamer.h"
+#include "job_system.h"
+#include "cpu_topology.h"
+#include "asset_registry.h"
+#include "gpu_resource_table.h"
+#include "upload_scheduler.h"
+#include "render_queue.h"
+#include "scene.h"
+#include "instance_bvh.h"
+#include "stress_scene.h"
+#include "scene_recording.h"
+#include "benchmark_baseline.h"
+#include "device_calibration.h"
+#include "device_lost_error.h"
+#include "redraw_scheduler.h"
+#include "render_texture.h"
+#include "lod_feedback.h"
+#include "virtual_texture.h"
+#include "shader_reflection.h"
+#include "command_counters.h"
+#include "shared_assets.h"
 
 #include <iostream>
 #include <stdexcept>
@@ -12,8 +74,28 @@
 #include <limits>
 #include <algorithm>
 #include <fstream>
+#include <filesystem>
 #include <chrono>
+#include <future>
 #include <unordered_set>
+#include <unordered_map>
+#include <span>
+#include <string_view>
+#include <array>
+#include <cstring>
+#include <tuple>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <bit>
+#include <atomic>
+#include <cassert>
+#include <memory_resource>
+#include <numeric>
+#include <new>
 
 #include <fmt/core.h>
 #include <fmt/ostream.h>
@@ -32,22 +114,857 @@
 #include <glm/gtx/hash.hpp>
 
 #include <stb/stb_image.h>
-#include <tiny_obj_loader/tiny_obj_loader.h>
 
 #include <compile_glsl_shaders/shaders_glsl.h>
 #include <compile_hlsl_shaders/shaders_hlsl.h>
 
 
+enum class FramePacing {
+    Unlimited,
+    FrameRateLimit,
+    LowLatency,
+};
+
+enum class BackgroundThrottle {
+    None,
+    Pause,
+    FrameRateLimit,
+};
+
 const uint32_t WIDTH = 800;
 const uint32_t HEIGHT = 600;
 
+const std::string WINDOW_TITLE = std::string { "Generating Mipmaps" };
 const std::string MODEL_PATH = std::string { "assets/viking_room/viking_room.obj" };
 const std::string TEXTURE_PATH = std::string { "assets/viking_room/viking_room.png" };
+// When this archive exists, the assets are read from it ahead of the loose files.
+// `--pack-assets <path>` packs the loose files into one.
+const std::string ASSET_ARCHIVE_PATH = std::string { "assets/viking_room.pak" };
+const std::string TEXTURE_CACHE_DIRECTORY = std::string { "cache/textures" };
+const std::string MESH_CACHE_DIRECTORY = std::string { "cache/meshes" };
+const std::string PIPELINE_CACHE_FILE = std::string { "cache/pipelines/pipeline.cache" };
+// With `--hot-reload`, the shader sources are polled for changes every
+// `SHADER_RELOAD_POLL_INTERVAL`, and the ones that change are recompiled into
+// `SHADER_RELOAD_DIRECTORY` with these compilers.
+const std::string SHADER_SOURCE_DIRECTORY = std::string { "shaders" };
+const std::string SHADER_RELOAD_DIRECTORY = std::string { "cache/shaders" };
+const auto SHADER_RELOAD_POLL_INTERVAL = std::chrono::milliseconds { 250 };
+const auto SHADER_RELOAD_COMPILERS = VulkanEngine::ShaderCompilers { .glslCompiler = "glslc", .hlslCompiler = "dxc" };
+// Where the CPU zones of the frame loop are written when the demo is built with
+// `ENABLE_CPU_PROFILING`.
+const std::string CPU_TRACE_FILE = std::string { "traces/cpu_trace.json" };
+// Print how long every step of startup took, slowest first, once the first frame is ready,
+// and write the same timings as JSON to `STARTUP_TIMINGS_FILE`.
+const bool PRINT_STARTUP_TIMINGS = true;
+const bool WRITE_STARTUP_TIMINGS = false;
+const std::string STARTUP_TIMINGS_FILE = std::string { "traces/startup_timings.json" };
+
+// The benchmark mode, run with `--benchmark`, draws a fixed number of frames with immediate
+// presents and no frame pacing, and writes its results as JSON. The first frames warm the
+// caches up and are left out of the frame times. After the frame loop, it uploads and
+// generates the mip chain of a texture of every size in `BENCHMARK_TEXTURE_SIZES`,
+// `BENCHMARK_TEXTURE_REPETITIONS` times each.
+const uint32_t BENCHMARK_FRAME_COUNT = 1000;
+const uint32_t BENCHMARK_WARMUP_FRAME_COUNT = 60;
+const std::string BENCHMARK_OUTPUT_FILE = std::string { "benchmarks/results.json" };
+const auto BENCHMARK_TEXTURE_SIZES = std::array<uint32_t, 4> { 256, 512, 1024, 2048 };
+const uint32_t BENCHMARK_TEXTURE_REPETITIONS = 5;
+
+// A benchmark run compares its frame times, startup phases and texture throughputs with
+// the baseline of its device and driver in `BENCHMARK_BASELINE_DIRECTORY`, and reports
+// every metric that regressed by the thresholds below. A device and driver without a
+// baseline take the run as theirs, and `--update-baseline` replaces the one there is. The
+// baseline does not know the options it was run with, so it only compares with runs that
+// share them.
+const std::string BENCHMARK_BASELINE_DIRECTORY = std::string { "benchmarks/baselines" };
+const auto BENCHMARK_COMPARISON_OPTIONS = VulkanEngine::BenchmarkComparisonOptions {
+    .significanceLevel = 0.01,
+    .minRelativeChange = 0.05,
+    .minMadChange = 1.0,
+    .minSingleSampleRelativeChange = 0.2,
+};
+
+// The mip benchmark, run with `--mip-benchmark`, times every mip generation backend over
+// every extent and format below instead of running the demo, and writes the results to
+// `--mip-output <path>`. Extents the device cannot create are skipped. Cube maps are timed
+// at the square extents, and volumes at the volume extents, on the GPU backends alone.
+const auto MIP_BENCHMARK_OUTPUT_FILE = "benchmarks/mip_results.json";
+const auto MIP_BENCHMARK_EXTENTS = std::array<VkExtent2D, 8> {
+    VkExtent2D { 256, 256 },
+    VkExtent2D { 1024, 1024 },
+    VkExtent2D { 4096, 4096 },
+    VkExtent2D { 16384, 16384 },
+    VkExtent2D { 1000, 1000 },
+    VkExtent2D { 1920, 1080 },
+    VkExtent2D { 3000, 2000 },
+    VkExtent2D { 8191, 4097 },
+};
+const auto MIP_BENCHMARK_VOLUME_EXTENTS = std::array<VkExtent3D, 3> {
+    VkExtent3D { 64, 64, 64 },
+    VkExtent3D { 256, 256, 256 },
+    VkExtent3D { 200, 120, 50 },
+};
+const auto MIP_BENCHMARK_FORMATS = std::array<VkFormat, 2> { VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R8G8B8A8_SRGB };
+const uint32_t MIP_BENCHMARK_REPETITIONS = 5;
+
+// The first windowed launch on a device and driver calibrates it: it runs a short set of
+// micro-benchmarks, of mip generation throughput on a `CALIBRATION_TEXTURE_SIZE` texture,
+// fill rate as blits over a `CALIBRATION_FILL_SIZE` image, upload bandwidth, and the build
+// time of the graphics pipeline, each `CALIBRATION_REPETITIONS` times. It stores what they
+// measured as the profile of the device and driver in `CALIBRATION_DIRECTORY`, and starts
+// again. Every windowed launch with a profile picks the sample count, the anisotropy, the
+// largest texture size, the frames in flight and the pipeline library links whose cost the
+// profile puts within `CALIBRATION_TARGET`, for a window of `WIDTH` by `HEIGHT`. With
+// `--calibrate`, the app measures the device again, writes its profile and exits, and with
+// `--no-calibration` it keeps the defaults. Benchmarks, deterministic and headless runs
+// keep the defaults too, so that their results only change with the code.
+const std::string CALIBRATION_DIRECTORY = std::string { "calibration" };
+const auto CALIBRATION_TARGET = VulkanEngine::CalibrationTarget {
+    .frameMilliseconds = 1000.0 / 60.0,
+    .textureLoadMilliseconds = 250.0,
+    .optimizedLinkMilliseconds = 50.0,
+};
+const uint32_t CALIBRATION_TEXTURE_SIZE = 2048;
+const uint32_t CALIBRATION_FILL_SIZE = 4096;
+const uint32_t CALIBRATION_FILL_SOURCE_SIZE = 16;
+const uint32_t CALIBRATION_FILL_BLIT_COUNT = 8;
+const uint32_t CALIBRATION_REPETITIONS = 5;
+
+// When the device is lost, as after a driver reset, the app destroys everything it created
+// on it, the engine opens the device again in place, on the instance and windows it kept,
+// and a new app starts on it. The new app builds its pipelines from the pipeline cache the
+// old device wrote out, and reads its assets back from the mesh and texture caches, so it
+// renders again after little more than a warm start. A device that keeps getting lost ends
+// the run after `DEVICE_LOST_RECOVERY_LIMIT` recoveries.
+const uint32_t DEVICE_LOST_RECOVERY_LIMIT = 3;
+
+// The headless mode, run with `--headless`, needs no display. It renders into device-local
+// images of its own instead of a swap chain, draws `HEADLESS_FRAME_COUNT` frames, or
+// `--frames <count>`, unless it benchmarks, and with `--readback <path>` writes the last
+// frame out as a PPM image. With `--export-frames` it renders into images whose memory, like
+// the timeline semaphore it signals with every frame, is exported as file descriptors, and
+// publishes every frame through a `FrameExporter` for a hardware encoder to read in place.
+const uint32_t HEADLESS_FRAME_COUNT = 1;
+const VkFormat HEADLESS_IMAGE_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+// With `--capture <directory>`, a headless run captures every `--capture-interval <count>`th
+// frame into the directory without waiting on the device. Captures are copied into a ring
+// of `CAPTURE_SLOT_COUNT` readback buffers, and written out on a worker thread, and a frame
+// that finds every slot still in use is not captured.
+const uint32_t CAPTURE_INTERVAL = 1;
+const uint32_t CAPTURE_SLOT_COUNT = 8;
+
+// With `--views <count>`, a headless run renders up to `MAX_VIEW_COUNT` camera views in
+// every pass with multiview, one per layer of its images, so every draw is recorded and
+// submitted once for all of them. The views are spaced evenly around the orbit of the
+// camera. The readback and every capture write one file per view. Per-view work the frame
+// does on the CPU, or for a single view on the GPU, is off: the draw culler, occlusion
+// queries, dynamic resolution and the passes that follow it, mesh shaders, the
+// post-process subpass and the performance HUD. Every multiview device renders at least
+// six views.
+const uint32_t MAX_VIEW_COUNT = 4;
+
+// With `--share-assets <socket path>`, the app creates the vertex and index buffers of the
+// model and its texture in memory exported as file descriptors, and hands them out through
+// a `SharedAssetPublisher` on the Unix domain socket at the path. Every app started with
+// `--import-assets <socket path>` on the same GPU imports them instead of loading and
+// uploading copies of its own, so device memory barely grows with each instance after the
+// owner. An importer waits up to `SHARED_ASSET_TIMEOUT` for the owner to start up and to
+// finish its uploads. The shared assets never change after that, so no app that shares
+// them streams the mesh or the texture, moves the mesh buffers, or paints the texture.
+const auto SHARED_ASSET_TIMEOUT = std::chrono::milliseconds { 30000 };
+const std::string SHARED_VERTEX_BUFFER_NAME = std::string { "vertices" };
+const std::string SHARED_INDEX_BUFFER_NAME = std::string { "indices" };
+const std::string SHARED_TEXTURE_NAME = std::string { "texture" };
+
+// Deduplicate the shapes of a model on all cores when it is imported.
+const bool PARALLEL_MESH_IMPORT = true;
+
+// Compile pipelines on all cores, in the background of startup and the frame loop.
+const bool PARALLEL_PIPELINE_COMPILATION = true;
+
+// Reorder imported meshes for the post-transform cache, overdraw and vertex fetch. The mesh
+// cache keys its entries by these settings, and `USE_MESH_SHADERS` decides whether meshes
+// are imported with meshlets, so entries made with other settings miss. `meshbake` bakes
+// with the settings below unless told otherwise.
+const bool OPTIMIZE_MESH = true;
+
+// Simplify imported meshes into levels of detail with about these fractions of the full
+// triangle count.
+const bool GENERATE_MESH_LODS = true;
+const auto MESH_LOD_TRIANGLE_RATIOS = std::array<float, 3> { 0.5f, 0.25f, 0.12f };
+
+// The memory of the meshes no longer in use that the mesh registry keeps loaded, so that a
+// mesh referenced again is not loaded again.
+const size_t MESH_REGISTRY_CACHE_BUDGET = 256 * 1024 * 1024;
+
+// The projected diameter in pixels below which the first simplified level of detail is
+// drawn. Every halving of the diameter below it steps one level further down.
+const float MESH_LOD_FULL_DETAIL_DIAMETER = 512.0f;
+
+// The layout vertices are uploaded in. Unorm16 positions are quantized to the bounding box
+// of their mesh. Unorm16 texture coordinates only hold coordinates in [0, 1], so meshes
+// with tiling coordinates need `VertexEncoding::Float16` instead.
+using GpuVertex = VulkanEngine::PackedVertex<VulkanEngine::VertexEncoding::Unorm16, VulkanEngine::VertexEncoding::Unorm16>;
+
+// Store the positions of the vertex buffer in their own stream, ahead of the other
+// attributes, so that depth-only passes can fetch positions alone.
+const bool SPLIT_VERTEX_STREAMS = true;
+const VkDeviceSize VERTEX_STREAM_ALIGNMENT = 16;
+
+// The shared vertex and index buffers of the geometry pool have room for this many vertices
+// and indices, or for the model when it needs more, so that later meshes fit alongside it.
+const uint32_t GEOMETRY_POOL_VERTEX_CAPACITY = 256 * 1024;
+const uint32_t GEOMETRY_POOL_INDEX_CAPACITY = 1024 * 1024;
+
+// Upload only the coarsest level of detail of a mesh with the initial batch, and stream in
+// the finer levels into the geometry pool as the view needs them. The finer levels are
+// evicted once the view no longer does, and a level that the pool has no room for is not
+// streamed in.
+const bool STREAM_MESH_LODS = true;
+
+// Draw this many copies of the mesh along each side of a square grid, spaced this far
+// apart, all in one instanced draw. The mesh shader pipeline only draws a single copy, so
+// a grid of more than one copy is drawn with the vertex pipeline.
+const uint32_t INSTANCE_GRID_SIZE = 1;
+const float INSTANCE_SPACING = 2.5f;
+
+// With any of `--stress-meshes <count>`, `--stress-overdraw <count>`, `--stress-textures
+// <count>`, `--stress-texture-size <texels>` or `--stress-materials <count>`, a synthetic
+// scene replaces the grid, so that benchmarks can sweep the work of a frame along one axis
+// at a time, and the flags left out take these values. The copies stand on a grid
+// `INSTANCE_SPACING` apart, `overdraw` of them nested on every spot, and take turns at the
+// materials by instance index. The textures are generated with their mip chains on the CPU
+// at startup. Copies with different materials cannot share a draw, so without indirect
+// draws every copy is a direct draw of its own, and the mesh shader pipeline never draws.
+const uint32_t STRESS_SCENE_MESH_COUNT = 1024;
+const uint32_t STRESS_SCENE_OVERDRAW = 1;
+const uint32_t STRESS_SCENE_TEXTURE_COUNT = 16;
+const uint32_t STRESS_SCENE_TEXTURE_SIZE = 256;
+const uint32_t STRESS_SCENE_MATERIAL_COUNT = 16;
+
+// With `PACK_STRESS_TEXTURES`, the textures of a stress scene are packed into the layers of
+// 2D array pages with `TexturePacker`, and only their first levels are generated on the
+// CPU, with the mips of every layer of every page generated on the GPU in one batch. That
+// takes a handful of images and allocations instead of one of each per texture. Every
+// texture is still sampled through a 2D view of its own layer, so the texture table and
+// the shaders stay as they are. The textures all share a format and an extent, and a
+// power-of-two extent fills its layers, so the texture coordinates need no remapping.
+// Textures of any other extent, or larger than the packer takes, keep an image each.
+const bool PACK_STRESS_TEXTURES = true;
+
+// With `--deterministic`, the scene advances by `DETERMINISTIC_FRAME_SECONDS` every frame
+// instead of by the wall clock, and nothing that depends on timing changes what a frame
+// draws: the assets load before the first frame, textures are resident in full, and the
+// resolution is fixed. With `--record-scene <path>`, the scene state of every frame is
+// written to a file once the run ends, and `--replay-scene <path>` draws the frames of
+// such a file again deterministically, exactly as they were recorded, and stops after the
+// last of them.
+const double DETERMINISTIC_FRAME_SECONDS = 1.0 / 60.0;
+
+// With `--on-demand`, the window only draws the frames that show a change of the scene, the
+// camera, the window or the streamed assets, and sleeps on the window events between
+// them. It wakes up for window events, and every `ON_DEMAND_WAIT_SECONDS` to look at what
+// no window event announces, such as reloaded shaders. Animations draw every frame while
+// they run: the orbit of the camera, which `CAMERA_ORBIT_KEY` pauses and resumes and which
+// starts out paused, asset and texture streaming, pipelines waiting to be swapped in, and
+// the performance HUD while it is shown. A change takes `ON_DEMAND_REDRAW_FRAME_COUNT`
+// frames to show, since the scene of the next frame is computed while the current one is
+// recorded. Dynamic resolution is off, since it settles over runs of frames that an idle
+// window never draws.
+const double ON_DEMAND_WAIT_SECONDS = 0.25;
+const uint32_t ON_DEMAND_REDRAW_FRAME_COUNT = 2;
+const int CAMERA_ORBIT_KEY = GLFW_KEY_O;
+
+// Draw the scene of the vertex pipeline with a single indirect draw, where the device takes
+// draw counts from buffers. Every copy of the mesh is a draw of its own, with the draws and
+// their count in a buffer that the CPU only rewrites where they change, so recording costs
+// the same however many draws there are.
+const bool USE_INDIRECT_DRAWS = true;
+
+// Sort the indirect draws of every frame by pipeline, material and depth in a render queue,
+// so that the nearest copies of the mesh draw first and hide the rest from early depth
+// tests.
+const bool SORT_DRAWS = true;
+
+// Cull the indirect draws against the view frustum in a compute pass at the start of every
+// frame, and draw only the ones that survive, compacted into a buffer of their own. Every
+// copy of the mesh is culled by its bounding sphere.
+const bool CULL_DRAWS_ON_GPU = true;
+
+// Cull the indirect draws against the view frustum on the CPU when they are not culled on
+// the GPU, with a bounding volume hierarchy over the copies' bounding spheres, and write
+// only the visible ones to the indirect draw buffer.
+const bool CULL_DRAWS_ON_CPU = true;
+
+// Draw every copy of the mesh under a predicate of its own, set by an occlusion query of
+// its bounding box drawn after the frame's draws, and skip the copies whose boxes were
+// hidden in the frame before. The queries are resolved into the predicates on the GPU, so
+// nothing waits on them, and every copy takes a direct draw of its own instead of the
+// indirect draws.
+const bool OCCLUSION_QUERIES = false;
+
+// Reduce the depth buffer into a pyramid of the farthest depths at the end of every frame,
+// and cull the draws of the next frame that the pyramid hides as well as the ones outside
+// the frustum. The depth buffer has to be stored for it instead of being discarded.
+const bool BUILD_DEPTH_PYRAMID = true;
+
+// Draw the mesh with task and mesh shaders where the device supports them, so that meshlets
+// facing away or outside the view are culled on the GPU before they are rasterized. The
+// vertex pipeline draws it everywhere else. The mesh shader fetches vertices itself, and
+// only knows split streams of Unorm16 positions and texture coordinates.
+const bool USE_MESH_SHADERS = true;
+
+// Fetch the vertices of the vertex pipeline and the depth prepass in the vertex shader, from
+// the vertex buffer read as a storage buffer by vertex index, instead of through fixed-
+// function vertex input. The pipelines then only describe the instance transforms, and not
+// the vertex layout. Like the mesh shader, the shader only knows split streams of Unorm16
+// positions and texture coordinates.
+const bool PULL_VERTICES = false;
+
+// Write the descriptors of the draw pipelines straight into a mapped descriptor buffer and
+// bind them by offset, where the device has descriptor buffers, instead of allocating
+// descriptor sets from pools and updating them. Streaming a texture into the texture table
+// is then a copy of its descriptor. The passes of their own keep their descriptor sets.
+const bool USE_DESCRIPTOR_BUFFERS = false;
+// The bytes of the descriptor buffer, which hold a full texture table for every frame in
+// flight there can be, at the largest combined image sampler descriptors devices have.
+const VkDeviceSize DESCRIPTOR_BUFFER_CAPACITY = 4 * 1024 * 1024;
+
+// Link the vertex pipeline and the depth prepass out of graphics pipeline library parts,
+// where the device has them, instead of building them in one piece. A part is compiled once
+// for its shader and state, so a reloaded shader only recompiles its own part.
+const bool USE_GRAPHICS_PIPELINE_LIBRARY = true;
+// Run the optimizer over linked pipelines as a whole. Links are then a full compile again,
+// but the pipelines run as fast as ones built in one piece. Without it, pipelines draw with
+// a fast link first, and an optimized link built in the background replaces it.
+const bool OPTIMIZE_PIPELINE_LIBRARY_LINKS = false;
+
+// Set the cull mode, front face, topology and depth state of the draw pipelines on the
+// command buffer, where the device has extended dynamic state, instead of building them in.
+// The vertex pipeline then writes its own depth until the depth prepass pipeline is ready,
+// instead of waiting for it.
+const bool USE_EXTENDED_DYNAMIC_STATE = true;
+
+// The meshlets one task shader workgroup culls, as `MESHLETS_PER_TASK` in the meshlet shaders.
+const uint32_t MESHLETS_PER_TASK = 32;
+
+// Render straight into the swap chain and depth images with dynamic rendering where the
+// device supports it, so there is no render pass, and resizes rebuild no framebuffers.
+const bool USE_DYNAMIC_RENDERING = true;
+
+// Tone map and grade the frame in a second subpass of the render pass, which reads the
+// scene color the first subpass wrote as an input attachment, so that on tile-based GPUs
+// it stays on chip and is never stored. The scene is then drawn into a transient
+// `POST_PROCESS_SCENE_COLOR_FORMAT` target in linear color, and the second subpass
+// encodes it for the swap chain. Only a render pass has subpasses, so this turns dynamic
+// rendering off, and the performance HUD and dynamic resolution with it. The defaults
+// leave the color as it is.
+const bool POST_PROCESS_SUBPASS = false;
+const VkFormat POST_PROCESS_SCENE_COLOR_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+const float POST_PROCESS_EXPOSURE = 1.0f;
+const float POST_PROCESS_CONTRAST = 1.0f;
+const float POST_PROCESS_SATURATION = 1.0f;
+
+// Expose the post process subpass for the log average luminance of the scene, which a
+// compute pass after the render pass reduces out of the scene color for the frame after,
+// with `POST_PROCESS_EXPOSURE` scaling it. The average moves
+// `POST_PROCESS_EXPOSURE_ADAPTATION` of the way toward every new frame, so the exposure
+// eases into a change of scene instead of jumping to it.
+const bool POST_PROCESS_AUTO_EXPOSURE = false;
+const float POST_PROCESS_EXPOSURE_ADAPTATION = 0.05f;
+// The luminance auto exposure brings the average to, as `MIDDLE_GREY` in the post process
+// shaders.
+const float POST_PROCESS_MIDDLE_GREY = 0.18f;
+
+// Move the color `POST_PROCESS_BLOOM_INTENSITY` of the way toward a bloom, which the same
+// compute pass blurs out of the scene color over `POST_PROCESS_BLOOM_LEVELS` halvings for
+// the frame after. Either effect stores the scene color, so it no longer stays on chip.
+const bool POST_PROCESS_BLOOM = false;
+const float POST_PROCESS_BLOOM_INTENSITY = 0.05f;
+const uint32_t POST_PROCESS_BLOOM_LEVELS = 6;
+
+// The most samples per pixel to antialias with. The device maximum is often 8 or more, which
+// costs far more than it shows, so the sample count is capped below it. The multisampled
+// targets are resolved into the swap chain image and never stored.
+const VkSampleCountFlagBits MSAA_MAX_SAMPLE_COUNT = VK_SAMPLE_COUNT_4_BIT;
+
+// Record one command buffer per frame slot and swap chain image, and re-submit it every
+// frame until the scene or the swap chain changes. Only the uniform buffer changes from
+// frame to frame, so a static scene costs no recording at all.
+const bool STATIC_SCENE = false;
+
+// Record the draws of a frame into secondary command buffers on all cores, and execute them
+// from the frame's primary command buffer. The demo draws a single mesh, which is split into
+// one run of triangles or meshlets per core, so this only pays off for much heavier scenes.
+// It has no effect on a static scene, which records its command buffers once.
+const bool PARALLEL_COMMAND_RECORDING = false;
+
+// The scratch of a frame's recording comes from an arena of its frame slot, which is rewound
+// once the slot's last submit is done. An arena that runs over grows to fit, so after the
+// first frames recording makes no heap allocations, which debug builds assert.
+const size_t FRAME_ARENA_CAPACITY = VulkanEngine::FrameArena::DEFAULT_CAPACITY;
+const uint64_t FRAME_ARENA_WARMUP_FRAME_COUNT = 16;
+
+// The worker threads that run the startup task graph next to the main thread. Loading the
+// mesh is the task that overlaps creating the engine.
+const uint32_t INIT_GRAPH_THREAD_COUNT = 1;
+
+// Time the render pass of every frame, and the startup uploads and mip generation, with GPU
+// timestamps where the graphics queue has them, and show the rolling timings of the last
+// frames in the window title, refreshed every `GPU_TIMINGS_TITLE_PERIOD` seconds.
+const bool PROFILE_GPU = true;
+const bool SHOW_GPU_TIMINGS_IN_TITLE = true;
+const double GPU_TIMINGS_TITLE_PERIOD = 0.5;
+
+// Count the vertex, clipping, fragment and compute work of every profiled scope with
+// pipeline statistics, and collect the vendor's performance counters where the device has
+// `VK_KHR_performance_query`, so that the averages printed on exit tell whether a pass is
+// bound by its vertices, its fragments or its memory traffic. Performance counters are
+// left out when the draws are recorded in parallel, since secondary command buffers cannot
+// run inside performance queries.
+const bool PROFILE_PIPELINE_STATISTICS = true;
+const bool PROFILE_PERFORMANCE_COUNTERS = true;
+
+// Draw an overlay over every frame, toggled with `PERFORMANCE_HUD_KEY`, with graphs of the
+// CPU and GPU frame times against `PERFORMANCE_HUD_BUDGET_MILLISECONDS`, the GPU times of
+// the profiled scopes, the budget of every memory heap, the uploads waiting, and the draws
+// and triangles submitted. While it is shown it costs a pass of its own and a few thousand
+// vertices written to mapped memory, and while it is hidden nothing but the frame times.
+// It is drawn with dynamic rendering into the finished swap chain image, on one device.
+const bool PERFORMANCE_HUD = true;
+const bool SHOW_PERFORMANCE_HUD = false;
+const int PERFORMANCE_HUD_KEY = GLFW_KEY_H;
+const double PERFORMANCE_HUD_BUDGET_MILLISECONDS = 1000.0 / 60.0;
+
+// With `--metrics-prometheus <port>` or `--metrics-statsd <host:port>`, the frame times, the
+// device memory in use, the streaming backlog and the dropped frames are exported for a
+// monitoring system, under names that start with `METRICS_PREFIX`. A frame that takes more
+// than one and a half refreshes at 60 Hz held the image before it on screen for an extra
+// refresh, so it counts as dropped. Statsd gets a datagram every `METRICS_STATSD_INTERVAL`.
+const std::string METRICS_PREFIX = std::string { "vulkan_engine" };
+const double METRICS_DROPPED_FRAME_MILLISECONDS = 1.5 * 1000.0 / 60.0;
+const auto METRICS_STATSD_INTERVAL = std::chrono::milliseconds { 1000 };
+
+// Render the scene at a scale of the swap chain extent that keeps the GPU time of the render
+// pass within `DYNAMIC_RESOLUTION_BUDGET_MILLISECONDS`, and upscale it into the swap chain
+// image with a linear blit. The scale never drops below `DYNAMIC_RESOLUTION_MIN_SCALE`, and
+// textures are sampled with a bias that follows it. The pass is timed with the GPU profiler,
+// so this needs one, and it needs dynamic rendering and no depth pyramid, which is built
+// from the whole depth image.
+const bool USE_DYNAMIC_RESOLUTION = false;
+const double DYNAMIC_RESOLUTION_BUDGET_MILLISECONDS = 1000.0 / 60.0;
+const float DYNAMIC_RESOLUTION_MIN_SCALE = 0.5f;
+
+// Every material samples its textures with a sampler policy: an anisotropy tier, a LOD bias
+// and a LOD range. The model texture takes `MODEL_TEXTURE_SAMPLER_POLICY`, and the materials
+// of a stress scene the policy of their filter in `STRESS_SAMPLER_POLICIES`. The sampler
+// cache caps the anisotropy of every policy at the preset of the device profile, and, with
+// dynamic resolution, one tier lower for every `DYNAMIC_RESOLUTION_FILTERING_STEP` the
+// render scale drops below 1, since a GPU that cannot keep up at full scale is better off
+// filtering less than rendering fewer pixels still.
+const auto MODEL_TEXTURE_SAMPLER_POLICY = SamplerPolicy {
+    .anisotropyTier = AnisotropyTier::High,
+    .mipLodBias = 0.0f,
+    .minLod = 0.0f,
+    .maxLod = VK_LOD_CLAMP_NONE,
+};
+const auto STRESS_SAMPLER_POLICIES = std::array<SamplerPolicy, static_cast<size_t>(StressFilter::Count)> {
+    SamplerPolicy { .anisotropyTier = AnisotropyTier::High },
+    SamplerPolicy { .anisotropyTier = AnisotropyTier::Off },
+    SamplerPolicy { .anisotropyTier = AnisotropyTier::Off },
+};
+const float DYNAMIC_RESOLUTION_FILTERING_STEP = 0.125f;
+
+// With dynamic resolution, jitter the projection by a subpixel offset every frame, and
+// accumulate the frames into an output sized history reprojected by camera motion, in place
+// of the blit and of multisampling. Frames rendered at half to two thirds of the resolution
+// then come close to native quality. The upscaler reads the frame's depth, and the history
+// goes from frame to frame, so this records every frame and does not mix with `STATIC_SCENE`.
+const bool USE_TEMPORAL_UPSCALING = true;
+
+// Shade the mesh at a coarser rate as it moves away, where the device has fragment shading
+// rates: one fragment for every 2x2 pixels from its first simplified level of detail on.
+// Coarse rates are only guaranteed up to 4 samples, so more multisampling shades every pixel.
+const bool USE_FRAGMENT_SHADING_RATE = true;
+
+// With temporal upscaling and attachment shading rates too, also build a shading rate image
+// from the luminance of the last upscaled frame, so that flat regions of the screen are
+// shaded at a coarser rate, whose texels cover `SHADING_RATE_TEXEL_SIZE` pixels on a side, or
+// the nearest size the device has. The rate of a draw and of the image are combined by
+// keeping the coarser one where the device can, and by taking the image's otherwise.
+const bool USE_SHADING_RATE_IMAGE = true;
+const uint32_t SHADING_RATE_TEXEL_SIZE = 16;
+
+// The frames the CPU may record ahead of the GPU at startup, from 1 to `MAX_FRAMES_IN_FLIGHT`.
+// The keys 1 to 4 change it while the demo runs. More frames keep the GPU busier, fewer
+// frames shorten the time from input to display.
+const uint32_t FRAMES_IN_FLIGHT = 2;
+const uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+// How the frame loop paces itself before it polls input. `FrameRateLimit` sleeps so that
+// frames start at most `FRAME_RATE_LIMIT` times a second. `LowLatency` waits for the previous
+// frame to reach the display where the device has present waits, and for the GPU to finish
+// it everywhere else, so input is sampled as late as possible before it is drawn.
+const auto FRAME_PACING = FramePacing::Unlimited;
+const double FRAME_RATE_LIMIT = 60.0;
+
+// How the frame loop holds back while the window is in the background, to leave the GPU
+// to whatever else runs on the machine. `Pause` draws nothing until the window is back,
+// and sleeps on the window events meanwhile. `FrameRateLimit` starts at most
+// `BACKGROUND_FRAME_RATE_LIMIT` frames a second, and wakes up early when the window is back.
+// A minimized window goes by `MINIMIZED_THROTTLE`, and one without the input focus by
+// `UNFOCUSED_THROTTLE`. With `SUSPEND_STREAMING_IN_BACKGROUND`, throttled frames publish no
+// streamed assets and stream in no texture levels, which wait until the window is back.
+const auto MINIMIZED_THROTTLE = BackgroundThrottle::Pause;
+const auto UNFOCUSED_THROTTLE = BackgroundThrottle::FrameRateLimit;
+const double BACKGROUND_FRAME_RATE_LIMIT = 10.0;
+const bool SUSPEND_STREAMING_IN_BACKGROUND = true;
+
+// With `--viewports <count>`, that many windows open next to the main window, one for each
+// display a single GPU drives, and each shows the frame of the main window, scaled to fit.
+// They share the device, the memory, the pipelines and the assets of the main window. The
+// frame is blitted into them in its own submission, and every window presents in one call.
+// A key or a close request in any of them goes to the app as a whole.
+const uint32_t MAX_VIEWPORT_WINDOW_COUNT = 8;
+
+// The present mode the swap chain asks for at startup. The keys I, R, M and F switch to
+// immediate, FIFO relaxed, mailbox and FIFO while the demo runs. Immediate presents never
+// wait for vertical blank, so they are the ones to run throughput benchmarks with.
+const auto PRESENT_MODE_POLICY = VulkanEngine::PresentModePolicy::Mailbox;
+
+// The images the swap chain asks for, which `--swap-images <driver, double, triple or
+// matched>` overrides. More images let more frames queue up for the display, at the cost of
+// their memory and of the latency of the frames in the queue. `Matched` follows the present
+// mode and the frames in flight, and the swap chain is created again when either changes.
+const auto SWAP_CHAIN_IMAGE_COUNT_POLICY = VulkanEngine::SwapChainImageCountPolicy::Driver;
+
+// The surface format the swap chain asks for, which falls back as
+// `Engine::selectSurfaceFormat` documents. On 10-bit and HDR formats the fragment shader
+// encodes its output for the display itself, so there is no conversion pass in between.
+// HDR formats show the scene's white at `HDR_PAPER_WHITE_NITS`.
+const auto SURFACE_FORMAT_POLICY = VulkanEngine::SurfaceFormatPolicy::Sdr;
+const float HDR_PAPER_WHITE_NITS = 200.0f;
+
+// The surface formats `--prewarm` builds pipelines for, which are every format any
+// surface format policy asks for, and the format of offscreen images. The ones the device
+// cannot render to are skipped.
+const auto PREWARM_SURFACE_FORMATS = std::array<VkSurfaceFormatKHR, 6> {
+    VkSurfaceFormatKHR { VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+    VkSurfaceFormatKHR { VK_FORMAT_R8G8B8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+    VkSurfaceFormatKHR { VK_FORMAT_A2B10G10R10_UNORM_PACK32, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+    VkSurfaceFormatKHR { VK_FORMAT_A2R10G10B10_UNORM_PACK32, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+    VkSurfaceFormatKHR { VK_FORMAT_A2B10G10R10_UNORM_PACK32, VK_COLOR_SPACE_HDR10_ST2084_EXT },
+    VkSurfaceFormatKHR { VK_FORMAT_R16G16B16A16_SFLOAT, VK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT },
+};
 
-const int MAX_FRAMES_IN_FLIGHT = 2;
+// The engine mode when neither `--engine-mode` nor `VULKAN_ENGINE_MODE` picks one. Release
+// mode enables no validation layers and creates no debug messenger.
+const auto DEFAULT_ENGINE_MODE = ENABLE_VALIDATION_LAYERS ? VulkanEngine::EngineMode::Debug : VulkanEngine::EngineMode::Release;
+
+// How long the low latency mode waits for a present to reach the display before it gives
+// up on it, in nanoseconds.
+const uint64_t PRESENT_WAIT_TIMEOUT = 100'000'000;
+
+// Generate mip chains on the CPU even when the GPU could do it, to keep that work off the GPU.
+const bool GENERATE_MIPMAPS_ON_CPU = false;
+const auto CPU_MIP_FILTER = VulkanEngine::CpuMipFilter::Kaiser;
+
+// The filter the compute mip generator downsamples with. The texture is opaque, so there is
+// no alpha coverage to preserve.
+const auto MIP_FILTER = VulkanEngine::MipFilter::Kaiser;
+const float MIP_ALPHA_CUTOFF = 0.0f;
+
+// Encode 8-bit textures into BC1, or BC3 when they have alpha, once their mip chains are
+// generated. The texture cache stores the encoded chain, so only the first launch pays for it.
+const bool COMPRESS_TEXTURES_ON_LOAD = true;
+
+// Upload KTX2 textures that the asset archive stores in compressed blocks as they are, and
+// expand them with a compute shader, instead of decompressing them on the CPU.
+const bool DECOMPRESS_ASSETS_ON_GPU = true;
+
+// The permutation of the fragment shader the pipelines are specialized for. Showing mip
+// levels shades every fragment by the level of the mip chain it samples, and the bias
+// shifts that level. Alpha testing is on when the mips preserve alpha coverage, with the
+// same cutoff.
+const bool SHOW_MIP_LEVELS = false;
+const float TEXTURE_LOD_BIAS = 0.0f;
+
+// The global texture table holds up to this many textures, and every draw samples the
+// one its material names by index, so the whole scene binds one descriptor set per frame.
+// The texture of the model comes first, and the materials of a stress scene follow it.
+const uint32_t MAX_TEXTURE_TABLE_SIZE = 4096;
+const uint32_t MODEL_TEXTURE_INDEX = 0;
+const uint32_t STRESS_MATERIAL_TEXTURE_INDEX = MODEL_TEXTURE_INDEX + 1;
+
+// Upload only the smallest levels of a texture whose mip chain is already on the CPU, and
+// stream in the detailed levels once the view needs them.
+const bool STREAM_TEXTURE_MIPS = true;
+const uint32_t STREAMING_RESIDENT_LEVEL_COUNT = 4;
+
+// Generate the mip chain of a texture decoded mid-session a few levels per frame, within
+// the upload budget, rather than in the batch that uploads its level 0. Sampling is clamped
+// to the levels generated so far.
+const bool SLICE_STREAMED_MIP_GENERATION = true;
+const uint32_t MAX_MIP_LEVELS_PER_FRAME = 2;
+
+// Back streamed textures with sparse residency where the device supports it, so that only
+// the levels the view needs occupy memory.
+const bool USE_SPARSE_TEXTURES = true;
+const VkDeviceSize SPARSE_TEXTURE_MEMORY_BUDGET = 256 * 1024 * 1024;
+
+// Stream the levels the fragment shader actually samples instead of the ones the projected
+// size of the mesh suggests. One fragment in every tile of `LOD_FEEDBACK_TILE_SIZE` pixels
+// a side writes the level it sampled to a feedback buffer, a different one each frame, so
+// the atomics stay few and every pixel is covered over a few frames. The buffer is read
+// back once the frame slot comes around again, and a texture no fragment sampled streams
+// down to its least detailed level. It needs stores from fragment shaders and one device.
+const bool LOD_FEEDBACK = true;
+const uint32_t LOD_FEEDBACK_TILE_SIZE = 4;
+
+// Stream the model texture as a virtual texture instead, cut into pages of every level of
+// which only the ones the view samples sit in an atlas of
+// `VIRTUAL_TEXTURE_ATLAS_TILES_PER_ROW` tiles a side, for textures too large to keep even
+// a level of in device memory. The fragment shader finds the pages through a page table
+// and writes the ones it samples to a feedback buffer, like the LOD feedback. Off by
+// default, since the shader filters the atlas itself, without anisotropy. It needs what
+// the LOD feedback does, and a texture of four bytes a texel from the texture cache, and
+// loads the texture before the first frame instead of through the asset streamer.
+const bool VIRTUAL_TEXTURE = false;
+const uint32_t VIRTUAL_TEXTURE_ATLAS_TILES_PER_ROW = 16;
+
+// Copy complete mip chains from host memory straight into their images where the device
+// can, instead of through the staging ring and a copy on the GPU.
+const bool USE_HOST_IMAGE_COPY = true;
+
+// Holding `TEXTURE_PAINT_KEY` paints a square of `TEXTURE_PAINT_SIZE` texels into the model
+// texture every frame, through `updateTextureRegion`, which uploads the square alone and
+// filters only the texels of the lower levels that it changes. Only an 8-bit texture whose
+// whole mip chain went through the staging ring uncompressed takes the paint, so streamed,
+// compressed and host copied textures stay as they are.
+const int TEXTURE_PAINT_KEY = GLFW_KEY_P;
+const uint32_t TEXTURE_PAINT_SIZE = 32;
+
+// Draw a dashboard of the frame time graphs into an offscreen target of
+// `DASHBOARD_TEXTURE_SIZE` texels a side every frame, and sample it as the model texture,
+// the way a reflection probe or a minimap is rendered and then sampled from a distance.
+// The compute queue fills the mip chain of the target after the frame has drawn it, and
+// every frame samples the one the frame before drew, so the graphics queue never waits on
+// the downsampling of its own frame. It is drawn with the performance HUD, which needs
+// dynamic rendering and one device, and never into the command buffers of a static scene.
+const bool DASHBOARD_TEXTURE = false;
+const uint32_t DASHBOARD_TEXTURE_SIZE = 512;
+
+// Load the texture of the model on worker threads while the first frames render, and sample
+// a placeholder texel until its upload has finished, so the first frame does not wait for
+// the texture to decode. Assets with a higher priority load first, and workers only start
+// loading another asset while the ones waiting for their upload fit inside the budget.
+// Benchmarks and headless runs load the texture before the first frame, so every frame
+// they measure or read back shows it.
+const bool STREAM_ASSETS = true;
+const uint32_t ASSET_STREAMING_THREAD_COUNT = 2;
+
+// The number of file reads kept in flight at once, enough to keep an NVMe queue busy.
+const uint32_t FILE_READ_QUEUE_DEPTH = 32;
+
+// Place threads by the CPU topology. The render thread, which records and submits every
+// frame and creates the device, runs on the performance cores of the first NUMA node that
+// has them, and the decode and I/O threads that fill the memory it stages run on the
+// efficiency cores of that node, or beside the render thread where it has none, so that
+// asset loads never cross nodes. Job workers are spread over the performance cores of
+// every node, each one kept to a single node. Thread pools started later from the render
+// thread without CPUs of their own inherit its affinity.
+const bool PIN_THREADS_TO_CPU_TOPOLOGY = true;
+
+// The frame loop runs on a render thread of its own, and the main thread only pumps the
+// events of the window and forwards them to it through a lock-free queue. Frames keep
+// their cadence while the platform holds the event loop up, as some do for as long as a
+// window is dragged or resized. Otherwise the main thread takes turns at both. Headless
+// runs have no events to pump, and render on the main thread either way.
+const bool SEPARATE_RENDER_THREAD = true;
+
+const size_t ASSET_STREAMING_MEMORY_BUDGET = 256 * 1024 * 1024;
+const int32_t MODEL_TEXTURE_PRIORITY = 0;
+
+// Cap what streaming uploads in a frame to what the transfer throughput, measured from the
+// GPU time of upload batches, moves in the time the render pass leaves free under the
+// frame budget, and to a number of copies. Streamed mip levels larger than that go out a
+// range of rows per frame. The minimum keeps streaming moving on a busy GPU, and the
+// initial throughput holds until the first upload has been timed.
+const double UPLOAD_FRAME_BUDGET_MILLISECONDS = 1000.0 / 60.0;
+const VkDeviceSize UPLOAD_MIN_BYTES_PER_FRAME = 256 * 1024;
+const VkDeviceSize UPLOAD_MAX_BYTES_PER_FRAME = 16 * 1024 * 1024;
+const uint32_t UPLOAD_MAX_COPIES_PER_FRAME = 32;
+const double UPLOAD_INITIAL_BYTES_PER_MILLISECOND = 1024.0 * 1024.0;
+
+// Hold the streamed texture one level coarser than the view needs, and give its evicted
+// pages back to the heap, whenever a device local heap uses more than this share of its
+// budget. Levels come back one at a time once usage falls below the lower share. The bias
+// only moves once every frame in flight has picked up the last change.
+const float MEMORY_BUDGET_EVICTION_THRESHOLD = 0.9f;
+const float MEMORY_BUDGET_RESTORE_THRESHOLD = 0.75f;
+
+// Compact device memory over long sessions by moving the mesh buffers out of mostly free
+// memory blocks into fuller ones, one buffer at a time, so that the blocks content left
+// behind can go back to the driver. A move is only tried once every interval while no asset
+// is loading. Benchmarks leave their memory where it is.
+const bool DEFRAGMENT_MEMORY = true;
+const uint32_t DEFRAGMENTATION_INTERVAL = 120;
+
+const glm::vec3 CAMERA_POSITION = glm::vec3(2.0f, 2.0f, 2.0f);
+const float CAMERA_FIELD_OF_VIEW = glm::radians(45.0f);
+const float CAMERA_NEAR_PLANE = 0.1f;
+// Only the standard depth range has a far plane.
+const float CAMERA_FAR_PLANE = 10.0f;
+
+// Map the near plane to a depth of one and a far plane at infinity to zero, test depth with
+// `GREATER`, and clear it to zero. Floating point depth is most precise near zero, which
+// evens out the precision a perspective divide piles up at the near plane.
+const bool REVERSE_Z = true;
+// The depth the far plane maps to, which depth is cleared to.
+const float FAR_DEPTH = REVERSE_Z ? 0.0f : 1.0f;
 
 
 using Engine = VulkanEngine::Engine;
+using DeviceDispatch = VulkanEngine::DeviceDispatch;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+using CommandFrameCounts = VulkanEngine::CommandFrameCounts;
+using CommandCounts = VulkanEngine::CommandCounts;
+using GpuAllocation = VulkanEngine::GpuAllocation;
+using UploadBatch = VulkanEngine::UploadBatch;
+using QueueSubmission = VulkanEngine::QueueSubmission;
+using SemaphoreSubmit = VulkanEngine::SemaphoreSubmit;
+using UniformRing = VulkanEngine::UniformRing;
+using DescriptorAllocator = VulkanEngine::DescriptorAllocator;
+using DescriptorPoolRatio = VulkanEngine::DescriptorPoolRatio;
+using DescriptorWrite = VulkanEngine::DescriptorWrite;
+using DescriptorBuffer = VulkanEngine::DescriptorBuffer;
+using DescriptorBufferSet = VulkanEngine::DescriptorBufferSet;
+using IndirectDrawBuffer = VulkanEngine::IndirectDrawBuffer;
+using DrawCuller = VulkanEngine::DrawCuller;
+using OcclusionQueries = VulkanEngine::OcclusionQueries;
+using PerformanceHud = VulkanEngine::PerformanceHud;
+using PerformanceHudSeries = VulkanEngine::PerformanceHudSeries;
+using FrameLatencyTracker = VulkanEngine::FrameLatencyTracker;
+using FrameLatencyStatistics = VulkanEngine::FrameLatencyStatistics;
+using MetricsExporter = VulkanEngine::MetricsExporter;
+using MetricsEndpoint = VulkanEngine::MetricsEndpoint;
+using MetricsTransport = VulkanEngine::MetricsTransport;
+using MetricsGauge = VulkanEngine::MetricsGauge;
+using DepthPyramid = VulkanEngine::DepthPyramid;
+using DepthReduction = VulkanEngine::DepthReduction;
+using LuminanceReduction = VulkanEngine::LuminanceReduction;
+using BloomChain = VulkanEngine::BloomChain;
+using RenderTexture = VulkanEngine::RenderTexture;
+using LodFeedback = VulkanEngine::LodFeedback;
+using ShaderReflection = VulkanEngine::ShaderReflection;
+using DescriptorSetLayoutBinding = VulkanEngine::DescriptorSetLayoutBinding;
+using VirtualTexture = VulkanEngine::VirtualTexture;
+using RenderGraph = VulkanEngine::RenderGraph;
+using RenderGraphState = VulkanEngine::RenderGraphState;
+using RenderGraphUse = VulkanEngine::RenderGraphUse;
+using FrameArena = VulkanEngine::FrameArena;
+using AssetStreamer = VulkanEngine::AssetStreamer;
+using UploadScheduler = VulkanEngine::UploadScheduler;
+using RenderQueue = VulkanEngine::RenderQueue;
+using Scene = VulkanEngine::Scene;
+using InstanceBvh = VulkanEngine::InstanceBvh;
+using StressSceneOptions = VulkanEngine::StressSceneOptions;
+using StressSceneGenerator = VulkanEngine::StressSceneGenerator;
+using StressFilter = VulkanEngine::StressFilter;
+using SamplerPolicy = VulkanEngine::SamplerPolicy;
+using AnisotropyTier = VulkanEngine::AnisotropyTier;
+using SceneRecording = VulkanEngine::SceneRecording;
+using SceneRecordingFrame = VulkanEngine::SceneRecordingFrame;
+using PhysicalDeviceSelector = VulkanEngine::PhysicalDeviceSelector;
+using BenchmarkBaseline = VulkanEngine::BenchmarkBaseline;
+using BenchmarkMetric = VulkanEngine::BenchmarkMetric;
+using BenchmarkMetricComparison = VulkanEngine::BenchmarkMetricComparison;
+using DeviceCalibration = VulkanEngine::DeviceCalibration;
+using DeviceLostError = VulkanEngine::DeviceLostError;
+using CalibrationMeasurements = VulkanEngine::CalibrationMeasurements;
+using PerformancePreset = VulkanEngine::PerformancePreset;
+using RedrawScheduler = VulkanEngine::RedrawScheduler;
+using AnimationSource = VulkanEngine::AnimationSource;
+using PreparedAsset = VulkanEngine::PreparedAsset;
+using JobSystem = VulkanEngine::JobSystem;
+using JobHandle = VulkanEngine::JobHandle;
+using HostImageCopier = VulkanEngine::HostImageCopier;
+using CpuTopology = VulkanEngine::CpuTopology;
+using CpuSet = VulkanEngine::CpuSet;
+using AssetKey = VulkanEngine::AssetKey;
+template <typename Asset>
+using AssetRegistry = VulkanEngine::AssetRegistry<Asset>;
+template <typename Asset>
+using LoadedAsset = VulkanEngine::LoadedAsset<Asset>;
+using GpuResourceTable = VulkanEngine::GpuResourceTable;
+using GpuBufferHandle = VulkanEngine::GpuBufferHandle;
+using GpuTimelineValue = VulkanEngine::GpuTimelineValue;
+using MipmapTarget = VulkanEngine::MipmapTarget;
+using CompressionTarget = VulkanEngine::CompressionTarget;
+using DecompressionTarget = VulkanEngine::DecompressionTarget;
+using GpuDecompressor = VulkanEngine::GpuDecompressor;
+using TextureCache = VulkanEngine::TextureCache;
+using TextureCacheEntry = VulkanEngine::TextureCacheEntry;
+using TextureCacheLevel = VulkanEngine::TextureCacheLevel;
+using TextureFormats = VulkanEngine::TextureFormats;
+using TexturePacker = VulkanEngine::TexturePacker;
+using TexturePackerSettings = VulkanEngine::TexturePackerSettings;
+using TexturePacking = VulkanEngine::TexturePacking;
+using TexturePlacement = VulkanEngine::TexturePlacement;
+using PackedTextureSource = VulkanEngine::PackedTextureSource;
+using CpuMipmapGenerator = VulkanEngine::CpuMipmapGenerator;
+using TextureStreamer = VulkanEngine::TextureStreamer;
+using MipmapSlicer = VulkanEngine::MipmapSlicer;
+using AssetArchive = VulkanEngine::AssetArchive;
+using AssetArchiveEntry = VulkanEngine::AssetArchiveEntry;
+using AssetCompression = VulkanEngine::AssetCompression;
+using AssetFile = VulkanEngine::AssetFile;
+using AsyncFileReader = VulkanEngine::AsyncFileReader;
+using AsyncReadRequest = VulkanEngine::AsyncReadRequest;
+using AsyncReadHandle = VulkanEngine::AsyncReadHandle;
+using MeshCache = VulkanEngine::MeshCache;
+using MeshCacheEntry = VulkanEngine::MeshCacheEntry;
+using GeometryPool = VulkanEngine::GeometryPool;
+using GeometryRange = VulkanEngine::GeometryRange;
+using GeometryStreamer = VulkanEngine::GeometryStreamer;
+using GeometryUpload = VulkanEngine::GeometryUpload;
+using MeshLod = VulkanEngine::MeshLod;
+using MeshletLod = VulkanEngine::MeshletLod;
+using Vertex = VulkanEngine::Vertex;
+using Mesh = VulkanEngine::Mesh;
+using MeshImporter = VulkanEngine::MeshImporter;
+using MeshImportSettings = VulkanEngine::MeshImportSettings;
+using PipelineCompiler = VulkanEngine::PipelineCompiler;
+using PipelineHandle = VulkanEngine::PipelineHandle;
+using GraphicsPipelineLibrary = VulkanEngine::GraphicsPipelineLibrary;
+using GraphicsPipelinePartKeys = VulkanEngine::GraphicsPipelinePartKeys;
+using CacheSourceKey = VulkanEngine::CacheSourceKey;
+using PresentModePolicy = VulkanEngine::PresentModePolicy;
+using SwapChainImageCountPolicy = VulkanEngine::SwapChainImageCountPolicy;
+using SurfaceFormatPolicy = VulkanEngine::SurfaceFormatPolicy;
+using SecondaryCommandRecorder = VulkanEngine::SecondaryCommandRecorder;
+using GpuProfiler = VulkanEngine::GpuProfiler;
+using DynamicResolution = VulkanEngine::DynamicResolution;
+using TemporalUpscaler = VulkanEngine::TemporalUpscaler;
+using TemporalUpscaleFrame = VulkanEngine::TemporalUpscaleFrame;
+using ShadingRateImage = VulkanEngine::ShadingRateImage;
+using FrameCapture = VulkanEngine::FrameCapture;
+using CaptureEncoding = VulkanEngine::CaptureEncoding;
+using FrameExporter = VulkanEngine::FrameExporter;
+using CpuProfiler = VulkanEngine::CpuProfiler;
+using StartupTimings = VulkanEngine::StartupTimings;
+using StartupTimeline = VulkanEngine::StartupTimeline;
+using TaskGraph = VulkanEngine::TaskGraph;
+using TaskAffinity = VulkanEngine::TaskAffinity;
+using DeviceSelection = VulkanEngine::DeviceSelection;
+using DeviceGroupMode = VulkanEngine::DeviceGroupMode;
+using EngineMode = VulkanEngine::EngineMode;
+using ShaderReloader = VulkanEngine::ShaderReloader;
+using SharedAssetPublisher = VulkanEngine::SharedAssetPublisher;
+using SharedAssetImporter = VulkanEngine::SharedAssetImporter;
+using HlslShader = shaders_hlsl::HlslShader;
 
 
 class StbTextureImage final {
@@ -60,9 +977,33 @@ class StbTextureImage final {
                 m_width = 0;
                 m_height = 0;
                 m_channels = 0;
+                m_format = VK_FORMAT_UNDEFINED;
             }
         }
 
+        // The pixels are owned by the image, so it can be moved between threads but not copied.
+        StbTextureImage(const StbTextureImage& other) = delete;
+        StbTextureImage& operator=(const StbTextureImage& other) = delete;
+
+        StbTextureImage(StbTextureImage&& other) noexcept
+            : m_width { std::exchange(other.m_width, 0) }
+            , m_height { std::exchange(other.m_height, 0) }
+            , m_channels { std::exchange(other.m_channels, 0) }
+            , m_format { std::exchange(other.m_format, VK_FORMAT_UNDEFINED) }
+            , m_pixels { std::exchange(other.m_pixels, nullptr) }
+        {
+        }
+
+        StbTextureImage& operator=(StbTextureImage&& other) noexcept {
+            std::swap(m_width, other.m_width);
+            std::swap(m_height, other.m_height);
+            std::swap(m_channels, other.m_channels);
+            std::swap(m_format, other.m_format);
+            std::swap(m_pixels, other.m_pixels);
+
+            return *this;
+        }
+
         const stbi_uc& pixels() const {
             return *m_pixels;
         }
@@ -78,11 +1019,20 @@ class StbTextureImage final {
         inline uint32_t channels() const noexcept {
             return m_channels;
         }
+
+        /// @brief The format of the pixels, which always have four channels.
+        ///
+        /// @note 8-bit images are sRGB encoded. HDR and 16-bit images are converted to
+        /// linear half floats, so they keep their range and precision.
+        inline VkFormat format() const noexcept {
+            return m_format;
+        }
     private:
-        uint32_t m_width;
-        uint32_t m_height;
-        uint32_t m_channels;
-        stbi_uc* m_pixels;
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+        uint32_t m_channels = 0;
+        VkFormat m_format = VK_FORMAT_UNDEFINED;
+        stbi_uc* m_pixels = nullptr;
 
         friend class StbTextureLoader;
 };
@@ -92,12 +1042,49 @@ class StbTextureLoader final {
         explicit StbTextureLoader(const std::string& filePath) : m_filePath { filePath } {}
 
         StbTextureImage load() {
+            const auto textureFile = AssetFile { m_filePath };
+            if (textureFile.getSize() > static_cast<size_t>(std::numeric_limits<int>::max())) {
+                throw std::runtime_error("failed to load texture image: the file is too large!");
+            }
+
+            const auto* fileData = textureFile.getData();
+            const auto fileSize = static_cast<int>(textureFile.getSize());
+            const auto isHdr = stbi_is_hdr_from_memory(fileData, fileSize) != 0;
             int textureWidth = 0;
             int textureHeight = 0;
             int textureChannels = 0;
-            stbi_uc* pixels = stbi_load(m_filePath.c_str(), &textureWidth, &textureHeight, &textureChannels, STBI_rgb_alpha);
-        
-            const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(textureWidth, textureHeight)))) + 1;
+            auto format = VK_FORMAT_R8G8B8A8_SRGB;
+            stbi_uc* pixels = nullptr;
+            if (isHdr) {
+                format = VK_FORMAT_R16G16B16A16_SFLOAT;
+                pixels = reinterpret_cast<stbi_uc*>(stbi_loadf_from_memory(
+                    fileData,
+                    fileSize,
+                    &textureWidth,
+                    &textureHeight,
+                    &textureChannels,
+                    STBI_rgb_alpha
+                ));
+            } else if (stbi_is_16_bit_from_memory(fileData, fileSize)) {
+                format = VK_FORMAT_R16G16B16A16_SFLOAT;
+                pixels = reinterpret_cast<stbi_uc*>(stbi_load_16_from_memory(
+                    fileData,
+                    fileSize,
+                    &textureWidth,
+                    &textureHeight,
+                    &textureChannels,
+                    STBI_rgb_alpha
+                ));
+            } else {
+                pixels = stbi_load_from_memory(
+                    fileData,
+                    fileSize,
+                    &textureWidth,
+                    &textureHeight,
+                    &textureChannels,
+                    STBI_rgb_alpha
+                );
+            }
 
             if (!pixels) {
                 throw std::runtime_error("failed to load texture image!");
@@ -108,1698 +1095,13079 @@ class StbTextureLoader final {
             textureImage.m_width = textureWidth;
             textureImage.m_height = textureHeight;
             textureImage.m_channels = textureChannels;
+            textureImage.m_format = format;
+
+            if (isHdr) {
+                StbTextureLoader::convertFloatsToHalves(pixels, size_t { 4 } * textureWidth * textureHeight);
+            } else if (format == VK_FORMAT_R16G16B16A16_SFLOAT) {
+                StbTextureLoader::convertSrgbShortsToHalves(pixels, size_t { 4 } * textureWidth * textureHeight);
+            }
 
             return textureImage;
         }
     private:
         const std::string& m_filePath;
-};
 
-struct Vertex {
-    glm::vec3 position;
-    glm::vec3 color;
-    glm::vec2 texCoord;
-
-    static VkVertexInputBindingDescription getBindingDescription() {
-        const auto bindingDescription = VkVertexInputBindingDescription {
-            .binding = 0,
-            .stride = sizeof(Vertex),
-            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-        };
-
-        return bindingDescription;
-    }
-
-    static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
-        const auto attributeDescriptions = std::array<VkVertexInputAttributeDescription, 3> {
-            VkVertexInputAttributeDescription {
-                .binding = 0,
-                .location = 0,
-                .format = VK_FORMAT_R32G32B32_SFLOAT,
-                .offset = offsetof(Vertex, position),
-            },
-            VkVertexInputAttributeDescription {
-                .binding = 0,
-                .location = 1,
-                .format = VK_FORMAT_R32G32B32_SFLOAT,
-                .offset = offsetof(Vertex, color),
-            },
-            VkVertexInputAttributeDescription {
-                .binding = 0,
-                .location = 2,
-                .format = VK_FORMAT_R32G32_SFLOAT,
-                .offset = offsetof(Vertex, texCoord),
-            },
-        };
+        // The halves replace the floats in place, since every half is written at or before
+        // the float it comes from.
+        static void convertFloatsToHalves(stbi_uc* pixels, size_t valueCount) {
+            for (size_t i = 0; i < valueCount; i++) {
+                auto value = 0.0f;
+                std::memcpy(&value, pixels + sizeof(float) * i, sizeof(float));
+                const auto half = TextureFormats::toHalf(value);
+                std::memcpy(pixels + sizeof(uint16_t) * i, &half, sizeof(uint16_t));
+            }
+        }
 
-        return attributeDescriptions;
-    }
+        // 16-bit files store sRGB encoded color like 8-bit files do, so the color channels are
+        // decoded to linear, which is what mips are filtered in and what float formats hold.
+        static void convertSrgbShortsToHalves(stbi_uc* pixels, size_t valueCount) {
+            for (size_t i = 0; i < valueCount; i++) {
+                auto value = uint16_t { 0 };
+                std::memcpy(&value, pixels + sizeof(uint16_t) * i, sizeof(uint16_t));
+                auto channel = static_cast<float>(value) / 65535.0f;
+                if (i % 4 != 3) {
+                    channel = (channel <= 0.04045f) ? channel / 12.92f : std::pow((channel + 0.055f) / 1.055f, 2.4f);
+                }
 
-    bool operator==(const Vertex& other) const {
-        return position == other.position && color == other.color && texCoord == other.texCoord;
-    }
+                const auto half = TextureFormats::toHalf(channel);
+                std::memcpy(pixels + sizeof(uint16_t) * i, &half, sizeof(uint16_t));
+            }
+        }
 };
 
-namespace std {
-    template<> struct hash<Vertex> {
-        size_t operator()(Vertex const& vertex) const {
-            return ((hash<glm::vec3>()(vertex.position) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (hash<glm::vec2>()(vertex.texCoord) << 1);
-        }
-    };
-}
+/// @brief A decoded texture, together with the file it was decoded from.
+struct StbDecodedTexture final {
+    std::string filePath;
+    StbTextureImage image;
+};
 
-class Mesh final {
+/// @brief Decodes texture files on a pool of worker threads.
+///
+/// @note Files are decoded in the order they are enqueued, but finish in any order.
+/// `waitNext` hands them out in the order they finish, so the caller can record the upload
+/// of one texture while the rest are still decoding.
+class StbTextureDecodePool final {
     public:
-        explicit Mesh() = default;
-        explicit Mesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
-            : m_vertices { vertices }
-            , m_indices { indices }
+        explicit StbTextureDecodePool() = delete;
+        explicit StbTextureDecodePool(uint32_t threadCount, CpuSet cpus = {})
+            : m_isStopping { false }
+            , m_pendingCount { 0 }
         {
+            for (uint32_t i = 0; i < std::max(threadCount, 1u); i++) {
+                m_workers.emplace_back([this, cpus]() {
+                    CpuTopology::pinCurrentThread(cpus);
+                    this->run();
+                });
+            }
         }
 
-        explicit Mesh(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices)
-            : m_vertices { vertices }
-            , m_indices { indices }
-        {
+        ~StbTextureDecodePool() {
+            {
+                const auto lock = std::lock_guard<std::mutex> { m_mutex };
+                m_isStopping = true;
+            }
+
+            m_workAvailable.notify_all();
+            for (auto& worker : m_workers) {
+                worker.join();
+            }
+        }
+
+        void enqueue(const std::string& filePath) {
+            {
+                const auto lock = std::lock_guard<std::mutex> { m_mutex };
+                m_filePaths.push_back(filePath);
+                m_pendingCount++;
+            }
+
+            m_workAvailable.notify_one();
         }
 
-        const std::vector<Vertex>& vertices() const {
-            return m_vertices;
+        /// @brief Whether any enqueued file has not been handed out by `waitNext` yet.
+        bool hasPending() const {
+            const auto lock = std::lock_guard<std::mutex> { m_mutex };
+
+            return m_pendingCount > 0;
         }
 
-        const std::vector<uint32_t>& indices() const {
-            return m_indices;
+        /// @brief Wait for the next decode to finish.
+        ///
+        /// @note A file that failed to decode rethrows its error here.
+        StbDecodedTexture waitNext() {
+            auto lock = std::unique_lock<std::mutex> { m_mutex };
+            if (m_pendingCount == 0) {
+                throw std::logic_error("no texture decodes are pending!");
+            }
+
+            m_resultAvailable.wait(lock, [this]() { return !m_results.empty(); });
+
+            auto result = std::move(m_results.front());
+            m_results.pop_front();
+            m_pendingCount--;
+            lock.unlock();
+
+            if (result.error) {
+                std::rethrow_exception(result.error);
+            }
+
+            return std::move(result.texture);
         }
     private:
-        std::vector<Vertex> m_vertices;
-        std::vector<uint32_t> m_indices;
-};
+        struct DecodeResult final {
+            StbDecodedTexture texture;
+            std::exception_ptr error;
+        };
 
-class MeshLoader final {
-    public:
-        explicit MeshLoader() = default;
-
-        Mesh load(const std::string& filePath) const {
-            auto attrib = tinyobj::attrib_t {};
-            auto shapes = std::vector<tinyobj::shape_t> {};
-            auto materials = std::vector<tinyobj::material_t> {};
-            auto warn = std::string {}; 
-            auto err = std::string {};
-
-            if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filePath.c_str())) {
-                throw std::runtime_error(warn + err);
-            }
-
-            auto uniqueVertices = std::unordered_map<Vertex, uint32_t> {};
-            auto vertices = std::vector<Vertex> {};
-            auto indices = std::vector<uint32_t> {};
-            for (const auto& shape : shapes) {
-                for (const auto& index : shape.mesh.indices) {
-                    const auto vertex = Vertex {
-                        .position = glm::vec3 {
-                            attrib.vertices[3 * index.vertex_index + 0],
-                            attrib.vertices[3 * index.vertex_index + 1],
-                            attrib.vertices[3 * index.vertex_index + 2]
-                        },
-                        .texCoord = glm::vec2 {
-                            attrib.texcoords[2 * index.texcoord_index + 0],
-                            1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-                        },
-                        .color = glm::vec3 { 1.0f, 1.0f, 1.0f },
-                    };
+        mutable std::mutex m_mutex;
+        std::condition_variable m_workAvailable;
+        std::condition_variable m_resultAvailable;
+        std::deque<std::string> m_filePaths;
+        std::deque<DecodeResult> m_results;
+        bool m_isStopping;
+        size_t m_pendingCount;
+        std::vector<std::thread> m_workers;
 
-                    if (uniqueVertices.count(vertex) == 0) {
-                        uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                        vertices.push_back(vertex);
-                    }
+        void run() {
+            while (true) {
+                auto lock = std::unique_lock<std::mutex> { m_mutex };
+                m_workAvailable.wait(lock, [this]() { return m_isStopping || !m_filePaths.empty(); });
+                if (m_isStopping) {
+                    return;
+                }
 
-                    indices.push_back(uniqueVertices[vertex]);
+                auto result = DecodeResult {
+                    .texture = StbDecodedTexture {
+                        .filePath = std::move(m_filePaths.front()),
+                        .image = StbTextureImage {},
+                    },
+                    .error = nullptr,
+                };
+                m_filePaths.pop_front();
+                lock.unlock();
+
+                try {
+                    auto textureLoader = StbTextureLoader { result.texture.filePath };
+                    result.texture.image = textureLoader.load();
+                } catch (...) {
+                    result.error = std::current_exception();
                 }
-            }
 
-            return Mesh { std::move(vertices), std::move(indices) };
+                lock.lock();
+                m_results.push_back(std::move(result));
+                lock.unlock();
+
+                m_resultAvailable.notify_one();
+            }
         }
 };
 
-/// @brief The uniform buffer object for distpaching camera data to the GPU.
-///
-/// @note Vulkan expects data to be aligned in a specific way. For example,
-/// let `T` be a data type.
+/// @brief One mip level of a KTX2 texture.
 ///
-/// @li If `T` is a scalar, `align(T) == sizeof(T)`
-/// @li If `T` is a scalar, `align(vec2<T>) == 2 * sizeof(T)`
-/// @li If `T` is a scalar, `align(vec3<T>) == 4 * sizeof(T)`
-/// @li If `T` is a scalar, `align(vec4<T>) == 4 * sizeof(T)`
-/// @li If `T` is a scalar, `align(mat4<T>) == 4 * sizeof(T)`
-/// @li If `T` is a structure type, `align(T) == max(align(members(T)))`
-///
-/// In particular, each data type is a nice multiple of the alignment of the largest
-/// scalar type constituting that data type. See the specification
-/// https://registry.khronos.org/vulkan/specs/1.3-extensions/html/chap15.html#interfaces-resources-layout
-/// for more details.
-struct UniformBufferObject {
-    glm::mat4x4 model;
-    glm::mat4x4 view;
-    glm::mat4x4 proj;
+/// @note `offset` is relative to the start of the level data written by
+/// `Ktx2TextureLoader::loadData`, and `fileOffset` to the start of the file.
+struct Ktx2TextureLevel final {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    VkDeviceSize fileOffset = 0;
 };
 
-class App final {
+class Ktx2TextureImage final {
     public:
-        explicit App() = default;
+        explicit Ktx2TextureImage() = default;
 
-        ~App() {
-            this->cleanup();
+        inline VkFormat format() const noexcept {
+            return m_format;
         }
 
-        void run() {
-            this->initApp();
-            this->mainLoop();
+        inline uint32_t width() const noexcept {
+            return m_width;
         }
-    private:
-        std::unique_ptr<Engine> m_engine;
-
-        std::unordered_map<std::string, std::vector<uint8_t>> m_glslShaders;
-        std::unordered_map<std::string, std::vector<uint8_t>> m_hlslShaders;
 
-        VkImage m_depthImage;
-        VkDeviceMemory m_depthImageMemory;
-        VkImageView m_depthImageView;
+        inline uint32_t height() const noexcept {
+            return m_height;
+        }
 
-        uint32_t m_mipLevels;
-        VkImage m_textureImage;
-        VkDeviceMemory m_textureImageMemory;
-        VkImageView m_textureImageView;
-        VkSampler m_textureSampler;
-
-        Mesh m_mesh;
-        VkBuffer m_vertexBuffer;
-        VkDeviceMemory m_vertexBufferMemory;
-        VkBuffer m_indexBuffer;
-        VkDeviceMemory m_indexBufferMemory;
-
-        std::vector<VkBuffer> m_uniformBuffers;
-        std::vector<VkDeviceMemory> m_uniformBuffersMemory;
-        std::vector<void*> m_uniformBuffersMapped;
-
-        VkDescriptorPool m_descriptorPool;
-        std::vector<VkDescriptorSet> m_descriptorSets;
-        VkDescriptorSetLayout m_descriptorSetLayout;
+        /// @brief The levels stored in the file, largest first.
+        const std::vector<Ktx2TextureLevel>& levels() const {
+            return m_levels;
+        }
 
-        std::vector<VkCommandBuffer> m_commandBuffers;
+        /// @brief Whether the file leaves mip generation to the loader.
+        ///
+        /// @note In that case the file carries only level 0.
+        inline bool requiresMipGeneration() const noexcept {
+            return m_requiresMipGeneration;
+        }
 
-        VkRenderPass m_renderPass;
-        VkPipelineLayout m_pipelineLayout;
-        VkPipeline m_graphicsPipeline;
+        /// @brief The size of the packed level data.
+        inline VkDeviceSize dataSize() const noexcept {
+            return m_dataSize;
+        }
 
-        std::vector<VkSemaphore> m_imageAvailableSemaphores;
-        std::vector<VkSemaphore> m_renderFinishedSemaphores;
-        std::vector<VkFence> m_inFlightFences;
+        /// @brief Whether the file holds a Basis Universal payload, ETC1S or UASTC, rather
+        /// than a native Vulkan format.
+        ///
+        /// @note Such a texture has no format and no levels, since it would have to be
+        /// transcoded first.
+        inline bool isBasisUniversal() const noexcept {
+            return m_isBasisUniversal;
+        }
+    private:
+        VkFormat m_format;
+        uint32_t m_width;
+        uint32_t m_height;
+        bool m_requiresMipGeneration;
+        bool m_isBasisUniversal;
+        std::vector<Ktx2TextureLevel> m_levels;
+        VkDeviceSize m_dataSize;
 
-        VkSwapchainKHR m_swapChain;
-        std::vector<VkImage> m_swapChainImages;
-        VkFormat m_swapChainImageFormat;
-        VkExtent2D m_swapChainExtent;
-        std::vector<VkImageView> m_swapChainImageViews;
-        std::vector<VkFramebuffer> m_swapChainFramebuffers;
-    
-        uint32_t m_currentFrame = 0;
+        friend class Ktx2TextureLoader;
+};
 
-        bool m_enableValidationLayers { false };
-        bool m_enableDebuggingExtensions { false };
+/// @brief Loads KTX2 containers holding textures in native Vulkan formats.
+///
+/// @note The level data is handed to the GPU as-is, so block-compressed formats such as
+/// BC1-7, ETC2 and ASTC never go through a CPU decode. Only plain 2D textures without
+/// supercompression are supported. Basis Universal files are recognized, so the caller can
+/// fall back to the source image, but there is no transcoder for them: the basisu
+/// transcoder is not vendored under external/, so they are never turned into BC or ASTC.
+///
+/// Loading happens in two steps. `load` maps the file and parses the header and the level
+/// index, so the caller can check the texture before committing to it. `loadData` then
+/// copies the levels out of the mapping straight into memory the caller provides, such as
+/// a mapped staging slice, without an intermediate copy. Given an asynchronous file reader,
+/// it reads every level from the file at once instead, so the texture does not fault its
+/// pages in one at a time.
+///
+/// A file the asset archive stores in compressed blocks is only decompressed as far as
+/// its first block by `load`, which holds the header and the level index. The caller can
+/// then upload the stored blocks with `loadCompressedData` and expand them on the GPU, while
+/// `loadData` decompresses the whole file on the CPU.
+class Ktx2TextureLoader final {
+    public:
+        explicit Ktx2TextureLoader(const std::string& filePath) : m_filePath { filePath } {}
+
+        Ktx2TextureImage load() {
+            const auto* archive = AssetArchive::getMounted();
+            const auto entry = archive != nullptr ? archive->find(m_filePath) : std::nullopt;
+            auto headerBytes = std::span<const uint8_t> {};
+            auto fileSize = size_t { 0 };
+            if (entry.has_value() && entry->compression == AssetCompression::Lz4Blocks && entry->size > 0) {
+                m_compressedEntry = entry;
+                m_firstBlock = archive->readBlock(*entry, 0);
+                headerBytes = m_firstBlock;
+                fileSize = entry->size;
+            } else {
+                // The mapping stays open for `loadData`.
+                m_file.emplace(m_filePath);
+                headerBytes = m_file->getBytes();
+                fileSize = m_file->getSize();
+            }
 
-        void cleanup() {
-            if (m_engine->isInitialized()) {
-                this->cleanupSwapChain();
+            const auto* fileData = headerBytes.data();
+            if (headerBytes.size() < sizeof(Header)) {
+                throw std::runtime_error("failed to load KTX2 texture: not a KTX2 file!");
+            }
 
-                vkDestroyPipeline(m_engine->getLogicalDevice(), m_graphicsPipeline, nullptr);
-                vkDestroyPipelineLayout(m_engine->getLogicalDevice(), m_pipelineLayout, nullptr);
-                vkDestroyRenderPass(m_engine->getLogicalDevice(), m_renderPass, nullptr);
+            auto header = Header {};
+            std::memcpy(&header, fileData, sizeof(Header));
+            if (!std::equal(IDENTIFIER.begin(), IDENTIFIER.end(), header.identifier.begin())) {
+                throw std::runtime_error("failed to load KTX2 texture: not a KTX2 file!");
+            }
 
-                for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-                    vkDestroySemaphore(m_engine->getLogicalDevice(), m_renderFinishedSemaphores[i], nullptr);
-                    vkDestroySemaphore(m_engine->getLogicalDevice(), m_imageAvailableSemaphores[i], nullptr);
-                    vkDestroyFence(m_engine->getLogicalDevice(), m_inFlightFences[i], nullptr);
-                }
+            // Basis Universal payloads, whether BasisLZ or Zstandard supercompressed, are the
+            // only KTX2 textures without a Vulkan format.
+            if (header.vkFormat == VK_FORMAT_UNDEFINED) {
+                auto textureImage = Ktx2TextureImage {};
+                textureImage.m_format = VK_FORMAT_UNDEFINED;
+                textureImage.m_width = header.pixelWidth;
+                textureImage.m_height = header.pixelHeight;
+                textureImage.m_requiresMipGeneration = false;
+                textureImage.m_isBasisUniversal = true;
+                textureImage.m_dataSize = 0;
+
+                return textureImage;
+            }
 
-                vkDestroyDescriptorPool(m_engine->getLogicalDevice(), m_descriptorPool, nullptr);
+            if (header.supercompressionScheme != 0) {
+                throw std::runtime_error("failed to load KTX2 texture: supercompressed textures are not supported!");
+            }
 
-                vkDestroySampler(m_engine->getLogicalDevice(), m_textureSampler, nullptr);
-                vkDestroyImageView(m_engine->getLogicalDevice(), m_textureImageView, nullptr);
+            if (header.pixelHeight == 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1) {
+                throw std::runtime_error("failed to load KTX2 texture: only 2D textures are supported!");
+            }
 
-                vkDestroyImage(m_engine->getLogicalDevice(), m_textureImage, nullptr);
-                vkFreeMemory(m_engine->getLogicalDevice(), m_textureImageMemory, nullptr);
+            // A level count of zero asks the loader to generate the mip chain, and the file
+            // then stores only level 0.
+            const auto storedLevelCount = std::max(header.levelCount, 1u);
+            const auto levelIndexEnd = sizeof(Header) + storedLevelCount * sizeof(LevelIndexEntry);
+            if (headerBytes.size() < levelIndexEnd) {
+                throw std::runtime_error("failed to load KTX2 texture: truncated level index!");
+            }
 
-                vkDestroyDescriptorSetLayout(m_engine->getLogicalDevice(), m_descriptorSetLayout, nullptr);
+            auto levelIndex = std::vector<LevelIndexEntry>(storedLevelCount);
+            std::memcpy(levelIndex.data(), fileData + sizeof(Header), storedLevelCount * sizeof(LevelIndexEntry));
+
+            // Pack the levels back to back, largest first, keeping every level aligned for
+            // `vkCmdCopyBufferToImage` regardless of the texel block size.
+            auto textureImage = Ktx2TextureImage {};
+            textureImage.m_format = static_cast<VkFormat>(header.vkFormat);
+            textureImage.m_width = header.pixelWidth;
+            textureImage.m_height = header.pixelHeight;
+            textureImage.m_requiresMipGeneration = header.levelCount == 0;
+            textureImage.m_isBasisUniversal = false;
+            textureImage.m_levels.reserve(storedLevelCount);
+
+            const auto formatInfo = TextureFormats::getInfo(textureImage.m_format);
+            auto offset = VkDeviceSize { 0 };
+            for (uint32_t i = 0; i < storedLevelCount; i++) {
+                const auto& entry = levelIndex[i];
+                // The offset and length come from the file, so their sum may wrap around.
+                if (entry.byteOffset > fileSize || entry.byteLength > fileSize - entry.byteOffset) {
+                    throw std::runtime_error("failed to load KTX2 texture: truncated level data!");
+                }
 
-                vkDestroyBuffer(m_engine->getLogicalDevice(), m_indexBuffer, nullptr);
-                vkFreeMemory(m_engine->getLogicalDevice(), m_indexBufferMemory, nullptr);
+                const auto levelWidth = std::max(header.pixelWidth >> i, 1u);
+                const auto levelHeight = std::max(header.pixelHeight >> i, 1u);
+                if (formatInfo.has_value() && entry.byteLength != formatInfo->getLevelSize(levelWidth, levelHeight)) {
+                    throw std::runtime_error("failed to load KTX2 texture: level size does not match the texture format!");
+                }
 
-                vkDestroyBuffer(m_engine->getLogicalDevice(), m_vertexBuffer, nullptr);
-                vkFreeMemory(m_engine->getLogicalDevice(), m_vertexBufferMemory, nullptr);
+                textureImage.m_levels.push_back(Ktx2TextureLevel {
+                    .width = levelWidth,
+                    .height = levelHeight,
+                    .offset = offset,
+                    .size = entry.byteLength,
+                    .fileOffset = entry.byteOffset,
+                });
 
-                for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-                    vkDestroyBuffer(m_engine->getLogicalDevice(), m_uniformBuffers[i], nullptr);
-                    vkFreeMemory(m_engine->getLogicalDevice(), m_uniformBuffersMemory[i], nullptr);
-                }
+                offset = (offset + entry.byteLength + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
             }
-        }
 
-        void createEngine() {
-            auto engine = Engine::createDebugMode();
-            engine->createWindow(WIDTH, HEIGHT, "Generating Mipmaps");
+            textureImage.m_dataSize = offset;
 
-            m_engine = std::move(engine);
+            return textureImage;
         }
 
-        void createShaderBinaries() {
-            const auto glslShaders = shaders_glsl::createGlslShaders();
-            const auto hlslShaders = shaders_hlsl::createHlslShaders();
-
-            m_glslShaders = std::move(glslShaders);
-            m_hlslShaders = std::move(hlslShaders);
-        }
+        /// @brief Read the levels of `textureImage` into `destination`, which must hold at
+        /// least `textureImage.dataSize()` bytes, and run `completion` once they have landed.
+        ///
+        /// @note With a reader, the levels are read in the background and the reads are
+        /// returned, for the caller to wait on before it uses `destination`. Otherwise they
+        /// are copied out of the mapping, `completion` runs before returning, and nothing
+        /// is returned.
+        AsyncReadHandle loadData(
+            const Ktx2TextureImage& textureImage,
+            void* destination,
+            AsyncFileReader* fileReader = nullptr,
+            AsyncFileReader::Completion completion = nullptr
+        ) {
+            if (!m_file.has_value() && !m_compressedEntry.has_value()) {
+                throw std::logic_error("the KTX2 texture has not been loaded!");
+            }
 
-        void initApp() {
-            this->createEngine();
+            if (!m_file.has_value()) {
+                m_file.emplace(m_filePath);
+            }
 
-            this->createShaderBinaries();
+            auto* data = static_cast<uint8_t*>(destination);
+            const auto& fileRegion = m_file->getFileRegion();
+            if (fileReader != nullptr && fileRegion.has_value()) {
+                auto requests = std::vector<AsyncReadRequest> {};
+                requests.reserve(textureImage.levels().size());
+                for (const auto& level : textureImage.levels()) {
+                    requests.push_back(AsyncReadRequest {
+                        .fileOffset = fileRegion->offset + level.fileOffset,
+                        .size = level.size,
+                        .destination = data + level.offset,
+                    });
+                }
 
-            this->createTextureImage(TEXTURE_PATH);
-            this->createTextureImageView();
-            this->createTextureSampler();
-            this->loadModel(MODEL_PATH);
-            this->createVertexBuffer();
-            this->createIndexBuffer();
-            this->createDescriptorSetLayout();
-            this->createUniformBuffers();
-            this->createDescriptorPool();
-            this->createDescriptorSets();
-            this->createCommandBuffers();
-            this->createSwapChain();
-            this->createImageViews();
-            this->createRenderPass();
-            this->createGraphicsPipeline();
-            this->createDepthResources();
-            this->createFramebuffers();
-            this->createRenderingSyncObjects();
-        }
+                return fileReader->submit(fileRegion->filePath, requests, std::move(completion));
+            }
 
-        void mainLoop() {
-            while (!glfwWindowShouldClose(m_engine->getWindow())) {
-                glfwPollEvents();
-                this->draw();
+            for (const auto& level : textureImage.levels()) {
+                std::memcpy(data + level.offset, m_file->getData() + level.fileOffset, level.size);
+            }
+            if (completion) {
+                completion(nullptr);
             }
 
-            vkDeviceWaitIdle(m_engine->getLogicalDevice());
+            return nullptr;
         }
 
-        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-            VkPhysicalDeviceMemoryProperties memProperties;
-            vkGetPhysicalDeviceMemoryProperties(m_engine->getPhysicalDevice(), &memProperties);
-
-            for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-                if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-                    return i;
-                }
-            }
-
-            throw std::runtime_error("failed to find suitable memory type!");
+        /// @brief The archive entry the file is stored in, when it is stored in compressed
+        /// blocks that the GPU can expand.
+        ///
+        /// @note The levels sit at their file offsets within the expanded entry.
+        const std::optional<AssetArchiveEntry>& getCompressedEntry() const {
+            return m_compressedEntry;
         }
 
-        std::tuple<VkBuffer, VkDeviceMemory> createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) {
-            const auto bufferInfo = VkBufferCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                .size = size,
-                .usage = usage,
-                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            };
+        /// @brief Read the stored blocks of the compressed entry into `destination`, which
+        /// must hold at least `getCompressedEntry()->storedSize` bytes.
+        ///
+        /// @note With a reader, the blocks are read in the background and the read is
+        /// returned, like `loadData` does.
+        AsyncReadHandle loadCompressedData(void* destination, AsyncFileReader* fileReader = nullptr) {
+            if (!m_compressedEntry.has_value()) {
+                throw std::logic_error("the KTX2 texture is not stored in compressed blocks!");
+            }
 
-            auto buffer = VkBuffer {};
-            const auto resultCreateBuffer = vkCreateBuffer(m_engine->getLogicalDevice(), &bufferInfo, nullptr, &buffer);
-            if (resultCreateBuffer != VK_SUCCESS) {
-                throw std::runtime_error("failed to create buffer!");
+            const auto* archive = AssetArchive::getMounted();
+            if (fileReader != nullptr) {
+                const auto request = AsyncReadRequest {
+                    .fileOffset = m_compressedEntry->offset,
+                    .size = m_compressedEntry->storedSize,
+                    .destination = destination,
+                };
+                return fileReader->submit(archive->getFilePath(), std::span { &request, 1 });
             }
 
-            auto memRequirements = VkMemoryRequirements {};
-            vkGetBufferMemoryRequirements(m_engine->getLogicalDevice(), buffer, &memRequirements);
+            const auto storedBytes = archive->getStoredBytes(*m_compressedEntry);
+            std::memcpy(destination, storedBytes.data(), storedBytes.size());
 
-            const auto allocInfo = VkMemoryAllocateInfo {
-                .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-                .allocationSize = memRequirements.size,
-                .memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties),
-            };
+            return nullptr;
+        }
+    private:
+        struct Header final {
+            std::array<uint8_t, 12> identifier;
+            uint32_t vkFormat;
+            uint32_t typeSize;
+            uint32_t pixelWidth;
+            uint32_t pixelHeight;
+            uint32_t pixelDepth;
+            uint32_t layerCount;
+            uint32_t faceCount;
+            uint32_t levelCount;
+            uint32_t supercompressionScheme;
+            uint32_t dfdByteOffset;
+            uint32_t dfdByteLength;
+            uint32_t kvdByteOffset;
+            uint32_t kvdByteLength;
+            uint64_t sgdByteOffset;
+            uint64_t sgdByteLength;
+        };
 
-            auto bufferMemory = VkDeviceMemory {};
-            const auto resultAllocateMemory = vkAllocateMemory(m_engine->getLogicalDevice(), &allocInfo, nullptr, &bufferMemory);
-            if (resultAllocateMemory != VK_SUCCESS) {
-                throw std::runtime_error("failed to allocate buffer memory!");
-            }
+        struct LevelIndexEntry final {
+            uint64_t byteOffset;
+            uint64_t byteLength;
+            uint64_t uncompressedByteLength;
+        };
 
-            vkBindBufferMemory(m_engine->getLogicalDevice(), buffer, bufferMemory, 0);
+        static constexpr std::array<uint8_t, 12> IDENTIFIER = {
+            0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+        };
+        static constexpr VkDeviceSize LEVEL_ALIGNMENT = 16;
 
-            return std::make_tuple(buffer, bufferMemory);
-        }
+        const std::string& m_filePath;
+        std::optional<AssetFile> m_file;
+        std::optional<AssetArchiveEntry> m_compressedEntry;
+        std::vector<uint8_t> m_firstBlock;
+};
 
-        std::tuple<VkImage, VkDeviceMemory> createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties) {
-            const auto imageInfo = VkImageCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-                .imageType = VK_IMAGE_TYPE_2D,
-                .extent.width = width,
-                .extent.height = height,
-                .extent.depth = 1,
-                .mipLevels = mipLevels,
-                .arrayLayers = 1,
-                .format = format,
-                .tiling = tiling,
-                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                .usage = usage,
-                .samples = numSamples,
-                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            };
+/// @brief A texture read and decoded on a worker thread, with only its upload left to
+/// record.
+///
+/// @note Exactly one source is set: a KTX2 file whose levels are read straight into the
+/// staging ring, a complete mip chain from the texture cache or the CPU, or a decoded
+/// image whose mips the GPU generates. The KTX2 loader refers to `filePath`, the file the
+/// texture was loaded from, so a prepared texture is not moved once it is loaded.
+struct PreparedTexture final {
+    std::string filePath;
+    std::unique_ptr<Ktx2TextureLoader> ktx2TextureLoader;
+    std::optional<Ktx2TextureImage> ktx2TextureImage;
+    std::optional<TextureCacheEntry> mipChain;
+    bool isMipChainCached = false;
+    std::optional<StbTextureImage> stbTextureImage;
+};
 
-            auto image = VkImage {};
-            const auto resultCreateImage = vkCreateImage(m_engine->getLogicalDevice(), &imageInfo, nullptr, &image);
-            if (resultCreateImage != VK_SUCCESS) {
-                throw std::runtime_error("failed to create image!");
-            }
+/// @brief The transform from the positions stored in a `GpuVertex` of `mesh` back to
+/// model space.
+static glm::mat4 getPositionDequantizeTransform(const Mesh& mesh) {
+    if (GpuVertex::IS_POSITION_NORMALIZED) {
+        const auto scale = glm::scale(glm::mat4(1.0f), mesh.boundsMax() - mesh.boundsMin());
 
-            auto memRequirements = VkMemoryRequirements {};
-            vkGetImageMemoryRequirements(m_engine->getLogicalDevice(), image, &memRequirements);
+        return glm::translate(glm::mat4(1.0f), mesh.boundsMin()) * scale;
+    } else {
+        return glm::mat4(1.0f);
+    }
+}
 
-            const auto allocInfo = VkMemoryAllocateInfo {
-                .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-                .allocationSize = memRequirements.size,
-                .memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties),
-            };
+/// @brief Pack `vertexCount` vertices of `mesh`, from `firstVertex` on, in the `GpuVertex`
+/// encodings.
+///
+/// @note Packed positions and texture coordinates are written `positionStride` and
+/// `texCoordStride` bytes apart, so the same packing fills interleaved and split streams.
+static void packVertices(
+    const Mesh& mesh,
+    size_t firstVertex,
+    size_t vertexCount,
+    uint8_t* positions,
+    size_t positionStride,
+    uint8_t* texCoords,
+    size_t texCoordStride
+) {
+    // A flat mesh has no extent along some axis, and all of its positions pack to zero there.
+    const auto extent = mesh.boundsMax() - mesh.boundsMin();
+    const auto inverseExtent = glm::vec3 {
+        (extent.x > 0.0f) ? 1.0f / extent.x : 0.0f,
+        (extent.y > 0.0f) ? 1.0f / extent.y : 0.0f,
+        (extent.z > 0.0f) ? 1.0f / extent.z : 0.0f,
+    };
 
-            auto imageMemory = VkDeviceMemory {};
-            const auto resultAllocateMemory = vkAllocateMemory(m_engine->getLogicalDevice(), &allocInfo, nullptr, &imageMemory);
-            if (resultAllocateMemory != VK_SUCCESS) {
-                throw std::runtime_error("failed to allocate image memory!");
+    for (size_t i = 0; i < vertexCount; i++) {
+        const auto& vertex = mesh.vertices()[firstVertex + i];
+        const auto position = [&mesh, &vertex, &inverseExtent]() -> glm::vec3 {
+            if (GpuVertex::IS_POSITION_NORMALIZED) {
+                return (vertex.position - mesh.boundsMin()) * inverseExtent;
+            } else {
+                return vertex.position;
             }
+        }();
 
-            vkBindImageMemory(m_engine->getLogicalDevice(), image, imageMemory, 0);
-
-            return std::make_tuple(image, imageMemory);
+        if (GpuVertex::IS_TEX_COORD_NORMALIZED) {
+            const auto isInUnitSquare = vertex.texCoord.x >= 0.0f && vertex.texCoord.x <= 1.0f &&
+                vertex.texCoord.y >= 0.0f && vertex.texCoord.y <= 1.0f;
+            if (!isInUnitSquare) {
+                throw std::runtime_error("texture coordinates outside [0, 1] do not fit the vertex layout!");
+            }
         }
 
-        VkCommandBuffer beginSingleTimeCommands() {
-            const auto allocInfo = VkCommandBufferAllocateInfo {
-                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-                .commandPool = m_engine->getCommandPool(),
-                .commandBufferCount = 1,
-            };
+        auto packedPosition = GpuVertex::Position {};
+        auto packedTexCoord = GpuVertex::TexCoord {};
+        packedPosition.encode(&position.x);
+        packedTexCoord.encode(&vertex.texCoord.x);
+        std::memcpy(positions + i * positionStride, &packedPosition, sizeof(packedPosition));
+        std::memcpy(texCoords + i * texCoordStride, &packedTexCoord, sizeof(packedTexCoord));
+    }
+}
 
-            auto commandBuffer = VkCommandBuffer {};
-            vkAllocateCommandBuffers(m_engine->getLogicalDevice(), &allocInfo, &commandBuffer);
+/// @brief A meshlet as the task and mesh shaders read it, with its culling bounds.
+struct GpuMeshlet {
+    glm::vec4 boundingSphere;
+    // The cone cutoff is stored in `w`.
+    glm::vec4 coneApex;
+    glm::vec4 coneAxis;
+    uint32_t vertexOffset;
+    uint32_t triangleOffset;
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+};
 
-            const auto beginInfo = VkCommandBufferBeginInfo {
-                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-            };
+static_assert(sizeof(GpuMeshlet) == 64, "`GpuMeshlet` must match the std430 layout of `Meshlet` in the meshlet shaders");
 
-            vkBeginCommandBuffer(commandBuffer, &beginInfo);
+/// @brief The constants the vertex pipeline pushes for every draw.
+///
+/// @note The model matrix maps the positions as they are stored in the vertex buffer into
+/// world space, dequantizing them. The copies of the mesh take turns at `materialCount`
+/// materials by instance index, from the entry `textureIndex` of the global texture table
+/// on, and the vertex shaders hand the entry of their copy to the fragment shader. Only the
+/// vertex pulling shader reads `texCoordOffset`, the word offset of the texture coordinate
+/// stream in the vertex buffer.
+struct DrawPushConstants {
+    glm::mat4x4 model;
+    uint32_t textureIndex;
+    uint32_t texCoordOffset;
+    uint32_t materialCount;
+};
 
-            return commandBuffer;
-        }
+/// @brief The transform of one copy of the mesh, which the vertex pipeline reads per
+/// instance from a vertex binding of its own.
+///
+/// @note The matrix goes in as its four columns, one attribute each, at the locations
+/// after the ones of the vertex.
+struct InstanceTransform {
+    glm::mat4x4 model;
 
-        void endSingleTimeCommands(VkCommandBuffer commandBuffer) {
-            vkEndCommandBuffer(commandBuffer);
+    static constexpr VkVertexInputBindingDescription getBindingDescription(uint32_t binding) {
+        return VkVertexInputBindingDescription {
+            .binding = binding,
+            .stride = sizeof(InstanceTransform),
+            .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
+        };
+    }
 
-            const auto submitInfo = VkSubmitInfo {
-                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                .commandBufferCount = 1,
-                .pCommandBuffers = &commandBuffer,
+    static constexpr std::array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions(uint32_t binding, uint32_t firstLocation) {
+        auto attributeDescriptions = std::array<VkVertexInputAttributeDescription, 4> {};
+        for (uint32_t i = 0; i < attributeDescriptions.size(); i++) {
+            attributeDescriptions[i] = VkVertexInputAttributeDescription {
+                .location = firstLocation + i,
+                .binding = binding,
+                .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+                .offset = static_cast<uint32_t>(i * sizeof(glm::vec4)),
             };
-
-            vkQueueSubmit(m_engine->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
-            vkQueueWaitIdle(m_engine->getGraphicsQueue());
-
-            vkFreeCommandBuffers(m_engine->getLogicalDevice(), m_engine->getCommandPool(), 1, &commandBuffer);
         }
 
-        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-            const auto commandBuffer = this->beginSingleTimeCommands();
+        return attributeDescriptions;
+    }
+};
 
-            const auto copyRegion = VkBufferCopy {
-                .size = size,
-            };
-            vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+/// @brief Fold the bytes of `value` into the FNV-1a hash `hash`.
+///
+/// @note `value` must have no padding, or its padding bytes are hashed as well.
+template <typename T>
+static uint64_t hashValue(const T& value, uint64_t hash) {
+    return CacheSourceKey::hashBytes(reinterpret_cast<const uint8_t*>(&value), sizeof(T), hash);
+}
 
-            this->endSingleTimeCommands(commandBuffer);
-        }
+/// @brief A perspective projection onto a depth range from one at the near plane to zero
+/// at a far plane infinitely far away, for reverse-Z.
+static glm::mat4 reverseInfinitePerspective(float fieldOfView, float aspectRatio, float nearPlane) {
+    const auto focalLength = 1.0f / std::tan(fieldOfView / 2.0f);
+    auto proj = glm::mat4(0.0f);
+    proj[0][0] = focalLength / aspectRatio;
+    proj[1][1] = focalLength;
+    proj[2][3] = -1.0f;
+    proj[3][2] = nearPlane;
+
+    return proj;
+}
 
-        void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels) {
-            const VkCommandBuffer commandBuffer = this->beginSingleTimeCommands();
+/// @brief The constants the mesh shader pipeline pushes for every draw.
+///
+/// @note The model matrix and texture index match the ones of `DrawPushConstants`, and
+/// only the mesh shader reads the matrix. The task shader culls the bounds of the
+/// meshlets, which are in the space of the unquantized positions, and that is world space
+/// since the mesh sits at the origin.
+struct MeshletPushConstants {
+    glm::mat4x4 model;
+    uint32_t textureIndex;
+    uint32_t firstMeshlet;
+    uint32_t meshletCount;
+    uint32_t texCoordOffset;
+};
 
-            const auto [srcAccessMask, dstAccessMask] = [oldLayout, newLayout]() -> std::tuple<VkAccessFlags, VkAccessFlags> {
-                if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-                    return std::make_tuple(
-                        0, 
-                        VK_ACCESS_TRANSFER_WRITE_BIT
-                    );
-                } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-                    return std::make_tuple(
-                        VK_ACCESS_TRANSFER_WRITE_BIT,
-                        VK_ACCESS_SHADER_READ_BIT
-                    );
-                } else {
-                    throw std::invalid_argument("unsupported layout transition!");
-                }
-            }();
-            const auto [sourceStage, destinationStage] = [oldLayout, newLayout]() -> std::tuple<VkPipelineStageFlags, VkPipelineStageFlags> {
-                if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-                    return std::make_tuple(
-                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                        VK_PIPELINE_STAGE_TRANSFER_BIT
-                    );
-                } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-                    return std::make_tuple(
-                        VK_PIPELINE_STAGE_TRANSFER_BIT,
-                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
-                    );
-                } else {
-                    throw std::invalid_argument("unsupported layout transition!");
-                }
-            }();
+/// @brief The attachment formats a pipeline renders to when it has no render pass, the
+/// sample count of its color and depth attachments, and the views it renders with multiview.
+struct AttachmentFormats final {
+    VkFormat colorFormat;
+    VkFormat depthFormat;
+    VkSampleCountFlagBits sampleCount;
+    uint32_t viewMask;
+};
 
-            const auto barrier = VkImageMemoryBarrier {
-                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                .oldLayout = oldLayout,
-                .newLayout = newLayout,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image = image,
-                .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                .subresourceRange.baseMipLevel = 0,
-                .subresourceRange.levelCount = mipLevels,
-                .subresourceRange.baseArrayLayer = 0,
-                .subresourceRange.layerCount = 1,
-                .srcAccessMask = srcAccessMask,
-                .dstAccessMask = dstAccessMask,
-            };
+/// @brief How the fragment shader encodes its linear output for the swap chain, as the
+/// `OUTPUT_ENCODING_` values of `shader.frag.hlsl` and `shader.frag.glsl`.
+///
+/// @note `None` is for sRGB formats, which the hardware encodes. `Srgb` is for UNORM
+/// formats in the sRGB color space. `Pq` is the ST 2084 perceptual quantizer in BT.2020
+/// primaries for HDR10, and `ScRgb` scales linear extended sRGB so that 1.0 is 80 nits.
+enum class OutputEncoding : uint32_t {
+    None = 0,
+    Srgb = 1,
+    Pq = 2,
+    ScRgb = 3,
+};
 
-            vkCmdPipelineBarrier(
-                commandBuffer,
-                sourceStage, destinationStage,
-                0,
-                0, nullptr,
-                0, nullptr,
-                1, &barrier
-            );
+/// @brief The specialization constants of the fragment shader, so that the choices between
+/// its permutations fold away when a pipeline is created instead of branching per fragment.
+///
+/// @note The layout matches the `constant_id`s of `shader.frag.hlsl` and `shader.frag.glsl`,
+/// and booleans take 32 bits. Each permutation is a pipeline of its own, which the pipeline
+/// cache keeps like any other.
+struct FragmentSpecialization final {
+    /// @brief Shade every fragment by the mip level it samples instead of by the texture.
+    VkBool32 showMipLevels;
+    /// @brief Discard the fragments whose alpha is below `alphaCutoff`.
+    VkBool32 alphaTest;
+    float alphaCutoff;
+    /// @brief Added to the level of detail the texture is sampled at.
+    float lodBias;
+    /// @brief The `OutputEncoding` of the color written to the swap chain.
+    uint32_t outputEncoding;
+    /// @brief The nits the scene's white is shown at on HDR formats.
+    float paperWhiteNits;
+    /// @brief Write the level one fragment of every tile samples to the LOD feedback
+    /// buffer, and the size of the tiles in pixels.
+    VkBool32 lodFeedback;
+    uint32_t lodFeedbackTileSize;
+    /// @brief Sample the model texture through the page table of a virtual texture.
+    VkBool32 virtualTexture;
+
+    static constexpr std::array<VkSpecializationMapEntry, 9> getMapEntries() {
+        return std::array<VkSpecializationMapEntry, 9> {
+            VkSpecializationMapEntry {
+                .constantID = 0,
+                .offset = offsetof(FragmentSpecialization, showMipLevels),
+                .size = sizeof(VkBool32),
+            },
+            VkSpecializationMapEntry {
+                .constantID = 1,
+                .offset = offsetof(FragmentSpecialization, alphaTest),
+                .size = sizeof(VkBool32),
+            },
+            VkSpecializationMapEntry {
+                .constantID = 2,
+                .offset = offsetof(FragmentSpecialization, alphaCutoff),
+                .size = sizeof(float),
+            },
+            VkSpecializationMapEntry {
+                .constantID = 3,
+                .offset = offsetof(FragmentSpecialization, lodBias),
+                .size = sizeof(float),
+            },
+            VkSpecializationMapEntry {
+                .constantID = 4,
+                .offset = offsetof(FragmentSpecialization, outputEncoding),
+                .size = sizeof(uint32_t),
+            },
+            VkSpecializationMapEntry {
+                .constantID = 5,
+                .offset = offsetof(FragmentSpecialization, paperWhiteNits),
+                .size = sizeof(float),
+            },
+            VkSpecializationMapEntry {
+                .constantID = 6,
+                .offset = offsetof(FragmentSpecialization, lodFeedback),
+                .size = sizeof(VkBool32),
+            },
+            VkSpecializationMapEntry {
+                .constantID = 7,
+                .offset = offsetof(FragmentSpecialization, lodFeedbackTileSize),
+                .size = sizeof(uint32_t),
+            },
+            VkSpecializationMapEntry {
+                .constantID = 8,
+                .offset = offsetof(FragmentSpecialization, virtualTexture),
+                .size = sizeof(VkBool32),
+            },
+        };
+    }
+};
 
-            this->endSingleTimeCommands(commandBuffer);
-        }
+/// @brief The constants the post process subpass pushes, as `PushConstants` of
+/// `post_process.frag.hlsl` and `post_process.frag.glsl`.
+struct PostProcessPushConstants final {
+    float exposure;
+    float contrast;
+    float saturation;
+    float bloomIntensity;
+    glm::vec2 inverseExtent;
+    uint32_t bloomLevelCount;
+};
 
-        void copyBufferToImage(VkBuffer srcBuffer, VkImage dstImage, uint32_t width, uint32_t height) {
-            const VkCommandBuffer commandBuffer = this->beginSingleTimeCommands();
+/// @brief The specialization constants of the post process fragment shader, which encodes
+/// the graded color for the swap chain like `FragmentSpecialization` does without it, and
+/// adds the post effects it is built with.
+struct PostProcessSpecialization final {
+    uint32_t outputEncoding;
+    float paperWhiteNits;
+    VkBool32 bloom;
+    VkBool32 autoExposure;
+
+    static constexpr std::array<VkSpecializationMapEntry, 4> getMapEntries() {
+        return std::array<VkSpecializationMapEntry, 4> {
+            VkSpecializationMapEntry {
+                .constantID = 0,
+                .offset = offsetof(PostProcessSpecialization, outputEncoding),
+                .size = sizeof(uint32_t),
+            },
+            VkSpecializationMapEntry {
+                .constantID = 1,
+                .offset = offsetof(PostProcessSpecialization, paperWhiteNits),
+                .size = sizeof(float),
+            },
+            VkSpecializationMapEntry {
+                .constantID = 2,
+                .offset = offsetof(PostProcessSpecialization, bloom),
+                .size = sizeof(VkBool32),
+            },
+            VkSpecializationMapEntry {
+                .constantID = 3,
+                .offset = offsetof(PostProcessSpecialization, autoExposure),
+                .size = sizeof(VkBool32),
+            },
+        };
+    }
+};
 
-            const auto region = VkBufferImageCopy {
-                .bufferOffset = 0,
-                .bufferRowLength = 0,
-                .bufferImageHeight = 0,
-                .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                .imageSubresource.mipLevel = 0,
-                .imageSubresource.baseArrayLayer = 0,
-                .imageSubresource.layerCount = 1,
-                .imageOffset = VkOffset3D { 0, 0, 0 },
-                .imageExtent = VkExtent3D { width, height, 1 },
-            };
+/// @brief The fixed-function state a draw pipeline rasterizes and tests depth with.
+///
+/// @note With extended dynamic state, the state is set on the command buffer after every
+/// bind instead of being built into the pipelines, so one pipeline draws with any of it.
+struct DrawState final {
+    VkCullModeFlags cullMode;
+    VkFrontFace frontFace;
+    VkPrimitiveTopology topology;
+    VkBool32 depthTestEnable;
+    VkBool32 depthWriteEnable;
+    VkCompareOp depthCompareOp;
+};
 
-            vkCmdCopyBufferToImage(commandBuffer, srcBuffer, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+/// @brief The code of a pipeline stage, either a shader module or, on devices with
+/// `VK_KHR_maintenance5`, the SPIR-V words the stage takes in a chained module info.
+///
+/// @note The words are not copied, so they are only used for code that outlives every
+/// build, such as the embedded shaders.
+struct ShaderStageCode final {
+    VkShaderModule shaderModule;
+    VkShaderModuleCreateInfo moduleInfo;
+
+    /// @brief The stage info of `stage` with the code, which points into the code, so it
+    /// has to stay where it is while the stage info is used.
+    VkPipelineShaderStageCreateInfo getStageInfo(VkShaderStageFlagBits stage, const VkSpecializationInfo* specializationInfo = nullptr) const {
+        return VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .pNext = shaderModule == VK_NULL_HANDLE ? &moduleInfo : nullptr,
+            .stage = stage,
+            .module = shaderModule,
+            .pName = "main",
+            .pSpecializationInfo = specializationInfo,
+        };
+    }
+};
 
-            this->endSingleTimeCommands(commandBuffer);
-        }
+/// @brief A replaced swap chain and the attachments that were sized for it, kept until
+/// every frame that may still use them has finished.
+struct RetiredSwapChain final {
+    VkSwapchainKHR swapChain;
+    std::vector<VkImageView> imageViews;
+    std::vector<VkFramebuffer> framebuffers;
+    /// @brief The images an offscreen target renders into instead of a swap chain's.
+    std::vector<VkImage> offscreenImages;
+    std::vector<GpuAllocation> offscreenImageAllocations;
+    VkImage colorImage;
+    GpuAllocation colorImageAllocation;
+    VkImageView colorImageView;
+    VkImage depthImage;
+    GpuAllocation depthImageAllocation;
+    VkImageView depthImageView;
+    /// @brief The image a dynamic resolution frame is rendered into, if any.
+    VkImage sceneColorImage;
+    GpuAllocation sceneColorImageAllocation;
+    VkImageView sceneColorImageView;
+    /// @brief The scene color the post process subpass reads, and the pool of the set
+    /// that binds it, if any.
+    VkImage postProcessInputImage;
+    GpuAllocation postProcessInputImageAllocation;
+    VkImageView postProcessInputImageView;
+    VkDescriptorPool postProcessDescriptorPool;
+    /// @brief The average luminance and the bloom built from the post process input, if any.
+    std::unique_ptr<LuminanceReduction> luminanceReduction;
+    std::unique_ptr<BloomChain> bloomChain;
+    /// @brief The pyramid built from the depth image, if any.
+    std::unique_ptr<DepthPyramid> depthPyramid;
+    /// @brief The upscaler that reads the scene color and depth images, if any.
+    std::unique_ptr<TemporalUpscaler> temporalUpscaler;
+    /// @brief The shading rate image built from the upscaler's history, if any.
+    std::unique_ptr<ShadingRateImage> shadingRateImage;
+    uint64_t submitCount;
+    /// @brief The frame slot that last presented from the swap chain.
+    uint32_t frameSlot;
+};
 
-        VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
-            const auto viewInfo = VkImageViewCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-                .image = image,
-                .viewType = VK_IMAGE_VIEW_TYPE_2D,
-                .format = format,
-                .components = VkComponentMapping { VK_COMPONENT_SWIZZLE_IDENTITY }, // Optional
-                .subresourceRange.aspectMask = aspectFlags,
-                .subresourceRange.baseMipLevel = 0,
-                .subresourceRange.levelCount = mipLevels,
-                .subresourceRange.baseArrayLayer = 0,
-                .subresourceRange.layerCount = 1,
-            };
+/// @brief The swap chain of a viewport window, which shows the frame of the main window,
+/// scaled to fit.
+struct ViewportSwapChain final {
+    VkSwapchainKHR swapChain;
+    std::vector<VkImage> images;
+    VkExtent2D extent;
+    /// @brief Whether the swap chain has to be recreated before its next image is acquired.
+    bool isOutOfDate;
+};
 
-            auto imageView = VkImageView {};
-            const auto result = vkCreateImageView(m_engine->getLogicalDevice(), &viewInfo, nullptr, &imageView);
-            if (result != VK_SUCCESS) {
-                throw std::runtime_error("failed to create texture image view!");
-            }
+/// @brief A replaced swap chain of a viewport window, kept until every frame that may
+/// still blit into it has finished.
+struct RetiredViewportSwapChain final {
+    VkSwapchainKHR swapChain;
+    uint64_t submitCount;
+    uint32_t frameSlot;
+};
 
-            return imageView;
-        }
+/// @brief A replaced pipeline, kept until every frame that may still use it has finished.
+struct RetiredPipeline final {
+    PipelineHandle pipeline;
+    uint64_t submitCount;
+};
 
-        VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) {
-            for (VkFormat format : candidates) {
-                auto props = VkFormatProperties {};
-                vkGetPhysicalDeviceFormatProperties(m_engine->getPhysicalDevice(), format, &props);
+/// @brief A buffer that defragmentation can move, and what it takes to create another
+/// like it.
+///
+/// @note Only buffers that no descriptor set refers to are movable, since moving one only
+/// takes recording the command buffers that bind it again.
+struct MovableBuffer final {
+    GpuBufferHandle buffer;
+    VkDeviceSize size;
+    VkBufferUsageFlags usage;
+};
 
-                if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features) {
-                    return format;
-                } else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features) {
-                    return format;
-                }
-            }
+/// @brief A movable buffer being copied into the place it moves to.
+struct BufferMove final {
+    size_t movableBufferIndex;
+    VkBuffer buffer;
+    GpuAllocation allocation;
+    uint64_t uploadValue;
+};
 
-            throw std::runtime_error("failed to find supported format!");
-        }
+/// @brief Everything a pre-recorded command buffer depends on besides the frame slot and
+/// the swap chain image it was recorded for.
+///
+/// @note The texture table is updated after it is bound, so the samplers and images in
+/// it can change without the command buffers that bind it being recorded again.
+struct RecordedScene final {
+    uint64_t swapChainGeneration = 0;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkPipeline depthPrepassPipeline = VK_NULL_HANDLE;
+    VkPipeline occlusionProxyPipeline = VK_NULL_HANDLE;
+    bool isPerformanceHudDrawn = false;
+    size_t meshLodLevel = 0;
+    /// @brief Where the level of detail sits in the index buffer, which changes when a
+    /// streamed level is evicted and streamed in again.
+    uint32_t meshLodFirstIndex = 0;
+    /// @brief Counts the buffer moves, each of which changes the buffers that are bound.
+    uint64_t bufferGeneration = 0;
+    /// @brief The extent the scene is rendered at, which dynamic resolution changes.
+    uint32_t renderWidth = 0;
+    uint32_t renderHeight = 0;
+
+    bool operator==(const RecordedScene& other) const = default;
+};
 
-        VkFormat findDepthFormat() {
-            auto candidates = std::vector<VkFormat> { 
-                VK_FORMAT_D32_SFLOAT,
-                VK_FORMAT_D32_SFLOAT_S8_UINT,
-                VK_FORMAT_D24_UNORM_S8_UINT
-            };
-            auto tiling = VK_IMAGE_TILING_OPTIMAL;
-            auto features = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
-        
-            return this->findSupportedFormat(candidates, tiling, features);
-        }
+/// @brief A generated texture of a stress scene, sampled by the materials that name it.
+///
+/// @note A texture packed into a page has no image of its own, only a view of its layer.
+struct StressTexture final {
+    VkImage image = VK_NULL_HANDLE;
+    GpuAllocation allocation;
+    VkImageView imageView = VK_NULL_HANDLE;
+};
 
-        bool hasStencilComponent(VkFormat format) {
-            return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
-        }
+/// @brief A 2D array image that holds packed stress textures, one per layer.
+struct StressTexturePage final {
+    VkImage image = VK_NULL_HANDLE;
+    GpuAllocation allocation;
+};
 
-        void createDepthResources() {
-            const VkFormat depthFormat = this->findDepthFormat();
+/// @brief A command buffer recorded for one frame slot and swap chain image, and the scene
+/// it was recorded against.
+struct StaticCommandBuffer final {
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    RecordedScene scene;
+};
 
-            const auto [depthImage, depthImageMemory] = this->createImage(
-                m_swapChainExtent.width,
-                m_swapChainExtent.height,
-                1,
-                VK_SAMPLE_COUNT_1_BIT,
-                depthFormat,
-                VK_IMAGE_TILING_OPTIMAL,
-                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-            );
-            auto depthImageView = this->createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
+/// @brief The settings of a benchmark run, from the command line.
+struct BenchmarkOptions final {
+    uint32_t frameCount = BENCHMARK_FRAME_COUNT;
+    std::filesystem::path outputPath = BENCHMARK_OUTPUT_FILE;
+    /// @brief Where the baselines of every device and driver live.
+    std::filesystem::path baselineDirectory = BENCHMARK_BASELINE_DIRECTORY;
+    /// @brief Whether the run replaces the baseline of its device and driver instead of
+    /// being compared with it.
+    bool isUpdatingBaseline = false;
+};
 
-            m_depthImage = depthImage;
-            m_depthImageMemory = depthImageMemory;
-            m_depthImageView = depthImageView;
-        }
+/// @brief Whether the app calibrates the device, and picks its settings from the profile.
+enum class CalibrationMode {
+    /// @brief Calibrate a device without a profile, and take the settings of the profile.
+    Auto,
+    /// @brief Calibrate the device, write its profile, and exit, instead of running the demo.
+    Calibrate,
+    /// @brief Keep the defaults.
+    Off
+};
 
-        void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
-            // Check if image format supports linear blitting.
-            auto formatProperties = VkFormatProperties {};
-            vkGetPhysicalDeviceFormatProperties(m_engine->getPhysicalDevice(), imageFormat, &formatProperties);
+/// @brief How the app runs, from the command line.
+struct AppOptions final {
+    std::optional<BenchmarkOptions> benchmark;
+    CalibrationMode calibrationMode = CalibrationMode::Auto;
+    bool isHeadless = false;
+    /// @brief How much validation the engine does.
+    EngineMode engineMode = DEFAULT_ENGINE_MODE;
+    /// @brief Where a headless run writes its last frame, if anywhere.
+    std::optional<std::filesystem::path> readbackPath;
+    /// @brief The frames a headless run draws when it does not benchmark.
+    uint32_t headlessFrameCount = HEADLESS_FRAME_COUNT;
+    /// @brief Where a headless run captures its frames, if anywhere, and every how many
+    /// frames.
+    std::optional<std::filesystem::path> captureDirectory;
+    uint32_t captureInterval = CAPTURE_INTERVAL;
+    /// @brief Whether a headless run exports its frames for an external encoder.
+    bool exportFrames = false;
+    /// @brief The camera views a headless run renders into the layers of its images.
+    uint32_t viewCount = 1;
+    /// @brief The socket to hand the model's assets out on to other instances, if any, or
+    /// the socket to import them from.
+    std::optional<std::string> shareAssetsSocketPath;
+    std::optional<std::string> importAssetsSocketPath;
+    /// @brief Where the mip benchmark writes its results, when it runs instead of the demo.
+    std::optional<std::filesystem::path> mipBenchmarkOutputPath;
+    /// @brief The GPU, or device group, to run on.
+    DeviceSelection deviceSelection;
+    /// @brief The number of independent headless render lanes, each an app of its own on a
+    /// GPU of its own, and the lane this app is.
+    uint32_t laneCount = 1;
+    uint32_t laneIndex = 0;
+    /// @brief Whether to recompile the shaders that change while the app runs, and swap in
+    /// the pipelines that use them.
+    bool hotReloadShaders = false;
+    /// @brief Where to pack the assets into an archive, when that runs instead of the demo.
+    std::optional<std::filesystem::path> packAssetsPath;
+    /// @brief Whether to build every pipeline permutation into the pipeline cache, and exit,
+    /// instead of running the demo.
+    bool prewarmPipelines = false;
+    /// @brief Where to export the metrics of the frame loop, if anywhere. Every render lane
+    /// after the first serves Prometheus on a port of its own, one past the lane before.
+    std::optional<MetricsEndpoint> metricsEndpoint;
+    /// @brief The synthetic scene that replaces the grid, if any.
+    std::optional<StressSceneOptions> stressScene;
+    /// @brief Whether the scene advances by a fixed step every frame, and timing never
+    /// changes what a frame draws.
+    bool isDeterministic = false;
+    /// @brief Where to write the scene state of every frame, if anywhere, and where to
+    /// read the frames of a replay from, if anywhere.
+    std::optional<std::filesystem::path> sceneRecordingPath;
+    std::optional<std::filesystem::path> sceneReplayPath;
+    /// @brief Whether the window only draws the frames that show a change.
+    bool isOnDemand = false;
+    /// @brief Whether to lay down the depth of the vertex pipeline's draws in a prepass
+    /// with positions alone and no fragment shader, then shade them testing depth with
+    /// `EQUAL` and without writing it, so that only the nearest fragment of every pixel is
+    /// shaded. This pays for itself in scenes with a lot of overdraw.
+    bool useDepthPrepass = false;
+    /// @brief The windows opened next to the main window, which show its frames.
+    uint32_t viewportWindowCount = 0;
+    /// @brief How many images the swap chains of the windows ask for.
+    SwapChainImageCountPolicy swapChainImageCountPolicy = SWAP_CHAIN_IMAGE_COUNT_POLICY;
+};
 
-            if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
-                throw std::runtime_error("texture image format does not support linear blitting!");
-            }
+/// @brief The file a render lane writes in place of `path`, so that lanes never write the
+/// same file.
+static std::filesystem::path getLanePath(const std::filesystem::path& path, uint32_t laneIndex) {
+    const auto fileName = fmt::format("{}.lane{}{}", path.stem().string(), laneIndex, path.extension().string());
 
-            VkCommandBuffer commandBuffer = this->beginSingleTimeCommands();
+    return path.parent_path() / fileName;
+}
 
-            auto barrier = VkImageMemoryBarrier {};
-            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-            barrier.image = image;
-            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            barrier.subresourceRange.baseArrayLayer = 0;
-            barrier.subresourceRange.layerCount = 1;
-            barrier.subresourceRange.levelCount = 1;
+/// @brief The file the camera view `viewIndex` of a multiview frame is written to in place
+/// of `path`.
+static std::filesystem::path getViewPath(const std::filesystem::path& path, uint32_t viewIndex) {
+    const auto fileName = fmt::format("{}.view{}{}", path.stem().string(), viewIndex, path.extension().string());
 
-            int32_t mipWidth = texWidth;
-            int32_t mipHeight = texHeight;
+    return path.parent_path() / fileName;
+}
 
-            for (uint32_t i = 1; i < mipLevels; i++) {
-                barrier.subresourceRange.baseMipLevel = i - 1;
-                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-                barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+/// @brief A way of generating a mip chain that the mip benchmark compares.
+enum class MipBenchmarkBackend {
+    /// @brief One blit per level on the graphics queue.
+    Blit,
+    /// @brief The compute generator with a box filter, which takes the single-pass
+    /// downsampler for power-of-two extents.
+    ComputeBox,
+    /// @brief The compute generator with `MIP_FILTER`, one dispatch per level.
+    ComputeFilter,
+    /// @brief The CPU generator with a box filter.
+    CpuBox,
+    /// @brief The CPU generator with `CPU_MIP_FILTER`.
+    CpuFilter
+};
 
-                vkCmdPipelineBarrier(
-                    commandBuffer,
-                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                    0, nullptr,
-                    0, nullptr,
-                    1, &barrier
-                );
+/// @brief The kind of image the mip benchmark generates a chain for.
+enum class MipBenchmarkShape {
+    /// @brief A 2D image of one layer.
+    Flat,
+    /// @brief A cube map, whose six faces are filtered in the same dispatches.
+    CubeMap,
+    /// @brief A 3D image, filtered along all three axes.
+    Volume
+};
 
-                const auto blit = VkImageBlit {
-                    .srcOffsets[0] = { 0, 0, 0 },
-                    .srcOffsets[1] = { mipWidth, mipHeight, 1 },
-                    .srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .srcSubresource.mipLevel = i - 1,
-                    .srcSubresource.baseArrayLayer = 0,
-                    .srcSubresource.layerCount = 1,
-                    .dstOffsets[0] = { 0, 0, 0 },
-                    .dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 },
-                    .dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .dstSubresource.mipLevel = i,
-                    .dstSubresource.baseArrayLayer = 0,
-                    .dstSubresource.layerCount = 1,
-                };
-
-                vkCmdBlitImage(
-                    commandBuffer,
-                    image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                    image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                    1, &blit,
-                    VK_FILTER_LINEAR
-                );
+/// @brief The mip generation times of one backend, shape, format and extent, averaged over
+/// every repetition.
+///
+/// @note The CPU time of a GPU backend is the time spent recording its commands. The CPU
+/// backends have no GPU time. A combination whose image or texels could not be allocated
+/// has no times at all. The extent of a cube map is that of each of its faces.
+struct MipBenchmarkResult final {
+    MipBenchmarkBackend backend;
+    MipBenchmarkShape shape;
+    VkFormat format;
+    VkExtent3D extent;
+    double cpuMilliseconds;
+    double gpuMilliseconds;
+    bool isAllocationFailed;
+};
 
-                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-                barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+/// @brief The upload and mip generation times of one texture size, averaged over every
+/// repetition.
+struct TextureBenchmarkResult final {
+    uint32_t size;
+    double uploadMegabytesPerSecond;
+    double mipGenerationMilliseconds;
+};
 
-                vkCmdPipelineBarrier(
-                    commandBuffer,
-                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-                    0, nullptr,
-                    0, nullptr,
-                    1, &barrier
-                );
+/// @brief The uniform buffer object for distpaching camera data to the GPU.
+///
+/// @note Vulkan expects data to be aligned in a specific way. For example,
+/// let `T` be a data type.
+///
+/// @li If `T` is a scalar, `align(T) == sizeof(T)`
+/// @li If `T` is a scalar, `align(vec2<T>) == 2 * sizeof(T)`
+/// @li If `T` is a scalar, `align(vec3<T>) == 4 * sizeof(T)`
+/// @li If `T` is a scalar, `align(vec4<T>) == 4 * sizeof(T)`
+/// @li If `T` is a scalar, `align(mat4<T>) == 4 * sizeof(T)`
+/// @li If `T` is a structure type, `align(T) == max(align(members(T)))`
+///
+/// In particular, each data type is a nice multiple of the alignment of the largest
+/// scalar type constituting that data type. See the specification
+/// https://registry.khronos.org/vulkan/specs/1.3-extensions/html/chap15.html#interfaces-resources-layout
+/// for more details.
+///
+/// The buffer only holds what every draw of a frame shares, with the projection and view
+/// multiplied once on the CPU. The transforms of the draws are push constants. The vertex
+/// and mesh shaders only read the view projection matrix, and the task shader reads the
+/// camera position as well, to cull meshlets by their normal cones. The draw culler reads
+/// the view projection matrix of the frame before too, which the depth pyramid it tests
+/// occlusion against was built with. The fragment shader only reads the LOD bias, which
+/// follows the scale of dynamic resolution, on top of the bias it is specialized with.
+struct UniformBufferObject {
+    glm::mat4x4 viewProj;
+    glm::vec4 cameraPosition;
+    glm::mat4x4 depthPyramidViewProj;
+    float lodBias;
+    /// @brief The pixel of every LOD feedback tile that writes its level this frame.
+    uint32_t lodFeedbackPhase;
+    /// @brief The matrix of every view the scene's vertex shaders pick by view index, the
+    /// first of which is `viewProj`. Only the views the frame renders are filled.
+    alignas(16) std::array<glm::mat4x4, MAX_VIEW_COUNT> viewProjs;
+};
 
-                if (mipWidth > 1) mipWidth /= 2;
-                if (mipHeight > 1) mipHeight /= 2;
-            }
+/// @brief The state of the scene that the update of a frame produces, and the rendering of
+/// the frame reads.
+///
+/// @note The update of the next frame runs on the job system while the main thread submits
+/// and presents the current one, so there are two of these, and every frame reads the one
+/// the update before it wrote. The draws are left empty without indirect draws.
+struct SceneState {
+    /// @brief The seconds since the first frame's scene.
+    double time;
+    glm::vec3 cameraPosition;
+    glm::mat4x4 view;
+    std::vector<VkDrawIndexedIndirectCommand> drawCommands;
+    /// @brief The draws in the order they are written to the indirect draw buffer, kept
+    /// with the state so that its memory is reused from frame to frame.
+    RenderQueue renderQueue;
+    /// @brief The copies the CPU culling found in the frustum, kept with the state for the
+    /// same reason.
+    std::vector<uint32_t> visibleInstances;
+};
 
-            barrier.subresourceRange.baseMipLevel = mipLevels - 1;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+class App final {
+    public:
+        explicit App() = default;
+        /// @brief An app that runs the benchmark when it is given options for one, and
+        /// renders offscreen when it is headless.
+        ///
+        /// @note Benchmarks present immediately and do not pace frames, so that frame times
+        /// are not capped at the refresh rate.
+        explicit App(const AppOptions& options)
+            : m_useDepthPrepass { options.useDepthPrepass }
+            , m_framePacing { options.benchmark ? FramePacing::Unlimited : FRAME_PACING }
+            , m_presentModePolicy { options.benchmark ? PresentModePolicy::Immediate : PRESENT_MODE_POLICY }
+            , m_swapChainImageCountPolicy { options.swapChainImageCountPolicy }
+            , m_benchmarkOptions { options.benchmark }
+            , m_calibrationMode { options.calibrationMode }
+            , m_isHeadless { options.isHeadless }
+            , m_engineMode { options.engineMode }
+            , m_readbackPath { options.readbackPath }
+            , m_headlessFrameCount { options.headlessFrameCount }
+            , m_captureDirectory { options.captureDirectory }
+            , m_captureInterval { options.captureInterval }
+            , m_exportFrames { options.exportFrames }
+            , m_viewCount { options.viewCount }
+            , m_shareAssetsSocketPath { options.shareAssetsSocketPath }
+            , m_importAssetsSocketPath { options.importAssetsSocketPath }
+            , m_mipBenchmarkOutputPath { options.mipBenchmarkOutputPath }
+            , m_deviceSelection { options.deviceSelection }
+            , m_laneCount { options.laneCount }
+            , m_laneIndex { options.laneIndex }
+            , m_hotReloadShaders { options.hotReloadShaders }
+            , m_prewarmPipelines { options.prewarmPipelines }
+            , m_metricsEndpoint { options.metricsEndpoint }
+            , m_stressSceneOptions { options.stressScene }
+            , m_isDeterministic { options.isDeterministic || options.sceneReplayPath.has_value() }
+            , m_sceneRecordingPath { options.sceneRecordingPath }
+            , m_sceneReplayPath { options.sceneReplayPath }
+            , m_isOnDemand { options.isOnDemand }
+            , m_viewportWindowCount { options.viewportWindowCount }
+        {
+        }
 
-            vkCmdPipelineBarrier(
-                commandBuffer,
-                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-                0, nullptr,
-                0, nullptr,
-                1, &barrier
-            );
+        /// @brief An app that starts on `engine`, whose device was opened again after the
+        /// one of an earlier app was lost, instead of creating an engine of its own.
+        ///
+        /// @note The engine has the windows of the earlier app, which had the same options.
+        explicit App(const AppOptions& options, std::unique_ptr<Engine> engine)
+            : App { options }
+        {
+            m_engine = std::move(engine);
+        }
 
-            this->endSingleTimeCommands(commandBuffer);
+        ~App() {
+            this->cleanup();
         }
 
-        void createTextureImage(const std::string& filePath) {
-            auto textureLoader = StbTextureLoader { filePath };
-            const auto stbTextureImage = textureLoader.load();
-            const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(stbTextureImage.width(), stbTextureImage.height())))) + 1;
-            const auto depth = stbTextureImage.channels() + 1;
-            const auto imageSize =  VkDeviceSize { stbTextureImage.width() * stbTextureImage.height() * depth };
-        
-            auto [stagingBuffer, stagingBufferMemory] = this->createBuffer(
-                imageSize,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-            );
-        
-            void* data;
-            vkMapMemory(m_engine->getLogicalDevice(), stagingBufferMemory, 0, imageSize, 0, &data);
-            memcpy(data, &stbTextureImage.pixels(), static_cast<size_t>(imageSize));
-            vkUnmapMemory(m_engine->getLogicalDevice(), stagingBufferMemory);
+        void run() {
+            this->initApp();
+            if (m_isCalibrating) {
+                this->runCalibration();
+                return;
+            }
 
-            auto [textureImage, textureImageMemory] = this->createImage(
-                stbTextureImage.width(),
-                stbTextureImage.height(),
-                mipLevels,
-                VK_SAMPLE_COUNT_1_BIT,
-                VK_FORMAT_R8G8B8A8_SRGB,
-                VK_IMAGE_TILING_OPTIMAL,
-                VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-            );
+            if (m_mipBenchmarkOutputPath) {
+                this->runMipBenchmark(*m_mipBenchmarkOutputPath);
+                return;
+            }
 
-            this->transitionImageLayout(
-                textureImage,
-                VK_FORMAT_R8G8B8A8_SRGB,
-                VK_IMAGE_LAYOUT_UNDEFINED,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                mipLevels
-            );
-            this->copyBufferToImage(
-                stagingBuffer,
-                textureImage,
-                static_cast<uint32_t>(stbTextureImage.width()),
-                static_cast<uint32_t>(stbTextureImage.height())
-            );
-            // Transitioned to `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL` while generating mipmaps.
+            if (m_prewarmPipelines) {
+                this->runPipelinePrewarm();
+                return;
+            }
 
-            vkDestroyBuffer(m_engine->getLogicalDevice(), stagingBuffer, nullptr);
-            vkFreeMemory(m_engine->getLogicalDevice(), stagingBufferMemory, nullptr);
+            if (m_isHeadless || !SEPARATE_RENDER_THREAD) {
+                this->renderFrames();
+                return;
+            }
 
-            this->generateMipmaps(textureImage, VK_FORMAT_R8G8B8A8_SRGB, stbTextureImage.width(), stbTextureImage.height(), mipLevels);
+            m_engine->runWindowEventPump([this]() {
+                if (PIN_THREADS_TO_CPU_TOPOLOGY) {
+                    CpuTopology::pinCurrentThread(m_cpuTopology->getRenderCpus());
+                }
 
-            m_textureImage = textureImage;
-            m_textureImageMemory = textureImageMemory;
-            m_mipLevels = mipLevels;
+                this->renderFrames();
+            });
         }
 
-        void createTextureImageView() {
-            auto textureImageView = this->createImageView(m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, m_mipLevels);
-
-            m_textureImageView = textureImageView;
+        /// @brief Whether the app calibrated a device that had no profile, and has to be
+        /// started again to take the settings of the profile.
+        bool isRestartRequested() const {
+            return m_isRestartRequested;
         }
 
-        void createTextureSampler() {
-            auto properties = VkPhysicalDeviceProperties {};
-            vkGetPhysicalDeviceProperties(m_engine->getPhysicalDevice(), &properties);
+        /// @brief Destroy everything the app created on its device, which was lost, and
+        /// hand over the engine, to open the device again and start a new app on.
+        ///
+        /// @note Throws when the teardown fails, after giving up the engine, since neither
+        /// the app nor the engine can be destroyed again half way through. The caller exits
+        /// then, which takes the rest with it.
+        std::unique_ptr<Engine> releaseLostEngine() {
+            try {
+                // Waits on a lost device return at once, so this only settles the host side.
+                const auto result = vkDeviceWaitIdle(m_engine->getLogicalDevice());
+                if (result != VK_SUCCESS && result != VK_ERROR_DEVICE_LOST) {
+                    throw std::runtime_error("failed to wait for the lost device!");
+                }
 
-            const auto samplerInfo = VkSamplerCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-                .magFilter = VK_FILTER_LINEAR,
-                .minFilter = VK_FILTER_LINEAR,
-                .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-                .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-                .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-                .anisotropyEnable = VK_TRUE,
-                .maxAnisotropy = properties.limits.maxSamplerAnisotropy,
-                .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
-                .unnormalizedCoordinates = VK_FALSE,
-                .compareEnable = VK_FALSE,
-                .compareOp = VK_COMPARE_OP_ALWAYS,
-                .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
-                .minLod = 0.0f,
-                .maxLod = static_cast<float>(m_mipLevels),
-                .mipLodBias = 0.0f,
-                // // Use these parameters to disable anisotropic filtering.
-                // .anisotropyEnable = VK_FALSE,
-                // .maxAnisotropy = 1.0f,
-            };
+                m_engine->markDeviceLost();
+                this->cleanup();
+            } catch (const std::exception& exception) {
+                static_cast<void>(m_engine.release());
+                m_dispatch = nullptr;
 
-            auto textureSampler = VkSampler {};
-            const auto result = vkCreateSampler(m_engine->getLogicalDevice(), &samplerInfo, nullptr, &textureSampler);
-            if (result != VK_SUCCESS) {
-                throw std::runtime_error("failed to create texture sampler!");
+                throw std::runtime_error(fmt::format("failed to recover from the lost device: {}", exception.what()));
             }
+            m_dispatch = nullptr;
 
-            m_textureSampler = textureSampler;
+            return std::move(m_engine);
         }
+    private:
+        std::unique_ptr<Engine> m_engine;
+        /// @brief The engine's table of the commands recorded every frame.
+        const DeviceDispatch* m_dispatch { nullptr };
+        std::unique_ptr<CpuTopology> m_cpuTopology;
+        std::unique_ptr<JobSystem> m_jobSystem;
 
-        void loadModel(const std::string& filePath) {
-            const auto meshLoader = MeshLoader {};
-            const auto mesh = meshLoader.load(filePath);
+        VkSampleCountFlagBits m_msaaSamples { VK_SAMPLE_COUNT_1_BIT };
+        VkImage m_colorImage;
+        GpuAllocation m_colorImageAllocation;
+        VkImageView m_colorImageView;
 
-            m_mesh = std::move(mesh);
-        }
+        VkImage m_depthImage;
+        GpuAllocation m_depthImageAllocation;
+        VkImageView m_depthImageView;
+        std::unique_ptr<DepthPyramid> m_depthPyramid;
+        /// @brief The view projection matrix of the frame before, whose depth the pyramid
+        /// holds when the frame is culled.
+        std::optional<glm::mat4x4> m_depthPyramidViewProj;
+
+        /// @brief Picks the scale the scene is rendered at, when the resolution is dynamic.
+        std::unique_ptr<DynamicResolution> m_dynamicResolution;
+        /// @brief The single-sampled image the scene is rendered or resolved into at its
+        /// scale, and upscaled from into the swap chain image.
+        VkImage m_sceneColorImage { VK_NULL_HANDLE };
+        GpuAllocation m_sceneColorImageAllocation;
+        VkImageView m_sceneColorImageView { VK_NULL_HANDLE };
+        bool m_useTemporalUpscaling { false };
+        std::unique_ptr<TemporalUpscaler> m_temporalUpscaler;
+        /// @brief The jitter of the frame being rendered in rendered pixels, and the map from
+        /// its unjittered clip space to the one of the frame before.
+        std::array<float, 2> m_temporalJitter { 0.0f, 0.0f };
+        glm::mat4x4 m_temporalReprojection { 1.0f };
+        bool m_useFragmentShadingRate { false };
+        bool m_useShadingRateImage { false };
+        std::unique_ptr<ShadingRateImage> m_shadingRateImage;
+        /// @brief How the rate of the shading rate image combines with the rate of a draw.
+        VkFragmentShadingRateCombinerOpKHR m_shadingRateImageCombinerOp { VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR };
 
-        void createVertexBuffer() {
-            const auto bufferSize = VkDeviceSize { sizeof(m_mesh.vertices()[0]) * m_mesh.vertices().size() };
-            VkBufferUsageFlags stagingBufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-            VkMemoryPropertyFlags stagingBufferPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | 
-                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-            auto [stagingBuffer, stagingBufferMemory] = this->createBuffer(
-                bufferSize,
-                stagingBufferUsageFlags, 
-                stagingBufferPropertyFlags
-            );
+        uint32_t m_mipLevels;
+        VkFormat m_textureFormat;
+        VkExtent2D m_textureExtent { 0, 0 };
+        /// @brief Whether regions of the texture can be replaced in place, which takes the
+        /// levels of a blit chain, uncompressed and outside of the texture streamer.
+        bool m_isTextureRegionUpdatable { false };
+        uint32_t m_texturePaintCount { 0 };
+        VkImage m_textureImage { VK_NULL_HANDLE };
+        GpuAllocation m_textureImageAllocation;
+        VkImageView m_textureImageView { VK_NULL_HANDLE };
+        VkSampler m_textureSampler { VK_NULL_HANDLE };
+        std::unique_ptr<TextureStreamer> m_textureStreamer;
+        /// @brief Generates the mip chain of a texture decoded mid-session, until it is
+        /// complete, and the timeline value of the chain's readback for the texture cache.
+        std::unique_ptr<MipmapSlicer> m_mipmapSlicer;
+        std::optional<uint64_t> m_pendingTextureCacheReadbackValue;
+        /// @brief How many levels coarser than the view needs the streamed texture is held,
+        /// to keep the device local heaps inside their budgets.
+        uint32_t m_textureLevelBias { 0 };
+        /// @brief The frames left before the level bias may change again.
+        uint32_t m_memoryBudgetCooldown { 0 };
+
+        bool m_streamAssets { false };
+        std::unique_ptr<AssetStreamer> m_assetStreamer;
+        std::unique_ptr<AsyncFileReader> m_fileReader;
+        /// @brief The reads into the staging ring that the batch being recorded has to wait
+        /// on before it is submitted.
+        std::vector<AsyncReadHandle> m_pendingTextureReads;
+        /// @brief The host copies that the reads of their levels schedule once they land,
+        /// which also have to finish before the batch is submitted.
+        std::vector<std::future<JobHandle>> m_pendingHostCopies;
+        /// @brief Whether the texture of the model has finished uploading, so that the
+        /// texture table holds it rather than the placeholder.
+        bool m_isTextureResident { false };
+        /// @brief The timeline value of the upload of the streamed texture, while it runs,
+        /// and the bytes it stages.
+        std::optional<uint64_t> m_pendingTextureUploadValue;
+        VkDeviceSize m_pendingTextureUploadSize { 0 };
+        /// @brief Caps the uploads that streaming submits in a frame.
+        std::unique_ptr<UploadScheduler> m_uploadScheduler;
+        VkImage m_placeholderTextureImage { VK_NULL_HANDLE };
+        GpuAllocation m_placeholderTextureImageAllocation;
+        VkImageView m_placeholderTextureImageView { VK_NULL_HANDLE };
+        VkSampler m_placeholderTextureSampler { VK_NULL_HANDLE };
+        /// @brief The synthetic scene that replaces the grid, if any, and the textures and
+        /// samplers of its materials, by `StressFilter`.
+        std::optional<StressSceneOptions> m_stressSceneOptions;
+        std::vector<StressTexture> m_stressTextures;
+        std::vector<StressTexturePage> m_stressTexturePages;
+        std::array<VkSampler, static_cast<size_t>(StressFilter::Count)> m_stressSamplers {};
+        /// @brief The generation of the sampler cache the model and stress samplers were
+        /// last taken at.
+        uint64_t m_samplerGeneration { 0 };
+
+        std::future<TextureCacheEntry> m_pendingCpuMipChain;
+        std::unique_ptr<StbTextureDecodePool> m_textureDecodePool;
+        std::optional<TextureCacheEntry> m_pendingTextureCacheEntry;
+        VkBuffer m_textureCacheReadbackBuffer { VK_NULL_HANDLE };
+        GpuAllocation m_textureCacheReadbackAllocation;
+
+        /// @brief Loads every mesh once per canonical path and import settings, and keeps the
+        /// ones released most recently in memory, up to `MESH_REGISTRY_CACHE_BUDGET`.
+        std::unique_ptr<AssetRegistry<Mesh>> m_meshRegistry;
+        AssetRegistry<Mesh>::Handle m_mesh;
+        float m_meshRadius;
+        glm::mat4 m_meshPositionTransform;
+        /// @brief Owns the mesh buffers, which can be replaced or released while frames are
+        /// in flight.
+        std::unique_ptr<GpuResourceTable> m_resourceTable;
+        /// @brief Keeps the books of the shared vertex and index buffers, and where the mesh
+        /// sits in them.
+        std::unique_ptr<GeometryPool> m_geometryPool;
+        GeometryRange m_meshRange;
+        /// @brief Streams the levels of detail of the mesh into the geometry pool, where the
+        /// mesh has more than one. The vertex range of the mesh is `m_meshRange`, and the
+        /// streamer owns the index ranges of its levels.
+        std::unique_ptr<GeometryStreamer> m_geometryStreamer;
+        GeometryUpload m_initialGeometryUpload;
+        GpuBufferHandle m_vertexBuffer;
+        std::vector<VkDeviceSize> m_vertexStreamOffsets;
+        GpuBufferHandle m_indexBuffer;
+        GpuBufferHandle m_instanceBuffer;
+        uint32_t m_instanceCount;
+        /// @brief A node for every copy of the mesh, whose world matrix is the copy's
+        /// instance transform.
+        Scene m_scene;
+        /// @brief The hierarchy the draws are culled with on the CPU, when they are not
+        /// culled on the GPU.
+        std::unique_ptr<InstanceBvh> m_instanceBvh;
+        /// @brief The host-visible buffer the scene's changes are copied to the GPU through,
+        /// with a region for every frame in flight.
+        VkBuffer m_sceneUploadBuffer { VK_NULL_HANDLE };
+        GpuAllocation m_sceneUploadBufferAllocation;
+        VkDeviceSize m_sceneUploadRegionSize { 0 };
+
+        bool m_defragmentMemory { false };
+        std::vector<MovableBuffer> m_movableBuffers;
+        std::optional<BufferMove> m_pendingBufferMove;
+        uint64_t m_bufferGeneration { 0 };
+        uint32_t m_framesSinceDefragmentation { 0 };
+
+        bool m_useMeshShaders { false };
+        bool m_useDynamicRendering { false };
+        bool m_usePostProcessSubpass { false };
+        bool m_useIndirectDraws { false };
+        std::unique_ptr<IndirectDrawBuffer> m_indirectDrawBuffer;
+        bool m_cullDraws { false };
+        bool m_buildDepthPyramid { false };
+        bool m_useDepthPrepass { false };
+        GpuBufferHandle m_boundingSphereBuffer;
+        std::unique_ptr<DrawCuller> m_drawCuller;
+        bool m_useOcclusionQueries { false };
+        std::unique_ptr<OcclusionQueries> m_occlusionQueries;
+        std::vector<MeshletLod> m_meshletLods;
+        GpuBufferHandle m_meshletBuffer;
+        std::array<VkDescriptorBufferInfo, 3> m_meshletBufferRanges;
+        VkDescriptorSetLayout m_meshletDescriptorSetLayout;
+        VkDescriptorSet m_meshletDescriptorSet;
+
+        bool m_pullVertices { false };
+        VkDescriptorSetLayout m_vertexPullDescriptorSetLayout;
+        VkDescriptorSet m_vertexPullDescriptorSet { VK_NULL_HANDLE };
+
+        /// @brief Whether the draw pipelines bind their sets from the descriptor buffer, in
+        /// which case their descriptor sets are never allocated.
+        bool m_useDescriptorBuffer { false };
+        std::unique_ptr<DescriptorBuffer> m_descriptorBuffer;
+        std::vector<DescriptorBufferSet> m_uniformBufferSets;
+        std::vector<DescriptorBufferSet> m_textureTableBufferSets;
+        DescriptorBufferSet m_meshletBufferSet;
+        DescriptorBufferSet m_vertexPullBufferSet;
+        /// @brief The size of the vertex buffer, which descriptors written by address name.
+        VkDeviceSize m_vertexBufferSize { 0 };
+
+        /// @brief Whether the draw pipelines take their `DrawState` from the command buffer.
+        bool m_useExtendedDynamicState { false };
+
+        std::array<SceneState, 2> m_sceneStates;
+        /// @brief The scene state the current frame reads.
+        uint32_t m_sceneStateIndex { 0 };
+        /// @brief The update writing the other scene state, while it runs.
+        JobHandle m_pendingSceneUpdate;
+
+        std::unique_ptr<UniformRing> m_uniformRing;
+        /// @brief The mip levels the fragment shader asked for, which set 0 binds for every
+        /// frame slot whether or not the shader writes them.
+        std::unique_ptr<LodFeedback> m_lodFeedback;
+        bool m_useLodFeedback { false };
+        /// @brief The model texture, when it streams as a virtual texture, whose atlas
+        /// `m_textureImage` is then.
+        std::unique_ptr<VirtualTexture> m_virtualTexture;
+        bool m_useVirtualTexture { false };
+        /// @brief The dynamic offset of the uniform buffer of the current frame in the
+        /// uniform ring.
+        uint32_t m_uniformBufferOffset;
+
+        std::unique_ptr<DescriptorAllocator> m_descriptorAllocator;
+        std::vector<VkDescriptorSet> m_descriptorSets;
+        VkDescriptorSetLayout m_descriptorSetLayout;
+        std::vector<VkDescriptorSet> m_textureTableSets;
+        /// @brief The model texture each frame's texture table holds.
+        std::vector<VkDescriptorImageInfo> m_textureTableEntries;
+        /// @brief The sampler generation of the stress materials in each frame's texture
+        /// table.
+        std::vector<uint64_t> m_textureTableSamplerGenerations;
+        VkDescriptorSetLayout m_textureTableSetLayout;
+
+        std::vector<VkCommandPool> m_commandPools;
+        std::vector<VkCommandBuffer> m_commandBuffers;
+        std::vector<VkCommandBuffer> m_sceneUploadCommandBuffers;
+        std::vector<std::unique_ptr<FrameArena>> m_frameArenas;
+        std::vector<std::vector<StaticCommandBuffer>> m_staticCommandBuffers;
+        std::unique_ptr<SecondaryCommandRecorder> m_secondaryCommandRecorder;
+        std::unique_ptr<GpuProfiler> m_gpuProfiler;
+        std::chrono::steady_clock::time_point m_gpuTimingsTitleTime;
+        std::unique_ptr<PerformanceHud> m_performanceHud;
+        bool m_isPerformanceHudVisible { false };
+        bool m_wasPerformanceHudKeyDown { false };
+        /// @brief When the last frame started, for the frame time the HUD graphs on the CPU.
+        std::optional<std::chrono::steady_clock::time_point> m_lastFrameStartTime;
+        /// @brief The commands of the last frame, collected when the next one starts.
+        CommandFrameCounts m_commandCounts;
+        /// @brief The target the dashboard is drawn into, which the model samples in place of
+        /// its texture, and the HUD that draws it.
+        std::unique_ptr<RenderTexture> m_dashboardTexture;
+        std::unique_ptr<PerformanceHud> m_dashboardHud;
+        VkSampler m_dashboardSampler { VK_NULL_HANDLE };
+
+        VkRenderPass m_renderPass { VK_NULL_HANDLE };
+        /// @brief The pipeline of the second subpass of the render pass, and the scene color
+        /// it reads as an input attachment, with the set that binds it, which are created
+        /// again with the swap chain.
+        VkDescriptorSetLayout m_postProcessSetLayout { VK_NULL_HANDLE };
+        VkPipelineLayout m_postProcessPipelineLayout { VK_NULL_HANDLE };
+        VkPipeline m_postProcessPipeline { VK_NULL_HANDLE };
+        VkImage m_postProcessInputImage { VK_NULL_HANDLE };
+        GpuAllocation m_postProcessInputImageAllocation;
+        VkImageView m_postProcessInputImageView { VK_NULL_HANDLE };
+        VkDescriptorPool m_postProcessDescriptorPool { VK_NULL_HANDLE };
+        VkDescriptorSet m_postProcessDescriptorSet { VK_NULL_HANDLE };
+        /// @brief The average luminance and the bloom the post effects pass builds out of the
+        /// post process input, for the frame after, if any.
+        std::unique_ptr<LuminanceReduction> m_luminanceReduction;
+        std::unique_ptr<BloomChain> m_bloomChain;
+        VkPipelineLayout m_pipelineLayout;
+        PipelineHandle m_graphicsPipeline { PipelineCompiler::INVALID_HANDLE };
+        PipelineHandle m_depthPrepassPipeline { PipelineCompiler::INVALID_HANDLE };
+        PipelineHandle m_occlusionProxyPipeline { PipelineCompiler::INVALID_HANDLE };
+        VkPipelineLayout m_meshShaderPipelineLayout;
+        PipelineHandle m_meshShaderPipeline { PipelineCompiler::INVALID_HANDLE };
+        // The rebuilds of the pipelines whose shaders were reloaded, or the optimized links
+        // of fast linked ones, until they are ready.
+        PipelineHandle m_pendingGraphicsPipeline { PipelineCompiler::INVALID_HANDLE };
+        PipelineHandle m_pendingDepthPrepassPipeline { PipelineCompiler::INVALID_HANDLE };
+        PipelineHandle m_pendingMeshShaderPipeline { PipelineCompiler::INVALID_HANDLE };
+        // Whether the vertex pipeline and the depth prepass are fast links, to be replaced
+        // by optimized links built in the background once nothing else is pending.
+        bool m_needsOptimizedLinks { false };
+        std::vector<RetiredPipeline> m_retiredPipelines;
+        // The code of every pipeline build, which it reads until it is done.
+        std::unordered_map<PipelineHandle, std::vector<ShaderStageCode>> m_buildShaderStageCode;
+        // The parts the vertex pipeline and the depth prepass are linked from, when they are.
+        std::unique_ptr<GraphicsPipelineLibrary> m_pipelineLibrary;
 
-            void* data;
-            vkMapMemory(m_engine->getLogicalDevice(), stagingBufferMemory, 0, bufferSize, 0, &data);
-            memcpy(data, m_mesh.vertices().data(), static_cast<size_t>(bufferSize));
-            vkUnmapMemory(m_engine->getLogicalDevice(), stagingBufferMemory);
+        std::vector<VkSemaphore> m_imageAvailableSemaphores;
+        std::vector<VkSemaphore> m_renderFinishedSemaphores;
+        VkSemaphore m_frameTimelineSemaphore;
+        std::vector<uint64_t> m_inFlightSubmitCounts;
+        // The frame slot whose semaphores the last present waited on.
+        uint32_t m_lastPresentFrame { 0 };
 
-            VkBufferUsageFlags vertexBufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | 
-                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-            VkMemoryPropertyFlags vertexBufferPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        VkSwapchainKHR m_swapChain { VK_NULL_HANDLE };
+        std::vector<VkImage> m_swapChainImages;
+        VkFormat m_swapChainImageFormat;
+        VkColorSpaceKHR m_swapChainColorSpace { VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+        VkExtent2D m_swapChainExtent;
+        std::vector<VkImageView> m_swapChainImageViews;
+        std::vector<VkFramebuffer> m_swapChainFramebuffers;
+        std::vector<RetiredSwapChain> m_retiredSwapChains;
+        uint64_t m_swapChainGeneration { 0 };
+
+        std::vector<ViewportSwapChain> m_viewportSwapChains;
+        std::vector<RetiredViewportSwapChain> m_retiredViewportSwapChains;
+        /// @brief The semaphores the images of the viewport windows are acquired with, frame
+        /// slot by frame slot, and viewport by viewport.
+        std::vector<std::vector<VkSemaphore>> m_viewportImageAvailableSemaphores;
+        /// @brief The command buffers that blit the frame into the viewport windows, one per
+        /// frame slot, allocated from the pool of the slot.
+        std::vector<VkCommandBuffer> m_viewportCommandBuffers;
+
+        /// @brief The pools of the present queue family, one per frame slot, when that is
+        /// not the graphics queue family, and the command buffers that take the presented
+        /// images over from the ones that hand them off.
+        std::vector<VkCommandPool> m_presentCommandPools;
+        std::vector<VkCommandBuffer> m_presentReleaseCommandBuffers;
+        std::vector<VkCommandBuffer> m_presentAcquireCommandBuffers;
+        std::vector<VkSemaphore> m_presentAcquiredSemaphores;
+    
+        uint32_t m_currentFrame = 0;
+        uint64_t m_submitCount { 0 };
+        uint32_t m_framesInFlight { FRAMES_IN_FLIGHT };
+        FramePacing m_framePacing { FRAME_PACING };
+        /// @brief When the next frame may start while the window is in the background, and
+        /// whether the frame being drawn holds streaming back.
+        std::chrono::steady_clock::time_point m_nextBackgroundFrameTime;
+        bool m_isStreamingSuspended { false };
+        std::chrono::steady_clock::time_point m_nextFrameTime;
+
+        PresentModePolicy m_presentModePolicy { PRESENT_MODE_POLICY };
+        SwapChainImageCountPolicy m_swapChainImageCountPolicy { SWAP_CHAIN_IMAGE_COUNT_POLICY };
+        uint64_t m_presentId { 0 };
+        uint64_t m_pendingPresentId { 0 };
+        std::chrono::steady_clock::time_point m_pendingPresentTime;
+        std::chrono::duration<double, std::milli> m_presentLatencyTotal { 0.0 };
+        uint64_t m_presentLatencyCount { 0 };
+        FrameLatencyTracker m_frameLatencyTracker;
+
+        std::optional<BenchmarkOptions> m_benchmarkOptions;
+        std::vector<double> m_benchmarkFrameTimes;
+        /// @brief The commands of every frame that is timed, summed up.
+        CommandFrameCounts m_benchmarkCommandCounts;
+
+        CalibrationMode m_calibrationMode { CalibrationMode::Auto };
+        /// @brief Whether this launch measures the device instead of running the demo, and
+        /// whether the app has to start again to take the profile it wrote.
+        bool m_isCalibrating { false };
+        bool m_isRestartRequested { false };
+        /// @brief The settings the profile of the device picked, if it has one and they apply.
+        std::optional<PerformancePreset> m_performancePreset;
+
+        bool m_isHeadless { false };
+        std::optional<std::filesystem::path> m_readbackPath;
+        uint32_t m_headlessFrameCount { HEADLESS_FRAME_COUNT };
+        std::optional<std::filesystem::path> m_captureDirectory;
+        uint32_t m_captureInterval { CAPTURE_INTERVAL };
+        std::unique_ptr<FrameCapture> m_frameCapture;
+        CaptureEncoding m_captureEncoding { CaptureEncoding::Raw };
+        bool m_exportFrames { false };
+        std::unique_ptr<FrameExporter> m_frameExporter;
+        /// @brief The camera views every pass renders with multiview, one per layer of the
+        /// offscreen images and the attachments.
+        uint32_t m_viewCount { 1 };
+        std::vector<GpuAllocation> m_offscreenImageAllocations;
+        std::optional<std::string> m_shareAssetsSocketPath;
+        std::optional<std::string> m_importAssetsSocketPath;
+        /// @brief The model's buffers and texture, when this app hands them out to other
+        /// instances, or when it takes them from one. Either holds the memory of the shared
+        /// buffers and owns the shared texture image.
+        std::unique_ptr<SharedAssetPublisher> m_sharedAssetPublisher;
+        std::unique_ptr<SharedAssetImporter> m_sharedAssetImporter;
+        std::optional<std::filesystem::path> m_mipBenchmarkOutputPath;
+        bool m_prewarmPipelines { false };
+        uint32_t m_lastImageIndex { 0 };
+        DeviceSelection m_deviceSelection;
+        uint32_t m_laneCount { 1 };
+        uint32_t m_laneIndex { 0 };
+
+        EngineMode m_engineMode { DEFAULT_ENGINE_MODE };
+
+        bool m_hotReloadShaders { false };
+        std::unique_ptr<ShaderReloader> m_shaderReloader;
+        std::unordered_map<HlslShader, std::vector<uint32_t>> m_reloadedShaderCode;
+
+        std::optional<MetricsEndpoint> m_metricsEndpoint;
+        std::unique_ptr<MetricsExporter> m_metricsExporter;
+
+        bool m_isDeterministic { false };
+        std::optional<std::filesystem::path> m_sceneRecordingPath;
+        std::optional<std::filesystem::path> m_sceneReplayPath;
+        /// @brief The scene state of every frame drawn so far, while recording, or of every
+        /// frame to draw, while replaying.
+        std::unique_ptr<SceneRecording> m_sceneRecording;
+        std::unique_ptr<SceneRecording> m_sceneReplay;
+        /// @brief The frame the next scene update computes the scene of, and when the first
+        /// one did, by the wall clock.
+        uint64_t m_sceneFrameIndex { 0 };
+        std::optional<std::chrono::steady_clock::time_point> m_sceneStartTime;
+        /// @brief The time the orbit of the camera stands still at, while it is paused.
+        std::optional<double> m_pausedSceneTime;
+        bool m_wasCameraOrbitKeyDown { false };
+
+        bool m_isOnDemand { false };
+        std::unique_ptr<RedrawScheduler> m_redrawScheduler;
+        /// @brief The window events that had reached the window by the last frame drawn on
+        /// demand.
+        uint64_t m_windowEventCount { 0 };
+
+        uint32_t m_viewportWindowCount { 0 };
 
-            const auto [vertexBuffer, vertexBufferMemory] = this->createBuffer(
-                bufferSize,
-                vertexBufferUsageFlags,
-                vertexBufferPropertyFlags
-            );
+        void cleanup() {
+            // A scene update left running writes the scene state, so it finishes before
+            // anything is destroyed. Its error no longer matters by then.
+            if (m_pendingSceneUpdate != nullptr) {
+                try {
+                    m_jobSystem->wait(m_pendingSceneUpdate);
+                } catch (...) {
+                }
+                m_pendingSceneUpdate = nullptr;
+            }
+
+            m_shaderReloader.reset();
+            m_metricsExporter.reset();
+            if (m_engine != nullptr && m_engine->isInitialized()) {
+                // A lost device has nothing to read back. The captures it never finished
+                // fail their waits and write nothing, and the texture cache is left for the
+                // next launch to fill.
+                if (m_engine->isDeviceLost()) {
+                    m_pendingTextureCacheReadbackValue.reset();
+                    m_pendingTextureCacheEntry.reset();
+                }
 
-            this->copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
+                // The captures in flight copy from the offscreen images.
+                m_frameCapture.reset();
+                this->cleanupSwapChain();
+                // The exported images outlive the offscreen swap chains that borrow them.
+                m_frameExporter.reset();
+
+                // Builds still running point at the layouts and the render pass.
+                auto& pipelineCompiler = m_engine->getPipelineCompiler();
+                pipelineCompiler.waitIdle();
+                this->destroyAllRetiredPipelines();
+                if (m_pendingGraphicsPipeline != PipelineCompiler::INVALID_HANDLE) {
+                    pipelineCompiler.destroyPipeline(m_pendingGraphicsPipeline);
+                }
+                if (m_pendingMeshShaderPipeline != PipelineCompiler::INVALID_HANDLE) {
+                    pipelineCompiler.destroyPipeline(m_pendingMeshShaderPipeline);
+                }
+                if (m_pendingDepthPrepassPipeline != PipelineCompiler::INVALID_HANDLE) {
+                    pipelineCompiler.destroyPipeline(m_pendingDepthPrepassPipeline);
+                }
+                pipelineCompiler.destroyPipeline(m_graphicsPipeline);
+                if (m_useDepthPrepass) {
+                    pipelineCompiler.destroyPipeline(m_depthPrepassPipeline);
+                }
+                if (m_useOcclusionQueries) {
+                    pipelineCompiler.destroyPipeline(m_occlusionProxyPipeline);
+                }
+                // The draw pipeline layouts and set layouts belong to the pipeline layout
+                // cache of the engine.
+                if (m_useMeshShaders) {
+                    pipelineCompiler.destroyPipeline(m_meshShaderPipeline);
+                }
+                m_pipelineLibrary.reset();
+                m_dashboardHud.reset();
+                m_dashboardTexture.reset();
+                m_performanceHud.reset();
+                if (m_usePostProcessSubpass) {
+                    vkDestroyPipeline(m_engine->getLogicalDevice(), m_postProcessPipeline, m_engine->getAllocationCallbacks());
+                    vkDestroyPipelineLayout(m_engine->getLogicalDevice(), m_postProcessPipelineLayout, m_engine->getAllocationCallbacks());
+                    vkDestroyDescriptorSetLayout(m_engine->getLogicalDevice(), m_postProcessSetLayout, m_engine->getAllocationCallbacks());
+                }
+                if (!m_useDynamicRendering) {
+                    vkDestroyRenderPass(m_engine->getLogicalDevice(), m_renderPass, m_engine->getAllocationCallbacks());
+                }
 
-            vkDestroyBuffer(m_engine->getLogicalDevice(), stagingBuffer, nullptr);
-            vkFreeMemory(m_engine->getLogicalDevice(), stagingBufferMemory, nullptr);
+                this->cleanupFrameResources();
+                m_descriptorAllocator.reset();
+                m_descriptorBuffer.reset();
+                m_secondaryCommandRecorder.reset();
+                m_gpuProfiler.reset();
+
+                // A texture that never finished loading has no image, view, or sampler, and
+                // may still hold the buffer its mip chain was read back into.
+                m_assetStreamer.reset();
+                if (m_textureCacheReadbackBuffer != VK_NULL_HANDLE) {
+                    m_engine->destroyBuffer(m_textureCacheReadbackBuffer, m_textureCacheReadbackAllocation);
+                }
+                // The samplers belong to the sampler cache.
+                vkDestroyImageView(m_engine->getLogicalDevice(), m_textureImageView, m_engine->getAllocationCallbacks());
+
+                // A sparse texture owns its image, so the streamer destroys it, and a virtual
+                // texture owns its atlas.
+                m_textureStreamer.reset();
+                m_mipmapSlicer.reset();
+                m_virtualTexture.reset();
+                if (m_textureImageAllocation.isValid()) {
+                    m_engine->destroyImage(m_textureImage, m_textureImageAllocation);
+                }
+                if (m_streamAssets) {
+                    vkDestroyImageView(m_engine->getLogicalDevice(), m_placeholderTextureImageView, m_engine->getAllocationCallbacks());
+                    m_engine->destroyImage(m_placeholderTextureImage, m_placeholderTextureImageAllocation);
+                }
+                for (const auto& stressTexture : m_stressTextures) {
+                    vkDestroyImageView(m_engine->getLogicalDevice(), stressTexture.imageView, m_engine->getAllocationCallbacks());
+                    if (stressTexture.allocation.isValid()) {
+                        m_engine->destroyImage(stressTexture.image, stressTexture.allocation);
+                    }
+                }
+                for (const auto& stressTexturePage : m_stressTexturePages) {
+                    m_engine->destroyImage(stressTexturePage.image, stressTexturePage.allocation);
+                }
 
-            m_vertexBuffer = vertexBuffer;
-            m_vertexBufferMemory = vertexBufferMemory;
+                // A move that did not finish leaves the buffer where it was. The table
+                // destroys every mesh buffer, and the buffers moves left behind.
+                if (m_pendingBufferMove.has_value()) {
+                    m_engine->destroyBuffer(m_pendingBufferMove->buffer, m_pendingBufferMove->allocation);
+                    m_pendingBufferMove.reset();
+                }
+                m_resourceTable.reset();
+                m_geometryStreamer.reset();
+                // The table destroyed the shared buffers, but their memory, and the shared
+                // texture, belong to the sharing.
+                m_sharedAssetPublisher.reset();
+                m_sharedAssetImporter.reset();
+            }
         }
 
-        void createIndexBuffer() {
-            const auto bufferSize = VkDeviceSize { sizeof(m_mesh.indices()[0]) * m_mesh.indices().size() };
-            VkBufferUsageFlags stagingBufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-            VkMemoryPropertyFlags stagingBufferPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | 
-                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-            auto [stagingBuffer, stagingBufferMemory] = this->createBuffer(
-                bufferSize,
-                stagingBufferUsageFlags, 
-                stagingBufferPropertyFlags
-            );
-        
-            void* data;
-            vkMapMemory(m_engine->getLogicalDevice(), stagingBufferMemory, 0, bufferSize, 0, &data);
-        
-            memcpy(data, m_mesh.indices().data(), static_cast<size_t>(bufferSize));
-        
-            vkUnmapMemory(m_engine->getLogicalDevice(), stagingBufferMemory);
+        /// @brief Destroy everything there is one of per frame in flight.
+        ///
+        /// @note The descriptor allocator outlives the frames, and resetting it returns the
+        /// meshlet set to its pools along with the frames' descriptor sets.
+        void cleanupFrameResources() {
+            for (size_t i = 0; i < m_imageAvailableSemaphores.size(); i++) {
+                vkDestroySemaphore(m_engine->getLogicalDevice(), m_renderFinishedSemaphores[i], m_engine->getAllocationCallbacks());
+                vkDestroySemaphore(m_engine->getLogicalDevice(), m_imageAvailableSemaphores[i], m_engine->getAllocationCallbacks());
+            }
 
-            VkBufferUsageFlags vertexBufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-            VkMemoryPropertyFlags vertexBufferPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-            const auto [indexBuffer, indexBufferMemory] = this->createBuffer(bufferSize, vertexBufferUsageFlags, vertexBufferPropertyFlags);
+            for (const auto& frameSemaphores : m_viewportImageAvailableSemaphores) {
+                for (const auto semaphore : frameSemaphores) {
+                    vkDestroySemaphore(m_engine->getLogicalDevice(), semaphore, m_engine->getAllocationCallbacks());
+                }
+            }
 
-            this->copyBuffer(stagingBuffer, indexBuffer, bufferSize);
+            for (const auto semaphore : m_presentAcquiredSemaphores) {
+                vkDestroySemaphore(m_engine->getLogicalDevice(), semaphore, m_engine->getAllocationCallbacks());
+            }
 
-            vkDestroyBuffer(m_engine->getLogicalDevice(), stagingBuffer, nullptr);
-            vkFreeMemory(m_engine->getLogicalDevice(), stagingBufferMemory, nullptr);
+            vkDestroySemaphore(m_engine->getLogicalDevice(), m_frameTimelineSemaphore, m_engine->getAllocationCallbacks());
 
-            m_indexBuffer = indexBuffer;
-            m_indexBufferMemory = indexBufferMemory;
-        }
+            // Destroying a frame's pool frees its command buffers.
+            for (const auto& commandPool : m_commandPools) {
+                vkDestroyCommandPool(m_engine->getLogicalDevice(), commandPool, m_engine->getAllocationCallbacks());
+            }
+            for (const auto& commandPool : m_presentCommandPools) {
+                vkDestroyCommandPool(m_engine->getLogicalDevice(), commandPool, m_engine->getAllocationCallbacks());
+            }
 
-        void createDescriptorSetLayout() {
-            const auto uboLayoutBinding = VkDescriptorSetLayoutBinding {
-                .binding = 0,
-                .descriptorCount = 1,
-                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                .pImmutableSamplers = nullptr,
-                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
-            };
-            const auto samplerLayoutBinding = VkDescriptorSetLayoutBinding {
-                .binding = 1,
-                .descriptorCount = 1,
-                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                .pImmutableSamplers = nullptr,
-                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-            };
-            const auto bindings = std::array<VkDescriptorSetLayoutBinding, 2> { uboLayoutBinding, samplerLayoutBinding };
-            const auto layoutInfo = VkDescriptorSetLayoutCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-                .bindingCount = static_cast<uint32_t>(bindings.size()),
-                .pBindings = bindings.data(),
-            };
+            m_engine->destroyBuffer(m_sceneUploadBuffer, m_sceneUploadBufferAllocation);
+            m_sceneUploadBuffer = VK_NULL_HANDLE;
+            m_sceneUploadRegionSize = 0;
 
-            auto descriptorSetLayout = VkDescriptorSetLayout {};
-            const auto result = vkCreateDescriptorSetLayout(m_engine->getLogicalDevice(), &layoutInfo, nullptr, &descriptorSetLayout);
-            if (result != VK_SUCCESS) {
-                throw std::runtime_error("failed to create descriptor set layout!");
+            for (const auto& staticCommandBuffers : m_staticCommandBuffers) {
+                for (const auto& staticCommandBuffer : staticCommandBuffers) {
+                    vkFreeCommandBuffers(m_engine->getLogicalDevice(), m_engine->getCommandPool(), 1, &staticCommandBuffer.commandBuffer);
+                }
             }
 
-            m_descriptorSetLayout = descriptorSetLayout;
+            if (m_useDescriptorBuffer) {
+                m_descriptorBuffer->reset();
+            } else {
+                m_descriptorAllocator->reset();
+            }
+
+            // The culler reads the uniform ring and the indirect draws.
+            m_drawCuller.reset();
+            m_occlusionQueries.reset();
+            m_uniformRing.reset();
+            m_lodFeedback.reset();
+            m_indirectDrawBuffer.reset();
+
+            m_imageAvailableSemaphores.clear();
+            m_renderFinishedSemaphores.clear();
+            m_viewportImageAvailableSemaphores.clear();
+            m_presentAcquiredSemaphores.clear();
+            m_frameTimelineSemaphore = VK_NULL_HANDLE;
+            m_inFlightSubmitCounts.clear();
+            m_commandPools.clear();
+            m_commandBuffers.clear();
+            m_sceneUploadCommandBuffers.clear();
+            m_viewportCommandBuffers.clear();
+            m_presentCommandPools.clear();
+            m_presentReleaseCommandBuffers.clear();
+            m_presentAcquireCommandBuffers.clear();
+            m_frameArenas.clear();
+            m_staticCommandBuffers.clear();
+            m_descriptorSets.clear();
+            m_textureTableSets.clear();
+            m_uniformBufferSets.clear();
+            m_textureTableBufferSets.clear();
+            m_textureTableEntries.clear();
+            m_textureTableSamplerGenerations.clear();
+            m_uniformBufferOffset = 0;
         }
 
-        void createUniformBuffers() {
-            const auto bufferSize = VkDeviceSize { sizeof(UniformBufferObject) };
-            auto uniformBuffers = std::vector<VkBuffer> { MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE };
-            auto uniformBuffersMemory = std::vector<VkDeviceMemory> { MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE };
-            auto uniformBuffersMapped = std::vector<void*> { MAX_FRAMES_IN_FLIGHT, nullptr };
+        void createFrameResources() {
+            this->createUniformBuffers();
+            this->createLodFeedback();
+            this->createIndirectDrawBuffer();
+            this->createDrawCuller();
+            this->createOcclusionQueries();
+            this->createDescriptorSets();
+            if (m_useMeshShaders) {
+                this->createMeshletDescriptorSet();
+            }
+            if (m_pullVertices) {
+                this->createVertexPullDescriptorSet();
+            }
+            this->createCommandBuffers();
+            this->createSceneUploadBuffer();
+            this->createRenderingSyncObjects();
+        }
 
-            for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-                VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-                VkMemoryPropertyFlags propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-            
-                const auto [uniformBuffer, uniformBufferMemory] = this->createBuffer(bufferSize, usageFlags, propertyFlags);
-                void* uniformBufferMapped;      
-                vkMapMemory(m_engine->getLogicalDevice(), uniformBufferMemory, 0, bufferSize, 0, &uniformBufferMapped);
+        /// @brief Rebuild every per-frame resource for `framesInFlight` frames in flight.
+        void setFramesInFlight(uint32_t framesInFlight) {
+            if (framesInFlight < 1 || framesInFlight > MAX_FRAMES_IN_FLIGHT) {
+                throw std::invalid_argument("frames in flight out of range!");
+            }
 
-                uniformBuffers[i] = uniformBuffer;
-                uniformBuffersMemory[i] = uniformBufferMemory;
-                uniformBuffersMapped[i] = uniformBufferMapped;
+            if (framesInFlight == m_framesInFlight) {
+                return;
             }
 
-            m_uniformBuffers = std::move(uniformBuffers);
-            m_uniformBuffersMemory = std::move(uniformBuffersMemory);
-            m_uniformBuffersMapped = std::move(uniformBuffersMapped);
-        }
+            vkDeviceWaitIdle(m_engine->getLogicalDevice());
 
-        void createDescriptorPool() {
-            const auto poolSizes = std::array<VkDescriptorPoolSize, 2> {
-                VkDescriptorPoolSize {
-                    .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                    .descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT),
-                },
-                VkDescriptorPoolSize {
-                    .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                    .descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT),
-                },
-            };
-            const auto poolInfo = VkDescriptorPoolCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-                .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
-                .pPoolSizes = poolSizes.data(),
-                .maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT),
-            };
+            // The frame timeline goes with the frames and starts over, and nothing is in
+            // flight now.
+            for (const auto& retiredSwapChain : m_retiredSwapChains) {
+                this->destroyRetiredSwapChain(retiredSwapChain);
+            }
+            m_retiredSwapChains.clear();
+            for (const auto& retiredViewportSwapChain : m_retiredViewportSwapChains) {
+                vkDestroySwapchainKHR(m_engine->getLogicalDevice(), retiredViewportSwapChain.swapChain, m_engine->getAllocationCallbacks());
+            }
+            m_retiredViewportSwapChains.clear();
+            this->destroyAllRetiredPipelines();
+            m_resourceTable->destroyQueued();
+
+            this->cleanupFrameResources();
+            m_framesInFlight = framesInFlight;
+            m_currentFrame = 0;
+            m_lastPresentFrame = 0;
+            m_submitCount = 0;
+            this->createFrameResources();
+
+            // The image count can follow the frames in flight, and then the swap chains take
+            // the new one.
+            if (!m_isHeadless && m_swapChainImageCountPolicy == SwapChainImageCountPolicy::Matched) {
+                this->recreateSwapChain();
+                for (auto& viewportSwapChain : m_viewportSwapChains) {
+                    viewportSwapChain.isOutOfDate = true;
+                }
+            }
+        }
 
-            auto descriptorPool = VkDescriptorPool {};
-            const auto result = vkCreateDescriptorPool(m_engine->getLogicalDevice(), &poolInfo, nullptr, &descriptorPool);
-            if (result != VK_SUCCESS) {
-                throw std::runtime_error("failed to create descriptor pool!");
+        /// @brief The CPUs of each job worker, or none when threads are not pinned.
+        std::vector<CpuSet> getWorkerCpuSets(uint32_t workerCount) const {
+            if (!PIN_THREADS_TO_CPU_TOPOLOGY) {
+                return {};
             }
 
-            m_descriptorPool = descriptorPool;
+            return m_cpuTopology->getWorkerCpuSets(workerCount);
         }
 
-        void createDescriptorSets() {
-            const auto layouts = std::vector<VkDescriptorSetLayout> { MAX_FRAMES_IN_FLIGHT, m_descriptorSetLayout };
-            const auto allocInfo = VkDescriptorSetAllocateInfo {
-                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-                .descriptorPool = m_descriptorPool,
-                .descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT),
-                .pSetLayouts = layouts.data(),
-            };
-
-            auto descriptorSets = std::vector<VkDescriptorSet> { MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE };
-            const auto result = vkAllocateDescriptorSets(m_engine->getLogicalDevice(), &allocInfo, descriptorSets.data());
-            if (result != VK_SUCCESS) {
-                throw std::runtime_error("failed to allocate descriptor sets!");
+        /// @brief The CPUs of the decode and I/O threads, or none when threads are not
+        /// pinned.
+        CpuSet getBackgroundCpus() const {
+            if (!PIN_THREADS_TO_CPU_TOPOLOGY) {
+                return {};
             }
 
-            for (size_t i = 0; i < descriptorSets.size(); i++) {
-                const auto bufferInfo = VkDescriptorBufferInfo {
-                    .buffer = m_uniformBuffers[i],
-                    .offset = 0,
-                    .range = sizeof(UniformBufferObject),
-                };
+            return m_cpuTopology->getBackgroundCpus();
+        }
 
-                const auto imageInfo = VkDescriptorImageInfo {
-                    .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                    .imageView = m_textureImageView,    
-                    .sampler = m_textureSampler,
-                };
+        void createEngine() {
+            if (m_engine != nullptr) {
+                m_dispatch = &m_engine->getDeviceDispatch();
+                return;
+            }
 
-                const auto descriptorWrites = std::array<VkWriteDescriptorSet, 2> {
-                    VkWriteDescriptorSet {
-                        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                        .dstSet = descriptorSets[i],
-                        .dstBinding = 0,
-                        .dstArrayElement = 0,
-                        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                        .descriptorCount = 1,
-                        .pBufferInfo = &bufferInfo,
-                    },
-                    VkWriteDescriptorSet {
-                        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                        .dstSet = descriptorSets[i],
-                        .dstBinding = 1,
-                        .dstArrayElement = 0,
-                        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                        .descriptorCount = 1,
-                        .pImageInfo = &imageInfo,
-                    },
-                };
+            if (m_isHeadless) {
+                m_engine = Engine::create(m_engineMode, true, m_deviceSelection);
+                m_dispatch = &m_engine->getDeviceDispatch();
+                return;
+            }
 
-                vkUpdateDescriptorSets(
-                    m_engine->getLogicalDevice(),
-                    static_cast<uint32_t>(descriptorWrites.size()),
-                    descriptorWrites.data(),
-                    0,
-                    nullptr
-                );
+            auto engine = Engine::create(m_engineMode, false, m_deviceSelection);
+            engine->createWindow(WIDTH, HEIGHT, WINDOW_TITLE);
+            for (uint32_t i = 0; i < m_viewportWindowCount; i++) {
+                engine->createViewportWindow(WIDTH, HEIGHT, fmt::format("{} - viewport {}", WINDOW_TITLE, i + 1));
             }
 
-            m_descriptorSets = std::move(descriptorSets);
+            m_engine = std::move(engine);
+            m_dispatch = &m_engine->getDeviceDispatch();
         }
 
-        void createCommandBuffers() {
-            auto commandBuffers = std::vector<VkCommandBuffer> { MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE };
-        
-            const auto allocInfo = VkCommandBufferAllocateInfo {
-                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                .commandPool = m_engine->getCommandPool(),
-                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-                .commandBufferCount = static_cast<uint32_t>(commandBuffers.size()),
-            };
-
-            const auto result = vkAllocateCommandBuffers(m_engine->getLogicalDevice(), &allocInfo, commandBuffers.data());
-            if (result != VK_SUCCESS) {
-                throw std::runtime_error("failed to allocate command buffers!");
+        /// @brief Run the steps of startup that do not record into the upload batch as a
+        /// task graph, so that loading the mesh overlaps creating the instance and the
+        /// device.
+        ///
+        /// @note The engine is created on the calling thread, since GLFW has to stay on the
+        /// main thread. Every task times itself, since tasks overlap. The shaders are
+        /// embedded in the binary, so they need no loading.
+        void runInitGraph() {
+            // The render thread is pinned before the engine, and the staging memory the
+            // driver gives it, are created, so that the memory is local to its node.
+            m_cpuTopology = std::make_unique<CpuTopology>(CpuTopology::detect());
+            if (PIN_THREADS_TO_CPU_TOPOLOGY) {
+                CpuTopology::pinCurrentThread(m_cpuTopology->getRenderCpus());
             }
 
-            m_commandBuffers = std::move(commandBuffers);
-        }
+            // The thread that waits on a job runs jobs too, so the workers leave it a core.
+            const auto jobThreadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+            m_jobSystem = std::make_unique<JobSystem>(jobThreadCount, this->getWorkerCpuSets(jobThreadCount));
+            m_fileReader = std::make_unique<AsyncFileReader>(FILE_READ_QUEUE_DEPTH, this->getBackgroundCpus());
+            m_meshRegistry = std::make_unique<AssetRegistry<Mesh>>(MESH_REGISTRY_CACHE_BUDGET);
+
+            auto initGraph = TaskGraph {};
+            const auto engineTask = initGraph.addTask("create engine", {}, [this]() {
+                // The engine times the steps of its own creation.
+                this->createEngine();
+            }, TaskAffinity::CallingThread);
+            initGraph.addTask("load mesh", {}, [this]() {
+                auto startupTimeline = StartupTimeline {};
+                this->loadModel(MODEL_PATH);
+                startupTimeline.mark("load mesh");
+            });
+            const auto pipelineCompilerTask = initGraph.addTask("create pipeline compiler", { engineTask }, [this]() {
+                auto startupTimeline = StartupTimeline {};
+                m_engine->createPipelineCache(this->getLaneFilePath(PIPELINE_CACHE_FILE));
+                startupTimeline.mark("load pipeline cache");
+                m_engine->createPipelineCompiler(PARALLEL_PIPELINE_COMPILATION ? std::thread::hardware_concurrency() : 1);
+                startupTimeline.mark("start pipeline compiler");
+            });
+            initGraph.addTask("create mipmap generator", { pipelineCompilerTask }, [this]() {
+                auto startupTimeline = StartupTimeline {};
+                m_engine->createMipmapGenerator(
+                    shaders_hlsl::getHlslShader(HlslShader::MipmapComp),
+                    shaders_hlsl::getHlslShader(HlslShader::MipmapFilterComp),
+                    shaders_hlsl::getHlslShader(HlslShader::MipmapVolumeComp)
+                );
+                startupTimeline.mark("create mipmap generator");
+            });
+            initGraph.addTask("create texture compressor", { pipelineCompilerTask }, [this]() {
+                if (!COMPRESS_TEXTURES_ON_LOAD) {
+                    return;
+                }
 
-        VkSurfaceFormatKHR selectSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
-            for (const auto& availableFormat : availableFormats) {
-                if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-                    return availableFormat;
+                auto startupTimeline = StartupTimeline {};
+                m_engine->createTextureCompressor(shaders_hlsl::getHlslShader(HlslShader::TextureCompressComp));
+                startupTimeline.mark("create texture compressor");
+            });
+            initGraph.addTask("create GPU decompressor", { pipelineCompilerTask }, [this]() {
+                if (!DECOMPRESS_ASSETS_ON_GPU) {
+                    return;
                 }
-            }
 
-            return availableFormats[0];
+                auto startupTimeline = StartupTimeline {};
+                m_engine->createGpuDecompressor(shaders_hlsl::getHlslShader(HlslShader::Lz4DecompressComp));
+                startupTimeline.mark("create GPU decompressor");
+            });
+
+            initGraph.run(INIT_GRAPH_THREAD_COUNT);
         }
 
-        VkPresentModeKHR selectSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
-            for (const auto& availablePresentMode : availablePresentModes) {
-                if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-                    return availablePresentMode;
+        void initApp() {
+            // A recording that cannot be replayed fails the run before anything is created.
+            if (m_sceneReplayPath) {
+                m_sceneReplay = std::make_unique<SceneRecording>(SceneRecording::load(*m_sceneReplayPath));
+                if (m_sceneReplay->getFrameCount() == 0) {
+                    throw std::runtime_error("failed to replay scene recording: it has no frames!");
                 }
             }
+            if (m_sceneRecordingPath) {
+                m_sceneRecording = std::make_unique<SceneRecording>();
+            }
 
-            // We would probably want to use `VK_PRESENT_MODE_FIFO_KHR` on mobile devices.
-            return VK_PRESENT_MODE_FIFO_KHR;
-        }
-
-        VkExtent2D selectSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) {
-            if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
-                return capabilities.currentExtent;
+            this->runInitGraph();
+            this->loadPerformancePreset();
+
+            auto startupTimeline = StartupTimeline {};
+
+            // Every startup upload is recorded into one batch and submitted once. The
+            // batch keeps running while the rest of the renderer is created, and we only
+            // wait on it right before the first frame.
+            auto& uploadContext = m_engine->getUploadContext();
+            auto uploadBatch = uploadContext.beginBatch();
+
+            // The profiler has a slot for every frame in flight there can be, and one more
+            // for the startup batch, which runs on the graphics queue family too. With a
+            // device group every device would write the same queries, so nothing is timed.
+            const auto gpuProfilerUploadFrame = MAX_FRAMES_IN_FLIGHT;
+            const auto canProfileGpu = m_engine->getDeviceCount() == 1 &&
+                GpuProfiler::isSupported(m_engine->getPhysicalDevice(), m_engine->getGraphicsQueueFamilyIndex());
+            if (PROFILE_GPU && canProfileGpu) {
+                const auto collectPipelineStatistics = PROFILE_PIPELINE_STATISTICS &&
+                    GpuProfiler::isPipelineStatisticsSupported(m_engine->getPhysicalDevice(), m_engine->getGraphicsQueueFamilyIndex());
+                const auto recordsInParallel = PARALLEL_COMMAND_RECORDING && !STATIC_SCENE;
+                m_gpuProfiler = std::make_unique<GpuProfiler>(
+                    m_engine->getInstance(),
+                    m_engine->getPhysicalDevice(),
+                    m_engine->getLogicalDevice(),
+                    m_engine->getGraphicsQueueFamilyIndex(),
+                    MAX_FRAMES_IN_FLIGHT + 1,
+                    collectPipelineStatistics,
+                    PROFILE_PERFORMANCE_COUNTERS && !recordsInParallel
+                );
+                m_gpuProfiler->resetFrame(uploadBatch.getCommandBuffer(), gpuProfilerUploadFrame);
+            }
+            const auto uploadScope = this->beginGpuScope(uploadBatch.getCommandBuffer(), "uploads");
+
+            // Texture files are decoded, and a mip chain built on the CPU is generated, on
+            // worker threads while the mesh uploads are recorded. They only join the batch
+            // once everything else has been recorded, so the phase that finishes the texture
+            // only counts the decoding the recording did not hide. A streamed texture joins
+            // a batch of its own after the first frame instead, and the batch only uploads
+            // the placeholder in its place.
+            // The buffers of a virtual texture are created with the texture, and the shader
+            // reads the page table from the first frame on, so the texture is not streamed
+            // in as an asset. The dashboard would take the place of the atlas.
+            m_useDescriptorBuffer = USE_DESCRIPTOR_BUFFERS && m_engine->supportsDescriptorBuffer();
+            m_useVirtualTexture = VIRTUAL_TEXTURE
+                && STREAM_TEXTURE_MIPS
+                && m_engine->getDeviceCapabilities().getFeatures().fragmentStoresAndAtomics
+                && m_engine->getDeviceCount() == 1
+                && !m_isDeterministic
+                && !DASHBOARD_TEXTURE
+                && !this->isSharingAssets();
+            m_streamAssets = STREAM_ASSETS
+                && !m_benchmarkOptions
+                && !m_isHeadless
+                && !m_isDeterministic
+                && !m_useVirtualTexture
+                && !this->isSharingAssets();
+            m_isTextureResident = !m_streamAssets;
+            m_uploadScheduler = std::make_unique<UploadScheduler>(
+                UPLOAD_FRAME_BUDGET_MILLISECONDS,
+                UPLOAD_MIN_BYTES_PER_FRAME,
+                UPLOAD_MAX_BYTES_PER_FRAME,
+                UPLOAD_MAX_COPIES_PER_FRAME,
+                UPLOAD_INITIAL_BYTES_PER_MILLISECOND
+            );
+            // An importer takes the owner's manifest before it creates anything shared, and
+            // never decodes the texture the owner shares.
+            this->createSharedAssets();
+            if (m_streamAssets) {
+                this->createPlaceholderTexture(uploadBatch);
+                m_assetStreamer = std::make_unique<AssetStreamer>(
+                    ASSET_STREAMING_THREAD_COUNT,
+                    ASSET_STREAMING_MEMORY_BUDGET,
+                    this->getBackgroundCpus()
+                );
+                this->requestTextureAsset(TEXTURE_PATH);
+            } else if (m_sharedAssetImporter != nullptr) {
+                this->importTextureImage();
             } else {
-                int _width, _height;
-                glfwGetWindowSize(m_engine->getWindow(), &_width, &_height);
+                m_textureDecodePool = std::make_unique<StbTextureDecodePool>(std::thread::hardware_concurrency(), this->getBackgroundCpus());
+                this->createTextureImage(uploadBatch, TEXTURE_PATH);
+            }
+            startupTimeline.mark("start texture decode");
+            if (m_stressSceneOptions) {
+                this->createStressTextures(uploadBatch);
+                startupTimeline.mark("generate stress textures");
+            }
+            m_useMeshShaders = this->canUseMeshShaders();
+            m_pullVertices = PULL_VERTICES && this->hasStorageVertexLayout();
+            // Only a streamed texture has levels to pick, and the host reads the feedback
+            // that only one device of a group would write.
+            m_useLodFeedback = LOD_FEEDBACK
+                && STREAM_TEXTURE_MIPS
+                && m_engine->getDeviceCapabilities().getFeatures().fragmentStoresAndAtomics
+                && m_engine->getDeviceCount() == 1;
+            m_useExtendedDynamicState = USE_EXTENDED_DYNAMIC_STATE && m_engine->supportsExtendedDynamicState();
+            if (USE_GRAPHICS_PIPELINE_LIBRARY && m_engine->supportsGraphicsPipelineLibrary()) {
+                m_pipelineLibrary = std::make_unique<GraphicsPipelineLibrary>(
+                    m_engine->getLogicalDevice(),
+                    m_performancePreset ? m_performancePreset->optimizePipelineLibraryLinks : OPTIMIZE_PIPELINE_LIBRARY_LINKS
+                );
+            }
+            // With a device group, the frame before may have resolved the predicates on
+            // another device. Every copy draws under its own predicate, which takes a direct
+            // draw per copy, so the queries go without the indirect draws. Queries and the
+            // draw culler only see one view.
+            m_useOcclusionQueries = OCCLUSION_QUERIES
+                && !m_useMeshShaders
+                && m_viewCount == 1
+                && m_engine->getDeviceCount() == 1
+                && m_engine->supportsConditionalRendering();
+            m_useIndirectDraws = USE_INDIRECT_DRAWS && !m_useOcclusionQueries && m_engine->supportsDrawIndirectCount();
+            m_cullDraws = CULL_DRAWS_ON_GPU && m_useIndirectDraws && m_viewCount == 1;
+            // With a device group, the frame before may have been rendered on another device.
+            m_buildDepthPyramid = BUILD_DEPTH_PYRAMID && m_cullDraws && m_engine->getDeviceCount() == 1;
+            // Alpha tested fragments would write depth in the prepass where the shading pass
+            // discards them, so alpha testing turns it off.
+            m_useDepthPrepass = m_useDepthPrepass && !(MIP_ALPHA_CUTOFF > 0.0f);
+            m_defragmentMemory = DEFRAGMENT_MEMORY && !m_benchmarkOptions && !this->isSharingAssets();
+            m_resourceTable = std::make_unique<GpuResourceTable>(m_engine->getLogicalDevice(), m_engine->getMemoryAllocator());
+            this->createGeometryPool();
+            this->createVertexBuffer(uploadBatch);
+            this->createIndexBuffer(uploadBatch);
+            this->createScene();
+            this->createInstanceBuffer(uploadBatch);
+            if (m_cullDraws) {
+                this->createBoundingSphereBuffer(uploadBatch);
+            }
+            if (m_useMeshShaders) {
+                this->createMeshletBuffer(uploadBatch);
+            }
+            startupTimeline.mark("record mesh uploads");
+            if (!m_streamAssets) {
+                if (m_sharedAssetImporter == nullptr) {
+                    this->finishTextureImage(uploadBatch);
+                    m_textureDecodePool.reset();
+                }
+                if (m_sharedAssetPublisher != nullptr) {
+                    this->shareTextureImage(uploadBatch);
+                }
+                startupTimeline.mark("finish texture decode and record mip generation");
+                this->createTextureImageView();
+                this->createTextureSampler();
+            }
+            // The shared assets change hands after everything that fills them, and an
+            // importer submits nothing that reads them before the owner has filled them.
+            if (m_sharedAssetPublisher != nullptr) {
+                m_sharedAssetPublisher->recordPublish(uploadBatch.getCommandBuffer());
+                m_sharedAssetPublisher->startServing();
+            }
+            if (m_sharedAssetImporter != nullptr) {
+                m_sharedAssetImporter->recordAcquire(uploadBatch.getCommandBuffer());
+                m_sharedAssetImporter->waitUntilReady(SHARED_ASSET_TIMEOUT);
+                startupTimeline.mark("wait for shared assets");
+            }
 
-                const uint32_t width = std::clamp(
-                    static_cast<uint32_t>(_width),
-                    capabilities.minImageExtent.width,
-                    capabilities.maxImageExtent.width
+            this->endGpuScope(uploadBatch.getCommandBuffer(), uploadScope);
+            const auto uploadSize = this->getTimedUploadSize(uploadBatch);
+            const auto uploadTimelineValue = uploadContext.submit(uploadBatch);
+            if (m_gpuProfiler) {
+                m_gpuProfiler->submitFrame(gpuProfilerUploadFrame);
+            }
+            startupTimeline.mark("submit uploads");
+
+            this->createDescriptorSetLayout();
+            if (m_useMeshShaders) {
+                this->createMeshletDescriptorSetLayout();
+            }
+            if (m_pullVertices) {
+                this->createVertexPullDescriptorSetLayout();
+            }
+            this->createUniformBuffers();
+            this->createLodFeedback();
+            this->createIndirectDrawBuffer();
+            this->createDrawCuller();
+            this->createOcclusionQueries();
+            this->createDescriptorAllocator();
+            this->createDescriptorSets();
+            if (m_useMeshShaders) {
+                this->createMeshletDescriptorSet();
+            }
+            if (m_pullVertices) {
+                this->createVertexPullDescriptorSet();
+            }
+            startupTimeline.mark("create descriptors and uniform buffers");
+            this->createCommandBuffers();
+            this->createSceneUploadBuffer();
+            // The recorder has pools for the most frames in flight there can be, so that it
+            // outlives changes to the number of frames in flight.
+            if (PARALLEL_COMMAND_RECORDING && !STATIC_SCENE) {
+                m_secondaryCommandRecorder = std::make_unique<SecondaryCommandRecorder>(
+                    m_engine->getLogicalDevice(),
+                    m_engine->getGraphicsQueueFamilyIndex(),
+                    MAX_FRAMES_IN_FLIGHT,
+                    std::thread::hardware_concurrency()
                 );
-                const uint32_t height = std::clamp(
-                    static_cast<uint32_t>(_height), 
-                    capabilities.minImageExtent.height, 
-                    capabilities.maxImageExtent.height
+            }
+            startupTimeline.mark("create command buffers");
+            m_usePostProcessSubpass = POST_PROCESS_SUBPASS && m_viewCount == 1;
+            m_useDynamicRendering = USE_DYNAMIC_RENDERING && !m_usePostProcessSubpass && m_engine->supportsDynamicRendering();
+            // The swap chain images are blitted into with dynamic resolution, so it is settled
+            // before they are created.
+            if (USE_DYNAMIC_RESOLUTION && !m_isDeterministic && !m_isOnDemand && this->canScaleResolution()) {
+                m_dynamicResolution = std::make_unique<DynamicResolution>(
+                    DYNAMIC_RESOLUTION_BUDGET_MILLISECONDS,
+                    DYNAMIC_RESOLUTION_MIN_SCALE,
+                    1.0f
                 );
-                const auto actualExtent = VkExtent2D {
-                    .width = width,
-                    .height = height,
-                };
+            }
+            m_useTemporalUpscaling = USE_TEMPORAL_UPSCALING && m_dynamicResolution != nullptr && !STATIC_SCENE;
+            this->createSwapChain();
+            this->createImageViews();
+            // The swap chains of the viewport windows are created as their first images are
+            // acquired.
+            m_viewportSwapChains = std::vector<ViewportSwapChain>(m_viewportWindowCount, ViewportSwapChain {
+                .swapChain = VK_NULL_HANDLE,
+                .images = {},
+                .extent = VkExtent2D { 0, 0 },
+                .isOutOfDate = true,
+            });
+            startupTimeline.mark("create swap chain");
+            // The upscaler antialiases over time, and reads single sampled images.
+            m_msaaSamples = m_useTemporalUpscaling ? VK_SAMPLE_COUNT_1_BIT : std::min(m_engine->getMsaaSamples(), MSAA_MAX_SAMPLE_COUNT);
+            if (m_performancePreset) {
+                m_msaaSamples = std::min(m_msaaSamples, m_performancePreset->msaaSamples);
+            }
+            m_useFragmentShadingRate = USE_FRAGMENT_SHADING_RATE
+                && m_engine->supportsFragmentShadingRate()
+                && m_msaaSamples <= VK_SAMPLE_COUNT_4_BIT;
+            m_useShadingRateImage = USE_SHADING_RATE_IMAGE && m_useFragmentShadingRate && this->canBuildShadingRateImage();
+            if (m_useShadingRateImage) {
+                const auto shadingRateProperties = m_engine->getFragmentShadingRateProperties();
+                m_shadingRateImageCombinerOp = shadingRateProperties.fragmentShadingRateNonTrivialCombinerOps
+                    ? VK_FRAGMENT_SHADING_RATE_COMBINER_OP_MAX_KHR
+                    : VK_FRAGMENT_SHADING_RATE_COMBINER_OP_REPLACE_KHR;
+            }
+            if (!m_useDynamicRendering) {
+                this->createRenderPass();
+            }
+            if (m_usePostProcessSubpass) {
+                this->createPostProcessPipeline();
+            }
+            this->createGraphicsPipeline();
+            if (m_useMeshShaders) {
+                this->createMeshShaderPipeline();
+            }
+            // The overlay renders into the swap chain image without a render pass, and its
+            // vertices live in host memory that only one device of a group reads. It only
+            // overlays the first view, so multiview frames go without it.
+            if (PERFORMANCE_HUD && m_useDynamicRendering && m_viewCount == 1 && m_engine->getDeviceCount() == 1) {
+                this->createPerformanceHud();
+                if (DASHBOARD_TEXTURE && !STATIC_SCENE) {
+                    this->createDashboardTexture();
+                }
+            }
+            startupTimeline.mark("create pipelines");
+            if (m_msaaSamples != VK_SAMPLE_COUNT_1_BIT) {
+                this->createColorResources();
+            }
+            if (m_dynamicResolution) {
+                this->createSceneColorResources();
+            }
+            this->createDepthResources();
+            if (m_usePostProcessSubpass) {
+                this->createPostProcessResources();
+            }
+            if (!m_useDynamicRendering) {
+                this->createFramebuffers();
+            }
+            this->createRenderingSyncObjects();
+            if (m_captureDirectory) {
+                this->createFrameCapture();
+            }
+            startupTimeline.mark("create attachments and sync objects");
 
-                return actualExtent;
+            uploadContext.wait(uploadTimelineValue);
+            if (m_sharedAssetPublisher != nullptr) {
+                m_sharedAssetPublisher->signalReady();
+            }
+            if (m_gpuProfiler) {
+                m_gpuProfiler->resolveFrame(gpuProfilerUploadFrame);
+                this->recordUploadThroughput(uploadSize);
+            }
+            startupTimeline.mark("wait for uploads");
+
+            this->storeTextureCache(TEXTURE_PATH);
+            startupTimeline.mark("store texture cache");
+
+            this->reportStartupTimings();
+
+            if (m_hotReloadShaders) {
+                m_shaderReloader = std::make_unique<ShaderReloader>(
+                    SHADER_SOURCE_DIRECTORY,
+                    SHADER_RELOAD_DIRECTORY,
+                    SHADER_RELOAD_COMPILERS,
+                    SHADER_RELOAD_POLL_INTERVAL
+                );
+            }
+
+            if (m_isOnDemand) {
+                m_redrawScheduler = std::make_unique<RedrawScheduler>(ON_DEMAND_REDRAW_FRAME_COUNT);
+                this->setCameraOrbitPaused(true);
+            }
+
+            if (m_metricsEndpoint) {
+                const auto metricPrefix = m_laneCount > 1 ? fmt::format("{}_lane{}", METRICS_PREFIX, m_laneIndex) : METRICS_PREFIX;
+                m_metricsExporter = std::make_unique<MetricsExporter>(
+                    *m_metricsEndpoint,
+                    metricPrefix,
+                    METRICS_DROPPED_FRAME_MILLISECONDS,
+                    METRICS_STATSD_INTERVAL
+                );
             }
         }
 
-        void createSwapChain() {
-            const auto swapChainSupport = m_engine->querySwapChainSupport(m_engine->getPhysicalDevice(), m_engine->getSurface());
-            const auto surfaceFormat = this->selectSwapSurfaceFormat(swapChainSupport.formats);
-            const auto presentMode = this->selectSwapPresentMode(swapChainSupport.presentModes);
-            const auto extent = this->selectSwapExtent(swapChainSupport.capabilities);
-            const auto imageCount = [&swapChainSupport]() {
-                uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
-                if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) {
-                    return swapChainSupport.capabilities.maxImageCount;
+        /// @brief Print and write the startup timings, with the GPU time of the startup
+        /// uploads and mip generation added as phases of their own.
+        ///
+        /// @note The GPU phases ran alongside the CPU phases after the uploads were
+        /// submitted, so they overlap them.
+        void reportStartupTimings() const {
+            if (m_gpuProfiler) {
+                for (const auto& statistics : m_gpuProfiler->getStatistics()) {
+                    StartupTimings::record(fmt::format("{} (GPU)", statistics.name), statistics.averageMilliseconds);
                 }
+            }
 
-                return imageCount;
-            }();
-            const auto indices = m_engine->findQueueFamilies(m_engine->getPhysicalDevice(), m_engine->getSurface());
-            auto queueFamilyIndices = std::array<uint32_t, 2> { 
-                indices.graphicsAndComputeFamily.value(),
-                indices.presentFamily.value()
-            };
-            const auto imageSharingMode = [&indices]() -> VkSharingMode {
-                if (indices.graphicsAndComputeFamily != indices.presentFamily) {
-                    return VK_SHARING_MODE_CONCURRENT;
+            if (PRINT_STARTUP_TIMINGS) {
+                m_cpuTopology->printReport();
+                StartupTimings::printReport();
+            }
+
+            if (WRITE_STARTUP_TIMINGS) {
+                StartupTimings::writeJson(STARTUP_TIMINGS_FILE);
+            }
+        }
+
+        /// @brief Run the frame loop, and the benchmark after it, when there is one.
+        void renderFrames() {
+            this->mainLoop();
+            if (m_benchmarkOptions) {
+                this->runBenchmark();
+            }
+        }
+
+        void mainLoop() {
+            m_nextFrameTime = std::chrono::steady_clock::now();
+            // A headless run has no window to close, so it always stops after its frames, and
+            // a replay stops after the frames it recorded.
+            const auto frameLimit = [this]() -> std::optional<uint32_t> {
+                if (m_sceneReplay != nullptr) {
+                    return static_cast<uint32_t>(m_sceneReplay->getFrameCount());
+                } else if (m_benchmarkOptions) {
+                    return BENCHMARK_WARMUP_FRAME_COUNT + m_benchmarkOptions->frameCount;
+                } else if (m_isHeadless) {
+                    return m_headlessFrameCount;
                 } else {
-                    return VK_SHARING_MODE_EXCLUSIVE;
+                    return std::nullopt;
                 }
             }();
-            const auto [queueFamilyIndicesPtr, queueFamilyIndexCount] = [&indices, &queueFamilyIndices]() -> std::tuple<const uint32_t*, uint32_t> {
-                if (indices.graphicsAndComputeFamily != indices.presentFamily) {
-                    const auto data = queueFamilyIndices.data();
-                    const auto size = static_cast<uint32_t>(queueFamilyIndices.size());
-                
-                    return std::make_tuple(data, size);
-                } else {
-                    const auto data = static_cast<uint32_t*>(nullptr);
-                    const auto size = static_cast<uint32_t>(0);
+            auto frameCount = uint32_t { 0 };
+            auto frameStartTime = std::chrono::steady_clock::now();
+            while (m_isHeadless || !m_engine->isWindowCloseRequested()) {
+                CPU_PROFILE_ZONE("frame");
+                const auto now = std::chrono::steady_clock::now();
+                CommandCounters::collectFrame(m_commandCounts);
+                if (m_benchmarkOptions && frameCount > BENCHMARK_WARMUP_FRAME_COUNT) {
+                    m_benchmarkFrameTimes.push_back(std::chrono::duration<double, std::milli> { now - frameStartTime }.count());
+                    m_benchmarkCommandCounts.add(m_commandCounts);
+                }
+                if (m_metricsExporter != nullptr && frameCount > 0) {
+                    this->updateMetrics(std::chrono::duration<double, std::milli> { now - frameStartTime }.count());
+                }
 
-                    return std::make_tuple(data, size);
+                frameStartTime = now;
+                if (frameLimit && frameCount == *frameLimit) {
+                    break;
                 }
-            }();
-            
-            const auto createInfo = VkSwapchainCreateInfoKHR {
-                .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
-                .surface = m_engine->getSurface(),
-                .minImageCount = imageCount,
-                .imageFormat = surfaceFormat.format,
-                .imageColorSpace = surfaceFormat.colorSpace,
-                .imageExtent = extent,
-                .imageArrayLayers = 1,
-                .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-                .imageSharingMode = imageSharingMode,
-                .queueFamilyIndexCount = queueFamilyIndexCount,
-                .pQueueFamilyIndices = queueFamilyIndices.data(),
-                .preTransform = swapChainSupport.capabilities.currentTransform,
-                .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-                .presentMode = presentMode,
-                .clipped = VK_TRUE,
-                .oldSwapchain = VK_NULL_HANDLE,
+
+                frameCount++;
+                this->paceFrame();
+                if (!m_isHeadless) {
+                    this->updateDisplayedPresents();
+                    {
+                        CPU_PROFILE_ZONE("poll events");
+                        m_engine->pollWindowEvents();
+                        if (m_redrawScheduler != nullptr) {
+                            this->waitForRedraw();
+                        }
+                        this->throttleInBackground();
+                    }
+                    m_frameLatencyTracker.recordInput(std::chrono::steady_clock::now());
+                    this->updateFramesInFlight();
+                    this->updatePresentModePolicy();
+                    this->updatePerformanceHudToggle();
+                    this->updateCameraOrbitToggle();
+                    this->updateTexturePaint();
+                    if (m_shaderReloader) {
+                        this->updateReloadedShaders();
+                    }
+                    this->updatePendingPipelines();
+                }
+                this->draw();
+                if (m_redrawScheduler != nullptr) {
+                    m_redrawScheduler->recordFrame();
+                }
+            }
+
+            vkDeviceWaitIdle(m_engine->getLogicalDevice());
+
+            if (m_sceneRecording != nullptr) {
+                m_sceneRecording->save(*m_sceneRecordingPath);
+                fmt::println("Scene recording of {} frames written to {}", m_sceneRecording->getFrameCount(), m_sceneRecordingPath->string());
+            }
+
+            if (m_readbackPath && m_viewCount > 1) {
+                for (uint32_t view = 0; view < m_viewCount; view++) {
+                    this->readBackFrame(getViewPath(*m_readbackPath, view), view);
+                }
+            } else if (m_readbackPath) {
+                this->readBackFrame(*m_readbackPath, 0);
+            }
+
+            if (m_frameExporter) {
+                fmt::println("Frames exported: {} dropped before they were taken", m_frameExporter->getDroppedCount());
+            }
+
+            if (m_frameCapture) {
+                m_frameCapture->waitIdle();
+                fmt::println(
+                    "Frames captured to {}: {} written, {} dropped",
+                    m_captureDirectory->string(),
+                    m_frameCapture->getWrittenCount(),
+                    m_frameCapture->getDroppedCount()
+                );
+            }
+
+            if constexpr (CpuProfiler::IS_ENABLED) {
+                CpuProfiler::writeChromeTrace(this->getLaneFilePath(CPU_TRACE_FILE));
+            }
+
+            if (m_presentLatencyCount > 0) {
+                const auto averageLatency = m_presentLatencyTotal.count() / static_cast<double>(m_presentLatencyCount);
+                fmt::println("Average present latency: {:.2f} ms over {} presents", averageLatency, m_presentLatencyCount);
+            }
+
+            const auto latencySteps = std::array<std::tuple<const char*, const FrameLatencyStatistics*>, 3> {
+                std::make_tuple("submit", &m_frameLatencyTracker.getInputToSubmitStatistics()),
+                std::make_tuple("present", &m_frameLatencyTracker.getInputToPresentStatistics()),
+                std::make_tuple("display", &m_frameLatencyTracker.getInputToDisplayStatistics()),
             };
+            for (const auto& [step, statistics] : latencySteps) {
+                if (statistics->sampleCount > 0) {
+                    fmt::println(
+                        "Input to {} latency: {:.2f} ms average, {:.2f} ms min, {:.2f} ms max over {} frames",
+                        step,
+                        statistics->averageMilliseconds,
+                        statistics->minMilliseconds,
+                        statistics->maxMilliseconds,
+                        statistics->sampleCount
+                    );
+                }
+            }
 
-            auto swapChain = VkSwapchainKHR {};
-            const auto result = vkCreateSwapchainKHR(m_engine->getLogicalDevice(), &createInfo, nullptr, &swapChain);
-            if (result != VK_SUCCESS) {
-                throw std::runtime_error("failed to create swap chain!");
+            if (m_gpuProfiler) {
+                for (const auto& statistics : m_gpuProfiler->getStatistics()) {
+                    fmt::println(
+                        "GPU {}: {:.3f} ms average, {:.3f} ms min, {:.3f} ms max",
+                        statistics.name,
+                        statistics.averageMilliseconds,
+                        statistics.minMilliseconds,
+                        statistics.maxMilliseconds
+                    );
+                    for (const auto& counter : statistics.counters) {
+                        fmt::println("    {}: {:.0f} {} average", counter.name, counter.averageValue, counter.unit);
+                    }
+                }
             }
+        }
 
-            uint32_t swapChainImageCount = 0;
-            vkGetSwapchainImagesKHR(m_engine->getLogicalDevice(), swapChain, &swapChainImageCount, nullptr);
-        
-            auto swapChainImages = std::vector<VkImage> { swapChainImageCount, VK_NULL_HANDLE };
-            vkGetSwapchainImagesKHR(m_engine->getLogicalDevice(), swapChain, &swapChainImageCount, swapChainImages.data());
+        /// @brief Time the uploads and mip generation of every benchmark texture size,
+        /// compare the run with the baseline of the device, and write the results of the run.
+        ///
+        /// @note The device has to be idle.
+        void runBenchmark() {
+            // The texture runs add scopes of their own to the profiler, so the frame loop's
+            // timings are taken first.
+            const auto gpuStatistics = [this]() -> std::vector<VulkanEngine::GpuScopeStatistics> {
+                if (m_gpuProfiler) {
+                    return m_gpuProfiler->getStatistics();
+                } else {
+                    return std::vector<VulkanEngine::GpuScopeStatistics> {};
+                }
+            }();
 
-            m_swapChain = swapChain;
-            m_swapChainImages = std::move(swapChainImages);
-            m_swapChainImageFormat = surfaceFormat.format;
-            m_swapChainExtent = extent;
+            auto textureResults = std::vector<TextureBenchmarkResult> {};
+            for (const auto size : BENCHMARK_TEXTURE_SIZES) {
+                textureResults.push_back(this->benchmarkTexture(size));
+            }
+
+            const auto comparisons = this->compareWithBaseline(textureResults);
+            this->writeBenchmarkResults(gpuStatistics, textureResults, comparisons);
         }
 
-        void createImageViews() {
-            auto swapChainImageViews = std::vector<VkImageView> { m_swapChainImages.size(), VK_NULL_HANDLE };
-            for (size_t i = 0; i < m_swapChainImages.size(); i++) {
-                auto swapChainImageView = this->createImageView(m_swapChainImages[i], m_swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-                swapChainImageViews[i] = swapChainImageView;
+        /// @brief Compare the run with the baseline of the device and driver, and report
+        /// what regressed, or make the run the baseline when there is none or it is being
+        /// updated.
+        ///
+        /// @note Startup phases and texture results are single samples, so they regress on
+        /// a threshold alone, while frame times are tested sample for sample.
+        std::vector<BenchmarkMetricComparison> compareWithBaseline(const std::vector<TextureBenchmarkResult>& textureResults) const {
+            auto properties = VkPhysicalDeviceProperties {};
+            vkGetPhysicalDeviceProperties(m_engine->getPhysicalDevice(), &properties);
+            const auto deviceUuid = PhysicalDeviceSelector::getDeviceUuid(m_engine->getPhysicalDevice());
+
+            auto run = BenchmarkBaseline { deviceUuid, properties.driverVersion };
+            run.addMetric(BenchmarkMetric {
+                .name = "frame time",
+                .unit = "ms",
+                .isHigherBetter = false,
+                .samples = m_benchmarkFrameTimes,
+            });
+            for (const auto& phase : StartupTimings::getPhases()) {
+                run.addMetric(BenchmarkMetric {
+                    .name = fmt::format("startup {}", phase.name),
+                    .unit = "ms",
+                    .isHigherBetter = false,
+                    .samples = { phase.milliseconds },
+                });
+            }
+            run.addMetric(BenchmarkMetric {
+                .name = "startup total",
+                .unit = "ms",
+                .isHigherBetter = false,
+                .samples = { StartupTimings::getTotalMilliseconds() },
+            });
+            for (const auto& result : textureResults) {
+                run.addMetric(BenchmarkMetric {
+                    .name = fmt::format("texture upload {}x{}", result.size, result.size),
+                    .unit = "MB/s",
+                    .isHigherBetter = true,
+                    .samples = { result.uploadMegabytesPerSecond },
+                });
+                // Devices without GPU timestamps have no mip generation times to compare.
+                if (result.mipGenerationMilliseconds > 0.0) {
+                    const auto megatexels = static_cast<double>(result.size) * result.size / 1.0e6;
+                    run.addMetric(BenchmarkMetric {
+                        .name = fmt::format("mip generation {}x{}", result.size, result.size),
+                        .unit = "Mtexel/s",
+                        .isHigherBetter = true,
+                        .samples = { megatexels / (result.mipGenerationMilliseconds / 1000.0) },
+                    });
+                }
             }
 
-            m_swapChainImageViews = std::move(swapChainImageViews);
+            const auto baselinePath = BenchmarkBaseline::getPath(m_benchmarkOptions->baselineDirectory, deviceUuid, properties.driverVersion);
+            if (m_benchmarkOptions->isUpdatingBaseline || !std::filesystem::exists(baselinePath)) {
+                run.save(baselinePath);
+                fmt::println("Benchmark baseline written to {}", baselinePath.string());
+
+                return std::vector<BenchmarkMetricComparison> {};
+            }
+
+            const auto baseline = BenchmarkBaseline::load(baselinePath);
+            const auto comparisons = baseline.compare(run, BENCHMARK_COMPARISON_OPTIONS);
+            auto regressionCount = size_t { 0 };
+            for (const auto& comparison : comparisons) {
+                if (!comparison.isRegression) {
+                    continue;
+                }
+
+                regressionCount++;
+                fmt::println(
+                    "Regression: {} went from {:.4f} to {:.4f} {} ({:+.1f}% worse{})",
+                    comparison.name,
+                    comparison.baselineMedian,
+                    comparison.runMedian,
+                    comparison.unit,
+                    100.0 * comparison.relativeChange,
+                    comparison.pValue ? fmt::format(", p = {:.2g}", *comparison.pValue) : std::string {}
+                );
+            }
+            fmt::println("{} of {} metrics regressed from the baseline in {}", regressionCount, comparisons.size(), baselinePath.string());
+
+            return comparisons;
         }
 
-        void createRenderPass() {
-            const auto colorAttachment = VkAttachmentDescription {
-                .format = m_swapChainImageFormat,
-                .samples = VK_SAMPLE_COUNT_1_BIT,
-                .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-                .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-                .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-                .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        TextureBenchmarkResult benchmarkTexture(uint32_t size) {
+            auto& uploadContext = m_engine->getUploadContext();
+            const auto formatInfo = *TextureFormats::getInfo(VK_FORMAT_R8G8B8A8_SRGB);
+            const auto imageSize = formatInfo.getLevelSize(size, size);
+            const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(size))) + 1;
+            const auto scopeName = fmt::format("mip generation {}x{}", size, size);
+            const auto gpuProfilerUploadFrame = MAX_FRAMES_IN_FLIGHT;
+
+            auto pixels = std::vector<uint8_t>(imageSize);
+            for (size_t i = 0; i < pixels.size(); i++) {
+                pixels[i] = static_cast<uint8_t>(i * 31);
+            }
+
+            auto uploadSeconds = 0.0;
+            for (uint32_t i = 0; i < BENCHMARK_TEXTURE_REPETITIONS; i++) {
+                auto [image, imageAllocation] = m_engine->createImage(
+                    size,
+                    size,
+                    mipLevels,
+                    VK_SAMPLE_COUNT_1_BIT,
+                    VK_FORMAT_R8G8B8A8_SRGB,
+                    VK_IMAGE_TILING_OPTIMAL,
+                    uploadContext.getMipmapImageUsage(VK_FORMAT_R8G8B8A8_SRGB) | VK_IMAGE_USAGE_SAMPLED_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    uploadContext.getMipmapImageCreateFlags(VK_FORMAT_R8G8B8A8_SRGB)
+                );
+
+                // The copy may run on the transfer queue, which is not profiled, so uploads
+                // are timed from submit to completion on the CPU.
+                auto uploadBatch = uploadContext.beginBatch();
+                const auto stagingSlice = uploadBatch.stage(pixels.data(), pixels.size());
+                uploadBatch.transitionImageLayout(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+                uploadBatch.copyBufferToImage(stagingSlice, image, size, size);
+                const auto uploadStartTime = std::chrono::steady_clock::now();
+                uploadContext.wait(uploadContext.submit(uploadBatch));
+                uploadSeconds += std::chrono::duration<double> { std::chrono::steady_clock::now() - uploadStartTime }.count();
+
+                auto mipmapBatch = uploadContext.beginBatch();
+                if (m_gpuProfiler) {
+                    m_gpuProfiler->resetFrame(mipmapBatch.getCommandBuffer(), gpuProfilerUploadFrame);
+                }
+                const auto mipmapTarget = MipmapTarget {
+                    .image = image,
+                    .format = VK_FORMAT_R8G8B8A8_SRGB,
+                    .width = size,
+                    .height = size,
+                    .mipLevels = mipLevels,
+                    .filter = MIP_FILTER,
+                    .alphaCutoff = MIP_ALPHA_CUTOFF,
+                };
+                const auto mipScope = this->beginGpuScope(mipmapBatch.getCommandBuffer(), scopeName);
+                mipmapBatch.generateMipmaps(std::span<const MipmapTarget> { &mipmapTarget, 1 });
+                this->endGpuScope(mipmapBatch.getCommandBuffer(), mipScope);
+                uploadContext.wait(uploadContext.submit(mipmapBatch));
+                if (m_gpuProfiler) {
+                    m_gpuProfiler->submitFrame(gpuProfilerUploadFrame);
+                    m_gpuProfiler->resolveFrame(gpuProfilerUploadFrame);
+                }
+
+                m_engine->destroyImage(image, imageAllocation);
+            }
+
+            const auto mipGenerationMilliseconds = [this, &scopeName]() -> double {
+                if (m_gpuProfiler) {
+                    for (const auto& statistics : m_gpuProfiler->getStatistics()) {
+                        if (statistics.name == scopeName) {
+                            return statistics.averageMilliseconds;
+                        }
+                    }
+                }
+
+                return 0.0;
+            }();
+
+            const auto uploadedMegabytes = static_cast<double>(imageSize) * BENCHMARK_TEXTURE_REPETITIONS / (1024.0 * 1024.0);
+
+            return TextureBenchmarkResult {
+                .size = size,
+                .uploadMegabytesPerSecond = uploadedMegabytes / uploadSeconds,
+                .mipGenerationMilliseconds = mipGenerationMilliseconds,
             };
-            const auto depthAttachment = VkAttachmentDescription {
-                .format = this->findDepthFormat(),
-                .samples = VK_SAMPLE_COUNT_1_BIT,
-                .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-                .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-                .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-                .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        }
+
+        /// @brief The file the calibration profile of the device and driver lives in.
+        std::filesystem::path getCalibrationProfilePath() const {
+            auto properties = VkPhysicalDeviceProperties {};
+            vkGetPhysicalDeviceProperties(m_engine->getPhysicalDevice(), &properties);
+            const auto deviceUuid = PhysicalDeviceSelector::getDeviceUuid(m_engine->getPhysicalDevice());
+
+            return DeviceCalibration::getPath(CALIBRATION_DIRECTORY, deviceUuid, properties.driverVersion);
+        }
+
+        /// @brief `CALIBRATION_TARGET`, for the initial window and the most of every setting
+        /// the device and the app allow.
+        VulkanEngine::CalibrationTarget getCalibrationTarget() const {
+            auto target = CALIBRATION_TARGET;
+            target.extent = VkExtent2D { WIDTH, HEIGHT };
+            target.maxSampleCount = std::min(m_engine->getMsaaSamples(), MSAA_MAX_SAMPLE_COUNT);
+            target.maxAnisotropy = m_engine->getSamplerCache().getMaxAnisotropy();
+            target.maxTextureSize = m_engine->getDeviceCapabilities().getLimits().maxImageDimension2D;
+            target.maxFramesInFlight = MAX_FRAMES_IN_FLIGHT;
+
+            return target;
+        }
+
+        static void printPerformancePreset(const PerformancePreset& preset) {
+            fmt::println(
+                "Performance preset: {}x MSAA, {}x anisotropy, textures up to {}x{}, {} frames in flight, {} pipeline library links",
+                static_cast<uint32_t>(preset.msaaSamples),
+                preset.maxAnisotropy,
+                preset.maxTextureSize,
+                preset.maxTextureSize,
+                preset.framesInFlight,
+                preset.optimizePipelineLibraryLinks ? "optimized" : "fast"
+            );
+        }
+
+        /// @brief Take the settings the profile of the device picks, or have this launch
+        /// calibrate the device when it has no profile, or one that fails to load.
+        ///
+        /// @note This runs before anything that depends on the settings is created.
+        void loadPerformancePreset() {
+            if (m_calibrationMode == CalibrationMode::Calibrate) {
+                m_isCalibrating = true;
+
+                return;
+            }
+
+            const auto isCalibrated = m_calibrationMode == CalibrationMode::Auto
+                && !m_benchmarkOptions
+                && !m_isHeadless
+                && !m_isDeterministic
+                && !m_mipBenchmarkOutputPath
+                && !m_prewarmPipelines;
+            if (!isCalibrated) {
+                return;
+            }
+
+            const auto profilePath = this->getCalibrationProfilePath();
+            if (!std::filesystem::exists(profilePath)) {
+                fmt::println("The device has no calibration profile yet, so it is calibrated before the demo starts");
+                m_isCalibrating = true;
+
+                return;
+            }
+
+            try {
+                const auto calibration = DeviceCalibration::load(profilePath);
+                m_performancePreset = calibration.selectPreset(this->getCalibrationTarget());
+            } catch (const std::exception& exception) {
+                fmt::println(std::cerr, "{}; calibrating the device again", exception.what());
+                m_isCalibrating = true;
+
+                return;
+            }
+
+            App::printPerformancePreset(*m_performancePreset);
+            m_framesInFlight = m_performancePreset->framesInFlight;
+            this->updateSamplerAnisotropyLimit();
+        }
+
+        /// @brief Run the micro-benchmarks of the calibration, write the profile of the
+        /// device, and ask for the app to start again when the calibration ran because the
+        /// device had no profile.
+        ///
+        /// @note The micro-benchmarks run on the renderer as it starts with the defaults. Each
+        /// one times its batches from submit to completion on the CPU, so it needs no
+        /// timestamps, and does enough work per batch for the submit not to matter.
+        void runCalibration() {
+            const auto startTime = std::chrono::steady_clock::now();
+            const auto [uploadMegabytesPerSecond, mipGenerationMegatexelsPerSecond] = this->calibrateTextures();
+            const auto measurements = CalibrationMeasurements {
+                .mipGenerationMegatexelsPerSecond = mipGenerationMegatexelsPerSecond,
+                .fillGigapixelsPerSecond = this->calibrateFill(),
+                .uploadMegabytesPerSecond = uploadMegabytesPerSecond,
+                .pipelineCompileMilliseconds = this->calibratePipelineCompile(),
             };
-            const auto colorAttachmentRef = VkAttachmentReference {
-                .attachment = 0,
-                .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            vkDeviceWaitIdle(m_engine->getLogicalDevice());
+
+            auto properties = VkPhysicalDeviceProperties {};
+            vkGetPhysicalDeviceProperties(m_engine->getPhysicalDevice(), &properties);
+            const auto calibration = DeviceCalibration {
+                PhysicalDeviceSelector::getDeviceUuid(m_engine->getPhysicalDevice()),
+                properties.driverVersion,
+                measurements,
             };
-            const auto depthAttachmentRef = VkAttachmentReference {
-                .attachment = 1,
-                .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            const auto profilePath = this->getCalibrationProfilePath();
+            calibration.save(profilePath);
+
+            const auto seconds = std::chrono::duration<double> { std::chrono::steady_clock::now() - startTime }.count();
+            fmt::println(
+                "Calibrated {} in {:.2f} s: mip generation {:.0f} Mtexel/s, fill {:.2f} Gpixel/s, upload {:.0f} MB/s, pipeline build {:.1f} ms, written to {}",
+                properties.deviceName,
+                seconds,
+                measurements.mipGenerationMegatexelsPerSecond,
+                measurements.fillGigapixelsPerSecond,
+                measurements.uploadMegabytesPerSecond,
+                measurements.pipelineCompileMilliseconds,
+                profilePath.string()
+            );
+            App::printPerformancePreset(calibration.selectPreset(this->getCalibrationTarget()));
+
+            m_isRestartRequested = m_calibrationMode == CalibrationMode::Auto;
+        }
+
+        /// @brief The upload bandwidth, in MB a second, and the mip generation throughput, in
+        /// megatexels of level 0 a second, of a `CALIBRATION_TEXTURE_SIZE` texture, uploaded
+        /// and mipmapped the way `benchmarkTexture` does.
+        std::tuple<double, double> calibrateTextures() {
+            auto& uploadContext = m_engine->getUploadContext();
+            const auto size = CALIBRATION_TEXTURE_SIZE;
+            const auto formatInfo = *TextureFormats::getInfo(VK_FORMAT_R8G8B8A8_SRGB);
+            const auto imageSize = formatInfo.getLevelSize(size, size);
+            const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(size))) + 1;
+
+            auto pixels = std::vector<uint8_t>(imageSize);
+            for (size_t i = 0; i < pixels.size(); i++) {
+                pixels[i] = static_cast<uint8_t>(i * 31);
+            }
+
+            auto uploadSeconds = 0.0;
+            auto mipGenerationSeconds = 0.0;
+            for (uint32_t i = 0; i < CALIBRATION_REPETITIONS; i++) {
+                auto [image, imageAllocation] = m_engine->createImage(
+                    size,
+                    size,
+                    mipLevels,
+                    VK_SAMPLE_COUNT_1_BIT,
+                    VK_FORMAT_R8G8B8A8_SRGB,
+                    VK_IMAGE_TILING_OPTIMAL,
+                    uploadContext.getMipmapImageUsage(VK_FORMAT_R8G8B8A8_SRGB) | VK_IMAGE_USAGE_SAMPLED_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    uploadContext.getMipmapImageCreateFlags(VK_FORMAT_R8G8B8A8_SRGB)
+                );
+
+                auto uploadBatch = uploadContext.beginBatch();
+                const auto stagingSlice = uploadBatch.stage(pixels.data(), pixels.size());
+                uploadBatch.transitionImageLayout(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+                uploadBatch.copyBufferToImage(stagingSlice, image, size, size);
+                const auto uploadStartTime = std::chrono::steady_clock::now();
+                uploadContext.wait(uploadContext.submit(uploadBatch));
+                uploadSeconds += std::chrono::duration<double> { std::chrono::steady_clock::now() - uploadStartTime }.count();
+
+                auto mipmapBatch = uploadContext.beginBatch();
+                const auto mipmapTarget = MipmapTarget {
+                    .image = image,
+                    .format = VK_FORMAT_R8G8B8A8_SRGB,
+                    .width = size,
+                    .height = size,
+                    .mipLevels = mipLevels,
+                    .filter = MIP_FILTER,
+                    .alphaCutoff = MIP_ALPHA_CUTOFF,
+                };
+                mipmapBatch.generateMipmaps(std::span<const MipmapTarget> { &mipmapTarget, 1 });
+                const auto mipGenerationStartTime = std::chrono::steady_clock::now();
+                uploadContext.wait(uploadContext.submit(mipmapBatch));
+                mipGenerationSeconds += std::chrono::duration<double> { std::chrono::steady_clock::now() - mipGenerationStartTime }.count();
+
+                m_engine->destroyImage(image, imageAllocation);
+            }
+
+            const auto uploadedMegabytes = static_cast<double>(imageSize) * CALIBRATION_REPETITIONS / (1024.0 * 1024.0);
+            const auto megatexels = static_cast<double>(size) * size * CALIBRATION_REPETITIONS / 1.0e6;
+
+            return std::make_tuple(uploadedMegabytes / uploadSeconds, megatexels / mipGenerationSeconds);
+        }
+
+        /// @brief The pixels a second, in billions, that blits of a small image stretched over
+        /// a `CALIBRATION_FILL_SIZE` one write.
+        ///
+        /// @note A blit writes every pixel of its destination, where a clear may only mark
+        /// the image as cleared on devices with fast clears.
+        double calibrateFill() {
+            auto& uploadContext = m_engine->getUploadContext();
+            auto [sourceImage, sourceImageAllocation] = m_engine->createImage(
+                CALIBRATION_FILL_SOURCE_SIZE,
+                CALIBRATION_FILL_SOURCE_SIZE,
+                1,
+                VK_SAMPLE_COUNT_1_BIT,
+                VK_FORMAT_R8G8B8A8_UNORM,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+            auto [destinationImage, destinationImageAllocation] = m_engine->createImage(
+                CALIBRATION_FILL_SIZE,
+                CALIBRATION_FILL_SIZE,
+                1,
+                VK_SAMPLE_COUNT_1_BIT,
+                VK_FORMAT_R8G8B8A8_UNORM,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+
+            const auto colorSubresourceRange = VkImageSubresourceRange {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
             };
-            const auto subpass = VkSubpassDescription {
-                .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-                .colorAttachmentCount = 1,
-                .pColorAttachments = &colorAttachmentRef,
-                .pDepthStencilAttachment = &depthAttachmentRef,
+            const auto getImageBarrier = [&colorSubresourceRange](VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask) {
+                return VkImageMemoryBarrier {
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .srcAccessMask = srcAccessMask,
+                    .dstAccessMask = dstAccessMask,
+                    .oldLayout = oldLayout,
+                    .newLayout = newLayout,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .image = image,
+                    .subresourceRange = colorSubresourceRange,
+                };
             };
 
-            const auto dependency = VkSubpassDependency {
-                .srcSubpass = VK_SUBPASS_EXTERNAL,
-                .dstSubpass = 0,
-                .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-                .srcAccessMask = 0,
-                .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-                .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            // The source is cleared once, and both images stay in their transfer layouts for
+            // every blit after.
+            auto clearBatch = uploadContext.beginBatch();
+            clearBatch.clearImage(sourceImage, VkClearColorValue { .float32 = { 0.25f, 0.5f, 0.75f, 1.0f } }, 1);
+            const auto layoutBarriers = std::array<VkImageMemoryBarrier, 2> {
+                getImageBarrier(sourceImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT),
+                getImageBarrier(destinationImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT),
             };
+            m_dispatch->vkCmdPipelineBarrier(
+                clearBatch.getCommandBuffer(),
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                static_cast<uint32_t>(layoutBarriers.size()),
+                layoutBarriers.data()
+            );
+            uploadContext.wait(uploadContext.submit(clearBatch));
 
-            const auto attachments = std::array<VkAttachmentDescription, 2> {
-                colorAttachment,
-                depthAttachment
+            const auto colorSubresource = VkImageSubresourceLayers {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
             };
-            const auto renderPassInfo = VkRenderPassCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-                .attachmentCount = static_cast<uint32_t>(attachments.size()),
-                .pAttachments = attachments.data(),
-                .subpassCount = 1,
-                .pSubpasses = &subpass,
-                .dependencyCount = 1,
-                .pDependencies = &dependency,
+            const auto blit = VkImageBlit {
+                .srcSubresource = colorSubresource,
+                .srcOffsets = {
+                    VkOffset3D { 0, 0, 0 },
+                    VkOffset3D { static_cast<int32_t>(CALIBRATION_FILL_SOURCE_SIZE), static_cast<int32_t>(CALIBRATION_FILL_SOURCE_SIZE), 1 },
+                },
+                .dstSubresource = colorSubresource,
+                .dstOffsets = {
+                    VkOffset3D { 0, 0, 0 },
+                    VkOffset3D { static_cast<int32_t>(CALIBRATION_FILL_SIZE), static_cast<int32_t>(CALIBRATION_FILL_SIZE), 1 },
+                },
+            };
+            // Every blit overwrites the one before it, so each waits for the last.
+            const auto blitBarrier = VkMemoryBarrier {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
             };
+            auto fillSeconds = 0.0;
+            for (uint32_t i = 0; i < CALIBRATION_REPETITIONS; i++) {
+                auto fillBatch = uploadContext.beginBatch();
+                const auto commandBuffer = fillBatch.getCommandBuffer();
+                for (uint32_t j = 0; j < CALIBRATION_FILL_BLIT_COUNT; j++) {
+                    m_dispatch->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &blitBarrier, 0, nullptr, 0, nullptr);
+                    m_dispatch->vkCmdBlitImage(
+                        commandBuffer,
+                        sourceImage,
+                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                        destinationImage,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        1,
+                        &blit,
+                        VK_FILTER_LINEAR
+                    );
+                }
 
-            auto renderPass = VkRenderPass {};
-            const auto result = vkCreateRenderPass(m_engine->getLogicalDevice(), &renderPassInfo, nullptr, &renderPass);
-            if (result != VK_SUCCESS) {
-                throw std::runtime_error("failed to create render pass!");
+                const auto fillStartTime = std::chrono::steady_clock::now();
+                uploadContext.wait(uploadContext.submit(fillBatch));
+                fillSeconds += std::chrono::duration<double> { std::chrono::steady_clock::now() - fillStartTime }.count();
+            }
+
+            m_engine->destroyImage(sourceImage, sourceImageAllocation);
+            m_engine->destroyImage(destinationImage, destinationImageAllocation);
+
+            const auto pixelCount = static_cast<double>(CALIBRATION_FILL_SIZE) * CALIBRATION_FILL_SIZE * CALIBRATION_FILL_BLIT_COUNT * CALIBRATION_REPETITIONS;
+
+            return pixelCount / fillSeconds / 1.0e9;
+        }
+
+        /// @brief The time the graphics pipeline takes to build, in milliseconds.
+        ///
+        /// @note The pipeline is built with one sample, and with the most the device offers,
+        /// as `runPipelinePrewarm` builds it. The slowest build counts, since the one the
+        /// demo started with comes out of the pipeline cache.
+        double calibratePipelineCompile() {
+            auto sampleCounts = std::vector<VkSampleCountFlagBits> { VK_SAMPLE_COUNT_1_BIT };
+            const auto maxSampleCount = std::min(m_engine->getMsaaSamples(), MSAA_MAX_SAMPLE_COUNT);
+            if (maxSampleCount != VK_SAMPLE_COUNT_1_BIT) {
+                sampleCounts.push_back(maxSampleCount);
             }
 
+            // The startup builds would share the compiler's workers with the timed ones.
+            auto& pipelineCompiler = m_engine->getPipelineCompiler();
+            pipelineCompiler.waitIdle();
+
+            const auto msaaSamples = m_msaaSamples;
+            const auto renderPass = m_renderPass;
+            auto compileMilliseconds = 0.0;
+            for (const auto sampleCount : sampleCounts) {
+                m_msaaSamples = sampleCount;
+                if (!m_useDynamicRendering) {
+                    this->createRenderPass();
+                }
+
+                const auto startTime = std::chrono::steady_clock::now();
+                const auto pipeline = this->enqueueGraphicsPipeline();
+                pipelineCompiler.wait(pipeline);
+                const auto milliseconds = std::chrono::duration<double, std::milli> { std::chrono::steady_clock::now() - startTime }.count();
+                compileMilliseconds = std::max(compileMilliseconds, milliseconds);
+                pipelineCompiler.destroyPipeline(pipeline);
+
+                if (!m_useDynamicRendering) {
+                    this->evictPipelineParts(m_renderPass);
+                    vkDestroyRenderPass(m_engine->getLogicalDevice(), m_renderPass, m_engine->getAllocationCallbacks());
+                }
+            }
+            m_msaaSamples = msaaSamples;
             m_renderPass = renderPass;
+
+            return compileMilliseconds;
         }
 
-        void createGraphicsPipeline() {
-            const auto vertexShaderModule = m_engine->createShaderModule(m_hlslShaders.at("shader.vert.hlsl"));
-            const auto fragmentShaderModule = m_engine->createShaderModule(m_hlslShaders.at("shader.frag.hlsl"));
+        /// @brief The surface formats of `PREWARM_SURFACE_FORMATS` the device can render to.
+        std::vector<VkSurfaceFormatKHR> getPrewarmSurfaceFormats() const {
+            auto surfaceFormats = std::vector<VkSurfaceFormatKHR> {};
+            for (const auto& surfaceFormat : PREWARM_SURFACE_FORMATS) {
+                auto formatProperties = VkFormatProperties {};
+                vkGetPhysicalDeviceFormatProperties(m_engine->getPhysicalDevice(), surfaceFormat.format, &formatProperties);
+                if ((formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT) != 0) {
+                    surfaceFormats.push_back(surfaceFormat);
+                }
+            }
 
-            const auto vertexShaderStageInfo = VkPipelineShaderStageCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                .stage = VK_SHADER_STAGE_VERTEX_BIT,
-                .module = vertexShaderModule,
-                .pName = "main",
-            };
-            const auto fragmentShaderStageInfo = VkPipelineShaderStageCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-                .module = fragmentShaderModule,
-                .pName = "main",
-            };
-            const auto shaderStages = std::array<VkPipelineShaderStageCreateInfo, 2> {
-                vertexShaderStageInfo,
-                fragmentShaderStageInfo
-            };
-            auto bindingDescription = Vertex::getBindingDescription();
-            auto attributeDescriptions = Vertex::getAttributeDescriptions();
-            const auto vertexInputInfo = VkPipelineVertexInputStateCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-                .vertexBindingDescriptionCount = 1,
-                .vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
-                .pVertexBindingDescriptions = &bindingDescription,
-                .pVertexAttributeDescriptions = attributeDescriptions.data(),
+            return surfaceFormats;
+        }
+
+        /// @brief Build the pipelines of every surface format and sample count the demo can
+        /// start with on this device into the pipeline cache, which is written back when the
+        /// engine is destroyed, so that the demo finds all of them cached.
+        ///
+        /// @note Everything else the pipelines depend on, like pulled vertices, the depth
+        /// prepass or mesh shaders, is settled by the device and the build, and is already
+        /// what the demo would pick. The sample count is one with temporal upscaling, and the
+        /// most the device offers otherwise. Every permutation is enqueued before any is
+        /// waited on, so they compile on all of the compiler's workers at once.
+        void runPipelinePrewarm() {
+            const auto start = std::chrono::steady_clock::now();
+            const auto surfaceFormats = this->getPrewarmSurfaceFormats();
+            auto sampleCounts = std::vector<VkSampleCountFlagBits> { VK_SAMPLE_COUNT_1_BIT };
+            const auto maxSampleCount = std::min(m_engine->getMsaaSamples(), MSAA_MAX_SAMPLE_COUNT);
+            if (maxSampleCount != VK_SAMPLE_COUNT_1_BIT) {
+                sampleCounts.push_back(maxSampleCount);
+            }
+
+            // The builds point at the render passes, so they are only destroyed once every
+            // build has finished, and the app's own state is put back after.
+            const auto swapChainImageFormat = m_swapChainImageFormat;
+            const auto swapChainColorSpace = m_swapChainColorSpace;
+            const auto msaaSamples = m_msaaSamples;
+            const auto renderPass = m_renderPass;
+            auto renderPasses = std::vector<VkRenderPass> {};
+            auto pipelines = std::vector<PipelineHandle> {};
+            for (const auto& surfaceFormat : surfaceFormats) {
+                for (const auto sampleCount : sampleCounts) {
+                    m_swapChainImageFormat = surfaceFormat.format;
+                    m_swapChainColorSpace = surfaceFormat.colorSpace;
+                    m_msaaSamples = sampleCount;
+                    if (!m_useDynamicRendering) {
+                        this->createRenderPass();
+                        renderPasses.push_back(m_renderPass);
+                    }
+
+                    pipelines.push_back(this->enqueueGraphicsPipeline());
+                    if (m_useDepthPrepass) {
+                        pipelines.push_back(this->enqueueDepthPrepassPipeline());
+                    }
+                    if (m_useOcclusionQueries) {
+                        pipelines.push_back(this->enqueueOcclusionProxyPipeline());
+                    }
+                    if (m_useMeshShaders) {
+                        pipelines.push_back(this->enqueueMeshShaderPipeline());
+                    }
+                }
+            }
+
+            auto& pipelineCompiler = m_engine->getPipelineCompiler();
+            pipelineCompiler.waitIdle();
+            auto failedCount = uint32_t { 0 };
+            for (const auto pipeline : pipelines) {
+                try {
+                    pipelineCompiler.wait(pipeline);
+                } catch (const std::exception& exception) {
+                    fmt::println(std::cerr, "failed to prewarm a pipeline: {}", exception.what());
+                    failedCount++;
+                }
+                pipelineCompiler.destroyPipeline(pipeline);
+            }
+
+            for (const auto prewarmRenderPass : renderPasses) {
+                this->evictPipelineParts(prewarmRenderPass);
+                vkDestroyRenderPass(m_engine->getLogicalDevice(), prewarmRenderPass, m_engine->getAllocationCallbacks());
+            }
+            m_swapChainImageFormat = swapChainImageFormat;
+            m_swapChainColorSpace = swapChainColorSpace;
+            m_msaaSamples = msaaSamples;
+            m_renderPass = renderPass;
+
+            const auto seconds = std::chrono::duration<double> { std::chrono::steady_clock::now() - start }.count();
+            fmt::println(
+                "Prewarmed {} pipelines for {} surface formats and {} sample counts, {} failed, in {:.2f} s",
+                pipelines.size() - failedCount,
+                surfaceFormats.size(),
+                sampleCounts.size(),
+                failedCount,
+                seconds
+            );
+            if (failedCount > 0) {
+                throw std::runtime_error("failed to prewarm every pipeline!");
+            }
+        }
+
+        /// @brief Time every mip generation backend over every extent and format of the mip
+        /// benchmark, and write the results to `outputPath`.
+        ///
+        /// @note Level 0 is cleared on the GPU rather than uploaded, so extents larger than the
+        /// staging ring can be measured. The backends do the same work whatever the texels
+        /// hold. Combinations a backend does not support are left out, and those that run out
+        /// of memory are recorded as failed while the rest carry on.
+        void runMipBenchmark(const std::filesystem::path& outputPath) {
+            const auto& limits = m_engine->getDeviceCapabilities().getLimits();
+            const auto maxExtent = limits.maxImageDimension2D;
+
+            const auto backends = std::array<MipBenchmarkBackend, 5> {
+                MipBenchmarkBackend::Blit,
+                MipBenchmarkBackend::ComputeBox,
+                MipBenchmarkBackend::ComputeFilter,
+                MipBenchmarkBackend::CpuBox,
+                MipBenchmarkBackend::CpuFilter,
             };
-            const auto inputAssembly = VkPipelineInputAssemblyStateCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-                .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-                .primitiveRestartEnable = VK_FALSE,
+            auto results = std::vector<MipBenchmarkResult> {};
+            const auto benchmarkShape = [this, &backends, &results](MipBenchmarkShape shape, const VkExtent3D& extent) {
+                for (const auto format : MIP_BENCHMARK_FORMATS) {
+                    for (const auto backend : backends) {
+                        const auto result = this->benchmarkMipBackend(backend, shape, format, extent);
+                        if (result) {
+                            results.push_back(*result);
+                        }
+                    }
+                }
             };
+            for (const auto& extent : MIP_BENCHMARK_EXTENTS) {
+                if (extent.width > maxExtent || extent.height > maxExtent) {
+                    fmt::println("Skipping the {}x{} mip benchmarks, the device supports at most {}x{}", extent.width, extent.height, maxExtent, maxExtent);
+                    continue;
+                }
 
-            // Without dynamic state, the viewport and scissor rectangle need to be set 
-            // in the pipeline using the `VkPipelineViewportStateCreateInfo` struct. This
-            // makes the viewport and scissor rectangle for this pipeline immutable.
-            // Any changes to these values would require a new pipeline to be created with
-            // the new values.
-            // ```
-            // const auto viewportState = VkPipelineViewportStateCreateInfo {
-            //     .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-            //     .viewportCount = 1,
-            //     .pViewports = &viewport,
-            //     .scissorCount = 1,
-            //     .pScissors = &scissor,
-            // };
-            // ```
-            const auto viewportState = VkPipelineViewportStateCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-                .viewportCount = 1,
-                .scissorCount = 1,
-            };
-            const auto rasterizer = VkPipelineRasterizationStateCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+                benchmarkShape(MipBenchmarkShape::Flat, VkExtent3D { extent.width, extent.height, 1 });
+            }
+
+            for (const auto& extent : MIP_BENCHMARK_EXTENTS) {
+                if (extent.width != extent.height) {
+                    continue;
+                } else if (extent.width > limits.maxImageDimensionCube) {
+                    fmt::println("Skipping the {}x{} cube map mip benchmarks, the device supports faces of at most {}x{}", extent.width, extent.height, limits.maxImageDimensionCube, limits.maxImageDimensionCube);
+                    continue;
+                }
+
+                benchmarkShape(MipBenchmarkShape::CubeMap, VkExtent3D { extent.width, extent.height, 1 });
+            }
+
+            for (const auto& extent : MIP_BENCHMARK_VOLUME_EXTENTS) {
+                if (std::max({ extent.width, extent.height, extent.depth }) > limits.maxImageDimension3D) {
+                    fmt::println("Skipping the {}x{}x{} volume mip benchmarks, the device supports at most {} along each axis", extent.width, extent.height, extent.depth, limits.maxImageDimension3D);
+                    continue;
+                }
+
+                benchmarkShape(MipBenchmarkShape::Volume, extent);
+            }
+
+            vkDeviceWaitIdle(m_engine->getLogicalDevice());
+
+            this->writeMipBenchmarkResults(outputPath, results);
+        }
+
+        /// @brief Time `backend` generating the mip chain of an image of `shape`, `format` and
+        /// `extent`, or nothing when the backend does not support it.
+        ///
+        /// @note The CPU generators only take flat images.
+        std::optional<MipBenchmarkResult> benchmarkMipBackend(
+            MipBenchmarkBackend backend,
+            MipBenchmarkShape shape,
+            VkFormat format,
+            const VkExtent3D& extent
+        ) {
+            const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max({ extent.width, extent.height, extent.depth })))) + 1;
+            const auto layerCount = shape == MipBenchmarkShape::CubeMap ? 6u : 1u;
+            const auto isCpuBackend = backend == MipBenchmarkBackend::CpuBox || backend == MipBenchmarkBackend::CpuFilter;
+            const auto failAllocation = [backend, shape, format, &extent](const char* reason) {
+                fmt::println(
+                    "The {} {} {} {}x{}x{} mip benchmark ran out of memory: {}",
+                    App::getMipBenchmarkBackendName(backend),
+                    App::getMipBenchmarkShapeName(shape),
+                    App::getMipBenchmarkFormatName(format),
+                    extent.width,
+                    extent.height,
+                    extent.depth,
+                    reason
+                );
+
+                return MipBenchmarkResult {
+                    .backend = backend,
+                    .shape = shape,
+                    .format = format,
+                    .extent = extent,
+                    .cpuMilliseconds = 0.0,
+                    .gpuMilliseconds = 0.0,
+                    .isAllocationFailed = true,
+                };
+            };
+            if (isCpuBackend) {
+                if (shape != MipBenchmarkShape::Flat || !CpuMipmapGenerator::supportsFormat(format)) {
+                    return std::nullopt;
+                }
+
+                const auto cpuFilter = backend == MipBenchmarkBackend::CpuBox ? VulkanEngine::CpuMipFilter::Box : CPU_MIP_FILTER;
+                const auto formatInfo = *TextureFormats::getInfo(format);
+                auto pixels = std::vector<uint8_t> {};
+                try {
+                    pixels.resize(formatInfo.getLevelSize(extent.width, extent.height));
+                } catch (const std::bad_alloc& exception) {
+                    return failAllocation(exception.what());
+                }
+                for (size_t i = 0; i < pixels.size(); i++) {
+                    pixels[i] = static_cast<uint8_t>(i * 31);
+                }
+
+                auto cpuSeconds = 0.0;
+                for (uint32_t i = 0; i < MIP_BENCHMARK_REPETITIONS; i++) {
+                    const auto startTime = std::chrono::steady_clock::now();
+                    CpuMipmapGenerator::generate(format, pixels.data(), extent.width, extent.height, mipLevels, cpuFilter);
+                    cpuSeconds += std::chrono::duration<double> { std::chrono::steady_clock::now() - startTime }.count();
+                }
+
+                return MipBenchmarkResult {
+                    .backend = backend,
+                    .shape = shape,
+                    .format = format,
+                    .extent = extent,
+                    .cpuMilliseconds = cpuSeconds * 1000.0 / MIP_BENCHMARK_REPETITIONS,
+                    .gpuMilliseconds = 0.0,
+                    .isAllocationFailed = false,
+                };
+            }
+
+            auto& uploadContext = m_engine->getUploadContext();
+            auto* mipmapGenerator = m_engine->getMipmapGenerator();
+            auto mipmapTarget = MipmapTarget {
+                .image = VK_NULL_HANDLE,
+                .format = format,
+                .width = extent.width,
+                .height = extent.height,
+                .depth = extent.depth,
+                .mipLevels = mipLevels,
+                .layerCount = layerCount,
+                .isCubeMap = shape == MipBenchmarkShape::CubeMap,
+                .filter = backend == MipBenchmarkBackend::ComputeFilter ? MIP_FILTER : VulkanEngine::MipFilter::Box,
+                .alphaCutoff = 0.0f,
+            };
+            if (backend == MipBenchmarkBackend::Blit && !uploadContext.supportsMipmapBlits(format)) {
+                return std::nullopt;
+            } else if (backend != MipBenchmarkBackend::Blit && (mipmapGenerator == nullptr || !mipmapGenerator->supportsTarget(mipmapTarget))) {
+                return std::nullopt;
+            }
+
+            const auto scopeName = fmt::format(
+                "mip benchmark {} {} {} {}x{}x{}",
+                App::getMipBenchmarkBackendName(backend),
+                App::getMipBenchmarkShapeName(shape),
+                App::getMipBenchmarkFormatName(format),
+                extent.width,
+                extent.height,
+                extent.depth
+            );
+            const auto cubeFlags = shape == MipBenchmarkShape::CubeMap ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : VkImageCreateFlags { 0 };
+            const auto gpuProfilerUploadFrame = MAX_FRAMES_IN_FLIGHT;
+
+            auto cpuSeconds = 0.0;
+            for (uint32_t i = 0; i < MIP_BENCHMARK_REPETITIONS; i++) {
+                auto image = VkImage {};
+                auto imageAllocation = GpuAllocation {};
+                try {
+                    std::tie(image, imageAllocation) = m_engine->createImage(
+                        extent.width,
+                        extent.height,
+                        mipLevels,
+                        VK_SAMPLE_COUNT_1_BIT,
+                        format,
+                        VK_IMAGE_TILING_OPTIMAL,
+                        uploadContext.getMipmapImageUsage(format) | VK_IMAGE_USAGE_SAMPLED_BIT,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                        uploadContext.getMipmapImageCreateFlags(format) | cubeFlags,
+                        layerCount,
+                        extent.depth,
+                        shape == MipBenchmarkShape::Volume ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D
+                    );
+                } catch (const std::runtime_error& exception) {
+                    return failAllocation(exception.what());
+                }
+                mipmapTarget.image = image;
+
+                auto clearBatch = uploadContext.beginBatch();
+                clearBatch.clearImage(image, VkClearColorValue { .float32 = { 0.25f, 0.5f, 0.75f, 1.0f } }, mipLevels, layerCount);
+                uploadContext.wait(uploadContext.submit(clearBatch));
+
+                // Without a mipmap generator, an upload batch falls back to a blit chain.
+                if (backend == MipBenchmarkBackend::Blit) {
+                    uploadContext.setMipmapGenerator(nullptr);
+                }
+
+                auto mipmapBatch = uploadContext.beginBatch();
+                if (m_gpuProfiler) {
+                    m_gpuProfiler->resetFrame(mipmapBatch.getCommandBuffer(), gpuProfilerUploadFrame);
+                }
+                const auto recordStartTime = std::chrono::steady_clock::now();
+                const auto mipScope = this->beginGpuScope(mipmapBatch.getCommandBuffer(), scopeName);
+                mipmapBatch.generateMipmaps(std::span<const MipmapTarget> { &mipmapTarget, 1 });
+                this->endGpuScope(mipmapBatch.getCommandBuffer(), mipScope);
+                cpuSeconds += std::chrono::duration<double> { std::chrono::steady_clock::now() - recordStartTime }.count();
+                uploadContext.setMipmapGenerator(mipmapGenerator);
+
+                uploadContext.wait(uploadContext.submit(mipmapBatch));
+                if (m_gpuProfiler) {
+                    m_gpuProfiler->submitFrame(gpuProfilerUploadFrame);
+                    m_gpuProfiler->resolveFrame(gpuProfilerUploadFrame);
+                }
+
+                m_engine->destroyImage(image, imageAllocation);
+            }
+
+            const auto gpuMilliseconds = [this, &scopeName]() -> double {
+                if (m_gpuProfiler) {
+                    for (const auto& statistics : m_gpuProfiler->getStatistics()) {
+                        if (statistics.name == scopeName) {
+                            return statistics.averageMilliseconds;
+                        }
+                    }
+                }
+
+                return 0.0;
+            }();
+
+            return MipBenchmarkResult {
+                .backend = backend,
+                .shape = shape,
+                .format = format,
+                .extent = extent,
+                .cpuMilliseconds = cpuSeconds * 1000.0 / MIP_BENCHMARK_REPETITIONS,
+                .gpuMilliseconds = gpuMilliseconds,
+                .isAllocationFailed = false,
+            };
+        }
+
+        static const char* getMipBenchmarkBackendName(MipBenchmarkBackend backend) {
+            switch (backend) {
+                case MipBenchmarkBackend::Blit: return "blit";
+                case MipBenchmarkBackend::ComputeBox: return "compute box";
+                case MipBenchmarkBackend::ComputeFilter: return "compute filter";
+                case MipBenchmarkBackend::CpuBox: return "cpu box";
+                case MipBenchmarkBackend::CpuFilter: return "cpu filter";
+            }
+
+            return "unknown";
+        }
+
+        static const char* getMipBenchmarkShapeName(MipBenchmarkShape shape) {
+            switch (shape) {
+                case MipBenchmarkShape::Flat: return "2d";
+                case MipBenchmarkShape::CubeMap: return "cube";
+                case MipBenchmarkShape::Volume: return "volume";
+            }
+
+            return "unknown";
+        }
+
+        static const char* getMipBenchmarkFormatName(VkFormat format) {
+            switch (format) {
+                case VK_FORMAT_R8G8B8A8_UNORM: return "R8G8B8A8_UNORM";
+                case VK_FORMAT_R8G8B8A8_SRGB: return "R8G8B8A8_SRGB";
+                default: return "unknown";
+            }
+        }
+
+        void writeMipBenchmarkResults(const std::filesystem::path& outputPath, const std::vector<MipBenchmarkResult>& results) const {
+            auto json = std::string {};
+            json += "{\n";
+            json += "  \"mipBenchmarks\": [";
+            for (size_t i = 0; i < results.size(); i++) {
+                const auto& result = results[i];
+                json += fmt::format(
+                    "{}\n    {{ \"backend\": \"{}\", \"shape\": \"{}\", \"format\": \"{}\", \"width\": {}, \"height\": {}, \"depth\": {}, \"cpuMilliseconds\": {:.4f}, \"gpuMilliseconds\": {:.4f}, \"allocationFailed\": {} }}",
+                    i == 0 ? "" : ",",
+                    App::getMipBenchmarkBackendName(result.backend),
+                    App::getMipBenchmarkShapeName(result.shape),
+                    App::getMipBenchmarkFormatName(result.format),
+                    result.extent.width,
+                    result.extent.height,
+                    result.extent.depth,
+                    result.cpuMilliseconds,
+                    result.gpuMilliseconds,
+                    result.isAllocationFailed
+                );
+            }
+            json += "\n  ]\n}\n";
+
+            if (outputPath.has_parent_path()) {
+                std::filesystem::create_directories(outputPath.parent_path());
+            }
+
+            auto file = std::ofstream { outputPath, std::ios::out | std::ios::trunc };
+            if (!file.is_open()) {
+                throw std::runtime_error("failed to open mip benchmark results file!");
+            }
+
+            file << json;
+            fmt::println("Mip benchmark results written to {}", outputPath.string());
+        }
+
+        void writeBenchmarkResults(
+            const std::vector<VulkanEngine::GpuScopeStatistics>& gpuStatistics,
+            const std::vector<TextureBenchmarkResult>& textureResults,
+            const std::vector<BenchmarkMetricComparison>& comparisons
+        ) const {
+            auto frameTimes = m_benchmarkFrameTimes;
+            std::sort(frameTimes.begin(), frameTimes.end());
+            const auto getPercentile = [&frameTimes](double percentile) -> double {
+                if (frameTimes.empty()) {
+                    return 0.0;
+                } else {
+                    const auto index = static_cast<size_t>(percentile / 100.0 * static_cast<double>(frameTimes.size() - 1));
+                    return frameTimes[index];
+                }
+            };
+            auto totalFrameTime = 0.0;
+            for (const auto& frameTime : frameTimes) {
+                totalFrameTime += frameTime;
+            }
+            const auto averageFrameTime = frameTimes.empty() ? 0.0 : totalFrameTime / static_cast<double>(frameTimes.size());
+
+            auto json = std::string {};
+            json += "{\n";
+            json += fmt::format("  \"frameCount\": {},\n", frameTimes.size());
+            // Only deterministic runs draw the same frames as each other.
+            json += fmt::format("  \"deterministic\": {},\n", m_isDeterministic);
+            json += fmt::format(
+                "  \"frameTimeMilliseconds\": {{ \"average\": {:.4f}, \"p50\": {:.4f}, \"p90\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f} }},\n",
+                averageFrameTime,
+                getPercentile(50.0),
+                getPercentile(90.0),
+                getPercentile(99.0),
+                getPercentile(100.0)
+            );
+            // Sweeps over stress scenes tell their runs apart by the scene each drew.
+            if (m_stressSceneOptions) {
+                json += fmt::format(
+                    "  \"stressScene\": {{ \"meshCount\": {}, \"overdraw\": {}, \"textureCount\": {}, \"textureSize\": {}, \"materialCount\": {} }},\n",
+                    m_stressSceneOptions->meshCount,
+                    m_stressSceneOptions->overdraw,
+                    m_stressSceneOptions->textureCount,
+                    m_stressSceneOptions->textureSize,
+                    m_stressSceneOptions->materialCount
+                );
+            }
+            json += "  \"gpuPasses\": [";
+            for (size_t i = 0; i < gpuStatistics.size(); i++) {
+                const auto& statistics = gpuStatistics[i];
+                json += fmt::format(
+                    "{}\n    {{ \"name\": \"{}\", \"averageMilliseconds\": {:.4f}, \"minMilliseconds\": {:.4f}, \"maxMilliseconds\": {:.4f} }}",
+                    i == 0 ? "" : ",",
+                    statistics.name,
+                    statistics.averageMilliseconds,
+                    statistics.minMilliseconds,
+                    statistics.maxMilliseconds
+                );
+            }
+            json += "\n  ],\n";
+            // The commands are averaged over the timed frames, by pass and by thread.
+            const auto frameCount = std::max(frameTimes.size(), size_t { 1 });
+            const auto formatCommandCounts = [frameCount](const CommandCounts& counts) -> std::string {
+                auto fields = std::string {};
+                for (size_t i = 0; i < counts.size(); i++) {
+                    fields += fmt::format(
+                        "{}\"{}\": {:.2f}",
+                        i == 0 ? "" : ", ",
+                        CommandCounters::getCounterName(static_cast<CommandCounter>(i)),
+                        static_cast<double>(counts[i]) / static_cast<double>(frameCount)
+                    );
+                }
+
+                return fields;
+            };
+            json += fmt::format("  \"commandsPerFrame\": {{ {} }},\n", formatCommandCounts(m_benchmarkCommandCounts.total));
+            json += "  \"commandPasses\": [";
+            for (uint32_t i = 0; i < m_benchmarkCommandCounts.passCount; i++) {
+                json += fmt::format(
+                    "{}\n    {{ \"name\": \"{}\", {} }}",
+                    i == 0 ? "" : ",",
+                    CommandCounters::getPassName(i),
+                    formatCommandCounts(m_benchmarkCommandCounts.passes[i])
+                );
+            }
+            json += "\n  ],\n";
+            json += "  \"commandThreads\": [";
+            for (uint32_t i = 0; i < m_benchmarkCommandCounts.threadCount; i++) {
+                json += fmt::format(
+                    "{}\n    {{ \"thread\": {}, {} }}",
+                    i == 0 ? "" : ",",
+                    i,
+                    formatCommandCounts(m_benchmarkCommandCounts.threads[i])
+                );
+            }
+            json += "\n  ],\n";
+            json += "  \"textures\": [";
+            for (size_t i = 0; i < textureResults.size(); i++) {
+                const auto& result = textureResults[i];
+                json += fmt::format(
+                    "{}\n    {{ \"width\": {}, \"height\": {}, \"uploadMegabytesPerSecond\": {:.2f}, \"mipGenerationMilliseconds\": {:.4f} }}",
+                    i == 0 ? "" : ",",
+                    result.size,
+                    result.size,
+                    result.uploadMegabytesPerSecond,
+                    result.mipGenerationMilliseconds
+                );
+            }
+            json += "\n  ],\n";
+            // A run that became the baseline has nothing to compare with.
+            json += "  \"baselineComparison\": [";
+            for (size_t i = 0; i < comparisons.size(); i++) {
+                const auto& comparison = comparisons[i];
+                json += fmt::format(
+                    "{}\n    {{ \"name\": \"{}\", \"unit\": \"{}\", \"baselineMedian\": {:.4f}, \"baselineMad\": {:.4f}, \"median\": {:.4f}, \"mad\": {:.4f}, \"relativeChange\": {:.4f}, \"pValue\": {}, \"isRegression\": {} }}",
+                    i == 0 ? "" : ",",
+                    comparison.name,
+                    comparison.unit,
+                    comparison.baselineMedian,
+                    comparison.baselineMad,
+                    comparison.runMedian,
+                    comparison.runMad,
+                    comparison.relativeChange,
+                    comparison.pValue ? fmt::format("{:.4g}", *comparison.pValue) : std::string { "null" },
+                    comparison.isRegression
+                );
+            }
+            json += "\n  ]\n}\n";
+
+            const auto& outputPath = m_benchmarkOptions->outputPath;
+            if (outputPath.has_parent_path()) {
+                std::filesystem::create_directories(outputPath.parent_path());
+            }
+
+            auto file = std::ofstream { outputPath, std::ios::out | std::ios::trunc };
+            if (!file.is_open()) {
+                throw std::runtime_error("failed to open benchmark results file!");
+            }
+
+            file << json;
+            fmt::println("Benchmark results written to {}", outputPath.string());
+        }
+
+        /// @brief Hold the next frame back according to the frame pacing mode.
+        ///
+        /// @note Without present waits, the low latency mode waits for the frame submitted
+        /// last on the frame timeline instead, which is reached once the GPU has finished it,
+        /// right ahead of its present.
+        void paceFrame() {
+            CPU_PROFILE_ZONE("pace frame");
+            switch (m_framePacing) {
+                case FramePacing::Unlimited: {
+                    break;
+                }
+                case FramePacing::FrameRateLimit: {
+                    const auto framePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double> { 1.0 / FRAME_RATE_LIMIT }
+                    );
+                    std::this_thread::sleep_until(m_nextFrameTime);
+                    // A frame that overran its slot does not make the next ones rush to
+                    // catch up.
+                    m_nextFrameTime = std::max(m_nextFrameTime, std::chrono::steady_clock::now()) + framePeriod;
+                    break;
+                }
+                case FramePacing::LowLatency: {
+                    if (this->waitForPendingPresent()) {
+                        break;
+                    }
+
+                    this->waitForSubmit(m_submitCount);
+                    break;
+                }
+            }
+        }
+
+        /// @brief Wait for the last present to reach the display, and add the time it took
+        /// from `vkQueuePresentKHR` to the present latency.
+        ///
+        /// @note Returns false when there is no present to wait for, because the device has
+        /// no present waits or the swap chain was recreated since, or the wait gave up.
+        bool waitForPendingPresent() {
+            if (!m_engine->supportsPresentWait() || m_pendingPresentId == 0) {
+                return false;
+            }
+
+            const auto presentId = m_pendingPresentId;
+            m_pendingPresentId = 0;
+
+            const auto result = m_engine->waitForPresent(m_swapChain, presentId, PRESENT_WAIT_TIMEOUT);
+            if (result == VK_TIMEOUT || result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+                return false;
+            } else if (result != VK_SUCCESS) {
+                throw std::runtime_error("failed to wait for present!");
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            m_presentLatencyTotal += now - m_pendingPresentTime;
+            m_presentLatencyCount++;
+            m_frameLatencyTracker.recordDisplayed(presentId, now);
+
+            return true;
+        }
+
+        /// @brief Hand the time of the last frame, and the values the monitoring system
+        /// follows, to the metrics exporter.
+        void updateMetrics(double frameMilliseconds) {
+            CPU_PROFILE_ZONE("update metrics");
+            m_metricsExporter->recordFrame(frameMilliseconds);
+
+            const auto& allocator = m_engine->getMemoryAllocator();
+            const auto& memoryProperties = allocator.getMemoryProperties();
+            auto usage = VkDeviceSize { 0 };
+            auto budget = VkDeviceSize { 0 };
+            for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+                if (!(memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+                    continue;
+                }
+
+                const auto heapBudget = allocator.getHeapBudget(i);
+                usage += heapBudget.usage;
+                budget += heapBudget.budget;
+            }
+            m_metricsExporter->setGauge(MetricsGauge::DeviceMemoryUsageBytes, static_cast<double>(usage));
+            m_metricsExporter->setGauge(MetricsGauge::DeviceMemoryBudgetBytes, static_cast<double>(budget));
+            const auto streamingBacklog = m_assetStreamer != nullptr ? m_assetStreamer->getPendingCount() : 0;
+            m_metricsExporter->setGauge(MetricsGauge::StreamingBacklog, static_cast<double>(streamingBacklog));
+        }
+
+        /// @brief Report the presents that have reached the display since the last frame to
+        /// the frame latency, without waiting for the ones that have not.
+        ///
+        /// @note A present is taken to be displayed when it is first seen here, so the
+        /// latency is up to a frame late, except in the low latency mode, which waits for
+        /// every present as it is displayed.
+        void updateDisplayedPresents() {
+            if (!m_engine->supportsPresentWait()) {
+                return;
+            }
+
+            while (const auto presentId = m_frameLatencyTracker.getOldestPendingPresentId()) {
+                const auto result = m_engine->waitForPresent(m_swapChain, *presentId, 0);
+                if (result == VK_TIMEOUT) {
+                    return;
+                } else if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+                    m_frameLatencyTracker.dropPendingFrames();
+                    return;
+                } else if (result != VK_SUCCESS) {
+                    throw std::runtime_error("failed to wait for present!");
+                }
+
+                m_frameLatencyTracker.recordDisplayed(*presentId, std::chrono::steady_clock::now());
+            }
+        }
+
+        /// @brief Switch the present mode to the one whose key is held down.
+        void updatePresentModePolicy() {
+            const auto keyPolicies = std::array<std::tuple<int, PresentModePolicy>, 4> {
+                std::make_tuple(GLFW_KEY_I, PresentModePolicy::Immediate),
+                std::make_tuple(GLFW_KEY_R, PresentModePolicy::FifoRelaxed),
+                std::make_tuple(GLFW_KEY_M, PresentModePolicy::Mailbox),
+                std::make_tuple(GLFW_KEY_F, PresentModePolicy::Fifo),
+            };
+            for (const auto& [key, policy] : keyPolicies) {
+                if (m_engine->isKeyDown(key)) {
+                    this->setPresentModePolicy(policy);
+                    return;
+                }
+            }
+        }
+
+        /// @brief Recreate the swap chain with the present mode `policy` asks for.
+        void setPresentModePolicy(PresentModePolicy policy) {
+            if (policy == m_presentModePolicy) {
+                return;
+            }
+
+            m_presentModePolicy = policy;
+            this->recreateSwapChain();
+            for (auto& viewportSwapChain : m_viewportSwapChains) {
+                viewportSwapChain.isOutOfDate = true;
+            }
+        }
+
+        /// @brief Change the frames in flight to the number key held down, from 1 up to
+        /// `MAX_FRAMES_IN_FLIGHT`.
+        void updateFramesInFlight() {
+            for (uint32_t framesInFlight = 1; framesInFlight <= MAX_FRAMES_IN_FLIGHT; framesInFlight++) {
+                const auto key = GLFW_KEY_1 + static_cast<int>(framesInFlight - 1);
+                if (m_engine->isKeyDown(key)) {
+                    this->setFramesInFlight(framesInFlight);
+                    return;
+                }
+            }
+        }
+
+        /// @brief How the frame loop holds back while the window is where it is now.
+        BackgroundThrottle getBackgroundThrottle() const {
+            if (m_isHeadless) {
+                return BackgroundThrottle::None;
+            } else if (m_engine->isWindowIconified()) {
+                return MINIMIZED_THROTTLE;
+            } else if (!m_engine->isWindowFocused()) {
+                return UNFOCUSED_THROTTLE;
+            } else {
+                return BackgroundThrottle::None;
+            }
+        }
+
+        /// @brief Hold the next frame back while the window is in the background, for as
+        /// long as its throttle asks, or until the window is back or is to close.
+        ///
+        /// @note Events are handled while it waits, so the window notices when it is back.
+        void throttleInBackground() {
+            CPU_PROFILE_ZONE("throttle in background");
+            const auto isClosing = [this]() -> bool {
+                return m_engine->isWindowCloseRequested();
+            };
+            while (this->getBackgroundThrottle() == BackgroundThrottle::Pause && !isClosing()) {
+                m_engine->waitWindowEvents(std::nullopt);
+            }
+
+            if (this->getBackgroundThrottle() == BackgroundThrottle::FrameRateLimit) {
+                auto now = std::chrono::steady_clock::now();
+                while (now < m_nextBackgroundFrameTime && this->getBackgroundThrottle() == BackgroundThrottle::FrameRateLimit && !isClosing()) {
+                    m_engine->waitWindowEvents(std::chrono::duration<double> { m_nextBackgroundFrameTime - now }.count());
+                    now = std::chrono::steady_clock::now();
+                }
+
+                const auto framePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double> { 1.0 / BACKGROUND_FRAME_RATE_LIMIT }
+                );
+                m_nextBackgroundFrameTime = now + framePeriod;
+            }
+
+            m_isStreamingSuspended = SUSPEND_STREAMING_IN_BACKGROUND && this->getBackgroundThrottle() != BackgroundThrottle::None;
+        }
+
+        /// @brief Sleep until there is a frame to draw on demand, or the window is to close.
+        ///
+        /// @note An animation source that is active keeps every frame due, so this returns
+        /// at once.
+        void waitForRedraw() {
+            while (true) {
+                if (m_shaderReloader) {
+                    this->updateReloadedShaders();
+                }
+                this->updatePendingPipelines();
+
+                this->updateRedrawSources();
+                if (m_redrawScheduler->isRedrawDue() || m_engine->isWindowCloseRequested()) {
+                    return;
+                }
+
+                CPU_PROFILE_ZONE("wait for events");
+                m_engine->waitWindowEvents(ON_DEMAND_WAIT_SECONDS);
+            }
+        }
+
+        /// @brief Ask for a redraw if window events came in since the last frame, and tell
+        /// the redraw scheduler which animation sources are active.
+        void updateRedrawSources() {
+            const auto windowEventCount = m_engine->getWindowEventCount();
+            if (windowEventCount != m_windowEventCount) {
+                m_windowEventCount = windowEventCount;
+                m_redrawScheduler->requestRedraw();
+            }
+
+            const auto isSwappingPipeline = m_pendingGraphicsPipeline != PipelineCompiler::INVALID_HANDLE
+                || m_pendingDepthPrepassPipeline != PipelineCompiler::INVALID_HANDLE
+                || m_pendingMeshShaderPipeline != PipelineCompiler::INVALID_HANDLE;
+            const auto isStreamingTexture = !m_isStreamingSuspended && (
+                (m_textureStreamer != nullptr && m_isTextureResident && m_textureStreamer->isStreaming())
+                || (m_mipmapSlicer != nullptr && m_isTextureResident)
+                || (m_virtualTexture != nullptr && m_virtualTexture->isStreaming())
+            );
+            m_redrawScheduler->setAnimating(AnimationSource::CameraOrbit, !m_pausedSceneTime.has_value());
+            m_redrawScheduler->setAnimating(AnimationSource::AssetStreaming, m_assetStreamer != nullptr && !m_isStreamingSuspended);
+            m_redrawScheduler->setAnimating(AnimationSource::TextureStreaming, isStreamingTexture);
+            m_redrawScheduler->setAnimating(
+                AnimationSource::GeometryStreaming,
+                !m_isStreamingSuspended && m_geometryStreamer != nullptr && m_geometryStreamer->isStreaming()
+            );
+            m_redrawScheduler->setAnimating(AnimationSource::PipelineSwap, isSwappingPipeline);
+            m_redrawScheduler->setAnimating(AnimationSource::PerformanceHud, m_performanceHud != nullptr && m_isPerformanceHudVisible);
+            m_redrawScheduler->setAnimating(AnimationSource::DashboardTexture, m_dashboardTexture != nullptr);
+        }
+
+        /// @brief Pause or resume the orbit of the camera when its key goes down.
+        void updateCameraOrbitToggle() {
+            const auto isKeyDown = m_engine->isKeyDown(CAMERA_ORBIT_KEY);
+            if (isKeyDown && !m_wasCameraOrbitKeyDown) {
+                this->setCameraOrbitPaused(!m_pausedSceneTime.has_value());
+            }
+            m_wasCameraOrbitKeyDown = isKeyDown;
+        }
+
+        /// @brief Paint a square into the model texture while `TEXTURE_PAINT_KEY` is down.
+        ///
+        /// @note Every square goes a golden ratio of the texture along from the one before,
+        /// so the squares spread over all of it, and takes a hue of its own.
+        void updateTexturePaint() {
+            if (!m_isTextureRegionUpdatable || m_textureFormat != VK_FORMAT_R8G8B8A8_SRGB || !m_engine->isKeyDown(TEXTURE_PAINT_KEY)) {
+                return;
+            }
+
+            m_texturePaintCount++;
+            const auto size = std::min({ TEXTURE_PAINT_SIZE, m_textureExtent.width, m_textureExtent.height });
+            const auto step = static_cast<double>(m_texturePaintCount);
+            const auto x = static_cast<int32_t>(std::fmod(0.618034 * step, 1.0) * (m_textureExtent.width - size));
+            const auto y = static_cast<int32_t>(std::fmod(0.754878 * step, 1.0) * (m_textureExtent.height - size));
+            const auto color = std::array<uint8_t, 4> {
+                static_cast<uint8_t>(m_texturePaintCount * 67),
+                static_cast<uint8_t>(m_texturePaintCount * 131),
+                static_cast<uint8_t>(m_texturePaintCount * 199),
+                255,
+            };
+
+            auto pixels = std::vector<uint8_t>(size_t { size } * size * color.size());
+            for (size_t i = 0; i < pixels.size(); i++) {
+                pixels[i] = color[i % color.size()];
+            }
+
+            this->updateTextureRegion(VkRect2D { .offset = { x, y }, .extent = { size, size } }, pixels.data());
+        }
+
+        /// @brief Replace `rect` of level 0 of the model texture with `pixels`, which are its
+        /// texels, tightly packed, and filter the texels of the lower levels that it changes.
+        ///
+        /// @note The upload goes to the graphics queue after the frames submitted so far and
+        /// before the next one, so the frames in flight sample the texture as it was, and no
+        /// frame waits for the upload. The texture must be one `m_isTextureRegionUpdatable`
+        /// holds for.
+        void updateTextureRegion(const VkRect2D& rect, const void* pixels) {
+            if (!m_isTextureRegionUpdatable) {
+                throw std::runtime_error("failed to update texture region: the texture cannot be updated in place!");
+            }
+
+            const auto isInside = rect.offset.x >= 0
+                && rect.offset.y >= 0
+                && rect.offset.x + rect.extent.width <= m_textureExtent.width
+                && rect.offset.y + rect.extent.height <= m_textureExtent.height;
+            if (!isInside) {
+                throw std::invalid_argument("texture region out of range!");
+            }
+
+            const auto formatInfo = *TextureFormats::getInfo(m_textureFormat);
+            auto& uploadContext = m_engine->getUploadContext();
+            auto uploadBatch = uploadContext.beginBatch();
+            const auto stagingSlice = uploadBatch.stage(pixels, formatInfo.getLevelSize(rect.extent.width, rect.extent.height));
+            const auto target = MipmapTarget {
+                .image = m_textureImage,
+                .format = m_textureFormat,
+                .width = m_textureExtent.width,
+                .height = m_textureExtent.height,
+                .mipLevels = m_mipLevels,
+            };
+            uploadBatch.updateImageRegion(stagingSlice, target, rect);
+            uploadContext.submit(uploadBatch);
+        }
+
+        /// @brief Hold the orbit of the camera where it is, or let it go on from there.
+        ///
+        /// @note Deterministic runs advance the scene by the frame, and never pause.
+        void setCameraOrbitPaused(bool isPaused) {
+            if (m_isDeterministic || isPaused == m_pausedSceneTime.has_value()) {
+                return;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if (!m_sceneStartTime) {
+                m_sceneStartTime = now;
+            }
+
+            if (isPaused) {
+                m_pausedSceneTime = std::chrono::duration<double> { now - *m_sceneStartTime }.count();
+            } else {
+                const auto pausedTime = std::chrono::duration<double> { *m_pausedSceneTime };
+                m_sceneStartTime = now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(pausedTime);
+                m_pausedSceneTime.reset();
+            }
+        }
+
+        /// @brief Show or hide the performance HUD when its key goes down.
+        void updatePerformanceHudToggle() {
+            if (m_performanceHud == nullptr) {
+                return;
+            }
+
+            const auto isKeyDown = m_engine->isKeyDown(PERFORMANCE_HUD_KEY);
+            if (isKeyDown && !m_wasPerformanceHudKeyDown) {
+                m_isPerformanceHudVisible = !m_isPerformanceHudVisible;
+            }
+            m_wasPerformanceHudKeyDown = isKeyDown;
+        }
+
+        /// @brief Create a view of `image`, or of its first `layerCount` layers as a 2D array.
+        VkImageView createImageView(
+            VkImage image,
+            VkFormat format,
+            VkImageAspectFlags aspectFlags,
+            uint32_t mipLevels,
+            uint32_t layerCount = 1,
+            uint32_t baseArrayLayer = 0
+        ) {
+            const auto viewInfo = VkImageViewCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image = image,
+                .viewType = layerCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D,
+                .format = format,
+                .components = VkComponentMapping { VK_COMPONENT_SWIZZLE_IDENTITY }, // Optional
+                .subresourceRange.aspectMask = aspectFlags,
+                .subresourceRange.baseMipLevel = 0,
+                .subresourceRange.levelCount = mipLevels,
+                .subresourceRange.baseArrayLayer = baseArrayLayer,
+                .subresourceRange.layerCount = layerCount,
+            };
+
+            auto imageView = VkImageView {};
+            const auto result = vkCreateImageView(m_engine->getLogicalDevice(), &viewInfo, m_engine->getAllocationCallbacks(), &imageView);
+            if (result != VK_SUCCESS) {
+                throw std::runtime_error("failed to create texture image view!");
+            }
+
+            return imageView;
+        }
+
+        VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) {
+            for (VkFormat format : candidates) {
+                const auto props = m_engine->getDeviceCapabilities().getFormatProperties(format);
+
+                if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features) {
+                    return format;
+                } else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features) {
+                    return format;
+                }
+            }
+
+            throw std::runtime_error("failed to find supported format!");
+        }
+
+        /// @brief The depth format to render with, the 32-bit float one wherever the device
+        /// has it, since reverse-Z only gains precision with floating point depth.
+        VkFormat findDepthFormat() {
+            auto candidates = std::vector<VkFormat> { 
+                VK_FORMAT_D32_SFLOAT,
+                VK_FORMAT_D32_SFLOAT_S8_UINT,
+                VK_FORMAT_D24_UNORM_S8_UINT
+            };
+            auto tiling = VK_IMAGE_TILING_OPTIMAL;
+            auto features = VkFormatFeatureFlags { VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT };
+            if (this->isDepthSampled()) {
+                features |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+            }
+        
+            return this->findSupportedFormat(candidates, tiling, features);
+        }
+
+        bool hasStencilComponent(VkFormat format) {
+            return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+        }
+
+        /// @brief The format the scene is drawn in: the linear one of the post process
+        /// subpass's input when there is one, and the swap chain's otherwise.
+        VkFormat getSceneColorFormat() const {
+            return m_usePostProcessSubpass ? POST_PROCESS_SCENE_COLOR_FORMAT : m_swapChainImageFormat;
+        }
+
+        /// @brief Create the multisampled color target, which is resolved into the swap chain
+        /// image at the end of every frame, or into the input of the post process subpass.
+        void createColorResources() {
+            const auto [colorImage, colorImageAllocation] = m_engine->createTransientAttachment(
+                m_swapChainExtent.width,
+                m_swapChainExtent.height,
+                m_msaaSamples,
+                this->getSceneColorFormat(),
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                m_viewCount
+            );
+            auto colorImageView = this->createImageView(colorImage, this->getSceneColorFormat(), VK_IMAGE_ASPECT_COLOR_BIT, 1, m_viewCount);
+
+            m_colorImage = colorImage;
+            m_colorImageAllocation = colorImageAllocation;
+            m_colorImageView = colorImageView;
+        }
+
+        /// @brief Create the image the scene is rendered into at the scale dynamic resolution
+        /// picks, and blitted from into the swap chain image.
+        ///
+        /// @note The image is as big as the swap chain, so the scale changes without it
+        /// being created again, and only its top left corner is rendered into.
+        void createSceneColorResources() {
+            const auto [sceneColorImage, sceneColorImageAllocation] = m_engine->createImage(
+                m_swapChainExtent.width,
+                m_swapChainExtent.height,
+                1,
+                VK_SAMPLE_COUNT_1_BIT,
+                m_swapChainImageFormat,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+            auto sceneColorImageView = this->createImageView(sceneColorImage, m_swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+
+            m_sceneColorImage = sceneColorImage;
+            m_sceneColorImageAllocation = sceneColorImageAllocation;
+            m_sceneColorImageView = sceneColorImageView;
+        }
+
+        /// @brief Whether anything reads the post process input outside the render pass: the
+        /// luminance reduction or the bloom chain.
+        bool isPostProcessInputSampled() const {
+            return m_usePostProcessSubpass && (POST_PROCESS_AUTO_EXPOSURE || POST_PROCESS_BLOOM);
+        }
+
+        /// @brief Create the single sampled scene color the post process subpass reads as an
+        /// input attachment, the luminance reduction and bloom chain built from it, and the
+        /// set that binds them.
+        ///
+        /// @note Unless the post effects sample the image, it is only ever an attachment of
+        /// the render pass, which never stores it, so it can live in lazily allocated memory.
+        /// The set has a pool of its own, which is retired along with the image when the swap
+        /// chain is created again.
+        void createPostProcessResources() {
+            const auto [inputImage, inputImageAllocation] = [this]() -> std::tuple<VkImage, GpuAllocation> {
+                if (this->isPostProcessInputSampled()) {
+                    return m_engine->createImage(
+                        m_swapChainExtent.width,
+                        m_swapChainExtent.height,
+                        1,
+                        VK_SAMPLE_COUNT_1_BIT,
+                        POST_PROCESS_SCENE_COLOR_FORMAT,
+                        VK_IMAGE_TILING_OPTIMAL,
+                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                    );
+                } else {
+                    return m_engine->createTransientAttachment(
+                        m_swapChainExtent.width,
+                        m_swapChainExtent.height,
+                        VK_SAMPLE_COUNT_1_BIT,
+                        POST_PROCESS_SCENE_COLOR_FORMAT,
+                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT
+                    );
+                }
+            }();
+            auto inputImageView = this->createImageView(inputImage, POST_PROCESS_SCENE_COLOR_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+
+            if (POST_PROCESS_AUTO_EXPOSURE) {
+                this->createLuminanceReduction(inputImageView);
+            }
+            if (POST_PROCESS_BLOOM) {
+                this->createBloomChain(inputImageView);
+            }
+
+            const auto poolSizes = std::array<VkDescriptorPoolSize, 3> {
+                VkDescriptorPoolSize {
+                    .type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
+                    .descriptorCount = 1,
+                },
+                VkDescriptorPoolSize {
+                    .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                    .descriptorCount = 2,
+                },
+                VkDescriptorPoolSize {
+                    .type = VK_DESCRIPTOR_TYPE_SAMPLER,
+                    .descriptorCount = 1,
+                },
+            };
+            const auto poolInfo = VkDescriptorPoolCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                .flags = 0,
+                .maxSets = 1,
+                .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+                .pPoolSizes = poolSizes.data(),
+            };
+
+            auto descriptorPool = VkDescriptorPool {};
+            const auto resultCreateDescriptorPool = vkCreateDescriptorPool(m_engine->getLogicalDevice(), &poolInfo, m_engine->getAllocationCallbacks(), &descriptorPool);
+            if (resultCreateDescriptorPool != VK_SUCCESS) {
+                throw std::runtime_error("failed to create post process descriptor pool!");
+            }
+
+            const auto allocInfo = VkDescriptorSetAllocateInfo {
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                .descriptorPool = descriptorPool,
+                .descriptorSetCount = 1,
+                .pSetLayouts = &m_postProcessSetLayout,
+            };
+
+            auto descriptorSet = VkDescriptorSet {};
+            const auto resultAllocateDescriptorSets = vkAllocateDescriptorSets(m_engine->getLogicalDevice(), &allocInfo, &descriptorSet);
+            if (resultAllocateDescriptorSets != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate post process descriptor set!");
+            }
+
+            const auto imageInfo = VkDescriptorImageInfo {
+                .sampler = VK_NULL_HANDLE,
+                .imageView = inputImageView,
+                .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            };
+            auto descriptorWrites = std::vector<VkWriteDescriptorSet> {
+                VkWriteDescriptorSet {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = descriptorSet,
+                    .dstBinding = 0,
+                    .dstArrayElement = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
+                    .pImageInfo = &imageInfo,
+                },
+            };
+            // The chains live in the general layout, where the post effects pass builds them.
+            const auto bloomInfo = VkDescriptorImageInfo {
+                .sampler = VK_NULL_HANDLE,
+                .imageView = m_bloomChain != nullptr ? m_bloomChain->getImageView() : VK_NULL_HANDLE,
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            };
+            const auto bloomSamplerInfo = VkDescriptorImageInfo {
+                .sampler = m_bloomChain != nullptr ? m_bloomChain->getSampler() : VK_NULL_HANDLE,
+                .imageView = VK_NULL_HANDLE,
+                .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            };
+            const auto averageLuminanceInfo = VkDescriptorImageInfo {
+                .sampler = VK_NULL_HANDLE,
+                .imageView = m_luminanceReduction != nullptr ? m_luminanceReduction->getAverageImageView() : VK_NULL_HANDLE,
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            };
+            if (m_bloomChain != nullptr) {
+                descriptorWrites.push_back(VkWriteDescriptorSet {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = descriptorSet,
+                    .dstBinding = 1,
+                    .dstArrayElement = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                    .pImageInfo = &bloomInfo,
+                });
+                descriptorWrites.push_back(VkWriteDescriptorSet {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = descriptorSet,
+                    .dstBinding = 3,
+                    .dstArrayElement = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+                    .pImageInfo = &bloomSamplerInfo,
+                });
+            }
+            if (m_luminanceReduction != nullptr) {
+                descriptorWrites.push_back(VkWriteDescriptorSet {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = descriptorSet,
+                    .dstBinding = 2,
+                    .dstArrayElement = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                    .pImageInfo = &averageLuminanceInfo,
+                });
+            }
+            m_dispatch->vkUpdateDescriptorSets(m_engine->getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+            m_postProcessInputImage = inputImage;
+            m_postProcessInputImageAllocation = inputImageAllocation;
+            m_postProcessInputImageView = inputImageView;
+            m_postProcessDescriptorPool = descriptorPool;
+            m_postProcessDescriptorSet = descriptorSet;
+        }
+
+        /// @brief Create the reduction of the post process input into its log average
+        /// luminance, which the tone mapper exposes the frame after with.
+        ///
+        /// @note The average starts out at middle grey, so that the frames exposed before it
+        /// is first reduced are exposed at `POST_PROCESS_EXPOSURE` alone.
+        void createLuminanceReduction(VkImageView inputImageView) {
+            m_luminanceReduction = std::make_unique<LuminanceReduction>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_engine->getPipelineCache(),
+                shaders_hlsl::getHlslShader(HlslShader::DownsampleComp),
+                inputImageView,
+                m_swapChainExtent
+            );
+
+            auto& uploadContext = m_engine->getUploadContext();
+            auto uploadBatch = uploadContext.beginBatch();
+            m_luminanceReduction->recordInitialization(uploadBatch.getCommandBuffer(), std::log(POST_PROCESS_MIDDLE_GREY));
+            uploadContext.wait(uploadContext.submit(uploadBatch));
+        }
+
+        /// @brief Create the bloom chain blurred out of the post process input, which the tone
+        /// mapper adds into the frame after.
+        ///
+        /// @note The chain starts out black, so that the frames before it is first blurred
+        /// have no bloom.
+        void createBloomChain(VkImageView inputImageView) {
+            m_bloomChain = std::make_unique<BloomChain>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_engine->getPipelineCache(),
+                shaders_hlsl::getHlslShader(HlslShader::DownsampleComp),
+                shaders_hlsl::getHlslShader(HlslShader::BloomUpsampleComp),
+                inputImageView,
+                m_swapChainExtent,
+                POST_PROCESS_BLOOM_LEVELS
+            );
+
+            auto& uploadContext = m_engine->getUploadContext();
+            auto uploadBatch = uploadContext.beginBatch();
+            m_bloomChain->recordInitialization(uploadBatch.getCommandBuffer());
+            uploadContext.wait(uploadContext.submit(uploadBatch));
+        }
+
+        /// @brief Whether anything reads the depth buffer outside the pass that writes it: the
+        /// depth pyramid or the temporal upscaler.
+        bool isDepthSampled() const {
+            return m_buildDepthPyramid || m_useTemporalUpscaling;
+        }
+
+        /// @brief Create the depth buffer, and the depth pyramid and temporal upscaler that
+        /// read it.
+        ///
+        /// @note Depth is cleared on load in every pass. When nothing samples it, it is also
+        /// discarded on store, so nothing ever reads it outside a pass and it can live in
+        /// lazily allocated memory.
+        void createDepthResources() {
+            const VkFormat depthFormat = this->findDepthFormat();
+
+            const auto [depthImage, depthImageAllocation] = [this, depthFormat]() -> std::tuple<VkImage, GpuAllocation> {
+                if (this->isDepthSampled()) {
+                    return m_engine->createImage(
+                        m_swapChainExtent.width,
+                        m_swapChainExtent.height,
+                        1,
+                        m_msaaSamples,
+                        depthFormat,
+                        VK_IMAGE_TILING_OPTIMAL,
+                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                        0,
+                        m_viewCount
+                    );
+                } else {
+                    return m_engine->createTransientAttachment(
+                        m_swapChainExtent.width,
+                        m_swapChainExtent.height,
+                        m_msaaSamples,
+                        depthFormat,
+                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                        m_viewCount
+                    );
+                }
+            }();
+            auto depthImageView = this->createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1, m_viewCount);
+
+            m_depthImage = depthImage;
+            m_depthImageAllocation = depthImageAllocation;
+            m_depthImageView = depthImageView;
+
+            if (m_buildDepthPyramid) {
+                this->createDepthPyramid();
+            }
+            if (m_useTemporalUpscaling) {
+                this->createTemporalUpscaler();
+            }
+            if (m_useShadingRateImage) {
+                this->createShadingRateImage();
+            }
+        }
+
+        /// @brief Create the upscaler that accumulates the scene color image into a history
+        /// as big as the swap chain, with a history that starts out empty.
+        void createTemporalUpscaler() {
+            const auto shaderModule = m_engine->createShaderModule(shaders_hlsl::getHlslShader(HlslShader::TemporalUpscaleComp));
+            m_temporalUpscaler = std::make_unique<TemporalUpscaler>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_engine->getPipelineCache(),
+                shaderModule,
+                m_sceneColorImageView,
+                m_depthImageView,
+                m_swapChainExtent
+            );
+            m_engine->releaseShaderModule(shaderModule);
+
+            auto& uploadContext = m_engine->getUploadContext();
+            auto uploadBatch = uploadContext.beginBatch();
+            m_temporalUpscaler->recordInitialization(uploadBatch.getCommandBuffer());
+            uploadContext.wait(uploadContext.submit(uploadBatch));
+        }
+
+        /// @brief Create the shading rate image over the scene color image, built from the
+        /// histories of the temporal upscaler, which has to exist already. It starts out
+        /// shading every pixel, and keeps that rate until the upscaler has a history to
+        /// build it from.
+        void createShadingRateImage() {
+            const auto shaderModule = m_engine->createShaderModule(shaders_hlsl::getHlslShader(HlslShader::ShadingRateComp));
+            m_shadingRateImage = std::make_unique<ShadingRateImage>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_engine->getPipelineCache(),
+                shaderModule,
+                m_temporalUpscaler->getHistoryImageViews(),
+                m_swapChainExtent,
+                this->getShadingRateTexelSize()
+            );
+            m_engine->releaseShaderModule(shaderModule);
+
+            auto& uploadContext = m_engine->getUploadContext();
+            auto uploadBatch = uploadContext.beginBatch();
+            m_shadingRateImage->recordInitialization(uploadBatch.getCommandBuffer());
+            uploadContext.wait(uploadContext.submit(uploadBatch));
+        }
+
+        /// @brief Create the pyramid of the farthest depths of the depth buffer.
+        ///
+        /// @note The pyramid starts out at the far plane, so that the frames culled before
+        /// it is first built cull nothing by occlusion.
+        void createDepthPyramid() {
+            m_depthPyramid = std::make_unique<DepthPyramid>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_engine->getPipelineCache(),
+                shaders_hlsl::getHlslShader(HlslShader::DepthPyramidComp),
+                shaders_hlsl::getHlslShader(HlslShader::DownsampleComp),
+                m_depthImageView,
+                m_swapChainExtent,
+                m_msaaSamples,
+                REVERSE_Z ? DepthReduction::Min : DepthReduction::Max
+            );
+
+            auto& uploadContext = m_engine->getUploadContext();
+            auto uploadBatch = uploadContext.beginBatch();
+            m_depthPyramid->recordInitialization(uploadBatch.getCommandBuffer(), FAR_DEPTH);
+            uploadContext.wait(uploadContext.submit(uploadBatch));
+        }
+
+        bool isSharingAssets() const {
+            return m_shareAssetsSocketPath.has_value() || m_importAssetsSocketPath.has_value();
+        }
+
+        /// @brief Start handing the model's assets out to other instances, or connect to the
+        /// instance that hands them out, when the app shares them.
+        ///
+        /// @note An importer blocks until the owner is listening, for at most
+        /// `SHARED_ASSET_TIMEOUT`.
+        void createSharedAssets() {
+            if (!this->isSharingAssets()) {
+                return;
+            }
+
+            if (!m_engine->supportsExternalMemoryFd()) {
+                throw std::runtime_error("failed to share assets: the device cannot share memory as file descriptors!");
+            }
+
+            if (m_shareAssetsSocketPath) {
+                m_sharedAssetPublisher = std::make_unique<SharedAssetPublisher>(
+                    m_engine->getPhysicalDevice(),
+                    m_engine->getLogicalDevice(),
+                    m_engine->getAllocationCallbacks(),
+                    m_engine->getGraphicsQueueFamilyIndex(),
+                    m_engine->supportsSynchronization2(),
+                    *m_shareAssetsSocketPath
+                );
+            } else {
+                m_sharedAssetImporter = std::make_unique<SharedAssetImporter>(
+                    m_engine->getPhysicalDevice(),
+                    m_engine->getLogicalDevice(),
+                    m_engine->getAllocationCallbacks(),
+                    m_engine->getGraphicsQueueFamilyIndex(),
+                    m_engine->supportsSynchronization2(),
+                    *m_importAssetsSocketPath,
+                    SHARED_ASSET_TIMEOUT
+                );
+            }
+        }
+
+        /// @brief Take the model texture from the instance that shares it, in place of
+        /// loading it.
+        void importTextureImage() {
+            const auto& description = m_sharedAssetImporter->getDescription(SHARED_TEXTURE_NAME);
+            m_textureImage = m_sharedAssetImporter->importImage(SHARED_TEXTURE_NAME);
+            m_textureImageAllocation = GpuAllocation {};
+            m_textureFormat = description.format;
+            m_mipLevels = description.mipLevels;
+            m_textureExtent = description.extent;
+            m_isTextureRegionUpdatable = false;
+        }
+
+        /// @brief Move the finished model texture into an image that other instances can
+        /// import, and destroy the image it was loaded into once the batch completes.
+        ///
+        /// @note Every path of `createTextureImage` leaves its image in the shader read-only
+        /// layout, whatever format and usage it took, so the texture is copied rather than
+        /// loaded into the shared image directly. Only the owner holds both images, and only
+        /// until the batch completes.
+        void shareTextureImage(UploadBatch& uploadBatch) {
+            const auto sharedImage = m_sharedAssetPublisher->createImage(
+                SHARED_TEXTURE_NAME,
+                m_textureFormat,
+                m_textureExtent,
+                m_mipLevels,
+                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+            );
+            m_sharedAssetPublisher->recordCopyToImage(uploadBatch.getCommandBuffer(), m_textureImage, SHARED_TEXTURE_NAME);
+            uploadBatch.deferDestruction([this, image = m_textureImage, allocation = m_textureImageAllocation]() {
+                m_engine->destroyImage(image, allocation);
+            });
+
+            m_textureImage = sharedImage;
+            m_textureImageAllocation = GpuAllocation {};
+            m_isTextureRegionUpdatable = false;
+        }
+
+        /// @brief `usage`, and the usage the model texture needs to be copied into the image
+        /// that other instances import, when the app hands its assets out.
+        VkImageUsageFlags getTextureImageUsage(VkImageUsageFlags usage) const {
+            return m_shareAssetsSocketPath ? usage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT : usage;
+        }
+
+        /// @brief Create the texture in the most compact format the device supports.
+        ///
+        /// @note A block-compressed KTX2 file sitting next to the source image is preferred.
+        /// The texture only falls back to the 8-bit RGBA source image, and the texture cache
+        /// in front of it, when there is no such file or the device cannot sample its format.
+        void createTextureImage(UploadBatch& uploadBatch, const std::string& filePath) {
+            const auto sourcePath = std::filesystem::path { filePath };
+            const auto compressedFilePath = std::filesystem::path { sourcePath }.replace_extension(".ktx2").string();
+            if (AssetFile::exists(compressedFilePath)) {
+                auto textureLoader = Ktx2TextureLoader { compressedFilePath };
+                const auto ktx2TextureImage = textureLoader.load();
+                if (this->isKtx2TextureSupported(ktx2TextureImage)) {
+                    this->createTextureImageFromKtx2(uploadBatch, textureLoader, ktx2TextureImage);
+
+                    return;
+                }
+
+                if (ktx2TextureImage.isBasisUniversal()) {
+                    fmt::println(std::cerr, "{} holds a Basis Universal texture, which cannot be transcoded; falling back to RGBA8", compressedFilePath);
+                } else {
+                    fmt::println(std::cerr, "Texture format of {} is not supported by the device; falling back to RGBA8", compressedFilePath);
+                }
+            }
+
+            if (sourcePath.extension() == ".ktx2") {
+                throw std::runtime_error("failed to create texture image: the texture format is not supported by the device!");
+            }
+
+            const auto textureCache = TextureCache { TEXTURE_CACHE_DIRECTORY };
+            auto cachedTexture = textureCache.load(filePath);
+            if (cachedTexture.has_value() && TextureFormats::isSampleable(m_engine->getDeviceCapabilities(), cachedTexture->format)) {
+                if (auto cappedTexture = this->getCappedMipChain(*cachedTexture)) {
+                    cachedTexture = std::move(cappedTexture);
+                }
+                if (STREAM_TEXTURE_MIPS && !m_isDeterministic && !this->isSharingAssets()) {
+                    this->createStreamedTextureImage(uploadBatch, std::move(*cachedTexture));
+                } else {
+                    this->createTextureImageFromMipChain(uploadBatch, *cachedTexture);
+                }
+            } else if (GENERATE_MIPMAPS_ON_CPU) {
+                this->beginCpuMipChain(filePath);
+            } else {
+                m_textureDecodePool->enqueue(filePath);
+            }
+        }
+
+        /// @brief Whether the mip chain of a decoded texture of `format` has to be built on the
+        /// CPU, since the device cannot blit it.
+        ///
+        /// @note 8-bit images decode to sRGB and HDR and 16-bit images to half floats, whose
+        /// blit support differs.
+        bool needsCpuMipChain(VkFormat format) const {
+            return GENERATE_MIPMAPS_ON_CPU || (!m_engine->getUploadContext().supportsMipmapBlits(format) && CpuMipmapGenerator::supportsFormat(format));
+        }
+
+        /// @brief Decode the texture and build its mip chain on a worker thread.
+        void beginCpuMipChain(const std::string& filePath) {
+            m_pendingCpuMipChain = std::async(std::launch::async, [filePath]() {
+                auto textureLoader = StbTextureLoader { filePath };
+                const auto stbTextureImage = textureLoader.load();
+                const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(stbTextureImage.width(), stbTextureImage.height())))) + 1;
+
+                return CpuMipmapGenerator::generate(
+                    stbTextureImage.format(),
+                    &stbTextureImage.pixels(),
+                    stbTextureImage.width(),
+                    stbTextureImage.height(),
+                    mipLevels,
+                    CPU_MIP_FILTER
+                );
+            });
+        }
+
+        /// @brief Upload the textures that are still decoding, and a mip chain built on the
+        /// CPU, if one is in flight, once the KTX2 levels still being read have landed.
+        ///
+        /// @note The finished chain is also kept for the texture cache, so it does not need
+        /// to be read back from the GPU.
+        void finishTextureImage(UploadBatch& uploadBatch) {
+            this->waitForTextureReads();
+
+            // Each texture is recorded as soon as it is decoded, while the others keep decoding.
+            while (m_textureDecodePool->hasPending()) {
+                const auto decodedTexture = m_textureDecodePool->waitNext();
+                const auto& stbTextureImage = decodedTexture.image;
+                if (this->needsCpuMipChain(stbTextureImage.format())) {
+                    const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(stbTextureImage.width(), stbTextureImage.height())))) + 1;
+                    this->createTextureImageFromCpuMipChain(uploadBatch, CpuMipmapGenerator::generate(
+                        stbTextureImage.format(),
+                        &stbTextureImage.pixels(),
+                        stbTextureImage.width(),
+                        stbTextureImage.height(),
+                        mipLevels,
+                        CPU_MIP_FILTER
+                    ));
+                } else {
+                    this->createTextureImageFromFile(uploadBatch, stbTextureImage);
+                }
+            }
+
+            if (!m_pendingCpuMipChain.valid()) {
+                return;
+            }
+
+            this->createTextureImageFromCpuMipChain(uploadBatch, m_pendingCpuMipChain.get());
+        }
+
+        /// @brief `mipChain` without the levels larger than the texture size of the
+        /// performance preset, or nothing when every level fits.
+        ///
+        /// @note The smallest level is always kept.
+        std::optional<TextureCacheEntry> getCappedMipChain(const TextureCacheEntry& mipChain) const {
+            if (!m_performancePreset) {
+                return std::nullopt;
+            }
+
+            auto firstLevel = size_t { 0 };
+            while (firstLevel + 1 < mipChain.levels.size()
+                && std::max(mipChain.levels[firstLevel].width, mipChain.levels[firstLevel].height) > m_performancePreset->maxTextureSize) {
+                firstLevel++;
+            }
+            if (firstLevel == 0) {
+                return std::nullopt;
+            }
+
+            const auto dataOffset = mipChain.levels[firstLevel].offset;
+            auto cappedMipChain = TextureCacheEntry {
+                .format = mipChain.format,
+                .width = mipChain.levels[firstLevel].width,
+                .height = mipChain.levels[firstLevel].height,
+                .levels = { mipChain.levels.begin() + static_cast<ptrdiff_t>(firstLevel), mipChain.levels.end() },
+                .data = { mipChain.data.begin() + static_cast<ptrdiff_t>(dataOffset), mipChain.data.end() },
+            };
+            for (auto& level : cappedMipChain.levels) {
+                level.offset -= dataOffset;
+            }
+
+            return cappedMipChain;
+        }
+
+        /// @brief Upload a mip chain built on the CPU, and keep it for the texture cache, so
+        /// that it does not need to be read back from the GPU.
+        ///
+        /// @note The cache keeps the whole chain, whatever the performance preset uploads.
+        void createTextureImageFromCpuMipChain(UploadBatch& uploadBatch, TextureCacheEntry mipChain) {
+            const auto cappedMipChain = this->getCappedMipChain(mipChain);
+            const auto& uploadedMipChain = cappedMipChain ? *cappedMipChain : mipChain;
+            if (STREAM_TEXTURE_MIPS && !m_isDeterministic && !this->isSharingAssets()) {
+                this->createStreamedTextureImage(uploadBatch, TextureCacheEntry { uploadedMipChain });
+            } else {
+                this->createTextureImageFromMipChain(uploadBatch, uploadedMipChain);
+            }
+
+            m_pendingTextureCacheEntry = std::move(mipChain);
+        }
+
+        /// @brief Read and decode a texture on a worker thread, down the same path through
+        /// the KTX2 file, the texture cache, and the source image that `createTextureImage`
+        /// takes.
+        ///
+        /// @note This only reads what the device supports, so it runs next to the frame loop.
+        std::shared_ptr<PreparedTexture> prepareTexture(const std::string& filePath) const {
+            auto preparedTexture = std::make_shared<PreparedTexture>();
+            const auto sourcePath = std::filesystem::path { filePath };
+            const auto compressedFilePath = std::filesystem::path { sourcePath }.replace_extension(".ktx2").string();
+            if (AssetFile::exists(compressedFilePath)) {
+                preparedTexture->filePath = compressedFilePath;
+                auto textureLoader = std::make_unique<Ktx2TextureLoader>(preparedTexture->filePath);
+                auto ktx2TextureImage = textureLoader->load();
+                if (this->isKtx2TextureSupported(ktx2TextureImage)) {
+                    preparedTexture->ktx2TextureLoader = std::move(textureLoader);
+                    preparedTexture->ktx2TextureImage = std::move(ktx2TextureImage);
+
+                    return preparedTexture;
+                }
+
+                if (ktx2TextureImage.isBasisUniversal()) {
+                    fmt::println(std::cerr, "{} holds a Basis Universal texture, which cannot be transcoded; falling back to RGBA8", compressedFilePath);
+                } else {
+                    fmt::println(std::cerr, "Texture format of {} is not supported by the device; falling back to RGBA8", compressedFilePath);
+                }
+            }
+
+            if (sourcePath.extension() == ".ktx2") {
+                throw std::runtime_error("failed to create texture image: the texture format is not supported by the device!");
+            }
+
+            preparedTexture->filePath = filePath;
+            const auto textureCache = TextureCache { TEXTURE_CACHE_DIRECTORY };
+            auto cachedTexture = textureCache.load(filePath);
+            if (cachedTexture.has_value() && TextureFormats::isSampleable(m_engine->getDeviceCapabilities(), cachedTexture->format)) {
+                preparedTexture->mipChain = std::move(cachedTexture);
+                preparedTexture->isMipChainCached = true;
+
+                return preparedTexture;
+            }
+
+            auto textureLoader = StbTextureLoader { filePath };
+            auto stbTextureImage = textureLoader.load();
+            if (this->needsCpuMipChain(stbTextureImage.format())) {
+                const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(stbTextureImage.width(), stbTextureImage.height())))) + 1;
+                preparedTexture->mipChain = CpuMipmapGenerator::generate(
+                    stbTextureImage.format(),
+                    &stbTextureImage.pixels(),
+                    stbTextureImage.width(),
+                    stbTextureImage.height(),
+                    mipLevels,
+                    CPU_MIP_FILTER
+                );
+            } else {
+                preparedTexture->stbTextureImage = std::move(stbTextureImage);
+            }
+
+            return preparedTexture;
+        }
+
+        /// @brief Record the upload of a texture a worker prepared, the way
+        /// `createTextureImage` and `finishTextureImage` record one loaded at startup.
+        void recordPreparedTexture(UploadBatch& uploadBatch, PreparedTexture& preparedTexture) {
+            if (preparedTexture.ktx2TextureLoader != nullptr) {
+                this->createTextureImageFromKtx2(uploadBatch, *preparedTexture.ktx2TextureLoader, *preparedTexture.ktx2TextureImage);
+            } else if (preparedTexture.isMipChainCached) {
+                if (auto cappedMipChain = this->getCappedMipChain(*preparedTexture.mipChain)) {
+                    preparedTexture.mipChain = std::move(cappedMipChain);
+                }
+                if (STREAM_TEXTURE_MIPS) {
+                    this->createStreamedTextureImage(uploadBatch, std::move(*preparedTexture.mipChain));
+                } else {
+                    this->createTextureImageFromMipChain(uploadBatch, *preparedTexture.mipChain);
+                }
+            } else if (preparedTexture.mipChain.has_value()) {
+                this->createTextureImageFromCpuMipChain(uploadBatch, std::move(*preparedTexture.mipChain));
+            } else if (SLICE_STREAMED_MIP_GENERATION) {
+                this->createSlicedTextureImageFromFile(uploadBatch, *preparedTexture.stbTextureImage);
+            } else {
+                this->createTextureImageFromFile(uploadBatch, *preparedTexture.stbTextureImage);
+            }
+        }
+
+        /// @brief Load the texture on the workers of the asset streamer, and publish it
+        /// between frames once it is prepared.
+        void requestTextureAsset(const std::string& filePath) {
+            m_assetStreamer->request(MODEL_TEXTURE_PRIORITY, [this, filePath]() {
+                auto preparedTexture = this->prepareTexture(filePath);
+                const auto byteSize = [&preparedTexture]() -> size_t {
+                    if (preparedTexture->ktx2TextureImage.has_value()) {
+                        return static_cast<size_t>(preparedTexture->ktx2TextureImage->dataSize());
+                    } else if (preparedTexture->mipChain.has_value()) {
+                        return preparedTexture->mipChain->data.size();
+                    } else {
+                        const auto& stbTextureImage = *preparedTexture->stbTextureImage;
+
+                        const auto formatInfo = *TextureFormats::getInfo(stbTextureImage.format());
+
+                        return static_cast<size_t>(formatInfo.getLevelSize(stbTextureImage.width(), stbTextureImage.height()));
+                    }
+                }();
+
+                return PreparedAsset {
+                    .byteSize = byteSize,
+                    .publish = [this, preparedTexture]() { this->publishTexture(*preparedTexture); },
+                };
+            });
+        }
+
+        /// @brief Record and submit the upload of a streamed texture in a batch of its own.
+        ///
+        /// @note The texture table holds the placeholder until the upload has finished. The
+        /// batch takes the profiler slot of the startup uploads, which were resolved before
+        /// the first frame.
+        void publishTexture(PreparedTexture& preparedTexture) {
+            auto& uploadContext = m_engine->getUploadContext();
+            auto uploadBatch = uploadContext.beginBatch();
+            const auto gpuProfilerUploadFrame = MAX_FRAMES_IN_FLIGHT;
+            if (m_gpuProfiler) {
+                m_gpuProfiler->resetFrame(uploadBatch.getCommandBuffer(), gpuProfilerUploadFrame);
+            }
+            const auto uploadScope = this->beginGpuScope(uploadBatch.getCommandBuffer(), "uploads");
+            this->recordPreparedTexture(uploadBatch, preparedTexture);
+            this->waitForTextureReads();
+            this->endGpuScope(uploadBatch.getCommandBuffer(), uploadScope);
+            m_pendingTextureUploadSize = this->getTimedUploadSize(uploadBatch);
+            m_pendingTextureUploadValue = uploadContext.submit(uploadBatch);
+            if (m_gpuProfiler) {
+                m_gpuProfiler->submitFrame(gpuProfilerUploadFrame);
+            }
+
+            this->createTextureImageView();
+            this->createTextureSampler();
+        }
+
+        /// @brief The bytes an upload batch stages, when the GPU time of its "uploads" scope
+        /// times its copies, or zero.
+        ///
+        /// @note With a dedicated transfer queue, the copies run on a command buffer of
+        /// their own before the timed one starts, so those batches are not timed.
+        VkDeviceSize getTimedUploadSize(const UploadBatch& uploadBatch) const {
+            return uploadBatch.hasOwnershipTransfer() ? 0 : uploadBatch.getStagedSize();
+        }
+
+        /// @brief Take the GPU time of the upload batch just resolved in the upload slot of
+        /// the profiler into the transfer throughput of the upload scheduler.
+        ///
+        /// @note The scope also times the mip generation recorded with the copies, so the
+        /// throughput errs on the low side, which only ever shrinks the budget.
+        void recordUploadThroughput(VkDeviceSize uploadSize) {
+            const auto uploadMilliseconds = m_gpuProfiler->getLatestMilliseconds("uploads");
+            if (uploadMilliseconds.has_value()) {
+                m_uploadScheduler->recordTransfer(uploadSize, *uploadMilliseconds);
+            }
+        }
+
+        /// @brief Publish the assets the workers have prepared, and swap the streamed
+        /// texture in for the placeholder once its upload has finished.
+        ///
+        /// @note Must be called between frames, since publishing records and submits
+        /// uploads. The workers are stopped once nothing is left to stream.
+        void updateAssetStreaming() {
+            if (m_assetStreamer == nullptr) {
+                return;
+            }
+
+            // Assets are published whole, so an asset is only held back once others have
+            // taken the budget of the frame.
+            m_assetStreamer->publishReady([this](size_t byteSize) {
+                return m_uploadScheduler->tryReserve(static_cast<VkDeviceSize>(byteSize), 1);
+            });
+            if (!m_pendingTextureUploadValue.has_value() || !m_engine->getUploadContext().isComplete(*m_pendingTextureUploadValue)) {
+                return;
+            }
+
+            if (m_gpuProfiler) {
+                m_gpuProfiler->resolveFrame(MAX_FRAMES_IN_FLIGHT);
+                this->recordUploadThroughput(m_pendingTextureUploadSize);
+            }
+            m_pendingTextureUploadValue.reset();
+            m_isTextureResident = true;
+            this->storeTextureCache(TEXTURE_PATH);
+            if (!m_assetStreamer->hasPending()) {
+                m_assetStreamer.reset();
+            }
+        }
+
+        /// @brief Upload a single mid grey texel for the texture table to hold while the
+        /// texture of the model streams in.
+        void createPlaceholderTexture(UploadBatch& uploadBatch) {
+            const auto texel = std::array<uint8_t, 4> { 128, 128, 128, 255 };
+            auto [textureImage, textureImageAllocation] = m_engine->createImage(
+                1,
+                1,
+                1,
+                VK_SAMPLE_COUNT_1_BIT,
+                VK_FORMAT_R8G8B8A8_SRGB,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+
+            const auto stagingSlice = uploadBatch.stage(texel.data(), texel.size());
+            uploadBatch.transitionImageLayout(
+                textureImage,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1
+            );
+            uploadBatch.copyBufferToImage(stagingSlice, textureImage, 1, 1);
+            uploadBatch.transitionImageLayout(
+                textureImage,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                1
+            );
+
+            const auto samplerInfo = VkSamplerCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                .magFilter = VK_FILTER_NEAREST,
+                .minFilter = VK_FILTER_NEAREST,
+                .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+                .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                .mipLodBias = 0.0f,
+                .anisotropyEnable = VK_FALSE,
+                .maxAnisotropy = 1.0f,
+                .compareEnable = VK_FALSE,
+                .compareOp = VK_COMPARE_OP_ALWAYS,
+                .minLod = 0.0f,
+                .maxLod = 0.0f,
+                .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+                .unnormalizedCoordinates = VK_FALSE,
+            };
+            const auto textureSampler = m_engine->getSamplerCache().getSampler(samplerInfo);
+
+            m_placeholderTextureImage = textureImage;
+            m_placeholderTextureImageAllocation = textureImageAllocation;
+            m_placeholderTextureImageView = this->createImageView(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+            m_placeholderTextureSampler = textureSampler;
+        }
+
+        /// @brief Where every texture of the stress scene is packed, or nothing for any of
+        /// them where `PACK_STRESS_TEXTURES` is off or their extent is not a power of two.
+        TexturePacking packStressTextures() const {
+            const auto& options = *m_stressSceneOptions;
+            if (!PACK_STRESS_TEXTURES || !std::has_single_bit(options.textureSize)) {
+                return TexturePacking {
+                    .pages = {},
+                    .placements = std::vector<std::optional<TexturePlacement>>(options.textureCount),
+                };
+            }
+
+            const auto source = PackedTextureSource {
+                .format = VK_FORMAT_R8G8B8A8_SRGB,
+                .width = options.textureSize,
+                .height = options.textureSize,
+            };
+            const auto sources = std::vector<PackedTextureSource>(options.textureCount, source);
+            auto settings = TexturePackerSettings {};
+            settings.maxLayerCount = std::min(settings.maxLayerCount, m_engine->getDeviceCapabilities().getLimits().maxImageArrayLayers);
+
+            return TexturePacker::pack(sources, settings);
+        }
+
+        /// @brief Generate every texture of the stress scene on the job system, upload them,
+        /// and create the sampler of every filter its materials take.
+        ///
+        /// @note The textures all have the same extent, so one sampler per filter serves them.
+        /// The packed textures are written straight into the first level of their layer, and
+        /// the mips of every page are generated together, so their barriers merge into one
+        /// per level. The rest get their mip chains on the CPU and an image each.
+        void createStressTextures(UploadBatch& uploadBatch) {
+            CPU_PROFILE_ZONE("generate stress textures");
+            const auto& options = *m_stressSceneOptions;
+            const auto packing = this->packStressTextures();
+            auto pageTexels = std::vector<std::vector<uint8_t>>(packing.pages.size());
+            for (size_t i = 0; i < packing.pages.size(); i++) {
+                pageTexels[i].resize(TexturePacker::getLayerSize(packing.pages[i]) * packing.pages[i].layerCount);
+            }
+
+            // Every packed texture writes a layer of its own, so the jobs never share texels.
+            auto mipChains = std::vector<TextureCacheEntry>(options.textureCount);
+            m_jobSystem->parallelFor(mipChains.size(), 1, [&options, &packing, &pageTexels, &mipChains](size_t i) {
+                const auto texture = static_cast<uint32_t>(i);
+                const auto& placement = packing.placements[i];
+                if (!placement.has_value()) {
+                    mipChains[i] = StressSceneGenerator::generateTexture(options, texture);
+                    return;
+                }
+
+                const auto source = PackedTextureSource {
+                    .format = VK_FORMAT_R8G8B8A8_SRGB,
+                    .width = options.textureSize,
+                    .height = options.textureSize,
+                };
+                const auto pixels = StressSceneGenerator::generateTexturePixels(options, texture);
+                TexturePacker::copyLayer(packing.pages[placement->page], *placement, source, pixels.data(), pageTexels[placement->page].data());
+            });
+
+            auto& uploadContext = m_engine->getUploadContext();
+            auto mipmapTargets = std::vector<MipmapTarget> {};
+            m_stressTexturePages.reserve(packing.pages.size());
+            for (size_t i = 0; i < packing.pages.size(); i++) {
+                const auto& page = packing.pages[i];
+                auto [pageImage, pageImageAllocation] = m_engine->createImage(
+                    page.width,
+                    page.height,
+                    page.mipLevels,
+                    VK_SAMPLE_COUNT_1_BIT,
+                    page.format,
+                    VK_IMAGE_TILING_OPTIMAL,
+                    uploadContext.getMipmapImageUsage(page.format) | VK_IMAGE_USAGE_SAMPLED_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    uploadContext.getMipmapImageCreateFlags(page.format),
+                    page.layerCount
+                );
+
+                const auto stagingSlice = uploadBatch.stage(pageTexels[i].data(), pageTexels[i].size());
+                uploadBatch.transitionImageLayout(pageImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, page.mipLevels, page.layerCount);
+                uploadBatch.copyBufferToImage(stagingSlice, pageImage, page.width, page.height, 1, page.layerCount);
+                mipmapTargets.push_back(MipmapTarget {
+                    .image = pageImage,
+                    .format = page.format,
+                    .width = page.width,
+                    .height = page.height,
+                    .mipLevels = page.mipLevels,
+                    .layerCount = page.layerCount,
+                });
+
+                m_stressTexturePages.push_back(StressTexturePage {
+                    .image = pageImage,
+                    .allocation = pageImageAllocation,
+                });
+            }
+            if (!mipmapTargets.empty()) {
+                uploadBatch.generateMipmaps(mipmapTargets);
+            }
+
+            m_stressTextures.reserve(mipChains.size());
+            for (uint32_t i = 0; i < options.textureCount; i++) {
+                const auto& placement = packing.placements[i];
+                if (placement.has_value()) {
+                    const auto& page = packing.pages[placement->page];
+                    m_stressTextures.push_back(StressTexture {
+                        .image = VK_NULL_HANDLE,
+                        .allocation = {},
+                        .imageView = this->createImageView(
+                            m_stressTexturePages[placement->page].image,
+                            page.format,
+                            VK_IMAGE_ASPECT_COLOR_BIT,
+                            page.mipLevels,
+                            1,
+                            placement->layer
+                        ),
+                    });
+                    continue;
+                }
+
+                const auto& mipChain = mipChains[i];
+                const auto mipLevels = static_cast<uint32_t>(mipChain.levels.size());
+                auto [textureImage, textureImageAllocation] = m_engine->createImage(
+                    mipChain.width,
+                    mipChain.height,
+                    mipLevels,
+                    VK_SAMPLE_COUNT_1_BIT,
+                    mipChain.format,
+                    VK_IMAGE_TILING_OPTIMAL,
+                    VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                );
+
+                const auto stagingSlice = uploadBatch.stage(mipChain.data.data(), mipChain.data.size());
+                const auto copyRegions = this->createMipLevelCopyRegions(mipChain.levels);
+                uploadBatch.transitionImageLayout(
+                    textureImage,
+                    VK_IMAGE_LAYOUT_UNDEFINED,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    mipLevels
+                );
+                uploadBatch.copyBufferToImage(stagingSlice, textureImage, copyRegions);
+                uploadBatch.transitionImageLayout(
+                    textureImage,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    mipLevels
+                );
+
+                m_stressTextures.push_back(StressTexture {
+                    .image = textureImage,
+                    .allocation = textureImageAllocation,
+                    .imageView = this->createImageView(textureImage, mipChain.format, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels),
+                });
+            }
+
+            this->createStressSamplers();
+        }
+
+        /// @brief Take the sampler of every filter the materials of the stress scene take
+        /// from the sampler cache, filtered as the policy of the filter asks.
+        ///
+        /// @note The LOD range is the whole of every texture, since they all have the same
+        /// extent.
+        void createStressSamplers() {
+            auto& samplerCache = m_engine->getSamplerCache();
+            for (size_t i = 0; i < m_stressSamplers.size(); i++) {
+                const auto filter = static_cast<StressFilter>(i);
+                const auto isNearest = filter == StressFilter::Nearest;
+                const auto samplerInfo = VkSamplerCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                    .magFilter = isNearest ? VK_FILTER_NEAREST : VK_FILTER_LINEAR,
+                    .minFilter = isNearest ? VK_FILTER_NEAREST : VK_FILTER_LINEAR,
+                    .mipmapMode = isNearest ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR,
+                    .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                    .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                    .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                    .mipLodBias = 0.0f,
+                    .compareEnable = VK_FALSE,
+                    .compareOp = VK_COMPARE_OP_ALWAYS,
+                    .minLod = 0.0f,
+                    .maxLod = VK_LOD_CLAMP_NONE,
+                    .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+                    .unnormalizedCoordinates = VK_FALSE,
+                };
+                m_stressSamplers[i] = samplerCache.getSampler(samplerInfo, STRESS_SAMPLER_POLICIES[i]);
+            }
+        }
+
+        bool isKtx2TextureSupported(const Ktx2TextureImage& ktx2TextureImage) const {
+            const auto formatInfo = TextureFormats::getInfo(ktx2TextureImage.format());
+            if (!formatInfo.has_value()) {
+                return false;
+            }
+
+            // Mip levels cannot be generated for block-compressed formats.
+            if (formatInfo->isCompressed() && ktx2TextureImage.requiresMipGeneration()) {
+                return false;
+            }
+
+            return TextureFormats::isSampleable(m_engine->getDeviceCapabilities(), ktx2TextureImage.format());
+        }
+
+        /// @brief Upload every level stored in a KTX2 file without decoding it.
+        ///
+        /// @note Mip generation only runs when the file asks for it by storing no levels
+        /// beyond level 0.
+        void createTextureImageFromKtx2(UploadBatch& uploadBatch, Ktx2TextureLoader& textureLoader, const Ktx2TextureImage& ktx2TextureImage) {
+            const auto format = ktx2TextureImage.format();
+            const auto& uploadContext = m_engine->getUploadContext();
+            const auto mipLevels = [&ktx2TextureImage]() -> uint32_t {
+                if (ktx2TextureImage.requiresMipGeneration()) {
+                    return static_cast<uint32_t>(std::floor(std::log2(std::max(ktx2TextureImage.width(), ktx2TextureImage.height())))) + 1;
+                } else {
+                    return static_cast<uint32_t>(ktx2TextureImage.levels().size());
+                }
+            }();
+            // Levels that are all in the file, and not compressed by the asset archive, are
+            // copied to the image from the host.
+            auto* hostImageCopier = this->getHostImageCopier(format);
+            if (ktx2TextureImage.requiresMipGeneration() || (m_engine->getGpuDecompressor() != nullptr && textureLoader.getCompressedEntry().has_value())) {
+                hostImageCopier = nullptr;
+            }
+            const auto [usage, flags] = [&ktx2TextureImage, &uploadContext, hostImageCopier, format]() -> std::tuple<VkImageUsageFlags, VkImageCreateFlags> {
+                if (ktx2TextureImage.requiresMipGeneration()) {
+                    return std::make_tuple(
+                        uploadContext.getMipmapImageUsage(format) | VK_IMAGE_USAGE_SAMPLED_BIT,
+                        uploadContext.getMipmapImageCreateFlags(format)
+                    );
+                } else if (hostImageCopier != nullptr) {
+                    return std::make_tuple(
+                        hostImageCopier->getRequiredImageUsage() | VK_IMAGE_USAGE_SAMPLED_BIT,
+                        0
+                    );
+                } else {
+                    return std::make_tuple(
+                        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                        0
+                    );
+                }
+            }();
+
+            auto [textureImage, textureImageAllocation] = m_engine->createImage(
+                ktx2TextureImage.width(),
+                ktx2TextureImage.height(),
+                mipLevels,
+                VK_SAMPLE_COUNT_1_BIT,
+                format,
+                VK_IMAGE_TILING_OPTIMAL,
+                this->getTextureImageUsage(usage),
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                flags
+            );
+
+            auto copyRegions = std::vector<VkBufferImageCopy> {};
+            copyRegions.reserve(ktx2TextureImage.levels().size());
+            for (uint32_t i = 0; i < ktx2TextureImage.levels().size(); i++) {
+                const auto& level = ktx2TextureImage.levels()[i];
+                copyRegions.push_back(this->createMipLevelCopyRegion(i, level.offset, level.width, level.height));
+            }
+
+            if (hostImageCopier != nullptr) {
+                // The reader schedules the copies on the job system once the levels have
+                // landed, so they do not hold up recording the rest of the batch.
+                auto levelData = std::make_shared<std::vector<char>>(ktx2TextureImage.dataSize());
+                auto hostCopy = std::make_shared<std::promise<JobHandle>>();
+                m_pendingHostCopies.push_back(hostCopy->get_future());
+                textureLoader.loadData(
+                    ktx2TextureImage,
+                    levelData->data(),
+                    m_fileReader.get(),
+                    [this, hostImageCopier, textureImage, mipLevels, levelData, copyRegions, hostCopy](std::exception_ptr error) {
+                        if (error) {
+                            hostCopy->set_exception(error);
+
+                            return;
+                        }
+
+                        hostCopy->set_value(m_jobSystem->schedule([this, hostImageCopier, textureImage, mipLevels, levelData, copyRegions]() {
+                            this->copyTextureLevelsFromHost(*hostImageCopier, textureImage, mipLevels, levelData->data(), copyRegions);
+                        }));
+                    }
+                );
+            } else if (m_engine->getGpuDecompressor() != nullptr && textureLoader.getCompressedEntry().has_value()) {
+                this->decompressKtx2Levels(uploadBatch, textureLoader, ktx2TextureImage, textureImage, mipLevels);
+            } else {
+                // The level data is read from the file straight into the staging ring.
+                // The copies are recorded while the reads are in flight, since nothing runs
+                // them before the batch is submitted.
+                const auto stagingSlice = uploadBatch.reserve(ktx2TextureImage.dataSize());
+                this->trackTextureRead(textureLoader.loadData(ktx2TextureImage, stagingSlice.mappedData, m_fileReader.get()));
+                uploadBatch.transitionImageLayout(
+                    textureImage,
+                    VK_IMAGE_LAYOUT_UNDEFINED,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    mipLevels
+                );
+                uploadBatch.copyBufferToImage(stagingSlice, textureImage, copyRegions);
+            }
+            if (ktx2TextureImage.requiresMipGeneration()) {
+                // Transitioned to `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL` while generating mipmaps.
+                const auto mipScope = this->beginGpuScope(uploadBatch.getCommandBuffer(), "mip generation");
+                uploadBatch.generateMipmaps(textureImage, format, ktx2TextureImage.width(), ktx2TextureImage.height(), mipLevels);
+                this->endGpuScope(uploadBatch.getCommandBuffer(), mipScope);
+            } else if (hostImageCopier == nullptr) {
+                uploadBatch.transitionImageLayout(
+                    textureImage,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    mipLevels
+                );
+            }
+
+            m_textureImage = textureImage;
+            m_textureImageAllocation = textureImageAllocation;
+            m_textureFormat = format;
+            m_mipLevels = mipLevels;
+            m_textureExtent = VkExtent2D { ktx2TextureImage.width(), ktx2TextureImage.height() };
+        }
+
+        /// @brief Upload the stored blocks of a KTX2 file that the asset archive compressed,
+        /// and expand them into the levels of `textureImage` on the GPU.
+        ///
+        /// @note The compressed blocks are all that goes through the staging ring. The whole
+        /// file is expanded into a device local buffer, and the levels are copied into the
+        /// image from their offsets in the file, which KTX2 keeps aligned to the texel block
+        /// size. Every level is left in the transfer destination layout, like after a copy
+        /// from staging. The decompression and the copy run on the graphics queue, so the
+        /// image never changes queue families.
+        void decompressKtx2Levels(
+            UploadBatch& uploadBatch,
+            Ktx2TextureLoader& textureLoader,
+            const Ktx2TextureImage& ktx2TextureImage,
+            VkImage textureImage,
+            uint32_t mipLevels
+        ) {
+            auto* gpuDecompressor = m_engine->getGpuDecompressor();
+            const auto& compressedEntry = *textureLoader.getCompressedEntry();
+            const auto stagingSlice = uploadBatch.reserve(
+                GpuDecompressor::getRangeSize(compressedEntry.storedSize),
+                gpuDecompressor->getSourceAlignment()
+            );
+            this->trackTextureRead(textureLoader.loadCompressedData(stagingSlice.mappedData, m_fileReader.get()));
+
+            const auto [contentsBuffer, contentsBufferAllocation] = m_engine->createBuffer(
+                GpuDecompressor::getRangeSize(compressedEntry.size),
+                gpuDecompressor->getRequiredBufferUsage(),
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+
+            auto copyRegions = std::vector<VkBufferImageCopy> {};
+            copyRegions.reserve(ktx2TextureImage.levels().size());
+            for (uint32_t i = 0; i < ktx2TextureImage.levels().size(); i++) {
+                const auto& level = ktx2TextureImage.levels()[i];
+                copyRegions.push_back(this->createMipLevelCopyRegion(i, level.fileOffset, level.width, level.height));
+            }
+
+            const auto decompressionTarget = DecompressionTarget {
+                .sourceBuffer = stagingSlice.buffer,
+                .sourceOffset = stagingSlice.offset,
+                .sourceSize = compressedEntry.storedSize,
+                .destinationBuffer = contentsBuffer,
+                .size = compressedEntry.size,
+                .blockSize = AssetArchive::COMPRESSED_BLOCK_SIZE,
+                .destinationImage = textureImage,
+                .mipLevels = mipLevels,
+                .regions = copyRegions,
+            };
+            const auto decompressionScope = this->beginGpuScope(uploadBatch.getCommandBuffer(), "asset decompression");
+            const auto resources = gpuDecompressor->record(uploadBatch.getCommandBuffer(), decompressionTarget);
+            this->endGpuScope(uploadBatch.getCommandBuffer(), decompressionScope);
+
+            uploadBatch.deferDestruction([this, gpuDecompressor, resources, contentsBuffer, contentsBufferAllocation]() {
+                gpuDecompressor->release(resources);
+                m_engine->destroyBuffer(contentsBuffer, contentsBufferAllocation);
+            });
+        }
+
+        /// @brief Hold the batch being recorded back until `read` has landed, if the read is
+        /// still in flight.
+        void trackTextureRead(AsyncReadHandle read) {
+            if (read != nullptr) {
+                m_pendingTextureReads.push_back(std::move(read));
+            }
+        }
+
+        /// @brief Wait for the texture reads the batch being recorded depends on, and the
+        /// host copies they schedule.
+        ///
+        /// @note Must be called before the batch is submitted, since its copies read the
+        /// staging ring the levels land in, and the submit makes the host copies visible.
+        void waitForTextureReads() {
+            for (const auto& read : m_pendingTextureReads) {
+                m_fileReader->wait(read);
+            }
+            m_pendingTextureReads.clear();
+            for (auto& hostCopy : m_pendingHostCopies) {
+                m_jobSystem->wait(hostCopy.get());
+            }
+            m_pendingHostCopies.clear();
+        }
+
+        /// @brief The host image copier, when textures of `format` are copied from the host.
+        HostImageCopier* getHostImageCopier(VkFormat format) const {
+            auto* hostImageCopier = m_engine->getHostImageCopier();
+            if (!USE_HOST_IMAGE_COPY || hostImageCopier == nullptr || !hostImageCopier->supportsFormat(format)) {
+                return nullptr;
+            }
+
+            return hostImageCopier;
+        }
+
+        /// @brief Copy the levels of `data` into `textureImage` from the host, and leave
+        /// the image ready to sample.
+        ///
+        /// @note Every level is copied by a job of its own, so the largest level does not
+        /// hold up the others. Nothing is recorded, and the first submit after the copies
+        /// makes them visible to the GPU.
+        void copyTextureLevelsFromHost(
+            const HostImageCopier& hostImageCopier,
+            VkImage textureImage,
+            uint32_t mipLevels,
+            const void* data,
+            std::span<const VkBufferImageCopy> copyRegions
+        ) {
+            CPU_PROFILE_ZONE("host image copy");
+            hostImageCopier.transitionToShaderRead(textureImage, mipLevels);
+            m_jobSystem->parallelFor(copyRegions.size(), 1, [&hostImageCopier, textureImage, data, copyRegions](size_t i) {
+                hostImageCopier.copyToImage(textureImage, data, copyRegions.subspan(i, 1));
+            });
+        }
+
+        /// @brief Upload a complete mip chain with a single copy and no mip generation.
+        void createTextureImageFromMipChain(UploadBatch& uploadBatch, const TextureCacheEntry& cachedTexture) {
+            const auto mipLevels = static_cast<uint32_t>(cachedTexture.levels.size());
+            auto* hostImageCopier = this->getHostImageCopier(cachedTexture.format);
+            // A chain copied through the staging ring can have regions replaced later, when
+            // its levels can blit one another.
+            const auto isRegionUpdatable = hostImageCopier == nullptr
+                && !TextureFormats::getInfo(cachedTexture.format)->isCompressed()
+                && m_engine->getUploadContext().supportsMipmapBlits(cachedTexture.format);
+            const auto usage = hostImageCopier != nullptr
+                ? hostImageCopier->getRequiredImageUsage() | VK_IMAGE_USAGE_SAMPLED_BIT
+                : VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (isRegionUpdatable ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0);
+            auto [textureImage, textureImageAllocation] = m_engine->createImage(
+                cachedTexture.width,
+                cachedTexture.height,
+                mipLevels,
+                VK_SAMPLE_COUNT_1_BIT,
+                cachedTexture.format,
+                VK_IMAGE_TILING_OPTIMAL,
+                this->getTextureImageUsage(usage),
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+
+            if (hostImageCopier != nullptr) {
+                const auto copyRegions = this->createMipLevelCopyRegions(cachedTexture.levels);
+                this->copyTextureLevelsFromHost(*hostImageCopier, textureImage, mipLevels, cachedTexture.data.data(), copyRegions);
+
+                m_textureImage = textureImage;
+                m_textureImageAllocation = textureImageAllocation;
+                m_textureFormat = cachedTexture.format;
+                m_mipLevels = mipLevels;
+                m_textureExtent = VkExtent2D { cachedTexture.width, cachedTexture.height };
+
+                return;
+            }
+
+            const auto stagingSlice = uploadBatch.stage(cachedTexture.data.data(), cachedTexture.data.size());
+            const auto copyRegions = this->createMipLevelCopyRegions(cachedTexture.levels);
+
+            uploadBatch.transitionImageLayout(
+                textureImage,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                mipLevels
+            );
+            uploadBatch.copyBufferToImage(stagingSlice, textureImage, copyRegions);
+            uploadBatch.transitionImageLayout(
+                textureImage,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                mipLevels
+            );
+
+            m_textureImage = textureImage;
+            m_textureImageAllocation = textureImageAllocation;
+            m_textureFormat = cachedTexture.format;
+            m_mipLevels = mipLevels;
+            m_textureExtent = VkExtent2D { cachedTexture.width, cachedTexture.height };
+            m_isTextureRegionUpdatable = isRegionUpdatable;
+        }
+
+        /// @brief Upload the smallest levels of a complete mip chain and stream in the rest
+        /// as the view needs them.
+        void createStreamedTextureImage(UploadBatch& uploadBatch, TextureCacheEntry mipChain) {
+            if (m_useVirtualTexture && VirtualTexture::isFormatSupported(mipChain.format)) {
+                this->createVirtualTexture(uploadBatch, std::move(mipChain));
+
+                return;
+            }
+
+            const auto mipLevels = static_cast<uint32_t>(mipChain.levels.size());
+            const auto format = mipChain.format;
+            const auto usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+            auto textureImageAllocation = GpuAllocation {};
+            auto textureStreamer = std::unique_ptr<TextureStreamer> {};
+            if (USE_SPARSE_TEXTURES && m_engine->supportsSparseTextures(format, usage)) {
+                auto sparseTexture = m_engine->createSparseTexture(
+                    mipChain.width,
+                    mipChain.height,
+                    mipLevels,
+                    format,
+                    usage,
+                    SPARSE_TEXTURE_MEMORY_BUDGET
+                );
+                // The frames in flight can change at runtime, so the streamer holds evicted
+                // levels for as many frames as there can ever be.
+                textureStreamer = std::make_unique<TextureStreamer>(
+                    m_engine->getLogicalDevice(),
+                    m_engine->getUploadContext(),
+                    std::move(sparseTexture),
+                    std::move(mipChain),
+                    MAX_FRAMES_IN_FLIGHT
+                );
+            } else {
+                auto [textureImage, denseImageAllocation] = m_engine->createImage(
+                    mipChain.width,
+                    mipChain.height,
+                    mipLevels,
+                    VK_SAMPLE_COUNT_1_BIT,
+                    format,
+                    VK_IMAGE_TILING_OPTIMAL,
+                    usage,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                );
+                textureImageAllocation = denseImageAllocation;
+                textureStreamer = std::make_unique<TextureStreamer>(
+                    m_engine->getLogicalDevice(),
+                    m_engine->getUploadContext(),
+                    textureImage,
+                    std::move(mipChain)
+                );
+            }
+
+            textureStreamer->beginStreaming(uploadBatch, STREAMING_RESIDENT_LEVEL_COUNT);
+
+            m_textureImage = textureStreamer->getImage();
+            m_textureImageAllocation = textureImageAllocation;
+            m_textureFormat = format;
+            m_mipLevels = mipLevels;
+            m_textureStreamer = std::move(textureStreamer);
+        }
+
+        /// @brief Stream a complete mip chain in as a virtual texture, whose atlas takes the
+        /// place of the model texture, with the levels that fit in a page uploaded first.
+        ///
+        /// @note The frames in flight can change at runtime, so the page table and the
+        /// feedback have a region for as many frames as there can ever be.
+        void createVirtualTexture(UploadBatch& uploadBatch, TextureCacheEntry mipChain) {
+            // The descriptor buffer names each frame's regions by their address.
+            const auto additionalUsage = m_useDescriptorBuffer ? VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT : 0;
+            const auto format = mipChain.format;
+            auto virtualTexture = std::make_unique<VirtualTexture>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_engine->getUploadContext(),
+                std::move(mipChain),
+                VIRTUAL_TEXTURE_ATLAS_TILES_PER_ROW,
+                MAX_FRAMES_IN_FLIGHT,
+                additionalUsage
+            );
+            virtualTexture->beginStreaming(uploadBatch);
+
+            m_textureImage = virtualTexture->getAtlasImage();
+            m_textureImageAllocation = GpuAllocation {};
+            m_textureFormat = format;
+            m_mipLevels = 1;
+            m_virtualTexture = std::move(virtualTexture);
+        }
+
+        /// @brief Upload a decoded texture, generate its mip chain, and read the chain back
+        /// so that the next launch can load it from the texture cache.
+        void createTextureImageFromFile(UploadBatch& uploadBatch, const StbTextureImage& stbTextureImage) {
+            const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(stbTextureImage.width(), stbTextureImage.height())))) + 1;
+            // The loader always expands the image to four channels, whatever the file stores,
+            // but HDR and 16-bit images take more bytes per texel.
+            const auto format = stbTextureImage.format();
+            const auto formatInfo = *TextureFormats::getInfo(format);
+            const auto imageSize = formatInfo.getLevelSize(stbTextureImage.width(), stbTextureImage.height());
+            const auto& uploadContext = m_engine->getUploadContext();
+        
+            auto [textureImage, textureImageAllocation] = m_engine->createImage(
+                stbTextureImage.width(),
+                stbTextureImage.height(),
+                mipLevels,
+                VK_SAMPLE_COUNT_1_BIT,
+                format,
+                VK_IMAGE_TILING_OPTIMAL,
+                this->getTextureImageUsage(uploadContext.getMipmapImageUsage(format) | VK_IMAGE_USAGE_SAMPLED_BIT),
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                uploadContext.getMipmapImageCreateFlags(format)
+            );
+
+            const auto stagingSlice = uploadBatch.stage(&stbTextureImage.pixels(), imageSize);
+
+            uploadBatch.transitionImageLayout(
+                textureImage,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                mipLevels
+            );
+            uploadBatch.copyBufferToImage(
+                stagingSlice,
+                textureImage,
+                static_cast<uint32_t>(stbTextureImage.width()),
+                static_cast<uint32_t>(stbTextureImage.height())
+            );
+            // Transitioned to `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL` while generating mipmaps.
+            // The compute generator only takes 8-bit formats, so half float images fall back to
+            // a blit chain, which filters their linear values as they are.
+            const auto mipmapTarget = MipmapTarget {
+                .image = textureImage,
+                .format = format,
+                .width = stbTextureImage.width(),
+                .height = stbTextureImage.height(),
+                .mipLevels = mipLevels,
+                .filter = MIP_FILTER,
+                .alphaCutoff = MIP_ALPHA_CUTOFF,
+            };
+            const auto mipScope = this->beginGpuScope(uploadBatch.getCommandBuffer(), "mip generation");
+            uploadBatch.generateMipmaps(std::span<const MipmapTarget> { &mipmapTarget, 1 });
+            this->endGpuScope(uploadBatch.getCommandBuffer(), mipScope);
+
+            // The file's own channel count tells whether the alpha the loader expanded to is
+            // real, so opaque images get the smaller BC1 blocks.
+            auto* textureCompressor = m_engine->getTextureCompressor();
+            const auto hasAlpha = stbTextureImage.channels() == 2 || stbTextureImage.channels() == 4;
+            auto compressedFormat = VK_FORMAT_UNDEFINED;
+            if (textureCompressor != nullptr) {
+                compressedFormat = textureCompressor->getCompressedFormat(format, hasAlpha);
+            }
+
+            auto cacheFormat = format;
+            if (compressedFormat != VK_FORMAT_UNDEFINED) {
+                const auto compressedFormatInfo = *TextureFormats::getInfo(compressedFormat);
+                const auto compressedLevels = TextureCache::createLevels(compressedFormatInfo, stbTextureImage.width(), stbTextureImage.height(), mipLevels);
+                const auto blockBufferSize = compressedLevels.back().offset + compressedLevels.back().size;
+                const auto [compressedImage, compressedImageAllocation] = m_engine->createImage(
+                    stbTextureImage.width(),
+                    stbTextureImage.height(),
+                    mipLevels,
+                    VK_SAMPLE_COUNT_1_BIT,
+                    compressedFormat,
+                    VK_IMAGE_TILING_OPTIMAL,
+                    textureCompressor->getRequiredImageUsage() | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                );
+                const auto [blockBuffer, blockBufferAllocation] = m_engine->createBuffer(
+                    blockBufferSize,
+                    textureCompressor->getRequiredBufferUsage(),
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                );
+
+                const auto compressionTarget = CompressionTarget {
+                    .sourceImage = textureImage,
+                    .sourceFormat = format,
+                    .destinationImage = compressedImage,
+                    .destinationFormat = compressedFormat,
+                    .blockBuffer = blockBuffer,
+                    .levels = compressedLevels,
+                };
+                const auto compressionScope = this->beginGpuScope(uploadBatch.getCommandBuffer(), "texture compression");
+                const auto resources = textureCompressor->record(uploadBatch.getCommandBuffer(), compressionTarget);
+                this->endGpuScope(uploadBatch.getCommandBuffer(), compressionScope);
+
+                // The uncompressed chain is only read by the encoder, so it goes with the
+                // block buffer once the batch completes.
+                uploadBatch.deferDestruction([
+                    this,
+                    textureCompressor,
+                    resources,
+                    sourceImage = textureImage,
+                    sourceImageAllocation = textureImageAllocation,
+                    blockBuffer,
+                    blockBufferAllocation
+                ]() {
+                    textureCompressor->release(resources);
+                    m_engine->destroyImage(sourceImage, sourceImageAllocation);
+                    m_engine->destroyBuffer(blockBuffer, blockBufferAllocation);
+                });
+
+                textureImage = compressedImage;
+                textureImageAllocation = compressedImageAllocation;
+                cacheFormat = compressedFormat;
+            }
+
+            auto cacheEntry = TextureCacheEntry {
+                .format = cacheFormat,
+                .width = stbTextureImage.width(),
+                .height = stbTextureImage.height(),
+                .levels = TextureCache::createLevels(*TextureFormats::getInfo(cacheFormat), stbTextureImage.width(), stbTextureImage.height(), mipLevels),
+            };
+            const auto readbackSize = cacheEntry.levels.back().offset + cacheEntry.levels.back().size;
+            const auto [readbackBuffer, readbackBufferAllocation] = m_engine->createBuffer(
+                readbackSize,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+            const auto copyRegions = this->createMipLevelCopyRegions(cacheEntry.levels);
+            uploadBatch.copyImageToBuffer(textureImage, mipLevels, readbackBuffer, copyRegions);
+
+            m_textureImage = textureImage;
+            m_textureImageAllocation = textureImageAllocation;
+            m_textureFormat = cacheFormat;
+            m_mipLevels = mipLevels;
+            m_textureExtent = VkExtent2D { stbTextureImage.width(), stbTextureImage.height() };
+            m_isTextureRegionUpdatable = cacheFormat == format && uploadContext.supportsMipmapBlits(format);
+
+            m_pendingTextureCacheEntry = std::move(cacheEntry);
+            m_textureCacheReadbackBuffer = readbackBuffer;
+            m_textureCacheReadbackAllocation = readbackBufferAllocation;
+        }
+
+        /// @brief Upload level 0 of a texture decoded mid-session, and leave its mip chain to
+        /// a mipmap slicer, which generates it a few levels per frame once the upload is done.
+        ///
+        /// @note The chain is read back for the texture cache once it is complete, but it is
+        /// not compressed, since the encoder would have to wait for the whole chain.
+        void createSlicedTextureImageFromFile(UploadBatch& uploadBatch, const StbTextureImage& stbTextureImage) {
+            const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(stbTextureImage.width(), stbTextureImage.height())))) + 1;
+            const auto format = stbTextureImage.format();
+            const auto formatInfo = *TextureFormats::getInfo(format);
+            const auto imageSize = formatInfo.getLevelSize(stbTextureImage.width(), stbTextureImage.height());
+
+            // The slices are blitted, so the image needs no usage of the compute generator.
+            auto [textureImage, textureImageAllocation] = m_engine->createImage(
+                stbTextureImage.width(),
+                stbTextureImage.height(),
+                mipLevels,
+                VK_SAMPLE_COUNT_1_BIT,
+                format,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+
+            const auto stagingSlice = uploadBatch.stage(&stbTextureImage.pixels(), imageSize);
+
+            uploadBatch.transitionImageLayout(
+                textureImage,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                mipLevels
+            );
+            uploadBatch.copyBufferToImage(
+                stagingSlice,
+                textureImage,
+                static_cast<uint32_t>(stbTextureImage.width()),
+                static_cast<uint32_t>(stbTextureImage.height())
+            );
+
+            const auto mipmapTarget = MipmapTarget {
+                .image = textureImage,
+                .format = format,
+                .width = stbTextureImage.width(),
+                .height = stbTextureImage.height(),
+                .mipLevels = mipLevels,
+            };
+            auto mipmapSlicer = std::make_unique<MipmapSlicer>(m_engine->getUploadContext(), mipmapTarget, MAX_MIP_LEVELS_PER_FRAME);
+            mipmapSlicer->beginSlicing(uploadBatch);
+
+            m_textureImage = textureImage;
+            m_textureImageAllocation = textureImageAllocation;
+            m_textureFormat = format;
+            m_mipLevels = mipLevels;
+            m_textureExtent = VkExtent2D { stbTextureImage.width(), stbTextureImage.height() };
+            // Region updates regenerate the levels below them, so they wait for the chain.
+            m_isTextureRegionUpdatable = false;
+            m_mipmapSlicer = std::move(mipmapSlicer);
+        }
+
+        /// @brief Generate the next levels of a texture decoded mid-session, and once its
+        /// chain is complete, sample all of it and read it back for the texture cache.
+        void updateMipmapSlicing() {
+            auto& uploadContext = m_engine->getUploadContext();
+            if (m_mipmapSlicer != nullptr) {
+                m_mipmapSlicer->update(*m_uploadScheduler);
+                if (!m_mipmapSlicer->isComplete()) {
+                    return;
+                }
+
+                m_mipmapSlicer.reset();
+                m_isTextureRegionUpdatable = uploadContext.supportsMipmapBlits(m_textureFormat);
+                m_pendingTextureCacheReadbackValue = this->readBackTextureCache();
+
+                return;
+            }
+
+            if (m_pendingTextureCacheReadbackValue.has_value() && uploadContext.isComplete(*m_pendingTextureCacheReadbackValue)) {
+                m_pendingTextureCacheReadbackValue.reset();
+                this->storeTextureCache(TEXTURE_PATH);
+            }
+        }
+
+        /// @brief Read the mip chain of the model texture back for the texture cache, in an
+        /// upload batch of its own, and return the timeline value of the batch.
+        uint64_t readBackTextureCache() {
+            auto cacheEntry = TextureCacheEntry {
+                .format = m_textureFormat,
+                .width = m_textureExtent.width,
+                .height = m_textureExtent.height,
+                .levels = TextureCache::createLevels(*TextureFormats::getInfo(m_textureFormat), m_textureExtent.width, m_textureExtent.height, m_mipLevels),
+            };
+            const auto readbackSize = cacheEntry.levels.back().offset + cacheEntry.levels.back().size;
+            const auto [readbackBuffer, readbackBufferAllocation] = m_engine->createBuffer(
+                readbackSize,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+            const auto copyRegions = this->createMipLevelCopyRegions(cacheEntry.levels);
+
+            auto& uploadContext = m_engine->getUploadContext();
+            auto uploadBatch = uploadContext.beginBatch();
+            uploadBatch.copyImageToBuffer(m_textureImage, m_mipLevels, readbackBuffer, copyRegions);
+
+            m_pendingTextureCacheEntry = std::move(cacheEntry);
+            m_textureCacheReadbackBuffer = readbackBuffer;
+            m_textureCacheReadbackAllocation = readbackBufferAllocation;
+
+            return uploadContext.submit(uploadBatch);
+        }
+
+        /// @brief A copy of one tightly packed mip level.
+        ///
+        /// @note For block-compressed formats the buffer holds whole blocks, but the image
+        /// extent is the level's texel extent. Vulkan allows an extent that is not a multiple
+        /// of the block extent only when it reaches the edge of the level, which a full level
+        /// copy always does. The buffer offset must be a multiple of the block size.
+        VkBufferImageCopy createMipLevelCopyRegion(uint32_t mipLevel, VkDeviceSize bufferOffset, uint32_t width, uint32_t height) const {
+            const auto copyRegion = VkBufferImageCopy {
+                .bufferOffset = bufferOffset,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .imageSubresource.mipLevel = mipLevel,
+                .imageSubresource.baseArrayLayer = 0,
+                .imageSubresource.layerCount = 1,
+                .imageOffset = VkOffset3D { 0, 0, 0 },
+                .imageExtent = VkExtent3D { width, height, 1 },
+            };
+
+            return copyRegion;
+        }
+
+        std::vector<VkBufferImageCopy> createMipLevelCopyRegions(const std::vector<TextureCacheLevel>& levels) const {
+            auto copyRegions = std::vector<VkBufferImageCopy> {};
+            copyRegions.reserve(levels.size());
+            for (uint32_t i = 0; i < levels.size(); i++) {
+                copyRegions.push_back(this->createMipLevelCopyRegion(i, levels[i].offset, levels[i].width, levels[i].height));
+            }
+
+            return copyRegions;
+        }
+
+        /// @brief Write the mip chain read back during the upload batch to the texture cache.
+        ///
+        /// @note Must only be called after the upload batch has completed. A failure to
+        /// write the cache is not fatal, the texture is simply rebuilt on the next launch.
+        void storeTextureCache(const std::string& filePath) {
+            if (!m_pendingTextureCacheEntry.has_value()) {
+                return;
+            }
+
+            // Chains generated on the GPU arrive through the readback buffer. Chains
+            // generated on the CPU already carry their data.
+            auto& cacheEntry = *m_pendingTextureCacheEntry;
+            const auto hasReadback = cacheEntry.data.empty();
+            if (hasReadback) {
+                const auto readbackData = static_cast<const uint8_t*>(m_textureCacheReadbackAllocation.mappedData);
+                const auto readbackSize = cacheEntry.levels.back().offset + cacheEntry.levels.back().size;
+                cacheEntry.data.assign(readbackData, readbackData + readbackSize);
+            }
+
+            // Render lanes load the same texture, so only the first one stores it.
+            if (m_laneIndex == 0) {
+                try {
+                    const auto textureCache = TextureCache { TEXTURE_CACHE_DIRECTORY };
+                    textureCache.store(filePath, cacheEntry);
+                } catch (const std::runtime_error& exception) {
+                    fmt::println(std::cerr, "Failed to store texture cache entry for {}: {}", filePath, exception.what());
+                }
+            }
+
+            if (hasReadback) {
+                m_engine->destroyBuffer(m_textureCacheReadbackBuffer, m_textureCacheReadbackAllocation);
+                m_textureCacheReadbackBuffer = VK_NULL_HANDLE;
+            }
+
+            m_pendingTextureCacheEntry.reset();
+        }
+
+        void createTextureImageView() {
+            auto textureImageView = this->createImageView(m_textureImage, m_textureFormat, VK_IMAGE_ASPECT_COLOR_BIT, m_mipLevels);
+
+            m_textureImageView = textureImageView;
+        }
+
+        /// @brief The first level of the model texture that fits the texture size of the
+        /// performance preset, which sampling is clamped to.
+        ///
+        /// @note Chains that are uploaded from the CPU drop the larger levels instead, and
+        /// start at 0.
+        float getTextureMinLod() const {
+            if (!m_performancePreset) {
+                return 0.0f;
+            }
+
+            auto level = uint32_t { 0 };
+            auto size = std::max(m_textureExtent.width, m_textureExtent.height);
+            while (size > m_performancePreset->maxTextureSize && level + 1 < m_mipLevels) {
+                size = std::max(size / 2, 1u);
+                level++;
+            }
+
+            return static_cast<float>(level);
+        }
+
+        /// @brief Take the sampler of the model texture from the sampler cache, filtered as
+        /// `MODEL_TEXTURE_SAMPLER_POLICY` asks.
+        ///
+        /// @note A texture with the same mip count shares the sampler, since `maxLod` is the
+        /// only state particular to the texture, besides the levels the preset leaves out.
+        void createTextureSampler() {
+            auto& samplerCache = m_engine->getSamplerCache();
+            auto samplerPolicy = MODEL_TEXTURE_SAMPLER_POLICY;
+            samplerPolicy.minLod = std::max(samplerPolicy.minLod, this->getTextureMinLod());
+            const auto textureSamplerInfo = VkSamplerCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                .magFilter = VK_FILTER_LINEAR,
+                .minFilter = VK_FILTER_LINEAR,
+                .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+                .unnormalizedCoordinates = VK_FALSE,
+                .compareEnable = VK_FALSE,
+                .compareOp = VK_COMPARE_OP_ALWAYS,
+                .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+                .minLod = 0.0f,
+                .maxLod = static_cast<float>(m_mipLevels),
+                .mipLodBias = 0.0f,
+            };
+            const auto samplerInfo = samplerCache.applyPolicy(textureSamplerInfo, samplerPolicy);
+
+            // The shader filters the atlas of a virtual texture itself, so the sampler only
+            // reads inside the tiles, bilinearly, and never past the edges of the atlas.
+            if (m_virtualTexture != nullptr) {
+                auto atlasSamplerInfo = samplerInfo;
+                atlasSamplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                atlasSamplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                atlasSamplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                atlasSamplerInfo.anisotropyEnable = VK_FALSE;
+                atlasSamplerInfo.maxAnisotropy = 1.0f;
+                atlasSamplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+                atlasSamplerInfo.minLod = 0.0f;
+                atlasSamplerInfo.maxLod = 0.0f;
+                m_textureSampler = samplerCache.getSampler(atlasSamplerInfo);
+
+                return;
+            }
+
+            // A streamed texture clamps sampling to its resident levels instead.
+            if (m_textureStreamer != nullptr) {
+                m_textureStreamer->createSamplers(samplerCache, samplerInfo);
+                m_textureSampler = VK_NULL_HANDLE;
+
+                return;
+            }
+
+            // A texture whose chain is still generating clamps sampling to the finished levels,
+            // and takes the sampler of the whole chain once it is complete.
+            if (m_mipmapSlicer != nullptr) {
+                m_mipmapSlicer->createSamplers(samplerCache, samplerInfo);
+            }
+
+            m_textureSampler = samplerCache.getSampler(samplerInfo);
+        }
+
+        /// @brief The view of the model texture that frames sample, which for a streamed
+        /// texture only reaches the levels that have arrived.
+        VkImageView getTextureImageView() const {
+            if (m_textureStreamer != nullptr) {
+                return m_textureStreamer->getImageView();
+            } else {
+                return m_textureImageView;
+            }
+        }
+
+        VkSampler getTextureSampler() const {
+            if (m_textureStreamer != nullptr) {
+                return m_textureStreamer->getSampler();
+            } else if (m_mipmapSlicer != nullptr) {
+                return m_mipmapSlicer->getSampler();
+            } else {
+                return m_textureSampler;
+            }
+        }
+
+        /// @brief Every texture of the scene, in the order of the global texture table.
+        ///
+        /// @note A material of the stress scene is an entry of its own, of the texture and
+        /// sampler it takes, from `STRESS_MATERIAL_TEXTURE_INDEX` on.
+        std::vector<VkDescriptorImageInfo> getTextureTable() const {
+            auto textureTable = std::vector<VkDescriptorImageInfo> {
+                this->getModelTextureInfo(),
+            };
+            if (m_stressSceneOptions) {
+                for (uint32_t i = 0; i < m_stressSceneOptions->materialCount; i++) {
+                    const auto material = StressSceneGenerator::getMaterial(*m_stressSceneOptions, i);
+                    textureTable.push_back(VkDescriptorImageInfo {
+                        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                        .imageView = m_stressTextures[material.texture].imageView,
+                        .sampler = m_stressSamplers[static_cast<size_t>(material.filter)],
+                    });
+                }
+            }
+
+            return textureTable;
+        }
+
+        /// @brief The entry of the global texture table of the first material the copies of
+        /// the mesh take turns at, by instance index.
+        uint32_t getFirstMaterialIndex() const {
+            return m_stressSceneOptions ? STRESS_MATERIAL_TEXTURE_INDEX : MODEL_TEXTURE_INDEX;
+        }
+
+        uint32_t getMaterialCount() const {
+            return m_stressSceneOptions ? m_stressSceneOptions->materialCount : 1;
+        }
+
+        /// @brief The texture of the model, the dashboard once one has been drawn, or the
+        /// placeholder while the texture is streaming in.
+        VkDescriptorImageInfo getModelTextureInfo() const {
+            if (m_dashboardTexture != nullptr && m_dashboardTexture->getSampledView() != VK_NULL_HANDLE) {
+                return VkDescriptorImageInfo {
+                    .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    .imageView = m_dashboardTexture->getSampledView(),
+                    .sampler = m_dashboardSampler,
+                };
+            }
+
+            if (!m_isTextureResident) {
+                return VkDescriptorImageInfo {
+                    .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    .imageView = m_placeholderTextureImageView,
+                    .sampler = m_placeholderTextureSampler,
+                };
+            }
+
+            return VkDescriptorImageInfo {
+                .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                .imageView = this->getTextureImageView(),
+                .sampler = this->getTextureSampler(),
+            };
+        }
+
+        /// @brief The diameter in pixels of the bounding sphere of the mesh on screen, or
+        /// nothing when the camera is inside the sphere.
+        std::optional<float> estimateProjectedMeshDiameter() const {
+            const auto distance = glm::length(CAMERA_POSITION);
+            if (distance <= m_meshRadius) {
+                return std::nullopt;
+            }
+
+            const auto viewportHeight = static_cast<float>(m_swapChainExtent.height);
+
+            return (m_meshRadius / (distance * std::tan(CAMERA_FIELD_OF_VIEW / 2.0f))) * viewportHeight;
+        }
+
+        /// @brief The level of detail of the mesh its projected size on screen calls for.
+        size_t estimateMeshLodLevel() const {
+            const auto projectedDiameter = this->estimateProjectedMeshDiameter();
+            if (!projectedDiameter.has_value() || *projectedDiameter >= MESH_LOD_FULL_DETAIL_DIAMETER) {
+                return 0;
+            }
+
+            const auto lodCount = m_mesh->lods().size();
+            const auto level = 1 + static_cast<size_t>(std::floor(std::log2(MESH_LOD_FULL_DETAIL_DIAMETER / std::max(*projectedDiameter, 1.0f))));
+
+            return std::min(level, lodCount - 1);
+        }
+
+        /// @brief Pick the level of detail of the mesh by its projected size on screen.
+        ///
+        /// @note A streamed mesh is drawn at the most detailed level that is resident, when
+        /// the one its size calls for has not streamed in yet.
+        size_t selectMeshLodLevel() const {
+            const auto level = this->estimateMeshLodLevel();
+            if (m_geometryStreamer == nullptr) {
+                return level;
+            }
+
+            return std::max(level, size_t { m_geometryStreamer->getResidentLevel() });
+        }
+
+        /// @brief The first index in the geometry pool of the level of detail `level` of the
+        /// mesh, which has to be resident.
+        uint32_t getMeshLodFirstIndex(size_t level) const {
+            if (m_geometryStreamer != nullptr) {
+                return m_geometryStreamer->getFirstIndex(static_cast<uint32_t>(level));
+            }
+
+            return m_meshRange.firstIndex + m_mesh->lods()[level].firstIndex;
+        }
+
+        const MeshLod& selectMeshLod() const {
+            return m_mesh->lods()[this->selectMeshLodLevel()];
+        }
+
+        /// @brief Estimate the most detailed mip level the mesh can show on screen.
+        ///
+        /// @note This assumes the texture is spread over the whole mesh once, and measures the
+        /// mesh by its bounding sphere. One texel per pixel across the projected sphere is
+        /// the level that is needed, and the level above it is requested too so that surfaces
+        /// seen at an angle stay sharp.
+        uint32_t estimateTextureLevel() const {
+            const auto projectedDiameter = this->estimateProjectedMeshDiameter();
+            if (!projectedDiameter.has_value()) {
+                return 0;
+            }
+
+            const auto textureExtent = static_cast<float>(std::max(m_textureStreamer->getWidth(), m_textureStreamer->getHeight()));
+            const auto texelsPerPixel = textureExtent / std::max(*projectedDiameter, 1.0f);
+            const auto level = static_cast<uint32_t>(std::max(std::floor(std::log2(std::max(texelsPerPixel, 1.0f))), 0.0f));
+
+            return level > 0 ? level - 1 : 0;
+        }
+
+        /// @brief The most detailed mip level of the streamed texture the view needs: the one
+        /// the fragment shader last asked for with LOD feedback, or the estimate from the
+        /// projected size of the mesh before any feedback was read back.
+        ///
+        /// @note A texture no fragment sampled needs only its least detailed level, so a
+        /// model out of view hands its detail back. While the dashboard is sampled in place
+        /// of the model texture, the feedback is of the dashboard, and the estimate is used.
+        uint32_t selectStreamedTextureLevel() const {
+            if (!m_useLodFeedback || m_dashboardTexture != nullptr || !m_lodFeedback->hasResults()) {
+                return this->estimateTextureLevel();
+            }
+
+            const auto requestedLevel = m_lodFeedback->getRequestedLevel(MODEL_TEXTURE_INDEX);
+
+            return std::min(requestedLevel.value_or(UINT32_MAX), m_textureStreamer->getMipLevels() - 1);
+        }
+
+        /// @brief The largest share of its budget that any device local heap uses.
+        float getDeviceLocalBudgetPressure() {
+            const auto& allocator = m_engine->getMemoryAllocator();
+            const auto& memoryProperties = allocator.getMemoryProperties();
+            auto pressure = 0.0f;
+            for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+                if (!(memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+                    continue;
+                }
+
+                const auto heapBudget = allocator.getHeapBudget(i);
+                if (heapBudget.budget == 0) {
+                    continue;
+                }
+
+                pressure = std::max(pressure, static_cast<float>(heapBudget.usage) / static_cast<float>(heapBudget.budget));
+            }
+
+            return pressure;
+        }
+
+        /// @brief Query the memory budgets, and trade the detail of the streamed texture for
+        /// memory while a device local heap runs short of its budget.
+        ///
+        /// @note The streamed texture is the only one whose levels come and go, so it is the
+        /// least recently used texture that can give memory back, and the only one evicted.
+        /// Only a sparse texture frees the memory of a level it drops. A dense image stops
+        /// streaming in more detail instead.
+        void updateMemoryBudget() {
+            m_engine->getMemoryAllocator().updateBudgets();
+            if (m_textureStreamer == nullptr || !m_isTextureResident) {
+                return;
+            }
+
+            const auto pressure = this->getDeviceLocalBudgetPressure();
+            if (pressure > MEMORY_BUDGET_EVICTION_THRESHOLD) {
+                m_textureStreamer->releaseEvictedMemory();
+            }
+
+            if (m_memoryBudgetCooldown > 0) {
+                m_memoryBudgetCooldown--;
+
+                return;
+            }
+
+            const auto maxLevelBias = m_textureStreamer->getMipLevels() - 1;
+            if (pressure > MEMORY_BUDGET_EVICTION_THRESHOLD && m_textureLevelBias < maxLevelBias) {
+                m_textureLevelBias++;
+                m_memoryBudgetCooldown = m_framesInFlight;
+            } else if (pressure < MEMORY_BUDGET_RESTORE_THRESHOLD && m_textureLevelBias > 0) {
+                m_textureLevelBias--;
+                m_memoryBudgetCooldown = m_framesInFlight;
+            }
+        }
+
+        /// @brief Stream in the texture levels the view needs, unless streaming is held back
+        /// in the background, and point the texture table of the frame at the model texture
+        /// as it stands: the placeholder until the texture has finished uploading, then the
+        /// sampler for the levels that have arrived.
+        ///
+        /// @note Must be called after the frame has been waited for on the frame timeline,
+        /// since it may update the frame's texture table.
+        void updateTextureStreaming(uint32_t currentFrame) {
+            if (m_textureStreamer != nullptr && m_isTextureResident && !m_isStreamingSuspended) {
+                m_textureStreamer->requestLevel(this->selectStreamedTextureLevel() + m_textureLevelBias);
+                m_textureStreamer->update(*m_uploadScheduler);
+            }
+            if (m_isTextureResident && !m_isStreamingSuspended) {
+                this->updateMipmapSlicing();
+            }
+
+            const auto imageInfo = this->getModelTextureInfo();
+            const auto& tableEntry = m_textureTableEntries[currentFrame];
+            if (tableEntry.imageView == imageInfo.imageView && tableEntry.sampler == imageInfo.sampler) {
+                return;
+            }
+
+            if (m_useDescriptorBuffer) {
+                m_descriptorBuffer->writeCombinedImageSampler(m_textureTableBufferSets[currentFrame], 0, MODEL_TEXTURE_INDEX, imageInfo);
+            } else {
+                const auto descriptorWrite = VkWriteDescriptorSet {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = m_textureTableSets[currentFrame],
+                    .dstBinding = 0,
+                    .dstArrayElement = MODEL_TEXTURE_INDEX,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                    .descriptorCount = 1,
+                    .pImageInfo = &imageInfo,
+                };
+                m_dispatch->vkUpdateDescriptorSets(m_engine->getLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+            }
+
+            m_textureTableEntries[currentFrame] = imageInfo;
+        }
+
+        /// @brief Stream in the level of detail of the mesh that the view needs, and evict the
+        /// finer ones it no longer does.
+        ///
+        /// @note One level is uploaded at a time, in an upload batch of its own, and only when
+        /// the budget of the upload scheduler takes its vertices and indices. Nothing is
+        /// written while a mesh buffer is being moved, since the move copies it as it was.
+        void updateGeometryStreaming() {
+            if (m_geometryStreamer == nullptr) {
+                return;
+            }
+
+            m_geometryStreamer->requestLevel(static_cast<uint32_t>(this->estimateMeshLodLevel()));
+            m_geometryStreamer->update();
+            if (m_pendingBufferMove.has_value()) {
+                return;
+            }
+
+            const auto upload = m_geometryStreamer->getNextUpload();
+            if (!upload.has_value()) {
+                return;
+            }
+
+            // A level whose vertices a coarser level already wrote only copies its indices.
+            const auto vertexSize = SPLIT_VERTEX_STREAMS ?
+                VkDeviceSize { sizeof(GpuVertex::Position) + sizeof(GpuVertex::TexCoord) } :
+                VkDeviceSize { sizeof(GpuVertex) };
+            const auto uploadSize = vertexSize * upload->vertexCount + VkDeviceSize { m_geometryPool->getIndexSize() } * upload->indexCount;
+            const auto vertexCopyCount = upload->vertexCount == 0 ? 0u : (SPLIT_VERTEX_STREAMS ? 2u : 1u);
+            if (!m_uploadScheduler->tryReserve(uploadSize, vertexCopyCount + 1)) {
+                return;
+            }
+
+            auto& uploadContext = m_engine->getUploadContext();
+            auto uploadBatch = uploadContext.beginBatch();
+            this->writeMeshVertices(
+                uploadBatch,
+                m_resourceTable->getBuffer(m_vertexBuffer),
+                m_resourceTable->getAllocation(m_vertexBuffer),
+                upload->firstVertex,
+                upload->vertexCount
+            );
+            this->writeMeshIndices(
+                uploadBatch,
+                m_resourceTable->getBuffer(m_indexBuffer),
+                m_resourceTable->getAllocation(m_indexBuffer),
+                m_mesh->lods()[upload->level].firstIndex,
+                upload->indexCount,
+                upload->firstIndex
+            );
+            m_geometryStreamer->submitUpload(*upload, uploadContext.submit(uploadBatch));
+        }
+
+        /// @brief The settings meshes are imported with, which `meshbake` has to bake with for
+        /// the demo to load its entries.
+        static MeshImportSettings getMeshImportSettings() {
+            return MeshImportSettings {
+                .optimize = OPTIMIZE_MESH,
+                .lodTriangleRatios = GENERATE_MESH_LODS ?
+                    std::vector<float>(MESH_LOD_TRIANGLE_RATIOS.begin(), MESH_LOD_TRIANGLE_RATIOS.end()) :
+                    std::vector<float> {},
+                .buildMeshlets = USE_MESH_SHADERS,
+            };
+        }
+
+        /// @brief Load a mesh through the mesh registry, so a mesh referenced again is
+        /// shared rather than loaded again.
+        ///
+        /// @note The settings hash keys the mesh, so that a mesh imported with other settings
+        /// is another asset.
+        void loadModel(const std::string& filePath) {
+            // Releasing the previous mesh lets the registry cache it before the next one
+            // loads.
+            m_mesh = nullptr;
+            m_meshRegistry->collect();
+
+            const auto meshKey = AssetKey::create(filePath, getMeshImportSettings().getHash());
+            const auto mesh = m_meshRegistry->acquire(meshKey, [this, &filePath]() {
+                auto loadedMesh = this->importMesh(filePath);
+                const auto byteSize = loadedMesh.byteSize();
+
+                return LoadedAsset<Mesh> { .asset = std::move(loadedMesh), .byteSize = byteSize };
+            });
+
+            auto meshRadius = 0.0f;
+            for (const auto& vertex : mesh->vertices()) {
+                meshRadius = std::max(meshRadius, glm::length(vertex.position));
+            }
+
+            m_mesh = mesh;
+            m_meshRadius = meshRadius;
+            m_meshPositionTransform = getPositionDequantizeTransform(*m_mesh);
+        }
+
+        /// @brief Read a mesh from the mesh cache, or import it and store it there.
+        ///
+        /// @note `meshbake` fills the cache ahead of time, so that the demo only maps it.
+        Mesh importMesh(const std::string& filePath) const {
+            const auto meshCache = MeshCache { MESH_CACHE_DIRECTORY };
+            const auto settings = getMeshImportSettings();
+            auto cachedMesh = MeshImporter::loadCached(meshCache, filePath, settings);
+            if (cachedMesh.has_value()) {
+                return std::move(*cachedMesh);
+            }
+
+            auto* jobSystem = PARALLEL_MESH_IMPORT ? m_jobSystem.get() : nullptr;
+            auto importedMesh = MeshImporter::import(filePath, settings, jobSystem);
+            try {
+                MeshImporter::storeCached(meshCache, filePath, settings, importedMesh);
+            } catch (const std::runtime_error& exception) {
+                fmt::println(std::cerr, "Failed to store mesh cache entry for {}: {}", filePath, exception.what());
+            }
+
+            return importedMesh;
+        }
+
+        /// @brief The memory of the mesh buffers, which is host visible too where most of the
+        /// device memory is, so that they are written in place.
+        VkMemoryPropertyFlags getMeshBufferPropertyFlags() const {
+            if (m_engine->getMemoryAllocator().isDeviceMemoryHostVisible()) {
+                return VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            }
+
+            return VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        }
+
+        /// @brief Where to write the contents of a new mesh buffer: the buffer itself where
+        /// its memory is mapped, or else a staging slice the upload batch copies into it.
+        ///
+        /// @note Nothing uses a new buffer yet, and submitting the batch makes host writes
+        /// visible to the device, so writing in place needs no copy and no barrier. Mapped
+        /// device memory is write combined and slow to read, so the data is only ever written.
+        /// Only the `size` bytes at `offset` are staged, so a mesh written into the geometry
+        /// pool stages its own range and not the whole pool.
+        void* getMeshBufferData(UploadBatch& uploadBatch, VkBuffer buffer, const GpuAllocation& allocation, VkDeviceSize size, VkDeviceSize offset = 0) {
+            if (allocation.mappedData != nullptr) {
+                return static_cast<uint8_t*>(allocation.mappedData) + offset;
+            }
+
+            const auto stagingSlice = uploadBatch.reserve(size);
+            uploadBatch.copyBuffer(stagingSlice, buffer, offset);
+
+            return stagingSlice.mappedData;
+        }
+
+        /// @brief Create a mesh buffer, in exported memory when the app hands its assets out,
+        /// or from the owner's memory when it imports them.
+        ///
+        /// @note Shared buffers are device local, so they are written through the staging
+        /// ring, and their memory belongs to the sharing, so the allocation is empty.
+        std::tuple<VkBuffer, GpuAllocation> createMeshBuffer(
+            const std::string& sharedName,
+            VkDeviceSize size,
+            VkBufferUsageFlags usage,
+            VkMemoryPropertyFlags properties
+        ) {
+            if (m_sharedAssetPublisher != nullptr) {
+                return std::make_tuple(m_sharedAssetPublisher->createBuffer(sharedName, size, usage), GpuAllocation {});
+            }
+
+            if (m_sharedAssetImporter != nullptr) {
+                return std::make_tuple(m_sharedAssetImporter->importBuffer(sharedName, size, usage), GpuAllocation {});
+            }
+
+            return m_engine->createBuffer(size, usage, properties);
+        }
+
+        /// @brief Create the geometry pool, and allocate the mesh its range.
+        ///
+        /// @note The pool stores indices of the width the mesh needs. They are relative to
+        /// the base vertex of their mesh, so 16-bit indices only limit how large each mesh
+        /// is, not how many share the pool. A streamed mesh only needs room for its
+        /// coarsest level, and the finer levels stream in as far as the pool has room left.
+        void createGeometryPool() {
+            const auto vertexCount = static_cast<uint32_t>(m_mesh->vertices().size());
+            const auto indexCount = static_cast<uint32_t>(m_mesh->indices().size());
+            const auto& lods = m_mesh->lods();
+            const auto isStreamed = STREAM_MESH_LODS && !m_isDeterministic && !this->isSharingAssets() && lods.size() > 1;
+            const auto residentIndexCount = isStreamed ? lods.back().indexCount : indexCount;
+            m_geometryPool = std::make_unique<GeometryPool>(
+                std::max(GEOMETRY_POOL_VERTEX_CAPACITY, vertexCount),
+                std::max(GEOMETRY_POOL_INDEX_CAPACITY, residentIndexCount),
+                m_mesh->indexType()
+            );
+
+            if (isStreamed) {
+                m_geometryStreamer = std::make_unique<GeometryStreamer>(
+                    m_engine->getUploadContext(),
+                    *m_geometryPool,
+                    lods,
+                    vertexCount,
+                    MAX_FRAMES_IN_FLIGHT
+                );
+                m_initialGeometryUpload = m_geometryStreamer->beginStreaming();
+                m_meshRange = GeometryRange {
+                    .baseVertex = m_geometryStreamer->getBaseVertex(),
+                    .vertexCount = vertexCount,
+                };
+
+                return;
+            }
+
+            const auto meshRange = m_geometryPool->allocate(vertexCount, indexCount);
+            if (!meshRange.has_value()) {
+                throw std::logic_error("the geometry pool is sized to hold the mesh!");
+            }
+
+            m_meshRange = *meshRange;
+        }
+
+        /// @brief Pack `vertexCount` vertices of the mesh, from `firstVertex` on, into their
+        /// place in the vertex range of the mesh.
+        void writeMeshVertices(
+            UploadBatch& uploadBatch,
+            VkBuffer vertexBuffer,
+            const GpuAllocation& vertexBufferAllocation,
+            uint32_t firstVertex,
+            uint32_t vertexCount
+        ) {
+            if (vertexCount == 0) {
+                return;
+            }
+
+            const auto baseVertex = VkDeviceSize { m_meshRange.baseVertex } + firstVertex;
+            const auto writtenVertexCount = VkDeviceSize { vertexCount };
+            if (SPLIT_VERTEX_STREAMS) {
+                auto* positionData = static_cast<uint8_t*>(this->getMeshBufferData(
+                    uploadBatch,
+                    vertexBuffer,
+                    vertexBufferAllocation,
+                    sizeof(GpuVertex::Position) * writtenVertexCount,
+                    sizeof(GpuVertex::Position) * baseVertex
+                ));
+                auto* texCoordData = static_cast<uint8_t*>(this->getMeshBufferData(
+                    uploadBatch,
+                    vertexBuffer,
+                    vertexBufferAllocation,
+                    sizeof(GpuVertex::TexCoord) * writtenVertexCount,
+                    m_vertexStreamOffsets[1] + sizeof(GpuVertex::TexCoord) * baseVertex
+                ));
+                packVertices(
+                    *m_mesh,
+                    firstVertex,
+                    vertexCount,
+                    positionData,
+                    sizeof(GpuVertex::Position),
+                    texCoordData,
+                    sizeof(GpuVertex::TexCoord)
+                );
+            } else {
+                auto* vertexData = static_cast<uint8_t*>(this->getMeshBufferData(
+                    uploadBatch,
+                    vertexBuffer,
+                    vertexBufferAllocation,
+                    sizeof(GpuVertex) * writtenVertexCount,
+                    sizeof(GpuVertex) * baseVertex
+                ));
+                packVertices(
+                    *m_mesh,
+                    firstVertex,
+                    vertexCount,
+                    vertexData + offsetof(GpuVertex, position),
+                    sizeof(GpuVertex),
+                    vertexData + offsetof(GpuVertex, texCoord),
+                    sizeof(GpuVertex)
+                );
+            }
+        }
+
+        /// @brief Write `indexCount` indices of the mesh, from `firstMeshIndex` on, to the
+        /// pool from `firstPoolIndex` on.
+        void writeMeshIndices(
+            UploadBatch& uploadBatch,
+            VkBuffer indexBuffer,
+            const GpuAllocation& indexBufferAllocation,
+            uint32_t firstMeshIndex,
+            uint32_t indexCount,
+            uint32_t firstPoolIndex
+        ) {
+            const auto indexSize = m_geometryPool->getIndexSize();
+            auto* indexData = this->getMeshBufferData(
+                uploadBatch,
+                indexBuffer,
+                indexBufferAllocation,
+                indexSize * indexCount,
+                indexSize * firstPoolIndex
+            );
+            const auto* indices = m_mesh->indices().data() + firstMeshIndex;
+            if (m_geometryPool->getIndexType() == VK_INDEX_TYPE_UINT16) {
+                // Pack straight into place, since every index fits in 16 bits.
+                auto* packedIndices = static_cast<uint16_t*>(indexData);
+                for (size_t i = 0; i < indexCount; i++) {
+                    packedIndices[i] = static_cast<uint16_t>(indices[i]);
+                }
+            } else {
+                std::memcpy(indexData, indices, indexSize * indexCount);
+            }
+        }
+
+        void createVertexBuffer(UploadBatch& uploadBatch) {
+            // Split streams store every position, then every other attribute, in one buffer.
+            // Both streams have room for every vertex of the pool, and the mesh is written to
+            // its range of each.
+            const auto vertexCount = VkDeviceSize { m_geometryPool->getVertexCapacity() };
+            const auto vertexStreamOffsets = [vertexCount]() -> std::vector<VkDeviceSize> {
+                if (SPLIT_VERTEX_STREAMS) {
+                    const auto positionStreamSize = sizeof(GpuVertex::Position) * vertexCount;
+                    const auto attributeStreamOffset = (positionStreamSize + VERTEX_STREAM_ALIGNMENT - 1) & ~(VERTEX_STREAM_ALIGNMENT - 1);
+
+                    return std::vector<VkDeviceSize> { 0, attributeStreamOffset };
+                } else {
+                    return std::vector<VkDeviceSize> { 0 };
+                }
+            }();
+            const auto bufferSize = [vertexCount, &vertexStreamOffsets]() -> VkDeviceSize {
+                if (SPLIT_VERTEX_STREAMS) {
+                    return vertexStreamOffsets[1] + sizeof(GpuVertex::TexCoord) * vertexCount;
+                } else {
+                    return sizeof(GpuVertex) * vertexCount;
+                }
+            }();
+
+            // The mesh shader and the vertex pulling shader fetch vertices from the same buffer
+            // as a storage buffer.
+            VkBufferUsageFlags vertexBufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | 
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+            if (m_useMeshShaders || m_pullVertices) {
+                vertexBufferUsageFlags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            }
+            // Descriptors in the descriptor buffer name the buffer by its address.
+            if ((m_useMeshShaders || m_pullVertices) && m_useDescriptorBuffer) {
+                vertexBufferUsageFlags |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+            }
+            // The meshlet and vertex pull descriptor sets refer to the vertex buffer, so it
+            // never moves.
+            const auto isMovable = m_defragmentMemory && !m_useMeshShaders && !m_pullVertices;
+            if (isMovable) {
+                vertexBufferUsageFlags |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            }
+            VkMemoryPropertyFlags vertexBufferPropertyFlags = this->getMeshBufferPropertyFlags();
+
+            const auto [vertexBuffer, vertexBufferAllocation] = this->createMeshBuffer(
+                SHARED_VERTEX_BUFFER_NAME,
+                bufferSize,
+                vertexBufferUsageFlags,
+                vertexBufferPropertyFlags
+            );
+
+            // A streamed mesh only writes the vertices of its coarsest level, and an importer
+            // of shared buffers none, since the owner writes them for every instance.
+            m_vertexStreamOffsets = vertexStreamOffsets;
+            if (m_geometryStreamer != nullptr) {
+                this->writeMeshVertices(
+                    uploadBatch,
+                    vertexBuffer,
+                    vertexBufferAllocation,
+                    m_initialGeometryUpload.firstVertex,
+                    m_initialGeometryUpload.vertexCount
+                );
+            } else if (m_sharedAssetImporter == nullptr) {
+                this->writeMeshVertices(uploadBatch, vertexBuffer, vertexBufferAllocation, 0, m_meshRange.vertexCount);
+            }
+
+            m_vertexBuffer = m_resourceTable->addBuffer(vertexBuffer, vertexBufferAllocation);
+            m_vertexBufferSize = bufferSize;
+            if (isMovable) {
+                m_movableBuffers.push_back(MovableBuffer {
+                    .buffer = m_vertexBuffer,
+                    .size = bufferSize,
+                    .usage = vertexBufferUsageFlags,
+                });
+            }
+        }
+
+        void createIndexBuffer(UploadBatch& uploadBatch) {
+            const auto indexSize = m_geometryPool->getIndexSize();
+            const auto bufferSize = VkDeviceSize { indexSize * m_geometryPool->getIndexCapacity() };
+            VkBufferUsageFlags vertexBufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+            if (m_defragmentMemory) {
+                vertexBufferUsageFlags |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            }
+            VkMemoryPropertyFlags vertexBufferPropertyFlags = this->getMeshBufferPropertyFlags();
+            const auto [indexBuffer, indexBufferAllocation] = this->createMeshBuffer(
+                SHARED_INDEX_BUFFER_NAME,
+                bufferSize,
+                vertexBufferUsageFlags,
+                vertexBufferPropertyFlags
+            );
+
+            // A streamed mesh only writes the indices of its coarsest level, and an importer
+            // of shared buffers none.
+            if (m_geometryStreamer != nullptr) {
+                this->writeMeshIndices(
+                    uploadBatch,
+                    indexBuffer,
+                    indexBufferAllocation,
+                    m_mesh->lods()[m_initialGeometryUpload.level].firstIndex,
+                    m_initialGeometryUpload.indexCount,
+                    m_initialGeometryUpload.firstIndex
+                );
+            } else if (m_sharedAssetImporter == nullptr) {
+                this->writeMeshIndices(uploadBatch, indexBuffer, indexBufferAllocation, 0, m_meshRange.indexCount, m_meshRange.firstIndex);
+            }
+
+            m_indexBuffer = m_resourceTable->addBuffer(indexBuffer, indexBufferAllocation);
+            if (m_defragmentMemory) {
+                m_movableBuffers.push_back(MovableBuffer {
+                    .buffer = m_indexBuffer,
+                    .size = bufferSize,
+                    .usage = vertexBufferUsageFlags,
+                });
+            }
+        }
+
+        /// @brief Add a node to the scene for every copy of the mesh, on a grid of
+        /// `INSTANCE_GRID_SIZE` copies a side centered on the origin, or where the stress
+        /// scene puts them, and compute their world transforms.
+        ///
+        /// @note The bounding sphere of every copy is the mesh's, around the origin of its
+        /// node. The buffers of the copies are created from the world transforms, so the
+        /// changes of the first update are not uploaded again.
+        void createScene() {
+            if (m_stressSceneOptions) {
+                for (const auto& instance : StressSceneGenerator::generateInstances(*m_stressSceneOptions)) {
+                    m_scene.addNode(
+                        Scene::NO_PARENT,
+                        instance.translation,
+                        instance.rotation,
+                        instance.scale,
+                        glm::vec4(0.0f, 0.0f, 0.0f, m_meshRadius)
+                    );
+                }
+            } else {
+                const auto gridOffset = 0.5f * static_cast<float>(INSTANCE_GRID_SIZE - 1);
+                for (uint32_t y = 0; y < INSTANCE_GRID_SIZE; y++) {
+                    for (uint32_t x = 0; x < INSTANCE_GRID_SIZE; x++) {
+                        const auto position = INSTANCE_SPACING * glm::vec3(static_cast<float>(x) - gridOffset, static_cast<float>(y) - gridOffset, 0.0f);
+                        m_scene.addNode(
+                            Scene::NO_PARENT,
+                            position,
+                            glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                            glm::vec3(1.0f),
+                            glm::vec4(0.0f, 0.0f, 0.0f, m_meshRadius)
+                        );
+                    }
+                }
+            }
+
+            m_scene.updateWorldTransforms(m_jobSystem.get());
+            m_scene.takeChangedRanges();
+            // The tree is culled against one view, so multiview frames draw every copy.
+            if (CULL_DRAWS_ON_CPU && m_useIndirectDraws && !m_cullDraws && m_viewCount == 1) {
+                m_instanceBvh = std::make_unique<InstanceBvh>();
+                m_instanceBvh->build(m_scene.getWorldBoundingSpheres());
+            }
+        }
+
+        void createInstanceBuffer(UploadBatch& uploadBatch) {
+            static_assert(sizeof(InstanceTransform) == sizeof(glm::mat4), "instance transforms must be laid out like world matrices");
+            const auto worldMatrices = m_scene.getWorldMatrices();
+            const auto bufferSize = VkDeviceSize { sizeof(InstanceTransform) * worldMatrices.size() };
+
+            VkBufferUsageFlags instanceBufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+            if (m_defragmentMemory) {
+                instanceBufferUsageFlags |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            }
+            VkMemoryPropertyFlags instanceBufferPropertyFlags = this->getMeshBufferPropertyFlags();
+            const auto [instanceBuffer, instanceBufferAllocation] = m_engine->createBuffer(bufferSize, instanceBufferUsageFlags, instanceBufferPropertyFlags);
+
+            auto* instanceData = this->getMeshBufferData(uploadBatch, instanceBuffer, instanceBufferAllocation, bufferSize);
+            std::memcpy(instanceData, worldMatrices.data(), bufferSize);
+
+            m_instanceBuffer = m_resourceTable->addBuffer(instanceBuffer, instanceBufferAllocation);
+            m_instanceCount = static_cast<uint32_t>(worldMatrices.size());
+            if (m_defragmentMemory) {
+                m_movableBuffers.push_back(MovableBuffer {
+                    .buffer = m_instanceBuffer,
+                    .size = bufferSize,
+                    .usage = instanceBufferUsageFlags,
+                });
+            }
+        }
+
+        /// @brief Upload the world space bounding sphere of every copy of the mesh, which the
+        /// draw culler tests against the frustum.
+        void createBoundingSphereBuffer(UploadBatch& uploadBatch) {
+            const auto boundingSpheres = m_scene.getWorldBoundingSpheres();
+            const auto bufferSize = VkDeviceSize { sizeof(glm::vec4) * boundingSpheres.size() };
+
+            VkBufferUsageFlags boundingSphereBufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            VkMemoryPropertyFlags boundingSphereBufferPropertyFlags = this->getMeshBufferPropertyFlags();
+            const auto [boundingSphereBuffer, boundingSphereBufferAllocation] = m_engine->createBuffer(
+                bufferSize,
+                boundingSphereBufferUsageFlags,
+                boundingSphereBufferPropertyFlags
+            );
+
+            auto* boundingSphereData = this->getMeshBufferData(uploadBatch, boundingSphereBuffer, boundingSphereBufferAllocation, bufferSize);
+            std::memcpy(boundingSphereData, boundingSpheres.data(), bufferSize);
+
+            m_boundingSphereBuffer = m_resourceTable->addBuffer(boundingSphereBuffer, boundingSphereBufferAllocation);
+        }
+
+        /// @brief Whether the vertices are stored in the layout the shaders that fetch them
+        /// from storage buffers read: split streams of Unorm16 positions, two words each, and
+        /// Unorm16 texture coordinates, one word each.
+        bool hasStorageVertexLayout() const {
+            return SPLIT_VERTEX_STREAMS &&
+                GpuVertex::IS_POSITION_NORMALIZED &&
+                GpuVertex::IS_TEX_COORD_NORMALIZED &&
+                sizeof(GpuVertex::Position) == 2 * sizeof(uint32_t) &&
+                sizeof(GpuVertex::TexCoord) == sizeof(uint32_t);
+        }
+
+        bool canUseMeshShaders() const {
+            const auto isSingleInstance = INSTANCE_GRID_SIZE == 1 && !m_stressSceneOptions;
+
+            return USE_MESH_SHADERS
+                && this->hasStorageVertexLayout()
+                && isSingleInstance
+                && m_viewCount == 1
+                && m_engine->supportsMeshShading();
+        }
+
+        /// @brief Partition the mesh into meshlets and upload them to one storage buffer.
+        ///
+        /// @note The buffer holds the meshlets, then their vertex lists, then their packed
+        /// triangles, each starting at an offset the device can bind a storage buffer at.
+        void createMeshletBuffer(UploadBatch& uploadBatch) {
+            // The meshlets are built when the mesh is imported, or baked into its cache entry.
+            const auto& meshletData = m_mesh->meshlets();
+            const auto& meshletLods = m_mesh->meshletLods();
+
+            const auto alignment = m_engine->getDeviceCapabilities().getLimits().minStorageBufferOffsetAlignment;
+            const auto alignUp = [alignment](VkDeviceSize offset) -> VkDeviceSize {
+                return (offset + alignment - 1) / alignment * alignment;
+            };
+
+            const auto meshletsSize = VkDeviceSize { sizeof(GpuMeshlet) * meshletData.meshlets.size() };
+            const auto verticesSize = VkDeviceSize { sizeof(uint32_t) * meshletData.vertices.size() };
+            const auto trianglesSize = VkDeviceSize { meshletData.triangles.size() };
+            const auto verticesOffset = alignUp(meshletsSize);
+            const auto trianglesOffset = alignUp(verticesOffset + verticesSize);
+            const auto bufferSize = trianglesOffset + trianglesSize;
+
+            VkBufferUsageFlags meshletBufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            if (m_useDescriptorBuffer) {
+                meshletBufferUsageFlags |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+            }
+            VkMemoryPropertyFlags meshletBufferPropertyFlags = this->getMeshBufferPropertyFlags();
+            const auto [meshletBuffer, meshletBufferAllocation] = m_engine->createBuffer(
+                bufferSize,
+                meshletBufferUsageFlags,
+                meshletBufferPropertyFlags
+            );
+
+            auto* meshletBufferData = static_cast<uint8_t*>(this->getMeshBufferData(uploadBatch, meshletBuffer, meshletBufferAllocation, bufferSize));
+            for (size_t i = 0; i < meshletData.meshlets.size(); i++) {
+                const auto& meshlet = meshletData.meshlets[i];
+                const auto& bounds = meshletData.bounds[i];
+                const auto gpuMeshlet = GpuMeshlet {
+                    .boundingSphere = glm::vec4 { bounds.center[0], bounds.center[1], bounds.center[2], bounds.radius },
+                    .coneApex = glm::vec4 { bounds.coneApex[0], bounds.coneApex[1], bounds.coneApex[2], bounds.coneCutoff },
+                    .coneAxis = glm::vec4 { bounds.coneAxis[0], bounds.coneAxis[1], bounds.coneAxis[2], 0.0f },
+                    .vertexOffset = meshlet.vertexOffset,
+                    .triangleOffset = meshlet.triangleOffset,
+                    .vertexCount = meshlet.vertexCount,
+                    .triangleCount = meshlet.triangleCount,
+                };
+                std::memcpy(meshletBufferData + i * sizeof(GpuMeshlet), &gpuMeshlet, sizeof(GpuMeshlet));
+            }
+            // Meshlet vertices index the whole vertex buffer, so they are offset to the mesh's
+            // range of the geometry pool.
+            auto* meshletVertices = reinterpret_cast<uint32_t*>(meshletBufferData + verticesOffset);
+            for (size_t i = 0; i < meshletData.vertices.size(); i++) {
+                meshletVertices[i] = m_meshRange.baseVertex + meshletData.vertices[i];
+            }
+            std::memcpy(meshletBufferData + trianglesOffset, meshletData.triangles.data(), trianglesSize);
+
+            m_meshletBuffer = m_resourceTable->addBuffer(meshletBuffer, meshletBufferAllocation);
+            m_meshletBufferRanges = std::array<VkDescriptorBufferInfo, 3> {
+                VkDescriptorBufferInfo { .buffer = meshletBuffer, .offset = 0, .range = meshletsSize },
+                VkDescriptorBufferInfo { .buffer = meshletBuffer, .offset = verticesOffset, .range = verticesSize },
+                VkDescriptorBufferInfo { .buffer = meshletBuffer, .offset = trianglesOffset, .range = trianglesSize },
+            };
+            m_meshletLods = meshletLods;
+        }
+
+        /// @brief The layouts of the uniform buffer and the LOD feedback buffer, in set 0, and
+        /// of the texture table, in set 1 of both pipelines, from the bindings the draw
+        /// shaders declare.
+        ///
+        /// @note The texture table is updated after it is bound, and a set layout that allows
+        /// that cannot hold dynamic uniform buffers, so the two live in sets of their own.
+        /// In the descriptor buffer, the uniform buffer descriptor of each frame is written
+        /// over with the frame's slice instead, since descriptor buffers hold no dynamic
+        /// uniform buffers, and the texture table is written without updating after bind.
+        void createDescriptorSetLayout() {
+            auto drawShaders = this->reflectVertexPipelineShaders();
+            if (m_useMeshShaders) {
+                auto meshShaderPipelineShaders = this->reflectMeshShaderPipelineShaders();
+                drawShaders.insert(drawShaders.end(), meshShaderPipelineShaders.begin(), meshShaderPipelineShaders.end());
+            }
+
+            // The uniform buffer is a window into the uniform ring, placed with a dynamic
+            // offset when the set is bound. The fragment shader declares the LOD feedback
+            // buffer, the page table and the page feedback of the virtual texture in every
+            // permutation, so their bindings are there even when nothing writes them.
+            auto layoutBindings = this->getReflectedBindings(drawShaders, 0);
+            if (layoutBindings.empty() || layoutBindings[0].binding != 0 || layoutBindings[0].descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+                throw std::runtime_error("failed to create descriptor set layout, the draw shaders have no uniform buffer at binding 0!");
+            }
+            layoutBindings[0].descriptorType = this->getUniformBufferDescriptorType();
+
+            auto& pipelineLayoutCache = m_engine->getPipelineLayoutCache();
+            const auto descriptorSetLayout = pipelineLayoutCache.getDescriptorSetLayout(this->getDescriptorSetLayoutFlags(), layoutBindings);
+
+            // Each texture table gets only as many descriptors as the scene has textures, the
+            // ones no draw samples stay unwritten, and the textures can be swapped out while
+            // frames that do not sample them are in flight.
+            auto textureTableLayoutBindings = this->getReflectedBindings(drawShaders, 1);
+            if (textureTableLayoutBindings.size() != 1 || textureTableLayoutBindings[0].descriptorType != VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) {
+                throw std::runtime_error("failed to create texture table descriptor set layout, the draw shaders have no texture table in set 1!");
+            }
+            textureTableLayoutBindings[0].descriptorCount = MAX_TEXTURE_TABLE_SIZE;
+            textureTableLayoutBindings[0].bindingFlags = [this]() -> VkDescriptorBindingFlags {
+                if (m_useDescriptorBuffer) {
+                    return VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+                } else {
+                    return VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+                        | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT
+                        | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+                        | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+                }
+            }();
+            const auto textureTableSetLayoutFlags = m_useDescriptorBuffer
+                ? VkDescriptorSetLayoutCreateFlags { VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT }
+                : VkDescriptorSetLayoutCreateFlags { VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT };
+            const auto textureTableSetLayout = pipelineLayoutCache.getDescriptorSetLayout(textureTableSetLayoutFlags, textureTableLayoutBindings);
+
+            m_descriptorSetLayout = descriptorSetLayout;
+            m_textureTableSetLayout = textureTableSetLayout;
+        }
+
+        /// @brief The shaders the pipelines on `m_pipelineLayout` are built from: the vertex
+        /// pipeline, and the depth prepass and occlusion proxy pipelines when they are used.
+        ///
+        /// @note The interfaces are the ones reflected when the shaders were built, which a
+        /// reloaded shader has to keep, since the layouts are not rebuilt for it.
+        std::vector<ShaderReflection> reflectVertexPipelineShaders() const {
+            auto shaders = std::vector<ShaderReflection> {};
+            shaders.emplace_back(shaders_hlsl::getHlslShaderReflection(m_pullVertices ? HlslShader::VertexPullVert : HlslShader::ShaderVert));
+            shaders.emplace_back(shaders_hlsl::getHlslShaderReflection(HlslShader::ShaderFrag));
+            if (m_useDepthPrepass && !m_pullVertices) {
+                shaders.emplace_back(shaders_hlsl::getHlslShaderReflection(HlslShader::DepthVert));
+            }
+            if (m_useOcclusionQueries) {
+                shaders.emplace_back(shaders_hlsl::getHlslShaderReflection(HlslShader::OcclusionProxyVert));
+            }
+
+            return shaders;
+        }
+
+        /// @brief The shaders of the mesh shader pipeline.
+        std::vector<ShaderReflection> reflectMeshShaderPipelineShaders() const {
+            auto shaders = std::vector<ShaderReflection> {};
+            shaders.emplace_back(shaders_hlsl::getHlslShaderReflection(HlslShader::MeshletTask));
+            shaders.emplace_back(shaders_hlsl::getHlslShaderReflection(HlslShader::MeshletMesh));
+            shaders.emplace_back(shaders_hlsl::getHlslShaderReflection(HlslShader::ShaderFrag));
+
+            return shaders;
+        }
+
+        /// @brief The bindings `shaders` declare in `set`, as the pipeline layout cache takes
+        /// them, where an array without a size still needs its count.
+        std::vector<DescriptorSetLayoutBinding> getReflectedBindings(std::span<const ShaderReflection> shaders, uint32_t set) const {
+            auto layoutBindings = std::vector<DescriptorSetLayoutBinding> {};
+            for (const auto& binding : ShaderReflection::mergeBindings(shaders, set)) {
+                layoutBindings.push_back(DescriptorSetLayoutBinding {
+                    .binding = binding.binding,
+                    .descriptorType = binding.descriptorType,
+                    .descriptorCount = binding.descriptorCount,
+                    .stageFlags = binding.stageFlags,
+                });
+            }
+
+            return layoutBindings;
+        }
+
+        /// @brief The push constant range of a pipeline layout whose draws push `pushedSize`
+        /// bytes to `pushedStages`, after checking that `shaders` read no more than that.
+        ///
+        /// @note The range covers everything that is pushed, so that the stages of every push
+        /// match the range, whichever of the stages read the constants.
+        VkPushConstantRange getPushConstantRange(std::span<const ShaderReflection> shaders, VkShaderStageFlags pushedStages, uint32_t pushedSize) const {
+            const auto reflectedRange = ShaderReflection::mergePushConstantRanges(shaders);
+            if (reflectedRange.has_value()) {
+                if ((reflectedRange->stageFlags & ~pushedStages) != 0) {
+                    throw std::runtime_error("failed to create pipeline layout, a shader reads push constants in a stage the draws do not push to!");
+                }
+                if (reflectedRange->offset + reflectedRange->size > pushedSize) {
+                    throw std::runtime_error("failed to create pipeline layout, the shaders read more push constants than the draws push!");
+                }
+            }
+
+            return VkPushConstantRange {
+                .stageFlags = pushedStages,
+                .offset = 0,
+                .size = pushedSize,
+            };
+        }
+
+        /// @brief The flags of the set layouts of the draw pipelines, which the descriptor
+        /// buffer needs on every one of them.
+        VkDescriptorSetLayoutCreateFlags getDescriptorSetLayoutFlags() const {
+            if (m_useDescriptorBuffer) {
+                return VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+            } else {
+                return 0;
+            }
+        }
+
+        /// @brief The type of the uniform buffer binding, which is dynamic unless it lives in
+        /// the descriptor buffer, since descriptor buffers have no dynamic descriptors.
+        VkDescriptorType getUniformBufferDescriptorType() const {
+            if (m_useDescriptorBuffer) {
+                return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            } else {
+                return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            }
+        }
+
+        /// @brief The flags of the draw pipelines, which bind their sets from the descriptor
+        /// buffer when there is one, and render with the shading rate image when there is one.
+        VkPipelineCreateFlags getPipelineCreateFlags() const {
+            auto flags = VkPipelineCreateFlags { 0 };
+            if (m_useDescriptorBuffer) {
+                flags |= VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+            }
+
+            if (m_useShadingRateImage) {
+                flags |= VK_PIPELINE_CREATE_RENDERING_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
+            }
+
+            return flags;
+        }
+
+        /// @brief The draw state of the draw pipelines, which test for the depth a depth
+        /// prepass wrote when `testsPrepassDepth`, and write their own depth otherwise.
+        DrawState getDrawState(bool testsPrepassDepth) const {
+            return DrawState {
+                .cullMode = VK_CULL_MODE_BACK_BIT,
+                .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+                .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+                .depthTestEnable = VK_TRUE,
+                .depthWriteEnable = testsPrepassDepth ? VK_FALSE : VK_TRUE,
+                .depthCompareOp = testsPrepassDepth ? VK_COMPARE_OP_EQUAL : (REVERSE_Z ? VK_COMPARE_OP_GREATER : VK_COMPARE_OP_LESS),
+            };
+        }
+
+        /// @brief The draw state of the bounding boxes drawn inside the occlusion queries,
+        /// which pass wherever a box is at least as near as the depth of the frame's draws,
+        /// and leave that depth as it is.
+        DrawState getOcclusionProxyDrawState() const {
+            return DrawState {
+                .cullMode = VK_CULL_MODE_NONE,
+                .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+                .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+                .depthTestEnable = VK_TRUE,
+                .depthWriteEnable = VK_FALSE,
+                .depthCompareOp = REVERSE_Z ? VK_COMPARE_OP_GREATER_OR_EQUAL : VK_COMPARE_OP_LESS_OR_EQUAL,
+            };
+        }
+
+        /// @brief The dynamic state of the draw pipelines.
+        ///
+        /// @note Pipelines without vertex input, like the mesh shader pipeline, have no
+        /// topology to set.
+        std::vector<VkDynamicState> getDynamicStates(bool hasVertexInput) const {
+            auto dynamicStates = std::vector<VkDynamicState> {
+                VK_DYNAMIC_STATE_VIEWPORT,
+                VK_DYNAMIC_STATE_SCISSOR
+            };
+            if (m_useFragmentShadingRate) {
+                dynamicStates.push_back(VK_DYNAMIC_STATE_FRAGMENT_SHADING_RATE_KHR);
+            }
+            if (m_useExtendedDynamicState) {
+                dynamicStates.insert(dynamicStates.end(), {
+                    VK_DYNAMIC_STATE_CULL_MODE,
+                    VK_DYNAMIC_STATE_FRONT_FACE,
+                    VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+                    VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+                    VK_DYNAMIC_STATE_DEPTH_COMPARE_OP,
+                });
+                if (hasVertexInput) {
+                    dynamicStates.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY);
+                }
+            }
+
+            return dynamicStates;
+        }
+
+        /// @brief Set `drawState` for the draw pipeline that was just bound, when it is
+        /// dynamic.
+        void setDrawState(VkCommandBuffer commandBuffer, const DrawState& drawState, bool hasVertexInput) const {
+            if (!m_useExtendedDynamicState) {
+                return;
+            }
+
+            m_dispatch->vkCmdSetCullMode(commandBuffer, drawState.cullMode);
+            m_dispatch->vkCmdSetFrontFace(commandBuffer, drawState.frontFace);
+            m_dispatch->vkCmdSetDepthTestEnable(commandBuffer, drawState.depthTestEnable);
+            m_dispatch->vkCmdSetDepthWriteEnable(commandBuffer, drawState.depthWriteEnable);
+            m_dispatch->vkCmdSetDepthCompareOp(commandBuffer, drawState.depthCompareOp);
+            if (hasVertexInput) {
+                m_dispatch->vkCmdSetPrimitiveTopology(commandBuffer, drawState.topology);
+            }
+        }
+
+        /// @brief The shading rate of the draws, which is coarser once the mesh is far enough
+        /// away to draw a simplified level of detail.
+        VkExtent2D getDrawShadingRate() const {
+            if (this->selectMeshLodLevel() > 0) {
+                return VkExtent2D { 2, 2 };
+            } else {
+                return VkExtent2D { 1, 1 };
+            }
+        }
+
+        /// @brief Set the shading rate of the draws, when it is dynamic.
+        ///
+        /// @note Draws have no rate per primitive, and the rate of the shading rate image,
+        /// if any, is combined with theirs last.
+        void setDrawShadingRate(VkCommandBuffer commandBuffer) const {
+            if (!m_useFragmentShadingRate) {
+                return;
+            }
+
+            const auto combinerOps = std::array<VkFragmentShadingRateCombinerOpKHR, 2> {
+                VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR,
+                m_shadingRateImageCombinerOp,
+            };
+            m_engine->setFragmentShadingRate(commandBuffer, this->getDrawShadingRate(), combinerOps);
+        }
+
+        /// @brief The layout of the meshlet buffer ranges and the vertex buffer, which the
+        /// task and mesh shaders read as storage buffers in set 2.
+        void createMeshletDescriptorSetLayout() {
+            const auto layoutBindings = this->getReflectedBindings(this->reflectMeshShaderPipelineShaders(), 2);
+            m_meshletDescriptorSetLayout = m_engine->getPipelineLayoutCache().getDescriptorSetLayout(this->getDescriptorSetLayoutFlags(), layoutBindings);
+        }
+
+        /// @brief The layout of the vertex buffer, which the vertex pulling shader reads as a
+        /// storage buffer in set 2.
+        void createVertexPullDescriptorSetLayout() {
+            const auto layoutBindings = this->getReflectedBindings(this->reflectVertexPipelineShaders(), 2);
+            m_vertexPullDescriptorSetLayout = m_engine->getPipelineLayoutCache().getDescriptorSetLayout(this->getDescriptorSetLayoutFlags(), layoutBindings);
+        }
+
+        /// @brief Create the uniform ring every frame in flight takes its uniform data from.
+        void createUniformBuffers() {
+            // The descriptor buffer names each frame's slice by its address.
+            const auto additionalUsage = m_useDescriptorBuffer ? VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT : 0;
+            m_uniformRing = std::make_unique<UniformRing>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_framesInFlight,
+                UniformRing::DEFAULT_FRAME_CAPACITY,
+                m_engine->getDeviceCapabilities().getLimits().minUniformBufferOffsetAlignment,
+                additionalUsage
+            );
+            m_uniformBufferOffset = 0;
+        }
+
+        /// @brief Create the LOD feedback buffer, with a region for every texture the
+        /// texture table can hold in every frame in flight.
+        void createLodFeedback() {
+            // The descriptor buffer names each frame's region by its address.
+            const auto additionalUsage = m_useDescriptorBuffer ? VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT : 0;
+            m_lodFeedback = std::make_unique<LodFeedback>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                MAX_TEXTURE_TABLE_SIZE,
+                m_framesInFlight,
+                additionalUsage
+            );
+        }
+
+        /// @brief The page table of the virtual texture for `frameIndex`, or the LOD feedback
+        /// in its place, which the shader never reads through the binding, without one.
+        VkDescriptorBufferInfo getPageTableInfo(uint32_t frameIndex) const {
+            if (m_virtualTexture != nullptr) {
+                return m_virtualTexture->getPageTableInfo(frameIndex);
+            }
+
+            return m_lodFeedback->getBufferInfo(frameIndex);
+        }
+
+        /// @brief The page feedback of the virtual texture for `frameIndex`, or the LOD
+        /// feedback in its place without one.
+        VkDescriptorBufferInfo getPageFeedbackInfo(uint32_t frameIndex) const {
+            if (m_virtualTexture != nullptr) {
+                return m_virtualTexture->getFeedbackInfo(frameIndex);
+            }
+
+            return m_lodFeedback->getBufferInfo(frameIndex);
+        }
+
+        /// @brief Create the buffer of the indirect draws of every frame in flight, with room
+        /// for a draw per copy of the mesh.
+        void createIndirectDrawBuffer() {
+            if (!m_useIndirectDraws) {
+                return;
+            }
+
+            m_indirectDrawBuffer = std::make_unique<IndirectDrawBuffer>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_framesInFlight,
+                m_instanceCount
+            );
+        }
+
+        /// @brief Create the buffer the changes of the scene are uploaded through, with a
+        /// region for every frame in flight that holds the world matrix and bounding sphere
+        /// of every node.
+        void createSceneUploadBuffer() {
+            m_sceneUploadRegionSize = m_scene.getNodeCount() * VkDeviceSize { sizeof(glm::mat4) + sizeof(glm::vec4) };
+            const auto [sceneUploadBuffer, sceneUploadBufferAllocation] = m_engine->createBuffer(
+                m_framesInFlight * m_sceneUploadRegionSize,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+            m_sceneUploadBuffer = sceneUploadBuffer;
+            m_sceneUploadBufferAllocation = sceneUploadBufferAllocation;
+        }
+
+        /// @brief Create the culler of the indirect draws of every frame in flight.
+        ///
+        /// @note It reads the frustum out of the uniform ring and the candidate draws out of
+        /// the indirect draw buffer, so it goes with them when the frames are rebuilt.
+        void createDrawCuller() {
+            if (!m_cullDraws) {
+                return;
+            }
+
+            const auto uniformBufferInfo = VkDescriptorBufferInfo {
+                .buffer = m_uniformRing->getBuffer(),
+                .offset = 0,
+                .range = sizeof(UniformBufferObject),
+            };
+            m_drawCuller = std::make_unique<DrawCuller>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_engine->getPipelineCache(),
+                shaders_hlsl::getHlslShader(HlslShader::CullComp),
+                *m_indirectDrawBuffer,
+                uniformBufferInfo,
+                m_resourceTable->getBuffer(m_boundingSphereBuffer),
+                REVERSE_Z
+            );
+        }
+
+        /// @brief Create the occlusion queries of every copy of the mesh for every frame in
+        /// flight, and the predicates they are resolved into.
+        void createOcclusionQueries() {
+            if (!m_useOcclusionQueries) {
+                return;
+            }
+
+            m_occlusionQueries = std::make_unique<OcclusionQueries>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_instanceCount,
+                m_framesInFlight
+            );
+        }
+
+        /// @brief Point the indirect draw of every copy of the mesh at the level of detail
+        /// of the frame.
+        ///
+        /// @note Must be called after the frame has been waited for on the frame timeline,
+        /// since it updates the frame's region of the indirect draw buffer. The copies draw
+        /// at the level of detail of the whole mesh, so their draws only change along with
+        /// it.
+        void updateIndirectDraws(uint32_t currentFrame, const SceneState& sceneState) {
+            if (m_indirectDrawBuffer == nullptr) {
+                return;
+            }
+
+            m_indirectDrawBuffer->update(currentFrame, sceneState.drawCommands);
+        }
+
+        /// @brief Bring the world transforms of the scene up to date, and record the copies
+        /// of the ones that changed into the instance and bounding sphere buffers, or return
+        /// `VK_NULL_HANDLE` when none did.
+        ///
+        /// @note Must be called after the frame has been waited for on the frame timeline,
+        /// since the changes go through the frame's region of the scene upload buffer, and
+        /// after the frame's pool has been reset. Earlier frames on the same queue may still
+        /// be drawing with the old transforms, so the copies wait for them with a barrier,
+        /// and the frame's culling and draws wait for the copies with another. While a buffer
+        /// is being moved the changes are held back, since the copy of the move would miss
+        /// them.
+        VkCommandBuffer recordSceneUploads() {
+            CPU_PROFILE_ZONE("scene uploads");
+            const auto hasUpdated = m_scene.updateWorldTransforms(m_jobSystem.get());
+            if (hasUpdated && m_instanceBvh) {
+                m_instanceBvh->refit(m_scene.getWorldBoundingSpheres());
+            }
+            if (m_pendingBufferMove.has_value()) {
+                return VK_NULL_HANDLE;
+            }
+
+            const auto changedRanges = m_scene.takeChangedRanges();
+            if (changedRanges.empty()) {
+                return VK_NULL_HANDLE;
+            }
+
+            // The region holds the changed matrices first and the changed spheres after
+            // room for every matrix.
+            const auto worldMatrices = m_scene.getWorldMatrices();
+            const auto worldBoundingSpheres = m_scene.getWorldBoundingSpheres();
+            const auto regionOffset = m_currentFrame * m_sceneUploadRegionSize;
+            const auto sphereOffset = regionOffset + m_scene.getNodeCount() * VkDeviceSize { sizeof(glm::mat4) };
+            auto* uploadData = static_cast<uint8_t*>(m_sceneUploadBufferAllocation.mappedData);
+            auto instanceCopies = std::vector<VkBufferCopy> {};
+            auto sphereCopies = std::vector<VkBufferCopy> {};
+            auto uploadedCount = VkDeviceSize { 0 };
+            for (const auto& changedRange : changedRanges) {
+                const auto instanceCopy = VkBufferCopy {
+                    .srcOffset = regionOffset + uploadedCount * sizeof(glm::mat4),
+                    .dstOffset = changedRange.firstNode * VkDeviceSize { sizeof(InstanceTransform) },
+                    .size = changedRange.nodeCount * VkDeviceSize { sizeof(glm::mat4) },
+                };
+                std::memcpy(uploadData + instanceCopy.srcOffset, &worldMatrices[changedRange.firstNode], instanceCopy.size);
+                instanceCopies.push_back(instanceCopy);
+
+                if (m_cullDraws) {
+                    const auto sphereCopy = VkBufferCopy {
+                        .srcOffset = sphereOffset + uploadedCount * sizeof(glm::vec4),
+                        .dstOffset = changedRange.firstNode * VkDeviceSize { sizeof(glm::vec4) },
+                        .size = changedRange.nodeCount * VkDeviceSize { sizeof(glm::vec4) },
+                    };
+                    std::memcpy(uploadData + sphereCopy.srcOffset, &worldBoundingSpheres[changedRange.firstNode], sphereCopy.size);
+                    sphereCopies.push_back(sphereCopy);
+                }
+
+                uploadedCount += changedRange.nodeCount;
+            }
+
+            // Without device group info, the command buffer runs on every device of a
+            // group, so that every copy of the buffers is updated.
+            const auto commandBuffer = m_sceneUploadCommandBuffers[m_currentFrame];
+            const auto beginInfo = VkCommandBufferBeginInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .pNext = nullptr,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                .pInheritanceInfo = nullptr,
+            };
+            const auto resultBeginCommandBuffer = m_dispatch->vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            if (resultBeginCommandBuffer != VK_SUCCESS) {
+                throw std::runtime_error("failed to begin recording scene upload command buffer!");
+            }
+
+            const auto readStages = VkPipelineStageFlags { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT };
+            const auto barrierBeforeCopies = VkMemoryBarrier {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .srcAccessMask = 0,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            };
+            m_dispatch->vkCmdPipelineBarrier(commandBuffer, readStages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrierBeforeCopies, 0, nullptr, 0, nullptr);
+            CommandCounters::add(CommandCounter::Barriers);
+
+            m_dispatch->vkCmdCopyBuffer(
+                commandBuffer,
+                m_sceneUploadBuffer,
+                m_resourceTable->getBuffer(m_instanceBuffer),
+                static_cast<uint32_t>(instanceCopies.size()),
+                instanceCopies.data()
+            );
+            if (!sphereCopies.empty()) {
+                m_dispatch->vkCmdCopyBuffer(
+                    commandBuffer,
+                    m_sceneUploadBuffer,
+                    m_resourceTable->getBuffer(m_boundingSphereBuffer),
+                    static_cast<uint32_t>(sphereCopies.size()),
+                    sphereCopies.data()
+                );
+            }
+
+            const auto barrierAfterCopies = VkMemoryBarrier {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+            };
+            m_dispatch->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, readStages, 0, 1, &barrierAfterCopies, 0, nullptr, 0, nullptr);
+            CommandCounters::add(CommandCounter::Barriers);
+
+            const auto resultEndCommandBuffer = m_dispatch->vkEndCommandBuffer(commandBuffer);
+            if (resultEndCommandBuffer != VK_SUCCESS) {
+                throw std::runtime_error("failed to record scene upload command buffer!");
+            }
+
+            return commandBuffer;
+        }
+
+        /// @brief Point the culler of the frame at the depth pyramid, which is replaced along
+        /// with the swap chain.
+        ///
+        /// @note Must be called after the frame has been waited for on the frame timeline,
+        /// since it may rewrite the frame's descriptor set. A new pyramid comes with a new
+        /// swap chain generation, so the static command buffers that bind the old set are
+        /// recorded again anyway.
+        void updateDrawCuller(uint32_t currentFrame) {
+            if (m_drawCuller == nullptr) {
+                return;
+            }
+
+            const auto depthPyramidView = m_depthPyramid != nullptr ? m_depthPyramid->getImageView() : VK_NULL_HANDLE;
+            m_drawCuller->setDepthPyramid(currentFrame, depthPyramidView);
+        }
+
+        /// @brief Create the allocator every descriptor set comes from, or the descriptor
+        /// buffer in its place.
+        ///
+        /// @note Its first pool fits the sets of the most frames in flight there can be,
+        /// and the meshlet set, which is static, so one of it serves every frame in flight.
+        /// Every frame has a uniform buffer set and a texture table of its own. The allocator
+        /// outlives changes to the number of frames in flight, and is only reset for them.
+        void createDescriptorAllocator() {
+            if (m_useDescriptorBuffer) {
+                m_descriptorBuffer = std::make_unique<DescriptorBuffer>(
+                    m_engine->getPhysicalDevice(),
+                    m_engine->getLogicalDevice(),
+                    m_engine->getMemoryAllocator(),
+                    DESCRIPTOR_BUFFER_CAPACITY
+                );
+
+                return;
+            }
+
+            const auto textureCount = static_cast<float>(this->getTextureTable().size());
+            auto ratios = std::vector<DescriptorPoolRatio> {
+                DescriptorPoolRatio { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+                DescriptorPoolRatio { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textureCount },
+            };
+            // Every uniform buffer set holds the LOD feedback buffer and the buffers of the
+            // virtual texture besides.
+            const auto storageBufferCount = 3.0f + (m_useMeshShaders ? 4.0f : 0.0f) + (m_pullVertices ? 1.0f : 0.0f);
+            ratios.push_back(DescriptorPoolRatio { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBufferCount });
+
+            m_descriptorAllocator = std::make_unique<DescriptorAllocator>(
+                m_engine->getLogicalDevice(),
+                ratios,
+                2 * MAX_FRAMES_IN_FLIGHT + 1,
+                VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT
+            );
+        }
+
+        /// @brief Allocate the uniform buffer set and the texture table of every frame in
+        /// flight.
+        ///
+        /// @note The texture tables are not cached, since streaming updates them in place.
+        /// The uniform buffer sets in the descriptor buffer are written every frame, once the
+        /// frame's slice of the uniform ring is known.
+        void createDescriptorSets() {
+            const auto textureTable = this->getTextureTable();
+            if (m_useDescriptorBuffer) {
+                auto uniformBufferSets = std::vector<DescriptorBufferSet> {};
+                auto textureTableBufferSets = std::vector<DescriptorBufferSet> {};
+                for (uint32_t i = 0; i < m_framesInFlight; i++) {
+                    uniformBufferSets.push_back(m_descriptorBuffer->allocate(m_descriptorSetLayout));
+                    m_descriptorBuffer->writeBuffer(uniformBufferSets.back(), 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_lodFeedback->getBufferInfo(i));
+                    m_descriptorBuffer->writeBuffer(uniformBufferSets.back(), 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, this->getPageTableInfo(i));
+                    m_descriptorBuffer->writeBuffer(uniformBufferSets.back(), 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, this->getPageFeedbackInfo(i));
+                    textureTableBufferSets.push_back(m_descriptorBuffer->allocate(m_textureTableSetLayout));
+                    for (uint32_t j = 0; j < textureTable.size(); j++) {
+                        m_descriptorBuffer->writeCombinedImageSampler(textureTableBufferSets.back(), 0, j, textureTable[j]);
+                    }
+                }
+
+                m_uniformBufferSets = std::move(uniformBufferSets);
+                m_textureTableBufferSets = std::move(textureTableBufferSets);
+                m_textureTableEntries = std::vector<VkDescriptorImageInfo> { m_framesInFlight, textureTable[MODEL_TEXTURE_INDEX] };
+                m_textureTableSamplerGenerations = std::vector<uint64_t>(m_framesInFlight, m_samplerGeneration);
+
+                return;
+            }
+
+            auto descriptorSets = std::vector<VkDescriptorSet> { m_framesInFlight, VK_NULL_HANDLE };
+            auto textureTableSets = std::vector<VkDescriptorSet> { m_framesInFlight, VK_NULL_HANDLE };
+            for (size_t i = 0; i < descriptorSets.size(); i++) {
+                descriptorSets[i] = m_descriptorAllocator->allocate(m_descriptorSetLayout);
+                textureTableSets[i] = m_descriptorAllocator->allocate(m_textureTableSetLayout, static_cast<uint32_t>(textureTable.size()));
+
+                const auto bufferInfo = VkDescriptorBufferInfo {
+                    .buffer = m_uniformRing->getBuffer(),
+                    .offset = 0,
+                    .range = sizeof(UniformBufferObject),
+                };
+                const auto lodFeedbackBufferInfo = m_lodFeedback->getBufferInfo(static_cast<uint32_t>(i));
+                const auto pageTableBufferInfo = this->getPageTableInfo(static_cast<uint32_t>(i));
+                const auto pageFeedbackBufferInfo = this->getPageFeedbackInfo(static_cast<uint32_t>(i));
+
+                const auto descriptorWrites = std::array<VkWriteDescriptorSet, 5> {
+                    VkWriteDescriptorSet {
+                        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                        .dstSet = descriptorSets[i],
+                        .dstBinding = 0,
+                        .dstArrayElement = 0,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                        .descriptorCount = 1,
+                        .pBufferInfo = &bufferInfo,
+                    },
+                    VkWriteDescriptorSet {
+                        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                        .dstSet = descriptorSets[i],
+                        .dstBinding = 1,
+                        .dstArrayElement = 0,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                        .descriptorCount = 1,
+                        .pBufferInfo = &lodFeedbackBufferInfo,
+                    },
+                    VkWriteDescriptorSet {
+                        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                        .dstSet = descriptorSets[i],
+                        .dstBinding = 2,
+                        .dstArrayElement = 0,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                        .descriptorCount = 1,
+                        .pBufferInfo = &pageTableBufferInfo,
+                    },
+                    VkWriteDescriptorSet {
+                        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                        .dstSet = descriptorSets[i],
+                        .dstBinding = 3,
+                        .dstArrayElement = 0,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                        .descriptorCount = 1,
+                        .pBufferInfo = &pageFeedbackBufferInfo,
+                    },
+                    VkWriteDescriptorSet {
+                        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                        .dstSet = textureTableSets[i],
+                        .dstBinding = 0,
+                        .dstArrayElement = 0,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                        .descriptorCount = static_cast<uint32_t>(textureTable.size()),
+                        .pImageInfo = textureTable.data(),
+                    },
+                };
+
+                m_dispatch->vkUpdateDescriptorSets(
+                    m_engine->getLogicalDevice(),
+                    static_cast<uint32_t>(descriptorWrites.size()),
+                    descriptorWrites.data(),
+                    0,
+                    nullptr
+                );
+            }
+
+            m_descriptorSets = std::move(descriptorSets);
+            m_textureTableSets = std::move(textureTableSets);
+            m_textureTableEntries = std::vector<VkDescriptorImageInfo> { m_framesInFlight, textureTable[MODEL_TEXTURE_INDEX] };
+            m_textureTableSamplerGenerations = std::vector<uint64_t>(m_framesInFlight, m_samplerGeneration);
+        }
+
+        void createMeshletDescriptorSet() {
+            const auto vertexBufferInfo = VkDescriptorBufferInfo {
+                .buffer = m_resourceTable->getBuffer(m_vertexBuffer),
+                .offset = 0,
+                .range = m_vertexBufferSize,
+            };
+            const auto bufferInfos = std::array<VkDescriptorBufferInfo, 4> {
+                m_meshletBufferRanges[0],
+                m_meshletBufferRanges[1],
+                m_meshletBufferRanges[2],
+                vertexBufferInfo,
+            };
+
+            auto descriptorWrites = std::vector<DescriptorWrite> {};
+            for (uint32_t i = 0; i < bufferInfos.size(); i++) {
+                descriptorWrites.push_back(DescriptorWrite {
+                    .binding = i,
+                    .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .bufferInfos = std::vector<VkDescriptorBufferInfo> { bufferInfos[i] },
+                    .imageInfos = std::vector<VkDescriptorImageInfo> {},
+                });
+            }
+
+            if (m_useDescriptorBuffer) {
+                m_meshletBufferSet = m_descriptorBuffer->allocate(m_meshletDescriptorSetLayout);
+                m_descriptorBuffer->write(m_meshletBufferSet, descriptorWrites);
+            } else {
+                m_meshletDescriptorSet = m_descriptorAllocator->getDescriptorSet(m_meshletDescriptorSetLayout, descriptorWrites);
+            }
+        }
+
+        void createVertexPullDescriptorSet() {
+            const auto vertexBufferInfo = VkDescriptorBufferInfo {
+                .buffer = m_resourceTable->getBuffer(m_vertexBuffer),
+                .offset = 0,
+                .range = m_vertexBufferSize,
+            };
+            const auto descriptorWrites = std::vector<DescriptorWrite> {
+                DescriptorWrite {
+                    .binding = 0,
+                    .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .bufferInfos = std::vector<VkDescriptorBufferInfo> { vertexBufferInfo },
+                    .imageInfos = std::vector<VkDescriptorImageInfo> {},
+                },
+            };
+
+            if (m_useDescriptorBuffer) {
+                m_vertexPullBufferSet = m_descriptorBuffer->allocate(m_vertexPullDescriptorSetLayout);
+                m_descriptorBuffer->write(m_vertexPullBufferSet, descriptorWrites);
+            } else {
+                m_vertexPullDescriptorSet = m_descriptorAllocator->getDescriptorSet(m_vertexPullDescriptorSetLayout, descriptorWrites);
+            }
+        }
+
+        /// @brief Create a transient command pool per frame in flight, each with the frame's
+        /// command buffer and the command buffer of its scene uploads, and the arena its
+        /// recording draws its scratch from.
+        ///
+        /// @note A frame's command buffers are rerecorded every frame, so its pool is reset
+        /// wholesale with `vkResetCommandPool` instead of resetting the command buffers
+        /// alone, and the driver can recycle the pool's memory in one go. The arena is
+        /// rewound the same way.
+        void createCommandBuffers() {
+            auto commandPools = std::vector<VkCommandPool> { m_framesInFlight, VK_NULL_HANDLE };
+            auto commandBuffers = std::vector<VkCommandBuffer> { m_framesInFlight, VK_NULL_HANDLE };
+            auto sceneUploadCommandBuffers = std::vector<VkCommandBuffer> { m_framesInFlight, VK_NULL_HANDLE };
+            const auto poolInfo = VkCommandPoolCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                .queueFamilyIndex = m_engine->getGraphicsQueueFamilyIndex(),
+            };
+            for (size_t i = 0; i < commandPools.size(); i++) {
+                const auto resultCreateCommandPool = vkCreateCommandPool(m_engine->getLogicalDevice(), &poolInfo, m_engine->getAllocationCallbacks(), &commandPools[i]);
+                if (resultCreateCommandPool != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create frame command pool!");
+                }
+
+                const auto allocInfo = VkCommandBufferAllocateInfo {
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    .commandPool = commandPools[i],
+                    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                    .commandBufferCount = 2,
+                };
+
+                auto frameCommandBuffers = std::array<VkCommandBuffer, 2> {};
+                const auto result = vkAllocateCommandBuffers(m_engine->getLogicalDevice(), &allocInfo, frameCommandBuffers.data());
+                if (result != VK_SUCCESS) {
+                    throw std::runtime_error("failed to allocate command buffers!");
+                }
+
+                commandBuffers[i] = frameCommandBuffers[0];
+                sceneUploadCommandBuffers[i] = frameCommandBuffers[1];
+            }
+
+            auto viewportCommandBuffers = std::vector<VkCommandBuffer> {};
+            if (m_viewportWindowCount > 0) {
+                viewportCommandBuffers.resize(m_framesInFlight, VK_NULL_HANDLE);
+                for (size_t i = 0; i < commandPools.size(); i++) {
+                    const auto allocInfo = VkCommandBufferAllocateInfo {
+                        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                        .commandPool = commandPools[i],
+                        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                        .commandBufferCount = 1,
+                    };
+                    const auto result = vkAllocateCommandBuffers(m_engine->getLogicalDevice(), &allocInfo, &viewportCommandBuffers[i]);
+                    if (result != VK_SUCCESS) {
+                        throw std::runtime_error("failed to allocate viewport command buffers!");
+                    }
+                }
+            }
+
+            auto frameArenas = std::vector<std::unique_ptr<FrameArena>> {};
+            for (uint32_t i = 0; i < m_framesInFlight; i++) {
+                frameArenas.push_back(std::make_unique<FrameArena>(FRAME_ARENA_CAPACITY));
+            }
+
+            m_commandPools = std::move(commandPools);
+            m_commandBuffers = std::move(commandBuffers);
+            m_sceneUploadCommandBuffers = std::move(sceneUploadCommandBuffers);
+            m_viewportCommandBuffers = std::move(viewportCommandBuffers);
+            m_frameArenas = std::move(frameArenas);
+            if (this->isPresentOwnershipTransferred()) {
+                this->createPresentCommandBuffers();
+            }
+            // The pre-recorded command buffers are allocated as swap chain images come up.
+            m_staticCommandBuffers = std::vector<std::vector<StaticCommandBuffer>> { m_framesInFlight };
+        }
+
+        /// @brief Create the command buffers that hand the presented images from the graphics
+        /// queue family to the present queue family, and take them over there, frame slot by
+        /// frame slot.
+        void createPresentCommandBuffers() {
+            auto presentCommandPools = std::vector<VkCommandPool> { m_framesInFlight, VK_NULL_HANDLE };
+            auto presentReleaseCommandBuffers = std::vector<VkCommandBuffer> { m_framesInFlight, VK_NULL_HANDLE };
+            auto presentAcquireCommandBuffers = std::vector<VkCommandBuffer> { m_framesInFlight, VK_NULL_HANDLE };
+            const auto poolInfo = VkCommandPoolCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                .queueFamilyIndex = m_engine->getPresentQueueFamilyIndex(),
+            };
+            for (size_t i = 0; i < presentCommandPools.size(); i++) {
+                const auto resultCreateCommandPool = vkCreateCommandPool(m_engine->getLogicalDevice(), &poolInfo, m_engine->getAllocationCallbacks(), &presentCommandPools[i]);
+                if (resultCreateCommandPool != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create present command pool!");
+                }
+
+                const auto releaseAllocInfo = VkCommandBufferAllocateInfo {
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    .commandPool = m_commandPools[i],
+                    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                    .commandBufferCount = 1,
+                };
+                const auto resultRelease = vkAllocateCommandBuffers(m_engine->getLogicalDevice(), &releaseAllocInfo, &presentReleaseCommandBuffers[i]);
+                const auto acquireAllocInfo = VkCommandBufferAllocateInfo {
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    .commandPool = presentCommandPools[i],
+                    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                    .commandBufferCount = 1,
+                };
+                const auto resultAcquire = vkAllocateCommandBuffers(m_engine->getLogicalDevice(), &acquireAllocInfo, &presentAcquireCommandBuffers[i]);
+                if (resultRelease != VK_SUCCESS || resultAcquire != VK_SUCCESS) {
+                    throw std::runtime_error("failed to allocate present command buffers!");
+                }
+            }
+
+            m_presentCommandPools = std::move(presentCommandPools);
+            m_presentReleaseCommandBuffers = std::move(presentReleaseCommandBuffers);
+            m_presentAcquireCommandBuffers = std::move(presentAcquireCommandBuffers);
+        }
+
+        /// @brief Whether the present queue is of another queue family than the graphics
+        /// queue, so that the exclusively owned swap chain images change hands before they
+        /// are presented.
+        bool isPresentOwnershipTransferred() const {
+            return !m_isHeadless && m_engine->getPresentQueueFamilyIndex() != m_engine->getGraphicsQueueFamilyIndex();
+        }
+
+        VkSurfaceFormatKHR selectSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
+            return Engine::selectSurfaceFormat(availableFormats, SURFACE_FORMAT_POLICY);
+        }
+
+        VkPresentModeKHR selectSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
+            // We would probably want to use `VK_PRESENT_MODE_FIFO_KHR` on mobile devices.
+            return Engine::selectPresentMode(availablePresentModes, m_presentModePolicy);
+        }
+
+        VkExtent2D selectSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) {
+            if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+                return capabilities.currentExtent;
+            } else {
+                const auto framebufferExtent = m_engine->getFramebufferExtent();
+
+                const uint32_t width = std::clamp(
+                    framebufferExtent.width,
+                    capabilities.minImageExtent.width,
+                    capabilities.maxImageExtent.width
+                );
+                const uint32_t height = std::clamp(
+                    framebufferExtent.height, 
+                    capabilities.minImageExtent.height, 
+                    capabilities.maxImageExtent.height
+                );
+                const auto actualExtent = VkExtent2D {
+                    .width = width,
+                    .height = height,
+                };
+
+                return actualExtent;
+            }
+        }
+
+        void createSwapChain() {
+            if (m_isHeadless) {
+                this->createOffscreenImages();
+                return;
+            }
+
+            const auto swapChainSupport = m_engine->querySwapChainSupport(m_engine->getPhysicalDevice(), m_engine->getSurface());
+            const auto surfaceFormat = this->selectSwapSurfaceFormat(swapChainSupport.formats);
+            const auto presentMode = this->selectSwapPresentMode(swapChainSupport.presentModes);
+            const auto extent = this->selectSwapExtent(swapChainSupport.capabilities);
+            const auto imageCount = Engine::selectSwapChainImageCount(swapChainSupport.capabilities, presentMode, m_framesInFlight, m_swapChainImageCountPolicy);
+            // Concurrent sharing can turn framebuffer compression off, so the images are owned
+            // by one queue family at a time, and the frame hands them to the present queue
+            // family when that is another one.
+            const auto createInfo = VkSwapchainCreateInfoKHR {
+                .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+                .surface = m_engine->getSurface(),
+                .minImageCount = imageCount,
+                .imageFormat = surfaceFormat.format,
+                .imageColorSpace = surfaceFormat.colorSpace,
+                .imageExtent = extent,
+                .imageArrayLayers = 1,
+                .imageUsage = this->getColorTargetUsage(),
+                .imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .queueFamilyIndexCount = 0,
+                .pQueueFamilyIndices = nullptr,
+                .preTransform = swapChainSupport.capabilities.currentTransform,
+                .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+                .presentMode = presentMode,
+                .clipped = VK_TRUE,
+                // The old swap chain hands its resources over, and is destroyed later by
+                // `destroyRetiredSwapChains`.
+                .oldSwapchain = m_swapChain,
+            };
+
+            auto swapChain = VkSwapchainKHR {};
+            const auto result = vkCreateSwapchainKHR(m_engine->getLogicalDevice(), &createInfo, m_engine->getAllocationCallbacks(), &swapChain);
+            if (result != VK_SUCCESS) {
+                throw std::runtime_error("failed to create swap chain!");
+            }
+
+            uint32_t swapChainImageCount = 0;
+            vkGetSwapchainImagesKHR(m_engine->getLogicalDevice(), swapChain, &swapChainImageCount, nullptr);
+        
+            auto swapChainImages = std::vector<VkImage> { swapChainImageCount, VK_NULL_HANDLE };
+            vkGetSwapchainImagesKHR(m_engine->getLogicalDevice(), swapChain, &swapChainImageCount, swapChainImages.data());
+
+            m_swapChain = swapChain;
+            m_swapChainImages = std::move(swapChainImages);
+            m_swapChainImageFormat = surfaceFormat.format;
+            m_swapChainColorSpace = surfaceFormat.colorSpace;
+            m_swapChainExtent = extent;
+            m_swapChainGeneration++;
+        }
+
+        /// @brief Create the swap chain of viewport window `viewport` for its current extent,
+        /// and retire the one it replaces.
+        ///
+        /// @note The frame of the main window is blitted into its images, so their format
+        /// has to take blits, and the one of the main window has to give them.
+        void createViewportSwapChain(uint32_t viewport) {
+            const auto surface = m_engine->getViewportSurface(viewport);
+            const auto swapChainSupport = m_engine->querySwapChainSupport(m_engine->getPhysicalDevice(), surface);
+            const auto surfaceFormat = this->selectSwapSurfaceFormat(swapChainSupport.formats);
+            const auto presentMode = this->selectSwapPresentMode(swapChainSupport.presentModes);
+            const auto extent = [this, viewport, &capabilities = swapChainSupport.capabilities]() -> VkExtent2D {
+                if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+                    return capabilities.currentExtent;
+                }
+
+                const auto viewportExtent = m_engine->getViewportExtent(viewport);
+
+                return VkExtent2D {
+                    .width = std::clamp(viewportExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width),
+                    .height = std::clamp(viewportExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height),
+                };
+            }();
+            const auto imageCount = Engine::selectSwapChainImageCount(swapChainSupport.capabilities, presentMode, m_framesInFlight, m_swapChainImageCountPolicy);
+
+            const auto isBlittable = [this](VkFormat format, VkFormatFeatureFlags features) -> bool {
+                auto formatProperties = VkFormatProperties {};
+                vkGetPhysicalDeviceFormatProperties(m_engine->getPhysicalDevice(), format, &formatProperties);
+
+                return (formatProperties.optimalTilingFeatures & features) == features;
+            };
+            const auto isTransferDestination = (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0;
+            if (!isTransferDestination || !isBlittable(surfaceFormat.format, VK_FORMAT_FEATURE_BLIT_DST_BIT) || !isBlittable(m_swapChainImageFormat, VK_FORMAT_FEATURE_BLIT_SRC_BIT)) {
+                throw std::runtime_error("failed to create viewport swap chain: the frame cannot be blitted into it!");
+            }
+
+            auto& viewportSwapChain = m_viewportSwapChains[viewport];
+            const auto createInfo = VkSwapchainCreateInfoKHR {
+                .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+                .surface = surface,
+                .minImageCount = imageCount,
+                .imageFormat = surfaceFormat.format,
+                .imageColorSpace = surfaceFormat.colorSpace,
+                .imageExtent = extent,
+                .imageArrayLayers = 1,
+                .imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                .imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .queueFamilyIndexCount = 0,
+                .pQueueFamilyIndices = nullptr,
+                .preTransform = swapChainSupport.capabilities.currentTransform,
+                .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+                .presentMode = presentMode,
+                .clipped = VK_TRUE,
+                .oldSwapchain = viewportSwapChain.swapChain,
+            };
+
+            auto swapChain = VkSwapchainKHR {};
+            const auto result = vkCreateSwapchainKHR(m_engine->getLogicalDevice(), &createInfo, m_engine->getAllocationCallbacks(), &swapChain);
+            if (result != VK_SUCCESS) {
+                throw std::runtime_error("failed to create viewport swap chain!");
+            }
+
+            uint32_t swapChainImageCount = 0;
+            vkGetSwapchainImagesKHR(m_engine->getLogicalDevice(), swapChain, &swapChainImageCount, nullptr);
+
+            auto swapChainImages = std::vector<VkImage> { swapChainImageCount, VK_NULL_HANDLE };
+            vkGetSwapchainImagesKHR(m_engine->getLogicalDevice(), swapChain, &swapChainImageCount, swapChainImages.data());
+
+            // The old swap chain may still be blitted into by frames in flight.
+            if (viewportSwapChain.swapChain != VK_NULL_HANDLE) {
+                m_retiredViewportSwapChains.push_back(RetiredViewportSwapChain {
+                    .swapChain = viewportSwapChain.swapChain,
+                    .submitCount = m_submitCount,
+                    .frameSlot = m_lastPresentFrame,
+                });
+            }
+
+            viewportSwapChain = ViewportSwapChain {
+                .swapChain = swapChain,
+                .images = std::move(swapChainImages),
+                .extent = extent,
+                .isOutOfDate = false,
+            };
+        }
+
+        /// @brief Create the images a headless app renders into in place of a swap chain's,
+        /// one for every frame slot, with a layer for every view.
+        ///
+        /// @note Frame slot `i` always renders into image `i`, so its timeline wait also
+        /// covers the image, and nothing is acquired.
+        void createOffscreenImages() {
+            const auto usage = this->getColorTargetUsage() | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            if (m_exportFrames) {
+                this->createExportedImages(usage);
+
+                return;
+            }
+
+            auto images = std::vector<VkImage> {};
+            auto imageAllocations = std::vector<GpuAllocation> {};
+            for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+                const auto [image, imageAllocation] = m_engine->createImage(
+                    WIDTH,
+                    HEIGHT,
+                    1,
+                    VK_SAMPLE_COUNT_1_BIT,
+                    HEADLESS_IMAGE_FORMAT,
+                    VK_IMAGE_TILING_OPTIMAL,
+                    usage,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    0,
+                    m_viewCount
+                );
+                images.push_back(image);
+                imageAllocations.push_back(imageAllocation);
+            }
+
+            m_swapChainImages = std::move(images);
+            m_offscreenImageAllocations = std::move(imageAllocations);
+            m_swapChainImageFormat = HEADLESS_IMAGE_FORMAT;
+            m_swapChainColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+            m_swapChainExtent = VkExtent2D { WIDTH, HEIGHT };
+            m_swapChainGeneration++;
+        }
+
+        /// @brief Render into the images of the frame exporter in place of offscreen images of
+        /// the app's own, creating it the first time.
+        ///
+        /// @note The exporter owns its images, so retired swap chains never destroy them, and
+        /// the same images are rendered into for as long as the app runs.
+        void createExportedImages(VkImageUsageFlags usage) {
+            if (m_frameExporter == nullptr) {
+                if (!m_engine->supportsExternalMemoryFd()) {
+                    throw std::runtime_error("failed to export frames: the device cannot export memory as file descriptors!");
+                }
+
+                m_frameExporter = std::make_unique<FrameExporter>(
+                    m_engine->getPhysicalDevice(),
+                    m_engine->getLogicalDevice(),
+                    VkExtent2D { WIDTH, HEIGHT },
+                    HEADLESS_IMAGE_FORMAT,
+                    usage,
+                    MAX_FRAMES_IN_FLIGHT
+                );
+            }
+
+            m_swapChainImages = m_frameExporter->getImages();
+            m_offscreenImageAllocations.clear();
+            m_swapChainImageFormat = HEADLESS_IMAGE_FORMAT;
+            m_swapChainColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+            m_swapChainExtent = VkExtent2D { WIDTH, HEIGHT };
+            m_swapChainGeneration++;
+        }
+
+        /// @brief How the swap chain or offscreen images are used: as color attachments, as
+        /// blit destinations with dynamic resolution, and as blit sources with viewport
+        /// windows.
+        VkImageUsageFlags getColorTargetUsage() const {
+            auto usage = VkImageUsageFlags { VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+            if (m_dynamicResolution) {
+                usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            }
+            // The viewport windows are blitted into from the swap chain images.
+            if (m_viewportWindowCount > 0) {
+                usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            }
+
+            return usage;
+        }
+
+        /// @brief Whether the scene can be rendered at a scale and blitted into the color
+        /// target.
+        ///
+        /// @note The render pass is timed to pick the scale, so this takes the GPU profiler,
+        /// which only runs on a single device. The depth pyramid is built from the whole
+        /// depth image, and would see the depth outside the scaled extent, so the two do not
+        /// mix. The color target has to take linear blits, in the format it will have, and
+        /// only the single layer of a frame of one view is blitted.
+        bool canScaleResolution() {
+            if (!m_useDynamicRendering || m_gpuProfiler == nullptr || m_engine->getDeviceCount() != 1 || m_buildDepthPyramid || m_viewCount > 1) {
+                return false;
+            }
+
+            const auto format = [this]() -> std::optional<VkFormat> {
+                if (m_isHeadless) {
+                    return HEADLESS_IMAGE_FORMAT;
+                }
+
+                const auto swapChainSupport = m_engine->querySwapChainSupport(m_engine->getPhysicalDevice(), m_engine->getSurface());
+                if ((swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) == 0) {
+                    return std::nullopt;
+                }
+
+                return this->selectSwapSurfaceFormat(swapChainSupport.formats).format;
+            }();
+            if (!format.has_value()) {
+                return false;
+            }
+
+            const auto requiredFeatures = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT
+                | VK_FORMAT_FEATURE_BLIT_SRC_BIT
+                | VK_FORMAT_FEATURE_BLIT_DST_BIT
+                | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+            return m_engine->getDeviceCapabilities().hasOptimalTilingFeatures(*format, requiredFeatures);
+        }
+
+        /// @brief Whether the shading rate image can be built and attached: it is built from
+        /// the history of the temporal upscaler, and attached in dynamic rendering, which the
+        /// upscaler always renders with.
+        bool canBuildShadingRateImage() const {
+            if (!m_useTemporalUpscaling || !m_engine->supportsFragmentShadingRateAttachment()) {
+                return false;
+            }
+
+            const auto requiredFeatures = VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT
+                | VK_FORMAT_FEATURE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR
+                | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+
+            return m_engine->getDeviceCapabilities().hasOptimalTilingFeatures(ShadingRateImage::FORMAT, requiredFeatures);
+        }
+
+        /// @brief The pixels every texel of the shading rate image covers, as near to
+        /// `SHADING_RATE_TEXEL_SIZE` as the device allows.
+        VkExtent2D getShadingRateTexelSize() const {
+            const auto shadingRateProperties = m_engine->getFragmentShadingRateProperties();
+            const auto& minTexelSize = shadingRateProperties.minFragmentShadingRateAttachmentTexelSize;
+            const auto& maxTexelSize = shadingRateProperties.maxFragmentShadingRateAttachmentTexelSize;
+
+            return VkExtent2D {
+                .width = std::clamp(SHADING_RATE_TEXEL_SIZE, minTexelSize.width, maxTexelSize.width),
+                .height = std::clamp(SHADING_RATE_TEXEL_SIZE, minTexelSize.height, maxTexelSize.height),
+            };
+        }
+
+        /// @brief The extent the scene is rendered at, which is the swap chain extent unless
+        /// the resolution is dynamic.
+        VkExtent2D getRenderExtent() const {
+            if (m_dynamicResolution) {
+                return m_dynamicResolution->getRenderExtent(m_swapChainExtent);
+            } else {
+                return m_swapChainExtent;
+            }
+        }
+
+        /// @brief The layout a frame leaves its color target in: presentable for a swap
+        /// chain image, and ready to copy from for an offscreen one.
+        VkImageLayout getFinalColorLayout() const {
+            if (m_isHeadless) {
+                return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            } else {
+                return VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            }
+        }
+
+        /// @brief The views every pass renders with multiview, or zero when a frame renders a
+        /// single view without it.
+        uint32_t getViewMask() const {
+            return m_viewCount > 1 ? (1u << m_viewCount) - 1 : 0;
+        }
+
+        /// @brief The file this app writes in place of `path`, which is only different when
+        /// it is one of several render lanes.
+        std::filesystem::path getLaneFilePath(const std::filesystem::path& path) const {
+            if (m_laneCount > 1) {
+                return getLanePath(path, m_laneIndex);
+            } else {
+                return path;
+            }
+        }
+
+        /// @brief The devices of the device group that render into image `imageIndex`. With
+        /// alternate frame rendering each frame slot has a device of its own, and otherwise
+        /// every device takes part.
+        uint32_t getFrameDeviceMask(uint32_t imageIndex) const {
+            const auto deviceCount = m_engine->getDeviceCount();
+            if (m_engine->getDeviceGroupMode() == DeviceGroupMode::AlternateFrame) {
+                return 1u << (imageIndex % deviceCount);
+            } else {
+                return (1u << deviceCount) - 1;
+            }
+        }
+
+        /// @brief The strip of the frame each device renders with split frame rendering,
+        /// from the top down, or nothing when every device renders whole frames.
+        std::vector<VkRect2D> getDeviceRenderAreas() const {
+            if (m_engine->getDeviceGroupMode() != DeviceGroupMode::SplitFrame) {
+                return std::vector<VkRect2D> {};
+            }
+
+            const auto deviceCount = m_engine->getDeviceCount();
+            const auto stripHeight = (m_swapChainExtent.height + deviceCount - 1) / deviceCount;
+            auto renderAreas = std::vector<VkRect2D> {};
+            renderAreas.reserve(deviceCount);
+            for (uint32_t i = 0; i < deviceCount; i++) {
+                const auto top = std::min(i * stripHeight, m_swapChainExtent.height);
+                const auto bottom = std::min(top + stripHeight, m_swapChainExtent.height);
+                renderAreas.push_back(VkRect2D {
+                    .offset = VkOffset2D { 0, static_cast<int32_t>(top) },
+                    .extent = VkExtent2D { m_swapChainExtent.width, bottom - top },
+                });
+            }
+
+            return renderAreas;
+        }
+
+        /// @brief Copy the layer `arrayLayer` of the last frame out of its offscreen image and
+        /// write it to `filePath` as a binary PPM image.
+        ///
+        /// @note The device has to be idle.
+        void readBackFrame(const std::filesystem::path& filePath, uint32_t arrayLayer) {
+            const auto formatInfo = *TextureFormats::getInfo(HEADLESS_IMAGE_FORMAT);
+            const auto imageSize = formatInfo.getLevelSize(m_swapChainExtent.width, m_swapChainExtent.height);
+            auto [readbackBuffer, readbackBufferAllocation] = m_engine->createBuffer(
+                imageSize,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+
+            const auto allocInfo = VkCommandBufferAllocateInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = m_engine->getCommandPool(),
+                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                .commandBufferCount = 1,
+            };
+            auto commandBuffer = VkCommandBuffer {};
+            const auto resultAllocateCommandBuffers = vkAllocateCommandBuffers(m_engine->getLogicalDevice(), &allocInfo, &commandBuffer);
+            if (resultAllocateCommandBuffers != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate readback command buffer!");
+            }
+
+            // The copy runs on the devices that rendered the frame.
+            const auto deviceGroupBeginInfo = VkDeviceGroupCommandBufferBeginInfo {
+                .sType = VK_STRUCTURE_TYPE_DEVICE_GROUP_COMMAND_BUFFER_BEGIN_INFO,
+                .pNext = nullptr,
+                .deviceMask = this->getFrameDeviceMask(m_lastImageIndex),
+            };
+            const auto beginInfo = VkCommandBufferBeginInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .pNext = m_engine->getDeviceCount() > 1 ? &deviceGroupBeginInfo : nullptr,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            };
+            m_dispatch->vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+            // The frame left the image ready to copy from, but its writes still have to be
+            // made visible to the copy, and the copy's to the host.
+            const auto imageBarrier = VkImageMemoryBarrier {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = m_swapChainImages[m_lastImageIndex],
+                .subresourceRange = VkImageSubresourceRange {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = arrayLayer,
+                    .layerCount = 1,
+                },
+            };
+            m_dispatch->vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                1,
+                &imageBarrier
+            );
+            CommandCounters::add(CommandCounter::Barriers);
+
+            // With split frame rendering each device only has its own strip of the frame, so
+            // each one copies its strip into the readback buffer, which lives in host memory
+            // that every device shares.
+            const auto deviceRenderAreas = this->getDeviceRenderAreas();
+            if (deviceRenderAreas.empty()) {
+                const auto region = VkBufferImageCopy {
+                    .bufferOffset = 0,
+                    .bufferRowLength = 0,
+                    .bufferImageHeight = 0,
+                    .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .imageSubresource.mipLevel = 0,
+                    .imageSubresource.baseArrayLayer = arrayLayer,
+                    .imageSubresource.layerCount = 1,
+                    .imageOffset = VkOffset3D { 0, 0, 0 },
+                    .imageExtent = VkExtent3D { m_swapChainExtent.width, m_swapChainExtent.height, 1 },
+                };
+                m_dispatch->vkCmdCopyImageToBuffer(
+                    commandBuffer,
+                    m_swapChainImages[m_lastImageIndex],
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    readbackBuffer,
+                    1,
+                    &region
+                );
+            } else {
+                for (uint32_t i = 0; i < deviceRenderAreas.size(); i++) {
+                    const auto& renderArea = deviceRenderAreas[i];
+                    const auto region = VkBufferImageCopy {
+                        .bufferOffset = formatInfo.getLevelSize(m_swapChainExtent.width, static_cast<uint32_t>(renderArea.offset.y)),
+                        .bufferRowLength = m_swapChainExtent.width,
+                        .bufferImageHeight = 0,
+                        .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .imageSubresource.mipLevel = 0,
+                        .imageSubresource.baseArrayLayer = arrayLayer,
+                        .imageSubresource.layerCount = 1,
+                        .imageOffset = VkOffset3D { renderArea.offset.x, renderArea.offset.y, 0 },
+                        .imageExtent = VkExtent3D { renderArea.extent.width, renderArea.extent.height, 1 },
+                    };
+                    m_dispatch->vkCmdSetDeviceMask(commandBuffer, 1u << i);
+                    m_dispatch->vkCmdCopyImageToBuffer(
+                        commandBuffer,
+                        m_swapChainImages[m_lastImageIndex],
+                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                        readbackBuffer,
+                        1,
+                        &region
+                    );
+                }
+                m_dispatch->vkCmdSetDeviceMask(commandBuffer, this->getFrameDeviceMask(m_lastImageIndex));
+            }
+
+            const auto bufferBarrier = VkBufferMemoryBarrier {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .buffer = readbackBuffer,
+                .offset = 0,
+                .size = VK_WHOLE_SIZE,
+            };
+            m_dispatch->vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_HOST_BIT,
+                0,
+                0,
+                nullptr,
+                1,
+                &bufferBarrier,
+                0,
+                nullptr
+            );
+            CommandCounters::add(CommandCounter::Barriers);
+
+            const auto resultEndCommandBuffer = m_dispatch->vkEndCommandBuffer(commandBuffer);
+            if (resultEndCommandBuffer != VK_SUCCESS) {
+                throw std::runtime_error("failed to record readback command buffer!");
+            }
+
+            m_engine->getQueueSubmitter().submit(
+                m_engine->getGraphicsQueue(),
+                QueueSubmission { .commandBuffers = std::vector<VkCommandBuffer> { commandBuffer } }
+            );
+
+            vkQueueWaitIdle(m_engine->getGraphicsQueue());
+            vkFreeCommandBuffers(m_engine->getLogicalDevice(), m_engine->getCommandPool(), 1, &commandBuffer);
+
+            // PPM stores three channels, so alpha is dropped.
+            const auto pixelCount = static_cast<size_t>(m_swapChainExtent.width) * m_swapChainExtent.height;
+            const auto* pixels = static_cast<const uint8_t*>(readbackBufferAllocation.mappedData);
+            auto rgbPixels = std::vector<uint8_t>(pixelCount * 3);
+            for (size_t i = 0; i < pixelCount; i++) {
+                rgbPixels[3 * i + 0] = pixels[4 * i + 0];
+                rgbPixels[3 * i + 1] = pixels[4 * i + 1];
+                rgbPixels[3 * i + 2] = pixels[4 * i + 2];
+            }
+
+            m_engine->destroyBuffer(readbackBuffer, readbackBufferAllocation);
+
+            if (filePath.has_parent_path()) {
+                std::filesystem::create_directories(filePath.parent_path());
+            }
+
+            auto file = std::ofstream { filePath, std::ios::out | std::ios::binary | std::ios::trunc };
+            if (!file.is_open()) {
+                throw std::runtime_error("failed to open readback file!");
+            }
+
+            file << fmt::format("P6\n{} {}\n255\n", m_swapChainExtent.width, m_swapChainExtent.height);
+            file.write(reinterpret_cast<const char*>(rgbPixels.data()), static_cast<std::streamsize>(rgbPixels.size()));
+            fmt::println("Frame written to {}", filePath.string());
+        }
+
+        /// @brief Set up the ring that headless frames are captured through, writing them in
+        /// the richest encoding the offscreen format has.
+        void createFrameCapture() {
+            m_captureEncoding = [this]() -> CaptureEncoding {
+                if (FrameCapture::isEncodable(m_swapChainImageFormat, CaptureEncoding::Ppm)) {
+                    return CaptureEncoding::Ppm;
+                } else if (FrameCapture::isEncodable(m_swapChainImageFormat, CaptureEncoding::Pfm)) {
+                    return CaptureEncoding::Pfm;
+                } else {
+                    return CaptureEncoding::Raw;
+                }
+            }();
+            m_frameCapture = std::make_unique<FrameCapture>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_engine->getGraphicsQueueFamilyIndex(),
+                m_swapChainExtent,
+                m_swapChainImageFormat,
+                // Every view of a frame takes a slot of its own.
+                CAPTURE_SLOT_COUNT * m_viewCount
+            );
+        }
+
+        /// @brief Capture the offscreen image the frame just submitted renders into, after
+        /// it on the graphics queue, one file per view.
+        void captureFrame(uint32_t imageIndex) {
+            CPU_PROFILE_ZONE("capture");
+            const auto extension = [this]() -> std::string_view {
+                switch (m_captureEncoding) {
+                    case CaptureEncoding::Ppm:
+                        return "ppm";
+                    case CaptureEncoding::Pfm:
+                        return "pfm";
+                    case CaptureEncoding::Raw:
+                        return "raw";
+                }
+
+                return "raw";
+            }();
+            if (m_viewCount == 1) {
+                const auto filePath = *m_captureDirectory / fmt::format("frame_{:06}.{}", m_submitCount, extension);
+                m_frameCapture->capture(m_engine->getGraphicsQueue(), m_swapChainImages[imageIndex], 0, filePath, m_captureEncoding);
+
+                return;
+            }
+
+            for (uint32_t view = 0; view < m_viewCount; view++) {
+                const auto filePath = *m_captureDirectory / fmt::format("frame_{:06}_view{}.{}", m_submitCount, view, extension);
+                m_frameCapture->capture(m_engine->getGraphicsQueue(), m_swapChainImages[imageIndex], view, filePath, m_captureEncoding);
+            }
+        }
+
+        void createImageViews() {
+            auto swapChainImageViews = std::vector<VkImageView> { m_swapChainImages.size(), VK_NULL_HANDLE };
+            for (size_t i = 0; i < m_swapChainImages.size(); i++) {
+                auto swapChainImageView = this->createImageView(m_swapChainImages[i], m_swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1, m_viewCount);
+                swapChainImageViews[i] = swapChainImageView;
+            }
+
+            m_swapChainImageViews = std::move(swapChainImageViews);
+        }
+
+        /// @brief Create the render pass the frame is drawn in without dynamic rendering.
+        ///
+        /// @note With the post process subpass, the first subpass draws the scene into its
+        /// input, or resolves into it, and the second reads it at every pixel and writes the
+        /// swap chain image, the last attachment. The input is never stored, so on tile-based
+        /// GPUs it stays on chip between the two.
+        void createRenderPass() {
+            // With multisampling, the color attachment is the multisampled target, which is
+            // resolved into the swap chain image, or the post process input, and then
+            // discarded.
+            const auto isMultisampled = m_msaaSamples != VK_SAMPLE_COUNT_1_BIT;
+            const auto isPostProcessed = m_usePostProcessSubpass;
+            // The post effects read the post process input after the pass, so it is stored.
+            const auto isPostProcessInputDiscarded = isPostProcessed && !this->isPostProcessInputSampled();
+            const auto sceneColorLayout = isPostProcessed ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : this->getFinalColorLayout();
+            const auto colorAttachment = VkAttachmentDescription {
+                .format = this->getSceneColorFormat(),
+                .samples = m_msaaSamples,
+                .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                .storeOp = isMultisampled || isPostProcessInputDiscarded ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE,
+                .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+                .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .finalLayout = isMultisampled ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : sceneColorLayout,
+            };
+            const auto depthAttachment = VkAttachmentDescription {
+                .format = this->findDepthFormat(),
+                .samples = m_msaaSamples,
+                .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                .storeOp = this->isDepthSampled() ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+                .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            };
+            const auto colorAttachmentRef = VkAttachmentReference {
+                .attachment = 0,
+                .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            };
+            const auto depthAttachmentRef = VkAttachmentReference {
+                .attachment = 1,
+                .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            };
+            const auto resolveAttachment = VkAttachmentDescription {
+                .format = this->getSceneColorFormat(),
+                .samples = VK_SAMPLE_COUNT_1_BIT,
+                .loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+                .storeOp = isPostProcessInputDiscarded ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE,
+                .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+                .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .finalLayout = sceneColorLayout,
+            };
+            const auto resolveAttachmentRef = VkAttachmentReference {
+                .attachment = 2,
+                .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            };
+            const auto swapChainAttachment = VkAttachmentDescription {
+                .format = m_swapChainImageFormat,
+                .samples = VK_SAMPLE_COUNT_1_BIT,
+                .loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+                .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+                .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+                .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .finalLayout = this->getFinalColorLayout(),
+            };
+            const auto postProcessInputRef = VkAttachmentReference {
+                .attachment = isMultisampled ? 2u : 0u,
+                .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            };
+            const auto swapChainAttachmentRef = VkAttachmentReference {
+                .attachment = isMultisampled ? 3u : 2u,
+                .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            };
+            const auto subpasses = std::array<VkSubpassDescription, 2> {
+                VkSubpassDescription {
+                    .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    .colorAttachmentCount = 1,
+                    .pColorAttachments = &colorAttachmentRef,
+                    .pResolveAttachments = isMultisampled ? &resolveAttachmentRef : nullptr,
+                    .pDepthStencilAttachment = &depthAttachmentRef,
+                },
+                VkSubpassDescription {
+                    .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    .inputAttachmentCount = 1,
+                    .pInputAttachments = &postProcessInputRef,
+                    .colorAttachmentCount = 1,
+                    .pColorAttachments = &swapChainAttachmentRef,
+                },
+            };
+
+            // The post process input of the frame before may still be read when the next
+            // frame draws into it again.
+            const auto postProcessReadStages = isPostProcessed ? VkPipelineStageFlags { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT } : VkPipelineStageFlags { 0 };
+            const auto dependencies = std::array<VkSubpassDependency, 3> {
+                VkSubpassDependency {
+                    .srcSubpass = VK_SUBPASS_EXTERNAL,
+                    .dstSubpass = 0,
+                    .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | postProcessReadStages,
+                    .srcAccessMask = 0,
+                    .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+                    .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                },
+                // Every pixel only reads the input at its own position, so the dependency is
+                // by region and the tile never has to be flushed.
+                VkSubpassDependency {
+                    .srcSubpass = 0,
+                    .dstSubpass = 1,
+                    .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                    .dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                    .dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+                    .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT,
+                },
+                VkSubpassDependency {
+                    .srcSubpass = VK_SUBPASS_EXTERNAL,
+                    .dstSubpass = 1,
+                    .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    .srcAccessMask = 0,
+                    .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                },
+            };
+
+            const auto attachments = [&colorAttachment, &depthAttachment, &resolveAttachment, &swapChainAttachment, isMultisampled, isPostProcessed]() -> std::vector<VkAttachmentDescription> {
+                auto attachments = std::vector<VkAttachmentDescription> { colorAttachment, depthAttachment };
+                if (isMultisampled) {
+                    attachments.push_back(resolveAttachment);
+                }
+                if (isPostProcessed) {
+                    attachments.push_back(swapChainAttachment);
+                }
+
+                return attachments;
+            }();
+            // Multiview frames have no post process subpass, so one view mask covers them.
+            const auto viewMask = this->getViewMask();
+            const auto multiviewInfo = VkRenderPassMultiviewCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO,
+                .subpassCount = 1,
+                .pViewMasks = &viewMask,
+            };
+            const auto renderPassInfo = VkRenderPassCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+                .pNext = viewMask != 0 ? &multiviewInfo : nullptr,
+                .attachmentCount = static_cast<uint32_t>(attachments.size()),
+                .pAttachments = attachments.data(),
+                .subpassCount = isPostProcessed ? 2u : 1u,
+                .pSubpasses = subpasses.data(),
+                .dependencyCount = isPostProcessed ? 3u : 1u,
+                .pDependencies = dependencies.data(),
+            };
+
+            auto renderPass = VkRenderPass {};
+            const auto result = vkCreateRenderPass(m_engine->getLogicalDevice(), &renderPassInfo, m_engine->getAllocationCallbacks(), &renderPass);
+            if (result != VK_SUCCESS) {
+                throw std::runtime_error("failed to create render pass!");
+            }
+
+            m_renderPass = renderPass;
+        }
+
+        /// @brief Create the pipeline of the second subpass of the render pass, which draws a
+        /// triangle over the swap chain image that tone maps, grades and encodes the scene
+        /// color at every pixel, adding the bloom and exposing for the average luminance of
+        /// the frame before when they are built.
+        ///
+        /// @note The pipeline is small, and no frame can be shown without it, so it is
+        /// built right away instead of on the pipeline compiler.
+        void createPostProcessPipeline() {
+            const auto bindings = std::array<VkDescriptorSetLayoutBinding, 4> {
+                VkDescriptorSetLayoutBinding {
+                    .binding = 0,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
+                    .descriptorCount = 1,
+                    .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                    .pImmutableSamplers = nullptr,
+                },
+                VkDescriptorSetLayoutBinding {
+                    .binding = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                    .descriptorCount = 1,
+                    .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                    .pImmutableSamplers = nullptr,
+                },
+                VkDescriptorSetLayoutBinding {
+                    .binding = 2,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                    .descriptorCount = 1,
+                    .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                    .pImmutableSamplers = nullptr,
+                },
+                VkDescriptorSetLayoutBinding {
+                    .binding = 3,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+                    .descriptorCount = 1,
+                    .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                    .pImmutableSamplers = nullptr,
+                },
+            };
+            // The bloom and the average luminance are only bound when they are built, and
+            // the shader is specialized not to touch them otherwise.
+            const auto bindingFlags = std::array<VkDescriptorBindingFlags, 4> {
+                0,
+                VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+                VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+                VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+            };
+            const auto bindingFlagsInfo = VkDescriptorSetLayoutBindingFlagsCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+                .bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+                .pBindingFlags = bindingFlags.data(),
+            };
+            const auto setLayoutInfo = VkDescriptorSetLayoutCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                .pNext = &bindingFlagsInfo,
+                .bindingCount = static_cast<uint32_t>(bindings.size()),
+                .pBindings = bindings.data(),
+            };
+
+            auto setLayout = VkDescriptorSetLayout {};
+            const auto resultCreateSetLayout = vkCreateDescriptorSetLayout(m_engine->getLogicalDevice(), &setLayoutInfo, m_engine->getAllocationCallbacks(), &setLayout);
+            if (resultCreateSetLayout != VK_SUCCESS) {
+                throw std::runtime_error("failed to create post process descriptor set layout!");
+            }
+
+            m_postProcessSetLayout = setLayout;
+
+            const auto pushConstantRange = VkPushConstantRange {
+                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .offset = 0,
+                .size = sizeof(PostProcessPushConstants),
+            };
+            const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                .setLayoutCount = 1,
+                .pSetLayouts = &m_postProcessSetLayout,
+                .pushConstantRangeCount = 1,
+                .pPushConstantRanges = &pushConstantRange,
+            };
+
+            auto pipelineLayout = VkPipelineLayout {};
+            const auto resultCreatePipelineLayout = vkCreatePipelineLayout(m_engine->getLogicalDevice(), &pipelineLayoutInfo, m_engine->getAllocationCallbacks(), &pipelineLayout);
+            if (resultCreatePipelineLayout != VK_SUCCESS) {
+                throw std::runtime_error("failed to create post process pipeline layout!");
+            }
+
+            m_postProcessPipelineLayout = pipelineLayout;
+
+            const auto vertexStageCode = this->getShaderStageCode(HlslShader::FullscreenVert);
+            const auto fragmentStageCode = this->getShaderStageCode(HlslShader::PostProcessFrag);
+            const auto specialization = PostProcessSpecialization {
+                .outputEncoding = static_cast<uint32_t>(this->getOutputEncoding()),
+                .paperWhiteNits = HDR_PAPER_WHITE_NITS,
+                .bloom = POST_PROCESS_BLOOM ? VK_TRUE : VK_FALSE,
+                .autoExposure = POST_PROCESS_AUTO_EXPOSURE ? VK_TRUE : VK_FALSE,
+            };
+            constexpr auto specializationEntries = PostProcessSpecialization::getMapEntries();
+            const auto specializationInfo = VkSpecializationInfo {
+                .mapEntryCount = static_cast<uint32_t>(specializationEntries.size()),
+                .pMapEntries = specializationEntries.data(),
+                .dataSize = sizeof(PostProcessSpecialization),
+                .pData = &specialization,
+            };
+            const auto shaderStages = std::array<VkPipelineShaderStageCreateInfo, 2> {
+                vertexStageCode.getStageInfo(VK_SHADER_STAGE_VERTEX_BIT),
+                fragmentStageCode.getStageInfo(VK_SHADER_STAGE_FRAGMENT_BIT, &specializationInfo),
+            };
+            const auto vertexInputInfo = VkPipelineVertexInputStateCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+            };
+            const auto inputAssembly = VkPipelineInputAssemblyStateCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+                .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+                .primitiveRestartEnable = VK_FALSE,
+            };
+            const auto viewportState = VkPipelineViewportStateCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+                .viewportCount = 1,
+                .scissorCount = 1,
+            };
+            const auto rasterizer = VkPipelineRasterizationStateCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
                 .depthClampEnable = VK_FALSE,
                 .rasterizerDiscardEnable = VK_FALSE,
                 .polygonMode = VK_POLYGON_MODE_FILL,
                 .lineWidth = 1.0f,
-                .cullMode = VK_CULL_MODE_BACK_BIT,
-                // .frontFace = VK_FRONT_FACE_CLOCKWISE,
+                .cullMode = VK_CULL_MODE_NONE,
                 .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
                 .depthBiasEnable = VK_FALSE,
             };
-            const auto multisampling = VkPipelineMultisampleStateCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-                .sampleShadingEnable = VK_FALSE,
-                .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
-                .pSampleMask = nullptr,            // Optional.
-                .alphaToCoverageEnable = VK_FALSE, // Optional.
-                .alphaToOneEnable = VK_FALSE,      // Optional.
+            const auto multisampling = VkPipelineMultisampleStateCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+                .sampleShadingEnable = VK_FALSE,
+                .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+                .pSampleMask = nullptr,
+                .alphaToCoverageEnable = VK_FALSE,
+                .alphaToOneEnable = VK_FALSE,
+            };
+            const auto colorBlendAttachment = VkPipelineColorBlendAttachmentState {
+                .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+                .blendEnable = VK_FALSE,
+            };
+            const auto colorBlending = VkPipelineColorBlendStateCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+                .logicOpEnable = VK_FALSE,
+                .logicOp = VK_LOGIC_OP_COPY,
+                .attachmentCount = 1,
+                .pAttachments = &colorBlendAttachment,
+            };
+            const auto dynamicStates = std::array<VkDynamicState, 2> {
+                VK_DYNAMIC_STATE_VIEWPORT,
+                VK_DYNAMIC_STATE_SCISSOR,
+            };
+            const auto dynamicState = VkPipelineDynamicStateCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+                .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+                .pDynamicStates = dynamicStates.data(),
+            };
+            const auto pipelineInfo = VkGraphicsPipelineCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                .stageCount = static_cast<uint32_t>(shaderStages.size()),
+                .pStages = shaderStages.data(),
+                .pVertexInputState = &vertexInputInfo,
+                .pInputAssemblyState = &inputAssembly,
+                .pViewportState = &viewportState,
+                .pRasterizationState = &rasterizer,
+                .pMultisampleState = &multisampling,
+                .pDepthStencilState = nullptr,
+                .pColorBlendState = &colorBlending,
+                .pDynamicState = &dynamicState,
+                .layout = m_postProcessPipelineLayout,
+                .renderPass = m_renderPass,
+                .subpass = 1,
+                .basePipelineHandle = VK_NULL_HANDLE,
+                .basePipelineIndex = -1,
+            };
+
+            auto pipeline = VkPipeline {};
+            const auto resultCreateGraphicsPipeline = vkCreateGraphicsPipelines(
+                m_engine->getLogicalDevice(),
+                m_engine->getPipelineCache(),
+                1,
+                &pipelineInfo,
+                m_engine->getAllocationCallbacks(),
+                &pipeline
+            );
+            // The pipeline is built before this returns, so its modules are not needed
+            // after it.
+            this->releaseShaderStageCode(vertexStageCode);
+            this->releaseShaderStageCode(fragmentStageCode);
+            if (resultCreateGraphicsPipeline != VK_SUCCESS) {
+                throw std::runtime_error("failed to create post process pipeline!");
+            }
+
+            m_postProcessPipeline = pipeline;
+        }
+
+        /// @brief The formats of the attachments that pipelines render to.
+        AttachmentFormats getAttachmentFormats() {
+            return AttachmentFormats {
+                .colorFormat = this->getSceneColorFormat(),
+                .depthFormat = this->findDepthFormat(),
+                .sampleCount = m_msaaSamples,
+                .viewMask = this->getViewMask(),
+            };
+        }
+
+        void createGraphicsPipeline() {
+            const auto pushConstantRange = this->getPushConstantRange(
+                this->reflectVertexPipelineShaders(),
+                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                sizeof(DrawPushConstants)
+            );
+            // Pulled vertices come from the vertex buffer in a set of its own, after the sets
+            // the vertex pipeline shares with the mesh shader pipeline.
+            auto setLayouts = std::vector<VkDescriptorSetLayout> {
+                m_descriptorSetLayout,
+                m_textureTableSetLayout,
+            };
+            if (m_pullVertices) {
+                setLayouts.push_back(m_vertexPullDescriptorSetLayout);
+            }
+
+            m_pipelineLayout = m_engine->getPipelineLayoutCache().getPipelineLayout(setLayouts, { &pushConstantRange, 1 });
+            m_graphicsPipeline = this->enqueueGraphicsPipeline();
+            if (m_useDepthPrepass) {
+                m_depthPrepassPipeline = this->enqueueDepthPrepassPipeline();
+            }
+            if (m_useOcclusionQueries) {
+                m_occlusionProxyPipeline = this->enqueueOcclusionProxyPipeline();
+            }
+            m_needsOptimizedLinks = this->usesFastPipelineLinks();
+        }
+
+        /// @brief Whether the pipelines are linked out of library parts without running the
+        /// optimizer over them.
+        bool usesFastPipelineLinks() const {
+            return m_pipelineLibrary != nullptr && !m_pipelineLibrary->isLinkOptimized();
+        }
+
+        /// @brief Destroy the library parts built against `renderPass`, which is about to be
+        /// destroyed.
+        void evictPipelineParts(VkRenderPass renderPass) {
+            if (m_pipelineLibrary != nullptr) {
+                m_pipelineLibrary->evictParts(renderPass);
+            }
+        }
+
+        /// @brief Start building the vertex pipeline with the current shaders, against
+        /// `m_pipelineLayout` and the attachments of the swap chain.
+        ///
+        /// @note After a depth prepass, the pipeline tests for the depth the prepass wrote
+        /// and leaves it as it is. When vertices are pulled, the vertex input only describes
+        /// the instance transforms. A pipeline linked out of library parts runs the
+        /// optimizer over the link when `isLinkOptimized` is set.
+        PipelineHandle enqueueGraphicsPipeline(bool isLinkOptimized = false) {
+            const auto vertexShader = m_pullVertices ? HlslShader::VertexPullVert : HlslShader::ShaderVert;
+            const auto vertexStageCode = this->getShaderStageCode(vertexShader);
+            const auto fragmentStageCode = this->getShaderStageCode(HlslShader::ShaderFrag);
+
+            // Everything the build points at is created inside it, so it can run on a
+            // compiler worker after this function returns.
+            const auto pipelineLayout = m_pipelineLayout;
+            const auto renderPass = m_renderPass;
+            const auto attachmentFormats = this->getAttachmentFormats();
+            const auto fragmentSpecialization = this->getFragmentSpecialization();
+            const auto pullVertices = m_pullVertices;
+            const auto pipelineFlags = this->getPipelineCreateFlags();
+            const auto drawState = this->getDrawState(m_useDepthPrepass);
+            const auto dynamicStates = this->getDynamicStates(true);
+            auto* pipelineLibrary = m_pipelineLibrary.get();
+            const auto partKeys = this->getPipelinePartKeys("vertex", this->getShaderCode(vertexShader), this->getShaderCode(HlslShader::ShaderFrag));
+            const auto graphicsPipelineHandle = m_engine->getPipelineCompiler().enqueue([vertexStageCode, fragmentStageCode, pipelineLayout, renderPass, attachmentFormats, fragmentSpecialization, pullVertices, pipelineFlags, pipelineLibrary, partKeys, isLinkOptimized, drawState, dynamicStates](VkDevice device, VkPipelineCache pipelineCache) -> VkPipeline {
+                constexpr auto fragmentSpecializationEntries = FragmentSpecialization::getMapEntries();
+                const auto fragmentSpecializationInfo = VkSpecializationInfo {
+                    .mapEntryCount = static_cast<uint32_t>(fragmentSpecializationEntries.size()),
+                    .pMapEntries = fragmentSpecializationEntries.data(),
+                    .dataSize = sizeof(FragmentSpecialization),
+                    .pData = &fragmentSpecialization,
+                };
+                const auto shaderStages = std::array<VkPipelineShaderStageCreateInfo, 2> {
+                    vertexStageCode.getStageInfo(VK_SHADER_STAGE_VERTEX_BIT),
+                    fragmentStageCode.getStageInfo(VK_SHADER_STAGE_FRAGMENT_BIT, &fragmentSpecializationInfo)
+                };
+                auto bindingDescriptions = [pullVertices]() -> std::vector<VkVertexInputBindingDescription> {
+                    if (pullVertices) {
+                        return std::vector<VkVertexInputBindingDescription> {};
+                    } else if (SPLIT_VERTEX_STREAMS) {
+                        constexpr auto splitBindingDescriptions = GpuVertex::getSplitBindingDescriptions();
+
+                        return std::vector<VkVertexInputBindingDescription>(splitBindingDescriptions.begin(), splitBindingDescriptions.end());
+                    } else {
+                        return std::vector<VkVertexInputBindingDescription> { GpuVertex::getBindingDescription() };
+                    }
+                }();
+                auto attributeDescriptions = [pullVertices]() -> std::vector<VkVertexInputAttributeDescription> {
+                    if (pullVertices) {
+                        return std::vector<VkVertexInputAttributeDescription> {};
+                    } else if (SPLIT_VERTEX_STREAMS) {
+                        constexpr auto splitAttributeDescriptions = GpuVertex::getSplitAttributeDescriptions();
+
+                        return std::vector<VkVertexInputAttributeDescription>(splitAttributeDescriptions.begin(), splitAttributeDescriptions.end());
+                    } else {
+                        constexpr auto interleavedAttributeDescriptions = GpuVertex::getAttributeDescriptions();
+
+                        return std::vector<VkVertexInputAttributeDescription>(interleavedAttributeDescriptions.begin(), interleavedAttributeDescriptions.end());
+                    }
+                }();
+                // The instance transforms follow the vertex streams, in a binding of their own,
+                // and keep the locations after the vertex attributes when there are none.
+                const auto instanceBinding = static_cast<uint32_t>(bindingDescriptions.size());
+                const auto instanceAttributeDescriptions = InstanceTransform::getAttributeDescriptions(
+                    instanceBinding,
+                    static_cast<uint32_t>(GpuVertex::getAttributeDescriptions().size())
+                );
+                bindingDescriptions.push_back(InstanceTransform::getBindingDescription(instanceBinding));
+                attributeDescriptions.insert(attributeDescriptions.end(), instanceAttributeDescriptions.begin(), instanceAttributeDescriptions.end());
+                const auto vertexInputInfo = VkPipelineVertexInputStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+                    .vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size()),
+                    .vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
+                    .pVertexBindingDescriptions = bindingDescriptions.data(),
+                    .pVertexAttributeDescriptions = attributeDescriptions.data(),
+                };
+                const auto inputAssembly = VkPipelineInputAssemblyStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+                    .topology = drawState.topology,
+                    .primitiveRestartEnable = VK_FALSE,
+                };
+
+                // Without dynamic state, the viewport and scissor rectangle need to be set 
+                // in the pipeline using the `VkPipelineViewportStateCreateInfo` struct. This
+                // makes the viewport and scissor rectangle for this pipeline immutable.
+                // Any changes to these values would require a new pipeline to be created with
+                // the new values.
+                // ```
+                // const auto viewportState = VkPipelineViewportStateCreateInfo {
+                //     .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+                //     .viewportCount = 1,
+                //     .pViewports = &viewport,
+                //     .scissorCount = 1,
+                //     .pScissors = &scissor,
+                // };
+                // ```
+                const auto viewportState = VkPipelineViewportStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+                    .viewportCount = 1,
+                    .scissorCount = 1,
+                };
+                const auto rasterizer = VkPipelineRasterizationStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+                    .depthClampEnable = VK_FALSE,
+                    .rasterizerDiscardEnable = VK_FALSE,
+                    .polygonMode = VK_POLYGON_MODE_FILL,
+                    .lineWidth = 1.0f,
+                    .cullMode = drawState.cullMode,
+                    // .frontFace = VK_FRONT_FACE_CLOCKWISE,
+                    .frontFace = drawState.frontFace,
+                    .depthBiasEnable = VK_FALSE,
+                };
+                const auto multisampling = VkPipelineMultisampleStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+                    .sampleShadingEnable = VK_FALSE,
+                    .rasterizationSamples = attachmentFormats.sampleCount,
+                    .pSampleMask = nullptr,            // Optional.
+                    .alphaToCoverageEnable = VK_FALSE, // Optional.
+                    .alphaToOneEnable = VK_FALSE,      // Optional.
+                };
+                const auto depthStencil = VkPipelineDepthStencilStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+                    .depthTestEnable = drawState.depthTestEnable,
+                    .depthWriteEnable = drawState.depthWriteEnable,
+                    .depthCompareOp = drawState.depthCompareOp,
+                    .depthBoundsTestEnable = VK_FALSE,
+                    .stencilTestEnable = VK_FALSE,
+                };
+                const auto colorBlendAttachment = VkPipelineColorBlendAttachmentState {
+                    .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+                    .blendEnable = VK_FALSE,
+                    .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,  // Optional
+                    .dstColorBlendFactor = VK_BLEND_FACTOR_ZERO, // Optional
+                    .colorBlendOp = VK_BLEND_OP_ADD,             // Optional
+                    .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,  // Optional
+                    .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO, // Optional
+                    .alphaBlendOp = VK_BLEND_OP_ADD,             // Optional
+                    // // Alpha blending:
+                    // // finalColor.rgb = newAlpha * newColor + (1 - newAlpha) * oldColor,
+                    // // finalColor.a = newAlpha.a,
+                    // .blendEnable = VK_TRUE,
+                    // .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+                    // .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+                    // .colorBlendOp = VK_BLEND_OP_ADD,
+                    // .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+                    // .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+                    // .alphaBlendOp = VK_BLEND_OP_ADD,
+                };
+                const auto colorBlending = VkPipelineColorBlendStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+                    .logicOpEnable = VK_FALSE,
+                    .logicOp = VK_LOGIC_OP_COPY,
+                    .attachmentCount = 1,
+                    .pAttachments = &colorBlendAttachment,
+                    .blendConstants[0] = 0.0f,
+                    .blendConstants[1] = 0.0f,
+                    .blendConstants[2] = 0.0f,
+                    .blendConstants[3] = 0.0f,
+                };
+
+                const auto dynamicState = VkPipelineDynamicStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+                    .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+                    .pDynamicStates = dynamicStates.data(),
+                };
+
+                // Without a render pass, the pipeline is created against the attachment formats.
+                const auto renderingInfo = VkPipelineRenderingCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+                    .viewMask = attachmentFormats.viewMask,
+                    .colorAttachmentCount = 1,
+                    .pColorAttachmentFormats = &attachmentFormats.colorFormat,
+                    .depthAttachmentFormat = attachmentFormats.depthFormat,
+                    .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+                };
+                const auto pipelineInfo = VkGraphicsPipelineCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                    .pNext = renderPass == VK_NULL_HANDLE ? &renderingInfo : nullptr,
+                    .flags = pipelineFlags,
+                    .stageCount = 2,
+                    .pStages = shaderStages.data(),
+                    .pVertexInputState = &vertexInputInfo,
+                    .pInputAssemblyState = &inputAssembly,
+                    .pViewportState = &viewportState,
+                    .pRasterizationState = &rasterizer,
+                    .pMultisampleState = &multisampling,
+                    .pDepthStencilState = &depthStencil,
+                    .pColorBlendState = &colorBlending,
+                    .pDynamicState = &dynamicState,
+                    .layout = pipelineLayout,
+                    .renderPass = renderPass,
+                    .subpass = 0,
+                    .basePipelineHandle = VK_NULL_HANDLE, // Optional
+                    .basePipelineIndex = -1,              // Optional
+                };
+
+                if (pipelineLibrary != nullptr) {
+                    return pipelineLibrary->createPipeline(pipelineCache, pipelineInfo, partKeys, isLinkOptimized);
+                }
+
+                auto graphicsPipeline = VkPipeline {};
+                const auto resultCreateGraphicsPipeline = vkCreateGraphicsPipelines(
+                    device, 
+                    pipelineCache, 
+                    1, 
+                    &pipelineInfo, 
+                    nullptr, 
+                    &graphicsPipeline
+                );
+
+                if (resultCreateGraphicsPipeline != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create graphics pipeline!");
+                }
+
+                return graphicsPipeline;
+            });
+            this->keepShaderStageCode(graphicsPipelineHandle, { vertexStageCode, fragmentStageCode });
+
+            return graphicsPipelineHandle;
+        }
+
+        /// @brief Start building the depth prepass pipeline with the current shader, against
+        /// `m_pipelineLayout` and the attachments of the swap chain.
+        ///
+        /// @note The pipeline reads positions and instance transforms from the vertex
+        /// pipeline's bindings, so the two draw from the same bound buffers. It has no
+        /// fragment shader and writes no color, only depth. When vertices are pulled, it
+        /// runs the vertex pipeline's own vertex shader, whose positions it matches exactly.
+        /// Links are optimized like the vertex pipeline's.
+        PipelineHandle enqueueDepthPrepassPipeline(bool isLinkOptimized = false) {
+            const auto vertexShader = m_pullVertices ? HlslShader::VertexPullVert : HlslShader::DepthVert;
+            const auto vertexStageCode = this->getShaderStageCode(vertexShader);
+
+            const auto pipelineLayout = m_pipelineLayout;
+            const auto renderPass = m_renderPass;
+            const auto attachmentFormats = this->getAttachmentFormats();
+            const auto pullVertices = m_pullVertices;
+            const auto pipelineFlags = this->getPipelineCreateFlags();
+            const auto drawState = this->getDrawState(false);
+            const auto dynamicStates = this->getDynamicStates(true);
+            auto* pipelineLibrary = m_pipelineLibrary.get();
+            const auto partKeys = this->getPipelinePartKeys("depth prepass", this->getShaderCode(vertexShader), std::span<const uint32_t> {});
+            const auto depthPrepassPipelineHandle = m_engine->getPipelineCompiler().enqueue([vertexStageCode, pipelineLayout, renderPass, attachmentFormats, pullVertices, pipelineFlags, pipelineLibrary, partKeys, isLinkOptimized, drawState, dynamicStates](VkDevice device, VkPipelineCache pipelineCache) -> VkPipeline {
+                const auto vertexShaderStageInfo = vertexStageCode.getStageInfo(VK_SHADER_STAGE_VERTEX_BIT);
+                auto bindingDescriptions = [pullVertices]() -> std::vector<VkVertexInputBindingDescription> {
+                    if (pullVertices) {
+                        return std::vector<VkVertexInputBindingDescription> {};
+                    } else if (SPLIT_VERTEX_STREAMS) {
+                        constexpr auto positionBindingDescriptions = GpuVertex::getPositionBindingDescriptions();
+
+                        return std::vector<VkVertexInputBindingDescription>(positionBindingDescriptions.begin(), positionBindingDescriptions.end());
+                    } else {
+                        return std::vector<VkVertexInputBindingDescription> { GpuVertex::getBindingDescription() };
+                    }
+                }();
+                auto attributeDescriptions = [pullVertices]() -> std::vector<VkVertexInputAttributeDescription> {
+                    if (pullVertices) {
+                        return std::vector<VkVertexInputAttributeDescription> {};
+                    } else if (SPLIT_VERTEX_STREAMS) {
+                        constexpr auto positionAttributeDescriptions = GpuVertex::getPositionAttributeDescriptions();
+
+                        return std::vector<VkVertexInputAttributeDescription>(positionAttributeDescriptions.begin(), positionAttributeDescriptions.end());
+                    } else {
+                        return std::vector<VkVertexInputAttributeDescription> { GpuVertex::getAttributeDescriptions()[0] };
+                    }
+                }();
+                // The instance transforms sit at the binding and locations they have in the
+                // vertex pipeline, after every one of its streams and attributes.
+                const auto instanceBinding = [pullVertices]() -> uint32_t {
+                    if (pullVertices) {
+                        return 0;
+                    } else {
+                        return static_cast<uint32_t>(SPLIT_VERTEX_STREAMS ? GpuVertex::getSplitBindingDescriptions().size() : 1);
+                    }
+                }();
+                const auto instanceAttributeDescriptions = InstanceTransform::getAttributeDescriptions(
+                    instanceBinding,
+                    static_cast<uint32_t>(GpuVertex::getAttributeDescriptions().size())
+                );
+                bindingDescriptions.push_back(InstanceTransform::getBindingDescription(instanceBinding));
+                attributeDescriptions.insert(attributeDescriptions.end(), instanceAttributeDescriptions.begin(), instanceAttributeDescriptions.end());
+                const auto vertexInputInfo = VkPipelineVertexInputStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+                    .vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size()),
+                    .vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
+                    .pVertexBindingDescriptions = bindingDescriptions.data(),
+                    .pVertexAttributeDescriptions = attributeDescriptions.data(),
+                };
+                const auto inputAssembly = VkPipelineInputAssemblyStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+                    .topology = drawState.topology,
+                    .primitiveRestartEnable = VK_FALSE,
+                };
+                const auto viewportState = VkPipelineViewportStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+                    .viewportCount = 1,
+                    .scissorCount = 1,
+                };
+                const auto rasterizer = VkPipelineRasterizationStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+                    .depthClampEnable = VK_FALSE,
+                    .rasterizerDiscardEnable = VK_FALSE,
+                    .polygonMode = VK_POLYGON_MODE_FILL,
+                    .lineWidth = 1.0f,
+                    .cullMode = drawState.cullMode,
+                    .frontFace = drawState.frontFace,
+                    .depthBiasEnable = VK_FALSE,
+                };
+                const auto multisampling = VkPipelineMultisampleStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+                    .sampleShadingEnable = VK_FALSE,
+                    .rasterizationSamples = attachmentFormats.sampleCount,
+                    .pSampleMask = nullptr,
+                    .alphaToCoverageEnable = VK_FALSE,
+                    .alphaToOneEnable = VK_FALSE,
+                };
+                const auto depthStencil = VkPipelineDepthStencilStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+                    .depthTestEnable = drawState.depthTestEnable,
+                    .depthWriteEnable = drawState.depthWriteEnable,
+                    .depthCompareOp = drawState.depthCompareOp,
+                    .depthBoundsTestEnable = VK_FALSE,
+                    .stencilTestEnable = VK_FALSE,
+                };
+                // The color attachment is still part of the pass, so it is only masked off.
+                const auto colorBlendAttachment = VkPipelineColorBlendAttachmentState {
+                    .colorWriteMask = 0,
+                    .blendEnable = VK_FALSE,
+                };
+                const auto colorBlending = VkPipelineColorBlendStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+                    .logicOpEnable = VK_FALSE,
+                    .logicOp = VK_LOGIC_OP_COPY,
+                    .attachmentCount = 1,
+                    .pAttachments = &colorBlendAttachment,
+                };
+
+                const auto dynamicState = VkPipelineDynamicStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+                    .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+                    .pDynamicStates = dynamicStates.data(),
+                };
+
+                const auto renderingInfo = VkPipelineRenderingCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+                    .viewMask = attachmentFormats.viewMask,
+                    .colorAttachmentCount = 1,
+                    .pColorAttachmentFormats = &attachmentFormats.colorFormat,
+                    .depthAttachmentFormat = attachmentFormats.depthFormat,
+                    .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+                };
+                const auto pipelineInfo = VkGraphicsPipelineCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                    .pNext = renderPass == VK_NULL_HANDLE ? &renderingInfo : nullptr,
+                    .flags = pipelineFlags,
+                    .stageCount = 1,
+                    .pStages = &vertexShaderStageInfo,
+                    .pVertexInputState = &vertexInputInfo,
+                    .pInputAssemblyState = &inputAssembly,
+                    .pViewportState = &viewportState,
+                    .pRasterizationState = &rasterizer,
+                    .pMultisampleState = &multisampling,
+                    .pDepthStencilState = &depthStencil,
+                    .pColorBlendState = &colorBlending,
+                    .pDynamicState = &dynamicState,
+                    .layout = pipelineLayout,
+                    .renderPass = renderPass,
+                    .subpass = 0,
+                    .basePipelineHandle = VK_NULL_HANDLE,
+                    .basePipelineIndex = -1,
+                };
+
+                if (pipelineLibrary != nullptr) {
+                    return pipelineLibrary->createPipeline(pipelineCache, pipelineInfo, partKeys, isLinkOptimized);
+                }
+
+                auto depthPrepassPipeline = VkPipeline {};
+                const auto resultCreateGraphicsPipeline = vkCreateGraphicsPipelines(
+                    device,
+                    pipelineCache,
+                    1,
+                    &pipelineInfo,
+                    nullptr,
+                    &depthPrepassPipeline
+                );
+
+                if (resultCreateGraphicsPipeline != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create depth prepass pipeline!");
+                }
+
+                return depthPrepassPipeline;
+            });
+            this->keepShaderStageCode(depthPrepassPipelineHandle, { vertexStageCode });
+
+            return depthPrepassPipelineHandle;
+        }
+
+        /// @brief Start building the pipeline that draws the bounding box of every copy of
+        /// the mesh inside its occlusion query, against `m_pipelineLayout` and the attachments
+        /// of the swap chain.
+        ///
+        /// @note The boxes are strips the vertex shader makes out of the vertex index, so the
+        /// pipeline only reads the instance transforms, from the first binding. It has no
+        /// fragment shader and writes neither color nor depth. Both faces of a box are drawn,
+        /// so that it is tested from inside too.
+        PipelineHandle enqueueOcclusionProxyPipeline() {
+            const auto vertexShaderCode = this->getShaderCode(HlslShader::OcclusionProxyVert);
+            const auto vertexStageCode = this->getShaderStageCode(HlslShader::OcclusionProxyVert);
+
+            const auto pipelineLayout = m_pipelineLayout;
+            const auto renderPass = m_renderPass;
+            const auto attachmentFormats = this->getAttachmentFormats();
+            const auto pipelineFlags = this->getPipelineCreateFlags();
+            const auto drawState = this->getOcclusionProxyDrawState();
+            const auto dynamicStates = this->getDynamicStates(true);
+            auto* pipelineLibrary = m_pipelineLibrary.get();
+            const auto partKeys = this->getPipelinePartKeys("occlusion proxy", vertexShaderCode, std::span<const uint32_t> {});
+            const auto occlusionProxyPipelineHandle = m_engine->getPipelineCompiler().enqueue([vertexStageCode, pipelineLayout, renderPass, attachmentFormats, pipelineFlags, pipelineLibrary, partKeys, drawState, dynamicStates](VkDevice device, VkPipelineCache pipelineCache) -> VkPipeline {
+                const auto vertexShaderStageInfo = vertexStageCode.getStageInfo(VK_SHADER_STAGE_VERTEX_BIT);
+                const auto bindingDescription = InstanceTransform::getBindingDescription(0);
+                const auto attributeDescriptions = InstanceTransform::getAttributeDescriptions(0, 0);
+                const auto vertexInputInfo = VkPipelineVertexInputStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+                    .vertexBindingDescriptionCount = 1,
+                    .vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
+                    .pVertexBindingDescriptions = &bindingDescription,
+                    .pVertexAttributeDescriptions = attributeDescriptions.data(),
+                };
+                const auto inputAssembly = VkPipelineInputAssemblyStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+                    .topology = drawState.topology,
+                    .primitiveRestartEnable = VK_FALSE,
+                };
+                const auto viewportState = VkPipelineViewportStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+                    .viewportCount = 1,
+                    .scissorCount = 1,
+                };
+                const auto rasterizer = VkPipelineRasterizationStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+                    .depthClampEnable = VK_FALSE,
+                    .rasterizerDiscardEnable = VK_FALSE,
+                    .polygonMode = VK_POLYGON_MODE_FILL,
+                    .lineWidth = 1.0f,
+                    .cullMode = drawState.cullMode,
+                    .frontFace = drawState.frontFace,
+                    .depthBiasEnable = VK_FALSE,
+                };
+                const auto multisampling = VkPipelineMultisampleStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+                    .sampleShadingEnable = VK_FALSE,
+                    .rasterizationSamples = attachmentFormats.sampleCount,
+                    .pSampleMask = nullptr,
+                    .alphaToCoverageEnable = VK_FALSE,
+                    .alphaToOneEnable = VK_FALSE,
+                };
+                const auto depthStencil = VkPipelineDepthStencilStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+                    .depthTestEnable = drawState.depthTestEnable,
+                    .depthWriteEnable = drawState.depthWriteEnable,
+                    .depthCompareOp = drawState.depthCompareOp,
+                    .depthBoundsTestEnable = VK_FALSE,
+                    .stencilTestEnable = VK_FALSE,
+                };
+                const auto colorBlendAttachment = VkPipelineColorBlendAttachmentState {
+                    .colorWriteMask = 0,
+                    .blendEnable = VK_FALSE,
+                };
+                const auto colorBlending = VkPipelineColorBlendStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+                    .logicOpEnable = VK_FALSE,
+                    .logicOp = VK_LOGIC_OP_COPY,
+                    .attachmentCount = 1,
+                    .pAttachments = &colorBlendAttachment,
+                };
+
+                const auto dynamicState = VkPipelineDynamicStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+                    .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+                    .pDynamicStates = dynamicStates.data(),
+                };
+
+                const auto renderingInfo = VkPipelineRenderingCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+                    .viewMask = attachmentFormats.viewMask,
+                    .colorAttachmentCount = 1,
+                    .pColorAttachmentFormats = &attachmentFormats.colorFormat,
+                    .depthAttachmentFormat = attachmentFormats.depthFormat,
+                    .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+                };
+                const auto pipelineInfo = VkGraphicsPipelineCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                    .pNext = renderPass == VK_NULL_HANDLE ? &renderingInfo : nullptr,
+                    .flags = pipelineFlags,
+                    .stageCount = 1,
+                    .pStages = &vertexShaderStageInfo,
+                    .pVertexInputState = &vertexInputInfo,
+                    .pInputAssemblyState = &inputAssembly,
+                    .pViewportState = &viewportState,
+                    .pRasterizationState = &rasterizer,
+                    .pMultisampleState = &multisampling,
+                    .pDepthStencilState = &depthStencil,
+                    .pColorBlendState = &colorBlending,
+                    .pDynamicState = &dynamicState,
+                    .layout = pipelineLayout,
+                    .renderPass = renderPass,
+                    .subpass = 0,
+                    .basePipelineHandle = VK_NULL_HANDLE,
+                    .basePipelineIndex = -1,
+                };
+
+                if (pipelineLibrary != nullptr) {
+                    return pipelineLibrary->createPipeline(pipelineCache, pipelineInfo, partKeys);
+                }
+
+                auto occlusionProxyPipeline = VkPipeline {};
+                const auto resultCreateGraphicsPipeline = vkCreateGraphicsPipelines(
+                    device,
+                    pipelineCache,
+                    1,
+                    &pipelineInfo,
+                    nullptr,
+                    &occlusionProxyPipeline
+                );
+
+                if (resultCreateGraphicsPipeline != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create occlusion proxy pipeline!");
+                }
+
+                return occlusionProxyPipeline;
+            });
+            this->keepShaderStageCode(occlusionProxyPipelineHandle, { vertexStageCode });
+
+            return occlusionProxyPipelineHandle;
+        }
+
+        /// @brief Create the pipeline that draws the mesh as meshlets.
+        ///
+        /// @note The task shader culls the meshlets, and the mesh shader fetches their
+        /// vertices from storage buffers, so the pipeline has no vertex input or input
+        /// assembly state. The rest of its state matches the vertex pipeline.
+        void createMeshShaderPipeline() {
+            const auto setLayouts = std::array<VkDescriptorSetLayout, 3> {
+                m_descriptorSetLayout,
+                m_textureTableSetLayout,
+                m_meshletDescriptorSetLayout,
+            };
+            const auto pushConstantRange = this->getPushConstantRange(
+                this->reflectMeshShaderPipelineShaders(),
+                VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                sizeof(MeshletPushConstants)
+            );
+
+            m_meshShaderPipelineLayout = m_engine->getPipelineLayoutCache().getPipelineLayout(setLayouts, { &pushConstantRange, 1 });
+            m_meshShaderPipeline = this->enqueueMeshShaderPipeline();
+        }
+
+        /// @brief Start building the mesh shader pipeline with the current shaders, against
+        /// `m_meshShaderPipelineLayout` and the attachments of the swap chain.
+        PipelineHandle enqueueMeshShaderPipeline() {
+            const auto taskStageCode = this->getShaderStageCode(HlslShader::MeshletTask);
+            const auto meshStageCode = this->getShaderStageCode(HlslShader::MeshletMesh);
+            const auto fragmentStageCode = this->getShaderStageCode(HlslShader::ShaderFrag);
+
+            const auto pipelineLayout = m_meshShaderPipelineLayout;
+            const auto renderPass = m_renderPass;
+            const auto attachmentFormats = this->getAttachmentFormats();
+            const auto fragmentSpecialization = this->getFragmentSpecialization();
+            const auto pipelineFlags = this->getPipelineCreateFlags();
+            const auto drawState = this->getDrawState(false);
+            const auto dynamicStates = this->getDynamicStates(false);
+            const auto meshShaderPipelineHandle = m_engine->getPipelineCompiler().enqueue([taskStageCode, meshStageCode, fragmentStageCode, pipelineLayout, renderPass, attachmentFormats, fragmentSpecialization, pipelineFlags, drawState, dynamicStates](VkDevice device, VkPipelineCache pipelineCache) -> VkPipeline {
+                constexpr auto fragmentSpecializationEntries = FragmentSpecialization::getMapEntries();
+                const auto fragmentSpecializationInfo = VkSpecializationInfo {
+                    .mapEntryCount = static_cast<uint32_t>(fragmentSpecializationEntries.size()),
+                    .pMapEntries = fragmentSpecializationEntries.data(),
+                    .dataSize = sizeof(FragmentSpecialization),
+                    .pData = &fragmentSpecialization,
+                };
+                const auto shaderStages = std::array<VkPipelineShaderStageCreateInfo, 3> {
+                    taskStageCode.getStageInfo(VK_SHADER_STAGE_TASK_BIT_EXT),
+                    meshStageCode.getStageInfo(VK_SHADER_STAGE_MESH_BIT_EXT),
+                    fragmentStageCode.getStageInfo(VK_SHADER_STAGE_FRAGMENT_BIT, &fragmentSpecializationInfo),
+                };
+                const auto viewportState = VkPipelineViewportStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+                    .viewportCount = 1,
+                    .scissorCount = 1,
+                };
+                const auto rasterizer = VkPipelineRasterizationStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+                    .depthClampEnable = VK_FALSE,
+                    .rasterizerDiscardEnable = VK_FALSE,
+                    .polygonMode = VK_POLYGON_MODE_FILL,
+                    .lineWidth = 1.0f,
+                    .cullMode = drawState.cullMode,
+                    .frontFace = drawState.frontFace,
+                    .depthBiasEnable = VK_FALSE,
+                };
+                const auto multisampling = VkPipelineMultisampleStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+                    .sampleShadingEnable = VK_FALSE,
+                    .rasterizationSamples = attachmentFormats.sampleCount,
+                    .pSampleMask = nullptr,
+                    .alphaToCoverageEnable = VK_FALSE,
+                    .alphaToOneEnable = VK_FALSE,
+                };
+                const auto depthStencil = VkPipelineDepthStencilStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+                    .depthTestEnable = drawState.depthTestEnable,
+                    .depthWriteEnable = drawState.depthWriteEnable,
+                    .depthCompareOp = drawState.depthCompareOp,
+                    .depthBoundsTestEnable = VK_FALSE,
+                    .stencilTestEnable = VK_FALSE,
+                };
+                const auto colorBlendAttachment = VkPipelineColorBlendAttachmentState {
+                    .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+                    .blendEnable = VK_FALSE,
+                };
+                const auto colorBlending = VkPipelineColorBlendStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+                    .logicOpEnable = VK_FALSE,
+                    .logicOp = VK_LOGIC_OP_COPY,
+                    .attachmentCount = 1,
+                    .pAttachments = &colorBlendAttachment,
+                };
+                const auto dynamicState = VkPipelineDynamicStateCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+                    .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+                    .pDynamicStates = dynamicStates.data(),
+                };
+
+                // Without a render pass, the pipeline is created against the attachment formats.
+                const auto renderingInfo = VkPipelineRenderingCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+                    .viewMask = attachmentFormats.viewMask,
+                    .colorAttachmentCount = 1,
+                    .pColorAttachmentFormats = &attachmentFormats.colorFormat,
+                    .depthAttachmentFormat = attachmentFormats.depthFormat,
+                    .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+                };
+                const auto pipelineInfo = VkGraphicsPipelineCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                    .pNext = renderPass == VK_NULL_HANDLE ? &renderingInfo : nullptr,
+                    .flags = pipelineFlags,
+                    .stageCount = static_cast<uint32_t>(shaderStages.size()),
+                    .pStages = shaderStages.data(),
+                    .pVertexInputState = nullptr,
+                    .pInputAssemblyState = nullptr,
+                    .pViewportState = &viewportState,
+                    .pRasterizationState = &rasterizer,
+                    .pMultisampleState = &multisampling,
+                    .pDepthStencilState = &depthStencil,
+                    .pColorBlendState = &colorBlending,
+                    .pDynamicState = &dynamicState,
+                    .layout = pipelineLayout,
+                    .renderPass = renderPass,
+                    .subpass = 0,
+                    .basePipelineHandle = VK_NULL_HANDLE,
+                    .basePipelineIndex = -1,
+                };
+
+                auto meshShaderPipeline = VkPipeline {};
+                const auto resultCreateGraphicsPipeline = vkCreateGraphicsPipelines(
+                    device,
+                    pipelineCache,
+                    1,
+                    &pipelineInfo,
+                    nullptr,
+                    &meshShaderPipeline
+                );
+
+                if (resultCreateGraphicsPipeline != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create mesh shader pipeline!");
+                }
+
+                return meshShaderPipeline;
+            });
+            this->keepShaderStageCode(meshShaderPipelineHandle, { taskStageCode, meshStageCode, fragmentStageCode });
+
+            return meshShaderPipelineHandle;
+        }
+
+        void createFramebuffers() {
+            auto swapChainFramebuffers = std::vector<VkFramebuffer> { m_swapChainImageViews.size(), VK_NULL_HANDLE };
+            for (size_t i = 0; i < m_swapChainImageViews.size(); i++) {
+                // The attachments are in the order of the render pass attachments.
+                const auto attachments = [this, i]() -> std::vector<VkImageView> {
+                    if (m_usePostProcessSubpass && m_msaaSamples != VK_SAMPLE_COUNT_1_BIT) {
+                        return std::vector<VkImageView> { m_colorImageView, m_depthImageView, m_postProcessInputImageView, m_swapChainImageViews[i] };
+                    } else if (m_usePostProcessSubpass) {
+                        return std::vector<VkImageView> { m_postProcessInputImageView, m_depthImageView, m_swapChainImageViews[i] };
+                    } else if (m_msaaSamples != VK_SAMPLE_COUNT_1_BIT) {
+                        return std::vector<VkImageView> { m_colorImageView, m_depthImageView, m_swapChainImageViews[i] };
+                    } else {
+                        return std::vector<VkImageView> { m_swapChainImageViews[i], m_depthImageView };
+                    }
+                }();
+
+                const auto framebufferInfo = VkFramebufferCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+                    .renderPass = m_renderPass,
+                    .attachmentCount = static_cast<uint32_t>(attachments.size()),
+                    .pAttachments = attachments.data(),
+                    .width = m_swapChainExtent.width,
+                    .height = m_swapChainExtent.height,
+                    .layers = 1,
+                };
+
+                auto swapChainFramebuffer = VkFramebuffer {};
+                const auto result = vkCreateFramebuffer(
+                    m_engine->getLogicalDevice(),
+                    &framebufferInfo,
+                    m_engine->getAllocationCallbacks(),
+                    &swapChainFramebuffer
+                );
+
+                if (result != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create framebuffer!");
+                }
+
+                swapChainFramebuffers[i] = swapChainFramebuffer;
+            }
+
+            m_swapChainFramebuffers = std::move(swapChainFramebuffers);
+        }
+
+        /// @brief Begin rendering to the swap chain image and the depth image without a render
+        /// pass.
+        ///
+        /// @note Without a render pass to do it, the images are moved into their attachment
+        /// layouts by hand. Their contents are cleared, so the previous layouts are discarded.
+        /// With dynamic resolution, the scene is rendered into the scene color image at its
+        /// scale instead, which the frame before may still be blitting from.
+        void beginDynamicRendering(
+            VkCommandBuffer commandBuffer,
+            uint32_t imageIndex,
+            const std::array<VkClearValue, 2>& clearValues,
+            VkRenderingFlags renderingFlags
+        ) {
+            const auto depthFormat = this->findDepthFormat();
+            const auto depthAspectMask = [this, depthFormat]() -> VkImageAspectFlags {
+                if (this->hasStencilComponent(depthFormat)) {
+                    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+                } else {
+                    return VK_IMAGE_ASPECT_DEPTH_BIT;
+                }
+            }();
+            const auto isMultisampled = m_msaaSamples != VK_SAMPLE_COUNT_1_BIT;
+            // Every view renders into a layer of its own.
+            const auto createColorBarrier = [this](VkImage image) -> VkImageMemoryBarrier {
+                return VkImageMemoryBarrier {
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .srcAccessMask = 0,
+                    .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                    .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                    .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .image = image,
+                    .subresourceRange = VkImageSubresourceRange {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = 1,
+                        .baseArrayLayer = 0,
+                        .layerCount = m_viewCount,
+                    },
+                };
+            };
+            const auto targetImage = m_dynamicResolution ? m_sceneColorImage : m_swapChainImages[imageIndex];
+            const auto targetImageView = m_dynamicResolution ? m_sceneColorImageView : m_swapChainImageViews[imageIndex];
+            auto barriers = std::pmr::vector<VkImageMemoryBarrier>({
+                createColorBarrier(targetImage),
+                // The previous frame may still be testing against the depth image.
+                VkImageMemoryBarrier {
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                    .dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                    .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                    .newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .image = m_depthImage,
+                    .subresourceRange = VkImageSubresourceRange {
+                        .aspectMask = depthAspectMask,
+                        .baseMipLevel = 0,
+                        .levelCount = 1,
+                        .baseArrayLayer = 0,
+                        .layerCount = m_viewCount,
+                    },
+                },
+            }, &this->getFrameArena());
+            if (isMultisampled) {
+                barriers.push_back(createColorBarrier(m_colorImage));
+            }
+
+            const auto blitStages = m_dynamicResolution ? VK_PIPELINE_STAGE_TRANSFER_BIT : 0;
+            const auto upscaleStages = m_temporalUpscaler ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : 0;
+            m_dispatch->vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | blitStages | upscaleStages,
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                0,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                static_cast<uint32_t>(barriers.size()),
+                barriers.data()
+            );
+            CommandCounters::add(CommandCounter::Barriers);
+
+            // With multisampling, the multisampled target is resolved into the swap chain
+            // image and then discarded.
+            const auto colorAttachment = VkRenderingAttachmentInfo {
+                .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+                .imageView = isMultisampled ? m_colorImageView : targetImageView,
+                .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .resolveMode = isMultisampled ? VK_RESOLVE_MODE_AVERAGE_BIT : VK_RESOLVE_MODE_NONE,
+                .resolveImageView = isMultisampled ? targetImageView : VK_NULL_HANDLE,
+                .resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                .storeOp = isMultisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE,
+                .clearValue = clearValues[0],
+            };
+            const auto depthAttachment = VkRenderingAttachmentInfo {
+                .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+                .imageView = m_depthImageView,
+                .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                .resolveMode = VK_RESOLVE_MODE_NONE,
+                .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                .storeOp = this->isDepthSampled() ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                .clearValue = clearValues[1],
+            };
+            const auto deviceRenderAreas = this->getDeviceRenderAreas();
+            const auto deviceGroupRenderPassInfo = VkDeviceGroupRenderPassBeginInfo {
+                .sType = VK_STRUCTURE_TYPE_DEVICE_GROUP_RENDER_PASS_BEGIN_INFO,
+                .pNext = nullptr,
+                .deviceMask = this->getFrameDeviceMask(imageIndex),
+                .deviceRenderAreaCount = static_cast<uint32_t>(deviceRenderAreas.size()),
+                .pDeviceRenderAreas = deviceRenderAreas.data(),
+            };
+            const auto* renderingInfoNext = m_engine->getDeviceCount() > 1 ? &deviceGroupRenderPassInfo : nullptr;
+
+            // The render graph has moved the shading rate image into its layout already.
+            const auto shadingRateAttachmentInfo = VkRenderingFragmentShadingRateAttachmentInfoKHR {
+                .sType = VK_STRUCTURE_TYPE_RENDERING_FRAGMENT_SHADING_RATE_ATTACHMENT_INFO_KHR,
+                .pNext = renderingInfoNext,
+                .imageView = m_shadingRateImage ? m_shadingRateImage->getImageView() : VK_NULL_HANDLE,
+                .imageLayout = VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR,
+                .shadingRateAttachmentTexelSize = m_shadingRateImage ? m_shadingRateImage->getTexelSize() : VkExtent2D { 1, 1 },
+            };
+            const auto renderingInfo = VkRenderingInfo {
+                .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+                .pNext = m_shadingRateImage ? static_cast<const void*>(&shadingRateAttachmentInfo) : renderingInfoNext,
+                .flags = renderingFlags,
+                .renderArea = VkRect2D {
+                    .offset = VkOffset2D { 0, 0 },
+                    .extent = this->getRenderExtent(),
+                },
+                .layerCount = 1,
+                .viewMask = this->getViewMask(),
+                .colorAttachmentCount = 1,
+                .pColorAttachments = &colorAttachment,
+                .pDepthAttachment = &depthAttachment,
+                .pStencilAttachment = nullptr,
+            };
+
+            m_dispatch->vkCmdBeginRendering(commandBuffer, &renderingInfo);
+        }
+
+        /// @brief End rendering and move the swap chain image into the layout it is presented
+        /// in, or an offscreen image into the layout it is copied from.
+        void endDynamicRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+            m_dispatch->vkCmdEndRendering(commandBuffer);
+
+            if (m_dynamicResolution) {
+                this->recordUpscale(commandBuffer, imageIndex);
+
+                return;
+            }
+
+            const auto barrier = VkImageMemoryBarrier {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = 0,
+                .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .newLayout = this->getFinalColorLayout(),
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = m_swapChainImages[imageIndex],
+                .subresourceRange = VkImageSubresourceRange {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = m_viewCount,
+                },
+            };
+            m_dispatch->vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                1,
+                &barrier
+            );
+            CommandCounters::add(CommandCounter::Barriers);
+        }
+
+        /// @brief Upscale the frame into the whole of the swap chain image, and move the swap
+        /// chain image into its final layout.
+        ///
+        /// @note Without temporal upscaling, the scene color image is blitted from the extent
+        /// it was rendered at. The blit filters linearly, so the last row and column of the
+        /// rendered extent blend a little with what is past them. With it, the temporal
+        /// upscaler reads the frame's color and depth, and its output history is blitted
+        /// over as it is, which only converts its format.
+        void recordUpscale(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+            const auto colorSubresourceRange = VkImageSubresourceRange {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            };
+            const auto depthFormat = this->findDepthFormat();
+            const auto sceneColorLayout = m_temporalUpscaler ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            // The swap chain image is overwritten whole, so its previous layout is discarded.
+            auto barriers = std::pmr::vector<VkImageMemoryBarrier>({
+                VkImageMemoryBarrier {
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                    .dstAccessMask = m_temporalUpscaler ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_TRANSFER_READ_BIT,
+                    .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                    .newLayout = sceneColorLayout,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .image = m_sceneColorImage,
+                    .subresourceRange = colorSubresourceRange,
+                },
+                VkImageMemoryBarrier {
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .srcAccessMask = 0,
+                    .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                    .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                    .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .image = m_swapChainImages[imageIndex],
+                    .subresourceRange = colorSubresourceRange,
+                },
+            }, &this->getFrameArena());
+            if (m_temporalUpscaler) {
+                barriers.push_back(VkImageMemoryBarrier {
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                    .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+                    .oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                    .newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .image = m_depthImage,
+                    .subresourceRange = VkImageSubresourceRange {
+                        .aspectMask = this->hasStencilComponent(depthFormat) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = 1,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                    },
+                });
+            }
+            m_dispatch->vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                static_cast<uint32_t>(barriers.size()),
+                barriers.data()
+            );
+            CommandCounters::add(CommandCounter::Barriers);
+
+            const auto renderExtent = this->getRenderExtent();
+            if (m_temporalUpscaler) {
+                auto frame = TemporalUpscaleFrame {
+                    .jitterX = m_temporalJitter[0],
+                    .jitterY = m_temporalJitter[1],
+                    .renderExtent = renderExtent,
+                };
+                memcpy(frame.reprojection.data(), &m_temporalReprojection, sizeof(frame.reprojection));
+                m_temporalUpscaler->record(commandBuffer, frame);
+            }
+
+            const auto [sourceImage, sourceLayout, sourceExtent, filter] = [this, &renderExtent]() -> std::tuple<VkImage, VkImageLayout, VkExtent2D, VkFilter> {
+                if (m_temporalUpscaler) {
+                    return { m_temporalUpscaler->getOutputImage(), VK_IMAGE_LAYOUT_GENERAL, m_temporalUpscaler->getExtent(), VK_FILTER_NEAREST };
+                } else {
+                    return { m_sceneColorImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, renderExtent, VK_FILTER_LINEAR };
+                }
+            }();
+            const auto colorSubresource = VkImageSubresourceLayers {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            };
+            const auto blit = VkImageBlit {
+                .srcSubresource = colorSubresource,
+                .srcOffsets = {
+                    VkOffset3D { 0, 0, 0 },
+                    VkOffset3D { static_cast<int32_t>(sourceExtent.width), static_cast<int32_t>(sourceExtent.height), 1 },
+                },
+                .dstSubresource = colorSubresource,
+                .dstOffsets = {
+                    VkOffset3D { 0, 0, 0 },
+                    VkOffset3D { static_cast<int32_t>(m_swapChainExtent.width), static_cast<int32_t>(m_swapChainExtent.height), 1 },
+                },
+            };
+            m_dispatch->vkCmdBlitImage(
+                commandBuffer,
+                sourceImage,
+                sourceLayout,
+                m_swapChainImages[imageIndex],
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1,
+                &blit,
+                filter
+            );
+
+            const auto finalBarrier = VkImageMemoryBarrier {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = 0,
+                .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .newLayout = this->getFinalColorLayout(),
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = m_swapChainImages[imageIndex],
+                .subresourceRange = colorSubresourceRange,
+            };
+            m_dispatch->vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                1,
+                &finalBarrier
+            );
+            CommandCounters::add(CommandCounter::Barriers);
+        }
+
+        /// @brief The keys of the library parts of the pipeline `pipelineName`, which is
+        /// built from `vertexShaderCode` and `fragmentShaderCode`.
+        ///
+        /// @note Every part is keyed by the pipeline's name, its layout and flags, the
+        /// attachments, and the configuration the pipelines are built for, and the shader
+        /// parts by their code as well, so that only a shader that changed is compiled again.
+        GraphicsPipelinePartKeys getPipelinePartKeys(
+            std::string_view pipelineName,
+            std::span<const uint32_t> vertexShaderCode,
+            std::span<const uint32_t> fragmentShaderCode
+        ) const {
+            const auto attachmentFormats = this->getAttachmentFormats();
+            const auto fragmentSpecialization = this->getFragmentSpecialization();
+            auto stateHash = CacheSourceKey::hashBytes(
+                reinterpret_cast<const uint8_t*>(pipelineName.data()),
+                pipelineName.size(),
+                CacheSourceKey::FNV_OFFSET_BASIS
+            );
+            stateHash = hashValue(m_pipelineLayout, stateHash);
+            stateHash = hashValue(m_renderPass, stateHash);
+            stateHash = hashValue(attachmentFormats.colorFormat, stateHash);
+            stateHash = hashValue(attachmentFormats.depthFormat, stateHash);
+            stateHash = hashValue(attachmentFormats.sampleCount, stateHash);
+            stateHash = hashValue(attachmentFormats.viewMask, stateHash);
+            stateHash = hashValue(this->getPipelineCreateFlags(), stateHash);
+            stateHash = hashValue(m_pullVertices, stateHash);
+            stateHash = hashValue(m_useDepthPrepass, stateHash);
+            stateHash = hashValue(m_useExtendedDynamicState, stateHash);
+
+            const auto fragmentHash = hashValue(fragmentSpecialization, stateHash);
+
+            return GraphicsPipelinePartKeys {
+                .vertexInput = stateHash,
+                .preRasterization = CacheSourceKey::hashBytes(
+                    reinterpret_cast<const uint8_t*>(vertexShaderCode.data()),
+                    vertexShaderCode.size_bytes(),
+                    stateHash
+                ),
+                .fragmentShader = CacheSourceKey::hashBytes(
+                    reinterpret_cast<const uint8_t*>(fragmentShaderCode.data()),
+                    fragmentShaderCode.size_bytes(),
+                    fragmentHash
+                ),
+                .fragmentOutput = stateHash,
+            };
+        }
+
+        /// @brief The permutation of the fragment shader every pipeline draws with.
+        FragmentSpecialization getFragmentSpecialization() const {
+            return FragmentSpecialization {
+                .showMipLevels = SHOW_MIP_LEVELS ? VK_TRUE : VK_FALSE,
+                .alphaTest = MIP_ALPHA_CUTOFF > 0.0f ? VK_TRUE : VK_FALSE,
+                .alphaCutoff = MIP_ALPHA_CUTOFF,
+                .lodBias = TEXTURE_LOD_BIAS,
+                // The post process subpass encodes the linear scene color itself.
+                .outputEncoding = static_cast<uint32_t>(m_usePostProcessSubpass ? OutputEncoding::None : this->getOutputEncoding()),
+                .paperWhiteNits = HDR_PAPER_WHITE_NITS,
+                .lodFeedback = m_useLodFeedback ? VK_TRUE : VK_FALSE,
+                .lodFeedbackTileSize = LOD_FEEDBACK_TILE_SIZE,
+                .virtualTexture = m_virtualTexture != nullptr ? VK_TRUE : VK_FALSE,
+            };
+        }
+
+        /// @brief How the fragment shader encodes its color for the format and color space
+        /// of the swap chain.
+        OutputEncoding getOutputEncoding() const {
+            if (m_swapChainColorSpace == VK_COLOR_SPACE_HDR10_ST2084_EXT) {
+                return OutputEncoding::Pq;
+            } else if (m_swapChainColorSpace == VK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT) {
+                return OutputEncoding::ScRgb;
+            }
+
+            const auto srgbFormats = std::array<VkFormat, 5> {
+                VK_FORMAT_R8G8B8A8_SRGB,
+                VK_FORMAT_B8G8R8A8_SRGB,
+                VK_FORMAT_A8B8G8R8_SRGB_PACK32,
+                VK_FORMAT_R8G8B8_SRGB,
+                VK_FORMAT_B8G8R8_SRGB,
+            };
+            const auto isSrgbFormat = std::find(srgbFormats.begin(), srgbFormats.end(), m_swapChainImageFormat) != srgbFormats.end();
+
+            return isSrgbFormat ? OutputEncoding::None : OutputEncoding::Srgb;
+        }
+
+        /// @brief The SPIR-V of `shader`, as it was last reloaded, or as it is embedded when
+        /// it never was.
+        std::span<const uint32_t> getShaderCode(HlslShader shader) const {
+            const auto reloadedShaderCode = m_reloadedShaderCode.find(shader);
+            if (reloadedShaderCode != m_reloadedShaderCode.end()) {
+                return reloadedShaderCode->second;
+            } else {
+                return shaders_hlsl::getHlslShader(shader);
+            }
+        }
+
+        /// @brief The code of `shader` for a pipeline stage, which is the embedded SPIR-V
+        /// itself where the device takes code in the stage, and a module otherwise.
+        ///
+        /// @note Reloaded code is freed by the next reload, maybe while a build still reads
+        /// it, so it always goes into a module.
+        ShaderStageCode getShaderStageCode(HlslShader shader) {
+            const auto code = this->getShaderCode(shader);
+            if (m_engine->supportsMaintenance5() && !m_reloadedShaderCode.contains(shader)) {
+                return ShaderStageCode {
+                    .shaderModule = VK_NULL_HANDLE,
+                    .moduleInfo = VkShaderModuleCreateInfo {
+                        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+                        .codeSize = code.size_bytes(),
+                        .pCode = code.data(),
+                    },
+                };
+            }
+
+            return ShaderStageCode {
+                .shaderModule = m_engine->createShaderModule(code),
+                .moduleInfo = {},
+            };
+        }
+
+        /// @brief Release the module of `stageCode`, if it has one, once the pipelines built
+        /// from it are created.
+        void releaseShaderStageCode(const ShaderStageCode& stageCode) {
+            if (stageCode.shaderModule != VK_NULL_HANDLE) {
+                m_engine->releaseShaderModule(stageCode.shaderModule);
+            }
+        }
+
+        /// @brief Start rebuilding the pipelines whose shaders were reloaded.
+        ///
+        /// @note This runs between frames and never waits on the device, or on a build. A
+        /// rebuild that a newer one replaces before it is ready is retired without being
+        /// used. Only the shaders the pipelines draw with are looked at, since the GLSL
+        /// shaders are not used, and the mip shaders only ran at startup.
+        void updateReloadedShaders() {
+            auto isGraphicsPipelineChanged = false;
+            auto isDepthPrepassPipelineChanged = false;
+            auto isMeshShaderPipelineChanged = false;
+            for (auto& reloadedShader : m_shaderReloader->takeReloadedShaders()) {
+                for (const auto shader : { HlslShader::ShaderVert, HlslShader::ShaderFrag, HlslShader::DepthVert, HlslShader::VertexPullVert, HlslShader::MeshletTask, HlslShader::MeshletMesh }) {
+                    if (reloadedShader.name != shaders_hlsl::getHlslShaderName(shader)) {
+                        continue;
+                    }
+
+                    fmt::println("Reloaded shader `{}`", reloadedShader.name);
+                    m_reloadedShaderCode.insert_or_assign(shader, std::move(reloadedShader.code));
+                    isGraphicsPipelineChanged |= shader == HlslShader::ShaderVert || shader == HlslShader::ShaderFrag || shader == HlslShader::VertexPullVert;
+                    isDepthPrepassPipelineChanged |= shader == HlslShader::DepthVert || shader == HlslShader::VertexPullVert;
+                    isMeshShaderPipelineChanged |= shader == HlslShader::MeshletTask || shader == HlslShader::MeshletMesh || shader == HlslShader::ShaderFrag;
+                }
+            }
+
+            if (isGraphicsPipelineChanged) {
+                this->retirePipeline(m_pendingGraphicsPipeline);
+                m_pendingGraphicsPipeline = this->enqueueGraphicsPipeline();
+            }
+
+            if (isDepthPrepassPipelineChanged && m_useDepthPrepass) {
+                this->retirePipeline(m_pendingDepthPrepassPipeline);
+                m_pendingDepthPrepassPipeline = this->enqueueDepthPrepassPipeline();
+            }
+
+            if (isMeshShaderPipelineChanged && m_useMeshShaders) {
+                this->retirePipeline(m_pendingMeshShaderPipeline);
+                m_pendingMeshShaderPipeline = this->enqueueMeshShaderPipeline();
+            }
+
+            // The rebuilds are fast links again, to be shown as soon as possible.
+            if (isGraphicsPipelineChanged || (isDepthPrepassPipelineChanged && m_useDepthPrepass)) {
+                m_needsOptimizedLinks = this->usesFastPipelineLinks();
+            }
+        }
+
+        /// @brief Swap in the pipeline rebuilds that are ready, and start the optimized links
+        /// of fast linked pipelines once no rebuild is pending.
+        ///
+        /// @note This runs between frames and never waits on the device, or on a build. The
+        /// optimized links are queued behind every other build, and the fast links keep
+        /// drawing until they are ready.
+        void updatePendingPipelines() {
+            const auto isLinkPending = m_pendingGraphicsPipeline != PipelineCompiler::INVALID_HANDLE
+                || m_pendingDepthPrepassPipeline != PipelineCompiler::INVALID_HANDLE;
+            if (m_needsOptimizedLinks && !isLinkPending) {
+                m_pendingGraphicsPipeline = this->enqueueGraphicsPipeline(true);
+                if (m_useDepthPrepass) {
+                    m_pendingDepthPrepassPipeline = this->enqueueDepthPrepassPipeline(true);
+                }
+                m_needsOptimizedLinks = false;
+            }
+
+            this->swapInPendingPipeline(m_pendingGraphicsPipeline, m_graphicsPipeline);
+            this->swapInPendingPipeline(m_pendingDepthPrepassPipeline, m_depthPrepassPipeline);
+            this->swapInPendingPipeline(m_pendingMeshShaderPipeline, m_meshShaderPipeline);
+            this->destroyRetiredPipelines();
+            this->releaseBuiltShaderStageCode();
+        }
+
+        /// @brief Replace `pipeline` with `pendingPipeline` once it is built.
+        ///
+        /// @note A rebuild that failed, like one whose shaders do not match the pipeline
+        /// layout, prints its error, and the pipeline is kept.
+        void swapInPendingPipeline(PipelineHandle& pendingPipeline, PipelineHandle& pipeline) {
+            if (pendingPipeline == PipelineCompiler::INVALID_HANDLE || !m_engine->getPipelineCompiler().isDone(pendingPipeline)) {
+                return;
+            }
+
+            try {
+                m_engine->getPipelineCompiler().tryGet(pendingPipeline);
+                this->retirePipeline(pipeline);
+                pipeline = pendingPipeline;
+            } catch (const std::exception& exception) {
+                fmt::println(std::cerr, "failed to rebuild a pipeline, keeping the last one: {}", exception.what());
+                this->retirePipeline(pendingPipeline);
+            }
+
+            pendingPipeline = PipelineCompiler::INVALID_HANDLE;
+        }
+
+        /// @brief Keep the code `pipeline` is built from until its build is done.
+        void keepShaderStageCode(PipelineHandle pipeline, std::vector<ShaderStageCode> stageCode) {
+            m_buildShaderStageCode.insert_or_assign(pipeline, std::move(stageCode));
+        }
+
+        /// @brief Release the modules of the builds that are done.
+        ///
+        /// @note A built pipeline no longer reads its modules, so the modules of replaced
+        /// shaders go with the next reload, instead of piling up until the device is
+        /// destroyed. This runs between frames, since the device's module table is not
+        /// thread safe.
+        void releaseBuiltShaderStageCode() {
+            auto& pipelineCompiler = m_engine->getPipelineCompiler();
+            std::erase_if(m_buildShaderStageCode, [this, &pipelineCompiler](const auto& buildShaderStageCode) {
+                const auto& [pipeline, stageCode] = buildShaderStageCode;
+                if (!pipelineCompiler.isDone(pipeline)) {
+                    return false;
+                }
+
+                for (const auto& code : stageCode) {
+                    this->releaseShaderStageCode(code);
+                }
+
+                return true;
+            });
+        }
+
+        /// @brief Hand the pipeline over to be destroyed once the frames submitted so far have
+        /// finished.
+        void retirePipeline(PipelineHandle pipeline) {
+            if (pipeline != PipelineCompiler::INVALID_HANDLE) {
+                m_retiredPipelines.push_back(RetiredPipeline { .pipeline = pipeline, .submitCount = m_submitCount });
+            }
+        }
+
+        /// @brief Destroy the retired pipelines that no frame in flight can still use, and
+        /// that are no longer being built.
+        void destroyRetiredPipelines() {
+            auto& pipelineCompiler = m_engine->getPipelineCompiler();
+            auto finishedSubmitCount = uint64_t { 0 };
+            m_dispatch->vkGetSemaphoreCounterValue(m_engine->getLogicalDevice(), m_frameTimelineSemaphore, &finishedSubmitCount);
+            const auto isFinished = [&pipelineCompiler, finishedSubmitCount](const RetiredPipeline& retiredPipeline) {
+                return retiredPipeline.submitCount <= finishedSubmitCount && pipelineCompiler.isDone(retiredPipeline.pipeline);
+            };
+            for (const auto& retiredPipeline : m_retiredPipelines) {
+                if (isFinished(retiredPipeline)) {
+                    pipelineCompiler.destroyPipeline(retiredPipeline.pipeline);
+                }
+            }
+
+            std::erase_if(m_retiredPipelines, isFinished);
+        }
+
+        /// @brief Move one buffer at a time out of the memory blocks that are mostly free,
+        /// while the app is otherwise idle.
+        ///
+        /// @note A move copies the buffer on the graphics queue, and the frames keep binding
+        /// the old buffer until the copy has finished. Then the new buffer takes its place,
+        /// the command buffers that bind it are recorded again, and the old one is retired
+        /// until the frames that may still bind it have finished.
+        void updateDefragmentation() {
+            if (!m_defragmentMemory) {
+                return;
+            }
+
+            auto& uploadContext = m_engine->getUploadContext();
+            if (m_pendingBufferMove.has_value()) {
+                if (!uploadContext.isComplete(m_pendingBufferMove->uploadValue)) {
+                    return;
+                }
+
+                const auto& movableBuffer = m_movableBuffers[m_pendingBufferMove->movableBufferIndex];
+                m_resourceTable->replaceBuffer(
+                    movableBuffer.buffer,
+                    m_pendingBufferMove->buffer,
+                    m_pendingBufferMove->allocation,
+                    GpuTimelineValue { .timelineSemaphore = m_frameTimelineSemaphore, .value = m_submitCount }
+                );
+                m_pendingBufferMove.reset();
+                m_bufferGeneration++;
+
+                return;
+            }
+
+            m_framesSinceDefragmentation++;
+            // A buffer is only moved while no upload writes to it.
+            const auto isLoading = (m_assetStreamer != nullptr && m_assetStreamer->hasPending())
+                || (m_geometryStreamer != nullptr && m_geometryStreamer->hasPendingUpload());
+            if (m_framesSinceDefragmentation < DEFRAGMENTATION_INTERVAL || isLoading) {
+                return;
+            }
+
+            m_framesSinceDefragmentation = 0;
+            for (size_t i = 0; i < m_movableBuffers.size(); i++) {
+                const auto& movableBuffer = m_movableBuffers[i];
+                const auto& allocation = m_resourceTable->getAllocation(movableBuffer.buffer);
+                const auto movedBuffer = m_engine->createMovedBuffer(allocation, movableBuffer.size, movableBuffer.usage);
+                if (!movedBuffer.has_value()) {
+                    continue;
+                }
+
+                const auto [buffer, movedAllocation] = *movedBuffer;
+                auto uploadBatch = uploadContext.beginBatch();
+                uploadBatch.copyBufferToBuffer(m_resourceTable->getBuffer(movableBuffer.buffer), buffer, movableBuffer.size);
+                m_pendingBufferMove = BufferMove {
+                    .movableBufferIndex = i,
+                    .buffer = buffer,
+                    .allocation = movedAllocation,
+                    .uploadValue = uploadContext.submit(uploadBatch),
+                };
+
+                return;
+            }
+        }
+
+        /// @brief Destroy every retired pipeline.
+        ///
+        /// @note The device has to be idle.
+        void destroyAllRetiredPipelines() {
+            for (const auto& retiredPipeline : m_retiredPipelines) {
+                m_engine->getPipelineCompiler().destroyPipeline(retiredPipeline.pipeline);
+            }
+
+            m_retiredPipelines.clear();
+        }
+
+        /// @brief The pipeline to draw the frame with, and whether it is the mesh shader
+        /// pipeline.
+        ///
+        /// @note Pipelines compile in the background. The vertex pipeline stands in for the
+        /// mesh shader pipeline until it is ready, and until either one is the frame is only
+        /// cleared. With a depth prepass, the vertex pipeline only shades the depth the
+        /// prepass writes, so it waits for the depth prepass pipeline too, unless its depth
+        /// state is dynamic and it can write depth itself in the meantime.
+        std::tuple<VkPipeline, bool> selectPipeline() const {
+            const auto& pipelineCompiler = m_engine->getPipelineCompiler();
+            const auto meshShaderPipeline = m_useMeshShaders ? pipelineCompiler.tryGet(m_meshShaderPipeline) : VK_NULL_HANDLE;
+            if (meshShaderPipeline != VK_NULL_HANDLE) {
+                return std::make_tuple(meshShaderPipeline, true);
+            } else if (m_useDepthPrepass && !m_useExtendedDynamicState && this->getDepthPrepassPipeline() == VK_NULL_HANDLE) {
+                return std::make_tuple(VK_NULL_HANDLE, false);
+            } else {
+                return std::make_tuple(pipelineCompiler.tryGet(m_graphicsPipeline), false);
+            }
+        }
+
+        /// @brief The depth prepass pipeline, or `VK_NULL_HANDLE` without a depth prepass or
+        /// until it is ready.
+        VkPipeline getDepthPrepassPipeline() const {
+            return m_useDepthPrepass ? m_engine->getPipelineCompiler().tryGet(m_depthPrepassPipeline) : VK_NULL_HANDLE;
+        }
+
+        /// @brief The occlusion proxy pipeline, or `VK_NULL_HANDLE` without occlusion queries
+        /// or until it is ready.
+        VkPipeline getOcclusionProxyPipeline() const {
+            return m_useOcclusionQueries ? m_engine->getPipelineCompiler().tryGet(m_occlusionProxyPipeline) : VK_NULL_HANDLE;
+        }
+
+        /// @brief Record chunk `chunkIndex` of `chunkCount` of the frame's draws.
+        ///
+        /// @note The mesh is split into runs of triangles, or of task workgroups with mesh
+        /// shaders, one per chunk, and a single chunk draws all of it. Every chunk binds its
+        /// own state, since secondary command buffers inherit none. The pipeline is selected
+        /// once per frame, so that every chunk splits the mesh the same way, and so is the
+        /// occlusion proxy pipeline, so that the frame's queries are run exactly when they
+        /// are reset and resolved.
+        void recordDraws(
+            VkCommandBuffer commandBuffer,
+            VkPipeline pipeline,
+            bool isMeshShaderPipeline,
+            VkPipeline occlusionProxyPipeline,
+            uint32_t chunkIndex,
+            uint32_t chunkCount
+        ) const {
+            if (pipeline != VK_NULL_HANDLE) {
+                m_dispatch->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                CommandCounters::add(CommandCounter::PipelineBinds);
+
+                const auto renderExtent = this->getRenderExtent();
+                const auto viewport = VkViewport {
+                    .x = 0.0f,
+                    .y = 0.0f,
+                    .width = static_cast<float>(renderExtent.width),
+                    .height = static_cast<float>(renderExtent.height),
+                    .minDepth = 0.0f,
+                    .maxDepth = 1.0f,
+                };
+                m_dispatch->vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+                const auto scissor = VkRect2D {
+                    .offset = VkOffset2D { 0, 0 },
+                    .extent = renderExtent,
+                };
+                m_dispatch->vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+                this->setDrawShadingRate(commandBuffer);
+
+                if (isMeshShaderPipeline) {
+                    this->setDrawState(commandBuffer, this->getDrawState(false), false);
+                    if (m_useDescriptorBuffer) {
+                        const auto descriptorBufferSets = std::array<DescriptorBufferSet, 3> {
+                            m_uniformBufferSets[m_currentFrame],
+                            m_textureTableBufferSets[m_currentFrame],
+                            m_meshletBufferSet,
+                        };
+                        m_descriptorBuffer->bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_meshShaderPipelineLayout, 0, descriptorBufferSets);
+                    } else {
+                        const auto descriptorSets = std::array<VkDescriptorSet, 3> {
+                            m_descriptorSets[m_currentFrame],
+                            m_textureTableSets[m_currentFrame],
+                            m_meshletDescriptorSet,
+                        };
+                        m_dispatch->vkCmdBindDescriptorSets(
+                            commandBuffer,
+                            VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            m_meshShaderPipelineLayout,
+                            0,
+                            static_cast<uint32_t>(descriptorSets.size()),
+                            descriptorSets.data(),
+                            1,
+                            &m_uniformBufferOffset
+                        );
+                        CommandCounters::add(CommandCounter::DescriptorBinds);
+                    }
+
+                    // Each chunk culls and draws its own run of whole task workgroups. The mesh
+                    // shader indexes the whole vertex buffer in 32-bit words.
+                    const auto& meshletLod = m_meshletLods[this->selectMeshLodLevel()];
+                    const auto taskCount = (meshletLod.meshletCount + MESHLETS_PER_TASK - 1) / MESHLETS_PER_TASK;
+                    const auto firstTask = taskCount * chunkIndex / chunkCount;
+                    const auto lastTask = taskCount * (chunkIndex + 1) / chunkCount;
+                    const auto firstMeshlet = std::min(firstTask * MESHLETS_PER_TASK, meshletLod.meshletCount);
+                    const auto lastMeshlet = std::min(lastTask * MESHLETS_PER_TASK, meshletLod.meshletCount);
+                    const auto pushConstants = MeshletPushConstants {
+                        .model = m_meshPositionTransform,
+                        .textureIndex = MODEL_TEXTURE_INDEX,
+                        .firstMeshlet = meshletLod.firstMeshlet + firstMeshlet,
+                        .meshletCount = lastMeshlet - firstMeshlet,
+                        .texCoordOffset = static_cast<uint32_t>(m_vertexStreamOffsets[1] / sizeof(uint32_t)),
+                    };
+                    m_dispatch->vkCmdPushConstants(
+                        commandBuffer,
+                        m_meshShaderPipelineLayout,
+                        VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                        0,
+                        sizeof(pushConstants),
+                        &pushConstants
+                    );
+
+                    m_engine->drawMeshTasks(commandBuffer, lastTask - firstTask, 1, 1);
+                } else {
+                    // Every stream lives in the same buffer, at its own offset. Pulled vertices
+                    // are read through the vertex pull descriptor set instead, and only the
+                    // instance transforms are bound.
+                    if (!m_pullVertices) {
+                        const auto vertexBuffer = m_resourceTable->getBuffer(m_vertexBuffer);
+                        const auto vertexBuffers = std::array<VkBuffer, 2> { vertexBuffer, vertexBuffer };
+                        m_dispatch->vkCmdBindVertexBuffers(
+                            commandBuffer,
+                            0,
+                            static_cast<uint32_t>(m_vertexStreamOffsets.size()),
+                            vertexBuffers.data(),
+                            m_vertexStreamOffsets.data()
+                        );
+                    }
+                    const auto instanceBuffer = m_resourceTable->getBuffer(m_instanceBuffer);
+                    const auto instanceBufferOffset = VkDeviceSize { 0 };
+                    m_dispatch->vkCmdBindVertexBuffers(
+                        commandBuffer,
+                        m_pullVertices ? 0 : static_cast<uint32_t>(m_vertexStreamOffsets.size()),
+                        1,
+                        &instanceBuffer,
+                        &instanceBufferOffset
+                    );
+
+                    m_dispatch->vkCmdBindIndexBuffer(commandBuffer, m_resourceTable->getBuffer(m_indexBuffer), 0, m_geometryPool->getIndexType());
+                    // Chunks may be recorded on other threads than the frame's arena is, so
+                    // the sets are gathered on the stack. Pulled vertices bind a third set.
+                    const auto descriptorSetCount = m_pullVertices ? 3u : 2u;
+                    if (m_useDescriptorBuffer) {
+                        const auto descriptorBufferSets = std::array<DescriptorBufferSet, 3> {
+                            m_uniformBufferSets[m_currentFrame],
+                            m_textureTableBufferSets[m_currentFrame],
+                            m_vertexPullBufferSet,
+                        };
+                        m_descriptorBuffer->bind(
+                            commandBuffer,
+                            VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            m_pipelineLayout,
+                            0,
+                            std::span { descriptorBufferSets }.first(descriptorSetCount)
+                        );
+                    } else {
+                        const auto descriptorSets = std::array<VkDescriptorSet, 3> {
+                            m_descriptorSets[m_currentFrame],
+                            m_textureTableSets[m_currentFrame],
+                            m_vertexPullDescriptorSet,
+                        };
+                        m_dispatch->vkCmdBindDescriptorSets(
+                            commandBuffer,
+                            VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            m_pipelineLayout,
+                            0,
+                            descriptorSetCount,
+                            descriptorSets.data(),
+                            1,
+                            &m_uniformBufferOffset
+                        );
+                        CommandCounters::add(CommandCounter::DescriptorBinds);
+                    }
+
+                    const auto pushConstants = DrawPushConstants {
+                        .model = m_meshPositionTransform,
+                        .textureIndex = this->getFirstMaterialIndex(),
+                        .texCoordOffset = m_pullVertices ? static_cast<uint32_t>(m_vertexStreamOffsets[1] / sizeof(uint32_t)) : 0,
+                        .materialCount = this->getMaterialCount(),
+                    };
+                    m_dispatch->vkCmdPushConstants(
+                        commandBuffer,
+                        m_pipelineLayout,
+                        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                        0,
+                        sizeof(pushConstants),
+                        &pushConstants
+                    );
+
+                    // The prepass lays down the depth of the whole frame before any of it is
+                    // shaded. The first half of the chunks draws the prepass and the rest shade,
+                    // each half splitting the mesh between its own chunks, since the primary
+                    // executes the chunks in order. A single chunk draws both.
+                    const auto depthPrepassPipeline = this->getDepthPrepassPipeline();
+                    auto shadingChunkIndex = chunkIndex;
+                    auto shadingChunkCount = chunkCount;
+                    if (depthPrepassPipeline != VK_NULL_HANDLE) {
+                        const auto prepassChunkCount = std::max(chunkCount / 2, 1u);
+                        if (chunkIndex < prepassChunkCount) {
+                            m_dispatch->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, depthPrepassPipeline);
+                            CommandCounters::add(CommandCounter::PipelineBinds);
+                            this->setDrawState(commandBuffer, this->getDrawState(false), true);
+                            this->recordVertexPipelineDraws(commandBuffer, chunkIndex, prepassChunkCount);
+                            if (chunkCount > 1) {
+                                return;
+                            }
+
+                            m_dispatch->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                            CommandCounters::add(CommandCounter::PipelineBinds);
+                        } else {
+                            shadingChunkIndex = chunkIndex - prepassChunkCount;
+                            shadingChunkCount = chunkCount - prepassChunkCount;
+                        }
+                    }
+
+                    // Until the depth prepass pipeline is ready, the vertex pipeline writes
+                    // the depth it tests.
+                    this->setDrawState(commandBuffer, this->getDrawState(depthPrepassPipeline != VK_NULL_HANDLE), true);
+                    this->recordVertexPipelineDraws(commandBuffer, shadingChunkIndex, shadingChunkCount);
+
+                    // The boxes are tested once every chunk before them has drawn, against
+                    // the depth of the whole frame.
+                    if (occlusionProxyPipeline != VK_NULL_HANDLE && chunkIndex + 1 == chunkCount) {
+                        this->recordOcclusionQueries(commandBuffer, occlusionProxyPipeline);
+                    }
+                }
+            }
+        }
+
+        /// @brief Draw the bounding box of every copy of the mesh inside its occlusion query,
+        /// after the frame's draws, with the state of the vertex pipeline's draws bound.
+        void recordOcclusionQueries(VkCommandBuffer commandBuffer, VkPipeline occlusionProxyPipeline) const {
+            m_dispatch->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, occlusionProxyPipeline);
+            CommandCounters::add(CommandCounter::PipelineBinds);
+            this->setDrawState(commandBuffer, this->getOcclusionProxyDrawState(), true);
+            const auto instanceBuffer = m_resourceTable->getBuffer(m_instanceBuffer);
+            const auto instanceBufferOffset = VkDeviceSize { 0 };
+            m_dispatch->vkCmdBindVertexBuffers(commandBuffer, 0, 1, &instanceBuffer, &instanceBufferOffset);
+
+            // Every copy is bounded by the mesh's bounding sphere around its origin.
+            const auto pushConstants = DrawPushConstants {
+                .model = glm::scale(glm::mat4(1.0f), glm::vec3(m_meshRadius)),
+                .textureIndex = MODEL_TEXTURE_INDEX,
+                .texCoordOffset = 0,
+                .materialCount = 1,
+            };
+            m_dispatch->vkCmdPushConstants(
+                commandBuffer,
+                m_pipelineLayout,
+                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                0,
+                sizeof(pushConstants),
+                &pushConstants
+            );
+
+            for (uint32_t copy = 0; copy < m_instanceCount; copy++) {
+                m_occlusionQueries->beginQuery(commandBuffer, m_currentFrame, copy);
+                m_dispatch->vkCmdDraw(commandBuffer, 14, 1, 0, copy);
+                CommandCounters::add(CommandCounter::Draws);
+                m_occlusionQueries->endQuery(commandBuffer, m_currentFrame, copy);
+            }
+        }
+
+        /// @brief Record the vertex pipeline's draws of chunk `chunkIndex` of `chunkCount`,
+        /// with whichever pipeline is bound.
+        void recordVertexPipelineDraws(VkCommandBuffer commandBuffer, uint32_t chunkIndex, uint32_t chunkCount) const {
+            // One indirect draw covers the whole scene, so only the first chunk draws.
+            // With culling, it draws the surviving draws the frame's cull pass wrote.
+            if (m_drawCuller != nullptr) {
+                if (chunkIndex == 0) {
+                    m_dispatch->vkCmdDrawIndexedIndirectCount(
+                        commandBuffer,
+                        m_drawCuller->getBuffer(),
+                        m_drawCuller->getDrawOffset(m_currentFrame),
+                        m_drawCuller->getBuffer(),
+                        m_drawCuller->getCountOffset(m_currentFrame),
+                        m_drawCuller->getMaxDrawCount(),
+                        sizeof(VkDrawIndexedIndirectCommand)
+                    );
+                    CommandCounters::add(CommandCounter::Draws);
+                }
+
+                return;
+            } else if (m_indirectDrawBuffer != nullptr) {
+                if (chunkIndex == 0) {
+                    m_dispatch->vkCmdDrawIndexedIndirectCount(
+                        commandBuffer,
+                        m_indirectDrawBuffer->getBuffer(),
+                        m_indirectDrawBuffer->getDrawOffset(m_currentFrame),
+                        m_indirectDrawBuffer->getBuffer(),
+                        m_indirectDrawBuffer->getCountOffset(m_currentFrame),
+                        m_indirectDrawBuffer->getMaxDrawCount(),
+                        sizeof(VkDrawIndexedIndirectCommand)
+                    );
+                    CommandCounters::add(CommandCounter::Draws);
+                }
+
+                return;
+            }
+
+            // Each chunk draws its own run of triangles.
+            const auto meshLodLevel = this->selectMeshLodLevel();
+            const auto& meshLod = m_mesh->lods()[meshLodLevel];
+            const auto meshLodFirstIndex = this->getMeshLodFirstIndex(meshLodLevel);
+            const auto triangleCount = meshLod.indexCount / 3;
+            const auto firstTriangle = triangleCount * chunkIndex / chunkCount;
+            const auto lastTriangle = triangleCount * (chunkIndex + 1) / chunkCount;
+            // Under occlusion queries, every copy is a draw of its own, skipped when its box
+            // was hidden in the frame before.
+            if (m_occlusionQueries != nullptr) {
+                for (uint32_t copy = 0; copy < m_instanceCount; copy++) {
+                    m_engine->beginConditionalRendering(
+                        commandBuffer,
+                        m_occlusionQueries->getPredicateBuffer(),
+                        m_occlusionQueries->getPredicateOffset(copy)
+                    );
+                    m_dispatch->vkCmdDrawIndexed(
+                        commandBuffer,
+                        3 * (lastTriangle - firstTriangle),
+                        1,
+                        meshLodFirstIndex + 3 * firstTriangle,
+                        static_cast<int32_t>(m_meshRange.baseVertex),
+                        copy
+                    );
+                    CommandCounters::add(CommandCounter::Draws);
+                    m_engine->endConditionalRendering(commandBuffer);
+                }
+
+                return;
+            }
+
+            // The copies of a stress scene take materials of their own, which the fragment
+            // shader only samples by an index that is uniform across a draw, so every copy is
+            // a draw of its own.
+            if (this->getMaterialCount() > 1) {
+                for (uint32_t copy = 0; copy < m_instanceCount; copy++) {
+                    m_dispatch->vkCmdDrawIndexed(
+                        commandBuffer,
+                        3 * (lastTriangle - firstTriangle),
+                        1,
+                        meshLodFirstIndex + 3 * firstTriangle,
+                        static_cast<int32_t>(m_meshRange.baseVertex),
+                        copy
+                    );
+                    CommandCounters::add(CommandCounter::Draws);
+                }
+
+                return;
+            }
+
+            // Every copy of the mesh is an instance of the same draw.
+            m_dispatch->vkCmdDrawIndexed(
+                commandBuffer,
+                3 * (lastTriangle - firstTriangle),
+                m_instanceCount,
+                meshLodFirstIndex + 3 * firstTriangle,
+                static_cast<int32_t>(m_meshRange.baseVertex),
+                0
+            );
+            CommandCounters::add(CommandCounter::Draws);
+        }
+
+        /// @brief Record the frame's draws into secondary command buffers on the recorder's
+        /// workers, and execute them from `commandBuffer`.
+        void recordSecondaryCommandBuffers(
+            VkCommandBuffer commandBuffer,
+            uint32_t imageIndex,
+            VkPipeline pipeline,
+            bool isMeshShaderPipeline,
+            VkPipeline occlusionProxyPipeline
+        ) {
+            const auto attachmentFormats = this->getAttachmentFormats();
+            const auto inheritanceRenderingInfo = VkCommandBufferInheritanceRenderingInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .viewMask = attachmentFormats.viewMask,
+                .colorAttachmentCount = 1,
+                .pColorAttachmentFormats = &attachmentFormats.colorFormat,
+                .depthAttachmentFormat = attachmentFormats.depthFormat,
+                .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+                .rasterizationSamples = attachmentFormats.sampleCount,
+            };
+            const auto inheritanceInfo = VkCommandBufferInheritanceInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                .pNext = m_useDynamicRendering ? &inheritanceRenderingInfo : nullptr,
+                .renderPass = m_useDynamicRendering ? VK_NULL_HANDLE : m_renderPass,
+                .subpass = 0,
+                .framebuffer = m_useDynamicRendering ? VK_NULL_HANDLE : m_swapChainFramebuffers[imageIndex],
+                .occlusionQueryEnable = VK_FALSE,
+                .queryFlags = 0,
+                // The render pass's profiler scope counts the secondaries' work too.
+                .pipelineStatistics = m_gpuProfiler ? m_gpuProfiler->getPipelineStatistics() : 0,
+            };
+
+            // The recorder waits for every chunk, so the pipeline is captured by reference,
+            // which keeps the recording function small enough not to allocate.
+            const auto drawPipelines = std::tuple { pipeline, isMeshShaderPipeline, occlusionProxyPipeline };
+            const auto secondaryCommandBuffers = m_secondaryCommandRecorder->record(
+                m_currentFrame,
+                inheritanceInfo,
+                [this, &drawPipelines](VkCommandBuffer secondaryCommandBuffer, uint32_t chunkIndex, uint32_t chunkCount) {
+                    const auto& [drawPipeline, isMeshShaderDrawPipeline, drawOcclusionProxyPipeline] = drawPipelines;
+                    this->recordDraws(secondaryCommandBuffer, drawPipeline, isMeshShaderDrawPipeline, drawOcclusionProxyPipeline, chunkIndex, chunkCount);
+                }
+            );
+            m_dispatch->vkCmdExecuteCommands(
+                commandBuffer,
+                static_cast<uint32_t>(secondaryCommandBuffers.size()),
+                secondaryCommandBuffers.data()
+            );
+        }
+
+        void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+            CPU_PROFILE_ZONE("record");
+            const auto deviceGroupBeginInfo = VkDeviceGroupCommandBufferBeginInfo {
+                .sType = VK_STRUCTURE_TYPE_DEVICE_GROUP_COMMAND_BUFFER_BEGIN_INFO,
+                .pNext = nullptr,
+                .deviceMask = this->getFrameDeviceMask(imageIndex),
+            };
+            const auto beginInfo = VkCommandBufferBeginInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .pNext = m_engine->getDeviceCount() > 1 ? &deviceGroupBeginInfo : nullptr,
+                .flags = 0,                  // Optional.
+                .pInheritanceInfo = nullptr, // Optional.
+            };
+
+            const auto resultBeginCommandBuffer = m_dispatch->vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            if (resultBeginCommandBuffer != VK_SUCCESS) {
+                throw std::runtime_error("failed to begin recording command buffer!");
+            }
+
+            // Queries are reset outside of the render pass.
+            if (m_gpuProfiler) {
+                m_gpuProfiler->resetFrame(commandBuffer, m_currentFrame);
+            }
+
+            // The dashboard the frame samples comes back from the compute queue first.
+            if (m_dashboardTexture != nullptr) {
+                m_dashboardTexture->recordAcquire(commandBuffer);
+            }
+
+            // The passes of the frame, with the barriers between them worked out from what each
+            // one reads and writes. Draws are culled outside of the render pass, ahead of the
+            // draw that reads them, and the cull pass is dropped when nothing draws with what
+            // it culls, like when the mesh shader pipeline draws the frame. The depth pyramid
+            // is built after the pass that writes depth, for the next frame to cull against, and
+            // the post effects after the pass that writes the scene color, for the next frame to
+            // tone map with. The graph and the uses of its passes come from the frame's arena.
+            const auto [pipeline, isMeshShaderPipeline] = this->selectPipeline();
+            auto& frameArena = this->getFrameArena();
+            auto renderGraph = RenderGraph { m_engine->supportsSynchronization2(), &frameArena };
+            auto cullUses = std::pmr::vector<RenderGraphUse> { &frameArena };
+            auto renderPassUses = std::pmr::vector<RenderGraphUse> { &frameArena };
+            auto depthPyramidUses = std::pmr::vector<RenderGraphUse> { &frameArena };
+            auto postEffectsUses = std::pmr::vector<RenderGraphUse> { &frameArena };
+            auto shadingRateUses = std::pmr::vector<RenderGraphUse> { &frameArena };
+            auto occlusionResolveUses = std::pmr::vector<RenderGraphUse> { &frameArena };
+            auto performanceHudUses = std::pmr::vector<RenderGraphUse> { &frameArena };
+            // The frame's queries are only run when the vertex pipeline draws, and once the
+            // boxes have a pipeline to draw with. Until then the predicates stay as they are.
+            const auto occlusionProxyPipeline = pipeline != VK_NULL_HANDLE && !isMeshShaderPipeline ? this->getOcclusionProxyPipeline() : VK_NULL_HANDLE;
+            if (m_occlusionQueries != nullptr) {
+                // The frame before resolved its queries into the predicates last, earlier on
+                // the same queue, and the next frame reads what this one resolves.
+                const auto predicates = renderGraph.importBuffer(
+                    m_occlusionQueries->getPredicateBuffer(),
+                    RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_COPY_BIT,
+                        .access = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                    },
+                    true
+                );
+                renderPassUses.push_back(RenderGraphUse {
+                    .resource = predicates,
+                    .state = RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_CONDITIONAL_RENDERING_BIT_EXT,
+                        .access = VK_ACCESS_2_CONDITIONAL_RENDERING_READ_BIT_EXT,
+                    },
+                });
+                occlusionResolveUses.push_back(RenderGraphUse {
+                    .resource = predicates,
+                    .state = RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_COPY_BIT,
+                        .access = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                    },
+                });
+            }
+            if (m_drawCuller != nullptr) {
+                // Every frame slot culls into a region of its own, which the slot's last submit
+                // is done with.
+                const auto culledDraws = renderGraph.importBuffer(m_drawCuller->getBuffer(), RenderGraphState {}, false);
+                cullUses.push_back(RenderGraphUse {
+                    .resource = culledDraws,
+                    .state = RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                        .access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                    },
+                });
+                if (pipeline != VK_NULL_HANDLE && !isMeshShaderPipeline) {
+                    renderPassUses.push_back(RenderGraphUse {
+                        .resource = culledDraws,
+                        .state = RenderGraphState {
+                            .stages = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+                            .access = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+                        },
+                    });
+                }
+            }
+
+            if (m_depthPyramid != nullptr) {
+                // The frame before wrote the pyramid last, earlier on the same queue.
+                const auto depthPyramid = renderGraph.importImage(
+                    m_depthPyramid->getImage(),
+                    VkImageSubresourceRange {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = m_depthPyramid->getMipLevels(),
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                    },
+                    RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                        .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                        .layout = VK_IMAGE_LAYOUT_GENERAL,
+                    },
+                    RenderGraphState { .layout = VK_IMAGE_LAYOUT_GENERAL },
+                    true
+                );
+                // The render pass discards the depth whatever layout it is in, and waits for
+                // the frame before itself. The next one finds it attached again.
+                const auto depthFormat = this->findDepthFormat();
+                const auto depthAttachmentState = RenderGraphState {
+                    .stages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                    .access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                    .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                };
+                const auto depth = renderGraph.importImage(
+                    m_depthImage,
+                    VkImageSubresourceRange {
+                        .aspectMask = this->hasStencilComponent(depthFormat) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = 1,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                    },
+                    RenderGraphState { .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL },
+                    depthAttachmentState,
+                    false
+                );
+                cullUses.push_back(RenderGraphUse {
+                    .resource = depthPyramid,
+                    .state = RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                        .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                        .layout = VK_IMAGE_LAYOUT_GENERAL,
+                    },
+                });
+                renderPassUses.push_back(RenderGraphUse { .resource = depth, .state = depthAttachmentState });
+                depthPyramidUses.push_back(RenderGraphUse {
+                    .resource = depth,
+                    .state = RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                        .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                    },
+                });
+                depthPyramidUses.push_back(RenderGraphUse {
+                    .resource = depthPyramid,
+                    .state = RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                        .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                        .layout = VK_IMAGE_LAYOUT_GENERAL,
+                    },
+                });
+            }
+
+            const auto isPostEffectsBuilt = m_luminanceReduction != nullptr || m_bloomChain != nullptr;
+            if (isPostEffectsBuilt) {
+                // The post effects of the frame before sampled the input last, and the render
+                // pass draws over it whatever layout it is in.
+                const auto sampledState = RenderGraphState {
+                    .stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                    .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                    .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                };
+                const auto postProcessInput = renderGraph.importImage(
+                    m_postProcessInputImage,
+                    VkImageSubresourceRange {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = 1,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                    },
+                    sampledState,
+                    RenderGraphState { .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+                    false
+                );
+                renderPassUses.push_back(RenderGraphUse {
+                    .resource = postProcessInput,
+                    .state = RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                        .access = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                        .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    },
+                });
+                postEffectsUses.push_back(RenderGraphUse { .resource = postProcessInput, .state = sampledState });
+
+                // The frame before built the chains last, earlier on the same queue, and the
+                // post process subpass samples them before this frame builds them again.
+                const auto importChain = [&renderGraph, &renderPassUses, &postEffectsUses](VkImage image, uint32_t mipLevels) {
+                    const auto chain = renderGraph.importImage(
+                        image,
+                        VkImageSubresourceRange {
+                            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                            .baseMipLevel = 0,
+                            .levelCount = mipLevels,
+                            .baseArrayLayer = 0,
+                            .layerCount = 1,
+                        },
+                        RenderGraphState {
+                            .stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                            .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                            .layout = VK_IMAGE_LAYOUT_GENERAL,
+                        },
+                        RenderGraphState { .layout = VK_IMAGE_LAYOUT_GENERAL },
+                        true
+                    );
+                    renderPassUses.push_back(RenderGraphUse {
+                        .resource = chain,
+                        .state = RenderGraphState {
+                            .stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                            .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                            .layout = VK_IMAGE_LAYOUT_GENERAL,
+                        },
+                    });
+                    postEffectsUses.push_back(RenderGraphUse {
+                        .resource = chain,
+                        .state = RenderGraphState {
+                            .stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                            .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                            .layout = VK_IMAGE_LAYOUT_GENERAL,
+                        },
+                    });
+                };
+                if (m_luminanceReduction != nullptr) {
+                    importChain(m_luminanceReduction->getImage(), m_luminanceReduction->getMipLevels());
+                }
+                if (m_bloomChain != nullptr) {
+                    importChain(m_bloomChain->getImage(), m_bloomChain->getMipLevels());
+                }
+            }
+
+            // The shading rate image is built from the history the upscaler wrote in the frame
+            // before, whose render pass read the shading rate image last.
+            const auto shadingRateSourceIndex = m_temporalUpscaler != nullptr ? m_temporalUpscaler->getOutputIndex() : 0;
+            if (m_shadingRateImage != nullptr) {
+                const auto colorSubresourceRange = VkImageSubresourceRange {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                };
+                const auto history = renderGraph.importImage(
+                    m_temporalUpscaler->getOutputImage(),
+                    colorSubresourceRange,
+                    RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                        .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                        .layout = VK_IMAGE_LAYOUT_GENERAL,
+                    },
+                    RenderGraphState { .layout = VK_IMAGE_LAYOUT_GENERAL },
+                    false
+                );
+                const auto shadingRateAttachmentState = RenderGraphState {
+                    .stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR,
+                    .access = VK_ACCESS_2_FRAGMENT_SHADING_RATE_ATTACHMENT_READ_BIT_KHR,
+                    .layout = VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR,
+                };
+                const auto shadingRate = renderGraph.importImage(
+                    m_shadingRateImage->getImage(),
+                    colorSubresourceRange,
+                    shadingRateAttachmentState,
+                    shadingRateAttachmentState,
+                    false
+                );
+                shadingRateUses.push_back(RenderGraphUse {
+                    .resource = history,
+                    .state = RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                        .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                        .layout = VK_IMAGE_LAYOUT_GENERAL,
+                    },
+                });
+                shadingRateUses.push_back(RenderGraphUse {
+                    .resource = shadingRate,
+                    .state = RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                        .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                        .layout = VK_IMAGE_LAYOUT_GENERAL,
+                    },
+                });
+                renderPassUses.push_back(RenderGraphUse { .resource = shadingRate, .state = shadingRateAttachmentState });
+            }
+
+            // The HUD is drawn over the finished swap chain image, which the render pass or the
+            // upscale leaves in its final layout themselves.
+            const auto isPerformanceHudDrawn = this->isPerformanceHudDrawn();
+            if (isPerformanceHudDrawn) {
+                const auto swapChainImage = renderGraph.importImage(
+                    m_swapChainImages[imageIndex],
+                    VkImageSubresourceRange {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = 1,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                    },
+                    RenderGraphState { .layout = this->getFinalColorLayout() },
+                    RenderGraphState { .layout = this->getFinalColorLayout() },
+                    false
+                );
+                renderPassUses.push_back(RenderGraphUse {
+                    .resource = swapChainImage,
+                    .state = RenderGraphState {
+                        .stages = m_dynamicResolution ? VK_PIPELINE_STAGE_2_BLIT_BIT : VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                        .access = m_dynamicResolution ? VK_ACCESS_2_TRANSFER_WRITE_BIT : VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                        .layout = this->getFinalColorLayout(),
+                    },
+                });
+                performanceHudUses.push_back(RenderGraphUse {
+                    .resource = swapChainImage,
+                    .state = RenderGraphState {
+                        .stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                        .access = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                        .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                    },
+                });
+            }
+
+            if (m_drawCuller != nullptr) {
+                renderGraph.addPass("cull draws", cullUses, [this](VkCommandBuffer commandBuffer) {
+                    const auto cullScope = this->beginGpuScope(commandBuffer, "cull draws");
+                    m_drawCuller->record(commandBuffer, m_currentFrame, m_uniformBufferOffset);
+                    this->endGpuScope(commandBuffer, cullScope);
+                }, false);
+            }
+            // The cleared history is black and would halve the rate everywhere, so the rate
+            // stays at 1x1 until the upscaler has written a frame into it.
+            if (m_shadingRateImage != nullptr && m_temporalUpscaler->hasHistory()) {
+                renderGraph.addPass("shading rate", shadingRateUses, [this, shadingRateSourceIndex](VkCommandBuffer commandBuffer) {
+                    const auto shadingRateScope = this->beginGpuScope(commandBuffer, "shading rate");
+                    m_shadingRateImage->record(commandBuffer, shadingRateSourceIndex, this->getRenderExtent());
+                    this->endGpuScope(commandBuffer, shadingRateScope);
+                }, false);
+            }
+            if (occlusionProxyPipeline != VK_NULL_HANDLE) {
+                renderGraph.addPass("reset occlusion queries", std::span<const RenderGraphUse> {}, [this](VkCommandBuffer commandBuffer) {
+                    m_occlusionQueries->recordReset(commandBuffer, m_currentFrame);
+                }, true);
+            }
+            // The graph is executed before the render pass's arguments go out of scope, so they
+            // are captured by reference, and the pass fits in its `std::function`.
+            const auto renderPassArguments = std::tuple { imageIndex, pipeline, isMeshShaderPipeline, occlusionProxyPipeline };
+            renderGraph.addPass("render pass", renderPassUses, [this, &renderPassArguments](VkCommandBuffer commandBuffer) {
+                const auto& [passImageIndex, passPipeline, passIsMeshShaderPipeline, passOcclusionProxyPipeline] = renderPassArguments;
+                this->recordRenderPass(commandBuffer, passImageIndex, passPipeline, passIsMeshShaderPipeline, passOcclusionProxyPipeline);
+            }, true);
+            if (isPerformanceHudDrawn) {
+                renderGraph.addPass("performance hud", performanceHudUses, [this, imageIndex](VkCommandBuffer commandBuffer) {
+                    this->recordPerformanceHud(commandBuffer, imageIndex);
+                }, true);
+            }
+            if (occlusionProxyPipeline != VK_NULL_HANDLE) {
+                renderGraph.addPass("resolve occlusion queries", occlusionResolveUses, [this](VkCommandBuffer commandBuffer) {
+                    m_occlusionQueries->recordResolve(commandBuffer, m_currentFrame);
+                }, false);
+            }
+            if (m_depthPyramid != nullptr) {
+                renderGraph.addPass("depth pyramid", depthPyramidUses, [this](VkCommandBuffer commandBuffer) {
+                    const auto depthPyramidScope = this->beginGpuScope(commandBuffer, "depth pyramid");
+                    m_depthPyramid->record(commandBuffer);
+                    this->endGpuScope(commandBuffer, depthPyramidScope);
+                }, false);
+            }
+            if (isPostEffectsBuilt) {
+                renderGraph.addPass("post effects", postEffectsUses, [this](VkCommandBuffer commandBuffer) {
+                    const auto postEffectsScope = this->beginGpuScope(commandBuffer, "post effects");
+                    if (m_luminanceReduction != nullptr) {
+                        m_luminanceReduction->record(commandBuffer, POST_PROCESS_EXPOSURE_ADAPTATION);
+                    }
+                    if (m_bloomChain != nullptr) {
+                        m_bloomChain->record(commandBuffer);
+                    }
+                    this->endGpuScope(commandBuffer, postEffectsScope);
+                }, false);
+            }
+            renderGraph.execute(commandBuffer);
+
+            if (m_dashboardTexture != nullptr) {
+                this->recordDashboardTexture(commandBuffer);
+            }
+            if (m_useLodFeedback) {
+                m_lodFeedback->recordReadback(commandBuffer);
+            }
+            if (m_virtualTexture != nullptr) {
+                m_virtualTexture->recordReadback(commandBuffer);
+            }
+
+            const auto resultEndCommandBuffer = m_dispatch->vkEndCommandBuffer(commandBuffer);
+            if (resultEndCommandBuffer != VK_SUCCESS) {
+                throw std::runtime_error("failed to record command buffer!");
+            }
+        }
+
+        /// @brief Draw the performance HUD over the finished swap chain image.
+        void recordPerformanceHud(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+            const auto hudScope = this->beginGpuScope(commandBuffer, "performance hud");
+            const auto colorAttachment = VkRenderingAttachmentInfo {
+                .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+                .pNext = nullptr,
+                .imageView = m_swapChainImageViews[imageIndex],
+                .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .resolveMode = VK_RESOLVE_MODE_NONE,
+                .resolveImageView = VK_NULL_HANDLE,
+                .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
+                .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+                .clearValue = VkClearValue {},
+            };
+            const auto renderingInfo = VkRenderingInfo {
+                .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .renderArea = VkRect2D {
+                    .offset = VkOffset2D { 0, 0 },
+                    .extent = m_swapChainExtent,
+                },
+                .layerCount = 1,
+                .viewMask = 0,
+                .colorAttachmentCount = 1,
+                .pColorAttachments = &colorAttachment,
+                .pDepthAttachment = nullptr,
+                .pStencilAttachment = nullptr,
+            };
+            m_dispatch->vkCmdBeginRendering(commandBuffer, &renderingInfo);
+            m_performanceHud->record(commandBuffer, m_currentFrame, m_swapChainExtent);
+            m_dispatch->vkCmdEndRendering(commandBuffer);
+            this->endGpuScope(commandBuffer, hudScope);
+        }
+
+        /// @brief Draw the dashboard into the next copy of its target, and hand the copy to
+        /// the compute queue for its mip chain.
+        void recordDashboardTexture(VkCommandBuffer commandBuffer) {
+            const auto dashboardScope = this->beginGpuScope(commandBuffer, "dashboard texture");
+            const auto extent = m_dashboardTexture->getExtent();
+            m_dashboardTexture->recordBeginRendering(commandBuffer);
+            const auto colorAttachment = VkRenderingAttachmentInfo {
+                .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+                .pNext = nullptr,
+                .imageView = m_dashboardTexture->getAttachmentView(),
+                .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .resolveMode = VK_RESOLVE_MODE_NONE,
+                .resolveImageView = VK_NULL_HANDLE,
+                .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+                .clearValue = VkClearValue { .color = VkClearColorValue { { 0.02f, 0.02f, 0.05f, 1.0f } } },
+            };
+            const auto renderingInfo = VkRenderingInfo {
+                .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .renderArea = VkRect2D {
+                    .offset = VkOffset2D { 0, 0 },
+                    .extent = extent,
+                },
+                .layerCount = 1,
+                .viewMask = 0,
+                .colorAttachmentCount = 1,
+                .pColorAttachments = &colorAttachment,
+                .pDepthAttachment = nullptr,
+                .pStencilAttachment = nullptr,
+            };
+            m_dispatch->vkCmdBeginRendering(commandBuffer, &renderingInfo);
+            m_dashboardHud->record(commandBuffer, m_currentFrame, extent);
+            m_dispatch->vkCmdEndRendering(commandBuffer);
+            m_dashboardTexture->recordEndRendering(commandBuffer);
+            this->endGpuScope(commandBuffer, dashboardScope);
+        }
+
+        /// @brief Record the pass that draws the frame into the swap chain image.
+        void recordRenderPass(
+            VkCommandBuffer commandBuffer,
+            uint32_t imageIndex,
+            VkPipeline pipeline,
+            bool isMeshShaderPipeline,
+            VkPipeline occlusionProxyPipeline
+        ) {
+            const auto renderPassScope = this->beginGpuScope(commandBuffer, "render pass");
+
+            // NOTE: The order of `clearValues` should be identical to the order of the attachments
+            // in the render pass.
+            const auto clearValues = std::array<VkClearValue, 2> {
+                VkClearValue { .color = VkClearColorValue { { 0.0f, 0.0f, 0.0f, 1.0f } } },
+                VkClearValue { .depthStencil = VkClearDepthStencilValue { FAR_DEPTH, 0 } },
+            };
+
+            // Secondaries are reset every frame, so the command buffers of a static scene,
+            // which are submitted over and over, always draw inline.
+            const auto useSecondaryCommandBuffers = m_secondaryCommandRecorder != nullptr;
+            if (m_useDynamicRendering) {
+                const auto renderingFlags = [useSecondaryCommandBuffers]() -> VkRenderingFlags {
+                    if (useSecondaryCommandBuffers) {
+                        return VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+                    } else {
+                        return 0;
+                    }
+                }();
+                this->beginDynamicRendering(commandBuffer, imageIndex, clearValues, renderingFlags);
+            } else {
+                const auto deviceRenderAreas = this->getDeviceRenderAreas();
+                const auto deviceGroupRenderPassInfo = VkDeviceGroupRenderPassBeginInfo {
+                    .sType = VK_STRUCTURE_TYPE_DEVICE_GROUP_RENDER_PASS_BEGIN_INFO,
+                    .pNext = nullptr,
+                    .deviceMask = this->getFrameDeviceMask(imageIndex),
+                    .deviceRenderAreaCount = static_cast<uint32_t>(deviceRenderAreas.size()),
+                    .pDeviceRenderAreas = deviceRenderAreas.data(),
+                };
+                const auto renderPassInfo = VkRenderPassBeginInfo {
+                    .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                    .pNext = m_engine->getDeviceCount() > 1 ? &deviceGroupRenderPassInfo : nullptr,
+                    .renderPass = m_renderPass,
+                    .framebuffer = m_swapChainFramebuffers[imageIndex],
+                    .renderArea.offset = VkOffset2D { 0, 0 },
+                    .renderArea.extent = m_swapChainExtent,
+                    .clearValueCount = static_cast<uint32_t>(clearValues.size()),
+                    .pClearValues = clearValues.data(),
+                };
+
+                const auto subpassContents = useSecondaryCommandBuffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+                m_dispatch->vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, subpassContents);
+            }
+
+            if (useSecondaryCommandBuffers) {
+                this->recordSecondaryCommandBuffers(commandBuffer, imageIndex, pipeline, isMeshShaderPipeline, occlusionProxyPipeline);
+            } else {
+                this->recordDraws(commandBuffer, pipeline, isMeshShaderPipeline, occlusionProxyPipeline, 0, 1);
+            }
+
+            if (m_useDynamicRendering) {
+                this->endDynamicRendering(commandBuffer, imageIndex);
+            } else {
+                if (m_usePostProcessSubpass) {
+                    this->recordPostProcess(commandBuffer);
+                }
+                m_dispatch->vkCmdEndRenderPass(commandBuffer);
+            }
+            this->endGpuScope(commandBuffer, renderPassScope);
+        }
+
+        /// @brief Move on to the second subpass of the render pass, and draw the scene color,
+        /// tone mapped, graded and encoded, into the swap chain image.
+        void recordPostProcess(VkCommandBuffer commandBuffer) {
+            m_dispatch->vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+            m_dispatch->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_postProcessPipeline);
+            CommandCounters::add(CommandCounter::PipelineBinds);
+            m_dispatch->vkCmdBindDescriptorSets(
+                commandBuffer,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                m_postProcessPipelineLayout,
+                0,
+                1,
+                &m_postProcessDescriptorSet,
+                0,
+                nullptr
+            );
+            CommandCounters::add(CommandCounter::DescriptorBinds);
+
+            const auto viewport = VkViewport {
+                .x = 0.0f,
+                .y = 0.0f,
+                .width = static_cast<float>(m_swapChainExtent.width),
+                .height = static_cast<float>(m_swapChainExtent.height),
+                .minDepth = 0.0f,
+                .maxDepth = 1.0f,
+            };
+            m_dispatch->vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+            const auto scissor = VkRect2D {
+                .offset = VkOffset2D { 0, 0 },
+                .extent = m_swapChainExtent,
+            };
+            m_dispatch->vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+            const auto pushConstants = PostProcessPushConstants {
+                .exposure = POST_PROCESS_EXPOSURE,
+                .contrast = POST_PROCESS_CONTRAST,
+                .saturation = POST_PROCESS_SATURATION,
+                .bloomIntensity = POST_PROCESS_BLOOM_INTENSITY,
+                .inverseExtent = glm::vec2 {
+                    1.0f / static_cast<float>(m_swapChainExtent.width),
+                    1.0f / static_cast<float>(m_swapChainExtent.height),
+                },
+                .bloomLevelCount = m_bloomChain != nullptr ? m_bloomChain->getMipLevels() : 0,
+            };
+            m_dispatch->vkCmdPushConstants(
+                commandBuffer,
+                m_postProcessPipelineLayout,
+                VK_SHADER_STAGE_FRAGMENT_BIT,
+                0,
+                sizeof(pushConstants),
+                &pushConstants
+            );
+            m_dispatch->vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+            CommandCounters::add(CommandCounter::Draws);
+        }
+
+        /// @brief Open a GPU profiler scope in the frame being recorded, if the GPU is profiled.
+        uint32_t beginGpuScope(VkCommandBuffer commandBuffer, const std::string& name) {
+            if (m_gpuProfiler) {
+                return m_gpuProfiler->beginScope(commandBuffer, name);
+            } else {
+                return 0;
+            }
+        }
+
+        void endGpuScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+            if (m_gpuProfiler) {
+                m_gpuProfiler->endScope(commandBuffer, scope);
+            }
+        }
+
+        /// @brief Move the render scale toward the one that keeps the render pass within its
+        /// budget, from the pass's time in the frame just resolved.
+        void updateDynamicResolution() {
+            const auto renderPassMilliseconds = m_gpuProfiler->getLatestMilliseconds("render pass");
+            if (renderPassMilliseconds.has_value() && m_dynamicResolution->update(*renderPassMilliseconds)) {
+                this->updateSamplerAnisotropyLimit();
+            }
+        }
+
+        /// @brief Cap the anisotropy of every sampler policy at the preset of the device
+        /// profile, and at the tier the render scale of dynamic resolution leaves.
+        ///
+        /// @note The samplers themselves are taken again as the frames come up.
+        void updateSamplerAnisotropyLimit() {
+            auto& samplerCache = m_engine->getSamplerCache();
+            auto anisotropyLimit = m_performancePreset ? m_performancePreset->maxAnisotropy : samplerCache.getMaxAnisotropy();
+            if (m_dynamicResolution) {
+                const auto tierSteps = static_cast<uint32_t>(std::floor((1.0f - m_dynamicResolution->getScale()) / DYNAMIC_RESOLUTION_FILTERING_STEP));
+                const auto tier = static_cast<AnisotropyTier>(static_cast<uint32_t>(AnisotropyTier::High) - std::min(tierSteps, static_cast<uint32_t>(AnisotropyTier::High)));
+                anisotropyLimit = std::min(anisotropyLimit, samplerCache.getTierAnisotropy(tier));
+            }
+
+            samplerCache.setAnisotropyLimit(anisotropyLimit);
+        }
+
+        /// @brief Take the samplers of the model texture and of the stress materials again,
+        /// once the sampler cache maps their policies to other samplers, and point the stress
+        /// materials of the frame's texture table at them.
+        ///
+        /// @note Must be called after the frame has been waited for on the frame timeline,
+        /// since it may update the frame's texture table. The model texture is pointed at its
+        /// sampler by `updateTextureStreaming`.
+        void updateTextureSamplers(uint32_t currentFrame) {
+            const auto samplerGeneration = m_engine->getSamplerCache().getGeneration();
+            if (samplerGeneration != m_samplerGeneration) {
+                this->createTextureSampler();
+                if (m_stressSceneOptions) {
+                    this->createStressSamplers();
+                }
+                m_samplerGeneration = samplerGeneration;
+            }
+
+            if (m_textureTableSamplerGenerations[currentFrame] == m_samplerGeneration) {
+                return;
+            }
+
+            const auto textureTable = this->getTextureTable();
+            if (textureTable.size() > STRESS_MATERIAL_TEXTURE_INDEX) {
+                const auto materialCount = static_cast<uint32_t>(textureTable.size()) - STRESS_MATERIAL_TEXTURE_INDEX;
+                if (m_useDescriptorBuffer) {
+                    for (uint32_t i = STRESS_MATERIAL_TEXTURE_INDEX; i < textureTable.size(); i++) {
+                        m_descriptorBuffer->writeCombinedImageSampler(m_textureTableBufferSets[currentFrame], 0, i, textureTable[i]);
+                    }
+                } else {
+                    const auto descriptorWrite = VkWriteDescriptorSet {
+                        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                        .dstSet = m_textureTableSets[currentFrame],
+                        .dstBinding = 0,
+                        .dstArrayElement = STRESS_MATERIAL_TEXTURE_INDEX,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                        .descriptorCount = materialCount,
+                        .pImageInfo = textureTable.data() + STRESS_MATERIAL_TEXTURE_INDEX,
+                    };
+                    m_dispatch->vkUpdateDescriptorSets(m_engine->getLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+                }
+            }
+
+            m_textureTableSamplerGenerations[currentFrame] = m_samplerGeneration;
+        }
+
+        /// @brief Show the rolling GPU timings of every scope in the window title.
+        void updateGpuTimingsTitle() {
+            if (!SHOW_GPU_TIMINGS_IN_TITLE || !m_gpuProfiler || m_isHeadless) {
+                return;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if (std::chrono::duration<double> { now - m_gpuTimingsTitleTime }.count() < GPU_TIMINGS_TITLE_PERIOD) {
+                return;
+            }
+
+            m_gpuTimingsTitleTime = now;
+            auto title = WINDOW_TITLE;
+            for (const auto& statistics : m_gpuProfiler->getStatistics()) {
+                title += fmt::format(
+                    " | {} {:.2f} ms ({:.2f}-{:.2f})",
+                    statistics.name,
+                    statistics.averageMilliseconds,
+                    statistics.minMilliseconds,
+                    statistics.maxMilliseconds
+                );
+            }
+
+            m_engine->setWindowTitle(title);
+        }
+
+        /// @brief Create the performance HUD for the format of the swap chain, with a region
+        /// of its buffer for the most frames in flight there can be, so that it outlives
+        /// changes to the number of frames in flight.
+        void createPerformanceHud() {
+            m_performanceHud = std::make_unique<PerformanceHud>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_engine->getPipelineCache(),
+                this->getShaderCode(HlslShader::HudVert),
+                this->getShaderCode(HlslShader::HudFrag),
+                m_swapChainImageFormat,
+                MAX_FRAMES_IN_FLIGHT
+            );
+            m_isPerformanceHudVisible = SHOW_PERFORMANCE_HUD;
+        }
+
+        /// @brief Create the dashboard target, with a copy for every frame in flight there
+        /// can be and one more, the HUD that draws into it, and the trilinear sampler the
+        /// model reads it with.
+        void createDashboardTexture() {
+            const auto format = VK_FORMAT_R8G8B8A8_SRGB;
+            m_dashboardTexture = std::make_unique<RenderTexture>(
+                m_engine->getDeviceCapabilities(),
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_engine->getQueueSubmitter(),
+                m_engine->getPipelineCache(),
+                m_engine->supportsPushDescriptors(),
+                m_engine->supportsSynchronization2(),
+                shaders_hlsl::getHlslShader(HlslShader::MipmapComp),
+                shaders_hlsl::getHlslShader(HlslShader::MipmapFilterComp),
+                shaders_hlsl::getHlslShader(HlslShader::MipmapVolumeComp),
+                m_engine->getComputeQueue(),
+                m_engine->getGraphicsQueueFamilyIndex(),
+                m_engine->getComputeQueueFamilyIndex(),
+                format,
+                VkExtent2D { DASHBOARD_TEXTURE_SIZE, DASHBOARD_TEXTURE_SIZE },
+                MAX_FRAMES_IN_FLIGHT + 1
+            );
+            m_dashboardHud = std::make_unique<PerformanceHud>(
+                m_engine->getLogicalDevice(),
+                m_engine->getMemoryAllocator(),
+                m_engine->getPipelineCache(),
+                this->getShaderCode(HlslShader::HudVert),
+                this->getShaderCode(HlslShader::HudFrag),
+                format,
+                MAX_FRAMES_IN_FLIGHT
+            );
+
+            auto& samplerCache = m_engine->getSamplerCache();
+            m_dashboardSampler = samplerCache.getSampler(VkSamplerCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                .magFilter = VK_FILTER_LINEAR,
+                .minFilter = VK_FILTER_LINEAR,
+                .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                .anisotropyEnable = VK_FALSE,
+                .maxAnisotropy = 1.0f,
+                .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+                .unnormalizedCoordinates = VK_FALSE,
+                .compareEnable = VK_FALSE,
+                .compareOp = VK_COMPARE_OP_ALWAYS,
+                .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+                .minLod = 0.0f,
+                .maxLod = VK_LOD_CLAMP_NONE,
+                .mipLodBias = 0.0f,
+            });
+        }
+
+        /// @brief Whether the frame draws the performance HUD, which is left out while a
+        /// recreated swap chain has a format other than the one its pipeline was built for.
+        bool isPerformanceHudDrawn() const {
+            return m_performanceHud != nullptr
+                && m_isPerformanceHudVisible
+                && m_performanceHud->getColorFormat() == m_swapChainImageFormat;
+        }
+
+        /// @brief Add the frame's times to the graphs of the performance HUD, and write the
+        /// overlay of the current frame slot while it is drawn.
+        ///
+        /// @note The frame time on the CPU is the time since the last frame got here, and
+        /// the one on the GPU spans the scopes of the last frame resolved. The draws and
+        /// triangles are the ones submitted, before the GPU culls any. Must be called once
+        /// the slot's previous submit has finished.
+        void updatePerformanceHud(const SceneState& sceneState) {
+            if (m_performanceHud == nullptr) {
+                return;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            const auto gpuMilliseconds = m_gpuProfiler ? m_gpuProfiler->getLatestFrameMilliseconds() : std::nullopt;
+            auto cpuMilliseconds = 0.0;
+            if (m_lastFrameStartTime.has_value()) {
+                cpuMilliseconds = std::chrono::duration<double, std::milli> { now - *m_lastFrameStartTime }.count();
+                m_performanceHud->addFrameTimes(cpuMilliseconds, gpuMilliseconds);
+                if (m_dashboardHud != nullptr) {
+                    m_dashboardHud->addFrameTimes(cpuMilliseconds, gpuMilliseconds);
+                }
+            }
+            m_lastFrameStartTime = now;
+            if (!this->isPerformanceHudDrawn()) {
+                return;
+            }
+
+            CPU_PROFILE_ZONE("performance hud");
+            auto& hud = *m_performanceHud;
+            const auto textColor = PerformanceHud::packColor(255, 255, 255, 255);
+            const auto warningColor = PerformanceHud::packColor(255, 96, 96, 255);
+            const auto margin = 8.0f;
+            auto y = margin;
+            // Every line is formatted into the same buffer, and drawn over a panel of its
+            // own width, so the overlay allocates nothing.
+            auto line = std::array<char, 128> {};
+            const auto addLine = [&hud, &y, margin](uint32_t color, std::string_view text) {
+                hud.addRect(margin - 2.0f, y - 2.0f, PerformanceHud::CHARACTER_ADVANCE * static_cast<float>(text.size()) + 4.0f, PerformanceHud::LINE_HEIGHT, PerformanceHud::packColor(0, 0, 0, 160));
+                hud.addText(margin, y, text, color);
+                y += PerformanceHud::LINE_HEIGHT;
+            };
+            const auto formatLine = [&line]<typename... Args>(fmt::format_string<Args...> format, Args&&... args) -> std::string_view {
+                const auto result = fmt::format_to_n(line.data(), line.size(), format, std::forward<Args>(args)...);
+
+                return std::string_view { line.data(), std::min(result.size, line.size()) };
+            };
+
+            hud.beginFrame(m_currentFrame);
+
+            addLine(textColor, gpuMilliseconds.has_value()
+                ? formatLine("CPU {:.2f} MS  GPU {:.2f} MS", cpuMilliseconds, *gpuMilliseconds)
+                : formatLine("CPU {:.2f} MS", cpuMilliseconds));
+            const auto& displayLatency = m_frameLatencyTracker.getInputToDisplayStatistics();
+            const auto& presentLatency = m_frameLatencyTracker.getInputToPresentStatistics();
+            if (displayLatency.sampleCount > 0) {
+                addLine(textColor, formatLine("INPUT TO DISPLAY {:.2f} MS", displayLatency.latestMilliseconds));
+            } else if (presentLatency.sampleCount > 0) {
+                addLine(textColor, formatLine("INPUT TO PRESENT {:.2f} MS", presentLatency.latestMilliseconds));
+            }
+
+            const auto graphWidth = 2.0f * static_cast<float>(PerformanceHud::GRAPH_LENGTH);
+            const auto graphHeight = 48.0f;
+            hud.addGraph(margin, y, graphWidth, graphHeight, PerformanceHudSeries::Cpu, PERFORMANCE_HUD_BUDGET_MILLISECONDS);
+            if (m_gpuProfiler) {
+                hud.addGraph(2.0f * margin + graphWidth, y, graphWidth, graphHeight, PerformanceHudSeries::Gpu, PERFORMANCE_HUD_BUDGET_MILLISECONDS);
+            }
+            y += graphHeight + margin;
+
+            if (m_gpuProfiler) {
+                for (const auto& statistics : m_gpuProfiler->getStatistics()) {
+                    addLine(textColor, formatLine(
+                        "{} {:.2f} MS ({:.2f}-{:.2f})",
+                        statistics.name,
+                        statistics.averageMilliseconds,
+                        statistics.minMilliseconds,
+                        statistics.maxMilliseconds
+                    ));
+                }
+            }
+
+            // The budget of every heap, with a bar that turns red as it fills up.
+            const auto& allocator = m_engine->getMemoryAllocator();
+            const auto& memoryProperties = allocator.getMemoryProperties();
+            for (uint32_t heapIndex = 0; heapIndex < memoryProperties.memoryHeapCount; heapIndex++) {
+                const auto heapBudget = allocator.getHeapBudget(heapIndex);
+                const auto isDeviceLocal = (memoryProperties.memoryHeaps[heapIndex].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+                const auto fraction = heapBudget.budget > 0 ? static_cast<float>(heapBudget.usage) / static_cast<float>(heapBudget.budget) : 0.0f;
+                const auto heapText = formatLine(
+                    "HEAP {}{} {} / {} MB",
+                    heapIndex,
+                    isDeviceLocal ? " (DEVICE)" : "",
+                    heapBudget.usage / (1024 * 1024),
+                    heapBudget.budget / (1024 * 1024)
+                );
+                const auto barX = margin + PerformanceHud::CHARACTER_ADVANCE * static_cast<float>(heapText.size()) + margin;
+                hud.addBar(barX, y, graphWidth, PerformanceHud::LINE_HEIGHT - 4.0f, fraction, fraction > MEMORY_BUDGET_EVICTION_THRESHOLD ? warningColor : PerformanceHud::packColor(96, 160, 255, 224));
+                addLine(textColor, heapText);
+            }
+
+            const auto queuedAssetCount = m_assetStreamer != nullptr ? m_assetStreamer->getPendingCount() : 0;
+            addLine(textColor, formatLine(
+                "UPLOADS {} QUEUED  {:.2f} MB LEFT THIS FRAME",
+                queuedAssetCount,
+                static_cast<double>(m_uploadScheduler->getRemainingBytes()) / (1024.0 * 1024.0)
+            ));
+
+            const auto [drawCount, triangleCount] = [this, &sceneState]() -> std::tuple<size_t, uint64_t> {
+                if (m_indirectDrawBuffer != nullptr) {
+                    auto triangles = uint64_t { 0 };
+                    for (const auto& drawCommand : sceneState.drawCommands) {
+                        triangles += uint64_t { drawCommand.indexCount / 3 } * drawCommand.instanceCount;
+                    }
+
+                    return { sceneState.drawCommands.size(), triangles };
+                }
+
+                const auto drawsEveryCopy = m_occlusionQueries != nullptr || this->getMaterialCount() > 1;
+                const auto drawCount = drawsEveryCopy ? size_t { m_instanceCount } : size_t { 1 };
+
+                return { drawCount, uint64_t { this->selectMeshLod().indexCount / 3 } * m_instanceCount };
+            }();
+            addLine(textColor, formatLine("DRAWS {}  TRIANGLES {}", drawCount, triangleCount));
+
+            // The commands the last frame recorded, in total and by pass, and by thread once
+            // more than one thread recorded.
+            const auto& commandCounts = m_commandCounts;
+            const auto& totalCounts = commandCounts.total;
+            addLine(textColor, formatLine(
+                "CMD DRAWS {}  DISPATCHES {}  PIPELINES {}  SETS {}",
+                CommandCounters::get(totalCounts, CommandCounter::Draws),
+                CommandCounters::get(totalCounts, CommandCounter::Dispatches),
+                CommandCounters::get(totalCounts, CommandCounter::PipelineBinds),
+                CommandCounters::get(totalCounts, CommandCounter::DescriptorBinds)
+            ));
+            addLine(textColor, formatLine(
+                "CMD BARRIERS {}  SUBMITS {}  UPLOADED {:.2f} MB",
+                CommandCounters::get(totalCounts, CommandCounter::Barriers),
+                CommandCounters::get(totalCounts, CommandCounter::Submits),
+                static_cast<double>(CommandCounters::get(totalCounts, CommandCounter::UploadedBytes)) / (1024.0 * 1024.0)
+            ));
+            const auto addCountsLine = [&addLine, &formatLine, textColor](std::string_view name, const CommandCounts& counts) {
+                if (counts == CommandCounts {}) {
+                    return;
+                }
+
+                addLine(textColor, formatLine(
+                    "  {} D{} X{} P{} S{} B{}",
+                    name,
+                    CommandCounters::get(counts, CommandCounter::Draws),
+                    CommandCounters::get(counts, CommandCounter::Dispatches),
+                    CommandCounters::get(counts, CommandCounter::PipelineBinds),
+                    CommandCounters::get(counts, CommandCounter::DescriptorBinds),
+                    CommandCounters::get(counts, CommandCounter::Barriers)
+                ));
+            };
+            for (uint32_t pass = 0; pass < commandCounts.passCount; pass++) {
+                addCountsLine(CommandCounters::getPassName(pass), commandCounts.passes[pass]);
+            }
+            const auto recordingThreadCount = std::count_if(
+                commandCounts.threads.begin(),
+                commandCounts.threads.begin() + commandCounts.threadCount,
+                [](const CommandCounts& counts) { return counts != CommandCounts {}; }
+            );
+            if (recordingThreadCount > 1) {
+                // The name has a buffer of its own, since the line is formatted into `line`.
+                auto threadName = std::array<char, 16> {};
+                for (uint32_t thread = 0; thread < commandCounts.threadCount; thread++) {
+                    const auto result = fmt::format_to_n(threadName.data(), threadName.size(), "THREAD {}", thread);
+                    addCountsLine(std::string_view { threadName.data(), std::min(result.size, threadName.size()) }, commandCounts.threads[thread]);
+                }
+            }
+
+            hud.endFrame();
+        }
+
+        /// @brief Write the dashboard of the current frame slot: the frame number over the
+        /// graphs of the CPU and GPU frame times, each as wide as the target.
+        ///
+        /// @note Must be called after `updatePerformanceHud`, which adds the frame's times.
+        void updateDashboardHud() {
+            if (m_dashboardHud == nullptr) {
+                return;
+            }
+
+            auto& hud = *m_dashboardHud;
+            const auto size = static_cast<float>(DASHBOARD_TEXTURE_SIZE);
+            const auto margin = 16.0f;
+            const auto graphHeight = 0.5f * (size - 4.0f * margin - PerformanceHud::LINE_HEIGHT);
+            auto line = std::array<char, 64> {};
+            const auto result = fmt::format_to_n(line.data(), line.size(), "FRAME {}", m_submitCount + 1);
+            const auto text = std::string_view { line.data(), std::min(result.size, line.size()) };
+
+            hud.beginFrame(m_currentFrame);
+            hud.addText(margin, margin, text, PerformanceHud::packColor(255, 255, 255, 255));
+            auto y = 2.0f * margin + PerformanceHud::LINE_HEIGHT;
+            hud.addGraph(margin, y, size - 2.0f * margin, graphHeight, PerformanceHudSeries::Cpu, PERFORMANCE_HUD_BUDGET_MILLISECONDS);
+            y += graphHeight + margin;
+            if (m_gpuProfiler) {
+                hud.addGraph(margin, y, size - 2.0f * margin, graphHeight, PerformanceHudSeries::Gpu, PERFORMANCE_HUD_BUDGET_MILLISECONDS);
+            }
+            hud.endFrame();
+        }
+
+        /// @brief The scene the current frame slot would record right now.
+        RecordedScene getRecordedScene() const {
+            return RecordedScene {
+                .swapChainGeneration = m_swapChainGeneration,
+                .pipeline = std::get<0>(this->selectPipeline()),
+                .depthPrepassPipeline = this->getDepthPrepassPipeline(),
+                .occlusionProxyPipeline = this->getOcclusionProxyPipeline(),
+                .isPerformanceHudDrawn = this->isPerformanceHudDrawn(),
+                .meshLodLevel = this->selectMeshLodLevel(),
+                .meshLodFirstIndex = this->getMeshLodFirstIndex(this->selectMeshLodLevel()),
+                .bufferGeneration = m_bufferGeneration,
+                .renderWidth = this->getRenderExtent().width,
+                .renderHeight = this->getRenderExtent().height,
+            };
+        }
+
+        /// @brief The pre-recorded command buffer for the current frame slot and `imageIndex`,
+        /// recorded again first if the scene changed since it was last recorded.
+        ///
+        /// @note A command buffer is only ever submitted from its own frame slot, and the
+        /// slot's previous submit has finished by the time the frame starts, so it can be
+        /// recorded again without waiting. The slot's texture table is updated after it is
+        /// bound, so texture streaming rewriting it does not invalidate the command buffer.
+        VkCommandBuffer getStaticCommandBuffer(uint32_t imageIndex) {
+            auto& staticCommandBuffers = m_staticCommandBuffers[m_currentFrame];
+            if (staticCommandBuffers.size() < m_swapChainImages.size()) {
+                auto commandBuffers = std::vector<VkCommandBuffer> { m_swapChainImages.size() - staticCommandBuffers.size(), VK_NULL_HANDLE };
+                const auto allocInfo = VkCommandBufferAllocateInfo {
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    .commandPool = m_engine->getCommandPool(),
+                    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                    .commandBufferCount = static_cast<uint32_t>(commandBuffers.size()),
+                };
+
+                const auto result = vkAllocateCommandBuffers(m_engine->getLogicalDevice(), &allocInfo, commandBuffers.data());
+                if (result != VK_SUCCESS) {
+                    throw std::runtime_error("failed to allocate command buffers!");
+                }
+
+                for (const auto& commandBuffer : commandBuffers) {
+                    staticCommandBuffers.push_back(StaticCommandBuffer { .commandBuffer = commandBuffer });
+                }
+            }
+
+            auto& staticCommandBuffer = staticCommandBuffers[imageIndex];
+            const auto scene = this->getRecordedScene();
+            if (staticCommandBuffer.scene != scene) {
+                m_dispatch->vkResetCommandBuffer(staticCommandBuffer.commandBuffer, /* VkCommandBufferResetFlagBits */ 0);
+                this->recordCommandBuffer(staticCommandBuffer.commandBuffer, imageIndex);
+                staticCommandBuffer.scene = scene;
+            }
+
+            return staticCommandBuffer.commandBuffer;
+        }
+
+        /// @brief Create the binary semaphores that order each frame's acquire, submit and
+        /// present, and the frame timeline semaphore.
+        ///
+        /// @note Every frame submit signals the next value of the frame timeline, which is the
+        /// submit count. The CPU waits for a frame by waiting for the value it signaled, so
+        /// there are no fences to reset. Acquires and presents only take binary semaphores.
+        void createRenderingSyncObjects() {
+            auto imageAvailableSemaphores = std::vector<VkSemaphore> { m_framesInFlight, VK_NULL_HANDLE };
+            auto renderFinishedSemaphores = std::vector<VkSemaphore> { m_framesInFlight, VK_NULL_HANDLE };
+
+            const auto semaphoreInfo = VkSemaphoreCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            };
+
+            for (size_t i = 0; i < imageAvailableSemaphores.size(); i++) {
+                const auto result = vkCreateSemaphore(m_engine->getLogicalDevice(), &semaphoreInfo, m_engine->getAllocationCallbacks(), &imageAvailableSemaphores[i]);
+                if (result != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create image-available semaphore synchronization object");
+                }
+            }
+
+            for (size_t i = 0; i < renderFinishedSemaphores.size(); i++) {
+                const auto result = vkCreateSemaphore(m_engine->getLogicalDevice(), &semaphoreInfo, m_engine->getAllocationCallbacks(), &renderFinishedSemaphores[i]);
+                if (result != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create render-finished semaphore synchronization object");
+                }
+            }
+
+            auto presentAcquiredSemaphores = std::vector<VkSemaphore> {};
+            if (this->isPresentOwnershipTransferred()) {
+                presentAcquiredSemaphores.resize(m_framesInFlight, VK_NULL_HANDLE);
+                for (auto& semaphore : presentAcquiredSemaphores) {
+                    const auto result = vkCreateSemaphore(m_engine->getLogicalDevice(), &semaphoreInfo, m_engine->getAllocationCallbacks(), &semaphore);
+                    if (result != VK_SUCCESS) {
+                        throw std::runtime_error("failed to create present-acquired semaphore synchronization object");
+                    }
+                }
+            }
+
+            auto viewportImageAvailableSemaphores = std::vector<std::vector<VkSemaphore>> { m_framesInFlight };
+            for (auto& frameSemaphores : viewportImageAvailableSemaphores) {
+                frameSemaphores = std::vector<VkSemaphore> { m_viewportWindowCount, VK_NULL_HANDLE };
+                for (auto& semaphore : frameSemaphores) {
+                    const auto result = vkCreateSemaphore(m_engine->getLogicalDevice(), &semaphoreInfo, m_engine->getAllocationCallbacks(), &semaphore);
+                    if (result != VK_SUCCESS) {
+                        throw std::runtime_error("failed to create viewport image-available semaphore synchronization object");
+                    }
+                }
+            }
+
+            const auto timelineCreateInfo = VkSemaphoreTypeCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+                .initialValue = 0,
             };
-            const auto depthStencil = VkPipelineDepthStencilStateCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
-                .depthTestEnable = VK_TRUE,
-                .depthWriteEnable = VK_TRUE,
-                .depthCompareOp = VK_COMPARE_OP_LESS,
-                .depthBoundsTestEnable = VK_FALSE,
-                .stencilTestEnable = VK_FALSE,
+            const auto timelineSemaphoreInfo = VkSemaphoreCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                .pNext = &timelineCreateInfo,
             };
-            const auto colorBlendAttachment = VkPipelineColorBlendAttachmentState {
-                .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-                .blendEnable = VK_FALSE,
-                .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,  // Optional
-                .dstColorBlendFactor = VK_BLEND_FACTOR_ZERO, // Optional
-                .colorBlendOp = VK_BLEND_OP_ADD,             // Optional
-                .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,  // Optional
-                .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO, // Optional
-                .alphaBlendOp = VK_BLEND_OP_ADD,             // Optional
-                // // Alpha blending:
-                // // finalColor.rgb = newAlpha * newColor + (1 - newAlpha) * oldColor,
-                // // finalColor.a = newAlpha.a,
-                // .blendEnable = VK_TRUE,
-                // .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
-                // .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
-                // .colorBlendOp = VK_BLEND_OP_ADD,
-                // .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
-                // .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
-                // .alphaBlendOp = VK_BLEND_OP_ADD,
+
+            auto frameTimelineSemaphore = VkSemaphore {};
+            const auto result = vkCreateSemaphore(m_engine->getLogicalDevice(), &timelineSemaphoreInfo, m_engine->getAllocationCallbacks(), &frameTimelineSemaphore);
+            if (result != VK_SUCCESS) {
+                throw std::runtime_error("failed to create frame timeline semaphore synchronization object");
+            }
+
+            m_imageAvailableSemaphores = std::move(imageAvailableSemaphores);
+            m_renderFinishedSemaphores = std::move(renderFinishedSemaphores);
+            m_viewportImageAvailableSemaphores = std::move(viewportImageAvailableSemaphores);
+            m_presentAcquiredSemaphores = std::move(presentAcquiredSemaphores);
+            m_frameTimelineSemaphore = frameTimelineSemaphore;
+            m_inFlightSubmitCounts = std::vector<uint64_t>(m_framesInFlight, 0);
+        }
+
+        /// @brief Start the update of the scene of the next frame on the job system.
+        ///
+        /// @note The update writes the scene state the current frame does not read. Besides
+        /// the level of detail and the projection, which are picked here since they depend on
+        /// the swap chain, it only reads what stays the same once the app has started, so it
+        /// runs alongside the rest of the frame. The world transforms of the scene, which it
+        /// sorts and culls the draws by, only change between waiting for the update and
+        /// starting the next one.
+        void beginSceneUpdate() {
+            const auto sceneStateIndex = (m_sceneStateIndex + 1) % static_cast<uint32_t>(m_sceneStates.size());
+            const auto meshLodLevel = this->selectMeshLodLevel();
+            const auto meshLodFirstIndex = this->getMeshLodFirstIndex(meshLodLevel);
+            const auto proj = this->getProjection();
+            const auto sceneFrame = this->getNextSceneFrame();
+            m_pendingSceneUpdate = m_jobSystem->schedule([this, sceneStateIndex, sceneFrame, meshLodLevel, meshLodFirstIndex, proj]() {
+                this->updateScene(m_sceneStates[sceneStateIndex], sceneFrame, meshLodLevel, meshLodFirstIndex, proj);
+            });
+        }
+
+        /// @brief The scene state of the next frame, as a replay recorded it, or with the
+        /// camera where its orbit is at the time of the frame.
+        ///
+        /// @note The camera orbits the mesh, which looks the same as the mesh spinning in
+        /// front of it, so that the model matrix the draws push never changes from frame to
+        /// frame, and pre-recorded command buffers stay valid.
+        SceneRecordingFrame getNextSceneFrame() {
+            const auto frameIndex = m_sceneFrameIndex++;
+            if (m_sceneReplay != nullptr) {
+                // The update of the frame after the last one may start before the run stops.
+                return m_sceneReplay->getFrame(std::min<size_t>(frameIndex, m_sceneReplay->getFrameCount() - 1));
+            }
+
+            const auto time = [this, frameIndex]() -> double {
+                if (m_isDeterministic) {
+                    return static_cast<double>(frameIndex) * DETERMINISTIC_FRAME_SECONDS;
+                } else if (m_pausedSceneTime) {
+                    return *m_pausedSceneTime;
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+                if (!m_sceneStartTime) {
+                    m_sceneStartTime = now;
+                }
+
+                return std::chrono::duration<double> { now - *m_sceneStartTime }.count();
+            }();
+            const auto orbit = glm::rotate(glm::mat4(1.0f), -static_cast<float>(time) * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+            const auto cameraPosition = glm::vec3(orbit * glm::vec4(CAMERA_POSITION, 1.0f));
+
+            return SceneRecordingFrame {
+                .time = time,
+                .cameraPosition = cameraPosition,
+                .view = glm::lookAt(cameraPosition, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
             };
-            const auto colorBlending = VkPipelineColorBlendStateCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-                .logicOpEnable = VK_FALSE,
-                .logicOp = VK_LOGIC_OP_COPY,
-                .attachmentCount = 1,
-                .pAttachments = &colorBlendAttachment,
-                .blendConstants[0] = 0.0f,
-                .blendConstants[1] = 0.0f,
-                .blendConstants[2] = 0.0f,
-                .blendConstants[3] = 0.0f,
+        }
+
+        /// @brief Wait for the update of the scene of the current frame, starting it first
+        /// if the frame before did not, and make its state the one the frame reads.
+        const SceneState& finishSceneUpdate() {
+            if (m_pendingSceneUpdate == nullptr) {
+                this->beginSceneUpdate();
+            }
+
+            {
+                CPU_PROFILE_ZONE("wait for scene update");
+                m_jobSystem->wait(m_pendingSceneUpdate);
+            }
+            m_pendingSceneUpdate = nullptr;
+            m_sceneStateIndex = (m_sceneStateIndex + 1) % static_cast<uint32_t>(m_sceneStates.size());
+
+            // Only the frames that take their scene state are recorded, so a replay draws as
+            // many as the recorded run did.
+            const auto& sceneState = m_sceneStates[m_sceneStateIndex];
+            if (m_sceneRecording != nullptr) {
+                m_sceneRecording->addFrame(SceneRecordingFrame {
+                    .time = sceneState.time,
+                    .cameraPosition = sceneState.cameraPosition,
+                    .view = sceneState.view,
+                });
+            }
+
+            return sceneState;
+        }
+
+        void updateScene(
+            SceneState& sceneState,
+            const SceneRecordingFrame& sceneFrame,
+            size_t meshLodLevel,
+            uint32_t meshLodFirstIndex,
+            const glm::mat4& proj
+        ) const {
+            CPU_PROFILE_ZONE("update scene");
+            sceneState.time = sceneFrame.time;
+            sceneState.cameraPosition = sceneFrame.cameraPosition;
+            sceneState.view = sceneFrame.view;
+
+            sceneState.drawCommands.clear();
+            if (!m_useIndirectDraws) {
+                return;
+            }
+
+            // Without culling on the GPU, only the copies in the frustum are drawn at all.
+            auto& visibleInstances = sceneState.visibleInstances;
+            if (m_instanceBvh) {
+                CPU_PROFILE_ZONE("cull instances");
+                m_instanceBvh->cull(proj * sceneState.view, m_jobSystem.get(), visibleInstances);
+            } else {
+                visibleInstances.resize(m_instanceCount);
+                std::iota(visibleInstances.begin(), visibleInstances.end(), 0);
+            }
+
+            // Every copy draws with the same pipeline, so their materials and then their
+            // depths along the view direction order them. The draws are written in the order
+            // of the queue, and each keeps its copy as its first instance, which is also what
+            // the culler looks its bounding sphere up by, and what picks its material.
+            auto& renderQueue = sceneState.renderQueue;
+            renderQueue.clear();
+            renderQueue.reserve(visibleInstances.size());
+            for (const auto i : visibleInstances) {
+                const auto center = glm::vec3(m_scene.getWorldBoundingSpheres()[i]);
+                const auto viewDepth = SORT_DRAWS ? -(sceneState.view * glm::vec4(center, 1.0f)).z : 0.0f;
+                const auto material = this->getFirstMaterialIndex() + i % this->getMaterialCount();
+                renderQueue.push(RenderQueue::makeSortKey(0, 0, material, viewDepth), i);
+            }
+            renderQueue.sort(m_jobSystem.get());
+
+            // The first index of the level was looked up before the update started, since the
+            // geometry streamer moves it on the main thread.
+            const auto& meshLod = m_mesh->lods()[meshLodLevel];
+            sceneState.drawCommands.reserve(renderQueue.getItems().size());
+            for (const auto& renderItem : renderQueue.getItems()) {
+                sceneState.drawCommands.push_back(VkDrawIndexedIndirectCommand {
+                    .indexCount = meshLod.indexCount,
+                    .instanceCount = 1,
+                    .firstIndex = meshLodFirstIndex,
+                    .vertexOffset = static_cast<int32_t>(m_meshRange.baseVertex),
+                    .firstInstance = renderItem.drawIndex,
+                });
+            }
+        }
+
+        /// @brief The projection of the camera onto the swap chain, with Y flipped for Vulkan.
+        glm::mat4 getProjection() const {
+            const auto aspectRatio = m_swapChainExtent.width / (float) m_swapChainExtent.height;
+            auto proj = [aspectRatio]() -> glm::mat4 {
+                if (REVERSE_Z) {
+                    return reverseInfinitePerspective(CAMERA_FIELD_OF_VIEW, aspectRatio, CAMERA_NEAR_PLANE);
+                } else {
+                    return glm::perspective(CAMERA_FIELD_OF_VIEW, aspectRatio, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
+                }
+            }();
+            proj[1][1] *= -1;
+
+            return proj;
+        }
+
+        void updateUniformBuffer(uint32_t currentImage, const SceneState& sceneState) {
+            CPU_PROFILE_ZONE("update uniform buffer");
+            const auto& cameraPosition = sceneState.cameraPosition;
+            const auto& view = sceneState.view;
+            const auto proj = this->getProjection();
+
+            // The depth pyramid holds the depth of the frame before, so occlusion is tested
+            // with the camera it was rendered with. The first frame has nothing before it,
+            // and its pyramid is empty either way.
+            const auto viewProj = proj * view;
+
+            // The temporal upscaler shifts every frame by a subpixel offset of its own, so
+            // its history sees the scene at more positions than there are rendered pixels.
+            // It reprojects with the camera alone, so the depth pyramid camera and the
+            // reprojection stay unjittered.
+            const auto drawViewProj = [this, &viewProj]() -> glm::mat4 {
+                if (!m_temporalUpscaler) {
+                    return viewProj;
+                }
+
+                m_temporalJitter = TemporalUpscaler::getJitter(m_submitCount, m_dynamicResolution->getScale());
+                m_temporalReprojection = m_depthPyramidViewProj.value_or(viewProj) * glm::inverse(viewProj);
+
+                const auto renderExtent = this->getRenderExtent();
+                const auto jitterOffset = glm::vec3 {
+                    2.0f * m_temporalJitter[0] / static_cast<float>(renderExtent.width),
+                    2.0f * m_temporalJitter[1] / static_cast<float>(renderExtent.height),
+                    0.0f,
+                };
+
+                return glm::translate(glm::mat4(1.0f), jitterOffset) * viewProj;
+            }();
+            // The views of a multiview frame are spaced evenly around the orbit of the camera,
+            // which circles the up axis.
+            const auto viewProjs = [this, &proj, &view, &drawViewProj]() {
+                auto viewProjs = std::array<glm::mat4x4, MAX_VIEW_COUNT> {};
+                viewProjs[0] = drawViewProj;
+                for (uint32_t i = 1; i < m_viewCount; i++) {
+                    const auto angle = glm::radians(360.0f) * static_cast<float>(i) / static_cast<float>(m_viewCount);
+                    viewProjs[i] = proj * view * glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 0.0f, 1.0f));
+                }
+
+                return viewProjs;
+            }();
+            const auto ubo = UniformBufferObject {
+                .viewProj = drawViewProj,
+                .cameraPosition = glm::vec4(cameraPosition, 1.0f),
+                .depthPyramidViewProj = m_depthPyramidViewProj.value_or(viewProj),
+                .lodBias = m_dynamicResolution ? m_dynamicResolution->getLodBias() : 0.0f,
+                .lodFeedbackPhase = static_cast<uint32_t>(m_submitCount % (LOD_FEEDBACK_TILE_SIZE * LOD_FEEDBACK_TILE_SIZE)),
+                .viewProjs = viewProjs,
             };
+            m_depthPyramidViewProj = viewProj;
+
+            // The frame's previous submit has finished, so its region of the ring is free
+            // again. The uniform buffer is always the first slice, so its offset stays the
+            // same from one frame in the slot to the next.
+            m_uniformRing->beginFrame(currentImage);
+            const auto uniformSlice = m_uniformRing->allocate(sizeof(ubo));
+            memcpy(uniformSlice.mappedData, &ubo, sizeof(ubo));
+            m_uniformBufferOffset = uniformSlice.offset;
+
+            // Descriptor buffers have no dynamic uniform buffers, so the frame's set points
+            // at the slice instead, which is safe since the frame's last submit is done.
+            if (m_useDescriptorBuffer) {
+                const auto bufferInfo = VkDescriptorBufferInfo {
+                    .buffer = m_uniformRing->getBuffer(),
+                    .offset = uniformSlice.offset,
+                    .range = sizeof(UniformBufferObject),
+                };
+                m_descriptorBuffer->writeBuffer(m_uniformBufferSets[currentImage], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, bufferInfo);
+            }
+        }
 
-            const auto dynamicStates = std::vector<VkDynamicState> {
-                VK_DYNAMIC_STATE_VIEWPORT,
-                VK_DYNAMIC_STATE_SCISSOR
+        /// @brief Wait for the frame timeline to reach `submitCount`.
+        void waitForSubmit(uint64_t submitCount) {
+            CPU_PROFILE_ZONE("wait for frame");
+            const auto waitInfo = VkSemaphoreWaitInfo {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                .semaphoreCount = 1,
+                .pSemaphores = &m_frameTimelineSemaphore,
+                .pValues = &submitCount,
+            };
+            const auto result = m_dispatch->vkWaitSemaphores(m_engine->getLogicalDevice(), &waitInfo, UINT64_MAX);
+            if (result == VK_ERROR_DEVICE_LOST) {
+                throw DeviceLostError("failed to wait for frame: the device was lost!");
+            } else if (result != VK_SUCCESS) {
+                throw std::runtime_error("failed to wait for frame!");
+            }
+        }
+
+        /// @brief The arena the current frame slot's recording takes its scratch from.
+        FrameArena& getFrameArena() {
+            return *m_frameArenas[m_currentFrame];
+        }
+
+        /// @brief Acquire an image of every viewport window for the current frame slot, and
+        /// recreate the swap chains that went out of date first.
+        ///
+        /// @returns The index of the image of each viewport window, or none for a window that
+        /// is minimized, or whose swap chain went out of date, and skips the frame.
+        std::vector<std::optional<uint32_t>> acquireViewportImages() {
+            CPU_PROFILE_ZONE("acquire viewports");
+            auto imageIndices = std::vector<std::optional<uint32_t>>(m_viewportSwapChains.size(), std::nullopt);
+            for (uint32_t viewport = 0; viewport < m_viewportSwapChains.size(); viewport++) {
+                auto& viewportSwapChain = m_viewportSwapChains[viewport];
+                if (m_engine->hasViewportResized(viewport)) {
+                    m_engine->setViewportResized(viewport, false);
+                    viewportSwapChain.isOutOfDate = true;
+                }
+
+                if (viewportSwapChain.isOutOfDate) {
+                    const auto viewportExtent = m_engine->getViewportExtent(viewport);
+                    if (viewportExtent.width == 0 || viewportExtent.height == 0) {
+                        continue;
+                    }
+
+                    this->createViewportSwapChain(viewport);
+                }
+
+                auto imageIndex = uint32_t { 0 };
+                const auto result = m_dispatch->vkAcquireNextImageKHR(
+                    m_engine->getLogicalDevice(),
+                    viewportSwapChain.swapChain,
+                    UINT64_MAX,
+                    m_viewportImageAvailableSemaphores[m_currentFrame][viewport],
+                    VK_NULL_HANDLE,
+                    &imageIndex
+                );
+                if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+                    viewportSwapChain.isOutOfDate = true;
+                    continue;
+                } else if (result == VK_ERROR_DEVICE_LOST) {
+                    throw DeviceLostError("failed to acquire viewport swap chain image: the device was lost!");
+                } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+                    throw std::runtime_error("failed to acquire viewport swap chain image!");
+                }
+
+                imageIndices[viewport] = imageIndex;
+            }
+
+            return imageIndices;
+        }
+
+        /// @brief Record the release of `images` by the graphics queue family, or their
+        /// acquire by the present queue family, which go in pairs with the same barriers.
+        ///
+        /// @note The images stay presentable, so the barriers only move the ownership, and
+        /// the frame's writes are made available before the images leave its queue. The
+        /// images come back to the graphics queue family without a transfer, since the frame
+        /// that acquires them next discards their contents.
+        void recordPresentOwnershipTransfer(VkCommandBuffer commandBuffer, std::span<const VkImage> images, bool isRelease) {
+            const auto beginInfo = VkCommandBufferBeginInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            };
+            const auto resultBeginCommandBuffer = m_dispatch->vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            if (resultBeginCommandBuffer != VK_SUCCESS) {
+                throw std::runtime_error("failed to begin recording present command buffer!");
+            }
+
+            auto barriers = std::pmr::vector<VkImageMemoryBarrier>(&this->getFrameArena());
+            for (const auto image : images) {
+                barriers.push_back(VkImageMemoryBarrier {
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .srcAccessMask = isRelease ? VkAccessFlags { VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT } : VkAccessFlags { 0 },
+                    .dstAccessMask = 0,
+                    .oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                    .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                    .srcQueueFamilyIndex = m_engine->getGraphicsQueueFamilyIndex(),
+                    .dstQueueFamilyIndex = m_engine->getPresentQueueFamilyIndex(),
+                    .image = image,
+                    .subresourceRange = VkImageSubresourceRange {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = 1,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                    },
+                });
+            }
+            // The present queue family may do no graphics, so its half only names stages
+            // every queue has.
+            const auto srcStageMask = isRelease
+                ? VkPipelineStageFlags { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT }
+                : VkPipelineStageFlags { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT };
+            m_dispatch->vkCmdPipelineBarrier(
+                commandBuffer,
+                srcStageMask,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                static_cast<uint32_t>(barriers.size()),
+                barriers.data()
+            );
+            CommandCounters::add(CommandCounter::Barriers);
+
+            const auto resultEndCommandBuffer = m_dispatch->vkEndCommandBuffer(commandBuffer);
+            if (resultEndCommandBuffer != VK_SUCCESS) {
+                throw std::runtime_error("failed to record present command buffer!");
+            }
+        }
+
+        /// @brief Mark the swap chains of the viewport windows whose presents went out of
+        /// date, or were suboptimal, to be recreated before their next frame.
+        void updateViewportPresentResults(const std::vector<std::optional<uint32_t>>& viewportImageIndices, std::span<const VkResult> presentResults) {
+            auto presentIndex = size_t { 0 };
+            for (uint32_t viewport = 0; viewport < viewportImageIndices.size(); viewport++) {
+                if (!viewportImageIndices[viewport]) {
+                    continue;
+                }
+
+                const auto result = presentResults[presentIndex++];
+                if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+                    m_viewportSwapChains[viewport].isOutOfDate = true;
+                } else if (result == VK_ERROR_DEVICE_LOST) {
+                    throw DeviceLostError("failed to present viewport swap chain image: the device was lost!");
+                } else if (result != VK_SUCCESS) {
+                    throw std::runtime_error("failed to present viewport swap chain image!");
+                }
+            }
+        }
+
+        /// @brief Record the blits of the swap chain image `imageIndex` into the acquired
+        /// images of the viewport windows, each scaled to fit its window, with black bars
+        /// where the aspect ratios differ.
+        ///
+        /// @note The swap chain image is left presentable again, and so are the images of
+        /// the viewport windows.
+        void recordViewportBlits(VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::vector<std::optional<uint32_t>>& viewportImageIndices) {
+            const auto beginInfo = VkCommandBufferBeginInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            };
+            const auto resultBeginCommandBuffer = m_dispatch->vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            if (resultBeginCommandBuffer != VK_SUCCESS) {
+                throw std::runtime_error("failed to begin recording viewport command buffer!");
+            }
+
+            const auto colorSubresourceRange = VkImageSubresourceRange {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            };
+            const auto getImageBarrier = [&colorSubresourceRange](VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask) {
+                return VkImageMemoryBarrier {
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .srcAccessMask = srcAccessMask,
+                    .dstAccessMask = dstAccessMask,
+                    .oldLayout = oldLayout,
+                    .newLayout = newLayout,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .image = image,
+                    .subresourceRange = colorSubresourceRange,
+                };
+            };
+
+            const auto sourceImage = m_swapChainImages[imageIndex];
+            // The images of the viewport windows are overwritten whole, so their previous
+            // layouts are discarded.
+            auto barriers = std::pmr::vector<VkImageMemoryBarrier>({
+                getImageBarrier(
+                    sourceImage,
+                    VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_ACCESS_TRANSFER_READ_BIT
+                ),
+            }, &this->getFrameArena());
+            for (uint32_t viewport = 0; viewport < m_viewportSwapChains.size(); viewport++) {
+                if (viewportImageIndices[viewport]) {
+                    const auto image = m_viewportSwapChains[viewport].images[*viewportImageIndices[viewport]];
+                    barriers.push_back(getImageBarrier(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+                }
+            }
+            m_dispatch->vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                static_cast<uint32_t>(barriers.size()),
+                barriers.data()
+            );
+            CommandCounters::add(CommandCounter::Barriers);
+
+            const auto clearColor = VkClearColorValue { .float32 = { 0.0f, 0.0f, 0.0f, 1.0f } };
+            for (uint32_t viewport = 0; viewport < m_viewportSwapChains.size(); viewport++) {
+                if (viewportImageIndices[viewport]) {
+                    const auto image = m_viewportSwapChains[viewport].images[*viewportImageIndices[viewport]];
+                    m_dispatch->vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &colorSubresourceRange);
+                }
+            }
+
+            const auto clearBarrier = VkMemoryBarrier {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            };
+            m_dispatch->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+            CommandCounters::add(CommandCounter::Barriers);
+
+            const auto colorSubresource = VkImageSubresourceLayers {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            };
+            for (uint32_t viewport = 0; viewport < m_viewportSwapChains.size(); viewport++) {
+                if (!viewportImageIndices[viewport]) {
+                    continue;
+                }
+
+                const auto& viewportSwapChain = m_viewportSwapChains[viewport];
+                const auto scale = std::min(
+                    static_cast<float>(viewportSwapChain.extent.width) / static_cast<float>(m_swapChainExtent.width),
+                    static_cast<float>(viewportSwapChain.extent.height) / static_cast<float>(m_swapChainExtent.height)
+                );
+                const auto width = std::max(static_cast<int32_t>(scale * static_cast<float>(m_swapChainExtent.width)), 1);
+                const auto height = std::max(static_cast<int32_t>(scale * static_cast<float>(m_swapChainExtent.height)), 1);
+                const auto x = (static_cast<int32_t>(viewportSwapChain.extent.width) - width) / 2;
+                const auto y = (static_cast<int32_t>(viewportSwapChain.extent.height) - height) / 2;
+                const auto blit = VkImageBlit {
+                    .srcSubresource = colorSubresource,
+                    .srcOffsets = {
+                        VkOffset3D { 0, 0, 0 },
+                        VkOffset3D { static_cast<int32_t>(m_swapChainExtent.width), static_cast<int32_t>(m_swapChainExtent.height), 1 },
+                    },
+                    .dstSubresource = colorSubresource,
+                    .dstOffsets = {
+                        VkOffset3D { x, y, 0 },
+                        VkOffset3D { x + width, y + height, 1 },
+                    },
+                };
+                m_dispatch->vkCmdBlitImage(
+                    commandBuffer,
+                    sourceImage,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    viewportSwapChain.images[*viewportImageIndices[viewport]],
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    1,
+                    &blit,
+                    VK_FILTER_LINEAR
+                );
+            }
+
+            barriers.clear();
+            barriers.push_back(getImageBarrier(sourceImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, 0));
+            for (uint32_t viewport = 0; viewport < m_viewportSwapChains.size(); viewport++) {
+                if (viewportImageIndices[viewport]) {
+                    const auto image = m_viewportSwapChains[viewport].images[*viewportImageIndices[viewport]];
+                    barriers.push_back(getImageBarrier(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_ACCESS_TRANSFER_WRITE_BIT, 0));
+                }
+            }
+            m_dispatch->vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                static_cast<uint32_t>(barriers.size()),
+                barriers.data()
+            );
+            CommandCounters::add(CommandCounter::Barriers);
+
+            const auto resultEndCommandBuffer = m_dispatch->vkEndCommandBuffer(commandBuffer);
+            if (resultEndCommandBuffer != VK_SUCCESS) {
+                throw std::runtime_error("failed to record viewport command buffer!");
+            }
+        }
+
+        void draw() {
+            this->waitForSubmit(m_inFlightSubmitCounts[m_currentFrame]);
+            // Nothing the slot's last recording allocated is used past its submit. Once the
+            // arena has grown to fit the frame, recording never runs over it again.
+            assert(m_submitCount < FRAME_ARENA_WARMUP_FRAME_COUNT || this->getFrameArena().getOverflowCount() == 0);
+            this->getFrameArena().reset();
+            // The slot's last submit has finished, so its timestamps are read without a stall.
+            auto renderPassMilliseconds = std::optional<double> {};
+            if (m_gpuProfiler) {
+                const auto isResolved = m_gpuProfiler->resolveFrame(m_currentFrame);
+                if (isResolved && m_dynamicResolution) {
+                    this->updateDynamicResolution();
+                }
+                if (isResolved) {
+                    renderPassMilliseconds = m_gpuProfiler->getLatestMilliseconds("render pass");
+                }
+            }
+            // The uploads of the frame are budgeted before streaming records any of them.
+            m_uploadScheduler->beginFrame(renderPassMilliseconds);
+            this->updateGpuTimingsTitle();
+            this->destroyRetiredSwapChains();
+            m_resourceTable->collect();
+            m_engine->getStagingRing().reclaim();
+            // Streaming, defragmentation and texture uploads are held back and go to their
+            // queues together with the frame's own command buffer, in one call per queue.
+            m_engine->getQueueSubmitter().beginBatch();
+            if (!m_isStreamingSuspended) {
+                this->updateAssetStreaming();
+            }
+            this->updateMemoryBudget();
+            this->updateDefragmentation();
+            this->updateTextureSamplers(m_currentFrame);
+            this->updateTextureStreaming(m_currentFrame);
+            if (!m_isStreamingSuspended) {
+                this->updateGeometryStreaming();
+            }
+
+            uint32_t imageIndex;
+            const auto resultAcquireNextImageKHR = [this, &imageIndex]() -> VkResult {
+                CPU_PROFILE_ZONE("acquire");
+                if (m_isHeadless) {
+                    // Every frame slot has an offscreen image of its own.
+                    imageIndex = m_currentFrame;
+                    if (m_frameExporter != nullptr) {
+                        m_frameExporter->waitForRelease(imageIndex);
+                    }
+
+                    return VK_SUCCESS;
+                }
+
+                return m_dispatch->vkAcquireNextImageKHR(
+                    m_engine->getLogicalDevice(), 
+                    m_swapChain, 
+                    UINT64_MAX, 
+                    m_imageAvailableSemaphores[m_currentFrame], 
+                    VK_NULL_HANDLE, 
+                    &imageIndex
+                );
+            }();
+
+            if (resultAcquireNextImageKHR == VK_ERROR_OUT_OF_DATE_KHR) {
+                m_engine->getQueueSubmitter().endBatch();
+                this->recreateSwapChain();
+                return;
+            } else if (resultAcquireNextImageKHR == VK_ERROR_DEVICE_LOST) {
+                throw DeviceLostError("failed to acquire swap chain image: the device was lost!");
+            } else if (resultAcquireNextImageKHR != VK_SUCCESS && resultAcquireNextImageKHR != VK_SUBOPTIMAL_KHR) {
+                throw std::runtime_error("failed to acquire swap chain image!");
+            }
+            // The viewport windows are acquired once the frame is sure to be drawn, since
+            // every image acquired has to be presented.
+            const auto viewportImageIndices = this->acquireViewportImages();
+            // The slot's feedback is cleared only for a frame that is sure to be drawn, and
+            // what it read back steers the streaming of the next frame.
+            if (m_useLodFeedback) {
+                m_lodFeedback->beginFrame(m_currentFrame);
+            }
+            if (m_virtualTexture != nullptr && !m_isStreamingSuspended) {
+                m_virtualTexture->update(m_currentFrame, *m_uploadScheduler);
+            }
+
+            const auto& sceneState = this->finishSceneUpdate();
+            this->updateUniformBuffer(m_currentFrame, sceneState);
+            this->updateIndirectDraws(m_currentFrame, sceneState);
+            this->updateDrawCuller(m_currentFrame);
+            this->updatePerformanceHud(sceneState);
+            this->updateDashboardHud();
+
+            // The pool holds the scene uploads as well, so it is reset even when the frame's
+            // own command buffer is pre-recorded elsewhere.
+            m_dispatch->vkResetCommandPool(m_engine->getLogicalDevice(), m_commandPools[m_currentFrame], /* VkCommandPoolResetFlags */ 0);
+            if (!m_presentCommandPools.empty()) {
+                m_dispatch->vkResetCommandPool(m_engine->getLogicalDevice(), m_presentCommandPools[m_currentFrame], /* VkCommandPoolResetFlags */ 0);
+            }
+            const auto sceneUploadCommandBuffer = this->recordSceneUploads();
+            const auto commandBuffer = [this, imageIndex]() -> VkCommandBuffer {
+                if (STATIC_SCENE) {
+                    return this->getStaticCommandBuffer(imageIndex);
+                } else {
+                    this->recordCommandBuffer(m_commandBuffers[m_currentFrame], imageIndex);
+
+                    return m_commandBuffers[m_currentFrame];
+                }
+            }();
+
+            // The values of binary semaphores are ignored. An offscreen image is neither
+            // acquired nor presented, so a headless submit only signals the timeline, and the
+            // exported timeline when its frames are exported.
+            const auto submitCount = m_submitCount + 1;
+
+            // With a device group the command buffer runs on the devices of its frame. The
+            // semaphores are signaled by the device that rendered the frame, or by the first
+            // device with split frame rendering.
+            const auto commandBufferDeviceMask = this->getFrameDeviceMask(imageIndex);
+            const auto signalDeviceIndex = [this, imageIndex]() -> uint32_t {
+                if (m_engine->getDeviceGroupMode() == DeviceGroupMode::AlternateFrame) {
+                    return imageIndex % m_engine->getDeviceCount();
+                } else {
+                    return 0;
+                }
+            }();
+            auto submission = QueueSubmission {
+                .waits = std::vector<SemaphoreSubmit> {},
+                .commandBuffers = std::vector<VkCommandBuffer> { commandBuffer },
+                .deviceMask = commandBufferDeviceMask,
+                .signals = std::vector<SemaphoreSubmit> {
+                    SemaphoreSubmit { .semaphore = m_frameTimelineSemaphore, .value = submitCount, .deviceIndex = signalDeviceIndex },
+                },
+            };
+            if (!m_isHeadless) {
+                submission.waits.push_back(SemaphoreSubmit {
+                    .semaphore = m_imageAvailableSemaphores[m_currentFrame],
+                    .stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                });
+            }
+            if (m_dashboardTexture != nullptr) {
+                if (const auto dashboardWait = m_dashboardTexture->getReadyWait()) {
+                    submission.waits.push_back(*dashboardWait);
+                }
+            }
+            // The blits into the viewport windows go in the frame's own submission, so the
+            // frame timeline covers them, and one semaphore lets every window present.
+            if (std::ranges::any_of(viewportImageIndices, [](const auto& viewportImageIndex) { return viewportImageIndex.has_value(); })) {
+                this->recordViewportBlits(m_viewportCommandBuffers[m_currentFrame], imageIndex, viewportImageIndices);
+                submission.commandBuffers.push_back(m_viewportCommandBuffers[m_currentFrame]);
+                for (uint32_t viewport = 0; viewport < viewportImageIndices.size(); viewport++) {
+                    if (viewportImageIndices[viewport]) {
+                        submission.waits.push_back(SemaphoreSubmit {
+                            .semaphore = m_viewportImageAvailableSemaphores[m_currentFrame][viewport],
+                            .stageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                        });
+                    }
+                }
+            }
+            if (m_frameExporter != nullptr) {
+                submission.signals.push_back(SemaphoreSubmit {
+                    .semaphore = m_frameExporter->getTimelineSemaphore(),
+                    .value = submitCount,
+                    .deviceIndex = signalDeviceIndex,
+                });
+            } else if (!m_isHeadless) {
+                submission.signals.push_back(SemaphoreSubmit {
+                    .semaphore = m_renderFinishedSemaphores[m_currentFrame],
+                    .deviceIndex = signalDeviceIndex,
+                });
+            }
+
+            // The presented images are handed to the present queue family at the end of the
+            // frame, and taken over by a submission of the present queue, which then signals
+            // the frame timeline in place of the frame, since it finishes last.
+            auto presentSubmission = std::optional<QueueSubmission> {};
+            if (this->isPresentOwnershipTransferred()) {
+                auto presentedImages = std::pmr::vector<VkImage>({ m_swapChainImages[imageIndex] }, &this->getFrameArena());
+                for (uint32_t viewport = 0; viewport < viewportImageIndices.size(); viewport++) {
+                    if (viewportImageIndices[viewport]) {
+                        presentedImages.push_back(m_viewportSwapChains[viewport].images[*viewportImageIndices[viewport]]);
+                    }
+                }
+                this->recordPresentOwnershipTransfer(m_presentReleaseCommandBuffers[m_currentFrame], presentedImages, true);
+                this->recordPresentOwnershipTransfer(m_presentAcquireCommandBuffers[m_currentFrame], presentedImages, false);
+                submission.commandBuffers.push_back(m_presentReleaseCommandBuffers[m_currentFrame]);
+
+                const auto frameTimelineSignal = submission.signals.front();
+                submission.signals.erase(submission.signals.begin());
+                presentSubmission = QueueSubmission {
+                    .waits = std::vector<SemaphoreSubmit> {
+                        SemaphoreSubmit { .semaphore = m_renderFinishedSemaphores[m_currentFrame] },
+                    },
+                    .commandBuffers = std::vector<VkCommandBuffer> { m_presentAcquireCommandBuffers[m_currentFrame] },
+                    .deviceMask = 0,
+                    .signals = std::vector<SemaphoreSubmit> {
+                        frameTimelineSignal,
+                        SemaphoreSubmit { .semaphore = m_presentAcquiredSemaphores[m_currentFrame] },
+                    },
+                };
+            }
+
+            {
+                CPU_PROFILE_ZONE("submit");
+                auto& queueSubmitter = m_engine->getQueueSubmitter();
+                // The uploads go on every device of a group, ahead of the frame on the same
+                // queue, and in the same call to the queue.
+                if (sceneUploadCommandBuffer != VK_NULL_HANDLE) {
+                    queueSubmitter.submit(m_engine->getGraphicsQueue(), QueueSubmission {
+                        .waits = std::vector<SemaphoreSubmit> {},
+                        .commandBuffers = std::vector<VkCommandBuffer> { sceneUploadCommandBuffer },
+                        .deviceMask = 0,
+                        .signals = std::vector<SemaphoreSubmit> {},
+                    });
+                }
+                queueSubmitter.submit(m_engine->getGraphicsQueue(), std::move(submission));
+                if (presentSubmission) {
+                    queueSubmitter.submit(m_engine->getPresentQueue(), std::move(*presentSubmission));
+                }
+                // The mip chain of the dashboard the frame drew is generated once the frame
+                // is done, for the next frame to sample.
+                if (m_dashboardTexture != nullptr) {
+                    m_dashboardTexture->submitMipmaps(m_frameTimelineSemaphore, submitCount);
+                }
+                queueSubmitter.endBatch();
+            }
+            m_submitCount = submitCount;
+            m_inFlightSubmitCounts[m_currentFrame] = submitCount;
+            m_frameLatencyTracker.recordSubmit(std::chrono::steady_clock::now());
+            if (m_gpuProfiler) {
+                m_gpuProfiler->submitFrame(m_currentFrame);
+            }
+
+            // The next frame's scene updates while this one presents and the next one
+            // waits for its slot.
+            this->beginSceneUpdate();
+
+            m_lastImageIndex = imageIndex;
+            if (m_isHeadless) {
+                if (m_frameCapture != nullptr && m_submitCount % m_captureInterval == 0) {
+                    this->captureFrame(imageIndex);
+                }
+                if (m_frameExporter != nullptr) {
+                    m_frameExporter->publish(imageIndex, m_submitCount);
+                }
+
+                m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+                return;
+            }
+
+            // Tag the present so that the low latency mode can wait for it to be displayed.
+            // Only the main window is waited for, so the viewport windows go untagged.
+            m_presentId++;
+            auto swapChains = std::pmr::vector<VkSwapchainKHR>({ m_swapChain }, &this->getFrameArena());
+            auto imageIndices = std::pmr::vector<uint32_t>({ imageIndex }, &this->getFrameArena());
+            auto presentIds = std::pmr::vector<uint64_t>({ m_presentId }, &this->getFrameArena());
+            for (uint32_t viewport = 0; viewport < viewportImageIndices.size(); viewport++) {
+                if (viewportImageIndices[viewport]) {
+                    swapChains.push_back(m_viewportSwapChains[viewport].swapChain);
+                    imageIndices.push_back(*viewportImageIndices[viewport]);
+                    presentIds.push_back(0);
+                }
+            }
+            auto presentResults = std::pmr::vector<VkResult>(swapChains.size(), VK_SUCCESS, &this->getFrameArena());
+
+            const auto presentIdInfo = VkPresentIdKHR {
+                .sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+                .pNext = nullptr,
+                .swapchainCount = static_cast<uint32_t>(presentIds.size()),
+                .pPresentIds = presentIds.data(),
             };
-            const auto dynamicState = VkPipelineDynamicStateCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-                .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
-                .pDynamicStates = dynamicStates.data(),
+            // Every window presents in one call, so they all show the frame at once.
+            const auto presentInfo = VkPresentInfoKHR {
+                .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+                .pNext = m_engine->supportsPresentWait() ? &presentIdInfo : nullptr,
+                .waitSemaphoreCount = 1,
+                .pWaitSemaphores = m_presentAcquiredSemaphores.empty()
+                    ? &m_renderFinishedSemaphores[m_currentFrame]
+                    : &m_presentAcquiredSemaphores[m_currentFrame],
+                .swapchainCount = static_cast<uint32_t>(swapChains.size()),
+                .pSwapchains = swapChains.data(),
+                .pImageIndices = imageIndices.data(),
+                .pResults = presentResults.data(),
             };
 
-            const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-                .setLayoutCount = 1,
-                .pSetLayouts = &m_descriptorSetLayout,
-                .pushConstantRangeCount = 0,    // Optional
-                .pPushConstantRanges = nullptr, // Optional
-            };
+            const auto resultQueuePresentKHR = [this, &presentInfo]() -> VkResult {
+                CPU_PROFILE_ZONE("present");
 
-            auto pipelineLayout = VkPipelineLayout {};
-            const auto resultCreatePipelineLayout = vkCreatePipelineLayout(m_engine->getLogicalDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
-            if (resultCreatePipelineLayout != VK_SUCCESS) {
-                throw std::runtime_error("failed to create pipeline layout!");
+                return m_dispatch->vkQueuePresentKHR(m_engine->getPresentQueue(), &presentInfo);
+            }();
+            m_lastPresentFrame = m_currentFrame;
+            m_pendingPresentId = m_presentId;
+            m_pendingPresentTime = std::chrono::steady_clock::now();
+            m_frameLatencyTracker.recordPresent(
+                m_engine->supportsPresentWait() ? std::optional<uint64_t> { m_presentId } : std::nullopt,
+                m_pendingPresentTime
+            );
+            this->updateViewportPresentResults(viewportImageIndices, std::span { presentResults }.subspan(1));
+            // The call returns the worst result of any window, so the main window goes by its
+            // own, unless the call failed as a whole.
+            const auto isPresented = resultQueuePresentKHR == VK_SUCCESS
+                || resultQueuePresentKHR == VK_SUBOPTIMAL_KHR
+                || resultQueuePresentKHR == VK_ERROR_OUT_OF_DATE_KHR;
+            const auto resultPresent = isPresented ? presentResults[0] : resultQueuePresentKHR;
+            if (resultPresent == VK_ERROR_DEVICE_LOST) {
+                throw DeviceLostError("failed to present swap chain image: the device was lost!");
+            } else if (resultPresent == VK_ERROR_OUT_OF_DATE_KHR || resultPresent == VK_SUBOPTIMAL_KHR || m_engine->hasFramebufferResized()) {
+                m_engine->setFramebufferResized(false);
+                this->recreateSwapChain();
+            } else if (resultPresent != VK_SUCCESS) {
+                throw std::runtime_error("failed to present swap chain image!");
             }
 
-            const auto pipelineInfo = VkGraphicsPipelineCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-                .stageCount = 2,
-                .pStages = shaderStages.data(),
-                .pVertexInputState = &vertexInputInfo,
-                .pInputAssemblyState = &inputAssembly,
-                .pViewportState = &viewportState,
-                .pRasterizationState = &rasterizer,
-                .pMultisampleState = &multisampling,
-                .pDepthStencilState = &depthStencil,
-                .pColorBlendState = &colorBlending,
-                .pDynamicState = &dynamicState,
-                .layout = pipelineLayout,
-                .renderPass = m_renderPass,
-                .subpass = 0,
-                .basePipelineHandle = VK_NULL_HANDLE, // Optional
-                .basePipelineIndex = -1,              // Optional
-            };
+            m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+        }
 
-            auto graphicsPipeline = VkPipeline {};
-            const auto resultCreateGraphicsPipeline = vkCreateGraphicsPipelines(
-                m_engine->getLogicalDevice(), 
-                VK_NULL_HANDLE, 
-                1, 
-                &pipelineInfo, 
-                nullptr, 
-                &graphicsPipeline
-            );
-        
-            if (resultCreateGraphicsPipeline != VK_SUCCESS) {
-                throw std::runtime_error("failed to create graphics pipeline!");
+        /// @brief Destroy the swap chain, the ones of the viewport windows, and every retired
+        /// one.
+        ///
+        /// @note The device has to be idle.
+        void cleanupSwapChain() {
+            this->retireSwapChain();
+            for (auto& retiredSwapChain : m_retiredSwapChains) {
+                this->destroyRetiredSwapChain(retiredSwapChain);
             }
 
-            /*
-            vkDestroyShaderModule(m_engine->getLogicalDevice(), fragmentShaderModule, nullptr);
-            vkDestroyShaderModule(m_engine->getLogicalDevice(), vertexShaderModule, nullptr);
-            */
+            m_retiredSwapChains.clear();
+            m_swapChain = VK_NULL_HANDLE;
 
-            m_pipelineLayout = pipelineLayout;
-            m_graphicsPipeline = graphicsPipeline;
+            for (const auto& retiredViewportSwapChain : m_retiredViewportSwapChains) {
+                vkDestroySwapchainKHR(m_engine->getLogicalDevice(), retiredViewportSwapChain.swapChain, m_engine->getAllocationCallbacks());
+            }
+            m_retiredViewportSwapChains.clear();
+            for (auto& viewportSwapChain : m_viewportSwapChains) {
+                vkDestroySwapchainKHR(m_engine->getLogicalDevice(), viewportSwapChain.swapChain, m_engine->getAllocationCallbacks());
+                viewportSwapChain.swapChain = VK_NULL_HANDLE;
+            }
         }
 
-        void createFramebuffers() {
-            auto swapChainFramebuffers = std::vector<VkFramebuffer> { m_swapChainImageViews.size(), VK_NULL_HANDLE };
-            for (size_t i = 0; i < m_swapChainImageViews.size(); i++) {
-                const auto attachments = std::array<VkImageView, 2> {
-                    m_swapChainImageViews[i],
-                    m_depthImageView,
-                };
+        /// @brief Hand the swap chain and its attachments over to be destroyed once the
+        /// frames submitted so far have finished.
+        ///
+        /// @note `m_swapChain` keeps its handle, so that the next swap chain can be created
+        /// with it as the old swap chain.
+        void retireSwapChain() {
+            const auto isMultisampled = m_msaaSamples != VK_SAMPLE_COUNT_1_BIT;
+            m_retiredSwapChains.push_back(RetiredSwapChain {
+                .swapChain = m_swapChain,
+                .imageViews = std::move(m_swapChainImageViews),
+                .framebuffers = std::move(m_swapChainFramebuffers),
+                .offscreenImages = m_isHeadless && m_frameExporter == nullptr ? m_swapChainImages : std::vector<VkImage> {},
+                .offscreenImageAllocations = std::move(m_offscreenImageAllocations),
+                .colorImage = isMultisampled ? m_colorImage : VK_NULL_HANDLE,
+                .colorImageAllocation = isMultisampled ? m_colorImageAllocation : GpuAllocation {},
+                .colorImageView = isMultisampled ? m_colorImageView : VK_NULL_HANDLE,
+                .depthImage = m_depthImage,
+                .depthImageAllocation = m_depthImageAllocation,
+                .depthImageView = m_depthImageView,
+                .sceneColorImage = m_dynamicResolution ? m_sceneColorImage : VK_NULL_HANDLE,
+                .sceneColorImageAllocation = m_dynamicResolution ? m_sceneColorImageAllocation : GpuAllocation {},
+                .sceneColorImageView = m_dynamicResolution ? m_sceneColorImageView : VK_NULL_HANDLE,
+                .postProcessInputImage = m_postProcessInputImage,
+                .postProcessInputImageAllocation = m_postProcessInputImageAllocation,
+                .postProcessInputImageView = m_postProcessInputImageView,
+                .postProcessDescriptorPool = m_postProcessDescriptorPool,
+                .luminanceReduction = std::move(m_luminanceReduction),
+                .bloomChain = std::move(m_bloomChain),
+                .depthPyramid = std::move(m_depthPyramid),
+                .temporalUpscaler = std::move(m_temporalUpscaler),
+                .shadingRateImage = std::move(m_shadingRateImage),
+                .submitCount = m_submitCount,
+                .frameSlot = m_lastPresentFrame,
+            });
+
+            m_swapChainImageViews.clear();
+            m_swapChainFramebuffers.clear();
+            m_offscreenImageAllocations.clear();
+            m_postProcessInputImage = VK_NULL_HANDLE;
+            m_postProcessInputImageAllocation = GpuAllocation {};
+            m_postProcessInputImageView = VK_NULL_HANDLE;
+            m_postProcessDescriptorPool = VK_NULL_HANDLE;
+            m_postProcessDescriptorSet = VK_NULL_HANDLE;
+        }
 
-                const auto framebufferInfo = VkFramebufferCreateInfo {
-                    .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-                    .renderPass = m_renderPass,
-                    .attachmentCount = static_cast<uint32_t>(attachments.size()),
-                    .pAttachments = attachments.data(),
-                    .width = m_swapChainExtent.width,
-                    .height = m_swapChainExtent.height,
-                    .layers = 1,
-                };
+        /// @brief Destroy the retired swap chains that no frame in flight, and no present, can
+        /// still use.
+        ///
+        /// @note A retired swap chain was last rendered into by the submit it was retired
+        /// after, and the frame timeline counts finished submits. The finished submit says
+        /// nothing about the present that followed it, which waits on the semaphores of its
+        /// frame slot, so the swap chain is kept until the slot has been waited on for a
+        /// later submit, which reuses them.
+        void destroyRetiredSwapChains() {
+            auto finishedSubmitCount = uint64_t { 0 };
+            m_dispatch->vkGetSemaphoreCounterValue(m_engine->getLogicalDevice(), m_frameTimelineSemaphore, &finishedSubmitCount);
+            const auto isSlotWaitedOn = [this, finishedSubmitCount](uint32_t frameSlot, uint64_t submitCount) {
+                const auto slotSubmitCount = m_inFlightSubmitCounts[frameSlot];
+
+                return slotSubmitCount > submitCount && slotSubmitCount <= finishedSubmitCount;
+            };
+            const auto isFinished = [isSlotWaitedOn](const RetiredSwapChain& retiredSwapChain) {
+                return isSlotWaitedOn(retiredSwapChain.frameSlot, retiredSwapChain.submitCount);
+            };
+            for (auto& retiredSwapChain : m_retiredSwapChains) {
+                if (isFinished(retiredSwapChain)) {
+                    this->destroyRetiredSwapChain(retiredSwapChain);
+                }
+            }
 
-                auto swapChainFramebuffer = VkFramebuffer {};
-                const auto result = vkCreateFramebuffer(
-                    m_engine->getLogicalDevice(),
-                    &framebufferInfo,
-                    nullptr,
-                    &swapChainFramebuffer
-                );
+            std::erase_if(m_retiredSwapChains, isFinished);
 
-                if (result != VK_SUCCESS) {
-                    throw std::runtime_error("failed to create framebuffer!");
+            const auto isViewportFinished = [isSlotWaitedOn](const RetiredViewportSwapChain& retiredViewportSwapChain) {
+                return isSlotWaitedOn(retiredViewportSwapChain.frameSlot, retiredViewportSwapChain.submitCount);
+            };
+            for (const auto& retiredViewportSwapChain : m_retiredViewportSwapChains) {
+                if (isViewportFinished(retiredViewportSwapChain)) {
+                    vkDestroySwapchainKHR(m_engine->getLogicalDevice(), retiredViewportSwapChain.swapChain, m_engine->getAllocationCallbacks());
                 }
-
-                swapChainFramebuffers[i] = swapChainFramebuffer;
             }
 
-            m_swapChainFramebuffers = std::move(swapChainFramebuffers);
+            std::erase_if(m_retiredViewportSwapChains, isViewportFinished);
         }
 
-        void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
-            const auto beginInfo = VkCommandBufferBeginInfo {
-                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-                .flags = 0,                  // Optional.
-                .pInheritanceInfo = nullptr, // Optional.
-            };
+        void destroyRetiredSwapChain(RetiredSwapChain& retiredSwapChain) {
+            retiredSwapChain.luminanceReduction.reset();
+            retiredSwapChain.bloomChain.reset();
+            retiredSwapChain.depthPyramid.reset();
+            retiredSwapChain.temporalUpscaler.reset();
+            retiredSwapChain.shadingRateImage.reset();
 
-            const auto resultBeginCommandBuffer = vkBeginCommandBuffer(commandBuffer, &beginInfo);
-            if (resultBeginCommandBuffer != VK_SUCCESS) {
-                throw std::runtime_error("failed to begin recording command buffer!");
+            if (retiredSwapChain.colorImage != VK_NULL_HANDLE) {
+                vkDestroyImageView(m_engine->getLogicalDevice(), retiredSwapChain.colorImageView, m_engine->getAllocationCallbacks());
+                m_engine->destroyImage(retiredSwapChain.colorImage, retiredSwapChain.colorImageAllocation);
             }
 
-            // NOTE: The order of `clearValues` should be identical to the order of the attachments
-            // in the render pass.
-            const auto clearValues = std::array<VkClearValue, 2> {
-                VkClearValue { .color = VkClearColorValue { { 0.0f, 0.0f, 0.0f, 1.0f } } },
-                VkClearValue { .depthStencil = VkClearDepthStencilValue { 1.0f, 0 } },
-            };
+            vkDestroyImageView(m_engine->getLogicalDevice(), retiredSwapChain.depthImageView, m_engine->getAllocationCallbacks());
+            m_engine->destroyImage(retiredSwapChain.depthImage, retiredSwapChain.depthImageAllocation);
 
-            const auto renderPassInfo = VkRenderPassBeginInfo {
-                .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-                .renderPass = m_renderPass,
-                .framebuffer = m_swapChainFramebuffers[imageIndex],
-                .renderArea.offset = VkOffset2D { 0, 0 },
-                .renderArea.extent = m_swapChainExtent,
-                .clearValueCount = static_cast<uint32_t>(clearValues.size()),
-                .pClearValues = clearValues.data(),
-            };
+            if (retiredSwapChain.sceneColorImage != VK_NULL_HANDLE) {
+                vkDestroyImageView(m_engine->getLogicalDevice(), retiredSwapChain.sceneColorImageView, m_engine->getAllocationCallbacks());
+                m_engine->destroyImage(retiredSwapChain.sceneColorImage, retiredSwapChain.sceneColorImageAllocation);
+            }
 
-            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-        
-            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
+            // Destroying the pool frees the set that binds the input image.
+            if (retiredSwapChain.postProcessInputImage != VK_NULL_HANDLE) {
+                vkDestroyDescriptorPool(m_engine->getLogicalDevice(), retiredSwapChain.postProcessDescriptorPool, m_engine->getAllocationCallbacks());
+                vkDestroyImageView(m_engine->getLogicalDevice(), retiredSwapChain.postProcessInputImageView, m_engine->getAllocationCallbacks());
+                m_engine->destroyImage(retiredSwapChain.postProcessInputImage, retiredSwapChain.postProcessInputImageAllocation);
+            }
 
-            const auto viewport = VkViewport {
-                .x = 0.0f,
-                .y = 0.0f,
-                .width = static_cast<float>(m_swapChainExtent.width),
-                .height = static_cast<float>(m_swapChainExtent.height),
-                .minDepth = 0.0f,
-                .maxDepth = 1.0f,
-            };
-            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+            for (size_t i = 0; i < retiredSwapChain.framebuffers.size(); i++) {
+                vkDestroyFramebuffer(m_engine->getLogicalDevice(), retiredSwapChain.framebuffers[i], m_engine->getAllocationCallbacks());
+            }
 
-            const auto scissor = VkRect2D {
-                .offset = VkOffset2D { 0, 0 },
-                .extent = m_swapChainExtent,
-            };
-            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+            for (size_t i = 0; i < retiredSwapChain.imageViews.size(); i++) {
+                vkDestroyImageView(m_engine->getLogicalDevice(), retiredSwapChain.imageViews[i], m_engine->getAllocationCallbacks());
+            }
 
-            const auto vertexBuffers = std::array<VkBuffer, 1> { m_vertexBuffer };
-            const auto offsets = std::array<VkDeviceSize, 1> { 0 };
-            vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers.data(), offsets.data());
+            for (size_t i = 0; i < retiredSwapChain.offscreenImageAllocations.size(); i++) {
+                m_engine->destroyImage(retiredSwapChain.offscreenImages[i], retiredSwapChain.offscreenImageAllocations[i]);
+            }
 
-            vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-            vkCmdBindDescriptorSets(
-                commandBuffer,
-                VK_PIPELINE_BIND_POINT_GRAPHICS,
-                m_pipelineLayout,
-                0,
-                1,
-                &m_descriptorSets[m_currentFrame],
-                0,
-                nullptr
-            );
-        
-            vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(m_mesh.indices().size()), 1, 0, 0, 0);
+            // A headless device has no swap chain functions to call.
+            if (retiredSwapChain.swapChain != VK_NULL_HANDLE) {
+                vkDestroySwapchainKHR(m_engine->getLogicalDevice(), retiredSwapChain.swapChain, m_engine->getAllocationCallbacks());
+            }
+        }
 
-            vkCmdEndRenderPass(commandBuffer);
+        void recreateSwapChain() {
+            // A minimized window has no extent to create a swap chain of, so this sleeps
+            // until it has one again, and wakes up once per event, not per size read.
+            while (m_engine->getFramebufferExtent().width == 0 || m_engine->getFramebufferExtent().height == 0) {
+                m_engine->waitWindowEvents(std::nullopt);
+            }
 
-            const auto resultEndCommandBuffer = vkEndCommandBuffer(commandBuffer);
-            if (resultEndCommandBuffer != VK_SUCCESS) {
-                throw std::runtime_error("failed to record command buffer!");
+            // The old swap chain and its attachments may still be in use by frames in flight,
+            // so they are retired rather than destroyed, and the GPU keeps running.
+            this->retireSwapChain();
+            // Present IDs belong to the swap chain they were presented to.
+            m_pendingPresentId = 0;
+            m_frameLatencyTracker.dropPendingFrames();
+            this->createSwapChain();
+            this->createImageViews();
+            if (m_msaaSamples != VK_SAMPLE_COUNT_1_BIT) {
+                this->createColorResources();
+            }
+            if (m_dynamicResolution) {
+                this->createSceneColorResources();
+            }
+            this->createDepthResources();
+            if (m_usePostProcessSubpass) {
+                this->createPostProcessResources();
+            }
+            if (!m_useDynamicRendering) {
+                this->createFramebuffers();
             }
         }
+};
 
-        void createRenderingSyncObjects() {
-            auto imageAvailableSemaphores = std::vector<VkSemaphore> { MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE };
-            auto renderFinishedSemaphores = std::vector<VkSemaphore> { MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE };
-            auto inFlightFences = std::vector<VkFence> { MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE };
+static uint16_t parsePort(const std::string& text) {
+    const auto port = std::stoul(text);
+    if (port == 0 || port > UINT16_MAX) {
+        throw std::invalid_argument(fmt::format("port out of range: {}", text));
+    }
 
-            const auto semaphoreInfo = VkSemaphoreCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-            };
+    return static_cast<uint16_t>(port);
+}
 
-            const auto fenceInfo = VkFenceCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-                .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+/// @brief Read `--benchmark`, and the `--frames <count>`, `--output <path>`,
+/// `--baseline-dir <directory>` and `--update-baseline` it takes,
+/// `--headless` and the `--frames <count>`, `--readback <path>`, `--capture <directory>`,
+/// `--capture-interval <count>`, `--export-frames`, `--views <count>`, `--device-group
+/// <afr or sfr>` and `--lanes <count>` it takes, `--mip-benchmark` and the `--mip-output <path>` it takes,
+/// `--share-assets <socket path>` or `--import-assets <socket path>`, `--device <name or UUID>`, `--engine-mode <release, debug or gpu-assisted>`,
+/// `--hot-reload`, `--pack-assets <path>`, `--prewarm`, `--calibrate` or `--no-calibration`, `--metrics-prometheus <port>` or
+/// `--metrics-statsd <host:port>`, and `--stress-meshes <count>`, `--stress-overdraw
+/// <count>`, `--stress-textures <count>`, `--stress-texture-size <texels>` and
+/// `--stress-materials <count>`, and `--deterministic`, `--record-scene <path>` and
+/// `--replay-scene <path>`, `--on-demand`, `--depth-prepass`, `--viewports <count>`, and
+/// `--swap-images <driver, double, triple or matched>`, off the command line.
+///
+/// @note The engine mode on the command line overrides the one `VULKAN_ENGINE_MODE` names.
+/// `--prewarm` runs headless, since it never draws a frame. A stress scene without
+/// `--stress-materials` takes a material for every texture, and at least
+/// `STRESS_SCENE_MATERIAL_COUNT`.
+static AppOptions parseAppOptions(int argc, char* argv[]) {
+    auto isBenchmark = false;
+    auto benchmarkOptions = BenchmarkOptions {};
+    auto isMipBenchmark = false;
+    auto isCalibrate = false;
+    auto isCalibrationOff = false;
+    auto mipBenchmarkOutputPath = std::filesystem::path { MIP_BENCHMARK_OUTPUT_FILE };
+    auto isStressScene = false;
+    auto isStressMaterialCountSet = false;
+    auto stressSceneOptions = StressSceneOptions {
+        .meshCount = STRESS_SCENE_MESH_COUNT,
+        .overdraw = STRESS_SCENE_OVERDRAW,
+        .textureCount = STRESS_SCENE_TEXTURE_COUNT,
+        .textureSize = STRESS_SCENE_TEXTURE_SIZE,
+        .materialCount = STRESS_SCENE_MATERIAL_COUNT,
+        .spacing = INSTANCE_SPACING,
+    };
+    auto options = AppOptions {};
+    options.engineMode = Engine::getEngineModeFromEnvironment(DEFAULT_ENGINE_MODE);
+    for (int i = 1; i < argc; i++) {
+        const auto argument = std::string { argv[i] };
+        if (argument == "--benchmark") {
+            isBenchmark = true;
+        } else if (argument == "--frames" && i + 1 < argc) {
+            benchmarkOptions.frameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+            options.headlessFrameCount = benchmarkOptions.frameCount;
+        } else if (argument == "--output" && i + 1 < argc) {
+            benchmarkOptions.outputPath = std::filesystem::path { argv[++i] };
+        } else if (argument == "--baseline-dir" && i + 1 < argc) {
+            benchmarkOptions.baselineDirectory = std::filesystem::path { argv[++i] };
+        } else if (argument == "--update-baseline") {
+            benchmarkOptions.isUpdatingBaseline = true;
+        } else if (argument == "--headless") {
+            options.isHeadless = true;
+        } else if (argument == "--readback" && i + 1 < argc) {
+            options.readbackPath = std::filesystem::path { argv[++i] };
+        } else if (argument == "--capture" && i + 1 < argc) {
+            options.captureDirectory = std::filesystem::path { argv[++i] };
+        } else if (argument == "--capture-interval" && i + 1 < argc) {
+            options.captureInterval = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (argument == "--export-frames") {
+            options.exportFrames = true;
+        } else if (argument == "--views" && i + 1 < argc) {
+            options.viewCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (argument == "--share-assets" && i + 1 < argc) {
+            options.shareAssetsSocketPath = std::string { argv[++i] };
+        } else if (argument == "--import-assets" && i + 1 < argc) {
+            options.importAssetsSocketPath = std::string { argv[++i] };
+        } else if (argument == "--mip-benchmark") {
+            isMipBenchmark = true;
+        } else if (argument == "--mip-output" && i + 1 < argc) {
+            mipBenchmarkOutputPath = std::filesystem::path { argv[++i] };
+        } else if (argument == "--device" && i + 1 < argc) {
+            options.deviceSelection.preferredDevice = std::string { argv[++i] };
+        } else if (argument == "--device-group" && i + 1 < argc) {
+            const auto mode = std::string { argv[++i] };
+            if (mode == "afr") {
+                options.deviceSelection.deviceGroupMode = DeviceGroupMode::AlternateFrame;
+            } else if (mode == "sfr") {
+                options.deviceSelection.deviceGroupMode = DeviceGroupMode::SplitFrame;
+            } else {
+                throw std::invalid_argument(fmt::format("unknown device group mode: {}", mode));
+            }
+        } else if (argument == "--lanes" && i + 1 < argc) {
+            options.laneCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (argument == "--engine-mode" && i + 1 < argc) {
+            options.engineMode = Engine::parseEngineMode(std::string { argv[++i] });
+        } else if (argument == "--hot-reload") {
+            options.hotReloadShaders = true;
+        } else if (argument == "--pack-assets" && i + 1 < argc) {
+            options.packAssetsPath = std::filesystem::path { argv[++i] };
+        } else if (argument == "--prewarm") {
+            options.prewarmPipelines = true;
+            options.isHeadless = true;
+        } else if (argument == "--calibrate") {
+            isCalibrate = true;
+        } else if (argument == "--no-calibration") {
+            isCalibrationOff = true;
+        } else if (argument == "--metrics-prometheus" && i + 1 < argc) {
+            options.metricsEndpoint = MetricsEndpoint {
+                .transport = MetricsTransport::Prometheus,
+                .host = std::string {},
+                .port = parsePort(std::string { argv[++i] }),
             };
-
-            for (size_t i = 0; i < imageAvailableSemaphores.size(); i++) {
-                const auto result = vkCreateSemaphore(m_engine->getLogicalDevice(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]);
-                if (result != VK_SUCCESS) {
-                    throw std::runtime_error("failed to create image-available semaphore synchronization object");
-                }
+        } else if (argument == "--metrics-statsd" && i + 1 < argc) {
+            const auto endpoint = std::string { argv[++i] };
+            const auto separator = endpoint.rfind(':');
+            if (separator == std::string::npos || separator == 0) {
+                throw std::invalid_argument(fmt::format("statsd endpoint is not host:port: {}", endpoint));
             }
 
-            for (size_t i = 0; i < renderFinishedSemaphores.size(); i++) {
-                const auto result = vkCreateSemaphore(m_engine->getLogicalDevice(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]);
-                if (result != VK_SUCCESS) {
-                    throw std::runtime_error("failed to create render-finished semaphore synchronization object");
-                }
+            options.metricsEndpoint = MetricsEndpoint {
+                .transport = MetricsTransport::Statsd,
+                .host = endpoint.substr(0, separator),
+                .port = parsePort(endpoint.substr(separator + 1)),
+            };
+        } else if (argument == "--stress-meshes" && i + 1 < argc) {
+            stressSceneOptions.meshCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+            isStressScene = true;
+        } else if (argument == "--stress-overdraw" && i + 1 < argc) {
+            stressSceneOptions.overdraw = static_cast<uint32_t>(std::stoul(argv[++i]));
+            isStressScene = true;
+        } else if (argument == "--stress-textures" && i + 1 < argc) {
+            stressSceneOptions.textureCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+            isStressScene = true;
+        } else if (argument == "--stress-texture-size" && i + 1 < argc) {
+            stressSceneOptions.textureSize = static_cast<uint32_t>(std::stoul(argv[++i]));
+            isStressScene = true;
+        } else if (argument == "--stress-materials" && i + 1 < argc) {
+            stressSceneOptions.materialCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+            isStressMaterialCountSet = true;
+            isStressScene = true;
+        } else if (argument == "--deterministic") {
+            options.isDeterministic = true;
+        } else if (argument == "--on-demand") {
+            options.isOnDemand = true;
+        } else if (argument == "--depth-prepass") {
+            options.useDepthPrepass = true;
+        } else if (argument == "--viewports" && i + 1 < argc) {
+            options.viewportWindowCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (argument == "--swap-images" && i + 1 < argc) {
+            const auto policy = std::string { argv[++i] };
+            if (policy == "driver") {
+                options.swapChainImageCountPolicy = SwapChainImageCountPolicy::Driver;
+            } else if (policy == "double") {
+                options.swapChainImageCountPolicy = SwapChainImageCountPolicy::Double;
+            } else if (policy == "triple") {
+                options.swapChainImageCountPolicy = SwapChainImageCountPolicy::Triple;
+            } else if (policy == "matched") {
+                options.swapChainImageCountPolicy = SwapChainImageCountPolicy::Matched;
+            } else {
+                throw std::invalid_argument(fmt::format("unknown swap chain image count policy: {}", policy));
             }
+        } else if (argument == "--record-scene" && i + 1 < argc) {
+            options.sceneRecordingPath = std::filesystem::path { argv[++i] };
+        } else if (argument == "--replay-scene" && i + 1 < argc) {
+            options.sceneReplayPath = std::filesystem::path { argv[++i] };
+        } else {
+            throw std::invalid_argument(fmt::format("unknown command line argument: {}", argument));
+        }
+    }
 
-            for (size_t i = 0; i < inFlightFences.size(); i++) {
-                const auto result = vkCreateFence(m_engine->getLogicalDevice(), &fenceInfo, nullptr, &inFlightFences[i]);
-                if (result != VK_SUCCESS) {
-                    throw std::runtime_error("failed to create in-flight fence synchronization object");
-                }
-            }
+    // Swap chain images cannot be copied from, so only offscreen frames are read back.
+    if (options.readbackPath && !options.isHeadless) {
+        throw std::invalid_argument("--readback needs --headless");
+    }
 
-            m_imageAvailableSemaphores = std::move(imageAvailableSemaphores);
-            m_renderFinishedSemaphores = std::move(renderFinishedSemaphores);
-            m_inFlightFences = std::move(inFlightFences);
-        }
+    // Captures copy whole frames, which split frame rendering spreads over devices.
+    if (options.captureDirectory && (!options.isHeadless || options.deviceSelection.deviceGroupMode != DeviceGroupMode::None)) {
+        throw std::invalid_argument("--capture needs --headless, and no --device-group");
+    }
 
-        void updateUniformBuffer(uint32_t currentImage) {
-            static auto startTime = std::chrono::high_resolution_clock::now();
+    // The exported timeline is signaled by one device.
+    if (options.exportFrames && (!options.isHeadless || options.deviceSelection.deviceGroupMode != DeviceGroupMode::None)) {
+        throw std::invalid_argument("--export-frames needs --headless, and no --device-group");
+    }
 
-            auto currentTime = std::chrono::high_resolution_clock::now();
-            float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+    if (options.captureInterval == 0) {
+        throw std::invalid_argument("--capture-interval needs an interval of at least one frame");
+    }
 
-            auto ubo = UniformBufferObject {
-                .model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-                .view = glm::lookAt(
-                    glm::vec3(2.0f, 2.0f, 2.0f),
-                    glm::vec3(0.0f, 0.0f, 0.0f),
-                    glm::vec3(0.0f, 0.0f, 1.0f)
-                ),
-                .proj = glm::perspective(
-                    glm::radians(45.0f),
-                    m_swapChainExtent.width / (float) m_swapChainExtent.height,
-                    0.1f,
-                    10.0f
-                ),
-            };
-            ubo.proj[1][1] *= -1;
+    // The layers of a frame are only ever read back or captured, and the exported frames
+    // and the frames of a device group are single images.
+    const auto isMultiviewRunnable = options.isHeadless
+        && !options.exportFrames
+        && options.deviceSelection.deviceGroupMode == DeviceGroupMode::None;
+    if (options.viewCount > 1 && !isMultiviewRunnable) {
+        throw std::invalid_argument("--views needs --headless, and no --export-frames or --device-group");
+    }
 
-            memcpy(m_uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
-        }
+    if (options.viewCount == 0 || options.viewCount > MAX_VIEW_COUNT) {
+        throw std::invalid_argument(fmt::format("--views needs between one and {} views", MAX_VIEW_COUNT));
+    }
 
-        void draw() {
-            vkWaitForFences(m_engine->getLogicalDevice(), 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+    // Assets are shared by one device with the processes on it, and lanes would all take
+    // the same socket.
+    const auto isSharingAssets = options.shareAssetsSocketPath || options.importAssetsSocketPath;
+    if (options.shareAssetsSocketPath && options.importAssetsSocketPath) {
+        throw std::invalid_argument("--share-assets and --import-assets cannot be combined");
+    }
+    if (isSharingAssets && (options.deviceSelection.deviceGroupMode != DeviceGroupMode::None || options.laneCount > 1)) {
+        throw std::invalid_argument("--share-assets and --import-assets need no --device-group or --lanes");
+    }
 
-            uint32_t imageIndex;
-            const auto resultAcquireNextImageKHR = vkAcquireNextImageKHR(
-                m_engine->getLogicalDevice(), 
-                m_swapChain, 
-                UINT64_MAX, 
-                m_imageAvailableSemaphores[m_currentFrame], 
-                VK_NULL_HANDLE, 
-                &imageIndex
-            );
+    // Device group frames are never presented, and lanes never open windows.
+    if (options.deviceSelection.deviceGroupMode != DeviceGroupMode::None && !options.isHeadless) {
+        throw std::invalid_argument("--device-group needs --headless");
+    }
 
-            if (resultAcquireNextImageKHR == VK_ERROR_OUT_OF_DATE_KHR) {
-                this->recreateSwapChain();
-                return;
-            } else if (resultAcquireNextImageKHR != VK_SUCCESS && resultAcquireNextImageKHR != VK_SUBOPTIMAL_KHR) {
-                throw std::runtime_error("failed to acquire swap chain image!");
-            }
+    if (options.laneCount > 1 && !options.isHeadless) {
+        throw std::invalid_argument("--lanes needs --headless");
+    }
 
-            this->updateUniformBuffer(m_currentFrame);
+    // A headless run stops after a handful of frames, long before anyone edits a shader.
+    if (options.hotReloadShaders && options.isHeadless) {
+        throw std::invalid_argument("--hot-reload needs a window, and no --headless");
+    }
 
-            vkResetFences(m_engine->getLogicalDevice(), 1, &m_inFlightFences[m_currentFrame]);
+    // Each lane takes the next best device, so none of them can be told which.
+    if (options.laneCount == 0 || (options.laneCount > 1 && !options.deviceSelection.preferredDevice.empty())) {
+        throw std::invalid_argument("--lanes needs a lane count of at least one, and no --device");
+    }
 
-            vkResetCommandBuffer(m_commandBuffers[m_currentFrame], /* VkCommandBufferResetFlagBits */ 0);
-            this->recordCommandBuffer(m_commandBuffers[m_currentFrame], imageIndex);
+    // A replay draws the frames of one recording, so there is nothing new to record.
+    if (options.sceneRecordingPath && options.sceneReplayPath) {
+        throw std::invalid_argument("--record-scene and --replay-scene cannot be combined");
+    }
 
-            auto waitSemaphores = std::array<VkSemaphore, 1> { m_imageAvailableSemaphores[m_currentFrame] };
-            auto waitStages = std::array<VkPipelineStageFlags, 1> { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-            auto signalSemaphores = std::array<VkSemaphore, 1> { m_renderFinishedSemaphores[m_currentFrame] };
+    // Frames drawn on demand come whenever something changes, which no run that counts its
+    // frames, or draws the same ones every time, can go by.
+    const auto isOnDemandRunnable = !options.isHeadless
+        && !isBenchmark
+        && !options.isDeterministic
+        && !options.sceneReplayPath;
+    if (options.isOnDemand && !isOnDemandRunnable) {
+        throw std::invalid_argument("--on-demand needs a window, and cannot be combined with --benchmark, --deterministic or --replay-scene");
+    }
 
-            const auto submitInfo = VkSubmitInfo {
-                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                .waitSemaphoreCount = 1,
-                .pWaitSemaphores = waitSemaphores.data(),
-                .pWaitDstStageMask = waitStages.data(),
-                .commandBufferCount = 1,
-                .pCommandBuffers = &m_commandBuffers[m_currentFrame],
-                .signalSemaphoreCount = 1,
-                .pSignalSemaphores = signalSemaphores.data(),
-            };
+    // The calibration measures the device on its own, with the renderer a windowed launch
+    // starts with.
+    if (isCalibrate && isCalibrationOff) {
+        throw std::invalid_argument("--calibrate and --no-calibration cannot be combined");
+    }
+    if (isCalibrate && (isBenchmark || isMipBenchmark || options.prewarmPipelines || options.laneCount > 1)) {
+        throw std::invalid_argument("--calibrate cannot be combined with --benchmark, --mip-benchmark, --prewarm or --lanes");
+    }
+    if (isCalibrate) {
+        options.calibrationMode = CalibrationMode::Calibrate;
+    } else if (isCalibrationOff) {
+        options.calibrationMode = CalibrationMode::Off;
+    }
 
-            const auto resultQueueSubmit = vkQueueSubmit(m_engine->getGraphicsQueue(), 1, &submitInfo, m_inFlightFences[m_currentFrame]);
-            if (resultQueueSubmit != VK_SUCCESS) {
-                throw std::runtime_error("failed to submit draw command buffer!");
-            }
+    if (options.viewportWindowCount > 0 && options.isHeadless) {
+        throw std::invalid_argument("--viewports needs a window, and no --headless");
+    }
 
-            const auto swapChains = std::array<VkSwapchainKHR, 1> { m_swapChain };
+    if (options.viewportWindowCount > MAX_VIEWPORT_WINDOW_COUNT) {
+        throw std::invalid_argument(fmt::format("--viewports needs at most {} windows", MAX_VIEWPORT_WINDOW_COUNT));
+    }
 
-            const auto presentInfo = VkPresentInfoKHR {
-                .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-                .waitSemaphoreCount = 1,
-                .pWaitSemaphores = signalSemaphores.data(),
-                .swapchainCount = 1,
-                .pSwapchains = swapChains.data(),
-                .pImageIndices = &imageIndex,
-            };
+    if (isBenchmark) {
+        options.benchmark = benchmarkOptions;
+    }
 
-            const auto resultQueuePresentKHR = vkQueuePresentKHR(m_engine->getPresentQueue(), &presentInfo);
-            if (resultQueuePresentKHR == VK_ERROR_OUT_OF_DATE_KHR || resultQueuePresentKHR == VK_SUBOPTIMAL_KHR || m_engine->hasFramebufferResized()) {
-                m_engine->setFramebufferResized(false);
-                this->recreateSwapChain();
-            } else if (resultQueuePresentKHR != VK_SUCCESS) {
-                throw std::runtime_error("failed to present swap chain image!");
-            }
+    if (isMipBenchmark) {
+        options.mipBenchmarkOutputPath = mipBenchmarkOutputPath;
+    }
 
-            m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    if (isStressScene) {
+        if (!isStressMaterialCountSet) {
+            stressSceneOptions.materialCount = std::max(stressSceneOptions.materialCount, stressSceneOptions.textureCount);
         }
 
-        void cleanupSwapChain() {
-            vkDestroyImageView(m_engine->getLogicalDevice(), m_depthImageView, nullptr);
-            vkDestroyImage(m_engine->getLogicalDevice(), m_depthImage, nullptr);
-            vkFreeMemory(m_engine->getLogicalDevice(), m_depthImageMemory, nullptr);
+        const auto copyCount = uint64_t { stressSceneOptions.meshCount } * stressSceneOptions.overdraw;
+        if (copyCount == 0 || copyCount > std::numeric_limits<uint32_t>::max()) {
+            throw std::invalid_argument("--stress-meshes and --stress-overdraw need at least one copy, and fewer than 2^32");
+        }
 
-            for (size_t i = 0; i < m_swapChainFramebuffers.size(); i++) {
-                vkDestroyFramebuffer(m_engine->getLogicalDevice(), m_swapChainFramebuffers[i], nullptr);
-            }
+        if (stressSceneOptions.textureCount == 0 || stressSceneOptions.textureSize == 0) {
+            throw std::invalid_argument("--stress-textures and --stress-texture-size need at least one");
+        }
 
-            for (size_t i = 0; i < m_swapChainImageViews.size(); i++) {
-                vkDestroyImageView(m_engine->getLogicalDevice(), m_swapChainImageViews[i], nullptr);
-            }
+        // Every texture is sampled by a material of its own, and every material is an entry
+        // of the texture table after the model's texture.
+        const auto maxMaterialCount = MAX_TEXTURE_TABLE_SIZE - STRESS_MATERIAL_TEXTURE_INDEX;
+        if (stressSceneOptions.materialCount < stressSceneOptions.textureCount || stressSceneOptions.materialCount > maxMaterialCount) {
+            throw std::invalid_argument(fmt::format("--stress-materials needs at least as many materials as textures, and at most {}", maxMaterialCount));
+        }
+
+        options.stressScene = stressSceneOptions;
+    }
+
+    return options;
+}
 
-            vkDestroySwapchainKHR(m_engine->getLogicalDevice(), m_swapChain, nullptr);
+/// @brief Run an app on each of the first `options.laneCount` devices, best scoring first,
+/// each on a thread of its own, and wait for all of them.
+///
+/// @note The lanes share nothing but the process, and write their files under names of
+/// their own.
+static int runLanes(const AppOptions& options) {
+    auto laneErrors = std::vector<std::exception_ptr>(options.laneCount, nullptr);
+    auto lanes = std::vector<std::thread> {};
+    lanes.reserve(options.laneCount);
+    for (uint32_t laneIndex = 0; laneIndex < options.laneCount; laneIndex++) {
+        auto laneOptions = options;
+        laneOptions.laneIndex = laneIndex;
+        laneOptions.deviceSelection.deviceRank = laneIndex;
+        if (laneOptions.readbackPath) {
+            laneOptions.readbackPath = getLanePath(*laneOptions.readbackPath, laneIndex);
+        }
+        if (laneOptions.captureDirectory) {
+            laneOptions.captureDirectory = getLanePath(*laneOptions.captureDirectory, laneIndex);
+        }
+        if (laneOptions.sceneRecordingPath) {
+            laneOptions.sceneRecordingPath = getLanePath(*laneOptions.sceneRecordingPath, laneIndex);
+        }
+        if (laneOptions.benchmark) {
+            laneOptions.benchmark->outputPath = getLanePath(laneOptions.benchmark->outputPath, laneIndex);
+        }
+        if (laneOptions.mipBenchmarkOutputPath) {
+            laneOptions.mipBenchmarkOutputPath = getLanePath(*laneOptions.mipBenchmarkOutputPath, laneIndex);
+        }
+        if (laneOptions.metricsEndpoint && laneOptions.metricsEndpoint->transport == MetricsTransport::Prometheus) {
+            laneOptions.metricsEndpoint->port = static_cast<uint16_t>(laneOptions.metricsEndpoint->port + laneIndex);
         }
 
-        void recreateSwapChain() {
-            int width = 0;
-            int height = 0;
-            glfwGetFramebufferSize(m_engine->getWindow(), &width, &height);
-            while (width == 0 || height == 0) {
-                glfwGetFramebufferSize(m_engine->getWindow(), &width, &height);
-                glfwWaitEvents();
+        lanes.emplace_back([laneOptions, &laneErrors]() {
+            try {
+                auto app = App { laneOptions };
+                app.run();
+            } catch (...) {
+                laneErrors[laneOptions.laneIndex] = std::current_exception();
             }
+        });
+    }
 
-            vkDeviceWaitIdle(m_engine->getLogicalDevice());
+    for (auto& lane : lanes) {
+        lane.join();
+    }
 
-            this->cleanupSwapChain();
-            this->createSwapChain();
-            this->createImageViews();
-            this->createDepthResources();
-            this->createFramebuffers();
+    auto exitCode = EXIT_SUCCESS;
+    for (uint32_t laneIndex = 0; laneIndex < options.laneCount; laneIndex++) {
+        if (!laneErrors[laneIndex]) {
+            continue;
         }
-};
 
-int main() {
-    auto app = App {};
+        try {
+            std::rethrow_exception(laneErrors[laneIndex]);
+        } catch (const std::exception& exception) {
+            fmt::println(std::cerr, "lane {}: {}", laneIndex, exception.what());
+        }
+        exitCode = EXIT_FAILURE;
+    }
+
+    return exitCode;
+}
 
+int main(int argc, char* argv[]) {
+    auto options = AppOptions {};
     try {
-        app.run();
+        options = parseAppOptions(argc, argv);
     } catch (const std::exception& exception) {
         fmt::println(std::cerr, "{}", exception.what());
         return EXIT_FAILURE;
     }
 
+    // The shaders are embedded in the executable, so the model and its texture are the only
+    // loose files.
+    if (options.packAssetsPath) {
+        auto filePaths = std::vector<std::string> { MODEL_PATH, TEXTURE_PATH };
+        const auto compressedTexturePath = std::filesystem::path { TEXTURE_PATH }.replace_extension(".ktx2").string();
+        if (std::filesystem::exists(compressedTexturePath)) {
+            filePaths.push_back(compressedTexturePath);
+        }
+
+        try {
+            AssetArchive::write(*options.packAssetsPath, filePaths);
+        } catch (const std::exception& exception) {
+            fmt::println(std::cerr, "{}", exception.what());
+            return EXIT_FAILURE;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    if (std::filesystem::exists(ASSET_ARCHIVE_PATH)) {
+        try {
+            AssetArchive::mount(ASSET_ARCHIVE_PATH);
+        } catch (const std::exception& exception) {
+            fmt::println(std::cerr, "{}", exception.what());
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (options.laneCount > 1) {
+        return runLanes(options);
+    }
+
+    // The first launch on a device calibrates it, and then starts over once, with the
+    // settings the calibration picked. The first app is gone before the second starts.
+    // A calibration asks for one more launch, and a lost device for a new app on the same
+    // engine.
+    auto engine = std::unique_ptr<Engine> {};
+    auto isRestarted = false;
+    uint32_t recoveryCount = 0;
+    while (true) {
+        {
+            auto app = App { options, std::move(engine) };
+
+            try {
+                app.run();
+            } catch (const DeviceLostError& exception) {
+                if (recoveryCount >= DEVICE_LOST_RECOVERY_LIMIT) {
+                    fmt::println(std::cerr, "{}", exception.what());
+                    return EXIT_FAILURE;
+                }
+
+                fmt::println(std::cerr, "{} Recovering.", exception.what());
+                try {
+                    engine = app.releaseLostEngine();
+                } catch (const std::exception& recoveryException) {
+                    fmt::println(std::cerr, "{}", recoveryException.what());
+                    return EXIT_FAILURE;
+                }
+            } catch (const std::exception& exception) {
+                fmt::println(std::cerr, "{}", exception.what());
+                return EXIT_FAILURE;
+            }
+
+            if (engine == nullptr) {
+                if (isRestarted || !app.isRestartRequested()) {
+                    break;
+                }
+
+                isRestarted = true;
+                continue;
+            }
+        }
+
+        try {
+            engine->recreateGpuDevice();
+        } catch (const std::exception& exception) {
+            fmt::println(std::cerr, "{}", exception.what());
+            return EXIT_FAILURE;
+        }
+        recoveryCount++;
+    }
+
     return EXIT_SUCCESS;
 }
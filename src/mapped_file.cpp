@@ -0,0 +1,187 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+using MappedFile = VulkanEngine::MappedFile;
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& filePath)
+    : m_data { nullptr }
+    , m_size { 0 }
+    , m_fileHandle { INVALID_HANDLE_VALUE }
+    , m_mappingHandle { nullptr }
+{
+    m_fileHandle = CreateFileA(
+        filePath.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr
+    );
+    if (m_fileHandle == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open file!");
+    }
+
+    auto fileSize = LARGE_INTEGER {};
+    if (!GetFileSizeEx(m_fileHandle, &fileSize)) {
+        this->unmap();
+
+        throw std::runtime_error("failed to get file size!");
+    }
+
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    if (m_size == 0) {
+        return;
+    }
+
+    m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mappingHandle == nullptr) {
+        this->unmap();
+
+        throw std::runtime_error("failed to map file!");
+    }
+
+    m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr) {
+        this->unmap();
+
+        throw std::runtime_error("failed to map file!");
+    }
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data { std::exchange(other.m_data, nullptr) }
+    , m_size { std::exchange(other.m_size, 0) }
+    , m_fileHandle { std::exchange(other.m_fileHandle, INVALID_HANDLE_VALUE) }
+    , m_mappingHandle { std::exchange(other.m_mappingHandle, nullptr) }
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    std::swap(m_fileHandle, other.m_fileHandle);
+    std::swap(m_mappingHandle, other.m_mappingHandle);
+
+    return *this;
+}
+
+void MappedFile::unmap() {
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+
+    if (m_mappingHandle != nullptr) {
+        CloseHandle(m_mappingHandle);
+    }
+
+    if (m_fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_fileHandle);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mappingHandle = nullptr;
+    m_fileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filePath)
+    : m_data { nullptr }
+    , m_size { 0 }
+{
+    const auto fileDescriptor = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor < 0) {
+        throw std::runtime_error("failed to open file!");
+    }
+
+    struct stat fileStatus = {};
+    if (fstat(fileDescriptor, &fileStatus) != 0) {
+        close(fileDescriptor);
+
+        throw std::runtime_error("failed to get file size!");
+    }
+
+    m_size = static_cast<size_t>(fileStatus.st_size);
+    if (m_size == 0) {
+        close(fileDescriptor);
+
+        return;
+    }
+
+    // The mapping keeps its own reference to the file, so the descriptor is not needed past here.
+    auto* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (data == MAP_FAILED) {
+        m_size = 0;
+
+        throw std::runtime_error("failed to map file!");
+    }
+
+    // Loaders read the file front to back, so let the kernel read ahead aggressively.
+    madvise(data, m_size, MADV_SEQUENTIAL);
+
+    m_data = static_cast<const uint8_t*>(data);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data { std::exchange(other.m_data, nullptr) }
+    , m_size { std::exchange(other.m_size, 0) }
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+
+    return *this;
+}
+
+void MappedFile::unmap() {
+    if (m_data != nullptr) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    this->unmap();
+}
+
+const uint8_t* MappedFile::getData() const {
+    return m_data;
+}
+
+size_t MappedFile::getSize() const {
+    return m_size;
+}
+
+std::span<const uint8_t> MappedFile::getBytes() const {
+    return std::span<const uint8_t> { m_data, m_size };
+}
+
@@ -0,0 +1,49 @@
+#ifndef _MAPPED_FILE_H
+#define _MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+
+namespace VulkanEngine {
+
+/// @brief A read-only memory mapping of a whole file.
+///
+/// @note Loaders parse straight out of the mapping, so a file is never buffered through
+/// the C runtime on its way in, and its pages come from the OS page cache, which every
+/// process reading the same file shares. The mapping starts on a page boundary, so its
+/// data is suitably aligned for any type. An empty file maps to an empty span.
+class MappedFile final {
+    public:
+        explicit MappedFile() = delete;
+        explicit MappedFile(const std::string& filePath);
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        const uint8_t* getData() const;
+
+        size_t getSize() const;
+
+        std::span<const uint8_t> getBytes() const;
+    private:
+        const uint8_t* m_data;
+        size_t m_size;
+#if defined(_WIN32)
+        void* m_fileHandle;
+        void* m_mappingHandle;
+#endif
+
+        void unmap();
+};
+
+}
+
+#endif // _MAPPED_FILE_H
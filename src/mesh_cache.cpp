@@ -0,0 +1,351 @@
+#include "mesh_cache.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "cache_source_key.h"
+
+
+using CacheSourceKey = VulkanEngine::CacheSourceKey;
+using MappedFile = VulkanEngine::MappedFile;
+using MeshCache = VulkanEngine::MeshCache;
+using MeshCacheEntry = VulkanEngine::MeshCacheEntry;
+using MeshLod = VulkanEngine::MeshLod;
+using MeshletLod = VulkanEngine::MeshletLod;
+using Meshlet = VulkanEngine::Meshlet;
+using MeshletBounds = VulkanEngine::MeshletBounds;
+using MeshCacheData = VulkanEngine::MeshCacheData;
+
+// The cache files are a header and the source path, followed by the vertex data, the index
+// data, the level of detail ranges and the meshlet data, each section starting on a
+// `DATA_ALIGNMENT` boundary. Any change to that layout must bump the version so stale
+// entries miss.
+static constexpr uint32_t CACHE_FILE_MAGIC = 0x4853454d; // "MESH"
+static constexpr uint32_t CACHE_FILE_VERSION = 4;
+
+enum CacheFileSection : uint32_t {
+    VERTEX_SECTION,
+    INDEX_SECTION,
+    LOD_SECTION,
+    MESHLET_SECTION,
+    MESHLET_BOUNDS_SECTION,
+    MESHLET_VERTEX_SECTION,
+    MESHLET_TRIANGLE_SECTION,
+    MESHLET_LOD_SECTION,
+    SECTION_COUNT
+};
+
+struct CacheFileSectionRange final {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct CacheFileHeader final {
+    uint32_t magic;
+    uint32_t version;
+    int64_t sourceModifiedTime;
+    uint64_t sourceContentHash;
+    uint64_t importSettingsHash;
+    uint32_t vertexLayoutVersion;
+    uint32_t vertexStride;
+    uint64_t sourcePathSize;
+    std::array<CacheFileSectionRange, SECTION_COUNT> sections;
+};
+
+static uint64_t alignDataOffset(uint64_t offset) {
+    return (offset + MeshCache::DATA_ALIGNMENT - 1) & ~(MeshCache::DATA_ALIGNMENT - 1);
+}
+
+/// @brief The size of one element of every section, in section order.
+static std::array<uint64_t, SECTION_COUNT> getElementSizes(uint32_t vertexStride) {
+    return std::array<uint64_t, SECTION_COUNT> {
+        vertexStride,
+        sizeof(uint32_t),
+        sizeof(MeshLod),
+        sizeof(Meshlet),
+        sizeof(MeshletBounds),
+        sizeof(uint32_t),
+        sizeof(uint8_t),
+        sizeof(MeshletLod),
+    };
+}
+
+template <typename T>
+static std::span<const uint8_t> getBytes(std::span<const T> elements) {
+    return std::span<const uint8_t> { reinterpret_cast<const uint8_t*>(elements.data()), elements.size_bytes() };
+}
+
+/// @brief The bytes of every section of `data`, in section order.
+static std::array<std::span<const uint8_t>, SECTION_COUNT> getSectionBytes(const MeshCacheData& data) {
+    return std::array<std::span<const uint8_t>, SECTION_COUNT> {
+        data.vertexData,
+        getBytes(data.indices),
+        getBytes(data.lods),
+        getBytes(data.meshlets),
+        getBytes(data.meshletBounds),
+        getBytes(data.meshletVertices),
+        data.meshletTriangles,
+        getBytes(data.meshletLods),
+    };
+}
+
+template <typename T>
+static std::span<const T> getSection(const uint8_t* fileData, const CacheFileSectionRange& section) {
+    return std::span<const T> { reinterpret_cast<const T*>(fileData + section.offset), section.count };
+}
+
+MeshCacheEntry::MeshCacheEntry(MappedFile file, const MeshCacheData& data)
+    : m_file { std::move(file) }
+    , m_data { data }
+{
+}
+
+uint32_t MeshCacheEntry::getVertexStride() const {
+    return m_data.vertexStride;
+}
+
+uint32_t MeshCacheEntry::getVertexCount() const {
+    return static_cast<uint32_t>(m_data.vertexData.size() / m_data.vertexStride);
+}
+
+std::span<const uint8_t> MeshCacheEntry::getVertexData() const {
+    return m_data.vertexData;
+}
+
+std::span<const uint32_t> MeshCacheEntry::getIndices() const {
+    return m_data.indices;
+}
+
+std::span<const MeshLod> MeshCacheEntry::getLods() const {
+    return m_data.lods;
+}
+
+std::span<const Meshlet> MeshCacheEntry::getMeshlets() const {
+    return m_data.meshlets;
+}
+
+std::span<const MeshletBounds> MeshCacheEntry::getMeshletBounds() const {
+    return m_data.meshletBounds;
+}
+
+std::span<const uint32_t> MeshCacheEntry::getMeshletVertices() const {
+    return m_data.meshletVertices;
+}
+
+std::span<const uint8_t> MeshCacheEntry::getMeshletTriangles() const {
+    return m_data.meshletTriangles;
+}
+
+std::span<const MeshletLod> MeshCacheEntry::getMeshletLods() const {
+    return m_data.meshletLods;
+}
+
+MeshCache::MeshCache(const std::filesystem::path& cacheDirectory)
+    : m_cacheDirectory { cacheDirectory }
+{
+}
+
+std::optional<MeshCacheEntry> MeshCache::load(
+    const std::filesystem::path& sourcePath,
+    uint32_t vertexLayoutVersion,
+    uint32_t vertexStride,
+    uint64_t importSettingsHash
+) const {
+    const auto entryPath = this->getEntryPath(sourcePath);
+    auto errorCode = std::error_code {};
+    if (!std::filesystem::exists(entryPath, errorCode)) {
+        return std::nullopt;
+    }
+
+    auto file = std::optional<MappedFile> {};
+    try {
+        file.emplace(entryPath.string());
+    } catch (const std::runtime_error&) {
+        return std::nullopt;
+    }
+
+    const auto* fileData = file->getData();
+    const auto fileSize = file->getSize();
+    auto header = CacheFileHeader {};
+    if (fileSize < sizeof(header)) {
+        return std::nullopt;
+    }
+
+    std::memcpy(&header, fileData, sizeof(header));
+    if (header.magic != CACHE_FILE_MAGIC || header.version != CACHE_FILE_VERSION) {
+        return std::nullopt;
+    }
+
+    if (header.vertexLayoutVersion != vertexLayoutVersion || header.vertexStride != vertexStride || header.importSettingsHash != importSettingsHash) {
+        return std::nullopt;
+    }
+
+    // Bounds are checked piece by piece so that a corrupt size cannot overflow the sums.
+    if (header.sourcePathSize > fileSize - sizeof(header)) {
+        return std::nullopt;
+    }
+
+    const auto elementSizes = getElementSizes(vertexStride);
+    auto sectionEnd = sizeof(header) + header.sourcePathSize;
+    for (uint32_t i = 0; i < SECTION_COUNT; i++) {
+        const auto& section = header.sections[i];
+        const auto isSectionValid = section.offset == alignDataOffset(sectionEnd) &&
+            section.offset <= fileSize &&
+            section.count <= fileSize / elementSizes[i] &&
+            section.count * elementSizes[i] <= fileSize - section.offset;
+        if (!isSectionValid) {
+            return std::nullopt;
+        }
+
+        sectionEnd = section.offset + section.count * elementSizes[i];
+    }
+
+    // Entry names are hashes of the source path, so the full path is stored to rule out
+    // collisions.
+    const auto sourcePathString = sourcePath.generic_string();
+    const auto cachedSourcePath = std::string_view { reinterpret_cast<const char*>(fileData + sizeof(header)), header.sourcePathSize };
+    if (cachedSourcePath != sourcePathString) {
+        return std::nullopt;
+    }
+
+    const auto sourceKey = CacheSourceKey::create(sourcePath);
+    if (!sourceKey.has_value()) {
+        return std::nullopt;
+    }
+
+    if (header.sourceModifiedTime != sourceKey->modifiedTime || header.sourceContentHash != sourceKey->contentHash) {
+        return std::nullopt;
+    }
+
+    // The mapping starts on a page boundary and every section on a `DATA_ALIGNMENT`
+    // boundary, so the sections can be read in place.
+    const auto& sections = header.sections;
+    const auto data = MeshCacheData {
+        .vertexStride = vertexStride,
+        .vertexData = std::span<const uint8_t> { fileData + sections[VERTEX_SECTION].offset, sections[VERTEX_SECTION].count * vertexStride },
+        .indices = getSection<uint32_t>(fileData, sections[INDEX_SECTION]),
+        .lods = getSection<MeshLod>(fileData, sections[LOD_SECTION]),
+        .meshlets = getSection<Meshlet>(fileData, sections[MESHLET_SECTION]),
+        .meshletBounds = getSection<MeshletBounds>(fileData, sections[MESHLET_BOUNDS_SECTION]),
+        .meshletVertices = getSection<uint32_t>(fileData, sections[MESHLET_VERTEX_SECTION]),
+        .meshletTriangles = getSection<uint8_t>(fileData, sections[MESHLET_TRIANGLE_SECTION]),
+        .meshletLods = getSection<MeshletLod>(fileData, sections[MESHLET_LOD_SECTION]),
+    };
+    for (const auto& lod : data.lods) {
+        if (lod.firstIndex > data.indices.size() || lod.indexCount > data.indices.size() - lod.firstIndex) {
+            return std::nullopt;
+        }
+
+        if (lod.vertexCount > sections[VERTEX_SECTION].count) {
+            return std::nullopt;
+        }
+    }
+
+    if (data.meshletBounds.size() != data.meshlets.size()) {
+        return std::nullopt;
+    }
+
+    for (const auto& meshlet : data.meshlets) {
+        const auto triangleSize = uint64_t { meshlet.triangleCount } * 3;
+        const auto isMeshletValid = meshlet.vertexOffset <= data.meshletVertices.size() &&
+            meshlet.vertexCount <= data.meshletVertices.size() - meshlet.vertexOffset &&
+            meshlet.triangleOffset <= data.meshletTriangles.size() &&
+            triangleSize <= data.meshletTriangles.size() - meshlet.triangleOffset;
+        if (!isMeshletValid) {
+            return std::nullopt;
+        }
+    }
+
+    for (const auto& meshletLod : data.meshletLods) {
+        if (meshletLod.firstMeshlet > data.meshlets.size() || meshletLod.meshletCount > data.meshlets.size() - meshletLod.firstMeshlet) {
+            return std::nullopt;
+        }
+    }
+
+    return MeshCacheEntry { std::move(*file), data };
+}
+
+void MeshCache::store(
+    const std::filesystem::path& sourcePath,
+    uint32_t vertexLayoutVersion,
+    uint64_t importSettingsHash,
+    const MeshCacheData& data
+) const {
+    const auto sourceKey = CacheSourceKey::create(sourcePath);
+    if (!sourceKey.has_value()) {
+        throw std::runtime_error("failed to hash mesh cache source!");
+    }
+
+    auto errorCode = std::error_code {};
+    std::filesystem::create_directories(m_cacheDirectory, errorCode);
+    if (errorCode) {
+        throw std::runtime_error("failed to create mesh cache directory!");
+    }
+
+    const auto sourcePathString = sourcePath.generic_string();
+    const auto elementSizes = getElementSizes(data.vertexStride);
+    const auto sectionBytes = getSectionBytes(data);
+    auto header = CacheFileHeader {
+        .magic = CACHE_FILE_MAGIC,
+        .version = CACHE_FILE_VERSION,
+        .sourceModifiedTime = sourceKey->modifiedTime,
+        .sourceContentHash = sourceKey->contentHash,
+        .importSettingsHash = importSettingsHash,
+        .vertexLayoutVersion = vertexLayoutVersion,
+        .vertexStride = data.vertexStride,
+        .sourcePathSize = sourcePathString.size(),
+        .sections = {},
+    };
+    auto sectionEnd = sizeof(header) + sourcePathString.size();
+    for (uint32_t i = 0; i < SECTION_COUNT; i++) {
+        header.sections[i] = CacheFileSectionRange {
+            .offset = alignDataOffset(sectionEnd),
+            .count = sectionBytes[i].size() / elementSizes[i],
+        };
+        sectionEnd = header.sections[i].offset + sectionBytes[i].size();
+    }
+
+    // Write to a temporary file first so a crash mid-write never leaves a truncated entry
+    // behind under the real name.
+    const auto entryPath = this->getEntryPath(sourcePath);
+    auto temporaryPath = entryPath;
+    temporaryPath += ".tmp";
+    {
+        auto file = std::ofstream { temporaryPath, std::ios::binary | std::ios::trunc };
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open mesh cache entry for writing!");
+        }
+
+        const auto padding = std::array<char, DATA_ALIGNMENT> {};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(sourcePathString.data(), static_cast<std::streamsize>(sourcePathString.size()));
+        auto written = sizeof(header) + sourcePathString.size();
+        for (uint32_t i = 0; i < SECTION_COUNT; i++) {
+            const auto& bytes = sectionBytes[i];
+            file.write(padding.data(), static_cast<std::streamsize>(header.sections[i].offset - written));
+            file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            written = header.sections[i].offset + bytes.size();
+        }
+
+        if (!file) {
+            throw std::runtime_error("failed to write mesh cache entry!");
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, entryPath, errorCode);
+    if (errorCode) {
+        std::filesystem::remove(temporaryPath, errorCode);
+
+        throw std::runtime_error("failed to write mesh cache entry!");
+    }
+}
+
+std::filesystem::path MeshCache::getEntryPath(const std::filesystem::path& sourcePath) const {
+    return m_cacheDirectory / CacheSourceKey::createEntryName(sourcePath, ".meshcache");
+}
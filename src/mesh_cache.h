@@ -0,0 +1,125 @@
+#ifndef _MESH_CACHE_H
+#define _MESH_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "mapped_file.h"
+#include "meshlet_builder.h"
+
+
+namespace VulkanEngine {
+
+/// @brief The range of the index data that holds one level of detail of a mesh.
+struct MeshLod final {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    /// @brief The vertices from the start of the vertex data that the level indexes, so
+    /// that a level can be uploaded without the vertices only finer levels use.
+    uint32_t vertexCount = 0;
+};
+
+/// @brief The range of the meshlets that partition one level of detail of a mesh.
+struct MeshletLod final {
+    uint32_t firstMeshlet = 0;
+    uint32_t meshletCount = 0;
+};
+
+/// @brief The data of a mesh as the cache stores it.
+///
+/// @note A mesh without meshlets has empty meshlet spans.
+struct MeshCacheData final {
+    uint32_t vertexStride = 0;
+    std::span<const uint8_t> vertexData;
+    std::span<const uint32_t> indices;
+    std::span<const MeshLod> lods;
+    std::span<const Meshlet> meshlets;
+    std::span<const MeshletBounds> meshletBounds;
+    std::span<const uint32_t> meshletVertices;
+    std::span<const uint8_t> meshletTriangles;
+    std::span<const MeshletLod> meshletLods;
+};
+
+/// @brief A cached mesh, read in place from its memory-mapped cache file.
+///
+/// @note The vertex, index, level of detail and meshlet data point into the mapping, so
+/// they stay valid only as long as the entry does.
+class MeshCacheEntry final {
+    public:
+        explicit MeshCacheEntry() = delete;
+        explicit MeshCacheEntry(MappedFile file, const MeshCacheData& data);
+
+        ~MeshCacheEntry() = default;
+
+        // Moving the mapping keeps its address, so the spans stay valid.
+        MeshCacheEntry(MeshCacheEntry&& other) noexcept = default;
+        MeshCacheEntry& operator=(MeshCacheEntry&& other) noexcept = default;
+
+        uint32_t getVertexStride() const;
+
+        uint32_t getVertexCount() const;
+
+        std::span<const uint8_t> getVertexData() const;
+
+        std::span<const uint32_t> getIndices() const;
+
+        std::span<const MeshLod> getLods() const;
+
+        std::span<const Meshlet> getMeshlets() const;
+
+        std::span<const MeshletBounds> getMeshletBounds() const;
+
+        std::span<const uint32_t> getMeshletVertices() const;
+
+        std::span<const uint8_t> getMeshletTriangles() const;
+
+        std::span<const MeshletLod> getMeshletLods() const;
+    private:
+        MappedFile m_file;
+        MeshCacheData m_data;
+};
+
+/// @brief An on-disk cache of imported meshes in their final vertex and index layout,
+/// with the index ranges of their levels of detail and their meshlets.
+///
+/// @note Entries are keyed the same way as texture cache entries, by the path, the
+/// modification time and a hash of the contents of the source model. A hit skips parsing
+/// the model, deduplicating its vertices and everything done to them after. The vertex
+/// layout is opaque to the cache, so callers pass a layout version that they bump whenever
+/// their vertex type changes, and a hash of the settings they import with, and entries
+/// written with another version, stride or settings miss.
+class MeshCache final {
+    public:
+        /// @brief The alignment of the vertex, index and level of detail data inside an entry.
+        static constexpr uint64_t DATA_ALIGNMENT = 16;
+
+        explicit MeshCache() = delete;
+        explicit MeshCache(const std::filesystem::path& cacheDirectory);
+
+        ~MeshCache() = default;
+
+        std::optional<MeshCacheEntry> load(
+            const std::filesystem::path& sourcePath,
+            uint32_t vertexLayoutVersion,
+            uint32_t vertexStride,
+            uint64_t importSettingsHash
+        ) const;
+
+        void store(
+            const std::filesystem::path& sourcePath,
+            uint32_t vertexLayoutVersion,
+            uint64_t importSettingsHash,
+            const MeshCacheData& data
+        ) const;
+    private:
+        std::filesystem::path m_cacheDirectory;
+
+        std::filesystem::path getEntryPath(const std::filesystem::path& sourcePath) const;
+};
+
+}
+
+#endif // _MESH_CACHE_H
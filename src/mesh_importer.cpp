@@ -0,0 +1,556 @@
+#include "mesh_importer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include <fmt/core.h>
+
+#include "asset_archive.h"
+#include "cache_source_key.h"
+#include "gltf_parser.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+
+
+using Vertex = VulkanEngine::Vertex;
+using Mesh = VulkanEngine::Mesh;
+using MeshLoader = VulkanEngine::MeshLoader;
+using GltfMeshLoader = VulkanEngine::GltfMeshLoader;
+using MeshImportSettings = VulkanEngine::MeshImportSettings;
+using MeshImporter = VulkanEngine::MeshImporter;
+using MeshCache = VulkanEngine::MeshCache;
+using MeshCacheData = VulkanEngine::MeshCacheData;
+using MeshLod = VulkanEngine::MeshLod;
+using MeshletLod = VulkanEngine::MeshletLod;
+using MeshletData = VulkanEngine::MeshletData;
+using MeshletBuilder = VulkanEngine::MeshletBuilder;
+using MeshOptimizer = VulkanEngine::MeshOptimizer;
+using MeshSimplifier = VulkanEngine::MeshSimplifier;
+using ObjParser = VulkanEngine::ObjParser;
+using ObjMesh = VulkanEngine::ObjMesh;
+using ObjIndex = VulkanEngine::ObjIndex;
+using GltfParser = VulkanEngine::GltfParser;
+using GltfPrimitive = VulkanEngine::GltfPrimitive;
+using AssetFile = VulkanEngine::AssetFile;
+using CacheSourceKey = VulkanEngine::CacheSourceKey;
+using TexturePlacement = VulkanEngine::TexturePlacement;
+
+/// @brief Deduplicates vertices with a flat, open-addressing hash table.
+///
+/// @note The table is a single array of slots probed linearly, so a lookup touches one or
+/// two cache lines instead of chasing list nodes, and each vertex costs one probe sequence
+/// whether or not it is new. Every slot keeps the 32-bit hash of its vertex next to its
+/// index, so most mismatches are rejected without loading the vertex. The table is sized
+/// up front, at a load factor of at most 3/4, for the largest possible number of unique
+/// vertices, and never rehashes.
+class VertexDeduplicator final {
+    public:
+        explicit VertexDeduplicator() = delete;
+        explicit VertexDeduplicator(size_t maxVertexCount)
+            : m_slots { std::vector<Slot>(std::bit_ceil(std::max(maxVertexCount + maxVertexCount / 3, size_t { 16 })), Slot {}) }
+            , m_vertices { std::vector<Vertex> {} }
+            , m_maxVertexCount { maxVertexCount }
+        {
+        }
+
+        /// @brief The index of `vertex`, which is appended to the unique vertices if it is new.
+        uint32_t insert(const Vertex& vertex) {
+            const auto hash = VertexDeduplicator::hashVertex(vertex);
+            const auto shortHash = static_cast<uint32_t>(hash >> 32);
+            const auto mask = m_slots.size() - 1;
+            for (auto slotIndex = static_cast<size_t>(hash) & mask; ; slotIndex = (slotIndex + 1) & mask) {
+                auto& slot = m_slots[slotIndex];
+                if (slot.vertexIndex == EMPTY_SLOT) {
+                    if (m_vertices.size() == m_maxVertexCount) {
+                        throw std::logic_error("more unique vertices than the deduplicator was sized for!");
+                    }
+
+                    slot.hash = shortHash;
+                    slot.vertexIndex = static_cast<uint32_t>(m_vertices.size());
+                    m_vertices.push_back(vertex);
+
+                    return slot.vertexIndex;
+                }
+
+                if (slot.hash == shortHash && m_vertices[slot.vertexIndex] == vertex) {
+                    return slot.vertexIndex;
+                }
+            }
+        }
+
+        std::vector<Vertex> takeVertices() {
+            return std::move(m_vertices);
+        }
+    private:
+        static constexpr uint32_t EMPTY_SLOT = std::numeric_limits<uint32_t>::max();
+
+        struct Slot final {
+            uint32_t hash = 0;
+            uint32_t vertexIndex = EMPTY_SLOT;
+        };
+
+        std::vector<Slot> m_slots;
+        std::vector<Vertex> m_vertices;
+        size_t m_maxVertexCount;
+
+        // Multiply to 128 bits and fold the halves together, as wyhash does.
+        static uint64_t mix(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+            const auto product = static_cast<unsigned __int128>(a) * b;
+
+            return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+            const auto aLow = a & 0xffffffff;
+            const auto aHigh = a >> 32;
+            const auto bLow = b & 0xffffffff;
+            const auto bHigh = b >> 32;
+            const auto lowLow = aLow * bLow;
+            const auto lowHigh = aLow * bHigh;
+            const auto highLow = aHigh * bLow;
+            const auto highHigh = aHigh * bHigh;
+            const auto middle = (lowLow >> 32) + (lowHigh & 0xffffffff) + (highLow & 0xffffffff);
+            const auto low = (lowLow & 0xffffffff) | (middle << 32);
+            const auto high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+
+            return low ^ high;
+#endif
+        }
+
+        // Adding zero turns -0.0 into 0.0, so vertices that compare equal also hash equal.
+        static uint64_t packComponents(float first, float second) {
+            const auto firstBits = std::bit_cast<uint32_t>(first + 0.0f);
+            const auto secondBits = std::bit_cast<uint32_t>(second + 0.0f);
+
+            return (static_cast<uint64_t>(firstBits) << 32) | secondBits;
+        }
+
+        // Only the components are hashed. The padding bytes of `Vertex` are never read.
+        static uint64_t hashVertex(const Vertex& vertex) {
+            const auto lane0 = packComponents(vertex.position.x, vertex.position.y);
+            const auto lane1 = packComponents(vertex.position.z, vertex.texCoord.x);
+            const auto lane2 = packComponents(vertex.texCoord.y, 0.0f) | vertex.textureLayer;
+            const auto hash = mix(lane0 ^ 0xa0761d6478bd642f, lane1 ^ 0xe7037ed1a0b428db) ^
+                mix(lane2 ^ 0x8ebc6af09c88c6e3, 0x589965cc75374cc3);
+
+            return mix(hash, 0x1d8e4e27c47d124f ^ sizeof(Vertex));
+        }
+};
+
+static Vertex createObjVertex(const ObjMesh& objMesh, const ObjIndex& index) {
+    const auto position = static_cast<size_t>(index.position);
+    const auto texCoord = static_cast<size_t>(index.texCoord);
+
+    // Faces without texture coordinates sample the corner of the texture.
+    return Vertex {
+        .position = glm::vec3 {
+            objMesh.positions[3 * position + 0],
+            objMesh.positions[3 * position + 1],
+            objMesh.positions[3 * position + 2]
+        },
+        .texCoord = index.texCoord == ObjParser::NO_TEX_COORD ? glm::vec2 { 0.0f } : glm::vec2 {
+            objMesh.texCoords[2 * texCoord + 0],
+            1.0f - objMesh.texCoords[2 * texCoord + 1]
+        },
+    };
+}
+
+/// @brief Convert the accessors of `primitive` into its vertices and its indices, which are
+/// offset by `baseVertex`.
+///
+/// @note glTF texture coordinates start at the top left of the image, as Vulkan's do, so
+/// unlike OBJ ones they are not flipped. Primitives without them sample the corner of the
+/// texture.
+static void convertGltfPrimitive(const GltfPrimitive& primitive, uint32_t baseVertex, Vertex* vertices, uint32_t* indices) {
+    const auto vertexCount = primitive.positions.count;
+    for (size_t i = 0; i < vertexCount; i++) {
+        auto& vertex = vertices[i];
+        primitive.positions.readFloats(i, &vertex.position[0]);
+        vertex.texCoord = glm::vec2 { 0.0f };
+        if (primitive.texCoords.has_value()) {
+            primitive.texCoords->readFloats(i, &vertex.texCoord[0]);
+        }
+    }
+
+    if (!primitive.indices.has_value()) {
+        for (size_t i = 0; i < vertexCount; i++) {
+            indices[i] = baseVertex + static_cast<uint32_t>(i);
+        }
+
+        return;
+    }
+
+    for (size_t i = 0; i < primitive.indices->count; i++) {
+        const auto index = primitive.indices->readIndex(i);
+        if (index >= vertexCount) {
+            throw std::runtime_error("failed to import GLB file: index out of range!");
+        }
+
+        indices[i] = baseVertex + index;
+    }
+}
+
+template <typename T>
+static uint64_t hashValue(const T& value, uint64_t hash) {
+    return CacheSourceKey::hashBytes(reinterpret_cast<const uint8_t*>(&value), sizeof(T), hash);
+}
+
+Mesh MeshLoader::load(const std::string& filePath) const {
+    // The parser reads straight out of the mapping, and splits large files across the job
+    // system.
+    const auto meshFile = AssetFile { filePath };
+    const auto objMesh = ObjParser::parse(meshFile.getBytes(), m_jobSystem);
+    if (m_jobSystem != nullptr && objMesh.shapes.size() > 1) {
+        return this->deduplicateInParallel(objMesh);
+    }
+
+    auto indexCount = size_t { 0 };
+    for (const auto& shape : objMesh.shapes) {
+        indexCount += shape.indices.size();
+    }
+
+    // Every index could name a new vertex, so that bounds the unique vertex count.
+    auto vertexDeduplicator = VertexDeduplicator { indexCount };
+    auto indices = std::vector<uint32_t> {};
+    indices.reserve(indexCount);
+    for (const auto& shape : objMesh.shapes) {
+        for (const auto& index : shape.indices) {
+            indices.push_back(vertexDeduplicator.insert(createObjVertex(objMesh, index)));
+        }
+    }
+
+    return Mesh { vertexDeduplicator.takeVertices(), std::move(indices) };
+}
+
+Mesh MeshLoader::deduplicateInParallel(const ObjMesh& objMesh) const {
+    // Shapes differ a lot in size, so every shape is a job of its own, and the workers that
+    // finish early steal the rest.
+    const auto& shapes = objMesh.shapes;
+    // Deduplicate every shape on its own, with shape-local indices.
+    auto shapeVertices = std::vector<std::vector<Vertex>>(shapes.size());
+    auto shapeIndices = std::vector<std::vector<uint32_t>>(shapes.size());
+    m_jobSystem->parallelFor(shapes.size(), 1, [&objMesh, &shapes, &shapeVertices, &shapeIndices](size_t shape) {
+        const auto& shapeMeshIndices = shapes[shape].indices;
+        auto vertexDeduplicator = VertexDeduplicator { shapeMeshIndices.size() };
+        auto& indices = shapeIndices[shape];
+        indices.reserve(shapeMeshIndices.size());
+        for (const auto& index : shapeMeshIndices) {
+            indices.push_back(vertexDeduplicator.insert(createObjVertex(objMesh, index)));
+        }
+
+        shapeVertices[shape] = vertexDeduplicator.takeVertices();
+    });
+
+    // Merge the shape vertex tables in shape order. That runs on one thread, but it only
+    // touches each shape's unique vertices, not its indices.
+    auto uniqueVertexCount = size_t { 0 };
+    auto indexOffsets = std::vector<size_t>(shapes.size() + 1, 0);
+    for (size_t shape = 0; shape < shapes.size(); shape++) {
+        uniqueVertexCount += shapeVertices[shape].size();
+        indexOffsets[shape + 1] = indexOffsets[shape] + shapeIndices[shape].size();
+    }
+
+    auto vertexDeduplicator = VertexDeduplicator { uniqueVertexCount };
+    auto vertexRemaps = std::vector<std::vector<uint32_t>>(shapes.size());
+    for (size_t shape = 0; shape < shapes.size(); shape++) {
+        auto& vertexRemap = vertexRemaps[shape];
+        vertexRemap.reserve(shapeVertices[shape].size());
+        for (const auto& vertex : shapeVertices[shape]) {
+            vertexRemap.push_back(vertexDeduplicator.insert(vertex));
+        }
+
+        shapeVertices[shape] = std::vector<Vertex> {};
+    }
+
+    // Remap every shape's indices into its own range of the merged index buffer.
+    auto indices = std::vector<uint32_t>(indexOffsets.back());
+    m_jobSystem->parallelFor(shapes.size(), 1, [&indices, &indexOffsets, &shapeIndices, &vertexRemaps](size_t shape) {
+        auto* shapeIndicesBegin = indices.data() + indexOffsets[shape];
+        for (size_t i = 0; i < shapeIndices[shape].size(); i++) {
+            shapeIndicesBegin[i] = vertexRemaps[shape][shapeIndices[shape][i]];
+        }
+    });
+
+    return Mesh { vertexDeduplicator.takeVertices(), std::move(indices) };
+}
+
+Mesh GltfMeshLoader::load(const std::string& filePath) const {
+    const auto meshFile = AssetFile { filePath };
+    const auto primitives = GltfParser::parse(meshFile.getBytes());
+    auto vertexOffsets = std::vector<size_t>(primitives.size() + 1, 0);
+    auto indexOffsets = std::vector<size_t>(primitives.size() + 1, 0);
+    for (size_t i = 0; i < primitives.size(); i++) {
+        const auto& primitive = primitives[i];
+        vertexOffsets[i + 1] = vertexOffsets[i] + primitive.positions.count;
+        indexOffsets[i + 1] = indexOffsets[i] + (primitive.indices.has_value() ? primitive.indices->count : primitive.positions.count);
+    }
+
+    if (vertexOffsets.back() > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("failed to import GLB file: too many vertices!");
+    }
+
+    auto vertices = std::vector<Vertex>(vertexOffsets.back());
+    auto indices = std::vector<uint32_t>(indexOffsets.back());
+    auto convertPrimitiveAt = [&primitives, &vertexOffsets, &indexOffsets, &vertices, &indices](size_t i) {
+        convertGltfPrimitive(
+            primitives[i],
+            static_cast<uint32_t>(vertexOffsets[i]),
+            vertices.data() + vertexOffsets[i],
+            indices.data() + indexOffsets[i]
+        );
+    };
+    if (m_jobSystem != nullptr && primitives.size() > 1) {
+        m_jobSystem->parallelFor(primitives.size(), 1, convertPrimitiveAt);
+    } else {
+        for (size_t i = 0; i < primitives.size(); i++) {
+            convertPrimitiveAt(i);
+        }
+    }
+
+    return Mesh { std::move(vertices), std::move(indices) };
+}
+
+uint64_t MeshImportSettings::getHash() const {
+    auto hash = hashValue(MeshImporter::VERTEX_LAYOUT_VERSION, CacheSourceKey::FNV_OFFSET_BASIS);
+    hash = hashValue(static_cast<uint32_t>(this->optimize ? 1 : 0), hash);
+    hash = hashValue(static_cast<uint32_t>(this->buildMeshlets ? 1 : 0), hash);
+    hash = hashValue(static_cast<uint64_t>(this->lodTriangleRatios.size()), hash);
+    for (const auto& triangleRatio : this->lodTriangleRatios) {
+        hash = hashValue(triangleRatio, hash);
+    }
+
+    // Only what the remap writes into the vertices tells placements apart. The page the
+    // texture landed on does not.
+    hash = hashValue(static_cast<uint32_t>(this->texturePlacement.has_value() ? 1 : 0), hash);
+    if (this->texturePlacement.has_value()) {
+        hash = hashValue(this->texturePlacement->layer, hash);
+        hash = hashValue(this->texturePlacement->uvScale.x, hash);
+        hash = hashValue(this->texturePlacement->uvScale.y, hash);
+        hash = hashValue(this->texturePlacement->uvOffset.x, hash);
+        hash = hashValue(this->texturePlacement->uvOffset.y, hash);
+    }
+
+    return hash;
+}
+
+Mesh MeshImporter::import(const std::string& filePath, const MeshImportSettings& settings, JobSystem* jobSystem) {
+    auto mesh = [jobSystem, &filePath]() -> Mesh {
+        if (std::filesystem::path { filePath }.extension() == ".glb") {
+            return GltfMeshLoader { jobSystem }.load(filePath);
+        }
+
+        return MeshLoader { jobSystem }.load(filePath);
+    }();
+    if (mesh.vertices().empty()) {
+        return mesh;
+    }
+
+    if (settings.texturePlacement.has_value()) {
+        mesh = MeshImporter::remapTexCoords(mesh, *settings.texturePlacement);
+    }
+
+    if (settings.optimize) {
+        mesh = MeshImporter::optimize(mesh);
+    }
+
+    if (!settings.lodTriangleRatios.empty()) {
+        mesh = MeshImporter::generateLods(mesh, settings.lodTriangleRatios);
+    }
+
+    if (settings.buildMeshlets) {
+        mesh = MeshImporter::buildMeshlets(mesh);
+    }
+
+    return mesh;
+}
+
+Mesh MeshImporter::remapTexCoords(const Mesh& mesh, const TexturePlacement& placement) {
+    auto vertices = mesh.vertices();
+    for (auto& vertex : vertices) {
+        vertex.texCoord = placement.remap(vertex.texCoord);
+        vertex.textureLayer = placement.layer;
+    }
+
+    auto indices = mesh.indices();
+    auto lods = mesh.lods();
+    auto meshletData = mesh.meshlets();
+    auto meshletLods = mesh.meshletLods();
+
+    return Mesh { std::move(vertices), std::move(indices), std::move(lods), std::move(meshletData), std::move(meshletLods) };
+}
+
+Mesh MeshImporter::optimize(const Mesh& mesh) {
+    const auto vertexCount = static_cast<uint32_t>(mesh.vertices().size());
+    auto indices = mesh.indices();
+    const auto acmrBefore = MeshOptimizer::computeAcmr(indices, vertexCount);
+
+    const auto clusters = MeshOptimizer::optimizeVertexCache(indices, vertexCount);
+    MeshOptimizer::optimizeOverdraw(
+        indices,
+        clusters,
+        &mesh.vertices()[0].position.x,
+        vertexCount,
+        sizeof(Vertex)
+    );
+    const auto remap = MeshOptimizer::optimizeVertexFetch(indices, vertexCount);
+
+    auto vertices = std::vector<Vertex> {};
+    vertices.resize(vertexCount - static_cast<uint32_t>(std::count(remap.begin(), remap.end(), MeshOptimizer::UNUSED_VERTEX)));
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        if (remap[i] != MeshOptimizer::UNUSED_VERTEX) {
+            vertices[remap[i]] = mesh.vertices()[i];
+        }
+    }
+
+    const auto acmrAfter = MeshOptimizer::computeAcmr(indices, static_cast<uint32_t>(vertices.size()));
+    fmt::println("Mesh ACMR: {:.3f} before optimization, {:.3f} after", acmrBefore, acmrAfter);
+
+    return Mesh { std::move(vertices), std::move(indices) };
+}
+
+Mesh MeshImporter::generateLods(const Mesh& mesh, std::span<const float> triangleRatios) {
+    const auto vertexCount = static_cast<uint32_t>(mesh.vertices().size());
+    auto indices = mesh.indices();
+    auto lods = std::vector<MeshLod> { MeshLod { .firstIndex = 0, .indexCount = static_cast<uint32_t>(indices.size()) } };
+    for (const auto& triangleRatio : triangleRatios) {
+        const auto targetIndexCount = static_cast<size_t>(static_cast<float>(mesh.indices().size() / 3) * triangleRatio) * 3;
+        auto lodIndices = MeshSimplifier::simplify(
+            mesh.indices(),
+            &mesh.vertices()[0].position.x,
+            vertexCount,
+            sizeof(Vertex),
+            targetIndexCount
+        );
+        if (lodIndices.empty() || lodIndices.size() >= lods.back().indexCount * 9 / 10) {
+            break;
+        }
+
+        MeshOptimizer::optimizeVertexCache(lodIndices, vertexCount);
+        lods.push_back(MeshLod {
+            .firstIndex = static_cast<uint32_t>(indices.size()),
+            .indexCount = static_cast<uint32_t>(lodIndices.size()),
+        });
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+    }
+
+    for (size_t i = 0; i < lods.size(); i++) {
+        fmt::println("Mesh LOD {}: {} triangles", i, lods[i].indexCount / 3);
+    }
+
+    // Number the vertices in the order the levels first use them, coarsest level first, so
+    // that every level indexes a prefix of the vertices.
+    auto remap = std::vector<uint32_t>(vertexCount, MeshOptimizer::UNUSED_VERTEX);
+    auto nextVertex = uint32_t { 0 };
+    for (auto lod = lods.rbegin(); lod != lods.rend(); lod++) {
+        for (uint32_t i = lod->firstIndex; i < lod->firstIndex + lod->indexCount; i++) {
+            if (remap[indices[i]] == MeshOptimizer::UNUSED_VERTEX) {
+                remap[indices[i]] = nextVertex++;
+            }
+        }
+
+        lod->vertexCount = nextVertex;
+    }
+
+    // Vertices that no level indexes keep their order behind the others.
+    for (auto& vertex : remap) {
+        if (vertex == MeshOptimizer::UNUSED_VERTEX) {
+            vertex = nextVertex++;
+        }
+    }
+
+    auto vertices = std::vector<Vertex>(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        vertices[remap[i]] = mesh.vertices()[i];
+    }
+    for (auto& index : indices) {
+        index = remap[index];
+    }
+
+    return Mesh { std::move(vertices), std::move(indices), std::move(lods) };
+}
+
+Mesh MeshImporter::buildMeshlets(const Mesh& mesh) {
+    const auto vertexCount = static_cast<uint32_t>(mesh.vertices().size());
+    auto meshletData = MeshletData {};
+    auto meshletLods = std::vector<MeshletLod> {};
+    for (const auto& lod : mesh.lods()) {
+        const auto lodIndices = std::span<const uint32_t> { mesh.indices() }.subspan(lod.firstIndex, lod.indexCount);
+        auto lodMeshletData = MeshletBuilder::build(lodIndices, &mesh.vertices()[0].position.x, vertexCount, sizeof(Vertex));
+
+        const auto vertexOffset = static_cast<uint32_t>(meshletData.vertices.size());
+        const auto triangleOffset = static_cast<uint32_t>(meshletData.triangles.size());
+        for (auto& meshlet : lodMeshletData.meshlets) {
+            meshlet.vertexOffset += vertexOffset;
+            meshlet.triangleOffset += triangleOffset;
+        }
+
+        meshletLods.push_back(MeshletLod {
+            .firstMeshlet = static_cast<uint32_t>(meshletData.meshlets.size()),
+            .meshletCount = static_cast<uint32_t>(lodMeshletData.meshlets.size()),
+        });
+        meshletData.meshlets.insert(meshletData.meshlets.end(), lodMeshletData.meshlets.begin(), lodMeshletData.meshlets.end());
+        meshletData.bounds.insert(meshletData.bounds.end(), lodMeshletData.bounds.begin(), lodMeshletData.bounds.end());
+        meshletData.vertices.insert(meshletData.vertices.end(), lodMeshletData.vertices.begin(), lodMeshletData.vertices.end());
+        meshletData.triangles.insert(meshletData.triangles.end(), lodMeshletData.triangles.begin(), lodMeshletData.triangles.end());
+    }
+
+    for (size_t i = 0; i < meshletLods.size(); i++) {
+        fmt::println("Mesh LOD {}: {} meshlets", i, meshletLods[i].meshletCount);
+    }
+
+    auto vertices = mesh.vertices();
+    auto indices = mesh.indices();
+    auto lods = mesh.lods();
+
+    return Mesh { std::move(vertices), std::move(indices), std::move(lods), std::move(meshletData), std::move(meshletLods) };
+}
+
+std::optional<Mesh> MeshImporter::loadCached(const MeshCache& meshCache, const std::string& filePath, const MeshImportSettings& settings) {
+    const auto cachedMesh = meshCache.load(filePath, MeshImporter::VERTEX_LAYOUT_VERSION, sizeof(Vertex), settings.getHash());
+    if (!cachedMesh.has_value()) {
+        return std::nullopt;
+    }
+
+    // The cache stores the final vertices and meshlets, so they are copied straight out of
+    // the mapping without parsing, deduplication or any of the steps after.
+    auto vertices = std::vector<Vertex>(cachedMesh->getVertexCount());
+    std::memcpy(vertices.data(), cachedMesh->getVertexData().data(), cachedMesh->getVertexData().size());
+    auto indices = std::vector<uint32_t>(cachedMesh->getIndices().begin(), cachedMesh->getIndices().end());
+    auto lods = std::vector<MeshLod>(cachedMesh->getLods().begin(), cachedMesh->getLods().end());
+    if (lods.empty()) {
+        return Mesh { std::move(vertices), std::move(indices) };
+    }
+
+    auto meshletData = MeshletData {
+        .meshlets = { cachedMesh->getMeshlets().begin(), cachedMesh->getMeshlets().end() },
+        .bounds = { cachedMesh->getMeshletBounds().begin(), cachedMesh->getMeshletBounds().end() },
+        .vertices = { cachedMesh->getMeshletVertices().begin(), cachedMesh->getMeshletVertices().end() },
+        .triangles = { cachedMesh->getMeshletTriangles().begin(), cachedMesh->getMeshletTriangles().end() },
+    };
+    auto meshletLods = std::vector<MeshletLod>(cachedMesh->getMeshletLods().begin(), cachedMesh->getMeshletLods().end());
+
+    return Mesh { std::move(vertices), std::move(indices), std::move(lods), std::move(meshletData), std::move(meshletLods) };
+}
+
+void MeshImporter::storeCached(const MeshCache& meshCache, const std::string& filePath, const MeshImportSettings& settings, const Mesh& mesh) {
+    const auto& meshlets = mesh.meshlets();
+    const auto data = MeshCacheData {
+        .vertexStride = sizeof(Vertex),
+        .vertexData = std::span<const uint8_t> {
+            reinterpret_cast<const uint8_t*>(mesh.vertices().data()),
+            mesh.vertices().size() * sizeof(Vertex)
+        },
+        .indices = mesh.indices(),
+        .lods = mesh.lods(),
+        .meshlets = meshlets.meshlets,
+        .meshletBounds = meshlets.bounds,
+        .meshletVertices = meshlets.vertices,
+        .meshletTriangles = meshlets.triangles,
+        .meshletLods = mesh.meshletLods(),
+    };
+    meshCache.store(filePath, MeshImporter::VERTEX_LAYOUT_VERSION, settings.getHash(), data);
+}
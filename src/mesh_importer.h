@@ -0,0 +1,299 @@
+#ifndef _MESH_IMPORTER_H
+#define _MESH_IMPORTER_H
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "job_system.h"
+#include "mesh_cache.h"
+#include "meshlet_builder.h"
+#include "obj_parser.h"
+#include "texture_packer.h"
+
+
+namespace VulkanEngine {
+
+/// @brief A vertex as imported, at full precision.
+///
+/// @note Meshes are deduplicated, optimized and cached as `Vertex`, and only packed into
+/// the vertex layout of the GPU when their vertex buffer is created.
+struct Vertex {
+    glm::vec3 position;
+    glm::vec2 texCoord;
+    /// @brief The layer of the page of packed textures that the texture coordinate samples,
+    /// or zero for a texture of its own.
+    uint32_t textureLayer = 0;
+
+    bool operator==(const Vertex& other) const {
+        return position == other.position && texCoord == other.texCoord && textureLayer == other.textureLayer;
+    }
+};
+
+/// @brief An indexed triangle mesh.
+///
+/// @note Indices are kept as 32-bit values on the CPU, but a mesh with fewer than 65536
+/// vertices is drawn with 16-bit indices, which halves its index memory and bandwidth.
+/// `indexType` is the width the index buffer is packed to and bound with.
+///
+/// The bounding box of the positions is kept for packing vertices with quantized positions.
+///
+/// The index data holds every level of detail of the mesh, the full detail level first,
+/// and all of them index the same vertices. The vertices are ordered coarsest level first,
+/// so that every level indexes only the first `MeshLod::vertexCount` of them. A mesh built without levels of detail has one
+/// level covering all of its indices. A mesh built with meshlets has the meshlets of every
+/// level of detail, level by level, and one range of them per level.
+class Mesh final {
+    public:
+        explicit Mesh()
+            : m_indexType { VK_INDEX_TYPE_UINT16 }
+            , m_bounds { glm::vec3 { 0.0f }, glm::vec3 { 0.0f } }
+            , m_lods { MeshLod {} }
+        {
+        }
+
+        explicit Mesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+            : m_vertices { vertices }
+            , m_indices { indices }
+            , m_indexType { selectIndexType(vertices.size()) }
+            , m_bounds { computeBounds(vertices) }
+            , m_lods { MeshLod { .firstIndex = 0, .indexCount = static_cast<uint32_t>(indices.size()), .vertexCount = static_cast<uint32_t>(vertices.size()) } }
+        {
+        }
+
+        explicit Mesh(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices)
+            : m_vertices { vertices }
+            , m_indices { indices }
+            , m_indexType { selectIndexType(m_vertices.size()) }
+            , m_bounds { computeBounds(m_vertices) }
+            , m_lods { MeshLod { .firstIndex = 0, .indexCount = static_cast<uint32_t>(m_indices.size()), .vertexCount = static_cast<uint32_t>(m_vertices.size()) } }
+        {
+        }
+
+        explicit Mesh(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices, std::vector<MeshLod>&& lods)
+            : m_vertices { vertices }
+            , m_indices { indices }
+            , m_indexType { selectIndexType(m_vertices.size()) }
+            , m_bounds { computeBounds(m_vertices) }
+            , m_lods { lods }
+        {
+        }
+
+        explicit Mesh(
+            std::vector<Vertex>&& vertices,
+            std::vector<uint32_t>&& indices,
+            std::vector<MeshLod>&& lods,
+            MeshletData&& meshlets,
+            std::vector<MeshletLod>&& meshletLods
+        )
+            : m_vertices { std::move(vertices) }
+            , m_indices { std::move(indices) }
+            , m_indexType { selectIndexType(m_vertices.size()) }
+            , m_bounds { computeBounds(m_vertices) }
+            , m_lods { std::move(lods) }
+            , m_meshlets { std::move(meshlets) }
+            , m_meshletLods { std::move(meshletLods) }
+        {
+        }
+
+        const std::vector<Vertex>& vertices() const {
+            return m_vertices;
+        }
+
+        const std::vector<uint32_t>& indices() const {
+            return m_indices;
+        }
+
+        VkIndexType indexType() const {
+            return m_indexType;
+        }
+
+        VkDeviceSize indexSize() const {
+            if (m_indexType == VK_INDEX_TYPE_UINT16) {
+                return sizeof(uint16_t);
+            } else {
+                return sizeof(uint32_t);
+            }
+        }
+
+        const glm::vec3& boundsMin() const {
+            return m_bounds[0];
+        }
+
+        const glm::vec3& boundsMax() const {
+            return m_bounds[1];
+        }
+
+        const std::vector<MeshLod>& lods() const {
+            return m_lods;
+        }
+
+        const MeshletData& meshlets() const {
+            return m_meshlets;
+        }
+
+        /// @brief The meshlets of every level of detail, or none for a mesh built without
+        /// meshlets.
+        const std::vector<MeshletLod>& meshletLods() const {
+            return m_meshletLods;
+        }
+
+        /// @brief The memory the mesh holds on the CPU.
+        size_t byteSize() const {
+            return m_vertices.size() * sizeof(Vertex) +
+                m_indices.size() * sizeof(uint32_t) +
+                m_meshlets.meshlets.size() * (sizeof(Meshlet) + sizeof(MeshletBounds)) +
+                m_meshlets.vertices.size() * sizeof(uint32_t) +
+                m_meshlets.triangles.size();
+        }
+    private:
+        std::vector<Vertex> m_vertices;
+        std::vector<uint32_t> m_indices;
+        VkIndexType m_indexType;
+        std::array<glm::vec3, 2> m_bounds;
+        std::vector<MeshLod> m_lods;
+        MeshletData m_meshlets;
+        std::vector<MeshletLod> m_meshletLods;
+
+        static std::array<glm::vec3, 2> computeBounds(const std::vector<Vertex>& vertices) {
+            if (vertices.empty()) {
+                return std::array<glm::vec3, 2> { glm::vec3 { 0.0f }, glm::vec3 { 0.0f } };
+            }
+
+            auto bounds = std::array<glm::vec3, 2> { vertices[0].position, vertices[0].position };
+            for (const auto& vertex : vertices) {
+                bounds[0] = glm::min(bounds[0], vertex.position);
+                bounds[1] = glm::max(bounds[1], vertex.position);
+            }
+
+            return bounds;
+        }
+
+        static VkIndexType selectIndexType(size_t vertexCount) {
+            if (vertexCount <= std::numeric_limits<uint16_t>::max()) {
+                return VK_INDEX_TYPE_UINT16;
+            } else {
+                return VK_INDEX_TYPE_UINT32;
+            }
+        }
+};
+
+/// @brief Imports OBJ models and deduplicates their vertices.
+///
+/// @note With a job system, every shape is deduplicated on its own, in parallel, and the
+/// per-shape vertex tables are then merged in shape order with their indices
+/// remapped. The first use of every vertex keeps its place in that order, so the result
+/// is identical to the serial import.
+class MeshLoader final {
+    public:
+        explicit MeshLoader() : m_jobSystem { nullptr } {}
+        explicit MeshLoader(JobSystem* jobSystem) : m_jobSystem { jobSystem } {}
+
+        Mesh load(const std::string& filePath) const;
+    private:
+        JobSystem* m_jobSystem;
+
+        Mesh deduplicateInParallel(const ObjMesh& objMesh) const;
+};
+
+/// @brief Imports binary glTF models, whose vertices are already indexed.
+///
+/// @note The accessors are read straight out of the mapped file into the vertices and the
+/// indices, with nothing to parse but the JSON chunk and nothing to deduplicate, so the
+/// import costs about as much as reading the file. Every primitive gets its own range of
+/// the vertices and the indices, and with a job system the primitives are converted in
+/// parallel.
+class GltfMeshLoader final {
+    public:
+        explicit GltfMeshLoader() : m_jobSystem { nullptr } {}
+        explicit GltfMeshLoader(JobSystem* jobSystem) : m_jobSystem { jobSystem } {}
+
+        Mesh load(const std::string& filePath) const;
+    private:
+        JobSystem* m_jobSystem;
+};
+
+/// @brief What importing a mesh does to it after loading it.
+struct MeshImportSettings final {
+    /// @brief Reorder the mesh for the post-transform cache, overdraw and vertex fetch.
+    bool optimize = true;
+    /// @brief The levels of detail to simplify the mesh into, as about these fractions of
+    /// the full triangle count, or none for a mesh of one level.
+    std::vector<float> lodTriangleRatios = { 0.5f, 0.25f, 0.12f };
+    /// @brief Partition every level of detail into meshlets for mesh shaders.
+    bool buildMeshlets = true;
+    /// @brief Where the texture the mesh samples was packed, whose layer and part of it the
+    /// texture coordinates are remapped into, or nothing for a texture of its own.
+    std::optional<TexturePlacement> texturePlacement;
+
+    /// @brief A hash of the settings and `MeshImporter::VERTEX_LAYOUT_VERSION`, which
+    /// tells meshes imported two ways apart.
+    uint64_t getHash() const;
+};
+
+/// @brief Runs every step of importing a mesh, from loading the model to building its
+/// meshlets, and reads and writes the results through the mesh cache.
+///
+/// @note The steps are the same whether a mesh is imported at load time or baked ahead of
+/// it, so a baked mesh cache entry is the entry the demo would have written itself, and
+/// loading it costs one memory mapping.
+class MeshImporter final {
+    public:
+        /// @brief Bump whenever `Vertex` or the way the mesh loaders build vertices changes,
+        /// so that stale mesh cache entries miss.
+        static constexpr uint32_t VERTEX_LAYOUT_VERSION = 5;
+
+        explicit MeshImporter() = delete;
+
+        /// @brief Load the OBJ or GLB model at `filePath`, and remap, optimize, simplify and
+        /// partition it as `settings` ask.
+        static Mesh import(const std::string& filePath, const MeshImportSettings& settings, JobSystem* jobSystem = nullptr);
+
+        /// @brief Map the texture coordinates of `mesh` into the part of the layer that its
+        /// texture was packed into, and point every vertex at that layer.
+        ///
+        /// @note The loaders read no materials, so every vertex of a mesh samples the one
+        /// texture, and takes the one placement.
+        static Mesh remapTexCoords(const Mesh& mesh, const TexturePlacement& placement);
+
+        /// @brief Reorder the triangles and vertices of `mesh` with `MeshOptimizer`,
+        /// reporting the ACMR before and after.
+        static Mesh optimize(const Mesh& mesh);
+
+        /// @brief Append simplified levels of detail to the single level of `mesh`.
+        ///
+        /// @note Every level is simplified from the full detail level and reordered for the
+        /// vertex cache on its own. Levels stop where the simplifier cannot get meaningfully
+        /// below the previous level. The vertices are then reordered coarsest level first:
+        /// the vertices of the coarsest level in the order it first uses them, then those
+        /// each finer level adds, so that a level can be streamed in on top of the coarser
+        /// ones by appending its new vertices.
+        static Mesh generateLods(const Mesh& mesh, std::span<const float> triangleRatios);
+
+        /// @brief Partition every level of detail of `mesh` into meshlets.
+        ///
+        /// @note The meshlets of all levels go into one `MeshletData`, level by level, with
+        /// their offsets rebased to match, and index the vertices of `mesh` directly.
+        static Mesh buildMeshlets(const Mesh& mesh);
+
+        /// @brief The mesh cached for `filePath` with `settings`, copied out of the mapping.
+        static std::optional<Mesh> loadCached(const MeshCache& meshCache, const std::string& filePath, const MeshImportSettings& settings);
+
+        static void storeCached(const MeshCache& meshCache, const std::string& filePath, const MeshImportSettings& settings, const Mesh& mesh);
+};
+
+}
+
+#endif // _MESH_IMPORTER_H
@@ -0,0 +1,352 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+
+using MeshOptimizer = VulkanEngine::MeshOptimizer;
+
+/// @brief Counts the misses of a FIFO post-transform cache.
+///
+/// @note Vertex timestamps stand in for the FIFO, so a lookup is constant time. A vertex is
+/// in the cache while fewer than `cacheSize` misses have happened since it was loaded.
+class FifoCacheSimulator final {
+    public:
+        explicit FifoCacheSimulator() = delete;
+        explicit FifoCacheSimulator(uint32_t vertexCount, uint32_t cacheSize)
+            : m_loadTimes { std::vector<uint32_t>(vertexCount, 0) }
+            , m_cacheSize { cacheSize }
+            , m_time { cacheSize + 1 }
+        {
+        }
+
+        /// @brief Look `vertex` up, loading it on a miss.
+        ///
+        /// @returns Whether the lookup missed.
+        bool access(uint32_t vertex) {
+            if (m_time - m_loadTimes[vertex] <= m_cacheSize) {
+                return false;
+            }
+
+            m_loadTimes[vertex] = m_time;
+            m_time++;
+
+            return true;
+        }
+
+        /// @brief Empty the cache.
+        void flush() {
+            m_time += m_cacheSize + 1;
+        }
+    private:
+        std::vector<uint32_t> m_loadTimes;
+        uint32_t m_cacheSize;
+        uint32_t m_time;
+};
+
+static void validateIndices(std::span<const uint32_t> indices, uint32_t vertexCount) {
+    if (indices.size() % 3 != 0) {
+        throw std::invalid_argument("mesh indices must form whole triangles!");
+    }
+
+    for (const auto& index : indices) {
+        if (index >= vertexCount) {
+            throw std::invalid_argument("mesh index out of range!");
+        }
+    }
+}
+
+float MeshOptimizer::computeAcmr(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize) {
+    validateIndices(indices, vertexCount);
+    if (indices.empty()) {
+        return 0.0f;
+    }
+
+    auto cache = FifoCacheSimulator { vertexCount, cacheSize };
+    auto missCount = size_t { 0 };
+    for (const auto& index : indices) {
+        missCount += cache.access(index) ? 1 : 0;
+    }
+
+    return static_cast<float>(missCount) / static_cast<float>(indices.size() / 3);
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize) {
+    validateIndices(indices, vertexCount);
+
+    const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    auto clusters = std::vector<uint32_t> {};
+    if (triangleCount == 0) {
+        return clusters;
+    }
+
+    // The triangles around every vertex, as one flat adjacency array.
+    auto liveTriangleCounts = std::vector<uint32_t>(vertexCount, 0);
+    for (const auto& index : indices) {
+        liveTriangleCounts[index]++;
+    }
+
+    auto adjacencyOffsets = std::vector<uint32_t>(vertexCount + 1, 0);
+    std::inclusive_scan(liveTriangleCounts.begin(), liveTriangleCounts.end(), adjacencyOffsets.begin() + 1);
+
+    auto adjacency = std::vector<uint32_t>(indices.size());
+    auto adjacencyFill = std::vector<uint32_t>(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (uint32_t i = 0; i < indices.size(); i++) {
+        adjacency[adjacencyFill[indices[i]]++] = i / 3;
+    }
+
+    // Tipsify, after Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex
+    // Locality and Reduced Overdraw", 2007. Triangles are emitted in fans around one vertex
+    // at a time, and the next fan is picked among the vertices of the last one by how
+    // likely it is to still be in the cache once its remaining triangles are emitted.
+    auto cacheTimes = std::vector<uint32_t>(vertexCount, 0);
+    auto isEmitted = std::vector<bool>(triangleCount, false);
+    auto deadEnds = std::vector<uint32_t> {};
+    auto candidates = std::vector<uint32_t> {};
+    auto reordered = std::vector<uint32_t> {};
+    reordered.reserve(indices.size());
+
+    auto time = cacheSize + 1;
+    auto scanCursor = uint32_t { 0 };
+    auto isInCache = [&cacheTimes, &time, cacheSize](uint32_t vertex) {
+        return time - cacheTimes[vertex] <= cacheSize;
+    };
+    auto skipDeadEnd = [&deadEnds, &liveTriangleCounts, &scanCursor, vertexCount]() -> int64_t {
+        while (!deadEnds.empty()) {
+            const auto vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangleCounts[vertex] > 0) {
+                return vertex;
+            }
+        }
+
+        while (scanCursor < vertexCount) {
+            if (liveTriangleCounts[scanCursor] > 0) {
+                return scanCursor;
+            }
+
+            scanCursor++;
+        }
+
+        return -1;
+    };
+
+    clusters.push_back(0);
+    auto fanVertex = int64_t { 0 };
+    while (liveTriangleCounts[static_cast<uint32_t>(fanVertex)] == 0) {
+        fanVertex++;
+    }
+
+    while (fanVertex >= 0) {
+        candidates.clear();
+        const auto vertex = static_cast<uint32_t>(fanVertex);
+        for (auto i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex + 1]; i++) {
+            const auto triangle = adjacency[i];
+            if (isEmitted[triangle]) {
+                continue;
+            }
+
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                const auto triangleVertex = indices[3 * triangle + corner];
+                reordered.push_back(triangleVertex);
+                deadEnds.push_back(triangleVertex);
+                candidates.push_back(triangleVertex);
+                liveTriangleCounts[triangleVertex]--;
+                if (!isInCache(triangleVertex)) {
+                    cacheTimes[triangleVertex] = time;
+                    time++;
+                }
+            }
+
+            isEmitted[triangle] = true;
+        }
+
+        // Prefer the candidate that stays in the cache longest while its remaining
+        // triangles are emitted. Candidates whose fans would push them out of the cache
+        // score as if they were freshly loaded.
+        auto bestVertex = int64_t { -1 };
+        auto bestPriority = int64_t { -1 };
+        for (const auto& candidate : candidates) {
+            if (liveTriangleCounts[candidate] == 0) {
+                continue;
+            }
+
+            auto priority = int64_t { 0 };
+            const auto age = static_cast<int64_t>(time - cacheTimes[candidate]);
+            if (age + 2 * static_cast<int64_t>(liveTriangleCounts[candidate]) <= static_cast<int64_t>(cacheSize)) {
+                priority = age;
+            }
+
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                bestVertex = candidate;
+            }
+        }
+
+        if (bestVertex < 0) {
+            bestVertex = skipDeadEnd();
+
+            // A fan that starts outside the cache starts a new cluster.
+            const auto triangleIndex = static_cast<uint32_t>(reordered.size() / 3);
+            if (bestVertex >= 0 && !isInCache(static_cast<uint32_t>(bestVertex)) && triangleIndex != clusters.back()) {
+                clusters.push_back(triangleIndex);
+            }
+        }
+
+        fanVertex = bestVertex;
+    }
+
+    std::copy(reordered.begin(), reordered.end(), indices.begin());
+
+    return clusters;
+}
+
+void MeshOptimizer::optimizeOverdraw(
+    std::span<uint32_t> indices,
+    std::span<const uint32_t> clusters,
+    const float* positions,
+    uint32_t vertexCount,
+    size_t positionStride,
+    uint32_t cacheSize,
+    float threshold
+) {
+    validateIndices(indices, vertexCount);
+
+    const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount == 0) {
+        return;
+    }
+
+    const auto getPosition = [positions, positionStride](uint32_t vertex) {
+        const auto* position = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+
+        return std::array<float, 3> { position[0], position[1], position[2] };
+    };
+
+    // Every cluster starts with a cold cache once the clusters are shuffled around, so a
+    // cluster is split wherever the part before the split already reaches close to the
+    // ACMR of the whole cluster.
+    auto cache = FifoCacheSimulator { vertexCount, cacheSize };
+    auto splitClusters = std::vector<uint32_t> {};
+    for (size_t i = 0; i < clusters.size(); i++) {
+        const auto clusterBegin = clusters[i];
+        const auto clusterEnd = (i + 1 < clusters.size()) ? clusters[i + 1] : triangleCount;
+
+        cache.flush();
+        auto clusterMisses = uint32_t { 0 };
+        for (auto triangle = clusterBegin; triangle < clusterEnd; triangle++) {
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                clusterMisses += cache.access(indices[3 * triangle + corner]) ? 1 : 0;
+            }
+        }
+
+        const auto clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(clusterEnd - clusterBegin);
+
+        cache.flush();
+        splitClusters.push_back(clusterBegin);
+        auto splitMisses = uint32_t { 0 };
+        auto splitBegin = clusterBegin;
+        for (auto triangle = clusterBegin; triangle < clusterEnd; triangle++) {
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                splitMisses += cache.access(indices[3 * triangle + corner]) ? 1 : 0;
+            }
+
+            const auto splitAcmr = static_cast<float>(splitMisses) / static_cast<float>(triangle + 1 - splitBegin);
+            if (triangle + 1 < clusterEnd && splitAcmr <= clusterAcmr * threshold) {
+                cache.flush();
+                splitMisses = 0;
+                splitBegin = triangle + 1;
+                splitClusters.push_back(splitBegin);
+            }
+        }
+    }
+
+    // Sort the clusters by how far they face away from the centroid of the mesh, outermost
+    // first. Centroids and normals are area weighted.
+    auto meshCentroid = std::array<double, 3> { 0.0, 0.0, 0.0 };
+    auto meshArea = 0.0;
+    auto clusterKeys = std::vector<std::array<double, 7>>(splitClusters.size());
+    for (size_t i = 0; i < splitClusters.size(); i++) {
+        const auto clusterBegin = splitClusters[i];
+        const auto clusterEnd = (i + 1 < splitClusters.size()) ? splitClusters[i + 1] : triangleCount;
+
+        auto& clusterKey = clusterKeys[i];
+        clusterKey.fill(0.0);
+        for (auto triangle = clusterBegin; triangle < clusterEnd; triangle++) {
+            const auto p0 = getPosition(indices[3 * triangle + 0]);
+            const auto p1 = getPosition(indices[3 * triangle + 1]);
+            const auto p2 = getPosition(indices[3 * triangle + 2]);
+            const auto e1 = std::array<double, 3> { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            const auto e2 = std::array<double, 3> { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            const auto normal = std::array<double, 3> {
+                e1[1] * e2[2] - e1[2] * e2[1],
+                e1[2] * e2[0] - e1[0] * e2[2],
+                e1[0] * e2[1] - e1[1] * e2[0],
+            };
+            const auto area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            for (uint32_t axis = 0; axis < 3; axis++) {
+                const auto center = (static_cast<double>(p0[axis]) + p1[axis] + p2[axis]) / 3.0;
+                clusterKey[axis] += center * area;
+                clusterKey[3 + axis] += normal[axis];
+                meshCentroid[axis] += center * area;
+            }
+
+            clusterKey[6] += area;
+            meshArea += area;
+        }
+    }
+
+    if (meshArea > 0.0) {
+        for (auto& axis : meshCentroid) {
+            axis /= meshArea;
+        }
+    }
+
+    auto sortKeys = std::vector<double>(splitClusters.size(), 0.0);
+    for (size_t i = 0; i < splitClusters.size(); i++) {
+        const auto& clusterKey = clusterKeys[i];
+        if (clusterKey[6] <= 0.0) {
+            continue;
+        }
+
+        for (uint32_t axis = 0; axis < 3; axis++) {
+            sortKeys[i] += (clusterKey[axis] / clusterKey[6] - meshCentroid[axis]) * clusterKey[3 + axis];
+        }
+    }
+
+    auto clusterOrder = std::vector<uint32_t>(splitClusters.size());
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32_t left, uint32_t right) {
+        return sortKeys[left] > sortKeys[right];
+    });
+
+    auto reordered = std::vector<uint32_t> {};
+    reordered.reserve(indices.size());
+    for (const auto& cluster : clusterOrder) {
+        const auto clusterBegin = splitClusters[cluster];
+        const auto clusterEnd = (cluster + 1 < splitClusters.size()) ? splitClusters[cluster + 1] : triangleCount;
+        reordered.insert(reordered.end(), indices.begin() + 3 * clusterBegin, indices.begin() + 3 * clusterEnd);
+    }
+
+    std::copy(reordered.begin(), reordered.end(), indices.begin());
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(std::span<uint32_t> indices, uint32_t vertexCount) {
+    validateIndices(indices, vertexCount);
+
+    auto remap = std::vector<uint32_t>(vertexCount, UNUSED_VERTEX);
+    auto nextVertex = uint32_t { 0 };
+    for (auto& index : indices) {
+        if (remap[index] == UNUSED_VERTEX) {
+            remap[index] = nextVertex;
+            nextVertex++;
+        }
+
+        index = remap[index];
+    }
+
+    return remap;
+}
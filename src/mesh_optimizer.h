@@ -0,0 +1,71 @@
+#ifndef _MESH_OPTIMIZER_H
+#define _MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief Reorders the triangles and vertices of indexed triangle lists for the GPU.
+///
+/// @note The passes are meant to run in order on a deduplicated mesh:
+///
+/// @li `optimizeVertexCache` reorders triangles with Tipsify so that consecutive triangles
+/// reuse vertices still in the post-transform cache, and reports the clusters it found.
+/// @li `optimizeOverdraw` splits those clusters further where that costs little cache
+/// efficiency, and draws the clusters that face away from the center of the mesh first,
+/// since they tend to occlude the rest.
+/// @li `optimizeVertexFetch` renumbers the vertices in the order the triangles first use
+/// them, so vertex fetches walk the vertex buffer front to back.
+///
+/// ACMR, the average number of cache misses per triangle, measures the result. It ranges
+/// from 3 for no reuse at all down to about 0.5 for a large regular grid.
+class MeshOptimizer final {
+    public:
+        /// @brief The post-transform cache size the passes optimize for.
+        static constexpr uint32_t DEFAULT_CACHE_SIZE = 16;
+
+        /// @brief How much worse than its parent cluster's ACMR a split cluster may get.
+        static constexpr float DEFAULT_OVERDRAW_THRESHOLD = 1.05f;
+
+        explicit MeshOptimizer() = delete;
+
+        /// @brief The ACMR of `indices` on a FIFO cache of `cacheSize` vertices.
+        static float computeAcmr(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+        /// @brief Reorder the triangles of `indices` in place with Tipsify.
+        ///
+        /// @returns The first triangle of every cluster, in ascending order. A cluster ends
+        /// wherever Tipsify ran out of triangles around the vertices in its cache.
+        static std::vector<uint32_t> optimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+        /// @brief Reorder the clusters of a cache-optimized `indices` in place to reduce overdraw.
+        ///
+        /// @note `positions` points to the first position, three floats, and consecutive
+        /// positions are `positionStride` bytes apart. The triangle order inside a cluster
+        /// is kept.
+        static void optimizeOverdraw(
+            std::span<uint32_t> indices,
+            std::span<const uint32_t> clusters,
+            const float* positions,
+            uint32_t vertexCount,
+            size_t positionStride,
+            uint32_t cacheSize = DEFAULT_CACHE_SIZE,
+            float threshold = DEFAULT_OVERDRAW_THRESHOLD
+        );
+
+        /// @brief Renumber the vertices in order of first use and rewrite `indices` to match.
+        ///
+        /// @returns The new index of every old vertex, or `UNUSED_VERTEX` for vertices no
+        /// triangle uses. The new vertex count is the number of used vertices.
+        static std::vector<uint32_t> optimizeVertexFetch(std::span<uint32_t> indices, uint32_t vertexCount);
+
+        static constexpr uint32_t UNUSED_VERTEX = 0xffffffff;
+};
+
+}
+
+#endif // _MESH_OPTIMIZER_H
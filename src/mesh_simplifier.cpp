@@ -0,0 +1,522 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+
+using MeshSimplifier = VulkanEngine::MeshSimplifier;
+
+using Vector3 = std::array<double, 3>;
+
+static Vector3 subtract(const Vector3& left, const Vector3& right) {
+    return Vector3 { left[0] - right[0], left[1] - right[1], left[2] - right[2] };
+}
+
+static Vector3 cross(const Vector3& left, const Vector3& right) {
+    return Vector3 {
+        left[1] * right[2] - left[2] * right[1],
+        left[2] * right[0] - left[0] * right[2],
+        left[0] * right[1] - left[1] * right[0],
+    };
+}
+
+static double dot(const Vector3& left, const Vector3& right) {
+    return left[0] * right[0] + left[1] * right[1] + left[2] * right[2];
+}
+
+static double length(const Vector3& vector) {
+    return std::sqrt(dot(vector, vector));
+}
+
+/// @brief The sum of squared distances to a set of weighted planes, as a symmetric 4x4
+/// matrix stored by its upper triangle.
+struct Quadric final {
+    double a00 = 0.0;
+    double a01 = 0.0;
+    double a02 = 0.0;
+    double a11 = 0.0;
+    double a12 = 0.0;
+    double a22 = 0.0;
+    double b0 = 0.0;
+    double b1 = 0.0;
+    double b2 = 0.0;
+    double c = 0.0;
+
+    /// @brief The quadric of the plane through `point` with unit `normal`.
+    static Quadric fromPlane(const Vector3& normal, const Vector3& point, double weight) {
+        const auto distance = -dot(normal, point);
+
+        return Quadric {
+            .a00 = weight * normal[0] * normal[0],
+            .a01 = weight * normal[0] * normal[1],
+            .a02 = weight * normal[0] * normal[2],
+            .a11 = weight * normal[1] * normal[1],
+            .a12 = weight * normal[1] * normal[2],
+            .a22 = weight * normal[2] * normal[2],
+            .b0 = weight * normal[0] * distance,
+            .b1 = weight * normal[1] * distance,
+            .b2 = weight * normal[2] * distance,
+            .c = weight * distance * distance,
+        };
+    }
+
+    Quadric& operator+=(const Quadric& other) {
+        a00 += other.a00;
+        a01 += other.a01;
+        a02 += other.a02;
+        a11 += other.a11;
+        a12 += other.a12;
+        a22 += other.a22;
+        b0 += other.b0;
+        b1 += other.b1;
+        b2 += other.b2;
+        c += other.c;
+
+        return *this;
+    }
+
+    double evaluate(const Vector3& point) const {
+        const auto x = point[0];
+        const auto y = point[1];
+        const auto z = point[2];
+        const auto error = a00 * x * x + a11 * y * y + a22 * z * z +
+            2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+            2.0 * (b0 * x + b1 * y + b2 * z) +
+            c;
+
+        return std::abs(error);
+    }
+};
+
+static constexpr uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+
+enum class VertexKind {
+    /// @brief The vertex may collapse onto any neighbour.
+    Manifold,
+    /// @brief The vertex lies on an open border and may only collapse along it.
+    Border,
+    /// @brief The vertex shares its position with one other vertex across an attribute
+    /// seam, and both may only collapse along the seam, together.
+    Seam,
+    /// @brief The vertex lies on an attribute seam or on non-manifold geometry and never moves.
+    Locked,
+};
+
+static uint64_t createEdgeKey(uint32_t first, uint32_t second) {
+    return (static_cast<uint64_t>(std::min(first, second)) << 32) | std::max(first, second);
+}
+
+/// @brief Moving `vertex` onto `target`, and for seam vertices `sibling` onto `siblingTarget`.
+struct Collapse final {
+    double cost = 0.0;
+    uint32_t vertex = NO_VERTEX;
+    uint32_t target = NO_VERTEX;
+    uint32_t sibling = NO_VERTEX;
+    uint32_t siblingTarget = NO_VERTEX;
+};
+
+// Border and seam edges are held in place by planes through them, perpendicular to their
+// triangle, weighted well above the surface planes.
+static constexpr double EDGE_PLANE_WEIGHT = 10.0;
+
+// Every pass tries the cheapest quarter of its candidate collapses.
+static constexpr size_t PASS_CANDIDATE_DIVISOR = 4;
+
+// A collapse is rejected when it turns a triangle by more than about 75 degrees.
+static constexpr double MIN_NORMAL_COSINE = 0.25;
+
+std::vector<uint32_t> MeshSimplifier::simplify(
+    std::span<const uint32_t> indices,
+    const float* positions,
+    uint32_t vertexCount,
+    size_t positionStride,
+    size_t targetIndexCount
+) {
+    if (indices.size() % 3 != 0) {
+        throw std::invalid_argument("mesh indices must form whole triangles!");
+    }
+
+    for (const auto& index : indices) {
+        if (index >= vertexCount) {
+            throw std::invalid_argument("mesh index out of range!");
+        }
+    }
+
+    auto result = std::vector<uint32_t>(indices.begin(), indices.end());
+    if (result.size() <= targetIndexCount) {
+        return result;
+    }
+
+    auto vertexPositions = std::vector<Vector3>(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        const auto* position = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + i * positionStride);
+        vertexPositions[i] = Vector3 { position[0], position[1], position[2] };
+    }
+
+    // Weld vertices by position, so that the topology is seen through attribute seams.
+    // Adding zero turns -0.0 into 0.0 before the bits are compared.
+    const auto hashPosition = [](const std::array<uint32_t, 3>& bits) {
+        const auto hash = (static_cast<uint64_t>(bits[0]) * 0x9e3779b97f4a7c15) ^
+            (static_cast<uint64_t>(bits[1]) * 0xc2b2ae3d27d4eb4f) ^
+            (static_cast<uint64_t>(bits[2]) * 0x165667b19e3779f9);
+
+        return static_cast<size_t>(hash ^ (hash >> 29));
+    };
+    auto positionIdsByBits = std::unordered_map<std::array<uint32_t, 3>, uint32_t, decltype(hashPosition)> { 0, hashPosition };
+    auto positionIds = std::vector<uint32_t>(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        const auto* position = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + i * positionStride);
+        const auto bits = std::array<uint32_t, 3> {
+            std::bit_cast<uint32_t>(position[0] + 0.0f),
+            std::bit_cast<uint32_t>(position[1] + 0.0f),
+            std::bit_cast<uint32_t>(position[2] + 0.0f),
+        };
+        positionIds[i] = positionIdsByBits.try_emplace(bits, i).first->second;
+    }
+
+    auto isReferenced = std::vector<bool>(vertexCount, false);
+    for (const auto& index : indices) {
+        isReferenced[index] = true;
+    }
+
+    auto wedgeCounts = std::vector<uint32_t>(vertexCount, 0);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        wedgeCounts[positionIds[i]] += isReferenced[i] ? 1 : 0;
+    }
+
+    // The number of triangles around every edge between two positions, counted again after
+    // every pass since collapses create new border edges.
+    auto edgeTriangleCounts = std::unordered_map<uint64_t, uint32_t> {};
+    const auto countEdgeTriangles = [&edgeTriangleCounts, &positionIds](std::span<const uint32_t> triangles) {
+        edgeTriangleCounts.clear();
+        edgeTriangleCounts.reserve(triangles.size());
+        for (size_t i = 0; i < triangles.size(); i += 3) {
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                const auto first = positionIds[triangles[i + corner]];
+                const auto second = positionIds[triangles[i + (corner + 1) % 3]];
+                edgeTriangleCounts[createEdgeKey(first, second)]++;
+            }
+        }
+    };
+    countEdgeTriangles(indices);
+
+    const auto getEdgeTriangleCount = [&edgeTriangleCounts, &positionIds](uint32_t first, uint32_t second) {
+        const auto edge = edgeTriangleCounts.find(createEdgeKey(positionIds[first], positionIds[second]));
+
+        return (edge != edgeTriangleCounts.end()) ? edge->second : 0;
+    };
+
+    // The other vertex at the position of every seam vertex.
+    auto siblings = std::vector<uint32_t>(vertexCount, NO_VERTEX);
+    auto firstWedges = std::vector<uint32_t>(vertexCount, NO_VERTEX);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        const auto positionId = positionIds[i];
+        if (!isReferenced[i] || wedgeCounts[positionId] != 2) {
+            continue;
+        }
+
+        if (firstWedges[positionId] == NO_VERTEX) {
+            firstWedges[positionId] = i;
+        } else {
+            siblings[i] = firstWedges[positionId];
+            siblings[firstWedges[positionId]] = i;
+        }
+    }
+
+    auto vertexKinds = std::vector<VertexKind>(vertexCount, VertexKind::Manifold);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        if (wedgeCounts[positionIds[i]] > 2) {
+            vertexKinds[i] = VertexKind::Locked;
+        } else if (wedgeCounts[positionIds[i]] == 2) {
+            vertexKinds[i] = VertexKind::Seam;
+        }
+    }
+
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            const auto first = indices[i + corner];
+            const auto second = indices[i + (corner + 1) % 3];
+            const auto edgeTriangleCount = getEdgeTriangleCount(first, second);
+            for (const auto& vertex : { first, second }) {
+                if (edgeTriangleCount > 2) {
+                    vertexKinds[vertex] = VertexKind::Locked;
+                } else if (edgeTriangleCount == 1 && vertexKinds[vertex] == VertexKind::Seam) {
+                    vertexKinds[vertex] = VertexKind::Locked;
+                } else if (edgeTriangleCount == 1 && vertexKinds[vertex] == VertexKind::Manifold) {
+                    vertexKinds[vertex] = VertexKind::Border;
+                }
+            }
+        }
+    }
+
+    // An edge of only one triangle is a border edge if its positions have no other triangle
+    // either, and a seam edge otherwise.
+    auto vertexEdgeTriangleCounts = std::unordered_map<uint64_t, uint32_t> {};
+    vertexEdgeTriangleCounts.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            vertexEdgeTriangleCounts[createEdgeKey(indices[i + corner], indices[i + (corner + 1) % 3])]++;
+        }
+    }
+
+    // Quadrics are kept per position, weighted by triangle area.
+    auto quadrics = std::vector<Quadric>(vertexCount);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const auto& p0 = vertexPositions[indices[i + 0]];
+        const auto& p1 = vertexPositions[indices[i + 1]];
+        const auto& p2 = vertexPositions[indices[i + 2]];
+        const auto normal = cross(subtract(p1, p0), subtract(p2, p0));
+        const auto doubleArea = length(normal);
+        if (doubleArea <= 0.0) {
+            continue;
+        }
+
+        const auto unitNormal = Vector3 { normal[0] / doubleArea, normal[1] / doubleArea, normal[2] / doubleArea };
+        const auto planeQuadric = Quadric::fromPlane(unitNormal, p0, 0.5 * doubleArea);
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            quadrics[positionIds[indices[i + corner]]] += planeQuadric;
+        }
+
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            const auto first = indices[i + corner];
+            const auto second = indices[i + (corner + 1) % 3];
+            if (vertexEdgeTriangleCounts[createEdgeKey(first, second)] != 1) {
+                continue;
+            }
+
+            const auto edge = subtract(vertexPositions[second], vertexPositions[first]);
+            const auto edgeLength = length(edge);
+            const auto edgeNormal = cross(edge, unitNormal);
+            const auto edgeNormalLength = length(edgeNormal);
+            if (edgeNormalLength <= 0.0) {
+                continue;
+            }
+
+            const auto unitEdgeNormal = Vector3 {
+                edgeNormal[0] / edgeNormalLength,
+                edgeNormal[1] / edgeNormalLength,
+                edgeNormal[2] / edgeNormalLength,
+            };
+            const auto edgeQuadric = Quadric::fromPlane(unitEdgeNormal, vertexPositions[first], EDGE_PLANE_WEIGHT * edgeLength * edgeLength);
+            quadrics[positionIds[first]] += edgeQuadric;
+            quadrics[positionIds[second]] += edgeQuadric;
+        }
+    }
+
+    // Every pass picks the cheapest collapse of every vertex and applies them cheapest first,
+    // moving each vertex at most once, until enough triangles are gone to reach the target.
+    auto adjacencyOffsets = std::vector<uint32_t>(vertexCount + 1, 0);
+    auto adjacency = std::vector<uint32_t> {};
+    auto collapses = std::vector<Collapse> {};
+    auto collapseTargets = std::vector<uint32_t>(vertexCount);
+    auto isCollapseLocked = std::vector<bool>(vertexCount, false);
+    const auto isDegenerate = [&positionIds](const std::array<uint32_t, 3>& corners) {
+        return positionIds[corners[0]] == positionIds[corners[1]] ||
+            positionIds[corners[1]] == positionIds[corners[2]] ||
+            positionIds[corners[2]] == positionIds[corners[0]];
+    };
+
+    // The vertex of the sibling of a seam vertex at the position of `target`.
+    const auto findSiblingTarget = [&adjacencyOffsets, &adjacency, &result, &positionIds](uint32_t sibling, uint32_t target) {
+        for (auto i = adjacencyOffsets[sibling]; i < adjacencyOffsets[sibling + 1]; i++) {
+            const auto triangle = adjacency[i];
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                const auto vertex = result[3 * triangle + corner];
+                if (vertex != target && positionIds[vertex] == positionIds[target]) {
+                    return vertex;
+                }
+            }
+        }
+
+        return NO_VERTEX;
+    };
+
+    while (result.size() > targetIndexCount) {
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (const auto& index : result) {
+            adjacencyOffsets[index + 1]++;
+        }
+
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        adjacency.resize(result.size());
+        auto adjacencyFill = std::vector<uint32_t>(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (uint32_t i = 0; i < result.size(); i++) {
+            adjacency[adjacencyFill[result[i]]++] = i / 3;
+        }
+
+        collapses.clear();
+        for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+            if (vertexKinds[vertex] == VertexKind::Locked) {
+                continue;
+            }
+
+            auto bestCollapse = Collapse { .cost = std::numeric_limits<double>::max() };
+            for (auto i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex + 1]; i++) {
+                const auto triangle = adjacency[i];
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    const auto target = result[3 * triangle + corner];
+                    if (target == vertex) {
+                        continue;
+                    }
+
+                    if (vertexKinds[vertex] == VertexKind::Border && getEdgeTriangleCount(vertex, target) != 1) {
+                        continue;
+                    }
+
+                    // A seam vertex moves together with its sibling, and only along the seam,
+                    // where the sibling has a vertex at the target position too.
+                    auto siblingTarget = NO_VERTEX;
+                    if (vertexKinds[vertex] == VertexKind::Seam) {
+                        siblingTarget = findSiblingTarget(siblings[vertex], target);
+                        if (siblingTarget == NO_VERTEX) {
+                            continue;
+                        }
+                    }
+
+                    auto quadric = quadrics[positionIds[vertex]];
+                    quadric += quadrics[positionIds[target]];
+                    const auto cost = quadric.evaluate(vertexPositions[target]);
+                    if (cost < bestCollapse.cost) {
+                        bestCollapse = Collapse {
+                            .cost = cost,
+                            .vertex = vertex,
+                            .target = target,
+                            .sibling = (siblingTarget != NO_VERTEX) ? siblings[vertex] : NO_VERTEX,
+                            .siblingTarget = siblingTarget,
+                        };
+                    }
+                }
+            }
+
+            if (bestCollapse.vertex != NO_VERTEX) {
+                collapses.push_back(bestCollapse);
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& left, const Collapse& right) {
+            return left.cost < right.cost;
+        });
+        std::iota(collapseTargets.begin(), collapseTargets.end(), 0);
+        std::fill(isCollapseLocked.begin(), isCollapseLocked.end(), false);
+
+        // Only the cheapest candidates of a pass are tried, since every collapse changes the
+        // costs around it, and the expensive candidates are picked again next pass.
+        const auto triangleGoal = (result.size() - targetIndexCount + 2) / 3;
+        const auto candidateCount = std::max(collapses.size() / PASS_CANDIDATE_DIVISOR, std::min(collapses.size(), size_t { 1 }));
+        auto removedTriangleCount = size_t { 0 };
+        auto collapseCount = size_t { 0 };
+        for (const auto& collapse : std::span { collapses }.first(candidateCount)) {
+            const auto hasSibling = collapse.sibling != NO_VERTEX;
+            if (isCollapseLocked[collapse.vertex] || isCollapseLocked[collapse.target]) {
+                continue;
+            }
+
+            if (hasSibling && (isCollapseLocked[collapse.sibling] || isCollapseLocked[collapse.siblingTarget])) {
+                continue;
+            }
+
+            const auto moveCorner = [&collapse](uint32_t corner) {
+                if (corner == collapse.vertex) {
+                    return collapse.target;
+                } else if (corner == collapse.sibling) {
+                    return collapse.siblingTarget;
+                } else {
+                    return corner;
+                }
+            };
+
+            // Check every triangle around the moving vertices in the state left by the
+            // collapses already applied in this pass.
+            auto isFlipping = false;
+            auto degenerateCount = size_t { 0 };
+            for (const auto& movingVertex : { collapse.vertex, collapse.sibling }) {
+                if (movingVertex == NO_VERTEX) {
+                    continue;
+                }
+
+                for (auto i = adjacencyOffsets[movingVertex]; i < adjacencyOffsets[movingVertex + 1] && !isFlipping; i++) {
+                    const auto triangle = adjacency[i];
+                    const auto cornersBefore = std::array<uint32_t, 3> {
+                        collapseTargets[result[3 * triangle + 0]],
+                        collapseTargets[result[3 * triangle + 1]],
+                        collapseTargets[result[3 * triangle + 2]],
+                    };
+                    if (isDegenerate(cornersBefore)) {
+                        continue;
+                    }
+
+                    const auto cornersAfter = std::array<uint32_t, 3> {
+                        moveCorner(cornersBefore[0]),
+                        moveCorner(cornersBefore[1]),
+                        moveCorner(cornersBefore[2]),
+                    };
+                    if (isDegenerate(cornersAfter)) {
+                        degenerateCount++;
+                        continue;
+                    }
+
+                    const auto normalBefore = cross(
+                        subtract(vertexPositions[cornersBefore[1]], vertexPositions[cornersBefore[0]]),
+                        subtract(vertexPositions[cornersBefore[2]], vertexPositions[cornersBefore[0]])
+                    );
+                    const auto normalAfter = cross(
+                        subtract(vertexPositions[cornersAfter[1]], vertexPositions[cornersAfter[0]]),
+                        subtract(vertexPositions[cornersAfter[2]], vertexPositions[cornersAfter[0]])
+                    );
+                    isFlipping = dot(normalBefore, normalAfter) < MIN_NORMAL_COSINE * length(normalBefore) * length(normalAfter);
+                }
+            }
+
+            if (isFlipping) {
+                continue;
+            }
+
+            collapseTargets[collapse.vertex] = collapse.target;
+            isCollapseLocked[collapse.vertex] = true;
+            isCollapseLocked[collapse.target] = true;
+            if (hasSibling) {
+                collapseTargets[collapse.sibling] = collapse.siblingTarget;
+                isCollapseLocked[collapse.sibling] = true;
+                isCollapseLocked[collapse.siblingTarget] = true;
+            }
+
+            quadrics[positionIds[collapse.target]] += quadrics[positionIds[collapse.vertex]];
+            removedTriangleCount += degenerateCount;
+            collapseCount++;
+            if (removedTriangleCount >= triangleGoal) {
+                break;
+            }
+        }
+
+        if (collapseCount == 0) {
+            break;
+        }
+
+        auto writeIndex = size_t { 0 };
+        for (size_t i = 0; i < result.size(); i += 3) {
+            const auto corners = std::array<uint32_t, 3> {
+                collapseTargets[result[i + 0]],
+                collapseTargets[result[i + 1]],
+                collapseTargets[result[i + 2]],
+            };
+            if (isDegenerate(corners)) {
+                continue;
+            }
+
+            std::copy(corners.begin(), corners.end(), result.begin() + writeIndex);
+            writeIndex += 3;
+        }
+
+        result.resize(writeIndex);
+        countEdgeTriangles(result);
+    }
+
+    return result;
+}
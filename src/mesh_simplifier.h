@@ -0,0 +1,45 @@
+#ifndef _MESH_SIMPLIFIER_H
+#define _MESH_SIMPLIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief Simplifies indexed triangle lists by quadric error edge collapse.
+///
+/// @note Every collapse moves one vertex onto a neighbour, so the simplified triangles
+/// index the vertices of the original mesh and a whole chain of levels of detail can share
+/// one vertex buffer. Collapses are picked by the quadric error metric of Garland and
+/// Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997, cheapest first,
+/// and collapses that would flip a triangle are rejected.
+///
+/// Vertices on open borders only slide along the border. Vertices on attribute seams, where
+/// two vertices share a position, only slide along the seam, both at once, so that texture
+/// coordinates stay continuous across it. Positions shared by more than two vertices never
+/// move, so meshes with many of them may stop short of the target.
+class MeshSimplifier final {
+    public:
+        explicit MeshSimplifier() = delete;
+
+        /// @brief Simplify `indices` to at most `targetIndexCount` indices where possible.
+        ///
+        /// @note `positions` points to the first position, three floats, and consecutive
+        /// positions are `positionStride` bytes apart.
+        ///
+        /// @returns The simplified triangles, indexing the same vertices as `indices`.
+        static std::vector<uint32_t> simplify(
+            std::span<const uint32_t> indices,
+            const float* positions,
+            uint32_t vertexCount,
+            size_t positionStride,
+            size_t targetIndexCount
+        );
+};
+
+}
+
+#endif // _MESH_SIMPLIFIER_H
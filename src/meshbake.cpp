@@ -0,0 +1,190 @@
+#include "job_system.h"
+#include "mesh_cache.h"
+#include "mesh_importer.h"
+#include "texture_packer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+
+
+using JobSystem = VulkanEngine::JobSystem;
+using MeshCache = VulkanEngine::MeshCache;
+using MeshImporter = VulkanEngine::MeshImporter;
+using MeshImportSettings = VulkanEngine::MeshImportSettings;
+using TexturePackTable = VulkanEngine::TexturePackTable;
+
+// The models baked, by extension, and where the demo reads its mesh cache from.
+const auto MODEL_EXTENSIONS = std::vector<std::string> { ".obj", ".glb" };
+const std::string DEFAULT_CACHE_DIRECTORY = std::string { "cache/meshes" };
+
+struct MeshbakeOptions final {
+    /// @brief The models to bake, and the directories to bake every model under.
+    std::vector<std::filesystem::path> inputPaths;
+    std::filesystem::path cacheDirectory = DEFAULT_CACHE_DIRECTORY;
+    MeshImportSettings settings;
+    /// @brief Whether to bake models whose cache entry is up to date too.
+    bool force = false;
+    /// @brief The table a `texbake --pack` wrote, and the texture in it the models sample.
+    std::optional<std::filesystem::path> packTablePath;
+    std::optional<std::string> texturePath;
+};
+
+/// @brief Read `<model or directory>...`, `--cache <directory>`, `--no-optimize`,
+/// `--no-lods`, `--no-meshlets`, `--pack-table <file> --texture <file>` and `--force` off
+/// the command line.
+///
+/// @note The demo only loads entries baked with the settings it imports with, which are
+/// the defaults. A demo built without `OPTIMIZE_MESH`, `GENERATE_MESH_LODS` or
+/// `USE_MESH_SHADERS` needs the matching `--no-` option. With `--pack-table`, the texture
+/// coordinates of every model are remapped into the layer `--texture` was packed into, as
+/// its source path is spelled on the `texbake` command line, and the entries are keyed by
+/// that placement too.
+static MeshbakeOptions parseMeshbakeOptions(int argc, char* argv[]) {
+    auto options = MeshbakeOptions {};
+    for (int i = 1; i < argc; i++) {
+        const auto argument = std::string { argv[i] };
+        if (argument == "--cache" && i + 1 < argc) {
+            options.cacheDirectory = std::filesystem::path { argv[++i] };
+        } else if (argument == "--pack-table" && i + 1 < argc) {
+            options.packTablePath = std::filesystem::path { argv[++i] };
+        } else if (argument == "--texture" && i + 1 < argc) {
+            options.texturePath = std::string { argv[++i] };
+        } else if (argument == "--no-optimize") {
+            options.settings.optimize = false;
+        } else if (argument == "--no-lods") {
+            options.settings.lodTriangleRatios.clear();
+        } else if (argument == "--no-meshlets") {
+            options.settings.buildMeshlets = false;
+        } else if (argument == "--force") {
+            options.force = true;
+        } else if (!argument.starts_with("--")) {
+            options.inputPaths.push_back(std::filesystem::path { argument });
+        } else {
+            throw std::invalid_argument(fmt::format("unknown command line argument: {}", argument));
+        }
+    }
+
+    if (options.inputPaths.empty()) {
+        throw std::invalid_argument("usage: meshbake <model or directory>... [--cache <directory>] [--no-optimize] [--no-lods] [--no-meshlets] [--pack-table <file> --texture <file>] [--force]");
+    }
+
+    if (options.packTablePath.has_value() != options.texturePath.has_value()) {
+        throw std::invalid_argument("--pack-table and --texture are given together");
+    }
+
+    if (options.packTablePath.has_value()) {
+        const auto table = TexturePackTable::load(*options.packTablePath);
+        options.settings.texturePlacement = table.find(*options.texturePath);
+        if (!options.settings.texturePlacement.has_value()) {
+            throw std::invalid_argument(fmt::format("{} was not packed into {}", *options.texturePath, options.packTablePath->string()));
+        }
+    }
+
+    return options;
+}
+
+static bool isModel(const std::filesystem::path& filePath) {
+    const auto extension = filePath.extension().string();
+
+    return std::find(MODEL_EXTENSIONS.begin(), MODEL_EXTENSIONS.end(), extension) != MODEL_EXTENSIONS.end();
+}
+
+/// @brief The models named on the command line, and the ones under the directories named
+/// there, in path order.
+///
+/// @note Cache entries are keyed by the path of their model as it is spelled, so the paths
+/// are kept as given, and the demo finds the entries when it runs from the same directory
+/// with the same paths.
+static std::vector<std::filesystem::path> findModels(const MeshbakeOptions& options) {
+    auto models = std::vector<std::filesystem::path> {};
+    for (const auto& inputPath : options.inputPaths) {
+        if (!std::filesystem::is_directory(inputPath)) {
+            models.push_back(inputPath);
+            continue;
+        }
+
+        auto directoryModels = std::vector<std::filesystem::path> {};
+        for (const auto& entry : std::filesystem::recursive_directory_iterator { inputPath }) {
+            if (entry.is_regular_file() && isModel(entry.path())) {
+                directoryModels.push_back(entry.path());
+            }
+        }
+
+        std::sort(directoryModels.begin(), directoryModels.end());
+        models.insert(models.end(), directoryModels.begin(), directoryModels.end());
+    }
+
+    return models;
+}
+
+int main(int argc, char* argv[]) {
+    auto options = MeshbakeOptions {};
+    try {
+        options = parseMeshbakeOptions(argc, argv);
+    } catch (const std::exception& exception) {
+        fmt::println(std::cerr, "{}", exception.what());
+        return EXIT_FAILURE;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto meshCache = MeshCache { options.cacheDirectory };
+    const auto models = findModels(options);
+
+    // The models are baked one after another, each of them split across every core by the
+    // loaders, which keeps the log of every model in one piece.
+    auto jobSystem = JobSystem { std::max(std::thread::hardware_concurrency(), 1u) };
+    auto bakedCount = uint32_t { 0 };
+    auto skippedCount = uint32_t { 0 };
+    auto failedCount = uint32_t { 0 };
+    for (const auto& model : models) {
+        const auto modelPath = model.generic_string();
+        try {
+            if (!options.force && MeshImporter::loadCached(meshCache, modelPath, options.settings).has_value()) {
+                skippedCount++;
+                continue;
+            }
+
+            fmt::println("{}", modelPath);
+            const auto mesh = MeshImporter::import(modelPath, options.settings, &jobSystem);
+            MeshImporter::storeCached(meshCache, modelPath, options.settings, mesh);
+            bakedCount++;
+
+            fmt::println(
+                "{}: {} vertices, {} triangles, {} levels of detail, {} meshlets",
+                modelPath,
+                mesh.vertices().size(),
+                mesh.lods().front().indexCount / 3,
+                mesh.lods().size(),
+                mesh.meshlets().meshlets.size()
+            );
+        } catch (const std::exception& exception) {
+            failedCount++;
+            fmt::println(std::cerr, "{}: {}", modelPath, exception.what());
+        }
+    }
+
+    const auto seconds = std::chrono::duration<double> { std::chrono::steady_clock::now() - start }.count();
+    fmt::println(
+        "baked {} meshes into {}, skipped {} up to date, {} failed, in {:.2f} s",
+        bakedCount,
+        options.cacheDirectory.string(),
+        skippedCount,
+        failedCount,
+        seconds
+    );
+
+    return failedCount > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,358 @@
+#include "meshlet_builder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+
+using MeshletBuilder = VulkanEngine::MeshletBuilder;
+using MeshletData = VulkanEngine::MeshletData;
+using Meshlet = VulkanEngine::Meshlet;
+using MeshletBounds = VulkanEngine::MeshletBounds;
+
+using Vector3 = std::array<double, 3>;
+
+static double dot(const Vector3& left, const Vector3& right) {
+    return left[0] * right[0] + left[1] * right[1] + left[2] * right[2];
+}
+
+static double length(const Vector3& vector) {
+    return std::sqrt(dot(vector, vector));
+}
+
+// Triangles facing more than about 84 degrees away from the average never let a cone cull
+// anything useful, so such meshlets get no cone at all.
+static constexpr double MIN_CONE_NORMAL_COSINE = 0.1;
+
+// How many of the triangles not yet in a meshlet are searched for the nearest one when a
+// meshlet runs out of neighbours. Bounding the search keeps meshes made of many small
+// pieces linear in their size.
+static constexpr uint32_t SEED_SEARCH_WINDOW = 256;
+
+// Only pieces facing about the same way as a meshlet join it, so that its cone stays narrow.
+static constexpr double MIN_MERGE_NORMAL_COSINE = 0.7;
+
+static MeshletBounds computeBounds(
+    std::span<const uint32_t> meshletVertices,
+    std::span<const uint32_t> meshletTriangles,
+    std::span<const uint32_t> indices,
+    std::span<const Vector3> positions,
+    std::span<const Vector3> normals
+) {
+    // The sphere is centered on the bounding box, which keeps it tight for the compact,
+    // mostly flat clusters meshlets are built as.
+    auto boundsMin = positions[meshletVertices[0]];
+    auto boundsMax = positions[meshletVertices[0]];
+    for (const auto& vertex : meshletVertices) {
+        for (uint32_t axis = 0; axis < 3; axis++) {
+            boundsMin[axis] = std::min(boundsMin[axis], positions[vertex][axis]);
+            boundsMax[axis] = std::max(boundsMax[axis], positions[vertex][axis]);
+        }
+    }
+
+    const auto center = Vector3 {
+        (boundsMin[0] + boundsMax[0]) / 2.0,
+        (boundsMin[1] + boundsMax[1]) / 2.0,
+        (boundsMin[2] + boundsMax[2]) / 2.0,
+    };
+    auto radius = 0.0;
+    for (const auto& vertex : meshletVertices) {
+        const auto& position = positions[vertex];
+        const auto offset = Vector3 { position[0] - center[0], position[1] - center[1], position[2] - center[2] };
+        radius = std::max(radius, length(offset));
+    }
+
+    auto bounds = MeshletBounds {
+        .center = { static_cast<float>(center[0]), static_cast<float>(center[1]), static_cast<float>(center[2]) },
+        .radius = static_cast<float>(radius),
+        .coneApex = { 0.0f, 0.0f, 0.0f },
+        .coneAxis = { 0.0f, 0.0f, 0.0f },
+        .coneCutoff = 1.0f,
+    };
+
+    auto normalSum = Vector3 { 0.0, 0.0, 0.0 };
+    for (const auto& triangle : meshletTriangles) {
+        for (uint32_t axis = 0; axis < 3; axis++) {
+            normalSum[axis] += normals[triangle][axis];
+        }
+    }
+
+    const auto normalSumLength = length(normalSum);
+    if (normalSumLength == 0.0) {
+        return bounds;
+    }
+
+    const auto axis = Vector3 { normalSum[0] / normalSumLength, normalSum[1] / normalSumLength, normalSum[2] / normalSumLength };
+    auto minNormalCosine = 1.0;
+    for (const auto& triangle : meshletTriangles) {
+        if (length(normals[triangle]) > 0.0) {
+            minNormalCosine = std::min(minNormalCosine, dot(normals[triangle], axis));
+        }
+    }
+
+    if (minNormalCosine <= MIN_CONE_NORMAL_COSINE) {
+        return bounds;
+    }
+
+    // Move the apex back along the axis until it is behind the plane of every triangle,
+    // so that a camera in front of any triangle sees the apex at an angle inside the cone.
+    auto apexDistance = 0.0;
+    for (const auto& triangle : meshletTriangles) {
+        const auto& normal = normals[triangle];
+        if (length(normal) == 0.0) {
+            continue;
+        }
+
+        const auto& corner = positions[indices[3 * triangle]];
+        const auto offset = Vector3 { center[0] - corner[0], center[1] - corner[1], center[2] - corner[2] };
+        apexDistance = std::max(apexDistance, dot(offset, normal) / dot(axis, normal));
+    }
+
+    for (uint32_t i = 0; i < 3; i++) {
+        bounds.coneApex[i] = static_cast<float>(center[i] - axis[i] * apexDistance);
+        bounds.coneAxis[i] = static_cast<float>(axis[i]);
+    }
+    bounds.coneCutoff = static_cast<float>(std::sqrt(1.0 - minNormalCosine * minNormalCosine));
+
+    return bounds;
+}
+
+MeshletData MeshletBuilder::build(
+    std::span<const uint32_t> indices,
+    const float* positions,
+    uint32_t vertexCount,
+    size_t positionStride,
+    uint32_t maxVertices,
+    uint32_t maxTriangles
+) {
+    if (indices.size() % 3 != 0) {
+        throw std::invalid_argument("mesh indices must form whole triangles!");
+    }
+
+    for (const auto& index : indices) {
+        if (index >= vertexCount) {
+            throw std::invalid_argument("mesh index out of range!");
+        }
+    }
+
+    // Meshlet triangles index their vertices with one byte.
+    if (maxVertices < 3 || maxVertices > 256 || maxTriangles == 0) {
+        throw std::invalid_argument("meshlets need between 3 and 256 vertices and at least one triangle!");
+    }
+
+    const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+    auto vertexPositions = std::vector<Vector3>(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        const auto* position = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + i * positionStride);
+        vertexPositions[i] = Vector3 { position[0], position[1], position[2] };
+    }
+
+    // Unit normals, left at zero for degenerate triangles.
+    auto triangleNormals = std::vector<Vector3>(triangleCount);
+    auto triangleCentroids = std::vector<Vector3>(triangleCount);
+    for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+        const auto& p0 = vertexPositions[indices[3 * triangle + 0]];
+        const auto& p1 = vertexPositions[indices[3 * triangle + 1]];
+        const auto& p2 = vertexPositions[indices[3 * triangle + 2]];
+        const auto e1 = Vector3 { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        const auto e2 = Vector3 { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        const auto normal = Vector3 {
+            e1[1] * e2[2] - e1[2] * e2[1],
+            e1[2] * e2[0] - e1[0] * e2[2],
+            e1[0] * e2[1] - e1[1] * e2[0],
+        };
+        triangleCentroids[triangle] = Vector3 {
+            (p0[0] + p1[0] + p2[0]) / 3.0,
+            (p0[1] + p1[1] + p2[1]) / 3.0,
+            (p0[2] + p1[2] + p2[2]) / 3.0,
+        };
+
+        const auto area = length(normal);
+        if (area > 0.0) {
+            triangleNormals[triangle] = Vector3 { normal[0] / area, normal[1] / area, normal[2] / area };
+        } else {
+            triangleNormals[triangle] = Vector3 { 0.0, 0.0, 0.0 };
+        }
+    }
+
+    // Vertices split along attribute seams share a position, and triangles across a seam
+    // are still neighbours, so adjacency is built over the first vertex at every position.
+    auto positionOrder = std::vector<uint32_t>(vertexCount);
+    std::iota(positionOrder.begin(), positionOrder.end(), 0);
+    std::stable_sort(positionOrder.begin(), positionOrder.end(), [&vertexPositions](uint32_t left, uint32_t right) {
+        return vertexPositions[left] < vertexPositions[right];
+    });
+
+    auto positionVertices = std::vector<uint32_t>(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        const auto vertex = positionOrder[i];
+        if (i > 0 && vertexPositions[vertex] == vertexPositions[positionOrder[i - 1]]) {
+            positionVertices[vertex] = positionVertices[positionOrder[i - 1]];
+        } else {
+            positionVertices[vertex] = vertex;
+        }
+    }
+
+    // The triangles around every position, in compressed sparse rows.
+    auto adjacencyOffsets = std::vector<uint32_t>(vertexCount + 1, 0);
+    for (const auto& index : indices) {
+        adjacencyOffsets[positionVertices[index] + 1]++;
+    }
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+    }
+
+    auto adjacentTriangles = std::vector<uint32_t>(indices.size());
+    auto adjacencyFill = std::vector<uint32_t>(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            adjacentTriangles[adjacencyFill[positionVertices[indices[3 * triangle + corner]]]++] = triangle;
+        }
+    }
+
+    constexpr auto NO_LOCAL_INDEX = std::numeric_limits<uint32_t>::max();
+    constexpr auto NO_TRIANGLE = std::numeric_limits<uint32_t>::max();
+
+    auto isEmitted = std::vector<bool>(triangleCount, false);
+    auto localIndices = std::vector<uint32_t>(vertexCount, NO_LOCAL_INDEX);
+    auto meshletVertices = std::vector<uint32_t> {};
+    auto meshletTriangles = std::vector<uint32_t> {};
+    auto meshletNormal = Vector3 { 0.0, 0.0, 0.0 };
+    auto meshletCentroidSum = Vector3 { 0.0, 0.0, 0.0 };
+    auto meshletData = MeshletData {};
+
+    const auto finishMeshlet = [&]() {
+        if (meshletTriangles.empty()) {
+            return;
+        }
+
+        const auto meshlet = Meshlet {
+            .vertexOffset = static_cast<uint32_t>(meshletData.vertices.size()),
+            .triangleOffset = static_cast<uint32_t>(meshletData.triangles.size()),
+            .vertexCount = static_cast<uint32_t>(meshletVertices.size()),
+            .triangleCount = static_cast<uint32_t>(meshletTriangles.size()),
+        };
+
+        meshletData.vertices.insert(meshletData.vertices.end(), meshletVertices.begin(), meshletVertices.end());
+        for (const auto& triangle : meshletTriangles) {
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                meshletData.triangles.push_back(static_cast<uint8_t>(localIndices[indices[3 * triangle + corner]]));
+            }
+        }
+        while (meshletData.triangles.size() % 4 != 0) {
+            meshletData.triangles.push_back(0);
+        }
+
+        meshletData.meshlets.push_back(meshlet);
+        meshletData.bounds.push_back(computeBounds(meshletVertices, meshletTriangles, indices, vertexPositions, triangleNormals));
+
+        for (const auto& vertex : meshletVertices) {
+            localIndices[vertex] = NO_LOCAL_INDEX;
+        }
+        meshletVertices.clear();
+        meshletTriangles.clear();
+        meshletNormal = Vector3 { 0.0, 0.0, 0.0 };
+        meshletCentroidSum = Vector3 { 0.0, 0.0, 0.0 };
+    };
+
+    auto seedCursor = uint32_t { 0 };
+    while (true) {
+        auto bestTriangle = NO_TRIANGLE;
+        auto bestNewVertexCount = uint32_t { 4 };
+        auto bestAlignment = -std::numeric_limits<double>::infinity();
+        for (const auto& vertex : meshletVertices) {
+            const auto positionVertex = positionVertices[vertex];
+            for (auto i = adjacencyOffsets[positionVertex]; i < adjacencyOffsets[positionVertex + 1]; i++) {
+                const auto triangle = adjacentTriangles[i];
+                if (isEmitted[triangle]) {
+                    continue;
+                }
+
+                auto newVertexCount = uint32_t { 0 };
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    newVertexCount += (localIndices[indices[3 * triangle + corner]] == NO_LOCAL_INDEX) ? 1 : 0;
+                }
+
+                const auto alignment = dot(triangleNormals[triangle], meshletNormal);
+                if (newVertexCount < bestNewVertexCount || (newVertexCount == bestNewVertexCount && alignment > bestAlignment)) {
+                    bestTriangle = triangle;
+                    bestNewVertexCount = newVertexCount;
+                    bestAlignment = alignment;
+                }
+            }
+        }
+
+        while (seedCursor < triangleCount && isEmitted[seedCursor]) {
+            seedCursor++;
+        }
+
+        // Once the meshlet has used up its piece of the mesh, continue with the nearest
+        // piece that is about to be seeded, rather than leave the meshlet small.
+        if (bestTriangle == NO_TRIANGLE && !meshletTriangles.empty()) {
+            const auto meshletCenter = Vector3 {
+                meshletCentroidSum[0] / meshletTriangles.size(),
+                meshletCentroidSum[1] / meshletTriangles.size(),
+                meshletCentroidSum[2] / meshletTriangles.size(),
+            };
+            auto bestDistance = std::numeric_limits<double>::infinity();
+            auto searchedCount = uint32_t { 0 };
+            for (auto triangle = seedCursor; triangle < triangleCount && searchedCount < SEED_SEARCH_WINDOW; triangle++) {
+                if (isEmitted[triangle]) {
+                    continue;
+                }
+
+                searchedCount++;
+                if (dot(triangleNormals[triangle], meshletNormal) < MIN_MERGE_NORMAL_COSINE * length(meshletNormal)) {
+                    continue;
+                }
+
+                const auto& centroid = triangleCentroids[triangle];
+                const auto offset = Vector3 { centroid[0] - meshletCenter[0], centroid[1] - meshletCenter[1], centroid[2] - meshletCenter[2] };
+                const auto distance = dot(offset, offset);
+                if (distance < bestDistance) {
+                    bestTriangle = triangle;
+                    bestDistance = distance;
+                }
+            }
+
+            if (bestTriangle != NO_TRIANGLE) {
+                bestNewVertexCount = 0;
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    bestNewVertexCount += (localIndices[indices[3 * bestTriangle + corner]] == NO_LOCAL_INDEX) ? 1 : 0;
+                }
+            }
+        }
+
+        const auto fits = (bestTriangle != NO_TRIANGLE) &&
+            (meshletVertices.size() + bestNewVertexCount <= maxVertices) &&
+            (meshletTriangles.size() < maxTriangles);
+        if (!fits) {
+            finishMeshlet();
+
+            if (seedCursor == triangleCount) {
+                break;
+            }
+
+            bestTriangle = seedCursor;
+        }
+
+        isEmitted[bestTriangle] = true;
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            const auto vertex = indices[3 * bestTriangle + corner];
+            if (localIndices[vertex] == NO_LOCAL_INDEX) {
+                localIndices[vertex] = static_cast<uint32_t>(meshletVertices.size());
+                meshletVertices.push_back(vertex);
+            }
+        }
+        for (uint32_t axis = 0; axis < 3; axis++) {
+            meshletNormal[axis] += triangleNormals[bestTriangle][axis];
+            meshletCentroidSum[axis] += triangleCentroids[bestTriangle][axis];
+        }
+        meshletTriangles.push_back(bestTriangle);
+    }
+
+    return meshletData;
+}
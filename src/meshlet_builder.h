@@ -0,0 +1,85 @@
+#ifndef _MESHLET_BUILDER_H
+#define _MESHLET_BUILDER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief A cluster of triangles drawn by one mesh shader workgroup.
+///
+/// @note A meshlet lists its own vertices, as indices into the vertex buffer, starting at
+/// `vertexOffset` in `MeshletData::vertices`. Its triangles index that list with one byte
+/// per corner, starting at byte `triangleOffset` of `MeshletData::triangles`.
+struct Meshlet final {
+    uint32_t vertexOffset = 0;
+    uint32_t triangleOffset = 0;
+    uint32_t vertexCount = 0;
+    uint32_t triangleCount = 0;
+};
+
+/// @brief The bounds a task shader culls a meshlet by.
+///
+/// @note The meshlet faces away from a camera at `cameraPosition`, and can be culled, when
+/// `dot(normalize(coneApex - cameraPosition), coneAxis) >= coneCutoff`. Meshlets whose
+/// triangles face too many ways for a cone have a cutoff of 1, and are never culled by it.
+struct MeshletBounds final {
+    std::array<float, 3> center = { 0.0f, 0.0f, 0.0f };
+    float radius = 0.0f;
+    std::array<float, 3> coneApex = { 0.0f, 0.0f, 0.0f };
+    std::array<float, 3> coneAxis = { 0.0f, 0.0f, 0.0f };
+    float coneCutoff = 1.0f;
+};
+
+struct MeshletData final {
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> bounds;
+    std::vector<uint32_t> vertices;
+    std::vector<uint8_t> triangles;
+};
+
+/// @brief Partitions indexed triangle lists into meshlets for mesh shaders.
+///
+/// @note Meshlets are grown greedily from a seed triangle. The next triangle is always
+/// the neighbour of the meshlet that adds the fewest new vertices, and of those the one
+/// that faces most like the meshlet does, so meshlets stay connected and their normal
+/// cones narrow. Triangles are neighbours when they share a position, even across
+/// attribute seams. A meshlet that runs out of neighbours continues with the nearest
+/// triangle facing its way instead, because meshes built from many small pieces would
+/// otherwise end up with many small meshlets. It is closed when the next triangle does not
+/// fit, and the next one is seeded with the first triangle not yet in a meshlet, so a
+/// cache-optimized index order keeps consecutive meshlets close together.
+///
+/// The triangles of every meshlet are padded to a multiple of four bytes, so a shader can
+/// read them as 32-bit words.
+class MeshletBuilder final {
+    public:
+        /// @brief The default limits, which fit the preferred output sizes of most mesh
+        /// shader implementations.
+        static constexpr uint32_t MAX_VERTICES = 64;
+        static constexpr uint32_t MAX_TRIANGLES = 124;
+
+        explicit MeshletBuilder() = delete;
+
+        /// @brief Partition `indices` into meshlets of at most `maxVertices` vertices and
+        /// `maxTriangles` triangles.
+        ///
+        /// @note `positions` points to the first position, three floats, and consecutive
+        /// positions are `positionStride` bytes apart.
+        static MeshletData build(
+            std::span<const uint32_t> indices,
+            const float* positions,
+            uint32_t vertexCount,
+            size_t positionStride,
+            uint32_t maxVertices = MAX_VERTICES,
+            uint32_t maxTriangles = MAX_TRIANGLES
+        );
+};
+
+}
+
+#endif // _MESHLET_BUILDER_H
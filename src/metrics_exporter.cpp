@@ -0,0 +1,348 @@
+#include "metrics_exporter.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+
+using MetricsExporter = VulkanEngine::MetricsExporter;
+using MetricsEndpoint = VulkanEngine::MetricsEndpoint;
+using MetricsTransport = VulkanEngine::MetricsTransport;
+using MetricsGauge = VulkanEngine::MetricsGauge;
+
+#if defined(_WIN32)
+using NativeSocket = SOCKET;
+
+static constexpr auto INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+
+static void closeSocket(NativeSocket socketHandle) {
+    closesocket(socketHandle);
+}
+
+static int pollSocket(NativeSocket socketHandle, int timeoutMilliseconds) {
+    auto descriptor = WSAPOLLFD { .fd = socketHandle, .events = POLLRDNORM, .revents = 0 };
+
+    return WSAPoll(&descriptor, 1, timeoutMilliseconds);
+}
+#else
+using NativeSocket = int;
+
+static constexpr auto INVALID_SOCKET_HANDLE = -1;
+
+static void closeSocket(NativeSocket socketHandle) {
+    close(socketHandle);
+}
+
+static int pollSocket(NativeSocket socketHandle, int timeoutMilliseconds) {
+    auto descriptor = pollfd { .fd = socketHandle, .events = POLLIN, .revents = 0 };
+
+    return poll(&descriptor, 1, timeoutMilliseconds);
+}
+#endif
+
+// A peer that goes away mid-send would otherwise raise `SIGPIPE` and end the process.
+#if defined(MSG_NOSIGNAL)
+static constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static constexpr int SEND_FLAGS = 0;
+#endif
+
+// How long a scraper that has connected gets to send its request, in milliseconds.
+static constexpr int REQUEST_TIMEOUT_MILLISECONDS = 1000;
+
+static constexpr std::array<double, 3> STATSD_PERCENTILES = { 0.5, 0.9, 0.99 };
+
+static bool sendAll(NativeSocket socketHandle, std::string_view data) {
+    while (!data.empty()) {
+        const auto sentSize = send(socketHandle, data.data(), static_cast<int>(data.size()), SEND_FLAGS);
+        if (sentSize <= 0) {
+            return false;
+        }
+
+        data.remove_prefix(static_cast<size_t>(sentSize));
+    }
+
+    return true;
+}
+
+// The frame time under which `percentile` of the frames of `bucketCounts` fall, taking the
+// frames of a bucket to be spread evenly over it. The frames past the last bound are all
+// taken to be at it.
+static double estimatePercentile(std::span<const uint64_t> bucketCounts, uint64_t frameCount, double percentile) {
+    const auto target = percentile * static_cast<double>(frameCount);
+    auto cumulativeCount = uint64_t { 0 };
+    for (size_t i = 0; i < bucketCounts.size(); i++) {
+        const auto lowerBound = i == 0 ? 0.0 : MetricsExporter::FRAME_TIME_BUCKETS[i - 1];
+        if (i == MetricsExporter::FRAME_TIME_BUCKETS.size()) {
+            return lowerBound;
+        }
+
+        const auto upperBound = MetricsExporter::FRAME_TIME_BUCKETS[i];
+        if (bucketCounts[i] > 0 && static_cast<double>(cumulativeCount + bucketCounts[i]) >= target) {
+            const auto fraction = (target - static_cast<double>(cumulativeCount)) / static_cast<double>(bucketCounts[i]);
+
+            return lowerBound + std::clamp(fraction, 0.0, 1.0) * (upperBound - lowerBound);
+        }
+
+        cumulativeCount += bucketCounts[i];
+    }
+
+    return MetricsExporter::FRAME_TIME_BUCKETS.back();
+}
+
+MetricsExporter::MetricsExporter(
+    const MetricsEndpoint& endpoint,
+    const std::string& metricPrefix,
+    double droppedFrameMilliseconds,
+    std::chrono::milliseconds statsdInterval
+)
+    : m_endpoint { endpoint }
+    , m_metricPrefix { metricPrefix }
+    , m_droppedFrameMilliseconds { droppedFrameMilliseconds }
+    , m_statsdInterval { statsdInterval }
+    , m_frameTimeBuckets {}
+    , m_frameTimeSum { 0.0 }
+    , m_droppedFrameCount { 0 }
+    , m_gauges {}
+    , m_socket { INVALID_SOCKET_HANDLE }
+    , m_isStopping { false }
+{
+#if defined(_WIN32)
+    auto wsaData = WSADATA {};
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        throw std::runtime_error("failed to initialize Winsock!");
+    }
+#endif
+
+    const auto isPrometheus = m_endpoint.transport == MetricsTransport::Prometheus;
+    // The fields of `addrinfo` are in another order on Windows, so they are not designated.
+    auto hints = addrinfo {};
+    hints.ai_flags = isPrometheus ? AI_PASSIVE : 0;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = isPrometheus ? SOCK_STREAM : SOCK_DGRAM;
+    const auto port = std::to_string(m_endpoint.port);
+    auto* addresses = static_cast<addrinfo*>(nullptr);
+    const auto host = m_endpoint.host.empty() ? nullptr : m_endpoint.host.c_str();
+    if (getaddrinfo(host, port.c_str(), &hints, &addresses) != 0) {
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+        throw std::runtime_error(fmt::format("failed to resolve metrics endpoint {}:{}!", m_endpoint.host, m_endpoint.port));
+    }
+
+    // A Prometheus endpoint listens on the first address it can bind, and a statsd socket
+    // is connected to the first address it can reach, so that every datagram goes there.
+    for (auto* address = addresses; address != nullptr && m_socket == INVALID_SOCKET_HANDLE; address = address->ai_next) {
+        const auto socketHandle = static_cast<SocketHandle>(socket(address->ai_family, address->ai_socktype, address->ai_protocol));
+        if (socketHandle == INVALID_SOCKET_HANDLE) {
+            continue;
+        }
+
+        if (isPrometheus) {
+            const auto reuseAddress = 1;
+            setsockopt(socketHandle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuseAddress), sizeof(reuseAddress));
+            if (bind(socketHandle, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0 && listen(socketHandle, SOMAXCONN) == 0) {
+                m_socket = socketHandle;
+            }
+        } else if (connect(socketHandle, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0) {
+            m_socket = socketHandle;
+        }
+
+        if (m_socket != socketHandle) {
+            closeSocket(socketHandle);
+        }
+    }
+    freeaddrinfo(addresses);
+
+    if (m_socket == INVALID_SOCKET_HANDLE) {
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+        throw std::runtime_error(fmt::format("failed to open metrics socket on {}:{}!", m_endpoint.host, m_endpoint.port));
+    }
+
+    m_thread = std::thread { [this, isPrometheus]() {
+        if (isPrometheus) {
+            this->servePrometheus();
+        } else {
+            this->sendStatsd();
+        }
+    } };
+}
+
+MetricsExporter::~MetricsExporter() {
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        m_isStopping = true;
+    }
+    m_stopRequested.notify_one();
+    m_thread.join();
+
+    closeSocket(m_socket);
+    m_socket = INVALID_SOCKET_HANDLE;
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+void MetricsExporter::recordFrame(double milliseconds) {
+    const auto bucket = static_cast<size_t>(
+        std::ranges::lower_bound(FRAME_TIME_BUCKETS, milliseconds) - FRAME_TIME_BUCKETS.begin()
+    );
+    m_frameTimeBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    // Only one thread records frames, so the sum needs no read-modify-write of its own.
+    m_frameTimeSum.store(m_frameTimeSum.load(std::memory_order_relaxed) + milliseconds, std::memory_order_relaxed);
+    if (milliseconds > m_droppedFrameMilliseconds) {
+        m_droppedFrameCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MetricsExporter::setGauge(MetricsGauge gauge, double value) {
+    m_gauges[static_cast<size_t>(gauge)].store(value, std::memory_order_relaxed);
+}
+
+MetricsExporter::BucketCounts MetricsExporter::loadBucketCounts() const {
+    auto bucketCounts = BucketCounts {};
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        bucketCounts[i] = m_frameTimeBuckets[i].load(std::memory_order_relaxed);
+    }
+
+    return bucketCounts;
+}
+
+std::string MetricsExporter::formatPrometheus() const {
+    const auto bucketCounts = this->loadBucketCounts();
+    auto text = std::string {};
+    text += fmt::format("# HELP {}_frame_time_milliseconds The time of every frame on the CPU.\n", m_metricPrefix);
+    text += fmt::format("# TYPE {}_frame_time_milliseconds histogram\n", m_metricPrefix);
+    auto cumulativeCount = uint64_t { 0 };
+    for (size_t i = 0; i < FRAME_TIME_BUCKETS.size(); i++) {
+        cumulativeCount += bucketCounts[i];
+        text += fmt::format("{}_frame_time_milliseconds_bucket{{le=\"{}\"}} {}\n", m_metricPrefix, FRAME_TIME_BUCKETS[i], cumulativeCount);
+    }
+    cumulativeCount += bucketCounts.back();
+    text += fmt::format("{}_frame_time_milliseconds_bucket{{le=\"+Inf\"}} {}\n", m_metricPrefix, cumulativeCount);
+    text += fmt::format("{}_frame_time_milliseconds_sum {}\n", m_metricPrefix, m_frameTimeSum.load(std::memory_order_relaxed));
+    text += fmt::format("{}_frame_time_milliseconds_count {}\n", m_metricPrefix, cumulativeCount);
+
+    text += fmt::format("# HELP {}_dropped_frames_total The frames slower than the dropped frame threshold.\n", m_metricPrefix);
+    text += fmt::format("# TYPE {}_dropped_frames_total counter\n", m_metricPrefix);
+    text += fmt::format("{}_dropped_frames_total {}\n", m_metricPrefix, m_droppedFrameCount.load(std::memory_order_relaxed));
+
+    const auto gauges = std::array<std::tuple<MetricsGauge, std::string_view, std::string_view>, 3> {
+        std::make_tuple(MetricsGauge::DeviceMemoryUsageBytes, "device_memory_usage_bytes", "The device local memory in use."),
+        std::make_tuple(MetricsGauge::DeviceMemoryBudgetBytes, "device_memory_budget_bytes", "The device local memory the process can use."),
+        std::make_tuple(MetricsGauge::StreamingBacklog, "streaming_backlog", "The assets waiting to be streamed in."),
+    };
+    for (const auto& [gauge, name, help] : gauges) {
+        text += fmt::format("# HELP {}_{} {}\n", m_metricPrefix, name, help);
+        text += fmt::format("# TYPE {}_{} gauge\n", m_metricPrefix, name);
+        text += fmt::format("{}_{} {}\n", m_metricPrefix, name, m_gauges[static_cast<size_t>(gauge)].load(std::memory_order_relaxed));
+    }
+
+    return text;
+}
+
+std::string MetricsExporter::formatStatsd(const BucketCounts& bucketCounts, const BucketCounts& lastBucketCounts, uint64_t droppedFrameCount) const {
+    auto intervalCounts = BucketCounts {};
+    auto frameCount = uint64_t { 0 };
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        intervalCounts[i] = bucketCounts[i] - lastBucketCounts[i];
+        frameCount += intervalCounts[i];
+    }
+
+    auto text = std::string {};
+    if (frameCount > 0) {
+        for (const auto percentile : STATSD_PERCENTILES) {
+            text += fmt::format(
+                "{}.frame_time_milliseconds.p{}:{:.3f}|g\n",
+                m_metricPrefix,
+                static_cast<uint32_t>(percentile * 100.0),
+                estimatePercentile(intervalCounts, frameCount, percentile)
+            );
+        }
+    }
+    text += fmt::format("{}.frames:{}|c\n", m_metricPrefix, frameCount);
+    text += fmt::format("{}.dropped_frames:{}|c\n", m_metricPrefix, droppedFrameCount);
+    text += fmt::format("{}.device_memory_usage_bytes:{}|g\n", m_metricPrefix, m_gauges[static_cast<size_t>(MetricsGauge::DeviceMemoryUsageBytes)].load(std::memory_order_relaxed));
+    text += fmt::format("{}.device_memory_budget_bytes:{}|g\n", m_metricPrefix, m_gauges[static_cast<size_t>(MetricsGauge::DeviceMemoryBudgetBytes)].load(std::memory_order_relaxed));
+    text += fmt::format("{}.streaming_backlog:{}|g", m_metricPrefix, m_gauges[static_cast<size_t>(MetricsGauge::StreamingBacklog)].load(std::memory_order_relaxed));
+
+    return text;
+}
+
+void MetricsExporter::servePrometheus() {
+    while (true) {
+        {
+            const auto lock = std::lock_guard<std::mutex> { m_mutex };
+            if (m_isStopping) {
+                return;
+            }
+        }
+
+        if (pollSocket(m_socket, ACCEPT_POLL_MILLISECONDS) <= 0) {
+            continue;
+        }
+
+        const auto client = static_cast<SocketHandle>(accept(m_socket, nullptr, nullptr));
+        if (client == INVALID_SOCKET_HANDLE) {
+            continue;
+        }
+
+        // Whatever the scraper asks for, it gets the metrics. The request is read so that
+        // closing the connection does not reset it before the response arrives.
+        if (pollSocket(client, REQUEST_TIMEOUT_MILLISECONDS) > 0) {
+            auto request = std::array<char, 1024> {};
+            if (recv(client, request.data(), static_cast<int>(request.size()), 0) > 0) {
+                const auto body = this->formatPrometheus();
+                const auto header = fmt::format(
+                    "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: {}\r\nConnection: close\r\n\r\n",
+                    body.size()
+                );
+                if (sendAll(client, header)) {
+                    sendAll(client, body);
+                }
+            }
+        }
+        closeSocket(client);
+    }
+}
+
+void MetricsExporter::sendStatsd() {
+    auto lastBucketCounts = BucketCounts {};
+    auto lastDroppedFrameCount = uint64_t { 0 };
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+    while (!m_stopRequested.wait_for(lock, m_statsdInterval, [this]() { return m_isStopping; })) {
+        lock.unlock();
+        const auto bucketCounts = this->loadBucketCounts();
+        const auto droppedFrameCount = m_droppedFrameCount.load(std::memory_order_relaxed);
+        const auto datagram = this->formatStatsd(bucketCounts, lastBucketCounts, droppedFrameCount - lastDroppedFrameCount);
+        // A datagram that does not go out is dropped, and its frames are counted in the next.
+        if (send(m_socket, datagram.data(), static_cast<int>(datagram.size()), SEND_FLAGS) >= 0) {
+            lastBucketCounts = bucketCounts;
+            lastDroppedFrameCount = droppedFrameCount;
+        }
+        lock.lock();
+    }
+}
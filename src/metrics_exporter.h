@@ -0,0 +1,126 @@
+#ifndef _METRICS_EXPORTER_H
+#define _METRICS_EXPORTER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+namespace VulkanEngine {
+
+/// @brief How a `MetricsExporter` hands its metrics out.
+enum class MetricsTransport {
+    /// @brief A Prometheus text endpoint that scrapers connect to over HTTP.
+    Prometheus,
+    /// @brief Datagrams pushed to a statsd server over UDP.
+    Statsd
+};
+
+/// @brief Where a `MetricsExporter` listens for scrapes, or where it sends its datagrams.
+///
+/// @note A Prometheus endpoint listens on every interface when the host is empty.
+struct MetricsEndpoint final {
+    MetricsTransport transport = MetricsTransport::Prometheus;
+    std::string host;
+    uint16_t port = 0;
+};
+
+/// @brief A value the frame loop sets, that a `MetricsExporter` reports as it was last set.
+enum class MetricsGauge {
+    DeviceMemoryUsageBytes,
+    DeviceMemoryBudgetBytes,
+    /// @brief The assets waiting to be streamed in.
+    StreamingBacklog,
+    Count
+};
+
+/// @brief Aggregates the frame loop's instrumentation into fixed-size histograms and values,
+/// and exports them from a background thread for a monitoring system to collect.
+///
+/// @note Recording a frame or setting a gauge only writes atomics, so the frame loop never
+/// takes a lock, never allocates and never waits on the network. The thread reads the
+/// atomics while they are written, so a report may be a frame behind in some of its values,
+/// but every value it reports is one that was recorded.
+///
+/// Frame times go into a histogram with the fixed buckets of `FRAME_TIME_BUCKETS`, in
+/// milliseconds, and one more for the frames slower than all of them. A frame slower than
+/// the dropped frame threshold is also counted as dropped. A Prometheus endpoint serves the
+/// histogram as it is, for the scraper to take percentiles of. Statsd has no histograms, so
+/// every `statsdInterval` the thread sends the percentiles of the frames since the last
+/// datagram as gauges, estimated from within their buckets, along with the counts of
+/// frames since then.
+class MetricsExporter final {
+    public:
+        static constexpr std::array<double, 12> FRAME_TIME_BUCKETS = {
+            2.0, 4.0, 8.0, 12.0, 16.7, 20.0, 25.0, 33.3, 50.0, 66.7, 100.0, 250.0,
+        };
+        /// @brief How often a Prometheus endpoint checks whether it is stopping while no
+        /// scrape comes in, in milliseconds.
+        static constexpr int ACCEPT_POLL_MILLISECONDS = 100;
+
+        explicit MetricsExporter() = delete;
+        explicit MetricsExporter(
+            const MetricsEndpoint& endpoint,
+            const std::string& metricPrefix,
+            double droppedFrameMilliseconds,
+            std::chrono::milliseconds statsdInterval
+        );
+
+        /// @brief Stop the thread, after the scrape or datagram it is on, if any.
+        ~MetricsExporter();
+
+        MetricsExporter(const MetricsExporter& other) = delete;
+        MetricsExporter& operator=(const MetricsExporter& other) = delete;
+
+        /// @brief Add a frame that took `milliseconds` on the CPU.
+        ///
+        /// @note Only one thread may record frames.
+        void recordFrame(double milliseconds);
+
+        void setGauge(MetricsGauge gauge, double value);
+    private:
+        static constexpr size_t BUCKET_COUNT = FRAME_TIME_BUCKETS.size() + 1;
+
+        using BucketCounts = std::array<uint64_t, BUCKET_COUNT>;
+
+#if defined(_WIN32)
+        using SocketHandle = uintptr_t;
+#else
+        using SocketHandle = int;
+#endif
+
+        MetricsEndpoint m_endpoint;
+        /// @brief What the name of every metric starts with.
+        std::string m_metricPrefix;
+        double m_droppedFrameMilliseconds;
+        std::chrono::milliseconds m_statsdInterval;
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_frameTimeBuckets;
+        std::atomic<double> m_frameTimeSum;
+        std::atomic<uint64_t> m_droppedFrameCount;
+        std::array<std::atomic<double>, static_cast<size_t>(MetricsGauge::Count)> m_gauges;
+        SocketHandle m_socket;
+        /// @brief Only the thread and the destructor take these, never the frame loop.
+        std::mutex m_mutex;
+        std::condition_variable m_stopRequested;
+        bool m_isStopping;
+        std::thread m_thread;
+
+        BucketCounts loadBucketCounts() const;
+
+        std::string formatPrometheus() const;
+
+        std::string formatStatsd(const BucketCounts& bucketCounts, const BucketCounts& lastBucketCounts, uint64_t droppedFrameCount) const;
+
+        void servePrometheus();
+
+        void sendStatsd();
+};
+
+}
+
+#endif // _METRICS_EXPORTER_H
@@ -0,0 +1,903 @@
+#include "mipmap_generator.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+
+#include "command_counters.h"
+
+
+using MipmapGenerator = VulkanEngine::MipmapGenerator;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+// The number of dispatches one descriptor pool serves before another pool is created.
+static constexpr uint32_t DESCRIPTOR_SETS_PER_POOL = 32;
+
+// The filter pipeline runs 8x8 workgroups, one layer deep.
+static constexpr uint32_t FILTER_GROUP_SIZE = 8;
+
+// The volume pipeline runs 4x4x4 workgroups.
+static constexpr uint32_t VOLUME_GROUP_SIZE = 4;
+
+// Each dispatch owns a scratch slot holding the single-pass workgroup counter followed by
+// an alpha histogram for every mip level.
+static constexpr VkDeviceSize SCRATCH_SLOT_SIZE =
+    (1 + VulkanEngine::MipmapGenerator::MAX_MIP_LEVELS * VulkanEngine::MipmapGenerator::HISTOGRAM_BIN_COUNT) * sizeof(uint32_t);
+
+MipmapGenerator::MipmapGenerator(
+    const DeviceCapabilities& capabilities,
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    VkPipelineCache pipelineCache,
+    bool isPushDescriptorSupported,
+    std::span<const uint32_t> shaderCode,
+    std::span<const uint32_t> filterShaderCode,
+    std::span<const uint32_t> volumeShaderCode
+)
+    : m_capabilities { capabilities }
+    , m_device { device }
+    , m_allocator { allocator }
+    , m_pipelineCache { pipelineCache }
+    , m_hasDynamicStorageImageIndexing { false }
+    , m_vkCmdPushDescriptorSetWithTemplateKHR { nullptr }
+    , m_descriptorSetLayout { VK_NULL_HANDLE }
+    , m_pipelineLayout { VK_NULL_HANDLE }
+    , m_pipeline { VK_NULL_HANDLE }
+    , m_filterPipelineLayout { VK_NULL_HANDLE }
+    , m_filterPipeline { VK_NULL_HANDLE }
+    , m_volumePipelineLayout { VK_NULL_HANDLE }
+    , m_volumePipeline { VK_NULL_HANDLE }
+    , m_updateTemplate { VK_NULL_HANDLE }
+    , m_pushTemplate { VK_NULL_HANDLE }
+    , m_filterPushTemplate { VK_NULL_HANDLE }
+    , m_volumePushTemplate { VK_NULL_HANDLE }
+    , m_descriptorPools { std::vector<VkDescriptorPool> {} }
+    , m_counterBuffer { VK_NULL_HANDLE }
+    , m_counterAllocation {}
+    , m_counterSlotStride { SCRATCH_SLOT_SIZE }
+{
+    // The shader indexes its array of mip views with a dynamically uniform level.
+    m_hasDynamicStorageImageIndexing = m_capabilities.getFeatures().shaderStorageImageArrayDynamicIndexing == VK_TRUE;
+
+    // The set layout is made for pushing or for allocating, so this has to be known first.
+    if (isPushDescriptorSupported) {
+        m_vkCmdPushDescriptorSetWithTemplateKHR = reinterpret_cast<PFN_vkCmdPushDescriptorSetWithTemplateKHR>(
+            vkGetDeviceProcAddr(m_device, "vkCmdPushDescriptorSetWithTemplateKHR")
+        );
+    }
+
+    this->createDescriptorSetLayout();
+
+    const auto [pipelineLayout, pipeline] = this->createPipeline(shaderCode, sizeof(PushConstants));
+    m_pipelineLayout = pipelineLayout;
+    m_pipeline = pipeline;
+
+    const auto [filterPipelineLayout, filterPipeline] = this->createPipeline(filterShaderCode, sizeof(FilterPushConstants));
+    m_filterPipelineLayout = filterPipelineLayout;
+    m_filterPipeline = filterPipeline;
+
+    const auto [volumePipelineLayout, volumePipeline] = this->createPipeline(volumeShaderCode, sizeof(VolumePushConstants));
+    m_volumePipelineLayout = volumePipelineLayout;
+    m_volumePipeline = volumePipeline;
+
+    // A push template is bound to one pipeline layout, and the layouts differ in their push
+    // constants, so every pipeline gets its own.
+    if (this->usesPushDescriptors()) {
+        m_pushTemplate = this->createUpdateTemplate(VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR, m_pipelineLayout);
+        m_filterPushTemplate = this->createUpdateTemplate(VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR, m_filterPipelineLayout);
+        m_volumePushTemplate = this->createUpdateTemplate(VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR, m_volumePipelineLayout);
+    } else {
+        m_updateTemplate = this->createUpdateTemplate(VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET, VK_NULL_HANDLE);
+    }
+
+    this->createCounterBuffer();
+}
+
+MipmapGenerator::~MipmapGenerator() {
+    for (const auto& descriptorPool : m_descriptorPools) {
+        vkDestroyDescriptorPool(m_device, descriptorPool, nullptr);
+    }
+
+    vkDestroyBuffer(m_device, m_counterBuffer, nullptr);
+    m_allocator.free(m_counterAllocation);
+
+    vkDestroyDescriptorUpdateTemplate(m_device, m_volumePushTemplate, nullptr);
+    vkDestroyDescriptorUpdateTemplate(m_device, m_filterPushTemplate, nullptr);
+    vkDestroyDescriptorUpdateTemplate(m_device, m_pushTemplate, nullptr);
+    vkDestroyDescriptorUpdateTemplate(m_device, m_updateTemplate, nullptr);
+
+    vkDestroyPipeline(m_device, m_volumePipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_volumePipelineLayout, nullptr);
+    vkDestroyPipeline(m_device, m_filterPipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_filterPipelineLayout, nullptr);
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+
+    m_descriptorPools.clear();
+    m_counterBuffer = VK_NULL_HANDLE;
+    m_volumePushTemplate = VK_NULL_HANDLE;
+    m_filterPushTemplate = VK_NULL_HANDLE;
+    m_pushTemplate = VK_NULL_HANDLE;
+    m_updateTemplate = VK_NULL_HANDLE;
+    m_volumePipeline = VK_NULL_HANDLE;
+    m_volumePipelineLayout = VK_NULL_HANDLE;
+    m_filterPipeline = VK_NULL_HANDLE;
+    m_filterPipelineLayout = VK_NULL_HANDLE;
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipelineLayout = VK_NULL_HANDLE;
+    m_descriptorSetLayout = VK_NULL_HANDLE;
+    m_pipelineCache = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+bool MipmapGenerator::supportsTarget(const MipmapTarget& target) const {
+    if (!m_hasDynamicStorageImageIndexing) {
+        return false;
+    }
+
+    if (target.mipLevels < 2 || target.mipLevels > MAX_MIP_LEVELS) {
+        return false;
+    }
+
+    // A volume has a single layer, and every cube has six square faces.
+    if (target.layerCount == 0 || (target.depth > 1 && target.layerCount > 1)) {
+        return false;
+    }
+
+    if (target.isCubeMap && (target.layerCount % 6 != 0 || target.width != target.height)) {
+        return false;
+    }
+
+    const auto storageFormat = MipmapGenerator::getStorageFormat(target.format);
+    if (storageFormat == VK_FORMAT_UNDEFINED) {
+        return false;
+    }
+
+    return m_capabilities.hasOptimalTilingFeatures(storageFormat, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT);
+}
+
+VkImageUsageFlags MipmapGenerator::getRequiredImageUsage(VkFormat format) const {
+    if (MipmapGenerator::getStorageFormat(format) == VK_FORMAT_UNDEFINED) {
+        return 0;
+    }
+
+    return VK_IMAGE_USAGE_STORAGE_BIT;
+}
+
+VkImageCreateFlags MipmapGenerator::getRequiredImageCreateFlags(VkFormat format) const {
+    // sRGB formats rarely support storage, so the image is written through a UNORM alias,
+    // which the device lists as the only other format of a mutable sRGB image.
+    if (MipmapGenerator::isSrgbFormat(format)) {
+        return VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+    }
+
+    return 0;
+}
+
+std::vector<MipmapGenerator::DispatchResources> MipmapGenerator::record(
+    VkCommandBuffer commandBuffer,
+    std::span<const MipmapTarget> targets,
+    VkPipelineStageFlags readStageMask
+) {
+    auto resources = std::vector<DispatchResources> {};
+    resources.reserve(targets.size());
+    try {
+        for (size_t first = 0; first < targets.size(); first += COUNTER_SLOT_COUNT) {
+            const auto count = std::min(targets.size() - first, static_cast<size_t>(COUNTER_SLOT_COUNT));
+            this->recordGroup(commandBuffer, targets.subspan(first, count), readStageMask, resources);
+        }
+    } catch (...) {
+        for (const auto& dispatchResources : resources) {
+            this->release(dispatchResources);
+        }
+
+        throw;
+    }
+
+    return resources;
+}
+
+void MipmapGenerator::recordGroup(
+    VkCommandBuffer commandBuffer,
+    std::span<const MipmapTarget> targets,
+    VkPipelineStageFlags readStageMask,
+    std::vector<DispatchResources>& resources
+) {
+    const auto firstResource = resources.size();
+    for (uint32_t slot = 0; slot < targets.size(); slot++) {
+        resources.push_back(this->createDispatchResources(targets[slot], slot));
+    }
+
+    // Reset the workgroup counters and alpha histograms. They are shared with earlier groups,
+    // so the fill has to wait for any earlier dispatch to finish with them.
+    const auto counterBarrierBeforeFill = VkBufferMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = m_counterBuffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        1, &counterBarrierBeforeFill,
+        0, nullptr
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+    vkCmdFillBuffer(commandBuffer, m_counterBuffer, 0, VK_WHOLE_SIZE, 0);
+
+    const auto counterBarrierAfterFill = VkBufferMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = m_counterBuffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+    // Mip 0 holds the uploaded texels and the other levels are still in the layout the upload
+    // left them in. All of them move to the general layout for storage access.
+    auto imageBarriers = std::vector<VkImageMemoryBarrier> {};
+    imageBarriers.reserve(targets.size());
+    for (const auto& target : targets) {
+        imageBarriers.push_back(VkImageMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = target.image,
+            .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .subresourceRange.baseMipLevel = 0,
+            .subresourceRange.levelCount = target.mipLevels,
+            .subresourceRange.baseArrayLayer = 0,
+            .subresourceRange.layerCount = target.layerCount,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        });
+    }
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, nullptr,
+        1, &counterBarrierAfterFill,
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    auto filterTargets = std::vector<MipmapTarget> {};
+    auto filterResources = std::vector<DispatchResources> {};
+    auto volumeTargets = std::vector<MipmapTarget> {};
+    auto volumeResources = std::vector<DispatchResources> {};
+    auto isPipelineBound = false;
+    for (uint32_t slot = 0; slot < targets.size(); slot++) {
+        const auto& target = targets[slot];
+        if (target.depth > 1) {
+            volumeTargets.push_back(target);
+            volumeResources.push_back(resources[firstResource + slot]);
+
+            continue;
+        }
+
+        if (!MipmapGenerator::usesSinglePass(target)) {
+            filterTargets.push_back(target);
+            filterResources.push_back(resources[firstResource + slot]);
+
+            continue;
+        }
+
+        if (!isPipelineBound) {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+            CommandCounters::add(CommandCounter::PipelineBinds);
+            isPipelineBound = true;
+        }
+
+        const auto workGroupCountX = (target.width + TILE_SIZE - 1) / TILE_SIZE;
+        const auto workGroupCountY = (target.height + TILE_SIZE - 1) / TILE_SIZE;
+        const auto pushConstants = PushConstants {
+            .sourceWidth = target.width,
+            .sourceHeight = target.height,
+            .mipCount = target.mipLevels,
+            .workGroupCount = workGroupCountX * workGroupCountY,
+            .isSrgb = MipmapGenerator::isSrgbFormat(target.format) ? 1u : 0u,
+        };
+
+        this->bindDescriptors(commandBuffer, m_pipelineLayout, m_pushTemplate, resources[firstResource + slot]);
+        vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstants);
+        vkCmdDispatch(commandBuffer, workGroupCountX, workGroupCountY, 1);
+        CommandCounters::add(CommandCounter::Dispatches);
+    }
+
+    // The pipelines write disjoint images and scratch slots, so the filter and volume passes
+    // do not have to wait for the single-pass dispatches.
+    if (!filterTargets.empty()) {
+        this->recordFilterPasses(commandBuffer, filterTargets, filterResources);
+    }
+
+    if (!volumeTargets.empty()) {
+        this->recordVolumePasses(commandBuffer, volumeTargets, volumeResources);
+    }
+
+    for (auto& imageBarrier : imageBarriers) {
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    }
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, readStageMask,
+        0,
+        0, nullptr,
+        0, nullptr,
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+}
+
+void MipmapGenerator::recordFilterPasses(
+    VkCommandBuffer commandBuffer,
+    std::span<const MipmapTarget> targets,
+    std::span<const DispatchResources> resources
+) {
+    auto getLevelExtent = [](uint32_t extent, uint32_t level) -> uint32_t {
+        return std::max(extent >> level, 1u);
+    };
+    // Every layer of the target is a slice of the same dispatch.
+    auto dispatch = [this, commandBuffer](
+        const DispatchResources& dispatchResources,
+        const FilterPushConstants& pushConstants,
+        uint32_t width,
+        uint32_t height,
+        uint32_t layerCount
+    ) {
+        this->bindDescriptors(commandBuffer, m_filterPipelineLayout, m_filterPushTemplate, dispatchResources);
+        vkCmdPushConstants(commandBuffer, m_filterPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(FilterPushConstants), &pushConstants);
+        vkCmdDispatch(commandBuffer, (width + FILTER_GROUP_SIZE - 1) / FILTER_GROUP_SIZE, (height + FILTER_GROUP_SIZE - 1) / FILTER_GROUP_SIZE, layerCount);
+        CommandCounters::add(CommandCounter::Dispatches);
+    };
+    // Each pass reads what the previous pass wrote, to images as well as to the histograms.
+    auto barrier = [commandBuffer]() {
+        const auto memoryBarrier = VkMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        };
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &memoryBarrier,
+            0, nullptr,
+            0, nullptr
+        );
+        CommandCounters::add(CommandCounter::Barriers);
+    };
+
+    auto maxMipLevels = 0u;
+    auto hasAlphaCoverage = false;
+    for (const auto& target : targets) {
+        maxMipLevels = std::max(maxMipLevels, target.mipLevels);
+        hasAlphaCoverage = hasAlphaCoverage || target.alphaCutoff > 0.0f;
+    }
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_filterPipeline);
+    CommandCounters::add(CommandCounter::PipelineBinds);
+
+    // The levels of every target advance in lockstep, so one barrier per pass covers the
+    // whole group instead of one per target.
+    for (uint32_t level = 1; level < maxMipLevels; level++) {
+        for (size_t i = 0; i < targets.size(); i++) {
+            const auto& target = targets[i];
+            if (level >= target.mipLevels) {
+                continue;
+            }
+
+            const auto sourceWidth = getLevelExtent(target.width, level - 1);
+            const auto sourceHeight = getLevelExtent(target.height, level - 1);
+            auto pushConstants = FilterPushConstants {
+                .sourceWidth = sourceWidth,
+                .sourceHeight = sourceHeight,
+                .destinationWidth = getLevelExtent(target.width, level),
+                .destinationHeight = getLevelExtent(target.height, level),
+                .sourceLevel = level - 1,
+                .filter = static_cast<uint32_t>(target.filter),
+                .pass = static_cast<uint32_t>(FilterPass::Downsample),
+                .isSrgb = MipmapGenerator::isSrgbFormat(target.format) ? 1u : 0u,
+                .alphaCutoff = target.alphaCutoff,
+                .isCubeMap = target.isCubeMap ? 1u : 0u,
+            };
+            dispatch(resources[i], pushConstants, pushConstants.destinationWidth, pushConstants.destinationHeight, target.layerCount);
+
+            // Level 0 is the coverage reference for every other level. It only reads level
+            // 0, so it shares the first pass with the first downsample.
+            if (level == 1 && target.alphaCutoff > 0.0f) {
+                pushConstants.pass = static_cast<uint32_t>(FilterPass::Histogram);
+                dispatch(resources[i], pushConstants, sourceWidth, sourceHeight, target.layerCount);
+            }
+        }
+
+        barrier();
+
+        if (!hasAlphaCoverage) {
+            continue;
+        }
+
+        for (const auto pass : { FilterPass::Histogram, FilterPass::ScaleAlpha }) {
+            for (size_t i = 0; i < targets.size(); i++) {
+                const auto& target = targets[i];
+                if (level >= target.mipLevels || target.alphaCutoff <= 0.0f) {
+                    continue;
+                }
+
+                const auto width = getLevelExtent(target.width, level);
+                const auto height = getLevelExtent(target.height, level);
+                const auto pushConstants = FilterPushConstants {
+                    .sourceWidth = width,
+                    .sourceHeight = height,
+                    .destinationWidth = width,
+                    .destinationHeight = height,
+                    .sourceLevel = level,
+                    .filter = static_cast<uint32_t>(target.filter),
+                    .pass = static_cast<uint32_t>(pass),
+                    .isSrgb = MipmapGenerator::isSrgbFormat(target.format) ? 1u : 0u,
+                    .alphaCutoff = target.alphaCutoff,
+                    .isCubeMap = target.isCubeMap ? 1u : 0u,
+                };
+                dispatch(resources[i], pushConstants, width, height, target.layerCount);
+            }
+
+            barrier();
+        }
+    }
+}
+
+void MipmapGenerator::recordVolumePasses(
+    VkCommandBuffer commandBuffer,
+    std::span<const MipmapTarget> targets,
+    std::span<const DispatchResources> resources
+) {
+    auto getLevelExtent = [](uint32_t extent, uint32_t level) -> uint32_t {
+        return std::max(extent >> level, 1u);
+    };
+    auto getGroupCount = [](uint32_t extent) -> uint32_t {
+        return (extent + VOLUME_GROUP_SIZE - 1) / VOLUME_GROUP_SIZE;
+    };
+
+    auto maxMipLevels = 0u;
+    for (const auto& target : targets) {
+        maxMipLevels = std::max(maxMipLevels, target.mipLevels);
+    }
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_volumePipeline);
+    CommandCounters::add(CommandCounter::PipelineBinds);
+
+    // Like the filter passes, the levels of every volume advance in lockstep.
+    for (uint32_t level = 1; level < maxMipLevels; level++) {
+        for (size_t i = 0; i < targets.size(); i++) {
+            const auto& target = targets[i];
+            if (level >= target.mipLevels) {
+                continue;
+            }
+
+            const auto pushConstants = VolumePushConstants {
+                .sourceWidth = getLevelExtent(target.width, level - 1),
+                .sourceHeight = getLevelExtent(target.height, level - 1),
+                .sourceDepth = getLevelExtent(target.depth, level - 1),
+                .destinationWidth = getLevelExtent(target.width, level),
+                .destinationHeight = getLevelExtent(target.height, level),
+                .destinationDepth = getLevelExtent(target.depth, level),
+                .sourceLevel = level - 1,
+                .filter = static_cast<uint32_t>(target.filter),
+                .isSrgb = MipmapGenerator::isSrgbFormat(target.format) ? 1u : 0u,
+            };
+
+            this->bindDescriptors(commandBuffer, m_volumePipelineLayout, m_volumePushTemplate, resources[i]);
+            vkCmdPushConstants(commandBuffer, m_volumePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(VolumePushConstants), &pushConstants);
+            vkCmdDispatch(
+                commandBuffer,
+                getGroupCount(pushConstants.destinationWidth),
+                getGroupCount(pushConstants.destinationHeight),
+                getGroupCount(pushConstants.destinationDepth)
+            );
+            CommandCounters::add(CommandCounter::Dispatches);
+        }
+
+        const auto memoryBarrier = VkMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        };
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &memoryBarrier,
+            0, nullptr,
+            0, nullptr
+        );
+        CommandCounters::add(CommandCounter::Barriers);
+    }
+}
+
+MipmapGenerator::DispatchResources MipmapGenerator::createDispatchResources(const MipmapTarget& target, uint32_t counterSlot) {
+    auto resources = DispatchResources {};
+    resources.mipViews.reserve(target.mipLevels);
+
+    // The views have to match the image dimensions each shader declares. The filter shader
+    // works on arrays, and cube maps are viewed as arrays of their faces.
+    auto viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    if (target.depth > 1) {
+        viewType = VK_IMAGE_VIEW_TYPE_3D;
+    } else if (MipmapGenerator::usesSinglePass(target)) {
+        viewType = VK_IMAGE_VIEW_TYPE_2D;
+    }
+
+    const auto storageFormat = MipmapGenerator::getStorageFormat(target.format);
+    for (uint32_t level = 0; level < target.mipLevels; level++) {
+        const auto viewInfo = VkImageViewCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = target.image,
+            .viewType = viewType,
+            .format = storageFormat,
+            .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .subresourceRange.baseMipLevel = level,
+            .subresourceRange.levelCount = 1,
+            .subresourceRange.baseArrayLayer = 0,
+            .subresourceRange.layerCount = target.layerCount,
+        };
+
+        auto mipView = VkImageView {};
+        const auto result = vkCreateImageView(m_device, &viewInfo, nullptr, &mipView);
+        if (result != VK_SUCCESS) {
+            this->release(resources);
+
+            throw std::runtime_error("failed to create mip level image view!");
+        }
+
+        resources.mipViews.push_back(mipView);
+    }
+
+    // Every element of the array has to hold a valid descriptor, so the levels past the end
+    // of the chain repeat the last view. The shader never touches them.
+    for (uint32_t i = 0; i < MAX_MIP_LEVELS; i++) {
+        resources.descriptors.mipViews[i] = VkDescriptorImageInfo {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = resources.mipViews[std::min(i, target.mipLevels - 1)],
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        };
+    }
+    resources.descriptors.scratchSlot = VkDescriptorBufferInfo {
+        .buffer = m_counterBuffer,
+        .offset = counterSlot * m_counterSlotStride,
+        .range = SCRATCH_SLOT_SIZE,
+    };
+
+    // Pushed descriptors are written when the dispatch is recorded.
+    if (this->usesPushDescriptors()) {
+        return resources;
+    }
+
+    try {
+        const auto [descriptorPool, descriptorSet] = this->allocateDescriptorSet();
+        resources.descriptorPool = descriptorPool;
+        resources.descriptorSet = descriptorSet;
+    } catch (...) {
+        this->release(resources);
+
+        throw;
+    }
+
+    vkUpdateDescriptorSetWithTemplate(m_device, resources.descriptorSet, m_updateTemplate, &resources.descriptors);
+
+    return resources;
+}
+
+void MipmapGenerator::release(const DispatchResources& resources) {
+    if (resources.descriptorSet != VK_NULL_HANDLE) {
+        vkFreeDescriptorSets(m_device, resources.descriptorPool, 1, &resources.descriptorSet);
+    }
+
+    for (const auto& mipView : resources.mipViews) {
+        vkDestroyImageView(m_device, mipView, nullptr);
+    }
+}
+
+VkFormat MipmapGenerator::getStorageFormat(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM: return VK_FORMAT_R8G8B8A8_UNORM;
+        case VK_FORMAT_R8G8B8A8_SRGB: return VK_FORMAT_R8G8B8A8_UNORM;
+        default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+bool MipmapGenerator::isSrgbFormat(VkFormat format) {
+    return format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+bool MipmapGenerator::usesSinglePass(const MipmapTarget& target) {
+    if (target.filter != MipFilter::Box || target.alphaCutoff > 0.0f) {
+        return false;
+    }
+
+    // The single-pass shader works on one 2D layer.
+    if (target.depth > 1 || target.layerCount > 1) {
+        return false;
+    }
+
+    // Every 2x2 reduction of the single-pass shader has to see whole footprints, and the
+    // last workgroup downsamples all of mip 6 by itself, so mip 6 has to fit in one tile.
+    // That caps the source at 4096x4096.
+    const auto maxExtent = TILE_SIZE << 6;
+    const auto isPowerOfTwo = [](uint32_t extent) -> bool {
+        return (extent & (extent - 1)) == 0;
+    };
+
+    return isPowerOfTwo(target.width) && isPowerOfTwo(target.height) && target.width <= maxExtent && target.height <= maxExtent;
+}
+
+void MipmapGenerator::createDescriptorSetLayout() {
+    const auto bindings = std::array<VkDescriptorSetLayoutBinding, 2> {
+        VkDescriptorSetLayoutBinding {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = MAX_MIP_LEVELS,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+    };
+    const auto layoutInfo = VkDescriptorSetLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .flags = this->usesPushDescriptors() ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0u,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+
+    auto descriptorSetLayout = VkDescriptorSetLayout {};
+    const auto result = vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &descriptorSetLayout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mipmap generator descriptor set layout!");
+    }
+
+    m_descriptorSetLayout = descriptorSetLayout;
+}
+
+std::tuple<VkPipelineLayout, VkPipeline> MipmapGenerator::createPipeline(std::span<const uint32_t> shaderCode, uint32_t pushConstantSize) {
+    const auto pushConstantRange = VkPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = pushConstantSize,
+    };
+    const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_descriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+
+    auto pipelineLayout = VkPipelineLayout {};
+    const auto resultCreatePipelineLayout = vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    if (resultCreatePipelineLayout != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mipmap generator pipeline layout!");
+    }
+
+    const auto shaderModuleInfo = VkShaderModuleCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = shaderCode.size_bytes(),
+        .pCode = shaderCode.data(),
+    };
+
+    auto shaderModule = VkShaderModule {};
+    const auto resultCreateShaderModule = vkCreateShaderModule(m_device, &shaderModuleInfo, nullptr, &shaderModule);
+    if (resultCreateShaderModule != VK_SUCCESS) {
+        vkDestroyPipelineLayout(m_device, pipelineLayout, nullptr);
+
+        throw std::runtime_error("failed to create mipmap generator shader module!");
+    }
+
+    const auto pipelineInfo = VkComputePipelineCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shaderModule,
+            .pName = "main",
+        },
+        .layout = pipelineLayout,
+    };
+
+    auto pipeline = VkPipeline {};
+    const auto resultCreatePipeline = vkCreateComputePipelines(m_device, m_pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    // The pipeline keeps everything it needs from the shader module.
+    vkDestroyShaderModule(m_device, shaderModule, nullptr);
+
+    if (resultCreatePipeline != VK_SUCCESS) {
+        vkDestroyPipelineLayout(m_device, pipelineLayout, nullptr);
+
+        throw std::runtime_error("failed to create mipmap generator pipeline!");
+    }
+
+    return std::make_tuple(pipelineLayout, pipeline);
+}
+
+bool MipmapGenerator::usesPushDescriptors() const {
+    return m_vkCmdPushDescriptorSetWithTemplateKHR != nullptr;
+}
+
+VkDescriptorUpdateTemplate MipmapGenerator::createUpdateTemplate(VkDescriptorUpdateTemplateType templateType, VkPipelineLayout pipelineLayout) {
+    const auto entries = std::array<VkDescriptorUpdateTemplateEntry, 2> {
+        VkDescriptorUpdateTemplateEntry {
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = MAX_MIP_LEVELS,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .offset = offsetof(DispatchDescriptors, mipViews),
+            .stride = sizeof(VkDescriptorImageInfo),
+        },
+        VkDescriptorUpdateTemplateEntry {
+            .dstBinding = 1,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .offset = offsetof(DispatchDescriptors, scratchSlot),
+            .stride = sizeof(VkDescriptorBufferInfo),
+        },
+    };
+    const auto templateInfo = VkDescriptorUpdateTemplateCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size()),
+        .pDescriptorUpdateEntries = entries.data(),
+        .templateType = templateType,
+        .descriptorSetLayout = m_descriptorSetLayout,
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_COMPUTE,
+        .pipelineLayout = pipelineLayout,
+        .set = 0,
+    };
+
+    auto updateTemplate = VkDescriptorUpdateTemplate {};
+    const auto result = vkCreateDescriptorUpdateTemplate(m_device, &templateInfo, nullptr, &updateTemplate);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mipmap generator descriptor update template!");
+    }
+
+    return updateTemplate;
+}
+
+void MipmapGenerator::bindDescriptors(
+    VkCommandBuffer commandBuffer,
+    VkPipelineLayout pipelineLayout,
+    VkDescriptorUpdateTemplate pushTemplate,
+    const DispatchResources& resources
+) const {
+    if (this->usesPushDescriptors()) {
+        m_vkCmdPushDescriptorSetWithTemplateKHR(commandBuffer, pushTemplate, pipelineLayout, 0, &resources.descriptors);
+        CommandCounters::add(CommandCounter::DescriptorBinds);
+
+        return;
+    }
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &resources.descriptorSet, 0, nullptr);
+    CommandCounters::add(CommandCounter::DescriptorBinds);
+}
+
+void MipmapGenerator::createCounterBuffer() {
+    // Each dispatch in a group binds its own scratch slot, and storage buffer bindings have
+    // to start at a multiple of the device's offset alignment.
+    const auto alignment = m_capabilities.getLimits().minStorageBufferOffsetAlignment;
+    m_counterSlotStride = ((SCRATCH_SLOT_SIZE + alignment - 1) / alignment) * alignment;
+
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = COUNTER_SLOT_COUNT * m_counterSlotStride,
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto result = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mipmap generator counter buffer!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    const auto allocation = m_allocator.allocate(
+        memRequirements,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        GpuResourceKind::Linear,
+        GpuMemoryCategory::Other
+    );
+
+    vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+    m_counterBuffer = buffer;
+    m_counterAllocation = allocation;
+}
+
+VkDescriptorPool MipmapGenerator::createDescriptorPool() {
+    const auto poolSizes = std::array<VkDescriptorPoolSize, 2> {
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = MAX_MIP_LEVELS * DESCRIPTOR_SETS_PER_POOL,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = DESCRIPTOR_SETS_PER_POOL,
+        },
+    };
+    const auto poolInfo = VkDescriptorPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+        .maxSets = DESCRIPTOR_SETS_PER_POOL,
+    };
+
+    auto descriptorPool = VkDescriptorPool {};
+    const auto result = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &descriptorPool);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mipmap generator descriptor pool!");
+    }
+
+    m_descriptorPools.push_back(descriptorPool);
+
+    return descriptorPool;
+}
+
+std::tuple<VkDescriptorPool, VkDescriptorSet> MipmapGenerator::allocateDescriptorSet() {
+    auto tryAllocate = [this](VkDescriptorPool descriptorPool) -> VkDescriptorSet {
+        const auto allocInfo = VkDescriptorSetAllocateInfo {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = descriptorPool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &m_descriptorSetLayout,
+        };
+
+        auto descriptorSet = VkDescriptorSet {};
+        const auto result = vkAllocateDescriptorSets(m_device, &allocInfo, &descriptorSet);
+        if (result != VK_SUCCESS) {
+            return VK_NULL_HANDLE;
+        }
+
+        return descriptorSet;
+    };
+
+    // Descriptor sets are freed once the batch that used them completes, so a pool is only
+    // full while that many dispatches are in flight.
+    for (const auto& descriptorPool : m_descriptorPools) {
+        const auto descriptorSet = tryAllocate(descriptorPool);
+        if (descriptorSet != VK_NULL_HANDLE) {
+            return std::make_tuple(descriptorPool, descriptorSet);
+        }
+    }
+
+    const auto descriptorPool = this->createDescriptorPool();
+    const auto descriptorSet = tryAllocate(descriptorPool);
+    if (descriptorSet == VK_NULL_HANDLE) {
+        throw std::runtime_error("failed to allocate mipmap generator descriptor set!");
+    }
+
+    return std::make_tuple(descriptorPool, descriptorSet);
+}
@@ -0,0 +1,251 @@
+#ifndef _MIPMAP_GENERATOR_H
+#define _MIPMAP_GENERATOR_H
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include "device_capabilities.h"
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief The downsampling filter of the compute mip generator.
+///
+/// @note The wider filters keep more detail in the smaller levels at the cost of more
+/// texel reads. Blit chains always filter linearly and ignore this.
+enum class MipFilter : uint32_t {
+    /// @brief Average the texels under each destination texel.
+    Box = 0,
+    /// @brief A triangle filter one destination texel wide on each side.
+    Tent = 1,
+    /// @brief A Kaiser-windowed sinc, 1.5 destination texels wide on each side.
+    Kaiser = 2,
+    /// @brief A two-lobe Lanczos filter.
+    Lanczos = 3
+};
+
+/// @brief An image whose mip chain is generated from its level 0.
+///
+/// @note Every layer of an array image gets a chain of its own. A volume texture has a
+/// depth above one and a single layer.
+struct MipmapTarget final {
+    VkImage image = VK_NULL_HANDLE;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t depth = 1;
+    uint32_t mipLevels = 1;
+    uint32_t layerCount = 1;
+    /// @brief Whether every six layers are the faces of a cube, in which case the filters
+    /// reach across face edges so that the faces of each level meet without seams.
+    bool isCubeMap = false;
+    MipFilter filter = MipFilter::Box;
+    /// @brief The alpha test reference value of a cutout texture, or zero for textures
+    /// that are not alpha tested.
+    ///
+    /// @note When set, every level is rescaled to keep the fraction of texels passing the
+    /// alpha test the same as in level 0.
+    float alphaCutoff = 0.0f;
+};
+
+/// @brief Generates mip chains with compute shaders.
+///
+/// @note Box-filtered power-of-two images without alpha coverage follow AMD's single-pass
+/// downsampler: one workgroup per 64x64 tile of mip 0 writes mips 1 through 6 out of shared
+/// memory, and the last workgroup to finish, found with a global atomic counter, downsamples
+/// the rest of the chain. Compared with a blit chain, which needs one blit and two barriers
+/// per level, the whole chain costs two barriers and one dispatch.
+///
+/// Every other image goes through a filter pipeline that runs one dispatch per level. It
+/// supports the wider filters of `MipFilter`, filters odd-sized levels over their exact
+/// footprint, and preserves alpha coverage for cutout textures. Array images and cube maps
+/// go through it too, with every layer of a level in the same dispatch. Volume textures
+/// have a pipeline of their own that filters along all three axes, without alpha coverage.
+///
+/// Only 8-bit RGBA formats are supported, and sRGB images are accessed through a UNORM
+/// view with the conversion done in the shader. Images must be created with the usage and
+/// create flags reported by `getRequiredImageUsage` and `getRequiredImageCreateFlags`.
+///
+/// The descriptors of a dispatch are written with descriptor update templates, from one
+/// `DispatchDescriptors` rather than an array of writes. With push descriptors they are
+/// pushed into the command buffer as it is recorded, so a dispatch allocates no set and
+/// touches no pool. Without them every dispatch still gets a set of its own.
+class MipmapGenerator final {
+    public:
+        static constexpr uint32_t MAX_MIP_LEVELS = 13;
+        static constexpr uint32_t TILE_SIZE = 64;
+        /// @brief The number of dispatches that share one reset of the workgroup counters.
+        static constexpr uint32_t COUNTER_SLOT_COUNT = 64;
+        static constexpr uint32_t HISTOGRAM_BIN_COUNT = 256;
+
+        /// @brief The descriptors of one dispatch, laid out as the update templates read
+        /// them.
+        struct DispatchDescriptors final {
+            std::array<VkDescriptorImageInfo, MAX_MIP_LEVELS> mipViews;
+            VkDescriptorBufferInfo scratchSlot;
+        };
+
+        /// @brief The per-dispatch resources that must outlive the command buffer.
+        ///
+        /// @note The set is only allocated without push descriptors.
+        struct DispatchResources final {
+            std::vector<VkImageView> mipViews;
+            DispatchDescriptors descriptors {};
+            VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        };
+
+        explicit MipmapGenerator() = delete;
+        explicit MipmapGenerator(
+            const DeviceCapabilities& capabilities,
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            VkPipelineCache pipelineCache,
+            bool isPushDescriptorSupported,
+            std::span<const uint32_t> shaderCode,
+            std::span<const uint32_t> filterShaderCode,
+            std::span<const uint32_t> volumeShaderCode
+        );
+
+        ~MipmapGenerator();
+
+        bool supportsTarget(const MipmapTarget& target) const;
+
+        VkImageUsageFlags getRequiredImageUsage(VkFormat format) const;
+
+        VkImageCreateFlags getRequiredImageCreateFlags(VkFormat format) const;
+
+        /// @brief Record the mip chain generation for every target.
+        ///
+        /// @note Targets are dispatched in groups of up to `COUNTER_SLOT_COUNT`. Every group
+        /// costs one counter reset, one barrier before and one barrier after its dispatches.
+        /// The barrier after them makes the chains visible to `readStageMask`, which work on
+        /// a compute queue sets to the compute shader stage.
+        std::vector<DispatchResources> record(
+            VkCommandBuffer commandBuffer,
+            std::span<const MipmapTarget> targets,
+            VkPipelineStageFlags readStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+        );
+
+        void release(const DispatchResources& resources);
+    private:
+        struct PushConstants final {
+            uint32_t sourceWidth;
+            uint32_t sourceHeight;
+            uint32_t mipCount;
+            uint32_t workGroupCount;
+            uint32_t isSrgb;
+        };
+
+        enum class FilterPass : uint32_t {
+            Downsample = 0,
+            Histogram = 1,
+            ScaleAlpha = 2
+        };
+
+        struct FilterPushConstants final {
+            uint32_t sourceWidth;
+            uint32_t sourceHeight;
+            uint32_t destinationWidth;
+            uint32_t destinationHeight;
+            uint32_t sourceLevel;
+            uint32_t filter;
+            uint32_t pass;
+            uint32_t isSrgb;
+            float alphaCutoff;
+            uint32_t isCubeMap;
+        };
+
+        struct VolumePushConstants final {
+            uint32_t sourceWidth;
+            uint32_t sourceHeight;
+            uint32_t sourceDepth;
+            uint32_t destinationWidth;
+            uint32_t destinationHeight;
+            uint32_t destinationDepth;
+            uint32_t sourceLevel;
+            uint32_t filter;
+            uint32_t isSrgb;
+        };
+
+        const DeviceCapabilities& m_capabilities;
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkPipelineCache m_pipelineCache;
+        bool m_hasDynamicStorageImageIndexing;
+        PFN_vkCmdPushDescriptorSetWithTemplateKHR m_vkCmdPushDescriptorSetWithTemplateKHR;
+        VkDescriptorSetLayout m_descriptorSetLayout;
+        VkPipelineLayout m_pipelineLayout;
+        VkPipeline m_pipeline;
+        VkPipelineLayout m_filterPipelineLayout;
+        VkPipeline m_filterPipeline;
+        VkPipelineLayout m_volumePipelineLayout;
+        VkPipeline m_volumePipeline;
+        /// @brief The template that writes allocated sets, without push descriptors.
+        VkDescriptorUpdateTemplate m_updateTemplate;
+        /// @brief The templates that push the descriptors of each pipeline, with them.
+        VkDescriptorUpdateTemplate m_pushTemplate;
+        VkDescriptorUpdateTemplate m_filterPushTemplate;
+        VkDescriptorUpdateTemplate m_volumePushTemplate;
+        std::vector<VkDescriptorPool> m_descriptorPools;
+        VkBuffer m_counterBuffer;
+        GpuAllocation m_counterAllocation;
+        VkDeviceSize m_counterSlotStride;
+
+        static VkFormat getStorageFormat(VkFormat format);
+
+        static bool isSrgbFormat(VkFormat format);
+
+        static bool usesSinglePass(const MipmapTarget& target);
+
+        void createDescriptorSetLayout();
+
+        std::tuple<VkPipelineLayout, VkPipeline> createPipeline(std::span<const uint32_t> shaderCode, uint32_t pushConstantSize);
+
+        bool usesPushDescriptors() const;
+
+        VkDescriptorUpdateTemplate createUpdateTemplate(VkDescriptorUpdateTemplateType templateType, VkPipelineLayout pipelineLayout);
+
+        void bindDescriptors(
+            VkCommandBuffer commandBuffer,
+            VkPipelineLayout pipelineLayout,
+            VkDescriptorUpdateTemplate pushTemplate,
+            const DispatchResources& resources
+        ) const;
+
+        void createCounterBuffer();
+
+        VkDescriptorPool createDescriptorPool();
+
+        std::tuple<VkDescriptorPool, VkDescriptorSet> allocateDescriptorSet();
+
+        DispatchResources createDispatchResources(const MipmapTarget& target, uint32_t counterSlot);
+
+        void recordGroup(
+            VkCommandBuffer commandBuffer,
+            std::span<const MipmapTarget> targets,
+            VkPipelineStageFlags readStageMask,
+            std::vector<DispatchResources>& resources
+        );
+
+        void recordFilterPasses(
+            VkCommandBuffer commandBuffer,
+            std::span<const MipmapTarget> targets,
+            std::span<const DispatchResources> resources
+        );
+
+        void recordVolumePasses(
+            VkCommandBuffer commandBuffer,
+            std::span<const MipmapTarget> targets,
+            std::span<const DispatchResources> resources
+        );
+};
+
+}
+
+#endif // _MIPMAP_GENERATOR_H
@@ -0,0 +1,105 @@
+#include "mipmap_slicer.h"
+#include "texture_format.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+
+using MipmapSlicer = VulkanEngine::MipmapSlicer;
+
+MipmapSlicer::MipmapSlicer(UploadContext& uploadContext, const MipmapTarget& target, uint32_t maxLevelsPerFrame)
+    : m_uploadContext { uploadContext }
+    , m_target { target }
+    , m_maxLevelsPerFrame { std::max(maxLevelsPerFrame, 1u) }
+    , m_samplers { std::vector<VkSampler> {} }
+    , m_completedLevelCount { 1 }
+    , m_submittedLevelCount { 1 }
+    , m_pendingTimelineValue {}
+{
+    if (m_target.mipLevels == 0) {
+        throw std::invalid_argument("a sliced mip chain needs at least one mip level!");
+    }
+
+    if (!TextureFormats::getInfo(m_target.format).has_value()) {
+        throw std::invalid_argument("a sliced mip chain needs a format the texture path knows!");
+    }
+}
+
+void MipmapSlicer::beginSlicing(UploadBatch& uploadBatch) {
+    uploadBatch.transitionImageLayout(
+        m_target.image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        m_target.mipLevels
+    );
+}
+
+void MipmapSlicer::createSamplers(SamplerCache& samplerCache, const VkSamplerCreateInfo& samplerInfo) {
+    auto samplers = std::vector<VkSampler> {};
+    samplers.reserve(m_target.mipLevels);
+    for (uint32_t level = 0; level < m_target.mipLevels; level++) {
+        auto levelSamplerInfo = samplerInfo;
+        levelSamplerInfo.maxLod = std::min(samplerInfo.maxLod, static_cast<float>(level));
+        levelSamplerInfo.minLod = std::min(samplerInfo.minLod, levelSamplerInfo.maxLod);
+
+        samplers.push_back(samplerCache.getSampler(levelSamplerInfo));
+    }
+
+    m_samplers = std::move(samplers);
+}
+
+void MipmapSlicer::update(UploadScheduler& uploadScheduler) {
+    if (m_pendingTimelineValue.has_value()) {
+        if (!m_uploadContext.isComplete(*m_pendingTimelineValue)) {
+            return;
+        }
+
+        m_completedLevelCount = m_submittedLevelCount;
+        m_pendingTimelineValue.reset();
+    }
+
+    auto levelCount = 0u;
+    while (levelCount < m_maxLevelsPerFrame && m_submittedLevelCount + levelCount < m_target.mipLevels) {
+        const auto sourceLevel = m_submittedLevelCount + levelCount - 1;
+        if (!uploadScheduler.tryReserve(this->getLevelSize(sourceLevel), 1)) {
+            break;
+        }
+
+        levelCount++;
+    }
+
+    if (levelCount == 0) {
+        return;
+    }
+
+    auto uploadBatch = m_uploadContext.beginBatch();
+    uploadBatch.generateMipLevels(m_target, m_submittedLevelCount, levelCount);
+    m_pendingTimelineValue = m_uploadContext.submit(uploadBatch);
+    m_submittedLevelCount += levelCount;
+}
+
+uint32_t MipmapSlicer::getCompletedLevelCount() const {
+    return m_completedLevelCount;
+}
+
+bool MipmapSlicer::isComplete() const {
+    return m_completedLevelCount == m_target.mipLevels;
+}
+
+VkSampler MipmapSlicer::getSampler() const {
+    if (m_samplers.empty()) {
+        return VK_NULL_HANDLE;
+    }
+
+    return m_samplers[m_completedLevelCount - 1];
+}
+
+VkDeviceSize MipmapSlicer::getLevelSize(uint32_t level) const {
+    const auto formatInfo = *TextureFormats::getInfo(m_target.format);
+    const auto width = std::max(m_target.width >> level, 1u);
+    const auto height = std::max(m_target.height >> level, 1u);
+    const auto depth = std::max(m_target.depth >> level, 1u);
+
+    return formatInfo.getLevelSize(width, height) * depth * m_target.layerCount;
+}
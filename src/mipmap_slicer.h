@@ -0,0 +1,76 @@
+#ifndef _MIPMAP_SLICER_H
+#define _MIPMAP_SLICER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "mipmap_generator.h"
+#include "sampler_cache.h"
+#include "upload_batch.h"
+#include "upload_scheduler.h"
+
+
+namespace VulkanEngine {
+
+/// @brief Generates the mip chain of a texture loaded at runtime a few levels at a time,
+/// so that a chain generated mid-session never makes a frame spike.
+///
+/// @note Level 0 goes out with the batch that `beginSlicing` records into. Each update then
+/// submits the next levels in an upload batch of their own, at most `maxLevelsPerFrame` of
+/// them, and only as many as the budget of the upload scheduler takes. A level costs the
+/// bytes of the level it is filtered from, which the blit reads, and a level that is the
+/// first upload of its frame goes out whatever its size, like any upload that cannot be
+/// split. One slice is in flight at a time.
+///
+/// Levels that have not been generated yet are never sampled. Every count of finished
+/// levels has a sampler whose `maxLod` clamps sampling to them, and `getSampler` returns
+/// the sampler of the levels that have finished.
+class MipmapSlicer final {
+    public:
+        explicit MipmapSlicer() = delete;
+        explicit MipmapSlicer(UploadContext& uploadContext, const MipmapTarget& target, uint32_t maxLevelsPerFrame);
+
+        ~MipmapSlicer() = default;
+
+        MipmapSlicer(const MipmapSlicer& other) = delete;
+        MipmapSlicer& operator=(const MipmapSlicer& other) = delete;
+
+        /// @brief Move every level of an image whose level 0 was just copied, and whose
+        /// levels are all in the transfer destination layout, to the shader read-only layout.
+        void beginSlicing(UploadBatch& uploadBatch);
+
+        /// @brief Take one sampler per count of finished levels from `samplerCache`, made
+        /// from `samplerInfo` with its `maxLod` clamped to the last of them.
+        void createSamplers(SamplerCache& samplerCache, const VkSamplerCreateInfo& samplerInfo);
+
+        /// @brief Pick up the slice that finished, and submit the next one, as far as the
+        /// budget of `uploadScheduler` goes.
+        ///
+        /// @note Call this once per frame.
+        void update(UploadScheduler& uploadScheduler);
+
+        /// @brief The levels from level 0 on that hold their texels.
+        uint32_t getCompletedLevelCount() const;
+
+        /// @brief Whether every level of the chain has been generated.
+        bool isComplete() const;
+
+        VkSampler getSampler() const;
+    private:
+        UploadContext& m_uploadContext;
+        MipmapTarget m_target;
+        uint32_t m_maxLevelsPerFrame;
+        std::vector<VkSampler> m_samplers;
+        uint32_t m_completedLevelCount;
+        uint32_t m_submittedLevelCount;
+        std::optional<uint64_t> m_pendingTimelineValue;
+
+        VkDeviceSize getLevelSize(uint32_t level) const;
+};
+
+}
+
+#endif // _MIPMAP_SLICER_H
@@ -0,0 +1,314 @@
+#include "obj_parser.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+
+using ObjParser = VulkanEngine::ObjParser;
+using ObjIndex = VulkanEngine::ObjIndex;
+using ObjShape = VulkanEngine::ObjShape;
+using ObjMesh = VulkanEngine::ObjMesh;
+
+// Files are only split into chunks of at least this size, so small files parse on one
+// thread, and into at most a few chunks per thread, so the workers that finish early
+// steal the rest.
+static constexpr size_t MIN_CHUNK_SIZE = 4 * 1024 * 1024;
+static constexpr size_t CHUNKS_PER_THREAD = 4;
+
+/// @brief An index of a chunk that was negative in the file, and is relative to the
+/// attributes that came before the chunk until it is resolved.
+struct RelativeIndex final {
+    uint32_t shape;
+    size_t index;
+    bool isTexCoord;
+};
+
+/// @brief The attributes and faces of a range of lines of an OBJ file.
+///
+/// @note The first shape of a chunk continues the last shape of the chunk before it,
+/// unless an `o` or `g` statement comes before the first face of the chunk.
+struct ObjChunk final {
+    std::vector<float> positions;
+    std::vector<float> texCoords;
+    std::vector<ObjShape> shapes;
+    bool startsShape;
+    std::vector<RelativeIndex> relativeIndices;
+};
+
+/// @brief One corner of a face, as parsed.
+struct ObjCorner final {
+    ObjIndex index;
+    bool isPositionRelative;
+    bool isTexCoordRelative;
+};
+
+static bool isSpace(char character) {
+    return character == ' ' || character == '\t' || character == '\r';
+}
+
+static const char* skipSpaces(const char* position, const char* end) {
+    while (position < end && isSpace(*position)) {
+        position++;
+    }
+
+    return position;
+}
+
+static const char* skipToken(const char* position, const char* end) {
+    while (position < end && !isSpace(*position)) {
+        position++;
+    }
+
+    return position;
+}
+
+static const char* parseFloat(const char* position, const char* end, float& value) {
+    position = skipSpaces(position, end);
+    if (position < end && *position == '+') {
+        position++;
+    }
+
+    // Values too small or too large for a float come back as out of range, and are as
+    // good as zero or infinity for a mesh.
+    const auto [next, error] = std::from_chars(position, end, value);
+    if (error == std::errc::invalid_argument) {
+        throw std::runtime_error("failed to parse OBJ file: malformed number!");
+    }
+
+    return next;
+}
+
+/// @brief Parse a one-based index, or a negative one relative to the `count` attributes
+/// parsed so far, into a zero-based one.
+static const char* parseIndex(const char* position, const char* end, size_t count, uint32_t& index, bool& isRelative) {
+    auto value = int64_t { 0 };
+    const auto [next, error] = std::from_chars(position, end, value);
+    if (error != std::errc {} || value == 0) {
+        throw std::runtime_error("failed to parse OBJ file: malformed face index!");
+    }
+
+    // Relative indices may reach back past the start of the chunk, so they wrap around
+    // until the chunk offsets are added.
+    isRelative = value < 0;
+    index = value > 0 ? static_cast<uint32_t>(value - 1) : static_cast<uint32_t>(static_cast<int64_t>(count) + value);
+
+    return next;
+}
+
+static const char* parseCorner(const char* position, const char* end, const ObjChunk& chunk, ObjCorner& corner) {
+    corner.index.texCoord = ObjParser::NO_TEX_COORD;
+    corner.isTexCoordRelative = false;
+    position = parseIndex(position, end, chunk.positions.size() / 3, corner.index.position, corner.isPositionRelative);
+    if (position < end && *position == '/') {
+        position++;
+        if (position < end && *position != '/' && !isSpace(*position)) {
+            position = parseIndex(position, end, chunk.texCoords.size() / 2, corner.index.texCoord, corner.isTexCoordRelative);
+        }
+    }
+
+    // Normals are not kept.
+    return skipToken(position, end);
+}
+
+static void addCorner(ObjChunk& chunk, const ObjCorner& corner) {
+    auto& shape = chunk.shapes.back();
+    const auto shapeIndex = static_cast<uint32_t>(chunk.shapes.size() - 1);
+    if (corner.isPositionRelative) {
+        chunk.relativeIndices.push_back(RelativeIndex { shapeIndex, shape.indices.size(), false });
+    }
+
+    if (corner.isTexCoordRelative) {
+        chunk.relativeIndices.push_back(RelativeIndex { shapeIndex, shape.indices.size(), true });
+    }
+
+    shape.indices.push_back(corner.index);
+}
+
+static void parseFace(const char* position, const char* end, ObjChunk& chunk) {
+    auto firstCorner = ObjCorner {};
+    auto previousCorner = ObjCorner {};
+    auto cornerCount = size_t { 0 };
+    for (position = skipSpaces(position, end); position < end; position = skipSpaces(position, end)) {
+        auto corner = ObjCorner {};
+        position = parseCorner(position, end, chunk, corner);
+
+        // Polygons are split into a fan of triangles around their first corner.
+        if (cornerCount >= 2) {
+            addCorner(chunk, firstCorner);
+            addCorner(chunk, previousCorner);
+            addCorner(chunk, corner);
+        }
+
+        if (cornerCount == 0) {
+            firstCorner = corner;
+        }
+
+        previousCorner = corner;
+        cornerCount++;
+    }
+}
+
+static void parseLine(const char* position, const char* end, ObjChunk& chunk) {
+    // A comment may follow the data on any line.
+    const auto* comment = static_cast<const char*>(std::memchr(position, '#', static_cast<size_t>(end - position)));
+    if (comment != nullptr) {
+        end = comment;
+    }
+
+    position = skipSpaces(position, end);
+    if (end - position < 2) {
+        return;
+    }
+
+    if (position[0] == 'v' && isSpace(position[1])) {
+        // Anything after the third coordinate, like a weight or a vertex color, is skipped.
+        auto coordinates = std::array<float, 3> {};
+        position += 1;
+        for (auto& coordinate : coordinates) {
+            position = parseFloat(position, end, coordinate);
+        }
+        chunk.positions.insert(chunk.positions.end(), coordinates.begin(), coordinates.end());
+    } else if (position[0] == 'v' && position[1] == 't' && end - position > 2 && isSpace(position[2])) {
+        // The second coordinate is optional and defaults to zero.
+        auto coordinates = std::array<float, 2> {};
+        position = parseFloat(position + 2, end, coordinates[0]);
+        if (skipSpaces(position, end) < end) {
+            position = parseFloat(position, end, coordinates[1]);
+        }
+        chunk.texCoords.insert(chunk.texCoords.end(), coordinates.begin(), coordinates.end());
+    } else if (position[0] == 'f' && isSpace(position[1])) {
+        parseFace(position + 1, end, chunk);
+    } else if ((position[0] == 'o' || position[0] == 'g') && isSpace(position[1])) {
+        if (!chunk.shapes.back().indices.empty()) {
+            chunk.shapes.emplace_back();
+        } else if (chunk.shapes.size() == 1) {
+            chunk.startsShape = true;
+        }
+    }
+}
+
+static void parseChunk(const char* position, const char* end, ObjChunk& chunk) {
+    chunk.shapes.emplace_back();
+    chunk.startsShape = false;
+    while (position < end) {
+        const auto* lineEnd = static_cast<const char*>(std::memchr(position, '\n', static_cast<size_t>(end - position)));
+        if (lineEnd == nullptr) {
+            lineEnd = end;
+        }
+
+        parseLine(position, lineEnd, chunk);
+        position = lineEnd + 1;
+    }
+}
+
+ObjMesh ObjParser::parse(std::span<const uint8_t> bytes, JobSystem* jobSystem) {
+    const auto* data = reinterpret_cast<const char*>(bytes.data());
+    const auto* dataEnd = data + bytes.size();
+    const auto chunkCount = [&bytes, jobSystem]() -> size_t {
+        if (jobSystem == nullptr) {
+            return 1;
+        }
+
+        const auto maxChunkCount = std::max<size_t>(jobSystem->getThreadCount(), 1) * CHUNKS_PER_THREAD;
+
+        return std::clamp<size_t>(bytes.size() / MIN_CHUNK_SIZE, 1, maxChunkCount);
+    }();
+
+    // Every chunk but the first starts right after a line break.
+    auto chunkStarts = std::vector<const char*>(chunkCount + 1, dataEnd);
+    chunkStarts[0] = data;
+    for (size_t i = 1; i < chunkCount; i++) {
+        const auto* splitPoint = std::max(data + bytes.size() / chunkCount * i, chunkStarts[i - 1]);
+        const auto* lineBreak = static_cast<const char*>(std::memchr(splitPoint, '\n', static_cast<size_t>(dataEnd - splitPoint)));
+        chunkStarts[i] = lineBreak != nullptr ? lineBreak + 1 : dataEnd;
+    }
+
+    auto chunks = std::vector<ObjChunk>(chunkCount);
+    auto parseChunkAt = [&chunkStarts, &chunks](size_t i) {
+        parseChunk(chunkStarts[i], chunkStarts[i + 1], chunks[i]);
+    };
+    if (jobSystem != nullptr && chunkCount > 1) {
+        jobSystem->parallelFor(chunkCount, 1, parseChunkAt);
+    } else {
+        parseChunkAt(0);
+    }
+
+    auto positionOffsets = std::vector<size_t>(chunkCount + 1, 0);
+    auto texCoordOffsets = std::vector<size_t>(chunkCount + 1, 0);
+    for (size_t i = 0; i < chunkCount; i++) {
+        positionOffsets[i + 1] = positionOffsets[i] + chunks[i].positions.size() / 3;
+        texCoordOffsets[i + 1] = texCoordOffsets[i] + chunks[i].texCoords.size() / 2;
+    }
+
+    const auto positionCount = positionOffsets.back();
+    const auto texCoordCount = texCoordOffsets.back();
+    if (positionCount >= NO_TEX_COORD || texCoordCount >= NO_TEX_COORD) {
+        throw std::runtime_error("failed to parse OBJ file: too many vertices!");
+    }
+
+    // Resolve the relative indices of every chunk, and check every index against the
+    // attributes of the whole file.
+    auto mesh = ObjMesh {};
+    mesh.positions.resize(positionCount * 3);
+    mesh.texCoords.resize(texCoordCount * 2);
+    auto resolveChunkAt = [&chunks, &positionOffsets, &texCoordOffsets, &mesh, positionCount, texCoordCount](size_t i) {
+        auto& chunk = chunks[i];
+        for (const auto& relativeIndex : chunk.relativeIndices) {
+            auto& index = chunk.shapes[relativeIndex.shape].indices[relativeIndex.index];
+            if (relativeIndex.isTexCoord) {
+                index.texCoord += static_cast<uint32_t>(texCoordOffsets[i]);
+
+                // One that reaches back past the first coordinate can wrap around onto
+                // `NO_TEX_COORD`, which the check below would let through.
+                if (index.texCoord >= texCoordCount) {
+                    throw std::runtime_error("failed to parse OBJ file: face index out of range!");
+                }
+            } else {
+                index.position += static_cast<uint32_t>(positionOffsets[i]);
+            }
+        }
+
+        for (const auto& shape : chunk.shapes) {
+            for (const auto& index : shape.indices) {
+                const auto isTexCoordValid = index.texCoord == NO_TEX_COORD || index.texCoord < texCoordCount;
+                if (index.position >= positionCount || !isTexCoordValid) {
+                    throw std::runtime_error("failed to parse OBJ file: face index out of range!");
+                }
+            }
+        }
+
+        std::ranges::copy(chunk.positions, mesh.positions.begin() + static_cast<ptrdiff_t>(positionOffsets[i] * 3));
+        std::ranges::copy(chunk.texCoords, mesh.texCoords.begin() + static_cast<ptrdiff_t>(texCoordOffsets[i] * 2));
+        chunk.positions = std::vector<float> {};
+        chunk.texCoords = std::vector<float> {};
+    };
+    if (jobSystem != nullptr && chunkCount > 1) {
+        jobSystem->parallelFor(chunkCount, 1, resolveChunkAt);
+    } else {
+        resolveChunkAt(0);
+    }
+
+    // Stitch the shapes back together in file order.
+    for (auto& chunk : chunks) {
+        for (size_t i = 0; i < chunk.shapes.size(); i++) {
+            auto& shape = chunk.shapes[i];
+            const auto isContinuation = i == 0 && !chunk.startsShape && !mesh.shapes.empty();
+            if (!isContinuation) {
+                mesh.shapes.push_back(std::move(shape));
+            } else if (mesh.shapes.back().indices.empty()) {
+                mesh.shapes.back() = std::move(shape);
+            } else {
+                auto& indices = mesh.shapes.back().indices;
+                indices.insert(indices.end(), shape.indices.begin(), shape.indices.end());
+            }
+        }
+    }
+
+    std::erase_if(mesh.shapes, [](const ObjShape& shape) { return shape.indices.empty(); });
+
+    return mesh;
+}
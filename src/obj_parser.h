@@ -0,0 +1,60 @@
+#ifndef _OBJ_PARSER_H
+#define _OBJ_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "job_system.h"
+
+
+namespace VulkanEngine {
+
+/// @brief The attributes one corner of an OBJ face refers to, as zero-based indices.
+///
+/// @note `texCoord` is `NO_TEX_COORD` when the face names no texture coordinate.
+struct ObjIndex final {
+    uint32_t position = 0;
+    uint32_t texCoord = 0;
+};
+
+/// @brief The triangles of one object or group of an OBJ file, three indices each.
+struct ObjShape final {
+    std::vector<ObjIndex> indices;
+};
+
+/// @brief The positions, texture coordinates and triangulated faces of an OBJ file.
+///
+/// @note `positions` holds three floats per position and `texCoords` two per texture
+/// coordinate, as they appear in the file.
+struct ObjMesh final {
+    std::vector<float> positions;
+    std::vector<float> texCoords;
+    std::vector<ObjShape> shapes;
+};
+
+/// @brief Parses the geometry of Wavefront OBJ files straight out of their bytes.
+///
+/// @note Only what the mesh loader needs is kept: positions, texture coordinates, and
+/// faces, grouped into a shape for every `o` and `g` statement. Normals, materials and the
+/// rest are skipped over without being parsed, and polygons are split into triangle fans.
+/// Numbers are parsed with `std::from_chars`, so nothing is allocated per line and no
+/// locale is consulted.
+///
+/// Given a job system, the file is split at line boundaries into chunks that are parsed in
+/// parallel, and the chunks are stitched back together in file order. Faces that refer to
+/// their attributes relative to the end of the list, with negative indices, are resolved
+/// once every chunk knows how many attributes came before it.
+class ObjParser final {
+    public:
+        static constexpr uint32_t NO_TEX_COORD = 0xffffffff;
+
+        explicit ObjParser() = delete;
+
+        static ObjMesh parse(std::span<const uint8_t> bytes, JobSystem* jobSystem = nullptr);
+};
+
+}
+
+#endif // _OBJ_PARSER_H
@@ -0,0 +1,139 @@
+#include "occlusion_queries.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/core.h>
+
+
+using OcclusionQueries = VulkanEngine::OcclusionQueries;
+
+OcclusionQueries::OcclusionQueries(VkDevice device, GpuMemoryAllocator& allocator, uint32_t objectCount, uint32_t frameCount)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_queryPool { VK_NULL_HANDLE }
+    , m_predicateBuffer { VK_NULL_HANDLE }
+    , m_predicateAllocation {}
+    , m_objectCount { objectCount }
+    , m_frameCount { frameCount }
+{
+    if (objectCount == 0 || frameCount == 0) {
+        throw std::invalid_argument("occlusion queries need at least one object and one frame!");
+    }
+
+    const auto queryPoolInfo = VkQueryPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .queryType = VK_QUERY_TYPE_OCCLUSION,
+        .queryCount = m_objectCount * m_frameCount,
+        .pipelineStatistics = 0,
+    };
+
+    auto queryPool = VkQueryPool {};
+    const auto resultCreateQueryPool = vkCreateQueryPool(m_device, &queryPoolInfo, nullptr, &queryPool);
+    if (resultCreateQueryPool != VK_SUCCESS) {
+        throw std::runtime_error("failed to create occlusion query pool!");
+    }
+
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = this->getPredicateBufferSize(),
+        .usage = VK_BUFFER_USAGE_CONDITIONAL_RENDERING_BIT_EXT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto resultCreateBuffer = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+    if (resultCreateBuffer != VK_SUCCESS) {
+        vkDestroyQueryPool(m_device, queryPool, nullptr);
+        throw std::runtime_error("failed to create occlusion predicate buffer!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    // The predicates are only written on the GPU after this, but mapped memory lets them
+    // start out visible without a transfer of their own.
+    const auto allocation = m_allocator.allocate(
+        memRequirements,
+        m_allocator.selectDynamicMemoryProperties(memRequirements.memoryTypeBits),
+        GpuResourceKind::Linear,
+        GpuMemoryCategory::Other
+    );
+
+    vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+    const auto predicates = std::vector<uint32_t>(m_objectCount, 1);
+    std::memcpy(allocation.mappedData, predicates.data(), predicates.size() * sizeof(uint32_t));
+
+    m_queryPool = queryPool;
+    m_predicateBuffer = buffer;
+    m_predicateAllocation = allocation;
+}
+
+OcclusionQueries::~OcclusionQueries() {
+    vkDestroyBuffer(m_device, m_predicateBuffer, nullptr);
+    m_allocator.free(m_predicateAllocation);
+    vkDestroyQueryPool(m_device, m_queryPool, nullptr);
+
+    m_predicateBuffer = VK_NULL_HANDLE;
+    m_queryPool = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void OcclusionQueries::recordReset(VkCommandBuffer commandBuffer, uint32_t frameIndex) const {
+    if (frameIndex >= m_frameCount) {
+        throw std::invalid_argument {
+            fmt::format("Frame {} is out of range for occlusion queries of {} frames", frameIndex, m_frameCount)
+        };
+    }
+
+    vkCmdResetQueryPool(commandBuffer, m_queryPool, frameIndex * m_objectCount, m_objectCount);
+}
+
+void OcclusionQueries::beginQuery(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t object) const {
+    // Any sample that passes makes the object visible, so the exact count is not needed.
+    vkCmdBeginQuery(commandBuffer, m_queryPool, frameIndex * m_objectCount + object, 0);
+}
+
+void OcclusionQueries::endQuery(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t object) const {
+    vkCmdEndQuery(commandBuffer, m_queryPool, frameIndex * m_objectCount + object);
+}
+
+void OcclusionQueries::recordResolve(VkCommandBuffer commandBuffer, uint32_t frameIndex) const {
+    if (frameIndex >= m_frameCount) {
+        throw std::invalid_argument {
+            fmt::format("Frame {} is out of range for occlusion queries of {} frames", frameIndex, m_frameCount)
+        };
+    }
+
+    // A 32-bit result is a predicate as it is: zero when no sample passed.
+    vkCmdCopyQueryPoolResults(
+        commandBuffer,
+        m_queryPool,
+        frameIndex * m_objectCount,
+        m_objectCount,
+        m_predicateBuffer,
+        0,
+        sizeof(uint32_t),
+        VK_QUERY_RESULT_WAIT_BIT
+    );
+}
+
+VkBuffer OcclusionQueries::getPredicateBuffer() const {
+    return m_predicateBuffer;
+}
+
+VkDeviceSize OcclusionQueries::getPredicateBufferSize() const {
+    return VkDeviceSize { sizeof(uint32_t) } * m_objectCount;
+}
+
+VkDeviceSize OcclusionQueries::getPredicateOffset(uint32_t object) const {
+    return VkDeviceSize { sizeof(uint32_t) } * object;
+}
+
+uint32_t OcclusionQueries::getObjectCount() const {
+    return m_objectCount;
+}
@@ -0,0 +1,67 @@
+#ifndef _OCCLUSION_QUERIES_H
+#define _OCCLUSION_QUERIES_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief An occlusion query for every object of a scene, with one range of queries for
+/// every frame in flight, and a buffer of predicates that the results are resolved into on
+/// the GPU, for `vkCmdBeginConditionalRenderingEXT`.
+///
+/// @note A frame draws every object under its predicate, then draws the bounds of every
+/// object inside its query, and resolves the queries into the predicates, which are read by
+/// the draws of the next frame. The results never come back to the CPU, so nothing waits
+/// on them there, at the cost of an object that comes into view appearing a frame late.
+/// Every predicate is one until its first resolve, so every object is drawn until its
+/// queries have run once. The predicates are shared by every frame, since the frames that
+/// resolve and read them run in submit order.
+class OcclusionQueries final {
+    public:
+        explicit OcclusionQueries() = delete;
+        explicit OcclusionQueries(VkDevice device, GpuMemoryAllocator& allocator, uint32_t objectCount, uint32_t frameCount);
+
+        ~OcclusionQueries();
+
+        OcclusionQueries(const OcclusionQueries& other) = delete;
+        OcclusionQueries& operator=(const OcclusionQueries& other) = delete;
+
+        /// @brief Reset the queries of `frameIndex`, outside of a render pass.
+        void recordReset(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+
+        void beginQuery(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t object) const;
+
+        void endQuery(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t object) const;
+
+        /// @brief Copy the results of the queries of `frameIndex` into the predicates,
+        /// outside of a render pass.
+        ///
+        /// @note The copy waits on the GPU for the queries to finish, and every query of the
+        /// frame must have been reset and then run in the same submit.
+        void recordResolve(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+
+        VkBuffer getPredicateBuffer() const;
+
+        VkDeviceSize getPredicateBufferSize() const;
+
+        VkDeviceSize getPredicateOffset(uint32_t object) const;
+
+        uint32_t getObjectCount() const;
+    private:
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkQueryPool m_queryPool;
+        VkBuffer m_predicateBuffer;
+        GpuAllocation m_predicateAllocation;
+        uint32_t m_objectCount;
+        uint32_t m_frameCount;
+};
+
+}
+
+#endif // _OCCLUSION_QUERIES_H
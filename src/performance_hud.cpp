@@ -0,0 +1,537 @@
+#include "performance_hud.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#include "command_counters.h"
+
+
+using PerformanceHud = VulkanEngine::PerformanceHud;
+using PerformanceHudSeries = VulkanEngine::PerformanceHudSeries;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+/// @brief The pixels of a character, as its rows from top to bottom, lit where they are
+/// ones.
+struct Glyph final {
+    char character;
+    std::string_view rows;
+};
+
+static constexpr auto GLYPHS = std::array<Glyph, 44> {
+    Glyph { '0', "111 101 101 101 111" },
+    Glyph { '1', "010 110 010 010 111" },
+    Glyph { '2', "111 001 111 100 111" },
+    Glyph { '3', "111 001 111 001 111" },
+    Glyph { '4', "101 101 111 001 001" },
+    Glyph { '5', "111 100 111 001 111" },
+    Glyph { '6', "111 100 111 101 111" },
+    Glyph { '7', "111 001 001 001 001" },
+    Glyph { '8', "111 101 111 101 111" },
+    Glyph { '9', "111 101 111 001 111" },
+    Glyph { 'A', "010 101 111 101 101" },
+    Glyph { 'B', "110 101 110 101 110" },
+    Glyph { 'C', "011 100 100 100 011" },
+    Glyph { 'D', "110 101 101 101 110" },
+    Glyph { 'E', "111 100 110 100 111" },
+    Glyph { 'F', "111 100 110 100 100" },
+    Glyph { 'G', "011 100 101 101 011" },
+    Glyph { 'H', "101 101 111 101 101" },
+    Glyph { 'I', "111 010 010 010 111" },
+    Glyph { 'J', "001 001 001 101 010" },
+    Glyph { 'K', "101 101 110 101 101" },
+    Glyph { 'L', "100 100 100 100 111" },
+    Glyph { 'M', "101 111 111 101 101" },
+    Glyph { 'N', "110 101 101 101 101" },
+    Glyph { 'O', "010 101 101 101 010" },
+    Glyph { 'P', "110 101 110 100 100" },
+    Glyph { 'Q', "010 101 101 110 011" },
+    Glyph { 'R', "110 101 110 101 101" },
+    Glyph { 'S', "011 100 010 001 110" },
+    Glyph { 'T', "111 010 010 010 010" },
+    Glyph { 'U', "101 101 101 101 111" },
+    Glyph { 'V', "101 101 101 101 010" },
+    Glyph { 'W', "101 101 111 111 101" },
+    Glyph { 'X', "101 101 010 101 101" },
+    Glyph { 'Y', "101 101 010 010 010" },
+    Glyph { 'Z', "111 001 010 100 111" },
+    Glyph { '.', "000 000 000 000 010" },
+    Glyph { ':', "000 010 000 010 000" },
+    Glyph { '/', "001 001 010 100 100" },
+    Glyph { '%', "101 001 010 100 101" },
+    Glyph { '-', "000 000 111 000 000" },
+    Glyph { '(', "010 100 100 100 010" },
+    Glyph { ')', "010 001 001 001 010" },
+    Glyph { '+', "000 010 111 010 000" },
+};
+
+/// @brief The mask of every ASCII character, with the pixel in row `r` and column `c` at
+/// bit `3 * r + c`, as the fragment shader of the overlay tests it.
+static constexpr auto GLYPH_MASKS = []() {
+    auto masks = std::array<uint16_t, 128> {};
+    for (const auto& glyph : GLYPHS) {
+        auto mask = uint16_t { 0 };
+        auto bit = 0;
+        for (const auto pixel : glyph.rows) {
+            if (pixel == ' ') {
+                continue;
+            }
+            if (pixel == '1') {
+                mask |= static_cast<uint16_t>(1 << bit);
+            }
+            bit++;
+        }
+        masks[static_cast<size_t>(glyph.character)] = mask;
+    }
+
+    return masks;
+}();
+
+// Capitals stand in for lower case letters, and nothing for the characters without a glyph.
+static uint32_t getGlyphMask(char character) {
+    if (character >= 'a' && character <= 'z') {
+        character = static_cast<char>(character - 'a' + 'A');
+    }
+
+    const auto index = static_cast<unsigned char>(character);
+
+    return index < GLYPH_MASKS.size() ? GLYPH_MASKS[index] : 0;
+}
+
+PerformanceHud::PerformanceHud(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    VkPipelineCache pipelineCache,
+    std::span<const uint32_t> vertexShaderCode,
+    std::span<const uint32_t> fragmentShaderCode,
+    VkFormat colorFormat,
+    uint32_t frameCount
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_pipelineLayout { VK_NULL_HANDLE }
+    , m_pipeline { VK_NULL_HANDLE }
+    , m_colorFormat { colorFormat }
+    , m_buffer { VK_NULL_HANDLE }
+    , m_allocation {}
+    , m_frameCount { frameCount }
+    , m_regionSize { 0 }
+    , m_frameIndex { 0 }
+    , m_quadCount { 0 }
+    , m_cpuMilliseconds {}
+    , m_gpuMilliseconds {}
+    , m_graphHead { 0 }
+    , m_graphSampleCount { 0 }
+{
+    if (frameCount == 0) {
+        throw std::invalid_argument("a performance hud needs at least one frame!");
+    }
+
+    this->createPipeline(pipelineCache, vertexShaderCode, fragmentShaderCode, colorFormat);
+    this->createBuffer();
+}
+
+PerformanceHud::~PerformanceHud() {
+    vkDestroyBuffer(m_device, m_buffer, nullptr);
+    m_allocator.free(m_allocation);
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+
+    m_buffer = VK_NULL_HANDLE;
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipelineLayout = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void PerformanceHud::addFrameTimes(double cpuMilliseconds, std::optional<double> gpuMilliseconds) {
+    m_cpuMilliseconds[m_graphHead] = static_cast<float>(cpuMilliseconds);
+    m_gpuMilliseconds[m_graphHead] = gpuMilliseconds.transform([](double milliseconds) {
+        return static_cast<float>(milliseconds);
+    });
+    m_graphHead = (m_graphHead + 1) % GRAPH_LENGTH;
+    m_graphSampleCount = std::min(m_graphSampleCount + 1, GRAPH_LENGTH);
+}
+
+void PerformanceHud::beginFrame(uint32_t frameIndex) {
+    if (frameIndex >= m_frameCount) {
+        throw std::invalid_argument {
+            fmt::format("Frame {} is out of range for a performance hud of {} frames", frameIndex, m_frameCount)
+        };
+    }
+
+    m_frameIndex = frameIndex;
+    m_quadCount = 0;
+}
+
+void PerformanceHud::addRect(float x, float y, float width, float height, uint32_t color) {
+    this->addQuad(x, y, width, height, color, FULL_GLYPH_MASK);
+}
+
+float PerformanceHud::addText(float x, float y, std::string_view text, uint32_t color) {
+    auto characterX = x;
+    for (const auto character : text) {
+        const auto glyphMask = getGlyphMask(character);
+        if (glyphMask != 0) {
+            this->addQuad(characterX, y, 3.0f * GLYPH_SCALE, 5.0f * GLYPH_SCALE, color, glyphMask);
+        }
+        characterX += CHARACTER_ADVANCE;
+    }
+
+    return characterX - x;
+}
+
+void PerformanceHud::addBar(float x, float y, float width, float height, float fraction, uint32_t color) {
+    this->addRect(x, y, width, height, packColor(255, 255, 255, 48));
+    this->addRect(x, y, width * std::clamp(fraction, 0.0f, 1.0f), height, color);
+}
+
+void PerformanceHud::addGraph(float x, float y, float width, float height, PerformanceHudSeries series, double budgetMilliseconds) {
+    this->addRect(x, y, width, height, packColor(0, 0, 0, 160));
+
+    // The graph goes up to twice the budget, so the budget line sits halfway up.
+    const auto scaleMilliseconds = static_cast<float>(2.0 * budgetMilliseconds);
+    const auto barWidth = width / static_cast<float>(GRAPH_LENGTH);
+    const auto firstSample = (m_graphHead + GRAPH_LENGTH - m_graphSampleCount) % GRAPH_LENGTH;
+    const auto firstX = x + width - barWidth * static_cast<float>(m_graphSampleCount);
+    for (uint32_t i = 0; i < m_graphSampleCount; i++) {
+        const auto sample = (firstSample + i) % GRAPH_LENGTH;
+        const auto milliseconds = series == PerformanceHudSeries::Cpu
+            ? std::optional<float> { m_cpuMilliseconds[sample] }
+            : m_gpuMilliseconds[sample];
+        if (!milliseconds.has_value()) {
+            continue;
+        }
+
+        const auto barHeight = height * std::min(*milliseconds / scaleMilliseconds, 1.0f);
+        const auto color = static_cast<double>(*milliseconds) > budgetMilliseconds
+            ? packColor(240, 64, 64, 224)
+            : packColor(96, 224, 96, 224);
+        this->addRect(firstX + barWidth * static_cast<float>(i), y + height - barHeight, barWidth, barHeight, color);
+    }
+
+    this->addRect(x, y + 0.5f * height, width, 1.0f, packColor(255, 255, 255, 128));
+}
+
+void PerformanceHud::endFrame() {
+    const auto regionOffset = m_frameIndex * m_regionSize;
+    const auto drawCommand = VkDrawIndirectCommand {
+        .vertexCount = 6 * m_quadCount,
+        .instanceCount = 1,
+        .firstVertex = 0,
+        .firstInstance = 0,
+    };
+    std::memcpy(static_cast<char*>(m_allocation.mappedData) + regionOffset, &drawCommand, sizeof(drawCommand));
+
+    m_allocator.addDirtyRange(m_allocation, regionOffset, VERTEX_OFFSET + 6 * m_quadCount * sizeof(Vertex));
+    m_allocator.flushDirtyRanges();
+}
+
+void PerformanceHud::record(VkCommandBuffer commandBuffer, uint32_t frameIndex, VkExtent2D extent) const {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+    CommandCounters::add(CommandCounter::PipelineBinds);
+
+    const auto viewport = VkViewport {
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = static_cast<float>(extent.width),
+        .height = static_cast<float>(extent.height),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+    const auto scissor = VkRect2D {
+        .offset = VkOffset2D { 0, 0 },
+        .extent = extent,
+    };
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+    const auto pushConstants = PushConstants {
+        .inverseWidth = 1.0f / static_cast<float>(std::max(extent.width, 1u)),
+        .inverseHeight = 1.0f / static_cast<float>(std::max(extent.height, 1u)),
+    };
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &pushConstants);
+
+    const auto regionOffset = frameIndex * m_regionSize;
+    const auto vertexOffset = regionOffset + VERTEX_OFFSET;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_buffer, &vertexOffset);
+    vkCmdDrawIndirect(commandBuffer, m_buffer, regionOffset, 1, sizeof(VkDrawIndirectCommand));
+    CommandCounters::add(CommandCounter::Draws);
+}
+
+VkFormat PerformanceHud::getColorFormat() const {
+    return m_colorFormat;
+}
+
+void PerformanceHud::createPipeline(
+    VkPipelineCache pipelineCache,
+    std::span<const uint32_t> vertexShaderCode,
+    std::span<const uint32_t> fragmentShaderCode,
+    VkFormat colorFormat
+) {
+    const auto pushConstantRange = VkPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 0,
+        .pSetLayouts = nullptr,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+
+    auto pipelineLayout = VkPipelineLayout {};
+    const auto resultCreatePipelineLayout = vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    if (resultCreatePipelineLayout != VK_SUCCESS) {
+        throw std::runtime_error("failed to create performance hud pipeline layout!");
+    }
+
+    auto shaderModules = std::array<VkShaderModule, 2> { VK_NULL_HANDLE, VK_NULL_HANDLE };
+    const auto shaderCodes = std::array<std::span<const uint32_t>, 2> { vertexShaderCode, fragmentShaderCode };
+    for (size_t i = 0; i < shaderModules.size(); i++) {
+        const auto shaderModuleInfo = VkShaderModuleCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .codeSize = shaderCodes[i].size_bytes(),
+            .pCode = shaderCodes[i].data(),
+        };
+
+        const auto resultCreateShaderModule = vkCreateShaderModule(m_device, &shaderModuleInfo, nullptr, &shaderModules[i]);
+        if (resultCreateShaderModule != VK_SUCCESS) {
+            vkDestroyShaderModule(m_device, shaderModules[0], nullptr);
+            vkDestroyPipelineLayout(m_device, pipelineLayout, nullptr);
+
+            throw std::runtime_error("failed to create performance hud shader module!");
+        }
+    }
+
+    const auto shaderStages = std::array<VkPipelineShaderStageCreateInfo, 2> {
+        VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = shaderModules[0],
+            .pName = "main",
+        },
+        VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = shaderModules[1],
+            .pName = "main",
+        },
+    };
+    const auto bindingDescription = VkVertexInputBindingDescription {
+        .binding = 0,
+        .stride = sizeof(Vertex),
+        .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+    };
+    const auto attributeDescriptions = std::array<VkVertexInputAttributeDescription, 4> {
+        VkVertexInputAttributeDescription {
+            .location = 0,
+            .binding = 0,
+            .format = VK_FORMAT_R32G32_SFLOAT,
+            .offset = offsetof(Vertex, x),
+        },
+        VkVertexInputAttributeDescription {
+            .location = 1,
+            .binding = 0,
+            .format = VK_FORMAT_R32G32_SFLOAT,
+            .offset = offsetof(Vertex, glyphX),
+        },
+        VkVertexInputAttributeDescription {
+            .location = 2,
+            .binding = 0,
+            .format = VK_FORMAT_R8G8B8A8_UNORM,
+            .offset = offsetof(Vertex, color),
+        },
+        VkVertexInputAttributeDescription {
+            .location = 3,
+            .binding = 0,
+            .format = VK_FORMAT_R32_UINT,
+            .offset = offsetof(Vertex, glyphMask),
+        },
+    };
+    const auto vertexInputInfo = VkPipelineVertexInputStateCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .vertexBindingDescriptionCount = 1,
+        .vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
+        .pVertexBindingDescriptions = &bindingDescription,
+        .pVertexAttributeDescriptions = attributeDescriptions.data(),
+    };
+    const auto inputAssembly = VkPipelineInputAssemblyStateCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        .primitiveRestartEnable = VK_FALSE,
+    };
+    const auto viewportState = VkPipelineViewportStateCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1,
+    };
+    const auto rasterizer = VkPipelineRasterizationStateCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .depthClampEnable = VK_FALSE,
+        .rasterizerDiscardEnable = VK_FALSE,
+        .polygonMode = VK_POLYGON_MODE_FILL,
+        .cullMode = VK_CULL_MODE_NONE,
+        .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        .depthBiasEnable = VK_FALSE,
+        .lineWidth = 1.0f,
+    };
+    const auto multisampling = VkPipelineMultisampleStateCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        .sampleShadingEnable = VK_FALSE,
+    };
+    const auto depthStencil = VkPipelineDepthStencilStateCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .depthTestEnable = VK_FALSE,
+        .depthWriteEnable = VK_FALSE,
+        .depthBoundsTestEnable = VK_FALSE,
+        .stencilTestEnable = VK_FALSE,
+    };
+    // The overlay is blended over the frame by its alpha, and leaves the frame's alpha.
+    const auto colorBlendAttachment = VkPipelineColorBlendAttachmentState {
+        .blendEnable = VK_TRUE,
+        .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+        .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+        .colorBlendOp = VK_BLEND_OP_ADD,
+        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+        .alphaBlendOp = VK_BLEND_OP_ADD,
+        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+    };
+    const auto colorBlending = VkPipelineColorBlendStateCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .logicOpEnable = VK_FALSE,
+        .logicOp = VK_LOGIC_OP_COPY,
+        .attachmentCount = 1,
+        .pAttachments = &colorBlendAttachment,
+    };
+    const auto dynamicStates = std::array<VkDynamicState, 2> {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+    };
+    const auto dynamicState = VkPipelineDynamicStateCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+        .pDynamicStates = dynamicStates.data(),
+    };
+    const auto renderingInfo = VkPipelineRenderingCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &colorFormat,
+        .depthAttachmentFormat = VK_FORMAT_UNDEFINED,
+        .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+    };
+    const auto pipelineInfo = VkGraphicsPipelineCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &renderingInfo,
+        .stageCount = static_cast<uint32_t>(shaderStages.size()),
+        .pStages = shaderStages.data(),
+        .pVertexInputState = &vertexInputInfo,
+        .pInputAssemblyState = &inputAssembly,
+        .pViewportState = &viewportState,
+        .pRasterizationState = &rasterizer,
+        .pMultisampleState = &multisampling,
+        .pDepthStencilState = &depthStencil,
+        .pColorBlendState = &colorBlending,
+        .pDynamicState = &dynamicState,
+        .layout = pipelineLayout,
+        .renderPass = VK_NULL_HANDLE,
+        .subpass = 0,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+
+    auto pipeline = VkPipeline {};
+    const auto resultCreatePipeline = vkCreateGraphicsPipelines(m_device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    // The pipeline keeps everything it needs from the shader modules.
+    for (const auto shaderModule : shaderModules) {
+        vkDestroyShaderModule(m_device, shaderModule, nullptr);
+    }
+
+    if (resultCreatePipeline != VK_SUCCESS) {
+        vkDestroyPipelineLayout(m_device, pipelineLayout, nullptr);
+
+        throw std::runtime_error("failed to create performance hud pipeline!");
+    }
+
+    m_pipelineLayout = pipelineLayout;
+    m_pipeline = pipeline;
+}
+
+void PerformanceHud::createBuffer() {
+    // Every region starts at a multiple of the largest `nonCoherentAtomSize` there is, so
+    // flushing one never reaches into the one next to it.
+    const auto regionAlignment = VkDeviceSize { 256 };
+    const auto regionSize = VERTEX_OFFSET + VkDeviceSize { 6 * MAX_QUADS * sizeof(Vertex) };
+    m_regionSize = (regionSize + regionAlignment - 1) / regionAlignment * regionAlignment;
+
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = m_regionSize * m_frameCount,
+        .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto resultCreateBuffer = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+    if (resultCreateBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to create performance hud buffer!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    const auto allocation = m_allocator.allocate(
+        memRequirements,
+        m_allocator.selectDynamicMemoryProperties(memRequirements.memoryTypeBits),
+        GpuResourceKind::Linear,
+        GpuMemoryCategory::Vertex
+    );
+
+    vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+    // Every region draws nothing until its frame writes it.
+    for (uint32_t frame = 0; frame < m_frameCount; frame++) {
+        const auto drawCommand = VkDrawIndirectCommand { 0, 1, 0, 0 };
+        std::memcpy(static_cast<char*>(allocation.mappedData) + frame * m_regionSize, &drawCommand, sizeof(drawCommand));
+    }
+    m_allocator.addDirtyRange(allocation, 0, m_regionSize * m_frameCount);
+    m_allocator.flushDirtyRanges();
+
+    m_buffer = buffer;
+    m_allocation = allocation;
+}
+
+PerformanceHud::Vertex* PerformanceHud::getVertices() const {
+    return reinterpret_cast<Vertex*>(static_cast<char*>(m_allocation.mappedData) + m_frameIndex * m_regionSize + VERTEX_OFFSET);
+}
+
+void PerformanceHud::addQuad(float x, float y, float width, float height, uint32_t color, uint32_t glyphMask) {
+    if (m_quadCount >= MAX_QUADS) {
+        return;
+    }
+
+    // Every corner of a glyph quad is a corner of its three by five pixels.
+    const auto corners = std::array<Vertex, 4> {
+        Vertex { x, y, 0.0f, 0.0f, color, glyphMask },
+        Vertex { x + width, y, 3.0f, 0.0f, color, glyphMask },
+        Vertex { x, y + height, 0.0f, 5.0f, color, glyphMask },
+        Vertex { x + width, y + height, 3.0f, 5.0f, color, glyphMask },
+    };
+    auto* vertices = this->getVertices() + 6 * m_quadCount;
+    vertices[0] = corners[0];
+    vertices[1] = corners[1];
+    vertices[2] = corners[2];
+    vertices[3] = corners[2];
+    vertices[4] = corners[1];
+    vertices[5] = corners[3];
+    m_quadCount++;
+}
@@ -0,0 +1,160 @@
+#ifndef _PERFORMANCE_HUD_H
+#define _PERFORMANCE_HUD_H
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief The frame times a graph of a `PerformanceHud` shows.
+enum class PerformanceHudSeries {
+    Cpu,
+    Gpu
+};
+
+/// @brief An overlay of text, bars and frame time graphs drawn over the finished frame,
+/// built on the CPU every frame into one persistently mapped vertex buffer.
+///
+/// @note Everything the overlay draws is a quad, and text is one quad per character, whose
+/// fragments test the bits of a 3x5 pixel glyph carried in the vertices, so the overlay
+/// needs no font texture and no descriptors. The buffer has one region for every frame in
+/// flight, each starting with the indirect draw of its quads, so that a command buffer
+/// recorded once draws whatever the frame wrote there. A region is rewritten by
+/// `beginFrame`, so it must only be called once the frame's previous submit has finished.
+/// Quads past `MAX_QUADS` in a frame are dropped.
+///
+/// Positions are in pixels from the top left corner of the color attachment, which is
+/// loaded and blended over without depth. The pipeline renders to `colorFormat` with
+/// dynamic rendering.
+class PerformanceHud final {
+    public:
+        static constexpr uint32_t MAX_QUADS = 4096;
+        /// @brief The pixels of a glyph pixel, and the pixels from one character or line to
+        /// the next.
+        static constexpr float GLYPH_SCALE = 2.0f;
+        static constexpr float CHARACTER_ADVANCE = 4.0f * GLYPH_SCALE;
+        static constexpr float LINE_HEIGHT = 7.0f * GLYPH_SCALE;
+        /// @brief The frames a graph shows, one bar each.
+        static constexpr uint32_t GRAPH_LENGTH = 120;
+
+        explicit PerformanceHud() = delete;
+        explicit PerformanceHud(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            VkPipelineCache pipelineCache,
+            std::span<const uint32_t> vertexShaderCode,
+            std::span<const uint32_t> fragmentShaderCode,
+            VkFormat colorFormat,
+            uint32_t frameCount
+        );
+
+        ~PerformanceHud();
+
+        PerformanceHud(const PerformanceHud& other) = delete;
+        PerformanceHud& operator=(const PerformanceHud& other) = delete;
+
+        /// @brief An RGBA color in the byte order of the vertices.
+        static constexpr uint32_t packColor(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha) {
+            return static_cast<uint32_t>(red)
+                | (static_cast<uint32_t>(green) << 8)
+                | (static_cast<uint32_t>(blue) << 16)
+                | (static_cast<uint32_t>(alpha) << 24);
+        }
+
+        /// @brief Add the CPU and GPU times of a frame to the graphs, without a GPU time
+        /// until a frame of it has been resolved.
+        void addFrameTimes(double cpuMilliseconds, std::optional<double> gpuMilliseconds);
+
+        /// @brief Start writing the quads of `frameIndex`, dropping those it wrote the last
+        /// time.
+        void beginFrame(uint32_t frameIndex);
+
+        void addRect(float x, float y, float width, float height, uint32_t color);
+
+        /// @brief Add a line of text with its top left corner at `x` and `y`, in capitals,
+        /// and return the width it takes.
+        ///
+        /// @note Lower case letters are drawn as capitals, and characters without a glyph
+        /// as spaces.
+        float addText(float x, float y, std::string_view text, uint32_t color);
+
+        /// @brief Add a bar filled from the left to `fraction` of its width, clamped to a
+        /// full bar.
+        void addBar(float x, float y, float width, float height, float fraction, uint32_t color);
+
+        /// @brief Add a graph of the frame times of `series`, the newest on the right, with
+        /// a line at `budgetMilliseconds` halfway up and the frames over it in red.
+        void addGraph(float x, float y, float width, float height, PerformanceHudSeries series, double budgetMilliseconds);
+
+        /// @brief Finish the quads of the current frame, and make them visible to the GPU.
+        void endFrame();
+
+        /// @brief Record the draw of the quads of `frameIndex` over an attachment of
+        /// `extent`, inside of rendering.
+        void record(VkCommandBuffer commandBuffer, uint32_t frameIndex, VkExtent2D extent) const;
+
+        /// @brief The format of the color attachments the pipeline renders to.
+        VkFormat getColorFormat() const;
+    private:
+        struct Vertex final {
+            float x;
+            float y;
+            /// @brief Where the vertex is in the glyph, in glyph pixels.
+            float glyphX;
+            float glyphY;
+            uint32_t color;
+            /// @brief The lit pixels of the glyph, row by row from the top left.
+            uint32_t glyphMask;
+        };
+
+        struct PushConstants final {
+            float inverseWidth;
+            float inverseHeight;
+        };
+
+        /// @brief The region of a frame holds its draw first, then its vertices.
+        static constexpr VkDeviceSize VERTEX_OFFSET = 16;
+        static constexpr uint32_t FULL_GLYPH_MASK = 0x7fff;
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkPipelineLayout m_pipelineLayout;
+        VkPipeline m_pipeline;
+        VkFormat m_colorFormat;
+        VkBuffer m_buffer;
+        GpuAllocation m_allocation;
+        uint32_t m_frameCount;
+        VkDeviceSize m_regionSize;
+        uint32_t m_frameIndex;
+        uint32_t m_quadCount;
+        std::array<float, GRAPH_LENGTH> m_cpuMilliseconds;
+        std::array<std::optional<float>, GRAPH_LENGTH> m_gpuMilliseconds;
+        /// @brief Where the next frame times go in the graphs, which start at the oldest.
+        uint32_t m_graphHead;
+        uint32_t m_graphSampleCount;
+
+        void createPipeline(
+            VkPipelineCache pipelineCache,
+            std::span<const uint32_t> vertexShaderCode,
+            std::span<const uint32_t> fragmentShaderCode,
+            VkFormat colorFormat
+        );
+
+        void createBuffer();
+
+        Vertex* getVertices() const;
+
+        void addQuad(float x, float y, float width, float height, uint32_t color, uint32_t glyphMask);
+};
+
+}
+
+#endif // _PERFORMANCE_HUD_H
@@ -0,0 +1,189 @@
+#include "pipeline_cache.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include "cache_source_key.h"
+
+
+using CacheSourceKey = VulkanEngine::CacheSourceKey;
+using PipelineCache = VulkanEngine::PipelineCache;
+
+// The cache file is a header followed by the data returned by `vkGetPipelineCacheData`.
+// Any change to that layout must bump the version so stale files are discarded.
+static constexpr uint32_t CACHE_FILE_MAGIC = 0x454e5050; // "PPNE"
+static constexpr uint32_t CACHE_FILE_VERSION = 1;
+
+struct CacheFileHeader final {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    std::array<uint8_t, VK_UUID_SIZE> pipelineCacheUUID;
+    uint64_t dataSize;
+    uint64_t dataHash;
+};
+
+static CacheFileHeader createCacheFileHeader(VkPhysicalDevice physicalDevice, const std::vector<uint8_t>& data) {
+    auto physicalDeviceProperties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+
+    auto header = CacheFileHeader {
+        .magic = CACHE_FILE_MAGIC,
+        .version = CACHE_FILE_VERSION,
+        .vendorID = physicalDeviceProperties.vendorID,
+        .deviceID = physicalDeviceProperties.deviceID,
+        .driverVersion = physicalDeviceProperties.driverVersion,
+        .pipelineCacheUUID = {},
+        .dataSize = data.size(),
+        .dataHash = CacheSourceKey::hashBytes(data.data(), data.size(), CacheSourceKey::FNV_OFFSET_BASIS),
+    };
+    std::memcpy(header.pipelineCacheUUID.data(), physicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    return header;
+}
+
+/// @brief Read the cache data stored for `physicalDevice`, or nothing when the file is
+/// missing, corrupt or was written by another device or driver.
+static std::vector<uint8_t> loadCacheData(VkPhysicalDevice physicalDevice, const std::filesystem::path& filePath) {
+    auto file = std::ifstream { filePath, std::ios::binary };
+    if (!file.is_open()) {
+        return std::vector<uint8_t> {};
+    }
+
+    const auto fileData = std::vector<uint8_t> { std::istreambuf_iterator<char> { file }, std::istreambuf_iterator<char> {} };
+    auto header = CacheFileHeader {};
+    if (fileData.size() < sizeof(header)) {
+        return std::vector<uint8_t> {};
+    }
+
+    std::memcpy(&header, fileData.data(), sizeof(header));
+    if (header.magic != CACHE_FILE_MAGIC || header.version != CACHE_FILE_VERSION) {
+        return std::vector<uint8_t> {};
+    }
+
+    if (header.dataSize != fileData.size() - sizeof(header)) {
+        return std::vector<uint8_t> {};
+    }
+
+    auto data = std::vector<uint8_t>(fileData.begin() + sizeof(header), fileData.end());
+    const auto expectedHeader = createCacheFileHeader(physicalDevice, data);
+    const auto isCompatible = header.vendorID == expectedHeader.vendorID &&
+        header.deviceID == expectedHeader.deviceID &&
+        header.driverVersion == expectedHeader.driverVersion &&
+        header.pipelineCacheUUID == expectedHeader.pipelineCacheUUID &&
+        header.dataHash == expectedHeader.dataHash;
+    if (!isCompatible) {
+        return std::vector<uint8_t> {};
+    }
+
+    // The data carries a header of its own, which has to agree with the device too.
+    auto dataHeader = VkPipelineCacheHeaderVersionOne {};
+    if (data.size() < sizeof(dataHeader)) {
+        return std::vector<uint8_t> {};
+    }
+
+    std::memcpy(&dataHeader, data.data(), sizeof(dataHeader));
+    const auto isDataHeaderValid = dataHeader.headerSize >= sizeof(dataHeader) &&
+        dataHeader.headerSize <= data.size() &&
+        dataHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        dataHeader.vendorID == expectedHeader.vendorID &&
+        dataHeader.deviceID == expectedHeader.deviceID &&
+        std::memcmp(dataHeader.pipelineCacheUUID, expectedHeader.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+    if (!isDataHeaderValid) {
+        return std::vector<uint8_t> {};
+    }
+
+    return data;
+}
+
+PipelineCache::PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const std::filesystem::path& filePath)
+    : m_physicalDevice { physicalDevice }
+    , m_device { device }
+    , m_pipelineCache { VK_NULL_HANDLE }
+    , m_filePath { filePath }
+{
+    const auto initialData = loadCacheData(physicalDevice, filePath);
+    const auto createInfo = VkPipelineCacheCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .initialDataSize = initialData.size(),
+        .pInitialData = initialData.empty() ? nullptr : initialData.data(),
+    };
+
+    auto pipelineCache = VkPipelineCache {};
+    const auto result = vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+
+    m_pipelineCache = pipelineCache;
+}
+
+PipelineCache::~PipelineCache() {
+    vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+
+    m_pipelineCache = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+    m_physicalDevice = VK_NULL_HANDLE;
+}
+
+VkPipelineCache PipelineCache::getHandle() const {
+    return m_pipelineCache;
+}
+
+void PipelineCache::store() const {
+    auto dataSize = size_t { 0 };
+    const auto resultGetDataSize = vkGetPipelineCacheData(m_device, m_pipelineCache, &dataSize, nullptr);
+    if (resultGetDataSize != VK_SUCCESS) {
+        throw std::runtime_error("failed to get pipeline cache data!");
+    }
+
+    auto data = std::vector<uint8_t>(dataSize);
+    const auto resultGetData = vkGetPipelineCacheData(m_device, m_pipelineCache, &dataSize, data.data());
+    if (resultGetData != VK_SUCCESS) {
+        throw std::runtime_error("failed to get pipeline cache data!");
+    }
+    data.resize(dataSize);
+
+    auto errorCode = std::error_code {};
+    if (m_filePath.has_parent_path()) {
+        std::filesystem::create_directories(m_filePath.parent_path(), errorCode);
+        if (errorCode) {
+            throw std::runtime_error("failed to create pipeline cache directory!");
+        }
+    }
+
+    const auto header = createCacheFileHeader(m_physicalDevice, data);
+
+    // Write to a temporary file first so a crash mid-write never leaves a truncated cache
+    // behind under the real name.
+    auto temporaryPath = m_filePath;
+    temporaryPath += ".tmp";
+    {
+        auto file = std::ofstream { temporaryPath, std::ios::binary | std::ios::trunc };
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open pipeline cache file for writing!");
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            throw std::runtime_error("failed to write pipeline cache file!");
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, m_filePath, errorCode);
+    if (errorCode) {
+        std::filesystem::remove(temporaryPath, errorCode);
+
+        throw std::runtime_error("failed to write pipeline cache file!");
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef _PIPELINE_CACHE_H
+#define _PIPELINE_CACHE_H
+
+#include <vulkan/vulkan.h>
+
+#include <filesystem>
+
+
+namespace VulkanEngine {
+
+/// @brief A `VkPipelineCache` that persists across runs in a file on disk.
+///
+/// @note The file stores the vendor, device and driver version and the pipeline cache UUID
+/// of the device that wrote it, followed by the cache data and its hash. Data written by
+/// another device or driver, or that fails the hash, is discarded and the cache starts out
+/// empty, since drivers are not required to reject foreign data safely.
+class PipelineCache final {
+    public:
+        explicit PipelineCache() = delete;
+        explicit PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const std::filesystem::path& filePath);
+
+        ~PipelineCache();
+
+        PipelineCache(const PipelineCache& other) = delete;
+        PipelineCache& operator=(const PipelineCache& other) = delete;
+
+        VkPipelineCache getHandle() const;
+
+        /// @brief Write the cache back to its file.
+        ///
+        /// @note The data is written to a temporary file that then replaces the old one, so
+        /// a crash mid-write keeps the previous cache intact.
+        void store() const;
+    private:
+        VkPhysicalDevice m_physicalDevice;
+        VkDevice m_device;
+        VkPipelineCache m_pipelineCache;
+        std::filesystem::path m_filePath;
+};
+
+}
+
+#endif // _PIPELINE_CACHE_H
@@ -0,0 +1,143 @@
+#include "pipeline_compiler.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+
+using PipelineCompiler = VulkanEngine::PipelineCompiler;
+using PipelineHandle = VulkanEngine::PipelineHandle;
+
+PipelineCompiler::PipelineCompiler(VkDevice device, VkPipelineCache pipelineCache, uint32_t threadCount)
+    : m_device { device }
+    , m_pipelineCache { pipelineCache }
+    , m_runningCount { 0 }
+    , m_isStopping { false }
+{
+    for (uint32_t i = 0; i < std::max(threadCount, 1u); i++) {
+        m_workers.emplace_back([this]() { this->run(); });
+    }
+}
+
+PipelineCompiler::~PipelineCompiler() {
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        m_isStopping = true;
+        m_builds.clear();
+    }
+
+    m_workAvailable.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+
+    for (const auto& entry : m_entries) {
+        vkDestroyPipeline(m_device, entry.pipeline, nullptr);
+    }
+
+    m_entries.clear();
+    m_pipelineCache = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+PipelineHandle PipelineCompiler::enqueue(PipelineBuilder builder) {
+    auto handle = INVALID_HANDLE;
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        handle = static_cast<PipelineHandle>(m_entries.size());
+        m_entries.push_back(PipelineEntry {});
+        m_builds.push_back(PipelineBuild { .handle = handle, .builder = std::move(builder) });
+    }
+
+    m_workAvailable.notify_one();
+
+    return handle;
+}
+
+VkPipeline PipelineCompiler::tryGet(PipelineHandle handle) const {
+    const auto lock = std::lock_guard<std::mutex> { m_mutex };
+    const auto& entry = this->getEntry(handle);
+    if (entry.error) {
+        std::rethrow_exception(entry.error);
+    }
+
+    return entry.pipeline;
+}
+
+bool PipelineCompiler::isDone(PipelineHandle handle) const {
+    const auto lock = std::lock_guard<std::mutex> { m_mutex };
+
+    return this->getEntry(handle).isDone;
+}
+
+VkPipeline PipelineCompiler::wait(PipelineHandle handle) const {
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+    m_buildFinished.wait(lock, [this, handle]() { return this->getEntry(handle).isDone; });
+
+    const auto& entry = this->getEntry(handle);
+    if (entry.error) {
+        std::rethrow_exception(entry.error);
+    }
+
+    return entry.pipeline;
+}
+
+void PipelineCompiler::waitIdle() const {
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+    m_buildFinished.wait(lock, [this]() { return m_builds.empty() && m_runningCount == 0; });
+}
+
+void PipelineCompiler::destroyPipeline(PipelineHandle handle) {
+    if (handle == INVALID_HANDLE) {
+        return;
+    }
+
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+    m_buildFinished.wait(lock, [this, handle]() { return this->getEntry(handle).isDone; });
+
+    auto& entry = m_entries[handle];
+    vkDestroyPipeline(m_device, entry.pipeline, nullptr);
+    entry.pipeline = VK_NULL_HANDLE;
+}
+
+const PipelineCompiler::PipelineEntry& PipelineCompiler::getEntry(PipelineHandle handle) const {
+    if (handle >= m_entries.size()) {
+        throw std::invalid_argument("unknown pipeline handle!");
+    }
+
+    return m_entries[handle];
+}
+
+void PipelineCompiler::run() {
+    while (true) {
+        auto lock = std::unique_lock<std::mutex> { m_mutex };
+        m_workAvailable.wait(lock, [this]() { return m_isStopping || !m_builds.empty(); });
+        if (m_isStopping) {
+            return;
+        }
+
+        auto build = std::move(m_builds.front());
+        m_builds.pop_front();
+        m_runningCount++;
+        lock.unlock();
+
+        auto pipeline = VkPipeline { VK_NULL_HANDLE };
+        auto error = std::exception_ptr { nullptr };
+        try {
+            pipeline = build.builder(m_device, m_pipelineCache);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        m_entries[build.handle] = PipelineEntry {
+            .pipeline = pipeline,
+            .error = error,
+            .isDone = true,
+        };
+        m_runningCount--;
+        lock.unlock();
+
+        m_buildFinished.notify_all();
+    }
+}
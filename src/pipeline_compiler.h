@@ -0,0 +1,101 @@
+#ifndef _PIPELINE_COMPILER_H
+#define _PIPELINE_COMPILER_H
+
+#include <vulkan/vulkan.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief Identifies a pipeline enqueued on a `PipelineCompiler`.
+using PipelineHandle = uint32_t;
+
+/// @brief Creates pipelines on a pool of worker threads against a shared pipeline cache.
+///
+/// @note Pipelines are built by callbacks that run on a worker, so everything a callback
+/// points its create info at has to live inside the callback, and every object it refers
+/// to, like a pipeline layout or a render pass, has to outlive the build. Pipeline caches
+/// are internally synchronized, so the workers share one.
+///
+/// The frame loop polls `tryGet` and draws with a fallback, or skips the draw, until a
+/// pipeline is ready, so compiling never stalls it. The compiler owns the pipelines it
+/// builds, and destroys any that are left when it is destroyed.
+class PipelineCompiler final {
+    public:
+        using PipelineBuilder = std::function<VkPipeline(VkDevice device, VkPipelineCache pipelineCache)>;
+
+        static constexpr PipelineHandle INVALID_HANDLE = std::numeric_limits<PipelineHandle>::max();
+
+        explicit PipelineCompiler() = delete;
+        explicit PipelineCompiler(VkDevice device, VkPipelineCache pipelineCache, uint32_t threadCount);
+
+        /// @brief Drop the builds that have not started, wait for the running ones, and
+        /// destroy every pipeline.
+        ~PipelineCompiler();
+
+        PipelineCompiler(const PipelineCompiler& other) = delete;
+        PipelineCompiler& operator=(const PipelineCompiler& other) = delete;
+
+        PipelineHandle enqueue(PipelineBuilder builder);
+
+        /// @brief The pipeline, or `VK_NULL_HANDLE` while it is still being built.
+        ///
+        /// @note A build that failed rethrows its error here.
+        VkPipeline tryGet(PipelineHandle handle) const;
+
+        /// @brief Whether the build has finished, whether or not it failed.
+        bool isDone(PipelineHandle handle) const;
+
+        /// @brief Wait for the pipeline to be built.
+        ///
+        /// @note A build that failed rethrows its error here.
+        VkPipeline wait(PipelineHandle handle) const;
+
+        /// @brief Wait for every enqueued build to finish.
+        void waitIdle() const;
+
+        /// @brief Wait for the pipeline to be built, then destroy it.
+        ///
+        /// @note Does nothing for `INVALID_HANDLE`, like `vkDestroyPipeline` does for a null
+        /// pipeline.
+        void destroyPipeline(PipelineHandle handle);
+    private:
+        struct PipelineEntry final {
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            std::exception_ptr error = nullptr;
+            bool isDone = false;
+        };
+
+        struct PipelineBuild final {
+            PipelineHandle handle;
+            PipelineBuilder builder;
+        };
+
+        VkDevice m_device;
+        VkPipelineCache m_pipelineCache;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_workAvailable;
+        mutable std::condition_variable m_buildFinished;
+        std::deque<PipelineBuild> m_builds;
+        std::vector<PipelineEntry> m_entries;
+        size_t m_runningCount;
+        bool m_isStopping;
+        std::vector<std::thread> m_workers;
+
+        const PipelineEntry& getEntry(PipelineHandle handle) const;
+
+        void run();
+};
+
+}
+
+#endif // _PIPELINE_COMPILER_H
@@ -0,0 +1,140 @@
+#include "pipeline_layout_cache.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+
+using PipelineLayoutCache = VulkanEngine::PipelineLayoutCache;
+
+PipelineLayoutCache::PipelineLayoutCache(VkDevice device)
+    : m_device { device }
+    , m_descriptorSetLayouts {}
+    , m_pipelineLayouts {}
+{}
+
+PipelineLayoutCache::~PipelineLayoutCache() {
+    for (const auto& [state, pipelineLayout] : m_pipelineLayouts) {
+        vkDestroyPipelineLayout(m_device, pipelineLayout, nullptr);
+    }
+    for (const auto& [state, descriptorSetLayout] : m_descriptorSetLayouts) {
+        vkDestroyDescriptorSetLayout(m_device, descriptorSetLayout, nullptr);
+    }
+
+    m_pipelineLayouts.clear();
+    m_descriptorSetLayouts.clear();
+    m_device = VK_NULL_HANDLE;
+}
+
+VkDescriptorSetLayout PipelineLayoutCache::getDescriptorSetLayout(VkDescriptorSetLayoutCreateFlags flags, std::span<const DescriptorSetLayoutBinding> bindings) {
+    auto state = SetLayoutState {
+        .flags = flags,
+        .bindings = {},
+    };
+    state.bindings.reserve(bindings.size());
+    for (const auto& binding : bindings) {
+        if (binding.descriptorCount == 0) {
+            throw std::invalid_argument("pipeline layout cache needs a descriptor count for every binding!");
+        }
+
+        state.bindings.push_back(BindingState {
+            .binding = binding.binding,
+            .descriptorType = binding.descriptorType,
+            .descriptorCount = binding.descriptorCount,
+            .stageFlags = binding.stageFlags,
+            .bindingFlags = binding.bindingFlags,
+        });
+    }
+
+    const auto found = m_descriptorSetLayouts.find(state);
+    if (found != m_descriptorSetLayouts.end()) {
+        return found->second;
+    }
+
+    auto layoutBindings = std::vector<VkDescriptorSetLayoutBinding> {};
+    auto bindingFlags = std::vector<VkDescriptorBindingFlags> {};
+    layoutBindings.reserve(state.bindings.size());
+    bindingFlags.reserve(state.bindings.size());
+    for (const auto& binding : state.bindings) {
+        layoutBindings.push_back(VkDescriptorSetLayoutBinding {
+            .binding = binding.binding,
+            .descriptorType = binding.descriptorType,
+            .descriptorCount = binding.descriptorCount,
+            .stageFlags = binding.stageFlags,
+            .pImmutableSamplers = nullptr,
+        });
+        bindingFlags.push_back(binding.bindingFlags);
+    }
+
+    const auto hasBindingFlags = std::any_of(bindingFlags.begin(), bindingFlags.end(), [](auto flags) {
+        return flags != 0;
+    });
+    const auto bindingFlagsInfo = VkDescriptorSetLayoutBindingFlagsCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+        .pBindingFlags = bindingFlags.data(),
+    };
+    const auto layoutInfo = VkDescriptorSetLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = hasBindingFlags ? &bindingFlagsInfo : nullptr,
+        .flags = state.flags,
+        .bindingCount = static_cast<uint32_t>(layoutBindings.size()),
+        .pBindings = layoutBindings.data(),
+    };
+
+    auto descriptorSetLayout = VkDescriptorSetLayout {};
+    const auto result = vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &descriptorSetLayout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+
+    m_descriptorSetLayouts.emplace(std::move(state), descriptorSetLayout);
+
+    return descriptorSetLayout;
+}
+
+VkPipelineLayout PipelineLayoutCache::getPipelineLayout(std::span<const VkDescriptorSetLayout> setLayouts, std::span<const VkPushConstantRange> pushConstantRanges) {
+    auto state = PipelineLayoutState {
+        .setLayouts = std::vector<VkDescriptorSetLayout>(setLayouts.begin(), setLayouts.end()),
+        .pushConstantRanges = {},
+    };
+    state.pushConstantRanges.reserve(pushConstantRanges.size());
+    for (const auto& range : pushConstantRanges) {
+        state.pushConstantRanges.push_back(PushConstantRangeState {
+            .stageFlags = range.stageFlags,
+            .offset = range.offset,
+            .size = range.size,
+        });
+    }
+
+    const auto found = m_pipelineLayouts.find(state);
+    if (found != m_pipelineLayouts.end()) {
+        return found->second;
+    }
+
+    const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+        .pSetLayouts = setLayouts.data(),
+        .pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size()),
+        .pPushConstantRanges = pushConstantRanges.data(),
+    };
+
+    auto pipelineLayout = VkPipelineLayout {};
+    const auto result = vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+
+    m_pipelineLayouts.emplace(std::move(state), pipelineLayout);
+
+    return pipelineLayout;
+}
+
+uint32_t PipelineLayoutCache::getDescriptorSetLayoutCount() const {
+    return static_cast<uint32_t>(m_descriptorSetLayouts.size());
+}
+
+uint32_t PipelineLayoutCache::getPipelineLayoutCount() const {
+    return static_cast<uint32_t>(m_pipelineLayouts.size());
+}
@@ -0,0 +1,94 @@
+#ifndef _PIPELINE_LAYOUT_CACHE_H
+#define _PIPELINE_LAYOUT_CACHE_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <map>
+#include <span>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief A binding of a set layout, with the flags of the binding.
+struct DescriptorSetLayoutBinding final {
+    uint32_t binding;
+    VkDescriptorType descriptorType;
+    uint32_t descriptorCount;
+    VkShaderStageFlags stageFlags;
+    VkDescriptorBindingFlags bindingFlags = 0;
+};
+
+/// @brief Hands out one descriptor set layout for every distinct set of bindings, and one
+/// pipeline layout for every distinct list of set layouts and push constant ranges.
+///
+/// @note A set layout is keyed by its flags and every field of its bindings, a pipeline
+/// layout by its set layouts and push constant ranges, so pipelines built from the same
+/// reflected shader interface share their layouts, and with them stay compatible when a
+/// command buffer switches between them. The cache owns its layouts and destroys them with
+/// itself, pipeline layouts first.
+class PipelineLayoutCache final {
+    public:
+        explicit PipelineLayoutCache() = delete;
+        explicit PipelineLayoutCache(VkDevice device);
+
+        ~PipelineLayoutCache();
+
+        PipelineLayoutCache(const PipelineLayoutCache& other) = delete;
+        PipelineLayoutCache& operator=(const PipelineLayoutCache& other) = delete;
+
+        /// @brief The set layout of `bindings` with `flags`, created the first time it is
+        /// asked for.
+        ///
+        /// @note The binding flags are only chained when one of them is set.
+        VkDescriptorSetLayout getDescriptorSetLayout(VkDescriptorSetLayoutCreateFlags flags, std::span<const DescriptorSetLayoutBinding> bindings);
+
+        /// @brief The pipeline layout of `setLayouts` and `pushConstantRanges`, created the
+        /// first time it is asked for.
+        VkPipelineLayout getPipelineLayout(std::span<const VkDescriptorSetLayout> setLayouts, std::span<const VkPushConstantRange> pushConstantRanges);
+
+        uint32_t getDescriptorSetLayoutCount() const;
+
+        uint32_t getPipelineLayoutCount() const;
+    private:
+        struct BindingState final {
+            uint32_t binding;
+            VkDescriptorType descriptorType;
+            uint32_t descriptorCount;
+            VkShaderStageFlags stageFlags;
+            VkDescriptorBindingFlags bindingFlags;
+
+            auto operator<=>(const BindingState& other) const = default;
+        };
+
+        struct SetLayoutState final {
+            VkDescriptorSetLayoutCreateFlags flags;
+            std::vector<BindingState> bindings;
+
+            auto operator<=>(const SetLayoutState& other) const = default;
+        };
+
+        struct PushConstantRangeState final {
+            VkShaderStageFlags stageFlags;
+            uint32_t offset;
+            uint32_t size;
+
+            auto operator<=>(const PushConstantRangeState& other) const = default;
+        };
+
+        struct PipelineLayoutState final {
+            std::vector<VkDescriptorSetLayout> setLayouts;
+            std::vector<PushConstantRangeState> pushConstantRanges;
+
+            auto operator<=>(const PipelineLayoutState& other) const = default;
+        };
+
+        VkDevice m_device;
+        std::map<SetLayoutState, VkDescriptorSetLayout> m_descriptorSetLayouts;
+        std::map<PipelineLayoutState, VkPipelineLayout> m_pipelineLayouts;
+};
+
+}
+
+#endif // _PIPELINE_LAYOUT_CACHE_H
@@ -0,0 +1,239 @@
+#include "queue_submitter.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "command_counters.h"
+#include "device_lost_error.h"
+
+
+using QueueSubmitter = VulkanEngine::QueueSubmitter;
+using QueueSubmission = VulkanEngine::QueueSubmission;
+using SemaphoreSubmit = VulkanEngine::SemaphoreSubmit;
+using DeviceDispatch = VulkanEngine::DeviceDispatch;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+using DeviceLostError = VulkanEngine::DeviceLostError;
+
+// The legacy stage bits have the same values in the synchronization2 masks. A wait of no
+// stage in particular is only valid with synchronization2, so it waits for every stage.
+static VkPipelineStageFlags toLegacyWaitStages(VkPipelineStageFlags2 stages) {
+    const auto legacyStages = static_cast<VkPipelineStageFlags>(stages & 0xffffffffull);
+    if (legacyStages == 0) {
+        return VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    }
+
+    return legacyStages;
+}
+
+static void checkSubmitResult(VkResult result) {
+    if (result == VK_ERROR_DEVICE_LOST) {
+        throw DeviceLostError("failed to submit to queue: the device was lost!");
+    }
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit to queue!");
+    }
+}
+
+QueueSubmitter::QueueSubmitter(const DeviceDispatch& dispatch, bool useSynchronization2, uint32_t deviceCount)
+    : m_dispatch { dispatch }
+    , m_useSynchronization2 { useSynchronization2 }
+    , m_deviceCount { deviceCount }
+    , m_batchDepth { 0 }
+    , m_queueBatches { std::vector<QueueBatch> {} }
+    , m_submitCallCount { 0 }
+{
+}
+
+void QueueSubmitter::beginBatch() {
+    m_batchDepth++;
+}
+
+void QueueSubmitter::endBatch() {
+    if (m_batchDepth == 0) {
+        throw std::logic_error("queue submitter batch ended without being begun!");
+    }
+
+    m_batchDepth--;
+    if (m_batchDepth == 0) {
+        this->flush();
+    }
+}
+
+void QueueSubmitter::submit(VkQueue queue, QueueSubmission submission) {
+    auto queueBatch = std::find_if(m_queueBatches.begin(), m_queueBatches.end(), [queue](const QueueBatch& batch) {
+        return batch.queue == queue;
+    });
+    if (queueBatch == m_queueBatches.end()) {
+        m_queueBatches.push_back(QueueBatch { queue, std::vector<QueueSubmission> {} });
+        queueBatch = std::prev(m_queueBatches.end());
+    }
+    queueBatch->submissions.push_back(std::move(submission));
+
+    if (m_batchDepth == 0) {
+        this->flush();
+    }
+}
+
+void QueueSubmitter::flush() {
+    // The batches are taken first, so that a failed submit does not leave them to be
+    // submitted a second time.
+    const auto queueBatches = std::exchange(m_queueBatches, std::vector<QueueBatch> {});
+    for (const auto& queueBatch : queueBatches) {
+        if (m_useSynchronization2) {
+            this->submitQueue(queueBatch.queue, queueBatch.submissions);
+        } else {
+            this->submitQueueLegacy(queueBatch.queue, queueBatch.submissions);
+        }
+        m_submitCallCount++;
+    }
+}
+
+bool QueueSubmitter::hasPending() const {
+    return !m_queueBatches.empty();
+}
+
+uint64_t QueueSubmitter::getSubmitCallCount() const {
+    return m_submitCallCount;
+}
+
+void QueueSubmitter::submitQueue(VkQueue queue, const std::vector<QueueSubmission>& submissions) {
+    const auto toSemaphoreInfo = [this](const SemaphoreSubmit& semaphoreSubmit) {
+        return VkSemaphoreSubmitInfo {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = semaphoreSubmit.semaphore,
+            .value = semaphoreSubmit.value,
+            .stageMask = semaphoreSubmit.stageMask,
+            .deviceIndex = m_deviceCount > 1 ? semaphoreSubmit.deviceIndex : 0,
+        };
+    };
+
+    // Every submission's infos go into one array each, and the submit infos point into
+    // them, so they are sized up front and never move.
+    auto waitCount = size_t { 0 };
+    auto commandBufferCount = size_t { 0 };
+    auto signalCount = size_t { 0 };
+    for (const auto& submission : submissions) {
+        waitCount += submission.waits.size();
+        commandBufferCount += submission.commandBuffers.size();
+        signalCount += submission.signals.size();
+    }
+
+    auto waitInfos = std::vector<VkSemaphoreSubmitInfo> {};
+    auto commandBufferInfos = std::vector<VkCommandBufferSubmitInfo> {};
+    auto signalInfos = std::vector<VkSemaphoreSubmitInfo> {};
+    waitInfos.reserve(waitCount);
+    commandBufferInfos.reserve(commandBufferCount);
+    signalInfos.reserve(signalCount);
+
+    auto submitInfos = std::vector<VkSubmitInfo2> {};
+    submitInfos.reserve(submissions.size());
+    for (const auto& submission : submissions) {
+        const auto firstWait = waitInfos.size();
+        const auto firstCommandBuffer = commandBufferInfos.size();
+        const auto firstSignal = signalInfos.size();
+        for (const auto& wait : submission.waits) {
+            waitInfos.push_back(toSemaphoreInfo(wait));
+        }
+        for (const auto commandBuffer : submission.commandBuffers) {
+            commandBufferInfos.push_back(VkCommandBufferSubmitInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+                .commandBuffer = commandBuffer,
+                .deviceMask = m_deviceCount > 1 ? submission.deviceMask : 0,
+            });
+        }
+        for (const auto& signal : submission.signals) {
+            signalInfos.push_back(toSemaphoreInfo(signal));
+        }
+
+        submitInfos.push_back(VkSubmitInfo2 {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+            .waitSemaphoreInfoCount = static_cast<uint32_t>(submission.waits.size()),
+            .pWaitSemaphoreInfos = waitInfos.data() + firstWait,
+            .commandBufferInfoCount = static_cast<uint32_t>(submission.commandBuffers.size()),
+            .pCommandBufferInfos = commandBufferInfos.data() + firstCommandBuffer,
+            .signalSemaphoreInfoCount = static_cast<uint32_t>(submission.signals.size()),
+            .pSignalSemaphoreInfos = signalInfos.data() + firstSignal,
+        });
+    }
+
+    const auto result = m_dispatch.vkQueueSubmit2(queue, static_cast<uint32_t>(submitInfos.size()), submitInfos.data(), VK_NULL_HANDLE);
+    CommandCounters::add(CommandCounter::Submits);
+    checkSubmitResult(result);
+}
+
+void QueueSubmitter::submitQueueLegacy(VkQueue queue, const std::vector<QueueSubmission>& submissions) {
+    // The legacy structures take the semaphores, values, stages and device indices as
+    // parallel arrays, one set per submission, so every submission keeps its own.
+    struct LegacySubmission final {
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<uint64_t> waitValues;
+        std::vector<VkPipelineStageFlags> waitStages;
+        std::vector<uint32_t> waitDeviceIndices;
+        std::vector<uint32_t> commandBufferDeviceMasks;
+        std::vector<VkSemaphore> signalSemaphores;
+        std::vector<uint64_t> signalValues;
+        std::vector<uint32_t> signalDeviceIndices;
+        VkTimelineSemaphoreSubmitInfo timelineSubmitInfo;
+        VkDeviceGroupSubmitInfo deviceGroupSubmitInfo;
+    };
+
+    auto legacySubmissions = std::vector<LegacySubmission>(submissions.size());
+    auto submitInfos = std::vector<VkSubmitInfo> {};
+    submitInfos.reserve(submissions.size());
+    for (size_t i = 0; i < submissions.size(); i++) {
+        const auto& submission = submissions[i];
+        auto& legacySubmission = legacySubmissions[i];
+        for (const auto& wait : submission.waits) {
+            legacySubmission.waitSemaphores.push_back(wait.semaphore);
+            legacySubmission.waitValues.push_back(wait.value);
+            legacySubmission.waitStages.push_back(toLegacyWaitStages(wait.stageMask));
+            legacySubmission.waitDeviceIndices.push_back(wait.deviceIndex);
+        }
+        legacySubmission.commandBufferDeviceMasks.assign(submission.commandBuffers.size(), submission.deviceMask);
+        for (const auto& signal : submission.signals) {
+            legacySubmission.signalSemaphores.push_back(signal.semaphore);
+            legacySubmission.signalValues.push_back(signal.value);
+            legacySubmission.signalDeviceIndices.push_back(signal.deviceIndex);
+        }
+
+        legacySubmission.deviceGroupSubmitInfo = VkDeviceGroupSubmitInfo {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_GROUP_SUBMIT_INFO,
+            .pNext = nullptr,
+            .waitSemaphoreCount = static_cast<uint32_t>(legacySubmission.waitDeviceIndices.size()),
+            .pWaitSemaphoreDeviceIndices = legacySubmission.waitDeviceIndices.data(),
+            .commandBufferCount = static_cast<uint32_t>(legacySubmission.commandBufferDeviceMasks.size()),
+            .pCommandBufferDeviceMasks = legacySubmission.commandBufferDeviceMasks.data(),
+            .signalSemaphoreCount = static_cast<uint32_t>(legacySubmission.signalDeviceIndices.size()),
+            .pSignalSemaphoreDeviceIndices = legacySubmission.signalDeviceIndices.data(),
+        };
+        // A device mask of zero is only valid in the synchronization2 structures.
+        const auto hasDeviceMasks = m_deviceCount > 1 && submission.deviceMask != 0;
+        legacySubmission.timelineSubmitInfo = VkTimelineSemaphoreSubmitInfo {
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .pNext = hasDeviceMasks ? &legacySubmission.deviceGroupSubmitInfo : nullptr,
+            .waitSemaphoreValueCount = static_cast<uint32_t>(legacySubmission.waitValues.size()),
+            .pWaitSemaphoreValues = legacySubmission.waitValues.data(),
+            .signalSemaphoreValueCount = static_cast<uint32_t>(legacySubmission.signalValues.size()),
+            .pSignalSemaphoreValues = legacySubmission.signalValues.data(),
+        };
+
+        submitInfos.push_back(VkSubmitInfo {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = &legacySubmission.timelineSubmitInfo,
+            .waitSemaphoreCount = static_cast<uint32_t>(legacySubmission.waitSemaphores.size()),
+            .pWaitSemaphores = legacySubmission.waitSemaphores.data(),
+            .pWaitDstStageMask = legacySubmission.waitStages.data(),
+            .commandBufferCount = static_cast<uint32_t>(submission.commandBuffers.size()),
+            .pCommandBuffers = submission.commandBuffers.data(),
+            .signalSemaphoreCount = static_cast<uint32_t>(legacySubmission.signalSemaphores.size()),
+            .pSignalSemaphores = legacySubmission.signalSemaphores.data(),
+        });
+    }
+
+    const auto result = m_dispatch.vkQueueSubmit(queue, static_cast<uint32_t>(submitInfos.size()), submitInfos.data(), VK_NULL_HANDLE);
+    CommandCounters::add(CommandCounter::Submits);
+    checkSubmitResult(result);
+}
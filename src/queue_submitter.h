@@ -0,0 +1,99 @@
+#ifndef _QUEUE_SUBMITTER_H
+#define _QUEUE_SUBMITTER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "device_dispatch.h"
+
+
+namespace VulkanEngine {
+
+/// @brief A semaphore that a submission waits on or signals.
+///
+/// @note The value is ignored for binary semaphores, and the device index outside of
+/// device groups.
+struct SemaphoreSubmit final {
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    uint64_t value = 0;
+    VkPipelineStageFlags2 stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    uint32_t deviceIndex = 0;
+};
+
+/// @brief The command buffers of one submission, the semaphores they wait on first, and
+/// the ones they signal once they are done.
+///
+/// @note A device mask of zero runs the command buffers on every device of a device group.
+struct QueueSubmission final {
+    std::vector<SemaphoreSubmit> waits;
+    std::vector<VkCommandBuffer> commandBuffers;
+    uint32_t deviceMask = 0;
+    std::vector<SemaphoreSubmit> signals;
+};
+
+/// @brief Submits the work of a frame, from every queue, in as few calls as it can.
+///
+/// @note Outside of a batch, every submission goes to its queue at once. Between
+/// `beginBatch` and `endBatch`, submissions are held, and `endBatch` hands all of those of
+/// one queue to a single `vkQueueSubmit2`, in the order they were made. Queues are
+/// submitted to in the order they were first used in the batch, so a submission that waits
+/// on a binary semaphore another queue signals finds the signal submitted before it.
+/// Devices without synchronization2 submit with `vkQueueSubmit`, one call per queue just
+/// the same, with the stage masks of the waits folded into their legacy bits.
+///
+/// The submits go through the device's dispatch table rather than the loader.
+///
+/// Anything that blocks on a value a held submission signals has to `flush` first, or it
+/// waits forever, so the staging ring and the upload context flush before they wait. A
+/// submit to a lost device throws a `DeviceLostError`.
+class QueueSubmitter final {
+    public:
+        explicit QueueSubmitter() = delete;
+        explicit QueueSubmitter(const DeviceDispatch& dispatch, bool useSynchronization2, uint32_t deviceCount);
+
+        ~QueueSubmitter() = default;
+
+        QueueSubmitter(const QueueSubmitter& other) = delete;
+        QueueSubmitter& operator=(const QueueSubmitter& other) = delete;
+
+        /// @brief Hold every submission until the matching `endBatch`.
+        ///
+        /// @note Batches nest, and only the outermost one submits.
+        void beginBatch();
+
+        void endBatch();
+
+        /// @brief Submit `submission` to `queue`, at once outside of a batch, and with the
+        /// rest of the batch inside one.
+        void submit(VkQueue queue, QueueSubmission submission);
+
+        /// @brief Submit every held submission, one call per queue, and keep batching.
+        void flush();
+
+        bool hasPending() const;
+
+        /// @brief The number of calls that submitted to a queue so far.
+        uint64_t getSubmitCallCount() const;
+    private:
+        struct QueueBatch final {
+            VkQueue queue;
+            std::vector<QueueSubmission> submissions;
+        };
+
+        const DeviceDispatch& m_dispatch;
+        bool m_useSynchronization2;
+        uint32_t m_deviceCount;
+        uint32_t m_batchDepth;
+        std::vector<QueueBatch> m_queueBatches;
+        uint64_t m_submitCallCount;
+
+        void submitQueue(VkQueue queue, const std::vector<QueueSubmission>& submissions);
+
+        void submitQueueLegacy(VkQueue queue, const std::vector<QueueSubmission>& submissions);
+};
+
+}
+
+#endif // _QUEUE_SUBMITTER_H
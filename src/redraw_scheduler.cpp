@@ -0,0 +1,36 @@
+#include "redraw_scheduler.h"
+
+
+using RedrawScheduler = VulkanEngine::RedrawScheduler;
+using AnimationSource = VulkanEngine::AnimationSource;
+
+// The first frames show the scene as it starts out.
+RedrawScheduler::RedrawScheduler(uint32_t redrawFrameCount)
+    : m_redrawFrameCount { redrawFrameCount }
+    , m_pendingFrameCount { redrawFrameCount }
+    , m_animatingSources {}
+{
+}
+
+void RedrawScheduler::requestRedraw() {
+    m_pendingFrameCount = m_redrawFrameCount;
+}
+
+void RedrawScheduler::setAnimating(AnimationSource source, bool isAnimating) {
+    const auto index = static_cast<size_t>(source);
+    if (m_animatingSources.test(index) && !isAnimating) {
+        this->requestRedraw();
+    }
+
+    m_animatingSources.set(index, isAnimating);
+}
+
+bool RedrawScheduler::isRedrawDue() const {
+    return m_pendingFrameCount > 0 || m_animatingSources.any();
+}
+
+void RedrawScheduler::recordFrame() {
+    if (m_pendingFrameCount > 0) {
+        m_pendingFrameCount--;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef _REDRAW_SCHEDULER_H
+#define _REDRAW_SCHEDULER_H
+
+#include <bitset>
+#include <cstdint>
+
+
+namespace VulkanEngine {
+
+/// @brief What keeps drawing frame after frame for as long as it is active, since every
+/// frame shows it a step further along.
+enum class AnimationSource {
+    CameraOrbit,
+    AssetStreaming,
+    TextureStreaming,
+    GeometryStreaming,
+    PipelineSwap,
+    PerformanceHud,
+    DashboardTexture,
+    Count
+};
+
+/// @brief Decides which frames a loop that only draws on demand draws: the frames that show
+/// a change, and every frame while an animation source is active.
+///
+/// @note A change takes `redrawFrameCount` frames to show, for state that was prepared for
+/// the next frame before the change came in. Nothing is drawn once every change has been
+/// shown and no animation source is active.
+class RedrawScheduler final {
+    public:
+        explicit RedrawScheduler() = delete;
+        explicit RedrawScheduler(uint32_t redrawFrameCount);
+
+        ~RedrawScheduler() = default;
+
+        RedrawScheduler(const RedrawScheduler& other) = delete;
+        RedrawScheduler& operator=(const RedrawScheduler& other) = delete;
+
+        /// @brief Draw the frames that show a change that has just happened.
+        void requestRedraw();
+
+        /// @brief Start or stop drawing every frame for `source`.
+        ///
+        /// @note A source that stops asks for a redraw, so the frame it ends on is shown.
+        void setAnimating(AnimationSource source, bool isAnimating);
+
+        /// @brief Whether the next frame is to be drawn.
+        bool isRedrawDue() const;
+
+        /// @brief Count a frame as drawn, toward the frames that show the last change.
+        void recordFrame();
+    private:
+        uint32_t m_redrawFrameCount;
+        uint32_t m_pendingFrameCount;
+        std::bitset<static_cast<size_t>(AnimationSource::Count)> m_animatingSources;
+};
+
+}
+
+#endif // _REDRAW_SCHEDULER_H
@@ -0,0 +1,235 @@
+#include "render_graph.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "command_counters.h"
+
+
+using RenderGraph = VulkanEngine::RenderGraph;
+using RenderGraphResource = VulkanEngine::RenderGraphResource;
+using RenderGraphState = VulkanEngine::RenderGraphState;
+using RenderGraphUse = VulkanEngine::RenderGraphUse;
+using BarrierBatch = VulkanEngine::BarrierBatch;
+using CommandCounters = VulkanEngine::CommandCounters;
+using CommandPassScope = VulkanEngine::CommandPassScope;
+
+static constexpr VkAccessFlags2 WRITE_ACCESS =
+    VK_ACCESS_2_SHADER_WRITE_BIT |
+    VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+    VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_2_TRANSFER_WRITE_BIT |
+    VK_ACCESS_2_HOST_WRITE_BIT |
+    VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+static bool isWrite(VkAccessFlags2 access) {
+    return (access & WRITE_ACCESS) != 0;
+}
+
+static bool isRead(VkAccessFlags2 access) {
+    return (access & ~WRITE_ACCESS) != 0;
+}
+
+RenderGraph::RenderGraph(bool useSynchronization2, std::pmr::memory_resource* memoryResource)
+    : m_useSynchronization2 { useSynchronization2 }
+    , m_memoryResource { memoryResource }
+    , m_resources { std::pmr::vector<Resource> { memoryResource } }
+    , m_passes { std::pmr::vector<Pass> { memoryResource } }
+{
+}
+
+RenderGraphResource RenderGraph::importBuffer(VkBuffer buffer, const RenderGraphState& initialState, bool isRetained) {
+    m_resources.push_back(Resource {
+        .buffer = buffer,
+        .image = VK_NULL_HANDLE,
+        .subresourceRange = VkImageSubresourceRange {},
+        .initialState = initialState,
+        .finalState = RenderGraphState {},
+        .isRetained = isRetained,
+    });
+
+    return static_cast<RenderGraphResource>(m_resources.size() - 1);
+}
+
+RenderGraphResource RenderGraph::importImage(
+    VkImage image,
+    const VkImageSubresourceRange& subresourceRange,
+    const RenderGraphState& initialState,
+    const RenderGraphState& finalState,
+    bool isRetained
+) {
+    if (finalState.layout == VK_IMAGE_LAYOUT_UNDEFINED || finalState.layout == VK_IMAGE_LAYOUT_PREINITIALIZED) {
+        throw std::invalid_argument("images cannot be handed over in an undefined or preinitialized layout!");
+    }
+
+    m_resources.push_back(Resource {
+        .buffer = VK_NULL_HANDLE,
+        .image = image,
+        .subresourceRange = subresourceRange,
+        .initialState = initialState,
+        .finalState = finalState,
+        .isRetained = isRetained,
+    });
+
+    return static_cast<RenderGraphResource>(m_resources.size() - 1);
+}
+
+void RenderGraph::addPass(const std::string& name, std::span<const RenderGraphUse> uses, RecordPass record, bool hasSideEffects) {
+    for (size_t i = 0; i < uses.size(); i++) {
+        if (uses[i].resource >= m_resources.size()) {
+            throw std::invalid_argument(fmt::format("render graph pass `{}` uses a resource that was never imported!", name));
+        }
+
+        const auto isUsedAgain = std::any_of(uses.begin() + i + 1, uses.end(), [&uses, i](const RenderGraphUse& use) {
+            return use.resource == uses[i].resource;
+        });
+        if (isUsedAgain) {
+            throw std::invalid_argument(fmt::format("render graph pass `{}` uses a resource more than once!", name));
+        }
+    }
+
+    m_passes.push_back(Pass {
+        .uses = std::pmr::vector<RenderGraphUse>(uses.begin(), uses.end(), m_memoryResource),
+        .record = std::move(record),
+        .hasSideEffects = hasSideEffects,
+        .counterPass = CommandCounters::findPass(name),
+    });
+}
+
+void RenderGraph::execute(VkCommandBuffer commandBuffer) const {
+    auto states = std::pmr::vector<ResourceState> { m_memoryResource };
+    states.reserve(m_resources.size());
+    for (const auto& resource : m_resources) {
+        const auto& initialState = resource.initialState;
+        const auto isWritten = isWrite(initialState.access);
+        states.push_back(ResourceState {
+            .layout = initialState.layout,
+            .writeStages = isWritten ? initialState.stages : VK_PIPELINE_STAGE_2_NONE,
+            .writeAccess = initialState.access & WRITE_ACCESS,
+            .readStages = isWritten ? VK_PIPELINE_STAGE_2_NONE : initialState.stages,
+            .readAccess = isWritten ? 0 : initialState.access,
+        });
+    }
+
+    auto barriers = BarrierBatch { m_useSynchronization2, m_memoryResource };
+    const auto isLive = this->findLivePasses();
+    for (size_t i = 0; i < m_passes.size(); i++) {
+        if (!isLive[i]) {
+            continue;
+        }
+
+        const auto& pass = m_passes[i];
+        const auto passScope = CommandPassScope { pass.counterPass };
+        for (const auto& use : pass.uses) {
+            this->addBarrier(barriers, m_resources[use.resource], states[use.resource], use.state);
+        }
+        barriers.flush(commandBuffer);
+
+        pass.record(commandBuffer);
+    }
+
+    for (size_t i = 0; i < m_resources.size(); i++) {
+        if (m_resources[i].image != VK_NULL_HANDLE) {
+            this->addBarrier(barriers, m_resources[i], states[i], m_resources[i].finalState);
+        }
+    }
+    barriers.flush(commandBuffer);
+}
+
+std::pmr::vector<bool> RenderGraph::findLivePasses() const {
+    auto isNeeded = std::pmr::vector<bool>(m_resources.size(), false, m_memoryResource);
+    for (size_t i = 0; i < m_resources.size(); i++) {
+        isNeeded[i] = m_resources[i].isRetained;
+    }
+
+    // Walking back from the last pass, a pass is needed once a needed pass after it reads
+    // what it writes. A write is taken to leave the rest of the resource as it was, so the
+    // passes that wrote it before stay needed too.
+    auto isLive = std::pmr::vector<bool>(m_passes.size(), false, m_memoryResource);
+    for (size_t i = m_passes.size(); i-- > 0;) {
+        const auto& pass = m_passes[i];
+        isLive[i] = pass.hasSideEffects || std::any_of(pass.uses.begin(), pass.uses.end(), [&isNeeded](const RenderGraphUse& use) {
+            return isWrite(use.state.access) && isNeeded[use.resource];
+        });
+        if (!isLive[i]) {
+            continue;
+        }
+
+        for (const auto& use : pass.uses) {
+            if (isRead(use.state.access)) {
+                isNeeded[use.resource] = true;
+            }
+        }
+    }
+
+    return isLive;
+}
+
+void RenderGraph::addBarrier(BarrierBatch& barriers, const Resource& resource, ResourceState& state, const RenderGraphState& use) const {
+    const auto isImage = resource.image != VK_NULL_HANDLE;
+    const auto oldLayout = state.layout;
+    const auto isLayoutChanged = isImage && use.layout != state.layout;
+    const auto isWritten = isWrite(use.access);
+    auto srcStageMask = VkPipelineStageFlags2 { VK_PIPELINE_STAGE_2_NONE };
+    auto srcAccessMask = VkAccessFlags2 { 0 };
+    if (isWritten || isLayoutChanged) {
+        // Nothing may still read the old contents, and a layout change rewrites them.
+        srcStageMask = state.writeStages | state.readStages;
+        srcAccessMask = state.writeAccess;
+        state = ResourceState {
+            .layout = isImage ? use.layout : oldLayout,
+            .writeStages = isWritten || isLayoutChanged ? use.stages : VK_PIPELINE_STAGE_2_NONE,
+            .writeAccess = use.access & WRITE_ACCESS,
+            .readStages = isWritten ? VK_PIPELINE_STAGE_2_NONE : use.stages,
+            .readAccess = isWritten ? 0 : use.access,
+        };
+        if (srcStageMask == VK_PIPELINE_STAGE_2_NONE && !isLayoutChanged) {
+            return;
+        }
+    } else {
+        const auto isVisible = (use.stages & ~state.readStages) == 0 && (use.access & ~state.readAccess) == 0;
+        state.readStages |= use.stages;
+        state.readAccess |= use.access;
+        if (isVisible || state.writeStages == VK_PIPELINE_STAGE_2_NONE) {
+            return;
+        }
+
+        srcStageMask = state.writeStages;
+        srcAccessMask = state.writeAccess;
+    }
+
+    if (isImage) {
+        barriers.addImageBarrier(VkImageMemoryBarrier2 {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = srcStageMask,
+            .srcAccessMask = srcAccessMask,
+            .dstStageMask = use.stages,
+            .dstAccessMask = use.access,
+            .oldLayout = oldLayout,
+            .newLayout = use.layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = resource.image,
+            .subresourceRange = resource.subresourceRange,
+        });
+    } else {
+        barriers.addBufferBarrier(VkBufferMemoryBarrier2 {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = srcStageMask,
+            .srcAccessMask = srcAccessMask,
+            .dstStageMask = use.stages,
+            .dstAccessMask = use.access,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = resource.buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+        });
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef _RENDER_GRAPH_H
+#define _RENDER_GRAPH_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "barrier_batch.h"
+
+
+namespace VulkanEngine {
+
+/// @brief Identifies a buffer or image imported into a `RenderGraph`.
+using RenderGraphResource = uint32_t;
+
+/// @brief The stages and accesses a resource is used with, and the layout of an image
+/// while it is.
+///
+/// @note The layout of a buffer is always `VK_IMAGE_LAYOUT_UNDEFINED`.
+struct RenderGraphState final {
+    VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 access = 0;
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+/// @brief A resource a pass of a `RenderGraph` uses, and how it uses it.
+struct RenderGraphUse final {
+    RenderGraphResource resource;
+    RenderGraphState state;
+};
+
+/// @brief Records the passes of a frame in the order they are added, with the barriers
+/// between them worked out from the resources each pass declares, and without the passes
+/// whose results nothing uses.
+///
+/// @note Only the resources that more than one pass touches are declared. The barriers
+/// inside a pass, and the attachments a render pass moves between layouts itself, stay
+/// with the pass. A write, or a change of layout, waits for every use of the resource
+/// since the last write before it. A read waits for the last write, unless a read since
+/// then with the same stages and accesses already did. A pass is culled when it has no
+/// side effects and nothing it writes is retained past the graph or read by a pass after
+/// it that is kept. Every image is imported, so none of them are aliased.
+///
+/// The graph keeps its resources, passes and barriers in `memoryResource`, so a graph
+/// built every frame from the frame's arena never goes to the heap. A pass whose recording
+/// function captures no more than two pointers is kept inside its `std::function` too.
+class RenderGraph final {
+    public:
+        using RecordPass = std::function<void(VkCommandBuffer)>;
+
+        explicit RenderGraph() = delete;
+        explicit RenderGraph(
+            bool useSynchronization2,
+            std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource()
+        );
+
+        ~RenderGraph() = default;
+
+        RenderGraph(const RenderGraph& other) = delete;
+        RenderGraph& operator=(const RenderGraph& other) = delete;
+
+        /// @brief Import a whole buffer, left in `initialState` by the commands recorded
+        /// before the graph.
+        ///
+        /// @note The contents of a retained resource outlive the graph, so the passes that
+        /// write it are never culled.
+        RenderGraphResource importBuffer(VkBuffer buffer, const RenderGraphState& initialState, bool isRetained);
+
+        /// @brief Import an image whose subresources in `subresourceRange` are all in the
+        /// layout of `initialState`, and hand it over in `finalState` to the commands
+        /// recorded after the graph.
+        RenderGraphResource importImage(
+            VkImage image,
+            const VkImageSubresourceRange& subresourceRange,
+            const RenderGraphState& initialState,
+            const RenderGraphState& finalState,
+            bool isRetained
+        );
+
+        /// @brief Add a pass that uses each of the resources in `uses` once.
+        ///
+        /// @note A pass with side effects outside of the graph, like one that draws to the
+        /// swap chain, is never culled. The commands the pass records, and the barriers
+        /// ahead of it, are counted under `name`.
+        void addPass(const std::string& name, std::span<const RenderGraphUse> uses, RecordPass record, bool hasSideEffects);
+
+        /// @brief Record every pass that is not culled into `commandBuffer`, each after the
+        /// barriers it needs, then the barriers that hand the images over.
+        void execute(VkCommandBuffer commandBuffer) const;
+    private:
+        struct Resource final {
+            VkBuffer buffer;
+            VkImage image;
+            VkImageSubresourceRange subresourceRange;
+            RenderGraphState initialState;
+            RenderGraphState finalState;
+            bool isRetained;
+        };
+
+        struct Pass final {
+            std::pmr::vector<RenderGraphUse> uses;
+            RecordPass record;
+            bool hasSideEffects;
+            /// @brief The pass of the command counters that the pass counts into.
+            uint32_t counterPass;
+        };
+
+        /// @brief The uses of a resource since it was last written, while the graph is
+        /// recorded.
+        struct ResourceState final {
+            VkImageLayout layout;
+            VkPipelineStageFlags2 writeStages;
+            VkAccessFlags2 writeAccess;
+            VkPipelineStageFlags2 readStages;
+            VkAccessFlags2 readAccess;
+        };
+
+        bool m_useSynchronization2;
+        std::pmr::memory_resource* m_memoryResource;
+        std::pmr::vector<Resource> m_resources;
+        std::pmr::vector<Pass> m_passes;
+
+        std::pmr::vector<bool> findLivePasses() const;
+
+        void addBarrier(BarrierBatch& barriers, const Resource& resource, ResourceState& state, const RenderGraphState& use) const;
+};
+
+}
+
+#endif // _RENDER_GRAPH_H
@@ -0,0 +1,118 @@
+#include "render_queue.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <utility>
+
+#include "job_system.h"
+
+
+using RenderQueue = VulkanEngine::RenderQueue;
+using RenderItem = VulkanEngine::RenderItem;
+
+// Flipping the sign bit of a positive float, and every bit of a negative one, orders the
+// bits as unsigned integers the way the floats order.
+static uint32_t toSortableDepth(float depth) {
+    const auto bits = std::bit_cast<uint32_t>(depth);
+
+    return (bits & 0x80000000u) != 0 ? ~bits : bits | 0x80000000u;
+}
+
+uint64_t RenderQueue::makeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth) {
+    if (pass >= (1u << PASS_BITS) || pipeline >= (1u << PIPELINE_BITS) || material >= (1u << MATERIAL_BITS)) {
+        throw std::invalid_argument("render queue pass, pipeline or material out of range!");
+    }
+
+    const auto stateKey = (pass << (PIPELINE_BITS + MATERIAL_BITS)) | (pipeline << MATERIAL_BITS) | material;
+
+    return (static_cast<uint64_t>(stateKey) << 32) | toSortableDepth(depth);
+}
+
+uint32_t RenderQueue::getStateKey(uint64_t sortKey) {
+    return static_cast<uint32_t>(sortKey >> 32);
+}
+
+void RenderQueue::clear() {
+    m_items.clear();
+}
+
+void RenderQueue::reserve(size_t itemCount) {
+    m_items.reserve(itemCount);
+}
+
+void RenderQueue::push(uint64_t sortKey, uint32_t drawIndex) {
+    m_items.push_back(RenderItem { sortKey, drawIndex });
+}
+
+void RenderQueue::sort(JobSystem* jobSystem) {
+    const auto itemCount = m_items.size();
+    if (itemCount < 2) {
+        return;
+    }
+
+    // Only the digits that differ between some two keys can reorder the items.
+    auto commonOnes = ~uint64_t { 0 };
+    auto anyOnes = uint64_t { 0 };
+    for (const auto& item : m_items) {
+        commonOnes &= item.sortKey;
+        anyOnes |= item.sortKey;
+    }
+    const auto varyingBits = commonOnes ^ anyOnes;
+    if (varyingBits == 0) {
+        return;
+    }
+
+    const auto isParallel = jobSystem != nullptr && itemCount >= PARALLEL_SORT_MIN_ITEMS;
+    const auto blockCount = isParallel ? std::max<size_t>(jobSystem->getThreadCount(), 1) : 1;
+    const auto blockSize = (itemCount + blockCount - 1) / blockCount;
+    auto runBlocks = [jobSystem, blockCount](const auto& function) {
+        if (blockCount == 1) {
+            function(0);
+        } else {
+            jobSystem->parallelFor(blockCount, 1, function);
+        }
+    };
+
+    m_scratchItems.resize(itemCount);
+    m_blockOffsets.resize(blockCount * DIGIT_COUNT);
+    for (uint32_t shift = 0; shift < 64; shift += DIGIT_BITS) {
+        if (((varyingBits >> shift) & (DIGIT_COUNT - 1)) == 0) {
+            continue;
+        }
+
+        std::fill(m_blockOffsets.begin(), m_blockOffsets.end(), 0);
+        runBlocks([this, shift, blockSize, itemCount](size_t block) {
+            auto* counts = m_blockOffsets.data() + block * DIGIT_COUNT;
+            const auto end = std::min((block + 1) * blockSize, itemCount);
+            for (auto i = block * blockSize; i < end; i++) {
+                counts[(m_items[i].sortKey >> shift) & (DIGIT_COUNT - 1)]++;
+            }
+        });
+
+        // Every digit's items go after those of the smaller digits, and within a digit every
+        // block's items go after those of the blocks before it, which keeps the sort stable.
+        auto offset = uint32_t { 0 };
+        for (uint32_t digit = 0; digit < DIGIT_COUNT; digit++) {
+            for (size_t block = 0; block < blockCount; block++) {
+                auto& blockOffset = m_blockOffsets[block * DIGIT_COUNT + digit];
+                offset += std::exchange(blockOffset, offset);
+            }
+        }
+
+        runBlocks([this, shift, blockSize, itemCount](size_t block) {
+            auto* offsets = m_blockOffsets.data() + block * DIGIT_COUNT;
+            const auto end = std::min((block + 1) * blockSize, itemCount);
+            for (auto i = block * blockSize; i < end; i++) {
+                const auto& item = m_items[i];
+                m_scratchItems[offsets[(item.sortKey >> shift) & (DIGIT_COUNT - 1)]++] = item;
+            }
+        });
+
+        std::swap(m_items, m_scratchItems);
+    }
+}
+
+std::span<const RenderItem> RenderQueue::getItems() const {
+    return m_items;
+}
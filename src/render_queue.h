@@ -0,0 +1,82 @@
+#ifndef _RENDER_QUEUE_H
+#define _RENDER_QUEUE_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+class JobSystem;
+
+/// @brief A draw of a frame, and the key it is recorded in the order of.
+struct RenderItem final {
+    uint64_t sortKey;
+    uint32_t drawIndex;
+};
+
+/// @brief Collects the draws of a frame and sorts them by pass, pipeline, material and
+/// depth, so that recording changes state as rarely as it can and draws opaque geometry
+/// front to back.
+///
+/// @note A key holds, from its highest bits down, the pass in 4 bits, the pipeline in 12,
+/// the material in 16 and the depth in 32. Every draw of a pass is recorded before the
+/// next pass, every draw of a pipeline within a pass together, and so on, with the nearest
+/// draws of a material first. Two consecutive items with the same state key bind the same
+/// state, so a recorder only binds when the state key changes.
+///
+/// Keys are sorted with an LSD radix sort of 8-bit digits, which keeps the order the draws
+/// were pushed in among equal keys. Digits that are the same in every key are skipped, so a
+/// frame that only has one pass, pipeline and material sorts in the four passes its depths
+/// need. Queues of at least `PARALLEL_SORT_MIN_ITEMS` items are split into blocks that
+/// count and scatter on the jobs of a `JobSystem`.
+class RenderQueue final {
+    public:
+        static constexpr uint32_t PASS_BITS = 4;
+        static constexpr uint32_t PIPELINE_BITS = 12;
+        static constexpr uint32_t MATERIAL_BITS = 16;
+        static constexpr size_t PARALLEL_SORT_MIN_ITEMS = 16 * 1024;
+
+        explicit RenderQueue() = default;
+
+        ~RenderQueue() = default;
+
+        RenderQueue(const RenderQueue& other) = delete;
+        RenderQueue& operator=(const RenderQueue& other) = delete;
+
+        /// @brief The key of a draw of `pass` with `pipeline` and `material`, `depth` away
+        /// from the camera along its view direction.
+        ///
+        /// @note Negative depths, of draws behind the camera, sort before every positive one.
+        static uint64_t makeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth);
+
+        /// @brief The pass, pipeline and material of `sortKey`, without its depth.
+        static uint32_t getStateKey(uint64_t sortKey);
+
+        /// @brief Forget every item, and keep the memory for the next frame.
+        void clear();
+
+        void reserve(size_t itemCount);
+
+        void push(uint64_t sortKey, uint32_t drawIndex);
+
+        /// @brief Sort the items by their keys, on the jobs of `jobSystem` if there are
+        /// enough of them, and on the calling thread otherwise or without one.
+        void sort(JobSystem* jobSystem);
+
+        std::span<const RenderItem> getItems() const;
+    private:
+        static constexpr uint32_t DIGIT_BITS = 8;
+        static constexpr uint32_t DIGIT_COUNT = 1 << DIGIT_BITS;
+
+        std::vector<RenderItem> m_items;
+        std::vector<RenderItem> m_scratchItems;
+        /// @brief The count of every digit in every block, turned into the position the
+        /// block writes its next item of that digit to.
+        std::vector<uint32_t> m_blockOffsets;
+};
+
+}
+
+#endif // _RENDER_QUEUE_H
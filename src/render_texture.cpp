@@ -0,0 +1,490 @@
+#include "render_texture.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+#include "barrier_batch.h"
+
+
+using RenderTexture = VulkanEngine::RenderTexture;
+using MipmapGenerator = VulkanEngine::MipmapGenerator;
+using MipmapTarget = VulkanEngine::MipmapTarget;
+using BarrierBatch = VulkanEngine::BarrierBatch;
+using QueueSubmission = VulkanEngine::QueueSubmission;
+using SemaphoreSubmit = VulkanEngine::SemaphoreSubmit;
+
+RenderTexture::RenderTexture(
+    const DeviceCapabilities& capabilities,
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    QueueSubmitter& queueSubmitter,
+    VkPipelineCache pipelineCache,
+    bool isPushDescriptorSupported,
+    bool useSynchronization2,
+    std::span<const uint32_t> shaderCode,
+    std::span<const uint32_t> filterShaderCode,
+    std::span<const uint32_t> volumeShaderCode,
+    VkQueue computeQueue,
+    uint32_t graphicsQueueFamilyIndex,
+    uint32_t computeQueueFamilyIndex,
+    VkFormat format,
+    VkExtent2D extent,
+    uint32_t copyCount
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_queueSubmitter { queueSubmitter }
+    , m_useSynchronization2 { useSynchronization2 }
+    , m_computeQueue { computeQueue }
+    , m_graphicsQueueFamilyIndex { graphicsQueueFamilyIndex }
+    , m_computeQueueFamilyIndex { computeQueueFamilyIndex }
+    , m_format { format }
+    , m_extent { extent }
+    , m_mipLevels { static_cast<uint32_t>(std::bit_width(std::max(extent.width, extent.height))) }
+    , m_mipmapGenerator {}
+    , m_commandPool { VK_NULL_HANDLE }
+    , m_timelineSemaphore { VK_NULL_HANDLE }
+    , m_timelineValue { 0 }
+    , m_copies {}
+    , m_targetCopy { 0 }
+    , m_readyCopy {}
+{
+    if (extent.width == 0 || extent.height == 0) {
+        throw std::invalid_argument("render texture needs an extent that is not empty");
+    }
+
+    if (copyCount < 2) {
+        throw std::invalid_argument("render texture needs a copy to sample while it renders into another");
+    }
+
+    m_mipmapGenerator = std::make_unique<MipmapGenerator>(
+        capabilities,
+        device,
+        allocator,
+        pipelineCache,
+        isPushDescriptorSupported,
+        shaderCode,
+        filterShaderCode,
+        volumeShaderCode
+    );
+    const auto target = MipmapTarget {
+        .format = format,
+        .width = extent.width,
+        .height = extent.height,
+        .mipLevels = m_mipLevels,
+    };
+    if (!m_mipmapGenerator->supportsTarget(target)) {
+        throw std::invalid_argument("render texture format is not supported by the mip generator");
+    }
+
+    this->createCommandPool();
+    this->createTimelineSemaphore();
+
+    // A copy that failed halfway is destroyed with the rest, since its handles start out
+    // null.
+    m_copies.resize(copyCount);
+    try {
+        for (auto& copy : m_copies) {
+            this->createCopy(copy);
+        }
+    } catch (...) {
+        for (auto& copy : m_copies) {
+            this->destroyCopy(copy);
+        }
+        vkDestroySemaphore(m_device, m_timelineSemaphore, nullptr);
+        vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+
+        throw;
+    }
+}
+
+RenderTexture::~RenderTexture() {
+    // The copies are handed back once the last mip chain is done with them.
+    if (m_timelineValue > 0) {
+        const auto waitInfo = VkSemaphoreWaitInfo {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .semaphoreCount = 1,
+            .pSemaphores = &m_timelineSemaphore,
+            .pValues = &m_timelineValue,
+        };
+        vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX);
+    }
+
+    for (auto& copy : m_copies) {
+        this->destroyCopy(copy);
+    }
+    m_copies.clear();
+
+    vkDestroySemaphore(m_device, m_timelineSemaphore, nullptr);
+    vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+    m_mipmapGenerator.reset();
+
+    m_timelineSemaphore = VK_NULL_HANDLE;
+    m_commandPool = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void RenderTexture::recordAcquire(VkCommandBuffer commandBuffer) {
+    if (!m_readyCopy.has_value()) {
+        return;
+    }
+
+    auto& copy = m_copies[*m_readyCopy];
+    if (copy.isAcquired) {
+        return;
+    }
+
+    auto barriers = BarrierBatch { m_useSynchronization2 };
+    barriers.addImageBarrier(VkImageMemoryBarrier2 {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+        .srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+        .srcAccessMask = 0,
+        .dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .srcQueueFamilyIndex = m_computeQueueFamilyIndex,
+        .dstQueueFamilyIndex = m_graphicsQueueFamilyIndex,
+        .image = copy.image,
+        .subresourceRange = this->getSubresourceRange(0, m_mipLevels),
+    });
+    barriers.flush(commandBuffer);
+
+    copy.isAcquired = true;
+}
+
+void RenderTexture::recordBeginRendering(VkCommandBuffer commandBuffer) {
+    // The copy after the one sampled was last sampled `copyCount - 1` frames ago.
+    m_targetCopy = m_readyCopy.has_value() ? (*m_readyCopy + 1) % static_cast<uint32_t>(m_copies.size()) : 0;
+
+    auto barriers = BarrierBatch { m_useSynchronization2 };
+    barriers.transitionImage(
+        m_copies[m_targetCopy].image,
+        this->getSubresourceRange(0, 1),
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    );
+    barriers.flush(commandBuffer);
+}
+
+VkImageView RenderTexture::getAttachmentView() const {
+    return m_copies[m_targetCopy].attachmentView;
+}
+
+void RenderTexture::recordEndRendering(VkCommandBuffer commandBuffer) {
+    // On a queue of the same family the compute submission moves the levels itself, after
+    // its semaphore wait.
+    if (!this->isOwnershipTransferred()) {
+        return;
+    }
+
+    auto& copy = m_copies[m_targetCopy];
+    auto barriers = BarrierBatch { m_useSynchronization2 };
+    barriers.addImageBarrier(VkImageMemoryBarrier2 {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        .srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+        .dstAccessMask = 0,
+        .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = m_graphicsQueueFamilyIndex,
+        .dstQueueFamilyIndex = m_computeQueueFamilyIndex,
+        .image = copy.image,
+        .subresourceRange = this->getSubresourceRange(0, 1),
+    });
+    barriers.flush(commandBuffer);
+
+    copy.isAcquired = false;
+}
+
+void RenderTexture::submitMipmaps(VkSemaphore waitSemaphore, uint64_t waitValue) {
+    auto& copy = m_copies[m_targetCopy];
+
+    // The frames that sampled the copy have finished by now, so its last mip chain has too,
+    // and this wait is only there to keep that true if the copies ever run short.
+    if (copy.readyValue > 0) {
+        const auto waitInfo = VkSemaphoreWaitInfo {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .semaphoreCount = 1,
+            .pSemaphores = &m_timelineSemaphore,
+            .pValues = &copy.readyValue,
+        };
+        const auto resultWait = vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX);
+        if (resultWait != VK_SUCCESS) {
+            throw std::runtime_error("failed to wait for render texture mip chain!");
+        }
+    }
+
+    for (const auto& dispatchResources : copy.dispatchResources) {
+        m_mipmapGenerator->release(dispatchResources);
+    }
+    copy.dispatchResources.clear();
+
+    vkResetCommandBuffer(copy.commandBuffer, 0);
+    const auto beginInfo = VkCommandBufferBeginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = nullptr,
+    };
+    const auto resultBegin = vkBeginCommandBuffer(copy.commandBuffer, &beginInfo);
+    if (resultBegin != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording render texture command buffer!");
+    }
+
+    // The levels move to the layout the generator starts from, the first one acquired from
+    // the graphics queue where it is of another family. The contents of the others are
+    // discarded, which needs no transfer of ownership.
+    const auto isOwnershipTransferred = this->isOwnershipTransferred();
+    const auto srcQueueFamilyIndex = isOwnershipTransferred ? m_graphicsQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+    const auto dstQueueFamilyIndex = isOwnershipTransferred ? m_computeQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+    auto barriers = BarrierBatch { m_useSynchronization2 };
+    barriers.addImageBarrier(VkImageMemoryBarrier2 {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+        .srcStageMask = isOwnershipTransferred ? VK_PIPELINE_STAGE_2_NONE : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        .srcAccessMask = 0,
+        .dstStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = srcQueueFamilyIndex,
+        .dstQueueFamilyIndex = dstQueueFamilyIndex,
+        .image = copy.image,
+        .subresourceRange = this->getSubresourceRange(0, 1),
+    });
+    if (m_mipLevels > 1) {
+        barriers.addImageBarrier(VkImageMemoryBarrier2 {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .srcAccessMask = 0,
+            .dstStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = copy.image,
+            .subresourceRange = this->getSubresourceRange(1, m_mipLevels - 1),
+        });
+    }
+    barriers.flush(copy.commandBuffer);
+
+    const auto target = MipmapTarget {
+        .image = copy.image,
+        .format = m_format,
+        .width = m_extent.width,
+        .height = m_extent.height,
+        .mipLevels = m_mipLevels,
+    };
+    copy.dispatchResources = m_mipmapGenerator->record(
+        copy.commandBuffer,
+        std::span<const MipmapTarget> { &target, 1 },
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+    );
+
+    if (isOwnershipTransferred) {
+        barriers.addImageBarrier(VkImageMemoryBarrier2 {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+            .dstAccessMask = 0,
+            .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = m_computeQueueFamilyIndex,
+            .dstQueueFamilyIndex = m_graphicsQueueFamilyIndex,
+            .image = copy.image,
+            .subresourceRange = this->getSubresourceRange(0, m_mipLevels),
+        });
+        barriers.flush(copy.commandBuffer);
+    }
+
+    const auto resultEnd = vkEndCommandBuffer(copy.commandBuffer);
+    if (resultEnd != VK_SUCCESS) {
+        throw std::runtime_error("failed to record render texture command buffer!");
+    }
+
+    m_timelineValue++;
+    m_queueSubmitter.submit(m_computeQueue, QueueSubmission {
+        .waits = { SemaphoreSubmit { .semaphore = waitSemaphore, .value = waitValue } },
+        .commandBuffers = { copy.commandBuffer },
+        .deviceMask = 0,
+        .signals = { SemaphoreSubmit { .semaphore = m_timelineSemaphore, .value = m_timelineValue } },
+    });
+
+    copy.readyValue = m_timelineValue;
+    m_readyCopy = m_targetCopy;
+}
+
+std::optional<SemaphoreSubmit> RenderTexture::getReadyWait() const {
+    if (!m_readyCopy.has_value()) {
+        return std::nullopt;
+    }
+
+    return SemaphoreSubmit {
+        .semaphore = m_timelineSemaphore,
+        .value = m_copies[*m_readyCopy].readyValue,
+        .stageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+    };
+}
+
+VkImageView RenderTexture::getSampledView() const {
+    if (!m_readyCopy.has_value()) {
+        return VK_NULL_HANDLE;
+    }
+
+    return m_copies[*m_readyCopy].sampledView;
+}
+
+VkFormat RenderTexture::getFormat() const {
+    return m_format;
+}
+
+VkExtent2D RenderTexture::getExtent() const {
+    return m_extent;
+}
+
+uint32_t RenderTexture::getMipLevels() const {
+    return m_mipLevels;
+}
+
+void RenderTexture::createCommandPool() {
+    const auto poolInfo = VkCommandPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = m_computeQueueFamilyIndex,
+    };
+    const auto result = vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create render texture command pool!");
+    }
+}
+
+void RenderTexture::createTimelineSemaphore() {
+    const auto timelineCreateInfo = VkSemaphoreTypeCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = nullptr,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    const auto semaphoreInfo = VkSemaphoreCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timelineCreateInfo,
+        .flags = 0,
+    };
+    const auto result = vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_timelineSemaphore);
+    if (result != VK_SUCCESS) {
+        vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+
+        throw std::runtime_error("failed to create render texture timeline semaphore!");
+    }
+}
+
+void RenderTexture::createCopy(Copy& copy) {
+    const auto imageInfo = VkImageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = m_mipmapGenerator->getRequiredImageCreateFlags(m_format),
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = m_format,
+        .extent = VkExtent3D { m_extent.width, m_extent.height, 1 },
+        .mipLevels = m_mipLevels,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+            m_mipmapGenerator->getRequiredImageUsage(m_format),
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    const auto resultCreateImage = vkCreateImage(m_device, &imageInfo, nullptr, &copy.image);
+    if (resultCreateImage != VK_SUCCESS) {
+        throw std::runtime_error("failed to create render texture image!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetImageMemoryRequirements(m_device, copy.image, &memRequirements);
+
+    copy.allocation = m_allocator.allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Optimal, GpuMemoryCategory::Attachment);
+
+    vkBindImageMemory(m_device, copy.image, copy.allocation.memory, copy.allocation.offset);
+
+    const auto createView = [this, &copy](uint32_t levelCount) -> VkImageView {
+        const auto viewInfo = VkImageViewCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = copy.image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = m_format,
+            .subresourceRange = this->getSubresourceRange(0, levelCount),
+        };
+
+        auto imageView = VkImageView {};
+        const auto result = vkCreateImageView(m_device, &viewInfo, nullptr, &imageView);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create render texture image view!");
+        }
+
+        return imageView;
+    };
+    copy.sampledView = createView(m_mipLevels);
+    copy.attachmentView = createView(1);
+
+    const auto allocInfo = VkCommandBufferAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .commandPool = m_commandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    const auto resultAllocate = vkAllocateCommandBuffers(m_device, &allocInfo, &copy.commandBuffer);
+    if (resultAllocate != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate render texture command buffer!");
+    }
+}
+
+void RenderTexture::destroyCopy(Copy& copy) {
+    for (const auto& dispatchResources : copy.dispatchResources) {
+        m_mipmapGenerator->release(dispatchResources);
+    }
+    copy.dispatchResources.clear();
+
+    if (copy.commandBuffer != VK_NULL_HANDLE) {
+        vkFreeCommandBuffers(m_device, m_commandPool, 1, &copy.commandBuffer);
+    }
+    vkDestroyImageView(m_device, copy.attachmentView, nullptr);
+    vkDestroyImageView(m_device, copy.sampledView, nullptr);
+    vkDestroyImage(m_device, copy.image, nullptr);
+    if (copy.allocation.isValid()) {
+        m_allocator.free(copy.allocation);
+    }
+
+    copy = Copy {};
+}
+
+bool RenderTexture::isOwnershipTransferred() const {
+    return m_graphicsQueueFamilyIndex != m_computeQueueFamilyIndex;
+}
+
+VkImageSubresourceRange RenderTexture::getSubresourceRange(uint32_t baseMipLevel, uint32_t levelCount) const {
+    return VkImageSubresourceRange {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = baseMipLevel,
+        .levelCount = levelCount,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+}
@@ -0,0 +1,159 @@
+#ifndef _RENDER_TEXTURE_H
+#define _RENDER_TEXTURE_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "device_capabilities.h"
+#include "gpu_memory_allocator.h"
+#include "mipmap_generator.h"
+#include "queue_submitter.h"
+
+
+namespace VulkanEngine {
+
+/// @brief An offscreen color target that the graphics queue renders into every frame and
+/// the compute queue then fills the mip chain of, for reflection probes, minimaps and
+/// portals that are sampled from a distance.
+///
+/// @note The target has `copyCount` copies, each a full mip chain, which frames take turns
+/// at. A frame renders into one copy between `recordBeginRendering` and
+/// `recordEndRendering`, and `submitMipmaps` then downsamples it on the compute queue,
+/// once the frame timeline says the rendering is done, and signals a timeline of its own.
+/// The frame after samples that copy, waiting on its value at the fragment shader stage,
+/// while it renders into the next copy, so the graphics queue never waits for the compute
+/// work of its own frame. With one more copy than frames in flight, a copy is only
+/// rendered into again once every frame that sampled it has finished.
+///
+/// Where the compute queue is of a family of its own, every copy is released to it after
+/// it is rendered and acquired back before it is sampled, with `recordAcquire`. The mip
+/// chain is generated by a `MipmapGenerator` of the target's own, since the workgroup
+/// counters of the one uploads share are used on the graphics queue. Only the 8-bit RGBA
+/// formats of the generator are supported.
+class RenderTexture final {
+    public:
+        explicit RenderTexture() = delete;
+        explicit RenderTexture(
+            const DeviceCapabilities& capabilities,
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            QueueSubmitter& queueSubmitter,
+            VkPipelineCache pipelineCache,
+            bool isPushDescriptorSupported,
+            bool useSynchronization2,
+            std::span<const uint32_t> shaderCode,
+            std::span<const uint32_t> filterShaderCode,
+            std::span<const uint32_t> volumeShaderCode,
+            VkQueue computeQueue,
+            uint32_t graphicsQueueFamilyIndex,
+            uint32_t computeQueueFamilyIndex,
+            VkFormat format,
+            VkExtent2D extent,
+            uint32_t copyCount
+        );
+
+        ~RenderTexture();
+
+        RenderTexture(const RenderTexture& other) = delete;
+        RenderTexture& operator=(const RenderTexture& other) = delete;
+
+        /// @brief Record acquiring the copy the frame samples from the compute queue, where
+        /// it is of another family and the copy has not been acquired yet.
+        ///
+        /// @note Must be recorded in the graphics command buffer that waits on
+        /// `getReadyWait`, before anything samples the copy.
+        void recordAcquire(VkCommandBuffer commandBuffer);
+
+        /// @brief Pick the copy the frame renders into, and record moving its first level
+        /// into the color attachment layout, with the contents it had discarded.
+        void recordBeginRendering(VkCommandBuffer commandBuffer);
+
+        /// @brief The view of the first level of the copy the frame renders into, for
+        /// `vkCmdBeginRendering`, in `VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL`.
+        VkImageView getAttachmentView() const;
+
+        /// @brief Record releasing the copy rendered into to the compute queue, where it is
+        /// of another family, with its first level moving to the layout the mip generator
+        /// starts from.
+        ///
+        /// @note Must be recorded after the rendering has ended. On a compute queue of the
+        /// graphics family, the compute submission moves the levels itself.
+        void recordEndRendering(VkCommandBuffer commandBuffer);
+
+        /// @brief Submit generating the mip chain of the copy rendered into to the compute
+        /// queue, once `waitSemaphore` reaches `waitValue`, which the graphics submission of
+        /// the frame signals.
+        ///
+        /// @note Inside a batch of the queue submitter, the submission goes out with the
+        /// rest of it.
+        void submitMipmaps(VkSemaphore waitSemaphore, uint64_t waitValue);
+
+        /// @brief The wait a graphics submission needs before it samples `getSampledView`,
+        /// or nothing before the first mip chain has been submitted.
+        std::optional<SemaphoreSubmit> getReadyWait() const;
+
+        /// @brief The view of every level of the newest copy with a mip chain, in
+        /// `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL`, or a null handle before there is one.
+        VkImageView getSampledView() const;
+
+        VkFormat getFormat() const;
+
+        VkExtent2D getExtent() const;
+
+        uint32_t getMipLevels() const;
+    private:
+        struct Copy final {
+            VkImage image = VK_NULL_HANDLE;
+            GpuAllocation allocation {};
+            VkImageView sampledView = VK_NULL_HANDLE;
+            VkImageView attachmentView = VK_NULL_HANDLE;
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            /// @brief The value of the timeline once the mip chain of the copy is done, or
+            /// zero before one was submitted.
+            uint64_t readyValue = 0;
+            /// @brief Whether the graphics queue owns the copy again, or never gave it up.
+            bool isAcquired = true;
+            std::vector<MipmapGenerator::DispatchResources> dispatchResources;
+        };
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        QueueSubmitter& m_queueSubmitter;
+        bool m_useSynchronization2;
+        VkQueue m_computeQueue;
+        uint32_t m_graphicsQueueFamilyIndex;
+        uint32_t m_computeQueueFamilyIndex;
+        VkFormat m_format;
+        VkExtent2D m_extent;
+        uint32_t m_mipLevels;
+        std::unique_ptr<MipmapGenerator> m_mipmapGenerator;
+        VkCommandPool m_commandPool;
+        VkSemaphore m_timelineSemaphore;
+        uint64_t m_timelineValue;
+        std::vector<Copy> m_copies;
+        /// @brief The copy the frame renders into.
+        uint32_t m_targetCopy;
+        /// @brief The newest copy with a mip chain, which frames sample.
+        std::optional<uint32_t> m_readyCopy;
+
+        void createCommandPool();
+
+        void createTimelineSemaphore();
+
+        void createCopy(Copy& copy);
+
+        void destroyCopy(Copy& copy);
+
+        bool isOwnershipTransferred() const;
+
+        VkImageSubresourceRange getSubresourceRange(uint32_t baseMipLevel, uint32_t levelCount) const;
+};
+
+}
+
+#endif // _RENDER_TEXTURE_H
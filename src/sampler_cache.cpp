@@ -0,0 +1,165 @@
+#include "sampler_cache.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+using SamplerCache = VulkanEngine::SamplerCache;
+
+SamplerCache::SamplerCache(VkPhysicalDevice physicalDevice, VkDevice device)
+    : m_device { device }
+    , m_maxAnisotropy { 1.0f }
+    , m_maxLodBias { 0.0f }
+    , m_maxSamplerCount { 0 }
+    , m_anisotropyLimit { 1.0f }
+    , m_generation { 0 }
+    , m_samplers {}
+{
+    auto properties = VkPhysicalDeviceProperties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    m_maxAnisotropy = std::max(properties.limits.maxSamplerAnisotropy, 1.0f);
+    m_maxLodBias = properties.limits.maxSamplerLodBias;
+    m_maxSamplerCount = properties.limits.maxSamplerAllocationCount;
+    m_anisotropyLimit = m_maxAnisotropy;
+}
+
+SamplerCache::~SamplerCache() {
+    for (const auto& [state, sampler] : m_samplers) {
+        vkDestroySampler(m_device, sampler, nullptr);
+    }
+
+    m_samplers.clear();
+    m_device = VK_NULL_HANDLE;
+}
+
+VkSampler SamplerCache::getSampler(const VkSamplerCreateInfo& samplerInfo) {
+    if (samplerInfo.pNext != nullptr) {
+        throw std::invalid_argument("sampler cache cannot key samplers with extension structures!");
+    }
+
+    const auto state = this->getSamplerState(samplerInfo);
+    const auto found = m_samplers.find(state);
+    if (found != m_samplers.end()) {
+        return found->second;
+    }
+
+    if (m_samplers.size() >= m_maxSamplerCount) {
+        throw std::runtime_error("failed to create sampler, the device allows no more!");
+    }
+
+    const auto cachedSamplerInfo = VkSamplerCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .flags = state.flags,
+        .magFilter = state.magFilter,
+        .minFilter = state.minFilter,
+        .mipmapMode = state.mipmapMode,
+        .addressModeU = state.addressModeU,
+        .addressModeV = state.addressModeV,
+        .addressModeW = state.addressModeW,
+        .mipLodBias = state.mipLodBias,
+        .anisotropyEnable = state.anisotropyEnable,
+        .maxAnisotropy = state.maxAnisotropy,
+        .compareEnable = state.compareEnable,
+        .compareOp = state.compareOp,
+        .minLod = state.minLod,
+        .maxLod = state.maxLod,
+        .borderColor = state.borderColor,
+        .unnormalizedCoordinates = state.unnormalizedCoordinates,
+    };
+
+    auto sampler = VkSampler {};
+    const auto result = vkCreateSampler(m_device, &cachedSamplerInfo, nullptr, &sampler);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create sampler!");
+    }
+
+    m_samplers.emplace(state, sampler);
+
+    return sampler;
+}
+
+VkSampler SamplerCache::getSampler(const VkSamplerCreateInfo& samplerInfo, const SamplerPolicy& policy) {
+    return this->getSampler(this->applyPolicy(samplerInfo, policy));
+}
+
+VkSamplerCreateInfo SamplerCache::applyPolicy(const VkSamplerCreateInfo& samplerInfo, const SamplerPolicy& policy) const {
+    const auto anisotropy = std::min(this->getTierAnisotropy(policy.anisotropyTier), m_anisotropyLimit);
+
+    auto policySamplerInfo = samplerInfo;
+    policySamplerInfo.anisotropyEnable = anisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+    policySamplerInfo.maxAnisotropy = anisotropy;
+    policySamplerInfo.mipLodBias = std::clamp(samplerInfo.mipLodBias + policy.mipLodBias, -m_maxLodBias, m_maxLodBias);
+    policySamplerInfo.minLod = std::max(samplerInfo.minLod, policy.minLod);
+    policySamplerInfo.maxLod = std::max(std::min(samplerInfo.maxLod, policy.maxLod), policySamplerInfo.minLod);
+
+    return policySamplerInfo;
+}
+
+float SamplerCache::getTierAnisotropy(AnisotropyTier tier) const {
+    switch (tier) {
+        case AnisotropyTier::Off:
+            return 1.0f;
+        case AnisotropyTier::Low:
+            return std::min(2.0f, m_maxAnisotropy);
+        case AnisotropyTier::Medium:
+            return std::min(4.0f, m_maxAnisotropy);
+        case AnisotropyTier::High:
+            return m_maxAnisotropy;
+    }
+
+    return 1.0f;
+}
+
+float SamplerCache::getMaxAnisotropy() const {
+    return m_maxAnisotropy;
+}
+
+void SamplerCache::setAnisotropyLimit(float anisotropyLimit) {
+    const auto clampedLimit = std::clamp(anisotropyLimit, 1.0f, m_maxAnisotropy);
+    if (clampedLimit == m_anisotropyLimit) {
+        return;
+    }
+
+    m_anisotropyLimit = clampedLimit;
+    m_generation++;
+}
+
+float SamplerCache::getAnisotropyLimit() const {
+    return m_anisotropyLimit;
+}
+
+uint64_t SamplerCache::getGeneration() const {
+    return m_generation;
+}
+
+uint32_t SamplerCache::getSamplerCount() const {
+    return static_cast<uint32_t>(m_samplers.size());
+}
+
+SamplerCache::SamplerState SamplerCache::getSamplerState(const VkSamplerCreateInfo& samplerInfo) const {
+    const auto isAnisotropic = samplerInfo.anisotropyEnable == VK_TRUE;
+    const auto isComparing = samplerInfo.compareEnable == VK_TRUE;
+    const auto usesBorderColor = samplerInfo.addressModeU == VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER ||
+        samplerInfo.addressModeV == VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER ||
+        samplerInfo.addressModeW == VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+
+    return SamplerState {
+        .flags = samplerInfo.flags,
+        .magFilter = samplerInfo.magFilter,
+        .minFilter = samplerInfo.minFilter,
+        .mipmapMode = samplerInfo.mipmapMode,
+        .addressModeU = samplerInfo.addressModeU,
+        .addressModeV = samplerInfo.addressModeV,
+        .addressModeW = samplerInfo.addressModeW,
+        .mipLodBias = samplerInfo.mipLodBias,
+        .anisotropyEnable = isAnisotropic ? VK_TRUE : VK_FALSE,
+        .maxAnisotropy = isAnisotropic ? std::clamp(samplerInfo.maxAnisotropy, 1.0f, m_maxAnisotropy) : 1.0f,
+        .compareEnable = isComparing ? VK_TRUE : VK_FALSE,
+        .compareOp = isComparing ? samplerInfo.compareOp : VK_COMPARE_OP_NEVER,
+        .minLod = samplerInfo.minLod,
+        .maxLod = samplerInfo.maxLod,
+        .borderColor = usesBorderColor ? samplerInfo.borderColor : VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+        .unnormalizedCoordinates = samplerInfo.unnormalizedCoordinates,
+    };
+}
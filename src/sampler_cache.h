@@ -0,0 +1,128 @@
+#ifndef _SAMPLER_CACHE_H
+#define _SAMPLER_CACHE_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <map>
+
+
+namespace VulkanEngine {
+
+/// @brief How much anisotropic filtering a material's textures ask for.
+enum class AnisotropyTier : uint32_t {
+    /// @brief No anisotropic filtering.
+    Off,
+    /// @brief 2x.
+    Low,
+    /// @brief 4x.
+    Medium,
+    /// @brief The most the device samples with.
+    High
+};
+
+/// @brief The filtering a material samples its textures with, on top of the filters and
+/// address modes of their sampler.
+///
+/// @note The anisotropy of the tier is clamped to the anisotropy limit of the cache, and
+/// the LOD range of the policy narrows the one of the texture.
+struct SamplerPolicy final {
+    AnisotropyTier anisotropyTier = AnisotropyTier::High;
+    float mipLodBias = 0.0f;
+    float minLod = 0.0f;
+    float maxLod = VK_LOD_CLAMP_NONE;
+};
+
+/// @brief Hands out one sampler for every distinct sampler state, however many textures
+/// ask for it.
+///
+/// @note A sampler is keyed by every field of its create info: the filters, the address
+/// modes, anisotropy, comparison, the border color, and its LOD range. A request for state
+/// the cache has seen before returns the same sampler, so textures that sample alike share
+/// a sampler, and the device's `maxSamplerAllocationCount` bounds the number of distinct
+/// states rather than the number of textures. The anisotropy of a request is clamped to the
+/// limit of the device, which is queried once. The cache owns its samplers and destroys them
+/// with itself.
+///
+/// Samplers asked for with a `SamplerPolicy` also take the anisotropy limit of the cache,
+/// which the device profile and dynamic resolution lower on slower GPUs. Every change of the
+/// limit bumps the generation, so that the owners of those samplers know to ask for them
+/// again. The samplers of the old limit stay valid, so frames in flight can keep them.
+class SamplerCache final {
+    public:
+        explicit SamplerCache() = delete;
+        explicit SamplerCache(VkPhysicalDevice physicalDevice, VkDevice device);
+
+        ~SamplerCache();
+
+        SamplerCache(const SamplerCache& other) = delete;
+        SamplerCache& operator=(const SamplerCache& other) = delete;
+
+        /// @brief The sampler for the state in `samplerInfo`, created the first time the
+        /// state is asked for.
+        ///
+        /// @note Extension structures cannot be keyed, so `samplerInfo.pNext` must be null.
+        VkSampler getSampler(const VkSamplerCreateInfo& samplerInfo);
+
+        /// @brief The sampler for the state in `samplerInfo` filtered as `policy` asks.
+        VkSampler getSampler(const VkSamplerCreateInfo& samplerInfo, const SamplerPolicy& policy);
+
+        /// @brief `samplerInfo` with the anisotropy, the LOD bias and the LOD range of
+        /// `policy`, for the owners that key samplers off it themselves.
+        VkSamplerCreateInfo applyPolicy(const VkSamplerCreateInfo& samplerInfo, const SamplerPolicy& policy) const;
+
+        /// @brief The anisotropy `tier` samples with on the device, before the limit.
+        float getTierAnisotropy(AnisotropyTier tier) const;
+
+        /// @brief The highest anisotropy the device samples with.
+        float getMaxAnisotropy() const;
+
+        /// @brief Cap the anisotropy of every sampler asked for with a policy from now on.
+        ///
+        /// @note The limit is clamped to the device's.
+        void setAnisotropyLimit(float anisotropyLimit);
+
+        float getAnisotropyLimit() const;
+
+        /// @brief A count that goes up whenever the samplers a policy maps to change.
+        uint64_t getGeneration() const;
+
+        uint32_t getSamplerCount() const;
+    private:
+        struct SamplerState final {
+            VkSamplerCreateFlags flags;
+            VkFilter magFilter;
+            VkFilter minFilter;
+            VkSamplerMipmapMode mipmapMode;
+            VkSamplerAddressMode addressModeU;
+            VkSamplerAddressMode addressModeV;
+            VkSamplerAddressMode addressModeW;
+            float mipLodBias;
+            VkBool32 anisotropyEnable;
+            float maxAnisotropy;
+            VkBool32 compareEnable;
+            VkCompareOp compareOp;
+            float minLod;
+            float maxLod;
+            VkBorderColor borderColor;
+            VkBool32 unnormalizedCoordinates;
+
+            auto operator<=>(const SamplerState& other) const = default;
+        };
+
+        VkDevice m_device;
+        float m_maxAnisotropy;
+        float m_maxLodBias;
+        uint32_t m_maxSamplerCount;
+        float m_anisotropyLimit;
+        uint64_t m_generation;
+        std::map<SamplerState, VkSampler> m_samplers;
+
+        /// @brief The state of `samplerInfo`, with the fields that do not change sampling
+        /// made the same, so that requests differing only in those share a sampler.
+        SamplerState getSamplerState(const VkSamplerCreateInfo& samplerInfo) const;
+};
+
+}
+
+#endif // _SAMPLER_CACHE_H
@@ -0,0 +1,207 @@
+#include "scene.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE__) || defined(_M_X64)
+    #include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+#include "job_system.h"
+
+
+using Scene = VulkanEngine::Scene;
+using SceneNodeRange = VulkanEngine::SceneNodeRange;
+
+// Every column of the product is the columns of `a` weighted by a column of `b`, which is
+// four multiply-adds of whole columns.
+static void multiplyMatrices(const glm::mat4& a, const glm::mat4& b, glm::mat4& result) {
+#if defined(__SSE__) || defined(_M_X64)
+    const auto a0 = _mm_loadu_ps(&a[0][0]);
+    const auto a1 = _mm_loadu_ps(&a[1][0]);
+    const auto a2 = _mm_loadu_ps(&a[2][0]);
+    const auto a3 = _mm_loadu_ps(&a[3][0]);
+    for (glm::length_t column = 0; column < 4; column++) {
+        auto sum = _mm_mul_ps(a0, _mm_set1_ps(b[column][0]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(b[column][1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(b[column][2])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(b[column][3])));
+        _mm_storeu_ps(&result[column][0], sum);
+    }
+#elif defined(__ARM_NEON)
+    const auto a0 = vld1q_f32(&a[0][0]);
+    const auto a1 = vld1q_f32(&a[1][0]);
+    const auto a2 = vld1q_f32(&a[2][0]);
+    const auto a3 = vld1q_f32(&a[3][0]);
+    for (glm::length_t column = 0; column < 4; column++) {
+        auto sum = vmulq_n_f32(a0, b[column][0]);
+        sum = vmlaq_n_f32(sum, a1, b[column][1]);
+        sum = vmlaq_n_f32(sum, a2, b[column][2]);
+        sum = vmlaq_n_f32(sum, a3, b[column][3]);
+        vst1q_f32(&result[column][0], sum);
+    }
+#else
+    result = a * b;
+#endif
+}
+
+// The translation, rotation and scale of a node as one matrix.
+static glm::mat4 composeLocalMatrix(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+    const auto rotationMatrix = glm::mat3_cast(rotation);
+
+    return glm::mat4 {
+        glm::vec4(rotationMatrix[0] * scale.x, 0.0f),
+        glm::vec4(rotationMatrix[1] * scale.y, 0.0f),
+        glm::vec4(rotationMatrix[2] * scale.z, 0.0f),
+        glm::vec4(translation, 1.0f),
+    };
+}
+
+uint32_t Scene::addNode(
+    uint32_t parent,
+    const glm::vec3& translation,
+    const glm::quat& rotation,
+    const glm::vec3& scale,
+    const glm::vec4& localBoundingSphere
+) {
+    if (parent != NO_PARENT && parent >= this->getNodeCount()) {
+        throw std::invalid_argument("scene node parent does not exist!");
+    }
+
+    const auto node = this->getNodeCount();
+    const auto level = parent == NO_PARENT ? 0 : m_levels[parent] + 1;
+    if (level >= m_levelNodes.size()) {
+        m_levelNodes.resize(level + 1);
+    }
+
+    m_parents.push_back(parent);
+    m_translations.push_back(translation);
+    m_rotations.push_back(rotation);
+    m_scales.push_back(scale);
+    m_localBoundingSpheres.push_back(localBoundingSphere);
+    m_worldMatrices.push_back(glm::mat4(1.0f));
+    m_worldBoundingSpheres.push_back(localBoundingSphere);
+    m_isDirty.push_back(1);
+    m_isChanged.push_back(0);
+    m_levelNodes[level].push_back(node);
+    m_levels.push_back(level);
+    m_dirtyCount++;
+
+    return node;
+}
+
+void Scene::setLocalTransform(uint32_t node, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+    if (node >= this->getNodeCount()) {
+        throw std::invalid_argument("scene node does not exist!");
+    }
+
+    m_translations[node] = translation;
+    m_rotations[node] = rotation;
+    m_scales[node] = scale;
+    if (m_isDirty[node] == 0) {
+        m_isDirty[node] = 1;
+        m_dirtyCount++;
+    }
+}
+
+bool Scene::updateWorldTransforms(JobSystem* jobSystem) {
+    if (m_dirtyCount == 0) {
+        return false;
+    }
+
+    // A node under a dirty parent is marked dirty as it is recomputed, for its own children
+    // to find at the next depth. Every job only writes the flags of its own nodes.
+    for (const auto& levelNodes : m_levelNodes) {
+        const auto updateRun = [this, &levelNodes](size_t run) {
+            const auto end = std::min((run + 1) * UPDATE_GRAIN_SIZE, levelNodes.size());
+            for (auto i = run * UPDATE_GRAIN_SIZE; i < end; i++) {
+                const auto node = levelNodes[i];
+                const auto parent = m_parents[node];
+                const auto isParentDirty = parent != NO_PARENT && m_isDirty[parent] != 0;
+                if (m_isDirty[node] == 0 && !isParentDirty) {
+                    continue;
+                }
+
+                m_isDirty[node] = 1;
+                this->updateNode(node);
+            }
+        };
+
+        const auto runCount = (levelNodes.size() + UPDATE_GRAIN_SIZE - 1) / UPDATE_GRAIN_SIZE;
+        if (jobSystem == nullptr || runCount < 2) {
+            for (size_t run = 0; run < runCount; run++) {
+                updateRun(run);
+            }
+        } else {
+            jobSystem->parallelFor(runCount, 1, updateRun);
+        }
+    }
+
+    for (size_t node = 0; node < m_isDirty.size(); node++) {
+        m_isChanged[node] |= m_isDirty[node];
+        m_isDirty[node] = 0;
+    }
+    m_dirtyCount = 0;
+    m_hasChanges = true;
+
+    return true;
+}
+
+std::vector<SceneNodeRange> Scene::takeChangedRanges() {
+    auto changedRanges = std::vector<SceneNodeRange> {};
+    if (!m_hasChanges) {
+        return changedRanges;
+    }
+
+    for (uint32_t node = 0; node < this->getNodeCount(); node++) {
+        if (m_isChanged[node] == 0) {
+            continue;
+        }
+
+        m_isChanged[node] = 0;
+        if (!changedRanges.empty() && changedRanges.back().firstNode + changedRanges.back().nodeCount == node) {
+            changedRanges.back().nodeCount++;
+        } else {
+            changedRanges.push_back(SceneNodeRange { .firstNode = node, .nodeCount = 1 });
+        }
+    }
+    m_hasChanges = false;
+
+    return changedRanges;
+}
+
+uint32_t Scene::getNodeCount() const {
+    return static_cast<uint32_t>(m_parents.size());
+}
+
+std::span<const glm::mat4> Scene::getWorldMatrices() const {
+    return m_worldMatrices;
+}
+
+std::span<const glm::vec4> Scene::getWorldBoundingSpheres() const {
+    return m_worldBoundingSpheres;
+}
+
+void Scene::updateNode(uint32_t node) {
+    const auto localMatrix = composeLocalMatrix(m_translations[node], m_rotations[node], m_scales[node]);
+    auto& worldMatrix = m_worldMatrices[node];
+    const auto parent = m_parents[node];
+    if (parent == NO_PARENT) {
+        worldMatrix = localMatrix;
+    } else {
+        multiplyMatrices(m_worldMatrices[parent], localMatrix, worldMatrix);
+    }
+
+    // The sphere is scaled by the longest axis of the world matrix, so that it holds the
+    // node however the matrix scales it.
+    const auto& localBoundingSphere = m_localBoundingSpheres[node];
+    const auto center = worldMatrix * glm::vec4(glm::vec3(localBoundingSphere), 1.0f);
+    const auto scale = std::max({
+        glm::length(glm::vec3(worldMatrix[0])),
+        glm::length(glm::vec3(worldMatrix[1])),
+        glm::length(glm::vec3(worldMatrix[2])),
+    });
+    m_worldBoundingSpheres[node] = glm::vec4(glm::vec3(center), localBoundingSphere.w * scale);
+}
@@ -0,0 +1,101 @@
+#ifndef _SCENE_H
+#define _SCENE_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+
+namespace VulkanEngine {
+
+class JobSystem;
+
+/// @brief A run of consecutive nodes of a `Scene`.
+struct SceneNodeRange final {
+    uint32_t firstNode;
+    uint32_t nodeCount;
+};
+
+/// @brief The transforms, bounds and hierarchy of the nodes of a scene, each in an array
+/// of its own, with the world transforms kept up to date by `updateWorldTransforms`.
+///
+/// @note A node's world matrix is its parent's world matrix times its local translation,
+/// rotation and scale, and its world bounding sphere holds its local one under the world
+/// matrix. Every parent comes before its children, so the nodes of each depth of the
+/// hierarchy only read world matrices of the depth above, which are final by the time they
+/// are read. The nodes of a depth are updated in runs of `UPDATE_GRAIN_SIZE` on the jobs
+/// of a `JobSystem`, with the matrix products done four floats at a time.
+///
+/// Setting a local transform marks the node dirty. An update only recomputes the dirty
+/// nodes and the nodes under them, and costs nothing when nothing is dirty. The nodes it
+/// recomputes are reported by `takeChangedRanges` until they are taken, so that only what
+/// changed is uploaded to the GPU.
+class Scene final {
+    public:
+        static constexpr uint32_t NO_PARENT = UINT32_MAX;
+        static constexpr size_t UPDATE_GRAIN_SIZE = 1024;
+
+        explicit Scene() = default;
+
+        ~Scene() = default;
+
+        Scene(const Scene& other) = delete;
+        Scene& operator=(const Scene& other) = delete;
+
+        /// @brief Add a dirty node under `parent`, or a root with `NO_PARENT`, and return
+        /// its index.
+        uint32_t addNode(
+            uint32_t parent,
+            const glm::vec3& translation,
+            const glm::quat& rotation,
+            const glm::vec3& scale,
+            const glm::vec4& localBoundingSphere
+        );
+
+        void setLocalTransform(uint32_t node, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+
+        /// @brief Recompute the world transforms and bounds of every dirty node and the
+        /// nodes under it, on the jobs of `jobSystem` if there are enough of them, and on
+        /// the calling thread otherwise or without one, and return whether any were.
+        bool updateWorldTransforms(JobSystem* jobSystem);
+
+        /// @brief The runs of nodes recomputed since the changes were last taken, in order,
+        /// and forget them.
+        std::vector<SceneNodeRange> takeChangedRanges();
+
+        uint32_t getNodeCount() const;
+
+        std::span<const glm::mat4> getWorldMatrices() const;
+
+        /// @brief The world space bounding sphere of every node, with the radius in `w`.
+        std::span<const glm::vec4> getWorldBoundingSpheres() const;
+    private:
+        std::vector<uint32_t> m_parents;
+        std::vector<glm::vec3> m_translations;
+        std::vector<glm::quat> m_rotations;
+        std::vector<glm::vec3> m_scales;
+        std::vector<glm::vec4> m_localBoundingSpheres;
+        std::vector<glm::mat4> m_worldMatrices;
+        std::vector<glm::vec4> m_worldBoundingSpheres;
+        /// @brief Whether each node is recomputed by the next update. Bytes rather than
+        /// `std::vector<bool>`, so that the jobs of an update can write their own nodes.
+        std::vector<uint8_t> m_isDirty;
+        std::vector<uint8_t> m_isChanged;
+        /// @brief The nodes of every depth of the hierarchy, roots first.
+        std::vector<std::vector<uint32_t>> m_levelNodes;
+        std::vector<uint32_t> m_levels;
+        uint32_t m_dirtyCount { 0 };
+        bool m_hasChanges { false };
+
+        void updateNode(uint32_t node);
+};
+
+}
+
+#endif // _SCENE_H
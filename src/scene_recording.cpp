@@ -0,0 +1,110 @@
+#include "scene_recording.h"
+
+#include <array>
+#include <fstream>
+#include <stdexcept>
+
+
+using SceneRecording = VulkanEngine::SceneRecording;
+using SceneRecordingFrame = VulkanEngine::SceneRecordingFrame;
+
+// Any change to the layout of the file must bump the version, so that old recordings fail
+// to load instead of replaying the wrong frames.
+static constexpr uint32_t RECORDING_FILE_MAGIC = 0x524e4353; // "SCNR"
+static constexpr uint32_t RECORDING_FILE_VERSION = 1;
+
+struct RecordingFileHeader final {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t frameCount;
+};
+
+// The frames are stored without the padding of the aligned GLM types.
+struct RecordingFileFrame final {
+    double time;
+    std::array<float, 3> cameraPosition;
+    std::array<float, 16> view;
+};
+
+SceneRecording SceneRecording::load(const std::filesystem::path& path) {
+    auto file = std::ifstream { path, std::ios::binary };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open scene recording!");
+    }
+
+    auto header = RecordingFileHeader {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != RECORDING_FILE_MAGIC || header.version != RECORDING_FILE_VERSION) {
+        throw std::runtime_error("failed to load scene recording: not a recording of this version!");
+    }
+
+    auto recording = SceneRecording {};
+    for (uint64_t i = 0; i < header.frameCount; i++) {
+        auto storedFrame = RecordingFileFrame {};
+        file.read(reinterpret_cast<char*>(&storedFrame), sizeof(storedFrame));
+        if (!file) {
+            throw std::runtime_error("failed to load scene recording: the file ends early!");
+        }
+
+        auto frame = SceneRecordingFrame {
+            .time = storedFrame.time,
+            .cameraPosition = glm::vec3(storedFrame.cameraPosition[0], storedFrame.cameraPosition[1], storedFrame.cameraPosition[2]),
+            .view = glm::mat4(1.0f),
+        };
+        for (glm::length_t column = 0; column < 4; column++) {
+            for (glm::length_t row = 0; row < 4; row++) {
+                frame.view[column][row] = storedFrame.view[4 * column + row];
+            }
+        }
+        recording.m_frames.push_back(frame);
+    }
+
+    return recording;
+}
+
+void SceneRecording::save(const std::filesystem::path& path) const {
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+
+    auto file = std::ofstream { path, std::ios::binary | std::ios::trunc };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open scene recording for writing!");
+    }
+
+    const auto header = RecordingFileHeader {
+        .magic = RECORDING_FILE_MAGIC,
+        .version = RECORDING_FILE_VERSION,
+        .frameCount = m_frames.size(),
+    };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& frame : m_frames) {
+        auto storedFrame = RecordingFileFrame {
+            .time = frame.time,
+            .cameraPosition = { frame.cameraPosition.x, frame.cameraPosition.y, frame.cameraPosition.z },
+            .view = {},
+        };
+        for (glm::length_t column = 0; column < 4; column++) {
+            for (glm::length_t row = 0; row < 4; row++) {
+                storedFrame.view[4 * column + row] = frame.view[column][row];
+            }
+        }
+        file.write(reinterpret_cast<const char*>(&storedFrame), sizeof(storedFrame));
+    }
+
+    if (!file) {
+        throw std::runtime_error("failed to write scene recording!");
+    }
+}
+
+void SceneRecording::addFrame(const SceneRecordingFrame& frame) {
+    m_frames.push_back(frame);
+}
+
+size_t SceneRecording::getFrameCount() const {
+    return m_frames.size();
+}
+
+const SceneRecordingFrame& SceneRecording::getFrame(size_t index) const {
+    return m_frames.at(index);
+}
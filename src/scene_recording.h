@@ -0,0 +1,57 @@
+#ifndef _SCENE_RECORDING_H
+#define _SCENE_RECORDING_H
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+
+namespace VulkanEngine {
+
+/// @brief The state of the scene one frame was drawn with.
+struct SceneRecordingFrame final {
+    /// @brief The seconds since the first frame, which the animations of the scene follow.
+    double time = 0.0;
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    glm::mat4 view = glm::mat4(1.0f);
+};
+
+/// @brief The scene state of every frame of a run, in the order they were drawn, which a
+/// later run can draw again exactly.
+///
+/// @note The file is a header and the frames, every value in the byte order and float
+/// format of the machine that wrote it, so values come back bit for bit. A file of another
+/// version, or one that ends early, fails to load.
+class SceneRecording final {
+    public:
+        explicit SceneRecording() = default;
+
+        ~SceneRecording() = default;
+
+        SceneRecording(SceneRecording&& other) noexcept = default;
+        SceneRecording& operator=(SceneRecording&& other) noexcept = default;
+
+        SceneRecording(const SceneRecording& other) = delete;
+        SceneRecording& operator=(const SceneRecording& other) = delete;
+
+        static SceneRecording load(const std::filesystem::path& path);
+
+        void save(const std::filesystem::path& path) const;
+
+        void addFrame(const SceneRecordingFrame& frame);
+
+        size_t getFrameCount() const;
+
+        const SceneRecordingFrame& getFrame(size_t index) const;
+    private:
+        std::vector<SceneRecordingFrame> m_frames;
+};
+
+}
+
+#endif // _SCENE_RECORDING_H
@@ -0,0 +1,187 @@
+#include "secondary_command_recorder.h"
+#include "cpu_profiler.h"
+#include "command_counters.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+
+using SecondaryCommandRecorder = VulkanEngine::SecondaryCommandRecorder;
+using CommandCounters = VulkanEngine::CommandCounters;
+using CommandPassScope = VulkanEngine::CommandPassScope;
+
+SecondaryCommandRecorder::SecondaryCommandRecorder(VkDevice device, uint32_t queueFamilyIndex, uint32_t frameCount, uint32_t threadCount)
+    : m_device { device }
+    , m_workers { std::vector<Worker> { std::max(threadCount, 1u) } }
+    , m_recordedCommandBuffers { std::vector<VkCommandBuffer>(m_workers.size(), VK_NULL_HANDLE) }
+    , m_generation { 0 }
+    , m_pendingCount { 0 }
+    , m_frameIndex { 0 }
+    , m_inheritanceInfo { nullptr }
+    , m_recordChunk { nullptr }
+    , m_counterPass { CommandCounters::NO_PASS }
+    , m_error { nullptr }
+    , m_isStopping { false }
+{
+    // Command buffers are only ever reset with their whole pool.
+    const auto poolInfo = VkCommandPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = queueFamilyIndex,
+    };
+    for (auto& worker : m_workers) {
+        for (uint32_t i = 0; i < frameCount; i++) {
+            auto commandPool = VkCommandPool {};
+            const auto resultCreateCommandPool = vkCreateCommandPool(m_device, &poolInfo, nullptr, &commandPool);
+            if (resultCreateCommandPool != VK_SUCCESS) {
+                throw std::runtime_error("failed to create secondary command pool!");
+            }
+
+            worker.commandPools.push_back(commandPool);
+
+            const auto allocInfo = VkCommandBufferAllocateInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = commandPool,
+                .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                .commandBufferCount = 1,
+            };
+            auto commandBuffer = VkCommandBuffer {};
+            const auto resultAllocateCommandBuffers = vkAllocateCommandBuffers(m_device, &allocInfo, &commandBuffer);
+            if (resultAllocateCommandBuffers != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate secondary command buffers!");
+            }
+
+            worker.commandBuffers.push_back(commandBuffer);
+        }
+    }
+
+    for (uint32_t i = 0; i < m_workers.size(); i++) {
+        m_threads.emplace_back([this, i]() { this->run(i); });
+    }
+}
+
+SecondaryCommandRecorder::~SecondaryCommandRecorder() {
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        m_isStopping = true;
+    }
+
+    m_workAvailable.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+
+    // Destroying a pool frees its command buffers.
+    for (const auto& worker : m_workers) {
+        for (const auto& commandPool : worker.commandPools) {
+            vkDestroyCommandPool(m_device, commandPool, nullptr);
+        }
+    }
+
+    m_threads.clear();
+    m_recordedCommandBuffers.clear();
+    m_workers.clear();
+    m_device = VK_NULL_HANDLE;
+}
+
+uint32_t SecondaryCommandRecorder::getThreadCount() const {
+    return static_cast<uint32_t>(m_workers.size());
+}
+
+std::span<const VkCommandBuffer> SecondaryCommandRecorder::record(
+    uint32_t frameIndex,
+    const VkCommandBufferInheritanceInfo& inheritanceInfo,
+    const ChunkRecorder& recordChunk
+) {
+    if (frameIndex >= m_workers.front().commandPools.size()) {
+        throw std::invalid_argument("frame index out of range!");
+    }
+
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+    m_frameIndex = frameIndex;
+    m_inheritanceInfo = &inheritanceInfo;
+    m_recordChunk = &recordChunk;
+    m_counterPass = CommandCounters::getCurrentPass();
+    m_error = nullptr;
+    m_pendingCount = static_cast<uint32_t>(m_workers.size());
+    m_generation++;
+    m_workAvailable.notify_all();
+
+    m_workFinished.wait(lock, [this]() { return m_pendingCount == 0; });
+
+    m_inheritanceInfo = nullptr;
+    m_recordChunk = nullptr;
+    if (m_error) {
+        std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        m_recordedCommandBuffers[i] = m_workers[i].commandBuffers[frameIndex];
+    }
+
+    return m_recordedCommandBuffers;
+}
+
+void SecondaryCommandRecorder::run(uint32_t workerIndex) {
+    auto generation = uint64_t { 0 };
+    while (true) {
+        auto lock = std::unique_lock<std::mutex> { m_mutex };
+        m_workAvailable.wait(lock, [this, generation]() { return m_isStopping || m_generation != generation; });
+        if (m_isStopping) {
+            return;
+        }
+
+        generation = m_generation;
+        lock.unlock();
+
+        auto error = std::exception_ptr { nullptr };
+        try {
+            this->recordChunk(workerIndex);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        if (error && !m_error) {
+            m_error = error;
+        }
+
+        m_pendingCount--;
+        const auto isDone = m_pendingCount == 0;
+        lock.unlock();
+
+        if (isDone) {
+            m_workFinished.notify_one();
+        }
+    }
+}
+
+void SecondaryCommandRecorder::recordChunk(uint32_t workerIndex) {
+    CPU_PROFILE_ZONE("record secondary");
+    const auto passScope = CommandPassScope { m_counterPass };
+    const auto& worker = m_workers[workerIndex];
+    const auto commandBuffer = worker.commandBuffers[m_frameIndex];
+
+    const auto resultResetCommandPool = vkResetCommandPool(m_device, worker.commandPools[m_frameIndex], 0);
+    if (resultResetCommandPool != VK_SUCCESS) {
+        throw std::runtime_error("failed to reset secondary command pool!");
+    }
+
+    const auto beginInfo = VkCommandBufferBeginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = m_inheritanceInfo,
+    };
+    const auto resultBeginCommandBuffer = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    if (resultBeginCommandBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording secondary command buffer!");
+    }
+
+    (*m_recordChunk)(commandBuffer, workerIndex, static_cast<uint32_t>(m_workers.size()));
+
+    const auto resultEndCommandBuffer = vkEndCommandBuffer(commandBuffer);
+    if (resultEndCommandBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to record secondary command buffer!");
+    }
+}
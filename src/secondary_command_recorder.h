@@ -0,0 +1,89 @@
+#ifndef _SECONDARY_COMMAND_RECORDER_H
+#define _SECONDARY_COMMAND_RECORDER_H
+
+#include <vulkan/vulkan.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief Records secondary command buffers in parallel on a pool of worker threads.
+///
+/// @note Command pools cannot be used from two threads at once, so every worker has a
+/// command pool of its own for every frame slot. Each pool holds one secondary command
+/// buffer. `record` resets the pools of a frame slot, so the slot's previous submit has
+/// to have finished first, just like the primary command buffer of the slot.
+///
+/// The work of a frame is split into one chunk per worker. Worker `i` always records chunk
+/// `i`, and the secondaries come back in chunk order, so the primary executes them in the
+/// same order every frame.
+class SecondaryCommandRecorder final {
+    public:
+        using ChunkRecorder = std::function<void(VkCommandBuffer commandBuffer, uint32_t chunkIndex, uint32_t chunkCount)>;
+
+        explicit SecondaryCommandRecorder() = delete;
+        explicit SecondaryCommandRecorder(VkDevice device, uint32_t queueFamilyIndex, uint32_t frameCount, uint32_t threadCount);
+
+        /// @brief Stop the workers and destroy their command pools.
+        ///
+        /// @note The secondaries must not be pending on the GPU.
+        ~SecondaryCommandRecorder();
+
+        SecondaryCommandRecorder(const SecondaryCommandRecorder& other) = delete;
+        SecondaryCommandRecorder& operator=(const SecondaryCommandRecorder& other) = delete;
+
+        uint32_t getThreadCount() const;
+
+        /// @brief Record one secondary command buffer per worker for `frameIndex`, and wait
+        /// for all of them.
+        ///
+        /// @note Every secondary is begun with `inheritanceInfo` and continues the render pass
+        /// or dynamic rendering of the primary, so `recordChunk` only records the commands
+        /// inside it. Secondaries inherit no state from the primary, so each chunk binds its
+        /// own pipeline, descriptor sets and dynamic state. An error thrown by `recordChunk`
+        /// is rethrown here. The secondaries are handed back in a list the recorder keeps, which
+        /// stays valid until the next call. The workers count their commands into the pass the
+        /// calling thread counts into.
+        std::span<const VkCommandBuffer> record(
+            uint32_t frameIndex,
+            const VkCommandBufferInheritanceInfo& inheritanceInfo,
+            const ChunkRecorder& recordChunk
+        );
+    private:
+        struct Worker final {
+            std::vector<VkCommandPool> commandPools;
+            std::vector<VkCommandBuffer> commandBuffers;
+        };
+
+        VkDevice m_device;
+        std::vector<Worker> m_workers;
+        std::vector<VkCommandBuffer> m_recordedCommandBuffers;
+        std::mutex m_mutex;
+        std::condition_variable m_workAvailable;
+        std::condition_variable m_workFinished;
+        uint64_t m_generation;
+        uint32_t m_pendingCount;
+        uint32_t m_frameIndex;
+        const VkCommandBufferInheritanceInfo* m_inheritanceInfo;
+        const ChunkRecorder* m_recordChunk;
+        uint32_t m_counterPass;
+        std::exception_ptr m_error;
+        bool m_isStopping;
+        std::vector<std::thread> m_threads;
+
+        void run(uint32_t workerIndex);
+
+        void recordChunk(uint32_t workerIndex);
+};
+
+}
+
+#endif // _SECONDARY_COMMAND_RECORDER_H
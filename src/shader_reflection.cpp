@@ -0,0 +1,137 @@
+#include "shader_reflection.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+using ShaderReflection = VulkanEngine::ShaderReflection;
+using ReflectedBinding = VulkanEngine::ReflectedBinding;
+using ReflectedVertexInput = VulkanEngine::ReflectedVertexInput;
+
+/// @brief The type of a binding that declares both `first` and `second`, such as the image
+/// and the sampler of a combined image sampler, or nothing if they cannot share one.
+static std::optional<VkDescriptorType> combineDescriptorTypes(VkDescriptorType first, VkDescriptorType second) {
+    if (first == second) {
+        return first;
+    }
+
+    const auto isImageOrSampler = [](VkDescriptorType type) {
+        return type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+            || type == VK_DESCRIPTOR_TYPE_SAMPLER
+            || type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    };
+    if (isImageOrSampler(first) && isImageOrSampler(second)) {
+        return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    }
+
+    return std::nullopt;
+}
+
+/// @brief Add `binding` to `bindings`, or combine it with the binding already there.
+static void addBinding(std::vector<ReflectedBinding>& bindings, const ReflectedBinding& binding) {
+    const auto found = std::find_if(bindings.begin(), bindings.end(), [&binding](const auto& other) {
+        return other.set == binding.set && other.binding == binding.binding;
+    });
+    if (found == bindings.end()) {
+        bindings.push_back(binding);
+        return;
+    }
+
+    const auto descriptorType = combineDescriptorTypes(found->descriptorType, binding.descriptorType);
+    if (!descriptorType.has_value() || found->descriptorCount != binding.descriptorCount) {
+        throw std::runtime_error("failed to reflect shaders, two descriptors share a binding!");
+    }
+
+    found->descriptorType = descriptorType.value();
+    found->stageFlags |= binding.stageFlags;
+}
+
+ShaderReflection::ShaderReflection(const embed_spirv::EmbeddedReflection& reflection)
+    : m_stage { static_cast<VkShaderStageFlagBits>(reflection.stage) }
+    , m_bindings {}
+    , m_pushConstantRange {}
+    , m_vertexInputs {}
+{
+    for (const auto& binding : reflection.bindings) {
+        m_bindings.push_back(ReflectedBinding {
+            .set = binding.set,
+            .binding = binding.binding,
+            .descriptorType = static_cast<VkDescriptorType>(binding.descriptorType),
+            .descriptorCount = binding.descriptorCount,
+            .stageFlags = static_cast<VkShaderStageFlags>(m_stage),
+        });
+    }
+
+    if (reflection.pushConstantSize > 0) {
+        m_pushConstantRange = VkPushConstantRange {
+            .stageFlags = static_cast<VkShaderStageFlags>(m_stage),
+            .offset = reflection.pushConstantOffset,
+            .size = reflection.pushConstantSize,
+        };
+    }
+
+    for (const auto& vertexInput : reflection.vertexInputs) {
+        m_vertexInputs.push_back(ReflectedVertexInput {
+            .location = vertexInput.location,
+            .format = static_cast<VkFormat>(vertexInput.format),
+        });
+    }
+}
+
+std::vector<ReflectedBinding> ShaderReflection::mergeBindings(std::span<const ShaderReflection> shaders, uint32_t set) {
+    auto bindings = std::vector<ReflectedBinding> {};
+    for (const auto& shader : shaders) {
+        for (const auto& binding : shader.getBindings()) {
+            if (binding.set == set) {
+                addBinding(bindings, binding);
+            }
+        }
+    }
+
+    std::sort(bindings.begin(), bindings.end(), [](const auto& first, const auto& second) {
+        return first.binding < second.binding;
+    });
+
+    return bindings;
+}
+
+std::optional<VkPushConstantRange> ShaderReflection::mergePushConstantRanges(std::span<const ShaderReflection> shaders) {
+    auto mergedRange = std::optional<VkPushConstantRange> {};
+    for (const auto& shader : shaders) {
+        const auto range = shader.getPushConstantRange();
+        if (!range.has_value()) {
+            continue;
+        }
+
+        if (!mergedRange.has_value()) {
+            mergedRange = range;
+            continue;
+        }
+
+        const auto begin = std::min(mergedRange->offset, range->offset);
+        const auto end = std::max(mergedRange->offset + mergedRange->size, range->offset + range->size);
+        mergedRange = VkPushConstantRange {
+            .stageFlags = mergedRange->stageFlags | range->stageFlags,
+            .offset = begin,
+            .size = end - begin,
+        };
+    }
+
+    return mergedRange;
+}
+
+VkShaderStageFlagBits ShaderReflection::getStage() const {
+    return m_stage;
+}
+
+const std::vector<ReflectedBinding>& ShaderReflection::getBindings() const {
+    return m_bindings;
+}
+
+std::optional<VkPushConstantRange> ShaderReflection::getPushConstantRange() const {
+    return m_pushConstantRange;
+}
+
+const std::vector<ReflectedVertexInput>& ShaderReflection::getVertexInputs() const {
+    return m_vertexInputs;
+}
@@ -0,0 +1,72 @@
+#ifndef _SHADER_REFLECTION_H
+#define _SHADER_REFLECTION_H
+
+#include <vulkan/vulkan.h>
+
+#include <embed_spirv/embedded_reflection.h>
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief A descriptor a shader declares.
+struct ReflectedBinding final {
+    uint32_t set;
+    uint32_t binding;
+    VkDescriptorType descriptorType;
+    /// @brief The descriptors of the binding, or zero for an array without a size, which
+    /// the layout has to give one.
+    uint32_t descriptorCount;
+    VkShaderStageFlags stageFlags;
+};
+
+/// @brief An input of a vertex shader that the vertex input state feeds.
+struct ReflectedVertexInput final {
+    uint32_t location;
+    VkFormat format;
+};
+
+/// @brief The interface of a shader: its stage, the descriptors it declares, the range of
+/// push constants it reads, and the inputs of a vertex shader.
+///
+/// @note `embed_spirv` reflects the SPIR-V when the shaders are built and embeds the result
+/// next to the code, so nothing is parsed at startup. An image and a sampler at the same
+/// binding, as HLSL declares them, already make a combined image sampler there.
+class ShaderReflection final {
+    public:
+        explicit ShaderReflection() = delete;
+        explicit ShaderReflection(const embed_spirv::EmbeddedReflection& reflection);
+
+        /// @brief The bindings of every shader in `shaders` in `set`, ordered by binding,
+        /// with the stages of the shaders that declare each.
+        ///
+        /// @note Throws when two of the shaders declare a binding differently.
+        static std::vector<ReflectedBinding> mergeBindings(std::span<const ShaderReflection> shaders, uint32_t set);
+
+        /// @brief The range that covers the push constants of every shader in `shaders`,
+        /// with the stages of the shaders that read them, or nothing if none does.
+        static std::optional<VkPushConstantRange> mergePushConstantRanges(std::span<const ShaderReflection> shaders);
+
+        VkShaderStageFlagBits getStage() const;
+
+        const std::vector<ReflectedBinding>& getBindings() const;
+
+        std::optional<VkPushConstantRange> getPushConstantRange() const;
+
+        /// @brief The vertex inputs, ordered by location, with a location for every column
+        /// of a matrix. Empty for every stage but the vertex stage.
+        const std::vector<ReflectedVertexInput>& getVertexInputs() const;
+    private:
+        VkShaderStageFlagBits m_stage;
+        std::vector<ReflectedBinding> m_bindings;
+        std::optional<VkPushConstantRange> m_pushConstantRange;
+        std::vector<ReflectedVertexInput> m_vertexInputs;
+};
+
+}
+
+#endif // _SHADER_REFLECTION_H
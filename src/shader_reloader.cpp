@@ -0,0 +1,217 @@
+#include "shader_reloader.h"
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+
+using ShaderReloader = VulkanEngine::ShaderReloader;
+using ReloadedShader = VulkanEngine::ReloadedShader;
+
+/// @brief The arguments that compile `sourceFile` into `spirvFile`, or nothing when the
+/// file is not named like a shader.
+///
+/// @note These mirror `cmake/CompileGLSL_Lib.cmake` and `cmake/CompileHLSL_Lib.cmake`. Task
+/// and mesh shaders need SPIR-V 1.4, so they target Vulkan 1.3, and everything else
+/// targets Vulkan 1.0.
+static std::optional<std::string> getCompileArguments(
+    const std::filesystem::path& sourceFile,
+    const std::filesystem::path& spirvFile
+) {
+    const auto language = sourceFile.extension().string();
+    const auto stage = sourceFile.stem().extension().string();
+    const auto isMeshShading = stage == ".task" || stage == ".mesh";
+    const auto files = fmt::format("-o \"{}\" \"{}\"", spirvFile.string(), sourceFile.string());
+    if (language == ".glsl") {
+        if (stage != ".vert" && stage != ".frag" && stage != ".comp" && !isMeshShading) {
+            return std::nullopt;
+        }
+
+        return fmt::format(
+            "-fshader-stage={} --target-env={} {}",
+            stage.substr(1),
+            isMeshShading ? "vulkan1.3" : "vulkan1.0",
+            files
+        );
+    } else if (language == ".hlsl") {
+        const auto profile = [&stage]() -> std::string {
+            if (stage == ".vert") {
+                return "vs_6_1";
+            } else if (stage == ".frag") {
+                return "ps_6_1";
+            } else if (stage == ".comp") {
+                return "cs_6_1";
+            } else if (stage == ".task") {
+                return "as_6_5";
+            } else if (stage == ".mesh") {
+                return "ms_6_5";
+            } else {
+                return "";
+            }
+        }();
+        if (profile.empty()) {
+            return std::nullopt;
+        }
+
+        // `dxc` only emits the `VK_EXT_mesh_shader` flavor of task and mesh shaders when
+        // asked for the extension.
+        const auto meshShadingArguments = isMeshShading ? " -fspv-target-env=vulkan1.3 -fspv-extension=SPV_EXT_mesh_shader" : "";
+
+        return fmt::format(
+            "-spirv -T {} -E main{} -Fo \"{}\" \"{}\"",
+            profile,
+            meshShadingArguments,
+            spirvFile.string(),
+            sourceFile.string()
+        );
+    } else {
+        return std::nullopt;
+    }
+}
+
+static std::optional<std::vector<uint32_t>> readSpirvFile(const std::filesystem::path& spirvFile) {
+    auto file = std::ifstream { spirvFile, std::ios::binary | std::ios::ate };
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+
+    const auto fileSize = static_cast<size_t>(file.tellg());
+    if (fileSize == 0 || fileSize % sizeof(uint32_t) != 0) {
+        return std::nullopt;
+    }
+
+    auto code = std::vector<uint32_t>(fileSize / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(code.data()), static_cast<std::streamsize>(fileSize));
+    if (!file) {
+        return std::nullopt;
+    }
+
+    return code;
+}
+
+ShaderReloader::ShaderReloader(
+    const std::filesystem::path& shaderDirectory,
+    const std::filesystem::path& outputDirectory,
+    const ShaderCompilers& compilers,
+    std::chrono::milliseconds pollInterval
+)
+    : m_shaderDirectory { shaderDirectory }
+    , m_outputDirectory { outputDirectory }
+    , m_compilers { compilers }
+    , m_pollInterval { pollInterval }
+    , m_writeTimes { WriteTimes {} }
+    , m_reloadedShaders { std::unordered_map<std::string, std::vector<uint32_t>> {} }
+    , m_isStopping { false }
+{
+    if (!std::filesystem::is_directory(m_shaderDirectory)) {
+        throw std::invalid_argument(fmt::format("shader directory not found: {}", m_shaderDirectory.string()));
+    }
+
+    std::filesystem::create_directories(m_outputDirectory);
+
+    // Only the shaders that change from here on are compiled, since the build compiled the
+    // rest.
+    m_writeTimes = this->findWriteTimes();
+    m_worker = std::thread { [this]() { this->run(); } };
+}
+
+ShaderReloader::~ShaderReloader() {
+    {
+        const auto lock = std::lock_guard<std::mutex> { m_mutex };
+        m_isStopping = true;
+    }
+
+    m_stopRequested.notify_all();
+    m_worker.join();
+}
+
+std::vector<ReloadedShader> ShaderReloader::takeReloadedShaders() {
+    const auto lock = std::lock_guard<std::mutex> { m_mutex };
+    auto reloadedShaders = std::vector<ReloadedShader> {};
+    reloadedShaders.reserve(m_reloadedShaders.size());
+    for (auto& [name, code] : m_reloadedShaders) {
+        reloadedShaders.push_back(ReloadedShader { .name = name, .code = std::move(code) });
+    }
+    m_reloadedShaders.clear();
+
+    return reloadedShaders;
+}
+
+ShaderReloader::WriteTimes ShaderReloader::findWriteTimes() const {
+    // Editors save by replacing files, so one may be missing for a moment, which only
+    // means it is looked at again on the next poll.
+    auto writeTimes = WriteTimes {};
+    auto error = std::error_code {};
+    for (const auto& entry : std::filesystem::directory_iterator { m_shaderDirectory, error }) {
+        const auto language = entry.path().extension();
+        if (!entry.is_regular_file(error) || (language != ".glsl" && language != ".hlsl")) {
+            continue;
+        }
+
+        const auto writeTime = entry.last_write_time(error);
+        if (!error) {
+            writeTimes.insert_or_assign(entry.path().filename().string(), writeTime);
+        }
+    }
+
+    return writeTimes;
+}
+
+std::optional<std::vector<uint32_t>> ShaderReloader::compileShader(const std::string& name) const {
+    const auto sourceFile = m_shaderDirectory / name;
+    const auto spirvFile = m_outputDirectory / fmt::format("{}.spv", name);
+    const auto arguments = getCompileArguments(sourceFile, spirvFile);
+    if (!arguments) {
+        return std::nullopt;
+    }
+
+    const auto& compiler = sourceFile.extension() == ".glsl" ? m_compilers.glslCompiler : m_compilers.hlslCompiler;
+    auto command = fmt::format("\"{}\" {}", compiler, *arguments);
+#if defined(_WIN32)
+    // `cmd.exe` strips the outer quotes of a command that starts with one.
+    command = fmt::format("\"{}\"", command);
+#endif
+
+    // A stale binary is never taken for the new one.
+    auto error = std::error_code {};
+    std::filesystem::remove(spirvFile, error);
+    if (std::system(command.c_str()) != 0) {
+        fmt::println(std::cerr, "failed to recompile shader `{}`, keeping the last version that compiled", name);
+        return std::nullopt;
+    }
+
+    return readSpirvFile(spirvFile);
+}
+
+void ShaderReloader::run() {
+    auto lock = std::unique_lock<std::mutex> { m_mutex };
+    while (!m_stopRequested.wait_for(lock, m_pollInterval, [this]() { return m_isStopping; })) {
+        lock.unlock();
+
+        const auto writeTimes = this->findWriteTimes();
+        auto reloadedShaders = std::vector<ReloadedShader> {};
+        for (const auto& [name, writeTime] : writeTimes) {
+            const auto previousWriteTime = m_writeTimes.find(name);
+            if (previousWriteTime != m_writeTimes.end() && previousWriteTime->second == writeTime) {
+                continue;
+            }
+
+            auto code = this->compileShader(name);
+            if (code) {
+                reloadedShaders.push_back(ReloadedShader { .name = name, .code = std::move(*code) });
+            }
+        }
+        m_writeTimes = writeTimes;
+
+        lock.lock();
+        for (auto& reloadedShader : reloadedShaders) {
+            m_reloadedShaders.insert_or_assign(reloadedShader.name, std::move(reloadedShader.code));
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef _SHADER_RELOADER_H
+#define _SHADER_RELOADER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief The shader compilers a `ShaderReloader` runs, by path or by name on the `PATH`.
+struct ShaderCompilers final {
+    /// @brief `glslc`, which compiles the `.glsl` shaders.
+    std::string glslCompiler;
+    /// @brief `dxc`, which compiles the `.hlsl` shaders.
+    std::string hlslCompiler;
+};
+
+/// @brief A shader whose source changed, and the SPIR-V it compiles to now.
+struct ReloadedShader final {
+    /// @brief The file name of the source, like `shader.frag.hlsl`, which is also the name
+    /// the build embeds the shader under.
+    std::string name;
+    std::vector<uint32_t> code;
+};
+
+/// @brief Watches a shader directory, and recompiles the shaders that change on a worker
+/// thread of its own.
+///
+/// @note The directory is polled for write times, which works the same everywhere. Shader
+/// files are named the way the build expects, `<name>.<vert|frag|comp|task|mesh>.<glsl|hlsl>`,
+/// and compile for the same stages and target environments the build compiles them for,
+/// but unoptimized. A shader that fails to compile prints the compiler's errors and is left
+/// out until it changes again, so the last version that compiled stays in use.
+class ShaderReloader final {
+    public:
+        explicit ShaderReloader() = delete;
+        explicit ShaderReloader(
+            const std::filesystem::path& shaderDirectory,
+            const std::filesystem::path& outputDirectory,
+            const ShaderCompilers& compilers,
+            std::chrono::milliseconds pollInterval
+        );
+
+        /// @brief Stop watching, after the shader being compiled, if any, is done.
+        ~ShaderReloader();
+
+        ShaderReloader(const ShaderReloader& other) = delete;
+        ShaderReloader& operator=(const ShaderReloader& other) = delete;
+
+        /// @brief Take the shaders recompiled since the last call, each in its latest
+        /// version.
+        std::vector<ReloadedShader> takeReloadedShaders();
+    private:
+        using WriteTimes = std::unordered_map<std::string, std::filesystem::file_time_type>;
+
+        std::filesystem::path m_shaderDirectory;
+        std::filesystem::path m_outputDirectory;
+        ShaderCompilers m_compilers;
+        std::chrono::milliseconds m_pollInterval;
+        /// @brief Only the worker reads and writes these once it has started.
+        WriteTimes m_writeTimes;
+        std::mutex m_mutex;
+        std::condition_variable m_stopRequested;
+        std::unordered_map<std::string, std::vector<uint32_t>> m_reloadedShaders;
+        bool m_isStopping;
+        std::thread m_worker;
+
+        WriteTimes findWriteTimes() const;
+
+        std::optional<std::vector<uint32_t>> compileShader(const std::string& name) const;
+
+        void run();
+};
+
+}
+
+#endif // _SHADER_RELOADER_H
@@ -0,0 +1,424 @@
+#include "shading_rate_image.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "command_counters.h"
+
+
+using ShadingRateImage = VulkanEngine::ShadingRateImage;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+ShadingRateImage::ShadingRateImage(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    VkPipelineCache pipelineCache,
+    VkShaderModule shaderModule,
+    std::span<const VkImageView> sourceImageViews,
+    VkExtent2D extent,
+    VkExtent2D texelSize
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_extent { extent }
+    , m_texelSize { texelSize }
+    , m_imageExtent {}
+    , m_descriptorSetLayout { VK_NULL_HANDLE }
+    , m_pipelineLayout { VK_NULL_HANDLE }
+    , m_pipeline { VK_NULL_HANDLE }
+    , m_sampler { VK_NULL_HANDLE }
+    , m_image { VK_NULL_HANDLE }
+    , m_imageAllocation {}
+    , m_imageView { VK_NULL_HANDLE }
+    , m_descriptorPool { VK_NULL_HANDLE }
+    , m_descriptorSets {}
+{
+    if (extent.width == 0 || extent.height == 0 || texelSize.width == 0 || texelSize.height == 0) {
+        throw std::invalid_argument("shading rate image needs an extent and a texel size that are not empty");
+    }
+
+    if (sourceImageViews.empty()) {
+        throw std::invalid_argument("shading rate image needs a source to build from");
+    }
+
+    m_imageExtent = VkExtent2D {
+        .width = (extent.width + texelSize.width - 1) / texelSize.width,
+        .height = (extent.height + texelSize.height - 1) / texelSize.height,
+    };
+
+    this->createDescriptorSetLayout();
+    this->createPipeline(pipelineCache, shaderModule);
+    this->createSampler();
+    this->createImage();
+    this->createDescriptorSets(sourceImageViews);
+}
+
+ShadingRateImage::~ShadingRateImage() {
+    vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+    vkDestroyImageView(m_device, m_imageView, nullptr);
+    vkDestroyImage(m_device, m_image, nullptr);
+    m_allocator.free(m_imageAllocation);
+    vkDestroySampler(m_device, m_sampler, nullptr);
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+
+    m_descriptorPool = VK_NULL_HANDLE;
+    m_descriptorSets.clear();
+    m_imageView = VK_NULL_HANDLE;
+    m_image = VK_NULL_HANDLE;
+    m_sampler = VK_NULL_HANDLE;
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipelineLayout = VK_NULL_HANDLE;
+    m_descriptorSetLayout = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void ShadingRateImage::recordInitialization(VkCommandBuffer commandBuffer) const {
+    const auto subresourceRange = VkImageSubresourceRange {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = 0,
+        .levelCount = 1,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+    const auto clearBarrier = VkImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_image,
+        .subresourceRange = subresourceRange,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &clearBarrier
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    // A rate of 0 is 1x1, which shades every pixel.
+    const auto clearColor = VkClearColorValue { .uint32 = { 0, 0, 0, 0 } };
+    vkCmdClearColorImage(commandBuffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &subresourceRange);
+
+    const auto readBarrier = VkImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_FRAGMENT_SHADING_RATE_ATTACHMENT_READ_BIT_KHR,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_image,
+        .subresourceRange = subresourceRange,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &readBarrier
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+}
+
+void ShadingRateImage::record(VkCommandBuffer commandBuffer, uint32_t sourceIndex, VkExtent2D renderExtent) const {
+    if (sourceIndex >= m_descriptorSets.size()) {
+        throw std::out_of_range("shading rate image source index out of range");
+    }
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    CommandCounters::add(CommandCounter::PipelineBinds);
+    vkCmdBindDescriptorSets(
+        commandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        m_pipelineLayout,
+        0,
+        1,
+        &m_descriptorSets[sourceIndex],
+        0,
+        nullptr
+    );
+    CommandCounters::add(CommandCounter::DescriptorBinds);
+
+    const auto pushConstants = PushConstants {
+        .renderWidth = std::clamp(renderExtent.width, 1u, m_extent.width),
+        .renderHeight = std::clamp(renderExtent.height, 1u, m_extent.height),
+        .texelWidth = m_texelSize.width,
+        .texelHeight = m_texelSize.height,
+        .imageWidth = m_imageExtent.width,
+        .imageHeight = m_imageExtent.height,
+    };
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+
+    const auto workGroupCountX = (m_imageExtent.width + THREAD_COUNT - 1) / THREAD_COUNT;
+    const auto workGroupCountY = (m_imageExtent.height + THREAD_COUNT - 1) / THREAD_COUNT;
+    vkCmdDispatch(commandBuffer, workGroupCountX, workGroupCountY, 1);
+    CommandCounters::add(CommandCounter::Dispatches);
+}
+
+VkImage ShadingRateImage::getImage() const {
+    return m_image;
+}
+
+VkImageView ShadingRateImage::getImageView() const {
+    return m_imageView;
+}
+
+VkExtent2D ShadingRateImage::getTexelSize() const {
+    return m_texelSize;
+}
+
+void ShadingRateImage::createDescriptorSetLayout() {
+    const auto createBinding = [](uint32_t binding, VkDescriptorType descriptorType) -> VkDescriptorSetLayoutBinding {
+        return VkDescriptorSetLayoutBinding {
+            .binding = binding,
+            .descriptorType = descriptorType,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        };
+    };
+    const auto bindings = std::array<VkDescriptorSetLayoutBinding, 3> {
+        createBinding(0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE),
+        createBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
+        createBinding(2, VK_DESCRIPTOR_TYPE_SAMPLER),
+    };
+    const auto layoutInfo = VkDescriptorSetLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+
+    auto descriptorSetLayout = VkDescriptorSetLayout {};
+    const auto result = vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &descriptorSetLayout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shading rate descriptor set layout!");
+    }
+
+    m_descriptorSetLayout = descriptorSetLayout;
+}
+
+void ShadingRateImage::createPipeline(VkPipelineCache pipelineCache, VkShaderModule shaderModule) {
+    const auto pushConstantRange = VkPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_descriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+
+    auto pipelineLayout = VkPipelineLayout {};
+    const auto resultCreatePipelineLayout = vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    if (resultCreatePipelineLayout != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shading rate pipeline layout!");
+    }
+
+    const auto pipelineInfo = VkComputePipelineCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shaderModule,
+            .pName = "main",
+        },
+        .layout = pipelineLayout,
+    };
+
+    auto pipeline = VkPipeline {};
+    const auto resultCreatePipeline = vkCreateComputePipelines(m_device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    if (resultCreatePipeline != VK_SUCCESS) {
+        vkDestroyPipelineLayout(m_device, pipelineLayout, nullptr);
+
+        throw std::runtime_error("failed to create shading rate pipeline!");
+    }
+
+    m_pipelineLayout = pipelineLayout;
+    m_pipeline = pipeline;
+}
+
+void ShadingRateImage::createSampler() {
+    // The points of a texel are sampled between source texels, and never past its edges.
+    const auto samplerInfo = VkSamplerCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .mipLodBias = 0.0f,
+        .anisotropyEnable = VK_FALSE,
+        .maxAnisotropy = 1.0f,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .minLod = 0.0f,
+        .maxLod = 0.0f,
+        .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+
+    auto sampler = VkSampler {};
+    const auto result = vkCreateSampler(m_device, &samplerInfo, nullptr, &sampler);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shading rate sampler!");
+    }
+
+    m_sampler = sampler;
+}
+
+void ShadingRateImage::createImage() {
+    const auto imageInfo = VkImageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = FORMAT,
+        .extent = VkExtent3D { m_imageExtent.width, m_imageExtent.height, 1 },
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    auto image = VkImage {};
+    const auto resultCreateImage = vkCreateImage(m_device, &imageInfo, nullptr, &image);
+    if (resultCreateImage != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shading rate image!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetImageMemoryRequirements(m_device, image, &memRequirements);
+
+    const auto allocation = m_allocator.allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Optimal, GpuMemoryCategory::Attachment);
+
+    vkBindImageMemory(m_device, image, allocation.memory, allocation.offset);
+
+    const auto viewInfo = VkImageViewCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = FORMAT,
+        .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .subresourceRange.baseMipLevel = 0,
+        .subresourceRange.levelCount = 1,
+        .subresourceRange.baseArrayLayer = 0,
+        .subresourceRange.layerCount = 1,
+    };
+
+    auto imageView = VkImageView {};
+    const auto resultCreateImageView = vkCreateImageView(m_device, &viewInfo, nullptr, &imageView);
+    if (resultCreateImageView != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shading rate image view!");
+    }
+
+    m_image = image;
+    m_imageAllocation = allocation;
+    m_imageView = imageView;
+}
+
+void ShadingRateImage::createDescriptorSets(std::span<const VkImageView> sourceImageViews) {
+    const auto setCount = static_cast<uint32_t>(sourceImageViews.size());
+    const auto poolSizes = std::array<VkDescriptorPoolSize, 3> {
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = setCount,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = setCount,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLER,
+            .descriptorCount = setCount,
+        },
+    };
+    const auto poolInfo = VkDescriptorPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = 0,
+        .maxSets = setCount,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+    };
+
+    auto descriptorPool = VkDescriptorPool {};
+    const auto resultCreateDescriptorPool = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &descriptorPool);
+    if (resultCreateDescriptorPool != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shading rate descriptor pool!");
+    }
+
+    m_descriptorPool = descriptorPool;
+
+    const auto setLayouts = std::vector<VkDescriptorSetLayout>(setCount, m_descriptorSetLayout);
+    const auto allocInfo = VkDescriptorSetAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_descriptorPool,
+        .descriptorSetCount = setCount,
+        .pSetLayouts = setLayouts.data(),
+    };
+
+    auto descriptorSets = std::vector<VkDescriptorSet>(setCount, VK_NULL_HANDLE);
+    const auto resultAllocateDescriptorSets = vkAllocateDescriptorSets(m_device, &allocInfo, descriptorSets.data());
+    if (resultAllocateDescriptorSets != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate shading rate descriptor sets!");
+    }
+
+    const auto outputInfo = VkDescriptorImageInfo {
+        .sampler = VK_NULL_HANDLE,
+        .imageView = m_imageView,
+        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+    };
+    const auto samplerInfo = VkDescriptorImageInfo {
+        .sampler = m_sampler,
+        .imageView = VK_NULL_HANDLE,
+        .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    auto sourceInfos = std::vector<VkDescriptorImageInfo> {};
+    sourceInfos.reserve(setCount);
+    for (const auto sourceImageView : sourceImageViews) {
+        sourceInfos.push_back(VkDescriptorImageInfo {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = sourceImageView,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        });
+    }
+
+    auto descriptorWrites = std::vector<VkWriteDescriptorSet> {};
+    descriptorWrites.reserve(3 * setCount);
+    for (uint32_t i = 0; i < setCount; i++) {
+        const auto createWrite = [&descriptorSets, i](uint32_t binding, VkDescriptorType descriptorType, const VkDescriptorImageInfo* imageInfo) -> VkWriteDescriptorSet {
+            return VkWriteDescriptorSet {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptorSets[i],
+                .dstBinding = binding,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = descriptorType,
+                .pImageInfo = imageInfo,
+            };
+        };
+        descriptorWrites.push_back(createWrite(0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, &sourceInfos[i]));
+        descriptorWrites.push_back(createWrite(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, &outputInfo));
+        descriptorWrites.push_back(createWrite(2, VK_DESCRIPTOR_TYPE_SAMPLER, &samplerInfo));
+    }
+    vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+    m_descriptorSets = std::move(descriptorSets);
+}
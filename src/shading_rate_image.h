@@ -0,0 +1,113 @@
+#ifndef _SHADING_RATE_IMAGE_H
+#define _SHADING_RATE_IMAGE_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief Builds a fragment shading rate attachment from the luminance of an earlier frame
+/// with a compute shader, so that flat regions of the screen are shaded at a coarser rate.
+///
+/// @note Every texel of the attachment covers `texelSize` pixels of the framebuffer, and
+/// samples a grid of `SAMPLE_COUNT` by `SAMPLE_COUNT` points of the source over them. Along
+/// each axis whose luminance changes by less than `CONTRAST_THRESHOLD` from one point to the
+/// next, the texel halves the shading rate, so its rate is 1x1, 2x1, 1x2 or 2x2, which
+/// every device with attachment shading rates supports. The source is output sized, and
+/// shows the frame before, whose render extent maps onto the whole of it.
+///
+/// The attachment is a `FORMAT` image, written in `VK_IMAGE_LAYOUT_GENERAL` and read in
+/// `VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR`, and the sources have to be
+/// sampled in `VK_IMAGE_LAYOUT_GENERAL`.
+class ShadingRateImage final {
+    public:
+        /// @brief The width and height of the workgroups of the shading rate shader.
+        static constexpr uint32_t THREAD_COUNT = 8;
+        static constexpr VkFormat FORMAT = VK_FORMAT_R8_UINT;
+        /// @brief The points sampled along each axis of a texel, as `SAMPLE_COUNT` in the
+        /// shading rate shader.
+        static constexpr uint32_t SAMPLE_COUNT = 4;
+        /// @brief The change in luminance between neighboring points below which the rate
+        /// is halved, as `CONTRAST_THRESHOLD` in the shading rate shader.
+        static constexpr float CONTRAST_THRESHOLD = 1.0f / 32.0f;
+
+        explicit ShadingRateImage() = delete;
+        /// @note `shaderModule` stays the caller's, and only has to live until the
+        /// constructor returns.
+        explicit ShadingRateImage(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            VkPipelineCache pipelineCache,
+            VkShaderModule shaderModule,
+            std::span<const VkImageView> sourceImageViews,
+            VkExtent2D extent,
+            VkExtent2D texelSize
+        );
+
+        ~ShadingRateImage();
+
+        ShadingRateImage(const ShadingRateImage& other) = delete;
+        ShadingRateImage& operator=(const ShadingRateImage& other) = delete;
+
+        /// @brief Record filling the attachment with the 1x1 rate, and moving it into the
+        /// layout it is read in.
+        void recordInitialization(VkCommandBuffer commandBuffer) const;
+
+        /// @brief Record building the attachment of a frame rendered at `renderExtent` from
+        /// source `sourceIndex`.
+        ///
+        /// @note The barriers are left to the caller.
+        void record(VkCommandBuffer commandBuffer, uint32_t sourceIndex, VkExtent2D renderExtent) const;
+
+        VkImage getImage() const;
+
+        VkImageView getImageView() const;
+
+        /// @brief The framebuffer pixels every texel of the attachment covers.
+        VkExtent2D getTexelSize() const;
+    private:
+        struct PushConstants final {
+            uint32_t renderWidth;
+            uint32_t renderHeight;
+            uint32_t texelWidth;
+            uint32_t texelHeight;
+            uint32_t imageWidth;
+            uint32_t imageHeight;
+        };
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkExtent2D m_extent;
+        VkExtent2D m_texelSize;
+        VkExtent2D m_imageExtent;
+        VkDescriptorSetLayout m_descriptorSetLayout;
+        VkPipelineLayout m_pipelineLayout;
+        VkPipeline m_pipeline;
+        VkSampler m_sampler;
+        VkImage m_image;
+        GpuAllocation m_imageAllocation;
+        VkImageView m_imageView;
+        VkDescriptorPool m_descriptorPool;
+        /// @brief One set for each source.
+        std::vector<VkDescriptorSet> m_descriptorSets;
+
+        void createDescriptorSetLayout();
+
+        void createPipeline(VkPipelineCache pipelineCache, VkShaderModule shaderModule);
+
+        void createSampler();
+
+        void createImage();
+
+        void createDescriptorSets(std::span<const VkImageView> sourceImageViews);
+};
+
+}
+
+#endif // _SHADING_RATE_IMAGE_H
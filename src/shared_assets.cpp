@@ -0,0 +1,1174 @@
+#include "shared_assets.h"
+#include "barrier_batch.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+
+using SharedAssetPublisher = VulkanEngine::SharedAssetPublisher;
+using SharedAssetImporter = VulkanEngine::SharedAssetImporter;
+using SharedAssetDescription = VulkanEngine::SharedAssetDescription;
+using SharedAssetKind = VulkanEngine::SharedAssetKind;
+using BarrierBatch = VulkanEngine::BarrierBatch;
+
+static constexpr auto MEMORY_HANDLE_TYPE = SharedAssetPublisher::MEMORY_HANDLE_TYPE;
+static constexpr auto SEMAPHORE_HANDLE_TYPE = SharedAssetPublisher::SEMAPHORE_HANDLE_TYPE;
+static constexpr uint32_t MAX_ASSET_COUNT = SharedAssetPublisher::MAX_ASSET_COUNT;
+
+static constexpr auto INVALID_SOCKET_HANDLE = -1;
+
+// "SHAS", and the version of the manifest below, which every importer has to speak.
+static constexpr uint32_t MANIFEST_MAGIC = 0x53414853;
+static constexpr uint32_t MANIFEST_VERSION = 1;
+
+// How long an importer waits before it tries to connect again to an owner that has not
+// created its socket yet, in milliseconds.
+static constexpr int CONNECT_RETRY_MILLISECONDS = 100;
+
+// The manifest goes over the socket as it is laid out in memory, so only the same build of
+// the renderer reads it, which the magic and the version stand in for.
+struct WireAsset final {
+    std::array<char, SharedAssetPublisher::MAX_NAME_LENGTH + 1> name;
+    uint32_t kind;
+    uint32_t usage;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipLevels;
+    uint32_t memoryTypeIndex;
+    uint64_t size;
+    uint64_t memorySize;
+};
+
+struct WireManifest final {
+    uint32_t magic;
+    uint32_t version;
+    std::array<uint8_t, VK_UUID_SIZE> deviceUuid;
+    std::array<uint8_t, VK_UUID_SIZE> driverUuid;
+    uint32_t assetCount;
+    std::array<WireAsset, MAX_ASSET_COUNT> assets;
+};
+
+#if defined(_WIN32)
+// Windows hands memory to another process as a handle it duplicates into that process, not
+// as a file descriptor sent over a socket, so only the owner's side of it could be shared.
+static constexpr auto UNSUPPORTED_PLATFORM_MESSAGE = "failed to share assets: Windows cannot pass file descriptors between processes!";
+
+static void closeDescriptor(int) {}
+
+static void removeSocketFile(const std::string&) {}
+
+static int listenOnSocket(const std::string&) {
+    throw std::runtime_error(UNSUPPORTED_PLATFORM_MESSAGE);
+}
+
+static int acceptConnection(int, int) {
+    return INVALID_SOCKET_HANDLE;
+}
+
+static int connectToSocket(const std::string&, std::chrono::steady_clock::time_point) {
+    throw std::runtime_error(UNSUPPORTED_PLATFORM_MESSAGE);
+}
+
+static bool sendManifest(int, const WireManifest&, std::span<const int>) {
+    return false;
+}
+
+static std::vector<int> receiveManifest(int, WireManifest&, std::chrono::steady_clock::time_point) {
+    throw std::runtime_error(UNSUPPORTED_PLATFORM_MESSAGE);
+}
+#else
+// An importer that goes away mid-send would otherwise raise `SIGPIPE` and end the owner.
+#if defined(MSG_NOSIGNAL)
+static constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static constexpr int SEND_FLAGS = 0;
+#endif
+
+// Descriptors an importer receives are not leaked into the processes it starts.
+#if defined(MSG_CMSG_CLOEXEC)
+static constexpr int RECEIVE_FLAGS = MSG_CMSG_CLOEXEC;
+#else
+static constexpr int RECEIVE_FLAGS = 0;
+#endif
+
+static void closeDescriptor(int fd) {
+    close(fd);
+}
+
+static void removeSocketFile(const std::string& socketPath) {
+    unlink(socketPath.c_str());
+}
+
+static sockaddr_un getSocketAddress(const std::string& socketPath) {
+    auto address = sockaddr_un {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument(fmt::format("shared asset socket path \"{}\" is empty or too long!", socketPath));
+    }
+
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    return address;
+}
+
+static int listenOnSocket(const std::string& socketPath) {
+    const auto address = getSocketAddress(socketPath);
+    const auto socketHandle = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socketHandle == INVALID_SOCKET_HANDLE) {
+        throw std::runtime_error("failed to create shared asset socket!");
+    }
+
+    // A socket left behind by an owner that went away would keep the path from being bound.
+    removeSocketFile(socketPath);
+    const auto* socketAddress = reinterpret_cast<const sockaddr*>(&address);
+    if (bind(socketHandle, socketAddress, sizeof(address)) != 0 || listen(socketHandle, SOMAXCONN) != 0) {
+        close(socketHandle);
+        throw std::runtime_error(fmt::format("failed to listen for asset importers on {}!", socketPath));
+    }
+
+    return socketHandle;
+}
+
+static int acceptConnection(int socketHandle, int timeoutMilliseconds) {
+    auto descriptor = pollfd { .fd = socketHandle, .events = POLLIN, .revents = 0 };
+    if (poll(&descriptor, 1, timeoutMilliseconds) <= 0) {
+        return INVALID_SOCKET_HANDLE;
+    }
+
+    return accept(socketHandle, nullptr, nullptr);
+}
+
+static int connectToSocket(const std::string& socketPath, std::chrono::steady_clock::time_point deadline) {
+    const auto address = getSocketAddress(socketPath);
+    const auto* socketAddress = reinterpret_cast<const sockaddr*>(&address);
+    while (true) {
+        const auto socketHandle = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (socketHandle == INVALID_SOCKET_HANDLE) {
+            throw std::runtime_error("failed to create shared asset socket!");
+        }
+
+        if (connect(socketHandle, socketAddress, sizeof(address)) == 0) {
+            return socketHandle;
+        }
+        close(socketHandle);
+
+        // The owner may still be starting up, and not listen yet.
+        if (std::chrono::steady_clock::now() >= deadline) {
+            throw std::runtime_error(fmt::format("failed to connect to the asset owner on {}!", socketPath));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds { CONNECT_RETRY_MILLISECONDS });
+    }
+}
+
+static bool sendManifest(int socketHandle, const WireManifest& manifest, std::span<const int> fds) {
+    auto control = std::vector<char>(CMSG_SPACE(sizeof(int) * fds.size()));
+    auto bytes = iovec {
+        .iov_base = const_cast<WireManifest*>(&manifest),
+        .iov_len = sizeof(WireManifest),
+    };
+    // The fields of `msghdr` differ in padding between platforms, so they are not designated.
+    auto message = msghdr {};
+    message.msg_iov = &bytes;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+    auto* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    std::memcpy(CMSG_DATA(header), fds.data(), sizeof(int) * fds.size());
+
+    const auto sentSize = sendmsg(socketHandle, &message, SEND_FLAGS);
+    if (sentSize <= 0) {
+        return false;
+    }
+
+    // The descriptors go with the first bytes, and whatever did not fit follows on its own.
+    const auto* manifestBytes = reinterpret_cast<const char*>(&manifest);
+    auto offset = static_cast<size_t>(sentSize);
+    while (offset < sizeof(WireManifest)) {
+        const auto size = send(socketHandle, manifestBytes + offset, sizeof(WireManifest) - offset, SEND_FLAGS);
+        if (size <= 0) {
+            return false;
+        }
+
+        offset += static_cast<size_t>(size);
+    }
+
+    return true;
+}
+
+static std::vector<int> receiveManifest(int socketHandle, WireManifest& manifest, std::chrono::steady_clock::time_point deadline) {
+    auto fds = std::vector<int> {};
+    const auto fail = [&fds](const char* message) {
+        for (const auto fd : fds) {
+            close(fd);
+        }
+
+        throw std::runtime_error(message);
+    };
+
+    auto* manifestBytes = reinterpret_cast<char*>(&manifest);
+    auto offset = size_t { 0 };
+    while (offset < sizeof(WireManifest)) {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        auto descriptor = pollfd { .fd = socketHandle, .events = POLLIN, .revents = 0 };
+        if (remaining.count() <= 0 || poll(&descriptor, 1, static_cast<int>(remaining.count())) <= 0) {
+            fail("failed to receive the shared asset manifest in time!");
+        }
+
+        auto control = std::vector<char>(CMSG_SPACE(sizeof(int) * (MAX_ASSET_COUNT + 1)));
+        auto bytes = iovec {
+            .iov_base = manifestBytes + offset,
+            .iov_len = sizeof(WireManifest) - offset,
+        };
+        auto message = msghdr {};
+        message.msg_iov = &bytes;
+        message.msg_iovlen = 1;
+        message.msg_control = control.data();
+        message.msg_controllen = control.size();
+        const auto receivedSize = recvmsg(socketHandle, &message, RECEIVE_FLAGS);
+        if (receivedSize <= 0) {
+            fail("failed to receive the shared asset manifest: the owner closed the connection!");
+        }
+
+        for (auto* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+
+            const auto fdCount = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i < fdCount; i++) {
+                auto fd = INVALID_SOCKET_HANDLE;
+                std::memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+                fds.push_back(fd);
+            }
+        }
+        if ((message.msg_flags & MSG_CTRUNC) != 0) {
+            fail("failed to receive the shared asset manifest: the owner sent more file descriptors than there are assets!");
+        }
+
+        offset += static_cast<size_t>(receivedSize);
+    }
+
+    return fds;
+}
+#endif
+
+static VkPhysicalDeviceIDProperties getIdProperties(VkPhysicalDevice physicalDevice) {
+    auto idProperties = VkPhysicalDeviceIDProperties {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+        .pNext = nullptr,
+    };
+    auto properties = VkPhysicalDeviceProperties2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &idProperties,
+    };
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    return idProperties;
+}
+
+static uint32_t findDeviceLocalMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter) {
+    auto memoryProperties = VkPhysicalDeviceMemoryProperties {};
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        const auto isAllowed = (typeFilter & (1u << i)) != 0;
+        const auto isDeviceLocal = (memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0;
+        if (isAllowed && isDeviceLocal) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find a device local memory type for shared assets!");
+}
+
+static bool isBufferShareable(VkPhysicalDevice physicalDevice, VkBufferUsageFlags usage, VkExternalMemoryFeatureFlags feature) {
+    const auto externalBufferInfo = VkPhysicalDeviceExternalBufferInfo {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_BUFFER_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .usage = usage,
+        .handleType = MEMORY_HANDLE_TYPE,
+    };
+    auto externalBufferProperties = VkExternalBufferProperties {
+        .sType = VK_STRUCTURE_TYPE_EXTERNAL_BUFFER_PROPERTIES,
+        .pNext = nullptr,
+    };
+    vkGetPhysicalDeviceExternalBufferProperties(physicalDevice, &externalBufferInfo, &externalBufferProperties);
+
+    return (externalBufferProperties.externalMemoryProperties.externalMemoryFeatures & feature) != 0;
+}
+
+static bool isImageShareable(VkPhysicalDevice physicalDevice, VkFormat format, VkImageUsageFlags usage, VkExternalMemoryFeatureFlags feature) {
+    const auto externalImageFormatInfo = VkPhysicalDeviceExternalImageFormatInfo {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_IMAGE_FORMAT_INFO,
+        .pNext = nullptr,
+        .handleType = MEMORY_HANDLE_TYPE,
+    };
+    const auto imageFormatInfo = VkPhysicalDeviceImageFormatInfo2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+        .pNext = &externalImageFormatInfo,
+        .format = format,
+        .type = VK_IMAGE_TYPE_2D,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = usage,
+        .flags = 0,
+    };
+    auto externalImageFormatProperties = VkExternalImageFormatProperties {
+        .sType = VK_STRUCTURE_TYPE_EXTERNAL_IMAGE_FORMAT_PROPERTIES,
+        .pNext = nullptr,
+    };
+    auto imageFormatProperties = VkImageFormatProperties2 {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2,
+        .pNext = &externalImageFormatProperties,
+    };
+    const auto result = vkGetPhysicalDeviceImageFormatProperties2(physicalDevice, &imageFormatInfo, &imageFormatProperties);
+    if (result != VK_SUCCESS) {
+        return false;
+    }
+
+    return (externalImageFormatProperties.externalMemoryProperties.externalMemoryFeatures & feature) != 0;
+}
+
+// The owner and its importers create every resource from its description the same way, so
+// that the memory requirements of both match.
+static VkBuffer createExternalBuffer(VkDevice device, const VkAllocationCallbacks* allocationCallbacks, const SharedAssetDescription& description) {
+    const auto externalMemoryBufferInfo = VkExternalMemoryBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO,
+        .pNext = nullptr,
+        .handleTypes = MEMORY_HANDLE_TYPE,
+    };
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext = &externalMemoryBufferInfo,
+        .flags = 0,
+        .size = description.size,
+        .usage = description.usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto result = vkCreateBuffer(device, &bufferInfo, allocationCallbacks, &buffer);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error(fmt::format("failed to create shared buffer {}!", description.name));
+    }
+
+    return buffer;
+}
+
+static VkImage createExternalImage(VkDevice device, const VkAllocationCallbacks* allocationCallbacks, const SharedAssetDescription& description) {
+    const auto externalMemoryImageInfo = VkExternalMemoryImageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .handleTypes = MEMORY_HANDLE_TYPE,
+    };
+    const auto imageInfo = VkImageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = &externalMemoryImageInfo,
+        .flags = 0,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = description.format,
+        .extent = VkExtent3D { description.extent.width, description.extent.height, 1 },
+        .mipLevels = description.mipLevels,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = description.usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    auto image = VkImage {};
+    const auto result = vkCreateImage(device, &imageInfo, allocationCallbacks, &image);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error(fmt::format("failed to create shared image {}!", description.name));
+    }
+
+    return image;
+}
+
+static VkImageSubresourceRange getColorSubresourceRange(uint32_t mipLevels) {
+    return VkImageSubresourceRange {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = 0,
+        .levelCount = mipLevels,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+}
+
+// Hand every resource from `srcQueueFamilyIndex` to `dstQueueFamilyIndex`, with the images in
+// the shader read-only layout on both sides. Importers read the assets any way they like,
+// so the release waits for every write, and the acquire makes them visible to every read.
+static void addOwnershipTransfers(
+    BarrierBatch& barriers,
+    std::span<const VkBuffer> buffers,
+    std::span<const VkImage> images,
+    std::span<const SharedAssetDescription> descriptions,
+    uint32_t srcQueueFamilyIndex,
+    uint32_t dstQueueFamilyIndex
+) {
+    const auto isRelease = dstQueueFamilyIndex == VK_QUEUE_FAMILY_EXTERNAL;
+    const auto srcStageMask = isRelease ? VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT : VK_PIPELINE_STAGE_2_NONE;
+    const auto srcAccessMask = isRelease ? VK_ACCESS_2_MEMORY_WRITE_BIT : 0;
+    const auto dstStageMask = isRelease ? VK_PIPELINE_STAGE_2_NONE : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    const auto dstAccessMask = isRelease ? 0 : VK_ACCESS_2_MEMORY_READ_BIT;
+    for (size_t i = 0; i < descriptions.size(); i++) {
+        if (buffers[i] != VK_NULL_HANDLE) {
+            barriers.addBufferBarrier(VkBufferMemoryBarrier2 {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                .srcStageMask = srcStageMask,
+                .srcAccessMask = srcAccessMask,
+                .dstStageMask = dstStageMask,
+                .dstAccessMask = dstAccessMask,
+                .srcQueueFamilyIndex = srcQueueFamilyIndex,
+                .dstQueueFamilyIndex = dstQueueFamilyIndex,
+                .buffer = buffers[i],
+                .offset = 0,
+                .size = VK_WHOLE_SIZE,
+            });
+        } else if (images[i] != VK_NULL_HANDLE) {
+            barriers.addImageBarrier(VkImageMemoryBarrier2 {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .srcStageMask = srcStageMask,
+                .srcAccessMask = srcAccessMask,
+                .dstStageMask = dstStageMask,
+                .dstAccessMask = dstAccessMask,
+                .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                .srcQueueFamilyIndex = srcQueueFamilyIndex,
+                .dstQueueFamilyIndex = dstQueueFamilyIndex,
+                .image = images[i],
+                .subresourceRange = getColorSubresourceRange(descriptions[i].mipLevels),
+            });
+        }
+    }
+}
+
+SharedAssetPublisher::SharedAssetPublisher(
+    VkPhysicalDevice physicalDevice,
+    VkDevice device,
+    const VkAllocationCallbacks* allocationCallbacks,
+    uint32_t queueFamilyIndex,
+    bool useSynchronization2,
+    const std::string& socketPath
+)
+    : m_physicalDevice { physicalDevice }
+    , m_device { device }
+    , m_allocationCallbacks { allocationCallbacks }
+    , m_queueFamilyIndex { queueFamilyIndex }
+    , m_useSynchronization2 { useSynchronization2 }
+    , m_socketPath { socketPath }
+    , m_descriptions { std::vector<SharedAssetDescription> {} }
+    , m_buffers { std::vector<VkBuffer> {} }
+    , m_images { std::vector<VkImage> {} }
+    , m_memories { std::vector<VkDeviceMemory> {} }
+    , m_timelineSemaphore { VK_NULL_HANDLE }
+    , m_vkGetMemoryFdKHR { nullptr }
+    , m_vkGetSemaphoreFdKHR { nullptr }
+    , m_socket { INVALID_SOCKET_HANDLE }
+    , m_mutex {}
+    , m_isStopping { false }
+    , m_thread {}
+{
+    if (!SharedAssetPublisher::isSupported(physicalDevice)) {
+        throw std::runtime_error("failed to share assets: the device cannot export timeline semaphores as file descriptors!");
+    }
+
+    // The loader does not export extension commands, so they come from the device.
+    m_vkGetMemoryFdKHR = reinterpret_cast<PFN_vkGetMemoryFdKHR>(
+        vkGetDeviceProcAddr(m_device, "vkGetMemoryFdKHR")
+    );
+    m_vkGetSemaphoreFdKHR = reinterpret_cast<PFN_vkGetSemaphoreFdKHR>(
+        vkGetDeviceProcAddr(m_device, "vkGetSemaphoreFdKHR")
+    );
+    if (m_vkGetMemoryFdKHR == nullptr || m_vkGetSemaphoreFdKHR == nullptr) {
+        throw std::runtime_error("failed to load external memory commands!");
+    }
+
+    const auto exportSemaphoreInfo = VkExportSemaphoreCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_CREATE_INFO,
+        .pNext = nullptr,
+        .handleTypes = SEMAPHORE_HANDLE_TYPE,
+    };
+    const auto timelineCreateInfo = VkSemaphoreTypeCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = &exportSemaphoreInfo,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    const auto semaphoreInfo = VkSemaphoreCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timelineCreateInfo,
+        .flags = 0,
+    };
+    const auto result = vkCreateSemaphore(m_device, &semaphoreInfo, m_allocationCallbacks, &m_timelineSemaphore);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shared asset timeline semaphore!");
+    }
+
+    // Importers that connect before the assets are served wait in the backlog.
+    try {
+        m_socket = listenOnSocket(m_socketPath);
+    } catch (...) {
+        vkDestroySemaphore(m_device, m_timelineSemaphore, m_allocationCallbacks);
+        throw;
+    }
+}
+
+SharedAssetPublisher::~SharedAssetPublisher() {
+    if (m_thread.joinable()) {
+        {
+            const auto lock = std::lock_guard<std::mutex> { m_mutex };
+            m_isStopping = true;
+        }
+        m_thread.join();
+    }
+
+    closeDescriptor(m_socket);
+    removeSocketFile(m_socketPath);
+    m_socket = INVALID_SOCKET_HANDLE;
+
+    vkDestroySemaphore(m_device, m_timelineSemaphore, m_allocationCallbacks);
+    for (size_t i = 0; i < m_descriptions.size(); i++) {
+        if (m_images[i] != VK_NULL_HANDLE) {
+            vkDestroyImage(m_device, m_images[i], m_allocationCallbacks);
+        }
+        vkFreeMemory(m_device, m_memories[i], m_allocationCallbacks);
+    }
+
+    m_descriptions.clear();
+    m_buffers.clear();
+    m_images.clear();
+    m_memories.clear();
+    m_timelineSemaphore = VK_NULL_HANDLE;
+    m_vkGetMemoryFdKHR = nullptr;
+    m_vkGetSemaphoreFdKHR = nullptr;
+    m_allocationCallbacks = nullptr;
+    m_device = VK_NULL_HANDLE;
+}
+
+bool SharedAssetPublisher::isSupported(VkPhysicalDevice physicalDevice) {
+    const auto semaphoreTypeInfo = VkSemaphoreTypeCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = nullptr,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    const auto externalSemaphoreInfo = VkPhysicalDeviceExternalSemaphoreInfo {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_SEMAPHORE_INFO,
+        .pNext = &semaphoreTypeInfo,
+        .handleType = SEMAPHORE_HANDLE_TYPE,
+    };
+    auto externalSemaphoreProperties = VkExternalSemaphoreProperties {
+        .sType = VK_STRUCTURE_TYPE_EXTERNAL_SEMAPHORE_PROPERTIES,
+        .pNext = nullptr,
+    };
+    vkGetPhysicalDeviceExternalSemaphoreProperties(physicalDevice, &externalSemaphoreInfo, &externalSemaphoreProperties);
+
+    const auto requiredFeatures = VK_EXTERNAL_SEMAPHORE_FEATURE_EXPORTABLE_BIT | VK_EXTERNAL_SEMAPHORE_FEATURE_IMPORTABLE_BIT;
+
+    return (externalSemaphoreProperties.externalSemaphoreFeatures & requiredFeatures) == requiredFeatures;
+}
+
+VkBuffer SharedAssetPublisher::createBuffer(const std::string& name, VkDeviceSize size, VkBufferUsageFlags usage) {
+    this->checkNewAsset(name);
+    if (!isBufferShareable(m_physicalDevice, usage, VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT)) {
+        throw std::runtime_error(fmt::format("failed to share buffer {}: the device cannot export it as a file descriptor!", name));
+    }
+
+    auto description = SharedAssetDescription {
+        .name = name,
+        .kind = SharedAssetKind::Buffer,
+        .size = size,
+        .usage = usage,
+    };
+    const auto buffer = createExternalBuffer(m_device, m_allocationCallbacks, description);
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+    description.memorySize = memRequirements.size;
+    description.memoryTypeIndex = findDeviceLocalMemoryType(m_physicalDevice, memRequirements.memoryTypeBits);
+
+    const auto exportAllocateInfo = VkExportMemoryAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .handleTypes = MEMORY_HANDLE_TYPE,
+    };
+    const auto dedicatedAllocateInfo = VkMemoryDedicatedAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+        .pNext = &exportAllocateInfo,
+        .image = VK_NULL_HANDLE,
+        .buffer = buffer,
+    };
+    const auto allocateInfo = VkMemoryAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = &dedicatedAllocateInfo,
+        .allocationSize = description.memorySize,
+        .memoryTypeIndex = description.memoryTypeIndex,
+    };
+
+    auto memory = VkDeviceMemory {};
+    const auto result = vkAllocateMemory(m_device, &allocateInfo, m_allocationCallbacks, &memory);
+    if (result != VK_SUCCESS) {
+        vkDestroyBuffer(m_device, buffer, m_allocationCallbacks);
+        throw std::runtime_error(fmt::format("failed to allocate shared buffer memory for {}!", name));
+    }
+
+    vkBindBufferMemory(m_device, buffer, memory, 0);
+
+    m_descriptions.push_back(description);
+    m_buffers.push_back(buffer);
+    m_images.push_back(VK_NULL_HANDLE);
+    m_memories.push_back(memory);
+
+    return buffer;
+}
+
+VkImage SharedAssetPublisher::createImage(const std::string& name, VkFormat format, VkExtent2D extent, uint32_t mipLevels, VkImageUsageFlags usage) {
+    this->checkNewAsset(name);
+    if (!isImageShareable(m_physicalDevice, format, usage, VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT)) {
+        throw std::runtime_error(fmt::format("failed to share image {}: the device cannot export it as a file descriptor!", name));
+    }
+
+    auto description = SharedAssetDescription {
+        .name = name,
+        .kind = SharedAssetKind::Image,
+        .size = 0,
+        .usage = usage,
+        .format = format,
+        .extent = extent,
+        .mipLevels = mipLevels,
+    };
+    const auto image = createExternalImage(m_device, m_allocationCallbacks, description);
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetImageMemoryRequirements(m_device, image, &memRequirements);
+    description.memorySize = memRequirements.size;
+    description.memoryTypeIndex = findDeviceLocalMemoryType(m_physicalDevice, memRequirements.memoryTypeBits);
+
+    const auto exportAllocateInfo = VkExportMemoryAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .handleTypes = MEMORY_HANDLE_TYPE,
+    };
+    const auto dedicatedAllocateInfo = VkMemoryDedicatedAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+        .pNext = &exportAllocateInfo,
+        .image = image,
+        .buffer = VK_NULL_HANDLE,
+    };
+    const auto allocateInfo = VkMemoryAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = &dedicatedAllocateInfo,
+        .allocationSize = description.memorySize,
+        .memoryTypeIndex = description.memoryTypeIndex,
+    };
+
+    auto memory = VkDeviceMemory {};
+    const auto result = vkAllocateMemory(m_device, &allocateInfo, m_allocationCallbacks, &memory);
+    if (result != VK_SUCCESS) {
+        vkDestroyImage(m_device, image, m_allocationCallbacks);
+        throw std::runtime_error(fmt::format("failed to allocate shared image memory for {}!", name));
+    }
+
+    vkBindImageMemory(m_device, image, memory, 0);
+
+    m_descriptions.push_back(description);
+    m_buffers.push_back(VK_NULL_HANDLE);
+    m_images.push_back(image);
+    m_memories.push_back(memory);
+
+    return image;
+}
+
+void SharedAssetPublisher::recordCopyToImage(VkCommandBuffer commandBuffer, VkImage sourceImage, const std::string& name) const {
+    const auto index = this->findAsset(name, SharedAssetKind::Image);
+    const auto& description = m_descriptions[index];
+    const auto subresourceRange = getColorSubresourceRange(description.mipLevels);
+
+    auto barriers = BarrierBatch { m_useSynchronization2 };
+    barriers.transitionImage(sourceImage, subresourceRange, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    barriers.transitionImage(m_images[index], subresourceRange, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    barriers.flush(commandBuffer);
+
+    // Block-compressed levels are copied by their texel extents, which reach the edge of
+    // every level.
+    auto regions = std::vector<VkImageCopy> {};
+    regions.reserve(description.mipLevels);
+    for (uint32_t level = 0; level < description.mipLevels; level++) {
+        const auto subresource = VkImageSubresourceLayers {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = level,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        };
+        regions.push_back(VkImageCopy {
+            .srcSubresource = subresource,
+            .srcOffset = VkOffset3D { 0, 0, 0 },
+            .dstSubresource = subresource,
+            .dstOffset = VkOffset3D { 0, 0, 0 },
+            .extent = VkExtent3D {
+                std::max(description.extent.width >> level, 1u),
+                std::max(description.extent.height >> level, 1u),
+                1,
+            },
+        });
+    }
+    vkCmdCopyImage(
+        commandBuffer,
+        sourceImage,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        m_images[index],
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(regions.size()),
+        regions.data()
+    );
+
+    barriers.transitionImage(m_images[index], subresourceRange, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    barriers.flush(commandBuffer);
+}
+
+void SharedAssetPublisher::recordPublish(VkCommandBuffer commandBuffer) const {
+    auto barriers = BarrierBatch { m_useSynchronization2 };
+    addOwnershipTransfers(barriers, m_buffers, m_images, m_descriptions, m_queueFamilyIndex, VK_QUEUE_FAMILY_EXTERNAL);
+    barriers.flush(commandBuffer);
+
+    addOwnershipTransfers(barriers, m_buffers, m_images, m_descriptions, VK_QUEUE_FAMILY_EXTERNAL, m_queueFamilyIndex);
+    barriers.flush(commandBuffer);
+}
+
+void SharedAssetPublisher::startServing() {
+    if (m_thread.joinable()) {
+        throw std::logic_error("shared assets are served already!");
+    }
+
+    m_thread = std::thread { [this]() { this->serve(); } };
+}
+
+void SharedAssetPublisher::signalReady() {
+    const auto signalInfo = VkSemaphoreSignalInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO,
+        .pNext = nullptr,
+        .semaphore = m_timelineSemaphore,
+        .value = READY_VALUE,
+    };
+    const auto result = vkSignalSemaphore(m_device, &signalInfo);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to signal shared asset timeline semaphore!");
+    }
+}
+
+size_t SharedAssetPublisher::findAsset(const std::string& name, SharedAssetKind kind) const {
+    for (size_t i = 0; i < m_descriptions.size(); i++) {
+        if (m_descriptions[i].name == name && m_descriptions[i].kind == kind) {
+            return i;
+        }
+    }
+
+    throw std::invalid_argument(fmt::format("there is no shared asset named {} of that kind!", name));
+}
+
+void SharedAssetPublisher::checkNewAsset(const std::string& name) const {
+    if (m_thread.joinable()) {
+        throw std::logic_error("shared assets cannot be created once they are served!");
+    }
+
+    if (name.empty() || name.size() > MAX_NAME_LENGTH) {
+        throw std::invalid_argument(fmt::format("shared asset name \"{}\" is empty or longer than {} characters!", name, MAX_NAME_LENGTH));
+    }
+
+    if (m_descriptions.size() >= MAX_ASSET_COUNT) {
+        throw std::invalid_argument(fmt::format("there can be at most {} shared assets!", MAX_ASSET_COUNT));
+    }
+
+    const auto isTaken = std::ranges::any_of(m_descriptions, [&name](const auto& description) {
+        return description.name == name;
+    });
+    if (isTaken) {
+        throw std::invalid_argument(fmt::format("there is a shared asset named {} already!", name));
+    }
+}
+
+void SharedAssetPublisher::serve() {
+    while (true) {
+        {
+            const auto lock = std::lock_guard<std::mutex> { m_mutex };
+            if (m_isStopping) {
+                return;
+            }
+        }
+
+        const auto client = acceptConnection(m_socket, ACCEPT_POLL_MILLISECONDS);
+        if (client == INVALID_SOCKET_HANDLE) {
+            continue;
+        }
+
+        this->answer(client);
+        closeDescriptor(client);
+    }
+}
+
+void SharedAssetPublisher::answer(SocketHandle client) const {
+    const auto idProperties = getIdProperties(m_physicalDevice);
+    auto manifest = WireManifest {};
+    manifest.magic = MANIFEST_MAGIC;
+    manifest.version = MANIFEST_VERSION;
+    std::copy_n(idProperties.deviceUUID, VK_UUID_SIZE, manifest.deviceUuid.begin());
+    std::copy_n(idProperties.driverUUID, VK_UUID_SIZE, manifest.driverUuid.begin());
+    manifest.assetCount = static_cast<uint32_t>(m_descriptions.size());
+    for (size_t i = 0; i < m_descriptions.size(); i++) {
+        const auto& description = m_descriptions[i];
+        auto& asset = manifest.assets[i];
+        std::copy_n(description.name.begin(), description.name.size(), asset.name.begin());
+        asset.kind = static_cast<uint32_t>(description.kind);
+        asset.usage = description.usage;
+        asset.format = static_cast<uint32_t>(description.format);
+        asset.width = description.extent.width;
+        asset.height = description.extent.height;
+        asset.mipLevels = description.mipLevels;
+        asset.memoryTypeIndex = description.memoryTypeIndex;
+        asset.size = description.size;
+        asset.memorySize = description.memorySize;
+    }
+
+    // Every importer gets descriptors of its own, which go away with the importer's copies
+    // once they are sent. An importer whose descriptors cannot be exported is turned away,
+    // and times out.
+    auto fds = std::vector<int> {};
+    auto isExported = true;
+    for (size_t i = 0; i < m_memories.size() && isExported; i++) {
+        const auto getFdInfo = VkMemoryGetFdInfoKHR {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
+            .pNext = nullptr,
+            .memory = m_memories[i],
+            .handleType = MEMORY_HANDLE_TYPE,
+        };
+        auto fd = -1;
+        isExported = m_vkGetMemoryFdKHR(m_device, &getFdInfo, &fd) == VK_SUCCESS;
+        if (isExported) {
+            fds.push_back(fd);
+        }
+    }
+    if (isExported) {
+        const auto getFdInfo = VkSemaphoreGetFdInfoKHR {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_GET_FD_INFO_KHR,
+            .pNext = nullptr,
+            .semaphore = m_timelineSemaphore,
+            .handleType = SEMAPHORE_HANDLE_TYPE,
+        };
+        auto fd = -1;
+        isExported = m_vkGetSemaphoreFdKHR(m_device, &getFdInfo, &fd) == VK_SUCCESS;
+        if (isExported) {
+            fds.push_back(fd);
+        }
+    }
+
+    if (isExported) {
+        sendManifest(client, manifest, fds);
+    }
+    for (const auto fd : fds) {
+        closeDescriptor(fd);
+    }
+}
+
+
+SharedAssetImporter::SharedAssetImporter(
+    VkPhysicalDevice physicalDevice,
+    VkDevice device,
+    const VkAllocationCallbacks* allocationCallbacks,
+    uint32_t queueFamilyIndex,
+    bool useSynchronization2,
+    const std::string& socketPath,
+    std::chrono::milliseconds timeout
+)
+    : m_physicalDevice { physicalDevice }
+    , m_device { device }
+    , m_allocationCallbacks { allocationCallbacks }
+    , m_queueFamilyIndex { queueFamilyIndex }
+    , m_useSynchronization2 { useSynchronization2 }
+    , m_descriptions { std::vector<SharedAssetDescription> {} }
+    , m_memoryFds { std::vector<int> {} }
+    , m_buffers { std::vector<VkBuffer> {} }
+    , m_images { std::vector<VkImage> {} }
+    , m_memories { std::vector<VkDeviceMemory> {} }
+    , m_timelineSemaphore { VK_NULL_HANDLE }
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    const auto socketHandle = connectToSocket(socketPath, deadline);
+    auto manifest = WireManifest {};
+    auto fds = std::vector<int> {};
+    try {
+        fds = receiveManifest(socketHandle, manifest, deadline);
+    } catch (...) {
+        closeDescriptor(socketHandle);
+        throw;
+    }
+    closeDescriptor(socketHandle);
+
+    const auto fail = [&fds](const char* message) {
+        for (const auto fd : fds) {
+            closeDescriptor(fd);
+        }
+
+        throw std::runtime_error(message);
+    };
+    if (manifest.magic != MANIFEST_MAGIC || manifest.version != MANIFEST_VERSION) {
+        fail("failed to import shared assets: the owner is another build of the renderer!");
+    }
+    if (manifest.assetCount > MAX_ASSET_COUNT || fds.size() != manifest.assetCount + 1) {
+        fail("failed to import shared assets: the owner sent a file descriptor for something other than every asset and the semaphore!");
+    }
+
+    // Opaque file descriptors only carry memory between devices with the same UUIDs.
+    const auto idProperties = getIdProperties(m_physicalDevice);
+    const auto isSameDevice = std::equal(manifest.deviceUuid.begin(), manifest.deviceUuid.end(), idProperties.deviceUUID);
+    const auto isSameDriver = std::equal(manifest.driverUuid.begin(), manifest.driverUuid.end(), idProperties.driverUUID);
+    if (!isSameDevice || !isSameDriver) {
+        fail("failed to import shared assets: the owner renders on another device or driver!");
+    }
+
+    for (uint32_t i = 0; i < manifest.assetCount; i++) {
+        const auto& asset = manifest.assets[i];
+        m_descriptions.push_back(SharedAssetDescription {
+            .name = std::string { asset.name.data(), strnlen(asset.name.data(), asset.name.size()) },
+            .kind = static_cast<SharedAssetKind>(asset.kind),
+            .size = asset.size,
+            .usage = asset.usage,
+            .format = static_cast<VkFormat>(asset.format),
+            .extent = VkExtent2D { asset.width, asset.height },
+            .mipLevels = asset.mipLevels,
+            .memorySize = asset.memorySize,
+            .memoryTypeIndex = asset.memoryTypeIndex,
+        });
+    }
+    m_memoryFds = std::vector<int>(fds.begin(), fds.end() - 1);
+    m_buffers = std::vector<VkBuffer>(manifest.assetCount, VK_NULL_HANDLE);
+    m_images = std::vector<VkImage>(manifest.assetCount, VK_NULL_HANDLE);
+    m_memories = std::vector<VkDeviceMemory>(manifest.assetCount, VK_NULL_HANDLE);
+
+    try {
+        this->importTimelineSemaphore(fds.back());
+    } catch (...) {
+        fail("failed to import shared asset timeline semaphore!");
+    }
+}
+
+SharedAssetImporter::~SharedAssetImporter() {
+    vkDestroySemaphore(m_device, m_timelineSemaphore, m_allocationCallbacks);
+    for (size_t i = 0; i < m_descriptions.size(); i++) {
+        if (m_images[i] != VK_NULL_HANDLE) {
+            vkDestroyImage(m_device, m_images[i], m_allocationCallbacks);
+        }
+        if (m_memories[i] != VK_NULL_HANDLE) {
+            vkFreeMemory(m_device, m_memories[i], m_allocationCallbacks);
+        }
+        if (m_memoryFds[i] != -1) {
+            closeDescriptor(m_memoryFds[i]);
+        }
+    }
+
+    m_descriptions.clear();
+    m_memoryFds.clear();
+    m_buffers.clear();
+    m_images.clear();
+    m_memories.clear();
+    m_timelineSemaphore = VK_NULL_HANDLE;
+    m_allocationCallbacks = nullptr;
+    m_device = VK_NULL_HANDLE;
+}
+
+bool SharedAssetImporter::hasAsset(const std::string& name) const {
+    return std::ranges::any_of(m_descriptions, [&name](const auto& description) {
+        return description.name == name;
+    });
+}
+
+const SharedAssetDescription& SharedAssetImporter::getDescription(const std::string& name) const {
+    const auto match = std::ranges::find_if(m_descriptions, [&name](const auto& description) {
+        return description.name == name;
+    });
+    if (match == m_descriptions.end()) {
+        throw std::runtime_error(fmt::format("failed to import shared assets: the owner shares no asset named {}!", name));
+    }
+
+    return *match;
+}
+
+VkBuffer SharedAssetImporter::importBuffer(const std::string& name, VkDeviceSize size, VkBufferUsageFlags usage) {
+    const auto index = this->findAsset(name, SharedAssetKind::Buffer);
+    const auto& description = m_descriptions[index];
+    if (description.size < size || (description.usage & usage) != usage) {
+        throw std::runtime_error(fmt::format("failed to import shared buffer {}: the owner's buffer is smaller, or has less usage, than this process needs!", name));
+    }
+
+    if (!isBufferShareable(m_physicalDevice, description.usage, VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT)) {
+        throw std::runtime_error(fmt::format("failed to import shared buffer {}: the device cannot import it from a file descriptor!", name));
+    }
+
+    const auto buffer = createExternalBuffer(m_device, m_allocationCallbacks, description);
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+    try {
+        m_memories[index] = this->importMemory(index, memRequirements, buffer, VK_NULL_HANDLE);
+    } catch (...) {
+        vkDestroyBuffer(m_device, buffer, m_allocationCallbacks);
+        throw;
+    }
+
+    vkBindBufferMemory(m_device, buffer, m_memories[index], 0);
+    m_buffers[index] = buffer;
+
+    return buffer;
+}
+
+VkImage SharedAssetImporter::importImage(const std::string& name) {
+    const auto index = this->findAsset(name, SharedAssetKind::Image);
+    const auto& description = m_descriptions[index];
+    if (!isImageShareable(m_physicalDevice, description.format, description.usage, VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT)) {
+        throw std::runtime_error(fmt::format("failed to import shared image {}: the device cannot import it from a file descriptor!", name));
+    }
+
+    const auto image = createExternalImage(m_device, m_allocationCallbacks, description);
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetImageMemoryRequirements(m_device, image, &memRequirements);
+    try {
+        m_memories[index] = this->importMemory(index, memRequirements, VK_NULL_HANDLE, image);
+    } catch (...) {
+        vkDestroyImage(m_device, image, m_allocationCallbacks);
+        throw;
+    }
+
+    vkBindImageMemory(m_device, image, m_memories[index], 0);
+    m_images[index] = image;
+
+    return image;
+}
+
+void SharedAssetImporter::recordAcquire(VkCommandBuffer commandBuffer) const {
+    auto barriers = BarrierBatch { m_useSynchronization2 };
+    addOwnershipTransfers(barriers, m_buffers, m_images, m_descriptions, VK_QUEUE_FAMILY_EXTERNAL, m_queueFamilyIndex);
+    barriers.flush(commandBuffer);
+}
+
+void SharedAssetImporter::waitUntilReady(std::chrono::milliseconds timeout) const {
+    const auto value = SharedAssetPublisher::READY_VALUE;
+    const auto waitInfo = VkSemaphoreWaitInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .semaphoreCount = 1,
+        .pSemaphores = &m_timelineSemaphore,
+        .pValues = &value,
+    };
+    const auto timeoutNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+    const auto result = vkWaitSemaphores(m_device, &waitInfo, static_cast<uint64_t>(timeoutNanoseconds));
+    if (result == VK_TIMEOUT) {
+        throw std::runtime_error("failed to import shared assets: the owner did not finish uploading them in time!");
+    }
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to wait for shared assets!");
+    }
+}
+
+size_t SharedAssetImporter::findAsset(const std::string& name, SharedAssetKind kind) const {
+    const auto& description = this->getDescription(name);
+    if (description.kind != kind) {
+        throw std::runtime_error(fmt::format("failed to import shared assets: the owner shares {} as another kind of resource!", name));
+    }
+
+    const auto index = static_cast<size_t>(&description - m_descriptions.data());
+    if (m_memoryFds[index] == -1) {
+        throw std::logic_error(fmt::format("shared asset {} is imported already!", name));
+    }
+
+    return index;
+}
+
+VkDeviceMemory SharedAssetImporter::importMemory(size_t index, const VkMemoryRequirements& memoryRequirements, VkBuffer buffer, VkImage image) {
+    const auto& description = m_descriptions[index];
+    const auto isTypeAllowed = (memoryRequirements.memoryTypeBits & (1u << description.memoryTypeIndex)) != 0;
+    if (memoryRequirements.size != description.memorySize || !isTypeAllowed) {
+        throw std::runtime_error(fmt::format("failed to import shared asset {}: its memory does not fit the resource made from its description!", description.name));
+    }
+
+    const auto importFdInfo = VkImportMemoryFdInfoKHR {
+        .sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR,
+        .pNext = nullptr,
+        .handleType = MEMORY_HANDLE_TYPE,
+        .fd = m_memoryFds[index],
+    };
+    const auto dedicatedAllocateInfo = VkMemoryDedicatedAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+        .pNext = &importFdInfo,
+        .image = image,
+        .buffer = buffer,
+    };
+    const auto allocateInfo = VkMemoryAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = &dedicatedAllocateInfo,
+        .allocationSize = description.memorySize,
+        .memoryTypeIndex = description.memoryTypeIndex,
+    };
+
+    auto memory = VkDeviceMemory {};
+    const auto result = vkAllocateMemory(m_device, &allocateInfo, m_allocationCallbacks, &memory);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error(fmt::format("failed to import shared asset memory for {}!", description.name));
+    }
+
+    // The memory owns the descriptor once it is imported.
+    m_memoryFds[index] = -1;
+
+    return memory;
+}
+
+void SharedAssetImporter::importTimelineSemaphore(int fd) {
+    const auto timelineCreateInfo = VkSemaphoreTypeCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = nullptr,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    const auto semaphoreInfo = VkSemaphoreCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timelineCreateInfo,
+        .flags = 0,
+    };
+    const auto resultCreate = vkCreateSemaphore(m_device, &semaphoreInfo, m_allocationCallbacks, &m_timelineSemaphore);
+    if (resultCreate != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shared asset timeline semaphore!");
+    }
+
+    const auto vkImportSemaphoreFdKHR = reinterpret_cast<PFN_vkImportSemaphoreFdKHR>(
+        vkGetDeviceProcAddr(m_device, "vkImportSemaphoreFdKHR")
+    );
+    const auto importFdInfo = VkImportSemaphoreFdInfoKHR {
+        .sType = VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_FD_INFO_KHR,
+        .pNext = nullptr,
+        .semaphore = m_timelineSemaphore,
+        .flags = 0,
+        .handleType = SEMAPHORE_HANDLE_TYPE,
+        .fd = fd,
+    };
+    if (vkImportSemaphoreFdKHR == nullptr || vkImportSemaphoreFdKHR(m_device, &importFdInfo) != VK_SUCCESS) {
+        vkDestroySemaphore(m_device, m_timelineSemaphore, m_allocationCallbacks);
+        m_timelineSemaphore = VK_NULL_HANDLE;
+        throw std::runtime_error("failed to import shared asset timeline semaphore!");
+    }
+}
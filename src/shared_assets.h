@@ -0,0 +1,223 @@
+#ifndef _SHARED_ASSETS_H
+#define _SHARED_ASSETS_H
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+enum class SharedAssetKind : uint32_t {
+    Buffer,
+    Image
+};
+
+/// @brief What an importer needs to create a resource identical to the owner's, so that it
+/// takes the owner's memory as it is.
+///
+/// @note `usage` holds buffer usage flags for a buffer and image usage flags for an image.
+/// Only images have a format, an extent and mip levels.
+struct SharedAssetDescription final {
+    std::string name;
+    SharedAssetKind kind = SharedAssetKind::Buffer;
+    VkDeviceSize size = 0;
+    uint32_t usage = 0;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent = VkExtent2D { 0, 0 };
+    uint32_t mipLevels = 0;
+    VkDeviceSize memorySize = 0;
+    uint32_t memoryTypeIndex = 0;
+};
+
+/// @brief The asset buffers and images of the process that owns them, in memory exported as
+/// POSIX file descriptors, so that other instances of the renderer on the same GPU read them
+/// in place instead of loading copies of their own.
+///
+/// @note The owner creates every asset here, fills it with its usual uploads, and records
+/// `recordPublish` after the last of them. `startServing` then hands every importer that
+/// connects to the Unix domain socket at `socketPath` a manifest of the assets, with a file
+/// descriptor for the memory of each and one for a timeline semaphore, and `signalReady`
+/// signals the semaphore from the host once the uploads have finished. Importers wait for
+/// it before their first frame, and only read the assets from then on.
+///
+/// Every asset has a dedicated allocation, which importers bind to a resource created from
+/// the same description. The buffers are handed to the caller, which destroys them like any
+/// other buffer, while the images stay with the publisher, like the images of a frame
+/// exporter. The memory outlives the publisher for as long as an importer holds it.
+class SharedAssetPublisher final {
+    public:
+        static constexpr VkExternalMemoryHandleTypeFlagBits MEMORY_HANDLE_TYPE = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+        static constexpr VkExternalSemaphoreHandleTypeFlagBits SEMAPHORE_HANDLE_TYPE = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT;
+        /// @brief The value the timeline semaphore reaches once the assets hold their data.
+        static constexpr uint64_t READY_VALUE = 1;
+        static constexpr uint32_t MAX_ASSET_COUNT = 16;
+        static constexpr size_t MAX_NAME_LENGTH = 31;
+        /// @brief How often the socket checks whether it is stopping while no importer
+        /// connects, in milliseconds.
+        static constexpr int ACCEPT_POLL_MILLISECONDS = 100;
+
+        explicit SharedAssetPublisher() = delete;
+        explicit SharedAssetPublisher(
+            VkPhysicalDevice physicalDevice,
+            VkDevice device,
+            const VkAllocationCallbacks* allocationCallbacks,
+            uint32_t queueFamilyIndex,
+            bool useSynchronization2,
+            const std::string& socketPath
+        );
+
+        /// @brief Stop answering importers, and destroy the images and the semaphore.
+        ///
+        /// @note The buffers have to be destroyed first. The device has to be idle.
+        ~SharedAssetPublisher();
+
+        SharedAssetPublisher(const SharedAssetPublisher& other) = delete;
+        SharedAssetPublisher& operator=(const SharedAssetPublisher& other) = delete;
+
+        /// @brief Whether `physicalDevice` can export timeline semaphores as file descriptors.
+        ///
+        /// @note Whether a buffer or an image can be exported is checked as it is created.
+        static bool isSupported(VkPhysicalDevice physicalDevice);
+
+        /// @brief A device local buffer whose memory importers can take, which the caller
+        /// owns and destroys.
+        VkBuffer createBuffer(const std::string& name, VkDeviceSize size, VkBufferUsageFlags usage);
+
+        /// @brief A device local, optimally tiled 2D image whose memory importers can take.
+        VkImage createImage(const std::string& name, VkFormat format, VkExtent2D extent, uint32_t mipLevels, VkImageUsageFlags usage);
+
+        /// @brief Copy every level of `sourceImage`, which is in the shader read-only layout and
+        /// matches image `name`, into image `name`, which is left in the same layout.
+        ///
+        /// @note `sourceImage` is left in the transfer source layout.
+        void recordCopyToImage(VkCommandBuffer commandBuffer, VkImage sourceImage, const std::string& name) const;
+
+        /// @brief Hand every asset to the external queue family and take it back, which makes
+        /// the writes before it, and the shader read-only layout of the images, available to
+        /// importers.
+        void recordPublish(VkCommandBuffer commandBuffer) const;
+
+        /// @brief Answer every importer that connects from now on, from a background thread.
+        ///
+        /// @note No asset can be created after this.
+        void startServing();
+
+        /// @brief Signal importers that the uploads recorded before `recordPublish` have
+        /// finished.
+        void signalReady();
+    private:
+        using SocketHandle = int;
+
+        VkPhysicalDevice m_physicalDevice;
+        VkDevice m_device;
+        const VkAllocationCallbacks* m_allocationCallbacks;
+        uint32_t m_queueFamilyIndex;
+        bool m_useSynchronization2;
+        std::string m_socketPath;
+        std::vector<SharedAssetDescription> m_descriptions;
+        /// @brief The buffer or the image of every asset, by the kind of its description.
+        std::vector<VkBuffer> m_buffers;
+        std::vector<VkImage> m_images;
+        std::vector<VkDeviceMemory> m_memories;
+        VkSemaphore m_timelineSemaphore;
+        PFN_vkGetMemoryFdKHR m_vkGetMemoryFdKHR;
+        PFN_vkGetSemaphoreFdKHR m_vkGetSemaphoreFdKHR;
+        SocketHandle m_socket;
+        std::mutex m_mutex;
+        bool m_isStopping;
+        std::thread m_thread;
+
+        size_t findAsset(const std::string& name, SharedAssetKind kind) const;
+
+        /// @brief Throw unless an asset named `name` can still be created.
+        void checkNewAsset(const std::string& name) const;
+
+        void serve();
+
+        void answer(SocketHandle client) const;
+};
+
+/// @brief The assets of another process on the same GPU, taken from a `SharedAssetPublisher`
+/// over the Unix domain socket at `socketPath`.
+///
+/// @note The manifest and the file descriptors are taken once, when the importer connects,
+/// trying again until `timeout` for an owner that is still starting up. Only devices with
+/// the owner's device and driver UUIDs can take its memory. Every asset is imported by
+/// name, into a resource created from its description, and `recordAcquire` takes the
+/// imported assets from the external queue family in the shader read-only layout, which
+/// the owner left them in. `waitUntilReady` has to return before the first submit that
+/// reads them.
+///
+/// Importers never write to the assets. As with the publisher, imported buffers belong to
+/// the caller, and imported images to the importer.
+class SharedAssetImporter final {
+    public:
+        explicit SharedAssetImporter() = delete;
+        explicit SharedAssetImporter(
+            VkPhysicalDevice physicalDevice,
+            VkDevice device,
+            const VkAllocationCallbacks* allocationCallbacks,
+            uint32_t queueFamilyIndex,
+            bool useSynchronization2,
+            const std::string& socketPath,
+            std::chrono::milliseconds timeout
+        );
+
+        /// @brief Destroy the images and the semaphore, and close the file descriptors that
+        /// were never imported.
+        ///
+        /// @note The buffers have to be destroyed first. The device has to be idle.
+        ~SharedAssetImporter();
+
+        SharedAssetImporter(const SharedAssetImporter& other) = delete;
+        SharedAssetImporter& operator=(const SharedAssetImporter& other) = delete;
+
+        bool hasAsset(const std::string& name) const;
+
+        const SharedAssetDescription& getDescription(const std::string& name) const;
+
+        /// @brief Buffer `name` of the owner, which the caller owns and destroys.
+        ///
+        /// @note The owner's buffer has to hold at least `size` bytes and have at least
+        /// `usage`. The buffer is created with the owner's size and usage, so that its
+        /// memory requirements match.
+        VkBuffer importBuffer(const std::string& name, VkDeviceSize size, VkBufferUsageFlags usage);
+
+        /// @brief Image `name` of the owner.
+        VkImage importImage(const std::string& name);
+
+        /// @brief Take the assets imported so far from the external queue family.
+        void recordAcquire(VkCommandBuffer commandBuffer) const;
+
+        /// @brief Block until the owner has filled the assets, or throw after `timeout`.
+        void waitUntilReady(std::chrono::milliseconds timeout) const;
+    private:
+        VkPhysicalDevice m_physicalDevice;
+        VkDevice m_device;
+        const VkAllocationCallbacks* m_allocationCallbacks;
+        uint32_t m_queueFamilyIndex;
+        bool m_useSynchronization2;
+        std::vector<SharedAssetDescription> m_descriptions;
+        /// @brief The file descriptor of every asset, until its memory is imported.
+        std::vector<int> m_memoryFds;
+        std::vector<VkBuffer> m_buffers;
+        std::vector<VkImage> m_images;
+        std::vector<VkDeviceMemory> m_memories;
+        VkSemaphore m_timelineSemaphore;
+
+        size_t findAsset(const std::string& name, SharedAssetKind kind) const;
+
+        VkDeviceMemory importMemory(size_t index, const VkMemoryRequirements& memoryRequirements, VkBuffer buffer, VkImage image);
+
+        void importTimelineSemaphore(int fd);
+};
+
+}
+
+#endif // _SHARED_ASSETS_H
@@ -0,0 +1,418 @@
+#include "sparse_texture.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+using SparseTexture = VulkanEngine::SparseTexture;
+
+SparseTexture::SparseTexture(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    VkQueue sparseBindingQueue,
+    uint32_t width,
+    uint32_t height,
+    uint32_t mipLevels,
+    VkFormat format,
+    VkImageUsageFlags usage,
+    VkDeviceSize memoryBudget
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_sparseBindingQueue { sparseBindingQueue }
+    , m_image { VK_NULL_HANDLE }
+    , m_width { width }
+    , m_height { height }
+    , m_mipLevels { mipLevels }
+    , m_memoryRequirements {}
+    , m_sparseMemoryRequirements {}
+    , m_mipTailAllocation {}
+    , m_levelPages { std::vector<std::vector<GpuAllocation>> { mipLevels } }
+    , m_freePages { std::vector<GpuAllocation> {} }
+    , m_pageCount { 0 }
+    , m_maxPageCount { 0 }
+    , m_bindSemaphore { VK_NULL_HANDLE }
+    , m_bindValue { 0 }
+{
+    const auto imageInfo = VkImageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .flags = VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .extent.width = width,
+        .extent.height = height,
+        .extent.depth = 1,
+        .mipLevels = mipLevels,
+        .arrayLayers = 1,
+        .format = format,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .usage = usage,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto image = VkImage {};
+    const auto resultCreateImage = vkCreateImage(m_device, &imageInfo, nullptr, &image);
+    if (resultCreateImage != VK_SUCCESS) {
+        throw std::runtime_error("failed to create sparse image!");
+    }
+
+    m_image = image;
+
+    // The alignment of a sparse image is the size of one sparse block, which is the size of
+    // every page in the pool.
+    vkGetImageMemoryRequirements(m_device, m_image, &m_memoryRequirements);
+
+    uint32_t requirementCount = 0;
+    vkGetImageSparseMemoryRequirements(m_device, m_image, &requirementCount, nullptr);
+
+    auto sparseMemoryRequirements = std::vector<VkSparseImageMemoryRequirements> { requirementCount };
+    vkGetImageSparseMemoryRequirements(m_device, m_image, &requirementCount, sparseMemoryRequirements.data());
+
+    const auto colorRequirements = std::find_if(
+        sparseMemoryRequirements.begin(),
+        sparseMemoryRequirements.end(),
+        [](const VkSparseImageMemoryRequirements& requirements) {
+            return (requirements.formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) != 0;
+        }
+    );
+    if (colorRequirements == sparseMemoryRequirements.end()) {
+        vkDestroyImage(m_device, m_image, nullptr);
+
+        throw std::runtime_error("failed to find sparse memory requirements of the color aspect!");
+    }
+
+    m_sparseMemoryRequirements = *colorRequirements;
+    m_maxPageCount = static_cast<uint32_t>(memoryBudget / m_memoryRequirements.alignment);
+
+    const auto timelineCreateInfo = VkSemaphoreTypeCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    const auto semaphoreInfo = VkSemaphoreCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timelineCreateInfo,
+    };
+
+    auto bindSemaphore = VkSemaphore {};
+    const auto resultCreateSemaphore = vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &bindSemaphore);
+    if (resultCreateSemaphore != VK_SUCCESS) {
+        vkDestroyImage(m_device, m_image, nullptr);
+
+        throw std::runtime_error("failed to create sparse bind semaphore!");
+    }
+
+    m_bindSemaphore = bindSemaphore;
+
+    try {
+        this->bindMipTail();
+    } catch (...) {
+        vkDestroySemaphore(m_device, m_bindSemaphore, nullptr);
+        vkDestroyImage(m_device, m_image, nullptr);
+
+        throw;
+    }
+}
+
+SparseTexture::~SparseTexture() {
+    vkDestroyImage(m_device, m_image, nullptr);
+    vkDestroySemaphore(m_device, m_bindSemaphore, nullptr);
+
+    for (const auto& pages : m_levelPages) {
+        for (const auto& page : pages) {
+            m_allocator.free(page);
+        }
+    }
+
+    for (const auto& page : m_freePages) {
+        m_allocator.free(page);
+    }
+
+    if (m_mipTailAllocation.isValid()) {
+        m_allocator.free(m_mipTailAllocation);
+    }
+
+    m_levelPages.clear();
+    m_freePages.clear();
+    m_bindSemaphore = VK_NULL_HANDLE;
+    m_image = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+bool SparseTexture::isSupported(VkPhysicalDevice physicalDevice, VkFormat format, VkImageUsageFlags usage) {
+    uint32_t propertyCount = 0;
+    vkGetPhysicalDeviceSparseImageFormatProperties(
+        physicalDevice,
+        format,
+        VK_IMAGE_TYPE_2D,
+        VK_SAMPLE_COUNT_1_BIT,
+        usage,
+        VK_IMAGE_TILING_OPTIMAL,
+        &propertyCount,
+        nullptr
+    );
+    if (propertyCount == 0) {
+        return false;
+    }
+
+    auto properties = std::vector<VkSparseImageFormatProperties> { propertyCount };
+    vkGetPhysicalDeviceSparseImageFormatProperties(
+        physicalDevice,
+        format,
+        VK_IMAGE_TYPE_2D,
+        VK_SAMPLE_COUNT_1_BIT,
+        usage,
+        VK_IMAGE_TILING_OPTIMAL,
+        &propertyCount,
+        properties.data()
+    );
+
+    // Pages are sized by the image alignment, which only matches the block extent when the
+    // device uses the standard block shapes.
+    return std::any_of(properties.begin(), properties.end(), [](const VkSparseImageFormatProperties& formatProperties) {
+        return (formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) != 0 &&
+            (formatProperties.flags & VK_SPARSE_IMAGE_FORMAT_NONSTANDARD_BLOCK_SIZE_BIT) == 0;
+    });
+}
+
+VkImage SparseTexture::getImage() const {
+    return m_image;
+}
+
+VkSemaphore SparseTexture::getBindSemaphore() const {
+    return m_bindSemaphore;
+}
+
+uint32_t SparseTexture::getMipTailFirstLevel() const {
+    return std::min(m_sparseMemoryRequirements.imageMipTailFirstLod, m_mipLevels);
+}
+
+bool SparseTexture::isLevelResident(uint32_t level) const {
+    if (level >= this->getMipTailFirstLevel()) {
+        return true;
+    }
+
+    return !m_levelPages[level].empty();
+}
+
+std::optional<uint64_t> SparseTexture::makeLevelResident(uint32_t level) {
+    if (this->isLevelResident(level)) {
+        return m_bindValue;
+    }
+
+    const auto blockCount = this->getBlockCount(level);
+    const auto availablePageCount = static_cast<uint32_t>(m_freePages.size()) + (m_maxPageCount - m_pageCount);
+    if (blockCount > availablePageCount) {
+        return std::nullopt;
+    }
+
+    // Evicted pages are reused first. The pool only allocates new pages once they run out.
+    auto pages = std::vector<GpuAllocation> {};
+    pages.reserve(blockCount);
+    try {
+        while (pages.size() < blockCount && !m_freePages.empty()) {
+            pages.push_back(m_freePages.back());
+            m_freePages.pop_back();
+        }
+
+        const auto pageRequirements = VkMemoryRequirements {
+            .size = m_memoryRequirements.alignment,
+            .alignment = m_memoryRequirements.alignment,
+            .memoryTypeBits = m_memoryRequirements.memoryTypeBits,
+        };
+        // Streamed levels only cost detail when they are paged out, unlike the mip tail
+        // every view falls back to.
+        while (pages.size() < blockCount) {
+            pages.push_back(m_allocator.allocate(
+                pageRequirements,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                GpuResourceKind::Optimal,
+                GpuMemoryCategory::Texture,
+                GpuMemoryPriority::Low
+            ));
+            m_pageCount++;
+        }
+    } catch (...) {
+        m_freePages.insert(m_freePages.end(), pages.begin(), pages.end());
+
+        throw;
+    }
+
+    const auto blockBinds = this->createBlockBinds(level, pages);
+    const auto imageBindInfo = VkSparseImageMemoryBindInfo {
+        .image = m_image,
+        .bindCount = static_cast<uint32_t>(blockBinds.size()),
+        .pBinds = blockBinds.data(),
+    };
+    const auto bindValue = this->bind(&imageBindInfo, nullptr);
+
+    m_levelPages[level] = std::move(pages);
+
+    return bindValue;
+}
+
+void SparseTexture::evictLevel(uint32_t level) {
+    if (level >= this->getMipTailFirstLevel() || m_levelPages[level].empty()) {
+        return;
+    }
+
+    auto& pages = m_levelPages[level];
+    auto blockBinds = this->createBlockBinds(level, pages);
+    for (auto& blockBind : blockBinds) {
+        blockBind.memory = VK_NULL_HANDLE;
+        blockBind.memoryOffset = 0;
+    }
+
+    const auto imageBindInfo = VkSparseImageMemoryBindInfo {
+        .image = m_image,
+        .bindCount = static_cast<uint32_t>(blockBinds.size()),
+        .pBinds = blockBinds.data(),
+    };
+    this->bind(&imageBindInfo, nullptr);
+
+    // Binds run in order, so a page is only bound elsewhere after this unbind.
+    m_freePages.insert(m_freePages.end(), pages.begin(), pages.end());
+    pages.clear();
+}
+
+void SparseTexture::releaseFreePages() {
+    if (m_freePages.empty()) {
+        return;
+    }
+
+    const auto waitInfo = VkSemaphoreWaitInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &m_bindSemaphore,
+        .pValues = &m_bindValue,
+    };
+    const auto result = vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to wait for sparse binds!");
+    }
+
+    for (const auto& page : m_freePages) {
+        m_allocator.free(page);
+    }
+
+    m_pageCount -= static_cast<uint32_t>(m_freePages.size());
+    m_freePages.clear();
+}
+
+VkDeviceSize SparseTexture::getResidentSize() const {
+    auto residentPageCount = VkDeviceSize { 0 };
+    for (const auto& pages : m_levelPages) {
+        residentPageCount += pages.size();
+    }
+
+    return residentPageCount * m_memoryRequirements.alignment + m_mipTailAllocation.size;
+}
+
+uint32_t SparseTexture::getBlockCount(uint32_t level) const {
+    const auto& granularity = m_sparseMemoryRequirements.formatProperties.imageGranularity;
+    const auto levelWidth = std::max(m_width >> level, 1u);
+    const auto levelHeight = std::max(m_height >> level, 1u);
+    const auto blockCountX = (levelWidth + granularity.width - 1) / granularity.width;
+    const auto blockCountY = (levelHeight + granularity.height - 1) / granularity.height;
+
+    return blockCountX * blockCountY;
+}
+
+std::vector<VkSparseImageMemoryBind> SparseTexture::createBlockBinds(uint32_t level, const std::vector<GpuAllocation>& pages) const {
+    const auto& granularity = m_sparseMemoryRequirements.formatProperties.imageGranularity;
+    const auto levelWidth = std::max(m_width >> level, 1u);
+    const auto levelHeight = std::max(m_height >> level, 1u);
+
+    auto blockBinds = std::vector<VkSparseImageMemoryBind> {};
+    blockBinds.reserve(pages.size());
+    for (uint32_t y = 0; y < levelHeight; y += granularity.height) {
+        for (uint32_t x = 0; x < levelWidth; x += granularity.width) {
+            const auto& page = pages[blockBinds.size()];
+            // Blocks at the right and bottom edges are clipped to the level.
+            blockBinds.push_back(VkSparseImageMemoryBind {
+                .subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .subresource.mipLevel = level,
+                .subresource.arrayLayer = 0,
+                .offset = VkOffset3D { static_cast<int32_t>(x), static_cast<int32_t>(y), 0 },
+                .extent = VkExtent3D { std::min(granularity.width, levelWidth - x), std::min(granularity.height, levelHeight - y), 1 },
+                .memory = page.memory,
+                .memoryOffset = page.offset,
+                .flags = 0,
+            });
+        }
+    }
+
+    return blockBinds;
+}
+
+uint64_t SparseTexture::bind(const VkSparseImageMemoryBindInfo* imageBindInfo, const VkSparseImageOpaqueMemoryBindInfo* opaqueBindInfo) {
+    // Every bind waits for the previous one, so binds that hand a page from one level to
+    // another complete in the order they were made.
+    const auto waitValue = m_bindValue;
+    const auto signalValue = m_bindValue + 1;
+    const auto waitSemaphoreCount = [waitValue]() -> uint32_t {
+        if (waitValue > 0) {
+            return 1;
+        } else {
+            return 0;
+        }
+    }();
+    const auto timelineSubmitInfo = VkTimelineSemaphoreSubmitInfo {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount = waitSemaphoreCount,
+        .pWaitSemaphoreValues = &waitValue,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues = &signalValue,
+    };
+    const auto bindSparseInfo = VkBindSparseInfo {
+        .sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO,
+        .pNext = &timelineSubmitInfo,
+        .waitSemaphoreCount = waitSemaphoreCount,
+        .pWaitSemaphores = &m_bindSemaphore,
+        .imageOpaqueBindCount = opaqueBindInfo != nullptr ? 1u : 0u,
+        .pImageOpaqueBinds = opaqueBindInfo,
+        .imageBindCount = imageBindInfo != nullptr ? 1u : 0u,
+        .pImageBinds = imageBindInfo,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = &m_bindSemaphore,
+    };
+
+    const auto result = vkQueueBindSparse(m_sparseBindingQueue, 1, &bindSparseInfo, VK_NULL_HANDLE);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to bind sparse image memory!");
+    }
+
+    m_bindValue = signalValue;
+
+    return signalValue;
+}
+
+void SparseTexture::bindMipTail() {
+    if (this->getMipTailFirstLevel() >= m_mipLevels || m_sparseMemoryRequirements.imageMipTailSize == 0) {
+        return;
+    }
+
+    const auto mipTailRequirements = VkMemoryRequirements {
+        .size = m_sparseMemoryRequirements.imageMipTailSize,
+        .alignment = m_memoryRequirements.alignment,
+        .memoryTypeBits = m_memoryRequirements.memoryTypeBits,
+    };
+    const auto allocation = m_allocator.allocate(mipTailRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Optimal, GpuMemoryCategory::Texture);
+
+    const auto memoryBind = VkSparseMemoryBind {
+        .resourceOffset = m_sparseMemoryRequirements.imageMipTailOffset,
+        .size = m_sparseMemoryRequirements.imageMipTailSize,
+        .memory = allocation.memory,
+        .memoryOffset = allocation.offset,
+        .flags = 0,
+    };
+    const auto opaqueBindInfo = VkSparseImageOpaqueMemoryBindInfo {
+        .image = m_image,
+        .bindCount = 1,
+        .pBinds = &memoryBind,
+    };
+    this->bind(nullptr, &opaqueBindInfo);
+
+    m_mipTailAllocation = allocation;
+}
@@ -0,0 +1,106 @@
+#ifndef _SPARSE_TEXTURE_H
+#define _SPARSE_TEXTURE_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief A partially resident texture whose detailed mip levels only occupy memory while
+/// they are resident.
+///
+/// @note The image is created with `VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT`, so creating it
+/// allocates nothing. The mip tail, the levels smaller than one sparse block, is bound once
+/// and stays resident. Every other level is backed by pages from a fixed-size page pool,
+/// one page per sparse block, and its pages go back to the pool when it is evicted. The pool
+/// never grows past the memory budget, which caps how much of the texture can be resident
+/// at once no matter how large the texture is.
+///
+/// Binds run on the sparse binding queue and signal a timeline semaphore of the texture.
+/// Uploads into a level that was just made resident must wait for the returned value.
+class SparseTexture final {
+    public:
+        explicit SparseTexture() = delete;
+        explicit SparseTexture(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            VkQueue sparseBindingQueue,
+            uint32_t width,
+            uint32_t height,
+            uint32_t mipLevels,
+            VkFormat format,
+            VkImageUsageFlags usage,
+            VkDeviceSize memoryBudget
+        );
+
+        ~SparseTexture();
+
+        /// @brief Whether the device can create sparse residency images of this format and
+        /// usage with single-aspect, standard-sized sparse blocks.
+        static bool isSupported(VkPhysicalDevice physicalDevice, VkFormat format, VkImageUsageFlags usage);
+
+        VkImage getImage() const;
+
+        VkSemaphore getBindSemaphore() const;
+
+        /// @brief The first level of the mip tail. It and every smaller level are always
+        /// resident.
+        uint32_t getMipTailFirstLevel() const;
+
+        bool isLevelResident(uint32_t level) const;
+
+        /// @brief Bind pages to every sparse block of `level`.
+        ///
+        /// @returns The bind semaphore value to wait for before writing the level, or
+        /// nothing when the page pool is out of budget.
+        std::optional<uint64_t> makeLevelResident(uint32_t level);
+
+        /// @brief Unbind the pages of `level` and return them to the page pool.
+        ///
+        /// @note The level must no longer be in use by the GPU.
+        void evictLevel(uint32_t level);
+
+        /// @brief Free the pages of evicted levels that are waiting in the page pool, so that
+        /// their memory goes back to its heap.
+        ///
+        /// @note Waits for the binds submitted so far, since a page has to be unbound before
+        /// its memory is freed. Pages freed here are allocated again on demand.
+        void releaseFreePages();
+
+        VkDeviceSize getResidentSize() const;
+    private:
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkQueue m_sparseBindingQueue;
+        VkImage m_image;
+        uint32_t m_width;
+        uint32_t m_height;
+        uint32_t m_mipLevels;
+        VkMemoryRequirements m_memoryRequirements;
+        VkSparseImageMemoryRequirements m_sparseMemoryRequirements;
+        GpuAllocation m_mipTailAllocation;
+        std::vector<std::vector<GpuAllocation>> m_levelPages;
+        std::vector<GpuAllocation> m_freePages;
+        uint32_t m_pageCount;
+        uint32_t m_maxPageCount;
+        VkSemaphore m_bindSemaphore;
+        uint64_t m_bindValue;
+
+        uint32_t getBlockCount(uint32_t level) const;
+
+        std::vector<VkSparseImageMemoryBind> createBlockBinds(uint32_t level, const std::vector<GpuAllocation>& pages) const;
+
+        uint64_t bind(const VkSparseImageMemoryBindInfo* imageBindInfo, const VkSparseImageOpaqueMemoryBindInfo* opaqueBindInfo);
+
+        void bindMipTail();
+};
+
+}
+
+#endif // _SPARSE_TEXTURE_H
@@ -0,0 +1,209 @@
+#include "staging_ring.h"
+
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#include "device_lost_error.h"
+
+
+using StagingRing = VulkanEngine::StagingRing;
+using DeviceLostError = VulkanEngine::DeviceLostError;
+
+StagingRing::StagingRing(VkDevice device, GpuMemoryAllocator& allocator, QueueSubmitter& queueSubmitter, VkDeviceSize capacity)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_queueSubmitter { queueSubmitter }
+    , m_buffer { VK_NULL_HANDLE }
+    , m_allocation {}
+    , m_capacity { capacity }
+    , m_head { 0 }
+    , m_tail { 0 }
+    , m_pendingSliceCount { 0 }
+    , m_inFlightBatches { std::deque<InFlightBatch> {} }
+{
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = capacity,
+        // Compressed assets are read by the GPU decompressor straight out of the ring.
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto resultCreateBuffer = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+    if (resultCreateBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to create staging ring buffer!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    const auto allocation = m_allocator.allocate(
+        memRequirements,
+        m_allocator.selectUploadMemoryProperties(memRequirements.memoryTypeBits, PREFER_CACHED_MEMORY),
+        GpuResourceKind::Linear,
+        GpuMemoryCategory::Staging
+    );
+
+    vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+    m_buffer = buffer;
+    m_allocation = allocation;
+}
+
+StagingRing::~StagingRing() {
+    // The held submits a lost device refuses never signal, so the batches are dropped.
+    try {
+        this->waitIdle();
+    } catch (const DeviceLostError&) {
+        m_inFlightBatches.clear();
+    }
+
+    vkDestroyBuffer(m_device, m_buffer, nullptr);
+    m_allocator.free(m_allocation);
+
+    m_buffer = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+VulkanEngine::StagingSlice StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    if (size >= m_capacity) {
+        throw std::invalid_argument {
+            fmt::format("Staging request of {} bytes exceeds the staging ring capacity of {} bytes", size, m_capacity)
+        };
+    }
+
+    this->reclaim();
+
+    auto offset = this->tryAllocate(size, alignment);
+    while (!offset.has_value()) {
+        if (m_inFlightBatches.empty()) {
+            throw std::runtime_error("staging ring exhausted by slices that have not been submitted!");
+        }
+
+        this->reclaimOldestBatch();
+        offset = this->tryAllocate(size, alignment);
+    }
+
+    m_pendingSliceCount++;
+    // The slice is written after it is handed out, but before the submit that flushes it.
+    m_allocator.addDirtyRange(m_allocation, offset.value(), size);
+
+    return StagingSlice {
+        .buffer = m_buffer,
+        .offset = offset.value(),
+        .size = size,
+        .mappedData = static_cast<char*>(m_allocation.mappedData) + offset.value(),
+    };
+}
+
+void StagingRing::flush() {
+    m_allocator.flushDirtyRanges();
+}
+
+void StagingRing::retirePendingSlices(VkSemaphore timelineSemaphore, uint64_t timelineValue) {
+    if (m_pendingSliceCount == 0) {
+        return;
+    }
+
+    m_inFlightBatches.push_back(InFlightBatch { timelineSemaphore, timelineValue, m_head });
+    m_pendingSliceCount = 0;
+}
+
+void StagingRing::reclaim() {
+    while (!m_inFlightBatches.empty()) {
+        const auto& oldestBatch = m_inFlightBatches.front();
+        if (!this->isBatchComplete(oldestBatch)) {
+            break;
+        }
+
+        this->reclaimOldestBatch();
+    }
+}
+
+void StagingRing::waitIdle() {
+    while (!m_inFlightBatches.empty()) {
+        this->reclaimOldestBatch();
+    }
+}
+
+void StagingRing::dropInFlightBatches() {
+    if (m_inFlightBatches.empty()) {
+        return;
+    }
+
+    m_tail = m_inFlightBatches.back().end;
+    m_inFlightBatches.clear();
+}
+
+VkBuffer StagingRing::getBuffer() const {
+    return m_buffer;
+}
+
+VkDeviceSize StagingRing::getCapacity() const {
+    return m_capacity;
+}
+
+bool StagingRing::isEmpty() const {
+    return m_inFlightBatches.empty() && m_pendingSliceCount == 0;
+}
+
+std::optional<VkDeviceSize> StagingRing::tryAllocate(VkDeviceSize size, VkDeviceSize alignment) {
+    if (this->isEmpty()) {
+        m_head = 0;
+        m_tail = 0;
+    }
+
+    const auto alignedHead = (m_head + alignment - 1) & ~(alignment - 1);
+    if (this->isEmpty() || m_head > m_tail) {
+        // The live region is `[tail, head)`, so the free space is `[head, capacity)` followed
+        // by `[0, tail)` once we wrap around.
+        if (alignedHead + size <= m_capacity) {
+            m_head = alignedHead + size;
+
+            return alignedHead;
+        } else if (size < m_tail) {
+            m_head = size;
+
+            return 0;
+        }
+
+        return std::nullopt;
+    }
+
+    // The ring has wrapped around, so the free space is `[head, tail)`. The inequality is
+    // strict so that `head == tail` always means the ring is empty.
+    if (alignedHead + size < m_tail) {
+        m_head = alignedHead + size;
+
+        return alignedHead;
+    }
+
+    return std::nullopt;
+}
+
+bool StagingRing::isBatchComplete(const InFlightBatch& batch) const {
+    uint64_t completedValue = 0;
+    vkGetSemaphoreCounterValue(m_device, batch.timelineSemaphore, &completedValue);
+
+    return completedValue >= batch.timelineValue;
+}
+
+void StagingRing::reclaimOldestBatch() {
+    const auto oldestBatch = m_inFlightBatches.front();
+    if (!this->isBatchComplete(oldestBatch)) {
+        m_queueSubmitter.flush();
+    }
+
+    const auto waitInfo = VkSemaphoreWaitInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &oldestBatch.timelineSemaphore,
+        .pValues = &oldestBatch.timelineValue,
+    };
+    vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX);
+
+    m_inFlightBatches.pop_front();
+    m_tail = oldestBatch.end;
+}
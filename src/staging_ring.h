@@ -0,0 +1,100 @@
+#ifndef _STAGING_RING_H
+#define _STAGING_RING_H
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include "gpu_memory_allocator.h"
+#include "queue_submitter.h"
+
+
+namespace VulkanEngine {
+
+/// @brief A slice of the staging ring that the host can write upload data into.
+struct StagingSlice final {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mappedData = nullptr;
+};
+
+/// @brief A persistently mapped, host-visible ring buffer for staging uploads.
+///
+/// @note The ring lives in host cached memory where the device has it, which the host
+/// writes and decodes into faster than uncached memory. When that memory is not host
+/// coherent, every slice is queued as a dirty range as it is handed out, and `flush` makes
+/// them visible to the device with one call before the submit that copies from them.
+///
+/// Slices are handed out in allocation order. Every slice allocated since the
+/// previous call to `retirePendingSlices` is tied to the timeline semaphore value passed to
+/// that call, and the caller must signal that value with the submission that consumes the
+/// slices. Once the value is reached, the ring reclaims the slices. When the ring runs out
+/// of space it waits on the oldest in-flight value, so a caller only stalls when the GPU
+/// is more than one ring's worth of uploads behind. The submissions `queueSubmitter` holds
+/// back are flushed before any wait, since they may be the ones that signal it.
+class StagingRing final {
+    public:
+        static constexpr VkDeviceSize DEFAULT_CAPACITY = 64 * 1024 * 1024;
+        static constexpr VkDeviceSize DEFAULT_ALIGNMENT = 16;
+        static constexpr bool PREFER_CACHED_MEMORY = true;
+
+        explicit StagingRing() = delete;
+        explicit StagingRing(VkDevice device, GpuMemoryAllocator& allocator, QueueSubmitter& queueSubmitter, VkDeviceSize capacity);
+
+        ~StagingRing();
+
+        StagingSlice allocate(VkDeviceSize size, VkDeviceSize alignment = DEFAULT_ALIGNMENT);
+
+        /// @brief Flush the slices written since the last flush, where the ring's memory
+        /// is not host coherent.
+        void flush();
+
+        void retirePendingSlices(VkSemaphore timelineSemaphore, uint64_t timelineValue);
+
+        void reclaim();
+
+        void waitIdle();
+
+        /// @brief Forget the batches in flight without waiting on them, and free what they
+        /// staged.
+        ///
+        /// @note Only for batches that have finished, or that a lost device never runs,
+        /// right before their timeline semaphore is destroyed.
+        void dropInFlightBatches();
+
+        VkBuffer getBuffer() const;
+
+        VkDeviceSize getCapacity() const;
+    private:
+        struct InFlightBatch final {
+            VkSemaphore timelineSemaphore;
+            uint64_t timelineValue;
+            VkDeviceSize end;
+        };
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        QueueSubmitter& m_queueSubmitter;
+        VkBuffer m_buffer;
+        GpuAllocation m_allocation;
+        VkDeviceSize m_capacity;
+        VkDeviceSize m_head;
+        VkDeviceSize m_tail;
+        uint32_t m_pendingSliceCount;
+        std::deque<InFlightBatch> m_inFlightBatches;
+
+        bool isEmpty() const;
+
+        std::optional<VkDeviceSize> tryAllocate(VkDeviceSize size, VkDeviceSize alignment);
+
+        bool isBatchComplete(const InFlightBatch& batch) const;
+
+        void reclaimOldestBatch();
+};
+
+}
+
+#endif // _STAGING_RING_H
@@ -0,0 +1,101 @@
+#include "startup_timings.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+
+using StartupPhase = VulkanEngine::StartupPhase;
+using StartupTimings = VulkanEngine::StartupTimings;
+using StartupTimeline = VulkanEngine::StartupTimeline;
+
+static std::mutex g_phasesMutex;
+static std::vector<StartupPhase> g_phases;
+
+void StartupTimings::record(const std::string& name, double milliseconds) {
+    const auto lock = std::lock_guard<std::mutex> { g_phasesMutex };
+    g_phases.push_back(StartupPhase { .name = name, .milliseconds = milliseconds });
+}
+
+std::vector<StartupPhase> StartupTimings::getPhases() {
+    const auto lock = std::lock_guard<std::mutex> { g_phasesMutex };
+
+    return g_phases;
+}
+
+double StartupTimings::getTotalMilliseconds() {
+    const auto elapsed = std::chrono::steady_clock::now() - StartupTimings::getStartTime();
+
+    return std::chrono::duration<double, std::milli> { elapsed }.count();
+}
+
+void StartupTimings::printReport() {
+    auto phases = StartupTimings::getPhases();
+    std::stable_sort(phases.begin(), phases.end(), [](const StartupPhase& left, const StartupPhase& right) {
+        return left.milliseconds > right.milliseconds;
+    });
+
+    auto nameWidth = std::string::size_type { 5 };
+    for (const auto& phase : phases) {
+        nameWidth = std::max(nameWidth, phase.name.size());
+    }
+
+    const auto totalMilliseconds = StartupTimings::getTotalMilliseconds();
+    fmt::println("{:<{}}  {:>10}  {:>6}", "Phase", nameWidth, "ms", "%");
+    for (const auto& phase : phases) {
+        const auto share = totalMilliseconds > 0.0 ? 100.0 * phase.milliseconds / totalMilliseconds : 0.0;
+        fmt::println("{:<{}}  {:>10.3f}  {:>6.1f}", phase.name, nameWidth, phase.milliseconds, share);
+    }
+    fmt::println("{:<{}}  {:>10.3f}", "Total", nameWidth, totalMilliseconds);
+}
+
+void StartupTimings::writeJson(const std::filesystem::path& filePath) {
+    if (filePath.has_parent_path()) {
+        std::filesystem::create_directories(filePath.parent_path());
+    }
+
+    auto file = std::ofstream { filePath, std::ios::out | std::ios::trunc };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open startup timings file!");
+    }
+
+    const auto phases = StartupTimings::getPhases();
+    file << "{\n";
+    file << fmt::format("  \"totalMilliseconds\": {:.4f},\n", StartupTimings::getTotalMilliseconds());
+    file << "  \"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++) {
+        file << fmt::format(
+            "{}\n    {{ \"name\": \"{}\", \"milliseconds\": {:.4f} }}",
+            i == 0 ? "" : ",",
+            phases[i].name,
+            phases[i].milliseconds
+        );
+    }
+    file << "\n  ]\n}\n";
+}
+
+std::chrono::steady_clock::time_point StartupTimings::getStartTime() {
+    static const auto startTime = std::chrono::steady_clock::now();
+
+    return startTime;
+}
+
+StartupTimeline::StartupTimeline()
+    : m_phaseStartTime { std::chrono::steady_clock::now() }
+{
+    StartupTimings::getStartTime();
+}
+
+void StartupTimeline::mark(const std::string& name) {
+    const auto now = std::chrono::steady_clock::now();
+    StartupTimings::record(name, std::chrono::duration<double, std::milli> { now - m_phaseStartTime }.count());
+
+    m_phaseStartTime = now;
+}
+
+void StartupTimeline::skip() {
+    m_phaseStartTime = std::chrono::steady_clock::now();
+}
@@ -0,0 +1,68 @@
+#ifndef _STARTUP_TIMINGS_H
+#define _STARTUP_TIMINGS_H
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief A step of startup and the time it took.
+struct StartupPhase final {
+    std::string name;
+    double milliseconds;
+};
+
+/// @brief Collects the phases of startup that every `StartupTimeline` records.
+///
+/// @note Phases are kept in the order they were recorded, from any thread. GPU work that
+/// runs alongside startup can be recorded as a phase of its own, so phases may overlap,
+/// and the total is the wall time since the first timeline started rather than their sum.
+class StartupTimings final {
+    public:
+        explicit StartupTimings() = delete;
+
+        static void record(const std::string& name, double milliseconds);
+
+        static std::vector<StartupPhase> getPhases();
+
+        /// @brief The wall time since the first timeline started.
+        static double getTotalMilliseconds();
+
+        /// @brief Print the phases as a table, slowest first, with their share of the total.
+        static void printReport();
+
+        static void writeJson(const std::filesystem::path& filePath);
+    private:
+        friend class StartupTimeline;
+
+        static std::chrono::steady_clock::time_point getStartTime();
+};
+
+/// @brief Times a sequence of startup steps, each one from the end of the step before it.
+class StartupTimeline final {
+    public:
+        explicit StartupTimeline();
+
+        ~StartupTimeline() = default;
+
+        StartupTimeline(const StartupTimeline& other) = delete;
+        StartupTimeline& operator=(const StartupTimeline& other) = delete;
+
+        /// @brief Record the time since the last mark as the phase `name`, and start the next
+        /// phase.
+        void mark(const std::string& name);
+
+        /// @brief Start the next phase without recording the time since the last mark.
+        ///
+        /// @note This is for steps that time their own phases, so they are not counted twice.
+        void skip();
+    private:
+        std::chrono::steady_clock::time_point m_phaseStartTime;
+};
+
+}
+
+#endif // _STARTUP_TIMINGS_H
@@ -0,0 +1,115 @@
+#include "stress_scene.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/constants.hpp>
+
+#include "cpu_mipmap_generator.h"
+
+
+using StressSceneGenerator = VulkanEngine::StressSceneGenerator;
+using StressSceneOptions = VulkanEngine::StressSceneOptions;
+using StressInstance = VulkanEngine::StressInstance;
+using StressMaterial = VulkanEngine::StressMaterial;
+using StressFilter = VulkanEngine::StressFilter;
+using CpuMipmapGenerator = VulkanEngine::CpuMipmapGenerator;
+using CpuMipFilter = VulkanEngine::CpuMipFilter;
+using TextureCacheEntry = VulkanEngine::TextureCacheEntry;
+
+// The finalizer of MurmurHash3, which spreads neighboring indices over the whole range.
+static uint32_t hashIndex(uint32_t index) {
+    auto hash = index;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+static float hashToUnitFloat(uint32_t index) {
+    return static_cast<float>(hashIndex(index) >> 8) / static_cast<float>(1u << 24);
+}
+
+// A fully saturated color of `hue`, in turns.
+static glm::vec3 getHueColor(float hue) {
+    const auto channel = [hue](float offset) -> float {
+        const auto distance = std::abs(std::fmod(hue * 6.0f + offset, 6.0f) - 3.0f);
+
+        return std::clamp(distance - 1.0f, 0.0f, 1.0f);
+    };
+
+    return glm::vec3(channel(0.0f), channel(4.0f), channel(2.0f));
+}
+
+std::vector<StressInstance> StressSceneGenerator::generateInstances(const StressSceneOptions& options) {
+    const auto gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(options.meshCount))));
+    const auto gridOffset = 0.5f * static_cast<float>(gridSize - 1);
+
+    auto instances = std::vector<StressInstance> {};
+    instances.reserve(size_t { options.meshCount } * options.overdraw);
+    for (uint32_t spot = 0; spot < options.meshCount; spot++) {
+        const auto x = static_cast<float>(spot % gridSize) - gridOffset;
+        const auto y = static_cast<float>(spot / gridSize) - gridOffset;
+        const auto angle = glm::two_pi<float>() * hashToUnitFloat(spot);
+        const auto rotation = glm::angleAxis(angle, glm::vec3(0.0f, 0.0f, 1.0f));
+
+        // The outermost copy is drawn first and the innermost last, so front to back
+        // sorting is what keeps the inner layers from being shaded.
+        for (uint32_t layer = 0; layer < options.overdraw; layer++) {
+            const auto nesting = options.overdraw > 1 ? static_cast<float>(layer) / static_cast<float>(options.overdraw - 1) : 0.0f;
+            const auto scale = 1.0f - (1.0f - MIN_NESTED_SCALE) * nesting;
+            instances.push_back(StressInstance {
+                .translation = options.spacing * glm::vec3(x, y, 0.0f),
+                .rotation = rotation,
+                .scale = glm::vec3(scale),
+            });
+        }
+    }
+
+    return instances;
+}
+
+StressMaterial StressSceneGenerator::getMaterial(const StressSceneOptions& options, uint32_t material) {
+    const auto filterCount = static_cast<uint32_t>(StressFilter::Count);
+
+    return StressMaterial {
+        .texture = material % options.textureCount,
+        .filter = static_cast<StressFilter>(material / options.textureCount % filterCount),
+    };
+}
+
+TextureCacheEntry StressSceneGenerator::generateTexture(const StressSceneOptions& options, uint32_t texture) {
+    const auto size = options.textureSize;
+    const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(size))) + 1;
+    const auto pixels = StressSceneGenerator::generateTexturePixels(options, texture);
+
+    return CpuMipmapGenerator::generate(VK_FORMAT_R8G8B8A8_SRGB, pixels.data(), size, size, mipLevels, CpuMipFilter::Box);
+}
+
+std::vector<uint8_t> StressSceneGenerator::generateTexturePixels(const StressSceneOptions& options, uint32_t texture) {
+    const auto size = options.textureSize;
+    const auto squareSize = std::max(size / CHECKER_COUNT, 1u);
+
+    // Hues a golden ratio of a turn apart never repeat, and neighbors are far apart.
+    const auto hue = std::fmod(0.618034f * static_cast<float>(texture), 1.0f);
+    const auto lightColor = glm::u8vec3(255.0f * getHueColor(hue));
+    const auto darkColor = glm::u8vec3(64.0f * getHueColor(hue));
+
+    auto pixels = std::vector<uint8_t>(size_t { size } * size * 4);
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            const auto isLight = (x / squareSize + y / squareSize) % 2 == 0;
+            const auto color = isLight ? lightColor : darkColor;
+            auto* pixel = pixels.data() + (size_t { y } * size + x) * 4;
+            pixel[0] = color.r;
+            pixel[1] = color.g;
+            pixel[2] = color.b;
+            pixel[3] = 255;
+        }
+    }
+
+    return pixels;
+}
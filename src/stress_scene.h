@@ -0,0 +1,91 @@
+#ifndef _STRESS_SCENE_H
+#define _STRESS_SCENE_H
+
+#include <cstdint>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "texture_cache.h"
+
+
+namespace VulkanEngine {
+
+/// @brief The shape of a synthetic scene that scales the work of a frame along one axis at
+/// a time.
+struct StressSceneOptions final {
+    /// @brief The spots on a square grid around the origin that copies of the mesh stand on.
+    uint32_t meshCount = 1;
+    /// @brief How many copies of the mesh stand on every spot, nested inside one another, so
+    /// that about as many layers cover the pixels of a spot from any side.
+    uint32_t overdraw = 1;
+    /// @brief The distinct textures the materials sample.
+    uint32_t textureCount = 1;
+    /// @brief The texels a side of every texture, at its first level.
+    uint32_t textureSize = 256;
+    /// @brief The materials the copies take turns at. There are at least as many as
+    /// textures.
+    uint32_t materialCount = 1;
+    /// @brief The distance between neighboring spots on the grid.
+    float spacing = 2.5f;
+};
+
+/// @brief How a material of a stress scene filters its texture.
+enum class StressFilter {
+    Anisotropic,
+    Trilinear,
+    Nearest,
+    Count
+};
+
+/// @brief What a material of a stress scene samples, and how.
+struct StressMaterial final {
+    uint32_t texture;
+    StressFilter filter;
+};
+
+/// @brief The local transform of one copy of the mesh in a stress scene.
+struct StressInstance final {
+    glm::vec3 translation;
+    glm::quat rotation;
+    glm::vec3 scale;
+};
+
+/// @brief Generates the copies, materials and textures of a stress scene.
+///
+/// @note Everything is generated deterministically from the options, so two runs with the
+/// same options draw the same frames. Copy `i` takes material `i % materialCount`, which
+/// is how the vertex shaders pick it by instance index, and material `k` samples texture
+/// `k % textureCount` with the filter `k / textureCount` picks, so materials past the
+/// textures differ in their samplers only.
+class StressSceneGenerator final {
+    public:
+        /// @brief The checker squares a side of every texture.
+        static constexpr uint32_t CHECKER_COUNT = 8;
+        /// @brief The scale of the innermost copy on a spot, where overdraw is more than one.
+        static constexpr float MIN_NESTED_SCALE = 0.4f;
+
+        explicit StressSceneGenerator() = delete;
+
+        /// @brief The copies of the mesh, `options.overdraw` per spot, spot by spot, each
+        /// spot turned about the up axis by an angle of its own.
+        static std::vector<StressInstance> generateInstances(const StressSceneOptions& options);
+
+        static StressMaterial getMaterial(const StressSceneOptions& options, uint32_t material);
+
+        /// @brief An sRGB checker board in a hue of the texture's own, and its full mip
+        /// chain, laid out like a texture cache entry.
+        static TextureCacheEntry generateTexture(const StressSceneOptions& options, uint32_t texture);
+
+        /// @brief Level 0 of the texture `generateTexture` generates, as tightly packed sRGB
+        /// RGBA texels, for textures whose mips are generated on the GPU.
+        static std::vector<uint8_t> generateTexturePixels(const StressSceneOptions& options, uint32_t texture);
+};
+
+}
+
+#endif // _STRESS_SCENE_H
@@ -0,0 +1,121 @@
+#include "task_graph.h"
+
+#include <stdexcept>
+#include <thread>
+
+
+using TaskGraph = VulkanEngine::TaskGraph;
+using TaskId = VulkanEngine::TaskId;
+using TaskAffinity = VulkanEngine::TaskAffinity;
+
+TaskGraph::TaskGraph()
+    : m_nodes { std::vector<Node> {} }
+{
+}
+
+TaskId TaskGraph::addTask(
+    const std::string& name,
+    const std::vector<TaskId>& dependencies,
+    Task task,
+    TaskAffinity affinity
+) {
+    const auto taskId = static_cast<TaskId>(m_nodes.size());
+    for (const auto dependency : dependencies) {
+        if (dependency >= taskId) {
+            throw std::invalid_argument("a task can only depend on tasks added before it!");
+        }
+
+        m_nodes[dependency].dependents.push_back(taskId);
+    }
+
+    m_nodes.push_back(Node {
+        .name = name,
+        .task = std::move(task),
+        .affinity = affinity,
+        .dependencyCount = static_cast<uint32_t>(dependencies.size()),
+        .dependents = std::vector<TaskId> {},
+    });
+
+    return taskId;
+}
+
+void TaskGraph::run(uint32_t threadCount) {
+    auto state = RunState {};
+    state.pendingDependencyCounts.reserve(m_nodes.size());
+    for (const auto& node : m_nodes) {
+        state.pendingDependencyCounts.push_back(node.dependencyCount);
+    }
+
+    for (TaskId taskId = 0; taskId < m_nodes.size(); taskId++) {
+        if (m_nodes[taskId].dependencyCount == 0) {
+            this->pushReadyTask(state, taskId);
+        }
+    }
+
+    auto workers = std::vector<std::thread> {};
+    workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++) {
+        workers.emplace_back([this, &state]() { this->runTasks(state, false); });
+    }
+
+    this->runTasks(state, true);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (state.error) {
+        std::rethrow_exception(state.error);
+    }
+}
+
+void TaskGraph::runTasks(RunState& state, bool isCallingThread) {
+    auto lock = std::unique_lock<std::mutex> { state.mutex };
+    while (true) {
+        state.taskReady.wait(lock, [this, &state, isCallingThread]() {
+            const auto isDone = state.error || state.finishedCount == m_nodes.size();
+            const auto hasTask = !state.anyThreadTasks.empty() || (isCallingThread && !state.callingThreadTasks.empty());
+
+            return isDone || hasTask;
+        });
+        if (state.error || state.finishedCount == m_nodes.size()) {
+            return;
+        }
+
+        auto& tasks = isCallingThread && !state.callingThreadTasks.empty() ? state.callingThreadTasks : state.anyThreadTasks;
+        const auto taskId = tasks.front();
+        tasks.pop_front();
+        lock.unlock();
+
+        auto error = std::exception_ptr { nullptr };
+        try {
+            m_nodes[taskId].task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        if (error) {
+            if (!state.error) {
+                state.error = error;
+            }
+        } else {
+            state.finishedCount++;
+            for (const auto dependent : m_nodes[taskId].dependents) {
+                state.pendingDependencyCounts[dependent]--;
+                if (state.pendingDependencyCounts[dependent] == 0) {
+                    this->pushReadyTask(state, dependent);
+                }
+            }
+        }
+
+        state.taskReady.notify_all();
+    }
+}
+
+void TaskGraph::pushReadyTask(RunState& state, TaskId taskId) const {
+    if (m_nodes[taskId].affinity == TaskAffinity::CallingThread) {
+        state.callingThreadTasks.push_back(taskId);
+    } else {
+        state.anyThreadTasks.push_back(taskId);
+    }
+}
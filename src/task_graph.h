@@ -0,0 +1,84 @@
+#ifndef _TASK_GRAPH_H
+#define _TASK_GRAPH_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+namespace VulkanEngine {
+
+/// @brief Identifies a task added to a `TaskGraph`.
+using TaskId = uint32_t;
+
+/// @brief The threads a task of a `TaskGraph` may run on.
+enum class TaskAffinity {
+    /// @brief Any worker of the graph, or the thread that runs it.
+    AnyThread,
+    /// @brief Only the thread that runs the graph, for work like GLFW calls that has to
+    /// stay on the main thread.
+    CallingThread
+};
+
+/// @brief Runs a small graph of tasks on a pool of worker threads, each task once every
+/// task it depends on has finished.
+///
+/// @note A task can only depend on tasks added before it, so the graph never has a cycle.
+/// The calling thread works through the graph too, and is the only thread that runs the
+/// tasks tied to it. When a task throws, no further tasks start, the running ones finish,
+/// and `run` rethrows the first error.
+class TaskGraph final {
+    public:
+        using Task = std::function<void()>;
+
+        explicit TaskGraph();
+
+        ~TaskGraph() = default;
+
+        TaskGraph(const TaskGraph& other) = delete;
+        TaskGraph& operator=(const TaskGraph& other) = delete;
+
+        TaskId addTask(
+            const std::string& name,
+            const std::vector<TaskId>& dependencies,
+            Task task,
+            TaskAffinity affinity = TaskAffinity::AnyThread
+        );
+
+        /// @brief Run every task with up to `threadCount` workers besides the calling thread,
+        /// and return once all of them have finished.
+        void run(uint32_t threadCount);
+    private:
+        struct Node final {
+            std::string name;
+            Task task;
+            TaskAffinity affinity;
+            uint32_t dependencyCount;
+            std::vector<TaskId> dependents;
+        };
+
+        struct RunState final {
+            std::mutex mutex;
+            std::condition_variable taskReady;
+            std::deque<TaskId> anyThreadTasks;
+            std::deque<TaskId> callingThreadTasks;
+            std::vector<uint32_t> pendingDependencyCounts;
+            size_t finishedCount = 0;
+            std::exception_ptr error = nullptr;
+        };
+
+        std::vector<Node> m_nodes;
+
+        void runTasks(RunState& state, bool isCallingThread);
+
+        void pushReadyTask(RunState& state, TaskId taskId) const;
+};
+
+}
+
+#endif // _TASK_GRAPH_H
@@ -0,0 +1,508 @@
+#include "temporal_upscaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "command_counters.h"
+
+
+using TemporalUpscaler = VulkanEngine::TemporalUpscaler;
+using TemporalUpscaleFrame = VulkanEngine::TemporalUpscaleFrame;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+/// @brief Element `index` of the Halton sequence in base `base`, in [0, 1).
+static float getHaltonValue(uint64_t index, uint32_t base) {
+    auto fraction = 1.0f;
+    auto value = 0.0f;
+    while (index > 0) {
+        fraction /= static_cast<float>(base);
+        value += fraction * static_cast<float>(index % base);
+        index /= base;
+    }
+
+    return value;
+}
+
+TemporalUpscaler::TemporalUpscaler(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    VkPipelineCache pipelineCache,
+    VkShaderModule shaderModule,
+    VkImageView colorImageView,
+    VkImageView depthImageView,
+    VkExtent2D extent
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_extent { extent }
+    , m_descriptorSetLayout { VK_NULL_HANDLE }
+    , m_pipelineLayout { VK_NULL_HANDLE }
+    , m_pipeline { VK_NULL_HANDLE }
+    , m_sampler { VK_NULL_HANDLE }
+    , m_historyImages { VK_NULL_HANDLE, VK_NULL_HANDLE }
+    , m_historyAllocations {}
+    , m_historyImageViews { VK_NULL_HANDLE, VK_NULL_HANDLE }
+    , m_descriptorPool { VK_NULL_HANDLE }
+    , m_descriptorSets { VK_NULL_HANDLE, VK_NULL_HANDLE }
+    , m_outputIndex { 1 }
+    , m_hasHistory { false }
+{
+    if (extent.width == 0 || extent.height == 0) {
+        throw std::invalid_argument("temporal upscaler needs an extent that is not empty");
+    }
+
+    this->createDescriptorSetLayout();
+    this->createPipeline(pipelineCache, shaderModule);
+    this->createSampler();
+    this->createHistoryImages();
+    this->createDescriptorSets(colorImageView, depthImageView);
+}
+
+TemporalUpscaler::~TemporalUpscaler() {
+    vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+
+    for (size_t i = 0; i < m_historyImages.size(); i++) {
+        vkDestroyImageView(m_device, m_historyImageViews[i], nullptr);
+        vkDestroyImage(m_device, m_historyImages[i], nullptr);
+        m_allocator.free(m_historyAllocations[i]);
+    }
+
+    vkDestroySampler(m_device, m_sampler, nullptr);
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+
+    m_descriptorPool = VK_NULL_HANDLE;
+    m_descriptorSets = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+    m_historyImageViews = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+    m_historyImages = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+    m_sampler = VK_NULL_HANDLE;
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipelineLayout = VK_NULL_HANDLE;
+    m_descriptorSetLayout = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+std::array<float, 2> TemporalUpscaler::getJitter(uint64_t frameIndex, float scale) {
+    const auto upscale = 1.0f / std::max(scale, 0.01f);
+    const auto phaseCount = static_cast<uint64_t>(std::ceil(static_cast<float>(BASE_JITTER_PHASE_COUNT) * upscale * upscale));
+    // The sequence starts at 1, since its first element sits on the corner of the pixel.
+    const auto index = frameIndex % phaseCount + 1;
+
+    return { getHaltonValue(index, 2) - 0.5f, getHaltonValue(index, 3) - 0.5f };
+}
+
+void TemporalUpscaler::recordInitialization(VkCommandBuffer commandBuffer) const {
+    const auto subresourceRange = VkImageSubresourceRange {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = 0,
+        .levelCount = 1,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+
+    auto clearBarriers = std::vector<VkImageMemoryBarrier> {};
+    auto readBarriers = std::vector<VkImageMemoryBarrier> {};
+    for (const auto image : m_historyImages) {
+        clearBarriers.push_back(VkImageMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = image,
+            .subresourceRange = subresourceRange,
+        });
+        readBarriers.push_back(VkImageMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = image,
+            .subresourceRange = subresourceRange,
+        });
+    }
+
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        static_cast<uint32_t>(clearBarriers.size()), clearBarriers.data()
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    const auto clearColor = VkClearColorValue { .float32 = { 0.0f, 0.0f, 0.0f, 1.0f } };
+    for (const auto image : m_historyImages) {
+        vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &subresourceRange);
+    }
+
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        static_cast<uint32_t>(readBarriers.size()), readBarriers.data()
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+}
+
+void TemporalUpscaler::record(VkCommandBuffer commandBuffer, const TemporalUpscaleFrame& frame) {
+    m_outputIndex = 1 - m_outputIndex;
+
+    // The frame before wrote the history this one reads, and the frame before that blitted
+    // from the one this one writes.
+    const auto historyBarrier = VkMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &historyBarrier,
+        0, nullptr,
+        0, nullptr
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    CommandCounters::add(CommandCounter::PipelineBinds);
+    vkCmdBindDescriptorSets(
+        commandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        m_pipelineLayout,
+        0,
+        1,
+        &m_descriptorSets[m_outputIndex],
+        0,
+        nullptr
+    );
+    CommandCounters::add(CommandCounter::DescriptorBinds);
+
+    const auto pushConstants = PushConstants {
+        .reprojection = frame.reprojection,
+        .jitterX = frame.jitterX,
+        .jitterY = frame.jitterY,
+        .renderWidth = std::min(frame.renderExtent.width, m_extent.width),
+        .renderHeight = std::min(frame.renderExtent.height, m_extent.height),
+        .outputWidth = m_extent.width,
+        .outputHeight = m_extent.height,
+        .hasHistory = m_hasHistory ? 1u : 0u,
+    };
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+
+    const auto workGroupCountX = (m_extent.width + THREAD_COUNT - 1) / THREAD_COUNT;
+    const auto workGroupCountY = (m_extent.height + THREAD_COUNT - 1) / THREAD_COUNT;
+    vkCmdDispatch(commandBuffer, workGroupCountX, workGroupCountY, 1);
+    CommandCounters::add(CommandCounter::Dispatches);
+
+    const auto outputBarrier = VkMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1, &outputBarrier,
+        0, nullptr,
+        0, nullptr
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    m_hasHistory = true;
+}
+
+VkImage TemporalUpscaler::getOutputImage() const {
+    return m_historyImages[m_outputIndex];
+}
+
+uint32_t TemporalUpscaler::getOutputIndex() const {
+    return m_outputIndex;
+}
+
+bool TemporalUpscaler::hasHistory() const {
+    return m_hasHistory;
+}
+
+std::span<const VkImageView> TemporalUpscaler::getHistoryImageViews() const {
+    return m_historyImageViews;
+}
+
+VkExtent2D TemporalUpscaler::getExtent() const {
+    return m_extent;
+}
+
+void TemporalUpscaler::createDescriptorSetLayout() {
+    const auto createBinding = [](uint32_t binding, VkDescriptorType descriptorType) -> VkDescriptorSetLayoutBinding {
+        return VkDescriptorSetLayoutBinding {
+            .binding = binding,
+            .descriptorType = descriptorType,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        };
+    };
+    const auto bindings = std::array<VkDescriptorSetLayoutBinding, 5> {
+        createBinding(0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE),
+        createBinding(1, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE),
+        createBinding(2, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE),
+        createBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
+        createBinding(4, VK_DESCRIPTOR_TYPE_SAMPLER),
+    };
+    const auto layoutInfo = VkDescriptorSetLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+
+    auto descriptorSetLayout = VkDescriptorSetLayout {};
+    const auto result = vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &descriptorSetLayout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create temporal upscaler descriptor set layout!");
+    }
+
+    m_descriptorSetLayout = descriptorSetLayout;
+}
+
+void TemporalUpscaler::createPipeline(VkPipelineCache pipelineCache, VkShaderModule shaderModule) {
+    const auto pushConstantRange = VkPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_descriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+
+    auto pipelineLayout = VkPipelineLayout {};
+    const auto resultCreatePipelineLayout = vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    if (resultCreatePipelineLayout != VK_SUCCESS) {
+        throw std::runtime_error("failed to create temporal upscaler pipeline layout!");
+    }
+
+    const auto pipelineInfo = VkComputePipelineCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shaderModule,
+            .pName = "main",
+        },
+        .layout = pipelineLayout,
+    };
+
+    auto pipeline = VkPipeline {};
+    const auto resultCreatePipeline = vkCreateComputePipelines(m_device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    if (resultCreatePipeline != VK_SUCCESS) {
+        vkDestroyPipelineLayout(m_device, pipelineLayout, nullptr);
+
+        throw std::runtime_error("failed to create temporal upscaler pipeline!");
+    }
+
+    m_pipelineLayout = pipelineLayout;
+    m_pipeline = pipeline;
+}
+
+void TemporalUpscaler::createSampler() {
+    // The color of the frame and the history are both sampled between texels, and never
+    // past their edges.
+    const auto samplerInfo = VkSamplerCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .mipLodBias = 0.0f,
+        .anisotropyEnable = VK_FALSE,
+        .maxAnisotropy = 1.0f,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .minLod = 0.0f,
+        .maxLod = 0.0f,
+        .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+
+    auto sampler = VkSampler {};
+    const auto result = vkCreateSampler(m_device, &samplerInfo, nullptr, &sampler);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create temporal upscaler sampler!");
+    }
+
+    m_sampler = sampler;
+}
+
+void TemporalUpscaler::createHistoryImages() {
+    for (size_t i = 0; i < m_historyImages.size(); i++) {
+        const auto imageInfo = VkImageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = HISTORY_FORMAT,
+            .extent = VkExtent3D { m_extent.width, m_extent.height, 1 },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+
+        auto image = VkImage {};
+        const auto resultCreateImage = vkCreateImage(m_device, &imageInfo, nullptr, &image);
+        if (resultCreateImage != VK_SUCCESS) {
+            throw std::runtime_error("failed to create temporal upscaler history image!");
+        }
+
+        auto memRequirements = VkMemoryRequirements {};
+        vkGetImageMemoryRequirements(m_device, image, &memRequirements);
+
+        const auto allocation = m_allocator.allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Optimal, GpuMemoryCategory::Attachment);
+
+        vkBindImageMemory(m_device, image, allocation.memory, allocation.offset);
+
+        const auto viewInfo = VkImageViewCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = HISTORY_FORMAT,
+            .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .subresourceRange.baseMipLevel = 0,
+            .subresourceRange.levelCount = 1,
+            .subresourceRange.baseArrayLayer = 0,
+            .subresourceRange.layerCount = 1,
+        };
+
+        auto imageView = VkImageView {};
+        const auto resultCreateImageView = vkCreateImageView(m_device, &viewInfo, nullptr, &imageView);
+        if (resultCreateImageView != VK_SUCCESS) {
+            throw std::runtime_error("failed to create temporal upscaler history image view!");
+        }
+
+        m_historyImages[i] = image;
+        m_historyAllocations[i] = allocation;
+        m_historyImageViews[i] = imageView;
+    }
+}
+
+void TemporalUpscaler::createDescriptorSets(VkImageView colorImageView, VkImageView depthImageView) {
+    const auto setCount = static_cast<uint32_t>(m_descriptorSets.size());
+    const auto poolSizes = std::array<VkDescriptorPoolSize, 3> {
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 3 * setCount,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = setCount,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLER,
+            .descriptorCount = setCount,
+        },
+    };
+    const auto poolInfo = VkDescriptorPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = 0,
+        .maxSets = setCount,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+    };
+
+    auto descriptorPool = VkDescriptorPool {};
+    const auto resultCreateDescriptorPool = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &descriptorPool);
+    if (resultCreateDescriptorPool != VK_SUCCESS) {
+        throw std::runtime_error("failed to create temporal upscaler descriptor pool!");
+    }
+
+    m_descriptorPool = descriptorPool;
+
+    const auto setLayouts = std::array<VkDescriptorSetLayout, 2> { m_descriptorSetLayout, m_descriptorSetLayout };
+    const auto allocInfo = VkDescriptorSetAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_descriptorPool,
+        .descriptorSetCount = setCount,
+        .pSetLayouts = setLayouts.data(),
+    };
+
+    auto descriptorSets = std::array<VkDescriptorSet, 2> {};
+    const auto resultAllocateDescriptorSets = vkAllocateDescriptorSets(m_device, &allocInfo, descriptorSets.data());
+    if (resultAllocateDescriptorSets != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate temporal upscaler descriptor sets!");
+    }
+
+    const auto colorInfo = VkDescriptorImageInfo {
+        .sampler = VK_NULL_HANDLE,
+        .imageView = colorImageView,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+    const auto depthInfo = VkDescriptorImageInfo {
+        .sampler = VK_NULL_HANDLE,
+        .imageView = depthImageView,
+        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+    };
+    const auto samplerInfo = VkDescriptorImageInfo {
+        .sampler = m_sampler,
+        .imageView = VK_NULL_HANDLE,
+        .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    // Set `i` writes history `i`, and reads the other one.
+    auto historyInfos = std::array<VkDescriptorImageInfo, 2> {};
+    auto outputInfos = std::array<VkDescriptorImageInfo, 2> {};
+    auto descriptorWrites = std::vector<VkWriteDescriptorSet> {};
+    descriptorWrites.reserve(5 * setCount);
+    for (uint32_t i = 0; i < setCount; i++) {
+        historyInfos[i] = VkDescriptorImageInfo {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = m_historyImageViews[1 - i],
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        };
+        outputInfos[i] = VkDescriptorImageInfo {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = m_historyImageViews[i],
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        };
+
+        const auto createWrite = [&descriptorSets, i](uint32_t binding, VkDescriptorType descriptorType, const VkDescriptorImageInfo* imageInfo) -> VkWriteDescriptorSet {
+            return VkWriteDescriptorSet {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptorSets[i],
+                .dstBinding = binding,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = descriptorType,
+                .pImageInfo = imageInfo,
+            };
+        };
+        descriptorWrites.push_back(createWrite(0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, &colorInfo));
+        descriptorWrites.push_back(createWrite(1, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, &depthInfo));
+        descriptorWrites.push_back(createWrite(2, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, &historyInfos[i]));
+        descriptorWrites.push_back(createWrite(3, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, &outputInfos[i]));
+        descriptorWrites.push_back(createWrite(4, VK_DESCRIPTOR_TYPE_SAMPLER, &samplerInfo));
+    }
+    vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+    m_descriptorSets = descriptorSets;
+}
@@ -0,0 +1,147 @@
+#ifndef _TEMPORAL_UPSCALER_H
+#define _TEMPORAL_UPSCALER_H
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief What the upscale of one frame needs to know about how it was rendered.
+///
+/// @note `reprojection` maps the clip space of the frame, without its jitter, to the clip
+/// space of the frame before, as a column major matrix. It is the view projection of the
+/// frame before times the inverse of the frame's own, so it covers camera motion only,
+/// which is all the motion there is in a scene that does not move.
+struct TemporalUpscaleFrame final {
+    std::array<float, 16> reprojection;
+    /// @brief The offset of the frame's projection in rendered pixels.
+    float jitterX = 0.0f;
+    float jitterY = 0.0f;
+    /// @brief The extent the frame was rendered at, in the top left corner of its images.
+    VkExtent2D renderExtent;
+};
+
+/// @brief Upscales a jittered frame rendered below the output resolution into an output
+/// sized history, which builds up detail over frames, with a compute shader.
+///
+/// @note Every output texel samples the color of the frame at its unjittered position, and
+/// reprojects itself into the frame before with the depth under it to sample the history
+/// there. The history is clamped to the colors around the texel in the frame, to
+/// reject what the camera motion does not explain, and blended with `FEEDBACK` of the new
+/// color. Texels that reproject off screen, and the first frame, take the new color alone.
+///
+/// There are two histories, and every frame reads the one the frame before wrote and
+/// writes the other, so they are recorded one frame after the other. The histories are
+/// `HISTORY_FORMAT` images as big as the color and depth images, and live in
+/// `VK_IMAGE_LAYOUT_GENERAL`. The color of the frame has to be sampled in
+/// `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL`, and its depth in
+/// `VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL`, both single sampled.
+class TemporalUpscaler final {
+    public:
+        /// @brief The width and height of the workgroups of the upscale shader.
+        static constexpr uint32_t THREAD_COUNT = 8;
+        static constexpr VkFormat HISTORY_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+        /// @brief The weight of the new color against the history, as `FEEDBACK` in the
+        /// upscale shader.
+        static constexpr float FEEDBACK = 0.1f;
+        /// @brief The jitter phases at native resolution, which grow with the square of the
+        /// upscale, so that every output pixel is covered as densely.
+        static constexpr uint32_t BASE_JITTER_PHASE_COUNT = 8;
+
+        explicit TemporalUpscaler() = delete;
+        /// @note `shaderModule` stays the caller's, and only has to live until the
+        /// constructor returns.
+        explicit TemporalUpscaler(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            VkPipelineCache pipelineCache,
+            VkShaderModule shaderModule,
+            VkImageView colorImageView,
+            VkImageView depthImageView,
+            VkExtent2D extent
+        );
+
+        ~TemporalUpscaler();
+
+        TemporalUpscaler(const TemporalUpscaler& other) = delete;
+        TemporalUpscaler& operator=(const TemporalUpscaler& other) = delete;
+
+        /// @brief The jitter of frame `frameIndex` in rendered pixels, from the Halton
+        /// sequence in bases 2 and 3, for frames rendered at `scale` of the output extent.
+        static std::array<float, 2> getJitter(uint64_t frameIndex, float scale);
+
+        /// @brief Record clearing the histories, and moving them into their layout.
+        void recordInitialization(VkCommandBuffer commandBuffer) const;
+
+        /// @brief Record upscaling `frame` into the next history.
+        ///
+        /// @note Must be recorded outside of a render pass. The barriers that order the
+        /// history writes of the frame before, and the blits from more than a frame back,
+        /// before the upscale are recorded here, and so is the one that makes the output
+        /// ready to blit from. The ones that order the color and depth writes before it are
+        /// left to the caller.
+        void record(VkCommandBuffer commandBuffer, const TemporalUpscaleFrame& frame);
+
+        /// @brief The history the last recorded upscale writes, in `VK_IMAGE_LAYOUT_GENERAL`.
+        VkImage getOutputImage() const;
+
+        /// @brief The index of the history the last recorded upscale writes, into
+        /// `getHistoryImageViews`.
+        uint32_t getOutputIndex() const;
+
+        /// @brief Whether an upscale has been recorded since the histories were cleared, so
+        /// that the last output holds a frame.
+        bool hasHistory() const;
+
+        /// @brief The views of both histories, for passes that sample the last output.
+        std::span<const VkImageView> getHistoryImageViews() const;
+
+        VkExtent2D getExtent() const;
+    private:
+        struct PushConstants final {
+            std::array<float, 16> reprojection;
+            float jitterX;
+            float jitterY;
+            uint32_t renderWidth;
+            uint32_t renderHeight;
+            uint32_t outputWidth;
+            uint32_t outputHeight;
+            uint32_t hasHistory;
+        };
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkExtent2D m_extent;
+        VkDescriptorSetLayout m_descriptorSetLayout;
+        VkPipelineLayout m_pipelineLayout;
+        VkPipeline m_pipeline;
+        VkSampler m_sampler;
+        std::array<VkImage, 2> m_historyImages;
+        std::array<GpuAllocation, 2> m_historyAllocations;
+        std::array<VkImageView, 2> m_historyImageViews;
+        VkDescriptorPool m_descriptorPool;
+        /// @brief One set for writing each history, reading the other.
+        std::array<VkDescriptorSet, 2> m_descriptorSets;
+        uint32_t m_outputIndex;
+        bool m_hasHistory;
+
+        void createDescriptorSetLayout();
+
+        void createPipeline(VkPipelineCache pipelineCache, VkShaderModule shaderModule);
+
+        void createSampler();
+
+        void createHistoryImages();
+
+        void createDescriptorSets(VkImageView colorImageView, VkImageView depthImageView);
+};
+
+}
+
+#endif // _TEMPORAL_UPSCALER_H
@@ -0,0 +1,806 @@
+#include <vulkan/vulkan.h>
+
+#include "engine.h"
+#include "ktx2_writer.h"
+#include "texture_cache.h"
+#include "texture_format.h"
+#include "texture_packer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+
+#include <stb/stb_image.h>
+
+#include <compile_hlsl_shaders/shaders_hlsl.h>
+
+
+using Engine = VulkanEngine::Engine;
+using EngineMode = VulkanEngine::EngineMode;
+using DeviceSelection = VulkanEngine::DeviceSelection;
+using UploadBatch = VulkanEngine::UploadBatch;
+using GpuAllocation = VulkanEngine::GpuAllocation;
+using MipmapTarget = VulkanEngine::MipmapTarget;
+using MipFilter = VulkanEngine::MipFilter;
+using CompressionTarget = VulkanEngine::CompressionTarget;
+using TextureCache = VulkanEngine::TextureCache;
+using TextureCacheEntry = VulkanEngine::TextureCacheEntry;
+using TextureCacheLevel = VulkanEngine::TextureCacheLevel;
+using TextureFormats = VulkanEngine::TextureFormats;
+using StagingRing = VulkanEngine::StagingRing;
+using Ktx2Writer = VulkanEngine::Ktx2Writer;
+using TexturePacker = VulkanEngine::TexturePacker;
+using TexturePackerSettings = VulkanEngine::TexturePackerSettings;
+using TexturePackTable = VulkanEngine::TexturePackTable;
+using TexturePage = VulkanEngine::TexturePage;
+using TexturePlacement = VulkanEngine::TexturePlacement;
+using PackedTextureSource = VulkanEngine::PackedTextureSource;
+using HlslShader = shaders_hlsl::HlslShader;
+
+// The source images baked, by extension. They are decoded to 8-bit RGBA, the way the demo
+// decodes them, and baked next to the source as a KTX2 file, which the demo then loads
+// ahead of the source without decoding it or generating its mips.
+const auto SOURCE_EXTENSIONS = std::vector<std::string> { ".png", ".jpg", ".jpeg" };
+const auto TEXTURE_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+// The filter of the compute mip generator, the same one the demo generates its mips with.
+const auto MIP_FILTER = MipFilter::Kaiser;
+const float MIP_ALPHA_CUTOFF = 0.0f;
+
+// The textures one lane decodes at once, each on a thread of its own, and records into one
+// upload batch. A batch is cut short once its textures fill this much of the staging ring.
+const size_t BATCH_TEXTURE_COUNT = 8;
+const VkDeviceSize BATCH_STAGING_SIZE = StagingRing::DEFAULT_CAPACITY / 2;
+
+// With `--pack`, the textures of up to this many texels a side are packed into the layers
+// of 2D array pages of this many layers at most, which every device supports, instead of
+// being baked one by one. The pages are written under the output root, the input
+// directory without `--output`, as `PACK_PAGE_PREFIX<page>.ktx2`, with the table of where
+// every texture landed in `PACK_TABLE_FILE`, for `meshbake --pack-table`. A page is staged
+// and read back whole, so its level 0 has to fit in the staging share of a batch.
+const uint32_t PACK_MAX_EXTENT = 256;
+const uint32_t PACK_MAX_LAYER_COUNT = 64;
+const auto PACK_PAGE_PREFIX = std::string { "texture_page_" };
+const auto PACK_TABLE_FILE = std::string { "texture_pack.json" };
+
+const auto DEFAULT_ENGINE_MODE = ENABLE_VALIDATION_LAYERS ? EngineMode::Debug : EngineMode::Release;
+
+struct TexbakeOptions final {
+    std::filesystem::path inputDirectory;
+    /// @brief Where to write the baked textures, under the same relative paths as their
+    /// sources, or nothing to write each one next to its source.
+    std::optional<std::filesystem::path> outputDirectory;
+    /// @brief Whether to encode the mip chains with the GPU texture compressor.
+    bool compress = false;
+    /// @brief The number of devices to bake on, each one in a lane of its own.
+    uint32_t gpuCount = 1;
+    /// @brief Whether to bake textures whose KTX2 file is newer than the source too.
+    bool force = false;
+    /// @brief Whether to pack the small textures into the layers of array pages.
+    bool pack = false;
+    EngineMode engineMode = DEFAULT_ENGINE_MODE;
+};
+
+struct BakeJob final {
+    std::filesystem::path sourcePath;
+    std::filesystem::path outputPath;
+};
+
+/// @brief A page of packed textures, baked from the sources of its layers in one go.
+///
+/// @note `sources` are the extents the headers of the sources gave when the page was
+/// planned, which the decoded images have to match.
+struct PageJob final {
+    TexturePage page;
+    std::vector<const BakeJob*> layerJobs;
+    std::vector<PackedTextureSource> sources;
+    std::vector<TexturePlacement> placements;
+    std::filesystem::path outputPath;
+};
+
+/// @brief The jobs that are baked one by one, and the pages the rest are packed into.
+struct BakePlan final {
+    std::vector<BakeJob> textureJobs;
+    std::vector<PageJob> pageJobs;
+};
+
+struct DecodedTexture final {
+    const BakeJob* job;
+    uint32_t width;
+    uint32_t height;
+    /// @brief The channels the file stores, which tell whether its alpha is real.
+    int channelCount;
+    std::unique_ptr<stbi_uc, decltype(&stbi_image_free)> pixels;
+};
+
+/// @brief A texture recorded into an upload batch, whose mip chain lands in the readback
+/// buffer once the batch completes.
+struct PendingTexture final {
+    const BakeJob* job;
+    TextureCacheEntry mipChain;
+    VkImage image;
+    GpuAllocation imageAllocation;
+    VkBuffer readbackBuffer;
+    GpuAllocation readbackAllocation;
+};
+
+/// @brief What the lanes did, shared between all of them.
+struct BakeProgress final {
+    std::atomic<size_t> nextJob { 0 };
+    std::atomic<size_t> nextPage { 0 };
+    std::atomic<uint32_t> bakedPageCount { 0 };
+    std::atomic<uint32_t> bakedCount { 0 };
+    std::atomic<uint32_t> failedCount { 0 };
+    std::mutex outputMutex;
+};
+
+/// @brief Read `<input directory>`, `--output <directory>`, `--compress`, `--gpus <count>`,
+/// `--force`, `--pack` and `--engine-mode <release, debug or gpu-assisted>` off the command
+/// line.
+///
+/// @note The engine mode on the command line overrides the one `VULKAN_ENGINE_MODE` names.
+static TexbakeOptions parseTexbakeOptions(int argc, char* argv[]) {
+    auto options = TexbakeOptions {};
+    options.engineMode = Engine::getEngineModeFromEnvironment(DEFAULT_ENGINE_MODE);
+    auto hasInputDirectory = false;
+    for (int i = 1; i < argc; i++) {
+        const auto argument = std::string { argv[i] };
+        if (argument == "--output" && i + 1 < argc) {
+            options.outputDirectory = std::filesystem::path { argv[++i] };
+        } else if (argument == "--compress") {
+            options.compress = true;
+        } else if (argument == "--gpus" && i + 1 < argc) {
+            options.gpuCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (argument == "--force") {
+            options.force = true;
+        } else if (argument == "--pack") {
+            options.pack = true;
+        } else if (argument == "--engine-mode" && i + 1 < argc) {
+            options.engineMode = Engine::parseEngineMode(std::string { argv[++i] });
+        } else if (!argument.starts_with("--") && !hasInputDirectory) {
+            options.inputDirectory = std::filesystem::path { argument };
+            hasInputDirectory = true;
+        } else {
+            throw std::invalid_argument(fmt::format("unknown command line argument: {}", argument));
+        }
+    }
+
+    if (!hasInputDirectory) {
+        throw std::invalid_argument("usage: texbake <input directory> [--output <directory>] [--compress] [--gpus <count>] [--force] [--pack]");
+    }
+
+    if (!std::filesystem::is_directory(options.inputDirectory)) {
+        throw std::invalid_argument(fmt::format("not a directory: {}", options.inputDirectory.string()));
+    }
+
+    if (options.gpuCount == 0) {
+        throw std::invalid_argument("--gpus needs a device count of at least one");
+    }
+
+    return options;
+}
+
+static bool isSourceImage(const std::filesystem::path& filePath) {
+    auto extension = filePath.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char character) {
+        return static_cast<char>(std::tolower(character));
+    });
+
+    return std::find(SOURCE_EXTENSIONS.begin(), SOURCE_EXTENSIONS.end(), extension) != SOURCE_EXTENSIONS.end();
+}
+
+/// @brief The source images under the input directory that need baking, in path order.
+///
+/// @note A texture whose KTX2 file is newer than its source is skipped, unless the bake
+/// is forced, so rerunning the bake over a tree only bakes what changed. A packed bake
+/// takes every texture, since any of them may move every other one on its page.
+static std::vector<BakeJob> findBakeJobs(const TexbakeOptions& options, uint32_t& skippedCount) {
+    auto jobs = std::vector<BakeJob> {};
+    for (const auto& entry : std::filesystem::recursive_directory_iterator { options.inputDirectory }) {
+        if (!entry.is_regular_file() || !isSourceImage(entry.path())) {
+            continue;
+        }
+
+        auto outputPath = entry.path();
+        if (options.outputDirectory) {
+            outputPath = *options.outputDirectory / std::filesystem::relative(entry.path(), options.inputDirectory);
+        }
+        outputPath.replace_extension(".ktx2");
+
+        auto errorCode = std::error_code {};
+        const auto outputTime = std::filesystem::last_write_time(outputPath, errorCode);
+        if (!options.force && !options.pack && !errorCode && outputTime >= entry.last_write_time()) {
+            skippedCount++;
+            continue;
+        }
+
+        jobs.push_back(BakeJob {
+            .sourcePath = entry.path(),
+            .outputPath = outputPath,
+        });
+    }
+
+    std::sort(jobs.begin(), jobs.end(), [](const BakeJob& lhs, const BakeJob& rhs) {
+        return lhs.sourcePath < rhs.sourcePath;
+    });
+
+    return jobs;
+}
+
+static DecodedTexture decodeTexture(const BakeJob& job) {
+    int width = 0;
+    int height = 0;
+    int channelCount = 0;
+    auto* pixels = stbi_load(job.sourcePath.string().c_str(), &width, &height, &channelCount, STBI_rgb_alpha);
+    if (pixels == nullptr) {
+        throw std::runtime_error(fmt::format("failed to decode texture: {}", stbi_failure_reason()));
+    }
+
+    return DecodedTexture {
+        .job = &job,
+        .width = static_cast<uint32_t>(width),
+        .height = static_cast<uint32_t>(height),
+        .channelCount = channelCount,
+        .pixels = { pixels, stbi_image_free },
+    };
+}
+
+/// @brief Split the jobs into the textures baked one by one and the pages that the small
+/// ones are packed into, by the extents in the headers of their sources.
+///
+/// @note Only the headers are read here. A source whose header cannot be read is baked on
+/// its own, which reports why it fails.
+static BakePlan planBake(const TexbakeOptions& options, const std::vector<BakeJob>& jobs) {
+    if (!options.pack) {
+        return BakePlan { .textureJobs = jobs, .pageJobs = {} };
+    }
+
+    auto sources = std::vector<PackedTextureSource>(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        int width = 0;
+        int height = 0;
+        int channelCount = 0;
+        if (stbi_info(jobs[i].sourcePath.string().c_str(), &width, &height, &channelCount) != 0) {
+            sources[i] = PackedTextureSource {
+                .format = TEXTURE_FORMAT,
+                .width = static_cast<uint32_t>(width),
+                .height = static_cast<uint32_t>(height),
+            };
+        }
+    }
+
+    const auto settings = TexturePackerSettings {
+        .maxExtent = PACK_MAX_EXTENT,
+        .maxLayerCount = PACK_MAX_LAYER_COUNT,
+    };
+    const auto packing = TexturePacker::pack(sources, settings);
+    const auto outputRoot = options.outputDirectory.value_or(options.inputDirectory);
+    auto plan = BakePlan {};
+    for (size_t i = 0; i < packing.pages.size(); i++) {
+        const auto& page = packing.pages[i];
+        plan.pageJobs.push_back(PageJob {
+            .page = page,
+            .layerJobs = std::vector<const BakeJob*>(page.layerCount, nullptr),
+            .sources = std::vector<PackedTextureSource>(page.layerCount),
+            .placements = std::vector<TexturePlacement>(page.layerCount),
+            .outputPath = outputRoot / fmt::format("{}{}.ktx2", PACK_PAGE_PREFIX, i),
+        });
+    }
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const auto& placement = packing.placements[i];
+        if (!placement.has_value()) {
+            plan.textureJobs.push_back(jobs[i]);
+            continue;
+        }
+
+        auto& pageJob = plan.pageJobs[placement->page];
+        pageJob.layerJobs[placement->layer] = &jobs[i];
+        pageJob.sources[placement->layer] = sources[i];
+        pageJob.placements[placement->layer] = *placement;
+    }
+
+    return plan;
+}
+
+static std::vector<VkBufferImageCopy> createMipLevelCopyRegions(const std::vector<TextureCacheLevel>& levels, uint32_t layerCount = 1) {
+    auto copyRegions = std::vector<VkBufferImageCopy> {};
+    copyRegions.reserve(levels.size());
+    for (uint32_t i = 0; i < levels.size(); i++) {
+        copyRegions.push_back(VkBufferImageCopy {
+            .bufferOffset = levels[i].offset,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .imageSubresource.mipLevel = i,
+            .imageSubresource.baseArrayLayer = 0,
+            .imageSubresource.layerCount = layerCount,
+            .imageOffset = VkOffset3D { 0, 0, 0 },
+            .imageExtent = VkExtent3D { levels[i].width, levels[i].height, 1 },
+        });
+    }
+
+    return copyRegions;
+}
+
+/// @brief Record the upload, mip generation and, where asked for, compression of `textures`
+/// into one batch, with the finished chains copied into readback buffers.
+///
+/// @note The mips of every texture of the batch are generated together, so their barriers
+/// merge into one per level.
+static std::vector<PendingTexture> recordBatch(Engine& engine, UploadBatch& uploadBatch, std::span<const DecodedTexture> textures, bool compress) {
+    const auto& uploadContext = engine.getUploadContext();
+    const auto formatInfo = *TextureFormats::getInfo(TEXTURE_FORMAT);
+    auto pendingTextures = std::vector<PendingTexture> {};
+    auto mipmapTargets = std::vector<MipmapTarget> {};
+    for (const auto& texture : textures) {
+        const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texture.width, texture.height)))) + 1;
+        const auto [image, imageAllocation] = engine.createImage(
+            texture.width,
+            texture.height,
+            mipLevels,
+            VK_SAMPLE_COUNT_1_BIT,
+            TEXTURE_FORMAT,
+            VK_IMAGE_TILING_OPTIMAL,
+            uploadContext.getMipmapImageUsage(TEXTURE_FORMAT) | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            uploadContext.getMipmapImageCreateFlags(TEXTURE_FORMAT)
+        );
+
+        const auto stagingSlice = uploadBatch.stage(texture.pixels.get(), formatInfo.getLevelSize(texture.width, texture.height));
+        uploadBatch.transitionImageLayout(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+        uploadBatch.copyBufferToImage(stagingSlice, image, texture.width, texture.height);
+
+        mipmapTargets.push_back(MipmapTarget {
+            .image = image,
+            .format = TEXTURE_FORMAT,
+            .width = texture.width,
+            .height = texture.height,
+            .mipLevels = mipLevels,
+            .filter = MIP_FILTER,
+            .alphaCutoff = MIP_ALPHA_CUTOFF,
+        });
+        pendingTextures.push_back(PendingTexture {
+            .job = texture.job,
+            .mipChain = TextureCacheEntry {
+                .format = TEXTURE_FORMAT,
+                .width = texture.width,
+                .height = texture.height,
+            },
+            .image = image,
+            .imageAllocation = imageAllocation,
+            .readbackBuffer = VK_NULL_HANDLE,
+            .readbackAllocation = GpuAllocation {},
+        });
+    }
+
+    // Transitions every image to `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL`.
+    uploadBatch.generateMipmaps(mipmapTargets);
+
+    auto* textureCompressor = compress ? engine.getTextureCompressor() : nullptr;
+    for (size_t i = 0; i < pendingTextures.size(); i++) {
+        auto& pendingTexture = pendingTextures[i];
+        const auto& texture = textures[i];
+        const auto mipLevels = mipmapTargets[i].mipLevels;
+
+        // The file's own channel count tells whether the alpha the decoder expanded to is
+        // real, so opaque images get the smaller BC1 blocks.
+        const auto hasAlpha = texture.channelCount == 2 || texture.channelCount == 4;
+        const auto compressedFormat = textureCompressor != nullptr ? textureCompressor->getCompressedFormat(TEXTURE_FORMAT, hasAlpha) : VK_FORMAT_UNDEFINED;
+        if (compressedFormat != VK_FORMAT_UNDEFINED) {
+            const auto compressedLevels = TextureCache::createLevels(*TextureFormats::getInfo(compressedFormat), texture.width, texture.height, mipLevels);
+            const auto blockBufferSize = compressedLevels.back().offset + compressedLevels.back().size;
+            const auto [compressedImage, compressedImageAllocation] = engine.createImage(
+                texture.width,
+                texture.height,
+                mipLevels,
+                VK_SAMPLE_COUNT_1_BIT,
+                compressedFormat,
+                VK_IMAGE_TILING_OPTIMAL,
+                textureCompressor->getRequiredImageUsage() | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+            const auto [blockBuffer, blockBufferAllocation] = engine.createBuffer(
+                blockBufferSize,
+                textureCompressor->getRequiredBufferUsage(),
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+
+            const auto compressionTarget = CompressionTarget {
+                .sourceImage = pendingTexture.image,
+                .sourceFormat = TEXTURE_FORMAT,
+                .destinationImage = compressedImage,
+                .destinationFormat = compressedFormat,
+                .blockBuffer = blockBuffer,
+                .levels = compressedLevels,
+            };
+            const auto resources = textureCompressor->record(uploadBatch.getCommandBuffer(), compressionTarget);
+
+            // The uncompressed chain is only read by the encoder, so it goes with the block
+            // buffer once the batch completes.
+            uploadBatch.deferDestruction([
+                &engine,
+                textureCompressor,
+                resources,
+                sourceImage = pendingTexture.image,
+                sourceImageAllocation = pendingTexture.imageAllocation,
+                blockBuffer,
+                blockBufferAllocation
+            ]() {
+                textureCompressor->release(resources);
+                engine.destroyImage(sourceImage, sourceImageAllocation);
+                engine.destroyBuffer(blockBuffer, blockBufferAllocation);
+            });
+
+            pendingTexture.image = compressedImage;
+            pendingTexture.imageAllocation = compressedImageAllocation;
+            pendingTexture.mipChain.format = compressedFormat;
+        }
+
+        auto& mipChain = pendingTexture.mipChain;
+        mipChain.levels = TextureCache::createLevels(*TextureFormats::getInfo(mipChain.format), texture.width, texture.height, mipLevels);
+        const auto readbackSize = mipChain.levels.back().offset + mipChain.levels.back().size;
+        const auto [readbackBuffer, readbackAllocation] = engine.createBuffer(
+            readbackSize,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+        const auto copyRegions = createMipLevelCopyRegions(mipChain.levels);
+        uploadBatch.copyImageToBuffer(pendingTexture.image, mipLevels, readbackBuffer, copyRegions);
+
+        pendingTexture.readbackBuffer = readbackBuffer;
+        pendingTexture.readbackAllocation = readbackAllocation;
+    }
+
+    return pendingTextures;
+}
+
+/// @brief Write out the chains of a batch that has completed, and destroy what it used.
+static void writeBatch(Engine& engine, std::vector<PendingTexture>& pendingTextures, BakeProgress& progress) {
+    for (auto& pendingTexture : pendingTextures) {
+        auto& mipChain = pendingTexture.mipChain;
+        const auto* readbackData = static_cast<const uint8_t*>(pendingTexture.readbackAllocation.mappedData);
+        const auto readbackSize = mipChain.levels.back().offset + mipChain.levels.back().size;
+        mipChain.data.assign(readbackData, readbackData + readbackSize);
+
+        engine.destroyBuffer(pendingTexture.readbackBuffer, pendingTexture.readbackAllocation);
+        engine.destroyImage(pendingTexture.image, pendingTexture.imageAllocation);
+
+        const auto& job = *pendingTexture.job;
+        try {
+            std::filesystem::create_directories(job.outputPath.parent_path());
+            Ktx2Writer::write(job.outputPath, mipChain);
+            progress.bakedCount++;
+
+            const auto lock = std::lock_guard<std::mutex> { progress.outputMutex };
+            fmt::println("{} -> {} ({}x{}, {} levels)", job.sourcePath.string(), job.outputPath.string(), mipChain.width, mipChain.height, mipChain.levels.size());
+        } catch (const std::exception& exception) {
+            progress.failedCount++;
+
+            const auto lock = std::lock_guard<std::mutex> { progress.outputMutex };
+            fmt::println(std::cerr, "{}: {}", job.sourcePath.string(), exception.what());
+        }
+    }
+
+    pendingTextures.clear();
+}
+
+/// @brief Decode the layers of a page, pack them, and bake the page with a mip chain for
+/// every layer, in a batch of its own.
+///
+/// @note The texture compressor encodes chains of a single layer, so pages are written
+/// uncompressed. A layer that fails to decode fails the whole page, since the placements
+/// of the others already count on it.
+static void bakePage(Engine& engine, const PageJob& pageJob, BakeProgress& progress) {
+    const auto& page = pageJob.page;
+    const auto reportFailure = [&pageJob, &progress](const char* message) {
+        progress.failedCount += pageJob.page.layerCount;
+
+        const auto lock = std::lock_guard<std::mutex> { progress.outputMutex };
+        fmt::println(std::cerr, "{}: {}", pageJob.outputPath.string(), message);
+    };
+
+    auto decodes = std::vector<std::future<DecodedTexture>> {};
+    for (const auto* layerJob : pageJob.layerJobs) {
+        decodes.push_back(std::async(std::launch::async, decodeTexture, std::cref(*layerJob)));
+    }
+
+    auto pageTexels = std::vector<uint8_t>(TexturePacker::getLayerSize(page) * page.layerCount);
+    try {
+        for (uint32_t layer = 0; layer < page.layerCount; layer++) {
+            const auto texture = decodes[layer].get();
+            const auto& source = pageJob.sources[layer];
+            if (texture.width != source.width || texture.height != source.height) {
+                throw std::runtime_error(fmt::format("{} changed size while it was baked", texture.job->sourcePath.string()));
+            }
+
+            TexturePacker::copyLayer(page, pageJob.placements[layer], source, texture.pixels.get(), pageTexels.data());
+        }
+    } catch (const std::exception& exception) {
+        reportFailure(exception.what());
+        return;
+    }
+
+    auto& uploadContext = engine.getUploadContext();
+    auto uploadBatch = uploadContext.beginBatch();
+    const auto [image, imageAllocation] = engine.createImage(
+        page.width,
+        page.height,
+        page.mipLevels,
+        VK_SAMPLE_COUNT_1_BIT,
+        page.format,
+        VK_IMAGE_TILING_OPTIMAL,
+        uploadContext.getMipmapImageUsage(page.format) | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        uploadContext.getMipmapImageCreateFlags(page.format),
+        page.layerCount
+    );
+
+    const auto stagingSlice = uploadBatch.stage(pageTexels.data(), pageTexels.size());
+    uploadBatch.transitionImageLayout(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, page.mipLevels, page.layerCount);
+    uploadBatch.copyBufferToImage(stagingSlice, image, page.width, page.height, 1, page.layerCount);
+
+    // Every layer gets a chain of its own, with the layers of a level filtered together.
+    const auto mipmapTarget = MipmapTarget {
+        .image = image,
+        .format = page.format,
+        .width = page.width,
+        .height = page.height,
+        .mipLevels = page.mipLevels,
+        .layerCount = page.layerCount,
+        .filter = MIP_FILTER,
+        .alphaCutoff = MIP_ALPHA_CUTOFF,
+    };
+    uploadBatch.generateMipmaps(std::span<const MipmapTarget> { &mipmapTarget, 1 });
+
+    auto mipChain = TextureCacheEntry {
+        .format = page.format,
+        .width = page.width,
+        .height = page.height,
+        .layerCount = page.layerCount,
+        .levels = TextureCache::createLevels(*TextureFormats::getInfo(page.format), page.width, page.height, page.mipLevels, page.layerCount),
+    };
+    const auto readbackSize = mipChain.levels.back().offset + mipChain.levels.back().size;
+    const auto [readbackBuffer, readbackAllocation] = engine.createBuffer(
+        readbackSize,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+    const auto copyRegions = createMipLevelCopyRegions(mipChain.levels, page.layerCount);
+    uploadBatch.copyImageToBuffer(image, page.mipLevels, readbackBuffer, copyRegions, page.layerCount);
+    uploadContext.wait(uploadContext.submit(uploadBatch));
+
+    const auto* readbackData = static_cast<const uint8_t*>(readbackAllocation.mappedData);
+    mipChain.data.assign(readbackData, readbackData + readbackSize);
+    engine.destroyBuffer(readbackBuffer, readbackAllocation);
+    engine.destroyImage(image, imageAllocation);
+
+    try {
+        std::filesystem::create_directories(pageJob.outputPath.parent_path());
+        Ktx2Writer::write(pageJob.outputPath, mipChain);
+        progress.bakedCount += page.layerCount;
+        progress.bakedPageCount++;
+
+        const auto lock = std::lock_guard<std::mutex> { progress.outputMutex };
+        fmt::println(
+            "{} ({}x{}, {} layers, {} levels)",
+            pageJob.outputPath.string(),
+            page.width,
+            page.height,
+            page.layerCount,
+            page.mipLevels
+        );
+    } catch (const std::exception& exception) {
+        reportFailure(exception.what());
+    }
+}
+
+/// @brief Bake textures on the device of rank `laneIndex` until every job has been taken,
+/// and then pages until every page has been.
+///
+/// @note The textures of a batch are decoded on threads of their own, and the next batch
+/// decodes while the GPU works through the previous one.
+static void runLane(uint32_t laneIndex, const TexbakeOptions& options, const BakePlan& plan, BakeProgress& progress) {
+    const auto& jobs = plan.textureJobs;
+    const auto deviceSelection = DeviceSelection { .deviceRank = laneIndex };
+    auto engine = Engine::create(options.engineMode, true, deviceSelection);
+    engine->createPipelineCompiler(1);
+    engine->createMipmapGenerator(
+        shaders_hlsl::getHlslShader(HlslShader::MipmapComp),
+        shaders_hlsl::getHlslShader(HlslShader::MipmapFilterComp),
+        shaders_hlsl::getHlslShader(HlslShader::MipmapVolumeComp)
+    );
+    if (options.compress) {
+        engine->createTextureCompressor(shaders_hlsl::getHlslShader(HlslShader::TextureCompressComp));
+    }
+
+    const auto takeBatch = [&jobs, &progress]() {
+        auto decodes = std::vector<std::future<DecodedTexture>> {};
+        for (size_t i = 0; i < BATCH_TEXTURE_COUNT; i++) {
+            const auto jobIndex = progress.nextJob.fetch_add(1);
+            if (jobIndex >= jobs.size()) {
+                break;
+            }
+
+            decodes.push_back(std::async(std::launch::async, decodeTexture, std::cref(jobs[jobIndex])));
+        }
+
+        return decodes;
+    };
+
+    auto& uploadContext = engine->getUploadContext();
+    auto decodes = takeBatch();
+    auto pendingTextures = std::vector<PendingTexture> {};
+    auto pendingValue = std::optional<uint64_t> {};
+    while (!decodes.empty() || pendingValue.has_value()) {
+        auto textures = std::vector<DecodedTexture> {};
+        for (auto& decode : decodes) {
+            try {
+                textures.push_back(decode.get());
+            } catch (const std::exception& exception) {
+                progress.failedCount++;
+
+                const auto lock = std::lock_guard<std::mutex> { progress.outputMutex };
+                fmt::println(std::cerr, "{}", exception.what());
+            }
+        }
+        decodes.clear();
+
+        // The previous batch has to finish before its chains are written, and before the
+        // staging ring takes this one.
+        if (pendingValue.has_value()) {
+            uploadContext.wait(*pendingValue);
+            writeBatch(*engine, pendingTextures, progress);
+            pendingValue.reset();
+        }
+
+        // The next batch decodes while this one runs on the GPU. A batch that would not fit
+        // in its share of the staging ring is split.
+        decodes = takeBatch();
+        auto first = size_t { 0 };
+        while (first < textures.size()) {
+            auto last = first + 1;
+            auto batchSize = VkDeviceSize { textures[first].width } * textures[first].height * 4;
+            while (last < textures.size() && batchSize + VkDeviceSize { textures[last].width } * textures[last].height * 4 <= BATCH_STAGING_SIZE) {
+                batchSize += VkDeviceSize { textures[last].width } * textures[last].height * 4;
+                last++;
+            }
+
+            if (pendingValue.has_value()) {
+                uploadContext.wait(*pendingValue);
+                writeBatch(*engine, pendingTextures, progress);
+            }
+
+            auto uploadBatch = uploadContext.beginBatch();
+            const auto batchTextures = std::span<const DecodedTexture> { textures.data() + first, last - first };
+            pendingTextures = recordBatch(*engine, uploadBatch, batchTextures, options.compress);
+            pendingValue = uploadContext.submit(uploadBatch);
+            first = last;
+        }
+    }
+
+    for (auto pageIndex = progress.nextPage.fetch_add(1); pageIndex < plan.pageJobs.size(); pageIndex = progress.nextPage.fetch_add(1)) {
+        bakePage(*engine, plan.pageJobs[pageIndex], progress);
+    }
+}
+
+/// @brief Write the table of where every packed texture landed next to the pages.
+///
+/// @note The table only goes out once every page is in place, so that it never names a
+/// layer that is missing.
+static void writePackTable(const TexbakeOptions& options, const BakePlan& plan) {
+    auto table = TexturePackTable {};
+    for (const auto& pageJob : plan.pageJobs) {
+        const auto pageIndex = table.addPage(pageJob.outputPath.string());
+        for (uint32_t layer = 0; layer < pageJob.page.layerCount; layer++) {
+            auto placement = pageJob.placements[layer];
+            placement.page = pageIndex;
+            table.addPlacement(pageJob.layerJobs[layer]->sourcePath.string(), placement);
+        }
+    }
+
+    const auto tablePath = options.outputDirectory.value_or(options.inputDirectory) / PACK_TABLE_FILE;
+    table.save(tablePath);
+    fmt::println("packed textures into {} pages, placed in {}", plan.pageJobs.size(), tablePath.string());
+}
+
+int main(int argc, char* argv[]) {
+    auto options = TexbakeOptions {};
+    try {
+        options = parseTexbakeOptions(argc, argv);
+    } catch (const std::exception& exception) {
+        fmt::println(std::cerr, "{}", exception.what());
+        return EXIT_FAILURE;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    auto skippedCount = uint32_t { 0 };
+    const auto jobs = findBakeJobs(options, skippedCount);
+    const auto plan = planBake(options, jobs);
+
+    // Every lane takes the next best device, and the jobs from one shared counter, so a
+    // faster device bakes more of them.
+    auto progress = BakeProgress {};
+    const auto workCount = plan.textureJobs.size() + plan.pageJobs.size();
+    const auto laneCount = std::min(options.gpuCount, static_cast<uint32_t>(std::max(workCount, size_t { 1 })));
+    auto laneErrors = std::vector<std::exception_ptr>(laneCount, nullptr);
+    auto lanes = std::vector<std::thread> {};
+    for (uint32_t laneIndex = 0; laneIndex < laneCount && !jobs.empty(); laneIndex++) {
+        lanes.emplace_back([laneIndex, &options, &plan, &progress, &laneErrors]() {
+            try {
+                runLane(laneIndex, options, plan, progress);
+            } catch (...) {
+                laneErrors[laneIndex] = std::current_exception();
+            }
+        });
+    }
+
+    for (auto& lane : lanes) {
+        lane.join();
+    }
+
+    auto exitCode = progress.failedCount > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    for (uint32_t laneIndex = 0; laneIndex < laneCount; laneIndex++) {
+        if (!laneErrors[laneIndex]) {
+            continue;
+        }
+
+        try {
+            std::rethrow_exception(laneErrors[laneIndex]);
+        } catch (const std::exception& exception) {
+            fmt::println(std::cerr, "lane {}: {}", laneIndex, exception.what());
+        }
+        exitCode = EXIT_FAILURE;
+    }
+
+    if (!plan.pageJobs.empty()) {
+        try {
+            if (progress.bakedPageCount != plan.pageJobs.size()) {
+                throw std::runtime_error("failed to bake every page, so the texture pack table is not written!");
+            }
+
+            writePackTable(options, plan);
+        } catch (const std::exception& exception) {
+            fmt::println(std::cerr, "{}", exception.what());
+            exitCode = EXIT_FAILURE;
+        }
+    }
+
+    // A lane that failed leaves its jobs to the others, but the ones it had taken are lost.
+    const auto unbakedCount = jobs.size() - progress.bakedCount - progress.failedCount;
+    const auto seconds = std::chrono::duration<double> { std::chrono::steady_clock::now() - start }.count();
+    fmt::println(
+        "baked {} textures, skipped {} up to date, {} failed, {} not baked, in {:.2f} s on {} lanes",
+        progress.bakedCount.load(),
+        skippedCount,
+        progress.failedCount.load(),
+        unbakedCount,
+        seconds,
+        lanes.size()
+    );
+    if (unbakedCount > 0) {
+        exitCode = EXIT_FAILURE;
+    }
+
+    return exitCode;
+}
@@ -0,0 +1,208 @@
+#include "texture_cache.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+
+using CacheSourceKey = VulkanEngine::CacheSourceKey;
+using TextureCache = VulkanEngine::TextureCache;
+using TextureCacheEntry = VulkanEngine::TextureCacheEntry;
+using TextureCacheLevel = VulkanEngine::TextureCacheLevel;
+using TextureFormatInfo = VulkanEngine::TextureFormatInfo;
+using TextureFormats = VulkanEngine::TextureFormats;
+
+// The cache files are a header, the source path, the level table and the texel data, in
+// that order. Any change to that layout must bump the version so stale entries miss.
+static constexpr uint32_t CACHE_FILE_MAGIC = 0x4350494d; // "MIPC"
+static constexpr uint32_t CACHE_FILE_VERSION = 1;
+
+struct CacheFileHeader final {
+    uint32_t magic;
+    uint32_t version;
+    int64_t sourceModifiedTime;
+    uint64_t sourceContentHash;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+    uint64_t sourcePathSize;
+    uint64_t dataSize;
+};
+
+struct CacheFileLevel final {
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;
+    uint64_t size;
+};
+
+TextureCache::TextureCache(const std::filesystem::path& cacheDirectory)
+    : m_cacheDirectory { cacheDirectory }
+{
+}
+
+std::optional<TextureCacheEntry> TextureCache::load(const std::filesystem::path& sourcePath) const {
+    auto file = std::ifstream { this->getEntryPath(sourcePath), std::ios::binary };
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+
+    auto header = CacheFileHeader {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != CACHE_FILE_MAGIC || header.version != CACHE_FILE_VERSION) {
+        return std::nullopt;
+    }
+
+    // Entry names are hashes of the source path, so the full path is stored to rule out
+    // collisions.
+    const auto sourcePathString = sourcePath.generic_string();
+    auto cachedSourcePath = std::string(header.sourcePathSize, '\0');
+    file.read(cachedSourcePath.data(), static_cast<std::streamsize>(cachedSourcePath.size()));
+    if (!file || cachedSourcePath != sourcePathString) {
+        return std::nullopt;
+    }
+
+    const auto sourceKey = CacheSourceKey::create(sourcePath);
+    if (!sourceKey.has_value()) {
+        return std::nullopt;
+    }
+
+    if (header.sourceModifiedTime != sourceKey->modifiedTime || header.sourceContentHash != sourceKey->contentHash) {
+        return std::nullopt;
+    }
+
+    const auto formatInfo = TextureFormats::getInfo(static_cast<VkFormat>(header.format));
+    if (!formatInfo.has_value()) {
+        return std::nullopt;
+    }
+
+    auto entry = TextureCacheEntry {
+        .format = static_cast<VkFormat>(header.format),
+        .width = header.width,
+        .height = header.height,
+    };
+    entry.levels.reserve(header.levelCount);
+    for (uint32_t i = 0; i < header.levelCount; i++) {
+        auto level = CacheFileLevel {};
+        file.read(reinterpret_cast<char*>(&level), sizeof(level));
+        const auto isLevelValid = level.size == formatInfo->getLevelSize(level.width, level.height) &&
+            level.offset % LEVEL_ALIGNMENT == 0 &&
+            level.offset + level.size <= header.dataSize;
+        if (!file || !isLevelValid) {
+            return std::nullopt;
+        }
+
+        entry.levels.push_back(TextureCacheLevel {
+            .width = level.width,
+            .height = level.height,
+            .offset = level.offset,
+            .size = level.size,
+        });
+    }
+
+    entry.data.resize(header.dataSize);
+    file.read(reinterpret_cast<char*>(entry.data.data()), static_cast<std::streamsize>(entry.data.size()));
+    if (!file) {
+        return std::nullopt;
+    }
+
+    return entry;
+}
+
+void TextureCache::store(const std::filesystem::path& sourcePath, const TextureCacheEntry& entry) const {
+    const auto sourceKey = CacheSourceKey::create(sourcePath);
+    if (!sourceKey.has_value()) {
+        throw std::runtime_error("failed to hash texture cache source!");
+    }
+
+    auto errorCode = std::error_code {};
+    std::filesystem::create_directories(m_cacheDirectory, errorCode);
+    if (errorCode) {
+        throw std::runtime_error("failed to create texture cache directory!");
+    }
+
+    const auto sourcePathString = sourcePath.generic_string();
+    const auto header = CacheFileHeader {
+        .magic = CACHE_FILE_MAGIC,
+        .version = CACHE_FILE_VERSION,
+        .sourceModifiedTime = sourceKey->modifiedTime,
+        .sourceContentHash = sourceKey->contentHash,
+        .format = static_cast<uint32_t>(entry.format),
+        .width = entry.width,
+        .height = entry.height,
+        .levelCount = static_cast<uint32_t>(entry.levels.size()),
+        .sourcePathSize = sourcePathString.size(),
+        .dataSize = entry.data.size(),
+    };
+
+    // Write to a temporary file first so a crash mid-write never leaves a truncated entry
+    // behind under the real name.
+    const auto entryPath = this->getEntryPath(sourcePath);
+    auto temporaryPath = entryPath;
+    temporaryPath += ".tmp";
+    {
+        auto file = std::ofstream { temporaryPath, std::ios::binary | std::ios::trunc };
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open texture cache entry for writing!");
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(sourcePathString.data(), static_cast<std::streamsize>(sourcePathString.size()));
+        for (const auto& level : entry.levels) {
+            const auto fileLevel = CacheFileLevel {
+                .width = level.width,
+                .height = level.height,
+                .offset = level.offset,
+                .size = level.size,
+            };
+            file.write(reinterpret_cast<const char*>(&fileLevel), sizeof(fileLevel));
+        }
+
+        file.write(reinterpret_cast<const char*>(entry.data.data()), static_cast<std::streamsize>(entry.data.size()));
+        if (!file) {
+            throw std::runtime_error("failed to write texture cache entry!");
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, entryPath, errorCode);
+    if (errorCode) {
+        std::filesystem::remove(temporaryPath, errorCode);
+
+        throw std::runtime_error("failed to write texture cache entry!");
+    }
+}
+
+std::vector<TextureCacheLevel> TextureCache::createLevels(
+    const TextureFormatInfo& formatInfo,
+    uint32_t width,
+    uint32_t height,
+    uint32_t mipLevels,
+    uint32_t layerCount
+) {
+    auto levels = std::vector<TextureCacheLevel> {};
+    levels.reserve(mipLevels);
+
+    auto offset = VkDeviceSize { 0 };
+    for (uint32_t i = 0; i < mipLevels; i++) {
+        const auto levelWidth = std::max(width >> i, 1u);
+        const auto levelHeight = std::max(height >> i, 1u);
+        const auto levelSize = formatInfo.getLevelSize(levelWidth, levelHeight) * layerCount;
+
+        levels.push_back(TextureCacheLevel {
+            .width = levelWidth,
+            .height = levelHeight,
+            .offset = offset,
+            .size = levelSize,
+        });
+
+        offset = (offset + levelSize + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
+    }
+
+    return levels;
+}
+
+std::filesystem::path TextureCache::getEntryPath(const std::filesystem::path& sourcePath) const {
+    return m_cacheDirectory / CacheSourceKey::createEntryName(sourcePath, ".mipcache");
+}
@@ -0,0 +1,81 @@
+#ifndef _TEXTURE_CACHE_H
+#define _TEXTURE_CACHE_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "cache_source_key.h"
+#include "texture_format.h"
+
+
+namespace VulkanEngine {
+
+/// @brief One mip level of a cached texture.
+///
+/// @note `offset` is relative to the start of the texel data of the entry.
+struct TextureCacheLevel final {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+};
+
+/// @brief A fully generated mip chain in the layout it is copied into the image with.
+///
+/// @note Every level of an array texture holds all of its layers, one after another. The
+/// cache itself only stores textures of a single layer.
+struct TextureCacheEntry final {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t layerCount = 1;
+    std::vector<TextureCacheLevel> levels;
+    std::vector<uint8_t> data;
+};
+
+/// @brief An on-disk cache of precomputed mip chains.
+///
+/// @note Entries are keyed by the path of the source image, its modification time and a
+/// hash of its contents. A hit hands back every mip level ready for a single
+/// `vkCmdCopyBufferToImage`, so neither the image decoder nor mip generation runs. Any
+/// mismatch, missing file or corrupt entry is reported as a miss.
+class TextureCache final {
+    public:
+        /// @brief The alignment of every level inside the texel data of an entry.
+        static constexpr VkDeviceSize LEVEL_ALIGNMENT = 16;
+
+        explicit TextureCache() = delete;
+        explicit TextureCache(const std::filesystem::path& cacheDirectory);
+
+        ~TextureCache() = default;
+
+        std::optional<TextureCacheEntry> load(const std::filesystem::path& sourcePath) const;
+
+        void store(const std::filesystem::path& sourcePath, const TextureCacheEntry& entry) const;
+
+        /// @brief Lay out the levels of a mip chain the way the cache stores them.
+        ///
+        /// @note Level sizes are rounded up to whole texel blocks, so block-compressed
+        /// formats are laid out correctly too. Every level of an array texture holds
+        /// `layerCount` layers.
+        static std::vector<TextureCacheLevel> createLevels(
+            const TextureFormatInfo& formatInfo,
+            uint32_t width,
+            uint32_t height,
+            uint32_t mipLevels,
+            uint32_t layerCount = 1
+        );
+    private:
+        std::filesystem::path m_cacheDirectory;
+
+        std::filesystem::path getEntryPath(const std::filesystem::path& sourcePath) const;
+};
+
+}
+
+#endif // _TEXTURE_CACHE_H
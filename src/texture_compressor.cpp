@@ -0,0 +1,401 @@
+#include "texture_compressor.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+#include "command_counters.h"
+
+
+using TextureCompressor = VulkanEngine::TextureCompressor;
+using TextureFormats = VulkanEngine::TextureFormats;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+
+// The compression pipeline runs 8x8 workgroups, one invocation per 4x4 block.
+static constexpr uint32_t GROUP_SIZE = 8;
+
+static constexpr uint32_t BLOCK_SIZE = 4;
+
+TextureCompressor::TextureCompressor(
+    const DeviceCapabilities& capabilities,
+    VkDevice device,
+    VkPipelineCache pipelineCache,
+    std::span<const uint32_t> shaderCode
+)
+    : m_capabilities { capabilities }
+    , m_device { device }
+    , m_pipelineCache { pipelineCache }
+    , m_descriptorSetLayout { VK_NULL_HANDLE }
+    , m_pipelineLayout { VK_NULL_HANDLE }
+    , m_pipeline { VK_NULL_HANDLE }
+{
+    this->createDescriptorSetLayout();
+    this->createPipeline(shaderCode);
+}
+
+TextureCompressor::~TextureCompressor() {
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipelineLayout = VK_NULL_HANDLE;
+    m_descriptorSetLayout = VK_NULL_HANDLE;
+    m_pipelineCache = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+VkFormat TextureCompressor::getCompressedFormat(VkFormat format, bool hasAlpha) const {
+    auto compressedFormat = VK_FORMAT_UNDEFINED;
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM: {
+            compressedFormat = hasAlpha ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+            break;
+        }
+        case VK_FORMAT_R8G8B8A8_SRGB: {
+            compressedFormat = hasAlpha ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+            break;
+        }
+        default: {
+            return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    // Devices without BC support, like most mobile GPUs, keep the uncompressed image.
+    if (!TextureFormats::isSampleable(m_capabilities, compressedFormat)) {
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    return compressedFormat;
+}
+
+VkImageUsageFlags TextureCompressor::getRequiredImageUsage() const {
+    return VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+}
+
+VkBufferUsageFlags TextureCompressor::getRequiredBufferUsage() const {
+    return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+}
+
+TextureCompressor::DispatchResources TextureCompressor::record(VkCommandBuffer commandBuffer, const CompressionTarget& target) {
+    const auto mipLevels = static_cast<uint32_t>(target.levels.size());
+    const auto isBc3 = target.destinationFormat == VK_FORMAT_BC3_UNORM_BLOCK || target.destinationFormat == VK_FORMAT_BC3_SRGB_BLOCK;
+    const auto isSrgb = target.destinationFormat == VK_FORMAT_BC1_RGB_SRGB_BLOCK || target.destinationFormat == VK_FORMAT_BC3_SRGB_BLOCK;
+
+    auto resources = DispatchResources {};
+
+    // The source is read through a view of its own format, so sRGB texels arrive linear
+    // and the shader encodes the endpoints back to sRGB.
+    const auto viewInfo = VkImageViewCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = target.sourceImage,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = target.sourceFormat,
+        .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .subresourceRange.baseMipLevel = 0,
+        .subresourceRange.levelCount = mipLevels,
+        .subresourceRange.baseArrayLayer = 0,
+        .subresourceRange.layerCount = 1,
+    };
+    const auto resultCreateImageView = vkCreateImageView(m_device, &viewInfo, nullptr, &resources.sourceView);
+    if (resultCreateImageView != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture compressor image view!");
+    }
+
+    // Every texture gets a pool of its own, which is destroyed with the rest of its
+    // resources once the batch completes.
+    const auto poolSizes = std::array<VkDescriptorPoolSize, 2> {
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 1,
+        },
+        VkDescriptorPoolSize {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+        },
+    };
+    const auto poolInfo = VkDescriptorPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+        .maxSets = 1,
+    };
+    const auto resultCreateDescriptorPool = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &resources.descriptorPool);
+    if (resultCreateDescriptorPool != VK_SUCCESS) {
+        this->release(resources);
+
+        throw std::runtime_error("failed to create texture compressor descriptor pool!");
+    }
+
+    const auto allocInfo = VkDescriptorSetAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = resources.descriptorPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &m_descriptorSetLayout,
+    };
+
+    auto descriptorSet = VkDescriptorSet {};
+    const auto resultAllocateDescriptorSet = vkAllocateDescriptorSets(m_device, &allocInfo, &descriptorSet);
+    if (resultAllocateDescriptorSet != VK_SUCCESS) {
+        this->release(resources);
+
+        throw std::runtime_error("failed to allocate texture compressor descriptor set!");
+    }
+
+    const auto imageInfo = VkDescriptorImageInfo {
+        .sampler = VK_NULL_HANDLE,
+        .imageView = resources.sourceView,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+    const auto bufferInfo = VkDescriptorBufferInfo {
+        .buffer = target.blockBuffer,
+        .offset = 0,
+        .range = VK_WHOLE_SIZE,
+    };
+    const auto descriptorWrites = std::array<VkWriteDescriptorSet, 2> {
+        VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 1,
+            .pImageInfo = &imageInfo,
+        },
+        VkWriteDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = 1,
+            .dstArrayElement = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .pBufferInfo = &bufferInfo,
+        },
+    };
+    vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+    // The mip chain was generated into the source, so its last writes have to land first,
+    // whether a shader or a blit made them. The generator's final barrier hands the image to
+    // the fragment stage, so that stage is named too for this barrier to chain from it.
+    const auto sourceBarrier = VkMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &sourceBarrier,
+        0, nullptr,
+        0, nullptr
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    CommandCounters::add(CommandCounter::PipelineBinds);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+    CommandCounters::add(CommandCounter::DescriptorBinds);
+
+    // The levels write disjoint ranges of the buffer, so they need no barriers between them.
+    for (uint32_t level = 0; level < mipLevels; level++) {
+        const auto& levelLayout = target.levels[level];
+        const auto blockCountX = (levelLayout.width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        const auto blockCountY = (levelLayout.height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        const auto pushConstants = PushConstants {
+            .width = levelLayout.width,
+            .height = levelLayout.height,
+            .level = level,
+            .blockOffset = static_cast<uint32_t>(levelLayout.offset / sizeof(uint32_t)),
+            .blockFormat = static_cast<uint32_t>(isBc3 ? BlockFormat::Bc3 : BlockFormat::Bc1),
+            .isSrgb = isSrgb ? 1u : 0u,
+        };
+
+        vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstants);
+        vkCmdDispatch(commandBuffer, (blockCountX + GROUP_SIZE - 1) / GROUP_SIZE, (blockCountY + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+        CommandCounters::add(CommandCounter::Dispatches);
+    }
+
+    const auto subresourceRange = VkImageSubresourceRange {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = 0,
+        .levelCount = mipLevels,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+    const auto blockBarrier = VkBufferMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = target.blockBuffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+    auto destinationBarrier = VkImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = target.destinationImage,
+        .subresourceRange = subresourceRange,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        1, &blockBarrier,
+        1, &destinationBarrier
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    auto copyRegions = std::vector<VkBufferImageCopy> {};
+    copyRegions.reserve(mipLevels);
+    for (uint32_t level = 0; level < mipLevels; level++) {
+        const auto& levelLayout = target.levels[level];
+        copyRegions.push_back(VkBufferImageCopy {
+            .bufferOffset = levelLayout.offset,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .imageSubresource.mipLevel = level,
+            .imageSubresource.baseArrayLayer = 0,
+            .imageSubresource.layerCount = 1,
+            .imageOffset = { 0, 0, 0 },
+            .imageExtent = { levelLayout.width, levelLayout.height, 1 },
+        });
+    }
+    vkCmdCopyBufferToImage(
+        commandBuffer,
+        target.blockBuffer,
+        target.destinationImage,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(copyRegions.size()),
+        copyRegions.data()
+    );
+
+    destinationBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    destinationBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    destinationBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    destinationBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &destinationBarrier
+    );
+    CommandCounters::add(CommandCounter::Barriers);
+
+    return resources;
+}
+
+void TextureCompressor::release(const DispatchResources& resources) {
+    // Destroying the pool frees its descriptor set.
+    if (resources.descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(m_device, resources.descriptorPool, nullptr);
+    }
+
+    if (resources.sourceView != VK_NULL_HANDLE) {
+        vkDestroyImageView(m_device, resources.sourceView, nullptr);
+    }
+}
+
+void TextureCompressor::createDescriptorSetLayout() {
+    const auto bindings = std::array<VkDescriptorSetLayoutBinding, 2> {
+        VkDescriptorSetLayoutBinding {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding {
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+    };
+    const auto layoutInfo = VkDescriptorSetLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+
+    auto descriptorSetLayout = VkDescriptorSetLayout {};
+    const auto result = vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &descriptorSetLayout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture compressor descriptor set layout!");
+    }
+
+    m_descriptorSetLayout = descriptorSetLayout;
+}
+
+void TextureCompressor::createPipeline(std::span<const uint32_t> shaderCode) {
+    const auto pushConstantRange = VkPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    const auto pipelineLayoutInfo = VkPipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_descriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+
+    auto pipelineLayout = VkPipelineLayout {};
+    const auto resultCreatePipelineLayout = vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+    if (resultCreatePipelineLayout != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture compressor pipeline layout!");
+    }
+
+    m_pipelineLayout = pipelineLayout;
+
+    const auto shaderModuleInfo = VkShaderModuleCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = shaderCode.size_bytes(),
+        .pCode = shaderCode.data(),
+    };
+
+    auto shaderModule = VkShaderModule {};
+    const auto resultCreateShaderModule = vkCreateShaderModule(m_device, &shaderModuleInfo, nullptr, &shaderModule);
+    if (resultCreateShaderModule != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture compressor shader module!");
+    }
+
+    const auto pipelineInfo = VkComputePipelineCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shaderModule,
+            .pName = "main",
+        },
+        .layout = m_pipelineLayout,
+    };
+
+    auto pipeline = VkPipeline {};
+    const auto resultCreatePipeline = vkCreateComputePipelines(m_device, m_pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    // The pipeline keeps everything it needs from the shader module.
+    vkDestroyShaderModule(m_device, shaderModule, nullptr);
+
+    if (resultCreatePipeline != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture compressor pipeline!");
+    }
+
+    m_pipeline = pipeline;
+}
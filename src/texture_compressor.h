@@ -0,0 +1,110 @@
+#ifndef _TEXTURE_COMPRESSOR_H
+#define _TEXTURE_COMPRESSOR_H
+
+#include <vulkan/vulkan.h>
+
+#include <span>
+
+#include "device_capabilities.h"
+#include "texture_cache.h"
+
+
+namespace VulkanEngine {
+
+/// @brief An 8-bit RGBA image with a complete mip chain, and the block-compressed image it
+/// is encoded into.
+struct CompressionTarget final {
+    /// @brief The source image, with every level in the shader read-only layout.
+    VkImage sourceImage = VK_NULL_HANDLE;
+    VkFormat sourceFormat = VK_FORMAT_UNDEFINED;
+    /// @brief The destination image, in the undefined layout, created with the usage
+    /// reported by `getRequiredImageUsage`.
+    VkImage destinationImage = VK_NULL_HANDLE;
+    VkFormat destinationFormat = VK_FORMAT_UNDEFINED;
+    /// @brief A device local buffer, created with the usage reported by
+    /// `getRequiredBufferUsage`, that holds the blocks of every level on their way into
+    /// the destination image.
+    VkBuffer blockBuffer = VK_NULL_HANDLE;
+    /// @brief The layout of the levels of the destination format, as the texture cache
+    /// lays them out.
+    std::span<const TextureCacheLevel> levels;
+};
+
+/// @brief Encodes textures into BC1 or BC3 with a compute shader, right after their mip
+/// chains are generated.
+///
+/// @note Source assets that only exist as PNG or JPEG files would otherwise stay 8-bit
+/// RGBA on the GPU. A block-compressed texture takes a quarter of the memory of an opaque
+/// 8-bit RGBA one as BC1, and half as BC3, and sampling it reads that much less. The
+/// encoder is a single-pass bounding box fit, so it runs in a fraction of a millisecond per
+/// texture, and the result is meant to be stored in the texture cache so that later runs
+/// skip it entirely.
+///
+/// The blocks are written to a buffer and copied into the destination image, since storage
+/// writes to block-compressed images are not portable.
+class TextureCompressor final {
+    public:
+        /// @brief The per-texture resources that must outlive the command buffer.
+        struct DispatchResources final {
+            VkImageView sourceView = VK_NULL_HANDLE;
+            VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        };
+
+        explicit TextureCompressor() = delete;
+        explicit TextureCompressor(
+            const DeviceCapabilities& capabilities,
+            VkDevice device,
+            VkPipelineCache pipelineCache,
+            std::span<const uint32_t> shaderCode
+        );
+
+        ~TextureCompressor();
+
+        TextureCompressor(const TextureCompressor& other) = delete;
+        TextureCompressor& operator=(const TextureCompressor& other) = delete;
+
+        /// @brief The block-compressed format to encode images of `format` into, or
+        /// `VK_FORMAT_UNDEFINED` when the format or the device is not supported.
+        ///
+        /// @note Opaque images are encoded as BC1, and images with alpha as BC3.
+        VkFormat getCompressedFormat(VkFormat format, bool hasAlpha) const;
+
+        VkImageUsageFlags getRequiredImageUsage() const;
+
+        VkBufferUsageFlags getRequiredBufferUsage() const;
+
+        /// @brief Record the encoding of every level of the source image, and leave the
+        /// destination image in the shader read-only layout.
+        DispatchResources record(VkCommandBuffer commandBuffer, const CompressionTarget& target);
+
+        void release(const DispatchResources& resources);
+    private:
+        enum class BlockFormat : uint32_t {
+            Bc1 = 0,
+            Bc3 = 1
+        };
+
+        struct PushConstants final {
+            uint32_t width;
+            uint32_t height;
+            uint32_t level;
+            uint32_t blockOffset;
+            uint32_t blockFormat;
+            uint32_t isSrgb;
+        };
+
+        const DeviceCapabilities& m_capabilities;
+        VkDevice m_device;
+        VkPipelineCache m_pipelineCache;
+        VkDescriptorSetLayout m_descriptorSetLayout;
+        VkPipelineLayout m_pipelineLayout;
+        VkPipeline m_pipeline;
+
+        void createDescriptorSetLayout();
+
+        void createPipeline(std::span<const uint32_t> shaderCode);
+};
+
+}
+
+#endif // _TEXTURE_COMPRESSOR_H
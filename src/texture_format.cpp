@@ -0,0 +1,185 @@
+#include "texture_format.h"
+
+#include <bit>
+#include <cmath>
+
+
+using TextureFormats = VulkanEngine::TextureFormats;
+using TextureFormatInfo = VulkanEngine::TextureFormatInfo;
+
+std::optional<TextureFormatInfo> TextureFormats::getInfo(VkFormat format) {
+    const auto info = [](uint32_t blockWidth, uint32_t blockHeight, uint32_t blockSize) -> TextureFormatInfo {
+        return TextureFormatInfo {
+            .blockWidth = blockWidth,
+            .blockHeight = blockHeight,
+            .blockSize = blockSize,
+        };
+    };
+
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM: return info(1, 1, 4);
+        case VK_FORMAT_R8G8B8A8_SRGB: return info(1, 1, 4);
+        case VK_FORMAT_B8G8R8A8_UNORM: return info(1, 1, 4);
+        case VK_FORMAT_B8G8R8A8_SRGB: return info(1, 1, 4);
+        case VK_FORMAT_B10G11R11_UFLOAT_PACK32: return info(1, 1, 4);
+        case VK_FORMAT_R16G16B16A16_UNORM: return info(1, 1, 8);
+        case VK_FORMAT_R16G16B16A16_SFLOAT: return info(1, 1, 8);
+        case VK_FORMAT_R32G32B32A32_SFLOAT: return info(1, 1, 16);
+
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK: return info(4, 4, 8);
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK: return info(4, 4, 8);
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: return info(4, 4, 8);
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: return info(4, 4, 8);
+        case VK_FORMAT_BC2_UNORM_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_BC2_SRGB_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_BC3_UNORM_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_BC3_SRGB_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_BC4_UNORM_BLOCK: return info(4, 4, 8);
+        case VK_FORMAT_BC4_SNORM_BLOCK: return info(4, 4, 8);
+        case VK_FORMAT_BC5_UNORM_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_BC5_SNORM_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_BC6H_UFLOAT_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_BC6H_SFLOAT_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_BC7_UNORM_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_BC7_SRGB_BLOCK: return info(4, 4, 16);
+
+        case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK: return info(4, 4, 8);
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK: return info(4, 4, 8);
+        case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK: return info(4, 4, 8);
+        case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK: return info(4, 4, 8);
+        case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_EAC_R11_UNORM_BLOCK: return info(4, 4, 8);
+        case VK_FORMAT_EAC_R11_SNORM_BLOCK: return info(4, 4, 8);
+        case VK_FORMAT_EAC_R11G11_UNORM_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_EAC_R11G11_SNORM_BLOCK: return info(4, 4, 16);
+
+        case VK_FORMAT_ASTC_4x4_UNORM_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_ASTC_4x4_SRGB_BLOCK: return info(4, 4, 16);
+        case VK_FORMAT_ASTC_5x4_UNORM_BLOCK: return info(5, 4, 16);
+        case VK_FORMAT_ASTC_5x4_SRGB_BLOCK: return info(5, 4, 16);
+        case VK_FORMAT_ASTC_5x5_UNORM_BLOCK: return info(5, 5, 16);
+        case VK_FORMAT_ASTC_5x5_SRGB_BLOCK: return info(5, 5, 16);
+        case VK_FORMAT_ASTC_6x5_UNORM_BLOCK: return info(6, 5, 16);
+        case VK_FORMAT_ASTC_6x5_SRGB_BLOCK: return info(6, 5, 16);
+        case VK_FORMAT_ASTC_6x6_UNORM_BLOCK: return info(6, 6, 16);
+        case VK_FORMAT_ASTC_6x6_SRGB_BLOCK: return info(6, 6, 16);
+        case VK_FORMAT_ASTC_8x5_UNORM_BLOCK: return info(8, 5, 16);
+        case VK_FORMAT_ASTC_8x5_SRGB_BLOCK: return info(8, 5, 16);
+        case VK_FORMAT_ASTC_8x6_UNORM_BLOCK: return info(8, 6, 16);
+        case VK_FORMAT_ASTC_8x6_SRGB_BLOCK: return info(8, 6, 16);
+        case VK_FORMAT_ASTC_8x8_UNORM_BLOCK: return info(8, 8, 16);
+        case VK_FORMAT_ASTC_8x8_SRGB_BLOCK: return info(8, 8, 16);
+        case VK_FORMAT_ASTC_10x5_UNORM_BLOCK: return info(10, 5, 16);
+        case VK_FORMAT_ASTC_10x5_SRGB_BLOCK: return info(10, 5, 16);
+        case VK_FORMAT_ASTC_10x6_UNORM_BLOCK: return info(10, 6, 16);
+        case VK_FORMAT_ASTC_10x6_SRGB_BLOCK: return info(10, 6, 16);
+        case VK_FORMAT_ASTC_10x8_UNORM_BLOCK: return info(10, 8, 16);
+        case VK_FORMAT_ASTC_10x8_SRGB_BLOCK: return info(10, 8, 16);
+        case VK_FORMAT_ASTC_10x10_UNORM_BLOCK: return info(10, 10, 16);
+        case VK_FORMAT_ASTC_10x10_SRGB_BLOCK: return info(10, 10, 16);
+        case VK_FORMAT_ASTC_12x10_UNORM_BLOCK: return info(12, 10, 16);
+        case VK_FORMAT_ASTC_12x10_SRGB_BLOCK: return info(12, 10, 16);
+        case VK_FORMAT_ASTC_12x12_UNORM_BLOCK: return info(12, 12, 16);
+        case VK_FORMAT_ASTC_12x12_SRGB_BLOCK: return info(12, 12, 16);
+
+        default: return std::nullopt;
+    }
+}
+
+VkFormat TextureFormats::getLinearFormat(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_SRGB: return VK_FORMAT_R8G8B8A8_UNORM;
+        case VK_FORMAT_B8G8R8A8_SRGB: return VK_FORMAT_B8G8R8A8_UNORM;
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK: return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case VK_FORMAT_BC2_SRGB_BLOCK: return VK_FORMAT_BC2_UNORM_BLOCK;
+        case VK_FORMAT_BC3_SRGB_BLOCK: return VK_FORMAT_BC3_UNORM_BLOCK;
+        case VK_FORMAT_BC7_SRGB_BLOCK: return VK_FORMAT_BC7_UNORM_BLOCK;
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK: return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+        case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK: return VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK;
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK: return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_4x4_SRGB_BLOCK: return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_5x4_SRGB_BLOCK: return VK_FORMAT_ASTC_5x4_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_5x5_SRGB_BLOCK: return VK_FORMAT_ASTC_5x5_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_6x5_SRGB_BLOCK: return VK_FORMAT_ASTC_6x5_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_6x6_SRGB_BLOCK: return VK_FORMAT_ASTC_6x6_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_8x5_SRGB_BLOCK: return VK_FORMAT_ASTC_8x5_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_8x6_SRGB_BLOCK: return VK_FORMAT_ASTC_8x6_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_8x8_SRGB_BLOCK: return VK_FORMAT_ASTC_8x8_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_10x5_SRGB_BLOCK: return VK_FORMAT_ASTC_10x5_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_10x6_SRGB_BLOCK: return VK_FORMAT_ASTC_10x6_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_10x8_SRGB_BLOCK: return VK_FORMAT_ASTC_10x8_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_10x10_SRGB_BLOCK: return VK_FORMAT_ASTC_10x10_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_12x10_SRGB_BLOCK: return VK_FORMAT_ASTC_12x10_UNORM_BLOCK;
+        case VK_FORMAT_ASTC_12x12_SRGB_BLOCK: return VK_FORMAT_ASTC_12x12_UNORM_BLOCK;
+        default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+bool TextureFormats::isSampleable(const DeviceCapabilities& capabilities, VkFormat format) {
+    const auto requiredFeatures = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT |
+        VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+
+    return capabilities.hasOptimalTilingFeatures(format, requiredFeatures);
+}
+
+uint16_t TextureFormats::toHalf(float value) {
+    const auto bits = std::bit_cast<uint32_t>(value);
+    const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const auto exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+    auto mantissa = bits & 0x007fffff;
+    if (((bits >> 23) & 0xff) == 0xff) {
+        // Infinities stay infinities, and NaNs stay NaNs.
+        return sign | 0x7c00 | (mantissa != 0 ? 0x0200 : 0);
+    }
+
+    if (exponent >= 31) {
+        return sign | 0x7c00;
+    }
+
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return sign;
+        }
+
+        // Subnormal halves keep the implicit leading bit in their mantissa.
+        mantissa |= 0x00800000;
+        const auto shift = static_cast<uint32_t>(14 - exponent);
+        auto half = mantissa >> shift;
+        const auto remainder = mantissa & ((1u << shift) - 1);
+        const auto halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1) != 0)) {
+            half++;
+        }
+
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    // Rounding up can carry into the exponent, which is still the nearest half.
+    auto half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    const auto remainder = mantissa & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0)) {
+        half++;
+    }
+
+    return sign | static_cast<uint16_t>(half);
+}
+
+float TextureFormats::fromHalf(uint16_t value) {
+    const auto sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    const auto exponent = static_cast<uint32_t>((value >> 10) & 0x1f);
+    const auto mantissa = static_cast<uint32_t>(value & 0x03ff);
+    if (exponent == 0) {
+        const auto magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+
+        return sign != 0 ? -magnitude : magnitude;
+    }
+
+    if (exponent == 31) {
+        return std::bit_cast<float>(sign | 0x7f800000 | (mantissa << 13));
+    }
+
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
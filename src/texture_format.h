@@ -0,0 +1,68 @@
+#ifndef _TEXTURE_FORMAT_H
+#define _TEXTURE_FORMAT_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <optional>
+
+#include "device_capabilities.h"
+
+
+namespace VulkanEngine {
+
+/// @brief The texel block layout of a texture format.
+///
+/// @note Uncompressed formats have 1x1 blocks. Block-compressed formats store every
+/// `blockWidth` by `blockHeight` texels in `blockSize` bytes, and a mip level occupies
+/// whole blocks even when its extent is not a multiple of the block extent.
+struct TextureFormatInfo final {
+    uint32_t blockWidth = 1;
+    uint32_t blockHeight = 1;
+    uint32_t blockSize = 0;
+
+    bool isCompressed() const {
+        return blockWidth > 1 || blockHeight > 1;
+    }
+
+    /// @brief The number of bytes a tightly packed `width` by `height` level takes up.
+    VkDeviceSize getLevelSize(uint32_t width, uint32_t height) const {
+        const auto blockCountX = VkDeviceSize { (width + blockWidth - 1) / blockWidth };
+        const auto blockCountY = VkDeviceSize { (height + blockHeight - 1) / blockHeight };
+
+        return blockCountX * blockCountY * blockSize;
+    }
+};
+
+/// @brief Format queries for the texture upload path.
+class TextureFormats final {
+    public:
+        explicit TextureFormats() = delete;
+
+        /// @brief The block layout of a format, or nothing when the texture path does not
+        /// know the format.
+        static std::optional<TextureFormatInfo> getInfo(VkFormat format);
+
+        /// @brief The UNORM format with the same texel layout as an sRGB format, or
+        /// `VK_FORMAT_UNDEFINED` when the format is not sRGB.
+        ///
+        /// @note Views of the UNORM format read and write the encoded values as they are
+        /// stored, which is how compute writes an sRGB image it cannot bind as storage.
+        static VkFormat getLinearFormat(VkFormat format);
+
+        /// @brief Whether an optimally tiled image of this format can be copied into and
+        /// sampled with linear filtering.
+        static bool isSampleable(const DeviceCapabilities& capabilities, VkFormat format);
+
+        /// @brief The nearest half precision float to `value`, with ties rounded to even.
+        ///
+        /// @note Values too large for half precision become infinities, and values too
+        /// small become subnormals or zero.
+        static uint16_t toHalf(float value);
+
+        static float fromHalf(uint16_t value);
+};
+
+}
+
+#endif // _TEXTURE_FORMAT_H
@@ -0,0 +1,273 @@
+#include "texture_packer.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+#include "json_reader.h"
+#include "texture_format.h"
+
+
+using TexturePacker = VulkanEngine::TexturePacker;
+using TexturePackTable = VulkanEngine::TexturePackTable;
+using TexturePacking = VulkanEngine::TexturePacking;
+using TexturePackerSettings = VulkanEngine::TexturePackerSettings;
+using TexturePage = VulkanEngine::TexturePage;
+using TexturePlacement = VulkanEngine::TexturePlacement;
+using PackedTextureSource = VulkanEngine::PackedTextureSource;
+using TextureFormats = VulkanEngine::TextureFormats;
+using JsonValue = VulkanEngine::JsonValue;
+using JsonReader = VulkanEngine::JsonReader;
+
+/// @brief The sources that share the format and the extent of the layers of their pages.
+struct PackGroup final {
+    VkFormat format;
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint32_t> sources;
+};
+
+static std::string escapeJsonString(const std::string& string) {
+    auto escaped = std::string {};
+    for (const auto character : string) {
+        if (character == '"' || character == '\\') {
+            escaped.push_back('\\');
+        }
+        escaped.push_back(character);
+    }
+
+    return escaped;
+}
+
+static const JsonValue& getMember(const JsonValue& object, std::string_view key, JsonValue::Type type) {
+    const auto* value = object.find(key);
+    if (value == nullptr || value->type != type) {
+        throw std::runtime_error(fmt::format("failed to load texture pack table: missing or malformed \"{}\"!", key));
+    }
+
+    return *value;
+}
+
+static glm::vec2 getVec2Member(const JsonValue& object, std::string_view key) {
+    const auto& elements = getMember(object, key, JsonValue::Type::Array).elements;
+    if (elements.size() != 2 || elements[0].type != JsonValue::Type::Number || elements[1].type != JsonValue::Type::Number) {
+        throw std::runtime_error(fmt::format("failed to load texture pack table: malformed \"{}\"!", key));
+    }
+
+    return glm::vec2 { static_cast<float>(elements[0].number), static_cast<float>(elements[1].number) };
+}
+
+TexturePacking TexturePacker::pack(std::span<const PackedTextureSource> sources, const TexturePackerSettings& settings) {
+    if (settings.maxExtent == 0 || settings.maxLayerCount == 0) {
+        throw std::invalid_argument("texture pages need a nonzero extent and layer count");
+    }
+
+    auto groups = std::vector<PackGroup> {};
+    for (uint32_t i = 0; i < sources.size(); i++) {
+        const auto& source = sources[i];
+        const auto formatInfo = TextureFormats::getInfo(source.format);
+        if (!formatInfo.has_value() || formatInfo->isCompressed()) {
+            continue;
+        }
+
+        if (source.width == 0 || source.height == 0 || std::max(source.width, source.height) > settings.maxExtent) {
+            continue;
+        }
+
+        const auto width = std::bit_ceil(source.width);
+        const auto height = std::bit_ceil(source.height);
+        auto group = std::find_if(groups.begin(), groups.end(), [&source, width, height](const PackGroup& group) {
+            return group.format == source.format && group.width == width && group.height == height;
+        });
+        if (group == groups.end()) {
+            group = groups.insert(groups.end(), PackGroup {
+                .format = source.format,
+                .width = width,
+                .height = height,
+                .sources = {},
+            });
+        }
+        group->sources.push_back(i);
+    }
+
+    auto packing = TexturePacking {};
+    packing.placements.resize(sources.size());
+    for (const auto& group : groups) {
+        if (group.sources.size() < 2) {
+            continue;
+        }
+
+        for (size_t first = 0; first < group.sources.size(); first += settings.maxLayerCount) {
+            const auto layerCount = static_cast<uint32_t>(std::min<size_t>(settings.maxLayerCount, group.sources.size() - first));
+            const auto pageIndex = static_cast<uint32_t>(packing.pages.size());
+            packing.pages.push_back(TexturePage {
+                .format = group.format,
+                .width = group.width,
+                .height = group.height,
+                .mipLevels = static_cast<uint32_t>(std::bit_width(std::max(group.width, group.height))),
+                .layerCount = layerCount,
+            });
+
+            for (uint32_t layer = 0; layer < layerCount; layer++) {
+                const auto sourceIndex = group.sources[first + layer];
+                const auto& source = sources[sourceIndex];
+                packing.placements[sourceIndex] = TexturePlacement {
+                    .page = pageIndex,
+                    .layer = layer,
+                    .uvScale = glm::vec2 {
+                        static_cast<float>(source.width) / static_cast<float>(group.width),
+                        static_cast<float>(source.height) / static_cast<float>(group.height)
+                    },
+                    .uvOffset = glm::vec2 { 0.0f },
+                };
+            }
+        }
+    }
+
+    return packing;
+}
+
+VkDeviceSize TexturePacker::getLayerSize(const TexturePage& page) {
+    return TextureFormats::getInfo(page.format)->getLevelSize(page.width, page.height);
+}
+
+void TexturePacker::copyLayer(
+    const TexturePage& page,
+    const TexturePlacement& placement,
+    const PackedTextureSource& source,
+    const uint8_t* sourceTexels,
+    uint8_t* pageTexels
+) {
+    if (source.format != page.format || source.width > page.width || source.height > page.height || placement.layer >= page.layerCount) {
+        throw std::invalid_argument("the texture does not fit its layer of the page");
+    }
+
+    // Uncompressed formats have blocks of a single texel.
+    const auto texelSize = size_t { TextureFormats::getInfo(page.format)->blockSize };
+    const auto sourceRowSize = size_t { source.width } * texelSize;
+    auto* layerTexels = pageTexels + placement.layer * TexturePacker::getLayerSize(page);
+    for (uint32_t y = 0; y < page.height; y++) {
+        const auto* sourceRow = sourceTexels + size_t { std::min(y, source.height - 1) } * sourceRowSize;
+        auto* row = layerTexels + size_t { y } * page.width * texelSize;
+        std::memcpy(row, sourceRow, sourceRowSize);
+
+        // The texels past the corner repeat its edge, so that the smaller levels, which
+        // average them in, do not darken its border.
+        const auto* lastTexel = sourceRow + sourceRowSize - texelSize;
+        for (uint32_t x = source.width; x < page.width; x++) {
+            std::memcpy(row + size_t { x } * texelSize, lastTexel, texelSize);
+        }
+    }
+}
+
+TexturePackTable TexturePackTable::load(const std::filesystem::path& path) {
+    auto file = std::ifstream { path, std::ios::in };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open texture pack table!");
+    }
+
+    const auto text = std::string { std::istreambuf_iterator<char> { file }, std::istreambuf_iterator<char> {} };
+    auto reader = JsonReader { text };
+    const auto document = reader.parseDocument();
+    if (getMember(document, "version", JsonValue::Type::Number).number != FILE_VERSION) {
+        throw std::runtime_error("failed to load texture pack table: not a table of this version!");
+    }
+
+    auto table = TexturePackTable {};
+    for (const auto& pageFile : getMember(document, "pages", JsonValue::Type::Array).elements) {
+        if (pageFile.type != JsonValue::Type::String) {
+            throw std::runtime_error("failed to load texture pack table: malformed page!");
+        }
+
+        table.addPage(pageFile.string);
+    }
+
+    for (const auto& texture : getMember(document, "textures", JsonValue::Type::Array).elements) {
+        const auto placement = TexturePlacement {
+            .page = static_cast<uint32_t>(getMember(texture, "page", JsonValue::Type::Number).number),
+            .layer = static_cast<uint32_t>(getMember(texture, "layer", JsonValue::Type::Number).number),
+            .uvScale = getVec2Member(texture, "uvScale"),
+            .uvOffset = getVec2Member(texture, "uvOffset"),
+        };
+        if (placement.page >= table.m_pageFiles.size()) {
+            throw std::runtime_error("failed to load texture pack table: placement on a page it does not list!");
+        }
+
+        table.addPlacement(getMember(texture, "source", JsonValue::Type::String).string, placement);
+    }
+
+    return table;
+}
+
+void TexturePackTable::save(const std::filesystem::path& path) const {
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+
+    auto file = std::ofstream { path, std::ios::out | std::ios::trunc };
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open texture pack table for writing!");
+    }
+
+    file << "{\n";
+    file << fmt::format("  \"version\": {},\n", FILE_VERSION);
+    file << "  \"pages\": [";
+    for (size_t i = 0; i < m_pageFiles.size(); i++) {
+        file << fmt::format("{}\n    \"{}\"", i == 0 ? "" : ",", escapeJsonString(m_pageFiles[i]));
+    }
+    file << "\n  ],\n";
+    file << "  \"textures\": [";
+    auto isFirst = true;
+    for (const auto& [sourcePath, placement] : m_placements) {
+        file << fmt::format(
+            "{}\n    {{ \"source\": \"{}\", \"page\": {}, \"layer\": {}, \"uvScale\": [{}, {}], \"uvOffset\": [{}, {}] }}",
+            isFirst ? "" : ",",
+            escapeJsonString(sourcePath),
+            placement.page,
+            placement.layer,
+            placement.uvScale.x,
+            placement.uvScale.y,
+            placement.uvOffset.x,
+            placement.uvOffset.y
+        );
+        isFirst = false;
+    }
+    file << "\n  ]\n}\n";
+
+    if (!file) {
+        throw std::runtime_error("failed to write texture pack table!");
+    }
+}
+
+uint32_t TexturePackTable::addPage(const std::string& filePath) {
+    m_pageFiles.push_back(TexturePackTable::normalizePath(filePath));
+
+    return static_cast<uint32_t>(m_pageFiles.size() - 1);
+}
+
+void TexturePackTable::addPlacement(const std::string& sourcePath, const TexturePlacement& placement) {
+    m_placements.insert_or_assign(TexturePackTable::normalizePath(sourcePath), placement);
+}
+
+std::optional<TexturePlacement> TexturePackTable::find(const std::string& sourcePath) const {
+    const auto placement = m_placements.find(TexturePackTable::normalizePath(sourcePath));
+    if (placement == m_placements.end()) {
+        return std::nullopt;
+    }
+
+    return placement->second;
+}
+
+const std::vector<std::string>& TexturePackTable::getPageFiles() const {
+    return m_pageFiles;
+}
+
+std::string TexturePackTable::normalizePath(const std::string& filePath) {
+    return std::filesystem::path { filePath }.lexically_normal().generic_string();
+}
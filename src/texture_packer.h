@@ -0,0 +1,141 @@
+#ifndef _TEXTURE_PACKER_H
+#define _TEXTURE_PACKER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+
+namespace VulkanEngine {
+
+/// @brief The format and extent of level 0 of a texture handed to `TexturePacker`.
+struct PackedTextureSource final {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+/// @brief The layer of a page a texture was packed into, and how its texture coordinates
+/// map into the part of the layer it fills.
+struct TexturePlacement final {
+    uint32_t page = 0;
+    uint32_t layer = 0;
+    glm::vec2 uvScale = glm::vec2 { 1.0f };
+    glm::vec2 uvOffset = glm::vec2 { 0.0f };
+
+    glm::vec2 remap(const glm::vec2& texCoord) const {
+        return texCoord * uvScale + uvOffset;
+    }
+};
+
+/// @brief A 2D array image that holds packed textures of one format, one per layer, each
+/// with a mip chain of its own.
+struct TexturePage final {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipLevels = 1;
+    uint32_t layerCount = 0;
+};
+
+struct TexturePackerSettings final {
+    /// @brief The largest side of a texture that is packed. Larger textures keep an image
+    /// of their own.
+    uint32_t maxExtent = 256;
+    /// @brief The most layers of a page, at most the `maxImageArrayLayers` of the device.
+    uint32_t maxLayerCount = 256;
+};
+
+struct TexturePacking final {
+    std::vector<TexturePage> pages;
+    /// @brief The placement of every source, in the order of the sources, or nothing for a
+    /// source that is not packed.
+    std::vector<std::optional<TexturePlacement>> placements;
+};
+
+/// @brief Packs small textures of the same format into the layers of 2D array pages, so
+/// that thousands of them take a handful of images, allocations and mip generation
+/// passes rather than one of each apiece.
+///
+/// @note Textures are grouped by format and by their extent rounded up to powers of two,
+/// and every group fills pages of up to `TexturePackerSettings::maxLayerCount` layers of
+/// that extent, in the order of the sources. A texture whose sides are powers of two fills
+/// its layer, so its texture coordinates stay as they are, and it still repeats. Any
+/// other texture fills the corner of its layer, with its last row and column repeated
+/// over the rest, and its texture coordinates are scaled into that corner, so they have to
+/// stay within [0, 1]. The mips of a page are generated from level 0 of every layer,
+/// layer by layer, as `MipmapTarget` does for array images.
+///
+/// Only uncompressed formats are packed, since the corner of a block-compressed layer
+/// would have to end on a block boundary. A group of a single texture is not packed
+/// either, since a page of one layer saves nothing.
+class TexturePacker final {
+    public:
+        explicit TexturePacker() = delete;
+
+        static TexturePacking pack(std::span<const PackedTextureSource> sources, const TexturePackerSettings& settings);
+
+        /// @brief The bytes of level 0 of one layer of `page`, which its layers follow each
+        /// other at.
+        static VkDeviceSize getLayerSize(const TexturePage& page);
+
+        /// @brief Copy the tightly packed level 0 of `source` into its layer of the level 0 of
+        /// `page`, which `pageTexels` holds layer after layer.
+        static void copyLayer(
+            const TexturePage& page,
+            const TexturePlacement& placement,
+            const PackedTextureSource& source,
+            const uint8_t* sourceTexels,
+            uint8_t* pageTexels
+        );
+};
+
+/// @brief The placements of the textures a bake packed, by the path of their sources, and
+/// the files their pages were written to.
+///
+/// @note The table is written as JSON next to the pages, so that the mesh bake can remap
+/// the texture coordinates of the models that sample a packed texture. Paths are compared
+/// in their lexically normal generic form.
+class TexturePackTable final {
+    public:
+        static constexpr uint32_t FILE_VERSION = 1;
+
+        explicit TexturePackTable() = default;
+
+        ~TexturePackTable() = default;
+
+        static TexturePackTable load(const std::filesystem::path& path);
+
+        void save(const std::filesystem::path& path) const;
+
+        /// @brief Add the file of the next page, and return its index.
+        uint32_t addPage(const std::string& filePath);
+
+        void addPlacement(const std::string& sourcePath, const TexturePlacement& placement);
+
+        /// @brief The placement of the texture packed from `sourcePath`, or nothing when it
+        /// was not packed.
+        std::optional<TexturePlacement> find(const std::string& sourcePath) const;
+
+        const std::vector<std::string>& getPageFiles() const;
+    private:
+        std::vector<std::string> m_pageFiles;
+        std::map<std::string, TexturePlacement> m_placements;
+
+        static std::string normalizePath(const std::string& filePath);
+};
+
+}
+
+#endif // _TEXTURE_PACKER_H
@@ -0,0 +1,388 @@
+#include "texture_streamer.h"
+#include "texture_format.h"
+
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+
+using TextureStreamer = VulkanEngine::TextureStreamer;
+
+TextureStreamer::TextureStreamer(VkDevice device, UploadContext& uploadContext, VkImage image, TextureCacheEntry mipChain)
+    : m_device { device }
+    , m_uploadContext { uploadContext }
+    , m_sparseTexture { nullptr }
+    , m_image { image }
+    , m_mipChain { std::move(mipChain) }
+    , m_imageViews { std::vector<VkImageView> {} }
+    , m_samplers { std::vector<VkSampler> {} }
+    , m_baseResidentLevel { 0 }
+    , m_residentLevel { 0 }
+    , m_requestedLevel { 0 }
+    , m_hasPendingUpload { false }
+    , m_pendingLevel { 0 }
+    , m_pendingTimelineValue { 0 }
+    , m_blockHeight { 1 }
+    , m_isLevelInProgress { false }
+    , m_uploadedRowCount { 0 }
+    , m_pendingBindValue {}
+    , m_framesInFlight { 0 }
+    , m_updateCount { 0 }
+    , m_pendingEvictions { std::vector<std::tuple<uint32_t, uint64_t>> {} }
+{
+    if (m_mipChain.levels.empty()) {
+        throw std::invalid_argument("a streamed texture needs at least one mip level!");
+    }
+
+    // A format the texture path does not know is uploaded a whole level at a time.
+    const auto formatInfo = TextureFormats::getInfo(m_mipChain.format);
+    m_blockHeight = formatInfo.has_value() ? formatInfo->blockHeight : 0;
+
+    m_baseResidentLevel = this->getMipLevels();
+    m_residentLevel = this->getMipLevels();
+    m_requestedLevel = this->getMipLevels();
+
+    // Each view starts at a level and runs to the end of the chain, so that frames only
+    // reach levels that are in the shader read-only layout.
+    m_imageViews.reserve(this->getMipLevels());
+    for (uint32_t level = 0; level < this->getMipLevels(); level++) {
+        const auto viewInfo = VkImageViewCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = m_image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = m_mipChain.format,
+            .components = VkComponentMapping { VK_COMPONENT_SWIZZLE_IDENTITY },
+            .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .subresourceRange.baseMipLevel = level,
+            .subresourceRange.levelCount = this->getMipLevels() - level,
+            .subresourceRange.baseArrayLayer = 0,
+            .subresourceRange.layerCount = 1,
+        };
+
+        auto imageView = VkImageView {};
+        const auto result = vkCreateImageView(m_device, &viewInfo, nullptr, &imageView);
+        if (result != VK_SUCCESS) {
+            for (const auto createdImageView : m_imageViews) {
+                vkDestroyImageView(m_device, createdImageView, nullptr);
+            }
+
+            throw std::runtime_error("failed to create streamed texture image view!");
+        }
+
+        m_imageViews.push_back(imageView);
+    }
+}
+
+TextureStreamer::TextureStreamer(
+    VkDevice device,
+    UploadContext& uploadContext,
+    std::unique_ptr<SparseTexture> sparseTexture,
+    TextureCacheEntry mipChain,
+    uint32_t framesInFlight
+)
+    : TextureStreamer { device, uploadContext, sparseTexture->getImage(), std::move(mipChain) }
+{
+    m_sparseTexture = std::move(sparseTexture);
+    m_framesInFlight = framesInFlight;
+}
+
+TextureStreamer::~TextureStreamer() {
+    for (const auto imageView : m_imageViews) {
+        vkDestroyImageView(m_device, imageView, nullptr);
+    }
+
+    m_imageViews.clear();
+    m_samplers.clear();
+    m_sparseTexture.reset();
+    m_image = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void TextureStreamer::beginStreaming(UploadBatch& uploadBatch, uint32_t residentLevelCount) {
+    const auto mipLevels = this->getMipLevels();
+    const auto firstLevel = mipLevels - std::clamp(residentLevelCount, 1u, mipLevels);
+
+    if (m_sparseTexture != nullptr) {
+        // The mip tail is always resident, so only the levels above it need pages.
+        for (uint32_t level = firstLevel; level < std::min(m_sparseTexture->getMipTailFirstLevel(), mipLevels); level++) {
+            const auto bindValue = m_sparseTexture->makeLevelResident(level);
+            if (!bindValue.has_value()) {
+                throw std::runtime_error("failed to make sparse texture levels resident: the memory budget is too small!");
+            }
+
+            uploadBatch.waitForSemaphore(m_sparseTexture->getBindSemaphore(), *bindValue);
+        }
+    }
+
+    // The levels get smaller towards the end of the chain, so the resident levels are one
+    // contiguous range at the end of the texel data.
+    const auto firstOffset = m_mipChain.levels[firstLevel].offset;
+    const auto& lastLevel = m_mipChain.levels.back();
+    const auto stagingSlice = uploadBatch.stage(m_mipChain.data.data() + firstOffset, lastLevel.offset + lastLevel.size - firstOffset);
+
+    auto copyRegions = std::vector<VkBufferImageCopy> {};
+    copyRegions.reserve(mipLevels - firstLevel);
+    for (uint32_t level = firstLevel; level < mipLevels; level++) {
+        copyRegions.push_back(this->createCopyRegion(level, m_mipChain.levels[level].offset - firstOffset));
+    }
+
+    // Every level moves to the shader read-only layout, including the ones that are still
+    // empty, so streamed levels all start out from the same layout.
+    uploadBatch.transitionImageLayout(
+        m_image,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        mipLevels
+    );
+    uploadBatch.copyBufferToImage(stagingSlice, m_image, copyRegions);
+    uploadBatch.transitionImageLayout(
+        m_image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        mipLevels
+    );
+
+    m_baseResidentLevel = firstLevel;
+    m_residentLevel = firstLevel;
+    m_requestedLevel = firstLevel;
+}
+
+void TextureStreamer::createSamplers(SamplerCache& samplerCache, const VkSamplerCreateInfo& samplerInfo) {
+    auto samplers = std::vector<VkSampler> {};
+    samplers.reserve(this->getMipLevels());
+    for (uint32_t level = 0; level < this->getMipLevels(); level++) {
+        // The view of the level starts at it, so LOD 0 of the view is the level itself.
+        auto levelSamplerInfo = samplerInfo;
+        levelSamplerInfo.minLod = std::max(samplerInfo.minLod - static_cast<float>(level), 0.0f);
+        levelSamplerInfo.maxLod = std::max(samplerInfo.maxLod - static_cast<float>(level), levelSamplerInfo.minLod);
+
+        samplers.push_back(samplerCache.getSampler(levelSamplerInfo));
+    }
+
+    m_samplers = std::move(samplers);
+}
+
+void TextureStreamer::requestLevel(uint32_t level) {
+    m_requestedLevel = std::min(level, this->getMipLevels() - 1);
+}
+
+void TextureStreamer::update(UploadScheduler& uploadScheduler) {
+    m_updateCount++;
+    this->evictRetiredLevels();
+
+    // A level that is partly submitted finishes before the requested level is looked at.
+    if (m_isLevelInProgress) {
+        this->uploadNextRows(uploadScheduler);
+
+        return;
+    }
+
+    if (m_hasPendingUpload) {
+        if (!m_uploadContext.isComplete(m_pendingTimelineValue)) {
+            return;
+        }
+
+        m_residentLevel = m_pendingLevel;
+        m_hasPendingUpload = false;
+    }
+
+    // A dense image never evicts levels. Asking for less detail only stops further levels
+    // from streaming in.
+    if (m_sparseTexture != nullptr && m_requestedLevel > m_residentLevel) {
+        this->coarsenResidentLevel(m_requestedLevel);
+
+        return;
+    }
+
+    if (m_requestedLevel >= m_residentLevel) {
+        return;
+    }
+
+    const auto level = m_residentLevel - 1;
+    auto bindValue = std::optional<uint64_t> {};
+    if (m_sparseTexture != nullptr) {
+        // A level that is still waiting for eviction keeps its pages and its texels, and so
+        // does a level in the mip tail, which is never unbound.
+        if (this->cancelEviction(level) || m_sparseTexture->isLevelResident(level)) {
+            m_residentLevel = level;
+
+            return;
+        }
+
+        bindValue = m_sparseTexture->makeLevelResident(level);
+        if (!bindValue.has_value()) {
+            // The page pool is out of budget. Try again once evictions have freed pages.
+            return;
+        }
+    }
+
+    m_pendingLevel = level;
+    m_isLevelInProgress = true;
+    m_uploadedRowCount = 0;
+    m_pendingBindValue = bindValue;
+    this->uploadNextRows(uploadScheduler);
+}
+
+void TextureStreamer::uploadNextRows(UploadScheduler& uploadScheduler) {
+    const auto& mipLevel = m_mipChain.levels[m_pendingLevel];
+    const auto rowCount = this->getRowCount(m_pendingLevel);
+    const auto rowSize = mipLevel.size / rowCount;
+    const auto remainingRowCount = rowCount - m_uploadedRowCount;
+    const auto budgetRowCount = static_cast<uint32_t>(std::min<VkDeviceSize>(uploadScheduler.getRemainingBytes() / rowSize, remainingRowCount));
+    const auto chunkRowCount = std::max(budgetRowCount, 1u);
+    if (!uploadScheduler.tryReserve(chunkRowCount * rowSize, 1)) {
+        return;
+    }
+
+    auto uploadBatch = m_uploadContext.beginBatch();
+    const auto isFirstPart = m_uploadedRowCount == 0;
+    const auto isLastPart = chunkRowCount == remainingRowCount;
+    if (isFirstPart && m_pendingBindValue.has_value()) {
+        uploadBatch.waitForSemaphore(m_sparseTexture->getBindSemaphore(), *m_pendingBindValue);
+    }
+
+    // The rows of a level are tightly packed, so a range of them is one contiguous range of
+    // its texel data. A level that is not split is one row as high as the level.
+    const auto rowHeight = rowCount == 1 ? mipLevel.height : m_blockHeight;
+    const auto firstTexelRow = m_uploadedRowCount * rowHeight;
+    auto copyRegion = this->createCopyRegion(m_pendingLevel, 0);
+    copyRegion.imageOffset.y = static_cast<int32_t>(firstTexelRow);
+    copyRegion.imageExtent.height = std::min(chunkRowCount * rowHeight, mipLevel.height - firstTexelRow);
+
+    const auto stagingSlice = uploadBatch.stage(
+        m_mipChain.data.data() + mipLevel.offset + m_uploadedRowCount * rowSize,
+        chunkRowCount * rowSize
+    );
+    uploadBatch.updateImageLevelsPart(
+        stagingSlice,
+        m_image,
+        m_pendingLevel,
+        1,
+        std::span<const VkBufferImageCopy> { &copyRegion, 1 },
+        isFirstPart,
+        isLastPart
+    );
+
+    m_pendingTimelineValue = m_uploadContext.submit(uploadBatch);
+    m_uploadedRowCount += chunkRowCount;
+    if (isLastPart) {
+        m_isLevelInProgress = false;
+        m_pendingBindValue.reset();
+        m_hasPendingUpload = true;
+    }
+}
+
+void TextureStreamer::releaseEvictedMemory() {
+    if (m_sparseTexture != nullptr) {
+        m_sparseTexture->releaseFreePages();
+    }
+}
+
+uint32_t TextureStreamer::getWidth() const {
+    return m_mipChain.width;
+}
+
+uint32_t TextureStreamer::getHeight() const {
+    return m_mipChain.height;
+}
+
+uint32_t TextureStreamer::getMipLevels() const {
+    return static_cast<uint32_t>(m_mipChain.levels.size());
+}
+
+uint32_t TextureStreamer::getResidentLevel() const {
+    return m_residentLevel;
+}
+
+bool TextureStreamer::isStreaming() const {
+    // A dense image never evicts, so asking it for less detail leaves nothing to do.
+    const auto isCoarsening = m_sparseTexture != nullptr && m_requestedLevel > m_residentLevel;
+
+    return m_isLevelInProgress
+        || m_hasPendingUpload
+        || !m_pendingEvictions.empty()
+        || m_requestedLevel < m_residentLevel
+        || isCoarsening;
+}
+
+VkSampler TextureStreamer::getSampler() const {
+    return m_samplers.at(std::min(m_residentLevel, this->getMipLevels() - 1));
+}
+
+VkImageView TextureStreamer::getImageView() const {
+    return m_imageViews.at(std::min(m_residentLevel, this->getMipLevels() - 1));
+}
+
+VkImage TextureStreamer::getImage() const {
+    return m_image;
+}
+
+VkBufferImageCopy TextureStreamer::createCopyRegion(uint32_t level, VkDeviceSize bufferOffset) const {
+    const auto& mipLevel = m_mipChain.levels[level];
+    const auto copyRegion = VkBufferImageCopy {
+        .bufferOffset = bufferOffset,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .imageSubresource.mipLevel = level,
+        .imageSubresource.baseArrayLayer = 0,
+        .imageSubresource.layerCount = 1,
+        .imageOffset = VkOffset3D { 0, 0, 0 },
+        .imageExtent = VkExtent3D { mipLevel.width, mipLevel.height, 1 },
+    };
+
+    return copyRegion;
+}
+
+uint32_t TextureStreamer::getRowCount(uint32_t level) const {
+    const auto& mipLevel = m_mipChain.levels[level];
+    if (m_blockHeight == 0) {
+        return 1;
+    }
+
+    // Only a level whose rows all take the same bytes can be split at row boundaries.
+    const auto rowCount = (mipLevel.height + m_blockHeight - 1) / m_blockHeight;
+    if (rowCount == 0 || mipLevel.size % rowCount != 0) {
+        return 1;
+    }
+
+    return rowCount;
+}
+
+void TextureStreamer::coarsenResidentLevel(uint32_t level) {
+    // The levels uploaded by `beginStreaming` stay resident, so there is always something
+    // to sample.
+    const auto coarsestLevel = std::min(level, m_baseResidentLevel);
+    for (uint32_t evictedLevel = m_residentLevel; evictedLevel < coarsestLevel; evictedLevel++) {
+        m_pendingEvictions.push_back(std::make_tuple(evictedLevel, m_updateCount));
+    }
+
+    m_residentLevel = std::max(m_residentLevel, coarsestLevel);
+}
+
+void TextureStreamer::evictRetiredLevels() {
+    // A level stops being sampled once every frame in flight has picked up the coarser
+    // sampler, which takes at most `m_framesInFlight` updates.
+    const auto isRetired = [this](const auto& pendingEviction) {
+        const auto& [level, updateCount] = pendingEviction;
+        if (m_updateCount >= updateCount + m_framesInFlight) {
+            m_sparseTexture->evictLevel(level);
+
+            return true;
+        } else {
+            return false;
+        }
+    };
+
+    std::erase_if(m_pendingEvictions, isRetired);
+}
+
+bool TextureStreamer::cancelEviction(uint32_t level) {
+    const auto isLevel = [level](const auto& pendingEviction) {
+        return std::get<0>(pendingEviction) == level;
+    };
+
+    return std::erase_if(m_pendingEvictions, isLevel) > 0;
+}
@@ -0,0 +1,146 @@
+#ifndef _TEXTURE_STREAMER_H
+#define _TEXTURE_STREAMER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+#include "sampler_cache.h"
+#include "sparse_texture.h"
+#include "texture_cache.h"
+#include "upload_batch.h"
+#include "upload_scheduler.h"
+
+
+namespace VulkanEngine {
+
+/// @brief Streams the mip levels of a texture into its image on demand.
+///
+/// @note Only the smallest levels of the chain are uploaded with the initial batch. The
+/// detailed levels follow one at a time, from the smallest up, whenever the renderer asks
+/// for a more detailed level than the image holds. Each level goes out in upload batches
+/// of its own, so a level never holds up the frames that do not need it, and a level larger
+/// than the upload budget of a frame goes out a range of rows at a time, at most one range
+/// per frame, so that it never makes a frame spike.
+///
+/// Levels that have not arrived yet are never sampled, nor reached by the view that is.
+/// Every resident level has an image view that starts at it and a sampler for that view,
+/// and `getImageView` and `getSampler` return those of the most detailed level that has
+/// finished uploading. A level that is streaming in changes layout outside of every view
+/// that frames sample, and the view only widens to it once its upload has completed.
+///
+/// A dense image is allocated for the whole chain up front, so streaming shortens the time
+/// to the first frame but does not lower the memory footprint of the image. A sparse texture
+/// only backs the levels that are resident, and levels the view no longer needs are evicted
+/// to make room for others. Evicted levels are unbound `framesInFlight` updates after the
+/// sampler stops reaching them, once no frame in flight can still sample them.
+class TextureStreamer final {
+    public:
+        explicit TextureStreamer() = delete;
+        explicit TextureStreamer(VkDevice device, UploadContext& uploadContext, VkImage image, TextureCacheEntry mipChain);
+        explicit TextureStreamer(
+            VkDevice device,
+            UploadContext& uploadContext,
+            std::unique_ptr<SparseTexture> sparseTexture,
+            TextureCacheEntry mipChain,
+            uint32_t framesInFlight
+        );
+
+        ~TextureStreamer();
+
+        /// @brief Record the upload of the `residentLevelCount` smallest levels and move the
+        /// whole image to the shader read-only layout.
+        ///
+        /// @note These levels are never evicted.
+        void beginStreaming(UploadBatch& uploadBatch, uint32_t residentLevelCount);
+
+        /// @brief Take one sampler per mip level from `samplerCache`, made from `samplerInfo`
+        /// with its LOD range moved to the image view of the level.
+        ///
+        /// @note The cache owns the samplers, so streamed textures that sample alike share them.
+        void createSamplers(SamplerCache& samplerCache, const VkSamplerCreateInfo& samplerInfo);
+
+        /// @brief Ask for `level` and every less detailed level to become resident.
+        void requestLevel(uint32_t level);
+
+        /// @brief Pick up finished uploads and submit the next rows of the level that is
+        /// streaming in, or of the next level, if one is requested, as far as the budget of
+        /// `uploadScheduler` goes. A sparse texture also retires the levels that fell out of
+        /// use.
+        ///
+        /// @note Call this once per frame. It only waits on the GPU when the staging ring is full.
+        void update(UploadScheduler& uploadScheduler);
+
+        /// @brief Give the memory of the evicted levels of a sparse texture back to its heap,
+        /// rather than keep it pooled for the levels that stream in next.
+        ///
+        /// @note Does nothing for a dense image, whose memory covers the whole chain.
+        void releaseEvictedMemory();
+
+        uint32_t getWidth() const;
+
+        uint32_t getHeight() const;
+
+        uint32_t getMipLevels() const;
+
+        /// @brief The most detailed mip level that can be sampled.
+        uint32_t getResidentLevel() const;
+
+        /// @brief Whether later updates still have work to do: levels to upload or to wait
+        /// for, or levels to evict.
+        bool isStreaming() const;
+
+        VkSampler getSampler() const;
+
+        /// @brief The view of the most detailed mip level that can be sampled, and of every
+        /// level below it.
+        VkImageView getImageView() const;
+
+        VkImage getImage() const;
+    private:
+        VkDevice m_device;
+        UploadContext& m_uploadContext;
+        std::unique_ptr<SparseTexture> m_sparseTexture;
+        VkImage m_image;
+        TextureCacheEntry m_mipChain;
+        std::vector<VkImageView> m_imageViews;
+        std::vector<VkSampler> m_samplers;
+        uint32_t m_baseResidentLevel;
+        uint32_t m_residentLevel;
+        uint32_t m_requestedLevel;
+        bool m_hasPendingUpload;
+        uint32_t m_pendingLevel;
+        uint64_t m_pendingTimelineValue;
+        /// @brief The block height of the format, which rows are uploaded in multiples of.
+        uint32_t m_blockHeight;
+        /// @brief Whether rows of `m_pendingLevel` are still to be submitted, how many
+        /// were, and the sparse bind the first of them waits for.
+        bool m_isLevelInProgress;
+        uint32_t m_uploadedRowCount;
+        std::optional<uint64_t> m_pendingBindValue;
+        uint32_t m_framesInFlight;
+        uint64_t m_updateCount;
+        std::vector<std::tuple<uint32_t, uint64_t>> m_pendingEvictions;
+
+        VkBufferImageCopy createCopyRegion(uint32_t level, VkDeviceSize bufferOffset) const;
+
+        /// @brief The rows of blocks of `level`, which the level is split into for uploads.
+        uint32_t getRowCount(uint32_t level) const;
+
+        /// @brief Submit the next rows of `m_pendingLevel` that fit the budget.
+        void uploadNextRows(UploadScheduler& uploadScheduler);
+
+        void coarsenResidentLevel(uint32_t level);
+
+        void evictRetiredLevels();
+
+        bool cancelEviction(uint32_t level);
+};
+
+}
+
+#endif // _TEXTURE_STREAMER_H
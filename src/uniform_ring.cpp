@@ -0,0 +1,109 @@
+#include "uniform_ring.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+
+using UniformRing = VulkanEngine::UniformRing;
+
+UniformRing::UniformRing(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    uint32_t frameCount,
+    VkDeviceSize frameCapacity,
+    VkDeviceSize minOffsetAlignment,
+    VkBufferUsageFlags additionalUsage
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_buffer { VK_NULL_HANDLE }
+    , m_allocation {}
+    , m_frameCount { frameCount }
+    , m_frameCapacity { 0 }
+    , m_alignment { std::max<VkDeviceSize>(minOffsetAlignment, 1) }
+    , m_frameIndex { 0 }
+    , m_head { 0 }
+{
+    if (frameCount == 0) {
+        throw std::invalid_argument("a uniform ring needs at least one frame!");
+    }
+
+    // Every region starts aligned, so the slices in it only need aligning within it.
+    m_frameCapacity = (frameCapacity + m_alignment - 1) / m_alignment * m_alignment;
+
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = m_frameCapacity * m_frameCount,
+        .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | additionalUsage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    auto buffer = VkBuffer {};
+    const auto resultCreateBuffer = vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer);
+    if (resultCreateBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to create uniform ring buffer!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+    const auto allocation = m_allocator.allocate(
+        memRequirements,
+        m_allocator.selectDynamicMemoryProperties(memRequirements.memoryTypeBits),
+        GpuResourceKind::Linear,
+        GpuMemoryCategory::Uniform
+    );
+
+    vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+    m_buffer = buffer;
+    m_allocation = allocation;
+}
+
+UniformRing::~UniformRing() {
+    vkDestroyBuffer(m_device, m_buffer, nullptr);
+    m_allocator.free(m_allocation);
+
+    m_buffer = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void UniformRing::beginFrame(uint32_t frameIndex) {
+    if (frameIndex >= m_frameCount) {
+        throw std::invalid_argument {
+            fmt::format("Frame {} is out of range for a uniform ring of {} frames", frameIndex, m_frameCount)
+        };
+    }
+
+    m_frameIndex = frameIndex;
+    m_head = 0;
+}
+
+VulkanEngine::UniformSlice UniformRing::allocate(VkDeviceSize size) {
+    const auto alignedHead = (m_head + m_alignment - 1) / m_alignment * m_alignment;
+    if (alignedHead + size > m_frameCapacity) {
+        throw std::runtime_error {
+            fmt::format("Uniform request of {} bytes exceeds the {} bytes left in the frame", size, m_frameCapacity - alignedHead)
+        };
+    }
+
+    m_head = alignedHead + size;
+
+    const auto offset = m_frameIndex * m_frameCapacity + alignedHead;
+
+    return UniformSlice {
+        .offset = static_cast<uint32_t>(offset),
+        .size = size,
+        .mappedData = static_cast<char*>(m_allocation.mappedData) + offset,
+    };
+}
+
+VkBuffer UniformRing::getBuffer() const {
+    return m_buffer;
+}
+
+VkDeviceSize UniformRing::getFrameCapacity() const {
+    return m_frameCapacity;
+}
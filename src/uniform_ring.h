@@ -0,0 +1,79 @@
+#ifndef _UNIFORM_RING_H
+#define _UNIFORM_RING_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+#include "gpu_memory_allocator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief A slice of the uniform ring that the host writes uniform data into, and that a
+/// draw binds by passing its offset as the dynamic offset of a dynamic uniform buffer.
+struct UniformSlice final {
+    uint32_t offset = 0;
+    VkDeviceSize size = 0;
+    void* mappedData = nullptr;
+};
+
+/// @brief A persistently mapped, host-visible uniform buffer with one region for every
+/// frame in flight, out of which the slices of a frame are handed out linearly.
+///
+/// @note A single `UNIFORM_BUFFER_DYNAMIC` descriptor over the buffer serves every slice,
+/// so uniform data for any number of draws needs no buffers or descriptor sets of its own.
+/// Slices are aligned to `minUniformBufferOffsetAlignment`. `beginFrame` reclaims the whole
+/// region of a frame at once, so it must only be called once the frame's previous submit
+/// has finished. A frame that allocates the same slices in the same order every time gets
+/// the same offsets every time, which keeps pre-recorded command buffers valid.
+///
+/// The buffer takes `additionalUsage` on top of its uniform buffer usage, such as a device
+/// address for descriptors written by address.
+class UniformRing final {
+    public:
+        static constexpr VkDeviceSize DEFAULT_FRAME_CAPACITY = 256 * 1024;
+
+        explicit UniformRing() = delete;
+        explicit UniformRing(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            uint32_t frameCount,
+            VkDeviceSize frameCapacity,
+            VkDeviceSize minOffsetAlignment,
+            VkBufferUsageFlags additionalUsage = 0
+        );
+
+        ~UniformRing();
+
+        UniformRing(const UniformRing& other) = delete;
+        UniformRing& operator=(const UniformRing& other) = delete;
+
+        /// @brief Start handing out slices of the region of `frameIndex`, reclaiming the
+        /// slices it handed out the last time.
+        void beginFrame(uint32_t frameIndex);
+
+        /// @brief Hand out `size` bytes of the region of the current frame.
+        ///
+        /// @note Throws when the region is full, since the GPU may still read every other
+        /// region.
+        UniformSlice allocate(VkDeviceSize size);
+
+        VkBuffer getBuffer() const;
+
+        VkDeviceSize getFrameCapacity() const;
+    private:
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        VkBuffer m_buffer;
+        GpuAllocation m_allocation;
+        uint32_t m_frameCount;
+        VkDeviceSize m_frameCapacity;
+        VkDeviceSize m_alignment;
+        uint32_t m_frameIndex;
+        VkDeviceSize m_head;
+};
+
+}
+
+#endif // _UNIFORM_RING_H
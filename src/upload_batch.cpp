@@ -0,0 +1,1081 @@
+#include "upload_batch.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "command_counters.h"
+#include "device_lost_error.h"
+
+
+using BarrierBatch = VulkanEngine::BarrierBatch;
+using QueueSubmission = VulkanEngine::QueueSubmission;
+using SemaphoreSubmit = VulkanEngine::SemaphoreSubmit;
+using UploadBatch = VulkanEngine::UploadBatch;
+using CommandCounter = VulkanEngine::CommandCounter;
+using CommandCounters = VulkanEngine::CommandCounters;
+using DeviceLostError = VulkanEngine::DeviceLostError;
+
+static VkImageSubresourceRange getColorSubresourceRange(uint32_t baseMipLevel, uint32_t levelCount, uint32_t layerCount = 1) {
+    return VkImageSubresourceRange {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = baseMipLevel,
+        .levelCount = levelCount,
+        .baseArrayLayer = 0,
+        .layerCount = layerCount,
+    };
+}
+
+UploadBatch::UploadBatch(
+    const DeviceCapabilities& capabilities,
+    VkCommandBuffer transferCommandBuffer,
+    uint32_t transferQueueFamilyIndex,
+    VkCommandBuffer graphicsCommandBuffer,
+    uint32_t graphicsQueueFamilyIndex,
+    StagingRing& stagingRing,
+    MipmapGenerator* mipmapGenerator,
+    bool useSynchronization2
+)
+    : m_capabilities { capabilities }
+    , m_transferCommandBuffer { transferCommandBuffer }
+    , m_transferQueueFamilyIndex { transferQueueFamilyIndex }
+    , m_graphicsCommandBuffer { graphicsCommandBuffer }
+    , m_graphicsQueueFamilyIndex { graphicsQueueFamilyIndex }
+    , m_stagingRing { stagingRing }
+    , m_mipmapGenerator { mipmapGenerator }
+    , m_transferBarriers { BarrierBatch { useSynchronization2 } }
+    , m_graphicsBarriers { BarrierBatch { useSynchronization2 } }
+    , m_deferredDestructions { std::vector<std::function<void()>> {} }
+    , m_semaphoreWaits { std::vector<UploadSemaphoreWait> {} }
+    , m_commandCount { 0 }
+    , m_stagedSize { 0 }
+{
+}
+
+VkCommandBuffer UploadBatch::getCommandBuffer() {
+    this->flushBarriers(m_graphicsCommandBuffer);
+
+    return m_graphicsCommandBuffer;
+}
+
+VkCommandBuffer UploadBatch::getTransferCommandBuffer() const {
+    return m_transferCommandBuffer;
+}
+
+bool UploadBatch::hasOwnershipTransfer() const {
+    return m_transferQueueFamilyIndex != m_graphicsQueueFamilyIndex;
+}
+
+VulkanEngine::StagingSlice UploadBatch::stage(const void* data, VkDeviceSize size, VkDeviceSize alignment) {
+    const auto stagingSlice = this->reserve(size, alignment);
+    memcpy(stagingSlice.mappedData, data, static_cast<size_t>(size));
+
+    return stagingSlice;
+}
+
+VulkanEngine::StagingSlice UploadBatch::reserve(VkDeviceSize size, VkDeviceSize alignment) {
+    m_stagedSize += size;
+    CommandCounters::add(CommandCounter::UploadedBytes, size);
+
+    return m_stagingRing.allocate(size, alignment);
+}
+
+void UploadBatch::copyBuffer(const StagingSlice& source, VkBuffer destination, VkDeviceSize destinationOffset) {
+    const auto copyRegion = VkBufferCopy {
+        .srcOffset = source.offset,
+        .dstOffset = destinationOffset,
+        .size = source.size,
+    };
+    this->flushBarriers(m_transferCommandBuffer);
+    vkCmdCopyBuffer(m_transferCommandBuffer, source.buffer, destination, 1, &copyRegion);
+
+    if (this->hasOwnershipTransfer()) {
+        this->transferBufferOwnership(destination, destinationOffset, source.size);
+    }
+
+    m_commandCount++;
+}
+
+void UploadBatch::copyBufferToBuffer(VkBuffer source, VkBuffer destination, VkDeviceSize size) {
+    const auto copyRegion = VkBufferCopy {
+        .srcOffset = 0,
+        .dstOffset = 0,
+        .size = size,
+    };
+    this->flushBarriers(m_graphicsCommandBuffer);
+    vkCmdCopyBuffer(m_graphicsCommandBuffer, source, destination, 1, &copyRegion);
+
+    m_commandCount++;
+}
+
+void UploadBatch::copyBufferToImage(
+    const StagingSlice& source,
+    VkImage destination,
+    uint32_t width,
+    uint32_t height,
+    uint32_t depth,
+    uint32_t layerCount
+) {
+    const auto region = VkBufferImageCopy {
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .imageSubresource.mipLevel = 0,
+        .imageSubresource.baseArrayLayer = 0,
+        .imageSubresource.layerCount = layerCount,
+        .imageOffset = VkOffset3D { 0, 0, 0 },
+        .imageExtent = VkExtent3D { width, height, depth },
+    };
+
+    this->copyBufferToImage(source, destination, std::span<const VkBufferImageCopy> { &region, 1 });
+}
+
+void UploadBatch::copyBufferToImage(const StagingSlice& source, VkImage destination, std::span<const VkBufferImageCopy> regions) {
+    auto stagingRegions = std::vector<VkBufferImageCopy> { regions.begin(), regions.end() };
+    for (auto& region : stagingRegions) {
+        region.bufferOffset += source.offset;
+    }
+
+    this->flushBarriers(m_transferCommandBuffer);
+    vkCmdCopyBufferToImage(
+        m_transferCommandBuffer,
+        source.buffer,
+        destination,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(stagingRegions.size()),
+        stagingRegions.data()
+    );
+
+    if (this->hasOwnershipTransfer()) {
+        this->transferImageOwnership(destination, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    }
+
+    m_commandCount++;
+}
+
+void UploadBatch::copyImageToBuffer(
+    VkImage source,
+    uint32_t mipLevels,
+    VkBuffer destination,
+    std::span<const VkBufferImageCopy> regions,
+    uint32_t layerCount
+) {
+    // The image may have just been written by a copy, a blit chain, or the compute mipmap
+    // generator earlier in the batch, and the fragment shaders that sample it in the shader
+    // read-only layout have to finish before the layout changes.
+    this->addImageBarrier(m_graphicsCommandBuffer, VkImageMemoryBarrier2 {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = source,
+        .subresourceRange = getColorSubresourceRange(0, mipLevels, layerCount),
+    });
+    this->flushBarriers(m_graphicsCommandBuffer);
+
+    vkCmdCopyImageToBuffer(
+        m_graphicsCommandBuffer,
+        source,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        destination,
+        static_cast<uint32_t>(regions.size()),
+        regions.data()
+    );
+
+    this->addBufferBarrier(m_graphicsCommandBuffer, VkBufferMemoryBarrier2 {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+        .dstAccessMask = VK_ACCESS_2_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = destination,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    });
+    this->transitionImage(
+        m_graphicsCommandBuffer,
+        source,
+        getColorSubresourceRange(0, mipLevels, layerCount),
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    );
+
+    m_commandCount++;
+}
+
+void UploadBatch::transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, uint32_t layerCount) {
+    // Transitions into the transfer destination layout precede the copies, so they run on
+    // the transfer queue. Everything after the copies belongs to the graphics queue.
+    const auto commandBuffer = [this, newLayout]() -> VkCommandBuffer {
+        if (newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+            return m_transferCommandBuffer;
+        } else {
+            return m_graphicsCommandBuffer;
+        }
+    }();
+
+    this->transitionImage(commandBuffer, image, getColorSubresourceRange(0, mipLevels, layerCount), oldLayout, newLayout);
+
+    m_commandCount++;
+}
+
+void UploadBatch::updateImageLevels(
+    const StagingSlice& source,
+    VkImage destination,
+    uint32_t baseMipLevel,
+    uint32_t levelCount,
+    std::span<const VkBufferImageCopy> regions
+) {
+    this->updateImageLevelsPart(source, destination, baseMipLevel, levelCount, regions, true, true);
+}
+
+void UploadBatch::updateImageLevelsPart(
+    const StagingSlice& source,
+    VkImage destination,
+    uint32_t baseMipLevel,
+    uint32_t levelCount,
+    std::span<const VkBufferImageCopy> regions,
+    bool isFirstPart,
+    bool isLastPart
+) {
+    // The old contents are discarded, so the transfer queue can take the levels without the
+    // graphics queue releasing them first. Later parts find the levels where the part
+    // before left them, and copy into regions of their own, so they need no barrier.
+    const auto subresourceRange = getColorSubresourceRange(baseMipLevel, levelCount);
+    if (isFirstPart) {
+        this->transitionImage(m_transferCommandBuffer, destination, subresourceRange, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    }
+
+    auto stagingRegions = std::vector<VkBufferImageCopy> { regions.begin(), regions.end() };
+    for (auto& region : stagingRegions) {
+        region.bufferOffset += source.offset;
+    }
+
+    this->flushBarriers(m_transferCommandBuffer);
+    vkCmdCopyBufferToImage(
+        m_transferCommandBuffer,
+        source.buffer,
+        destination,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(stagingRegions.size()),
+        stagingRegions.data()
+    );
+
+    if (!isLastPart) {
+        m_commandCount++;
+
+        return;
+    }
+
+    if (!this->hasOwnershipTransfer()) {
+        this->transitionImage(m_graphicsCommandBuffer, destination, subresourceRange, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        m_commandCount++;
+
+        return;
+    }
+
+    // The move to the shader read-only layout doubles as the ownership transfer, so the
+    // release and the acquire perform the same layout transition.
+    auto barrier = VkImageMemoryBarrier2 {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+        .dstAccessMask = 0,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .srcQueueFamilyIndex = m_transferQueueFamilyIndex,
+        .dstQueueFamilyIndex = m_graphicsQueueFamilyIndex,
+        .image = destination,
+        .subresourceRange = subresourceRange,
+    };
+    this->addImageBarrier(m_transferCommandBuffer, barrier);
+
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+    barrier.srcAccessMask = 0;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+    this->addImageBarrier(m_graphicsCommandBuffer, barrier);
+
+    m_commandCount++;
+}
+
+void UploadBatch::updateImageRegion(const StagingSlice& source, const MipmapTarget& target, const VkRect2D& region) {
+    if (target.mipLevels > 1 && !m_capabilities.hasOptimalTilingFeatures(target.format, VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
+        throw std::runtime_error("texture image format does not support linear blitting!");
+    }
+
+    // The texels around the region are kept, so the levels cannot be handed to the transfer
+    // queue without the graphics queue releasing them first, which nothing recorded before
+    // the transfer submission could do. The copy goes on the graphics queue instead, and
+    // the staging slice, which only the host wrote, needs no transfer either.
+    this->transitionImage(m_graphicsCommandBuffer, target.image, getColorSubresourceRange(0, 1), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    this->flushBarriers(m_graphicsCommandBuffer);
+
+    const auto copyRegion = VkBufferImageCopy {
+        .bufferOffset = source.offset,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .imageSubresource.mipLevel = 0,
+        .imageSubresource.baseArrayLayer = 0,
+        .imageSubresource.layerCount = 1,
+        .imageOffset = VkOffset3D { region.offset.x, region.offset.y, 0 },
+        .imageExtent = VkExtent3D { region.extent.width, region.extent.height, 1 },
+    };
+    vkCmdCopyBufferToImage(
+        m_graphicsCommandBuffer,
+        source.buffer,
+        target.image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1,
+        &copyRegion
+    );
+
+    const auto mipExtent = [](uint32_t extent, uint32_t mipLevel) -> uint32_t {
+        return std::max(extent >> mipLevel, uint32_t { 1 });
+    };
+
+    // The changed texels of every level, per axis, from the first one to past the last one.
+    // A blit of a whole level filters every texel of the level below from the 2x2 block
+    // above it where the level halves evenly, so the blit of the changed blocks writes the
+    // same texels. Where an axis does not halve evenly, the footprints of the texels
+    // straddle texels above, and the rest of the chain is blitted in full along it.
+    struct ChangedSpan final {
+        uint32_t begin;
+        uint32_t end;
+    };
+    auto changedSpans = std::array<ChangedSpan, 2> {
+        ChangedSpan { static_cast<uint32_t>(region.offset.x), region.offset.x + region.extent.width },
+        ChangedSpan { static_cast<uint32_t>(region.offset.y), region.offset.y + region.extent.height },
+    };
+    const auto extents = std::array<uint32_t, 2> { target.width, target.height };
+    for (uint32_t i = 1; i < target.mipLevels; i++) {
+        if (i >= 2) {
+            this->transitionImage(m_graphicsCommandBuffer, target.image, getColorSubresourceRange(i - 2, 1), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+        this->transitionImage(m_graphicsCommandBuffer, target.image, getColorSubresourceRange(i - 1, 1), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        this->transitionImage(m_graphicsCommandBuffer, target.image, getColorSubresourceRange(i, 1), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        this->flushBarriers(m_graphicsCommandBuffer);
+
+        auto sourceSpans = std::array<ChangedSpan, 2> {};
+        for (size_t axis = 0; axis < changedSpans.size(); axis++) {
+            const auto sourceExtent = mipExtent(extents[axis], i - 1);
+            const auto destinationExtent = mipExtent(extents[axis], i);
+            auto& changedSpan = changedSpans[axis];
+            if (sourceExtent == 2 * destinationExtent) {
+                changedSpan = ChangedSpan { changedSpan.begin / 2, (changedSpan.end + 1) / 2 };
+                sourceSpans[axis] = ChangedSpan { 2 * changedSpan.begin, 2 * changedSpan.end };
+            } else {
+                changedSpan = ChangedSpan { 0, destinationExtent };
+                sourceSpans[axis] = ChangedSpan { 0, sourceExtent };
+            }
+        }
+
+        const auto blit = VkImageBlit {
+            .srcOffsets[0] = { static_cast<int32_t>(sourceSpans[0].begin), static_cast<int32_t>(sourceSpans[1].begin), 0 },
+            .srcOffsets[1] = { static_cast<int32_t>(sourceSpans[0].end), static_cast<int32_t>(sourceSpans[1].end), 1 },
+            .srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .srcSubresource.mipLevel = i - 1,
+            .srcSubresource.baseArrayLayer = 0,
+            .srcSubresource.layerCount = 1,
+            .dstOffsets[0] = { static_cast<int32_t>(changedSpans[0].begin), static_cast<int32_t>(changedSpans[1].begin), 0 },
+            .dstOffsets[1] = { static_cast<int32_t>(changedSpans[0].end), static_cast<int32_t>(changedSpans[1].end), 1 },
+            .dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .dstSubresource.mipLevel = i,
+            .dstSubresource.baseArrayLayer = 0,
+            .dstSubresource.layerCount = 1,
+        };
+        vkCmdBlitImage(
+            m_graphicsCommandBuffer,
+            target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            target.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &blit,
+            VK_FILTER_LINEAR
+        );
+    }
+
+    if (target.mipLevels >= 2) {
+        this->transitionImage(m_graphicsCommandBuffer, target.image, getColorSubresourceRange(target.mipLevels - 2, 1), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    this->transitionImage(m_graphicsCommandBuffer, target.image, getColorSubresourceRange(target.mipLevels - 1, 1), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    m_commandCount++;
+}
+
+void UploadBatch::updateImageRegions(const StagingSlice& source, VkImage destination, std::span<const VkBufferImageCopy> regions) {
+    // Like `updateImageRegion`, the texels around the regions are kept, so the copy goes on
+    // the graphics queue, where the transition also waits for the frames that sampled them.
+    this->transitionImage(m_graphicsCommandBuffer, destination, getColorSubresourceRange(0, 1), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    this->flushBarriers(m_graphicsCommandBuffer);
+
+    auto stagingRegions = std::vector<VkBufferImageCopy> { regions.begin(), regions.end() };
+    for (auto& region : stagingRegions) {
+        region.bufferOffset += source.offset;
+    }
+
+    vkCmdCopyBufferToImage(
+        m_graphicsCommandBuffer,
+        source.buffer,
+        destination,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(stagingRegions.size()),
+        stagingRegions.data()
+    );
+
+    this->transitionImage(m_graphicsCommandBuffer, destination, getColorSubresourceRange(0, 1), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    m_commandCount++;
+}
+
+void UploadBatch::clearImage(VkImage image, const VkClearColorValue& color, uint32_t mipLevels, uint32_t layerCount) {
+    this->transitionImage(m_graphicsCommandBuffer, image, getColorSubresourceRange(0, mipLevels, layerCount), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    this->flushBarriers(m_graphicsCommandBuffer);
+
+    const auto subresourceRange = getColorSubresourceRange(0, 1, layerCount);
+    vkCmdClearColorImage(m_graphicsCommandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &subresourceRange);
+
+    m_commandCount++;
+}
+
+void UploadBatch::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
+    const auto target = MipmapTarget {
+        .image = image,
+        .format = imageFormat,
+        .width = static_cast<uint32_t>(texWidth),
+        .height = static_cast<uint32_t>(texHeight),
+        .mipLevels = mipLevels,
+    };
+
+    this->generateMipmaps(std::span<const MipmapTarget> { &target, 1 });
+}
+
+void UploadBatch::generateMipmaps(std::span<const MipmapTarget> targets) {
+    auto computeTargets = std::vector<MipmapTarget> {};
+    auto blitTargets = std::vector<MipmapTarget> {};
+    for (const auto& target : targets) {
+        const auto isComputeSupported = m_mipmapGenerator != nullptr && 
+            m_mipmapGenerator->supportsTarget(target);
+        if (isComputeSupported) {
+            computeTargets.push_back(target);
+        } else {
+            blitTargets.push_back(target);
+        }
+    }
+
+    if (!computeTargets.empty()) {
+        this->flushBarriers(m_graphicsCommandBuffer);
+        auto resources = m_mipmapGenerator->record(m_graphicsCommandBuffer, computeTargets);
+        auto mipmapGenerator = m_mipmapGenerator;
+        this->deferDestruction([mipmapGenerator, resources = std::move(resources)]() {
+            for (const auto& dispatchResources : resources) {
+                mipmapGenerator->release(dispatchResources);
+            }
+        });
+    }
+
+    if (!blitTargets.empty()) {
+        this->generateMipmapsWithBlits(blitTargets);
+    }
+
+    m_commandCount++;
+}
+
+void UploadBatch::generateMipLevels(const MipmapTarget& target, uint32_t firstLevel, uint32_t levelCount) {
+    if (firstLevel == 0 || levelCount == 0 || firstLevel + levelCount > target.mipLevels) {
+        throw std::invalid_argument("mip levels to generate must lie below level 0 of the chain!");
+    }
+
+    if (!m_capabilities.hasOptimalTilingFeatures(target.format, VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
+        throw std::runtime_error("texture image format does not support linear blitting!");
+    }
+
+    const auto mipExtent = [](uint32_t extent, uint32_t mipLevel) -> int32_t {
+        return static_cast<int32_t>(std::max(extent >> mipLevel, uint32_t { 1 }));
+    };
+
+    // The generated levels are past the LOD clamp of every sampler that reaches the image,
+    // so they are moved out of the shader read-only layout all at once. Each round then
+    // turns the level the previous round wrote into the next blit source.
+    this->transitionImage(
+        m_graphicsCommandBuffer,
+        target.image,
+        getColorSubresourceRange(firstLevel - 1, 1, target.layerCount),
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+    );
+    this->transitionImage(
+        m_graphicsCommandBuffer,
+        target.image,
+        getColorSubresourceRange(firstLevel, levelCount, target.layerCount),
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    );
+    for (uint32_t i = firstLevel; i < firstLevel + levelCount; i++) {
+        if (i > firstLevel) {
+            this->transitionImage(
+                m_graphicsCommandBuffer,
+                target.image,
+                getColorSubresourceRange(i - 1, 1, target.layerCount),
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+            );
+        }
+
+        this->flushBarriers(m_graphicsCommandBuffer);
+
+        const auto blit = VkImageBlit {
+            .srcOffsets[0] = { 0, 0, 0 },
+            .srcOffsets[1] = { mipExtent(target.width, i - 1), mipExtent(target.height, i - 1), mipExtent(target.depth, i - 1) },
+            .srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .srcSubresource.mipLevel = i - 1,
+            .srcSubresource.baseArrayLayer = 0,
+            .srcSubresource.layerCount = target.layerCount,
+            .dstOffsets[0] = { 0, 0, 0 },
+            .dstOffsets[1] = { mipExtent(target.width, i), mipExtent(target.height, i), mipExtent(target.depth, i) },
+            .dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .dstSubresource.mipLevel = i,
+            .dstSubresource.baseArrayLayer = 0,
+            .dstSubresource.layerCount = target.layerCount,
+        };
+
+        vkCmdBlitImage(
+            m_graphicsCommandBuffer,
+            target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            target.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &blit,
+            VK_FILTER_LINEAR
+        );
+    }
+
+    // Every blit source is done with, and the last level generated is still a destination.
+    this->transitionImage(
+        m_graphicsCommandBuffer,
+        target.image,
+        getColorSubresourceRange(firstLevel - 1, levelCount, target.layerCount),
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    );
+    this->transitionImage(
+        m_graphicsCommandBuffer,
+        target.image,
+        getColorSubresourceRange(firstLevel + levelCount - 1, 1, target.layerCount),
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    );
+
+    m_commandCount++;
+}
+
+void UploadBatch::deferDestruction(std::function<void()> destroy) {
+    m_deferredDestructions.push_back(std::move(destroy));
+}
+
+std::vector<std::function<void()>> UploadBatch::takeDeferredDestructions() {
+    return std::exchange(m_deferredDestructions, std::vector<std::function<void()>> {});
+}
+
+void UploadBatch::waitForSemaphore(VkSemaphore timelineSemaphore, uint64_t value) {
+    m_semaphoreWaits.push_back(UploadSemaphoreWait { timelineSemaphore, value });
+}
+
+const std::vector<VulkanEngine::UploadSemaphoreWait>& UploadBatch::getSemaphoreWaits() const {
+    return m_semaphoreWaits;
+}
+
+void UploadBatch::finishRecording() {
+    // Make every transfer write in the batch visible to the graphics pipeline stages that
+    // consume uploaded data, so later frames need no extra synchronization with the batch.
+    // It goes out with the transitions that end the last uploads.
+    m_graphicsBarriers.addMemoryBarrier(VkMemoryBarrier2 {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT |
+            VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT |
+            VK_ACCESS_2_UNIFORM_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT,
+    });
+
+    this->flushBarriers(m_transferCommandBuffer);
+    this->flushBarriers(m_graphicsCommandBuffer);
+}
+
+void UploadBatch::generateMipmapsWithBlits(std::span<const MipmapTarget> targets) {
+    auto maxMipLevels = uint32_t { 0 };
+    for (const auto& target : targets) {
+        // Check if image format supports linear blitting.
+        if (!m_capabilities.hasOptimalTilingFeatures(target.format, VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
+            throw std::runtime_error("texture image format does not support linear blitting!");
+        }
+
+        maxMipLevels = std::max(maxMipLevels, target.mipLevels);
+    }
+
+    const auto mipExtent = [](uint32_t extent, uint32_t mipLevel) -> int32_t {
+        return static_cast<int32_t>(std::max(extent >> mipLevel, uint32_t { 1 }));
+    };
+
+    // Level N is generated for every image before level N + 1. Each round needs a single
+    // barrier: it turns level N - 1 of every image into a blit source, and moves level N - 2,
+    // which the previous round read from, into the shader read-only layout.
+    for (uint32_t i = 1; i < maxMipLevels; i++) {
+        for (const auto& target : targets) {
+            if (i >= 2 && i - 1 < target.mipLevels) {
+                this->transitionImage(
+                    m_graphicsCommandBuffer,
+                    target.image,
+                    getColorSubresourceRange(i - 2, 1, target.layerCount),
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                );
+            }
+
+            if (i < target.mipLevels) {
+                this->transitionImage(
+                    m_graphicsCommandBuffer,
+                    target.image,
+                    getColorSubresourceRange(i - 1, 1, target.layerCount),
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                );
+            }
+        }
+
+        this->flushBarriers(m_graphicsCommandBuffer);
+
+        for (const auto& target : targets) {
+            if (i >= target.mipLevels) {
+                continue;
+            }
+
+            // One blit covers every layer of an array, and all three axes of a volume. Blits
+            // filter each cube face on its own, so the faces do not agree along their edges.
+            const auto blit = VkImageBlit {
+                .srcOffsets[0] = { 0, 0, 0 },
+                .srcOffsets[1] = { mipExtent(target.width, i - 1), mipExtent(target.height, i - 1), mipExtent(target.depth, i - 1) },
+                .srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .srcSubresource.mipLevel = i - 1,
+                .srcSubresource.baseArrayLayer = 0,
+                .srcSubresource.layerCount = target.layerCount,
+                .dstOffsets[0] = { 0, 0, 0 },
+                .dstOffsets[1] = { mipExtent(target.width, i), mipExtent(target.height, i), mipExtent(target.depth, i) },
+                .dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .dstSubresource.mipLevel = i,
+                .dstSubresource.baseArrayLayer = 0,
+                .dstSubresource.layerCount = target.layerCount,
+            };
+
+            vkCmdBlitImage(
+                m_graphicsCommandBuffer,
+                target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                target.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1, &blit,
+                VK_FILTER_LINEAR
+            );
+        }
+    }
+
+    // The last blit source and the last level of every image are still outstanding.
+    for (const auto& target : targets) {
+        // Images with a shorter chain had their last blit source transitioned in the round
+        // after it was read.
+        if (target.mipLevels >= 2 && target.mipLevels == maxMipLevels) {
+            this->transitionImage(
+                m_graphicsCommandBuffer,
+                target.image,
+                getColorSubresourceRange(target.mipLevels - 2, 1, target.layerCount),
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            );
+        }
+
+        this->transitionImage(
+            m_graphicsCommandBuffer,
+            target.image,
+            getColorSubresourceRange(target.mipLevels - 1, 1, target.layerCount),
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+    }
+}
+
+bool UploadBatch::isEmpty() const {
+    return m_commandCount == 0;
+}
+
+VkDeviceSize UploadBatch::getStagedSize() const {
+    return m_stagedSize;
+}
+
+VulkanEngine::BarrierBatch& UploadBatch::getPendingBarriers(VkCommandBuffer commandBuffer) {
+    if (commandBuffer == m_graphicsCommandBuffer) {
+        return m_graphicsBarriers;
+    } else {
+        return m_transferBarriers;
+    }
+}
+
+void UploadBatch::transitionImage(
+    VkCommandBuffer commandBuffer,
+    VkImage image,
+    const VkImageSubresourceRange& subresourceRange,
+    VkImageLayout oldLayout,
+    VkImageLayout newLayout
+) {
+    auto& barriers = this->getPendingBarriers(commandBuffer);
+    if (barriers.hasImageBarrier(image, subresourceRange)) {
+        barriers.flush(commandBuffer);
+    }
+
+    barriers.transitionImage(image, subresourceRange, oldLayout, newLayout);
+}
+
+void UploadBatch::addImageBarrier(VkCommandBuffer commandBuffer, const VkImageMemoryBarrier2& barrier) {
+    auto& barriers = this->getPendingBarriers(commandBuffer);
+    if (barriers.hasImageBarrier(barrier.image, barrier.subresourceRange)) {
+        barriers.flush(commandBuffer);
+    }
+
+    barriers.addImageBarrier(barrier);
+}
+
+void UploadBatch::addBufferBarrier(VkCommandBuffer commandBuffer, const VkBufferMemoryBarrier2& barrier) {
+    this->getPendingBarriers(commandBuffer).addBufferBarrier(barrier);
+}
+
+void UploadBatch::flushBarriers(VkCommandBuffer commandBuffer) {
+    this->getPendingBarriers(commandBuffer).flush(commandBuffer);
+}
+
+void UploadBatch::transferBufferOwnership(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size) {
+    auto barrier = VkBufferMemoryBarrier2 {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+        .dstAccessMask = 0,
+        .srcQueueFamilyIndex = m_transferQueueFamilyIndex,
+        .dstQueueFamilyIndex = m_graphicsQueueFamilyIndex,
+        .buffer = buffer,
+        .offset = offset,
+        .size = size,
+    };
+    this->addBufferBarrier(m_transferCommandBuffer, barrier);
+
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+    barrier.srcAccessMask = 0;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT |
+        VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT |
+        VK_ACCESS_2_UNIFORM_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT;
+    this->addBufferBarrier(m_graphicsCommandBuffer, barrier);
+}
+
+void UploadBatch::transferImageOwnership(VkImage image, VkImageLayout layout) {
+    // The whole image changes hands, since every mip level of every layer was transitioned
+    // on the transfer queue before the copy. The layout is left alone so that mip generation
+    // can pick up where the copy left off.
+    auto barrier = VkImageMemoryBarrier2 {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+        .dstAccessMask = 0,
+        .oldLayout = layout,
+        .newLayout = layout,
+        .srcQueueFamilyIndex = m_transferQueueFamilyIndex,
+        .dstQueueFamilyIndex = m_graphicsQueueFamilyIndex,
+        .image = image,
+        .subresourceRange = getColorSubresourceRange(0, VK_REMAINING_MIP_LEVELS, VK_REMAINING_ARRAY_LAYERS),
+    };
+    this->addImageBarrier(m_transferCommandBuffer, barrier);
+
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+    barrier.srcAccessMask = 0;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+    this->addImageBarrier(m_graphicsCommandBuffer, barrier);
+}
+
+
+using UploadContext = VulkanEngine::UploadContext;
+
+UploadContext::UploadContext(
+    const DeviceCapabilities& capabilities,
+    VkDevice device,
+    const UploadQueue& graphicsQueue,
+    const UploadQueue& transferQueue,
+    StagingRing& stagingRing,
+    QueueSubmitter& queueSubmitter,
+    bool useSynchronization2
+)
+    : m_capabilities { capabilities }
+    , m_device { device }
+    , m_graphicsQueue { graphicsQueue }
+    , m_transferQueue { transferQueue }
+    , m_stagingRing { stagingRing }
+    , m_queueSubmitter { queueSubmitter }
+    , m_mipmapGenerator { nullptr }
+    , m_useSynchronization2 { useSynchronization2 }
+    , m_timelineSemaphore { VK_NULL_HANDLE }
+    , m_nextTimelineValue { 1 }
+    , m_transferTimelineSemaphore { VK_NULL_HANDLE }
+    , m_nextTransferTimelineValue { 1 }
+    , m_inFlightCommandBuffers { std::deque<InFlightCommandBuffer> {} }
+    , m_deferredDestructions { std::deque<DeferredDestruction> {} }
+{
+    m_timelineSemaphore = this->createTimelineSemaphore();
+    if (this->hasDedicatedTransferQueue()) {
+        try {
+            m_transferTimelineSemaphore = this->createTimelineSemaphore();
+        } catch (...) {
+            vkDestroySemaphore(m_device, m_timelineSemaphore, nullptr);
+            throw;
+        }
+    }
+}
+
+UploadContext::~UploadContext() {
+    // A lost device runs nothing more, so there is nothing left to wait for.
+    try {
+        this->wait(m_nextTimelineValue - 1);
+    } catch (const DeviceLostError&) {
+    }
+    this->collectCompletedCommandBuffers();
+    // The ring's batches wait on the timeline semaphore, and none of them is left to run.
+    m_stagingRing.dropInFlightBatches();
+
+    vkDestroySemaphore(m_device, m_transferTimelineSemaphore, nullptr);
+    vkDestroySemaphore(m_device, m_timelineSemaphore, nullptr);
+
+    m_transferTimelineSemaphore = VK_NULL_HANDLE;
+    m_timelineSemaphore = VK_NULL_HANDLE;
+    m_transferQueue = UploadQueue {};
+    m_graphicsQueue = UploadQueue {};
+    m_device = VK_NULL_HANDLE;
+}
+
+UploadBatch UploadContext::beginBatch() {
+    this->collectCompletedCommandBuffers();
+
+    const auto graphicsCommandBuffer = this->beginCommandBuffer(m_graphicsQueue.commandPool);
+    const auto transferCommandBuffer = [this, graphicsCommandBuffer]() -> VkCommandBuffer {
+        if (this->hasDedicatedTransferQueue()) {
+            return this->beginCommandBuffer(m_transferQueue.commandPool);
+        } else {
+            return graphicsCommandBuffer;
+        }
+    }();
+    const auto transferQueueFamilyIndex = [this]() -> uint32_t {
+        if (this->hasDedicatedTransferQueue()) {
+            return m_transferQueue.queueFamilyIndex;
+        } else {
+            return m_graphicsQueue.queueFamilyIndex;
+        }
+    }();
+
+    return UploadBatch {
+        m_capabilities,
+        transferCommandBuffer,
+        transferQueueFamilyIndex,
+        graphicsCommandBuffer,
+        m_graphicsQueue.queueFamilyIndex,
+        m_stagingRing,
+        m_mipmapGenerator,
+        m_useSynchronization2
+    };
+}
+
+uint64_t UploadContext::submit(UploadBatch& batch) {
+    batch.finishRecording();
+    const auto graphicsCommandBuffer = batch.getCommandBuffer();
+    auto deferredDestructions = batch.takeDeferredDestructions();
+
+    auto waits = std::vector<SemaphoreSubmit> {};
+    for (const auto& semaphoreWait : batch.getSemaphoreWaits()) {
+        waits.push_back(SemaphoreSubmit { .semaphore = semaphoreWait.semaphore, .value = semaphoreWait.value });
+    }
+
+    m_stagingRing.flush();
+    const auto timelineValue = m_nextTimelineValue++;
+    if (batch.hasOwnershipTransfer()) {
+        // The staging slices are only read by the transfer submission, so the ring can
+        // reclaim them as soon as the copies finish, before the graphics half completes.
+        // The transfer command buffer is freed with the graphics half, which waits on it.
+        const auto transferSignal = SemaphoreSubmit { .semaphore = m_transferTimelineSemaphore, .value = m_nextTransferTimelineValue++ };
+        this->submitCommandBuffer(m_transferQueue, batch.getTransferCommandBuffer(), waits, transferSignal, timelineValue);
+        m_stagingRing.retirePendingSlices(transferSignal.semaphore, transferSignal.value);
+
+        waits = std::vector<SemaphoreSubmit> { transferSignal };
+    }
+
+    const auto signal = SemaphoreSubmit { .semaphore = m_timelineSemaphore, .value = timelineValue };
+    this->submitCommandBuffer(m_graphicsQueue, graphicsCommandBuffer, waits, signal, timelineValue);
+    if (!batch.hasOwnershipTransfer()) {
+        m_stagingRing.retirePendingSlices(m_timelineSemaphore, timelineValue);
+    }
+    for (auto& destroy : deferredDestructions) {
+        m_deferredDestructions.push_back(DeferredDestruction { std::move(destroy), timelineValue });
+    }
+
+    return timelineValue;
+}
+
+void UploadContext::wait(uint64_t timelineValue) {
+    if (this->isComplete(timelineValue)) {
+        return;
+    }
+
+    // The value may belong to a submission the queue submitter still holds.
+    m_queueSubmitter.flush();
+
+    const auto waitInfo = VkSemaphoreWaitInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &m_timelineSemaphore,
+        .pValues = &timelineValue,
+    };
+    const auto result = vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX);
+    if (result == VK_ERROR_DEVICE_LOST) {
+        throw DeviceLostError("failed to wait for upload batch: the device was lost!");
+    }
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to wait for upload batch!");
+    }
+}
+
+bool UploadContext::isComplete(uint64_t timelineValue) const {
+    return this->getCompletedValue() >= timelineValue;
+}
+
+uint64_t UploadContext::getCompletedValue() const {
+    uint64_t completedValue = 0;
+    vkGetSemaphoreCounterValue(m_device, m_timelineSemaphore, &completedValue);
+
+    return completedValue;
+}
+
+VkSemaphore UploadContext::getTimelineSemaphore() const {
+    return m_timelineSemaphore;
+}
+
+bool UploadContext::hasDedicatedTransferQueue() const {
+    return m_transferQueue.queueFamilyIndex != m_graphicsQueue.queueFamilyIndex;
+}
+
+void UploadContext::setMipmapGenerator(MipmapGenerator* mipmapGenerator) {
+    m_mipmapGenerator = mipmapGenerator;
+}
+
+VkImageUsageFlags UploadContext::getMipmapImageUsage(VkFormat format) const {
+    const auto blitUsage = VkImageUsageFlags { VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT };
+    if (m_mipmapGenerator == nullptr) {
+        return blitUsage;
+    }
+
+    return blitUsage | m_mipmapGenerator->getRequiredImageUsage(format);
+}
+
+bool UploadContext::supportsMipmapBlits(VkFormat format) const {
+    return m_capabilities.hasOptimalTilingFeatures(format, VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+}
+
+VkImageCreateFlags UploadContext::getMipmapImageCreateFlags(VkFormat format) const {
+    if (m_mipmapGenerator == nullptr) {
+        return 0;
+    }
+
+    return m_mipmapGenerator->getRequiredImageCreateFlags(format);
+}
+
+VkCommandBuffer UploadContext::beginCommandBuffer(VkCommandPool commandPool) {
+    const auto allocInfo = VkCommandBufferAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandPool = commandPool,
+        .commandBufferCount = 1,
+    };
+
+    auto commandBuffer = VkCommandBuffer {};
+    const auto resultAllocateCommandBuffers = vkAllocateCommandBuffers(m_device, &allocInfo, &commandBuffer);
+    if (resultAllocateCommandBuffers != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate upload command buffer!");
+    }
+
+    const auto beginInfo = VkCommandBufferBeginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    return commandBuffer;
+}
+
+VkSemaphore UploadContext::createTimelineSemaphore() const {
+    const auto timelineCreateInfo = VkSemaphoreTypeCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    const auto semaphoreInfo = VkSemaphoreCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timelineCreateInfo,
+    };
+
+    auto timelineSemaphore = VkSemaphore {};
+    const auto result = vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &timelineSemaphore);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload timeline semaphore!");
+    }
+
+    return timelineSemaphore;
+}
+
+void UploadContext::submitCommandBuffer(
+    const UploadQueue& uploadQueue,
+    VkCommandBuffer commandBuffer,
+    std::span<const SemaphoreSubmit> waits,
+    const SemaphoreSubmit& signal,
+    uint64_t timelineValue
+) {
+    vkEndCommandBuffer(commandBuffer);
+
+    auto submission = QueueSubmission {};
+    submission.waits.assign(waits.begin(), waits.end());
+    submission.commandBuffers.push_back(commandBuffer);
+    submission.signals.push_back(signal);
+
+    m_queueSubmitter.submit(uploadQueue.queue, std::move(submission));
+
+    m_inFlightCommandBuffers.push_back(InFlightCommandBuffer { uploadQueue.commandPool, commandBuffer, timelineValue });
+}
+
+void UploadContext::collectCompletedCommandBuffers() {
+    const auto completedValue = this->getCompletedValue();
+    while (!m_inFlightCommandBuffers.empty() && m_inFlightCommandBuffers.front().timelineValue <= completedValue) {
+        const auto& inFlightCommandBuffer = m_inFlightCommandBuffers.front();
+        vkFreeCommandBuffers(m_device, inFlightCommandBuffer.commandPool, 1, &inFlightCommandBuffer.commandBuffer);
+
+        m_inFlightCommandBuffers.pop_front();
+    }
+
+    while (!m_deferredDestructions.empty() && m_deferredDestructions.front().timelineValue <= completedValue) {
+        m_deferredDestructions.front().destroy();
+
+        m_deferredDestructions.pop_front();
+    }
+}
@@ -0,0 +1,381 @@
+#ifndef _UPLOAD_BATCH_H
+#define _UPLOAD_BATCH_H
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "barrier_batch.h"
+#include "device_capabilities.h"
+#include "queue_submitter.h"
+#include "staging_ring.h"
+#include "mipmap_generator.h"
+
+
+namespace VulkanEngine {
+
+/// @brief A queue that upload batches are submitted to, together with the command pool
+/// its command buffers are allocated from.
+struct UploadQueue final {
+    VkQueue queue = VK_NULL_HANDLE;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    uint32_t queueFamilyIndex = 0;
+};
+
+/// @brief A timeline semaphore value that an upload batch waits for before it starts.
+struct UploadSemaphoreWait final {
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    uint64_t value = 0;
+};
+
+/// @brief A command buffer that accumulates uploads until it is submitted.
+///
+/// @note An upload batch records any number of staging copies, layout transitions
+/// and mip chain generations. Nothing is sent to the GPU until the batch is handed to
+/// `UploadContext::submit`, which submits it once and returns the timeline value that
+/// signals its completion.
+///
+/// When the device has a dedicated transfer queue family, copies are recorded into a
+/// transfer command buffer and every destination resource is released to the graphics
+/// queue family right after its copy. The matching acquire barriers, mip generation and
+/// shader read transitions go into a graphics command buffer that waits on the transfer
+/// submission. Otherwise both command buffers are the same and no ownership transfer is
+/// recorded.
+///
+/// Barriers are recorded through a `BarrierBatch`, with synchronization2 when the device
+/// has it. Each command buffer keeps the barriers the batch has added to it pending until
+/// the next command recorded into it, so the transitions that end one upload and those
+/// that start the next go into one pipeline barrier. A barrier on a subresource that
+/// already has one pending records the pending ones first.
+class UploadBatch final {
+    public:
+        explicit UploadBatch() = delete;
+        explicit UploadBatch(
+            const DeviceCapabilities& capabilities,
+            VkCommandBuffer transferCommandBuffer,
+            uint32_t transferQueueFamilyIndex,
+            VkCommandBuffer graphicsCommandBuffer,
+            uint32_t graphicsQueueFamilyIndex,
+            StagingRing& stagingRing,
+            MipmapGenerator* mipmapGenerator,
+            bool useSynchronization2
+        );
+
+        ~UploadBatch() = default;
+
+        /// @brief The graphics command buffer, for commands recorded outside of the batch.
+        ///
+        /// @note The barriers pending on it are recorded first, so that the commands come
+        /// after everything the batch has recorded so far.
+        VkCommandBuffer getCommandBuffer();
+
+        VkCommandBuffer getTransferCommandBuffer() const;
+
+        bool hasOwnershipTransfer() const;
+
+        StagingSlice stage(const void* data, VkDeviceSize size, VkDeviceSize alignment = StagingRing::DEFAULT_ALIGNMENT);
+
+        /// @brief Allocate a staging slice for the caller to write into.
+        ///
+        /// @note Loaders use this to read or decode upload data straight into mapped staging
+        /// memory instead of staging a copy of it. The slice must be filled in before the
+        /// batch is submitted.
+        StagingSlice reserve(VkDeviceSize size, VkDeviceSize alignment = StagingRing::DEFAULT_ALIGNMENT);
+
+        void copyBuffer(const StagingSlice& source, VkBuffer destination, VkDeviceSize destinationOffset);
+
+        /// @brief Copy the first `size` bytes of one buffer the graphics queue family owns
+        /// into another, like a buffer that is moved to compact its memory.
+        ///
+        /// @note The copy is recorded into the graphics command buffer, so neither buffer
+        /// changes hands.
+        void copyBufferToBuffer(VkBuffer source, VkBuffer destination, VkDeviceSize size);
+
+        /// @brief Copy level 0 of an image out of a staging slice that holds it tightly packed,
+        /// layer after layer, and slice after slice for a 3D image.
+        void copyBufferToImage(
+            const StagingSlice& source,
+            VkImage destination,
+            uint32_t width,
+            uint32_t height,
+            uint32_t depth = 1,
+            uint32_t layerCount = 1
+        );
+
+        /// @brief Copy any number of regions of a staging slice into an image with one copy command.
+        ///
+        /// @note Buffer offsets of the regions are relative to the start of the slice.
+        void copyBufferToImage(const StagingSlice& source, VkImage destination, std::span<const VkBufferImageCopy> regions);
+
+        /// @brief Copy regions of the first `layerCount` layers of an image in the shader
+        /// read-only layout back into a host visible buffer.
+        ///
+        /// @note The image is returned to the shader read-only layout afterwards, and the
+        /// buffer contents are visible to the host once the batch has completed.
+        void copyImageToBuffer(
+            VkImage source,
+            uint32_t mipLevels,
+            VkBuffer destination,
+            std::span<const VkBufferImageCopy> regions,
+            uint32_t layerCount = 1
+        );
+
+        /// @brief Transition every mip level of the first `layerCount` layers of a color image
+        /// between any two layouts.
+        ///
+        /// @note Transitions into the transfer destination layout are recorded on the transfer
+        /// command buffer, and every other transition on the graphics command buffer.
+        void transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, uint32_t layerCount = 1);
+
+        /// @brief Replace the contents of a range of mip levels of an image that is already
+        /// in the shader read-only layout.
+        ///
+        /// @note Only the levels in the range change layout or queue family, so the other
+        /// levels can stay in use by shaders while the batch runs. Their previous contents
+        /// are discarded. The buffer offsets of the regions are relative to the start of the
+        /// slice, and the range is back in the shader read-only layout afterwards.
+        void updateImageLevels(
+            const StagingSlice& source,
+            VkImage destination,
+            uint32_t baseMipLevel,
+            uint32_t levelCount,
+            std::span<const VkBufferImageCopy> regions
+        );
+
+        /// @brief Copy one part of the contents `updateImageLevels` replaces, for levels too
+        /// large to upload in one batch.
+        ///
+        /// @note The first part discards the previous contents, and the last one moves the
+        /// range back to the shader read-only layout. In between, the range stays in the
+        /// transfer destination layout, owned by the transfer queue family, so the parts
+        /// have to be submitted in order, and the levels must not be sampled until the last
+        /// one has completed.
+        void updateImageLevelsPart(
+            const StagingSlice& source,
+            VkImage destination,
+            uint32_t baseMipLevel,
+            uint32_t levelCount,
+            std::span<const VkBufferImageCopy> regions,
+            bool isFirstPart,
+            bool isLastPart
+        );
+
+        /// @brief Replace a region of level 0 of an image that is already in the shader
+        /// read-only layout, and filter the texels of every lower level that it changes.
+        ///
+        /// @note The slice holds the texels of the region, tightly packed. Everything is
+        /// recorded on the graphics command buffer, and each level is blitted from the one
+        /// above it, so the image must take blits like a blit chain's, and the lower levels
+        /// come out as a blit chain filters them. Along an axis whose extent does not halve
+        /// evenly, the levels from there on are blitted in full. Every level is back in the
+        /// shader read-only layout afterwards.
+        void updateImageRegion(const StagingSlice& source, const MipmapTarget& target, const VkRect2D& region);
+
+        /// @brief Replace regions of an image of one level that is already in the shader
+        /// read-only layout, and keep the texels around them, like the tiles of an atlas.
+        ///
+        /// @note Everything is recorded on the graphics command buffer, after every frame
+        /// submitted before that samples the image, and the image is back in the shader
+        /// read-only layout afterwards. The buffer offsets of the regions are relative to
+        /// the start of the slice.
+        void updateImageRegions(const StagingSlice& source, VkImage destination, std::span<const VkBufferImageCopy> regions);
+
+        /// @brief Fill level 0 of every one of the `layerCount` layers of a color image with
+        /// one color, and leave every level in the transfer destination layout that
+        /// `generateMipmaps` starts from.
+        ///
+        /// @note The clear is recorded on the graphics command buffer, so it takes no staging
+        /// memory, and images of any size can be filled. Every slice of a 3D image is filled.
+        void clearImage(VkImage image, const VkClearColorValue& color, uint32_t mipLevels, uint32_t layerCount = 1);
+
+        /// @brief Generate every mip level below level 0 and leave the whole image in the
+        /// shader read-only layout.
+        ///
+        /// @note The chain is generated with a single compute dispatch when the upload
+        /// context has a mipmap generator that supports the image, and with a blit chain
+        /// otherwise. The image must be created with the usage and create flags returned by
+        /// `UploadContext::getMipmapImageUsage` and `UploadContext::getMipmapImageCreateFlags`.
+        void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
+
+        /// @brief Generate the mip chains of many images at once.
+        ///
+        /// @note Level N is generated for every image before level N + 1, and the barriers of
+        /// each level are merged into a single pipeline barrier for all images. Blit
+        /// chains always filter linearly and ignore the filter and alpha cutoff of a target,
+        /// and filter the faces of a cube map without regard to their shared edges.
+        void generateMipmaps(std::span<const MipmapTarget> targets);
+
+        /// @brief Generate `levelCount` levels of a mip chain from `firstLevel` on, each from
+        /// the level above it, in an image whose levels are all in the shader read-only layout.
+        ///
+        /// @note Only the source level and the levels generated change layout, so the levels
+        /// above them can stay in use by shaders while the batch runs, and the levels below
+        /// them keep their contents. The levels are blitted on the graphics command buffer and
+        /// always filter linearly, and they are back in the shader read-only layout afterwards.
+        void generateMipLevels(const MipmapTarget& target, uint32_t firstLevel, uint32_t levelCount);
+
+        void deferDestruction(std::function<void()> destroy);
+
+        std::vector<std::function<void()>> takeDeferredDestructions();
+
+        /// @brief Hold back every command of the batch until a timeline semaphore, signaled
+        /// outside of the upload context, reaches `value`.
+        ///
+        /// @note This orders uploads after work submitted elsewhere, such as the sparse
+        /// memory binds that back the destination of a copy.
+        void waitForSemaphore(VkSemaphore timelineSemaphore, uint64_t value);
+
+        const std::vector<UploadSemaphoreWait>& getSemaphoreWaits() const;
+
+        /// @brief Record the barriers still pending, along with the one that makes every
+        /// upload in the batch visible to the stages that consume uploaded data.
+        ///
+        /// @note `UploadContext::submit` calls this, and nothing may be recorded afterwards.
+        void finishRecording();
+
+        bool isEmpty() const;
+
+        /// @brief The bytes of staging memory the batch has taken.
+        VkDeviceSize getStagedSize() const;
+    private:
+        const DeviceCapabilities& m_capabilities;
+        VkCommandBuffer m_transferCommandBuffer;
+        uint32_t m_transferQueueFamilyIndex;
+        VkCommandBuffer m_graphicsCommandBuffer;
+        uint32_t m_graphicsQueueFamilyIndex;
+        StagingRing& m_stagingRing;
+        MipmapGenerator* m_mipmapGenerator;
+        BarrierBatch m_transferBarriers;
+        BarrierBatch m_graphicsBarriers;
+        std::vector<std::function<void()>> m_deferredDestructions;
+        std::vector<UploadSemaphoreWait> m_semaphoreWaits;
+        uint32_t m_commandCount;
+        VkDeviceSize m_stagedSize;
+
+        /// @brief The barriers pending on `commandBuffer`, which are the graphics ones when
+        /// the batch has a single command buffer.
+        BarrierBatch& getPendingBarriers(VkCommandBuffer commandBuffer);
+
+        void transitionImage(
+            VkCommandBuffer commandBuffer,
+            VkImage image,
+            const VkImageSubresourceRange& subresourceRange,
+            VkImageLayout oldLayout,
+            VkImageLayout newLayout
+        );
+
+        void addImageBarrier(VkCommandBuffer commandBuffer, const VkImageMemoryBarrier2& barrier);
+
+        void addBufferBarrier(VkCommandBuffer commandBuffer, const VkBufferMemoryBarrier2& barrier);
+
+        /// @brief Record the barriers pending on `commandBuffer`, right before a command that
+        /// may depend on them.
+        void flushBarriers(VkCommandBuffer commandBuffer);
+
+        void generateMipmapsWithBlits(std::span<const MipmapTarget> targets);
+
+        void transferBufferOwnership(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+
+        void transferImageOwnership(VkImage image, VkImageLayout layout);
+};
+
+/// @brief Owns the upload timeline and submits upload batches.
+///
+/// @note Every submitted batch signals the next value of a timeline semaphore. Callers
+/// hold on to the returned value and only wait on it when they actually need the
+/// uploaded data, so a whole startup sequence costs at most one CPU-GPU round trip.
+/// Only the graphics queue signals that timeline. The transfer half of a batch on a
+/// dedicated transfer queue signals a timeline of its own, which the graphics half waits
+/// on, since the signals of two queues are not ordered and could move one timeline back.
+/// Submissions go through `queueSubmitter`, so the uploads of a frame share the submit
+/// call of the frame itself.
+class UploadContext final {
+    public:
+        explicit UploadContext() = delete;
+        explicit UploadContext(
+            const DeviceCapabilities& capabilities,
+            VkDevice device,
+            const UploadQueue& graphicsQueue,
+            const UploadQueue& transferQueue,
+            StagingRing& stagingRing,
+            QueueSubmitter& queueSubmitter,
+            bool useSynchronization2
+        );
+
+        ~UploadContext();
+
+        UploadBatch beginBatch();
+
+        uint64_t submit(UploadBatch& batch);
+
+        void wait(uint64_t timelineValue);
+
+        bool isComplete(uint64_t timelineValue) const;
+
+        uint64_t getCompletedValue() const;
+
+        VkSemaphore getTimelineSemaphore() const;
+
+        bool hasDedicatedTransferQueue() const;
+
+        void setMipmapGenerator(MipmapGenerator* mipmapGenerator);
+
+        VkImageUsageFlags getMipmapImageUsage(VkFormat format) const;
+
+        VkImageCreateFlags getMipmapImageCreateFlags(VkFormat format) const;
+
+        /// @brief Whether `UploadBatch::generateMipmaps` can fall back to a blit chain for
+        /// images of this format.
+        ///
+        /// @note When it cannot, the mip chain has to be generated on the CPU.
+        bool supportsMipmapBlits(VkFormat format) const;
+    private:
+        struct InFlightCommandBuffer final {
+            VkCommandPool commandPool;
+            VkCommandBuffer commandBuffer;
+            uint64_t timelineValue;
+        };
+
+        struct DeferredDestruction final {
+            std::function<void()> destroy;
+            uint64_t timelineValue;
+        };
+
+        const DeviceCapabilities& m_capabilities;
+        VkDevice m_device;
+        UploadQueue m_graphicsQueue;
+        UploadQueue m_transferQueue;
+        StagingRing& m_stagingRing;
+        QueueSubmitter& m_queueSubmitter;
+        MipmapGenerator* m_mipmapGenerator;
+        bool m_useSynchronization2;
+        VkSemaphore m_timelineSemaphore;
+        uint64_t m_nextTimelineValue;
+        VkSemaphore m_transferTimelineSemaphore;
+        uint64_t m_nextTransferTimelineValue;
+        std::deque<InFlightCommandBuffer> m_inFlightCommandBuffers;
+        std::deque<DeferredDestruction> m_deferredDestructions;
+
+        VkCommandBuffer beginCommandBuffer(VkCommandPool commandPool);
+
+        VkSemaphore createTimelineSemaphore() const;
+
+        /// @brief Submit `commandBuffer`, which is freed once the upload timeline reaches
+        /// `timelineValue`.
+        void submitCommandBuffer(
+            const UploadQueue& uploadQueue,
+            VkCommandBuffer commandBuffer,
+            std::span<const SemaphoreSubmit> waits,
+            const SemaphoreSubmit& signal,
+            uint64_t timelineValue
+        );
+
+        void collectCompletedCommandBuffers();
+};
+
+}
+
+#endif // _UPLOAD_BATCH_H
@@ -0,0 +1,89 @@
+#include "upload_scheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+using UploadScheduler = VulkanEngine::UploadScheduler;
+
+UploadScheduler::UploadScheduler(
+    double frameBudgetMilliseconds,
+    VkDeviceSize minBytesPerFrame,
+    VkDeviceSize maxBytesPerFrame,
+    uint32_t maxCopiesPerFrame,
+    double initialBytesPerMillisecond
+)
+    : m_frameBudgetMilliseconds { frameBudgetMilliseconds }
+    , m_minBytesPerFrame { minBytesPerFrame }
+    , m_maxBytesPerFrame { maxBytesPerFrame }
+    , m_maxCopiesPerFrame { maxCopiesPerFrame }
+    , m_bytesPerMillisecond { initialBytesPerMillisecond }
+    , m_hasTransferSample { false }
+    , m_averageFrameMilliseconds {}
+    , m_remainingBytes { minBytesPerFrame }
+    , m_remainingCopies { maxCopiesPerFrame }
+    , m_isFrameUntouched { true }
+{
+    if (!(frameBudgetMilliseconds > 0.0) || minBytesPerFrame == 0 || minBytesPerFrame > maxBytesPerFrame || maxCopiesPerFrame == 0 || !(initialBytesPerMillisecond > 0.0)) {
+        throw std::invalid_argument("the upload scheduler needs a positive frame budget, throughput and copy count, and a byte range that is not empty!");
+    }
+}
+
+void UploadScheduler::beginFrame(std::optional<double> gpuFrameMilliseconds) {
+    if (gpuFrameMilliseconds.has_value()) {
+        if (m_averageFrameMilliseconds.has_value()) {
+            m_averageFrameMilliseconds = *m_averageFrameMilliseconds + SMOOTHING * (*gpuFrameMilliseconds - *m_averageFrameMilliseconds);
+        } else {
+            m_averageFrameMilliseconds = gpuFrameMilliseconds;
+        }
+    }
+
+    // Without GPU times, nothing is known about the headroom, so only the minimum goes out.
+    const auto headroomMilliseconds = m_averageFrameMilliseconds.has_value()
+        ? std::max(m_frameBudgetMilliseconds - *m_averageFrameMilliseconds, 0.0)
+        : 0.0;
+    const auto budgetBytes = static_cast<VkDeviceSize>(headroomMilliseconds * m_bytesPerMillisecond);
+
+    m_remainingBytes = std::clamp(budgetBytes, m_minBytesPerFrame, m_maxBytesPerFrame);
+    m_remainingCopies = m_maxCopiesPerFrame;
+    m_isFrameUntouched = true;
+}
+
+void UploadScheduler::recordTransfer(VkDeviceSize byteCount, double gpuMilliseconds) {
+    if (byteCount == 0 || !(gpuMilliseconds > 0.0)) {
+        return;
+    }
+
+    const auto bytesPerMillisecond = static_cast<double>(byteCount) / gpuMilliseconds;
+    if (m_hasTransferSample) {
+        m_bytesPerMillisecond = m_bytesPerMillisecond + SMOOTHING * (bytesPerMillisecond - m_bytesPerMillisecond);
+    } else {
+        m_bytesPerMillisecond = bytesPerMillisecond;
+        m_hasTransferSample = true;
+    }
+}
+
+bool UploadScheduler::tryReserve(VkDeviceSize byteCount, uint32_t copyCount) {
+    const auto fits = byteCount <= m_remainingBytes && copyCount <= m_remainingCopies;
+    if (!fits && !m_isFrameUntouched) {
+        return false;
+    }
+
+    m_remainingBytes -= std::min(byteCount, m_remainingBytes);
+    m_remainingCopies -= std::min(copyCount, m_remainingCopies);
+    m_isFrameUntouched = false;
+
+    return true;
+}
+
+VkDeviceSize UploadScheduler::getRemainingBytes() const {
+    return m_remainingBytes;
+}
+
+uint32_t UploadScheduler::getRemainingCopies() const {
+    return m_remainingCopies;
+}
+
+double UploadScheduler::getBytesPerMillisecond() const {
+    return m_bytesPerMillisecond;
+}
@@ -0,0 +1,71 @@
+#ifndef _UPLOAD_SCHEDULER_H
+#define _UPLOAD_SCHEDULER_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <optional>
+
+
+namespace VulkanEngine {
+
+/// @brief Caps the bytes and copy commands that streaming uploads submit in a frame, so
+/// that streaming never makes a frame spike.
+///
+/// @note The budget of a frame is the transfer throughput measured so far times the GPU
+/// time the frame leaves free under `frameBudgetMilliseconds`, clamped between the
+/// minimum, which keeps streaming moving however busy the GPU is, and the maximum.
+/// Throughput samples are smoothed, and so is the GPU time of frames. Until the first
+/// sample comes in, the throughput is `initialBytesPerMillisecond`.
+///
+/// An upload that can be split, like the rows of a mip level, is sized to the budget that
+/// is left. One that cannot is let through whole when it is the first of its frame, since
+/// it would never fit otherwise.
+class UploadScheduler final {
+    public:
+        static constexpr double SMOOTHING = 0.2;
+
+        explicit UploadScheduler() = delete;
+        explicit UploadScheduler(
+            double frameBudgetMilliseconds,
+            VkDeviceSize minBytesPerFrame,
+            VkDeviceSize maxBytesPerFrame,
+            uint32_t maxCopiesPerFrame,
+            double initialBytesPerMillisecond
+        );
+
+        UploadScheduler(const UploadScheduler& other) = delete;
+        UploadScheduler& operator=(const UploadScheduler& other) = delete;
+
+        /// @brief Start the budget of the next frame, from the GPU time of a frame that just
+        /// resolved, or from the times seen so far when none did.
+        void beginFrame(std::optional<double> gpuFrameMilliseconds);
+
+        /// @brief Take the GPU time an upload of `byteCount` bytes took into the throughput.
+        void recordTransfer(VkDeviceSize byteCount, double gpuMilliseconds);
+
+        /// @brief Take `byteCount` bytes and `copyCount` copy commands out of the budget of
+        /// the frame, and return whether they were taken.
+        bool tryReserve(VkDeviceSize byteCount, uint32_t copyCount);
+
+        VkDeviceSize getRemainingBytes() const;
+
+        uint32_t getRemainingCopies() const;
+
+        double getBytesPerMillisecond() const;
+    private:
+        double m_frameBudgetMilliseconds;
+        VkDeviceSize m_minBytesPerFrame;
+        VkDeviceSize m_maxBytesPerFrame;
+        uint32_t m_maxCopiesPerFrame;
+        double m_bytesPerMillisecond;
+        bool m_hasTransferSample;
+        std::optional<double> m_averageFrameMilliseconds;
+        VkDeviceSize m_remainingBytes;
+        uint32_t m_remainingCopies;
+        bool m_isFrameUntouched;
+};
+
+}
+
+#endif // _UPLOAD_SCHEDULER_H
@@ -0,0 +1,55 @@
+#include "vertex_layout.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+
+using VertexEncoders = VulkanEngine::VertexEncoders;
+
+uint16_t VertexEncoders::encodeFloat16(float value) {
+    const auto bits = std::bit_cast<uint32_t>(value);
+    const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const auto exponent = static_cast<int32_t>((bits >> 23) & 0xff);
+    const auto mantissa = bits & 0x007fffff;
+
+    // Infinity and NaN, keeping NaNs quiet.
+    if (exponent == 0xff) {
+        return sign | 0x7c00 | ((mantissa != 0) ? 0x0200 : 0);
+    }
+
+    const auto halfExponent = exponent - 127 + 15;
+    if (halfExponent >= 0x1f) {
+        return sign | 0x7c00;
+    }
+
+    if (halfExponent <= 0) {
+        // Subnormal halves, or zero once the value is too small to round up to one.
+        if (halfExponent < -10) {
+            return sign;
+        }
+
+        const auto fullMantissa = mantissa | 0x00800000;
+        const auto shift = static_cast<uint32_t>(14 - halfExponent);
+        const auto halfMantissa = fullMantissa >> shift;
+        const auto remainder = fullMantissa & ((1u << shift) - 1);
+        const auto halfway = 1u << (shift - 1);
+        const auto roundUp = (remainder > halfway) || (remainder == halfway && (halfMantissa & 1) != 0);
+
+        return sign | static_cast<uint16_t>(halfMantissa + (roundUp ? 1 : 0));
+    }
+
+    // A mantissa that rounds up past its top carries into the exponent, which is the
+    // correctly rounded result, up to and including infinity.
+    const auto halfBits = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    const auto remainder = mantissa & 0x1fff;
+    const auto roundUp = (remainder > 0x1000) || (remainder == 0x1000 && (halfBits & 1) != 0);
+
+    return sign | static_cast<uint16_t>(halfBits + (roundUp ? 1 : 0));
+}
+
+uint16_t VertexEncoders::encodeUnorm16(float value) {
+    const auto clampedValue = std::clamp(value, 0.0f, 1.0f);
+
+    return static_cast<uint16_t>(std::lround(clampedValue * 65535.0f));
+}
@@ -0,0 +1,188 @@
+#ifndef _VERTEX_LAYOUT_H
+#define _VERTEX_LAYOUT_H
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+
+namespace VulkanEngine {
+
+/// @brief How the components of a vertex attribute are stored in a vertex buffer.
+enum class VertexEncoding {
+    Float32,
+    Float16,
+    /// @brief 16-bit unsigned normalized integers. Values must be in [0, 1].
+    Unorm16,
+};
+
+class VertexEncoders final {
+    public:
+        explicit VertexEncoders() = delete;
+
+        /// @brief Round `value` to the nearest IEEE half, ties to even.
+        static uint16_t encodeFloat16(float value);
+
+        /// @brief Round `value`, clamped to [0, 1], to the nearest 16-bit unsigned normalized integer.
+        static uint16_t encodeUnorm16(float value);
+};
+
+/// @brief One vertex attribute of `ComponentCount` components stored with `Encoding`.
+///
+/// @note Three-component 16-bit formats are rarely supported as vertex formats, so they
+/// are padded to four components, and the shader ignores the last one.
+template <VertexEncoding Encoding, uint32_t ComponentCount>
+struct VertexAttribute final {
+    static_assert(ComponentCount >= 1 && ComponentCount <= 4, "vertex attributes have one to four components");
+
+    using Component = std::conditional_t<Encoding == VertexEncoding::Float32, float, uint16_t>;
+
+    static constexpr uint32_t STORED_COMPONENT_COUNT = (Encoding != VertexEncoding::Float32 && ComponentCount == 3) ? 4 : ComponentCount;
+
+    static constexpr VkFormat FORMAT = [] {
+        constexpr auto float32Formats = std::array<VkFormat, 4> {
+            VK_FORMAT_R32_SFLOAT,
+            VK_FORMAT_R32G32_SFLOAT,
+            VK_FORMAT_R32G32B32_SFLOAT,
+            VK_FORMAT_R32G32B32A32_SFLOAT,
+        };
+        constexpr auto float16Formats = std::array<VkFormat, 4> {
+            VK_FORMAT_R16_SFLOAT,
+            VK_FORMAT_R16G16_SFLOAT,
+            VK_FORMAT_R16G16B16A16_SFLOAT,
+            VK_FORMAT_R16G16B16A16_SFLOAT,
+        };
+        constexpr auto unorm16Formats = std::array<VkFormat, 4> {
+            VK_FORMAT_R16_UNORM,
+            VK_FORMAT_R16G16_UNORM,
+            VK_FORMAT_R16G16B16A16_UNORM,
+            VK_FORMAT_R16G16B16A16_UNORM,
+        };
+
+        if constexpr (Encoding == VertexEncoding::Float32) {
+            return float32Formats[ComponentCount - 1];
+        } else if constexpr (Encoding == VertexEncoding::Float16) {
+            return float16Formats[ComponentCount - 1];
+        } else {
+            return unorm16Formats[ComponentCount - 1];
+        }
+    }();
+
+    std::array<Component, STORED_COMPONENT_COUNT> components;
+
+    void encode(const float* values) {
+        for (uint32_t i = 0; i < STORED_COMPONENT_COUNT; i++) {
+            const auto value = (i < ComponentCount) ? values[i] : 0.0f;
+            if constexpr (Encoding == VertexEncoding::Float32) {
+                components[i] = value;
+            } else if constexpr (Encoding == VertexEncoding::Float16) {
+                components[i] = VertexEncoders::encodeFloat16(value);
+            } else {
+                components[i] = VertexEncoders::encodeUnorm16(value);
+            }
+        }
+    }
+};
+
+/// @brief The layout of a vertex in a vertex buffer: a position and a texture coordinate,
+/// each stored with its own encoding.
+///
+/// @note With `VertexEncoding::Unorm16` positions, the positions are stored normalized to
+/// the bounding box of their mesh, and the model matrix has to scale and translate them
+/// back. Texture coordinates are stored as they are, so a `VertexEncoding::Unorm16`
+/// texture coordinate only holds coordinates in [0, 1].
+///
+/// The vertex input descriptions are derived from the encodings at compile time, so the
+/// pipeline always matches the layout the vertices were packed in.
+///
+/// Vertices are either interleaved in one stream, or split into a position stream at
+/// `POSITION_BINDING` and a stream of the other attributes at `ATTRIBUTE_BINDING`. With
+/// split streams, a depth-only pass binds the position stream alone with
+/// `getPositionBindingDescriptions` and fetches only the positions.
+template <VertexEncoding PositionEncoding, VertexEncoding TexCoordEncoding>
+struct PackedVertex final {
+    using Position = VertexAttribute<PositionEncoding, 3>;
+    using TexCoord = VertexAttribute<TexCoordEncoding, 2>;
+
+    static constexpr bool IS_POSITION_NORMALIZED = PositionEncoding == VertexEncoding::Unorm16;
+    static constexpr bool IS_TEX_COORD_NORMALIZED = TexCoordEncoding == VertexEncoding::Unorm16;
+
+    static constexpr uint32_t POSITION_BINDING = 0;
+    static constexpr uint32_t ATTRIBUTE_BINDING = 1;
+
+    Position position;
+    TexCoord texCoord;
+
+    static constexpr VkVertexInputBindingDescription getBindingDescription() {
+        return VkVertexInputBindingDescription {
+            .binding = 0,
+            .stride = sizeof(PackedVertex),
+            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+        };
+    }
+
+    static constexpr std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
+        return std::array<VkVertexInputAttributeDescription, 2> {
+            VkVertexInputAttributeDescription {
+                .location = 0,
+                .binding = 0,
+                .format = Position::FORMAT,
+                .offset = offsetof(PackedVertex, position),
+            },
+            VkVertexInputAttributeDescription {
+                .location = 1,
+                .binding = 0,
+                .format = TexCoord::FORMAT,
+                .offset = offsetof(PackedVertex, texCoord),
+            },
+        };
+    }
+
+    static constexpr std::array<VkVertexInputBindingDescription, 2> getSplitBindingDescriptions() {
+        return std::array<VkVertexInputBindingDescription, 2> {
+            VkVertexInputBindingDescription {
+                .binding = POSITION_BINDING,
+                .stride = sizeof(Position),
+                .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+            },
+            VkVertexInputBindingDescription {
+                .binding = ATTRIBUTE_BINDING,
+                .stride = sizeof(TexCoord),
+                .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+            },
+        };
+    }
+
+    static constexpr std::array<VkVertexInputAttributeDescription, 2> getSplitAttributeDescriptions() {
+        return std::array<VkVertexInputAttributeDescription, 2> {
+            VkVertexInputAttributeDescription {
+                .location = 0,
+                .binding = POSITION_BINDING,
+                .format = Position::FORMAT,
+                .offset = 0,
+            },
+            VkVertexInputAttributeDescription {
+                .location = 1,
+                .binding = ATTRIBUTE_BINDING,
+                .format = TexCoord::FORMAT,
+                .offset = 0,
+            },
+        };
+    }
+
+    /// @brief The binding of the position stream alone, for depth-only pipelines.
+    static constexpr std::array<VkVertexInputBindingDescription, 1> getPositionBindingDescriptions() {
+        return std::array<VkVertexInputBindingDescription, 1> { getSplitBindingDescriptions()[0] };
+    }
+
+    static constexpr std::array<VkVertexInputAttributeDescription, 1> getPositionAttributeDescriptions() {
+        return std::array<VkVertexInputAttributeDescription, 1> { getSplitAttributeDescriptions()[0] };
+    }
+};
+
+}
+
+#endif // _VERTEX_LAYOUT_H
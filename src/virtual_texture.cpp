@@ -0,0 +1,463 @@
+#include "virtual_texture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "texture_format.h"
+
+
+using VirtualTexture = VulkanEngine::VirtualTexture;
+using TextureFormats = VulkanEngine::TextureFormats;
+
+static constexpr uint32_t BYTES_PER_TEXEL = 4;
+// The header starts with the width, the height, the level count and the tiles of a row of
+// the atlas, and then has two entries for every level.
+static constexpr uint32_t HEADER_FIXED_SIZE = 4;
+static constexpr uint32_t ENTRY_LEVEL_SHIFT = 16;
+
+// Texels outside a level wrap around, as the sampler of the texture repeats it.
+static uint32_t wrapTexel(int64_t texel, uint32_t extent) {
+    const auto wrapped = texel % static_cast<int64_t>(extent);
+
+    return static_cast<uint32_t>(wrapped < 0 ? wrapped + extent : wrapped);
+}
+
+VirtualTexture::VirtualTexture(
+    VkDevice device,
+    GpuMemoryAllocator& allocator,
+    UploadContext& uploadContext,
+    TextureCacheEntry mipChain,
+    uint32_t atlasTilesPerRow,
+    uint32_t frameCount,
+    VkBufferUsageFlags additionalUsage
+)
+    : m_device { device }
+    , m_allocator { allocator }
+    , m_uploadContext { uploadContext }
+    , m_mipChain { std::move(mipChain) }
+    , m_atlasTilesPerRow { atlasTilesPerRow }
+    , m_frameCount { frameCount }
+    , m_levels {}
+    , m_pages {}
+    , m_headerSize { 0 }
+    , m_atlasImage { VK_NULL_HANDLE }
+    , m_atlasAllocation {}
+    , m_freeTiles {}
+    , m_tilePages {}
+    , m_pageTableBuffer { VK_NULL_HANDLE }
+    , m_pageTableAllocation {}
+    , m_pageTableRegionSize { 0 }
+    , m_pageTable {}
+    , m_pageTableVersion { 0 }
+    , m_regionVersions(frameCount, 0)
+    , m_feedback {}
+    , m_updateCount { 0 }
+    , m_requestedPages {}
+    , m_uploadingPages {}
+    , m_uploadTimelineValue { 0 }
+{
+    if (!VirtualTexture::isFormatSupported(m_mipChain.format)) {
+        throw std::invalid_argument("virtual textures only take uncompressed formats of four bytes a texel!");
+    }
+
+    this->createLevels();
+
+    const auto pinnedPageCount = std::ranges::count_if(m_pages, [](const auto& page) { return page.isPinned; });
+    const auto atlasTileCount = this->getAtlasTileCount();
+    if (atlasTileCount > (1u << ENTRY_LEVEL_SHIFT) || static_cast<uint32_t>(pinnedPageCount) >= atlasTileCount) {
+        throw std::invalid_argument("the virtual texture atlas must hold more tiles than the levels that stay resident, and fewer than 65536!");
+    }
+
+    m_freeTiles.reserve(atlasTileCount);
+    for (uint32_t tile = atlasTileCount; tile > 0; tile--) {
+        m_freeTiles.push_back(tile - 1);
+    }
+    m_tilePages.resize(atlasTileCount);
+
+    this->createAtlas();
+    this->createPageTableBuffer(additionalUsage);
+    m_feedback = std::make_unique<LodFeedback>(
+        m_device,
+        m_allocator,
+        m_headerSize + static_cast<uint32_t>(m_pages.size()),
+        m_frameCount,
+        additionalUsage
+    );
+}
+
+VirtualTexture::~VirtualTexture() {
+    m_feedback.reset();
+
+    vkDestroyBuffer(m_device, m_pageTableBuffer, nullptr);
+    m_allocator.free(m_pageTableAllocation);
+    vkDestroyImage(m_device, m_atlasImage, nullptr);
+    m_allocator.free(m_atlasAllocation);
+
+    m_pageTableBuffer = VK_NULL_HANDLE;
+    m_atlasImage = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+bool VirtualTexture::isFormatSupported(VkFormat format) {
+    const auto formatInfo = TextureFormats::getInfo(format);
+
+    return formatInfo.has_value() && !formatInfo->isCompressed() && formatInfo->blockSize == BYTES_PER_TEXEL;
+}
+
+void VirtualTexture::beginStreaming(UploadBatch& uploadBatch) {
+    uploadBatch.transitionImageLayout(m_atlasImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+
+    auto pinnedPages = std::vector<uint32_t> {};
+    for (uint32_t i = 0; i < m_pages.size(); i++) {
+        if (m_pages[i].isPinned) {
+            m_pages[i].tile = *this->takeTile();
+            m_tilePages[*m_pages[i].tile] = i;
+            pinnedPages.push_back(i);
+        }
+    }
+    this->recordTileUploads(uploadBatch, pinnedPages);
+
+    // The batch goes out before the first frame, which samples the pages.
+    this->rebuildPageTable();
+}
+
+void VirtualTexture::update(uint32_t frameIndex, UploadScheduler& uploadScheduler) {
+    m_updateCount++;
+    if (!m_uploadingPages.empty() && m_uploadContext.isComplete(m_uploadTimelineValue)) {
+        for (const auto page : m_uploadingPages) {
+            m_pages[page].isUploading = false;
+        }
+        m_uploadingPages.clear();
+        this->rebuildPageTable();
+    }
+
+    this->readFeedback(frameIndex);
+
+    // One upload is in flight at a time, so the pages of the next one are picked from the
+    // newest feedback.
+    if (m_uploadingPages.empty() && !m_requestedPages.empty()) {
+        const auto tileByteSize = VkDeviceSize { ATLAS_TILE_SIZE * ATLAS_TILE_SIZE * BYTES_PER_TEXEL };
+        auto pages = std::vector<uint32_t> {};
+        for (const auto pageIndex : m_requestedPages) {
+            const auto tile = this->takeTile();
+            if (!tile.has_value()) {
+                break;
+            }
+            if (!uploadScheduler.tryReserve(tileByteSize, 1)) {
+                m_freeTiles.push_back(*tile);
+                break;
+            }
+
+            auto& page = m_pages[pageIndex];
+            page.tile = tile;
+            page.isUploading = true;
+            m_tilePages[*tile] = pageIndex;
+            pages.push_back(pageIndex);
+        }
+
+        if (!pages.empty()) {
+            auto uploadBatch = m_uploadContext.beginBatch();
+            this->recordTileUploads(uploadBatch, pages);
+            m_uploadTimelineValue = m_uploadContext.submit(uploadBatch);
+            m_uploadingPages = std::move(pages);
+            std::erase_if(m_requestedPages, [this](uint32_t pageIndex) { return m_pages[pageIndex].tile.has_value(); });
+            // The pages whose tiles were taken fall back to the levels above them.
+            this->rebuildPageTable();
+        }
+    }
+
+    if (m_regionVersions[frameIndex] != m_pageTableVersion) {
+        std::memcpy(this->getRegion(frameIndex), m_pageTable.data(), m_pageTable.size() * sizeof(uint32_t));
+        m_allocator.addDirtyRange(m_pageTableAllocation, frameIndex * m_pageTableRegionSize, m_pageTable.size() * sizeof(uint32_t));
+        m_allocator.flushDirtyRanges();
+        m_regionVersions[frameIndex] = m_pageTableVersion;
+    }
+}
+
+void VirtualTexture::recordReadback(VkCommandBuffer commandBuffer) const {
+    m_feedback->recordReadback(commandBuffer);
+}
+
+VkDescriptorBufferInfo VirtualTexture::getPageTableInfo(uint32_t frameIndex) const {
+    return VkDescriptorBufferInfo {
+        .buffer = m_pageTableBuffer,
+        .offset = frameIndex * m_pageTableRegionSize,
+        .range = m_pageTable.size() * sizeof(uint32_t),
+    };
+}
+
+VkDescriptorBufferInfo VirtualTexture::getFeedbackInfo(uint32_t frameIndex) const {
+    return m_feedback->getBufferInfo(frameIndex);
+}
+
+VkImage VirtualTexture::getAtlasImage() const {
+    return m_atlasImage;
+}
+
+VkFormat VirtualTexture::getFormat() const {
+    return m_mipChain.format;
+}
+
+uint32_t VirtualTexture::getMipLevels() const {
+    return static_cast<uint32_t>(m_levels.size());
+}
+
+uint32_t VirtualTexture::getResidentPageCount() const {
+    return static_cast<uint32_t>(std::ranges::count_if(m_pages, [](const auto& page) {
+        return page.tile.has_value() && !page.isUploading;
+    }));
+}
+
+uint32_t VirtualTexture::getAtlasTileCount() const {
+    return m_atlasTilesPerRow * m_atlasTilesPerRow;
+}
+
+bool VirtualTexture::isStreaming() const {
+    return !m_uploadingPages.empty() || !m_requestedPages.empty();
+}
+
+void VirtualTexture::createLevels() {
+    const auto levelCount = static_cast<uint32_t>(m_mipChain.levels.size());
+    for (uint32_t level = 0; level < levelCount; level++) {
+        const auto& mipLevel = m_mipChain.levels[level];
+        const auto pagesPerRow = (mipLevel.width + TILE_SIZE - 1) / TILE_SIZE;
+        const auto pageRowCount = (mipLevel.height + TILE_SIZE - 1) / TILE_SIZE;
+        m_levels.push_back(Level {
+            .width = mipLevel.width,
+            .height = mipLevel.height,
+            .pagesPerRow = pagesPerRow,
+            .pageRowCount = pageRowCount,
+            .firstPage = static_cast<uint32_t>(m_pages.size()),
+        });
+
+        for (uint32_t y = 0; y < pageRowCount; y++) {
+            for (uint32_t x = 0; x < pagesPerRow; x++) {
+                m_pages.push_back(Page {
+                    .level = level,
+                    .x = x,
+                    .y = y,
+                    .tile = std::nullopt,
+                    .isUploading = false,
+                    .isPinned = pagesPerRow == 1 && pageRowCount == 1,
+                    .lastSampledUpdate = 0,
+                });
+            }
+        }
+    }
+
+    m_headerSize = HEADER_FIXED_SIZE + 2 * levelCount;
+}
+
+void VirtualTexture::createAtlas() {
+    const auto atlasExtent = m_atlasTilesPerRow * ATLAS_TILE_SIZE;
+    const auto imageInfo = VkImageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = m_mipChain.format,
+        .extent = VkExtent3D { atlasExtent, atlasExtent, 1 },
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    const auto resultCreateImage = vkCreateImage(m_device, &imageInfo, nullptr, &m_atlasImage);
+    if (resultCreateImage != VK_SUCCESS) {
+        throw std::runtime_error("failed to create virtual texture atlas!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetImageMemoryRequirements(m_device, m_atlasImage, &memRequirements);
+
+    m_atlasAllocation = m_allocator.allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Optimal, GpuMemoryCategory::Texture);
+
+    vkBindImageMemory(m_device, m_atlasImage, m_atlasAllocation.memory, m_atlasAllocation.offset);
+}
+
+void VirtualTexture::createPageTableBuffer(VkBufferUsageFlags additionalUsage) {
+    m_pageTable = std::vector<uint32_t>(m_headerSize + m_pages.size(), 0);
+    m_pageTable[0] = m_mipChain.width;
+    m_pageTable[1] = m_mipChain.height;
+    m_pageTable[2] = static_cast<uint32_t>(m_levels.size());
+    m_pageTable[3] = m_atlasTilesPerRow;
+    for (uint32_t level = 0; level < m_levels.size(); level++) {
+        m_pageTable[HEADER_FIXED_SIZE + 2 * level] = m_headerSize + m_levels[level].firstPage;
+        m_pageTable[HEADER_FIXED_SIZE + 2 * level + 1] = m_levels[level].pagesPerRow;
+    }
+
+    // Every region starts at a multiple of the largest `nonCoherentAtomSize` and
+    // `minStorageBufferOffsetAlignment` there is, so it can be bound and flushed on its own.
+    const auto regionAlignment = VkDeviceSize { 256 };
+    const auto regionSize = VkDeviceSize { m_pageTable.size() * sizeof(uint32_t) };
+    m_pageTableRegionSize = (regionSize + regionAlignment - 1) / regionAlignment * regionAlignment;
+
+    const auto bufferInfo = VkBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = m_pageTableRegionSize * m_frameCount,
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | additionalUsage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    const auto resultCreateBuffer = vkCreateBuffer(m_device, &bufferInfo, nullptr, &m_pageTableBuffer);
+    if (resultCreateBuffer != VK_SUCCESS) {
+        throw std::runtime_error("failed to create virtual texture page table!");
+    }
+
+    auto memRequirements = VkMemoryRequirements {};
+    vkGetBufferMemoryRequirements(m_device, m_pageTableBuffer, &memRequirements);
+
+    m_pageTableAllocation = m_allocator.allocate(
+        memRequirements,
+        m_allocator.selectDynamicMemoryProperties(memRequirements.memoryTypeBits),
+        GpuResourceKind::Linear,
+        GpuMemoryCategory::Other
+    );
+
+    vkBindBufferMemory(m_device, m_pageTableBuffer, m_pageTableAllocation.memory, m_pageTableAllocation.offset);
+}
+
+void VirtualTexture::readFeedback(uint32_t frameIndex) {
+    m_feedback->beginFrame(frameIndex);
+    if (!m_feedback->hasResults()) {
+        return;
+    }
+
+    m_requestedPages.clear();
+    for (uint32_t i = 0; i < m_pages.size(); i++) {
+        if (!m_feedback->getRequestedLevel(m_headerSize + i).has_value()) {
+            continue;
+        }
+
+        auto& page = m_pages[i];
+        page.lastSampledUpdate = m_updateCount;
+        if (!page.tile.has_value()) {
+            m_requestedPages.push_back(i);
+        }
+    }
+
+    // The pages of less detailed levels come first, so the view sharpens level by level
+    // instead of leaving the coarse fallback in place where the detailed pages run out.
+    std::ranges::stable_sort(m_requestedPages, [this](uint32_t left, uint32_t right) {
+        return m_pages[left].level > m_pages[right].level;
+    });
+}
+
+std::optional<uint32_t> VirtualTexture::takeTile() {
+    if (!m_freeTiles.empty()) {
+        const auto tile = m_freeTiles.back();
+        m_freeTiles.pop_back();
+
+        return tile;
+    }
+
+    // A page that a frame in flight still samples would only be asked for again.
+    auto evictedPage = std::optional<uint32_t> {};
+    for (const auto& tilePage : m_tilePages) {
+        if (!tilePage.has_value()) {
+            continue;
+        }
+
+        const auto& page = m_pages[*tilePage];
+        if (page.isPinned || page.isUploading || page.lastSampledUpdate + m_frameCount >= m_updateCount) {
+            continue;
+        }
+        if (!evictedPage.has_value() || page.lastSampledUpdate < m_pages[*evictedPage].lastSampledUpdate) {
+            evictedPage = *tilePage;
+        }
+    }
+
+    if (!evictedPage.has_value()) {
+        return std::nullopt;
+    }
+
+    auto& page = m_pages[*evictedPage];
+    const auto tile = *page.tile;
+    page.tile.reset();
+    m_tilePages[tile].reset();
+
+    return tile;
+}
+
+void VirtualTexture::writeTileTexels(const Page& page, uint8_t* destination) const {
+    const auto& mipLevel = m_mipChain.levels[page.level];
+    const auto* levelTexels = m_mipChain.data.data() + mipLevel.offset;
+    const auto originX = static_cast<int64_t>(page.x * TILE_SIZE) - TILE_BORDER;
+    const auto originY = static_cast<int64_t>(page.y * TILE_SIZE) - TILE_BORDER;
+    for (uint32_t y = 0; y < ATLAS_TILE_SIZE; y++) {
+        const auto sourceY = wrapTexel(originY + y, mipLevel.height);
+        const auto* sourceRow = levelTexels + size_t { sourceY } * mipLevel.width * BYTES_PER_TEXEL;
+        auto* destinationRow = destination + size_t { y } * ATLAS_TILE_SIZE * BYTES_PER_TEXEL;
+        for (uint32_t x = 0; x < ATLAS_TILE_SIZE; x++) {
+            const auto sourceX = wrapTexel(originX + x, mipLevel.width);
+            std::memcpy(destinationRow + x * BYTES_PER_TEXEL, sourceRow + sourceX * BYTES_PER_TEXEL, BYTES_PER_TEXEL);
+        }
+    }
+}
+
+VkBufferImageCopy VirtualTexture::createTileCopyRegion(uint32_t tile, VkDeviceSize bufferOffset) const {
+    const auto tileX = tile % m_atlasTilesPerRow;
+    const auto tileY = tile / m_atlasTilesPerRow;
+
+    return VkBufferImageCopy {
+        .bufferOffset = bufferOffset,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .imageSubresource.mipLevel = 0,
+        .imageSubresource.baseArrayLayer = 0,
+        .imageSubresource.layerCount = 1,
+        .imageOffset = VkOffset3D { static_cast<int32_t>(tileX * ATLAS_TILE_SIZE), static_cast<int32_t>(tileY * ATLAS_TILE_SIZE), 0 },
+        .imageExtent = VkExtent3D { ATLAS_TILE_SIZE, ATLAS_TILE_SIZE, 1 },
+    };
+}
+
+void VirtualTexture::recordTileUploads(UploadBatch& uploadBatch, const std::vector<uint32_t>& pages) {
+    const auto tileByteSize = VkDeviceSize { ATLAS_TILE_SIZE * ATLAS_TILE_SIZE * BYTES_PER_TEXEL };
+    const auto stagingSlice = uploadBatch.reserve(tileByteSize * pages.size());
+    auto copyRegions = std::vector<VkBufferImageCopy> {};
+    copyRegions.reserve(pages.size());
+    for (size_t i = 0; i < pages.size(); i++) {
+        const auto& page = m_pages[pages[i]];
+        this->writeTileTexels(page, static_cast<uint8_t*>(stagingSlice.mappedData) + i * tileByteSize);
+        copyRegions.push_back(this->createTileCopyRegion(*page.tile, i * tileByteSize));
+    }
+
+    uploadBatch.updateImageRegions(stagingSlice, m_atlasImage, copyRegions);
+}
+
+void VirtualTexture::rebuildPageTable() {
+    for (auto level = static_cast<uint32_t>(m_levels.size()); level > 0; level--) {
+        const auto& levelInfo = m_levels[level - 1];
+        for (uint32_t y = 0; y < levelInfo.pageRowCount; y++) {
+            for (uint32_t x = 0; x < levelInfo.pagesPerRow; x++) {
+                const auto pageIndex = levelInfo.firstPage + y * levelInfo.pagesPerRow + x;
+                const auto& page = m_pages[pageIndex];
+                if (page.tile.has_value() && !page.isUploading) {
+                    m_pageTable[m_headerSize + pageIndex] = *page.tile | ((level - 1) << ENTRY_LEVEL_SHIFT);
+                    continue;
+                }
+
+                // The levels that fit in one page are always resident, so there is a
+                // level above every page that is not.
+                const auto& parentLevel = m_levels[level];
+                const auto parentX = std::min(x / 2, parentLevel.pagesPerRow - 1);
+                const auto parentY = std::min(y / 2, parentLevel.pageRowCount - 1);
+                const auto parentIndex = parentLevel.firstPage + parentY * parentLevel.pagesPerRow + parentX;
+                m_pageTable[m_headerSize + pageIndex] = m_pageTable[m_headerSize + parentIndex];
+            }
+        }
+    }
+
+    m_pageTableVersion++;
+}
+
+uint32_t* VirtualTexture::getRegion(uint32_t frameIndex) const {
+    return reinterpret_cast<uint32_t*>(static_cast<char*>(m_pageTableAllocation.mappedData) + frameIndex * m_pageTableRegionSize);
+}
@@ -0,0 +1,189 @@
+#ifndef _VIRTUAL_TEXTURE_H
+#define _VIRTUAL_TEXTURE_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "gpu_memory_allocator.h"
+#include "lod_feedback.h"
+#include "texture_cache.h"
+#include "upload_batch.h"
+#include "upload_scheduler.h"
+
+
+namespace VulkanEngine {
+
+/// @brief A texture too large for device memory, split into square pages across every mip
+/// level, of which only the pages the view samples are kept in a fixed atlas of tiles.
+///
+/// @note The whole mip chain stays in host memory. Every page is `TILE_SIZE` texels a side
+/// and takes a tile of the atlas with `TILE_BORDER` texels of its neighbors around it, so
+/// bilinear filtering never reaches into the next tile. The levels that fit in one page
+/// are uploaded by `beginStreaming` and never leave, so there is always a level to sample.
+///
+/// The page table is a storage buffer with a region per frame slot, which starts with a
+/// header the shader reads the layout from: the width and height of the texture, its level
+/// count, the tiles of a row of the atlas, and for every level the entry its first page is
+/// at and the pages of a row of it. An entry per page follows, which holds the atlas tile
+/// in its low 16 bits and the level of the tile above them, of the page itself when it is
+/// resident or of the nearest less detailed page that covers it when it is not, so the
+/// shader finds something to sample with one read.
+///
+/// The fragment shader writes the pages it samples to the feedback, an entry to a page at
+/// the same index as the page table. `update` reads back a frame slot's feedback once the
+/// slot's last submit has finished, and uploads the pages that were asked for and are not
+/// resident, the least detailed first, as far as the budget of the upload scheduler
+/// goes. Once the atlas is full, the page that was sampled longest ago makes room, as long
+/// as none of the last `frameCount` frames read back sampled it. Tiles are copied on the
+/// graphics queue, after every frame that could still sample what they held, and a page
+/// only enters the page table once its upload has completed. Only uncompressed formats of
+/// four bytes a texel are supported.
+class VirtualTexture final {
+    public:
+        static constexpr uint32_t TILE_SIZE = 128;
+        static constexpr uint32_t TILE_BORDER = 4;
+        /// @brief The texels a side of a tile of the atlas, with its border.
+        static constexpr uint32_t ATLAS_TILE_SIZE = TILE_SIZE + 2 * TILE_BORDER;
+
+        explicit VirtualTexture() = delete;
+        explicit VirtualTexture(
+            VkDevice device,
+            GpuMemoryAllocator& allocator,
+            UploadContext& uploadContext,
+            TextureCacheEntry mipChain,
+            uint32_t atlasTilesPerRow,
+            uint32_t frameCount,
+            VkBufferUsageFlags additionalUsage = 0
+        );
+
+        ~VirtualTexture();
+
+        VirtualTexture(const VirtualTexture& other) = delete;
+        VirtualTexture& operator=(const VirtualTexture& other) = delete;
+
+        /// @brief Whether textures of `format` can be virtual.
+        static bool isFormatSupported(VkFormat format);
+
+        /// @brief Record the upload of the pages of every level that fits in one, and move
+        /// the atlas to the shader read-only layout.
+        void beginStreaming(UploadBatch& uploadBatch);
+
+        /// @brief Read back the pages the last frame of `frameIndex` sampled, submit the
+        /// uploads of the pages it is missing, as far as the budget of `uploadScheduler`
+        /// goes, and write the page table of the frame.
+        ///
+        /// @note Must be called once per frame that is drawn, after the slot's last submit
+        /// has finished.
+        void update(uint32_t frameIndex, UploadScheduler& uploadScheduler);
+
+        /// @brief Record the barrier that makes the feedback of the frame visible to the
+        /// host, after the last draw of the frame.
+        void recordReadback(VkCommandBuffer commandBuffer) const;
+
+        /// @brief The page table of `frameIndex`, for its storage buffer descriptor.
+        VkDescriptorBufferInfo getPageTableInfo(uint32_t frameIndex) const;
+
+        /// @brief The feedback of `frameIndex`, for its storage buffer descriptor.
+        VkDescriptorBufferInfo getFeedbackInfo(uint32_t frameIndex) const;
+
+        /// @brief The atlas, a single level image in `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL`.
+        VkImage getAtlasImage() const;
+
+        VkFormat getFormat() const;
+
+        uint32_t getMipLevels() const;
+
+        uint32_t getResidentPageCount() const;
+
+        uint32_t getAtlasTileCount() const;
+
+        /// @brief Whether pages that were asked for are still missing or uploading.
+        bool isStreaming() const;
+    private:
+        struct Level final {
+            uint32_t width;
+            uint32_t height;
+            uint32_t pagesPerRow;
+            uint32_t pageRowCount;
+            /// @brief The index of the first page of the level among every page.
+            uint32_t firstPage;
+        };
+
+        struct Page final {
+            uint32_t level = 0;
+            uint32_t x = 0;
+            uint32_t y = 0;
+            std::optional<uint32_t> tile;
+            bool isUploading = false;
+            bool isPinned = false;
+            /// @brief The update that last read back a frame that sampled the page.
+            uint64_t lastSampledUpdate = 0;
+        };
+
+        VkDevice m_device;
+        GpuMemoryAllocator& m_allocator;
+        UploadContext& m_uploadContext;
+        TextureCacheEntry m_mipChain;
+        uint32_t m_atlasTilesPerRow;
+        uint32_t m_frameCount;
+        std::vector<Level> m_levels;
+        std::vector<Page> m_pages;
+        /// @brief The entries of the page table before the first page.
+        uint32_t m_headerSize;
+        VkImage m_atlasImage;
+        GpuAllocation m_atlasAllocation;
+        std::vector<uint32_t> m_freeTiles;
+        /// @brief The page of every tile of the atlas, if one holds it.
+        std::vector<std::optional<uint32_t>> m_tilePages;
+        VkBuffer m_pageTableBuffer;
+        GpuAllocation m_pageTableAllocation;
+        VkDeviceSize m_pageTableRegionSize;
+        /// @brief The page table as the frames that are recorded next see it, and the
+        /// version of it every frame slot's region holds.
+        std::vector<uint32_t> m_pageTable;
+        uint64_t m_pageTableVersion;
+        std::vector<uint64_t> m_regionVersions;
+        std::unique_ptr<LodFeedback> m_feedback;
+        uint64_t m_updateCount;
+        std::vector<uint32_t> m_requestedPages;
+        /// @brief The pages of the upload that is in flight, and its timeline value.
+        std::vector<uint32_t> m_uploadingPages;
+        uint64_t m_uploadTimelineValue;
+
+        void createLevels();
+
+        void createAtlas();
+
+        void createPageTableBuffer(VkBufferUsageFlags additionalUsage);
+
+        /// @brief Take the pages the feedback of `frameIndex` asked for that are missing
+        /// into `m_requestedPages`, and mark every page it asked for as sampled.
+        void readFeedback(uint32_t frameIndex);
+
+        /// @brief A free tile of the atlas, or the tile of the page sampled longest ago, if
+        /// none of the last `m_frameCount` frames read back sampled it.
+        std::optional<uint32_t> takeTile();
+
+        /// @brief Copy the texels of `page` and its border into `destination`.
+        void writeTileTexels(const Page& page, uint8_t* destination) const;
+
+        VkBufferImageCopy createTileCopyRegion(uint32_t tile, VkDeviceSize bufferOffset) const;
+
+        /// @brief Stage the texels of `pages`, which have their tiles, and record copying
+        /// them into the atlas.
+        void recordTileUploads(UploadBatch& uploadBatch, const std::vector<uint32_t>& pages);
+
+        /// @brief Resolve the entry of every page, from the least detailed level to the
+        /// most detailed one.
+        void rebuildPageTable();
+
+        uint32_t* getRegion(uint32_t frameIndex) const;
+};
+
+}
+
+#endif // _VIRTUAL_TEXTURE_H
@@ -0,0 +1,70 @@
+#include "window_event_queue.h"
+
+#include <chrono>
+
+
+using WindowEventQueue = VulkanEngine::WindowEventQueue;
+using WindowEvent = VulkanEngine::WindowEvent;
+
+WindowEventQueue::WindowEventQueue()
+    : m_events {}
+    , m_pushPosition { 0 }
+    , m_popPosition { 0 }
+    , m_droppedCount { 0 }
+    , m_wakeMutex {}
+    , m_wakeCondition {}
+{
+}
+
+bool WindowEventQueue::push(const WindowEvent& event) {
+    const auto position = m_pushPosition.load(std::memory_order_relaxed);
+    if (position - m_popPosition.load(std::memory_order_acquire) == CAPACITY) {
+        m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+
+        return false;
+    }
+
+    m_events[position & (CAPACITY - 1)] = event;
+    m_pushPosition.store(position + 1, std::memory_order_release);
+
+    // The waiting thread checks for events under the lock, so taking it once the event is
+    // in makes sure the thread either sees it or is already asleep to be woken.
+    {
+        auto lock = std::lock_guard<std::mutex> { m_wakeMutex };
+    }
+    m_wakeCondition.notify_one();
+
+    return true;
+}
+
+std::optional<WindowEvent> WindowEventQueue::pop() {
+    const auto position = m_popPosition.load(std::memory_order_relaxed);
+    if (position == m_pushPosition.load(std::memory_order_acquire)) {
+        return std::nullopt;
+    }
+
+    const auto event = m_events[position & (CAPACITY - 1)];
+    m_popPosition.store(position + 1, std::memory_order_release);
+
+    return event;
+}
+
+void WindowEventQueue::waitForEvent(std::optional<double> timeoutSeconds) {
+    auto lock = std::unique_lock<std::mutex> { m_wakeMutex };
+    const auto hasEvent = [this]() -> bool {
+        return !this->isEmpty();
+    };
+    if (timeoutSeconds) {
+        m_wakeCondition.wait_for(lock, std::chrono::duration<double> { *timeoutSeconds }, hasEvent);
+    } else {
+        m_wakeCondition.wait(lock, hasEvent);
+    }
+}
+
+uint64_t WindowEventQueue::getDroppedCount() const {
+    return m_droppedCount.load(std::memory_order_relaxed);
+}
+
+bool WindowEventQueue::isEmpty() const {
+    return m_popPosition.load(std::memory_order_relaxed) == m_pushPosition.load(std::memory_order_acquire);
+}
@@ -0,0 +1,89 @@
+#ifndef _WINDOW_EVENT_QUEUE_H
+#define _WINDOW_EVENT_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+
+namespace VulkanEngine {
+
+enum class WindowEventType {
+    FramebufferResize,
+    Refresh,
+    Focus,
+    Iconify,
+    Key,
+    Close,
+};
+
+/// @brief An event of the window, as GLFW reported it to its callbacks.
+struct WindowEvent final {
+    WindowEventType type = WindowEventType::Refresh;
+    /// @brief The window the event reached: 0 for the main window, and `i + 1` for viewport
+    /// window `i`.
+    uint32_t window = 0;
+    /// @brief The framebuffer extent of a resize.
+    uint32_t width = 0;
+    uint32_t height = 0;
+    /// @brief The GLFW key and action of a key event.
+    int32_t key = 0;
+    int32_t action = 0;
+    /// @brief Whether a focus event gained the focus, or an iconify event minimized the
+    /// window.
+    bool isSet = false;
+};
+
+/// @brief A bounded, lock-free queue that carries the events of a window from the thread
+/// that handles them to the thread that renders.
+///
+/// @note One thread pushes and one thread pops. Neither ever waits on the other to push or
+/// pop, so a window drag that holds the event thread up never holds up a frame. Only the
+/// popping thread's sleep in `waitForEvent` takes a lock, which a push takes for no more
+/// than a notify. When every slot is taken the event is dropped and counted, rather than
+/// blocking the thread that handles events.
+class WindowEventQueue final {
+    public:
+        static constexpr size_t CAPACITY = 1024;
+
+        explicit WindowEventQueue();
+
+        ~WindowEventQueue() = default;
+
+        WindowEventQueue(const WindowEventQueue& other) = delete;
+        WindowEventQueue& operator=(const WindowEventQueue& other) = delete;
+
+        /// @brief Queue an event, and wake the thread that waits for one.
+        ///
+        /// @note Returns false, and drops the event, when the queue is full.
+        bool push(const WindowEvent& event);
+
+        /// @brief The oldest event in the queue, if there is one.
+        std::optional<WindowEvent> pop();
+
+        /// @brief Sleep until there is an event to pop, or until `timeoutSeconds` have
+        /// passed, when there is a timeout.
+        void waitForEvent(std::optional<double> timeoutSeconds);
+
+        /// @brief The events dropped so far because the queue was full.
+        uint64_t getDroppedCount() const;
+    private:
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "the capacity has to be a power of two");
+
+        std::array<WindowEvent, CAPACITY> m_events;
+        std::atomic<size_t> m_pushPosition;
+        std::atomic<size_t> m_popPosition;
+        std::atomic<uint64_t> m_droppedCount;
+        std::mutex m_wakeMutex;
+        std::condition_variable m_wakeCondition;
+
+        bool isEmpty() const;
+};
+
+}
+
+#endif // _WINDOW_EVENT_QUEUE_H